@@ -13,6 +13,27 @@ using namespace std::chrono_literals;
 constexpr auto WAVE_SIZE = 16u;
 constexpr auto WAVE_DATA = std::array<byte, WAVE_SIZE>{ 128, 159, 191, 223, 255, 223, 191, 159, 128, 96, 64, 32, 0, 32, 64, 96 };
 
+// Scripts that play notes in an endless loop would otherwise queue them faster than they can be played.
+// The notes beyond this limit are dropped. At 24 bytes per note this amounts to about 1.5MB.
+constexpr size_t MAX_PENDING_NOTES = 64 * 1024;
+
+MidiAudio::~MidiAudio()
+{
+    {
+        const std::scoped_lock lock{ _notesMutex };
+        _shutdown = true;
+    }
+
+    // Break out of the note that's currently playing, if any.
+    _skip.SetEvent();
+    _notesPending.SetEvent();
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
 void MidiAudio::_initialize(HWND windowHandle) noexcept
 {
     _hwnd = windowHandle;
@@ -35,6 +56,11 @@ void MidiAudio::_initialize(HWND windowHandle) noexcept
 void MidiAudio::BeginSkip() noexcept
 {
     _skip.SetEvent();
+
+    // Skipping means that none of the notes that
+    // were queued up until now should be played.
+    const std::scoped_lock lock{ _notesMutex };
+    _notes.clear();
 }
 
 void MidiAudio::EndSkip() noexcept
@@ -42,6 +68,8 @@ void MidiAudio::EndSkip() noexcept
     _skip.ResetEvent();
 }
 
+// Queues the given note to be played after all previously queued ones.
+// This returns immediately, unlike the note, which is sustained for its duration.
 void MidiAudio::PlayNote(HWND windowHandle, const int noteNumber, const int velocity, const std::chrono::milliseconds duration) noexcept
 try
 {
@@ -50,11 +78,73 @@ try
         return;
     }
 
-    if (_hwnd != windowHandle)
     {
-        _initialize(windowHandle);
+        const std::scoped_lock lock{ _notesMutex };
+
+        if (_notes.size() >= MAX_PENDING_NOTES)
+        {
+            return;
+        }
+
+        // The DirectSound objects are created on the playback thread, so we start it lazily.
+        // Most sessions never play a single note.
+        if (!_thread.joinable())
+        {
+            _thread = std::thread{ [this]() noexcept { _playbackLoop(); } };
+        }
+
+        _notes.emplace_back(Note{ windowHandle, noteNumber, velocity, duration });
+    }
+
+    _notesPending.SetEvent();
+}
+CATCH_LOG()
+
+void MidiAudio::_playbackLoop() noexcept
+{
+    for (;;)
+    {
+        _notesPending.wait();
+
+        for (;;)
+        {
+            Note note;
+
+            {
+                const std::scoped_lock lock{ _notesMutex };
+
+                if (_shutdown)
+                {
+                    return;
+                }
+                if (_notes.empty())
+                {
+                    break;
+                }
+
+                note = _notes.front();
+                _notes.pop_front();
+            }
+
+            _playNote(note);
+        }
+    }
+}
+
+void MidiAudio::_playNote(const Note& note) noexcept
+try
+{
+    if (_skip.is_signaled())
+    {
+        return;
+    }
+
+    if (_hwnd != note.windowHandle)
+    {
+        _initialize(note.windowHandle);
     }
 
+    const auto velocity = note.velocity;
     const auto& buffer = _buffers.at(_activeBufferIndex);
     if (velocity && buffer)
     {
@@ -63,7 +153,7 @@ try
         // which is why we subtract 69. We also need to multiply by the size
         // of the wave form to determine the frequency that the sound buffer
         // has to be played to achieve the equivalent note frequency.
-        const auto frequency = std::pow(2.0, (noteNumber - 69.0) / 12.0) * 440.0 * WAVE_SIZE;
+        const auto frequency = std::pow(2.0, (note.noteNumber - 69.0) / 12.0) * 440.0 * WAVE_SIZE;
         buffer->SetFrequency(gsl::narrow_cast<DWORD>(frequency));
         // For the volume, we're using the formula defined in the General
         // MIDI Level 2 specification: Gain in dB = 40 * log10(v/127). We need
@@ -80,7 +170,7 @@ try
     // By waiting on the skip event with a maximum duration of the note, we'll
     // either be paused for the appropriate amount of time, or we'll break out early
     // because BeginSkip() was called. This happens for Ctrl+C or during shutdown.
-    _skip.wait(::base::saturated_cast<DWORD>(duration.count()));
+    _skip.wait(::base::saturated_cast<DWORD>(note.duration.count()));
 
     if (velocity && buffer)
     {
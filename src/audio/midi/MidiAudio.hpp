@@ -6,7 +6,8 @@ Module Name:
 - MidiAudio.hpp
 
 Abstract:
-  This modules provide basic MIDI support with blocking sound output.
+  This modules provide basic MIDI support. Notes are queued and played
+  in order on a dedicated thread, so that callers don't block on them.
   */
 
 #pragma once
@@ -19,16 +20,39 @@ struct IDirectSoundBuffer;
 class MidiAudio
 {
 public:
+    MidiAudio() = default;
+    MidiAudio(const MidiAudio&) = delete;
+    MidiAudio& operator=(const MidiAudio&) = delete;
+    ~MidiAudio();
+
     void BeginSkip() noexcept;
     void EndSkip() noexcept;
     void PlayNote(HWND windowHandle, const int noteNumber, const int velocity, const std::chrono::milliseconds duration) noexcept;
 
 private:
+    struct Note
+    {
+        HWND windowHandle = nullptr;
+        int noteNumber = 0;
+        int velocity = 0;
+        std::chrono::milliseconds duration{};
+    };
+
+    void _playbackLoop() noexcept;
+    void _playNote(const Note& note) noexcept;
     void _initialize(HWND windowHandle) noexcept;
     void _createBuffers() noexcept;
 
     wil::slim_event_manual_reset _skip;
 
+    // The notes that haven't been played yet, in order. They're protected by _notesMutex,
+    // while everything below _thread is only accessed by the playback thread.
+    std::mutex _notesMutex;
+    std::deque<Note> _notes;
+    bool _shutdown = false;
+    wil::slim_event_auto_reset _notesPending;
+    std::thread _thread;
+
     HWND _hwnd = nullptr;
     wil::unique_hmodule _directSoundModule;
     wil::com_ptr<IDirectSound8> _directSound;
@@ -0,0 +1,336 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "BufferSnapshot.hpp"
+
+#include <til/hash.h>
+
+#include "textBuffer.hpp"
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+static constexpr uint8_t flagWrapForced = 0x01;
+static constexpr uint8_t flagDoubleBytePadded = 0x02;
+// The ROW's _charOffsets are 0, 1, 2, ... (= only narrow glyphs of 1 wchar_t each) and weren't stored.
+static constexpr uint8_t flagTrivialOffsets = 0x04;
+
+namespace
+{
+    struct AttributeHasher
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            return til::hash(&attr, sizeof(attr));
+        }
+    };
+
+    template<typename T>
+    void append(std::vector<std::byte>& out, const T* data, const size_t count)
+    {
+        const auto bytes = reinterpret_cast<const std::byte*>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+
+    // Reads from a snapshot, which may be truncated or otherwise corrupted. All reads are bounds checked.
+    struct Reader
+    {
+        std::span<const std::byte> data;
+
+        template<typename T>
+        void read(T* out, const size_t count)
+        {
+            const auto size = count * sizeof(T);
+            THROW_HR_IF(E_UNEXPECTED, count > data.size() / sizeof(T));
+            memcpy(out, data.data(), size);
+            data = data.subspan(size);
+        }
+
+        template<typename T>
+        T read()
+        {
+            T value;
+            read(&value, 1);
+            return value;
+        }
+
+        std::wstring readString(const size_t length)
+        {
+            std::wstring str(length, L'\0');
+            read(str.data(), length);
+            return str;
+        }
+    };
+}
+
+// Appends a snapshot of the first rowCount rows of the given buffer to `out`.
+// The caller needs to hold the lock that protects the buffer, but it doesn't need to hold it for writing.
+void BufferSnapshot::Capture(const TextBuffer& buffer, til::CoordType rowCount, std::vector<std::byte>& out)
+{
+    const auto size = buffer.GetSize();
+    const auto cursor = buffer.GetCursor().GetPosition();
+
+    // Rows below the cursor without any text in them aren't worth restoring.
+    rowCount = std::clamp(rowCount, 0, size.Height());
+    while (rowCount > cursor.y + 1 && !buffer.GetRowByOffset(rowCount - 1).ContainsText())
+    {
+        --rowCount;
+    }
+
+    std::vector<TextAttribute> attributes;
+    const auto rows = _captureRows(buffer, 0, rowCount, attributes);
+
+    std::unordered_map<uint16_t, const std::wstring*> customIds;
+    for (const auto& [key, id] : buffer._hyperlinkCustomIdMap)
+    {
+        customIds.emplace(id, &key);
+    }
+
+    const auto beg = out.size();
+    Header header{
+        .magic = Magic,
+        .version = Version,
+        .attributeSize = sizeof(TextAttribute),
+        .columnCount = gsl::narrow<uint16_t>(size.Width()),
+        .rowCount = gsl::narrow<uint16_t>(rowCount),
+        .attributeCount = gsl::narrow<uint32_t>(attributes.size()),
+        .hyperlinkCount = gsl::narrow<uint32_t>(buffer._hyperlinkMap.size()),
+        .cursorX = cursor.x,
+        .cursorY = cursor.y,
+        .currentHyperlinkId = buffer._currentHyperlinkId,
+    };
+    append(out, &header, 1);
+    append(out, attributes.data(), attributes.size());
+
+    for (const auto& [id, uri] : buffer._hyperlinkMap)
+    {
+        const auto it = customIds.find(id);
+        const auto customId = it != customIds.end() ? it->second : nullptr;
+        const HyperlinkHeader link{
+            .id = id,
+            .uriLength = gsl::narrow<uint32_t>(uri.size()),
+            .customIdLength = customId ? gsl::narrow<uint32_t>(customId->size()) : 0,
+        };
+        append(out, &link, 1);
+        append(out, uri.data(), uri.size());
+        if (customId)
+        {
+            append(out, customId->data(), customId->size());
+        }
+    }
+
+    append(out, rows.data(), rows.size());
+
+    // The size is only known now. Patch it into the header we wrote.
+    header.size = out.size() - beg;
+    memcpy(out.data() + beg + offsetof(Header, size), &header.size, sizeof(header.size));
+}
+
+std::vector<std::byte> BufferSnapshot::_captureRows(const TextBuffer& buffer, const til::CoordType beg, const til::CoordType end, std::vector<TextAttribute>& attributes)
+{
+    std::unordered_map<TextAttribute, uint16_t, AttributeHasher> attributeIds;
+    std::vector<InternedRun> interned;
+    std::vector<std::byte> out;
+
+    for (auto y = beg; y < end; ++y)
+    {
+        const auto& row = buffer.GetRowByOffset(y);
+        const auto columns = row._columnCount;
+        const auto charCount = row._charSize();
+        std::wstring_view text{ row._chars.data(), charCount };
+
+        uint8_t flags = 0;
+        if (row._wrapForced)
+        {
+            flags |= flagWrapForced;
+        }
+        if (row._doubleBytePadded)
+        {
+            flags |= flagDoubleBytePadded;
+        }
+
+        if (charCount == columns)
+        {
+            uint16_t col = 0;
+            for (; col < columns && row._charOffsets[col] == col; ++col)
+            {
+            }
+            if (col == columns)
+            {
+                flags |= flagTrivialOffsets;
+                text = text.substr(0, text.find_last_not_of(L' ') + 1);
+            }
+        }
+
+        interned.clear();
+        for (const auto& run : row._attr.runs())
+        {
+            const auto [it, inserted] = attributeIds.emplace(run.value, gsl::narrow_cast<uint16_t>(attributes.size()));
+            if (inserted)
+            {
+                THROW_HR_IF(E_OUTOFMEMORY, attributes.size() > UINT16_MAX);
+                attributes.emplace_back(run.value);
+            }
+            interned.push_back({ it->second, run.length });
+        }
+
+        const RowHeader header{
+            .charCount = charCount,
+            .runCount = gsl::narrow<uint16_t>(interned.size()),
+            .textLength = gsl::narrow<uint16_t>(text.size()),
+            .flags = flags,
+            .lineRendition = static_cast<uint8_t>(row._lineRendition),
+        };
+        append(out, &header, 1);
+        append(out, interned.data(), interned.size());
+        if (!(flags & flagTrivialOffsets))
+        {
+            append(out, row._charOffsets.data(), row._charOffsets.size());
+        }
+        append(out, text.data(), text.size());
+    }
+
+    return out;
+}
+
+// Imports a snapshot written by Capture() into the given buffer, which is expected to be freshly created.
+// If the widths don't match, the snapshot is decoded into a temporary buffer and reflowed into the given one.
+BufferSnapshot::RestoreResult BufferSnapshot::Restore(TextBuffer& buffer, std::span<const std::byte> data)
+{
+    Reader reader{ data };
+
+    const auto header = reader.read<Header>();
+    THROW_HR_IF(E_UNEXPECTED, header.magic != Magic || header.version != Version || header.attributeSize != sizeof(TextAttribute));
+    THROW_HR_IF(E_UNEXPECTED, header.size < sizeof(Header) || header.size > data.size() || header.columnCount == 0);
+    reader.data = data.subspan(sizeof(Header), gsl::narrow_cast<size_t>(header.size) - sizeof(Header));
+
+    THROW_HR_IF(E_UNEXPECTED, header.attributeCount > UINT16_MAX + 1u);
+    std::vector<TextAttribute> attributes(header.attributeCount);
+    reader.read(attributes.data(), attributes.size());
+
+    std::unordered_map<uint16_t, std::wstring> hyperlinkMap;
+    std::unordered_map<std::wstring, uint16_t> hyperlinkCustomIdMap;
+    for (uint32_t i = 0; i < header.hyperlinkCount; ++i)
+    {
+        const auto link = reader.read<HyperlinkHeader>();
+        auto uri = reader.readString(link.uriLength);
+        if (link.customIdLength)
+        {
+            hyperlinkCustomIdMap.insert_or_assign(reader.readString(link.customIdLength), link.id);
+        }
+        hyperlinkMap.insert_or_assign(link.id, std::move(uri));
+    }
+
+    RestoreResult result;
+    result.size = gsl::narrow_cast<size_t>(header.size);
+
+    const auto size = buffer.GetSize();
+    til::point cursor{ header.cursorX, header.cursorY };
+
+    if (header.columnCount == size.Width())
+    {
+        const auto skip = std::max(0, header.rowCount - size.Height());
+        _restoreRows(buffer, header, attributes, reader.data, skip);
+        cursor.y -= skip;
+        result.rowDelta = skip;
+    }
+    else
+    {
+        TextBuffer temp{ { header.columnCount, std::max<til::CoordType>(header.rowCount, 1) }, buffer.GetCurrentAttributes(), 0, false, buffer._renderer };
+        _restoreRows(temp, header, attributes, reader.data, 0);
+        temp.GetSize().Clamp(cursor);
+        temp.GetCursor().SetPosition(cursor);
+        THROW_IF_FAILED(TextBuffer::Reflow(temp, buffer, std::nullopt, std::nullopt));
+        cursor = buffer.GetCursor().GetPosition();
+    }
+
+    size.Clamp(cursor);
+    buffer.GetCursor().SetPosition(cursor);
+    buffer._hyperlinkMap = std::move(hyperlinkMap);
+    buffer._hyperlinkCustomIdMap = std::move(hyperlinkCustomIdMap);
+    buffer._currentHyperlinkId = header.currentHyperlinkId;
+    return result;
+}
+
+// Decodes the rows of a snapshot into the given buffer, which must be as wide as the snapshot.
+// The first `skip` rows are decoded and discarded, so that the last ones fit into the buffer.
+void BufferSnapshot::_restoreRows(TextBuffer& buffer, const Header& header, std::span<const TextAttribute> attributes, std::span<const std::byte> rows, const til::CoordType skip)
+{
+    const auto columns = header.columnCount;
+    Reader reader{ rows };
+    std::vector<til::rle_pair<TextAttribute, uint16_t>> runs;
+    std::vector<uint16_t> offsets(columns + size_t{ 1 });
+    std::wstring text;
+
+    for (til::CoordType y = 0; y < header.rowCount; ++y)
+    {
+        const auto rowHeader = reader.read<RowHeader>();
+        THROW_HR_IF(E_UNEXPECTED, rowHeader.lineRendition > static_cast<uint8_t>(LineRendition::DoubleHeightBottom));
+
+        runs.clear();
+        size_t total = 0;
+        for (uint16_t i = 0; i < rowHeader.runCount; ++i)
+        {
+            const auto run = reader.read<InternedRun>();
+            THROW_HR_IF(E_UNEXPECTED, run.id >= attributes.size());
+            runs.emplace_back(til::at(attributes, run.id), run.length);
+            total += run.length;
+        }
+        THROW_HR_IF(E_UNEXPECTED, total != columns);
+
+        const auto trivialOffsets = (rowHeader.flags & flagTrivialOffsets) != 0;
+        if (trivialOffsets)
+        {
+            THROW_HR_IF(E_UNEXPECTED, rowHeader.charCount != columns || rowHeader.textLength > columns);
+            std::iota(offsets.begin(), offsets.end(), uint16_t{ 0 });
+        }
+        else
+        {
+            reader.read(offsets.data(), offsets.size());
+
+            // The offsets are used to index into the text without any further checks. They must start at 0,
+            // be monotonic and end with the charCount. Only entries in between may be marked as trailers.
+            uint16_t previous = 0;
+            for (size_t i = 0; i < offsets.size(); ++i)
+            {
+                const auto offset = til::at(offsets, i);
+                const auto isTrailer = (offset & ~ROW::CharOffsetsMask) != 0;
+                const auto value = gsl::narrow_cast<uint16_t>(offset & ROW::CharOffsetsMask);
+                THROW_HR_IF(E_UNEXPECTED, value < previous || value > rowHeader.charCount || (isTrailer && (i == 0 || i == columns)));
+                previous = value;
+            }
+            THROW_HR_IF(E_UNEXPECTED, offsets.front() != 0 || offsets.back() != rowHeader.charCount || rowHeader.textLength != rowHeader.charCount);
+        }
+
+        text.resize(rowHeader.textLength);
+        reader.read(text.data(), text.size());
+
+        if (y < skip)
+        {
+            continue;
+        }
+
+        auto& row = buffer.GetRowByOffset(y - skip);
+
+        if (rowHeader.charCount > row._chars.size())
+        {
+            row._charsHeap = std::make_unique_for_overwrite<wchar_t[]>(rowHeader.charCount);
+            row._chars = { row._charsHeap.get(), rowHeader.charCount };
+        }
+
+        const auto chars = row._chars.first(rowHeader.charCount);
+        std::copy(text.begin(), text.end(), chars.begin());
+        std::fill(chars.begin() + text.size(), chars.end(), L' ');
+        std::copy(offsets.begin(), offsets.end(), row._charOffsets.begin());
+
+        row._attr.replace(0, row._attr.size(), runs);
+        row._lineRendition = static_cast<LineRendition>(rowHeader.lineRendition);
+        row._wrapForced = (rowHeader.flags & flagWrapForced) != 0;
+        row._doubleBytePadded = (rowHeader.flags & flagDoubleBytePadded) != 0;
+        row._bumpGeneration();
+    }
+}
+
+#pragma warning(pop)
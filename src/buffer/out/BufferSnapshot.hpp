@@ -0,0 +1,91 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- BufferSnapshot.hpp
+
+Abstract:
+- Encodes the contents of a TextBuffer into a compact binary snapshot and
+  imports them again, which allows restoring a session without replaying VT.
+- A snapshot consists of a header, the table of distinct attributes, the
+  hyperlink maps and the ROWs. Similar to ScrollbackArchive, each ROW is stored
+  as its line flags, its runs of interned attributes, its column-to-character
+  offsets (only if they aren't trivial) and its text as UTF-16 (without
+  trailing whitespace if the offsets are trivial).
+- Snapshots are only meant to be read by the same build that wrote them.
+  The header contains a version and the size of TextAttribute, and anything
+  that doesn't match is rejected. Everything else is validated while decoding,
+  because the file might have been truncated or tampered with.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+class TextBuffer;
+
+class BufferSnapshot final
+{
+public:
+    struct RestoreResult
+    {
+        // The number of bytes of the snapshot that were consumed. Callers may append their own data after it.
+        size_t size = 0;
+        // The amount by which the rows moved up compared to when they were captured, or nullopt if they
+        // had to be reflowed into a buffer of a different width. Absolute positions (like scroll marks)
+        // must be translated with this, or be dropped if it's nullopt.
+        std::optional<til::CoordType> rowDelta;
+    };
+
+    static void Capture(const TextBuffer& buffer, til::CoordType rowCount, std::vector<std::byte>& out);
+    static RestoreResult Restore(TextBuffer& buffer, std::span<const std::byte> data);
+
+private:
+    static constexpr uint32_t Magic = 0x53425457; // "WTBS"
+    static constexpr uint16_t Version = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t attributeSize;
+        uint16_t columnCount;
+        uint16_t rowCount;
+        uint32_t attributeCount;
+        uint32_t hyperlinkCount;
+        til::CoordType cursorX;
+        til::CoordType cursorY;
+        uint16_t currentHyperlinkId;
+        uint16_t reserved;
+        // The size of the entire snapshot, including this header.
+        uint64_t size;
+    };
+
+    struct HyperlinkHeader
+    {
+        uint16_t id;
+        uint16_t reserved;
+        uint32_t uriLength;
+        // The length of the key in TextBuffer::_hyperlinkCustomIdMap, or 0 if the hyperlink didn't have one.
+        uint32_t customIdLength;
+    };
+
+    struct RowHeader
+    {
+        uint16_t charCount;
+        uint16_t runCount;
+        uint16_t textLength;
+        uint8_t flags;
+        uint8_t lineRendition;
+    };
+
+    struct InternedRun
+    {
+        uint16_t id;
+        uint16_t length;
+    };
+
+    static std::vector<std::byte> _captureRows(const TextBuffer& buffer, til::CoordType beg, til::CoordType end, std::vector<TextAttribute>& attributes);
+    static void _restoreRows(TextBuffer& buffer, const Header& header, std::span<const TextAttribute> attributes, std::span<const std::byte> rows, til::CoordType skip);
+};
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ImageSlice.hpp"
+
+#include "Row.hpp"
+
+ImageSlice::ImageSlice(const til::size cellSize) noexcept :
+    _cellSize{ cellSize },
+    _revision{ ROW::NextGeneration() }
+{
+}
+
+til::size ImageSlice::CellSize() const noexcept
+{
+    return _cellSize;
+}
+
+til::CoordType ImageSlice::ColumnBegin() const noexcept
+{
+    return _columnBegin;
+}
+
+til::CoordType ImageSlice::ColumnEnd() const noexcept
+{
+    return _columnEnd;
+}
+
+til::CoordType ImageSlice::PixelWidth() const noexcept
+{
+    return _pixelWidth;
+}
+
+uint64_t ImageSlice::Revision() const noexcept
+{
+    return _revision;
+}
+
+std::span<const til::color> ImageSlice::Pixels() const noexcept
+{
+    return _pixels;
+}
+
+// Routine Description:
+// - Grows the slice so that it covers at least the given column range
+//   and returns the pixels of that range. The returned span starts at the
+//   top-left pixel of columnBegin and successive pixel rows are PixelWidth() apart.
+// Arguments:
+// - columnBegin - the first column that will be written to
+// - columnEnd - one past the last column that will be written to
+// Return Value:
+// - The pixels starting at columnBegin. They remain valid until the next call.
+std::span<til::color> ImageSlice::MutablePixels(const til::CoordType columnBegin, const til::CoordType columnEnd)
+{
+    if (_pixels.empty())
+    {
+        _columnBegin = columnBegin;
+        _columnEnd = columnEnd;
+        _pixelWidth = (columnEnd - columnBegin) * _cellSize.width;
+        _pixels.resize(gsl::narrow_cast<size_t>(_pixelWidth) * _cellSize.height);
+    }
+    else if (columnBegin < _columnBegin || columnEnd > _columnEnd)
+    {
+        const auto newColumnBegin = std::min(columnBegin, _columnBegin);
+        const auto newColumnEnd = std::max(columnEnd, _columnEnd);
+        const auto newPixelWidth = (newColumnEnd - newColumnBegin) * _cellSize.width;
+        const auto offset = (_columnBegin - newColumnBegin) * _cellSize.width;
+
+        std::vector<til::color> newPixels(gsl::narrow_cast<size_t>(newPixelWidth) * _cellSize.height);
+        for (til::CoordType y = 0; y < _cellSize.height; ++y)
+        {
+            const auto src = _pixels.begin() + gsl::narrow_cast<size_t>(y) * _pixelWidth;
+            const auto dst = newPixels.begin() + gsl::narrow_cast<size_t>(y) * newPixelWidth + offset;
+            std::copy_n(src, _pixelWidth, dst);
+        }
+
+        _pixels = std::move(newPixels);
+        _columnBegin = newColumnBegin;
+        _columnEnd = newColumnEnd;
+        _pixelWidth = newPixelWidth;
+    }
+
+    _bumpRevision();
+
+    const auto offset = gsl::narrow_cast<size_t>(columnBegin - _columnBegin) * _cellSize.width;
+    return std::span{ _pixels }.subspan(offset);
+}
+
+void ImageSlice::CopyRow(const ROW& srcRow, ROW& dstRow)
+{
+    const auto srcSlice = srcRow.GetImageSlice();
+    dstRow.SetImageSlice(srcSlice ? std::make_unique<ImageSlice>(*srcSlice) : nullptr);
+}
+
+// Routine Description:
+// - Erases the image pixels in the given column range of the row.
+//   The slice is released entirely once nothing visible remains.
+void ImageSlice::EraseCells(ROW& row, const til::CoordType columnBegin, const til::CoordType columnEnd)
+{
+    if (const auto slice = row.GetMutableImageSlice())
+    {
+        if (slice->_eraseCells(columnBegin, columnEnd))
+        {
+            row.SetImageSlice(nullptr);
+        }
+    }
+}
+
+// Returns true if the slice is entirely empty after erasing the given columns.
+bool ImageSlice::_eraseCells(const til::CoordType columnBegin, const til::CoordType columnEnd) noexcept
+{
+    const auto eraseBegin = std::max(columnBegin, _columnBegin);
+    const auto eraseEnd = std::min(columnEnd, _columnEnd);
+    if (eraseBegin >= eraseEnd)
+    {
+        return false;
+    }
+    if (eraseBegin == _columnBegin && eraseEnd == _columnEnd)
+    {
+        return true;
+    }
+
+    const auto offset = (eraseBegin - _columnBegin) * _cellSize.width;
+    const auto count = (eraseEnd - eraseBegin) * _cellSize.width;
+    for (til::CoordType y = 0; y < _cellSize.height; ++y)
+    {
+        const auto row = _pixels.begin() + gsl::narrow_cast<size_t>(y) * _pixelWidth + offset;
+        std::fill_n(row, count, til::color{});
+    }
+
+    _bumpRevision();
+    return false;
+}
+
+void ImageSlice::_bumpRevision() noexcept
+{
+    _revision = ROW::NextGeneration();
+}
@@ -0,0 +1,56 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ImageSlice.hpp
+
+Abstract:
+- Holds the pixels of the part of an image (for instance a sixel graphic)
+  that covers a single textbuffer row. Each ROW owns at most one slice and
+  since the slice is owned by the ROW, it is scrolled, recycled and erased
+  together with the row's text.
+- The pixels are stored in "virtual" pixels, which are measured relative to
+  a fixed cell size that is independent of the font. It's the renderer's job
+  to scale them to the actual cell size.
+
+--*/
+
+#pragma once
+
+class ROW;
+
+class ImageSlice
+{
+public:
+    using Pointer = std::unique_ptr<ImageSlice>;
+
+    explicit ImageSlice(til::size cellSize) noexcept;
+
+    til::size CellSize() const noexcept;
+    til::CoordType ColumnBegin() const noexcept;
+    til::CoordType ColumnEnd() const noexcept;
+    til::CoordType PixelWidth() const noexcept;
+    uint64_t Revision() const noexcept;
+
+    std::span<const til::color> Pixels() const noexcept;
+    std::span<til::color> MutablePixels(til::CoordType columnBegin, til::CoordType columnEnd);
+
+    static void CopyRow(const ROW& srcRow, ROW& dstRow);
+    static void EraseCells(ROW& row, til::CoordType columnBegin, til::CoordType columnEnd);
+
+private:
+    bool _eraseCells(til::CoordType columnBegin, til::CoordType columnEnd) noexcept;
+    void _bumpRevision() noexcept;
+
+    til::size _cellSize;
+    // Row-major pixels, _pixelWidth wide and _cellSize.height tall. Unused pixels are
+    // transparent (all zero), which means that they can be treated as premultiplied.
+    std::vector<til::color> _pixels;
+    til::CoordType _columnBegin = 0;
+    til::CoordType _columnEnd = 0;
+    til::CoordType _pixelWidth = 0;
+    // A process-wide unique value that changes whenever the pixels change.
+    // Same idea as ROW::GetGeneration(), so that it remains a valid cache key across scrolling.
+    uint64_t _revision = 0;
+};
@@ -7,10 +7,22 @@
 #include <til/unicode.h>
 
 #include "textBuffer.hpp"
+#include "../../types/inc/convert.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
 
 extern "C" int __isa_available;
 
+// ROW::WriteCharInfos() maps the color bits of CHAR_INFO::Attributes (the lower 8 bits) via this table,
+// instead of constructing and comparing a TextAttribute for every single cell.
+static const auto s_legacyAttributes = [] {
+    std::array<TextAttribute, 256> table;
+    for (WORD i = 0; i < table.size(); ++i)
+    {
+        til::at(table, i) = TextAttribute{ i };
+    }
+    return table;
+}();
+
 // The STL is missing a std::iota_n analogue for std::iota, so I made my own.
 template<typename OutIt, typename Diff, typename T>
 constexpr OutIt iota_n(OutIt dest, Diff count, T val)
@@ -70,6 +82,41 @@ constexpr OutIt copy_n_small(InIt first, Diff count, OutIt dest)
     return dest;
 }
 
+// Returns the length of the longest prefix of [beg, beg + count) that consists of ASCII
+// characters only. They're always narrow and thus occupy exactly 1 column each.
+static size_t asciiPrefixLength(const wchar_t* beg, const size_t count) noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    auto it = beg;
+    const auto end = beg + count;
+
+#if defined(TIL_SSE_INTRINSICS)
+    for (; end - it >= 8; it += 8)
+    {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(-0x80)), _mm_setzero_si128());
+        if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(ascii)) ^ 0xffffu)
+        {
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            // _mm_movemask_epi8 returns 2 bits per wchar_t.
+            return gsl::narrow_cast<size_t>(it - beg) + index / 2;
+        }
+    }
+#endif
+
+    for (; it != end && *it < 0x80; ++it)
+    {
+    }
+
+    return gsl::narrow_cast<size_t>(it - beg);
+
+#pragma warning(pop)
+}
+
 // Routine Description:
 // - constructor
 // Arguments:
@@ -117,6 +164,21 @@ LineRendition ROW::GetLineRendition() const noexcept
     return _lineRendition;
 }
 
+const ImageSlice* ROW::GetImageSlice() const noexcept
+{
+    return _imageSlice.get();
+}
+
+ImageSlice* ROW::GetMutableImageSlice() noexcept
+{
+    return _imageSlice.get();
+}
+
+void ROW::SetImageSlice(ImageSlice::Pointer imageSlice) noexcept
+{
+    _imageSlice = std::move(imageSlice);
+}
+
 // Routine Description:
 // - Sets all properties of the ROW to default values
 // Arguments:
@@ -133,11 +195,14 @@ void ROW::Reset(const TextAttribute& attr) noexcept
     _lineRendition = LineRendition::SingleWidth;
     _wrapForced = false;
     _doubleBytePadded = false;
+    _imageSlice.reset();
     _init();
 }
 
 void ROW::_init() noexcept
 {
+    _bumpGeneration();
+
 #pragma warning(push)
 #pragma warning(disable : 26462) // The value pointed to by '...' is assigned only once, mark it as a pointer to const (con.4).
 #pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
@@ -255,6 +320,7 @@ void ROW::TransferAttributes(const til::small_rle<TextAttribute, uint16_t, 1>& a
 {
     _attr = attr;
     _attr.resize_trailing_extent(gsl::narrow<uint16_t>(newWidth));
+    _bumpGeneration();
 }
 
 void ROW::CopyFrom(const ROW& source)
@@ -264,6 +330,7 @@ void ROW::CopyFrom(const ROW& source)
     TransferAttributes(source.Attributes(), _columnCount);
     _lineRendition = source._lineRendition;
     _wrapForced = source._wrapForced;
+    ImageSlice::CopyRow(source, *this);
 }
 
 // Returns the previous possible cursor position, preceding the given column.
@@ -333,6 +400,8 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
     uint16_t colorUses = 0;
     auto colorStarts = gsl::narrow_cast<uint16_t>(columnBegin);
     auto currentIndex = colorStarts;
+    // The color runs are collected and committed into the attr row in a single pass at the end.
+    til::small_vector<decltype(_attr)::range_replacement, 16> colors;
 
     while (it && currentIndex <= finalColumnInRow)
     {
@@ -348,8 +417,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
             else
             {
                 // Otherwise, commit this color into the run and save off the new one.
-                // Now commit the new color runs into the attr row.
-                _attr.replace(colorStarts, currentIndex, currentColor);
+                colors.push_back({ colorStarts, currentIndex, currentColor });
                 currentColor = it->TextAttr();
                 colorUses = 1;
                 colorStarts = currentIndex;
@@ -426,23 +494,172 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
         ++currentIndex;
     }
 
-    // Now commit the final color into the attr row
+    // Now commit the final color and with it all runs into the attr row
     if (colorUses)
     {
-        _attr.replace(colorStarts, currentIndex, currentColor);
+        colors.push_back({ colorStarts, currentIndex, currentColor });
     }
+    _attr.replace_runs({ colors.data(), colors.size() });
 
+    _bumpGeneration();
     return it;
 }
 
+// Writes a line of CHAR_INFOs the same way WriteCells() would via an OutputCellIterator, but in bulk:
+// The text is written with a single WriteHelper and the attributes with a single replace() call.
+// Returns false without modifying the row, if the CHAR_INFOs don't fit into the row, or if their leading
+// and trailing halves don't pair up. WriteCells() knows how to deal with the latter and callers should
+// fall back to it in that case.
+bool ROW::WriteCharInfos(const til::CoordType columnBegin, const std::span<const CHAR_INFO> infos)
+try
+{
+    if (columnBegin < 0 || columnBegin >= _columnCount || infos.empty() || infos.size() > static_cast<size_t>(_columnCount - columnBegin))
+    {
+        return false;
+    }
+
+    til::small_vector<wchar_t, 256> chars;
+    til::small_vector<decltype(_attr)::rle_type, 16> attrs;
+    WORD lastAttributes = 0;
+    auto expectTrailer = false;
+
+    for (const auto& ci : infos)
+    {
+        if (WI_IsFlagSet(ci.Attributes, COMMON_LVB_LEADING_BYTE))
+        {
+            if (expectTrailer)
+            {
+                return false;
+            }
+            chars.emplace_back(ci.Char.UnicodeChar);
+            expectTrailer = true;
+        }
+        else if (WI_IsFlagSet(ci.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            // The trailing half is a copy of the leading one and its character is ignored.
+            if (!expectTrailer)
+            {
+                return false;
+            }
+            expectTrailer = false;
+        }
+        else
+        {
+            if (expectTrailer)
+            {
+                return false;
+            }
+            chars.emplace_back(ci.Char.UnicodeChar);
+        }
+
+        const WORD attributes = ci.Attributes & ~COMMON_LVB_SBCSDBCS;
+        if (!attrs.empty() && attributes == lastAttributes)
+        {
+            attrs.back().length++;
+        }
+        else
+        {
+            const auto attr = WI_IsAnyFlagSet(attributes, USED_META_ATTRS) ? TextAttribute{ attributes } : til::at(s_legacyAttributes, attributes & 0xff);
+            attrs.emplace_back(attr, uint16_t{ 1 });
+            lastAttributes = attributes;
+        }
+    }
+
+    if (expectTrailer)
+    {
+        return false;
+    }
+
+    const std::wstring_view text{ chars.data(), chars.size() };
+    const auto columnEnd = gsl::narrow_cast<til::CoordType>(columnBegin + infos.size());
+
+    {
+        WriteHelper h{ *this, columnBegin, columnEnd, text };
+        h.ReplaceCharInfos(infos);
+        h.Finish();
+    }
+
+    _attr.replace(gsl::narrow_cast<uint16_t>(columnBegin), gsl::narrow_cast<uint16_t>(columnEnd), std::span{ attrs.data(), attrs.size() });
+    return true;
+}
+catch (...)
+{
+    Reset(TextAttribute{});
+    throw;
+}
+
+// WriteCharInfos() has already verified that all leading halves are followed by a trailing one
+// and that they fit into the row. We only need to compute the char offsets here.
+[[msvc::forceinline]] void ROW::WriteHelper::ReplaceCharInfos(const std::span<const CHAR_INFO> infos) noexcept
+{
+    auto ch = chBeg;
+
+    for (const auto& ci : infos)
+    {
+        if (WI_IsFlagClear(ci.Attributes, COMMON_LVB_LEADING_BYTE) && WI_IsFlagSet(ci.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            til::at(row._charOffsets, colEnd++) = gsl::narrow_cast<uint16_t>((ch - 1) | CharOffsetsTrailer);
+        }
+        else
+        {
+            til::at(row._charOffsets, colEnd++) = ch++;
+        }
+    }
+
+    colEndDirty = colEnd;
+    charsConsumed = chars.size();
+}
+
+// The counterpart to WriteCharInfos() for ReadConsoleOutputW(). Turning a TextAttribute into legacy attributes
+// may have to search for the closest legacy color, so this happens once per attribute run instead of once per cell.
+void ROW::ReadCharInfos(const til::CoordType columnBegin, const std::span<CHAR_INFO> infos) const
+{
+    const auto colBeg = _clampedColumnInclusive(columnBegin);
+    const auto colEnd = _clampedColumnInclusive(columnBegin + gsl::narrow_cast<til::CoordType>(infos.size()));
+    uint16_t runBeg = 0;
+
+    for (const auto& run : _attr.runs())
+    {
+        const auto runEnd = gsl::narrow_cast<uint16_t>(runBeg + run.length);
+        const auto beg = std::max(runBeg, colBeg);
+        const auto end = std::min(runEnd, colEnd);
+
+        if (beg < end)
+        {
+            const auto attributes = run.value.GetLegacyAttributes();
+            for (auto col = beg; col < end; ++col)
+            {
+                auto& ci = til::at(infos, col - colBeg);
+                ci.Char.UnicodeChar = Utf16ToUcs2(GlyphAt(col));
+                ci.Attributes = attributes | GeneratePublicApiAttributeFormat(DbcsAttrAt(col));
+            }
+        }
+
+        if (runEnd >= colEnd)
+        {
+            break;
+        }
+        runBeg = runEnd;
+    }
+}
+
 void ROW::SetAttrToEnd(const til::CoordType columnBegin, const TextAttribute attr)
 {
     _attr.replace(_clampedColumnInclusive(columnBegin), _attr.size(), attr);
+    _bumpGeneration();
 }
 
 void ROW::ReplaceAttributes(const til::CoordType beginIndex, const til::CoordType endIndex, const TextAttribute& newAttr)
 {
     _attr.replace(_clampedColumnInclusive(beginIndex), _clampedColumnInclusive(endIndex), newAttr);
+    _bumpGeneration();
+}
+
+// Replaces several ranges of attributes at once. See til::basic_rle::replace_runs().
+void ROW::ReplaceAttributes(const std::span<const til::small_rle<TextAttribute, uint16_t, 1>::range_replacement> replacements)
+{
+    _attr.replace_runs(replacements);
+    _bumpGeneration();
 }
 
 [[msvc::forceinline]] ROW::WriteHelper::WriteHelper(ROW& row, til::CoordType columnBegin, til::CoordType columnLimit, const std::wstring_view& chars) noexcept :
@@ -536,11 +753,55 @@ catch (...)
     throw;
 }
 
+void ROW::FillText(RowWriteState& state)
+try
+{
+    WriteHelper h{ *this, state.columnBegin, state.columnLimit, state.text };
+    if (!h.IsValid())
+    {
+        state.columnEnd = h.colBeg;
+        state.columnBeginDirty = h.colBeg;
+        state.columnEndDirty = h.colBeg;
+        return;
+    }
+    h.FillText();
+    h.FinishFill();
+
+    state.columnEnd = h.colEnd;
+    state.columnBeginDirty = h.colBegDirty;
+    state.columnEndDirty = h.colEndDirty;
+}
+catch (...)
+{
+    Reset(TextAttribute{});
+    throw;
+}
+
+// Every column gets its own copy of the single narrow character in `chars`,
+// which means that the char offsets are simply successive numbers.
+[[msvc::forceinline]] void ROW::WriteHelper::FillText() noexcept
+{
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+    std::iota(row._charOffsets.data() + colBeg, row._charOffsets.data() + colLimit, chBeg);
+    colEnd = colLimit;
+    colEndDirty = colLimit;
+    charsConsumed = colLimit - colBeg;
+}
+
 [[msvc::forceinline]] void ROW::WriteHelper::ReplaceText() noexcept
 {
-    size_t ch = chBeg;
+    // Most text is ASCII and every ASCII character occupies exactly 1 column. The leading ASCII run
+    // of `chars` can thus skip the width lookup and have its char offsets written in bulk.
+    // Any wide glyphs we overwrite at either end of the run are handled by Finish() as usual.
+    const auto ascii = asciiPrefixLength(chars.data(), std::min<size_t>(chars.size(), colLimit - colEnd));
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+    std::iota(row._charOffsets.data() + colEnd, row._charOffsets.data() + colEnd + ascii, chBeg);
+    colEnd = gsl::narrow_cast<uint16_t>(colEnd + ascii);
+    colEndDirty = colEnd;
+
+    size_t ch = chBeg + ascii;
 
-    for (const auto& s : til::utf16_iterator{ chars })
+    for (const auto& s : til::utf16_iterator{ chars.substr(ascii) })
     {
         const auto wide = til::at(s, 0) < 0x80 ? false : IsGlyphFullWidth(s);
         const auto colEndNew = gsl::narrow_cast<uint16_t>(colEnd + 1u + wide);
@@ -647,6 +908,35 @@ catch (...)
     __assume(src != nullptr);
     __assume(dst != nullptr);
 
+#if defined(TIL_SSE_INTRINSICS)
+#pragma warning(push)
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+    // The loop below gets vectorized with SSE2, because that's our baseline ISA. During reflow and
+    // scrolling of wide rows we can copy twice as many offsets at once if the CPU supports AVX2.
+    // Just like in ROW::Reset(), the final chunk is aligned to the end of the input, overlapping the
+    // previous one. Rewriting the overlapping offsets is harmless, because src and dst don't alias.
+    if (__isa_available >= __ISA_AVAILABLE_AVX2 && size >= 16)
+    {
+        const auto mask = _mm256_set1_epi16(CharOffsetsMask);
+        const auto trailer = _mm256_set1_epi16(static_cast<short>(CharOffsetsTrailer));
+        const auto off = _mm256_set1_epi16(static_cast<short>(offset));
+        const auto rebase = [&](const uint16_t* s, uint16_t* d) noexcept {
+            const auto ch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+            const auto newOff = _mm256_add_epi16(_mm256_and_si256(ch, mask), off);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_or_si256(newOff, _mm256_and_si256(ch, trailer)));
+        };
+
+        const auto tail = size - 16u;
+        for (size_t i = 0; i < tail; i += 16)
+        {
+            rebase(src + i, dst + i);
+        }
+        rebase(src + tail, dst + tail);
+        return;
+    }
+#pragma warning(pop)
+#endif
+
     // All tested compilers (including MSVC) will neatly unroll and vectorize
     // this loop, which is why it's written in this particular way.
     for (const auto end = src + size; src != end; ++src, ++dst)
@@ -662,6 +952,26 @@ catch (...)
 
 [[msvc::forceinline]] void ROW::WriteHelper::Finish()
 {
+    _finishResize();
+    // std::copy_n compiles to memmove. We can do better. It also gets rid of an extra branch,
+    // because std::copy_n avoids calling memmove if the count is 0. It's never 0 for us.
+    memcpy(&row._chars[chBeg], chars.data(), charsConsumed * sizeof(wchar_t));
+    _finishPadding();
+}
+
+// Same as Finish(), but for FillText(), where `chars` is a single character
+// that's repeated `charsConsumed` times. std::fill_n gets vectorized just fine.
+[[msvc::forceinline]] void ROW::WriteHelper::FinishFill()
+{
+    _finishResize();
+    std::fill_n(row._chars.begin() + chBeg, charsConsumed, til::at(chars, 0));
+    _finishPadding();
+}
+
+[[msvc::forceinline]] void ROW::WriteHelper::_finishResize()
+{
+    row._bumpGeneration();
+
     colEndDirty = row._adjustForward(colEndDirty);
 
     const uint16_t trailingSpaces = colEndDirty - colEnd;
@@ -672,12 +982,13 @@ catch (...)
     {
         row._resizeChars(colEndDirty, chBegDirty, chEndDirty, chEndDirtyOld);
     }
+}
 
+[[msvc::forceinline]] void ROW::WriteHelper::_finishPadding() noexcept
+{
     {
-        // std::copy_n compiles to memmove. We can do better. It also gets rid of an extra branch,
-        // because std::copy_n avoids calling memmove if the count is 0. It's never 0 for us.
         const auto itBeg = row._chars.begin() + chBeg;
-        memcpy(&*itBeg, chars.data(), charsConsumed * sizeof(wchar_t));
+        const uint16_t trailingSpaces = colEndDirty - colEnd;
 
         if (leadingSpaces)
         {
@@ -742,6 +1053,36 @@ void ROW::_resizeChars(uint16_t colEndDirty, uint16_t chBegDirty, size_t chEndDi
     }
 }
 
+// Returns a value that changes whenever the text or attributes of this ROW are modified.
+// The value is unique across all ROWs in the process: If two calls return the same value,
+// the ROW's contents are guaranteed to be identical. This allows consumers to cache
+// information they computed for a ROW and to only update it for ROWs that changed.
+// NOTE: Modifications made through the non-const Attributes() accessor aren't tracked.
+uint64_t ROW::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+static std::atomic<uint64_t> s_generation{ 0 };
+
+// Returns the most recently handed out generation. Any ROW modified after
+// this call is guaranteed to have a GetGeneration() larger than this value.
+uint64_t ROW::GetLatestGeneration() noexcept
+{
+    return s_generation.load(std::memory_order_relaxed);
+}
+
+// Hands out a new, process-wide unique generation.
+uint64_t ROW::NextGeneration() noexcept
+{
+    return s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void ROW::_bumpGeneration() noexcept
+{
+    _generation = NextGeneration();
+}
+
 til::small_rle<TextAttribute, uint16_t, 1>& ROW::Attributes() noexcept
 {
     return _attr;
@@ -882,23 +1223,310 @@ std::wstring_view ROW::GetText() const noexcept
     return { _chars.data(), _charSize() };
 }
 
-DelimiterClass ROW::DelimiterClassAt(til::CoordType column, const std::wstring_view& wordDelimiters) const noexcept
+// Returns the first column of the glyph that the given offset into GetText() belongs to.
+// The offset is clamped to the valid range [0, GetText().size()).
+til::CoordType ROW::GetLeadingColumnAtCharOffset(const ptrdiff_t offset) const noexcept
 {
-    const auto col = _clampedColumn(column);
-    // Safety: col is [0, _columnCount).
-    const auto glyph = _uncheckedChar(_uncheckedCharOffset(col));
+    return _adjustBackward(_columnPastCharOffset(offset) - 1);
+}
 
-    if (glyph <= L' ')
+// Returns the last column of the glyph that the given offset into GetText() belongs to.
+// The offset is clamped to the valid range [0, GetText().size()).
+til::CoordType ROW::GetTrailingColumnAtCharOffset(const ptrdiff_t offset) const noexcept
+{
+    return _columnPastCharOffset(offset) - 1;
+}
+
+// Returns the first column past the glyph that the given offset into GetText() belongs to.
+uint16_t ROW::_columnPastCharOffset(const ptrdiff_t offset) const noexcept
+{
+    const auto off = gsl::narrow_cast<uint16_t>(std::clamp<ptrdiff_t>(offset, 0, std::max(0, _charSize() - 1)));
+
+    // _charOffsets is sorted, which allows us to binary search for the first column that starts past the offset.
+    // The first column always has an offset of 0 and so this will return a value in the range [1, _columnCount].
+    uint16_t lo = 1;
+    uint16_t hi = _columnCount;
+    while (lo < hi)
+    {
+        const auto mid = gsl::narrow_cast<uint16_t>((lo + hi) / 2);
+        if (_uncheckedCharOffset(mid) <= off)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+WordDelimiters::WordDelimiters(const std::wstring_view& delimiters)
+{
+    for (const auto ch : delimiters)
+    {
+        // Control characters and whitespace classify as DelimiterClass::ControlChar
+        // no matter whether they're in the list, so they're not stored at all.
+        if (ch <= L' ')
+        {
+            continue;
+        }
+        if (ch < 0x80)
+        {
+            til::at(_ascii, ch & 15) |= gsl::narrow_cast<uint8_t>(1u << (ch >> 4));
+        }
+        else
+        {
+            _other.push_back(ch);
+        }
+    }
+
+    std::sort(_other.begin(), _other.end());
+    _other.erase(std::unique(_other.begin(), _other.end()), _other.end());
+}
+
+DelimiterClass WordDelimiters::Classify(const wchar_t ch) const noexcept
+{
+    if (ch <= L' ')
     {
         return DelimiterClass::ControlChar;
     }
-    else if (wordDelimiters.find(glyph) != std::wstring_view::npos)
+
+    bool delimiter;
+    if (ch < 0x80)
     {
-        return DelimiterClass::DelimiterChar;
+        delimiter = ((til::at(_ascii, ch & 15) >> (ch >> 4)) & 1) != 0;
     }
     else
     {
-        return DelimiterClass::RegularChar;
+        delimiter = std::binary_search(_other.begin(), _other.end(), ch);
+    }
+    return delimiter ? DelimiterClass::DelimiterChar : DelimiterClass::RegularChar;
+}
+
+#if defined(TIL_SSE_INTRINSICS)
+
+// Returns a 16-bit mask with 2 bits set for each of the 8 characters in vec that are
+// NOT of class cls. Non-ASCII characters are always reported, as _ascii can't classify them.
+static int delimiterMismatchMask(const __m128i vec, const __m128i asciiTable, const DelimiterClass cls) noexcept
+{
+    // The bit (ch >> 4) selects the row within the _ascii entry for (ch & 15).
+    // Indices 8-15 only occur for non-ASCII characters (after saturation) and map to 0.
+    const auto bitTable = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const auto nibbleMask = _mm_set1_epi8(0x0f);
+
+    const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(vec, _mm_set1_epi16(-0x80)), _mm_setzero_si128());
+    const auto control = _mm_and_si128(ascii, _mm_cmplt_epi16(vec, _mm_set1_epi16(0x21)));
+
+    const auto bytes = _mm_packus_epi16(vec, vec);
+    const auto row = _mm_shuffle_epi8(asciiTable, _mm_and_si128(bytes, nibbleMask));
+    const auto bit = _mm_shuffle_epi8(bitTable, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibbleMask));
+    const auto notDelimiter8 = _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+    const auto notDelimiter = _mm_unpacklo_epi8(notDelimiter8, notDelimiter8);
+    const auto delimiter = _mm_andnot_si128(notDelimiter, ascii);
+    const auto regular = _mm_andnot_si128(_mm_or_si128(control, delimiter), ascii);
+
+    __m128i match;
+    switch (cls)
+    {
+    case DelimiterClass::ControlChar:
+        match = control;
+        break;
+    case DelimiterClass::DelimiterChar:
+        match = delimiter;
+        break;
+    default:
+        match = regular;
+        break;
+    }
+    return _mm_movemask_epi8(match) ^ 0xffff;
+}
+
+#endif
+
+// Routine Description:
+// - Returns the first character in [beg, end) that is not of the given class.
+// Arguments:
+// - beg, end - The characters to scan.
+// - cls - The class of the characters to skip.
+// Return Value:
+// - The first character that isn't of class cls, or end if there's none.
+const wchar_t* WordDelimiters::SkipForward(const wchar_t* beg, const wchar_t* end, const DelimiterClass cls) const noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    auto it = beg;
+
+#if defined(TIL_SSE_INTRINSICS)
+    const auto simd = __isa_available >= __ISA_AVAILABLE_SSE42;
+    const auto asciiTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_ascii.data()));
+#endif
+
+    while (it != end)
+    {
+#if defined(TIL_SSE_INTRINSICS)
+        if (simd && end - it >= 8)
+        {
+            const auto mask = delimiterMismatchMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)), asciiTable, cls);
+            if (!mask)
+            {
+                it += 8;
+                continue;
+            }
+            // Non-ASCII characters are flagged as well, so the candidate is re-checked below.
+            unsigned long index;
+            _BitScanForward(&index, gsl::narrow_cast<unsigned long>(mask));
+            it += index / 2;
+        }
+#endif
+        if (Classify(*it) != cls)
+        {
+            break;
+        }
+        ++it;
+    }
+
+    return it;
+
+#pragma warning(pop)
+}
+
+// Routine Description:
+// - The counterpart to SkipForward(): Skips all characters of the given class at the end of [beg, end).
+// Arguments:
+// - beg, end - The characters to scan.
+// - cls - The class of the characters to skip.
+// Return Value:
+// - The start of the run of characters of class cls that ends at end. beg if all of them are of class cls.
+const wchar_t* WordDelimiters::SkipBackward(const wchar_t* beg, const wchar_t* end, const DelimiterClass cls) const noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    auto it = end;
+
+#if defined(TIL_SSE_INTRINSICS)
+    const auto simd = __isa_available >= __ISA_AVAILABLE_SSE42;
+    const auto asciiTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_ascii.data()));
+#endif
+
+    while (it != beg)
+    {
+#if defined(TIL_SSE_INTRINSICS)
+        if (simd && it - beg >= 8)
+        {
+            const auto mask = delimiterMismatchMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it - 8)), asciiTable, cls);
+            if (!mask)
+            {
+                it -= 8;
+                continue;
+            }
+            // Move it to just past the last flagged character, so that it gets re-checked below.
+            unsigned long index;
+            _BitScanReverse(&index, gsl::narrow_cast<unsigned long>(mask));
+            it -= 8 - index / 2 - 1;
+        }
+#endif
+        if (Classify(it[-1]) != cls)
+        {
+            break;
+        }
+        --it;
+    }
+
+    return it;
+
+#pragma warning(pop)
+}
+
+DelimiterClass ROW::DelimiterClassAt(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept
+{
+    const auto col = _clampedColumn(column);
+    // Safety: col is [0, _columnCount).
+    const auto glyph = _uncheckedChar(_uncheckedCharOffset(col));
+    return wordDelimiters.Classify(glyph);
+}
+
+// Routine Description:
+// - Returns the first column of the run of glyphs around the given column, which all have the same DelimiterClass.
+//   This is what double-click selection expands to on the left.
+// Arguments:
+// - column - The column to start searching from.
+// - wordDelimiters - The delimiters that make up DelimiterClass::DelimiterChar.
+// Return Value:
+// - The leading column of the first glyph in the run.
+til::CoordType ROW::GetDelimiterRunStart(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept
+{
+    auto col = _adjustBackward(_clampedColumn(column));
+    const auto cls = DelimiterClassAt(col, wordDelimiters);
+    const auto chars = _chars.data();
+
+    for (;;)
+    {
+        // All characters in [beg, chars + off) are of class cls. If that's all of them, the run extends to the start of the row.
+        // Otherwise, the character just before beg belongs to a glyph of a different class, or it's a combining mark
+        // or similar in a glyph that still belongs to the run, in which case we keep going in front of that glyph.
+        const auto off = _uncheckedCharOffset(col);
+        const auto beg = wordDelimiters.SkipBackward(chars, chars + off, cls);
+        if (beg == chars)
+        {
+            return 0;
+        }
+
+        const auto past = _columnPastCharOffset(beg - chars - 1);
+        const auto glyphCol = _adjustBackward(past - 1);
+        if (DelimiterClassAt(glyphCol, wordDelimiters) != cls)
+        {
+            return past;
+        }
+        if (glyphCol == 0)
+        {
+            return 0;
+        }
+        col = glyphCol;
+    }
+}
+
+// Routine Description:
+// - Returns the last column of the run of glyphs around the given column, which all have the same DelimiterClass.
+//   This is what double-click selection expands to on the right.
+// Arguments:
+// - column - The column to start searching from.
+// - wordDelimiters - The delimiters that make up DelimiterClass::DelimiterChar.
+// Return Value:
+// - The last column (inclusive) of the last glyph in the run.
+til::CoordType ROW::GetDelimiterRunEnd(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept
+{
+    auto col = _clampedColumn(column);
+    const auto cls = DelimiterClassAt(col, wordDelimiters);
+    const auto chars = _chars.data();
+    const auto charsEnd = chars + _charSize();
+
+    for (;;)
+    {
+        // Same as in GetDelimiterRunStart(), but in the other direction:
+        // All characters in [chars + off, end) are of class cls.
+        const auto off = _uncheckedCharOffset(col);
+        const auto end = wordDelimiters.SkipForward(chars + off, charsEnd, cls);
+        if (end == charsEnd)
+        {
+            return _columnCount - 1;
+        }
+
+        const auto past = _columnPastCharOffset(end - chars);
+        const auto glyphCol = _adjustBackward(past - 1);
+        if (DelimiterClassAt(glyphCol, wordDelimiters) != cls)
+        {
+            return glyphCol - 1;
+        }
+        if (past >= _columnCount)
+        {
+            return _columnCount - 1;
+        }
+        col = past;
     }
 }
 
@@ -22,6 +22,7 @@ Revision History:
 
 #include <til/rle.h>
 
+#include "ImageSlice.hpp"
 #include "LineRendition.hpp"
 #include "OutputCell.hpp"
 #include "OutputCellIterator.hpp"
@@ -36,6 +37,29 @@ enum class DelimiterClass
     RegularChar
 };
 
+// The word delimiters of a TextBuffer, compiled for fast classification of characters.
+// ASCII delimiters are stored in a 128-bit bitmap, which doubles as a lookup table for
+// SSSE3's pshufb, so that entire rows can be classified 8 characters at a time.
+// All others are stored in a sorted string that's binary searched.
+class WordDelimiters
+{
+public:
+    WordDelimiters() = default;
+    // Implicit, so that callers can continue to pass a plain string.
+    WordDelimiters(const std::wstring_view& delimiters);
+
+    DelimiterClass Classify(wchar_t ch) const noexcept;
+    const wchar_t* SkipForward(const wchar_t* beg, const wchar_t* end, DelimiterClass cls) const noexcept;
+    const wchar_t* SkipBackward(const wchar_t* beg, const wchar_t* end, DelimiterClass cls) const noexcept;
+
+    bool operator==(const WordDelimiters& other) const noexcept = default;
+
+private:
+    // Bit (ch >> 4) of _ascii[ch & 15] is set if the ASCII character ch is a delimiter.
+    std::array<uint8_t, 16> _ascii{};
+    std::wstring _other;
+};
+
 struct RowWriteState
 {
     // The text you want to write into the given ROW. When ReplaceText() returns,
@@ -123,6 +147,9 @@ public:
     bool WasDoubleBytePadded() const noexcept;
     void SetLineRendition(const LineRendition lineRendition) noexcept;
     LineRendition GetLineRendition() const noexcept;
+    const ImageSlice* GetImageSlice() const noexcept;
+    ImageSlice* GetMutableImageSlice() noexcept;
+    void SetImageSlice(ImageSlice::Pointer imageSlice) noexcept;
 
     void Reset(const TextAttribute& attr) noexcept;
     void TransferAttributes(const til::small_rle<TextAttribute, uint16_t, 1>& attr, til::CoordType newWidth);
@@ -133,10 +160,14 @@ public:
 
     void ClearCell(til::CoordType column);
     OutputCellIterator WriteCells(OutputCellIterator it, til::CoordType columnBegin, std::optional<bool> wrap = std::nullopt, std::optional<til::CoordType> limitRight = std::nullopt);
+    bool WriteCharInfos(til::CoordType columnBegin, std::span<const CHAR_INFO> infos);
+    void ReadCharInfos(til::CoordType columnBegin, std::span<CHAR_INFO> infos) const;
     void SetAttrToEnd(til::CoordType columnBegin, TextAttribute attr);
     void ReplaceAttributes(til::CoordType beginIndex, til::CoordType endIndex, const TextAttribute& newAttr);
+    void ReplaceAttributes(std::span<const til::small_rle<TextAttribute, uint16_t, 1>::range_replacement> replacements);
     void ReplaceCharacters(til::CoordType columnBegin, til::CoordType width, const std::wstring_view& chars);
     void ReplaceText(RowWriteState& state);
+    void FillText(RowWriteState& state);
     void CopyTextFrom(RowCopyTextFromState& state);
 
     til::small_rle<TextAttribute, uint16_t, 1>& Attributes() noexcept;
@@ -151,11 +182,23 @@ public:
     std::wstring_view GlyphAt(til::CoordType column) const noexcept;
     DbcsAttribute DbcsAttrAt(til::CoordType column) const noexcept;
     std::wstring_view GetText() const noexcept;
-    DelimiterClass DelimiterClassAt(til::CoordType column, const std::wstring_view& wordDelimiters) const noexcept;
+    til::CoordType GetLeadingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
+    til::CoordType GetTrailingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
+    DelimiterClass DelimiterClassAt(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept;
+    til::CoordType GetDelimiterRunStart(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept;
+    til::CoordType GetDelimiterRunEnd(til::CoordType column, const WordDelimiters& wordDelimiters) const noexcept;
+
+    uint64_t GetGeneration() const noexcept;
+    static uint64_t GetLatestGeneration() noexcept;
+    static uint64_t NextGeneration() noexcept;
 
     auto AttrBegin() const noexcept { return _attr.begin(); }
     auto AttrEnd() const noexcept { return _attr.end(); }
 
+    // ScrollbackArchive and BufferSnapshot encode and decode the internal state of ROWs.
+    friend class ScrollbackArchive;
+    friend class BufferSnapshot;
+
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
     friend class RowTests;
@@ -170,9 +213,14 @@ private:
         bool IsValid() const noexcept;
         void ReplaceCharacters(til::CoordType width) noexcept;
         void ReplaceText() noexcept;
+        void ReplaceCharInfos(std::span<const CHAR_INFO> infos) noexcept;
+        void FillText() noexcept;
         void CopyTextFrom(const std::span<const uint16_t>& charOffsets) noexcept;
         static void _copyOffsets(uint16_t* dst, const uint16_t* src, uint16_t size, uint16_t offset) noexcept;
         void Finish();
+        void FinishFill();
+        void _finishResize();
+        void _finishPadding() noexcept;
 
         // Parent pointer.
         ROW& row;
@@ -222,6 +270,7 @@ private:
 
     uint16_t _adjustBackward(uint16_t column) const noexcept;
     uint16_t _adjustForward(uint16_t column) const noexcept;
+    uint16_t _columnPastCharOffset(ptrdiff_t offset) const noexcept;
 
     wchar_t _uncheckedChar(size_t off) const noexcept;
     uint16_t _charSize() const noexcept;
@@ -229,6 +278,7 @@ private:
     bool _uncheckedIsTrailer(size_t col) const noexcept;
 
     void _init() noexcept;
+    void _bumpGeneration() noexcept;
     void _resizeChars(uint16_t colEndDirty, uint16_t chBegDirty, size_t chEndDirty, uint16_t chEndDirtyOld);
 
     // These fields are a bit "wasteful", but it makes all this a bit more robust against
@@ -274,10 +324,16 @@ private:
     // _attr is a run-length-encoded vector of TextAttribute with a decompressed
     // length equal to _columnCount (= 1 TextAttribute per column).
     til::small_rle<TextAttribute, uint16_t, 1> _attr;
+    // A process-wide unique value that changes whenever the text or attributes of this row are modified.
+    // Since it's unique across all ROWs, it can be used as a cache key that remains valid when ROWs are
+    // scrolled around, and is never mistaken for the contents of another ROW. See GetGeneration().
+    uint64_t _generation = 0;
     // The width of the row in visual columns.
     uint16_t _columnCount = 0;
     // Stores double-width/height (DECSWL/DECDWL/DECDHL) attributes.
     LineRendition _lineRendition = LineRendition::SingleWidth;
+    // The part of an image (such as a sixel graphic) that covers this row, if any.
+    ImageSlice::Pointer _imageSlice;
     // Occurs when the user runs out of text in a given row and we're forced to wrap the cursor to the next line
     bool _wrapForced = false;
     // Occurs when the user runs out of text to support a double byte character and we're forced to the next line
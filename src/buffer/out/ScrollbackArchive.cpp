@@ -0,0 +1,437 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ScrollbackArchive.hpp"
+
+#include <til/hash.h>
+#include <til/unicode.h>
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// The archive reserves address space for at least this many bytes and commits it in commitChunkSize steps.
+static constexpr size_t initialCapacity = 1024 * 1024;
+static constexpr size_t commitChunkSize = 64 * 1024;
+
+static constexpr uint8_t flagWrapForced = 0x01;
+static constexpr uint8_t flagDoubleBytePadded = 0x02;
+// The ROW's _charOffsets are 0, 1, 2, ... (= only narrow glyphs of 1 wchar_t each) and weren't stored.
+static constexpr uint8_t flagTrivialOffsets = 0x04;
+// The ROW contains unpaired surrogates, which don't survive a round-trip through UTF-8.
+static constexpr uint8_t flagUtf16Text = 0x08;
+// The attribute table is full and the runs were stored as plain AttributeRuns instead of InternedRuns.
+static constexpr uint8_t flagPlainRuns = 0x10;
+// The text is pure ASCII and was stored 1 byte per wchar_t. Load() widens it without decoding UTF-8.
+static constexpr uint8_t flagAsciiText = 0x20;
+
+static constexpr size_t alignRecord(size_t size) noexcept
+{
+    return (size + 7) & ~size_t{ 7 };
+}
+
+static constexpr size_t alignCommit(size_t size) noexcept
+{
+    return (size + commitChunkSize - 1) & ~(commitChunkSize - 1);
+}
+
+// Narrows the given text into `out`, if it's pure ASCII. Returns false otherwise, with `out` in an unspecified state.
+static bool narrowAscii(const std::wstring_view& text, std::string& out)
+{
+    out.resize(text.size());
+    wchar_t combined = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const auto ch = til::at(text, i);
+        combined |= ch;
+        til::at(out, i) = static_cast<char>(ch);
+    }
+    return combined < 0x80;
+}
+
+static bool isValidUtf16(const std::wstring_view& text) noexcept
+{
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const auto ch = til::at(text, i);
+        if (til::is_leading_surrogate(ch) && i + 1 < text.size() && til::is_trailing_surrogate(til::at(text, i + 1)))
+        {
+            ++i;
+        }
+        else if (til::is_surrogate(ch))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScrollbackArchive::Empty() const noexcept
+{
+    return _count == 0;
+}
+
+size_t ScrollbackArchive::Count() const noexcept
+{
+    return _count;
+}
+
+// Returns the number of bytes committed for the archived ROWs, plus the bookkeeping that goes with them.
+size_t ScrollbackArchive::GetMemoryUsage() const noexcept
+{
+    return _committed +
+           _entries.capacity() * sizeof(Entry) +
+           _attributes.capacity() * sizeof(TextAttribute) * 2 +
+           _interned.capacity() * sizeof(InternedRun) +
+           _runs.capacity() * sizeof(AttributeRun) +
+           _utf8.capacity() +
+           _utf16.capacity() * sizeof(wchar_t);
+}
+
+// Encodes the given ROW and stores it under the given offset, replacing any previous record.
+// The ROW itself is left untouched: It's up to the caller to destroy it and release its memory.
+void ScrollbackArchive::Store(const size_t offset, const ROW& row)
+{
+    const auto columns = row._columnCount;
+    const auto charCount = row._charSize();
+    const auto& runs = row._attr.runs();
+    std::wstring_view text{ row._chars.data(), charCount };
+
+    uint8_t flags = 0;
+    if (row._wrapForced)
+    {
+        flags |= flagWrapForced;
+    }
+    if (row._doubleBytePadded)
+    {
+        flags |= flagDoubleBytePadded;
+    }
+
+    if (charCount == columns)
+    {
+        uint16_t col = 0;
+        for (; col < columns && row._charOffsets[col] == col; ++col)
+        {
+        }
+        if (col == columns)
+        {
+            flags |= flagTrivialOffsets;
+            // Most rows in the scrollback are mostly whitespace. If every column holds exactly one wchar_t,
+            // trailing whitespace can be trimmed, because Load() can trivially infer it again.
+            text = text.substr(0, text.find_last_not_of(L' ') + 1);
+        }
+    }
+
+    // Most of the scrollback is plain ASCII. Narrowing it is a lot cheaper than
+    // running it through the UTF-8 encoder and it's trivially undone in Load().
+    std::span<const std::byte> payload;
+    if (narrowAscii(text, _utf8))
+    {
+        flags |= flagAsciiText;
+        payload = std::as_bytes(std::span{ _utf8 });
+    }
+    else if (isValidUtf16(text))
+    {
+        THROW_IF_FAILED(til::u16u8(text, _utf8));
+        payload = std::as_bytes(std::span{ _utf8 });
+    }
+    else
+    {
+        flags |= flagUtf16Text;
+        payload = std::as_bytes(std::span{ text });
+    }
+
+    const std::span<const AttributeRun> runsSpan{ runs.data(), runs.size() };
+    std::span<const std::byte> runsPayload;
+    if (_intern(runsSpan))
+    {
+        runsPayload = std::as_bytes(std::span{ _interned });
+    }
+    else
+    {
+        flags |= flagPlainRuns;
+        runsPayload = std::as_bytes(runsSpan);
+    }
+
+    const auto runsSize = runsPayload.size();
+    const auto offsetsSize = (flags & flagTrivialOffsets) ? 0 : (columns + size_t{ 1 }) * sizeof(uint16_t);
+    const auto size = alignRecord(sizeof(Header) + runsSize + offsetsSize + payload.size());
+
+    const Header header{
+        .generation = row._generation,
+        .columnCount = columns,
+        .charCount = charCount,
+        .runCount = gsl::narrow<uint16_t>(runs.size()),
+        .flags = flags,
+        .lineRendition = static_cast<uint8_t>(row._lineRendition),
+        .textSize = gsl::narrow<uint32_t>(payload.size()),
+    };
+
+    if (offset >= _entries.size())
+    {
+        _entries.resize(offset + 1);
+    }
+
+    auto p = _allocate(size);
+    const auto position = gsl::narrow_cast<size_t>(p - _view.get());
+
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, runsPayload.data(), runsSize);
+    p += runsSize;
+    memcpy(p, row._charOffsets.data(), offsetsSize);
+    p += offsetsSize;
+    memcpy(p, payload.data(), payload.size());
+
+    Discard(offset);
+    til::at(_entries, offset) = { position, gsl::narrow_cast<uint32_t>(size) };
+    _live += size;
+    _count++;
+}
+
+// Decodes the record stored under the given offset into a freshly constructed ROW of the same width
+// and removes it from the archive. The record is removed even if decoding fails, in which case the
+// ROW might be left partially blank. This ensures that the ROW and the archive never disagree.
+void ScrollbackArchive::Load(const size_t offset, ROW& row)
+{
+    const auto entry = til::at(_entries, offset);
+    // The entry is only removed once the ROW is fully decoded, because concurrent readers
+    // will use the ROW without any further synchronization as soon as Contains() returns false.
+    const auto discard = wil::scope_exit([&]() noexcept {
+        Discard(offset);
+    });
+
+    const auto* p = _view.get() + entry.position;
+    Header header;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+
+    THROW_HR_IF(E_UNEXPECTED, header.columnCount != row._columnCount);
+
+    // Records are 8-byte aligned and the Header is a multiple of 2 bytes
+    // large, which ensures that the runs are sufficiently aligned.
+    std::span<const AttributeRun> runs;
+    if (header.flags & flagPlainRuns)
+    {
+        runs = { reinterpret_cast<const AttributeRun*>(p), header.runCount };
+        p += runs.size_bytes();
+    }
+    else
+    {
+        const std::span interned{ reinterpret_cast<const InternedRun*>(p), header.runCount };
+        p += interned.size_bytes();
+
+        _runs.clear();
+        for (const auto& run : interned)
+        {
+            _runs.emplace_back(til::at(_attributes, run.id), run.length);
+        }
+        runs = _runs;
+    }
+
+    if (header.flags & flagTrivialOffsets)
+    {
+        std::iota(row._charOffsets.begin(), row._charOffsets.end(), uint16_t{ 0 });
+    }
+    else
+    {
+        memcpy(row._charOffsets.data(), p, row._charOffsets.size_bytes());
+        p += row._charOffsets.size_bytes();
+    }
+
+    if (header.charCount > row._chars.size())
+    {
+        row._charsHeap = std::make_unique_for_overwrite<wchar_t[]>(header.charCount);
+        row._chars = { row._charsHeap.get(), header.charCount };
+    }
+
+    const auto chars = row._chars.first(header.charCount);
+    size_t written = 0;
+
+    if (header.flags & flagUtf16Text)
+    {
+        written = std::min<size_t>(header.textSize / sizeof(wchar_t), chars.size());
+        memcpy(chars.data(), p, written * sizeof(wchar_t));
+    }
+    else if (header.flags & flagAsciiText)
+    {
+        written = std::min<size_t>(header.textSize, chars.size());
+        const auto bytes = reinterpret_cast<const uint8_t*>(p);
+        std::copy_n(bytes, written, chars.begin());
+    }
+    else
+    {
+        THROW_IF_FAILED(til::u8u16({ reinterpret_cast<const char*>(p), header.textSize }, _utf16));
+        written = std::min(_utf16.size(), chars.size());
+        std::copy_n(_utf16.begin(), written, chars.begin());
+    }
+
+    std::fill(chars.begin() + written, chars.end(), L' ');
+
+    row._attr.replace(0, row._attr.size(), runs);
+    row._lineRendition = static_cast<LineRendition>(header.lineRendition);
+    row._wrapForced = (header.flags & flagWrapForced) != 0;
+    row._doubleBytePadded = (header.flags & flagDoubleBytePadded) != 0;
+    row._generation = header.generation;
+}
+
+// Returns the same as ROW::GetGeneration() would for the archived ROW, without restoring it.
+uint64_t ScrollbackArchive::GetGeneration(const size_t offset) const noexcept
+{
+    Header header;
+    memcpy(&header, _view.get() + til::at(_entries, offset).position, sizeof(header));
+    return header.generation;
+}
+
+// Returns the same as ROW::GetHyperlinks() would for the archived ROW, without restoring it.
+std::vector<uint16_t> ScrollbackArchive::GetHyperlinks(const size_t offset) const
+{
+    const auto p = _view.get() + til::at(_entries, offset).position;
+    Header header;
+    memcpy(&header, p, sizeof(header));
+
+    std::vector<uint16_t> ids;
+    const auto collect = [&](const TextAttribute& attr) {
+        if (attr.IsHyperlink())
+        {
+            ids.emplace_back(attr.GetHyperlinkId());
+        }
+    };
+
+    if (header.flags & flagPlainRuns)
+    {
+        for (const auto& run : std::span{ reinterpret_cast<const AttributeRun*>(p + sizeof(header)), header.runCount })
+        {
+            collect(run.value);
+        }
+    }
+    else
+    {
+        for (const auto& run : std::span{ reinterpret_cast<const InternedRun*>(p + sizeof(header)), header.runCount })
+        {
+            collect(til::at(_attributes, run.id));
+        }
+    }
+    return ids;
+}
+
+// Forgets about the ROW stored under the given offset, if any.
+void ScrollbackArchive::Discard(const size_t offset) noexcept
+{
+    if (Contains(offset))
+    {
+        auto& entry = til::at(_entries, offset);
+        _live -= entry.size;
+        _count--;
+        // The record itself stays intact until the next _grow(). This is the store that Contains() synchronizes with.
+        std::atomic_ref{ entry.size }.store(0, std::memory_order_release);
+    }
+}
+
+// Forgets about all ROWs and releases all memory.
+void ScrollbackArchive::Clear() noexcept
+{
+    _view.reset();
+    _section.reset();
+    _capacity = 0;
+    _committed = 0;
+    _used = 0;
+    _live = 0;
+    _count = 0;
+    _entries = {};
+    _attributes = {};
+    _attributeIds = {};
+}
+
+// Translates the given runs into _interned, adding any new attributes to the table.
+// Returns false if the table is full, in which case the runs need to be stored as is.
+bool ScrollbackArchive::_intern(const std::span<const AttributeRun> runs)
+{
+    _interned.clear();
+
+    for (const auto& run : runs)
+    {
+        auto it = _attributeIds.find(run.value);
+        if (it == _attributeIds.end())
+        {
+            if (_attributes.size() > std::numeric_limits<uint16_t>::max())
+            {
+                return false;
+            }
+
+            const auto id = gsl::narrow_cast<uint16_t>(_attributes.size());
+            _attributes.emplace_back(run.value);
+            it = _attributeIds.emplace(run.value, id).first;
+        }
+
+        _interned.push_back({ it->second, run.length });
+    }
+
+    return true;
+}
+
+// Returns a pointer to size-many bytes at the end of the section, growing it if needed.
+std::byte* ScrollbackArchive::_allocate(const size_t size)
+{
+    if (_capacity - _used < size)
+    {
+        _grow(size);
+    }
+
+    const auto end = _used + size;
+    if (end > _committed)
+    {
+        const auto committed = std::min(_capacity, alignCommit(end));
+        THROW_LAST_ERROR_IF_NULL(VirtualAlloc(_view.get() + _committed, committed - _committed, MEM_COMMIT, PAGE_READWRITE));
+        _committed = committed;
+    }
+
+    const auto p = _view.get() + _used;
+    _used = end;
+    return p;
+}
+
+// Creates a new section that fits all live records plus minimumCapacity more bytes and moves the records over.
+// Since this also drops all garbage, this is effectively a compaction, which is why the section is only
+// doubled in size if less than half of it is garbage. Sections can't be shrunk or partially decommitted.
+void ScrollbackArchive::_grow(const size_t minimumCapacity)
+{
+    auto capacity = std::max(initialCapacity, _live * 2 <= _used ? _capacity : _capacity * 2);
+    while (capacity < _live + minimumCapacity)
+    {
+        capacity *= 2;
+    }
+
+    const auto capacity64 = ::base::strict_cast<uint64_t>(capacity);
+    wil::unique_handle section{ CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_RESERVE, gsl::narrow_cast<DWORD>(capacity64 >> 32), gsl::narrow_cast<DWORD>(capacity64), nullptr) };
+    THROW_LAST_ERROR_IF(!section);
+
+    wil::unique_mapview_ptr<std::byte> view{ static_cast<std::byte*>(MapViewOfFile(section.get(), FILE_MAP_WRITE, 0, 0, capacity)) };
+    THROW_LAST_ERROR_IF(!view);
+
+    const auto committed = std::min(capacity, alignCommit(_live));
+    if (committed)
+    {
+        THROW_LAST_ERROR_IF_NULL(VirtualAlloc(view.get(), committed, MEM_COMMIT, PAGE_READWRITE));
+    }
+
+    size_t used = 0;
+    for (auto& entry : _entries)
+    {
+        if (entry.size)
+        {
+            memcpy(view.get() + used, _view.get() + entry.position, entry.size);
+            entry.position = used;
+            used += entry.size;
+        }
+    }
+
+    _section = std::move(section);
+    _view = std::move(view);
+    _capacity = capacity;
+    _committed = committed;
+    _used = used;
+}
+
+#pragma warning(pop)
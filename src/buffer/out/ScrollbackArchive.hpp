@@ -0,0 +1,115 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollbackArchive.hpp
+
+Abstract:
+- Stores ROWs that are far away from the viewport in a compact form, so that
+  TextBuffer can decommit the memory they occupy in its ROW arena.
+- A ROW is encoded as its generation, its line flags, its run-length encoded attributes, its
+  column-to-character offsets (only if they aren't trivial) and its text as
+  UTF-8 (without trailing whitespace). Pure ASCII text, which is most of it,
+  is narrowed to 1 byte per character instead, which is cheaper to undo. The attributes are interned into a
+  table shared by all records, so that each run only takes up 4 bytes. The resulting records are appended to
+  a pagefile-backed section, which the OS is free to page out.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+class ScrollbackArchive final
+{
+public:
+    ScrollbackArchive() = default;
+
+    ScrollbackArchive(const ScrollbackArchive&) = delete;
+    ScrollbackArchive& operator=(const ScrollbackArchive&) = delete;
+
+    ScrollbackArchive(ScrollbackArchive&&) = default;
+    ScrollbackArchive& operator=(ScrollbackArchive&&) = default;
+
+    // Returns true if the ROW at the given TextBuffer offset has been archived.
+    // This is called for every ROW access and as such inlined into the header.
+    // Readers may call this while another reader restores the ROW, hence the atomic load. See Discard().
+    bool Contains(const size_t offset) const noexcept
+    {
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+        return offset < _entries.size() && std::atomic_ref{ const_cast<uint32_t&>(til::at(_entries, offset).size) }.load(std::memory_order_acquire) != 0;
+    }
+
+    bool Empty() const noexcept;
+    size_t Count() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    void Store(size_t offset, const ROW& row);
+    void Load(size_t offset, ROW& row);
+    std::vector<uint16_t> GetHyperlinks(size_t offset) const;
+    uint64_t GetGeneration(size_t offset) const noexcept;
+    void Discard(size_t offset) noexcept;
+    void Clear() noexcept;
+
+private:
+    using AttributeRun = til::rle_pair<TextAttribute, uint16_t>;
+
+    struct Header
+    {
+        // The ROW's generation is restored by Load(), as its contents don't change.
+        uint64_t generation;
+        uint16_t columnCount;
+        uint16_t charCount;
+        uint16_t runCount;
+        uint8_t flags;
+        uint8_t lineRendition;
+        uint32_t textSize;
+    };
+
+    struct Entry
+    {
+        size_t position = 0;
+        uint32_t size = 0;
+    };
+
+    // An AttributeRun with the attribute replaced by its index in _attributes.
+    struct InternedRun
+    {
+        uint16_t id;
+        uint16_t length;
+    };
+
+    struct AttributeHasher
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            return til::hash(&attr, sizeof(attr));
+        }
+    };
+
+    bool _intern(std::span<const AttributeRun> runs);
+    std::byte* _allocate(size_t size);
+    void _grow(size_t minimumCapacity);
+
+    // A pagefile-backed section, created with SEC_RESERVE and committed incrementally.
+    wil::unique_handle _section;
+    wil::unique_mapview_ptr<std::byte> _view;
+    size_t _capacity = 0;
+    size_t _committed = 0;
+    size_t _used = 0;
+    // The sum of Entry::size over all _entries. The difference to _used is
+    // garbage left behind by Load() and Discard(), which _grow() compacts.
+    size_t _live = 0;
+    size_t _count = 0;
+    // Indexed by TextBuffer's ROW offset (the scratchpad ROW being offset 0).
+    std::vector<Entry> _entries;
+    // All distinct attributes of the stored ROWs and the reverse mapping back
+    // to their index. They're only ever appended to, until the next Clear().
+    std::vector<TextAttribute> _attributes;
+    std::unordered_map<TextAttribute, uint16_t, AttributeHasher> _attributeIds;
+    // Scratch space for Store() and Load().
+    std::vector<InternedRun> _interned;
+    std::vector<AttributeRun> _runs;
+    std::string _utf8;
+    std::wstring _utf16;
+};
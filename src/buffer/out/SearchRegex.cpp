@@ -0,0 +1,776 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "SearchRegex.hpp"
+
+#include <til/mutex.h>
+
+// The builtin classes \d \D \w \W \s \S, which can be used on their own or inside brackets, as in [\w-].
+static constexpr uint8_t builtinDigit = 0x01;
+static constexpr uint8_t builtinNotDigit = 0x02;
+static constexpr uint8_t builtinWord = 0x04;
+static constexpr uint8_t builtinNotWord = 0x08;
+static constexpr uint8_t builtinSpace = 0x10;
+static constexpr uint8_t builtinNotSpace = 0x20;
+
+// Bounded repetitions are compiled by repeating their operand, and so a pattern
+// like "(a{1000}){1000}" would compile into a million instructions.
+static constexpr size_t maxProgramSize = 64 * 1024;
+static constexpr uint32_t maxRepeatCount = 1000;
+static constexpr uint32_t unbounded = UINT32_MAX;
+
+// The number of compiled patterns retained by SearchRegex::Compile().
+static constexpr size_t cacheSize = 8;
+
+static constexpr bool isDigit(const wchar_t ch) noexcept
+{
+    return ch >= L'0' && ch <= L'9';
+}
+
+// Unlike in ECMAScript, \w and \b don't just consider ASCII letters to be part of a word,
+// since the text in a terminal is just as likely to contain words in other scripts.
+static bool isWordChar(const wchar_t ch) noexcept
+{
+    return ch == L'_' || ::iswalnum(ch);
+}
+
+static bool isSpace(const wchar_t ch) noexcept
+{
+    return ::iswspace(ch);
+}
+
+static uint8_t builtinClass(const wchar_t ch) noexcept
+{
+    switch (ch)
+    {
+    case L'd':
+        return builtinDigit;
+    case L'D':
+        return builtinNotDigit;
+    case L'w':
+        return builtinWord;
+    case L'W':
+        return builtinNotWord;
+    case L's':
+        return builtinSpace;
+    case L'S':
+        return builtinNotSpace;
+    default:
+        return 0;
+    }
+}
+
+static int hexValue(const wchar_t ch) noexcept
+{
+    if (ch >= L'0' && ch <= L'9')
+    {
+        return ch - L'0';
+    }
+    if (ch >= L'a' && ch <= L'f')
+    {
+        return ch - L'a' + 10;
+    }
+    if (ch >= L'A' && ch <= L'F')
+    {
+        return ch - L'A' + 10;
+    }
+    return -1;
+}
+
+// Returns true if the raw set of characters (ignoring `negated`) contains ch.
+bool SearchRegex::CharClass::Contains(const wchar_t ch) const noexcept
+{
+    for (const auto& [lo, hi] : ranges)
+    {
+        if (ch >= lo && ch <= hi)
+        {
+            return true;
+        }
+    }
+
+    return (WI_IsFlagSet(builtins, builtinDigit) && isDigit(ch)) ||
+           (WI_IsFlagSet(builtins, builtinNotDigit) && !isDigit(ch)) ||
+           (WI_IsFlagSet(builtins, builtinWord) && isWordChar(ch)) ||
+           (WI_IsFlagSet(builtins, builtinNotWord) && !isWordChar(ch)) ||
+           (WI_IsFlagSet(builtins, builtinSpace) && isSpace(ch)) ||
+           (WI_IsFlagSet(builtins, builtinNotSpace) && !isSpace(ch));
+}
+
+// A recursive descent parser, which compiles the pattern into fragments of the program.
+// The jump targets in a fragment are relative to its start, so that fragments can
+// be concatenated and repeated by simply copying them and offsetting their targets.
+class SearchRegex::Parser final
+{
+public:
+    Parser(const std::wstring_view& pattern, SearchRegex& regex) noexcept :
+        _pattern{ pattern },
+        _regex{ regex }
+    {
+    }
+
+    // Returns false if the pattern is invalid or too large.
+    bool Parse()
+    {
+        auto program = _alternation();
+        if (!program || _pos != _pattern.size())
+        {
+            return false;
+        }
+
+        program->emplace_back(Inst{ .op = Op::Match });
+        _regex._program = std::move(*program);
+        return true;
+    }
+
+private:
+    using Fragment = std::vector<Inst>;
+
+    bool _eof() const noexcept
+    {
+        return _pos >= _pattern.size();
+    }
+
+    wchar_t _peek() const noexcept
+    {
+        return _eof() ? L'\0' : til::at(_pattern, _pos);
+    }
+
+    bool _consume(const wchar_t ch) noexcept
+    {
+        if (!_eof() && til::at(_pattern, _pos) == ch)
+        {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    static bool _append(Fragment& dst, const Fragment& src)
+    {
+        if (dst.size() + src.size() > maxProgramSize)
+        {
+            return false;
+        }
+
+        const auto base = gsl::narrow_cast<uint32_t>(dst.size());
+        for (auto inst : src)
+        {
+            if (inst.op == Op::Split || inst.op == Op::Jump)
+            {
+                inst.x += base;
+                inst.y += base;
+            }
+            dst.emplace_back(inst);
+        }
+        return true;
+    }
+
+    static Fragment _single(const Op op, const wchar_t ch = 0, const uint32_t x = 0)
+    {
+        return Fragment{ Inst{ .op = op, .ch = ch, .x = x } };
+    }
+
+    // alternation := concatenation ('|' concatenation)*
+    std::optional<Fragment> _alternation()
+    {
+        auto lhs = _concatenation();
+        if (!lhs || !_consume(L'|'))
+        {
+            return lhs;
+        }
+
+        auto rhs = _alternation();
+        if (!rhs)
+        {
+            return std::nullopt;
+        }
+
+        //     split L1, L2
+        // L1: <lhs>
+        //     jump end
+        // L2: <rhs>
+        // end:
+        const auto lhsSize = gsl::narrow_cast<uint32_t>(lhs->size());
+        const auto rhsSize = gsl::narrow_cast<uint32_t>(rhs->size());
+        Fragment fragment;
+        fragment.emplace_back(Inst{ .op = Op::Split, .x = 1, .y = lhsSize + 2 });
+        if (!_append(fragment, *lhs))
+        {
+            return std::nullopt;
+        }
+        fragment.emplace_back(Inst{ .op = Op::Jump, .x = lhsSize + rhsSize + 2 });
+        if (!_append(fragment, *rhs))
+        {
+            return std::nullopt;
+        }
+        return fragment;
+    }
+
+    // concatenation := repetition*
+    std::optional<Fragment> _concatenation()
+    {
+        Fragment fragment;
+        while (!_eof() && _peek() != L'|' && _peek() != L')')
+        {
+            const auto repetition = _repetition();
+            if (!repetition || !_append(fragment, *repetition))
+            {
+                return std::nullopt;
+            }
+        }
+        return fragment;
+    }
+
+    // repetition := atom ('*' | '+' | '?' | '{n}' | '{n,}' | '{n,m}')* with an optional '?' after each quantifier
+    std::optional<Fragment> _repetition()
+    {
+        auto atom = _atom();
+
+        while (atom)
+        {
+            uint32_t min = 0;
+            uint32_t max = unbounded;
+
+            if (_consume(L'*'))
+            {
+            }
+            else if (_consume(L'+'))
+            {
+                min = 1;
+            }
+            else if (_consume(L'?'))
+            {
+                max = 1;
+            }
+            else if (const auto bounds = _bounds())
+            {
+                std::tie(min, max) = *bounds;
+                if (min > max || min > maxRepeatCount || (max != unbounded && max > maxRepeatCount))
+                {
+                    return std::nullopt;
+                }
+            }
+            else
+            {
+                break;
+            }
+
+            // Lazy quantifiers make no difference for leftmost-longest matches.
+            _consume(L'?');
+            atom = _repeat(*atom, min, max);
+        }
+
+        return atom;
+    }
+
+    // Parses "{n}", "{n,}" or "{n,m}". Like in ECMAScript, a "{" that doesn't start
+    // one of them is a literal, in which case this returns nullopt and consumes nothing.
+    std::optional<std::pair<uint32_t, uint32_t>> _bounds() noexcept
+    {
+        const auto beg = _pos;
+        if (!_consume(L'{'))
+        {
+            return std::nullopt;
+        }
+
+        const auto number = [&]() noexcept -> std::optional<uint32_t> {
+            if (!isDigit(_peek()))
+            {
+                return std::nullopt;
+            }
+            uint32_t value = 0;
+            while (isDigit(_peek()))
+            {
+                // Saturating at a value that's guaranteed to fail the maxRepeatCount check.
+                value = std::min<uint32_t>(value * 10 + (_peek() - L'0'), maxRepeatCount + 1);
+                ++_pos;
+            }
+            return value;
+        };
+
+        if (const auto min = number())
+        {
+            auto max = *min;
+            if (_consume(L','))
+            {
+                max = number().value_or(unbounded);
+            }
+            if (_consume(L'}'))
+            {
+                return std::pair{ *min, max };
+            }
+        }
+
+        _pos = beg;
+        return std::nullopt;
+    }
+
+    static std::optional<Fragment> _repeat(const Fragment& operand, const uint32_t min, const uint32_t max)
+    {
+        Fragment fragment;
+
+        for (uint32_t i = 0; i < min; ++i)
+        {
+            if (!_append(fragment, operand))
+            {
+                return std::nullopt;
+            }
+        }
+
+        const auto operandSize = gsl::narrow_cast<uint32_t>(operand.size());
+
+        if (max == unbounded)
+        {
+            // L:  split L+1, end
+            //     <operand>
+            //     jump L
+            // end:
+            const auto loop = gsl::narrow_cast<uint32_t>(fragment.size());
+            fragment.emplace_back(Inst{ .op = Op::Split, .x = loop + 1, .y = loop + operandSize + 2 });
+            if (!_append(fragment, operand))
+            {
+                return std::nullopt;
+            }
+            fragment.emplace_back(Inst{ .op = Op::Jump, .x = loop });
+            return fragment;
+        }
+
+        // Each optional copy of the operand can skip straight to the end:
+        //     split L1, end
+        // L1: <operand>
+        //     split L2, end
+        // L2: <operand>
+        // end:
+        const auto optionalCount = max - min;
+        if (fragment.size() + size_t{ optionalCount } * (operandSize + 1) > maxProgramSize)
+        {
+            return std::nullopt;
+        }
+
+        const auto end = gsl::narrow_cast<uint32_t>(fragment.size() + optionalCount * (operandSize + 1));
+        for (uint32_t i = 0; i < optionalCount; ++i)
+        {
+            const auto split = gsl::narrow_cast<uint32_t>(fragment.size());
+            fragment.emplace_back(Inst{ .op = Op::Split, .x = split + 1, .y = end });
+            _append(fragment, operand);
+        }
+        return fragment;
+    }
+
+    // atom := '(' ('?:')? alternation ')' | '[' class ']' | '.' | '^' | '$' | '\' escape | char
+    std::optional<Fragment> _atom()
+    {
+        if (_eof())
+        {
+            return std::nullopt;
+        }
+
+        const auto ch = til::at(_pattern, _pos++);
+        switch (ch)
+        {
+        case L'(':
+        {
+            // Only non-capturing groups are supported besides regular ones. Lookarounds need backtracking.
+            if (_consume(L'?') && !_consume(L':'))
+            {
+                return std::nullopt;
+            }
+            auto group = _alternation();
+            if (!_consume(L')'))
+            {
+                return std::nullopt;
+            }
+            return group;
+        }
+        case L'*':
+        case L'+':
+        case L'?':
+            // There's nothing to repeat.
+            return std::nullopt;
+        case L'.':
+            return _single(Op::Any);
+        case L'^':
+            return _single(Op::LineBegin);
+        case L'$':
+            return _single(Op::LineEnd);
+        case L'[':
+            return _class();
+        case L'\\':
+            return _escape();
+        default:
+            return _char(ch);
+        }
+    }
+
+    Fragment _char(const wchar_t ch) const
+    {
+        return _single(Op::Char, _regex._caseInsensitive ? ::towlower(ch) : ch);
+    }
+
+    Fragment _builtin(const uint8_t builtins)
+    {
+        CharClass charClass;
+        charClass.builtins = builtins;
+        return _addClass(std::move(charClass));
+    }
+
+    Fragment _addClass(CharClass&& charClass)
+    {
+        const auto index = gsl::narrow_cast<uint32_t>(_regex._classes.size());
+        _regex._classes.emplace_back(std::move(charClass));
+        return _single(Op::Class, 0, index);
+    }
+
+    std::optional<Fragment> _escape()
+    {
+        if (_eof())
+        {
+            return std::nullopt;
+        }
+
+        const auto ch = til::at(_pattern, _pos++);
+        if (const auto builtins = builtinClass(ch))
+        {
+            return _builtin(builtins);
+        }
+        if (ch == L'b')
+        {
+            return _single(Op::WordBoundary);
+        }
+        if (ch == L'B')
+        {
+            return _single(Op::NotWordBoundary);
+        }
+        if (const auto escaped = _escapedChar(ch))
+        {
+            return _char(*escaped);
+        }
+        return std::nullopt;
+    }
+
+    // Returns the character that the escape sequence "\" + ch stands for (outside of "\d" etc.).
+    // Backreferences and any other escapes of letters and digits aren't supported.
+    std::optional<wchar_t> _escapedChar(const wchar_t ch) noexcept
+    {
+        switch (ch)
+        {
+        case L't':
+            return L'\t';
+        case L'n':
+            return L'\n';
+        case L'r':
+            return L'\r';
+        case L'f':
+            return L'\f';
+        case L'v':
+            return L'\v';
+        case L'0':
+            return L'\0';
+        case L'x':
+            return _hex(2);
+        case L'u':
+            return _hex(4);
+        default:
+            if (::iswalnum(ch))
+            {
+                return std::nullopt;
+            }
+            return ch;
+        }
+    }
+
+    std::optional<wchar_t> _hex(const size_t digits) noexcept
+    {
+        if (_pattern.size() - _pos < digits)
+        {
+            return std::nullopt;
+        }
+
+        int value = 0;
+        for (size_t i = 0; i < digits; ++i)
+        {
+            const auto digit = hexValue(til::at(_pattern, _pos++));
+            if (digit < 0)
+            {
+                return std::nullopt;
+            }
+            value = value * 16 + digit;
+        }
+        return gsl::narrow_cast<wchar_t>(value);
+    }
+
+    // class := '^'? (char ('-' char)? | '\' escape)* ']'
+    // Like in ECMAScript "[]" matches nothing and "[^]" matches anything.
+    std::optional<Fragment> _class()
+    {
+        CharClass charClass;
+        charClass.negated = _consume(L'^');
+
+        // Returns the next (possibly escaped) char of the class. Builtin classes are added
+        // to charClass directly, in which case this returns L'\0' and sets `builtin`.
+        const auto classChar = [&](bool& builtin) -> std::optional<wchar_t> {
+            builtin = false;
+            if (_eof())
+            {
+                return std::nullopt;
+            }
+            const auto ch = til::at(_pattern, _pos++);
+            if (ch != L'\\')
+            {
+                return ch;
+            }
+            if (_eof())
+            {
+                return std::nullopt;
+            }
+            const auto escaped = til::at(_pattern, _pos++);
+            if (const auto builtins = builtinClass(escaped))
+            {
+                charClass.builtins |= builtins;
+                builtin = true;
+                return L'\0';
+            }
+            if (escaped == L'b')
+            {
+                return L'\b';
+            }
+            if (escaped == L'-')
+            {
+                return L'-';
+            }
+            return _escapedChar(escaped);
+        };
+
+        while (!_consume(L']'))
+        {
+            bool builtin;
+            const auto lo = classChar(builtin);
+            if (!lo)
+            {
+                return std::nullopt;
+            }
+            if (builtin)
+            {
+                continue;
+            }
+
+            auto hi = *lo;
+            if (_pos + 1 < _pattern.size() && til::at(_pattern, _pos) == L'-' && til::at(_pattern, _pos + 1) != L']')
+            {
+                ++_pos;
+                const auto end = classChar(builtin);
+                if (!end || builtin || *end < *lo)
+                {
+                    return std::nullopt;
+                }
+                hi = *end;
+            }
+
+            charClass.ranges.emplace_back(*lo, hi);
+        }
+
+        return _addClass(std::move(charClass));
+    }
+
+    std::wstring_view _pattern;
+    SearchRegex& _regex;
+    size_t _pos = 0;
+};
+
+// Routine Description:
+// - Compiles the given pattern. The most recently compiled patterns are cached, because the buffer
+//   is searched in many small slices and the search box is updated with every keystroke.
+// Arguments:
+// - pattern - The regular expression
+// - caseInsensitive - Whether the case of the text should be ignored
+// Return Value:
+// - The compiled pattern, or nullptr if the pattern is invalid or unsupported.
+std::shared_ptr<const SearchRegex> SearchRegex::Compile(const std::wstring_view& pattern, const bool caseInsensitive)
+{
+    struct CacheEntry
+    {
+        std::wstring pattern;
+        bool caseInsensitive;
+        std::shared_ptr<const SearchRegex> regex;
+    };
+    static til::shared_mutex<std::vector<CacheEntry>> cache;
+
+    {
+        const auto entries = cache.lock();
+        const auto it = std::find_if(entries->begin(), entries->end(), [&](const CacheEntry& entry) {
+            return entry.caseInsensitive == caseInsensitive && entry.pattern == pattern;
+        });
+        if (it != entries->end())
+        {
+            // Move the entry to the front, so that the least recently used one is evicted first.
+            std::rotate(entries->begin(), it, it + 1);
+            return entries->front().regex;
+        }
+    }
+
+    auto regex = std::make_shared<SearchRegex>();
+    regex->_caseInsensitive = caseInsensitive;
+    if (!Parser{ pattern, *regex }.Parse())
+    {
+        regex.reset();
+    }
+
+    const auto entries = cache.lock();
+    if (entries->size() >= cacheSize)
+    {
+        entries->pop_back();
+    }
+    entries->insert(entries->begin(), CacheEntry{ std::wstring{ pattern }, caseInsensitive, regex });
+    return regex;
+}
+
+bool SearchRegex::_matches(const Inst& inst, const wchar_t ch) const noexcept
+{
+    switch (inst.op)
+    {
+    case Op::Char:
+        return (_caseInsensitive ? ::towlower(ch) : ch) == inst.ch;
+    case Op::Any:
+        return true;
+    case Op::Class:
+    {
+        const auto& charClass = til::at(_classes, inst.x);
+        auto contains = charClass.Contains(ch);
+        if (!contains && _caseInsensitive)
+        {
+            contains = charClass.Contains(::towlower(ch)) || charClass.Contains(::towupper(ch));
+        }
+        return contains != charClass.negated;
+    }
+    default:
+        return false;
+    }
+}
+
+// Routine Description:
+// - Finds the leftmost-longest match in the text, that starts at or after the given offset.
+// - All threads of the NFA are advanced over the text in lock-step. Each thread remembers the offset
+//   its match started at. The thread lists are ordered by that offset and each instruction is only
+//   added once per list, keeping the thread that started first. This limits the work per character to
+//   the size of the program. Once a match is found no new threads are started and only the ones that
+//   started at or before it are advanced further, in order to find a longer (or more leftmost) match.
+// Arguments:
+// - text - The line to search in. "^" and "$" match at its start and end only.
+// - offset - The offset to start searching at
+// Return Value:
+// - The offset of the first character of the match and the one past its end.
+//   Both are npos if there's no match. Matches may be empty.
+std::pair<size_t, size_t> SearchRegex::Find(const std::wstring_view& text, size_t offset) const
+{
+    struct Thread
+    {
+        uint32_t pc;
+        size_t start;
+    };
+
+    std::vector<Thread> curr;
+    std::vector<Thread> next;
+    std::vector<uint32_t> stack;
+    // marks[pc] is the offset of the thread list that instruction pc was last added to.
+    std::vector<size_t> marks(_program.size(), npos);
+
+    const auto isWordAt = [&](const size_t pos) noexcept {
+        return pos < text.size() && isWordChar(til::at(text, pos));
+    };
+
+    // Adds the thread and follows its jumps and assertions, until it either reaches
+    // an instruction that consumes a character or the Match instruction.
+    const auto addThread = [&](std::vector<Thread>& list, const uint32_t pc, const size_t start, const size_t pos) {
+        stack.emplace_back(pc);
+        while (!stack.empty())
+        {
+            const auto p = stack.back();
+            stack.pop_back();
+
+            auto& mark = til::at(marks, p);
+            if (mark == pos)
+            {
+                continue;
+            }
+            mark = pos;
+
+            const auto& inst = til::at(_program, p);
+            switch (inst.op)
+            {
+            case Op::Jump:
+                stack.emplace_back(inst.x);
+                break;
+            case Op::Split:
+                stack.emplace_back(inst.y);
+                stack.emplace_back(inst.x);
+                break;
+            case Op::LineBegin:
+                if (pos == 0)
+                {
+                    stack.emplace_back(p + 1);
+                }
+                break;
+            case Op::LineEnd:
+                if (pos == text.size())
+                {
+                    stack.emplace_back(p + 1);
+                }
+                break;
+            case Op::WordBoundary:
+            case Op::NotWordBoundary:
+                if (((pos > 0 && isWordAt(pos - 1)) != isWordAt(pos)) == (inst.op == Op::WordBoundary))
+                {
+                    stack.emplace_back(p + 1);
+                }
+                break;
+            default:
+                list.emplace_back(Thread{ p, start });
+                break;
+            }
+        }
+    };
+
+    auto bestBeg = npos;
+    auto bestEnd = npos;
+
+    for (auto pos = offset; pos <= text.size(); ++pos)
+    {
+        // The new thread has the lowest priority, since it starts the latest.
+        if (bestBeg == npos)
+        {
+            addThread(curr, 0, pos, pos);
+        }
+        else if (curr.empty())
+        {
+            break;
+        }
+
+        const auto ch = pos < text.size() ? til::at(text, pos) : L'\0';
+
+        for (const auto& thread : curr)
+        {
+            if (thread.start > bestBeg)
+            {
+                // The list is ordered by start offset, so no subsequent thread can improve on the match.
+                break;
+            }
+
+            const auto& inst = til::at(_program, thread.pc);
+            if (inst.op == Op::Match)
+            {
+                bestBeg = thread.start;
+                bestEnd = pos;
+            }
+            else if (pos < text.size() && _matches(inst, ch))
+            {
+                addThread(next, thread.pc + 1, thread.start, pos + 1);
+            }
+        }
+
+        curr.swap(next);
+        next.clear();
+    }
+
+    return { bestBeg, bestEnd };
+}
@@ -0,0 +1,71 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SearchRegex.hpp
+
+Abstract:
+- A regular expression engine for searching the text buffer. Unlike std::wregex it doesn't
+  backtrack and runs in O(text * pattern) time, which makes it suitable for scanning the entire scrollback.
+- Patterns are compiled into a program for a Thompson NFA, which is simulated by advancing all
+  of its threads over the text in lock-step. Matches are leftmost-longest, like in POSIX.
+- The supported syntax is the subset of ECMAScript's that doesn't require backtracking: literals, ".",
+  character classes (including \d \w \s and their negations), groups, alternation, the quantifiers
+  * + ? {n} {n,} {n,m} (lazy quantifiers are accepted, but match greedily) and the assertions ^ $ \b \B.
+  "^" and "$" match at the start and end of the searched line. The text is matched per UTF-16 code unit.
+--*/
+
+#pragma once
+
+class SearchRegex final
+{
+public:
+    static constexpr size_t npos = std::wstring_view::npos;
+
+    static std::shared_ptr<const SearchRegex> Compile(const std::wstring_view& pattern, const bool caseInsensitive);
+
+    std::pair<size_t, size_t> Find(const std::wstring_view& text, size_t offset) const;
+
+private:
+    enum class Op : uint8_t
+    {
+        Char,
+        Any,
+        Class,
+        Split,
+        Jump,
+        LineBegin,
+        LineEnd,
+        WordBoundary,
+        NotWordBoundary,
+        Match,
+    };
+
+    // Split continues at both x and y, Jump only at x. Class uses x as the index into _classes.
+    // The targets are absolute in _program, but relative to the start of a fragment during parsing.
+    struct Inst
+    {
+        Op op = Op::Match;
+        wchar_t ch = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+    };
+
+    struct CharClass
+    {
+        std::vector<std::pair<wchar_t, wchar_t>> ranges;
+        uint8_t builtins = 0;
+        bool negated = false;
+
+        bool Contains(const wchar_t ch) const noexcept;
+    };
+
+    class Parser;
+
+    bool _matches(const Inst& inst, const wchar_t ch) const noexcept;
+
+    std::vector<Inst> _program;
+    std::vector<CharClass> _classes;
+    bool _caseInsensitive = false;
+};
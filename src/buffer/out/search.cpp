@@ -5,10 +5,7 @@
 
 #include "search.h"
 
-#include <til/unicode.h>
-
 #include "textBuffer.hpp"
-#include "../types/inc/GlyphWidth.hpp"
 
 using namespace Microsoft::Console::Types;
 
@@ -16,8 +13,8 @@ using namespace Microsoft::Console::Types;
 // - Constructs a Search object.
 // - Make a Search object then call .FindNext() to locate items.
 // - Once you've found something, you can perform actions like .Select() or .Color()
+// - All matches are found upfront in a single pass over the buffer. See TextBuffer::SearchText().
 // Arguments:
-// - textBuffer - The screen text buffer to search through (the "haystack")
 // - renderData - The IRenderData type reference, it is for providing selection methods
 // - str - The search term you want to find (the "needle")
 // - direction - The direction to search (upward or downward)
@@ -26,13 +23,8 @@ Search::Search(Microsoft::Console::Render::IRenderData& renderData,
                const std::wstring_view str,
                const Direction direction,
                const Sensitivity sensitivity) :
-    _direction(direction),
-    _sensitivity(sensitivity),
-    _needle(s_CreateNeedleFromString(str)),
-    _renderData(renderData),
-    _coordAnchor(s_GetInitialAnchor(renderData, direction))
+    Search(renderData, str, direction, sensitivity, s_GetInitialAnchor(renderData, direction))
 {
-    _coordNext = _coordAnchor;
 }
 
 // Routine Description:
@@ -40,7 +32,6 @@ Search::Search(Microsoft::Console::Render::IRenderData& renderData,
 // - Make a Search object then call .FindNext() to locate items.
 // - Once you've found something, you can perform actions like .Select() or .Color()
 // Arguments:
-// - textBuffer - The screen text buffer to search through (the "haystack")
 // - renderData - The IRenderData type reference, it is for providing selection methods
 // - str - The search term you want to find (the "needle")
 // - direction - The direction to search (upward or downward)
@@ -51,13 +42,28 @@ Search::Search(Microsoft::Console::Render::IRenderData& renderData,
                const Direction direction,
                const Sensitivity sensitivity,
                const til::point anchor) :
+    _matches(s_FindMatches(renderData, str, sensitivity)),
+    _direction(direction),
+    _renderData(renderData)
+{
+    _nextMatch = s_GetFirstMatch(_matches, anchor, direction);
+}
+
+// Routine Description:
+// - Constructs a Search object from matches that were found already, for instance
+//   by searching the buffer in multiple slices via s_FindMatchesInRows().
+// Arguments:
+// - renderData - The IRenderData type reference, it is for providing selection methods
+// - matches - All matches of the search term in the buffer, in order
+// - direction - The direction to search (upward or downward)
+Search::Search(Microsoft::Console::Render::IRenderData& renderData,
+               std::vector<til::point_span> matches,
+               const Direction direction) :
+    _matches(std::move(matches)),
     _direction(direction),
-    _sensitivity(sensitivity),
-    _needle(s_CreateNeedleFromString(str)),
-    _coordAnchor(anchor),
     _renderData(renderData)
 {
-    _coordNext = _coordAnchor;
+    _nextMatch = s_GetFirstMatch(_matches, s_GetInitialAnchor(renderData, direction), direction);
 }
 
 // Routine Description
@@ -69,28 +75,25 @@ Search::Search(Microsoft::Console::Render::IRenderData& renderData,
 // - NOTE: You can FindNext() again after False to go around the buffer again.
 bool Search::FindNext()
 {
-    if (_reachedEnd)
+    if (_reachedEnd || _matches.empty())
     {
         _reachedEnd = false;
         return false;
     }
 
-    do
-    {
-        if (_FindNeedleInHaystackAt(_coordNext, _coordSelStart, _coordSelEnd))
-        {
-            _UpdateNextPosition();
-            _reachedEnd = _coordNext == _coordAnchor;
-            return true;
-        }
-        else
-        {
-            _UpdateNextPosition();
-        }
+    const auto& match = til::at(_matches, _nextMatch);
+    _coordSelStart = match.start;
+    _coordSelEnd = match.end;
+    _currentMatch = gsl::narrow_cast<ptrdiff_t>(_nextMatch);
+    _nextMatch = _Step(_nextMatch);
 
-    } while (_coordNext != _coordAnchor);
+    if (++_foundMatches == _matches.size())
+    {
+        _foundMatches = 0;
+        _reachedEnd = true;
+    }
 
-    return false;
+    return true;
 }
 
 // Routine Description:
@@ -118,6 +121,23 @@ void Search::Color(const TextAttribute attr) const
     }
 }
 
+// Routine Description:
+// - Changes the direction of future calls to FindNext(). If a match was found already,
+//   the next one is the one in the new direction from it.
+// Arguments:
+// - direction - The direction to search (upward or downward)
+void Search::SetDirection(const Direction direction) noexcept
+{
+    if (_direction != direction)
+    {
+        _direction = direction;
+        if (_currentMatch >= 0)
+        {
+            _nextMatch = _Step(gsl::narrow_cast<size_t>(_currentMatch));
+        }
+    }
+}
+
 // Routine Description:
 // - gets start and end position of text sound by search. only guaranteed to have valid data if FindNext has
 // been called and returned true.
@@ -128,6 +148,32 @@ std::pair<til::point, til::point> Search::GetFoundLocation() const noexcept
     return { _coordSelStart, _coordSelEnd };
 }
 
+// Routine Description:
+// - Returns all matches of the search term in the buffer, in order.
+const std::vector<til::point_span>& Search::GetMatches() const noexcept
+{
+    return _matches;
+}
+
+// Routine Description:
+// - Returns the index of the match that FindNext() found last in GetMatches(), or -1 if there's none.
+ptrdiff_t Search::GetCurrentMatch() const noexcept
+{
+    return _currentMatch;
+}
+
+// Routine Description:
+// - Returns the index of the match that follows the given one in the current direction, wrapping around.
+size_t Search::_Step(const size_t index) const noexcept
+{
+    const auto count = _matches.size();
+    if (_direction == Direction::Forward)
+    {
+        return index + 1 < count ? index + 1 : 0;
+    }
+    return index > 0 ? index - 1 : count - 1;
+}
+
 // Routine Description:
 // - Finds the anchor position where we will start searches from.
 // - This position will represent the "wrap around" point in the buffer or where
@@ -177,167 +223,96 @@ til::point Search::s_GetInitialAnchor(const Microsoft::Console::Render::IRenderD
 }
 
 // Routine Description:
-// - Attempts to compare the search term (the needle) to the screen buffer (the haystack)
-//   at the given coordinate position of the screen buffer.
-// - Performs one comparison. Call again with new positions to check other spots.
+// - Finds all matches of the search term that start before the end of the written text.
 // Arguments:
-// - pos - The position in the haystack (screen buffer) to compare
-// - start - If we found it, this is filled with the coordinate of the first character of the needle.
-// - end - If we found it, this is filled with the coordinate of the last character of the needle.
+// - renderData - The reference to the IRenderData interface type object
+// - str - The search term
+// - sensitivity - Whether or not you care about case
 // Return Value:
-// - True if we found it. False if not.
-bool Search::_FindNeedleInHaystackAt(const til::point pos, til::point& start, til::point& end) const
+// - The matches, in order.
+std::vector<til::point_span> Search::s_FindMatches(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view str, const Sensitivity sensitivity)
 {
-    start = {};
-    end = {};
-
-    auto bufferPos = pos;
-
-    for (const auto& needleChars : _needle)
-    {
-        // Haystack is the buffer. Needle is the string we were given.
-        const auto hayIter = _renderData.GetTextBuffer().GetTextDataAt(bufferPos);
-        const auto hayChars = *hayIter;
-
-        // If we didn't match at any point of the needle, return false.
-        if (!_CompareChars(hayChars, needleChars))
-        {
-            return false;
-        }
-
-        _IncrementCoord(bufferPos);
-    }
-
-    _DecrementCoord(bufferPos);
-
-    // If we made it the whole way through the needle, then it was in the haystack.
-    // Fill out the span that we found the result at and return true.
-    start = pos;
-    end = bufferPos;
-
-    return true;
+    std::vector<til::point_span> matches;
+    s_FindMatchesInRows(renderData, str, sensitivity, Syntax::Literal, 0, til::CoordTypeMax, matches);
+    return matches;
 }
 
 // Routine Description:
-// - Provides an abstraction for comparing two spans of text.
-// - Internally handles case sensitivity based on object construction.
+// - Finds the matches of the search term in the given rows, that start before the end of the written text.
+//   The rows are extended to the end of the soft-wrapped line that the last one is part of, so that
+//   no match gets cut in half. This allows callers to search the buffer in multiple slices.
 // Arguments:
-// - one - String view representing the first string of text
-// - two - String view representing the second string of text
+// - renderData - The reference to the IRenderData interface type object
+// - str - The search term
+// - sensitivity - Whether or not you care about case
+// - syntax - Whether the search term is literal text or a regular expression (see SearchRegex)
+// - rowBeg - The first row to search. It should be the first row of a line.
+// - rowEnd - The row past the last row to search
+// - matches - The vector the matches get appended to, in order
 // Return Value:
-// - True if they are the same. False otherwise.
-bool Search::_CompareChars(const std::wstring_view one, const std::wstring_view two) const noexcept
+// - The row past the last row that was searched. The buffer has been searched
+//   in its entirety once it's past the row of GetTextBufferEndPosition().
+til::CoordType Search::s_FindMatchesInRows(const Microsoft::Console::Render::IRenderData& renderData,
+                                           const std::wstring_view str,
+                                           const Sensitivity sensitivity,
+                                           const Syntax syntax,
+                                           const til::CoordType rowBeg,
+                                           til::CoordType rowEnd,
+                                           std::vector<til::point_span>& matches)
 {
-    if (one.size() != two.size())
-    {
-        return false;
-    }
+    const auto& textBuffer = renderData.GetTextBuffer();
+    const auto end = renderData.GetTextBufferEndPosition();
 
-    for (size_t i = 0; i < one.size(); i++)
+    rowEnd = std::min(rowEnd, end.y + 1);
+    while (rowEnd > rowBeg && rowEnd <= end.y && textBuffer.GetRowByOffset(rowEnd - 1).WasWrapForced())
     {
-        if (_ApplySensitivity(one.at(i)) != _ApplySensitivity(two.at(i)))
-        {
-            return false;
-        }
+        ++rowEnd;
     }
 
-    return true;
-}
-
-// Routine Description:
-// - Provides an abstraction for conditionally applying case sensitivity
-//   based on object construction
-// Arguments:
-// - wch - Character to adjust if necessary
-// Return Value:
-// - Adjusted value (or not).
-wchar_t Search::_ApplySensitivity(const wchar_t wch) const noexcept
-{
-    if (_sensitivity == Sensitivity::CaseInsensitive)
-    {
-        return ::towlower(wch);
-    }
-    else
+    const auto caseInsensitive = sensitivity == Sensitivity::CaseInsensitive;
+    auto found = syntax == Syntax::Regex ?
+                     textBuffer.SearchTextRegex(str, caseInsensitive, rowBeg, rowEnd) :
+                     textBuffer.SearchText(str, caseInsensitive, rowBeg, rowEnd);
+    while (!found.empty() && found.back().start > end)
     {
-        return wch;
+        found.pop_back();
     }
-}
+    matches.insert(matches.end(), found.begin(), found.end());
 
-// Routine Description:
-// - Helper to increment a coordinate in respect to the associated screen buffer
-// Arguments
-// - coord - Updated by function to increment one position (will wrap X and Y direction)
-void Search::_IncrementCoord(til::point& coord) const noexcept
-{
-    _renderData.GetTextBuffer().GetSize().IncrementInBoundsCircular(coord);
+    return std::max(rowBeg, rowEnd);
 }
 
 // Routine Description:
-// - Helper to decrement a coordinate in respect to the associated screen buffer
-// Arguments
-// - coord - Updated by function to decrement one position (will wrap X and Y direction)
-void Search::_DecrementCoord(til::point& coord) const noexcept
-{
-    _renderData.GetTextBuffer().GetSize().DecrementInBoundsCircular(coord);
-}
-
-// Routine Description:
-// - Helper to update the coordinate position to the next point to be searched
+// - Returns the index of the first match at or after the anchor in the given direction,
+//   wrapping around to the other end of the buffer if there's none.
+// Arguments:
+// - matches - The matches, in order
+// - anchor - The position to start searching from
+// - direction - The direction to search (upward or downward)
 // Return Value:
-// - True if we haven't reached the end of the buffer. False otherwise.
-void Search::_UpdateNextPosition()
+// - The index into matches. 0 if there are no matches.
+size_t Search::s_GetFirstMatch(const std::vector<til::point_span>& matches, const til::point anchor, const Direction direction) noexcept
 {
-    if (_direction == Direction::Forward)
-    {
-        _IncrementCoord(_coordNext);
-    }
-    else if (_direction == Direction::Backward)
-    {
-        _DecrementCoord(_coordNext);
-    }
-    else
+    if (matches.empty())
     {
-        THROW_HR(E_NOTIMPL);
+        return 0;
     }
 
-    // To reduce wrap-around time, if the next position is larger than
-    // the end position of the written text
-    // We put the next position to:
-    // Forward: (0, 0)
-    // Backward: the position of the end of the text buffer
-    const auto bufferEndPosition = _renderData.GetTextBufferEndPosition();
+    // The first match that starts past the anchor.
+    const auto it = std::upper_bound(matches.begin(), matches.end(), anchor, [](const til::point anchor, const til::point_span& match) {
+        return anchor < match.start;
+    });
+    const auto past = gsl::narrow_cast<size_t>(it - matches.begin());
 
-    if (_coordNext.y > bufferEndPosition.y ||
-        (_coordNext.y == bufferEndPosition.y && _coordNext.x > bufferEndPosition.x))
+    if (direction == Direction::Forward)
     {
-        if (_direction == Direction::Forward)
-        {
-            _coordNext = {};
-        }
-        else
+        // A match that starts right at the anchor counts.
+        if (past > 0 && til::at(matches, past - 1).start == anchor)
         {
-            _coordNext = bufferEndPosition;
+            return past - 1;
         }
+        return past < matches.size() ? past : 0;
     }
-}
 
-// Routine Description:
-// - Creates a "needle" of the correct format for comparison to the screen buffer text data
-//   that we can use for our search
-// Arguments:
-// - wstr - String that will be our search term
-// Return Value:
-// - Structured text data for comparison to screen buffer text data.
-std::vector<std::wstring> Search::s_CreateNeedleFromString(const std::wstring_view wstr)
-{
-    std::vector<std::wstring> cells;
-    for (const auto& chars : til::utf16_iterator{ wstr })
-    {
-        if (IsGlyphFullWidth(chars))
-        {
-            cells.emplace_back(chars);
-        }
-        cells.emplace_back(chars);
-    }
-    return cells;
+    return past > 0 ? past - 1 : matches.size() - 1;
 }
@@ -39,6 +39,12 @@ public:
         CaseSensitive
     };
 
+    enum class Syntax
+    {
+        Literal,
+        Regex
+    };
+
     Search(Microsoft::Console::Render::IRenderData& renderData,
            const std::wstring_view str,
            const Direction dir,
@@ -50,34 +56,49 @@ public:
            const Sensitivity sensitivity,
            const til::point anchor);
 
+    Search(Microsoft::Console::Render::IRenderData& renderData,
+           std::vector<til::point_span> matches,
+           const Direction dir);
+
     bool FindNext();
     void Select() const;
     void Color(const TextAttribute attr) const;
 
+    void SetDirection(const Direction dir) noexcept;
+
     std::pair<til::point, til::point> GetFoundLocation() const noexcept;
+    const std::vector<til::point_span>& GetMatches() const noexcept;
+    ptrdiff_t GetCurrentMatch() const noexcept;
 
-private:
-    wchar_t _ApplySensitivity(const wchar_t wch) const noexcept;
-    bool _FindNeedleInHaystackAt(const til::point pos, til::point& start, til::point& end) const;
-    bool _CompareChars(const std::wstring_view one, const std::wstring_view two) const noexcept;
-    void _UpdateNextPosition();
+    static til::CoordType s_FindMatchesInRows(const Microsoft::Console::Render::IRenderData& renderData,
+                                              const std::wstring_view str,
+                                              const Sensitivity sensitivity,
+                                              const Syntax syntax,
+                                              const til::CoordType rowBeg,
+                                              til::CoordType rowEnd,
+                                              std::vector<til::point_span>& matches);
 
-    void _IncrementCoord(til::point& coord) const noexcept;
-    void _DecrementCoord(til::point& coord) const noexcept;
+private:
+    size_t _Step(const size_t index) const noexcept;
 
     static til::point s_GetInitialAnchor(const Microsoft::Console::Render::IRenderData& renderData, const Direction dir);
-
-    static std::vector<std::wstring> s_CreateNeedleFromString(const std::wstring_view wstr);
+    static std::vector<til::point_span> s_FindMatches(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view str, const Sensitivity sensitivity);
+    static size_t s_GetFirstMatch(const std::vector<til::point_span>& matches, const til::point anchor, const Direction dir) noexcept;
 
     bool _reachedEnd = false;
-    til::point _coordNext;
     til::point _coordSelStart;
     til::point _coordSelEnd;
 
-    const til::point _coordAnchor;
-    const std::vector<std::wstring> _needle;
-    const Direction _direction;
-    const Sensitivity _sensitivity;
+    // All matches in the buffer, in order. _nextMatch is the one that FindNext() returns next
+    // and _currentMatch the one it returned last (or -1). _foundMatches counts the matches
+    // FindNext() returned since it last returned false. Once it returned each match once,
+    // it returns false once, so that callers know when to stop iterating.
+    std::vector<til::point_span> _matches;
+    size_t _nextMatch = 0;
+    ptrdiff_t _currentMatch = -1;
+    size_t _foundMatches = 0;
+
+    Direction _direction;
     Microsoft::Console::Render::IRenderData& _renderData;
 
 #ifdef UNIT_TESTING
@@ -4,6 +4,9 @@
 #include "precomp.h"
 
 #include "textBuffer.hpp"
+#include "SearchRegex.hpp"
+
+#include <execution>
 
 #include <til/hash.h>
 #include <til/unicode.h>
@@ -12,12 +15,45 @@
 #include "../types/inc/utils.hpp"
 #include "../types/inc/convert.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
+#include "../../types/inc/PerformanceRegion.hpp"
 
 using namespace Microsoft::Console;
 using namespace Microsoft::Console::Types;
+using namespace std::string_view_literals;
 
 using PointTree = interval_tree::IntervalTree<til::point, size_t>;
 
+namespace
+{
+    // The memory arena of a recyclable TextBuffer (see SetRecyclable()) after it was destroyed.
+    // Its pages up to `committed` remain committed, but don't contain any constructed ROWs anymore.
+    struct RecycledArena
+    {
+        wil::unique_virtualalloc_ptr<std::byte> buffer;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        size_t committed = 0;
+    };
+
+    // Alternate screen buffers are all sized to the viewport and there are rarely more than
+    // a few in use at a time (one per tab), which is why this doesn't need to be large.
+    // The budget is the amount of committed memory we're willing to hold on to.
+    constexpr size_t recycledArenaBudget = 8 * 1024 * 1024;
+
+    struct RecycledArenaPool
+    {
+        std::mutex mutex;
+        std::vector<RecycledArena> arenas;
+        size_t committed = 0;
+    };
+
+    RecycledArenaPool& recycledArenaPool()
+    {
+        static RecycledArenaPool pool;
+        return pool;
+    }
+}
+
 // Routine Description:
 // - Creates a new instance of TextBuffer
 // Arguments:
@@ -50,6 +86,7 @@ TextBuffer::~TextBuffer()
     if (_buffer)
     {
         _destroy();
+        _recycle();
     }
 }
 
@@ -85,11 +122,35 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     const auto rowCount = ::base::strict_cast<uint64_t>(h) + 1;
     const auto allocSize = gsl::narrow<size_t>(rowCount * rowStride);
 
+    // Reuse the arena of a recently destroyed buffer of the same size, if there's one.
+    // This avoids having to VirtualAlloc() and fault in the same pages all over again.
+    RecycledArena recycled;
+    {
+        auto& pool = recycledArenaPool();
+        const std::lock_guard guard{ pool.mutex };
+        const auto it = std::find_if(pool.arenas.begin(), pool.arenas.end(), [&](const RecycledArena& arena) {
+            return arena.width == w && arena.height == h;
+        });
+        if (it != pool.arenas.end())
+        {
+            recycled = std::move(*it);
+            pool.arenas.erase(it);
+            pool.committed -= recycled.committed;
+        }
+    }
+
     // NOTE: Modifications to this block of code might have to be mirrored over to ResizeTraditional().
     // It constructs a temporary TextBuffer and then extracts the members below, overwriting itself.
-    _buffer = wil::unique_virtualalloc_ptr<std::byte>{
-        static_cast<std::byte*>(THROW_LAST_ERROR_IF_NULL(VirtualAlloc(nullptr, allocSize, MEM_RESERVE, PAGE_READWRITE)))
-    };
+    if (recycled.buffer)
+    {
+        _buffer = std::move(recycled.buffer);
+    }
+    else
+    {
+        _buffer = wil::unique_virtualalloc_ptr<std::byte>{
+            static_cast<std::byte*>(THROW_LAST_ERROR_IF_NULL(VirtualAlloc(nullptr, allocSize, MEM_RESERVE, PAGE_READWRITE)))
+        };
+    }
     _bufferEnd = _buffer.get() + allocSize;
     _commitWatermark = _buffer.get();
     _initialAttributes = defaultAttributes;
@@ -98,7 +159,44 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     _bufferOffsetCharOffsets = rowSize + charsBufferSize;
     _width = w;
     _height = h;
+
+    // The recycled pages are still committed. We just need to construct the ROWs in them again.
+    _construct(_buffer.get() + recycled.committed);
+}
+
+// Hands the memory arena over to the pool that _reserve() draws from, if this buffer is recyclable.
+// Must be called after _destroy(). Arenas with archived ROWs aren't recycled, because parts of them
+// may have been decommitted, which would break the assumption that the recycled pages are committed.
+void TextBuffer::_recycle() noexcept
+try
+{
+    if (!_recyclable || !_archive.Empty())
+    {
+        return;
+    }
+
+    const auto committed = gsl::narrow_cast<size_t>(_commitWatermark - _buffer.get());
+    if (committed > recycledArenaBudget)
+    {
+        return;
+    }
+
+    auto& pool = recycledArenaPool();
+    const std::lock_guard guard{ pool.mutex };
+
+    // Evict the oldest arenas until the new one fits into our budget.
+    auto evict = pool.arenas.begin();
+    while (pool.committed + committed > recycledArenaBudget)
+    {
+        pool.committed -= evict->committed;
+        ++evict;
+    }
+    pool.arenas.erase(pool.arenas.begin(), evict);
+
+    pool.arenas.emplace_back(RecycledArena{ std::move(_buffer), _width, _height, committed });
+    pool.committed += committed;
 }
+CATCH_LOG()
 
 // MEM_COMMITs the memory and constructs all ROWs up to and including the given row pointer.
 // It's expected that the caller verifies the parameter. It goes hand in hand with _getRowByOffsetDirect().
@@ -124,43 +222,201 @@ __declspec(noinline) void TextBuffer::_commit(const std::byte* row)
 void TextBuffer::_decommit() noexcept
 {
     _destroy();
+    _archive.Clear();
     VirtualFree(_buffer.get(), 0, MEM_DECOMMIT);
     _commitWatermark = _buffer.get();
+    _rowSlots.clear();
+    _rowSlotPositions.clear();
+    _layoutGeneration = ROW::NextGeneration();
 }
 
 // Constructs ROWs up to (excluding) the ROW pointed to by `until`.
+// The _commitWatermark is only advanced once they're all constructed, as concurrent
+// readers in _getRowByOffsetDirect() may use the ROWs below it without taking _lazyRowsLock.
 void TextBuffer::_construct(const std::byte* until) noexcept
 {
-    for (; _commitWatermark < until; _commitWatermark += _bufferRowStride)
+    auto it = _commitWatermark;
+    for (; it < until; it += _bufferRowStride)
     {
-        const auto row = reinterpret_cast<ROW*>(_commitWatermark);
-        const auto chars = reinterpret_cast<wchar_t*>(_commitWatermark + _bufferOffsetChars);
-        const auto indices = reinterpret_cast<uint16_t*>(_commitWatermark + _bufferOffsetCharOffsets);
+        const auto row = reinterpret_cast<ROW*>(it);
+        const auto chars = reinterpret_cast<wchar_t*>(it + _bufferOffsetChars);
+        const auto indices = reinterpret_cast<uint16_t*>(it + _bufferOffsetCharOffsets);
         std::construct_at(row, chars, indices, _width, _initialAttributes);
     }
+    std::atomic_ref{ _commitWatermark }.store(it, std::memory_order_release);
 }
 
 // Destroys all previously constructed ROWs.
 // Be careful! This doesn't reset any of the members, in particular the _commitWatermark.
 void TextBuffer::_destroy() const noexcept
 {
-    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride)
+    size_t offset = 0;
+    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride, ++offset)
+    {
+        // Archived ROWs have already been destroyed and their memory might not be committed anymore.
+        if (!_archive.Contains(offset))
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
+    }
+}
+
+// MEM_COMMITs the memory of the ROW at the given offset and constructs it.
+// This is used to bring back ROWs below the _commitWatermark that have been archived.
+ROW& TextBuffer::_constructAt(size_t offset)
+{
+    const auto it = _buffer.get() + _bufferRowStride * offset;
+    THROW_LAST_ERROR_IF_NULL(VirtualAlloc(it, _bufferRowStride, MEM_COMMIT, PAGE_READWRITE));
+
+    const auto row = reinterpret_cast<ROW*>(it);
+    const auto chars = reinterpret_cast<wchar_t*>(it + _bufferOffsetChars);
+    const auto indices = reinterpret_cast<uint16_t*>(it + _bufferOffsetCharOffsets);
+    return *std::construct_at(row, chars, indices, _width, _initialAttributes);
+}
+
+// Reverses what CompactScrollback() did to the ROW at the given offset.
+// Just like _commit() this is noinline, because archived ROWs are rarely accessed.
+__declspec(noinline) void TextBuffer::_restore(size_t offset)
+{
+    auto& row = _constructAt(offset);
+    _archive.Load(offset, row);
+}
+
+// MEM_DECOMMITs all memory pages that are fully covered by the archived ROWs in the offset range [beg, end).
+// Already archived ROWs right next to the range are included, because they may share a page with it.
+void TextBuffer::_decommitArchived(size_t beg, size_t end) noexcept
+{
+    static constexpr uintptr_t pageSize = 4096;
+
+    if (beg >= end)
+    {
+        return;
+    }
+
+    const auto neighbors = pageSize / _bufferRowStride + 1;
+    for (size_t i = 0; i < neighbors && _archive.Contains(beg - 1); ++i)
+    {
+        --beg;
+    }
+    for (size_t i = 0; i < neighbors && _archive.Contains(end); ++i)
+    {
+        ++end;
+    }
+
+    const auto first = (reinterpret_cast<uintptr_t>(_buffer.get() + _bufferRowStride * beg) + pageSize - 1) & ~(pageSize - 1);
+    const auto last = reinterpret_cast<uintptr_t>(_buffer.get() + _bufferRowStride * end) & ~(pageSize - 1);
+    if (first < last)
+    {
+        VirtualFree(reinterpret_cast<void*>(first), last - first, MEM_DECOMMIT);
+    }
+}
+
+// Moves the committed ROWs in the GetRowByOffset() index range [beg, end) into the ScrollbackArchive,
+// if the predicate returns true for them. Afterwards the memory occupied by those ROWs is decommitted.
+template<typename T>
+void TextBuffer::_archiveRows(const til::CoordType beg, const til::CoordType end, T&& predicate)
+{
+    // We collect contiguous ranges of archived ROWs, so that we can decommit their memory in one go.
+    size_t runBeg = 0;
+    size_t runEnd = 0;
+
+    for (auto y = beg; y < end; ++y)
+    {
+        const auto offset = _getOffset(y);
+        const auto it = _buffer.get() + _bufferRowStride * offset;
+        if (it >= _commitWatermark || _archive.Contains(offset))
+        {
+            continue;
+        }
+
+        const auto row = reinterpret_cast<ROW*>(it);
+        if (!predicate(y, std::as_const(*row)))
+        {
+            continue;
+        }
+
+        try
+        {
+            _archive.Store(offset, *row);
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            break;
+        }
+        std::destroy_at(row);
+
+        if (offset != runEnd)
+        {
+            _decommitArchived(runBeg, runEnd);
+            runBeg = offset;
+        }
+        runEnd = offset + 1;
+    }
+
+    _decommitArchived(runBeg, runEnd);
+}
+
+// Returns true if the given ROW is indistinguishable from one that was just constructed by _construct().
+bool TextBuffer::_isInitialRow(const ROW& row) const noexcept
+{
+    const auto& runs = row.Attributes().runs();
+    return !row.ContainsText() &&
+           !row.WasWrapForced() &&
+           !row.WasDoubleBytePadded() &&
+           row.GetLineRendition() == LineRendition::SingleWidth &&
+           !row.GetImageSlice() &&
+           runs.size() == 1 &&
+           runs.front().value == _initialAttributes;
+}
+
+// Turns a GetRowByOffset() index into an offset for _getRowByOffsetDirect().
+size_t TextBuffer::_getOffset(const til::CoordType index) const noexcept
+{
+    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
+    auto offset = (_firstRow + index) % _height;
+
+    // Support negative wrap around. This way an index of -1 will
+    // wrap to _rowCount-1 and make implementing scrolling easier.
+    if (offset < 0)
+    {
+        offset += _height;
+    }
+
+    // ScrollRows() may have permuted the ROWs. Otherwise we add 1 to the row offset,
+    // because row "0" is the one returned by GetScratchpadRow().
+    if (!_rowSlots.empty())
     {
-        std::destroy_at(reinterpret_cast<ROW*>(it));
+        return til::at(_rowSlots, offset);
     }
+    return gsl::narrow_cast<size_t>(offset) + 1;
 }
 
 // This function is "direct" because it trusts the caller to properly wrap the "offset"
 // parameter modulo the _height of the buffer, etc. But keep in mind that a offset=0
 // is the GetScratchpadRow() and not the GetRowByOffset(0). That one is offset=1.
+//
+// Callers holding the Terminal lock in shared mode may call this concurrently, which is why
+// committing and restoring ROWs is serialized by _lazyRowsLock. Everything else is only
+// modified by callers holding the lock exclusively and needs no synchronization.
 ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
 {
     const auto row = _buffer.get() + _bufferRowStride * offset;
     THROW_HR_IF(E_UNEXPECTED, row < _buffer.get() || row >= _bufferEnd);
 
-    if (row >= _commitWatermark)
+    if (row >= std::atomic_ref{ _commitWatermark }.load(std::memory_order_acquire) || _archive.Contains(offset))
     {
-        _commit(row);
+        const std::lock_guard guard{ _lazyRowsLock };
+
+        // Another reader may have beaten us to it.
+        if (row >= _commitWatermark)
+        {
+            _commit(row);
+        }
+        else if (_archive.Contains(offset))
+        {
+            _restore(offset);
+        }
     }
 
     return *reinterpret_cast<ROW*>(row);
@@ -171,6 +427,12 @@ ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
 // Returns 0 if no rows are committed in.
 til::CoordType TextBuffer::_estimateOffsetOfLastCommittedRow() const noexcept
 {
+    // Once ScrollRows() permuted the ROWs, the committed ones aren't necessarily at the start anymore.
+    if (!_rowSlots.empty())
+    {
+        return std::max(0, gsl::narrow_cast<til::CoordType>(_height) - 1);
+    }
+
     const auto lastRowOffset = (_commitWatermark - _buffer.get()) / _bufferRowStride;
     // This subtracts 2 from the offset to account for the:
     // * scratchpad row at offset 0, whereas regular rows start at offset 1.
@@ -192,18 +454,7 @@ const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 // (what corresponds to the top row of the screen buffer).
 ROW& TextBuffer::GetRowByOffset(const til::CoordType index)
 {
-    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
-    auto offset = (_firstRow + index) % _height;
-
-    // Support negative wrap around. This way an index of -1 will
-    // wrap to _rowCount-1 and make implementing scrolling easier.
-    if (offset < 0)
-    {
-        offset += _height;
-    }
-
-    // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
-    return _getRowByOffsetDirect(gsl::narrow_cast<size_t>(offset) + 1);
+    return _getRowByOffsetDirect(_getOffset(index));
 }
 
 // Returns a row filled with whitespace and the current attributes, for you to freely use.
@@ -220,6 +471,123 @@ ROW& TextBuffer::GetScratchpadRow(const TextAttribute& attributes)
     return r;
 }
 
+// Moves all ROWs above the given limit into a compact, pagefile-backed ScrollbackArchive and decommits
+// their memory. They're transparently decoded again by _getRowByOffsetDirect() whenever they're accessed.
+// Since ROWs near the limit are likely to be accessed again, it should be a few pages away from the viewport.
+//
+// This needs to scan the buffer and so it only does something once enough
+// ROWs scrolled past the limit. This allows you to call it after every write.
+void TextBuffer::CompactScrollback(const til::CoordType limit)
+{
+    const auto end = std::min(limit, TotalRowCount());
+    if (end <= 0)
+    {
+        return;
+    }
+
+    // The position is smaller than the previous one if the buffer got cleared or the cursor moved up.
+    const auto position = _rowsScrolled + gsl::narrow_cast<uint64_t>(end);
+    if (position >= _lastCompaction && position - _lastCompaction < _compactionInterval)
+    {
+        return;
+    }
+    _lastCompaction = position;
+
+    _archiveRows(0, end, [](til::CoordType, const ROW&) { return true; });
+}
+
+// Releases the memory of ROWs that aren't in use. This is intended to be called when the buffer isn't visible.
+// * ROWs at the end of the memory arena that are still in their initial state get destroyed and
+//   decommitted, lowering the _commitWatermark. _commit() will simply construct them again later.
+// * All other blank ROWs get moved into the ScrollbackArchive, where they only take up a few bytes.
+// * If compactText is true, ROWs containing text get archived as well. This is meant for when the system is low on memory.
+// ROWs within the given inUse spans (for instance the viewport and the selection) are left untouched,
+// because they're likely going to be accessed again soon after.
+void TextBuffer::TrimMemory(const std::span<const til::point_span> inUse, const bool compactText)
+{
+    const auto isInUse = [&](const til::CoordType y) {
+        return std::any_of(inUse.begin(), inUse.end(), [&](const til::point_span& span) {
+            return y >= span.start.y && y <= span.end.y;
+        });
+    };
+
+    // The scratchpad row at offset 0 must stay committed, which is why this loop stops before reaching it.
+    const auto firstRow = _buffer.get() + _bufferRowStride;
+    auto watermark = _commitWatermark;
+    while (watermark > firstRow)
+    {
+        const auto it = watermark - _bufferRowStride;
+        const auto offset = gsl::narrow_cast<size_t>(it - _buffer.get()) / _bufferRowStride;
+        const auto position = _rowSlotPositions.empty() ? gsl::narrow_cast<til::CoordType>(offset) - 1 : til::at(_rowSlotPositions, offset);
+        const auto y = (position - _firstRow + _height) % _height;
+        const auto row = reinterpret_cast<ROW*>(it);
+
+        if (_archive.Contains(offset) || isInUse(y) || !_isInitialRow(*row))
+        {
+            break;
+        }
+
+        std::destroy_at(row);
+        watermark = it;
+    }
+
+    if (watermark != _commitWatermark)
+    {
+        static constexpr uintptr_t pageSize = 4096;
+        const auto first = (reinterpret_cast<uintptr_t>(watermark) + pageSize - 1) & ~(pageSize - 1);
+        const auto last = (reinterpret_cast<uintptr_t>(_commitWatermark) + pageSize - 1) & ~(pageSize - 1);
+        if (first < last)
+        {
+            VirtualFree(reinterpret_cast<void*>(first), last - first, MEM_DECOMMIT);
+        }
+        _commitWatermark = watermark;
+        // The destroyed ROWs may have changed since GetChangedRowsSince() was last called,
+        // but they won't be reported anymore now that they're beyond the _commitWatermark.
+        _layoutGeneration = ROW::NextGeneration();
+    }
+
+    _archiveRows(0, _height, [&](const til::CoordType y, const ROW& row) {
+        return !isInUse(y) && (compactText || !row.ContainsText());
+    });
+}
+
+// Releases the memory arenas that destroyed buffers left behind for reuse. See SetRecyclable().
+// This only costs the next alternate screen buffer a few page faults and is meant for when the system is low on memory.
+void TextBuffer::TrimRecycledMemory() noexcept
+{
+    std::vector<RecycledArena> arenas;
+    {
+        auto& pool = recycledArenaPool();
+        const std::lock_guard guard{ pool.mutex };
+        arenas = std::move(pool.arenas);
+        pool.arenas.clear();
+        pool.committed = 0;
+    }
+    // The arenas are released here, outside of the lock.
+}
+
+// Returns an estimate of the number of bytes this buffer occupies: The committed part of its memory arena,
+// the ScrollbackArchive and the hyperlink maps. ROWs in the archive have their pages decommitted,
+// which is why they're subtracted from the arena. The estimate ignores the heap allocations of individual ROWs.
+size_t TextBuffer::GetMemoryUsage() const noexcept
+{
+    const auto committed = gsl::narrow_cast<size_t>(_commitWatermark - _buffer.get());
+    const auto archived = _archive.Count() * _bufferRowStride;
+    auto usage = committed - std::min(committed, archived) + _archive.GetMemoryUsage();
+
+    // Every node of an unordered_map costs roughly a key, a value and two pointers.
+    for (const auto& [id, uri] : _hyperlinkMap)
+    {
+        usage += sizeof(id) + sizeof(uri) + uri.capacity() * sizeof(wchar_t) + 2 * sizeof(void*);
+    }
+    for (const auto& [key, id] : _hyperlinkCustomIdMap)
+    {
+        usage += sizeof(key) + sizeof(id) + key.capacity() * sizeof(wchar_t) + 2 * sizeof(void*);
+    }
+
+    return usage;
+}
+
 #pragma warning(pop)
 #pragma endregion
 
@@ -235,6 +603,19 @@ void TextBuffer::CopyProperties(const TextBuffer& OtherBuffer) noexcept
     GetCursor().CopyProperties(OtherBuffer.GetCursor());
 }
 
+// Routine Description:
+// - Marks this buffer's memory as reusable once the buffer is destroyed. The next buffer of
+//   the same size will then be constructed on top of already committed memory. This is meant for
+//   alternate screen buffers, which applications like pagers create and destroy all the time.
+// Arguments:
+// - recyclable - Whether the memory should be recycled.
+// Return Value:
+// - <none>
+void TextBuffer::SetRecyclable(const bool recyclable) noexcept
+{
+    _recyclable = recyclable;
+}
+
 // Routine Description:
 // - Gets the number of rows in the buffer
 // Arguments:
@@ -453,6 +834,7 @@ void TextBuffer::ConsumeGrapheme(std::wstring_view& chars) noexcept
 void TextBuffer::WriteLine(til::CoordType row, bool wrapAtEOL, const TextAttribute& attributes, RowWriteState& state)
 {
     auto& r = GetRowByOffset(row);
+    Render::PerfCounters::Add(_renderer.GetPerfCounters().rowsWritten, 1);
 
     r.ReplaceText(state);
     r.ReplaceAttributes(state.columnBegin, state.columnEnd, attributes);
@@ -465,6 +847,12 @@ void TextBuffer::WriteLine(til::CoordType row, bool wrapAtEOL, const TextAttribu
     TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, row, state.columnEndDirty, row + 1 }));
 }
 
+// Returns true if `fill` is a single narrow character, which ROW::FillText() can write in bulk.
+static bool isNarrowFillCharacter(const std::wstring_view& fill)
+{
+    return fill.size() == 1 && !til::is_surrogate(fill.front()) && (fill.front() < 0x80 || !IsGlyphFullWidth(fill));
+}
+
 // Fills an area of the buffer with a given fill character(s) and attributes.
 void TextBuffer::FillRect(const til::rect& rect, const std::wstring_view& fill, const TextAttribute& attributes)
 {
@@ -473,11 +861,30 @@ void TextBuffer::FillRect(const til::rect& rect, const std::wstring_view& fill,
         return;
     }
 
+    // Filling with a single narrow character (whitespace being the most common case by far,
+    // followed by the box drawing characters used by TUIs) doesn't need to measure any text.
+    // ROW::FillText() fills the chars and offsets in bulk, which is a lot faster.
+    if (isNarrowFillCharacter(fill))
+    {
+        for (auto y = rect.top; y < rect.bottom; ++y)
+        {
+            RowWriteState state{
+                .text = fill,
+                .columnBegin = rect.left,
+                .columnLimit = rect.right,
+            };
+
+            auto& r = GetRowByOffset(y);
+            r.FillText(state);
+            r.ReplaceAttributes(rect.left, rect.right, attributes);
+            ImageSlice::EraseCells(r, rect.left, rect.right);
+            TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, y, state.columnEndDirty, y + 1 }));
+        }
+        return;
+    }
+
     auto& scratchpad = GetScratchpadRow(attributes);
 
-    // The scratchpad row gets reset to whitespace by default, so there's no need to
-    // initialize it again. Filling with whitespace is the most common operation by far.
-    if (fill != L" ")
     {
         RowWriteState state{
             .columnLimit = rect.right,
@@ -515,70 +922,267 @@ void TextBuffer::FillRect(const til::rect& rect, const std::wstring_view& fill,
             auto& r = GetRowByOffset(y);
             r.CopyTextFrom(state);
             r.ReplaceAttributes(rect.left, rect.right, attributes);
+            ImageSlice::EraseCells(r, rect.left, rect.right);
             TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, y, state.columnEndDirty, y + 1 }));
         }
     }
 }
 
 // Routine Description:
-// - Writes cells to the output buffer. Writes at the cursor.
+// - Writes a line of CHAR_INFOs, as given to WriteConsoleOutputW(), into the row at target.y.
+// - This is equivalent to Write(OutputCellIterator{ infos }, target), but transcodes the
+//   CHAR_INFOs directly into ROW storage with a single write for the text and the attributes each.
 // Arguments:
-// - givenIt - Iterator representing output cell data to write
+// - target - the row/column to start writing the CHAR_INFOs to
+// - infos - the cells to write
 // Return Value:
-// - The final position of the iterator
-OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt)
+// - <none>
+void TextBuffer::WriteCharInfos(const til::point target, const std::span<const CHAR_INFO> infos)
 {
-    const auto& cursor = GetCursor();
-    const auto target = cursor.GetPosition();
+    if (!GetSize().IsInBounds(target))
+    {
+        return;
+    }
 
-    const auto finalIt = Write(givenIt, target);
+    auto& row = GetRowByOffset(target.y);
+    if (!row.WriteCharInfos(target.x, infos))
+    {
+        // Lone leading/trailing halves (for instance from a ReadConsoleOutputW() call that
+        // split a wide glyph) need the DBCS handling of the generic, slower path.
+        Write(OutputCellIterator{ infos }, target);
+        return;
+    }
 
-    return finalIt;
+    // Write() defaults to setting the wrap flag if the last column got filled.
+    const auto columnEnd = target.x + gsl::narrow_cast<til::CoordType>(infos.size());
+    if (columnEnd >= row.size())
+    {
+        row.SetWrapForced(true);
+    }
+
+    Render::PerfCounters::Add(_renderer.GetPerfCounters().rowsWritten, 1);
+    TriggerRedraw(Viewport::FromExclusive({ target.x, target.y, columnEnd, target.y + 1 }));
 }
 
 // Routine Description:
-// - Writes cells to the output buffer.
+// - Reads a line of CHAR_INFOs, as returned by ReadConsoleOutputW(), from the row at target.y.
+// - This is equivalent to calling CONSOLE_INFORMATION::AsCharInfo() for each cell from GetCellDataAt(),
+//   but converts the attributes only once per run instead of for every cell.
 // Arguments:
-// - givenIt - Iterator representing output cell data to write
-// - target - the row/column to start writing the text to
-// - wrap - change the wrap flag if we hit the end of the row while writing and there's still more data
+// - target - the row/column to start reading at
+// - infos - receives the cells. It must not extend past the end of the row.
 // Return Value:
-// - The final position of the iterator
-OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt,
-                                     const til::point target,
-                                     const std::optional<bool> wrap)
+// - <none>
+void TextBuffer::ReadCharInfos(const til::point target, const std::span<CHAR_INFO> infos) const
 {
-    // Make mutable copy so we can walk.
-    auto it = givenIt;
+    if (!GetSize().IsInBounds(target))
+    {
+        return;
+    }
 
-    // Make mutable target so we can walk down lines.
-    auto lineTarget = target;
+    GetRowByOffset(target.y).ReadCharInfos(target.x, infos);
+}
+
+// Routine Description:
+// - Fills `count` cells with the given character, starting at `target` and continuing
+//   on the following rows, without changing their attributes. It's equivalent to
+//   Write(OutputCellIterator{ ch, count }, target, wrap), but fills whole row segments at once.
+// Arguments:
+// - target - the row/column to start filling at
+// - ch - the character to fill with
+// - count - the number of cells to fill
+// - wrap - change the wrap flag of each row whose last column got filled
+// Return Value:
+// - The number of cells that were filled, which is less than count if the end of the buffer was reached.
+size_t TextBuffer::FillText(const til::point target, const wchar_t ch, const size_t count, const std::optional<bool> wrap)
+{
+    const std::wstring_view fill{ &ch, 1 };
+    if (!isNarrowFillCharacter(fill))
+    {
+        const OutputCellIterator it{ ch, count };
+        return Write(it, target, wrap).GetInputDistance(it);
+    }
 
-    // Get size of the text buffer so we can stay in bounds.
     const auto size = GetSize();
+    const auto width = size.Width();
+    auto pos = target;
+    size_t filled = 0;
 
-    // While there's still data in the iterator and we're still targeting in bounds...
-    while (it && size.IsInBounds(lineTarget))
+    while (filled < count && size.IsInBounds(pos))
     {
-        // Attempt to write as much data as possible onto this line.
-        // NOTE: if wrap = true/false, we want to set the line's wrap to true/false (respectively) if we reach the end of the line
-        it = WriteLine(it, lineTarget, wrap);
+        const auto columns = gsl::narrow_cast<til::CoordType>(std::min<size_t>(count - filled, gsl::narrow_cast<size_t>(width - pos.x)));
+        RowWriteState state{
+            .text = fill,
+            .columnBegin = pos.x,
+            .columnLimit = pos.x + columns,
+        };
 
-        // Move to the next line down.
-        lineTarget.x = 0;
-        ++lineTarget.y;
+        auto& r = GetRowByOffset(pos.y);
+        r.FillText(state);
+        if (wrap.has_value() && state.columnLimit == width)
+        {
+            r.SetWrapForced(*wrap);
+        }
+        Render::PerfCounters::Add(_renderer.GetPerfCounters().rowsWritten, 1);
+        TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, pos.y, state.columnEndDirty, pos.y + 1 }));
+
+        filled += gsl::narrow_cast<size_t>(columns);
+        pos = { 0, pos.y + 1 };
     }
 
-    return it;
+    return filled;
 }
 
 // Routine Description:
-// - Writes one line of text to the output buffer.
+// - Fills the attributes of `count` cells, starting at `target` and continuing on the
+//   following rows, without changing their text. It's equivalent to
+//   Write(OutputCellIterator{ attributes, count }, target), but fills whole row segments at once.
 // Arguments:
-// - givenIt - The iterator that will dereference into cell data to insert
-// - target - Coordinate targeted within output buffer
-// - wrap - change the wrap flag if we hit the end of the row while writing and there's still more data in the iterator.
-// - limitRight - Optionally restrict the right boundary for writing (e.g. stop writing earlier than the end of line)
+// - target - the row/column to start filling at
+// - attributes - the attributes to fill with
+// - count - the number of cells to fill
+// Return Value:
+// - The number of cells that were filled, which is less than count if the end of the buffer was reached.
+size_t TextBuffer::FillAttributes(const til::point target, const TextAttribute& attributes, const size_t count)
+{
+    const auto size = GetSize();
+    const auto width = size.Width();
+    auto pos = target;
+    size_t filled = 0;
+
+    while (filled < count && size.IsInBounds(pos))
+    {
+        const auto columns = gsl::narrow_cast<til::CoordType>(std::min<size_t>(count - filled, gsl::narrow_cast<size_t>(width - pos.x)));
+
+        GetRowByOffset(pos.y).ReplaceAttributes(pos.x, pos.x + columns, attributes);
+        Render::PerfCounters::Add(_renderer.GetPerfCounters().rowsWritten, 1);
+        TriggerRedraw(Viewport::FromDimensions(pos, { columns, 1 }));
+
+        filled += gsl::narrow_cast<size_t>(columns);
+        pos = { 0, pos.y + 1 };
+    }
+
+    return filled;
+}
+
+// Routine Description:
+// - Lays out the rows containing any of the given codepoints again, because their width
+//   changed since they were written. See SetGlyphWidthFallbackDeferred().
+//   Glyphs that don't fit into the row anymore are cut off at its end.
+// Arguments:
+// - codepoints - the codepoints whose width changed
+// - generation - Only rows changed since this ROW::GetLatestGeneration() are checked.
+//   Any text written before it is known to have been measured correctly.
+// Return Value:
+// - <none>
+void TextBuffer::RemeasureGlyphs(const std::span<const char32_t> codepoints, const uint64_t generation)
+{
+    std::vector<std::wstring> needles;
+    needles.reserve(codepoints.size());
+    for (const auto cp : codepoints)
+    {
+        auto& needle = needles.emplace_back();
+        if (cp < 0x10000)
+        {
+            needle.push_back(static_cast<wchar_t>(cp));
+        }
+        else
+        {
+            needle.push_back(static_cast<wchar_t>(0xD7C0 + (cp >> 10)));
+            needle.push_back(static_cast<wchar_t>(0xDC00 | (cp & 0x3FF)));
+        }
+    }
+
+    for (const auto y : GetChangedRowsSince(generation, 0, TotalRowCount()))
+    {
+        auto& row = GetRowByOffset(y);
+        const auto text = row.GetText();
+        if (std::none_of(needles.begin(), needles.end(), [&](const auto& needle) { return text.find(needle) != std::wstring_view::npos; }))
+        {
+            continue;
+        }
+
+        // The scratchpad keeps the old layout, while we rewrite the row glyph by glyph.
+        auto& scratch = GetScratchpadRow();
+        scratch.CopyFrom(row);
+
+        const auto width = row.size();
+        til::CoordType columnOld = 0;
+        til::CoordType columnNew = 0;
+        while (columnOld < width && columnNew < width)
+        {
+            const auto glyph = scratch.GlyphAt(columnOld);
+            const auto widthOld = scratch.DbcsAttrAt(columnOld) == DbcsAttribute::Leading ? 2 : 1;
+            const auto widthNew = IsGlyphFullWidth(glyph) ? 2 : 1;
+            row.ReplaceCharacters(columnNew, widthNew, glyph);
+            row.ReplaceAttributes(columnNew, columnNew + widthNew, scratch.GetAttrByColumn(columnOld));
+            columnOld += widthOld;
+            columnNew += widthNew;
+        }
+
+        TriggerRedraw(Viewport::FromDimensions({ 0, y }, { width, 1 }));
+    }
+}
+
+// Routine Description:
+// - Writes cells to the output buffer. Writes at the cursor.
+// Arguments:
+// - givenIt - Iterator representing output cell data to write
+// Return Value:
+// - The final position of the iterator
+OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt)
+{
+    const auto& cursor = GetCursor();
+    const auto target = cursor.GetPosition();
+
+    const auto finalIt = Write(givenIt, target);
+
+    return finalIt;
+}
+
+// Routine Description:
+// - Writes cells to the output buffer.
+// Arguments:
+// - givenIt - Iterator representing output cell data to write
+// - target - the row/column to start writing the text to
+// - wrap - change the wrap flag if we hit the end of the row while writing and there's still more data
+// Return Value:
+// - The final position of the iterator
+OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt,
+                                     const til::point target,
+                                     const std::optional<bool> wrap)
+{
+    // Make mutable copy so we can walk.
+    auto it = givenIt;
+
+    // Make mutable target so we can walk down lines.
+    auto lineTarget = target;
+
+    // Get size of the text buffer so we can stay in bounds.
+    const auto size = GetSize();
+
+    // While there's still data in the iterator and we're still targeting in bounds...
+    while (it && size.IsInBounds(lineTarget))
+    {
+        // Attempt to write as much data as possible onto this line.
+        // NOTE: if wrap = true/false, we want to set the line's wrap to true/false (respectively) if we reach the end of the line
+        it = WriteLine(it, lineTarget, wrap);
+
+        // Move to the next line down.
+        lineTarget.x = 0;
+        ++lineTarget.y;
+    }
+
+    return it;
+}
+
+// Routine Description:
+// - Writes one line of text to the output buffer.
+// Arguments:
+// - givenIt - The iterator that will dereference into cell data to insert
+// - target - Coordinate targeted within output buffer
+// - wrap - change the wrap flag if we hit the end of the row while writing and there's still more data in the iterator.
+// - limitRight - Optionally restrict the right boundary for writing (e.g. stop writing earlier than the end of line)
 // Return Value:
 // - The iterator, but advanced to where we stopped writing. Use to find input consumed length or cells written length.
 OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
@@ -595,6 +1199,7 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     //  Get the row and write the cells
     auto& row = GetRowByOffset(target.y);
     const auto newIt = row.WriteCells(givenIt, target.x, wrap, limitRight);
+    Render::PerfCounters::Add(_renderer.GetPerfCounters().rowsWritten, 1);
 
     // Take the cell distance written and notify that it needs to be repainted.
     const auto written = newIt.GetCellDistance(givenIt);
@@ -761,7 +1366,15 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
     _PruneHyperlinks();
 
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
+    // If it has been archived there's no point in decoding it, just to reset it right after.
+    if (const auto offset = _getOffset(0); _archive.Contains(offset))
+    {
+        _constructAt(offset);
+        _archive.Discard(offset);
+    }
     GetRowByOffset(0).Reset(fillAttributes);
+    _rowsScrolled++;
+    _layoutGeneration = ROW::NextGeneration();
     {
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
@@ -856,6 +1469,15 @@ const til::CoordType TextBuffer::GetFirstRowIndex() const noexcept
     return _firstRow;
 }
 
+// Routine Description:
+// - Returns the number of times IncrementCircularBuffer() was called.
+//   Callers that read the buffer in multiple steps can use the difference between
+//   two calls to adjust row offsets which moved up in the meantime.
+uint64_t TextBuffer::GetRowsScrolled() const noexcept
+{
+    return _rowsScrolled;
+}
+
 const Viewport TextBuffer::GetSize() const noexcept
 {
     return Viewport::FromDimensions({ _width, _height });
@@ -864,8 +1486,13 @@ const Viewport TextBuffer::GetSize() const noexcept
 void TextBuffer::_SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept
 {
     _firstRow = FirstRowIndex;
+    _layoutGeneration = ROW::NextGeneration();
 }
 
+// Routine Description:
+// - Moves the rows [firstRow, firstRow + size) up (negative delta) or down (positive delta).
+// - The rows that are vacated by the move receive the rows that were overwritten by it.
+//   Callers are expected to erase them afterwards.
 void TextBuffer::ScrollRows(const til::CoordType firstRow, til::CoordType size, const til::CoordType delta)
 {
     if (delta == 0)
@@ -873,10 +1500,111 @@ void TextBuffer::ScrollRows(const til::CoordType firstRow, til::CoordType size,
         return;
     }
 
-    // Since the for() loop uses !=, we must ensure that size is positive.
-    // A negative size doesn't make any sense anyways.
+    // A negative size doesn't make any sense.
     size = std::max(0, size);
 
+    // Moving the rows [firstRow, firstRow + size) by delta is equivalent to rotating them together with
+    // the rows they overwrite, which end up in the rows that were vacated by the move. This is the same
+    // trick IncrementCircularBuffer() does with _firstRow, but for arbitrary ranges, which is why
+    // it requires an indirection table from row positions to ROW slots in our memory arena.
+    const auto beg = delta < 0 ? firstRow + delta : firstRow;
+    const auto end = delta < 0 ? firstRow + size : firstRow + size + delta;
+    if (size == 0 || beg < 0 || end > _height)
+    {
+        _copyRows(firstRow, size, delta);
+        return;
+    }
+
+    _layoutGeneration = ROW::NextGeneration();
+
+    if (_rowSlots.empty())
+    {
+        _rowSlots.resize(_height);
+        _rowSlotPositions.resize(_height + 1);
+        for (uint16_t i = 0; i < _height; ++i)
+        {
+            til::at(_rowSlots, i) = gsl::narrow_cast<uint16_t>(i + 1);
+            til::at(_rowSlotPositions, i + 1u) = i;
+        }
+    }
+
+    const auto count = gsl::narrow_cast<size_t>(end - beg);
+    const auto positionOf = [&](size_t i) {
+        return gsl::narrow_cast<size_t>((_firstRow + beg + gsl::narrow_cast<til::CoordType>(i)) % _height);
+    };
+
+    _rowSlotsScratch.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        til::at(_rowSlotsScratch, i) = til::at(_rowSlots, positionOf(i));
+    }
+
+    const auto middle = delta < 0 ? _rowSlotsScratch.begin() - delta : _rowSlotsScratch.end() - delta;
+    std::rotate(_rowSlotsScratch.begin(), middle, _rowSlotsScratch.end());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto position = positionOf(i);
+        const auto slot = til::at(_rowSlotsScratch, i);
+        til::at(_rowSlots, position) = slot;
+        til::at(_rowSlotPositions, slot) = gsl::narrow_cast<uint16_t>(position);
+    }
+}
+
+// Routine Description:
+// - Returns the rows in the range [beg, end) that changed since the given generation,
+//   which should be a value previously returned by ROW::GetLatestGeneration().
+//   This allows consumers to update cached information incrementally.
+// - If rows moved to different positions since then (for instance due to scrolling)
+//   or the buffer was reset, all rows in the range are returned.
+// - Archived rows aren't restored to check their generation.
+// Arguments:
+// - generation - The ROW::GetLatestGeneration() value of the last time the caller checked
+// - beg, end - The range of rows to check
+// Return Value:
+// - The changed rows in ascending order
+std::vector<til::CoordType> TextBuffer::GetChangedRowsSince(const uint64_t generation, til::CoordType beg, til::CoordType end) const
+{
+    beg = std::max(0, beg);
+    end = std::min(end, TotalRowCount());
+
+    std::vector<til::CoordType> rows;
+    if (beg >= end)
+    {
+        return rows;
+    }
+
+    const auto everything = generation < _layoutGeneration;
+    for (auto y = beg; y < end; ++y)
+    {
+        const auto offset = _getOffset(y);
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+        const auto it = _buffer.get() + _bufferRowStride * offset;
+        // ROWs beyond the _commitWatermark were never accessed and are thus unchanged.
+        auto changed = everything;
+
+        if (!changed && _archive.Contains(offset))
+        {
+            changed = _archive.GetGeneration(offset) > generation;
+        }
+        else if (!changed && it < _commitWatermark)
+        {
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+            changed = reinterpret_cast<const ROW*>(it)->GetGeneration() > generation;
+        }
+
+        if (changed)
+        {
+            rows.emplace_back(y);
+        }
+    }
+    return rows;
+}
+
+// The fallback for ScrollRows() for ranges that extend past the buffer:
+// Copies the rows [firstRow, firstRow + size) to firstRow + delta.
+void TextBuffer::_copyRows(const til::CoordType firstRow, const til::CoordType size, const til::CoordType delta)
+{
     til::CoordType y = 0;
     til::CoordType end = 0;
     til::CoordType step = 0;
@@ -1075,6 +1803,10 @@ void TextBuffer::Reset() noexcept
         _bufferOffsetCharOffsets = newBuffer._bufferOffsetCharOffsets;
         _width = newBuffer._width;
         _height = newBuffer._height;
+        _archive = std::move(newBuffer._archive);
+        _rowSlots = std::move(newBuffer._rowSlots);
+        _rowSlotPositions = std::move(newBuffer._rowSlotPositions);
+        _layoutGeneration = newBuffer._layoutGeneration;
 
         _SetFirstRowIndex(0);
     }
@@ -1122,6 +1854,14 @@ void TextBuffer::TriggerRedrawAll()
     }
 }
 
+void TextBuffer::TriggerRedrawSearchHighlights(std::span<const til::point_span> highlights)
+{
+    if (_isActiveBuffer)
+    {
+        _renderer.TriggerRedrawSearchHighlights(highlights);
+    }
+}
+
 void TextBuffer::TriggerScroll()
 {
     if (_isActiveBuffer)
@@ -1138,6 +1878,14 @@ void TextBuffer::TriggerScroll(const til::point delta)
     }
 }
 
+void TextBuffer::TriggerScrollRegion(const til::rect& region, const til::CoordType delta)
+{
+    if (_isActiveBuffer)
+    {
+        _renderer.TriggerScrollRegion(region, delta);
+    }
+}
+
 void TextBuffer::TriggerNewTextNotification(const std::wstring_view newText)
 {
     if (_isActiveBuffer)
@@ -1154,7 +1902,7 @@ void TextBuffer::TriggerNewTextNotification(const std::wstring_view newText)
 // - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
 // Return Value:
 // - the delimiter class for the given char
-DelimiterClass TextBuffer::_GetDelimiterClassAt(const til::point pos, const std::wstring_view wordDelimiters) const
+DelimiterClass TextBuffer::_GetDelimiterClassAt(const til::point pos, const WordDelimiters& wordDelimiters) const
 {
     return GetRowByOffset(pos.y).DelimiterClassAt(pos.x, wordDelimiters);
 }
@@ -1170,7 +1918,7 @@ DelimiterClass TextBuffer::_GetDelimiterClassAt(const til::point pos, const std:
 // - limitOptional - (optional) the last possible position in the buffer that can be explored. This can be used to improve performance.
 // Return Value:
 // - The til::point for the first character on the "word" (inclusive)
-til::point TextBuffer::GetWordStart(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode, std::optional<til::point> limitOptional) const
+til::point TextBuffer::GetWordStart(const til::point target, const WordDelimiters& wordDelimiters, bool accessibilityMode, std::optional<til::point> limitOptional) const
 {
     // Consider a buffer with this text in it:
     // "  word   other  "
@@ -1220,42 +1968,29 @@ til::point TextBuffer::GetWordStart(const til::point target, const std::wstring_
 // - wordDelimiters - what characters are we considering for the separation of words
 // Return Value:
 // - The til::point for the first character on the current/previous READABLE "word" (inclusive)
-til::point TextBuffer::_GetWordStartForAccessibility(const til::point target, const std::wstring_view wordDelimiters) const
+til::point TextBuffer::_GetWordStartForAccessibility(const til::point target, const WordDelimiters& wordDelimiters) const
 {
-    auto result = target;
-    const auto bufferSize = GetSize();
-    auto stayAtOrigin = false;
+    const std::lock_guard guard{ _wordStartCacheLock };
+    _PrepareWordStartCache(wordDelimiters);
 
-    // ignore left boundary. Continue until readable text found
-    while (_GetDelimiterClassAt(result, wordDelimiters) != DelimiterClass::RegularChar)
+    // The word we're on starts at the last word start at or before target.
+    // If there's none, target is preceded by delimiters only and we stay at the origin.
+    for (auto y = target.y; y >= 0; --y)
     {
-        if (!bufferSize.DecrementInBounds(result))
-        {
-            // first char in buffer is a DelimiterChar or ControlChar
-            // we can't move any further back
-            stayAtOrigin = true;
-            break;
-        }
-    }
+        const auto& columns = _GetRowWordStarts(y, wordDelimiters).columns;
+        auto it = y == target.y ? std::upper_bound(columns.begin(), columns.end(), target.x) : columns.end();
 
-    // make sure we expand to the left boundary or the beginning of the word
-    while (_GetDelimiterClassAt(result, wordDelimiters) == DelimiterClass::RegularChar)
-    {
-        if (!bufferSize.DecrementInBounds(result))
+        while (it != columns.begin())
         {
-            // first char in buffer is a RegularChar
-            // we can't move any further back
-            break;
+            --it;
+            if (const til::point pos{ *it, y }; _IsRowWordStart(pos, wordDelimiters))
+            {
+                return pos;
+            }
         }
     }
 
-    // move off of delimiter and onto word start
-    if (!stayAtOrigin && _GetDelimiterClassAt(result, wordDelimiters) != DelimiterClass::RegularChar)
-    {
-        bufferSize.IncrementInBounds(result);
-    }
-
-    return result;
+    return GetSize().Origin();
 }
 
 // Method Description:
@@ -1265,26 +2000,11 @@ til::point TextBuffer::_GetWordStartForAccessibility(const til::point target, co
 // - wordDelimiters - what characters are we considering for the separation of words
 // Return Value:
 // - The til::point for the first character on the current word or delimiter run (stopped by the left margin)
-til::point TextBuffer::_GetWordStartForSelection(const til::point target, const std::wstring_view wordDelimiters) const
+til::point TextBuffer::_GetWordStartForSelection(const til::point target, const WordDelimiters& wordDelimiters) const
 {
-    auto result = target;
-    const auto bufferSize = GetSize();
-
-    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
-
     // expand left until we hit the left boundary or a different delimiter class
-    while (result.x > bufferSize.Left() && (_GetDelimiterClassAt(result, wordDelimiters) == initialDelimiter))
-    {
-        bufferSize.DecrementInBounds(result);
-    }
-
-    if (_GetDelimiterClassAt(result, wordDelimiters) != initialDelimiter)
-    {
-        // move off of delimiter
-        bufferSize.IncrementInBounds(result);
-    }
-
-    return result;
+    const auto& row = GetRowByOffset(target.y);
+    return { row.GetDelimiterRunStart(target.x, wordDelimiters), target.y };
 }
 
 // Method Description:
@@ -1298,7 +2018,7 @@ til::point TextBuffer::_GetWordStartForSelection(const til::point target, const
 // - limitOptional - (optional) the last possible position in the buffer that can be explored. This can be used to improve performance.
 // Return Value:
 // - The til::point for the last character on the "word" (inclusive)
-til::point TextBuffer::GetWordEnd(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode, std::optional<til::point> limitOptional) const
+til::point TextBuffer::GetWordEnd(const til::point target, const WordDelimiters& wordDelimiters, bool accessibilityMode, std::optional<til::point> limitOptional) const
 {
     // Consider a buffer with this text in it:
     // "  word   other  "
@@ -1336,7 +2056,7 @@ til::point TextBuffer::GetWordEnd(const til::point target, const std::wstring_vi
 // - limit - the last "valid" position in the text buffer (to improve performance)
 // Return Value:
 // - The til::point for the first character of the next readable "word". If no next word, return one past the end of the buffer
-til::point TextBuffer::_GetWordEndForAccessibility(const til::point target, const std::wstring_view wordDelimiters, const til::point limit) const
+til::point TextBuffer::_GetWordEndForAccessibility(const til::point target, const WordDelimiters& wordDelimiters, const til::point limit) const
 {
     const auto bufferSize{ GetSize() };
     auto result{ target };
@@ -1352,31 +2072,107 @@ til::point TextBuffer::_GetWordEndForAccessibility(const til::point target, cons
     }
     else
     {
-        auto iter{ GetCellDataAt(result, bufferSize) };
-        while (iter && iter.Pos() != limit && _GetDelimiterClassAt(iter.Pos(), wordDelimiters) == DelimiterClass::RegularChar)
-        {
-            // Iterate through readable text
-            ++iter;
-        }
+        const std::lock_guard guard{ _wordStartCacheLock };
+        _PrepareWordStartCache(wordDelimiters);
+
+        // The beginning of the NEXT word is the first word start after target. If there's
+        // none before the limit (which is at most the EndExclusive point), we stop there.
+        result = limit;
 
-        while (iter && iter.Pos() != limit && _GetDelimiterClassAt(iter.Pos(), wordDelimiters) != DelimiterClass::RegularChar)
+        const auto lastRow = std::min(limit.y, bufferSize.BottomInclusive());
+        for (auto y = target.y; y <= lastRow && result == limit; ++y)
         {
-            // expand to the beginning of the NEXT word
-            ++iter;
+            const auto& columns = _GetRowWordStarts(y, wordDelimiters).columns;
+            auto it = y == target.y ? std::upper_bound(columns.begin(), columns.end(), target.x) : columns.begin();
+
+            for (; it != columns.end(); ++it)
+            {
+                if (const til::point pos{ *it, y }; _IsRowWordStart(pos, wordDelimiters))
+                {
+                    if (pos < limit)
+                    {
+                        result = pos;
+                    }
+                    break;
+                }
+            }
         }
+    }
+
+    return result;
+}
+
+// Method Description:
+// - Clears _wordStartCache if it was computed with different delimiters or grew too large.
+// - Must be called with _wordStartCacheLock held, before any call to _GetRowWordStarts(),
+//   because the references it returns are only valid until the cache is cleared.
+// Arguments:
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - <none>
+void TextBuffer::_PrepareWordStartCache(const WordDelimiters& wordDelimiters) const
+{
+    if (_wordStartCacheDelimiters != wordDelimiters)
+    {
+        _wordStartCache.clear();
+        _wordStartCacheDelimiters = wordDelimiters;
+    }
+    // Stale generations pile up as ROWs get rewritten. Twice the buffer height
+    // leaves enough room for all current ROWs, while bounding the memory usage.
+    else if (_wordStartCache.size() > 2 * gsl::narrow_cast<size_t>(TotalRowCount()))
+    {
+        _wordStartCache.clear();
+    }
+}
+
+// Method Description:
+// - Returns the cached word starts of the given row (see _wordStartCache), computing them if needed.
+// - The caller must hold _wordStartCacheLock for as long as it uses the result.
+// Arguments:
+// - y - the row to get the word starts of
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - The word starts of the row.
+const TextBuffer::RowWordStarts& TextBuffer::_GetRowWordStarts(const til::CoordType y, const WordDelimiters& wordDelimiters) const
+{
+    const auto& row = GetRowByOffset(y);
+    const auto [it, inserted] = _wordStartCache.try_emplace(row.GetGeneration());
+    auto& starts = it->second;
 
-        result = iter.Pos();
+    if (inserted)
+    {
+        // Everything past MeasureRight() is whitespace.
+        const auto right = row.MeasureRight();
+        auto previous = DelimiterClass::ControlChar;
 
-        // Special case: we tried to move one past the end of the buffer,
-        // but iter prevented that (because that pos doesn't exist).
-        // Manually increment onto the EndExclusive point.
-        if (!iter)
+        for (til::CoordType x = 0; x < right; ++x)
         {
-            bufferSize.IncrementInBounds(result, true);
+            const auto cls = row.DelimiterClassAt(x, wordDelimiters);
+            if (cls == DelimiterClass::RegularChar && previous != DelimiterClass::RegularChar)
+            {
+                starts.columns.emplace_back(gsl::narrow_cast<uint16_t>(x));
+            }
+            previous = cls;
         }
+
+        starts.endsWithRegularChar = right == row.size() && previous == DelimiterClass::RegularChar;
     }
 
-    return result;
+    return starts;
+}
+
+// Method Description:
+// - Returns whether a word start in _GetRowWordStarts() also starts a word across rows,
+//   which isn't the case if it's in column 0 and the previous row ends with the same word.
+// - The caller must hold _wordStartCacheLock.
+// Arguments:
+// - pos - a word start returned by _GetRowWordStarts()
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - true, if pos is the first character of a readable word.
+bool TextBuffer::_IsRowWordStart(const til::point pos, const WordDelimiters& wordDelimiters) const
+{
+    return pos.x != 0 || pos.y == 0 || !_GetRowWordStarts(pos.y - 1, wordDelimiters).endsWithRegularChar;
 }
 
 // Method Description:
@@ -1386,7 +2182,7 @@ til::point TextBuffer::_GetWordEndForAccessibility(const til::point target, cons
 // - wordDelimiters - what characters are we considering for the separation of words
 // Return Value:
 // - The til::point for the last character of the current word or delimiter run (stopped by right margin)
-til::point TextBuffer::_GetWordEndForSelection(const til::point target, const std::wstring_view wordDelimiters) const
+til::point TextBuffer::_GetWordEndForSelection(const til::point target, const WordDelimiters& wordDelimiters) const
 {
     const auto bufferSize = GetSize();
 
@@ -1396,68 +2192,67 @@ til::point TextBuffer::_GetWordEndForSelection(const til::point target, const st
         return target;
     }
 
-    auto result = target;
-    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
-
     // expand right until we hit the right boundary or a different delimiter class
-    while (result.x < bufferSize.RightInclusive() && (_GetDelimiterClassAt(result, wordDelimiters) == initialDelimiter))
+    const auto& row = GetRowByOffset(target.y);
+    return { row.GetDelimiterRunEnd(target.x, wordDelimiters), target.y };
+}
+
+void TextBuffer::_PruneHyperlinks()
+{
+    // Hyperlink references of the row we're erasing become candidates for removal from our hyperlink map.
+    // Checking whether they're still referenced requires us to search the entire buffer however,
+    // which gets quadratic in the buffer height if we did that for every single row that scrolls off.
+    // Instead we accumulate candidates and sweep them at most once per TotalRowCount() scrolled rows,
+    // which amortizes to O(1) per row. This way, obsolete hyperlink references are still cleared
+    // from our hyperlink map instead of hanging around.
+    for (const auto id : _GetHyperlinksByOffset(0))
     {
-        bufferSize.IncrementInBounds(result);
+        _hyperlinkPruneCandidates.emplace(id);
     }
 
-    if (_GetDelimiterClassAt(result, wordDelimiters) != initialDelimiter)
+    if (_hyperlinkPruneCountdown > 0)
     {
-        // move off of delimiter
-        bufferSize.DecrementInBounds(result);
+        --_hyperlinkPruneCountdown;
+        return;
+    }
+    if (_hyperlinkPruneCandidates.empty())
+    {
+        return;
     }
 
-    return result;
-}
-
-void TextBuffer::_PruneHyperlinks()
-{
-    // Check the old first row for hyperlink references
-    // If there are any, search the entire buffer for the same reference
-    // If the buffer does not contain the same reference, we can remove that hyperlink from our map
-    // This way, obsolete hyperlink references are cleared from our hyperlink map instead of hanging around
-    // Get all the hyperlink references in the row we're erasing
-    const auto hyperlinks = GetRowByOffset(0).GetHyperlinks();
-
-    if (!hyperlinks.empty())
-    {
-        // Move to unordered set so we can use hashed lookup of IDs instead of linear search.
-        // Only make it an unordered set now because set always heap allocates but vector
-        // doesn't when the set is empty (saving an allocation in the common case of no links.)
-        std::unordered_set<uint16_t> firstRowRefs{ hyperlinks.cbegin(), hyperlinks.cend() };
-
-        const auto total = TotalRowCount();
-        // Loop through all the rows in the buffer except the first row -
-        // we have found all hyperlink references in the first row and put them in refs,
-        // now we need to search the rest of the buffer (i.e. all the rows except the first)
-        // to see if those references are anywhere else
-        for (til::CoordType i = 1; i < total; ++i)
-        {
-            const auto nextRowRefs = GetRowByOffset(i).GetHyperlinks();
-            for (auto id : nextRowRefs)
-            {
-                if (firstRowRefs.find(id) != firstRowRefs.end())
-                {
-                    firstRowRefs.erase(id);
-                }
-            }
-            if (firstRowRefs.empty())
-            {
-                // No more hyperlink references left to search for, terminate early
-                break;
-            }
-        }
+    const auto total = TotalRowCount();
+    _hyperlinkPruneCountdown = total;
 
-        // Now delete obsolete references from our map
-        for (auto hyperlinkReference : firstRowRefs)
+    // Loop through all the rows in the buffer except the first row (which is about to be erased)
+    // and see whether any of the candidates are still referenced somewhere.
+    for (til::CoordType i = 1; i < total && !_hyperlinkPruneCandidates.empty(); ++i)
+    {
+        for (const auto id : _GetHyperlinksByOffset(i))
         {
-            RemoveHyperlinkFromMap(hyperlinkReference);
+            _hyperlinkPruneCandidates.erase(id);
         }
     }
+
+    // Now delete obsolete references from our maps
+    for (const auto id : _hyperlinkPruneCandidates)
+    {
+        _hyperlinkMap.erase(id);
+    }
+    std::erase_if(_hyperlinkCustomIdMap, [&](const auto& customIdPair) {
+        return _hyperlinkPruneCandidates.contains(customIdPair.second);
+    });
+    _hyperlinkPruneCandidates.clear();
+}
+
+// Same as GetRowByOffset(index).GetHyperlinks(), but this doesn't restore archived ROWs.
+// This ensures that _PruneHyperlinks() doesn't undo what CompactScrollback() did.
+std::vector<uint16_t> TextBuffer::_GetHyperlinksByOffset(const til::CoordType index) const
+{
+    if (const auto offset = _getOffset(index); _archive.Contains(offset))
+    {
+        return _archive.GetHyperlinks(offset);
+    }
+    return GetRowByOffset(index).GetHyperlinks();
 }
 
 // Method Description:
@@ -1469,7 +2264,7 @@ void TextBuffer::_PruneHyperlinks()
 // Return Value:
 // - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
 // - pos - The til::point for the first character on the "word" (inclusive)
-bool TextBuffer::MoveToNextWord(til::point& pos, const std::wstring_view wordDelimiters, std::optional<til::point> limitOptional) const
+bool TextBuffer::MoveToNextWord(til::point& pos, const WordDelimiters& wordDelimiters, std::optional<til::point> limitOptional) const
 {
     // move to the beginning of the next word
     // NOTE: _GetWordEnd...() returns the exclusive position of the "end of the word"
@@ -1495,7 +2290,7 @@ bool TextBuffer::MoveToNextWord(til::point& pos, const std::wstring_view wordDel
 // Return Value:
 // - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
 // - pos - The til::point for the first character on the "word" (inclusive)
-bool TextBuffer::MoveToPreviousWord(til::point& pos, std::wstring_view wordDelimiters) const
+bool TextBuffer::MoveToPreviousWord(til::point& pos, const WordDelimiters& wordDelimiters) const
 {
     // move to the beginning of the current word
     auto copy{ GetWordStart(pos, wordDelimiters, true) };
@@ -1659,9 +2454,11 @@ bool TextBuffer::MoveToPreviousGlyph(til::point& pos, std::optional<til::point>
 //                   buffer margins
 // - bufferCoordinates: when enabled, treat the coordinates as relative to
 //                      the buffer rather than the screen.
+// - rowBeg, rowEnd: (optional) only the rects of the rows in [rowBeg, rowEnd) are returned.
+//                   The renderer uses this to avoid computing the rects of rows outside the viewport.
 // Return Value:
 // - One or more rects corresponding to the selection area
-const std::vector<til::inclusive_rect> TextBuffer::GetTextRects(til::point start, til::point end, bool blockSelection, bool bufferCoordinates) const
+const std::vector<til::inclusive_rect> TextBuffer::GetTextRects(til::point start, til::point end, bool blockSelection, bool bufferCoordinates, til::CoordType rowBeg, til::CoordType rowEnd) const
 {
     std::vector<til::inclusive_rect> textRects;
 
@@ -1674,11 +2471,17 @@ const std::vector<til::inclusive_rect> TextBuffer::GetTextRects(til::point start
                                                std::make_tuple(start, end) :
                                                std::make_tuple(end, start);
 
-    const auto textRectSize = 1 + lowerCoord.y - higherCoord.y;
-    textRects.reserve(textRectSize);
-    for (auto row = higherCoord.y; row <= lowerCoord.y; row++)
+    const auto firstRow = std::max(higherCoord.y, rowBeg);
+    const auto lastRow = std::min(lowerCoord.y, rowEnd - 1);
+    if (firstRow > lastRow)
     {
-        til::inclusive_rect textRow;
+        return textRects;
+    }
+
+    textRects.reserve(1 + lastRow - firstRow);
+    for (auto row = firstRow; row <= lastRow; row++)
+    {
+        til::inclusive_rect textRow;
 
         textRow.top = row;
         textRow.bottom = row;
@@ -1838,8 +2641,7 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
     data.text.reserve(rows);
     if (copyTextColor)
     {
-        data.FgAttr.reserve(rows);
-        data.BkAttr.reserve(rows);
+        data.colors.reserve(rows);
     }
 
     // for each row in the selection
@@ -1854,16 +2656,25 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
 
         // allocate a string buffer
         std::wstring selectionText;
-        std::vector<COLORREF> selectionFgAttr;
-        std::vector<COLORREF> selectionBkAttr;
+        std::vector<TextAndColor::ColorRun> selectionColors;
 
         // preallocate to avoid reallocs
         selectionText.reserve(gsl::narrow<size_t>(highlight.Width()) + 2); // + 2 for \r\n if we munged it
-        if (copyTextColor)
-        {
-            selectionFgAttr.reserve(gsl::narrow<size_t>(highlight.Width()) + 2);
-            selectionBkAttr.reserve(gsl::narrow<size_t>(highlight.Width()) + 2);
-        }
+
+        const auto appendColors = [&](const COLORREF fg, const COLORREF bg, const size_t length) {
+            if (!selectionColors.empty() && selectionColors.back().foreground == fg && selectionColors.back().background == bg)
+            {
+                selectionColors.back().length += length;
+            }
+            else
+            {
+                selectionColors.push_back({ fg, bg, length });
+            }
+        };
+
+        // Mapping attributes to colors isn't free, but most cells share their attributes with their neighbors.
+        std::optional<TextAttribute> lastAttr;
+        std::pair<COLORREF, COLORREF> lastColors;
 
         // copy char data into the string buffer, skipping trailing bytes
         while (it)
@@ -1877,13 +2688,13 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
 
                 if (copyTextColor)
                 {
-                    const auto cellData = cell.TextAttr();
-                    const auto [CellFgAttr, CellBkAttr] = GetAttributeColors(cellData);
-                    for (size_t j = 0; j < chars.size(); ++j)
+                    const auto& cellData = cell.TextAttr();
+                    if (!lastAttr || *lastAttr != cellData)
                     {
-                        selectionFgAttr.push_back(CellFgAttr);
-                        selectionBkAttr.push_back(CellBkAttr);
+                        lastAttr = cellData;
+                        lastColors = GetAttributeColors(cellData);
                     }
+                    appendColors(lastColors.first, lastColors.second, chars.size());
                 }
             }
 
@@ -1901,10 +2712,9 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
                 while (!selectionText.empty() && selectionText.back() == UNICODE_SPACE)
                 {
                     selectionText.pop_back();
-                    if (copyTextColor)
+                    if (copyTextColor && --selectionColors.back().length == 0)
                     {
-                        selectionFgAttr.pop_back();
-                        selectionBkAttr.pop_back();
+                        selectionColors.pop_back();
                     }
                 }
             }
@@ -1924,10 +2734,7 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
                 {
                     // can't see CR/LF so just use black FG & BK
                     const auto Blackness = RGB(0x00, 0x00, 0x00);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
+                    appendColors(Blackness, Blackness, 2);
                 }
             }
         }
@@ -1935,8 +2742,7 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
         data.text.emplace_back(std::move(selectionText));
         if (copyTextColor)
         {
-            data.FgAttr.emplace_back(std::move(selectionFgAttr));
-            data.BkAttr.emplace_back(std::move(selectionBkAttr));
+            data.colors.emplace_back(std::move(selectionColors));
         }
     }
 
@@ -1980,8 +2786,90 @@ std::wstring TextBuffer::GetPlainText(const til::point& start, const til::point&
     return text;
 }
 
+// Routine Description:
+// - Appends the given text to the HTML output as UTF-8, escaping the characters that HTML reserves.
+//   Unpaired surrogates are replaced with U+FFFD, the same as WideCharToMultiByte() would.
+// Arguments:
+// - out - the buffer to append to
+// - text - the text to append
+static void _AppendHTMLText(fmt::memory_buffer& out, const std::wstring_view& text)
+{
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        uint32_t cp = til::at(text, i);
+
+        switch (cp)
+        {
+        case L'<':
+            out.append(std::string_view{ "&lt;" });
+            continue;
+        case L'>':
+            out.append(std::string_view{ "&gt;" });
+            continue;
+        case L'&':
+            out.append(std::string_view{ "&amp;" });
+            continue;
+        default:
+            break;
+        }
+
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+            continue;
+        }
+
+        if (til::is_leading_surrogate(static_cast<wchar_t>(cp)) && i + 1 < text.size() && til::is_trailing_surrogate(til::at(text, i + 1)))
+        {
+            cp = ((cp - 0xD800) << 10) + (til::at(text, ++i) - 0xDC00) + 0x10000;
+        }
+        else if (til::is_surrogate(static_cast<wchar_t>(cp)))
+        {
+            cp = 0xFFFD;
+        }
+
+        if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        }
+        else
+        {
+            if (cp < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            }
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        }
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Routine Description:
+// - Returns a rough estimate of the size of the HTML or RTF generated for the given rows,
+//   which is used to reserve the output buffers upfront. It's fine to be off by a bit.
+static size_t _EstimateFormattedSize(const TextBuffer::TextAndColor& rows)
+{
+    size_t size = 256;
+    for (size_t row = 0; row < rows.text.size(); ++row)
+    {
+        size += til::at(rows.text, row).size() + 8;
+        if (row < rows.colors.size())
+        {
+            size += til::at(rows.colors, row).size() * 24;
+        }
+    }
+    return size;
+}
+
 // Routine Description:
 // - Generates a CF_HTML compliant structure based on the passed in text and color data
+// - Each distinct pair of foreground and background colors is turned into a CSS class
+//   once, which the <SPAN>s for the color runs then refer to.
 // Arguments:
 // - rows - the text and color data we will format & encapsulate
 // - backgroundColor - default background color for characters, also used in padding
@@ -1996,171 +2884,139 @@ std::string TextBuffer::GenHTML(const TextAndColor& rows,
 {
     try
     {
-        std::ostringstream htmlBuilder;
+        // Maps a pair of colors (foreground in the upper 32 bits) to the index of its CSS class.
+        std::unordered_map<uint64_t, size_t> styleIds;
+        std::vector<std::pair<COLORREF, COLORREF>> styles;
 
-        // First we have to add some standard
-        // HTML boiler plate required for CF_HTML
-        // as part of the HTML Clipboard format
-        const std::string htmlHeader =
-            "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
-        htmlBuilder << htmlHeader;
+        fmt::memory_buffer fragment;
+        fragment.reserve(_EstimateFormattedSize(rows));
 
-        htmlBuilder << "<!--StartFragment -->";
+        fragment.append(std::string_view{ "<!--StartFragment -->" });
 
         // apply global style in div element
-        {
-            htmlBuilder << "<DIV STYLE=\"";
-            htmlBuilder << "display:inline-block;";
-            htmlBuilder << "white-space:pre;";
-
-            htmlBuilder << "background-color:";
-            htmlBuilder << Utils::ColorToHexString(backgroundColor);
-            htmlBuilder << ";";
-
-            htmlBuilder << "font-family:";
-            htmlBuilder << "'";
-            htmlBuilder << ConvertToA(CP_UTF8, fontFaceName);
-            htmlBuilder << "',";
-            // even with different font, add monospace as fallback
-            htmlBuilder << "monospace;";
-
-            htmlBuilder << "font-size:";
-            htmlBuilder << fontHeightPoints;
-            htmlBuilder << "pt;";
-
-            // note: MS Word doesn't support padding (in this way at least)
-            htmlBuilder << "padding:";
-            htmlBuilder << 4; // todo: customizable padding
-            htmlBuilder << "px;";
-
-            htmlBuilder << "\">";
-        }
+        // note: MS Word doesn't support padding (in this way at least)
+        // todo: customizable padding
+        fmt::format_to(std::back_inserter(fragment),
+                       FMT_COMPILE("<DIV STYLE=\"display:inline-block;white-space:pre;background-color:#{:02X}{:02X}{:02X};font-family:'{}',monospace;font-size:{}pt;padding:4px;\">"),
+                       GetRValue(backgroundColor),
+                       GetGValue(backgroundColor),
+                       GetBValue(backgroundColor),
+                       til::u16u8(fontFaceName),
+                       fontHeightPoints);
 
         // copy text and info color from buffer
         auto hasWrittenAnyText = false;
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
+        std::optional<size_t> styleId;
         for (size_t row = 0; row < rows.text.size(); row++)
         {
-            size_t startOffset = 0;
-
             if (row != 0)
             {
-                htmlBuilder << "<BR>";
+                fragment.append(std::string_view{ "<BR>" });
             }
 
-            for (size_t col = 0; col < rows.text.at(row).length(); col++)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '<':
-                                htmlBuilder << "&lt;";
-                                break;
-                            case '>':
-                                htmlBuilder << "&gt;";
-                                break;
-                            case '&':
-                                htmlBuilder << "&amp;";
-                                break;
-                            default:
-                                htmlBuilder << c;
-                            }
-                        }
+            // do not include \r nor \n as they don't have color attributes
+            // and are not HTML friendly. For line break use '<BR>' instead.
+            const std::wstring_view text{ rows.text.at(row) };
+            const auto textEnd = std::min(text.find_first_of(L"\r\n"), text.size());
+            size_t offset = 0;
 
-                        startOffset = col;
-                    }
-                };
-
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
+            for (const auto& run : rows.colors.at(row))
+            {
+                if (offset >= textEnd)
                 {
-                    // do not include \r nor \n as they don't have color attributes
-                    // and are not HTML friendly. For line break use '<BR>' instead.
-                    writeAccumulatedChars(false);
                     break;
                 }
 
-                auto colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
+                const auto key = static_cast<uint64_t>(run.foreground) << 32 | run.background;
+                const auto [it, inserted] = styleIds.emplace(key, styles.size());
+                if (inserted)
                 {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
+                    styles.emplace_back(run.foreground, run.background);
                 }
 
-                if (colorChanged)
+                if (styleId != it->second)
                 {
-                    writeAccumulatedChars(false);
+                    styleId = it->second;
 
                     if (hasWrittenAnyText)
                     {
-                        htmlBuilder << "</SPAN>";
+                        fragment.append(std::string_view{ "</SPAN>" });
                     }
 
-                    htmlBuilder << "<SPAN STYLE=\"";
-                    htmlBuilder << "color:";
-                    htmlBuilder << Utils::ColorToHexString(fgColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "background-color:";
-                    htmlBuilder << Utils::ColorToHexString(bkColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "\">";
+                    fmt::format_to(std::back_inserter(fragment), FMT_COMPILE("<SPAN CLASS=\"c{}\">"), *styleId);
                 }
 
                 hasWrittenAnyText = true;
 
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
+                const auto length = std::min(run.length, textEnd - offset);
+                _AppendHTMLText(fragment, text.substr(offset, length));
+                offset += length;
             }
         }
 
         if (hasWrittenAnyText)
         {
             // last opened span wasn't closed in loop above, so close it now
-            htmlBuilder << "</SPAN>";
+            fragment.append(std::string_view{ "</SPAN>" });
         }
 
-        htmlBuilder << "</DIV>";
+        fragment.append(std::string_view{ "</DIV><!--EndFragment -->" });
 
-        htmlBuilder << "<!--EndFragment -->";
+        // First we have to add some standard
+        // HTML boiler plate required for CF_HTML
+        // as part of the HTML Clipboard format.
+        // The style sheet can only be written now that all colors are known.
+        fmt::memory_buffer htmlHeader;
+        htmlHeader.append(std::string_view{ "<!DOCTYPE><HTML><HEAD><STYLE>" });
+        for (size_t i = 0; i < styles.size(); ++i)
+        {
+            const auto [fg, bg] = til::at(styles, i);
+            fmt::format_to(std::back_inserter(htmlHeader),
+                           FMT_COMPILE(".c{}{{color:#{:02X}{:02X}{:02X};background-color:#{:02X}{:02X}{:02X};}}"),
+                           i,
+                           GetRValue(fg),
+                           GetGValue(fg),
+                           GetBValue(fg),
+                           GetRValue(bg),
+                           GetGValue(bg),
+                           GetBValue(bg));
+        }
+        htmlHeader.append(std::string_view{ "</STYLE></HEAD><BODY>" });
 
         constexpr std::string_view HtmlFooter = "</BODY></HTML>";
-        htmlBuilder << HtmlFooter;
 
         // once filled with values, there will be exactly 157 bytes in the clipboard header
         constexpr size_t ClipboardHeaderSize = 157;
 
         // these values are byte offsets from start of clipboard
         const auto htmlStartPos = ClipboardHeaderSize;
-        const auto htmlEndPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlBuilder.tellp());
-        const auto fragStartPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlHeader.length());
+        const auto htmlEndPos = ClipboardHeaderSize + htmlHeader.size() + fragment.size() + HtmlFooter.size();
+        const auto fragStartPos = ClipboardHeaderSize + htmlHeader.size();
         const auto fragEndPos = htmlEndPos - HtmlFooter.length();
 
         // header required by HTML 0.9 format
-        std::ostringstream clipHeaderBuilder;
-        clipHeaderBuilder << "Version:0.9\r\n";
-        clipHeaderBuilder << std::setfill('0');
-        clipHeaderBuilder << "StartHTML:" << std::setw(10) << htmlStartPos << "\r\n";
-        clipHeaderBuilder << "EndHTML:" << std::setw(10) << htmlEndPos << "\r\n";
-        clipHeaderBuilder << "StartFragment:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndFragment:" << std::setw(10) << fragEndPos << "\r\n";
-        clipHeaderBuilder << "StartSelection:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndSelection:" << std::setw(10) << fragEndPos << "\r\n";
-
-        return clipHeaderBuilder.str() + htmlBuilder.str();
+        std::string html;
+        html.reserve(htmlEndPos);
+        fmt::format_to(std::back_inserter(html),
+                       FMT_COMPILE("Version:0.9\r\n"
+                                   "StartHTML:{:010}\r\n"
+                                   "EndHTML:{:010}\r\n"
+                                   "StartFragment:{:010}\r\n"
+                                   "EndFragment:{:010}\r\n"
+                                   "StartSelection:{:010}\r\n"
+                                   "EndSelection:{:010}\r\n"),
+                       htmlStartPos,
+                       htmlEndPos,
+                       fragStartPos,
+                       fragEndPos,
+                       fragStartPos,
+                       fragEndPos);
+        assert(html.size() == ClipboardHeaderSize);
+
+        html.append(htmlHeader.data(), htmlHeader.size());
+        html.append(fragment.data(), fragment.size());
+        html.append(HtmlFooter);
+        return html;
     }
     catch (...)
     {
@@ -2184,156 +3040,98 @@ std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoi
 {
     try
     {
-        std::ostringstream rtfBuilder;
-
-        // start rtf
-        rtfBuilder << "{";
-
-        // Standard RTF header.
-        // This is similar to the header generated by WordPad.
-        // \ansi - specifies that the ANSI char set is used in the current doc
-        // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
-        // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
-        // \nouicompat - ?
-        rtfBuilder << "\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat";
-
-        // font table
-        rtfBuilder << "{\\fonttbl{\\f0\\fmodern\\fcharset0 " << ConvertToA(CP_UTF8, fontFaceName) << ";}}";
-
         // map to keep track of colors:
         // keys are colors represented by COLORREF
         // values are indices of the corresponding colors in the color table
-        std::unordered_map<COLORREF, int> colorMap;
-        auto nextColorIndex = 1; // leave 0 for the default color and start from 1.
-
-        // RTF color table
-        std::ostringstream colorTableBuilder;
-        colorTableBuilder << "{\\colortbl ;";
-        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(backgroundColor))
-                          << "\\green" << static_cast<int>(GetGValue(backgroundColor))
-                          << "\\blue" << static_cast<int>(GetBValue(backgroundColor))
-                          << ";";
-        colorMap[backgroundColor] = nextColorIndex++;
+        std::unordered_map<COLORREF, size_t> colorMap;
+        std::vector<COLORREF> colors;
+        const auto getColorIndex = [&](const COLORREF color) {
+            // leave 0 for the default color and start from 1.
+            const auto [it, inserted] = colorMap.emplace(color, colors.size() + 1);
+            if (inserted)
+            {
+                colors.emplace_back(color);
+            }
+            return it->second;
+        };
+        getColorIndex(backgroundColor);
 
         // content
-        std::ostringstream contentBuilder;
-        contentBuilder << "\\viewkind4\\uc4";
+        fmt::memory_buffer content;
+        content.reserve(_EstimateFormattedSize(rows));
 
         // paragraph styles
         // \fs specifies font size in half-points i.e. \fs20 results in a font size
         // of 10 pts. That's why, font size is multiplied by 2 here.
-        contentBuilder << "\\pard\\slmult1\\f0\\fs" << std::to_string(2 * fontHeightPoints)
-                       << "\\highlight1"
-                       << " ";
+        fmt::format_to(std::back_inserter(content), FMT_COMPILE("\\viewkind4\\uc4\\pard\\slmult1\\f0\\fs{}\\highlight1 "), 2 * fontHeightPoints);
 
         std::optional<COLORREF> fgColor = std::nullopt;
         std::optional<COLORREF> bkColor = std::nullopt;
         for (size_t row = 0; row < rows.text.size(); ++row)
         {
-            size_t startOffset = 0;
-
             if (row != 0)
             {
-                contentBuilder << "\\line "; // new line
+                content.append(std::string_view{ "\\line " }); // new line
             }
 
-            for (size_t col = 0; col < rows.text.at(row).length(); ++col)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto text = std::wstring_view{ rows.text.at(row) }.substr(startOffset, col - startOffset + includeCurrent);
-                        _AppendRTFText(contentBuilder, text);
-
-                        startOffset = col;
-                    }
-                };
+            // do not include \r nor \n as they don't have color attributes.
+            // For line break use \line instead.
+            const std::wstring_view text{ rows.text.at(row) };
+            const auto textEnd = std::min(text.find_first_of(L"\r\n"), text.size());
+            size_t offset = 0;
 
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
+            for (const auto& run : rows.colors.at(row))
+            {
+                if (offset >= textEnd)
                 {
-                    // do not include \r nor \n as they don't have color attributes.
-                    // For line break use \line instead.
-                    writeAccumulatedChars(false);
                     break;
                 }
 
-                auto colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
+                if (!fgColor.has_value() || !bkColor.has_value() || run.foreground != fgColor.value() || run.background != bkColor.value())
                 {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
+                    fgColor = run.foreground;
+                    bkColor = run.background;
 
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
+                    const auto bkColorIndex = getColorIndex(*bkColor);
+                    const auto fgColorIndex = getColorIndex(*fgColor);
+                    fmt::format_to(std::back_inserter(content), FMT_COMPILE("\\highlight{}\\cf{} "), bkColorIndex, fgColorIndex);
                 }
 
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
+                const auto length = std::min(run.length, textEnd - offset);
+                _AppendRTFText(content, text.substr(offset, length));
+                offset += length;
+            }
+        }
 
-                    auto bkColorIndex = 0;
-                    if (colorMap.find(bkColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        bkColorIndex = colorMap[bkColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(bkColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(bkColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(bkColor.value()))
-                                          << ";";
-                        colorMap[bkColor.value()] = nextColorIndex;
-                        bkColorIndex = nextColorIndex++;
-                    }
+        std::string rtf;
+        rtf.reserve(content.size() + colors.size() * 32 + 256);
 
-                    auto fgColorIndex = 0;
-                    if (colorMap.find(fgColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        fgColorIndex = colorMap[fgColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(fgColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(fgColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(fgColor.value()))
-                                          << ";";
-                        colorMap[fgColor.value()] = nextColorIndex;
-                        fgColorIndex = nextColorIndex++;
-                    }
+        // Standard RTF header.
+        // This is similar to the header generated by WordPad.
+        // \ansi - specifies that the ANSI char set is used in the current doc
+        // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
+        // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
+        // \nouicompat - ?
+        rtf.append("{\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat");
 
-                    contentBuilder << "\\highlight" << bkColorIndex
-                                   << "\\cf" << fgColorIndex
-                                   << " ";
-                }
+        // font table
+        fmt::format_to(std::back_inserter(rtf), FMT_COMPILE("{{\\fonttbl{{\\f0\\fmodern\\fcharset0 {};}}}}"), til::u16u8(fontFaceName));
 
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
-            }
+        // RTF color table
+        rtf.append("{\\colortbl ;");
+        for (const auto color : colors)
+        {
+            fmt::format_to(std::back_inserter(rtf), FMT_COMPILE("\\red{}\\green{}\\blue{};"), GetRValue(color), GetGValue(color), GetBValue(color));
         }
-
-        // end colortbl
-        colorTableBuilder << "}";
-
-        // add color table to the final RTF
-        rtfBuilder << colorTableBuilder.str();
+        rtf.append("}");
 
         // add the text content to the final RTF
-        rtfBuilder << contentBuilder.str();
+        rtf.append(content.data(), content.size());
 
         // end rtf
-        rtfBuilder << "}";
+        rtf.append("}");
 
-        return rtfBuilder.str();
+        return rtf;
     }
     catch (...)
     {
@@ -2342,7 +3140,7 @@ std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoi
     }
 }
 
-void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::wstring_view& text)
+void TextBuffer::_AppendRTFText(fmt::memory_buffer& contentBuilder, const std::wstring_view& text)
 {
     for (const auto codeUnit : text)
     {
@@ -2353,60 +3151,56 @@ void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::w
             case L'\\':
             case L'{':
             case L'}':
-                contentBuilder << "\\" << gsl::narrow<char>(codeUnit);
+                contentBuilder.push_back('\\');
+                contentBuilder.push_back(gsl::narrow_cast<char>(codeUnit));
                 break;
             default:
-                contentBuilder << gsl::narrow<char>(codeUnit);
+                contentBuilder.push_back(gsl::narrow_cast<char>(codeUnit));
             }
         }
         else
         {
             // Windows uses unsigned wchar_t - RTF uses signed ones.
-            contentBuilder << "\\u" << std::to_string(til::bit_cast<int16_t>(codeUnit)) << "?";
+            fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\u{}?"), til::bit_cast<int16_t>(codeUnit));
         }
     }
 }
 
-// Function Description:
-// - Reflow the contents from the old buffer into the new buffer. The new buffer
-//   can have different dimensions than the old buffer. If it does, then this
-//   function will attempt to maintain the logical contents of the old buffer,
-//   by continuing wrapped lines onto the next line in the new buffer.
+// Routine Description:
+// - Returns true if the given row ends a logical line. _ReflowRows() ends each row that
+//   isn't wrapped and doesn't span the entire width of the row with a NewlineCursor().
+bool TextBuffer::_IsHardLineBreak(const til::CoordType y) const
+{
+    const auto& row = GetRowByOffset(y);
+    return !row.WasWrapForced() && row.MeasureRight() < GetLineWidth(y);
+}
+
+// Routine Description:
+// - Reprints the rows [rowBeg, rowEnd) of the old buffer into the new buffer at its cursor position.
+//   This is the core of Reflow(). The positions it finds are those of the new buffer's cursor at the time.
 // Arguments:
 // - oldBuffer - the text buffer to copy the contents FROM
 // - newBuffer - the text buffer to copy the contents TO
-// - lastCharacterViewport - Optional. If the caller knows that the last
-//   nonspace character is in a particular Viewport, the caller can provide this
-//   parameter as an optimization, as opposed to searching the entire buffer.
-// - positionInfo - Optional. The caller can provide a pair of rows in this
-//   parameter and we'll calculate the position of the _end_ of those rows in
-//   the new buffer. The rows's new value is placed back into this parameter.
+// - rowBeg, rowEnd - the range of rows to copy
+// - rowsTotal - the number of rows that Reflow() copies in total
+// - cOldCursorPos - the position of the cursor in the old buffer
+// - oldPositions - Optional. The rows the caller of Reflow() is interested in.
+// - result - receives the positions of the cursor and the oldPositions rows, if they were within the range
 // Return Value:
-// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
-HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
-                           TextBuffer& newBuffer,
-                           const std::optional<Viewport> lastCharacterViewport,
-                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo)
-try
+// - <none>
+void TextBuffer::_ReflowRows(const TextBuffer& oldBuffer,
+                             TextBuffer& newBuffer,
+                             const til::CoordType rowBeg,
+                             const til::CoordType rowEnd,
+                             const til::CoordType rowsTotal,
+                             const til::point cOldCursorPos,
+                             const PositionInformation* oldPositions,
+                             ReflowResult& result)
 {
-    const auto& oldCursor = oldBuffer.GetCursor();
     auto& newCursor = newBuffer.GetCursor();
 
-    // We need to save the old cursor position so that we can
-    // place the new cursor back on the equivalent character in
-    // the new buffer.
-    const auto cOldCursorPos = oldCursor.GetPosition();
-    const auto cOldLastChar = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport);
-
-    const auto cOldRowsTotal = cOldLastChar.y + 1;
-
-    til::point cNewCursorPos;
-    auto fFoundCursorPos = false;
-    auto foundOldMutable = false;
-    auto foundOldVisible = false;
     // Loop through all the rows of the old buffer and reprint them into the new buffer
-    til::CoordType iOldRow = 0;
-    for (; iOldRow < cOldRowsTotal; iOldRow++)
+    for (auto iOldRow = rowBeg; iOldRow < rowEnd; iOldRow++)
     {
         // Fetch the row and its "right" which is the last printable character.
         const auto& row = oldBuffer.GetRowByOffset(iOldRow);
@@ -2455,8 +3249,7 @@ try
         {
             if (iOldCol == cOldCursorPos.x && iOldRow == cOldCursorPos.y)
             {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
+                result.cursor = newCursor.GetPosition();
             }
 
             // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
@@ -2505,24 +3298,16 @@ try
         // If we found the old row that the caller was interested in, set the
         // out value of that parameter to the cursor's current Y position (the
         // new location of the _end_ of that row in the buffer).
-        if (positionInfo.has_value())
+        if (oldPositions)
         {
-            if (!foundOldMutable)
+            if (!result.mutableViewportTop && iOldRow >= oldPositions->mutableViewportTop)
             {
-                if (iOldRow >= positionInfo.value().get().mutableViewportTop)
-                {
-                    positionInfo.value().get().mutableViewportTop = newCursor.GetPosition().y;
-                    foundOldMutable = true;
-                }
+                result.mutableViewportTop = newCursor.GetPosition().y;
             }
 
-            if (!foundOldVisible)
+            if (!result.visibleViewportTop && iOldRow >= oldPositions->visibleViewportTop)
             {
-                if (iOldRow >= positionInfo.value().get().visibleViewportTop)
-                {
-                    positionInfo.value().get().visibleViewportTop = newCursor.GetPosition().y;
-                    foundOldVisible = true;
-                }
+                result.visibleViewportTop = newCursor.GetPosition().y;
             }
         }
 
@@ -2533,16 +3318,15 @@ try
         // only because we ran out of space.
         if (iRight < cOldColsTotal && !row.WasWrapForced())
         {
-            if (!fFoundCursorPos && (iRight == cOldCursorPos.x && iOldRow == cOldCursorPos.y))
+            if (!result.cursor && (iRight == cOldCursorPos.x && iOldRow == cOldCursorPos.y))
             {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
+                result.cursor = newCursor.GetPosition();
             }
             // Only do this if it's not the final line in the buffer.
             // On the final line, we want the cursor to sit
             // where it is done printing for the cursor
             // adjustment to follow.
-            if (iOldRow < cOldRowsTotal - 1)
+            if (iOldRow < rowsTotal - 1)
             {
                 newBuffer.NewlineCursor();
             }
@@ -2583,89 +3367,415 @@ try
             }
         }
     }
+}
 
-    // Finish copying buffer attributes to remaining rows below the last
-    // printable character. This is to fix the `color 2f` scenario, where you
-    // change the buffer colors then resize and everything below the last
-    // printable char gets reset. See GH #12567
-    auto newRowY = newCursor.GetPosition().y + 1;
-    const auto newHeight = newBuffer.GetSize().Height();
-    const auto oldHeight = oldBuffer._estimateOffsetOfLastCommittedRow() + 1;
-    for (;
-         iOldRow < oldHeight && newRowY < newHeight;
-         iOldRow++)
+// Routine Description:
+// - A parallel implementation of _ReflowRows(). Logical lines are independent of
+//   each other, so the old buffer is split at hard line breaks into chunks, which are reflowed concurrently into
+//   temporary buffers. The chunks' row counts are then prefix-summed into their offsets in the new buffer and
+//   their rows are copied over, again concurrently.
+// - The results are exactly those of _ReflowRows(), including the effects of the new buffer running
+//   out of rows and scrolling and the positions that were found while doing so.
+// Arguments:
+// - see _ReflowRows()
+// Return Value:
+// - false if the buffer is too small for this to be worth it. The caller should use _ReflowRows() then.
+bool TextBuffer::_ReflowRowsParallel(const TextBuffer& oldBuffer,
+                                     TextBuffer& newBuffer,
+                                     const til::CoordType rowBeg,
+                                     const til::CoordType rowEnd,
+                                     const til::CoordType rowsTotal,
+                                     const til::point cOldCursorPos,
+                                     const std::optional<PositionInformation>& oldPositions,
+                                     ReflowResult& result)
+{
+    static constexpr til::CoordType minimumChunkRows = 1024;
+
+    const auto threads = gsl::narrow_cast<til::CoordType>(std::thread::hardware_concurrency());
+    const auto oldWidth = oldBuffer.GetSize().Width();
+    const auto newWidth = newBuffer.GetSize().Width();
+    if (threads < 2 || rowEnd - rowBeg < 2 * minimumChunkRows || newWidth < 4)
     {
-        const auto& row = oldBuffer.GetRowByOffset(iOldRow);
+        return false;
+    }
 
-        // Optimization: Since all these rows are below the last printable char,
-        // we can reasonably assume that they are filled with just spaces.
-        // That's convenient, we can just copy the attr row from the old buffer
-        // into the new one, and resize the row to match. We'll rely on the
-        // behavior of ATTR_ROW::Resize to trim down when narrower, or extend
-        // the last attr when wider.
-        auto& newRow = newBuffer.GetRowByOffset(newRowY);
-        const auto newWidth = newBuffer.GetLineWidth(newRowY);
-        newRow.TransferAttributes(row.Attributes(), newWidth);
+    // An upper bound for the number of rows a single old row turns into: Double width line renditions halve the
+    // width of a row, padding for wide glyphs wastes up to 1 column per row and the final newline adds 1 more row.
+    // This lets us size the temporary buffers so that they never scroll.
+    const auto rowsPerRow = oldWidth / (newWidth / 2 - 1) + 2;
+    // TextBuffer can't be taller than 65535 rows.
+    const auto maximumChunkRows = (UINT16_MAX - 1) / rowsPerRow;
+    const auto chunkRows = std::min(maximumChunkRows, std::max(minimumChunkRows, (rowEnd - rowBeg + threads - 1) / threads));
+    if (chunkRows < minimumChunkRows)
+    {
+        return false;
+    }
 
-        newRowY++;
+    // GetRowByOffset() commits and restores ROWs on demand, which isn't thread-safe. Do it upfront.
+    for (auto y = rowBeg; y < rowEnd; ++y)
+    {
+        oldBuffer.GetRowByOffset(y);
     }
 
-    // Finish copying remaining parameters from the old text buffer to the new one
-    newBuffer.CopyProperties(oldBuffer);
-    newBuffer.CopyHyperlinkMaps(oldBuffer);
-    newBuffer.CopyPatterns(oldBuffer);
+    // If we split the buffer right after hard line breaks, each chunk will start at the beginning of a new row.
+    std::vector<til::CoordType> bounds{ rowBeg };
+    for (auto y = rowBeg + chunkRows - 1; y < rowEnd - 1; y += chunkRows)
+    {
+        while (y < rowEnd - 1 && !oldBuffer._IsHardLineBreak(y))
+        {
+            ++y;
+        }
+        if (y < rowEnd - 1)
+        {
+            bounds.emplace_back(y + 1);
+        }
+    }
+    bounds.emplace_back(rowEnd);
 
-    // If we found where to put the cursor while placing characters into the buffer,
-    //   just put the cursor there. Otherwise we have to advance manually.
-    if (fFoundCursorPos)
+    const auto chunkCount = bounds.size() - 1;
+    if (chunkCount < 2)
     {
-        newCursor.SetPosition(cNewCursorPos);
+        return false;
     }
-    else
+    for (size_t i = 0; i < chunkCount; ++i)
     {
-        // Advance the cursor to the same offset as before
-        // get the number of newlines and spaces between the old end of text and the old cursor,
-        //   then advance that many newlines and chars
-        auto iNewlines = cOldCursorPos.y - cOldLastChar.y;
-        const auto iIncrements = cOldCursorPos.x - cOldLastChar.x;
-        const auto cNewLastChar = newBuffer.GetLastNonSpaceCharacter();
-
-        // If the last row of the new buffer wrapped, there's going to be one less newline needed,
-        //   because the cursor is already on the next line
-        if (newBuffer.GetRowByOffset(cNewLastChar.y).WasWrapForced())
+        if (til::at(bounds, i + 1) - til::at(bounds, i) > maximumChunkRows)
         {
-            iNewlines = std::max(iNewlines - 1, 0);
+            return false;
         }
-        else
+    }
+
+    // Exceptions must not escape std::execution::par algorithms, or std::terminate() gets called.
+    std::vector<size_t> indices(chunkCount);
+    std::iota(indices.begin(), indices.end(), size_t{ 0 });
+    const auto parallelForEachChunk = [&](auto&& func) {
+        std::vector<std::exception_ptr> exceptions(chunkCount);
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](const size_t i) {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                til::at(exceptions, i) = std::current_exception();
+            }
+        });
+        for (const auto& ex : exceptions)
         {
-            // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
-            //   old buffer will be one more than in this buffer, so new need one LESS.
-            if (oldBuffer.GetRowByOffset(cOldLastChar.y).WasWrapForced())
+            if (ex)
             {
-                iNewlines = std::max(iNewlines - 1, 0);
+                std::rethrow_exception(ex);
             }
         }
+    };
 
-        for (auto r = 0; r < iNewlines; r++)
+    std::vector<std::unique_ptr<TextBuffer>> chunks(chunkCount);
+    std::vector<ReflowResult> results(chunkCount);
+    const auto oldPositionsPtr = oldPositions ? &*oldPositions : nullptr;
+
+    parallelForEachChunk([&](const size_t i) {
+        const auto beg = til::at(bounds, i);
+        const auto end = til::at(bounds, i + 1);
+        const til::size size{ newWidth, (end - beg) * rowsPerRow + 1 };
+        auto& chunk = til::at(chunks, i);
+        chunk = std::make_unique<TextBuffer>(size, newBuffer._initialAttributes, 0, false, newBuffer._renderer);
+        _ReflowRows(oldBuffer, *chunk, beg, end, rowsTotal, cOldCursorPos, oldPositionsPtr, til::at(results, i));
+    });
+
+    // Each chunk but the last one ends with a NewlineCursor() and thus occupies all rows above its cursor.
+    std::vector<til::CoordType> offsets(chunkCount);
+    til::CoordType offset = 0;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        til::at(offsets, i) = offset;
+        offset += til::at(chunks, i)->GetCursor().GetPosition().y;
+    }
+
+    // These are the coordinates the new buffer's cursor would've had if it was infinitely tall.
+    // Once it reaches the bottom of the new buffer, it'll stay there and scroll the buffer instead.
+    const auto bottom = newBuffer.GetSize().BottomInclusive();
+    const auto finalCursor = chunks.back()->GetCursor().GetPosition();
+    const auto finalY = offsets.back() + finalCursor.y;
+    const auto scrolled = std::max(0, finalY - bottom);
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const auto& r = til::at(results, i);
+        const auto translate = [&](const til::CoordType y) {
+            return std::min(til::at(offsets, i) + y, bottom);
+        };
+
+        if (!result.cursor && r.cursor)
         {
-            newBuffer.NewlineCursor();
+            result.cursor = til::point{ r.cursor->x, translate(r.cursor->y) };
         }
-        for (auto c = 0; c < iIncrements - 1; c++)
+        if (!result.mutableViewportTop && r.mutableViewportTop)
         {
-            newBuffer.IncrementCursor();
+            result.mutableViewportTop = translate(*r.mutableViewportTop);
+        }
+        if (!result.visibleViewportTop && r.visibleViewportTop)
+        {
+            result.visibleViewportTop = translate(*r.visibleViewportTop);
         }
     }
 
-    // Save old cursor size before we delete it
-    const auto ulSize = oldCursor.GetSize();
+    // Commit all the rows we're about to write to, so that the calls to GetRowByOffset() below are thread-safe.
+    newBuffer.GetRowByOffset(finalY - scrolled);
 
-    // Set size back to real size as it will be taking over the rendering duties.
-    newCursor.SetSize(ulSize);
+    parallelForEachChunk([&](const size_t i) {
+        const auto& chunk = *til::at(chunks, i);
+        const auto rows = i + 1 == chunkCount ? finalCursor.y + 1 : chunk.GetCursor().GetPosition().y;
 
-    return S_OK;
+        for (til::CoordType y = 0; y < rows; ++y)
+        {
+            const auto dst = til::at(offsets, i) + y - scrolled;
+            if (dst >= 0)
+            {
+                const auto& src = chunk.GetRowByOffset(y);
+                auto& row = newBuffer.GetRowByOffset(dst);
+                row.CopyFrom(src);
+                row.SetDoubleBytePadded(src.WasDoubleBytePadded());
+            }
+        }
+    });
+
+    newBuffer.GetCursor().SetPosition({ finalCursor.x, std::min(finalY, bottom) });
+    return true;
+}
+
+// Function Description:
+// - Reflow the contents from the old buffer into the new buffer. The new buffer
+//   can have different dimensions than the old buffer. If it does, then this
+//   function will attempt to maintain the logical contents of the old buffer,
+//   by continuing wrapped lines onto the next line in the new buffer.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the text buffer to copy the contents TO
+// - lastCharacterViewport - Optional. If the caller knows that the last
+//   nonspace character is in a particular Viewport, the caller can provide this
+//   parameter as an optimization, as opposed to searching the entire buffer.
+// - positionInfo - Optional. The caller can provide a pair of rows in this
+//   parameter and we'll calculate the position of the _end_ of those rows in
+//   the new buffer. The rows's new value is placed back into this parameter.
+// - firstRow - Optional. The rows above this one are skipped. It should be
+//   the start of a logical line, which GetReflowStart() will return.
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
+                           TextBuffer& newBuffer,
+                           const std::optional<Viewport> lastCharacterViewport,
+                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo,
+                           const til::CoordType firstRow)
+try
+{
+    const PerformanceRegion region{ "TextBuffer_Reflow" };
+
+    const auto& oldCursor = oldBuffer.GetCursor();
+    auto& newCursor = newBuffer.GetCursor();
+
+    // We need to save the old cursor position so that we can
+    // place the new cursor back on the equivalent character in
+    // the new buffer.
+    const auto cOldCursorPos = oldCursor.GetPosition();
+    const auto cOldLastChar = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport);
+
+    const auto cOldRowsTotal = cOldLastChar.y + 1;
+    const auto cOldRowsBeg = std::clamp(firstRow, 0, cOldRowsTotal);
+
+    std::optional<PositionInformation> oldPositions;
+    if (positionInfo.has_value())
+    {
+        oldPositions = positionInfo.value().get();
+    }
+
+    // Reprint all the rows of the old buffer into the new buffer.
+    ReflowResult result;
+    if (!_ReflowRowsParallel(oldBuffer, newBuffer, cOldRowsBeg, cOldRowsTotal, cOldRowsTotal, cOldCursorPos, oldPositions, result))
+    {
+        _ReflowRows(oldBuffer, newBuffer, cOldRowsBeg, cOldRowsTotal, cOldRowsTotal, cOldCursorPos, oldPositions ? &*oldPositions : nullptr, result);
+    }
+
+    // If we found the old rows that the caller was interested in, set the out value
+    // of that parameter to the new location of the _end_ of that row in the buffer.
+    if (positionInfo.has_value())
+    {
+        if (result.mutableViewportTop)
+        {
+            positionInfo.value().get().mutableViewportTop = *result.mutableViewportTop;
+        }
+        if (result.visibleViewportTop)
+        {
+            positionInfo.value().get().visibleViewportTop = *result.visibleViewportTop;
+        }
+    }
+
+    const auto fFoundCursorPos = result.cursor.has_value();
+    const auto cNewCursorPos = result.cursor.value_or(til::point{});
+    auto iOldRow = cOldRowsTotal;
+
+    // Finish copying buffer attributes to remaining rows below the last
+    // printable character. This is to fix the `color 2f` scenario, where you
+    // change the buffer colors then resize and everything below the last
+    // printable char gets reset. See GH #12567
+    auto newRowY = newCursor.GetPosition().y + 1;
+    const auto newHeight = newBuffer.GetSize().Height();
+    const auto oldHeight = oldBuffer._estimateOffsetOfLastCommittedRow() + 1;
+    for (;
+         iOldRow < oldHeight && newRowY < newHeight;
+         iOldRow++)
+    {
+        const auto& row = oldBuffer.GetRowByOffset(iOldRow);
+
+        // Optimization: Since all these rows are below the last printable char,
+        // we can reasonably assume that they are filled with just spaces.
+        // That's convenient, we can just copy the attr row from the old buffer
+        // into the new one, and resize the row to match. We'll rely on the
+        // behavior of ATTR_ROW::Resize to trim down when narrower, or extend
+        // the last attr when wider.
+        auto& newRow = newBuffer.GetRowByOffset(newRowY);
+        const auto newWidth = newBuffer.GetLineWidth(newRowY);
+        newRow.TransferAttributes(row.Attributes(), newWidth);
+
+        newRowY++;
+    }
+
+    // Finish copying remaining parameters from the old text buffer to the new one
+    newBuffer.CopyProperties(oldBuffer);
+    newBuffer.CopyHyperlinkMaps(oldBuffer);
+    newBuffer.CopyPatterns(oldBuffer);
+
+    // If we found where to put the cursor while placing characters into the buffer,
+    //   just put the cursor there. Otherwise we have to advance manually.
+    if (fFoundCursorPos)
+    {
+        newCursor.SetPosition(cNewCursorPos);
+    }
+    else
+    {
+        // Advance the cursor to the same offset as before
+        // get the number of newlines and spaces between the old end of text and the old cursor,
+        //   then advance that many newlines and chars
+        auto iNewlines = cOldCursorPos.y - cOldLastChar.y;
+        const auto iIncrements = cOldCursorPos.x - cOldLastChar.x;
+        const auto cNewLastChar = newBuffer.GetLastNonSpaceCharacter();
+
+        // If the last row of the new buffer wrapped, there's going to be one less newline needed,
+        //   because the cursor is already on the next line
+        if (newBuffer.GetRowByOffset(cNewLastChar.y).WasWrapForced())
+        {
+            iNewlines = std::max(iNewlines - 1, 0);
+        }
+        else
+        {
+            // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
+            //   old buffer will be one more than in this buffer, so new need one LESS.
+            if (oldBuffer.GetRowByOffset(cOldLastChar.y).WasWrapForced())
+            {
+                iNewlines = std::max(iNewlines - 1, 0);
+            }
+        }
+
+        for (auto r = 0; r < iNewlines; r++)
+        {
+            newBuffer.NewlineCursor();
+        }
+        for (auto c = 0; c < iIncrements - 1; c++)
+        {
+            newBuffer.IncrementCursor();
+        }
+    }
+
+    // Save old cursor size before we delete it
+    const auto ulSize = oldCursor.GetSize();
+
+    // Set size back to real size as it will be taking over the rendering duties.
+    newCursor.SetSize(ulSize);
+
+    return S_OK;
 }
 CATCH_RETURN()
 
+// Routine Description:
+// - Returns the first row of the logical line that contains the given row, or rather the first row
+//   at or above it, at which Reflow() can start without changing how any of the following rows reflow.
+// Arguments:
+// - row - the row to start searching from
+// Return Value:
+// - The row at which the logical line starts.
+til::CoordType TextBuffer::GetReflowStart(const til::CoordType row) const
+{
+    auto y = std::clamp(row, 0, _height - 1);
+    while (y > 0 && !_IsHardLineBreak(y - 1))
+    {
+        --y;
+    }
+    return y;
+}
+
+// Routine Description:
+// - The counterpart to calling Reflow() with a firstRow: Reflows the first historyRows rows of the history
+//   buffer into the new buffer and appends the first bufferRows rows of the buffer below them, as is.
+//   The buffer must have been reflowed from the history buffer before and have the same width as the new buffer.
+// Arguments:
+// - history - the text buffer that the rows above Reflow()'s firstRow were left behind in
+// - historyRows - the firstRow that was given to Reflow()
+// - buffer - the text buffer that Reflow() reflowed the remaining rows into
+// - bufferRows - the number of rows of the buffer that are in use
+// - newBuffer - the text buffer to copy the contents TO
+// Return Value:
+// - The distance that the rows of the buffer were moved down by in the new buffer.
+//   It's negative if the new buffer ran out of space and had to scroll them up instead.
+til::CoordType TextBuffer::ReflowWithHistory(const TextBuffer& history,
+                                             const til::CoordType historyRows,
+                                             const TextBuffer& buffer,
+                                             const til::CoordType bufferRows,
+                                             TextBuffer& newBuffer)
+{
+    auto& newCursor = newBuffer.GetCursor();
+
+    // Treating the history as if it was followed by another row ensures that the last logical line
+    // is terminated with a newline, just like it was when Reflow() reflowed the rest of the rows.
+    ReflowResult result;
+    static constexpr til::point noCursor{ -1, -1 };
+    if (!_ReflowRowsParallel(history, newBuffer, 0, historyRows, historyRows + 1, noCursor, std::nullopt, result))
+    {
+        _ReflowRows(history, newBuffer, 0, historyRows, historyRows + 1, noCursor, nullptr, result);
+    }
+
+    const auto top = newCursor.GetPosition().y;
+    til::CoordType scrolled = 0;
+
+    for (til::CoordType y = 0; y < bufferRows; ++y)
+    {
+        if (y != 0)
+        {
+            const auto before = newCursor.GetPosition().y;
+            newBuffer.NewlineCursor();
+            if (newCursor.GetPosition().y == before)
+            {
+                scrolled++;
+            }
+        }
+
+        const auto& src = buffer.GetRowByOffset(y);
+        auto& row = newBuffer.GetRowByOffset(newCursor.GetPosition().y);
+        row.CopyFrom(src);
+        row.SetDoubleBytePadded(src.WasDoubleBytePadded());
+    }
+
+    const auto offset = top - scrolled;
+
+    newBuffer.CopyProperties(buffer);
+    newBuffer.CopyHyperlinkMaps(buffer);
+    newBuffer.CopyPatterns(buffer);
+
+    const auto cursor = buffer.GetCursor().GetPosition();
+    newCursor.SetPosition({ cursor.x, std::clamp(cursor.y + offset, 0, newBuffer.GetSize().BottomInclusive()) });
+    newCursor.SetSize(buffer.GetCursor().GetSize());
+
+    return offset;
+}
+
 // Method Description:
 // - Adds or updates a hyperlink in our hyperlink table
 // Arguments:
@@ -2715,8 +3825,9 @@ uint16_t TextBuffer::GetHyperlinkId(std::wstring_view uri, std::wstring_view id)
         }
         numericId = (*(result.first)).second;
     }
-    // _currentHyperlinkId could overflow, make sure its not 0
-    if (_currentHyperlinkId == 0)
+    // _currentHyperlinkId could overflow, make sure its not 0 and that we don't hand out
+    // IDs which are still in use. IDs that were pruned are free to be reused this way.
+    for (uint32_t attempts = 0; (_currentHyperlinkId == 0 || _hyperlinkMap.contains(_currentHyperlinkId)) && attempts <= UINT16_MAX; ++attempts)
     {
         ++_currentHyperlinkId;
     }
@@ -2770,6 +3881,8 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
     _hyperlinkMap = other._hyperlinkMap;
     _hyperlinkCustomIdMap = other._hyperlinkCustomIdMap;
     _currentHyperlinkId = other._currentHyperlinkId;
+    _hyperlinkPruneCandidates = other._hyperlinkPruneCandidates;
+    _hyperlinkPruneCountdown = other._hyperlinkPruneCountdown;
 }
 
 // Method Description:
@@ -2817,19 +3930,29 @@ PointTree TextBuffer::GetPatterns(const til::CoordType firstRow, const til::Coor
 
     std::wstring concatAll;
     const auto rowSize = GetRowByOffset(0).size();
-    concatAll.reserve(gsl::narrow_cast<size_t>(rowSize) * gsl::narrow_cast<size_t>(lastRow - firstRow + 1));
-
-    // to deal with text that spans multiple lines, we will first concatenate
-    // all the text into one string and find the patterns in that string
-    for (til::CoordType i = firstRow; i <= lastRow; ++i)
-    {
-        auto& row = GetRowByOffset(i);
-        concatAll += row.GetText();
-    }
 
     // for each pattern we know of, iterate through the string
     for (const auto& idAndPattern : _idsAndPatterns)
     {
+        // The URL pattern is by far the most common one and is matched without std::wregex.
+        if (idAndPattern.second == UrlPattern)
+        {
+            _GetUrlPatterns(firstRow, lastRow, idAndPattern.first, intervals);
+            continue;
+        }
+
+        // to deal with text that spans multiple lines, we will first concatenate
+        // all the text into one string and find the patterns in that string
+        if (concatAll.empty())
+        {
+            concatAll.reserve(gsl::narrow_cast<size_t>(rowSize) * gsl::narrow_cast<size_t>(lastRow - firstRow + 1));
+            for (til::CoordType i = firstRow; i <= lastRow; ++i)
+            {
+                auto& row = GetRowByOffset(i);
+                concatAll += row.GetText();
+            }
+        }
+
         std::wregex regexObj{ idAndPattern.second };
 
         // search through the run with our regex object
@@ -2871,3 +3994,538 @@ PointTree TextBuffer::GetPatterns(const til::CoordType firstRow, const til::Coor
     PointTree result(std::move(intervals));
     return result;
 }
+
+namespace
+{
+    // The character classes used by TextBuffer::UrlPattern.
+    enum UrlCharClass : uint8_t
+    {
+        // [A-Za-z0-9_] as used by \b
+        UrlWord = 0b001,
+        // [-A-Za-z0-9+&@#/%?=~_|$!:,.;] which may appear anywhere in the URL after the scheme
+        UrlBody = 0b010,
+        // [A-Za-z0-9+&@#/%=~_|$] which may appear at the end of the URL
+        UrlEnd = 0b100,
+    };
+
+    constexpr auto urlCharClasses = []() {
+        std::array<uint8_t, 128> classes{};
+        for (const auto ch : std::string_view{ "-+&@#/%?=~_|$!:,.;" })
+        {
+            classes[ch] |= UrlBody;
+        }
+        for (const auto ch : std::string_view{ "+&@#/%=~_|$" })
+        {
+            classes[ch] |= UrlEnd;
+        }
+        for (const auto& [beg, end] : { std::pair{ 'A', 'Z' }, std::pair{ 'a', 'z' }, std::pair{ '0', '9' } })
+        {
+            for (auto ch = beg; ch <= end; ++ch)
+            {
+                classes[ch] |= UrlWord | UrlBody | UrlEnd;
+            }
+        }
+        classes['_'] |= UrlWord;
+        return classes;
+    }();
+
+    constexpr uint8_t urlCharClass(const wchar_t ch) noexcept
+    {
+        return ch < urlCharClasses.size() ? til::at(urlCharClasses, ch) : 0;
+    }
+
+    // Appends one character per column of the given row to `columns`. URLs only consist of ASCII
+    // characters and so all other columns are represented as U+FFFF, which is never part of a URL.
+    // This allows us to find URLs by column, without having to measure the width of the text.
+    void appendUrlColumns(const ROW& row, std::wstring& columns)
+    {
+        const til::CoordType width = row.size();
+        for (til::CoordType column = 0; column < width; ++column)
+        {
+            const auto glyph = row.GlyphAt(column);
+            columns.push_back(glyph.size() == 1 && til::at(glyph, 0) < 0x80 ? til::at(glyph, 0) : L'\uffff');
+        }
+    }
+
+    // Finds all matches of TextBuffer::UrlPattern in `text` and appends their [begin, end) offsets to `urls`.
+    // This is a hand-written equivalent of the std::wregex, which works like a small DFA:
+    // \b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$]
+    template<typename T>
+    void findUrls(const std::wstring_view& text, std::vector<std::pair<T, T>>& urls)
+    {
+        static constexpr std::array schemes{ L"https://"sv, L"http://"sv, L"ftp://"sv, L"file://"sv };
+
+        for (size_t i = 0; i < text.size();)
+        {
+            const auto ch = til::at(text, i);
+
+            // All schemes start with either "f" or "h", which are word characters and as such \b
+            // requires that the preceding character isn't one or that we're at the start of the text.
+            if ((ch == L'f' || ch == L'h') && (i == 0 || !(urlCharClass(til::at(text, i - 1)) & UrlWord)))
+            {
+                const auto remaining = text.substr(i);
+                size_t schemeLength = 0;
+                for (const auto& scheme : schemes)
+                {
+                    if (remaining.starts_with(scheme))
+                    {
+                        schemeLength = scheme.size();
+                        break;
+                    }
+                }
+
+                if (schemeLength)
+                {
+                    // The body is matched greedily, but has to end with an UrlEnd character.
+                    size_t end = 0;
+                    for (auto j = i + schemeLength; j < text.size(); ++j)
+                    {
+                        const auto c = urlCharClass(til::at(text, j));
+                        if (!(c & UrlBody))
+                        {
+                            break;
+                        }
+                        if (c & UrlEnd)
+                        {
+                            end = j + 1;
+                        }
+                    }
+
+                    if (end)
+                    {
+                        urls.emplace_back(gsl::narrow_cast<T>(i), gsl::narrow_cast<T>(end));
+                        i = end;
+                        continue;
+                    }
+                }
+            }
+
+            ++i;
+        }
+    }
+}
+
+// Method Description:
+// - Finds all URLs within the requested region of the text buffer and appends them to `intervals`.
+//   These are the same matches as GetPatterns() would find for UrlPattern with std::wregex.
+// - The URLs of each row are cached by the row's generation, so that only rows
+//   that changed since the last call need to be scanned again. A URL can only span multiple
+//   rows if it reaches the last column of a row. Those rows are scanned together and not cached.
+// Arguments:
+// - The firstRow to start searching from
+// - The lastRow to search
+// - The id of the pattern to store in the intervals
+// - The vector the found intervals are appended to
+void TextBuffer::_GetUrlPatterns(const til::CoordType firstRow, const til::CoordType lastRow, const size_t patternId, PointTree::interval_vector& intervals) const
+{
+    const til::CoordType rowSize = GetRowByOffset(0).size();
+
+    // We only need the cache to hold the rows of the last call, but keeping it a bit larger
+    // means we won't need to rescan a row that was scrolled out of the viewport and back in.
+    // The cache is guarded by its own lock, since this function is called by shared readers.
+    {
+        const std::lock_guard guard{ _urlCacheLock };
+        if (_urlCache.size() > 1024)
+        {
+            _urlCache.clear();
+        }
+    }
+
+    const auto emit = [&](const til::CoordType offset, const til::CoordType begin, const til::CoordType end) {
+        const auto start = offset + begin;
+        const auto stop = offset + end;
+        intervals.push_back(PointTree::interval({ start % rowSize, start / rowSize }, { stop % rowSize, stop / rowSize }, patternId));
+    };
+
+    std::wstring columns;
+    std::vector<std::pair<til::CoordType, til::CoordType>> chainUrls;
+
+    for (auto y = firstRow; y <= lastRow;)
+    {
+        // Relative to firstRow, just like the intervals GetPatterns() returns.
+        const auto offset = (y - firstRow) * rowSize;
+        const auto& row = GetRowByOffset(y);
+
+        {
+            const std::lock_guard guard{ _urlCacheLock };
+            if (const auto it = _urlCache.find(row.GetGeneration()); it != _urlCache.end())
+            {
+                for (const auto& [begin, end] : it->second)
+                {
+                    emit(offset, begin, end);
+                }
+                ++y;
+                continue;
+            }
+        }
+
+        columns.clear();
+        appendUrlColumns(row, columns);
+
+        auto yEnd = y + 1;
+        for (; yEnd <= lastRow && !columns.empty() && (urlCharClass(columns.back()) & UrlBody); ++yEnd)
+        {
+            appendUrlColumns(GetRowByOffset(yEnd), columns);
+        }
+
+        if (yEnd == y + 1 && (columns.empty() || !(urlCharClass(columns.back()) & UrlBody)))
+        {
+            std::vector<std::pair<uint16_t, uint16_t>> urls;
+            findUrls(columns, urls);
+            for (const auto& [begin, end] : urls)
+            {
+                emit(offset, begin, end);
+            }
+
+            const std::lock_guard guard{ _urlCacheLock };
+            _urlCache.insert_or_assign(row.GetGeneration(), std::move(urls));
+        }
+        else
+        {
+            chainUrls.clear();
+            findUrls(columns, chainUrls);
+            for (const auto& [begin, end] : chainUrls)
+            {
+                emit(offset, begin, end);
+            }
+        }
+
+        y = yEnd;
+    }
+}
+
+// Method Description:
+// - Finds the URL (see UrlPattern) at the given position, anywhere in the buffer.
+// - Unlike GetPatterns(), this only scans the rows the URL may span. Since it uses the
+//   same per-row cache as _GetUrlPatterns(), it's cheap enough to be called on every mouse move.
+// - URLs that wrap across more than MaxUrlRows rows in either direction are cut off.
+// Arguments:
+// - pos - The position to look at, in buffer coordinates
+// - patternId - The id of the pattern to store in the interval
+// Return Value:
+// - The URL's interval in buffer coordinates, or nullopt if there's no URL at pos.
+std::optional<PointTree::interval> TextBuffer::GetUrlAt(const til::point pos, const size_t patternId) const
+{
+    static constexpr til::CoordType MaxUrlRows = 32;
+
+    const auto size = GetSize();
+    if (!size.IsInBounds(pos))
+    {
+        return std::nullopt;
+    }
+
+    const auto rowSize = size.Width();
+    const auto continuesIntoNextRow = [&](const til::CoordType y) {
+        const auto glyph = GetRowByOffset(y).GlyphAt(rowSize - 1);
+        return glyph.size() == 1 && (urlCharClass(til::at(glyph, 0)) & UrlBody);
+    };
+
+    auto firstRow = pos.y;
+    while (firstRow > 0 && pos.y - firstRow < MaxUrlRows && continuesIntoNextRow(firstRow - 1))
+    {
+        --firstRow;
+    }
+
+    auto lastRow = pos.y;
+    while (lastRow < size.BottomInclusive() && lastRow - pos.y < MaxUrlRows && continuesIntoNextRow(lastRow))
+    {
+        ++lastRow;
+    }
+
+    PointTree::interval_vector intervals;
+    _GetUrlPatterns(firstRow, lastRow, patternId, intervals);
+
+    // The intervals are relative to firstRow and sorted by their start.
+    const auto target = (pos.y - firstRow) * rowSize + pos.x;
+    for (auto& interval : intervals)
+    {
+        const auto start = interval.start.y * rowSize + interval.start.x;
+        const auto stop = interval.stop.y * rowSize + interval.stop.x;
+        if (start > target)
+        {
+            break;
+        }
+        if (target < stop)
+        {
+            interval.start.y += firstRow;
+            interval.stop.y += firstRow;
+            return interval;
+        }
+    }
+
+    return std::nullopt;
+}
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// Returns the offset of the first position at or after `offset`, where the haystack might contain the needle,
+// judging by its first 2 chars. `prefix` contains 2 variants (the lower and upper case form) of each of those chars.
+// If the needle is just 1 char long, `twoChars` is false and the last 2 entries of `prefix` are ignored.
+// Returns haystack.size() if the needle doesn't occur at or after the given offset.
+static size_t findSearchCandidate(const std::wstring_view& haystack, const size_t offset, const std::array<wchar_t, 4>& prefix, const bool twoChars) noexcept
+{
+    const auto beg = haystack.data();
+    const auto end = beg + haystack.size();
+    auto it = beg + std::min(offset, haystack.size());
+
+    // The vectorized loops compare 8 chars at `it` against the first needle char and the 8 chars
+    // at `it + 1` against the second one. This is why they need at least 9 chars to work with.
+#if defined(TIL_SSE_INTRINSICS)
+    {
+        const auto a0 = _mm_set1_epi16(til::at(prefix, 0));
+        const auto b0 = _mm_set1_epi16(til::at(prefix, 1));
+        const auto a1 = _mm_set1_epi16(til::at(prefix, 2));
+        const auto b1 = _mm_set1_epi16(til::at(prefix, 3));
+        const auto any1 = twoChars ? _mm_setzero_si128() : _mm_set1_epi16(-1);
+
+        for (; end - it >= 9; it += 8)
+        {
+            const auto v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 1));
+            const auto m0 = _mm_or_si128(_mm_cmpeq_epi16(v0, a0), _mm_cmpeq_epi16(v0, b0));
+            const auto m1 = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v1, a1), _mm_cmpeq_epi16(v1, b1)), any1);
+            if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(m0, m1))))
+            {
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return gsl::narrow_cast<size_t>(it - beg) + (index / 2);
+            }
+        }
+    }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+    {
+        const auto a0 = vdupq_n_u16(til::at(prefix, 0));
+        const auto b0 = vdupq_n_u16(til::at(prefix, 1));
+        const auto a1 = vdupq_n_u16(til::at(prefix, 2));
+        const auto b1 = vdupq_n_u16(til::at(prefix, 3));
+        const auto any1 = vdupq_n_u16(twoChars ? 0 : 0xffff);
+
+        for (; end - it >= 9; it += 8)
+        {
+            const auto v0 = vld1q_u16(reinterpret_cast<const uint16_t*>(it));
+            const auto v1 = vld1q_u16(reinterpret_cast<const uint16_t*>(it + 1));
+            const auto m0 = vorrq_u16(vceqq_u16(v0, a0), vceqq_u16(v0, b0));
+            const auto m1 = vorrq_u16(vorrq_u16(vceqq_u16(v1, a1), vceqq_u16(v1, b1)), any1);
+            // Narrow each 16-bit lane down to 8 bits, so that the 8 lanes fit into a single uint64_t.
+            const auto hits = vmovn_u16(vandq_u16(m0, m1));
+            if (const auto mask = vget_lane_u64(vreinterpret_u64_u8(hits), 0))
+            {
+                unsigned long index;
+                _BitScanForward64(&index, mask);
+                return gsl::narrow_cast<size_t>(it - beg) + (index / 8);
+            }
+        }
+    }
+#endif
+
+    for (; it != end; ++it)
+    {
+        const auto c0 = *it;
+        if (c0 == til::at(prefix, 0) || c0 == til::at(prefix, 1))
+        {
+            if (!twoChars)
+            {
+                break;
+            }
+            if (end - it >= 2)
+            {
+                const auto c1 = it[1];
+                if (c1 == til::at(prefix, 2) || c1 == til::at(prefix, 3))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return gsl::narrow_cast<size_t>(it - beg);
+}
+
+#pragma warning(pop)
+
+// Routine Description:
+// - Calls findMatch for each line in the given rows and collects the matches it returns. Soft-wrapped rows
+//   are concatenated into a single line, so that matches can span them. Matches can't span hard line breaks.
+// Arguments:
+// - rowBeg - The first row to search
+// - rowEnd - The row past the last row to search
+// - results - The vector the first and last (inclusive) cell of each match gets appended to
+// - findMatch - Called as findMatch(line, offset) and returns the offset of the first match at or after
+//   offset and the one past its end, or npos if there's none. Empty matches are skipped.
+template<typename FindMatch>
+void TextBuffer::_SearchLines(til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results, FindMatch&& findMatch) const
+{
+    rowBeg = std::max(0, rowBeg);
+    rowEnd = std::min(rowEnd, _estimateOffsetOfLastCommittedRow() + 1);
+
+    // Soft-wrapped rows are concatenated into `line`. rowStarts[i] is the offset in the line at which row y+i starts.
+    std::wstring line;
+    std::vector<size_t> rowStarts;
+
+    for (auto y = rowBeg; y < rowEnd;)
+    {
+        std::wstring_view haystack;
+        auto yEnd = y;
+
+        line.clear();
+        rowStarts.clear();
+
+        for (;;)
+        {
+            const auto& row = GetRowByOffset(yEnd++);
+            auto text = row.GetText();
+            const auto wrapped = row.WasWrapForced() && yEnd < rowEnd;
+
+            // The padding inserted before a wide glyph that didn't fit into the row isn't part of the text.
+            if (wrapped && row.WasDoubleBytePadded() && !text.empty())
+            {
+                text.remove_suffix(1);
+            }
+
+            rowStarts.emplace_back(line.size());
+
+            // The common case is a row that isn't wrapped. Its text can be searched without copying it.
+            if (!wrapped && rowStarts.size() == 1)
+            {
+                haystack = text;
+                break;
+            }
+
+            line.append(text);
+
+            if (!wrapped)
+            {
+                haystack = line;
+                break;
+            }
+        }
+
+        const auto toPoint = [&](const size_t offset, const bool trailing) {
+            const auto it = std::upper_bound(rowStarts.begin(), rowStarts.end(), offset) - 1;
+            const auto rowOffset = gsl::narrow_cast<til::CoordType>(it - rowStarts.begin());
+            const auto& row = GetRowByOffset(y + rowOffset);
+            const auto charOffset = gsl::narrow_cast<ptrdiff_t>(offset - *it);
+            const auto x = trailing ? row.GetTrailingColumnAtCharOffset(charOffset) : row.GetLeadingColumnAtCharOffset(charOffset);
+            return til::point{ x, y + rowOffset };
+        };
+
+        for (size_t offset = 0; offset <= haystack.size();)
+        {
+            const auto [beg, end] = findMatch(haystack, offset);
+            if (beg >= haystack.size())
+            {
+                break;
+            }
+            if (end > beg)
+            {
+                results.emplace_back(til::point_span{ toPoint(beg, false), toPoint(end - 1, true) });
+            }
+            offset = std::max(end, beg + 1);
+        }
+
+        y = yEnd;
+    }
+}
+
+// Routine Description:
+// - Finds all occurrences of the needle in the given rows in a single pass. Soft-wrapped rows are searched
+//   as a single line, so that matches can span them. Matches don't overlap and can't span hard line breaks.
+// - The text of each row is scanned directly, with a vectorized filter for the first 2 chars of the needle.
+//   For case-insensitive searches the needle is folded with towlower() upfront. The filter looks for
+//   the lower and upper case form of each char, which means that it misses the few chars that only fold
+//   into the needle's chars, but aren't their upper case form, like the Kelvin sign.
+// Arguments:
+// - needle - The text to search for
+// - caseInsensitive - Whether the case of the text should be ignored
+// - rowBeg - The first row to search
+// - rowEnd - The row past the last row to search
+// Return Value:
+// - The first and last (inclusive) cell of each match, in order.
+std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& needle, const bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    std::vector<til::point_span> results;
+
+    if (needle.empty())
+    {
+        return results;
+    }
+
+    std::wstring folded{ needle };
+    if (caseInsensitive)
+    {
+        for (auto& ch : folded)
+        {
+            ch = ::towlower(ch);
+        }
+    }
+
+    const auto twoChars = folded.size() > 1;
+    const auto c0 = til::at(folded, 0);
+    const auto c1 = twoChars ? til::at(folded, 1) : L'\0';
+    const std::array<wchar_t, 4> prefix{
+        c0,
+        caseInsensitive ? ::towupper(c0) : c0,
+        c1,
+        caseInsensitive ? ::towupper(c1) : c1,
+    };
+
+    const auto matchesAt = [&](const std::wstring_view& haystack, const size_t offset) noexcept {
+        if (haystack.size() - offset < folded.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < folded.size(); ++i)
+        {
+            const auto ch = til::at(haystack, offset + i);
+            if ((caseInsensitive ? ::towlower(ch) : ch) != til::at(folded, i))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    _SearchLines(rowBeg, rowEnd, results, [&](const std::wstring_view& haystack, size_t offset) {
+        while ((offset = findSearchCandidate(haystack, offset, prefix, twoChars)) < haystack.size())
+        {
+            if (matchesAt(haystack, offset))
+            {
+                return std::pair{ offset, offset + folded.size() };
+            }
+            ++offset;
+        }
+        return std::pair{ std::wstring_view::npos, std::wstring_view::npos };
+    });
+
+    return results;
+}
+
+// Routine Description:
+// - Finds all matches of the regular expression in the given rows, the same way SearchText() does.
+//   See SearchRegex for the supported syntax. "^" and "$" match at the start and end of each line.
+// Arguments:
+// - pattern - The regular expression to search for
+// - caseInsensitive - Whether the case of the text should be ignored
+// - rowBeg - The first row to search
+// - rowEnd - The row past the last row to search
+// Return Value:
+// - The first and last (inclusive) cell of each non-empty match, in order.
+//   There are none if the pattern is invalid.
+std::vector<til::point_span> TextBuffer::SearchTextRegex(const std::wstring_view& pattern, const bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    std::vector<til::point_span> results;
+
+    const auto regex = pattern.empty() ? nullptr : SearchRegex::Compile(pattern, caseInsensitive);
+    if (!regex)
+    {
+        return results;
+    }
+
+    _SearchLines(rowBeg, rowEnd, results, [&](const std::wstring_view& haystack, const size_t offset) {
+        return regex->Find(haystack, offset);
+    });
+
+    return results;
+}
@@ -53,6 +53,7 @@ filling in the last row, and updating the screen.
 
 #include "cursor.h"
 #include "Row.hpp"
+#include "ScrollbackArchive.hpp"
 #include "TextAttribute.hpp"
 #include "../types/inc/Viewport.hpp"
 
@@ -82,6 +83,7 @@ public:
 
     // Used for duplicating properties to another text buffer
     void CopyProperties(const TextBuffer& OtherBuffer) noexcept;
+    void SetRecyclable(const bool recyclable) noexcept;
 
     // row manipulation
     ROW& GetScratchpadRow();
@@ -100,6 +102,11 @@ public:
     static void ConsumeGrapheme(std::wstring_view& chars) noexcept;
     void WriteLine(til::CoordType row, bool wrapAtEOL, const TextAttribute& attributes, RowWriteState& state);
     void FillRect(const til::rect& rect, const std::wstring_view& fill, const TextAttribute& attributes);
+    size_t FillText(const til::point target, const wchar_t ch, const size_t count, const std::optional<bool> wrap = std::nullopt);
+    size_t FillAttributes(const til::point target, const TextAttribute& attributes, const size_t count);
+    void RemeasureGlyphs(const std::span<const char32_t> codepoints, const uint64_t generation);
+    void WriteCharInfos(const til::point target, const std::span<const CHAR_INFO> infos);
+    void ReadCharInfos(const til::point target, const std::span<CHAR_INFO> infos) const;
 
     OutputCellIterator Write(const OutputCellIterator givenIt);
 
@@ -119,6 +126,11 @@ public:
 
     // Scroll needs access to this to quickly rotate around the buffer.
     void IncrementCircularBuffer(const TextAttribute& fillAttributes = {});
+    uint64_t GetRowsScrolled() const noexcept;
+    void CompactScrollback(const til::CoordType limit);
+    void TrimMemory(const std::span<const til::point_span> inUse, const bool compactText);
+    static void TrimRecycledMemory() noexcept;
+    size_t GetMemoryUsage() const noexcept;
 
     til::point GetLastNonSpaceCharacter(std::optional<const Microsoft::Console::Types::Viewport> viewOptional = std::nullopt) const;
 
@@ -130,6 +142,7 @@ public:
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
 
     void ScrollRows(const til::CoordType firstRow, const til::CoordType size, const til::CoordType delta);
+    std::vector<til::CoordType> GetChangedRowsSince(uint64_t generation, til::CoordType beg, til::CoordType end) const;
 
     til::CoordType TotalRowCount() const noexcept;
 
@@ -159,21 +172,23 @@ public:
     void TriggerRedraw(const Microsoft::Console::Types::Viewport& viewport);
     void TriggerRedrawCursor(const til::point position);
     void TriggerRedrawAll();
+    void TriggerRedrawSearchHighlights(std::span<const til::point_span> highlights);
     void TriggerScroll();
     void TriggerScroll(const til::point delta);
+    void TriggerScrollRegion(const til::rect& region, const til::CoordType delta);
     void TriggerNewTextNotification(const std::wstring_view newText);
 
-    til::point GetWordStart(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
-    til::point GetWordEnd(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
-    bool MoveToNextWord(til::point& pos, const std::wstring_view wordDelimiters, std::optional<til::point> limitOptional = std::nullopt) const;
-    bool MoveToPreviousWord(til::point& pos, const std::wstring_view wordDelimiters) const;
+    til::point GetWordStart(const til::point target, const WordDelimiters& wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
+    til::point GetWordEnd(const til::point target, const WordDelimiters& wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
+    bool MoveToNextWord(til::point& pos, const WordDelimiters& wordDelimiters, std::optional<til::point> limitOptional = std::nullopt) const;
+    bool MoveToPreviousWord(til::point& pos, const WordDelimiters& wordDelimiters) const;
 
     til::point GetGlyphStart(const til::point pos, std::optional<til::point> limitOptional = std::nullopt) const;
     til::point GetGlyphEnd(const til::point pos, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
     bool MoveToNextGlyph(til::point& pos, bool allowBottomExclusive = false, std::optional<til::point> limitOptional = std::nullopt) const;
     bool MoveToPreviousGlyph(til::point& pos, std::optional<til::point> limitOptional = std::nullopt) const;
 
-    const std::vector<til::inclusive_rect> GetTextRects(til::point start, til::point end, bool blockSelection, bool bufferCoordinates) const;
+    const std::vector<til::inclusive_rect> GetTextRects(til::point start, til::point end, bool blockSelection, bool bufferCoordinates, til::CoordType rowBeg = til::CoordTypeMin, til::CoordType rowEnd = til::CoordTypeMax) const;
     std::vector<til::point_span> GetTextSpans(til::point start, til::point end, bool blockSelection, bool bufferCoordinates) const;
 
     void AddHyperlinkToMap(std::wstring_view uri, uint16_t id);
@@ -186,9 +201,17 @@ public:
     class TextAndColor
     {
     public:
+        // A number of consecutive wchar_t in a row of text with identical colors.
+        struct ColorRun
+        {
+            COLORREF foreground;
+            COLORREF background;
+            size_t length;
+        };
+
         std::vector<std::wstring> text;
-        std::vector<std::vector<COLORREF>> FgAttr;
-        std::vector<std::vector<COLORREF>> BkAttr;
+        // The colors of each row of text, if requested. The lengths of the runs in a row add up to the row's length.
+        std::vector<std::vector<ColorRun>> colors;
     };
 
     size_t SpanLength(const til::point coordStart, const til::point coordEnd) const;
@@ -220,12 +243,27 @@ public:
     static HRESULT Reflow(TextBuffer& oldBuffer,
                           TextBuffer& newBuffer,
                           const std::optional<Microsoft::Console::Types::Viewport> lastCharacterViewport,
-                          std::optional<std::reference_wrapper<PositionInformation>> positionInfo);
+                          std::optional<std::reference_wrapper<PositionInformation>> positionInfo,
+                          const til::CoordType firstRow = 0);
+    til::CoordType GetReflowStart(const til::CoordType row) const;
+    static til::CoordType ReflowWithHistory(const TextBuffer& history,
+                                            const til::CoordType historyRows,
+                                            const TextBuffer& buffer,
+                                            const til::CoordType bufferRows,
+                                            TextBuffer& newBuffer);
+
+    // The regular expression used for hyperlink detection. GetPatterns() recognizes it
+    // and finds its matches using a hand-written matcher instead of std::wregex.
+    static constexpr std::wstring_view UrlPattern{ LR"(\b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])" };
 
     const size_t AddPatternRecognizer(const std::wstring_view regexString);
     void ClearPatternRecognizers() noexcept;
     void CopyPatterns(const TextBuffer& OtherBuffer);
     interval_tree::IntervalTree<til::point, size_t> GetPatterns(const til::CoordType firstRow, const til::CoordType lastRow) const;
+    std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> GetUrlAt(const til::point pos, const size_t patternId) const;
+
+    std::vector<til::point_span> SearchText(const std::wstring_view& needle, const bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
+    std::vector<til::point_span> SearchTextRegex(const std::wstring_view& pattern, const bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
 
 private:
     void _reserve(til::size screenBufferSize, const TextAttribute& defaultAttributes);
@@ -233,6 +271,15 @@ private:
     void _decommit() noexcept;
     void _construct(const std::byte* until) noexcept;
     void _destroy() const noexcept;
+    void _recycle() noexcept;
+    ROW& _constructAt(size_t offset);
+    void _restore(size_t offset);
+    void _decommitArchived(size_t beg, size_t end) noexcept;
+    template<typename T>
+    void _archiveRows(til::CoordType beg, til::CoordType end, T&& predicate);
+    bool _isInitialRow(const ROW& row) const noexcept;
+    size_t _getOffset(til::CoordType index) const noexcept;
+    void _copyRows(til::CoordType firstRow, til::CoordType size, til::CoordType delta);
     ROW& _getRowByOffsetDirect(size_t offset);
     til::CoordType _estimateOffsetOfLastCommittedRow() const noexcept;
 
@@ -244,23 +291,77 @@ private:
     void _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
     bool _AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribute);
     void _ExpandTextRow(til::inclusive_rect& selectionRow) const;
-    DelimiterClass _GetDelimiterClassAt(const til::point pos, const std::wstring_view wordDelimiters) const;
-    til::point _GetWordStartForAccessibility(const til::point target, const std::wstring_view wordDelimiters) const;
-    til::point _GetWordStartForSelection(const til::point target, const std::wstring_view wordDelimiters) const;
-    til::point _GetWordEndForAccessibility(const til::point target, const std::wstring_view wordDelimiters, const til::point limit) const;
-    til::point _GetWordEndForSelection(const til::point target, const std::wstring_view wordDelimiters) const;
+    DelimiterClass _GetDelimiterClassAt(const til::point pos, const WordDelimiters& wordDelimiters) const;
+    til::point _GetWordStartForAccessibility(const til::point target, const WordDelimiters& wordDelimiters) const;
+    til::point _GetWordStartForSelection(const til::point target, const WordDelimiters& wordDelimiters) const;
+    til::point _GetWordEndForAccessibility(const til::point target, const WordDelimiters& wordDelimiters, const til::point limit) const;
+    til::point _GetWordEndForSelection(const til::point target, const WordDelimiters& wordDelimiters) const;
+    struct RowWordStarts;
+    void _PrepareWordStartCache(const WordDelimiters& wordDelimiters) const;
+    const RowWordStarts& _GetRowWordStarts(const til::CoordType y, const WordDelimiters& wordDelimiters) const;
+    bool _IsRowWordStart(const til::point pos, const WordDelimiters& wordDelimiters) const;
     void _PruneHyperlinks();
+    std::vector<uint16_t> _GetHyperlinksByOffset(const til::CoordType index) const;
+    template<typename FindMatch>
+    void _SearchLines(til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results, FindMatch&& findMatch) const;
+    void _GetUrlPatterns(const til::CoordType firstRow, const til::CoordType lastRow, const size_t patternId, interval_tree::IntervalTree<til::point, size_t>::interval_vector& intervals) const;
+
+    static void _AppendRTFText(fmt::memory_buffer& contentBuilder, const std::wstring_view& text);
+    bool _IsHardLineBreak(const til::CoordType y) const;
 
-    static void _AppendRTFText(std::ostringstream& contentBuilder, const std::wstring_view& text);
+    struct ReflowResult
+    {
+        std::optional<til::point> cursor;
+        std::optional<til::CoordType> mutableViewportTop;
+        std::optional<til::CoordType> visibleViewportTop;
+    };
+
+    static void _ReflowRows(const TextBuffer& oldBuffer,
+                            TextBuffer& newBuffer,
+                            const til::CoordType rowBeg,
+                            const til::CoordType rowEnd,
+                            const til::CoordType rowsTotal,
+                            const til::point cOldCursorPos,
+                            const PositionInformation* oldPositions,
+                            ReflowResult& result);
+    static bool _ReflowRowsParallel(const TextBuffer& oldBuffer,
+                                    TextBuffer& newBuffer,
+                                    const til::CoordType rowBeg,
+                                    const til::CoordType rowEnd,
+                                    const til::CoordType rowsTotal,
+                                    const til::point cOldCursorPos,
+                                    const std::optional<PositionInformation>& oldPositions,
+                                    ReflowResult& result);
 
     Microsoft::Console::Render::Renderer& _renderer;
 
     std::unordered_map<uint16_t, std::wstring> _hyperlinkMap;
     std::unordered_map<std::wstring, uint16_t> _hyperlinkCustomIdMap;
     uint16_t _currentHyperlinkId = 1;
+    // Hyperlink IDs of ROWs that scrolled off since the last sweep, and
+    // the number of ROWs that may scroll off until the next one. See _PruneHyperlinks().
+    std::unordered_set<uint16_t> _hyperlinkPruneCandidates;
+    til::CoordType _hyperlinkPruneCountdown = 0;
 
     std::unordered_map<size_t, std::wstring> _idsAndPatterns;
     size_t _currentPatternId = 0;
+    // The URLs found in each ROW by _GetUrlPatterns(), keyed by ROW::GetGeneration().
+    // Only contains ROWs whose URLs can't continue into the next ROW.
+    mutable std::unordered_map<uint64_t, std::vector<std::pair<uint16_t, uint16_t>>> _urlCache;
+    mutable std::mutex _urlCacheLock;
+
+    // The columns at which readable words (see GetWordStart()'s accessibilityMode) begin in each ROW,
+    // keyed by ROW::GetGeneration(). Column 0 is included if it holds a RegularChar, even if the word
+    // actually started in the previous, wrapped ROW. See _IsRowWordStart().
+    struct RowWordStarts
+    {
+        std::vector<uint16_t> columns;
+        bool endsWithRegularChar = false;
+    };
+    mutable std::unordered_map<uint64_t, RowWordStarts> _wordStartCache;
+    // The delimiters _wordStartCache was computed with. It's cleared when they change.
+    mutable WordDelimiters _wordStartCacheDelimiters;
+    mutable std::mutex _wordStartCacheLock;
 
     // This block describes the state of the underlying virtual memory buffer that holds all ROWs, text and attributes.
     // Initially memory is only allocated with MEM_RESERVE to reduce the private working set of conhost.
@@ -293,6 +394,7 @@ private:
     // _commitWatermark will always be a multiple of _bufferRowStride away from _buffer.
     // In other words, _commitWatermark itself will either point exactly onto the next ROW
     // that should be committed or be equal to _bufferEnd when all ROWs are committed.
+    // It's accessed atomically by _getRowByOffsetDirect(), because shared readers may commit ROWs concurrently.
     std::byte* _commitWatermark = nullptr;
     // This will MEM_COMMIT 128 rows more than we need, to avoid us from having to call VirtualAlloc too often.
     // This equates to roughly the following commit chunk sizes at these column counts:
@@ -314,6 +416,27 @@ private:
     size_t _bufferRowStride = 0;
     size_t _bufferOffsetChars = 0;
     size_t _bufferOffsetCharOffsets = 0;
+    // ROWs that CompactScrollback() moved out of the memory arena. Their memory may have been decommitted
+    // and they aren't constructed anymore, even if they're below the _commitWatermark.
+    // _getRowByOffsetDirect() transparently restores them when they're accessed.
+    ScrollbackArchive _archive;
+    // Serializes _commit() and _restore() between concurrent readers. See _getRowByOffsetDirect().
+    std::mutex _lazyRowsLock;
+    // Maps the row positions that _getOffset() computes (= _firstRow + index) to ROW slots in
+    // the memory arena and vice versa. Both are empty and the mapping the identity (+1 for the
+    // scratchpad row) until ScrollRows() permutes the ROWs. _rowSlotsScratch is used by the latter.
+    std::vector<uint16_t> _rowSlots;
+    std::vector<uint16_t> _rowSlotPositions;
+    std::vector<uint16_t> _rowSlotsScratch;
+    // A ROW generation (see ROW::NextGeneration) taken whenever ROWs were moved to different
+    // positions, or all of them got reset. See GetChangedRowsSince().
+    uint64_t _layoutGeneration = ROW::NextGeneration();
+    // The number of times IncrementCircularBuffer() was called. Together with the limit passed to
+    // CompactScrollback() this tells us how many ROWs scrolled past it since it last ran.
+    uint64_t _rowsScrolled = 0;
+    uint64_t _lastCompaction = 0;
+    // CompactScrollback() only scans the buffer after this many ROWs scrolled past its limit.
+    static constexpr uint64_t _compactionInterval = 256;
     // The width of the buffer in columns.
     uint16_t _width = 0;
     // The height of the buffer in rows, excluding the scratchpad row.
@@ -325,9 +448,15 @@ private:
     Cursor _cursor;
 
     bool _isActiveBuffer = false;
+    // Whether the destructor hands the memory arena over to the next buffer of the same size.
+    bool _recyclable = false;
+
+    // BufferSnapshot persists and restores the hyperlink maps along with the ROWs.
+    friend class BufferSnapshot;
 
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
+    friend class ReflowTests;
     friend class UiaTextRangeTests;
 #endif
 };
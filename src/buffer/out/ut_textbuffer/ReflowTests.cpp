@@ -840,6 +840,64 @@ class ReflowTests
             _compareTextBufferAgainstTestBuffer(*textBuffer, testBuffer);
         }
     }
+
+    TEST_METHOD(TestParallelReflowMatchesSerial)
+    {
+        if (std::thread::hardware_concurrency() < 2)
+        {
+            Log::Result(TestResults::Skipped);
+            return;
+        }
+
+        // Lines of varying length (some wrapped, some containing wide glyphs) in a buffer large enough to be split.
+        static constexpr til::size oldSize{ 100, 6000 };
+        static constexpr til::size newSize{ 37, 9000 };
+        const auto oldBuffer = std::make_unique<TextBuffer>(oldSize, TextAttribute{ 0x7 }, 0, false, renderer);
+        for (til::CoordType y = 0; y < oldSize.height; ++y)
+        {
+            auto& row = oldBuffer->GetRowByOffset(y);
+            const auto length = (y * 7919) % (oldSize.width + 1);
+            for (til::CoordType x = 0; x < length; ++x)
+            {
+                if (x % 13 == 12 && x + 1 < length)
+                {
+                    row.ReplaceCharacters(x++, 2, L"\x3042");
+                }
+                else
+                {
+                    const wchar_t ch = L'A' + (x + y) % 26;
+                    row.ReplaceCharacters(x, 1, { &ch, 1 });
+                }
+            }
+            row.SetWrapForced(length == oldSize.width && y % 3 != 0);
+        }
+
+        const til::point cursor{ 7, 4321 };
+        const TextBuffer::PositionInformation positions{ .mutableViewportTop = 5000, .visibleViewportTop = 2500 };
+
+        const auto serialBuffer = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::ReflowResult serial;
+        TextBuffer::_ReflowRows(*oldBuffer, *serialBuffer, 0, oldSize.height, oldSize.height, cursor, &positions, serial);
+
+        const auto parallelBuffer = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::ReflowResult parallel;
+        VERIFY_IS_TRUE(TextBuffer::_ReflowRowsParallel(*oldBuffer, *parallelBuffer, 0, oldSize.height, oldSize.height, cursor, positions, parallel));
+
+        VERIFY_IS_TRUE(serial.cursor == parallel.cursor);
+        VERIFY_IS_TRUE(serial.mutableViewportTop == parallel.mutableViewportTop);
+        VERIFY_IS_TRUE(serial.visibleViewportTop == parallel.visibleViewportTop);
+        VERIFY_ARE_EQUAL(serialBuffer->GetCursor().GetPosition(), parallelBuffer->GetCursor().GetPosition());
+
+        for (til::CoordType y = 0; y < newSize.height; ++y)
+        {
+            const auto& expected = serialBuffer->GetRowByOffset(y);
+            const auto& actual = parallelBuffer->GetRowByOffset(y);
+            VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+            VERIFY_ARE_EQUAL(expected.WasWrapForced(), actual.WasWrapForced());
+            VERIFY_ARE_EQUAL(expected.WasDoubleBytePadded(), actual.WasDoubleBytePadded());
+            VERIFY_IS_TRUE(expected.Attributes() == actual.Attributes());
+        }
+    }
 };
 
 DummyRenderer ReflowTests::renderer{};
@@ -25,6 +25,7 @@ class TextAttributeTests
     TEST_METHOD(TestReverseDefaultColors);
     TEST_METHOD(TestRoundtripDefaultColors);
     TEST_METHOD(TestIntenseAsBright);
+    TEST_METHOD(TestColorTableChangeUpdatesAttributeColors);
 
     RenderSettings _renderSettings;
     const COLORREF _defaultFg = RGB(1, 2, 3);
@@ -325,3 +326,26 @@ void TextAttributeTests::TestIntenseAsBright()
     // Restore the default IntenseIsBright mode.
     _renderSettings.SetRenderMode(RenderSettings::Mode::IntenseIsBright, true);
 }
+
+void TextAttributeTests::TestColorTableChangeUpdatesAttributeColors()
+{
+    const auto darkGreen = _renderSettings.GetColorTableEntry(TextColor::DARK_GREEN);
+    const auto otherGreen = RGB(0, 100, 0);
+    TextAttribute attr{};
+    attr.SetIndexedForeground(TextColor::DARK_GREEN);
+
+    VERIFY_ARE_EQUAL(std::make_pair(darkGreen, _defaultBg), _renderSettings.GetAttributeColors(attr));
+
+    Log::Comment(L"The resolved colors of an attribute must follow changes to the color table");
+    _renderSettings.SetColorTableEntry(TextColor::DARK_GREEN, otherGreen);
+    VERIFY_ARE_EQUAL(std::make_pair(otherGreen, _defaultBg), _renderSettings.GetAttributeColors(attr));
+
+    Log::Comment(L"...and to the color aliases");
+    _renderSettings.SetColorAliasIndex(ColorAlias::DefaultBackground, TextColor::DARK_GREEN);
+    VERIFY_ARE_EQUAL(std::make_pair(otherGreen, otherGreen), _renderSettings.GetAttributeColors(attr));
+
+    // Restore the defaults.
+    _renderSettings.SetColorAliasIndex(ColorAlias::DefaultBackground, _defaultBgIndex);
+    _renderSettings.SetColorTableEntry(TextColor::DARK_GREEN, darkGreen);
+    VERIFY_ARE_EQUAL(std::make_pair(darkGreen, _defaultBg), _renderSettings.GetAttributeColors(attr));
+}
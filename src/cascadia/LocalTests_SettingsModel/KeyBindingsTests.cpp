@@ -43,6 +43,7 @@ namespace SettingsModelLocalTests
         TEST_METHOD(UnbindKeybindings);
         TEST_METHOD(LayerScancodeKeybindings);
         TEST_METHOD(TestExplicitUnbind);
+        TEST_METHOD(TestFlattenedKeyChordLookup);
         TEST_METHOD(TestArbitraryArgs);
         TEST_METHOD(TestSplitPaneArgs);
         TEST_METHOD(TestStringOverload);
@@ -267,6 +268,51 @@ namespace SettingsModelLocalTests
         VERIFY_IS_FALSE(actionMap->IsKeyChordExplicitlyUnbound(keyChord));
     }
 
+    void KeyBindingsTests::TestFlattenedKeyChordLookup()
+    {
+        const std::string parentString{ R"([ { "command": "copy", "keys": ["ctrl+c"] }, { "command": "paste", "keys": ["ctrl+v"] } ])" };
+        const std::string childString{ R"([ { "command": "unbound", "keys": ["ctrl+c"] }, { "command": "closePane", "keys": ["ctrl+w"] } ])" };
+
+        const auto parentJson = VerifyParseSucceeded(parentString);
+        const auto childJson = VerifyParseSucceeded(childString);
+
+        const KeyChord ctrlC{ VirtualKeyModifiers::Control, static_cast<int32_t>('C'), 0 };
+        const KeyChord ctrlV{ VirtualKeyModifiers::Control, static_cast<int32_t>('V'), 0 };
+        const KeyChord ctrlW{ VirtualKeyModifiers::Control, static_cast<int32_t>('W'), 0 };
+        const KeyChord ctrlX{ VirtualKeyModifiers::Control, static_cast<int32_t>('X'), 0 };
+        const KeyChord shiftV{ VirtualKeyModifiers::Shift, static_cast<int32_t>('V'), 0 };
+
+        auto parent = winrt::make_self<implementation::ActionMap>();
+        parent->LayerJson(parentJson);
+        auto child = winrt::make_self<implementation::ActionMap>();
+        child->LayerJson(childJson);
+        child->AddLeastImportantParent(parent);
+
+        const auto verifyLookup = [&]() {
+            VERIFY_IS_NULL(child->GetActionByKeyChord(ctrlC));
+            VERIFY_IS_TRUE(child->IsKeyChordExplicitlyUnbound(ctrlC));
+            VERIFY_ARE_EQUAL(ShortcutAction::PasteText, child->GetActionByKeyChord(ctrlV).ActionAndArgs().Action());
+            VERIFY_ARE_EQUAL(ShortcutAction::ClosePane, child->GetActionByKeyChord(ctrlW).ActionAndArgs().Action());
+            VERIFY_IS_NULL(child->GetActionByKeyChord(ctrlX));
+            VERIFY_IS_FALSE(child->IsKeyChordExplicitlyUnbound(ctrlX));
+            VERIFY_IS_NULL(child->GetActionByKeyChord(shiftV));
+            VERIFY_IS_FALSE(child->IsKeyChordExplicitlyUnbound(shiftV));
+        };
+
+        Log::Comment(L"Walking the layers");
+        verifyLookup();
+
+        Log::Comment(L"Using the flattened lookup");
+        child->_FinalizeInheritance();
+        VERIFY_IS_TRUE(child->_KeyChordLookup.has_value());
+        verifyLookup();
+
+        Log::Comment(L"Modifying the action map drops the flattened lookup");
+        child->RegisterKeyBinding(ctrlX, ActionAndArgs{ ShortcutAction::CopyText, nullptr });
+        VERIFY_IS_FALSE(child->_KeyChordLookup.has_value());
+        VERIFY_ARE_EQUAL(ShortcutAction::CopyText, child->GetActionByKeyChord(ctrlX).ActionAndArgs().Action());
+    }
+
     void KeyBindingsTests::TestArbitraryArgs()
     {
         const std::string bindings0String{ R"([
@@ -102,6 +102,10 @@ namespace SettingsModelLocalTests
                 "experimental.input.forceVT": false,
                 "experimental.rendering.forceFullRepaint": false,
                 "experimental.rendering.software": false,
+                "experimental.rendering.pacing": "lowLatency",
+                "experimental.rendering.smoothScrolling": false,
+                "experimental.rendering.pixelShaderFrameRate": 0,
+                "experimental.rendering.outputGovernorThreshold": 8388608,
 
                 "actions": []
             })" };
@@ -41,6 +41,7 @@ namespace SettingsModelLocalTests
         TEST_METHOD(NormalizeCommandLine);
         TEST_METHOD(GetProfileForArgsWithCommandline);
         TEST_METHOD(MakeSettingsForProfile);
+        TEST_METHOD(MakeSettingsForProfileIsCached);
         TEST_METHOD(MakeSettingsForDefaultProfileThatDoesntExist);
         TEST_METHOD(TestLayerProfileOnColorScheme);
         TEST_METHOD(TestCommandlineToTitlePromotion);
@@ -657,6 +658,47 @@ namespace SettingsModelLocalTests
         }
     }
 
+    void TerminalSettingsTests::MakeSettingsForProfileIsCached()
+    {
+        // Test that the settings of a profile are resolved once
+        // and that overriding them doesn't affect other terminals.
+        static constexpr std::string_view settingsString{ R"(
+        {
+            "defaultProfile": "{6239a42c-1111-49a3-80bd-e8fdd045185c}",
+            "profiles": [
+                {
+                    "name" : "profile0",
+                    "guid": "{6239a42c-1111-49a3-80bd-e8fdd045185c}",
+                    "historySize": 1,
+                    "commandline": "cmd.exe"
+                }
+            ]
+        })" };
+        const auto settings = winrt::make_self<implementation::CascadiaSettings>(settingsString);
+        const auto profile = settings->FindProfile(::Microsoft::Console::Utils::GuidFromString(L"{6239a42c-1111-49a3-80bd-e8fdd045185c}"));
+
+        const auto first{ TerminalSettings::CreateWithProfile(*settings, profile, nullptr) };
+        const auto second{ TerminalSettings::CreateWithProfile(*settings, profile, nullptr) };
+        const auto firstImpl = winrt::get_self<implementation::TerminalSettings>(first.DefaultSettings());
+        const auto secondImpl = winrt::get_self<implementation::TerminalSettings>(second.DefaultSettings());
+
+        VERIFY_ARE_NOT_EQUAL(firstImpl, secondImpl);
+        VERIFY_ARE_EQUAL(1u, firstImpl->_parents.size());
+        VERIFY_ARE_EQUAL(1u, secondImpl->_parents.size());
+        VERIFY_ARE_EQUAL(firstImpl->_parents[0], secondImpl->_parents[0]);
+
+        first.DefaultSettings().Commandline(L"pwsh.exe");
+        VERIFY_ARE_EQUAL(L"pwsh.exe", first.DefaultSettings().Commandline());
+        VERIFY_ARE_EQUAL(L"cmd.exe", second.DefaultSettings().Commandline());
+        VERIFY_ARE_EQUAL(1, second.DefaultSettings().HistorySize());
+
+        // A new settings load starts with an empty cache.
+        const auto copy = winrt::get_self<implementation::CascadiaSettings>(settings->Copy());
+        const auto third{ TerminalSettings::CreateWithProfile(*copy, copy->FindProfile(profile.Guid()), nullptr) };
+        const auto thirdImpl = winrt::get_self<implementation::TerminalSettings>(third.DefaultSettings());
+        VERIFY_ARE_NOT_EQUAL(firstImpl->_parents[0], thirdImpl->_parents[0]);
+    }
+
     void TerminalSettingsTests::MakeSettingsForDefaultProfileThatDoesntExist()
     {
         // Test that MakeSettings _doesnt_ throw when we load settings with a
@@ -104,6 +104,20 @@ namespace TerminalAppLocalTests
                 VERIFY_ARE_EQUAL(segments.GetAt(0).TextSegment(), L"AAAAAABBBBBBCCC");
                 VERIFY_IS_FALSE(segments.GetAt(0).IsHighlighted());
             }
+            {
+                Log::Comment(L"Testing command name segmentation with non-ASCII characters in the name");
+                const auto unicodePaletteItem{ winrt::make<winrt::TerminalApp::implementation::CommandLinePaletteItem>(L"\u00C4BC") };
+                const auto filteredCommand = winrt::make_self<winrt::TerminalApp::implementation::FilteredCommand>(unicodePaletteItem);
+                filteredCommand->_Filter = L"\u00E4c";
+                auto segments = filteredCommand->_computeHighlightedName().Segments();
+                VERIFY_ARE_EQUAL(segments.Size(), 3u);
+                VERIFY_ARE_EQUAL(segments.GetAt(0).TextSegment(), L"\u00C4");
+                VERIFY_IS_TRUE(segments.GetAt(0).IsHighlighted());
+                VERIFY_ARE_EQUAL(segments.GetAt(1).TextSegment(), L"B");
+                VERIFY_IS_FALSE(segments.GetAt(1).IsHighlighted());
+                VERIFY_ARE_EQUAL(segments.GetAt(2).TextSegment(), L"C");
+                VERIFY_IS_TRUE(segments.GetAt(2).IsHighlighted());
+            }
         });
 
         VERIFY_SUCCEEDED(result);
@@ -384,6 +384,24 @@ void HwndTerminal::SendOutput(std::wstring_view data)
     _terminal->Write(data);
 }
 
+void HwndTerminal::SendOutput(std::string_view data)
+{
+    if (!_terminal)
+    {
+        return;
+    }
+    _terminal->Write(data);
+}
+
+void HwndTerminal::SendOutput(std::span<const std::string_view> data)
+{
+    if (!_terminal)
+    {
+        return;
+    }
+    _terminal->Write(data);
+}
+
 HRESULT _stdcall CreateTerminal(HWND parentHwnd, _Out_ void** hwnd, _Out_ void** terminal)
 {
     auto _terminal = std::make_unique<HwndTerminal>(parentHwnd);
@@ -413,6 +431,46 @@ void _stdcall TerminalSendOutput(void* terminal, LPCWSTR data)
     publicTerminal->SendOutput(data);
 }
 
+/// <summary>
+/// Writes UTF-8 output to the terminal. Unlike TerminalSendOutput, the data doesn't need to be
+/// NUL-terminated, and incomplete UTF-8 sequences at its end are continued by the next call.
+/// </summary>
+/// <param name="terminal">Terminal pointer.</param>
+/// <param name="data">The UTF-8 output.</param>
+/// <param name="length">The length of data in bytes.</param>
+void _stdcall TerminalSendOutputUtf8(void* terminal, _In_reads_(length) const char* data, size_t length)
+try
+{
+    const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
+    publicTerminal->SendOutput(std::string_view{ data, length });
+}
+CATCH_LOG();
+
+/// <summary>
+/// Writes multiple chunks of UTF-8 output to the terminal, parsing all of them under a single lock.
+/// This is equivalent to calling TerminalSendOutputUtf8 for each chunk, but much cheaper for hosts that
+/// buffer many small chunks, because the render thread and the UI aren't interleaved with each of them.
+/// </summary>
+/// <param name="terminal">Terminal pointer.</param>
+/// <param name="data">The chunks of UTF-8 output.</param>
+/// <param name="lengths">The length of each chunk in bytes.</param>
+/// <param name="count">The number of chunks.</param>
+void _stdcall TerminalSendOutputUtf8Batch(void* terminal, _In_reads_(count) const char* const* data, _In_reads_(count) const size_t* lengths, size_t count)
+try
+{
+    const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
+
+    std::vector<std::string_view> chunks;
+    chunks.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        chunks.emplace_back(data[i], lengths[i]);
+    }
+
+    publicTerminal->SendOutput(chunks);
+}
+CATCH_LOG();
+
 /// <summary>
 /// Triggers a terminal resize using the new width and height in pixel.
 /// </summary>
@@ -633,7 +691,7 @@ const wchar_t* _stdcall TerminalGetSelection(void* terminal)
         return nullptr;
     }
 
-    const auto bufferData = publicTerminal->_terminal->RetrieveSelectedTextFromBuffer(false);
+    const auto bufferData = publicTerminal->_terminal->RetrieveSelectedTextFromBuffer(false, false);
     publicTerminal->_ClearSelection();
 
     // convert text: vector<string> --> string
@@ -1036,17 +1036,43 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         _forEachPeasant(func, onError);
     }
 
+    // Method Description:
+    // - Asks the given peasant for its window layout on a background thread.
+    // Arguments:
+    // - peasant: The peasant to ask.
+    // Return Value:
+    // - The window layout as json.
+    Windows::Foundation::IAsyncOperation<winrt::hstring> Monarch::_getWindowLayoutAsync(Remoting::IPeasant peasant)
+    {
+        co_await winrt::resume_background();
+        co_return peasant.GetWindowLayout();
+    }
+
     // Method Description:
     // - Ask all peasants to return their window layout as json
+    // - Each peasant has to hop onto its own UI thread to serialize its layout.
+    //   All of them are asked at once, so that we only wait for the slowest
+    //   one, instead of the sum of all of them.
     // Arguments:
     // - <none>
     // Return Value:
     // - The collection of window layouts from each peasant.
     Windows::Foundation::Collections::IVector<winrt::hstring> Monarch::GetAllWindowLayouts()
     {
+        std::unordered_map<uint64_t, Windows::Foundation::IAsyncOperation<winrt::hstring>> operations;
+        auto request = [&](const auto& id, const auto& p) {
+            operations.emplace(id, _getWindowLayoutAsync(p));
+        };
+        _forEachPeasant(request, [](auto&&) {});
+
+        // The results are collected in a second pass, so that any errors are
+        // attributed to the right peasant, just like with any other request.
         std::vector<winrt::hstring> vec;
-        auto callback = [&](const auto& /*id*/, const auto& p) {
-            vec.emplace_back(p.GetWindowLayout());
+        auto callback = [&](const auto& id, const auto& /*p*/) {
+            if (const auto it = operations.find(id); it != operations.end())
+            {
+                vec.emplace_back(it->second.get());
+            }
         };
         auto onError = [](auto&& id) {
             TraceLoggingWrite(g_hRemotingProvider,
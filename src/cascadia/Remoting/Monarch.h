@@ -124,6 +124,7 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         std::shared_mutex _mruPeasantsMutex{};
 
         winrt::Microsoft::Terminal::Remoting::IPeasant _getPeasant(uint64_t peasantID, bool clearMruPeasantOnFailure = true);
+        static Windows::Foundation::IAsyncOperation<winrt::hstring> _getWindowLayoutAsync(winrt::Microsoft::Terminal::Remoting::IPeasant peasant);
         uint64_t _getMostRecentPeasantID(bool limitToCurrentDesktop, const bool ignoreQuakeWindow);
         uint64_t _lookupPeasantIdForName(std::wstring_view name);
 
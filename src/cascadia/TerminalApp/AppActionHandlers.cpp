@@ -335,6 +335,15 @@ namespace winrt::TerminalApp::implementation
         args.Handled(true);
     }
 
+    void TerminalPage::_HandleJumpToOutputEnd(const IInspectable& /*sender*/,
+                                              const ActionEventArgs& args)
+    {
+        _ApplyToActiveControls([](auto& control) {
+            control.JumpToOutputEnd();
+        });
+        args.Handled(true);
+    }
+
     void TerminalPage::_HandleScrollToMark(const IInspectable& /*sender*/,
                                            const ActionEventArgs& args)
     {
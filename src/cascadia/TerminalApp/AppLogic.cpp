@@ -704,18 +704,44 @@ namespace winrt::TerminalApp::implementation
 
     void AppLogic::SaveWindowLayoutJsons(const Windows::Foundation::Collections::IVector<hstring>& layouts)
     {
-        std::vector<WindowLayout> converted;
-        converted.reserve(layouts.Size());
+        std::vector<hstring> jsons;
+        jsons.reserve(layouts.Size());
 
         for (const auto& json : layouts)
         {
             if (json != L"")
             {
-                converted.emplace_back(WindowLayout::FromJson(json));
+                jsons.emplace_back(json);
+            }
+        }
+
+        const auto state = ApplicationState::SharedInstance();
+
+        // The layouts are collected periodically, but most of the time nothing changed since the last time.
+        // Every write to the ApplicationState serializes and writes all of state.json again, so avoid that.
+        // The persisted layouts are compared by their json, because that's what the windows gave us anyway.
+        if (const auto persisted = state.PersistedWindowLayouts(); persisted && persisted.Size() == jsons.size())
+        {
+            auto unchanged = true;
+            for (uint32_t i = 0; unchanged && i < persisted.Size(); ++i)
+            {
+                unchanged = WindowLayout::ToJson(persisted.GetAt(i)) == jsons[i];
             }
+            if (unchanged)
+            {
+                return;
+            }
+        }
+
+        std::vector<WindowLayout> converted;
+        converted.reserve(jsons.size());
+
+        for (const auto& json : jsons)
+        {
+            converted.emplace_back(WindowLayout::FromJson(json));
         }
 
-        ApplicationState::SharedInstance().PersistedWindowLayouts(winrt::single_threaded_vector(std::move(converted)));
+        state.PersistedWindowLayouts(winrt::single_threaded_vector(std::move(converted)));
     }
 
     TerminalApp::ParseCommandlineResult AppLogic::GetParseCommandlineMessage(array_view<const winrt::hstring> args)
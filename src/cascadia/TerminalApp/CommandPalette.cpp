@@ -944,6 +944,7 @@ namespace winrt::TerminalApp::implementation
 
     void CommandPalette::SetCommands(const Collections::IVector<Command>& actions)
     {
+        _filterCache = {};
         _allCommands.Clear();
         for (const auto& action : actions)
         {
@@ -1083,7 +1084,33 @@ namespace winrt::TerminalApp::implementation
         {
             std::copy(begin(commandsToFilter), end(commandsToFilter), std::back_inserter(actions));
         }
-        else if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::ActionMode || _currentMode == CommandPaletteMode::CommandlineMode)
+        else if (_currentMode == CommandPaletteMode::ActionMode)
+        {
+            // Any command matching the new search text must have also matched
+            // the previous one, if the new text merely extends it. In that case
+            // we only need to look at the previous matches, instead of all the
+            // (possibly hundreds of) commands again.
+            const std::wstring_view needle{ searchText };
+            const auto narrowing = _filterCache.source == commandsToFilter &&
+                                   !_filterCache.needle.empty() &&
+                                   needle.starts_with(_filterCache.needle);
+            auto candidates = narrowing ? std::move(_filterCache.matches) : std::vector<winrt::TerminalApp::FilteredCommand>{ begin(commandsToFilter), end(commandsToFilter) };
+
+            for (const auto& action : candidates)
+            {
+                action.UpdateFilter(searchText);
+
+                if (searchText.empty() || action.Weight() > 0)
+                {
+                    actions.push_back(action);
+                }
+            }
+
+            _filterCache.source = commandsToFilter;
+            _filterCache.needle = needle;
+            _filterCache.matches = actions;
+        }
+        else if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::CommandlineMode)
         {
             for (const auto& action : commandsToFilter)
             {
@@ -1164,6 +1191,7 @@ namespace winrt::TerminalApp::implementation
     // - <none>
     void CommandPalette::_updateCurrentNestedCommands(const winrt::Microsoft::Terminal::Settings::Model::Command& parentCommand)
     {
+        _filterCache = {};
         _currentNestedCommands.Clear();
         for (const auto& nameAndCommand : parentCommand.NestedCommands())
         {
@@ -81,6 +81,15 @@ namespace winrt::TerminalApp::implementation
 
         bool _lastFilterTextWasEmpty{ true };
 
+        // The matches of the last search in ActionMode, which
+        // _collectFilteredActions() narrows down as the search text grows.
+        struct FilterCache
+        {
+            Windows::Foundation::Collections::IVector<winrt::TerminalApp::FilteredCommand> source{ nullptr };
+            std::wstring needle;
+            std::vector<winrt::TerminalApp::FilteredCommand> matches;
+        } _filterCache;
+
         void _filterTextChanged(const Windows::Foundation::IInspectable& sender,
                                 const Windows::UI::Xaml::RoutedEventArgs& args);
         void _previewKeyDownHandler(const Windows::Foundation::IInspectable& sender,
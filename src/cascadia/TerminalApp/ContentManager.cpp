@@ -25,7 +25,15 @@ namespace winrt::TerminalApp::implementation
                                                     const IControlAppearance& unfocusedAppearance,
                                                     const TerminalConnection::ITerminalConnection& connection)
     {
-        ControlInteractivity content{ settings, unfocusedAppearance, connection };
+        auto content{ _takePrewarmed() };
+        if (content)
+        {
+            content.Core().Recycle(settings, unfocusedAppearance, connection);
+        }
+        else
+        {
+            content = ControlInteractivity{ settings, unfocusedAppearance, connection };
+        }
         content.Closed({ get_weak(), &ContentManager::_closedHandler });
 
         _content.emplace(content.Id(), content);
@@ -48,6 +56,49 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Constructs contents ahead of time, until there are `count` of them for the
+    //   current thread, or releases the surplus ones if there are more than that.
+    //   Constructing a ControlCore sets up its renderer, which is a noticeable
+    //   part of opening a new tab or pane.
+    // - The contents are constructed without a connection, as it depends on the
+    //   profile. CreateCore() will recycle them with the actual settings and connection.
+    // Arguments:
+    // - settings, unfocusedAppearance: the settings to construct the contents with.
+    // - count: the number of contents to keep around for the current thread.
+    void ContentManager::Prewarm(const Microsoft::Terminal::Control::IControlSettings& settings,
+                                 const IControlAppearance& unfocusedAppearance,
+                                 uint32_t count)
+    {
+        const auto threadId = GetCurrentThreadId();
+        uint32_t available = 0;
+
+        std::erase_if(_prewarmed, [&](const auto& pair) {
+            return pair.first == threadId && available++ >= count;
+        });
+
+        for (; available < count; ++available)
+        {
+            _prewarmed.emplace_back(threadId, ControlInteractivity{ settings, unfocusedAppearance, nullptr });
+        }
+    }
+
+    ControlInteractivity ContentManager::_takePrewarmed()
+    {
+        const auto threadId = GetCurrentThreadId();
+        const auto it = std::find_if(_prewarmed.begin(), _prewarmed.end(), [&](const auto& pair) {
+            return pair.first == threadId;
+        });
+        if (it == _prewarmed.end())
+        {
+            return nullptr;
+        }
+
+        auto content{ std::move(it->second) };
+        _prewarmed.erase(it);
+        return content;
+    }
+
     void ContentManager::_closedHandler(const winrt::Windows::Foundation::IInspectable& sender,
                                         const winrt::Windows::Foundation::IInspectable&)
     {
@@ -21,6 +21,8 @@ Abstract:
 - Detach can be used to temporarily remove a content from its hosted
   TermControl. After detaching, you can still use LookupCore &
   TermControl::AttachContent to re-attach to the content.
+- Prewarm can be used to construct contents ahead of time, which CreateCore
+  will then hand out (on the same thread) instead of constructing a new one.
 --*/
 #pragma once
 
@@ -39,9 +41,18 @@ namespace winrt::TerminalApp::implementation
         Microsoft::Terminal::Control::ControlInteractivity TryLookupCore(uint64_t id);
 
         void Detach(const Microsoft::Terminal::Control::TermControl& control);
+        void Prewarm(const Microsoft::Terminal::Control::IControlSettings& settings,
+                     const Microsoft::Terminal::Control::IControlAppearance& unfocusedAppearance,
+                     uint32_t count);
 
     private:
         std::unordered_map<uint64_t, Microsoft::Terminal::Control::ControlInteractivity> _content;
+        // The contents constructed by Prewarm() and the ID of the thread they were constructed on.
+        // A ControlCore binds to the dispatcher and render thread of that thread, so they're
+        // only ever handed out to (and released on) the same one.
+        std::vector<std::pair<DWORD, Microsoft::Terminal::Control::ControlInteractivity>> _prewarmed;
+
+        Microsoft::Terminal::Control::ControlInteractivity _takePrewarmed();
 
         void _closedHandler(const winrt::Windows::Foundation::IInspectable& sender,
                             const winrt::Windows::Foundation::IInspectable& e);
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "DeferredTab.h"
+#include "DeferredTab.g.cpp"
+
+using namespace winrt;
+using namespace winrt::Windows::UI::Xaml;
+using namespace winrt::Microsoft::Terminal::Settings::Model;
+
+namespace winrt
+{
+    namespace MUX = Microsoft::UI::Xaml;
+    namespace WUX = Windows::UI::Xaml;
+}
+
+#define ASSERT_UI_THREAD() assert(TabViewItem().Dispatcher().HasThreadAccess())
+
+namespace winrt::TerminalApp::implementation
+{
+    DeferredTab::DeferredTab(std::vector<ActionAndArgs> actions,
+                             const winrt::hstring& title,
+                             const winrt::hstring& icon) :
+        _actions{ std::move(actions) }
+    {
+        // The content is shown for the brief moment between this tab getting
+        // selected and TerminalPage replacing it with the actual tab.
+        Content(WUX::Controls::Grid{});
+        Title(title);
+
+        _MakeTabViewItem();
+        _CreateContextMenu();
+
+        if (!icon.empty())
+        {
+            // The TabViewItem Icon needs MUX while the IconSourceElement in the CommandPalette needs WUX...
+            Icon(icon);
+            TabViewItem().IconSource(IconPathConverter::IconSourceMUX(icon));
+        }
+    }
+
+    // Method Description:
+    // - Returns the actions this tab was created with, as they're also what
+    //   recreates its state.
+    // Arguments:
+    // - asContent: unused. The tab doesn't have any content that could be moved.
+    //  Return Value:
+    // - The list of actions.
+    std::vector<ActionAndArgs> DeferredTab::BuildStartupActions(const bool /*asContent*/) const
+    {
+        ASSERT_UI_THREAD();
+
+        return _actions;
+    }
+
+    void DeferredTab::Focus(WUX::FocusState focusState)
+    {
+        ASSERT_UI_THREAD();
+
+        _focusState = focusState;
+    }
+
+    void DeferredTab::_MakeTabViewItem()
+    {
+        TabBase::_MakeTabViewItem();
+
+        TabViewItem().Header(winrt::box_value(Title()));
+    }
+
+    winrt::Windows::UI::Xaml::Media::Brush DeferredTab::_BackgroundBrush()
+    {
+        return nullptr;
+    }
+}
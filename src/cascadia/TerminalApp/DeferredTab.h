@@ -0,0 +1,40 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- DeferredTab.h
+
+Abstract:
+- The DeferredTab is a placeholder for a tab of a restored window layout that
+  hasn't been focused yet. It only has a header and the actions that will
+  create the actual TerminalTab (and with it the connection, control and
+  renderer) once TerminalPage materializes it.
+
+--*/
+
+#pragma once
+#include "TabBase.h"
+#include "DeferredTab.g.h"
+
+namespace winrt::TerminalApp::implementation
+{
+    struct DeferredTab : DeferredTabT<DeferredTab, TabBase>
+    {
+    public:
+        DeferredTab(std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs> actions,
+                    const winrt::hstring& title,
+                    const winrt::hstring& icon);
+
+        void Focus(winrt::Windows::UI::Xaml::FocusState focusState) override;
+
+        std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs> BuildStartupActions(const bool asContent = false) const override;
+
+    private:
+        std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs> _actions;
+
+        void _MakeTabViewItem() override;
+
+        virtual winrt::Windows::UI::Xaml::Media::Brush _BackgroundBrush() override;
+    };
+}
@@ -17,6 +17,19 @@ using namespace winrt::Windows::Foundation;
 using namespace winrt::Windows::Foundation::Collections;
 using namespace winrt::Microsoft::Terminal::Settings::Model;
 
+// Returns a bitmask with a bit set for each (case-folded) ASCII character in
+// `text`. Non-ASCII characters may compare equal to ASCII ones under
+// lstrcmpi(), which is why they contribute `nonAsciiMask` instead.
+static uint64_t characterMask(const std::wstring_view text, const uint64_t nonAsciiMask) noexcept
+{
+    uint64_t mask = 0;
+    for (const auto ch : text)
+    {
+        mask |= ch < 0x80 ? uint64_t{ 1 } << (til::tolower_ascii(ch) & 63) : nonAsciiMask;
+    }
+    return mask;
+}
+
 namespace winrt::TerminalApp::implementation
 {
     // This class is a wrapper of PaletteItem, that is used as an item of a filterable list in CommandPalette.
@@ -26,6 +39,7 @@ namespace winrt::TerminalApp::implementation
         _Filter(L""),
         _Weight(0)
     {
+        _nameMask = characterMask(_Item.Name(), UINT64_MAX);
         _HighlightedName = _computeHighlightedName();
 
         // Recompute the highlighted name if the item name changes
@@ -33,6 +47,7 @@ namespace winrt::TerminalApp::implementation
             auto filteredCommand{ weakThis.get() };
             if (filteredCommand && e.PropertyName() == L"Name")
             {
+                filteredCommand->_nameMask = characterMask(filteredCommand->_Item.Name(), UINT64_MAX);
                 filteredCommand->HighlightedName(filteredCommand->_computeHighlightedName());
                 filteredCommand->Weight(filteredCommand->_computeWeight());
             }
@@ -78,6 +93,14 @@ namespace winrt::TerminalApp::implementation
         uint32_t nextOffsetToReport = 0;
         uint32_t currentOffset = 0;
 
+        // The filter can't possibly match if it contains characters the name doesn't.
+        // This lets us skip the (comparatively slow) lstrcmpi() loop below for most items.
+        if ((characterMask(_Filter, 0) & ~_nameMask) != 0)
+        {
+            segments.Append(winrt::make<HighlightedTextSegment>(commandName, false));
+            return winrt::make<HighlightedText>(segments);
+        }
+
         for (const auto searchChar : _Filter)
         {
             const WCHAR searchCharAsString[] = { searchChar, L'\0' };
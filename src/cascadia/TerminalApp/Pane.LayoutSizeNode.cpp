@@ -34,13 +34,43 @@ Pane::LayoutSizeNode::LayoutSizeNode(const LayoutSizeNode& other) :
 // - itself
 Pane::LayoutSizeNode& Pane::LayoutSizeNode::operator=(const LayoutSizeNode& other)
 {
+    if (this == &other)
+    {
+        return *this;
+    }
+
     size = other.size;
     isMinimumSize = other.isMinimumSize;
 
-    firstChild = other.firstChild ? std::make_unique<LayoutSizeNode>(*other.firstChild) : nullptr;
-    secondChild = other.secondChild ? std::make_unique<LayoutSizeNode>(*other.secondChild) : nullptr;
-    nextFirstChild = other.nextFirstChild ? std::make_unique<LayoutSizeNode>(*other.nextFirstChild) : nullptr;
-    nextSecondChild = other.nextSecondChild ? std::make_unique<LayoutSizeNode>(*other.nextSecondChild) : nullptr;
+    _AssignNode(firstChild, other.firstChild);
+    _AssignNode(secondChild, other.secondChild);
+    _AssignNode(nextFirstChild, other.nextFirstChild);
+    _AssignNode(nextSecondChild, other.nextSecondChild);
 
     return *this;
 }
+
+// Method Description:
+// - Makes the given node equal the other one, reusing its allocation (and those
+//   of its descendants) if it has one. _AdvanceSnappedDimension() assigns nodes
+//   on every step, so this saves us from reallocating the whole subtree each time.
+// Arguments:
+// - node: The node to assign to.
+// - other: The node to take the values from. May be null.
+// Return Value:
+// - <none>
+void Pane::LayoutSizeNode::_AssignNode(std::unique_ptr<LayoutSizeNode>& node, const std::unique_ptr<LayoutSizeNode>& other)
+{
+    if (!other)
+    {
+        node.reset();
+    }
+    else if (node)
+    {
+        *node = *other;
+    }
+    else
+    {
+        node = std::make_unique<LayoutSizeNode>(*other);
+    }
+}
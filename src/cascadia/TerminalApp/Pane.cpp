@@ -176,6 +176,12 @@ NewTerminalArgs Pane::GetTerminalArgsForPane(const bool asContent) const
         args.ContentId(_control.ContentId());
     }
 
+    // The session ID is only assigned once the buffer got persisted. See TerminalPage::_PersistBuffers().
+    if (_sessionId != winrt::guid{})
+    {
+        args.SessionId(_sessionId);
+    }
+
     return args;
 }
 
@@ -1635,6 +1641,7 @@ void Pane::_CloseChild(const bool closeFirst, const bool isDetaching)
         _profile = remainingChild->_profile;
         _id = remainingChild->Id();
         _isDefTermSession = remainingChild->_isDefTermSession;
+        _sessionId = remainingChild->_sessionId;
 
         // Add our new event handler before revoking the old one.
         _setupControlEvents();
@@ -2528,6 +2535,7 @@ std::pair<std::shared_ptr<Pane>, std::shared_ptr<Pane>> Pane::_Split(SplitDirect
         _profile = nullptr;
         _control = { nullptr };
         _firstChild->_isDefTermSession = _isDefTermSession;
+        _firstChild->_sessionId = std::exchange(_sessionId, winrt::guid{});
     }
 
     _splitState = actualSplitType;
@@ -2798,11 +2806,13 @@ Pane::SnapChildrenSizeResult Pane::_CalcSnappedChildrenSizes(const bool widthOrH
     // size, but it doesn't seem to be beneficial.
 
     auto sizeTree = _CreateMinSizeTree(widthOrHeight);
-    auto lastSizeTree{ sizeTree };
+    // Only the sizes of our children are needed from the previous step, so
+    // there's no need to copy the entire tree on every iteration.
+    std::pair lastSizes{ sizeTree.firstChild->size, sizeTree.secondChild->size };
 
     while (sizeTree.size < fullSize)
     {
-        lastSizeTree = sizeTree;
+        lastSizes = { sizeTree.firstChild->size, sizeTree.secondChild->size };
         _AdvanceSnappedDimension(widthOrHeight, sizeTree);
 
         if (sizeTree.size == fullSize)
@@ -2814,10 +2824,10 @@ Pane::SnapChildrenSizeResult Pane::_CalcSnappedChildrenSizes(const bool widthOrH
         }
     }
 
-    // We exceeded the requested size in the loop above, so lastSizeTree will have
+    // We exceeded the requested size in the loop above, so lastSizes will have
     // the last good sizes (so that children fit in) and sizeTree has the next possible
     // snapped sizes. Return them as lower and higher snap possibilities.
-    return { { lastSizeTree.firstChild->size, lastSizeTree.secondChild->size },
+    return { lastSizes,
              { sizeTree.firstChild->size, sizeTree.secondChild->size } };
 }
 
@@ -3077,20 +3087,32 @@ Size Pane::_GetMinSize() const
 // Method Description:
 // - Builds a tree of LayoutSizeNode that matches the tree of panes. Each node
 //   has minimum size that the corresponding pane can have.
+// - The tree is built bottom-up, the same way _GetMinSize() combines the sizes
+//   of our children. This way we ask each control for its minimum size only once,
+//   instead of once per ancestor.
 // Arguments:
 // - widthOrHeight: if true operates on width, otherwise on height
 // Return Value:
 // - Root node of built tree that matches this pane.
 Pane::LayoutSizeNode Pane::_CreateMinSizeTree(const bool widthOrHeight) const
 {
-    const auto size = _GetMinSize();
-    LayoutSizeNode node(widthOrHeight ? size.Width : size.Height);
-    if (!_IsLeaf())
+    if (_IsLeaf())
     {
-        node.firstChild = std::make_unique<LayoutSizeNode>(_firstChild->_CreateMinSizeTree(widthOrHeight));
-        node.secondChild = std::make_unique<LayoutSizeNode>(_secondChild->_CreateMinSizeTree(widthOrHeight));
+        const auto size = _GetMinSize();
+        return LayoutSizeNode{ widthOrHeight ? size.Width : size.Height };
     }
 
+    auto firstChild = std::make_unique<LayoutSizeNode>(_firstChild->_CreateMinSizeTree(widthOrHeight));
+    auto secondChild = std::make_unique<LayoutSizeNode>(_secondChild->_CreateMinSizeTree(widthOrHeight));
+
+    // Mirrors _GetMinSize(): children are either side by side or on top of each other.
+    const auto minSize = _splitState == (widthOrHeight ? SplitState::Vertical : SplitState::Horizontal) ?
+                             firstChild->size + secondChild->size :
+                             std::max(firstChild->size, secondChild->size);
+
+    LayoutSizeNode node{ minSize };
+    node.firstChild = std::move(firstChild);
+    node.secondChild = std::move(secondChild);
     return node;
 }
 
@@ -3148,6 +3170,16 @@ void Pane::FinalizeConfigurationGivenDefault()
     _isDefTermSession = true;
 }
 
+winrt::guid Pane::SessionId() const noexcept
+{
+    return _sessionId;
+}
+
+void Pane::SessionId(const winrt::guid& sessionId) noexcept
+{
+    _sessionId = sessionId;
+}
+
 // Method Description:
 // - Returns true if the pane or one of its descendants is read-only
 bool Pane::ContainsReadOnly() const
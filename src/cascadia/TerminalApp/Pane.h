@@ -140,6 +140,9 @@ public:
 
     void FinalizeConfigurationGivenDefault();
 
+    winrt::guid SessionId() const noexcept;
+    void SessionId(const winrt::guid& sessionId) noexcept;
+
     bool ContainsReadOnly() const;
 
     void UpdateResources(const PaneResources& resources);
@@ -236,6 +239,8 @@ private:
     winrt::Microsoft::Terminal::TerminalConnection::ConnectionState _connectionState{ winrt::Microsoft::Terminal::TerminalConnection::ConnectionState::NotConnected };
     winrt::Microsoft::Terminal::Settings::Model::Profile _profile{ nullptr };
     bool _isDefTermSession{ false };
+    // Identifies the buffer snapshot of this pane when the session gets persisted. Empty until then.
+    winrt::guid _sessionId{};
 #pragma endregion
 
     std::optional<uint32_t> _id;
@@ -401,8 +406,13 @@ private:
 
         explicit LayoutSizeNode(const float minSize);
         LayoutSizeNode(const LayoutSizeNode& other);
+        LayoutSizeNode(LayoutSizeNode&& other) noexcept = default;
 
         LayoutSizeNode& operator=(const LayoutSizeNode& other);
+        LayoutSizeNode& operator=(LayoutSizeNode&& other) noexcept = default;
+
+    private:
+        static void _AssignNode(std::unique_ptr<LayoutSizeNode>& node, const std::unique_ptr<LayoutSizeNode>& other);
     };
 
     friend struct winrt::TerminalApp::implementation::TerminalTab;
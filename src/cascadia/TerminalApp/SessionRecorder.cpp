@@ -0,0 +1,270 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "SessionRecorder.h"
+
+#include <filesystem>
+
+using namespace winrt::Microsoft::Terminal::TerminalConnection;
+using namespace winrt::Microsoft::TerminalApp::implementation;
+
+// The capacity of the queue between the connection and the writer in chunks.
+static constexpr size_t queueCapacity = 4096;
+// Since chunks can be large, the queue is additionally limited to this many characters (16MiB).
+static constexpr uint64_t maxQueuedChars = 8 * 1024 * 1024;
+// The number of chunks the writer formats into one write.
+static constexpr size_t batchSize = 256;
+
+namespace
+{
+    void appendJsonString(std::string& out, const std::string_view str)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        out.push_back('"');
+
+        for (const auto ch : str)
+        {
+            const auto c = static_cast<uint8_t>(ch);
+            switch (c)
+            {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    out.append("\\u00");
+                    out.push_back(hex[c >> 4]);
+                    out.push_back(hex[c & 15]);
+                }
+                else
+                {
+                    out.push_back(ch);
+                }
+                break;
+            }
+        }
+
+        out.push_back('"');
+    }
+
+    void appendEvent(std::string& out, const double seconds, const char type, const std::string_view data)
+    {
+        fmt::format_to(std::back_inserter(out), "[{:.6f}, \"{}\", ", seconds, type);
+        appendJsonString(out, data);
+        out.append("]\n");
+    }
+
+    // Writes buffers to a file opened with FILE_FLAG_OVERLAPPED, with at most one write in flight.
+    struct OverlappedWriter
+    {
+        explicit OverlappedWriter(wil::unique_hfile file) :
+            _file{ std::move(file) }
+        {
+            _event.create(wil::EventOptions::ManualReset);
+            _overlapped.hEvent = _event.get();
+        }
+
+        OverlappedWriter(const OverlappedWriter&) = delete;
+        OverlappedWriter& operator=(const OverlappedWriter&) = delete;
+
+        ~OverlappedWriter()
+        {
+            LOG_IF_FAILED(wait());
+        }
+
+        // The buffer must stay alive and unmodified until the next call to write() or wait().
+        HRESULT write(const std::string_view buffer) noexcept
+        {
+            RETURN_IF_FAILED(wait());
+
+            _overlapped.Offset = static_cast<DWORD>(_offset);
+            _overlapped.OffsetHigh = static_cast<DWORD>(_offset >> 32);
+            _offset += buffer.size();
+
+            if (!WriteFile(_file.get(), buffer.data(), gsl::narrow_cast<DWORD>(buffer.size()), nullptr, &_overlapped))
+            {
+                const auto gle = GetLastError();
+                RETURN_HR_IF(HRESULT_FROM_WIN32(gle), gle != ERROR_IO_PENDING);
+            }
+
+            _pending = true;
+            return S_OK;
+        }
+
+        HRESULT wait() noexcept
+        {
+            if (!_pending)
+            {
+                return S_OK;
+            }
+
+            _pending = false;
+            DWORD written = 0;
+            RETURN_IF_WIN32_BOOL_FALSE(GetOverlappedResult(_file.get(), &_overlapped, &written, TRUE));
+            return S_OK;
+        }
+
+    private:
+        wil::unique_hfile _file;
+        wil::unique_event _event;
+        OVERLAPPED _overlapped{};
+        uint64_t _offset = 0;
+        bool _pending = false;
+    };
+
+    void writerThread(const til::mpsc::consumer<SessionRecorder::Chunk> rx, const std::shared_ptr<SessionRecorder::Stats> stats, wil::unique_hfile file, std::string header, const std::chrono::steady_clock::time_point start) noexcept
+    try
+    {
+        // Two buffers, so that the next batch can be formatted while the previous one is being written.
+        // They're declared before the writer, because they must outlive its last pending write.
+        std::array<std::string, 2> buffers;
+        OverlappedWriter writer{ std::move(file) };
+        size_t current = 0;
+        std::string utf8;
+        til::u16state state;
+        std::array<SessionRecorder::Chunk, batchSize> batch;
+
+        buffers[current] = std::move(header);
+        THROW_IF_FAILED(writer.write(buffers[current]));
+
+        for (;;)
+        {
+            const auto [count, ok] = rx.pop_n(batch.begin(), batch.size());
+            uint64_t chars = 0;
+
+            current ^= 1;
+            auto& buffer = buffers[current];
+            buffer.clear();
+
+            const auto droppedChunks = stats->droppedChunks.exchange(0, std::memory_order_relaxed);
+            const auto droppedChars = stats->droppedChars.exchange(0, std::memory_order_relaxed);
+            if (droppedChunks)
+            {
+                const auto time = count ? batch[0].time : std::chrono::steady_clock::now();
+                const auto seconds = std::chrono::duration<double>(time - start).count();
+                const auto label = fmt::format("dropped {} chunks ({} characters) of output", droppedChunks, droppedChars);
+                appendEvent(buffer, seconds, 'm', label);
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto& chunk = til::at(batch, i);
+                const auto seconds = std::chrono::duration<double>(chunk.time - start).count();
+                // A surrogate pair may be split across two chunks, which the u16state takes care of.
+                THROW_IF_FAILED(til::u16u8(chunk.text, utf8, state));
+                appendEvent(buffer, seconds, 'o', utf8);
+                chars += chunk.text.size();
+                // Release the string right away instead of holding onto it until the batch slot gets reused.
+                chunk.text = {};
+            }
+
+            stats->queuedChars.fetch_sub(chars, std::memory_order_relaxed);
+
+            if (!buffer.empty())
+            {
+                THROW_IF_FAILED(writer.write(buffer));
+            }
+
+            if (!ok)
+            {
+                break;
+            }
+        }
+    }
+    CATCH_LOG()
+
+    std::filesystem::path makeRecordingPath(const std::wstring_view directory)
+    {
+        static std::atomic<uint32_t> counter{ 0 };
+
+        std::filesystem::path path{ wil::ExpandEnvironmentStringsW<std::wstring>(std::wstring{ directory }.c_str()) };
+        std::filesystem::create_directories(path);
+
+        SYSTEMTIME time;
+        GetLocalTime(&time);
+        path /= fmt::format(L"{:04}-{:02}-{:02}_{:02}-{:02}-{:02}_{}_{}.cast", time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, GetCurrentProcessId(), counter.fetch_add(1, std::memory_order_relaxed));
+        return path;
+    }
+
+    // Recordings are highly compressible. NTFS compression keeps them small without turning
+    // them into a custom format, which every tool that reads asciicast files can still read.
+    void tryCompress(HANDLE file) noexcept
+    {
+        wil::unique_event event;
+        if (!event.try_create(wil::EventOptions::ManualReset, nullptr))
+        {
+            return;
+        }
+
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = event.get();
+        USHORT format = COMPRESSION_FORMAT_DEFAULT;
+        DWORD bytes = 0;
+
+        // This fails on file systems like FAT32 or ReFS, which is fine.
+        if (DeviceIoControl(file, FSCTL_SET_COMPRESSION, &format, sizeof(format), nullptr, 0, nullptr, &overlapped) || GetLastError() == ERROR_IO_PENDING)
+        {
+            GetOverlappedResult(file, &overlapped, &bytes, TRUE);
+        }
+    }
+}
+
+SessionRecorder::SessionRecorder(til::mpsc::producer<Chunk> tx, std::shared_ptr<Stats> stats) noexcept :
+    _tx{ std::move(tx) },
+    _stats{ std::move(stats) }
+{
+}
+
+void SessionRecorder::Attach(const ITerminalConnection& connection, const std::wstring_view directory, const std::wstring_view title, const int32_t columns, const int32_t rows) noexcept
+try
+{
+    const auto path = makeRecordingPath(directory);
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+    tryCompress(file.get());
+
+    std::string header;
+    fmt::format_to(std::back_inserter(header), R"({{"version": 2, "width": {}, "height": {}, "timestamp": {}, "title": )", columns, rows, std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    appendJsonString(header, til::u16u8(title));
+    header.append(R"(, "env": {"TERM": "xterm-256color"}})"
+                  "\n");
+
+    auto [tx, rx] = til::mpsc::channel<Chunk>(queueCapacity);
+    auto stats = std::make_shared<Stats>();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::thread{ writerThread, std::move(rx), stats, std::move(file), std::move(header), start }.detach();
+
+    connection.TerminalOutput([recorder = std::make_shared<SessionRecorder>(std::move(tx), std::move(stats))](const winrt::hstring& text) {
+        recorder->_record(text);
+    });
+}
+CATCH_LOG()
+
+// Called by the connection for every chunk of output. This must never block the connection.
+void SessionRecorder::_record(const winrt::hstring& text) noexcept
+{
+    const auto queued = _stats->queuedChars.fetch_add(text.size(), std::memory_order_relaxed);
+
+    if (queued > maxQueuedChars || !_tx.try_emplace(Chunk{ text, std::chrono::steady_clock::now() }))
+    {
+        _stats->queuedChars.fetch_sub(text.size(), std::memory_order_relaxed);
+        _stats->droppedChunks.fetch_add(1, std::memory_order_relaxed);
+        _stats->droppedChars.fetch_add(text.size(), std::memory_order_relaxed);
+    }
+}
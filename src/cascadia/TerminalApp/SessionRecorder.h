@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <winrt/Microsoft.Terminal.TerminalConnection.h>
+#include <til/mpsc.h>
+
+namespace winrt::Microsoft::TerminalApp::implementation
+{
+    // Records the output of a connection into an asciicast v2 file (https://docs.asciinema.org/manual/asciicast/v2/),
+    // so that sessions can be retained and replayed later, for instance with `asciinema play`.
+    //
+    // The TerminalOutput handler only timestamps each chunk and pushes it into a bounded til::mpsc queue.
+    // It never blocks: If the writer falls behind, chunks are dropped and counted instead, and the
+    // amount of lost output is recorded as a marker ("m") event as soon as the writer catches up.
+    // A background thread formats the chunks and writes them with overlapped I/O, so that
+    // formatting the next batch overlaps with writing the previous one.
+    //
+    // The recorder lives as long as the connection holds on to its TerminalOutput handler.
+    // Once the connection is destroyed, the background thread writes the remaining output and exits.
+    class SessionRecorder
+    {
+    public:
+        // Starts recording the connection into a new file inside the given directory.
+        // Failures are logged, but don't prevent the connection from being used.
+        static void Attach(const Microsoft::Terminal::TerminalConnection::ITerminalConnection& connection, std::wstring_view directory, std::wstring_view title, int32_t columns, int32_t rows) noexcept;
+
+        struct Chunk
+        {
+            winrt::hstring text;
+            std::chrono::steady_clock::time_point time;
+        };
+
+        // Shared between the recorder and its writer thread.
+        struct Stats
+        {
+            std::atomic<uint64_t> queuedChars{ 0 };
+            std::atomic<uint64_t> droppedChunks{ 0 };
+            std::atomic<uint64_t> droppedChars{ 0 };
+        };
+
+        SessionRecorder(til::mpsc::producer<Chunk> tx, std::shared_ptr<Stats> stats) noexcept;
+
+    private:
+        void _record(const winrt::hstring& text) noexcept;
+
+        til::mpsc::producer<Chunk> _tx;
+        std::shared_ptr<Stats> _stats;
+    };
+}
@@ -167,10 +167,22 @@ namespace winrt::TerminalApp::implementation
     {
         ASSERT_UI_THREAD();
 
+        // This gets called for every tab whenever any tab is added, removed
+        // or moved. With lots of tabs most of these calls are no-ops, and
+        // we avoid looking up the key chord (and rebuilding the tool tip) for them.
+        const auto indexChanged = idx != _TabViewIndex;
+        if (!indexChanged && numTabs == _TabViewNumTabs)
+        {
+            return;
+        }
+
         TabViewIndex(idx);
         TabViewNumTabs(numTabs);
         _EnableCloseMenuItems();
-        _UpdateSwitchToTabKeyChord();
+        if (indexChanged)
+        {
+            _UpdateSwitchToTabKeyChord();
+        }
     }
 
     void TabBase::SetDispatch(const winrt::TerminalApp::ShortcutActionDispatch& dispatch)
@@ -228,8 +240,17 @@ namespace winrt::TerminalApp::implementation
     // - <none>
     void TabBase::_UpdateToolTip()
     {
+        auto title = _CreateToolTipTitle();
+        if (_hasToolTip && title == _toolTipTitle && _keyChord == _toolTipKeyChord)
+        {
+            return;
+        }
+        _hasToolTip = true;
+        _toolTipTitle = title;
+        _toolTipKeyChord = _keyChord;
+
         auto titleRun = WUX::Documents::Run();
-        titleRun.Text(_CreateToolTipTitle());
+        titleRun.Text(title);
 
         auto textBlock = WUX::Controls::TextBlock{};
         textBlock.TextWrapping(WUX::TextWrapping::Wrap);
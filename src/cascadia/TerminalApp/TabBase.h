@@ -55,6 +55,11 @@ namespace winrt::TerminalApp::implementation
         winrt::TerminalApp::ShortcutActionDispatch _dispatch;
         Microsoft::Terminal::Settings::Model::IActionMapView _actionMap{ nullptr };
         winrt::hstring _keyChord{};
+        // The text of the current tool tip, so that _UpdateToolTip() can
+        // avoid rebuilding it, when nothing changed.
+        winrt::hstring _toolTipTitle{};
+        winrt::hstring _toolTipKeyChord{};
+        bool _hasToolTip{ false };
 
         winrt::Microsoft::Terminal::Settings::Model::ThemeColor _themeColor{ nullptr };
         winrt::Microsoft::Terminal::Settings::Model::ThemeColor _unfocusedThemeColor{ nullptr };
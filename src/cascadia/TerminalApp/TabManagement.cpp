@@ -20,6 +20,7 @@
 #include "ColorHelper.h"
 #include "DebugTapConnection.h"
 #include "SettingsTab.h"
+#include "DeferredTab.h"
 #include "..\TerminalSettingsModel\FileUtils.h"
 
 #include <shlobj.h>
@@ -284,6 +285,169 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Processes the actions of a restored window layout, but only creates the
+    //   tab that's going to be focused right away. Every other tab is created as
+    //   a DeferredTab, which only has a header. Its connection, control and
+    //   renderer are created once it's selected for the first time.
+    // - Falls back to running all the actions if the layout doesn't start with a new tab.
+    // Arguments:
+    // - actions: the actions of the window layout, as built by GetWindowLayout.
+    void TerminalPage::_ProcessDeferredStartupActions(const IVector<ActionAndArgs>& actions)
+    {
+        std::vector<std::vector<ActionAndArgs>> tabActions;
+        std::vector<ActionAndArgs> windowActions;
+        std::optional<uint32_t> focusedTabIndex;
+
+        for (const auto& action : actions)
+        {
+            const auto shortcutAction = action.Action();
+
+            if (shortcutAction == ShortcutAction::NewTab)
+            {
+                tabActions.emplace_back();
+            }
+            else if (shortcutAction == ShortcutAction::SwitchToTab || shortcutAction == ShortcutAction::RenameWindow)
+            {
+                // GetWindowLayout appends these after the actions of all the tabs.
+                if (const auto args{ action.Args().try_as<SwitchToTabArgs>() })
+                {
+                    focusedTabIndex = args.TabIndex();
+                }
+                windowActions.emplace_back(action);
+                continue;
+            }
+
+            if (tabActions.empty())
+            {
+                for (const auto& a : actions)
+                {
+                    _actionDispatch->DoAction(a);
+                }
+                return;
+            }
+
+            tabActions.back().emplace_back(action);
+        }
+
+        if (!tabActions.empty())
+        {
+            // Without a SwitchToTab the last tab is the focused one.
+            const auto focused = std::min<size_t>(focusedTabIndex.value_or(UINT32_MAX), tabActions.size() - 1);
+
+            for (size_t i = 0; i < tabActions.size(); ++i)
+            {
+                if (i == focused)
+                {
+                    for (const auto& action : tabActions[i])
+                    {
+                        _actionDispatch->DoAction(action);
+                    }
+                }
+                else
+                {
+                    _CreateDeferredTab(std::move(tabActions[i]));
+                }
+            }
+        }
+
+        for (const auto& action : windowActions)
+        {
+            _actionDispatch->DoAction(action);
+        }
+    }
+
+    // Method Description:
+    // - Appends a DeferredTab for the given actions to our list of tabs, without selecting it.
+    // Arguments:
+    // - actions: the actions that create the actual tab, starting with a NewTab action.
+    void TerminalPage::_CreateDeferredTab(std::vector<ActionAndArgs> actions)
+    {
+        NewTerminalArgs terminalArgs{ nullptr };
+        if (const auto args{ actions.front().Args().try_as<NewTabArgs>() })
+        {
+            terminalArgs = args.TerminalArgs();
+        }
+
+        const auto profile = _settings.GetProfileForArgs(terminalArgs);
+        const auto title = terminalArgs && !terminalArgs.TabTitle().empty() ? terminalArgs.TabTitle() : profile.Name();
+
+        auto newTabImpl = winrt::make_self<DeferredTab>(std::move(actions), title, profile.Icon());
+
+        _tabs.Append(*newTabImpl);
+        _mruTabs.Append(*newTabImpl);
+
+        newTabImpl->SetDispatch(*_actionDispatch);
+        newTabImpl->SetActionMap(_settings.ActionMap());
+
+        // Give the tab its index in the _tabs vector so it can manage its own SwitchToTab command.
+        _UpdateTabIndices();
+
+        // Don't capture a strong ref to the tab. If the tab is removed as this
+        // is called, we don't really care anymore about handling the event.
+        auto weakTab = make_weak(newTabImpl);
+
+        auto tabViewItem = newTabImpl->TabViewItem();
+        _tabView.TabItems().Append(tabViewItem);
+
+        tabViewItem.PointerReleased({ this, &TerminalPage::_OnTabClick });
+
+        // When the tab requests close, try to close it (prompt for approval, if required)
+        newTabImpl->CloseRequested([weakTab, weakThis{ get_weak() }](auto&& /*s*/, auto&& /*e*/) {
+            auto page{ weakThis.get() };
+            auto tab{ weakTab.get() };
+
+            if (page && tab)
+            {
+                page->_HandleCloseTabRequested(*tab);
+            }
+        });
+
+        // When the tab is closed, remove it from our list of tabs.
+        newTabImpl->Closed([tabViewItem, weakThis{ get_weak() }](auto&& /*s*/, auto&& /*e*/) {
+            if (auto page{ weakThis.get() })
+            {
+                page->_RemoveOnCloseRoutine(tabViewItem, page);
+            }
+        });
+    }
+
+    // Method Description:
+    // - Replaces the given DeferredTab with the tab that its actions create.
+    //   This happens on a subsequent pass of the UI thread, because we get here
+    //   while the TabView is still processing the selection change.
+    // Arguments:
+    // - tab: the DeferredTab that got selected.
+    winrt::fire_and_forget TerminalPage::_MaterializeDeferredTab(winrt::TerminalApp::TabBase tab)
+    {
+        auto weakThis{ get_weak() };
+
+        co_await wil::resume_foreground(Dispatcher(), CoreDispatcherPriority::Normal);
+
+        const auto page{ weakThis.get() };
+        uint32_t tabIndex{};
+        // Don't bother if the user already went on to another tab.
+        if (!page || !_tabs.IndexOf(tab, tabIndex) || _GetFocusedTabIndex() != tabIndex)
+        {
+            co_return;
+        }
+
+        const auto tabCount = _tabs.Size();
+        for (const auto& action : winrt::get_self<DeferredTab>(tab)->BuildStartupActions())
+        {
+            _actionDispatch->DoAction(action);
+        }
+
+        // The NewTab action appended the actual tab and selected it, unless it
+        // couldn't be created here (for instance because the profile is elevated).
+        // Either way, the DeferredTab has done its job.
+        if (_tabs.Size() > tabCount)
+        {
+            _TryMoveTab(tabCount, tabIndex);
+        }
+        _RemoveTab(tab);
+    }
+
     // Method Description:
     // - Get the icon of the currently focused terminal control, and set its
     //   tab's icon to that icon.
@@ -439,8 +603,10 @@ namespace winrt::TerminalApp::implementation
 
                 if (!path.empty())
                 {
-                    const auto buffer = control.ReadEntireBuffer();
-                    CascadiaSettings::ExportFile(path, buffer);
+                    // Exporting a large buffer takes a while. ExportToPath() streams it
+                    // to the file in chunks, which doesn't need to block the UI thread.
+                    co_await winrt::resume_background();
+                    control.ExportToPath(path);
                 }
             }
         }
@@ -537,6 +703,7 @@ namespace winrt::TerminalApp::implementation
             // if the user manually closed all tabs.
             // Do this only if we are the last window; the monarch will notice
             // we are missing and remove us that way otherwise.
+            _manager.Prewarm(nullptr, nullptr, 0);
             _LastTabClosedHandlers(*this, winrt::make<LastTabClosedEventArgs>(!_maintainStateOnTabClose));
         }
         else if (focusedTabIndex.has_value() && focusedTabIndex.value() == gsl::narrow_cast<uint32_t>(tabIndex))
@@ -959,6 +1126,21 @@ namespace winrt::TerminalApp::implementation
             tab.Focus(FocusState::Unfocused);
         }
 
+        // Let the controls of all the other tabs suspend their rendering.
+        for (const auto& t : _tabs)
+        {
+            if (const auto terminalTab{ _GetTerminalTabImpl(t) })
+            {
+                const auto inBackground = t != tab;
+                terminalTab->GetRootPane()->WalkTree([&](auto&& pane) {
+                    if (const auto control{ pane->GetTerminalControl() })
+                    {
+                        control.SetInBackground(inBackground);
+                    }
+                });
+            }
+        }
+
         try
         {
             _tabContent.Children().Clear();
@@ -998,6 +1180,10 @@ namespace winrt::TerminalApp::implementation
                 auto profile = tab_impl->GetFocusedProfile();
                 _UpdateBackground(profile);
             }
+            else if (tab.try_as<TerminalApp::DeferredTab>())
+            {
+                _MaterializeDeferredTab(tab);
+            }
         }
         CATCH_LOG();
     }
@@ -1055,6 +1241,13 @@ namespace winrt::TerminalApp::implementation
     // - <none>
     void TerminalPage::_UpdateMRUTab(const winrt::TerminalApp::TabBase& tab)
     {
+        // The tab is usually already at the front (e.g. when focus moves
+        // between its panes), so check for that before searching the list.
+        if (_mruTabs.Size() > 0 && _mruTabs.GetAt(0) == tab)
+        {
+            return;
+        }
+
         uint32_t mruIndex;
         if (_mruTabs.IndexOf(tab, mruIndex))
         {
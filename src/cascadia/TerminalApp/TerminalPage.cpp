@@ -20,6 +20,7 @@
 #include "../../types/inc/utils.hpp"
 #include "ColorHelper.h"
 #include "DebugTapConnection.h"
+#include "SessionRecorder.h"
 #include "SettingsTab.h"
 #include "TabRowControl.h"
 #include "Utils.h"
@@ -283,6 +284,8 @@ namespace winrt::TerminalApp::implementation
         }
         CATCH_LOG();
 
+        _StartLowMemoryMonitor();
+
         ShowSetAsDefaultInfoBar();
     }
 
@@ -583,15 +586,22 @@ namespace winrt::TerminalApp::implementation
 
         if (auto page{ weakThis.get() })
         {
-            for (const auto& action : actions)
+            if (initial && _deferStartupTabs)
             {
-                if (auto page{ weakThis.get() })
-                {
-                    _actionDispatch->DoAction(action);
-                }
-                else
+                _ProcessDeferredStartupActions(actions);
+            }
+            else
+            {
+                for (const auto& action : actions)
                 {
-                    co_return;
+                    if (auto page{ weakThis.get() })
+                    {
+                        _actionDispatch->DoAction(action);
+                    }
+                    else
+                    {
+                        co_return;
+                    }
                 }
             }
 
@@ -1221,6 +1231,20 @@ namespace winrt::TerminalApp::implementation
             connection.Initialize(valueSet);
         }
 
+        else if (connectionType == TerminalConnection::PlaybackConnection::ConnectionType())
+        {
+            // Playback profiles use their commandline as the path to the recording.
+            std::wstring_view path{ settings.Commandline() };
+            if (path.size() >= 2 && path.front() == L'"' && path.back() == L'"')
+            {
+                path = path.substr(1, path.size() - 2);
+            }
+
+            const auto expandedPath = wil::ExpandEnvironmentStringsW<std::wstring>(std::wstring{ path }.c_str());
+            connection = TerminalConnection::PlaybackConnection{};
+            connection.Initialize(TerminalConnection::PlaybackConnection::CreateSettings(expandedPath, 1.0));
+        }
+
         else
         {
             const auto environment = settings.EnvironmentVariables() != nullptr ?
@@ -1268,6 +1292,12 @@ namespace winrt::TerminalApp::implementation
             connection = conhostConn;
         }
 
+        // The recorder needs to be attached before the connection is started, so that it doesn't miss any output.
+        if (const auto recordingPath = profile.SessionRecordingPath(); !recordingPath.empty())
+        {
+            SessionRecorder::Attach(connection, recordingPath, profile.Name(), settings.InitialCols(), settings.InitialRows());
+        }
+
         TraceLoggingWrite(
             g_hTerminalAppProvider,
             "ConnectionCreated",
@@ -1835,6 +1865,50 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Writes a snapshot of the buffer of every pane next to the settings, so that
+    //   they can be restored along with the layout. Panes that don't have a session
+    //   ID yet get one here, which GetTerminalArgsForPane() then persists.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TerminalPage::_PersistBuffers()
+    {
+        if (!_settings.GlobalSettings().ShouldUsePersistedLayout())
+        {
+            return;
+        }
+
+        for (const auto& tab : _tabs)
+        {
+            if (const auto terminalTab{ _GetTerminalTabImpl(tab) })
+            {
+                terminalTab->GetRootPane()->WalkTree([](const auto& pane) {
+                    if (const auto control = pane->GetTerminalControl())
+                    {
+                        if (pane->SessionId() == winrt::guid{})
+                        {
+                            pane->SessionId(::Microsoft::Console::Utils::CreateGuid());
+                        }
+
+                        try
+                        {
+                            control.PersistToPath(_GetBufferSnapshotPath(pane->SessionId()));
+                        }
+                        CATCH_LOG();
+                    }
+                });
+            }
+        }
+    }
+
+    std::wstring TerminalPage::_GetBufferSnapshotPath(const winrt::guid& sessionId)
+    {
+        const std::filesystem::path settingsPath{ std::wstring_view{ CascadiaSettings::SettingsPath() } };
+        return (settingsPath.parent_path() / fmt::format(L"buffer_{}.bin", ::Microsoft::Console::Utils::GuidToString(sessionId))).wstring();
+    }
+
     // Method Description:
     // - Saves the window position and tab layout to the application state
     // - This does not create the InitialPosition field, that needs to be
@@ -1850,6 +1924,9 @@ namespace winrt::TerminalApp::implementation
             return nullptr;
         }
 
+        // This assigns the session IDs that BuildStartupActions() then refers to.
+        _PersistBuffers();
+
         std::vector<ActionAndArgs> actions;
 
         for (auto tab : _tabs)
@@ -2857,9 +2934,35 @@ namespace winrt::TerminalApp::implementation
         // TermControl will copy the settings out of the settings passed to it.
 
         const auto content = _manager.CreateCore(settings.DefaultSettings(), settings.UnfocusedSettings(), connection);
+        _PrewarmContent(settings);
         return _SetupControl(TermControl{ content });
     }
 
+    // Method Description:
+    // - Replenishes the contents that the ContentManager constructs ahead of time,
+    //   once the UI thread is done with everything else, so that the next new tab
+    //   or pane can be created faster. See "experimental.prewarmedControls".
+    // Arguments:
+    // - settings: the settings to construct the contents with. They'll be replaced
+    //   with the actual ones once a content is used.
+    void TerminalPage::_PrewarmContent(const TerminalSettingsCreateResult& settings)
+    {
+        const auto count = gsl::narrow_cast<uint32_t>(std::max(0, _settings.GlobalSettings().PrewarmedControlCount()));
+        if (count == 0)
+        {
+            // Release any contents we may have constructed before the setting changed.
+            _manager.Prewarm(nullptr, nullptr, 0);
+            return;
+        }
+
+        Dispatcher().RunAsync(CoreDispatcherPriority::Low, [weak = get_weak(), settings, count]() {
+            if (auto self{ weak.get() })
+            {
+                self->_manager.Prewarm(settings.DefaultSettings(), settings.UnfocusedSettings(), count);
+            }
+        });
+    }
+
     TermControl TerminalPage::_AttachControlToContent(const uint64_t& contentId)
     {
         if (const auto& content{ _manager.TryLookupCore(contentId) })
@@ -2981,6 +3084,16 @@ namespace winrt::TerminalApp::implementation
 
         auto resultPane = std::make_shared<Pane>(profile, control);
 
+        // Panes of a persisted session bring their buffer contents back with them.
+        if (newTerminalArgs)
+        {
+            if (const auto sessionId = newTerminalArgs.SessionId(); sessionId != winrt::guid{})
+            {
+                control.RestoreFromPath(_GetBufferSnapshotPath(sessionId));
+                resultPane->SessionId(sessionId);
+            }
+        }
+
         if (debugConnection) // this will only be set if global debugging is on and tap is active
         {
             auto newControl = _CreateNewControlAndContent(controlSettings, debugConnection);
@@ -3245,10 +3358,14 @@ namespace winrt::TerminalApp::implementation
     // - This function will have no effective result after Create() is called.
     // Arguments:
     // - actions: a list of Actions to process on startup.
+    // - deferBackgroundTabs: if true, only the tab that ends up focused is created
+    //   right away. See _ProcessDeferredStartupActions.
     // Return Value:
     // - <none>
-    void TerminalPage::SetStartupActions(std::vector<ActionAndArgs>& actions)
+    void TerminalPage::SetStartupActions(std::vector<ActionAndArgs>& actions, const bool deferBackgroundTabs)
     {
+        _deferStartupTabs = deferBackgroundTabs;
+
         // The fastest way to copy all the actions out of the std::vector and
         // put them into a winrt::IVector is by making a copy, then moving the
         // copy into the winrt vector ctor.
@@ -3346,6 +3463,7 @@ namespace winrt::TerminalApp::implementation
     void TerminalPage::WindowVisibilityChanged(const bool showOrHide)
     {
         _visible = showOrHide;
+        _updateAnimationsPaused();
         for (const auto& tab : _tabs)
         {
             if (auto terminalTab{ _GetTerminalTabImpl(tab) })
@@ -3362,6 +3480,105 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Starts waiting for the system to signal that it's low on physical memory,
+    //   at which point _OnLowMemory() trims the memory of our background panes.
+    void TerminalPage::_StartLowMemoryMonitor()
+    try
+    {
+        _lowMemoryNotification.reset(CreateMemoryResourceNotification(LowMemoryResourceNotification));
+        THROW_LAST_ERROR_IF(!_lowMemoryNotification);
+
+        // The callback can't outlive the page: Destroying _lowMemoryWait waits for pending callbacks.
+        _lowMemoryWait.reset(CreateThreadpoolWait(
+            [](PTP_CALLBACK_INSTANCE, PVOID context, PTP_WAIT, TP_WAIT_RESULT) noexcept {
+                static_cast<TerminalPage*>(context)->_OnLowMemory();
+            },
+            this,
+            nullptr));
+        THROW_LAST_ERROR_IF(!_lowMemoryWait);
+
+        SetThreadpoolWait(_lowMemoryWait.get(), _lowMemoryNotification.get(), nullptr);
+    }
+    CATCH_LOG()
+
+    // Method Description:
+    // - Called on a background thread when the system is low on physical memory. The
+    //   notification stays signaled for as long as that's the case, which is why we only
+    //   rearm the wait after a cooldown, instead of trimming over and over again.
+    winrt::fire_and_forget TerminalPage::_OnLowMemory()
+    {
+        static constexpr auto cooldown = std::chrono::seconds{ 30 };
+
+        auto weakThis{ get_weak() };
+        co_await wil::resume_foreground(Dispatcher(), CoreDispatcherPriority::Low);
+
+        if (const auto page{ weakThis.get() })
+        {
+            page->_TrimBackgroundPanes();
+        }
+
+        co_await winrt::resume_after(cooldown);
+
+        if (const auto page{ weakThis.get() })
+        {
+            SetThreadpoolWait(page->_lowMemoryWait.get(), page->_lowMemoryNotification.get(), nullptr);
+        }
+    }
+
+    // Method Description:
+    // - Trims the memory of the panes in our background tabs, in least recently used order, as
+    //   those are the least likely to be looked at again soon. See ControlCore::TrimMemory().
+    //   This stops as soon as the system isn't low on memory anymore. The selected tab is
+    //   only trimmed if the window is hidden, because its panes would otherwise redraw right away.
+    void TerminalPage::_TrimBackgroundPanes()
+    {
+        const auto sum = [](const Control::MemoryUsage& usage) {
+            return usage.Buffer + usage.Renderer + usage.Connection;
+        };
+
+        uint64_t bytesBefore = 0;
+        uint64_t bytesAfter = 0;
+        uint32_t tabsTrimmed = 0;
+
+        for (auto i = _mruTabs.Size(); i-- > 0;)
+        {
+            if (i == 0 && _visible)
+            {
+                break;
+            }
+
+            if (const auto terminalTab{ _GetTerminalTabImpl(_mruTabs.GetAt(i)) })
+            {
+                terminalTab->GetRootPane()->WalkTree([&](auto&& pane) {
+                    if (const auto control{ pane->GetTerminalControl() })
+                    {
+                        bytesBefore += sum(control.GetMemoryUsage());
+                        control.TrimMemory();
+                        bytesAfter += sum(control.GetMemoryUsage());
+                    }
+                });
+                ++tabsTrimmed;
+            }
+
+            auto low = FALSE;
+            if (!QueryMemoryResourceNotification(_lowMemoryNotification.get(), &low) || !low)
+            {
+                break;
+            }
+        }
+
+        TraceLoggingWrite(
+            g_hTerminalAppProvider,
+            "LowMemoryTrim",
+            TraceLoggingDescription("Event emitted when the memory of background panes got trimmed, because the system is low on memory"),
+            TraceLoggingUInt32(tabsTrimmed, "TabsTrimmed", "The number of tabs whose panes were trimmed"),
+            TraceLoggingUInt64(bytesBefore, "BytesBefore", "The approximate memory usage of the trimmed panes before trimming"),
+            TraceLoggingUInt64(bytesAfter, "BytesAfter", "The approximate memory usage of the trimmed panes after trimming"),
+            TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
+            TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
+    }
+
     // Method Description:
     // - Called when the user tries to do a search using keybindings.
     //   This will tell the active terminal control of the passed tab
@@ -4567,6 +4784,39 @@ namespace winrt::TerminalApp::implementation
         // the settings, change active panes, etc.
         _activated = activated;
         _updateThemeColors();
+        _updateAnimationsPaused();
+    }
+
+    // Method Description:
+    // - Stops the blinking cursors and text of all of our controls while the
+    //   window is inactive or hidden. They share a single clock per window.
+    void TerminalPage::_updateAnimationsPaused()
+    {
+        TermControl::PauseAnimations(!_activated || !_visible || _sessionLocked);
+    }
+
+    // Method Description:
+    // - Notifies all of our controls that the session got locked or unlocked,
+    //   so that they stop painting while nobody can see them.
+    // Arguments:
+    // - locked: true if the session got locked, false once it's unlocked.
+    void TerminalPage::SessionLockChanged(const bool locked)
+    {
+        _sessionLocked = locked;
+        _updateAnimationsPaused();
+
+        for (const auto& tab : _tabs)
+        {
+            if (auto terminalTab{ _GetTerminalTabImpl(tab) })
+            {
+                terminalTab->GetRootPane()->WalkTree([&](auto&& pane) {
+                    if (auto control = pane->GetTerminalControl())
+                    {
+                        control.SessionLockChanged(locked);
+                    }
+                });
+            }
+        }
     }
 
     void TerminalPage::_ContextMenuOpened(const IInspectable& sender,
@@ -110,6 +110,7 @@ namespace winrt::TerminalApp::implementation
 
         void TitlebarClicked();
         void WindowVisibilityChanged(const bool showOrHide);
+        void SessionLockChanged(const bool locked);
 
         float CalcSnappedDimension(const bool widthOrHeight, const float dimension) const;
 
@@ -131,7 +132,7 @@ namespace winrt::TerminalApp::implementation
         void Maximized(bool newMaximized);
         void RequestSetMaximized(bool newMaximized);
 
-        void SetStartupActions(std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs>& actions);
+        void SetStartupActions(std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs>& actions, const bool deferBackgroundTabs = false);
 
         void SetInboundListener(bool isEmbedding);
         static std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs> ConvertExecuteCommandlineToActions(const Microsoft::Terminal::Settings::Model::ExecuteCommandlineArgs& args);
@@ -217,6 +218,9 @@ namespace winrt::TerminalApp::implementation
         Windows::Foundation::Collections::IObservableVector<TerminalApp::TabBase> _mruTabs;
         static winrt::com_ptr<TerminalTab> _GetTerminalTabImpl(const TerminalApp::TabBase& tab);
 
+        void _PersistBuffers();
+        static std::wstring _GetBufferSnapshotPath(const winrt::guid& sessionId);
+
         void _UpdateTabIndices();
 
         TerminalApp::SettingsTab _settingsTab{ nullptr };
@@ -236,6 +240,11 @@ namespace winrt::TerminalApp::implementation
 
         bool _activated{ false };
         bool _visible{ true };
+        bool _sessionLocked{ false };
+
+        // Signaled by the system while it's low on physical memory. See _StartLowMemoryMonitor().
+        wil::unique_handle _lowMemoryNotification;
+        wil::unique_threadpool_wait _lowMemoryWait;
 
         std::vector<std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs>> _previouslyClosedPanesAndTabs{};
 
@@ -251,6 +260,7 @@ namespace winrt::TerminalApp::implementation
         StartupState _startupState{ StartupState::NotInitialized };
 
         Windows::Foundation::Collections::IVector<Microsoft::Terminal::Settings::Model::ActionAndArgs> _startupActions;
+        bool _deferStartupTabs{ false };
         bool _shouldStartInboundListener{ false };
         bool _isEmbeddingInboundListener{ false };
 
@@ -296,6 +306,9 @@ namespace winrt::TerminalApp::implementation
         void _OpenNewTabDropdown();
         HRESULT _OpenNewTab(const Microsoft::Terminal::Settings::Model::NewTerminalArgs& newTerminalArgs, winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection existingConnection = nullptr);
         void _CreateNewTabFromPane(std::shared_ptr<Pane> pane, uint32_t insertPosition = -1);
+        void _ProcessDeferredStartupActions(const Windows::Foundation::Collections::IVector<Microsoft::Terminal::Settings::Model::ActionAndArgs>& actions);
+        void _CreateDeferredTab(std::vector<Microsoft::Terminal::Settings::Model::ActionAndArgs> actions);
+        winrt::fire_and_forget _MaterializeDeferredTab(winrt::TerminalApp::TabBase tab);
 
         std::wstring _evaluatePathForCwd(std::wstring_view path);
 
@@ -440,6 +453,7 @@ namespace winrt::TerminalApp::implementation
 
         winrt::Microsoft::Terminal::Control::TermControl _CreateNewControlAndContent(const winrt::Microsoft::Terminal::Settings::Model::TerminalSettingsCreateResult& settings,
                                                                                      const winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection& connection);
+        void _PrewarmContent(const winrt::Microsoft::Terminal::Settings::Model::TerminalSettingsCreateResult& settings);
         winrt::Microsoft::Terminal::Control::TermControl _SetupControl(const winrt::Microsoft::Terminal::Control::TermControl& term);
         winrt::Microsoft::Terminal::Control::TermControl _AttachControlToContent(const uint64_t& contentGuid);
 
@@ -454,6 +468,10 @@ namespace winrt::TerminalApp::implementation
 
         void _StartInboundListener();
 
+        void _StartLowMemoryMonitor();
+        winrt::fire_and_forget _OnLowMemory();
+        void _TrimBackgroundPanes();
+
         winrt::fire_and_forget _CompleteInitialization();
 
         void _FocusActiveControl(IInspectable sender, IInspectable eventArgs);
@@ -508,6 +526,7 @@ namespace winrt::TerminalApp::implementation
         static void _DismissMessage(const winrt::Microsoft::Terminal::Settings::Model::InfoBarMessage& message);
 
         void _updateThemeColors();
+        void _updateAnimationsPaused();
         void _updateAllTabCloseButtons(const winrt::TerminalApp::TabBase& focusedTab);
         void _updatePaneResources(const winrt::Windows::UI::Xaml::ElementTheme& requestedTheme);
 
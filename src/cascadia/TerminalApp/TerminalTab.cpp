@@ -388,12 +388,19 @@ namespace winrt::TerminalApp::implementation
         ASSERT_UI_THREAD();
 
         const auto activeTitle = _GetActiveTitle();
-        // Bubble our current tab text to anyone who's listening for changes.
-        Title(activeTitle);
+        // Shells tend to set the same title over and over again (e.g. on every
+        // prompt). There's no need to update the header for that.
+        if (activeTitle != _Title || activeTitle.empty())
+        {
+            // Bubble our current tab text to anyone who's listening for changes.
+            Title(activeTitle);
 
-        // Update the control to reflect the changed title
-        _headerControl.Title(activeTitle);
-        Automation::AutomationProperties::SetName(TabViewItem(), activeTitle);
+            // Update the control to reflect the changed title
+            _headerControl.Title(activeTitle);
+            Automation::AutomationProperties::SetName(TabViewItem(), activeTitle);
+        }
+        // The tool tip also depends on the active pane's profile, but
+        // _UpdateToolTip() won't rebuild it if its text didn't change.
         _UpdateToolTip();
     }
 
@@ -166,7 +166,7 @@ namespace winrt::TerminalApp::implementation
                 {
                     actions.emplace_back(a);
                 }
-                _root->SetStartupActions(actions);
+                _root->SetStartupActions(actions, true);
             }
             else
             {
@@ -837,6 +837,20 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Called when the session of this window got locked or unlocked.
+    // Arguments:
+    // - locked: true if the session got locked, false once it's unlocked.
+    // Return Value:
+    // - <none>
+    void TerminalWindow::SessionLockChanged(const bool locked)
+    {
+        if (_root)
+        {
+            _root->SessionLockChanged(locked);
+        }
+    }
+
     // Method Description:
     // - Implements the F7 handler (per GH#638)
     // - Implements the Alt handler (per GH#6421)
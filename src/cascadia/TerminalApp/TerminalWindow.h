@@ -125,6 +125,7 @@ namespace winrt::TerminalApp::implementation
 
         void CloseWindow(Microsoft::Terminal::Settings::Model::LaunchPosition position, const bool isLastWindow);
         void WindowVisibilityChanged(const bool showOrHide);
+        void SessionLockChanged(const bool locked);
 
         winrt::TerminalApp::TaskbarState TaskbarState();
         winrt::Windows::UI::Xaml::Media::Brush TitlebarBrush();
@@ -35,6 +35,11 @@ namespace WWH = ::winrt::Windows::Web::Http;
 
 static constexpr winrt::guid AzureConnectionType = { 0xd9fcfdfa, 0xa479, 0x412c, { 0x83, 0xb7, 0xc5, 0x64, 0xe, 0x61, 0xcd, 0x62 } };
 
+// How long received output may be held back to coalesce it with the websocket frames following it.
+static constexpr std::chrono::milliseconds outputLatency{ 4 };
+// Accumulated output is flushed immediately once it's this many characters long.
+static constexpr size_t outputFlushThreshold = 128 * 1024;
+
 static inline std::wstring _colorize(const unsigned int colorCode, const std::wstring_view text)
 {
     return fmt::format(L"\x1b[{0}m{1}\x1b[m", colorCode, text);
@@ -280,10 +285,27 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 _hOutputThread.reset();
             }
 
+            // The same applies to the flush timer. Destroying it waits for its callback.
+            _flushPendingOutputThrottled.reset();
+
             _transitionToState(ConnectionState::Closed);
         }
     }
 
+    // Method description:
+    // - Passes the output accumulated by _OutputThread() to our registered event handlers.
+    void AzureConnection::_FlushPendingOutput()
+    {
+        const std::lock_guard guard{ _pendingOutputMutex };
+
+        if (!_pendingOutput.empty())
+        {
+            _TerminalOutputHandlers(_pendingOutput);
+            // clear() retains the capacity, so that the buffer is reused for the next batch.
+            _pendingOutput.clear();
+        }
+    }
+
     // Method description:
     // - This method returns a tenant's ID and display name (if one is available).
     //   If there is no display name, a placeholder is returned in its stead.
@@ -388,6 +410,8 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 // We are connected, continuously read from the websocket until its closed
                 case AzureState::TermConnected:
                 {
+                    _flushPendingOutputThrottled.emplace(outputLatency, [this]() { _FlushPendingOutput(); });
+
                     _transitionToState(ConnectionState::Connected);
 
                     while (true)
@@ -414,11 +438,25 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                                 continue;
                             }
 
-                            // Pass the output to our registered event handlers
-                            _TerminalOutputHandlers(_u16Str);
+                            auto flushNow = false;
+                            {
+                                const std::lock_guard guard{ _pendingOutputMutex };
+                                _pendingOutput.append(_u16Str);
+                                flushNow = _pendingOutput.size() >= outputFlushThreshold;
+                            }
+
+                            if (flushNow)
+                            {
+                                _FlushPendingOutput();
+                            }
+                            else
+                            {
+                                (*_flushPendingOutputThrottled)();
+                            }
                             break;
                         }
                         case WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE:
+                            _FlushPendingOutput();
                             // EXIT POINT
                             if (_transitionToState(ConnectionState::Closed))
                             {
@@ -8,6 +8,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include <til/throttled_func.h>
+
 #include "ConnectionStateHolder.h"
 #include "AzureClient.h"
 
@@ -99,7 +101,16 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         til::u8state _u8State{};
         std::wstring _u16Str;
-        std::array<char, 4096> _buffer{};
+        std::array<char, 64 * 1024> _buffer{};
+
+        // Cloud Shell sends output in many small websocket frames. Instead of raising TerminalOutput
+        // for each of them, the output is accumulated here and flushed after a short delay, or once
+        // enough of it accumulated. The mutex also ensures that flushes happen in order.
+        std::mutex _pendingOutputMutex;
+        std::wstring _pendingOutput;
+        std::optional<til::throttled_func_trailing<>> _flushPendingOutputThrottled;
+
+        void _FlushPendingOutput();
 
         static winrt::hstring _ParsePreferredShellType(const winrt::Windows::Data::Json::JsonObject& settingsResponse);
     };
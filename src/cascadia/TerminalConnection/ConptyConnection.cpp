@@ -11,6 +11,7 @@
 
 #include "CTerminalHandoff.h"
 #include "LibraryResources.h"
+#include "../../types/inc/PerformanceRegion.hpp"
 #include "../../types/inc/utils.hpp"
 
 #include "ConptyConnection.g.cpp"
@@ -34,15 +35,51 @@ static constexpr auto _errorFormat = L"{0} ({0:#010x})"sv;
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
+    // Function Description:
+    // - Creates a unidirectional pipe, just like CreatePipe(), except that the
+    //   reading end (our side) is opened for overlapped I/O. The writing end
+    //   (the pseudoconsole side) remains synchronous, which is what conhost expects.
+    // Arguments:
+    // - phRead: Receives the overlapped handle for reading from the pipe.
+    // - phWrite: Receives the synchronous handle for writing into the pipe.
+    static HRESULT _CreateOverlappedReadPipe(wil::unique_hfile& phRead, wil::unique_hfile& phWrite) noexcept
+    try
+    {
+        static std::atomic<uint32_t> counter{ 0 };
+        const auto name = fmt::format(FMT_COMPILE(L"\\\\.\\pipe\\Local\\ConptyConnection-{}-{}"), GetCurrentProcessId(), counter.fetch_add(1, std::memory_order_relaxed));
+
+        phRead.reset(CreateNamedPipeW(name.c_str(),
+                                      PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                      PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                      1,
+                                      0,
+                                      128 * 1024,
+                                      0,
+                                      nullptr));
+        RETURN_LAST_ERROR_IF(!phRead);
+
+        phWrite.reset(CreateFileW(name.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr));
+        RETURN_LAST_ERROR_IF(!phWrite);
+        return S_OK;
+    }
+    CATCH_RETURN()
+
+    // The size of the shared memory ring the conpty writes its output into, if Feature_ConptySharedMemoryOutput is enabled.
+    // It's large enough to hold the output of several frames, so that the conpty rarely needs to wait for us.
+    static constexpr uint32_t outputRingCapacity = 1024 * 1024;
+
     // Function Description:
     // - creates some basic anonymous pipes and passes them to CreatePseudoConsole
     // Arguments:
     // - size: The size of the conpty to create, in characters.
+    // - outputRing: If not null, the conpty is asked to write its output into this ring instead of phOutput.
+    //   Fails with HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED) if the conpty doesn't support that.
     // - phInput: Receives the handle to the newly-created anonymous pipe for writing input to the conpty.
-    // - phOutput: Receives the handle to the newly-created anonymous pipe for reading the output of the conpty.
+    // - phOutput: Receives the handle to the newly-created pipe for reading the output of the conpty.
+    //   This handle is opened for overlapped I/O.
     // - phPc: Receives a token value to identify this conpty
 #pragma warning(suppress : 26430) // This statement sufficiently checks the out parameters. Analyzer cannot find this.
-    static HRESULT _CreatePseudoConsoleAndPipes(const COORD size, const DWORD dwFlags, HANDLE* phInput, HANDLE* phOutput, HPCON* phPC) noexcept
+    static HRESULT _CreatePseudoConsoleAndPipes(const COORD size, const DWORD dwFlags, const til::shared_ring::handles* outputRing, HANDLE* phInput, HANDLE* phOutput, HPCON* phPC) noexcept
     {
         RETURN_HR_IF(E_INVALIDARG, phPC == nullptr || phInput == nullptr || phOutput == nullptr);
 
@@ -50,13 +87,162 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         wil::unique_hfile inPipeOurSide, inPipePseudoConsoleSide;
 
         RETURN_IF_WIN32_BOOL_FALSE(CreatePipe(&inPipePseudoConsoleSide, &inPipeOurSide, nullptr, 0));
-        RETURN_IF_WIN32_BOOL_FALSE(CreatePipe(&outPipeOurSide, &outPipePseudoConsoleSide, nullptr, 0));
-        RETURN_IF_FAILED(ConptyCreatePseudoConsole(size, inPipePseudoConsoleSide.get(), outPipePseudoConsoleSide.get(), dwFlags, phPC));
+        RETURN_IF_FAILED(_CreateOverlappedReadPipe(outPipeOurSide, outPipePseudoConsoleSide));
+        if (outputRing)
+        {
+            RETURN_IF_FAILED(ConptyCreatePseudoConsoleWithOutputRing(size,
+                                                                     inPipePseudoConsoleSide.get(),
+                                                                     outPipePseudoConsoleSide.get(),
+                                                                     outputRing->section.get(),
+                                                                     outputRing->data.get(),
+                                                                     outputRing->space.get(),
+                                                                     dwFlags,
+                                                                     phPC));
+        }
+        else
+        {
+            RETURN_IF_FAILED(ConptyCreatePseudoConsole(size, inPipePseudoConsoleSide.get(), outPipePseudoConsoleSide.get(), dwFlags, phPC));
+        }
         *phInput = inPipeOurSide.release();
         *phOutput = outPipeOurSide.release();
         return S_OK;
     }
 
+    struct PooledPseudoConsole
+    {
+        static void close(HPCON hPC) noexcept
+        {
+            ::ConptyClosePseudoConsoleTimeout(hPC, 0);
+        }
+
+        wil::unique_hfile inPipe;
+        wil::unique_hfile outPipe;
+        std::optional<til::shared_ring::handles> outputRing;
+        wil::unique_any<HPCON, decltype(close), close> hPC;
+    };
+
+    // Function Description:
+    // - creates a pseudoconsole and its pipes, writing its output into a shared memory ring if possible
+    // Arguments:
+    // - size: The size of the conpty to create, in characters.
+    // - dwFlags: The PSEUDOCONSOLE_* flags to create the conpty with.
+    // - pc: Receives the pseudoconsole and the handles to communicate with it.
+    static HRESULT _CreatePseudoConsole(const COORD size, const DWORD dwFlags, PooledPseudoConsole& pc) noexcept
+    try
+    {
+        std::optional<til::shared_ring::handles> outputRing;
+        if constexpr (Feature_ConptySharedMemoryOutput::IsEnabled())
+        {
+            outputRing.emplace(til::shared_ring::create(outputRingCapacity));
+        }
+
+        HPCON hPC = nullptr;
+        auto hr = _CreatePseudoConsoleAndPipes(size, dwFlags, outputRing ? &*outputRing : nullptr, pc.inPipe.addressof(), pc.outPipe.addressof(), &hPC);
+        // The conpty we're using might be the inbox one, which doesn't know about the output ring.
+        if (hr == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED) && outputRing)
+        {
+            outputRing.reset();
+            hr = _CreatePseudoConsoleAndPipes(size, dwFlags, nullptr, pc.inPipe.addressof(), pc.outPipe.addressof(), &hPC);
+        }
+        RETURN_IF_FAILED(hr);
+
+        pc.hPC.reset(hPC);
+        pc.outputRing = std::move(outputRing);
+        return S_OK;
+    }
+    CATCH_RETURN()
+
+    // If Feature_ConptyPool is enabled, Start() takes its pseudoconsole out of this pool whenever it can,
+    // instead of waiting for OpenConsole to be spawned and initialized. The pool holds one pseudoconsole
+    // that was created ahead of time with the default flags and is refilled in the background once it's taken.
+    // The pool is intentionally leaked: Its pseudoconsole exits by itself once our end of its signal pipe closes.
+    struct PseudoConsolePool
+    {
+        static constexpr COORD size{ 120, 30 };
+        static constexpr DWORD flags = PSEUDOCONSOLE_RESIZE_QUIRK;
+
+        std::mutex lock;
+        std::optional<PooledPseudoConsole> ready;
+        bool refilling = false;
+    };
+
+    static PseudoConsolePool& _GetPseudoConsolePool()
+    {
+        static auto& pool = *new PseudoConsolePool{};
+        return pool;
+    }
+
+    static void _RefillPseudoConsolePool() noexcept
+    try
+    {
+        auto& pool = _GetPseudoConsolePool();
+        {
+            const std::lock_guard guard{ pool.lock };
+            if (pool.ready || pool.refilling)
+            {
+                return;
+            }
+            pool.refilling = true;
+        }
+
+        const auto refill = [](PTP_CALLBACK_INSTANCE, void*) {
+            try
+            {
+                auto& pool = _GetPseudoConsolePool();
+                PooledPseudoConsole pc;
+                const auto hr = _CreatePseudoConsole(PseudoConsolePool::size, PseudoConsolePool::flags, pc);
+                LOG_IF_FAILED(hr);
+
+                const std::lock_guard guard{ pool.lock };
+                if (SUCCEEDED(hr))
+                {
+                    pool.ready.emplace(std::move(pc));
+                }
+                pool.refilling = false;
+            }
+            CATCH_LOG();
+        };
+
+        if (!TrySubmitThreadpoolCallback(refill, nullptr, nullptr))
+        {
+            LOG_LAST_ERROR();
+            const std::lock_guard guard{ pool.lock };
+            pool.refilling = false;
+        }
+    }
+    CATCH_LOG()
+
+    // Function Description:
+    // - takes the pseudoconsole out of the pool, if there's one, and schedules the pool to be refilled
+    // Arguments:
+    // - size: The size the conpty should be resized to, in characters.
+    // Return Value:
+    // - The pooled pseudoconsole or nullopt if the pool was empty.
+    static std::optional<PooledPseudoConsole> _TakePooledPseudoConsole(const COORD size) noexcept
+    try
+    {
+        auto& pool = _GetPseudoConsolePool();
+        std::optional<PooledPseudoConsole> pc;
+        {
+            const std::lock_guard guard{ pool.lock };
+            pc.swap(pool.ready);
+        }
+
+        _RefillPseudoConsolePool();
+
+        // No client is attached yet, so this is as good as having created it at this size.
+        if (pc && FAILED_LOG(ConptyResizePseudoConsole(pc->hPC.get(), size)))
+        {
+            pc.reset();
+        }
+        return pc;
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        return std::nullopt;
+    }
+
     // Function Description:
     // - launches the client application attached to the new pseudoconsole
     HRESULT ConptyConnection::_LaunchAttachedClient() noexcept
@@ -213,7 +399,8 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         _cols{ 80 },
         _guid{ Utils::CreateGuid() },
         _inPipe{ hIn },
-        _outPipe{ hOut }
+        _outPipe{ hOut },
+        _bufferingEarlyOutput{ true }
     {
         THROW_IF_FAILED(ConptyPackPseudoConsole(hServerProcess, hRef, hSig, &_hPC));
         _piClient.hProcess = hClientProcess;
@@ -345,7 +532,29 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 }
             }
 
-            THROW_IF_FAILED(_CreatePseudoConsoleAndPipes(til::unwrap_coord_size(dimensions), flags, &_inPipe, &_outPipe, &_hPC));
+            std::optional<PooledPseudoConsole> pc;
+            if constexpr (Feature_ConptyPool::IsEnabled())
+            {
+                // Only pseudoconsoles with the default flags are pooled.
+                if (flags == PseudoConsolePool::flags)
+                {
+                    pc = _TakePooledPseudoConsole(til::unwrap_coord_size(dimensions));
+                }
+            }
+            if (!pc)
+            {
+                THROW_IF_FAILED(_CreatePseudoConsole(til::unwrap_coord_size(dimensions), flags, pc.emplace()));
+            }
+
+            _inPipe = std::move(pc->inPipe);
+            _outPipe = std::move(pc->outPipe);
+            _hPC.reset(pc->hPC.release());
+            _outPipeOverlapped = true;
+
+            if (pc->outputRing)
+            {
+                _outputRing = std::make_unique<til::shared_ring::consumer>(std::move(*pc->outputRing));
+            }
 
             if (_initialParentHwnd != 0)
             {
@@ -385,10 +594,55 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         THROW_IF_FAILED(ConptyReleasePseudoConsole(_hPC.get()));
 
+        // Handoff connections already started draining their output in NewHandoff().
+        if (!_hOutputThread)
+        {
+            _startOutputThread();
+        }
+
+        _startInputThread();
+
+        _transitionToState(ConnectionState::Connected);
+
+        _flushEarlyOutput();
+    }
+    catch (...)
+    {
+        // EXIT POINT
+        const auto hr = wil::ResultFromCaughtException();
+
+        // Let the output thread report the exit of a handed-off client from now on.
+        _flushEarlyOutput();
+
+        // GH#11556 - make sure to format the error code to this string as an UNSIGNED int
+        winrt::hstring failureText{ fmt::format(std::wstring_view{ RS_(L"ProcessFailedToLaunch") },
+                                                fmt::format(_errorFormat, static_cast<unsigned int>(hr)),
+                                                _commandline) };
+        _TerminalOutputHandlers(failureText);
+
+        // If the path was invalid, let's present an informative message to the user
+        if (hr == HRESULT_FROM_WIN32(ERROR_DIRECTORY))
+        {
+            winrt::hstring badPathText{ fmt::format(std::wstring_view{ RS_(L"BadPathText") },
+                                                    _startingDirectory) };
+            _TerminalOutputHandlers(L"\r\n");
+            _TerminalOutputHandlers(badPathText);
+        }
+
+        _transitionToState(ConnectionState::Failed);
+
+        // Tear down any state we may have accumulated.
+        _hPC.reset();
+    }
+
+    // Method Description:
+    // - Creates the thread that reads the output of our backing host.
+    //   This must be done after the pipes are populated.
+    void ConptyConnection::_startOutputThread()
+    {
         _startTime = std::chrono::high_resolution_clock::now();
 
         // Create our own output handling thread
-        // This must be done after the pipes are populated.
         // Each connection needs to make sure to drain the output from its backing host.
         _hOutputThread.reset(CreateThread(
             nullptr,
@@ -408,33 +662,152 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         THROW_LAST_ERROR_IF_NULL(_hOutputThread);
 
         LOG_IF_FAILED(SetThreadDescription(_hOutputThread.get(), L"ConptyConnection Output Thread"));
+    }
 
-        _transitionToState(ConnectionState::Connected);
+    // Method Description:
+    // - Creates the thread that writes our input to the backing host.
+    //   This must be done after the pipes are populated.
+    void ConptyConnection::_startInputThread()
+    {
+        _hInputThread.reset(CreateThread(
+            nullptr,
+            0,
+            [](LPVOID lpParameter) noexcept {
+                const auto pInstance = static_cast<ConptyConnection*>(lpParameter);
+                if (pInstance)
+                {
+                    return pInstance->_InputThread();
+                }
+                return gsl::narrow_cast<DWORD>(E_INVALIDARG);
+            },
+            this,
+            0,
+            nullptr));
+
+        THROW_LAST_ERROR_IF_NULL(_hInputThread);
+
+        LOG_IF_FAILED(SetThreadDescription(_hInputThread.get(), L"ConptyConnection Input Thread"));
     }
-    catch (...)
+
+    // Method Description:
+    // - Stops the input thread and drops any input that hasn't been written yet.
+    //   Afterwards _inPipe and _hPC aren't used concurrently anymore.
+    void ConptyConnection::_stopInputThread() noexcept
     {
-        // EXIT POINT
-        const auto hr = wil::ResultFromCaughtException();
+        if (!_hInputThread)
+        {
+            return;
+        }
 
-        // GH#11556 - make sure to format the error code to this string as an UNSIGNED int
-        winrt::hstring failureText{ fmt::format(std::wstring_view{ RS_(L"ProcessFailedToLaunch") },
-                                                fmt::format(_errorFormat, static_cast<unsigned int>(hr)),
-                                                _commandline) };
-        _TerminalOutputHandlers(failureText);
+        {
+            const std::lock_guard guard{ _inputMutex };
+            _inputExitRequested = true;
+        }
+        _inputEvent.notify_one();
 
-        // If the path was invalid, let's present an informative message to the user
-        if (hr == HRESULT_FROM_WIN32(ERROR_DIRECTORY))
+        for (;;)
         {
-            winrt::hstring badPathText{ fmt::format(std::wstring_view{ RS_(L"BadPathText") },
-                                                    _startingDirectory) };
-            _TerminalOutputHandlers(L"\r\n");
-            _TerminalOutputHandlers(badPathText);
+            // The input thread might be stuck in WriteFile() if the conpty doesn't read its input anymore.
+            CancelSynchronousIo(_hInputThread.get());
+
+            const auto result = WaitForSingleObject(_hInputThread.get(), 1000);
+            if (result == WAIT_OBJECT_0)
+            {
+                break;
+            }
+
+            LOG_LAST_ERROR();
         }
 
-        _transitionToState(ConnectionState::Failed);
+        _hInputThread.reset();
+    }
 
-        // Tear down any state we may have accumulated.
-        _hPC.reset();
+    // Method Description:
+    // - Sends a signal (resizing, clearing, etc.) to the conpty. If there's input
+    //   that hasn't been written yet, the signal is queued up behind it instead.
+    //   Otherwise it's sent right away and its failure is thrown to the caller.
+    // Arguments:
+    // - signal: the function that sends the signal.
+    void ConptyConnection::_sendSignal(std::function<HRESULT()> signal)
+    {
+        std::unique_lock lock{ _inputMutex };
+
+        if (_inputBusy || !_inputQueue.empty())
+        {
+            _inputQueue.emplace_back(InputQueueItem{ {}, std::move(signal) });
+            lock.unlock();
+            _inputEvent.notify_one();
+            return;
+        }
+
+        // Holding the lock prevents new input from overtaking the signal.
+        THROW_IF_FAILED(signal());
+    }
+
+    DWORD ConptyConnection::_InputThread()
+    {
+        std::unique_lock lock{ _inputMutex };
+
+        for (;;)
+        {
+            _inputEvent.wait(lock, [this]() {
+                return _inputExitRequested || !_inputQueue.empty();
+            });
+
+            if (_inputExitRequested)
+            {
+                return 0;
+            }
+
+            auto item = std::move(_inputQueue.front());
+            _inputQueue.pop_front();
+            _inputBusy = true;
+            lock.unlock();
+
+            if (item.signal)
+            {
+                LOG_IF_FAILED(item.signal());
+            }
+            else if (!WriteFile(_inPipe.get(), item.text.data(), gsl::narrow_cast<DWORD>(item.text.size()), nullptr, nullptr))
+            {
+                const auto gle = GetLastError();
+                // ERROR_OPERATION_ABORTED is the result of CancelSynchronousIo() in _stopInputThread().
+                if (gle != ERROR_OPERATION_ABORTED)
+                {
+                    LOG_WIN32(gle);
+                }
+            }
+
+            lock.lock();
+            _inputBusy = false;
+        }
+    }
+
+    // Method Description:
+    // - A handed-off connection starts reading its output as soon as it's received,
+    //   long before the tab that hosts it has been built and called Start().
+    //   Until then the output is collected in _earlyOutput. This passes it on to our
+    //   event handlers and lets the output thread dispatch directly from now on.
+    void ConptyConnection::_flushEarlyOutput() noexcept
+    {
+        if (_bufferingEarlyOutput.load(std::memory_order_relaxed))
+        {
+            // The output thread blocks on the mutex while we're flushing,
+            // which keeps the early and the subsequent output in order.
+            const std::lock_guard guard{ _earlyOutputMutex };
+            try
+            {
+                if (!_earlyOutput.empty())
+                {
+                    _TerminalOutputHandlers(_earlyOutput);
+                }
+            }
+            CATCH_LOG();
+            _earlyOutput = {};
+            _bufferingEarlyOutput.store(false, std::memory_order_release);
+        }
+
+        _outputAttached.SetEvent();
     }
 
     // Method Description:
@@ -482,7 +855,22 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // convert from UTF-16LE to UTF-8 as ConPty expects UTF-8
         // TODO GH#3378 reconcile and unify UTF-8 converters
         auto str = winrt::to_string(data);
-        LOG_IF_WIN32_BOOL_FALSE(WriteFile(_inPipe.get(), str.c_str(), (DWORD)str.length(), nullptr, nullptr));
+
+        {
+            const std::lock_guard guard{ _inputMutex };
+
+            // Input that the input thread didn't get to yet is coalesced into a single write.
+            if (!_inputQueue.empty() && !_inputQueue.back().signal)
+            {
+                _inputQueue.back().text.append(str);
+            }
+            else
+            {
+                _inputQueue.emplace_back(InputQueueItem{ std::move(str), nullptr });
+            }
+        }
+
+        _inputEvent.notify_one();
     }
 
     void ConptyConnection::Resize(uint32_t rows, uint32_t columns)
@@ -493,7 +881,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         if (_isConnected())
         {
-            THROW_IF_FAILED(ConptyResizePseudoConsole(_hPC.get(), { Utils::ClampToShortMax(columns, 1), Utils::ClampToShortMax(rows, 1) }));
+            _sendSignal([hPC = _hPC.get(), size = COORD{ Utils::ClampToShortMax(columns, 1), Utils::ClampToShortMax(rows, 1) }]() {
+                return ConptyResizePseudoConsole(hPC, size);
+            });
         }
     }
 
@@ -503,16 +893,38 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // anything. The connection should already start clear!
         if (_isConnected())
         {
-            THROW_IF_FAILED(ConptyClearPseudoConsole(_hPC.get()));
+            _sendSignal([hPC = _hPC.get()]() {
+                return ConptyClearPseudoConsole(hPC);
+            });
         }
     }
 
+    // Method Description:
+    // - Returns the number of bytes used by the buffers that the output passes through:
+    //   The output ring shared with the conpty (if any), the read buffers, the UTF-16
+    //   decoding buffer and any output that's been buffered until Start() got called.
+    uint64_t ConptyConnection::MemoryUsage() const
+    {
+        uint64_t usage = sizeof(_buffer) + _readBufferSize.load(std::memory_order_relaxed) + _decodeBufferSize.load(std::memory_order_relaxed);
+        if (_outputRing)
+        {
+            usage += til::shared_ring::mapping_size(outputRingCapacity);
+        }
+        {
+            const std::lock_guard guard{ _earlyOutputMutex };
+            usage += _earlyOutput.capacity() * sizeof(wchar_t);
+        }
+        return usage;
+    }
+
     void ConptyConnection::ShowHide(const bool show)
     {
         // If we haven't connected yet, then stash for when we do connect.
         if (_isConnected())
         {
-            THROW_IF_FAILED(ConptyShowHidePseudoConsole(_hPC.get(), show));
+            _sendSignal([hPC = _hPC.get(), show]() {
+                return ConptyShowHidePseudoConsole(hPC, show);
+            });
         }
         else
         {
@@ -532,7 +944,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // possible to reparent terminals to different windows.
         else if (_isConnected())
         {
-            THROW_IF_FAILED(ConptyReparentPseudoConsole(_hPC.get(), reinterpret_cast<HWND>(newParent)));
+            _sendSignal([hPC = _hPC.get(), newParent]() {
+                return ConptyReparentPseudoConsole(hPC, reinterpret_cast<HWND>(newParent));
+            });
         }
     }
 
@@ -541,6 +955,13 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     {
         _transitionToState(ConnectionState::Closing);
 
+        // Release the output thread in case it's holding on to the exit of a handed-off
+        // client which was never started. The Closing state tells it to bail out.
+        _outputAttached.SetEvent();
+
+        // The input thread uses both _hPC and _inPipe, so it needs to exit before they're released.
+        _stopInputThread();
+
         // .reset()ing either of these two will signal ConPTY to send out a CTRL_CLOSE_EVENT to all attached clients.
         // FYI: The other members of this class are concurrently read by the _hOutputThread
         // thread running in the background and so they're not safe to be .reset().
@@ -558,6 +979,16 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 // reference UI objects like `ControlCore`. CancelSynchronousIo() allows us to have the background
                 // thread exit as fast as possible by aborting any ongoing writes coming from OpenConsole.
                 CancelSynchronousIo(_hOutputThread.get());
+                // The overlapped reads of _OverlappedOutputThread() aren't affected by CancelSynchronousIo().
+                if (_outPipeOverlapped)
+                {
+                    CancelIoEx(_outPipe.get(), nullptr);
+                }
+                // Neither is _RingOutputThread() waiting for the ring. This wakes it up.
+                if (_outputRing)
+                {
+                    _outputRing->close();
+                }
 
                 // Waiting for the output thread to exit ensures that all pending _TerminalOutputHandlers()
                 // calls have returned and won't notify our caller (ControlCore) anymore. This ensures that
@@ -620,6 +1051,17 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // won't wait for us, and the known exit points _do_.
         auto strongThis{ get_strong() };
 
+        if (_outputRing)
+        {
+            return _RingOutputThread();
+        }
+
+        // Pipes we received via a handoff are synchronous and can only be read from in a blocking manner.
+        if (_outPipeOverlapped)
+        {
+            return _OverlappedOutputThread();
+        }
+
         // process the data of the output pipe in a loop
         while (true)
         {
@@ -637,6 +1079,15 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             {
                 // EXIT POINT
                 const auto lastError = GetLastError();
+
+                // A handed-off client may exit before our tab called Start(). Hold on to
+                // the exit until then, so that it's reported after the client's output.
+                _outputAttached.wait();
+                if (_isStateAtOrBeyond(ConnectionState::Closing))
+                {
+                    return 0;
+                }
+
                 if (lastError == ERROR_BROKEN_PIPE)
                 {
                     _LastConPtyClientDisconnected();
@@ -664,27 +1115,271 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 return 0;
             }
 
-            if (!_receivedFirstByte)
+            _dispatchOutput();
+        }
+
+        return 0;
+    }
+
+    // Method Description:
+    // - The overlapped I/O variant of _OutputThread(). It rotates between
+    //   multiple buffers, so that the next ReadFile() is already in flight,
+    //   while the _TerminalOutputHandlers are busy with the previous chunk.
+    //   The size of the buffers is adapted to the observed read sizes:
+    //   Whenever a read filled the buffer completely we double its size.
+    DWORD ConptyConnection::_OverlappedOutputThread()
+    {
+        static constexpr size_t minimumBufferSize = 4 * 1024;
+        static constexpr size_t maximumBufferSize = 128 * 1024;
+
+        struct PendingRead
+        {
+            OVERLAPPED overlapped{};
+            wil::unique_event event{ wil::EventOptions::ManualReset };
+            std::vector<char> buffer;
+            DWORD error = ERROR_SUCCESS;
+        };
+
+        std::array<PendingRead, 2> reads;
+        auto bufferSize = minimumBufferSize;
+
+        const auto issueRead = [&](PendingRead& r) {
+            r.buffer.resize(bufferSize);
+            _readBufferSize.store(til::at(reads, 0).buffer.capacity() + til::at(reads, 1).buffer.capacity(), std::memory_order_relaxed);
+            r.overlapped = {};
+            r.overlapped.hEvent = r.event.get();
+            r.error = ERROR_SUCCESS;
+
+            if (!ReadFile(_outPipe.get(), r.buffer.data(), gsl::narrow_cast<DWORD>(r.buffer.size()), nullptr, &r.overlapped))
+            {
+                const auto lastError = GetLastError();
+                if (lastError != ERROR_IO_PENDING)
+                {
+                    r.error = lastError;
+                }
+            }
+        };
+
+        size_t current = 0;
+        issueRead(reads[current]);
+
+        // process the data of the output pipe in a loop
+        while (true)
+        {
+            auto& r = til::at(reads, current);
+            DWORD read{};
+            auto lastError = r.error;
+
+            if (lastError == ERROR_SUCCESS && !GetOverlappedResult(_outPipe.get(), &r.overlapped, &read, TRUE))
             {
-                const auto now = std::chrono::high_resolution_clock::now();
-                const std::chrono::duration<double> delta = now - _startTime;
+                lastError = GetLastError();
+            }
 
-#pragma warning(suppress : 26477 26485 26494 26482 26446) // We don't control TraceLoggingWrite
-                TraceLoggingWrite(g_hTerminalConnectionProvider,
-                                  "ReceivedFirstByte",
-                                  TraceLoggingDescription("An event emitted when the connection receives the first byte"),
-                                  TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
-                                  TraceLoggingFloat64(delta.count(), "Duration"),
-                                  TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
-                                  TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
-                _receivedFirstByte = true;
+            // When we call CancelIoEx() in Close() this is the branch that's taken and gets us out of here.
+            if (_isStateAtOrBeyond(ConnectionState::Closing))
+            {
+                return 0;
+            }
+
+            if (lastError != ERROR_SUCCESS) // reading failed (we must check this first, because read will also be 0.)
+            {
+                // EXIT POINT
+                if (lastError == ERROR_BROKEN_PIPE)
+                {
+                    _LastConPtyClientDisconnected();
+                    return S_OK;
+                }
+                else
+                {
+                    _indicateExitWithStatus(HRESULT_FROM_WIN32(lastError)); // print a message
+                    _transitionToState(ConnectionState::Failed);
+                    return gsl::narrow_cast<DWORD>(HRESULT_FROM_WIN32(lastError));
+                }
+            }
+
+            if (read == 0)
+            {
+                return 0;
+            }
+
+            // The child is producing output faster than we can consume it. Use larger reads.
+            if (read == r.buffer.size())
+            {
+                bufferSize = std::min(bufferSize * 2, maximumBufferSize);
+            }
+
+            // Queue up the next read before we process the current chunk. Any failure
+            // to do so is stashed in the PendingRead and handled in the next iteration.
+            current = (current + 1) % reads.size();
+            issueRead(til::at(reads, current));
+
+            const auto result{ til::u8u16(std::string_view{ r.buffer.data(), read }, _u16Str, _u8State) };
+            if (FAILED(result))
+            {
+                // EXIT POINT
+                _indicateExitWithStatus(result); // print a message
+                _transitionToState(ConnectionState::Failed);
+                return gsl::narrow_cast<DWORD>(result);
+            }
+
+            // The chunk may have consisted of nothing but the beginning of a UTF-8 sequence.
+            if (!_u16Str.empty())
+            {
+                _dispatchOutput();
             }
+        }
+    }
 
-            // Pass the output to our registered event handlers
-            _TerminalOutputHandlers(_u16Str);
+    // Method Description:
+    // - The shared memory variant of _OutputThread(). The conpty writes its output into
+    //   _outputRing, which we decode straight out of the shared memory without any syscalls,
+    //   as long as the ring is neither empty nor full.
+    //   The output pipe stays connected. OpenConsole never writes to it, but closes it when it
+    //   exits, so a pending read on it tells us about its exit. If the read returns data instead,
+    //   the console host ignored the ring and we fall back to reading the pipe.
+    DWORD ConptyConnection::_RingOutputThread()
+    {
+        wil::unique_event probeEvent{ wil::EventOptions::ManualReset };
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = probeEvent.get();
+        char probe = 0;
+        DWORD probeError = ERROR_SUCCESS;
+        DWORD read{};
+
+        if (!ReadFile(_outPipe.get(), &probe, 1, nullptr, &overlapped))
+        {
+            probeError = GetLastError();
+            if (probeError != ERROR_IO_PENDING)
+            {
+                // The read failed right away and won't signal the event. Do it ourselves, so that
+                // the loop below drains the ring and then stops instead of waiting forever.
+                probeEvent.SetEvent();
+            }
         }
 
-        return 0;
+        // process the data of the output ring in a loop
+        while (true)
+        {
+            const auto data = _outputRing->read(probeEvent.get());
+
+            // When we call _outputRing->close() in Close() this is the branch that's taken and gets us out of here.
+            if (_isStateAtOrBeyond(ConnectionState::Closing))
+            {
+                return 0;
+            }
+
+            if (data.empty())
+            {
+                break;
+            }
+
+            const auto result{ til::u8u16(data, _u16Str, _u8State) };
+            // _u16Str holds a copy of the data now. Give the space back to the conpty before we dispatch it.
+            _outputRing->consume(data.size());
+            if (FAILED(result))
+            {
+                // EXIT POINT
+                _indicateExitWithStatus(result); // print a message
+                _transitionToState(ConnectionState::Failed);
+                return gsl::narrow_cast<DWORD>(result);
+            }
+
+            // The chunk may have consisted of nothing but the beginning of a UTF-8 sequence.
+            if (!_u16Str.empty())
+            {
+                _dispatchOutput();
+            }
+        }
+
+        // The ring got closed or the probe completed. Either way we need the probe's result to find out why.
+        if (probeError == ERROR_IO_PENDING)
+        {
+            probeError = GetOverlappedResult(_outPipe.get(), &overlapped, &read, TRUE) ? ERROR_SUCCESS : GetLastError();
+        }
+        else if (probeError == ERROR_SUCCESS)
+        {
+            LOG_IF_WIN32_BOOL_FALSE(GetOverlappedResult(_outPipe.get(), &overlapped, &read, FALSE));
+        }
+
+        // When we call CancelIoEx() in Close() this is the branch that's taken and gets us out of here.
+        if (_isStateAtOrBeyond(ConnectionState::Closing))
+        {
+            return 0;
+        }
+
+        if (probeError != ERROR_SUCCESS)
+        {
+            // EXIT POINT
+            if (probeError == ERROR_BROKEN_PIPE)
+            {
+                _LastConPtyClientDisconnected();
+                return S_OK;
+            }
+            else
+            {
+                _indicateExitWithStatus(HRESULT_FROM_WIN32(probeError)); // print a message
+                _transitionToState(ConnectionState::Failed);
+                return gsl::narrow_cast<DWORD>(HRESULT_FROM_WIN32(probeError));
+            }
+        }
+
+        if (read == 0)
+        {
+            return 0;
+        }
+
+        // The console host writes to the pipe after all. Pass on the byte we read and continue there.
+        const auto result{ til::u8u16(std::string_view{ &probe, read }, _u16Str, _u8State) };
+        if (FAILED(result))
+        {
+            // EXIT POINT
+            _indicateExitWithStatus(result); // print a message
+            _transitionToState(ConnectionState::Failed);
+            return gsl::narrow_cast<DWORD>(result);
+        }
+        if (!_u16Str.empty())
+        {
+            _dispatchOutput();
+        }
+
+        return _OverlappedOutputThread();
+    }
+
+    // Method Description:
+    // - Passes the contents of _u16Str to our registered event handlers.
+    void ConptyConnection::_dispatchOutput()
+    {
+        if (!_receivedFirstByte)
+        {
+            const auto now = std::chrono::high_resolution_clock::now();
+            const std::chrono::duration<double> delta = now - _startTime;
+
+#pragma warning(suppress : 26477 26485 26494 26482 26446) // We don't control TraceLoggingWrite
+            TraceLoggingWrite(g_hTerminalConnectionProvider,
+                              "ReceivedFirstByte",
+                              TraceLoggingDescription("An event emitted when the connection receives the first byte"),
+                              TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
+                              TraceLoggingFloat64(delta.count(), "Duration"),
+                              TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
+                              TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
+            _receivedFirstByte = true;
+        }
+
+        if (_bufferingEarlyOutput.load(std::memory_order_acquire))
+        {
+            const std::lock_guard guard{ _earlyOutputMutex };
+            if (_bufferingEarlyOutput.load(std::memory_order_relaxed))
+            {
+                _earlyOutput.append(_u16Str);
+                return;
+            }
+        }
+
+        _decodeBufferSize.store(_u16Str.capacity() * sizeof(wchar_t), std::memory_order_relaxed);
+
+        // Pass the output to our registered event handlers
+        const ::Microsoft::Console::Types::PerformanceRegion region{ "ConptyConnection_Output" };
+        _TerminalOutputHandlers(_u16Str);
     }
 
     static winrt::event<NewConnectionHandler> _newConnectionHandlers;
@@ -700,7 +1395,17 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     HRESULT ConptyConnection::NewHandoff(HANDLE in, HANDLE out, HANDLE signal, HANDLE ref, HANDLE server, HANDLE client, TERMINAL_STARTUP_INFO startupInfo) noexcept
     try
     {
-        _newConnectionHandlers(winrt::make<ConptyConnection>(signal, in, out, ref, server, client, startupInfo));
+        const auto connection = winrt::make_self<ConptyConnection>(signal, in, out, ref, server, client, startupInfo);
+
+        // Our handlers build an entire tab for the connection and only call Start() once that's done.
+        // The client's console host doesn't wait for that and will block once the output pipe is full,
+        // so we begin draining it right away. The output is held in memory until Start() is called.
+        if (_newConnectionHandlers)
+        {
+            connection->_startOutputThread();
+        }
+
+        _newConnectionHandlers(*connection);
 
         return S_OK;
     }
@@ -716,6 +1421,18 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         THROW_IF_FAILED(CTerminalHandoff::s_StopListening());
     }
 
+    // Function Description:
+    // - Fills the pseudoconsole pool ahead of the first Start(), so that spawning
+    //   OpenConsole overlaps with whatever the caller does in the meantime,
+    //   like loading the settings and building the UI during startup.
+    void ConptyConnection::PrestartPseudoConsole()
+    {
+        if constexpr (Feature_ConptyPool::IsEnabled())
+        {
+            _RefillPseudoConsolePool();
+        }
+    }
+
     // Function Description:
     // - This function will be called (by C++/WinRT) after the final outstanding reference to
     //   any given connection instance is released.
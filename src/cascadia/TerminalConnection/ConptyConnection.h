@@ -8,6 +8,10 @@
 
 #include "ITerminalHandoff.h"
 
+#include <til/shared_ring.h>
+
+#include <condition_variable>
+
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
     struct ConptyConnection : ConptyConnectionT<ConptyConnection>, ConnectionStateHolder<ConptyConnection>
@@ -30,6 +34,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         void Resize(uint32_t rows, uint32_t columns);
         void Close() noexcept;
         void ClearBuffer();
+        uint64_t MemoryUsage() const;
 
         void ShowHide(const bool show);
 
@@ -41,6 +46,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         WORD ShowWindow() const noexcept;
 
         static void StartInboundListener();
+        static void PrestartPseudoConsole();
         static void StopInboundListener();
 
         static winrt::event_token NewConnection(const NewConnectionHandler& handler);
@@ -82,6 +88,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         wil::unique_hfile _inPipe; // The pipe for writing input to
         wil::unique_hfile _outPipe; // The pipe for reading output from
+        std::unique_ptr<til::shared_ring::consumer> _outputRing; // Replaces _outPipe for output, if the conpty supports it
         wil::unique_handle _hOutputThread;
         wil::unique_process_information _piClient;
         wil::unique_any<HPCON, decltype(closePseudoConsoleAsync), closePseudoConsoleAsync> _hPC;
@@ -89,6 +96,10 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         til::u8state _u8State{};
         std::wstring _u16Str{};
         std::array<char, 4096> _buffer{};
+        // The sizes of the buffers owned by the output thread, published for MemoryUsage().
+        std::atomic<size_t> _readBufferSize{ 0 };
+        std::atomic<size_t> _decodeBufferSize{ 0 };
+        bool _outPipeOverlapped{ false };
         bool _passthroughMode{};
         bool _inheritCursor{ false };
         bool _reloadEnvironmentVariables{};
@@ -103,7 +114,38 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         } _startupInfo{};
 
+        // Output of a handed-off connection that arrived before Start(). See _flushEarlyOutput().
+        mutable std::mutex _earlyOutputMutex;
+        std::wstring _earlyOutput;
+        std::atomic<bool> _bufferingEarlyOutput{ false };
+        wil::slim_event_manual_reset _outputAttached;
+
+        // WriteInput() only queues up the input, which is then written to _inPipe by _InputThread(),
+        // so that a conpty that's busy and stops reading its input can't block the UI thread.
+        // Consecutive input is coalesced into a single write. Signals (resizing, etc.) that are sent
+        // while input is pending get queued up behind it, so that the conpty receives both in order.
+        struct InputQueueItem
+        {
+            std::string text;
+            std::function<HRESULT()> signal;
+        };
+        std::mutex _inputMutex;
+        std::condition_variable _inputEvent;
+        std::deque<InputQueueItem> _inputQueue;
+        bool _inputBusy{ false };
+        bool _inputExitRequested{ false };
+        wil::unique_handle _hInputThread;
+
+        void _startOutputThread();
+        void _startInputThread();
+        void _stopInputThread() noexcept;
+        void _sendSignal(std::function<HRESULT()> signal);
+        DWORD _InputThread();
+        void _flushEarlyOutput() noexcept;
         DWORD _OutputThread();
+        DWORD _OverlappedOutputThread();
+        DWORD _RingOutputThread();
+        void _dispatchOutput();
     };
 }
 
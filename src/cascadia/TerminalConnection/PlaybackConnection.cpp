@@ -0,0 +1,714 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "PlaybackConnection.h"
+
+#include <charconv>
+
+#include <LibraryResources.h>
+
+#include "PlaybackConnection.g.cpp"
+
+using namespace ::std::string_view_literals;
+
+// {4b7ad1d3-6a52-4b33-9a0e-21c2bd9a0f35}
+static constexpr winrt::guid PlaybackConnectionType = { 0x4b7ad1d3, 0x6a52, 0x4b33, { 0x9a, 0x0e, 0x21, 0xc2, 0xbd, 0x9a, 0x0f, 0x35 } };
+static constexpr auto errorFormat = L"{0} ({0:#010x})"sv;
+// The amount of UTF-8 that's decoded and handed to TerminalOutput at once.
+static constexpr size_t batchSize = 128 * 1024;
+// How far the left and right keys seek, in seconds of recording time.
+static constexpr double seekStep = 10.0;
+static constexpr double maxSpeed = 64.0;
+static constexpr double minSpeed = 1.0 / 16.0;
+
+namespace
+{
+    constexpr bool isJsonWhitespace(const char ch) noexcept
+    {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    }
+
+    void skipWhitespace(const std::string_view str, size_t& pos) noexcept
+    {
+        while (pos < str.size() && isJsonWhitespace(str[pos]))
+        {
+            ++pos;
+        }
+    }
+
+    bool consume(const std::string_view str, size_t& pos, const char ch) noexcept
+    {
+        skipWhitespace(str, pos);
+        if (pos < str.size() && str[pos] == ch)
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    // Expects pos to point at the opening quote of a JSON string and returns its still escaped contents.
+    std::optional<std::string_view> consumeString(const std::string_view str, size_t& pos) noexcept
+    {
+        if (!consume(str, pos, '"'))
+        {
+            return std::nullopt;
+        }
+
+        const auto beg = pos;
+        while (pos < str.size())
+        {
+            const auto ch = str[pos];
+            if (ch == '"')
+            {
+                return str.substr(beg, pos++ - beg);
+            }
+            pos += ch == '\\' ? 2 : 1;
+        }
+
+        return std::nullopt;
+    }
+
+    // Parses an asciicast v2 event line of the form `[time, "type", "data"]`.
+    bool parseEvent(const std::string_view line, double& time, std::string_view& type, std::string_view& data) noexcept
+    {
+        size_t pos = 0;
+
+        if (!consume(line, pos, '['))
+        {
+            return false;
+        }
+
+        skipWhitespace(line, pos);
+        const auto [end, ec] = std::from_chars(line.data() + pos, line.data() + line.size(), time);
+        if (ec != std::errc{})
+        {
+            return false;
+        }
+        pos = end - line.data();
+
+        if (!consume(line, pos, ','))
+        {
+            return false;
+        }
+        const auto t = consumeString(line, pos);
+        if (!t || !consume(line, pos, ','))
+        {
+            return false;
+        }
+        const auto d = consumeString(line, pos);
+        if (!d)
+        {
+            return false;
+        }
+
+        type = *t;
+        data = *d;
+        return true;
+    }
+
+    constexpr int hexValue(const char ch) noexcept
+    {
+        if (ch >= '0' && ch <= '9')
+        {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f')
+        {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F')
+        {
+            return ch - 'A' + 10;
+        }
+        return -1;
+    }
+
+    // Parses the 4 hex digits following a "\u" at str[pos]. Returns -1 if they're invalid.
+    int parseUnicodeEscape(const std::string_view str, const size_t pos) noexcept
+    {
+        if (pos + 6 > str.size() || str[pos] != '\\' || str[pos + 1] != 'u')
+        {
+            return -1;
+        }
+
+        auto value = 0;
+        for (size_t i = pos + 2; i < pos + 6; ++i)
+        {
+            const auto digit = hexValue(str[i]);
+            if (digit < 0)
+            {
+                return -1;
+            }
+            value = value << 4 | digit;
+        }
+        return value;
+    }
+
+    void appendUtf8(std::string& out, const uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    // Appends the UTF-8 contents of an escaped JSON string. Invalid escapes and unpaired surrogates turn into U+FFFD.
+    void appendUnescaped(std::string& out, const std::string_view str)
+    {
+        size_t pos = 0;
+
+        while (pos < str.size())
+        {
+            const auto esc = str.find('\\', pos);
+            if (esc == std::string_view::npos)
+            {
+                out.append(str.substr(pos));
+                break;
+            }
+
+            out.append(str.substr(pos, esc - pos));
+            pos = esc + 2;
+
+            switch (esc + 1 < str.size() ? str[esc + 1] : '\0')
+            {
+            case '"':
+                out.push_back('"');
+                break;
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '/':
+                out.push_back('/');
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u':
+            {
+                auto cp = parseUnicodeEscape(str, esc);
+                if (cp < 0)
+                {
+                    appendUtf8(out, 0xFFFD);
+                    break;
+                }
+
+                pos = esc + 6;
+
+                if (til::is_leading_surrogate(static_cast<wchar_t>(cp)))
+                {
+                    const auto trailing = parseUnicodeEscape(str, pos);
+                    if (trailing >= 0 && til::is_trailing_surrogate(static_cast<wchar_t>(trailing)))
+                    {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (trailing - 0xDC00);
+                        pos += 6;
+                    }
+                    else
+                    {
+                        cp = 0xFFFD;
+                    }
+                }
+                else if (til::is_trailing_surrogate(static_cast<wchar_t>(cp)))
+                {
+                    cp = 0xFFFD;
+                }
+
+                appendUtf8(out, gsl::narrow_cast<uint32_t>(cp));
+                break;
+            }
+            default:
+                appendUtf8(out, 0xFFFD);
+                break;
+            }
+        }
+    }
+
+    // Returns true if the escaped JSON string contains a RIS (ESC c) or an ED 3 (ESC [ 3 J), after which the
+    // terminal is reset or at least its buffer is cleared. Replaying a recording from an event like that looks
+    // the same as replaying it from the beginning. JSON encodes ESC as "\u001b", since it's a control character.
+    bool clearsTerminal(const std::string_view str) noexcept
+    {
+        for (size_t pos = 0; pos < str.size();)
+        {
+            if (str[pos] != '\\')
+            {
+                ++pos;
+                continue;
+            }
+
+            if (parseUnicodeEscape(str, pos) == 0x1b)
+            {
+                const auto rest = str.substr(pos + 6);
+                if (rest.starts_with("c") || rest.starts_with("[3J"))
+                {
+                    return true;
+                }
+                pos += 6;
+            }
+            else
+            {
+                pos += 2;
+            }
+        }
+
+        return false;
+    }
+}
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    winrt::guid PlaybackConnection::ConnectionType() noexcept
+    {
+        return PlaybackConnectionType;
+    }
+
+    Windows::Foundation::Collections::ValueSet PlaybackConnection::CreateSettings(const winrt::hstring& path, const double speed)
+    {
+        Windows::Foundation::Collections::ValueSet vs{};
+        vs.Insert(L"path", Windows::Foundation::PropertyValue::CreateString(path));
+        vs.Insert(L"speed", Windows::Foundation::PropertyValue::CreateDouble(speed));
+        return vs;
+    }
+
+    void PlaybackConnection::Initialize(const Windows::Foundation::Collections::ValueSet& settings)
+    {
+        if (settings)
+        {
+            _path = winrt::unbox_value_or<winrt::hstring>(settings.TryLookup(L"path").try_as<Windows::Foundation::IPropertyValue>(), _path);
+            _speed = std::clamp(winrt::unbox_value_or<double>(settings.TryLookup(L"speed").try_as<Windows::Foundation::IPropertyValue>(), _speed), 0.0, maxSpeed);
+        }
+    }
+
+    void PlaybackConnection::Start()
+    {
+        _hOutputThread.reset(CreateThread(
+            nullptr,
+            0,
+            [](LPVOID lpParameter) noexcept {
+                const auto pInstance = static_cast<PlaybackConnection*>(lpParameter);
+                if (pInstance)
+                {
+                    return pInstance->_OutputThread();
+                }
+                return gsl::narrow<DWORD>(E_INVALIDARG);
+            },
+            this,
+            0,
+            nullptr));
+
+        THROW_LAST_ERROR_IF_NULL(_hOutputThread);
+
+        LOG_IF_FAILED(SetThreadDescription(_hOutputThread.get(), L"PlaybackConnection Output Thread"));
+
+        _transitionToState(ConnectionState::Connecting);
+    }
+
+    // Method description:
+    // - Translates the keys sent by the terminal into playback controls. Plain characters are
+    //   handled as is, while the arrow keys arrive as CSI sequences or, if the recording happened
+    //   to enable win32-input-mode, as "CSI Vk;Sc;Uc;Kd;Cs;Rc _" sequences.
+    // Arguments:
+    // - data: the input from the terminal
+    void PlaybackConnection::WriteInput(const hstring& data)
+    {
+        const std::wstring_view str{ data };
+
+        {
+            const auto lock = std::lock_guard{ _mutex };
+
+            for (size_t pos = 0; pos < str.size();)
+            {
+                if (!str.substr(pos).starts_with(L"\x1b["))
+                {
+                    _handleKey(str[pos++]);
+                    continue;
+                }
+
+                const auto beg = pos + 2;
+                pos = beg;
+                while (pos < str.size() && (str[pos] < 0x40 || str[pos] > 0x7e))
+                {
+                    ++pos;
+                }
+                if (pos >= str.size())
+                {
+                    break;
+                }
+
+                const auto final = str[pos++];
+                if (final == L'C')
+                {
+                    _control(Control::SeekForward);
+                }
+                else if (final == L'D')
+                {
+                    _control(Control::SeekBackward);
+                }
+                else if (final == L'_')
+                {
+                    // Vk;Sc;Uc;Kd;Cs;Rc. Only key presses are of interest.
+                    std::array<int, 4> params{};
+                    size_t i = 0;
+                    for (const auto ch : str.substr(beg, pos - 1 - beg))
+                    {
+                        if (ch == L';')
+                        {
+                            if (++i == params.size())
+                            {
+                                break;
+                            }
+                        }
+                        else if (ch >= L'0' && ch <= L'9')
+                        {
+                            til::at(params, i) = til::at(params, i) * 10 + (ch - L'0');
+                        }
+                    }
+
+                    const auto keyDown = params[3] != 0;
+                    if (keyDown && params[2] != 0)
+                    {
+                        _handleKey(gsl::narrow_cast<wchar_t>(params[2]));
+                    }
+                    else if (keyDown && params[0] == VK_RIGHT)
+                    {
+                        _control(Control::SeekForward);
+                    }
+                    else if (keyDown && params[0] == VK_LEFT)
+                    {
+                        _control(Control::SeekBackward);
+                    }
+                }
+            }
+        }
+
+        _cv.notify_all();
+    }
+
+    // Must be called with _mutex held.
+    void PlaybackConnection::_handleKey(const wchar_t key) noexcept
+    {
+        switch (key)
+        {
+        case L' ':
+            _control(Control::TogglePause);
+            break;
+        case L'+':
+            _control(Control::SpeedUp);
+            break;
+        case L'-':
+            _control(Control::SlowDown);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Must be called with _mutex held.
+    void PlaybackConnection::_control(const Control control) noexcept
+    {
+        switch (control)
+        {
+        case Control::TogglePause:
+            _paused = !_paused;
+            break;
+        case Control::SpeedUp:
+            // Speeding up past the maximum plays as fast as possible.
+            if (_speed != 0)
+            {
+                _speed = _speed < maxSpeed ? _speed * 2 : 0;
+            }
+            break;
+        case Control::SlowDown:
+            _speed = _speed != 0 ? std::max(_speed / 2, minSpeed) : maxSpeed;
+            break;
+        case Control::SeekBackward:
+            _pendingSeek -= seekStep;
+            break;
+        case Control::SeekForward:
+            _pendingSeek += seekStep;
+            break;
+        }
+
+        _resetOrigin();
+    }
+
+    void PlaybackConnection::Resize(uint32_t /*rows*/, uint32_t /*columns*/) noexcept
+    {
+        // The recording was made at a fixed size and there's nothing to resize.
+    }
+
+    void PlaybackConnection::Close() noexcept
+    {
+        if (_transitionToState(ConnectionState::Closing))
+        {
+            // Acquiring the lock ensures that the output thread is either waiting already
+            // or will observe the Closing state before it would start waiting.
+            {
+                const auto lock = std::lock_guard{ _mutex };
+            }
+            _cv.notify_all();
+
+            if (_hOutputThread)
+            {
+                // Waiting for the output thread to exit ensures that all pending _TerminalOutputHandlers()
+                // calls have returned and won't notify our caller (ControlCore) anymore. This ensures that
+                // we don't call a destroyed event handler asynchronously from a background thread (GH#13880).
+                WaitForSingleObject(_hOutputThread.get(), INFINITE);
+                _hOutputThread.reset();
+            }
+
+            _transitionToState(ConnectionState::Closed);
+        }
+    }
+
+    void PlaybackConnection::_open()
+    {
+        _file.reset(CreateFileW(_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+        THROW_LAST_ERROR_IF(!_file);
+
+        LARGE_INTEGER size{};
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(_file.get(), &size));
+        if (size.QuadPart == 0)
+        {
+            // Empty files can't be mapped and there's nothing to play anyway.
+            return;
+        }
+
+        _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_mapping);
+
+        _view.reset(static_cast<char*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+        THROW_LAST_ERROR_IF_NULL(_view);
+
+        _contents = { _view.get(), gsl::narrow<size_t>(size.QuadPart) };
+    }
+
+    // Method description:
+    // - Splits the recording into its events, without decoding their output.
+    //   Lines that aren't valid events (for instance the tail of a recording that
+    //   is still being written) are skipped. Throws if the header is missing.
+    void PlaybackConnection::_index()
+    {
+        auto contents = _contents;
+        if (contents.starts_with("\xEF\xBB\xBF"))
+        {
+            contents = contents.substr(3);
+        }
+
+        bool header = true;
+
+        while (!contents.empty())
+        {
+            const auto eol = std::min(contents.find('\n'), contents.size());
+            const auto line = contents.substr(0, eol);
+            contents = contents.substr(std::min(eol + 1, contents.size()));
+
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+            {
+                continue;
+            }
+
+            if (header)
+            {
+                // The header is an object, while all events are arrays.
+                THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), !line.starts_with('{'));
+                header = false;
+                continue;
+            }
+
+            double time = 0;
+            std::string_view type;
+            std::string_view data;
+            if (!parseEvent(line, time, type, data) || type != "o")
+            {
+                continue;
+            }
+
+            if (_events.empty() || clearsTerminal(data))
+            {
+                _checkpoints.emplace_back(_events.size());
+            }
+            _events.emplace_back(time, data);
+        }
+
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), header);
+    }
+
+    std::chrono::steady_clock::time_point PlaybackConnection::_dueTime(const double time) const noexcept
+    {
+        const std::chrono::duration<double> delay{ (time - _originTime) / _speed };
+        return _originClock + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+    }
+
+    // Method description:
+    // - Restarts the pacing at the current position. Must be called with _mutex held
+    //   whenever the position, speed or pause state changes.
+    void PlaybackConnection::_resetOrigin() noexcept
+    {
+        _originClock = std::chrono::steady_clock::now();
+        _originTime = _position ? til::at(_events, _position - 1).time : 0.0;
+    }
+
+    // Method description:
+    // - Decodes the output of the events in [begin, end) and hands it to TerminalOutput,
+    //   in batches of roughly batchSize. Must be called without _mutex held.
+    // Arguments:
+    // - reset: whether to reset the terminal (RIS) first
+    void PlaybackConnection::_emit(const size_t begin, const size_t end, const bool reset)
+    {
+        std::string utf8;
+        std::wstring wide;
+
+        if (reset)
+        {
+            utf8.append("\x1b"
+                        "c");
+        }
+
+        for (auto i = begin; i < end; ++i)
+        {
+            appendUnescaped(utf8, til::at(_events, i).data);
+
+            if (utf8.size() >= batchSize || i + 1 == end)
+            {
+                THROW_IF_FAILED(til::u8u16(utf8, wide));
+                _TerminalOutputHandlers(wide);
+                utf8.clear();
+
+                // Seeking may emit an hour worth of output. Don't hold up Close() for it.
+                if (_isStateAtOrBeyond(ConnectionState::Closing))
+                {
+                    return;
+                }
+            }
+        }
+
+        if (!utf8.empty())
+        {
+            THROW_IF_FAILED(til::u8u16(utf8, wide));
+            _TerminalOutputHandlers(wide);
+        }
+    }
+
+    DWORD PlaybackConnection::_OutputThread()
+    {
+        try
+        {
+            _open();
+            _index();
+            _transitionToState(ConnectionState::Connected);
+            _play();
+            return 0;
+        }
+        catch (...)
+        {
+            const auto hr = wil::ResultFromCaughtException();
+            winrt::hstring failureText{ fmt::format(std::wstring_view{ RS_(L"PlaybackFailed") },
+                                                    fmt::format(errorFormat, static_cast<unsigned int>(hr)),
+                                                    _path) };
+            _TerminalOutputHandlers(failureText);
+            _transitionToState(ConnectionState::Failed);
+            return gsl::narrow_cast<DWORD>(hr);
+        }
+    }
+
+    void PlaybackConnection::_play()
+    {
+        auto lock = std::unique_lock{ _mutex };
+        _resetOrigin();
+
+        while (!_isStateAtOrBeyond(ConnectionState::Closing))
+        {
+            auto begin = _position;
+            auto end = _position;
+            auto reset = false;
+
+            if (_pendingSeek != 0)
+            {
+                const auto current = _position ? til::at(_events, _position - 1).time : 0.0;
+                const auto target = current + std::exchange(_pendingSeek, 0.0);
+
+                // All events up to and including the target time have been played after seeking.
+                end = gsl::narrow_cast<size_t>(std::upper_bound(_events.begin(), _events.end(), target, [](double time, const Event& event) { return time < event.time; }) - _events.begin());
+
+                // Going backward requires starting over, and going forward past a checkpoint allows skipping
+                // everything before it. Either way, playback resumes at the checkpoint closest to the target.
+                const auto checkpoint = end ? *(std::upper_bound(_checkpoints.begin(), _checkpoints.end(), end - 1) - 1) : 0;
+                if (end < _position || checkpoint > _position)
+                {
+                    begin = checkpoint;
+                    reset = true;
+                }
+
+                _position = end;
+                _resetOrigin();
+            }
+            else if (_paused || _position >= _events.size())
+            {
+                // Once the recording is over, the tab stays open, so that it can be scrolled and seeked.
+                _cv.wait(lock);
+                continue;
+            }
+            else
+            {
+                const auto now = std::chrono::steady_clock::now();
+
+                if (_speed != 0)
+                {
+                    if (const auto due = _dueTime(til::at(_events, _position).time); due > now)
+                    {
+                        // The wait may end early due to the input changing the playback, which is re-evaluated above.
+                        _cv.wait_until(lock, due);
+                        continue;
+                    }
+                }
+
+                // Coalesce all events that are due into one batch, so that playing at a high speed
+                // (or as fast as possible) doesn't cost one TerminalOutput call per tiny event.
+                size_t length = 0;
+                while (end < _events.size() && length < batchSize && (_speed == 0 || _dueTime(til::at(_events, end).time) <= now))
+                {
+                    length += til::at(_events, end).data.size();
+                    ++end;
+                }
+            }
+
+            _position = end;
+
+            lock.unlock();
+            _emit(begin, end, reset);
+            lock.lock();
+        }
+    }
+}
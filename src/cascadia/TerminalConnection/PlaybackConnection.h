@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "PlaybackConnection.g.h"
+
+#include <mutex>
+#include <condition_variable>
+
+#include "ConnectionStateHolder.h"
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    // Replays asciicast v2 recordings, like the ones written by TerminalApp's SessionRecorder.
+    //
+    // The recording is memory-mapped and indexed once, without decoding any of its output. Playback then
+    // decodes the output and hands it to TerminalOutput in large batches, either as fast as possible
+    // (a speed of 0) or paced by the recorded timestamps, divided by the speed.
+    //
+    // While playing, the input controls the playback:
+    // * Space pauses and resumes.
+    // * + and - double and halve the speed. Speeding up past 64x plays as fast as possible.
+    // * Left and right seek 10 seconds backward and forward.
+    struct PlaybackConnection : PlaybackConnectionT<PlaybackConnection>, ConnectionStateHolder<PlaybackConnection>
+    {
+        static winrt::guid ConnectionType() noexcept;
+        static Windows::Foundation::Collections::ValueSet CreateSettings(const winrt::hstring& path, double speed);
+
+        PlaybackConnection() = default;
+        void Initialize(const Windows::Foundation::Collections::ValueSet& settings);
+
+        void Start();
+        void WriteInput(const hstring& data);
+        void Resize(uint32_t rows, uint32_t columns) noexcept;
+        void Close() noexcept;
+
+        WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+
+    private:
+        struct Event
+        {
+            double time = 0;
+            // The contents of the event's JSON string, still escaped, pointing into _view.
+            std::string_view data;
+        };
+
+        enum class Control
+        {
+            TogglePause,
+            SpeedUp,
+            SlowDown,
+            SeekBackward,
+            SeekForward,
+        };
+
+        DWORD _OutputThread();
+        void _open();
+        void _index();
+        void _play();
+        void _handleKey(wchar_t key) noexcept;
+        void _control(Control control) noexcept;
+        std::chrono::steady_clock::time_point _dueTime(double time) const noexcept;
+        void _resetOrigin() noexcept;
+        void _emit(size_t begin, size_t end, bool reset);
+
+        hstring _path;
+
+        wil::unique_hfile _file;
+        wil::unique_handle _mapping;
+        wil::unique_mapview_ptr<char> _view;
+        std::string_view _contents;
+        wil::unique_handle _hOutputThread;
+
+        // The indexed "o" events and, sorted, the indices of the events that reset or clear the terminal.
+        // Replaying from such a checkpoint looks the same as replaying from the beginning, which is what
+        // seeking does instead of re-parsing everything before it. The first event is always a checkpoint.
+        std::vector<Event> _events;
+        std::vector<size_t> _checkpoints;
+
+        // Everything below is protected by _mutex.
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        double _speed = 1.0;
+        bool _paused = false;
+        double _pendingSeek = 0;
+        // The index of the next event to be played.
+        size_t _position = 0;
+        // Pacing is relative to this point in time, at which playback was at _originTime.
+        std::chrono::steady_clock::time_point _originClock;
+        double _originTime = 0;
+    };
+}
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::factory_implementation
+{
+    BASIC_FACTORY(PlaybackConnection);
+}
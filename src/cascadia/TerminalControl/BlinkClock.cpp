@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "BlinkClock.h"
+
+using namespace winrt::Windows::UI::Xaml;
+
+namespace winrt::Microsoft::Terminal::Control::implementation
+{
+    // There's no reason to keep the clock of a window around that has no TermControls anymore.
+    // The controls (via their subscriptions) hold the strong references.
+    static thread_local std::weak_ptr<BlinkClock> s_currentThreadClock;
+    static thread_local bool s_currentThreadPaused = false;
+
+    BlinkClock::Subscription::Subscription(std::shared_ptr<BlinkClock> clock, std::function<void()> tick, std::function<void()> paused) :
+        _clock{ std::move(clock) },
+        _tick{ std::move(tick) },
+        _paused{ std::move(paused) }
+    {
+    }
+
+    BlinkClock::Subscription::~Subscription()
+    {
+        Stop();
+    }
+
+    void BlinkClock::Subscription::Start()
+    {
+        _started = std::chrono::steady_clock::now();
+        if (!_running)
+        {
+            _running = true;
+            _clock->_add(this);
+        }
+    }
+
+    void BlinkClock::Subscription::Stop()
+    {
+        if (_running)
+        {
+            _running = false;
+            _clock->_remove(this);
+        }
+    }
+
+    // Method Description:
+    // - Returns the clock of the window that the caller's thread belongs to and creates it if needed.
+    // Arguments:
+    // - interval: The time between two ticks, usually GetCaretBlinkTime().
+    std::shared_ptr<BlinkClock> BlinkClock::GetForCurrentThread(const std::chrono::milliseconds interval)
+    {
+        auto clock = s_currentThreadClock.lock();
+        if (!clock)
+        {
+            clock = std::make_shared<BlinkClock>(interval);
+            clock->_paused = s_currentThreadPaused;
+            s_currentThreadClock = clock;
+        }
+        else if (clock->_interval != interval)
+        {
+            // The caret blink time is a system setting and may change at runtime.
+            // Controls that get created afterwards bring the new value along.
+            clock->_interval = interval;
+            clock->_timer.Interval(interval);
+        }
+        return clock;
+    }
+
+    // Method Description:
+    // - Stops (or resumes) all blinking in the window that the caller's thread belongs to.
+    void BlinkClock::PauseForCurrentThread(const bool paused)
+    {
+        s_currentThreadPaused = paused;
+        if (const auto clock = s_currentThreadClock.lock())
+        {
+            clock->_setPaused(paused);
+        }
+    }
+
+    BlinkClock::BlinkClock(const std::chrono::milliseconds interval) :
+        _interval{ interval }
+    {
+        _timer.Interval(interval);
+        _timer.Tick([this](auto&&, auto&&) { _tick(); });
+    }
+
+    void BlinkClock::_add(Subscription* subscription)
+    {
+        _subscriptions.emplace_back(subscription);
+        _update();
+    }
+
+    void BlinkClock::_remove(Subscription* subscription)
+    {
+        const auto it = std::find(_subscriptions.begin(), _subscriptions.end(), subscription);
+        if (it == _subscriptions.end())
+        {
+            return;
+        }
+
+        if (_iterating)
+        {
+            *it = nullptr;
+        }
+        else
+        {
+            _subscriptions.erase(it);
+            _update();
+        }
+    }
+
+    void BlinkClock::_setPaused(const bool paused)
+    {
+        if (_paused == paused)
+        {
+            return;
+        }
+
+        _paused = paused;
+        _update();
+
+        if (paused)
+        {
+            _forEach([](Subscription& s) {
+                if (s._paused)
+                {
+                    s._paused();
+                }
+            });
+        }
+    }
+
+    // Calls func for each subscription, while allowing func to add or remove subscriptions.
+    // Subscriptions added during the iteration aren't visited.
+    template<typename Func>
+    void BlinkClock::_forEach(Func&& func)
+    {
+        _iterating = true;
+        const auto count = _subscriptions.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (const auto s = _subscriptions[i])
+            {
+                func(*s);
+            }
+        }
+        _iterating = false;
+
+        std::erase(_subscriptions, nullptr);
+        _update();
+    }
+
+    // Starts or stops the timer depending on whether anyone is listening.
+    void BlinkClock::_update()
+    {
+        if (!_paused && !_subscriptions.empty())
+        {
+            if (!_timer.IsEnabled())
+            {
+                _timer.Start();
+            }
+        }
+        else
+        {
+            _timer.Stop();
+        }
+    }
+
+    void BlinkClock::_tick()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        // Subscriptions that were (re)started within the last half interval skip this tick,
+        // so that the cursor stays visible for at least that long after a key press.
+        const auto minimumAge = _interval / 2;
+
+        _forEach([&](Subscription& s) {
+            if (now - s._started >= minimumAge)
+            {
+                s._tick();
+            }
+        });
+    }
+}
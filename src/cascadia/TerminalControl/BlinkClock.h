@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// Module Name:
+// - BlinkClock.h
+//
+// Abstract:
+// - A single timer per window, which drives the blinking cursor and the
+//   blinking text attributes of all of the TermControls in it. Since every
+//   window has its own UI thread, there's one clock per thread. Compared
+//   to giving each control its own timers, this avoids waking up the UI
+//   thread at a different time for each pane and keeps them in phase.
+// - The clock only runs while it has subscriptions, and is paused entirely
+//   while the window is inactive or hidden (see TermControl::PauseAnimations).
+//
+
+#pragma once
+
+namespace winrt::Microsoft::Terminal::Control::implementation
+{
+    class BlinkClock
+    {
+    public:
+        // A control's registration with the clock. Start() and Stop() behave like
+        // they do for a DispatcherTimer with the clock's interval.
+        class Subscription
+        {
+        public:
+            // `paused` is called instead of `tick` when the clock gets paused
+            // while the subscription is running. It may be empty.
+            Subscription(std::shared_ptr<BlinkClock> clock, std::function<void()> tick, std::function<void()> paused = {});
+            ~Subscription();
+
+            Subscription(const Subscription&) = delete;
+            Subscription& operator=(const Subscription&) = delete;
+
+            // (Re)starts the subscription. Just like restarting a DispatcherTimer,
+            // this delays the next tick, which prevents the cursor from flickering.
+            void Start();
+            void Stop();
+
+        private:
+            friend class BlinkClock;
+
+            std::shared_ptr<BlinkClock> _clock;
+            std::function<void()> _tick;
+            std::function<void()> _paused;
+            std::chrono::steady_clock::time_point _started;
+            bool _running = false;
+        };
+
+        static std::shared_ptr<BlinkClock> GetForCurrentThread(std::chrono::milliseconds interval);
+        static void PauseForCurrentThread(bool paused);
+
+        explicit BlinkClock(std::chrono::milliseconds interval);
+
+    private:
+        void _add(Subscription* subscription);
+        void _remove(Subscription* subscription);
+        void _setPaused(bool paused);
+        void _update();
+        void _tick();
+        template<typename Func>
+        void _forEach(Func&& func);
+
+        Windows::UI::Xaml::DispatcherTimer _timer;
+        std::chrono::milliseconds _interval;
+        // Entries are null while _forEach() runs if they got removed during a callback.
+        std::vector<Subscription*> _subscriptions;
+        bool _iterating = false;
+        bool _paused = false;
+    };
+}
@@ -18,6 +18,7 @@
 #include "../../buffer/out/search.h"
 #include "../../renderer/atlas/AtlasEngine.h"
 #include "../../renderer/dx/DxRenderer.hpp"
+#include "../TerminalCore/tracing.hpp"
 
 #include "ControlCore.g.cpp"
 #include "SelectionColor.g.cpp"
@@ -33,12 +34,89 @@ using namespace winrt::Windows::ApplicationModel::DataTransfer;
 // The updates are throttled to limit power usage.
 constexpr const auto ScrollBarUpdateInterval = std::chrono::milliseconds(8);
 
+// The minimum delay between two mouse motion reports. High polling rate mice produce
+// far more pointer events than there are frames, and every report is sent to the client.
+constexpr const auto MouseMotionReportInterval = std::chrono::milliseconds(8);
+
 // The minimum delay between updating the TSF input control.
 constexpr const auto TsfRedrawInterval = std::chrono::milliseconds(100);
 
 // The minimum delay between updating the locations of regex patterns
 constexpr const auto UpdatePatternLocationsInterval = std::chrono::milliseconds(500);
 
+// The maximum delay and amount of text that's coalesced before it's written to the
+// terminal, while the terminal lock is held by someone else. This allows us to acquire
+// the lock once for many small writes, as produced by spinners and progress bars.
+constexpr const auto OutputCoalesceInterval = std::chrono::milliseconds(1);
+constexpr const size_t OutputCoalesceLimit = 64 * 1024;
+
+// The output governor measures the throughput of the connection over windows of this length.
+// See ControlCore::_governOutput().
+constexpr const auto OutputGovernorWindow = std::chrono::milliseconds(250);
+
+// A resize is considered to have settled once the size hasn't changed for this long.
+// Until then only the rows around the viewport get reflowed. See Terminal::LiveResize().
+constexpr const auto LiveResizeSettleInterval = std::chrono::milliseconds(200);
+
+// The minimum delay between two resizes of the connection. Dragging the window
+// border resizes the control many times per frame and every single resize makes
+// conpty reflow its buffer and repaint everything. Only the latest size is sent.
+constexpr const auto ConnectionResizeInterval = std::chrono::milliseconds(16);
+
+// The background search holds the terminal lock for at most this long per slice of
+// SearchSliceRows rows, so that neither output nor input get blocked while it runs.
+constexpr const auto SearchSliceDuration = std::chrono::milliseconds(4);
+constexpr const auto SearchSliceInterval = std::chrono::milliseconds(1);
+constexpr const til::CoordType SearchSliceRows = 256;
+
+// The minimum delay between two updates of the search box's match count, while a search is running.
+constexpr const auto SearchStatusUpdateInterval = std::chrono::milliseconds(50);
+
+// The minimum delay between two title or taskbar progress updates. Prompts and progress bars
+// may change these hundreds of times per second, but the tab only needs the latest state per frame.
+constexpr const auto TitleAndProgressUpdateInterval = std::chrono::milliseconds(16);
+
+// The minimum delay between two font size changes while zooming. Each one recreates the renderer's
+// font resources and glyph atlas, and resizes the buffer. In between, the last frame is shown scaled.
+constexpr const auto FontSizeZoomInterval = std::chrono::milliseconds(100);
+
+// How much later than their interval the timers of the throttled functions that only update the UI may fire.
+// This lets the OS wake the CPU just once for the timers of all panes, which adds up with many panes open.
+// The output, input, resize and search slice timers don't use it, as their latency is noticeable.
+constexpr const auto UiTimerSlack = std::chrono::milliseconds(4);
+
+// Returns true if the system signaled that it's running low on physical memory.
+static bool isLowOnMemory() noexcept
+{
+    static const wil::unique_handle notification{ CreateMemoryResourceNotification(LowMemoryResourceNotification) };
+    auto low = FALSE;
+    return notification && QueryMemoryResourceNotification(notification.get(), &low) && low;
+}
+
+// Returns true if both maps contain the same key/value pairs. A null map is equal to an empty one.
+template<typename K, typename V>
+static bool mapsEqual(const winrt::Windows::Foundation::Collections::IMap<K, V>& lhs, const winrt::Windows::Foundation::Collections::IMap<K, V>& rhs)
+{
+    const auto lhsSize = lhs ? lhs.Size() : 0;
+    const auto rhsSize = rhs ? rhs.Size() : 0;
+    if (lhsSize != rhsSize)
+    {
+        return false;
+    }
+    if (lhsSize == 0)
+    {
+        return true;
+    }
+    for (const auto& [key, value] : lhs)
+    {
+        if (!rhs.HasKey(key) || rhs.Lookup(key) != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 namespace winrt::Microsoft::Terminal::Control::implementation
 {
     static winrt::Microsoft::Terminal::Core::OptionalColor OptionalFromColor(const til::color& c)
@@ -84,6 +162,49 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _settings = winrt::make_self<implementation::ControlSettings>(settings, unfocusedAppearance);
         _terminal = std::make_shared<::Microsoft::Terminal::Core::Terminal>();
 
+        // This doesn't depend on the dispatcher, unlike the throttled functions in
+        // _setupDispatcherAndCallbacks(), and so it doesn't need to be recreated in AttachToNewControl().
+        _flushPendingOutput = std::make_unique<til::throttled_func_trailing<>>(
+            OutputCoalesceInterval,
+            [this]() {
+                _writePendingOutput(_terminal->LockForWriting());
+            });
+
+        _finishLiveResize = std::make_unique<til::throttled_func_trailing<>>(
+            LiveResizeSettleInterval,
+            [this]() {
+                const auto lock = _terminal->LockForWriting();
+                // The throttled function runs at most once per interval, but we want to wait until
+                // the resize is done. If it isn't, check again once the interval has passed again.
+                if (std::chrono::steady_clock::now() - _lastLiveResize < LiveResizeSettleInterval)
+                {
+                    (*_finishLiveResize)();
+                    return;
+                }
+                _terminal->FinishLiveResize();
+                _searchStale = true;
+                _restartBackgroundSearch();
+            });
+
+        _searchSlice = std::make_unique<til::throttled_func_trailing<>>(
+            SearchSliceInterval,
+            [this]() {
+                _searchNextSlice();
+            });
+
+        // Re-evaluates the throughput while the governor is engaged, as otherwise
+        // nobody would disengage it once the connection stopped writing.
+        _outputGovernorCheck = std::make_unique<til::throttled_func_trailing<>>(
+            OutputGovernorWindow,
+            [this]() {
+                try
+                {
+                    const auto lock = _terminal->LockForWriting();
+                    _governOutput(0);
+                }
+                CATCH_LOG();
+            });
+
         _setupDispatcherAndCallbacks();
 
         Connection(connection);
@@ -129,7 +250,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             // to paint itself *after* we hand off its ownership to the renderer.
             // We split up construction and initialization of the render thread object this way
             // because the renderer and render thread have circular references to each other.
-            auto renderThread = std::make_unique<::Microsoft::Console::Render::RenderThread>();
+            // All controls created on the same thread (= in the same window) share a single
+            // thread for rendering, which paints all of their frames in one go.
+            auto renderThread = std::make_unique<::Microsoft::Console::Render::RenderThread>(::Microsoft::Console::Render::SharedRenderThread::GetForCurrentThread());
             auto* const localPointerToThread = renderThread.get();
 
             // Now create the renderer and initialize the render thread.
@@ -139,6 +262,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             _renderer->SetBackgroundColorChangedCallback([this]() { _rendererBackgroundColorChanged(); });
             _renderer->SetFrameColorChangedCallback([this]() { _rendererTabColorChanged(); });
             _renderer->SetRendererEnteredErrorStateCallback([this]() { _RendererEnteredErrorStateHandlers(nullptr, nullptr); });
+            _renderer->SetInputLatencyCallback([](const std::chrono::microseconds latency) {
+                // Each sample is logged individually, so that a trace can be turned into a histogram.
+                TraceLoggingWrite(
+                    g_hCTerminalCoreProvider,
+                    "InputLatency",
+                    TraceLoggingDescription("The time from sending a key press until a frame with its echo was presented"),
+                    TraceLoggingUInt64(gsl::narrow_cast<uint64_t>(latency.count()), "LatencyMicroseconds"),
+                    TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                    TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+            });
 
             THROW_IF_FAILED(localPointerToThread->Initialize(_renderer.get()));
         }
@@ -146,6 +279,24 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         UpdateSettings(settings, unfocusedAppearance);
     }
 
+    // Method Description:
+    // - Prepares a core that was constructed ahead of time (see ContentManager::Prewarm)
+    //   for the given settings and connection, as if they had been passed to the constructor.
+    // - This may only be called before the core has been initialized.
+    void ControlCore::Recycle(const Control::IControlSettings& settings,
+                              const IControlAppearance& unfocusedAppearance,
+                              const TerminalConnection::ITerminalConnection& connection)
+    {
+        assert(!_initializedTerminal.load(std::memory_order_relaxed));
+
+        Connection(connection);
+        UpdateSettings(settings, unfocusedAppearance);
+
+        const auto lock = _terminal->LockForWriting();
+        // GH#8969: pre-seed working directory to prevent potential races
+        _terminal->SetWorkingDirectory(_settings->StartingDirectory());
+    }
+
     void ControlCore::_setupDispatcherAndCallbacks()
     {
         // Get our dispatcher. If we're hosted in-proc with XAML, this will get
@@ -173,6 +324,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         //   need to hop across the process boundary every time text is output.
         //   We can throttle this to once every 8ms, which will get us out of
         //   the way of the main output & rendering threads.
+        // * _updateSearchStatus: The background search reports its progress
+        //   after every slice, but the search box only needs a few updates.
+        // * _resizeConnection: While the window is being resized, the connection
+        //   only needs to know about the size it ends up with.
+        // * _updateTitle, _updateTaskbarProgress: Every update re-lays out the
+        //   tab header or the taskbar button, so only the latest one per frame is raised.
+        // * _applyPendingFontSize: Ctrl+scroll zooming changes the font size in many
+        //   small steps, but the expensive font update only needs to happen for the latest.
         const auto shared = _shared.lock();
         shared->tsfTryRedrawCanvas = std::make_shared<ThrottledFuncTrailing<>>(
             _dispatcher,
@@ -182,7 +341,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 {
                     core->_CursorPositionChangedHandlers(*core, nullptr);
                 }
-            });
+            },
+            UiTimerSlack);
 
         // NOTE: Calling UpdatePatternLocations from a background
         // thread is a workaround for us to hit GH#12607 less often.
@@ -194,7 +354,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                     auto lock = t->LockForWriting();
                     t->UpdatePatternsUnderLock();
                 }
-            });
+            },
+            UiTimerSlack);
 
         shared->updateScrollBar = std::make_shared<ThrottledFuncTrailing<Control::ScrollPositionChangedArgs>>(
             _dispatcher,
@@ -204,6 +365,70 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 {
                     core->_ScrollPositionChangedHandlers(*core, update);
                 }
+            },
+            UiTimerSlack);
+
+        shared->updateSearchStatus = std::make_shared<ThrottledFuncTrailing<Control::FoundResultsArgs>>(
+            _dispatcher,
+            SearchStatusUpdateInterval,
+            [weakThis = get_weak()](const auto& update) {
+                if (auto core{ weakThis.get() }; !core->_IsClosing())
+                {
+                    core->_FoundMatchHandlers(*core, update);
+                }
+            },
+            UiTimerSlack);
+
+        shared->flushMouseMotion = std::make_shared<ThrottledFuncTrailing<>>(
+            _dispatcher,
+            MouseMotionReportInterval,
+            [weakThis = get_weak()]() {
+                if (auto core{ weakThis.get() }; !core->_IsClosing())
+                {
+                    core->_sendPendingMouseMotion();
+                }
+            });
+
+        shared->resizeConnection = std::make_shared<ThrottledFuncTrailing<til::CoordType, til::CoordType>>(
+            _dispatcher,
+            ConnectionResizeInterval,
+            [weakThis = get_weak()](const til::CoordType rows, const til::CoordType columns) {
+                if (auto core{ weakThis.get() }; !core->_IsClosing() && core->_connection)
+                {
+                    core->_connection.Resize(rows, columns);
+                }
+            });
+
+        shared->updateTitle = std::make_shared<ThrottledFuncTrailing<winrt::hstring>>(
+            _dispatcher,
+            TitleAndProgressUpdateInterval,
+            [weakThis = get_weak()](const winrt::hstring& title) {
+                if (auto core{ weakThis.get() }; !core->_IsClosing())
+                {
+                    core->_raiseTitleChanged(title);
+                }
+            },
+            UiTimerSlack);
+
+        shared->updateTaskbarProgress = std::make_shared<ThrottledFuncTrailing<size_t, size_t>>(
+            _dispatcher,
+            TitleAndProgressUpdateInterval,
+            [weakThis = get_weak()](const size_t state, const size_t progress) {
+                if (auto core{ weakThis.get() }; !core->_IsClosing())
+                {
+                    core->_raiseTaskbarProgressChanged(state, progress);
+                }
+            },
+            UiTimerSlack);
+
+        shared->applyPendingFontSize = std::make_shared<ThrottledFuncTrailing<>>(
+            _dispatcher,
+            FontSizeZoomInterval,
+            [weakThis = get_weak()]() {
+                if (auto core{ weakThis.get() }; !core->_IsClosing())
+                {
+                    core->_applyPendingFontSize();
+                }
             });
     }
 
@@ -211,6 +436,13 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         Close();
 
+        // Close() ensured that the connection won't call us anymore. Now wait for
+        // any pending flush, before the _terminal it refers to gets destroyed.
+        _flushPendingOutput.reset();
+        _finishLiveResize.reset();
+        _searchSlice.reset();
+        _outputGovernorCheck.reset();
+
         if (_renderer)
         {
             _renderer->TriggerTeardown();
@@ -230,6 +462,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         shared->tsfTryRedrawCanvas.reset();
         shared->updatePatternLocations.reset();
         shared->updateScrollBar.reset();
+        shared->updateSearchStatus.reset();
+        shared->flushMouseMotion.reset();
+        shared->resizeConnection.reset();
+        shared->updateTitle.reset();
+        shared->updateTaskbarProgress.reset();
+        shared->applyPendingFontSize.reset();
+        _pendingMouseMotion.reset();
+        _pendingFontSize.reset();
     }
 
     void ControlCore::AttachToNewControl(const Microsoft::Terminal::Control::IKeyBindings& keyBindings)
@@ -373,6 +613,13 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             _terminal->CreateFromSettings(*_settings, *_renderer);
 
+            // Restore the snapshot before the connection starts, as its output is supposed to follow the snapshot.
+            if (!_restorePath.empty())
+            {
+                _restoreFromPath(_restorePath.c_str());
+                _restorePath.clear();
+            }
+
             // IMPORTANT! Set this callback up sooner than later. If we do it
             // after Enable, then it'll be possible to paint the frame once
             // _before_ the warning handler is set up, and then warnings from
@@ -388,10 +635,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             _renderEngine->SetRetroTerminalEffect(_settings->RetroTerminalEffect());
             _renderEngine->SetPixelShaderPath(_settings->PixelShaderPath());
+            _renderEngine->SetPixelShaderFrameRate(_settings->PixelShaderFrameRate());
             _renderEngine->SetForceFullRepaintRendering(_settings->ForceFullRepaintRendering());
             _renderEngine->SetSoftwareRendering(_settings->SoftwareRendering());
+            _renderEngine->SetPreferLowPowerAdapter(_settings->PreferLowPowerAdapter());
+            _renderEngine->SetMonitorHwnd(reinterpret_cast<HWND>(_owningHwnd));
 
             _updateAntiAliasingMode();
+            _updatePacingMode();
+            _renderer->SetSmoothScrolling(_settings->SmoothScrolling());
 
             // GH#5098: Inform the engine of the opacity of the default text background.
             // GH#11315: Always do this, even if they don't have acrylic on.
@@ -440,6 +692,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
         else
         {
+            if (_keyTimestamp && _renderer)
+            {
+                _renderer->GetPerfCounters().InputSent(*_keyTimestamp);
+            }
             _connection.WriteInput(wstr);
         }
     }
@@ -462,6 +718,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         const wchar_t CtrlD = 0x4;
         const wchar_t Enter = '\r';
 
+        _keyTimestamp = std::chrono::steady_clock::now();
+        const auto resetKeyTimestamp = wil::scope_exit([&]() noexcept { _keyTimestamp.reset(); });
+
         if (_connection.State() >= winrt::Microsoft::Terminal::TerminalConnection::ConnectionState::Closed)
         {
             if (ch == CtrlD)
@@ -539,16 +798,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             else if (vkey == VK_RETURN && mods.IsCtrlPressed() && !mods.IsAltPressed() && !mods.IsShiftPressed())
             {
                 // Ctrl + Enter --> Open URL
-                auto lock = _terminal->LockForReading();
-                if (const auto uri = _terminal->GetHyperlinkAtBufferPosition(_terminal->GetSelectionAnchor()); !uri.empty())
-                {
-                    _OpenHyperlinkHandlers(*this, winrt::make<OpenHyperlinkEventArgs>(winrt::hstring{ uri }));
-                }
-                else
+                // The handlers are raised outside of the lock, as a reader mustn't lock for writing.
+                std::wstring target;
                 {
-                    const auto selectedText = _terminal->GetTextBuffer().GetPlainText(_terminal->GetSelectionAnchor(), _terminal->GetSelectionEnd());
-                    _OpenHyperlinkHandlers(*this, winrt::make<OpenHyperlinkEventArgs>(winrt::hstring{ selectedText }));
+                    auto lock = _terminal->LockForReading();
+                    target = _terminal->GetHyperlinkAtBufferPosition(_terminal->GetSelectionAnchor());
+                    if (target.empty())
+                    {
+                        target = _terminal->GetTextBuffer().GetPlainText(_terminal->GetSelectionAnchor(), _terminal->GetSelectionEnd());
+                    }
                 }
+                _OpenHyperlinkHandlers(*this, winrt::make<OpenHyperlinkEventArgs>(winrt::hstring{ target }));
                 return true;
             }
             else if (vkey == VK_RETURN && !mods.IsCtrlPressed() && !mods.IsAltPressed())
@@ -624,6 +884,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             }
         }
 
+        if (keyDown)
+        {
+            _keyTimestamp = std::chrono::steady_clock::now();
+        }
+        const auto resetKeyTimestamp = wil::scope_exit([&]() noexcept { _keyTimestamp.reset(); });
+
         // If the terminal translated the key, mark the event as handled.
         // This will prevent the system from trying to get the character out
         // of it and sending us a CharacterReceived event.
@@ -640,9 +906,52 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                      const short wheelDelta,
                                      const TerminalInput::MouseButtonState state)
     {
+        // Mouse motion is reported at most once every MouseMotionReportInterval.
+        // Any motion in between is deferred until the interval has passed and
+        // only the most recent one is sent. Other events are never deferred,
+        // but the deferred motion must be sent before them to preserve the order.
+        if (uiButton == WM_MOUSEMOVE && !_inUnitTests)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - _lastMouseMotion < MouseMotionReportInterval)
+            {
+                const auto shared = _shared.lock_shared();
+                if (shared->flushMouseMotion)
+                {
+                    _pendingMouseMotion = PendingMouseMotion{ viewportPos, states, state };
+                    shared->flushMouseMotion->Run();
+                    return _terminal->IsTrackingMouseInput();
+                }
+            }
+
+            _pendingMouseMotion.reset();
+            // Motion that didn't result in a report (for instance because it
+            // didn't leave the current cell) doesn't count against the budget.
+            const auto handled = _terminal->SendMouseEvent(viewportPos, uiButton, states, wheelDelta, state);
+            if (handled)
+            {
+                _lastMouseMotion = now;
+            }
+            return handled;
+        }
+
+        _sendPendingMouseMotion();
         return _terminal->SendMouseEvent(viewportPos, uiButton, states, wheelDelta, state);
     }
 
+    void ControlCore::_sendPendingMouseMotion()
+    {
+        if (_pendingMouseMotion)
+        {
+            const auto motion = *_pendingMouseMotion;
+            _pendingMouseMotion.reset();
+            if (_terminal->SendMouseEvent(motion.viewportPos, WM_MOUSEMOVE, motion.states, 0, motion.state))
+            {
+                _lastMouseMotion = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
     void ControlCore::UserScrollViewport(const int viewTop)
     {
         // Clear the regex pattern tree so the renderer does not try to render them while scrolling
@@ -659,6 +968,23 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    bool ControlCore::SmoothScrolling() const
+    {
+        return _settings->SmoothScrolling();
+    }
+
+    // Method Description:
+    // - Sets the fraction of a row by which the viewport is scrolled past the row
+    //   given to the last UserScrollViewport() call. This is only drawn by the
+    //   renderer if the "experimental.rendering.smoothScrolling" setting is enabled.
+    // Arguments:
+    // - rows: the offset in rows, in the range [0, 1).
+    void ControlCore::SetSmoothScrollOffset(const float rows)
+    {
+        const auto lock = _terminal->LockForWriting();
+        _renderer->SetSmoothScrollOffset(rows);
+    }
+
     void ControlCore::AdjustOpacity(const double adjustment)
     {
         if (adjustment == 0)
@@ -720,6 +1046,45 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _renderer->TriggerRedrawAll();
     }
 
+    // Method Description:
+    // - Shows or hides the engine's debug overlay with the rates of the counters
+    //   returned by GetPerfCounters(). Only the AtlasEngine implements one.
+    void ControlCore::TogglePerfOverlay()
+    {
+        if (!_renderEngine)
+        {
+            return;
+        }
+
+        auto lock = _terminal->LockForWriting();
+        _renderEngine->SetPerfOverlay(!_renderEngine->GetPerfOverlay());
+        _renderer->TriggerRedrawAll();
+    }
+
+    // Method Description:
+    // - Returns the counters for this control's output pipeline, from parsing
+    //   the connection's output to presenting frames.
+    Control::PerfCounters ControlCore::GetPerfCounters() const noexcept
+    {
+        if (!_renderer)
+        {
+            return {};
+        }
+
+        const auto snapshot = _renderer->GetPerfCounters().Take();
+        return {
+            .ParsedBytes = snapshot.parsedBytes,
+            .RowsWritten = snapshot.rowsWritten,
+            .Frames = snapshot.frames,
+            .PaintMicroseconds = snapshot.paintMicroseconds,
+            .RenderMicroseconds = snapshot.renderMicroseconds,
+            .ShapingMicroseconds = snapshot.shapingMicroseconds,
+            .AtlasMisses = snapshot.atlasMisses,
+            .InputLatencies = snapshot.inputLatencies,
+            .InputLatencyMicroseconds = snapshot.inputLatencyMicroseconds,
+        };
+    }
+
     // Method description:
     // - Updates last hovered cell, renders / removes rendering of hyper-link if required
     // Arguments:
@@ -806,7 +1171,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - INVARIANT: This method can only be called if the caller DOES NOT HAVE writing lock on the terminal.
     void ControlCore::UpdateSettings(const IControlSettings& settings, const IControlAppearance& newAppearance)
     {
-        _settings = winrt::make_self<implementation::ControlSettings>(settings, newAppearance);
+        const auto previousSettings = std::exchange(_settings, winrt::make_self<implementation::ControlSettings>(settings, newAppearance));
 
         auto lock = _terminal->LockForWriting();
 
@@ -817,7 +1182,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // Manually turn off acrylic if they turn off transparency.
         _runtimeUseAcrylic = _settings->Opacity() < 1.0 && _settings->UseAcrylic();
 
-        const auto sizeChanged = _setFontSizeUnderLock(_settings->FontSize());
+        // Reloading the settings pushes them into every control, even if only
+        // an unrelated setting changed. Recreating the font is the most expensive
+        // part of this, so skip it if none of the font settings changed.
+        // Comparing against _desiredFont also catches a runtime font size change.
+        auto sizeChanged = false;
+        if (_fontSettingsChanged(previousSettings.get()))
+        {
+            sizeChanged = _setFontSizeUnderLock(_settings->FontSize());
+        }
 
         // Update the terminal core with its new Core settings
         _terminal->UpdateSettings(*_settings);
@@ -831,6 +1204,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         _renderEngine->SetForceFullRepaintRendering(_settings->ForceFullRepaintRendering());
         _renderEngine->SetSoftwareRendering(_settings->SoftwareRendering());
+        _renderEngine->SetPreferLowPowerAdapter(_settings->PreferLowPowerAdapter());
+        _renderEngine->SetPixelShaderFrameRate(_settings->PixelShaderFrameRate());
         // Inform the renderer of our opacity
         _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
 
@@ -838,6 +1213,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _renderer->TriggerRedrawAll(true, true);
 
         _updateAntiAliasingMode();
+        _updatePacingMode();
+        _renderer->SetSmoothScrolling(_settings->SmoothScrolling());
 
         if (sizeChanged)
         {
@@ -886,6 +1263,19 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _renderEngine->SetAntialiasingMode(mode);
     }
 
+    void ControlCore::_updatePacingMode()
+    {
+        using ::Microsoft::Console::Render::PacingMode;
+        _outputGovernorThreshold.store(std::max(0, _settings->OutputGovernorThreshold()), std::memory_order_relaxed);
+
+        auto mode = _settings->PacingMode() == RenderPacingMode::Throughput ? PacingMode::Throughput : PacingMode::LowLatency;
+        if (_outputGoverned.load(std::memory_order_relaxed))
+        {
+            mode = PacingMode::Throttled;
+        }
+        _renderer->SetPacingMode(mode);
+    }
+
     // Method Description:
     // - Update the font with the renderer. This will be called either when the
     //      font changes or the DPI changes, as DPI changes will necessitate a
@@ -947,6 +1337,27 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _FontSizeChangedHandlers(actualNewSize.width, actualNewSize.height, initialUpdate);
     }
 
+    // Method Description:
+    // - Returns true if the current _settings require the font to be updated,
+    //   compared to the given previous settings and the current _desiredFont.
+    // Arguments:
+    // - previousSettings: the settings that were in use before, if any.
+    bool ControlCore::_fontSettingsChanged(const implementation::ControlSettings* previousSettings) const
+    {
+        if (!previousSettings || !_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+
+        return _desiredFont.GetFontSize() != std::max(_settings->FontSize(), 1.0f) ||
+               std::wstring_view{ _desiredFont.GetFaceName() } != std::wstring_view{ _settings->FontFace() } ||
+               _desiredFont.GetWeight() != _settings->FontWeight().Weight ||
+               previousSettings->CellWidth() != _settings->CellWidth() ||
+               previousSettings->CellHeight() != _settings->CellHeight() ||
+               !mapsEqual(previousSettings->FontFeatures(), _settings->FontFeatures()) ||
+               !mapsEqual(previousSettings->FontAxes(), _settings->FontAxes());
+    }
+
     // Method Description:
     // - Set the font size of the terminal control.
     // Arguments:
@@ -955,6 +1366,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - Returns true if you need to call _refreshSizeUnderLock().
     bool ControlCore::_setFontSizeUnderLock(float fontSize)
     {
+        // Any zoom that's still pending is superseded by this font size.
+        _pendingFontSize.reset();
+
         // Make sure we have a non-zero font size
         const auto newSize = std::max(fontSize, 1.0f);
         const auto fontFace = _settings->FontFace();
@@ -989,8 +1403,34 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - Adjust the font size of the terminal control.
     // Arguments:
     // - fontSizeDelta: The amount to increase or decrease the font size by.
+    // - While zooming, the new font size is only applied once per FontSizeZoomInterval.
+    //   Until then, FontSizePreviewChanged allows the control to show the last frame
+    //   scaled to the pending font size. See FontSizePreviewScale().
     void ControlCore::AdjustFontSize(float fontSizeDelta)
     {
+        if (!_inUnitTests)
+        {
+            std::shared_ptr<ThrottledFuncTrailing<>> applyPendingFontSize;
+            {
+                const auto shared = _shared.lock_shared();
+                applyPendingFontSize = shared->applyPendingFontSize;
+            }
+
+            if (applyPendingFontSize)
+            {
+                auto fontSize = _pendingFontSize.value_or(0.0f);
+                if (!_pendingFontSize)
+                {
+                    const auto lock = _terminal->LockForReading();
+                    fontSize = _desiredFont.GetFontSize();
+                }
+                _pendingFontSize = std::max(fontSize + fontSizeDelta, 1.0f);
+                applyPendingFontSize->Run();
+                _FontSizePreviewChangedHandlers(*this, nullptr);
+                return;
+            }
+        }
+
         const auto lock = _terminal->LockForWriting();
 
         if (_setFontSizeUnderLock(_desiredFont.GetFontSize() + fontSizeDelta))
@@ -999,6 +1439,38 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Method Description:
+    // - Applies the font size that AdjustFontSize() accumulated while zooming.
+    void ControlCore::_applyPendingFontSize()
+    {
+        if (!_pendingFontSize)
+        {
+            return;
+        }
+
+        const auto lock = _terminal->LockForWriting();
+
+        if (_setFontSizeUnderLock(*_pendingFontSize))
+        {
+            _refreshSizeUnderLock();
+        }
+    }
+
+    // Method Description:
+    // - Returns how much the last frame should be scaled by, to approximate
+    //   the font size that AdjustFontSize() will apply shortly. This is 1
+    //   when no zoom is pending. Only valid on the UI thread.
+    float ControlCore::FontSizePreviewScale()
+    {
+        if (!_pendingFontSize)
+        {
+            return 1.0f;
+        }
+
+        const auto lock = _terminal->LockForReading();
+        return *_pendingFontSize / _desiredFont.GetFontSize();
+    }
+
     // Method Description:
     // - Process a resize event that was initiated by the user. This can either
     //   be due to the user resizing the window (causing the swapchain to
@@ -1041,11 +1513,38 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         // If this function succeeds with S_FALSE, then the terminal didn't
         // actually change size. No need to notify the connection of this no-op.
-        const auto hr = _terminal->UserResize({ vp.Width(), vp.Height() });
+        const auto hr = _terminal->LiveResize({ vp.Width(), vp.Height() });
         if (SUCCEEDED(hr) && hr != S_FALSE)
         {
-            _connection.Resize(vp.Height(), vp.Width());
+            _resizeConnection(vp.Height(), vp.Width());
+
+            _searchStale = true;
+            _restartBackgroundSearch();
+            _lastLiveResize = std::chrono::steady_clock::now();
+            (*_finishLiveResize)();
+        }
+    }
+
+    // Method Description:
+    // - Tells the connection about the new size of the terminal. While the
+    //   size changes rapidly, only the latest one is sent, once per
+    //   ConnectionResizeInterval. See _setupDispatcherAndCallbacks.
+    // Arguments:
+    // - rows: The new height of the terminal in rows.
+    // - columns: The new width of the terminal in columns.
+    void ControlCore::_resizeConnection(const til::CoordType rows, const til::CoordType columns)
+    {
+        if (!_inUnitTests)
+        {
+            const auto shared = _shared.lock_shared();
+            if (shared->resizeConnection)
+            {
+                shared->resizeConnection->Run(rows, columns);
+                return;
+            }
         }
+
+        _connection.Resize(rows, columns);
     }
 
     void ControlCore::SizeChanged(const float width,
@@ -1166,9 +1665,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             return false;
         }
 
+        const auto copyHtml = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML);
+        const auto copyRtf = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF);
+
         // extract text from buffer
         // RetrieveSelectedTextFromBuffer will lock while it's reading
-        const auto bufferData = _terminal->RetrieveSelectedTextFromBuffer(singleLine);
+        const auto bufferData = _terminal->RetrieveSelectedTextFromBuffer(singleLine, copyHtml || copyRtf);
 
         // convert text: vector<string> --> string
         std::wstring textData;
@@ -1183,7 +1685,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // GH#5347 - Don't provide a title for the generated HTML, as many
         // web applications will paste the title first, followed by the HTML
         // content, which is unexpected.
-        const auto htmlData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML) ?
+        const auto htmlData = copyHtml ?
                                   TextBuffer::GenHTML(bufferData,
                                                       _actualFont.GetUnscaledSize().height,
                                                       _actualFont.GetFaceName(),
@@ -1191,7 +1693,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                   "";
 
         // convert to RTF format
-        const auto rtfData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF) ?
+        const auto rtfData = copyRtf ?
                                  TextBuffer::GenRTF(bufferData,
                                                     _actualFont.GetUnscaledSize().height,
                                                     _actualFont.GetFaceName(),
@@ -1414,7 +1916,38 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // Since this can only ever be triggered by output from the connection,
         // then the Terminal already has the write lock when calling this
         // callback.
-        _TitleChangedHandlers(*this, winrt::make<TitleChangedEventArgs>(winrt::hstring{ wstr }));
+        winrt::hstring title{ wstr };
+
+        if (_inUnitTests) [[unlikely]]
+        {
+            _raiseTitleChanged(title);
+        }
+        else
+        {
+            const auto shared = _shared.lock_shared();
+            if (shared->updateTitle)
+            {
+                shared->updateTitle->Run(std::move(title));
+            }
+        }
+    }
+
+    // Method Description:
+    // - Raises the TitleChanged event for the latest title, unless it's
+    //   the title we raised it for the last time already.
+    // Arguments:
+    // - title: the new title of this terminal.
+    // Return Value:
+    // - <none>
+    void ControlCore::_raiseTitleChanged(const winrt::hstring& title)
+    {
+        if (title == _lastRaisedTitle)
+        {
+            return;
+        }
+
+        _lastRaisedTitle = title;
+        _TitleChangedHandlers(*this, winrt::make<TitleChangedEventArgs>(title));
     }
 
     // Method Description:
@@ -1442,6 +1975,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // TODO GH#9617: refine locking around pattern tree
         _terminal->ClearPatternTree();
 
+        // The terminal moved the viewport on its own, for instance to follow new output.
+        // Any remaining smooth scrolling offset would leave the viewport between two rows.
+        _renderer->SetSmoothScrollOffset(0);
+
         // Start the throttled update of our scrollbar.
         auto update{ winrt::make<ScrollPositionChangedArgs>(viewTop,
                                                             viewHeight,
@@ -1474,6 +2011,34 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     void ControlCore::_terminalTaskbarProgressChanged()
     {
+        // Like the title, this is only ever triggered by output
+        // from the connection, while we hold the write lock.
+        const auto state = _terminal->GetTaskbarState();
+        const auto progress = _terminal->GetTaskbarProgress();
+
+        if (_inUnitTests) [[unlikely]]
+        {
+            _raiseTaskbarProgressChanged(state, progress);
+        }
+        else
+        {
+            const auto shared = _shared.lock_shared();
+            if (shared->updateTaskbarProgress)
+            {
+                shared->updateTaskbarProgress->Run(state, progress);
+            }
+        }
+    }
+
+    void ControlCore::_raiseTaskbarProgressChanged(const size_t state, const size_t progress)
+    {
+        if (state == _lastRaisedTaskbarState && progress == _lastRaisedTaskbarProgress)
+        {
+            return;
+        }
+
+        _lastRaisedTaskbarState = state;
+        _lastRaisedTaskbarProgress = progress;
         _TaskbarProgressChangedHandlers(*this, nullptr);
     }
 
@@ -1484,17 +2049,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     }
 
     // Method Description:
-    // - Plays a single MIDI note, blocking for the duration.
+    // - Queues a single MIDI note, which is played after all previously queued ones.
     // Arguments:
     // - noteNumber - The MIDI note number to be played (0 - 127).
     // - velocity - The force with which the note should be played (0 - 127).
     // - duration - How long the note should be sustained (in microseconds).
     void ControlCore::_terminalPlayMidiNote(const int noteNumber, const int velocity, const std::chrono::microseconds duration)
     {
-        // The UI thread might try to acquire the console lock from time to time.
-        // --> Unlock it, so the UI doesn't hang while we're busy.
-        const auto suspension = _terminal->SuspendLock();
-        // This call will block for the duration, unless shutdown early.
+        // This call returns immediately. The note is played on MidiAudio's own thread,
+        // so neither the output nor the UI thread wait for it.
         _midiAudio.PlayNote(reinterpret_cast<HWND>(_owningHwnd), noteNumber, velocity, std::chrono::duration_cast<std::chrono::milliseconds>(duration));
     }
 
@@ -1511,7 +2074,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     Windows::Foundation::Collections::IVector<winrt::hstring> ControlCore::SelectedText(bool trimTrailingWhitespace) const
     {
         // RetrieveSelectedTextFromBuffer will lock while it's reading
-        const auto internalResult{ _terminal->RetrieveSelectedTextFromBuffer(trimTrailingWhitespace).text };
+        const auto internalResult{ _terminal->RetrieveSelectedTextFromBuffer(trimTrailingWhitespace, false).text };
 
         auto result = winrt::single_threaded_vector<winrt::hstring>();
 
@@ -1529,16 +2092,20 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     // Method Description:
     // - Search text in text buffer. This is triggered if the user click
-    //   search button or press enter.
+    //   search button or press enter. If the buffer has been searched for the
+    //   text already, this steps to the next match. Otherwise the buffer gets
+    //   searched in the background, and we step to the first match once it's done.
     // Arguments:
     // - text: the text to search
     // - goForward: boolean that represents if the current search direction is forward
     // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: boolean that represents if the text is a regular expression
     // Return Value:
     // - <none>
     void ControlCore::Search(const winrt::hstring& text,
                              const bool goForward,
-                             const bool caseSensitive)
+                             const bool caseSensitive,
+                             const bool regex)
     {
         if (text.size() == 0)
         {
@@ -1549,33 +2116,203 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                    Search::Direction::Forward :
                                    Search::Direction::Backward;
 
-        const auto sensitivity = caseSensitive ?
-                                     Search::Sensitivity::CaseSensitive :
-                                     Search::Sensitivity::CaseInsensitive;
-
-        ::Search search(*GetRenderData(), text.c_str(), direction, sensitivity);
         auto lock = _terminal->LockForWriting();
-        const auto foundMatch{ search.FindNext() };
-        if (foundMatch)
-        {
-            _terminal->SetBlockSelection(false);
-            search.Select();
 
-            // this is used for search,
-            // DO NOT call _updateSelectionUI() here.
-            // We don't want to show the markers so manually tell it to clear it.
-            _renderer->TriggerSelection();
-            _UpdateSelectionMarkersHandlers(*this, winrt::make<implementation::UpdateSelectionMarkersEventArgs>(true));
+        // Searching the entire buffer is costly. As long as neither the buffer contents nor
+        // the query changed, we can just step to the next match of the previous search.
+        if (!_searchStale && _searcher && _searchText == text && _searchCaseSensitive == caseSensitive && _searchRegex == regex)
+        {
+            _searcher->SetDirection(direction);
+            _stepToNextMatch();
+            return;
         }
 
-        // Raise a FoundMatch event, which the control will use to notify
-        // narrator if there was any results in the buffer
-        auto foundResults = winrt::make_self<implementation::FoundResultsArgs>(foundMatch);
-        _FoundMatchHandlers(*this, *foundResults);
+        // If the buffer is being searched for this text already, step once that's done.
+        if (!_backgroundSearch || _backgroundSearch->text != text || _backgroundSearch->caseSensitive != caseSensitive || _backgroundSearch->regex != regex)
+        {
+            _startBackgroundSearch(text, caseSensitive, regex);
+        }
+        _backgroundSearch->pendingStep = direction;
     }
 
-    void ControlCore::Close()
-    {
+    // Method Description:
+    // - Starts searching for the text in the background, as the user is typing it.
+    //   This cancels any search that's still in progress for the previous text.
+    //   The matches are highlighted as they're found, without selecting any of them.
+    // Arguments:
+    // - text: the text to search
+    // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: boolean that represents if the text is a regular expression
+    void ControlCore::SearchChanged(const winrt::hstring& text, const bool caseSensitive, const bool regex)
+    {
+        auto lock = _terminal->LockForWriting();
+
+        if (text.empty())
+        {
+            _clearSearch();
+            _postSearchStatus(false);
+            return;
+        }
+
+        _startBackgroundSearch(text, caseSensitive, regex);
+    }
+
+    // Method Description:
+    // - Cancels the search in progress and removes the highlighted matches.
+    //   This is called once the search box gets closed.
+    void ControlCore::ClearSearch()
+    {
+        auto lock = _terminal->LockForWriting();
+        _clearSearch();
+    }
+
+    void ControlCore::_clearSearch()
+    {
+        _backgroundSearch.reset();
+        _searcher.reset();
+        _searchText = {};
+        _terminal->ClearSearchHighlights();
+    }
+
+    // Method Description:
+    // - Replaces the current search (if any) with a new one, that
+    //   searches the buffer in slices on a background thread.
+    //   The terminal lock must be held by the caller.
+    void ControlCore::_startBackgroundSearch(winrt::hstring text, const bool caseSensitive, const bool regex)
+    {
+        _clearSearch();
+        _backgroundSearch.emplace(BackgroundSearch{
+            .text = std::move(text),
+            .caseSensitive = caseSensitive,
+            .regex = regex,
+            .rotationCount = _terminal->GetBufferRotationCount(),
+        });
+        _searchStale = false;
+        (*_searchSlice)();
+    }
+
+    // Method Description:
+    // - Resizing reflows the buffer and invalidates the locations of the matches that were
+    //   found so far. This searches the buffer again for the same text, if it was searched at all.
+    //   The terminal lock must be held by the caller.
+    void ControlCore::_restartBackgroundSearch()
+    {
+        if (_backgroundSearch)
+        {
+            _startBackgroundSearch(_backgroundSearch->text, _backgroundSearch->caseSensitive, _backgroundSearch->regex);
+        }
+        else if (_searcher)
+        {
+            _startBackgroundSearch(_searchText, _searchCaseSensitive, _searchRegex);
+        }
+    }
+
+    // Method Description:
+    // - Searches the next couple rows of the buffer for the text of the background search.
+    //   The terminal lock is released after SearchSliceDuration, after which it reschedules itself.
+    //   Once the entire buffer has been searched, the matches are used for stepping through them.
+    void ControlCore::_searchNextSlice()
+    {
+        const auto lock = _terminal->LockForWriting();
+        if (!_backgroundSearch)
+        {
+            return;
+        }
+
+        auto& search = *_backgroundSearch;
+        const auto& renderData = *GetRenderData();
+        const auto sensitivity = search.caseSensitive ?
+                                     Search::Sensitivity::CaseSensitive :
+                                     Search::Sensitivity::CaseInsensitive;
+        const auto syntax = search.regex ? Search::Syntax::Regex : Search::Syntax::Literal;
+
+        // The rows we've searched already may have scrolled out of the buffer since the last slice.
+        const auto rotationCount = _terminal->GetBufferRotationCount();
+        search.nextRow = std::max(0, search.nextRow - gsl::narrow_cast<til::CoordType>(rotationCount - search.rotationCount));
+        search.rotationCount = rotationCount;
+
+        const auto deadline = std::chrono::steady_clock::now() + SearchSliceDuration;
+        const auto lastRow = renderData.GetTextBufferEndPosition().y;
+        std::vector<til::point_span> matches;
+
+        do
+        {
+            search.nextRow = ::Search::s_FindMatchesInRows(renderData, search.text, sensitivity, syntax, search.nextRow, search.nextRow + SearchSliceRows, matches);
+        } while (search.nextRow <= lastRow && std::chrono::steady_clock::now() < deadline);
+
+        _terminal->AppendSearchHighlights(matches);
+
+        if (search.nextRow <= lastRow)
+        {
+            (*_searchSlice)();
+            _postSearchStatus(false);
+            return;
+        }
+
+        const auto highlights = _terminal->GetSearchHighlights();
+        const auto pendingStep = search.pendingStep;
+        _searcher.emplace(renderData, std::vector<til::point_span>{ highlights.begin(), highlights.end() }, pendingStep.value_or(Search::Direction::Forward));
+        _searchText = search.text;
+        _searchCaseSensitive = search.caseSensitive;
+        _searchRegex = search.regex;
+        _backgroundSearch.reset();
+
+        if (pendingStep)
+        {
+            _stepToNextMatch();
+        }
+        else
+        {
+            _postSearchStatus(false);
+        }
+    }
+
+    // Method Description:
+    // - Selects the next match of the finished search and reports it to the search box.
+    //   The terminal lock must be held by the caller.
+    void ControlCore::_stepToNextMatch()
+    {
+        auto& search = *_searcher;
+        // FindNext() returns false once after it returned every match, so that callers
+        // know when they've gone around the buffer. We just want to wrap around.
+        const auto foundMatch{ search.FindNext() || search.FindNext() };
+        if (foundMatch)
+        {
+            _terminal->SetBlockSelection(false);
+            search.Select();
+
+            // this is used for search,
+            // DO NOT call _updateSelectionUI() here.
+            // We don't want to show the markers so manually tell it to clear it.
+            _renderer->TriggerSelection();
+            _UpdateSelectionMarkersHandlers(*this, winrt::make<implementation::UpdateSelectionMarkersEventArgs>(true));
+        }
+
+        _postSearchStatus(foundMatch);
+    }
+
+    // Method Description:
+    // - Raises a FoundMatch event with the number of matches found so far, which the
+    //   control will use to update the search box and to notify narrator if there were any
+    //   results in the buffer. The events are throttled and raised on the UI thread.
+    //   The terminal lock must be held by the caller.
+    // Arguments:
+    // - foundMatch: whether a match just got selected
+    void ControlCore::_postSearchStatus(const bool foundMatch)
+    {
+        const auto totalMatches = gsl::narrow_cast<int32_t>(_terminal->GetSearchHighlights().size());
+        const auto currentMatch = _searcher ? gsl::narrow_cast<int32_t>(_searcher->GetCurrentMatch()) : -1;
+        auto foundResults = winrt::make<implementation::FoundResultsArgs>(foundMatch || totalMatches != 0, totalMatches, currentMatch);
+
+        const auto shared = _shared.lock_shared();
+        if (shared->updateSearchStatus)
+        {
+            shared->updateSearchStatus->Run(std::move(foundResults));
+        }
+    }
+
+    void ControlCore::Close()
+    {
         if (!_IsClosing())
         {
             _closing = true;
@@ -1766,11 +2503,22 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     void ControlCore::AttachUiaEngine(::Microsoft::Console::Render::IRenderEngine* const pEngine)
     {
-        // _renderer will always exist since it's introduced in the ctor
-        _renderer->AddRenderEngine(pEngine);
+        const auto lock = _terminal->LockForWriting();
+        _uiaEngine = pEngine;
+        // The output governor adds the engine once it disengages.
+        if (!_outputGoverned.load(std::memory_order_relaxed))
+        {
+            // _renderer will always exist since it's introduced in the ctor
+            _renderer->AddRenderEngine(pEngine);
+        }
     }
     void ControlCore::DetachUiaEngine(::Microsoft::Console::Render::IRenderEngine* const pEngine)
     {
+        const auto lock = _terminal->LockForWriting();
+        if (_uiaEngine == pEngine)
+        {
+            _uiaEngine = nullptr;
+        }
         _renderer->RemoveRenderEngine(pEngine);
     }
 
@@ -1795,14 +2543,66 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _RaiseNoticeHandlers(*this, std::move(noticeArgs));
     }
     void ControlCore::_connectionOutputHandler(const hstring& hstr)
+    {
+        size_t pending;
+        {
+            const auto output = _pendingOutput.lock();
+            output->append(hstr);
+            pending = output->size();
+        }
+
+        // If the terminal is busy (for instance because we're rendering), we don't wait
+        // for it and instead coalesce the text for up to OutputCoalesceInterval. Once we
+        // accumulated enough text, we block and write it out, which also ensures that the
+        // connection can't outpace the terminal.
+        if (pending >= OutputCoalesceLimit)
+        {
+            _writePendingOutput(_terminal->LockForWriting());
+        }
+        else if (auto lock = _terminal->TryLockForWriting())
+        {
+            _writePendingOutput(std::move(lock));
+        }
+        else
+        {
+            (*_flushPendingOutput)();
+        }
+    }
+
+    // Method Description:
+    // - Writes all text accumulated by _connectionOutputHandler to the terminal at once.
+    // - This may be called concurrently from the connection's output thread and the
+    //   thread pool. The pending text is taken while holding the terminal lock,
+    //   which ensures that the batches are written in the order they were received.
+    // Arguments:
+    // - lock: The terminal's write lock, which is released once the text was written.
+    void ControlCore::_writePendingOutput(std::unique_lock<til::recursive_ticket_lock> lock)
     {
         try
         {
-            _terminal->Write(hstr);
+            {
+                const auto output = _pendingOutput.lock();
+                if (output->empty())
+                {
+                    return;
+                }
+                // Swapping (instead of moving) allows us to retain the capacity of both strings.
+                _pendingOutputBatch.clear();
+                _pendingOutputBatch.swap(*output);
+            }
+
+            _terminal->Write(_pendingOutputBatch);
+            _searchStale = true;
+            // This is done while holding the lock, so that the next frame is guaranteed to contain the echo.
+            _renderer->GetPerfCounters().OutputReceived();
+            _governOutput(_pendingOutputBatch.size());
+            lock.unlock();
 
             // Start the throttled update of where our hyperlinks are.
+            // Nobody can see them while we're in the background. SetInBackground() catches up.
+            // The same goes for while the output governor is engaged and _setOutputGoverned().
             const auto shared = _shared.lock_shared();
-            if (shared->updatePatternLocations)
+            if (shared->updatePatternLocations && !_inBackground.load(std::memory_order_relaxed) && !_outputGoverned.load(std::memory_order_relaxed))
             {
                 (*shared->updatePatternLocations)();
             }
@@ -1810,8 +2610,116 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         catch (...)
         {
             // We're expecting to receive an exception here if the terminal
-            // is closed while we're blocked playing a MIDI note.
+            // is closed while we're writing to it.
+        }
+    }
+
+    // Method Description:
+    // - The output governor. While the connection produces more than OutputGovernorThreshold
+    //   characters per second, for instance because someone printed a huge binary file, we keep
+    //   parsing all of it, but limit rendering to PacingMode::Throttled and suspend the UIA
+    //   engine and the hyperlink pattern updates, all of which would otherwise have to process
+    //   each intermediate frame. It disengages once the throughput drops below half the threshold.
+    // - Must be called while holding the terminal's write lock.
+    // Arguments:
+    // - chars: The number of characters that were just written to the terminal.
+    void ControlCore::_governOutput(const size_t chars)
+    {
+        const auto threshold = _outputGovernorThreshold.load(std::memory_order_relaxed);
+        const auto governed = _outputGoverned.load(std::memory_order_relaxed);
+        if (threshold == 0 && !governed)
+        {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = now - _outputGovernorWindowStart;
+        _outputGovernorWindowChars += chars;
+
+        if (elapsed >= OutputGovernorWindow)
+        {
+            const auto rate = _outputGovernorWindowChars / std::chrono::duration<double>(elapsed).count();
+            _outputGovernorWindowStart = now;
+            _outputGovernorWindowChars = 0;
+
+            if (!governed && rate > threshold)
+            {
+                _setOutputGoverned(true);
+            }
+            else if (governed && rate < threshold / 2.0)
+            {
+                _setOutputGoverned(false);
+            }
+        }
+
+        if (_outputGoverned.load(std::memory_order_relaxed))
+        {
+            (*_outputGovernorCheck)();
+        }
+    }
+
+    // Method Description:
+    // - Engages or disengages the output governor. See _governOutput().
+    // - Must be called while holding the terminal's write lock, because it modifies the renderer's engines.
+    // Arguments:
+    // - governed: True if the connection is flooding us with output.
+    void ControlCore::_setOutputGoverned(const bool governed)
+    {
+        _outputGoverned.store(governed, std::memory_order_relaxed);
+        _updatePacingMode();
+
+        if (_uiaEngine)
+        {
+            if (governed)
+            {
+                _renderer->RemoveRenderEngine(_uiaEngine);
+            }
+            else
+            {
+                _renderer->AddRenderEngine(_uiaEngine);
+            }
+        }
+
+        if (governed)
+        {
+            return;
+        }
+
+        // JumpToOutputEnd() disabled painting entirely until now.
+        if (_outputSkipping.exchange(false, std::memory_order_relaxed) && !_inBackground.load(std::memory_order_relaxed))
+        {
+            _renderer->EnablePainting();
+        }
+        _renderer->TriggerRedrawAll();
+
+        const auto shared = _shared.lock_shared();
+        if (shared->updatePatternLocations && !_inBackground.load(std::memory_order_relaxed))
+        {
+            (*shared->updatePatternLocations)();
+        }
+    }
+
+    // Method Description:
+    // - Scrolls to the bottom of the buffer. If the output governor is engaged, this
+    //   additionally stops painting until the flood of output is over. The output is
+    //   still parsed, but none of the rows in between are rendered, and those that
+    //   scroll out of the scrollback in the meantime are never rendered at all.
+    void ControlCore::JumpToOutputEnd()
+    {
+        if (_outputGoverned.load(std::memory_order_relaxed) && !_outputSkipping.exchange(true, std::memory_order_relaxed))
+        {
+            // This must not be called while holding the terminal lock, as the render thread needs it to finish the frame.
+            _renderer->WaitForPaintCompletionAndDisable(INFINITE);
+
+            // The governor may have disengaged in the meantime and enabled painting before we disabled it.
+            const auto lock = _terminal->LockForWriting();
+            if (!_outputSkipping.load(std::memory_order_relaxed) && !_inBackground.load(std::memory_order_relaxed))
+            {
+                _renderer->EnablePainting();
+            }
         }
+
+        UserScrollViewport(std::numeric_limits<int>::max());
     }
 
     uint64_t ControlCore::SwapChainHandle() const
@@ -1854,6 +2762,23 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Appends the text of the given row without its trailing whitespace, followed by
+    // a newline unless the row wraps into the next one.
+    static void appendRowText(std::wstring& str, const ROW& row)
+    {
+        const auto rowText = row.GetText();
+        const auto strEnd = rowText.find_last_not_of(UNICODE_SPACE);
+        if (strEnd != decltype(rowText)::npos)
+        {
+            str.append(rowText.substr(0, strEnd + 1));
+        }
+
+        if (!row.WasWrapForced())
+        {
+            str.append(L"\r\n");
+        }
+    }
+
     hstring ControlCore::ReadEntireBuffer() const
     {
         auto terminalLock = _terminal->LockForWriting();
@@ -1864,23 +2789,152 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         const auto lastRow = textBuffer.GetLastNonSpaceCharacter().y;
         for (auto rowIndex = 0; rowIndex <= lastRow; rowIndex++)
         {
-            const auto& row = textBuffer.GetRowByOffset(rowIndex);
-            const auto rowText = row.GetText();
-            const auto strEnd = rowText.find_last_not_of(UNICODE_SPACE);
-            if (strEnd != decltype(rowText)::npos)
+            appendRowText(str, textBuffer.GetRowByOffset(rowIndex));
+        }
+
+        return hstring{ str };
+    }
+
+    // Method Description:
+    // - Writes the same text that ReadEntireBuffer() returns to the given file, encoded as UTF-8.
+    // - The buffer is read in chunks of rows, and the terminal is only locked while one is read.
+    //   This keeps the memory usage flat and doesn't hold up the output for the entire export.
+    //   Rows that scroll up in the meantime are accounted for. Rows that scroll out of the
+    //   buffer before they were read are lost.
+    // - This is meant to be called on a background thread.
+    // Arguments:
+    // - path: The file to write. It's overwritten if it exists.
+    void ControlCore::ExportToPath(const winrt::hstring& path) const
+    {
+        static constexpr til::CoordType rowsPerChunk = 1024;
+
+        const wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!file);
+
+        std::wstring text;
+        std::string utf8;
+        til::CoordType beg = 0;
+        uint64_t rowsScrolled = 0;
+        auto done = false;
+
+        while (!done)
+        {
+            text.clear();
+
             {
-                str.append(rowText.substr(0, strEnd + 1));
+                const auto lock = _terminal->LockForReading();
+                const auto& textBuffer = _terminal->GetTextBuffer();
+
+                // Rows that were at offset `beg` during the last chunk may have scrolled up since.
+                const auto scrolled = textBuffer.GetRowsScrolled();
+                if (beg != 0)
+                {
+                    beg = gsl::narrow_cast<til::CoordType>(std::max<int64_t>(0, beg - gsl::narrow_cast<int64_t>(scrolled - rowsScrolled)));
+                }
+                rowsScrolled = scrolled;
+
+                const auto lastRow = textBuffer.GetLastNonSpaceCharacter().y;
+                const auto end = std::min(beg + rowsPerChunk, lastRow + 1);
+                for (auto rowIndex = beg; rowIndex < end; rowIndex++)
+                {
+                    appendRowText(text, textBuffer.GetRowByOffset(rowIndex));
+                }
+
+                beg = end;
+                done = end > lastRow;
             }
 
-            if (!row.WasWrapForced())
+            if (!text.empty())
             {
-                str.append(L"\r\n");
+                THROW_IF_FAILED(til::u16u8(text, utf8));
+
+                DWORD written = 0;
+                THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), utf8.data(), gsl::narrow<DWORD>(utf8.size()), &written, nullptr));
+                THROW_HR_IF(E_FAIL, written != utf8.size());
             }
         }
+    }
 
-        return hstring{ str };
+    // Method Description:
+    // - Writes a snapshot of the buffer contents, their attributes, hyperlinks and
+    //   scroll marks to the given file, which RestoreFromPath() can import again.
+    // - The terminal is only locked while the snapshot is encoded in memory,
+    //   so output isn't held up while the file is written.
+    // Arguments:
+    // - path: The file to write. It's overwritten if it exists.
+    void ControlCore::PersistToPath(const winrt::hstring& path) const
+    {
+        std::vector<std::byte> snapshot;
+        {
+            const auto lock = _terminal->LockForReading();
+
+            if (!_initializedTerminal.load(std::memory_order_relaxed))
+            {
+                // We never got to restore our own snapshot. Pass it on, since it's still our contents.
+                if (!_restorePath.empty() && _restorePath != path)
+                {
+                    LOG_IF_WIN32_BOOL_FALSE(CopyFileW(_restorePath.c_str(), path.c_str(), FALSE));
+                }
+                return;
+            }
+
+            _terminal->SerializeSnapshot(snapshot);
+        }
+
+        const wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!file);
+
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), snapshot.data(), gsl::narrow<DWORD>(snapshot.size()), &written, nullptr));
+        THROW_HR_IF(E_FAIL, written != snapshot.size());
     }
 
+    // Method Description:
+    // - Imports a snapshot written by PersistToPath() once the terminal gets initialized.
+    //   The file is consumed by the import and deleted afterwards.
+    // Arguments:
+    // - path: The file to read. Nothing is restored if it doesn't exist.
+    void ControlCore::RestoreFromPath(const winrt::hstring& path)
+    {
+        const auto lock = _terminal->LockForWriting();
+
+        if (_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            _restoreFromPath(path.c_str());
+        }
+        else
+        {
+            _restorePath = path;
+        }
+    }
+
+    void ControlCore::_restoreFromPath(const wchar_t* path)
+    try
+    {
+        // The snapshot is mapped into memory and imported from there directly.
+        // FILE_FLAG_DELETE_ON_CLOSE ensures that it's never restored twice, even if the import fails.
+        const wil::unique_hfile file{ CreateFileW(path, GENERIC_READ | DELETE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, nullptr) };
+        if (!file)
+        {
+            return;
+        }
+
+        LARGE_INTEGER size{};
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+        if (size.QuadPart <= 0)
+        {
+            return;
+        }
+
+        const wil::unique_handle mapping{ CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr) };
+        THROW_LAST_ERROR_IF(!mapping);
+        const wil::unique_mapview_ptr<std::byte> view{ static_cast<std::byte*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)) };
+        THROW_LAST_ERROR_IF(!view);
+
+        _terminal->RestoreSnapshot({ view.get(), gsl::narrow<size_t>(size.QuadPart) });
+    }
+    CATCH_LOG()
+
     Core::Scheme ControlCore::ColorScheme() const noexcept
     {
         Core::Scheme s;
@@ -2007,6 +3061,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     //         class as the target for transmission. But since this message isn't
     //         coming in via VT parsing (and rather from a window state transition)
     //         we generate and send it here.
+    // - When hidden, this also releases the memory of rows that aren't visible.
     // Arguments:
     // - visible: True for visible; false for not visible.
     // Return Value:
@@ -2020,6 +3075,122 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             {
                 conpty.ShowHide(showOrHide);
             }
+
+            const auto lock = _terminal->LockForWriting();
+
+            // Nobody can see our frames while we're minimized. The renderer draws a single
+            // frame once we're shown again, instead of painting all the output in between.
+            _renderer->SetOccluded(::Microsoft::Console::Render::OcclusionReason::WindowHidden, !showOrHide);
+
+            // While we're minimized or otherwise hidden nobody is going to look at
+            // the scrollback and we can give its memory back to the system.
+            if (!showOrHide)
+            {
+                _terminal->TrimMemory(isLowOnMemory());
+            }
+        }
+    }
+
+    // Method Description:
+    // - Stops (or resumes) painting while the session is locked or
+    //   disconnected, similar to WindowVisibilityChanged().
+    // Arguments:
+    // - locked: true if the session got locked, false once it's unlocked.
+    void ControlCore::SessionLockChanged(const bool locked)
+    {
+        if (_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            const auto lock = _terminal->LockForWriting();
+            _renderer->SetOccluded(::Microsoft::Console::Render::OcclusionReason::SessionLocked, locked);
+        }
+    }
+
+    // Method Description:
+    // - Puts the control into or out of the "background" state, in which it's
+    //   not visible (for instance because its tab isn't selected). In the
+    //   background we stop painting, release the engine's swap chain and atlas
+    //   and stop tracking hyperlinks. The connection's output is still written
+    //   into the buffer. Coming back does a single full repaint.
+    // Arguments:
+    // - inBackground: True if the control isn't visible anymore.
+    void ControlCore::SetInBackground(const bool inBackground)
+    {
+        if (!_initializedTerminal.load(std::memory_order_relaxed) ||
+            _inBackground.exchange(inBackground, std::memory_order_relaxed) == inBackground)
+        {
+            return;
+        }
+
+        if (inBackground)
+        {
+            _renderer->WaitForPaintCompletionAndDisable(INFINITE);
+            _renderEngine->ReleaseResources();
+            return;
+        }
+
+        // JumpToOutputEnd() keeps painting disabled until the flood of output is over.
+        if (!_outputSkipping.load(std::memory_order_relaxed))
+        {
+            _renderer->EnablePainting();
+        }
+        _renderer->TriggerRedrawAll();
+
+        const auto shared = _shared.lock_shared();
+        if (shared->updatePatternLocations && !_outputGoverned.load(std::memory_order_relaxed))
+        {
+            (*shared->updatePatternLocations)();
+        }
+    }
+
+    // Method Description:
+    // - Returns the approximate number of bytes held by this control: By its text
+    //   buffers, by its renderer (mostly GPU memory) and by its connection's buffers.
+    Control::MemoryUsage ControlCore::GetMemoryUsage() const
+    {
+        Control::MemoryUsage usage{};
+        if (!_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            return usage;
+        }
+
+        {
+            const auto lock = _terminal->LockForReading();
+            usage.Buffer = _terminal->GetMemoryUsage();
+        }
+        if (_renderEngine)
+        {
+            usage.Renderer = _renderEngine->GetMemoryUsage();
+        }
+        if (const auto conpty{ _connection.try_as<TerminalConnection::ConptyConnection>() })
+        {
+            usage.Connection = conpty.MemoryUsage();
+        }
+        return usage;
+    }
+
+    // Method Description:
+    // - Releases as much memory as possible without losing any of the buffer's contents.
+    //   This is meant for when the system is low on memory. All rows outside of the viewport
+    //   get compacted and, if the control is in the background, the renderer releases its
+    //   swap chain and glyph atlas, just like SetInBackground() did when we got hidden.
+    //   The buffers that were kept around for reuse by TextBuffer get released as well.
+    void ControlCore::TrimMemory()
+    {
+        if (!_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        {
+            const auto lock = _terminal->LockForWriting();
+            _terminal->TrimMemory(true);
+        }
+        TextBuffer::TrimRecycledMemory();
+
+        if (_inBackground.load(std::memory_order_relaxed))
+        {
+            _renderer->WaitForPaintCompletionAndDisable(INFINITE);
+            _renderEngine->ReleaseResources();
         }
     }
 
@@ -2053,6 +3224,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         const auto previous = std::exchange(_isReadOnly, false);
         const auto restore = wil::scope_exit([&]() { _isReadOnly = previous; });
         _terminal->FocusChanged(focused);
+
+        // The focused pane gets painted first among all panes sharing the same render thread.
+        if (_renderer)
+        {
+            _renderer->SetHighPriority(focused);
+        }
     }
 
     bool ControlCore::_isBackgroundTransparent()
@@ -2082,6 +3259,13 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             }
         }
         _owningHwnd = owner;
+
+        // The renderer picks the GPU that drives the monitor the window is on.
+        if (_initializedTerminal.load(std::memory_order_relaxed))
+        {
+            const auto lock = _terminal->LockForWriting();
+            _renderEngine->SetMonitorHwnd(reinterpret_cast<HWND>(owner));
+        }
     }
 
     Windows::Foundation::Collections::IVector<Control::ScrollMark> ControlCore::ScrollMarks() const
@@ -2138,70 +3322,34 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     void ControlCore::ScrollToMark(const Control::ScrollToMarkDirection& direction)
     {
         const auto currentOffset = ScrollOffset();
-        const auto& marks{ _terminal->GetScrollMarks() };
 
+        // The marks are sorted by their start, so we can look up the target directly.
         std::optional<DispatchTypes::ScrollMark> tgt;
 
         switch (direction)
         {
         case ScrollToMarkDirection::Last:
-        {
-            int highest = currentOffset;
-            for (const auto& mark : marks)
+            tgt = _terminal->GetScrollMarkBefore(til::CoordTypeMax);
+            if (tgt && tgt->start.y <= currentOffset)
             {
-                const auto newY = mark.start.y;
-                if (newY > highest)
-                {
-                    tgt = mark;
-                    highest = newY;
-                }
+                tgt.reset();
             }
             break;
-        }
         case ScrollToMarkDirection::First:
-        {
-            int lowest = currentOffset;
-            for (const auto& mark : marks)
+            tgt = _terminal->GetScrollMarkAfter(til::CoordTypeMin);
+            if (tgt && tgt->start.y >= currentOffset)
             {
-                const auto newY = mark.start.y;
-                if (newY < lowest)
-                {
-                    tgt = mark;
-                    lowest = newY;
-                }
+                tgt.reset();
             }
             break;
-        }
         case ScrollToMarkDirection::Next:
-        {
-            int minDistance = INT_MAX;
-            for (const auto& mark : marks)
-            {
-                const auto delta = mark.start.y - currentOffset;
-                if (delta > 0 && delta < minDistance)
-                {
-                    tgt = mark;
-                    minDistance = delta;
-                }
-            }
+            tgt = _terminal->GetScrollMarkAfter(currentOffset);
             break;
-        }
         case ScrollToMarkDirection::Previous:
         default:
-        {
-            int minDistance = INT_MAX;
-            for (const auto& mark : marks)
-            {
-                const auto delta = currentOffset - mark.start.y;
-                if (delta > 0 && delta < minDistance)
-                {
-                    tgt = mark;
-                    minDistance = delta;
-                }
-            }
+            tgt = _terminal->GetScrollMarkBefore(currentOffset);
             break;
         }
-        }
 
         const auto viewHeight = ViewHeight();
         const auto bufferSize = BufferHeight();
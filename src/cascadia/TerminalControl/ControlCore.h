@@ -73,6 +73,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void UpdateSettings(const Control::IControlSettings& settings, const IControlAppearance& newAppearance);
         void ApplyAppearance(const bool& focused);
+        void Recycle(const Control::IControlSettings& settings, const IControlAppearance& unfocusedAppearance, const TerminalConnection::ITerminalConnection& connection);
         Control::IControlSettings Settings() { return *_settings; };
         Control::IControlAppearance FocusedAppearance() const { return *_settings->FocusedAppearance(); };
         Control::IControlAppearance UnfocusedAppearance() const { return *_settings->UnfocusedAppearance(); };
@@ -90,6 +91,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void AdjustFontSize(float fontSizeDelta);
         void ResetFontSize();
+        float FontSizePreviewScale();
         FontInfo GetFont() const;
         winrt::Windows::Foundation::Size FontSizeInDips() const;
 
@@ -116,6 +118,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void LostFocus();
 
         void ToggleShaderEffects();
+        void TogglePerfOverlay();
+        Control::PerfCounters GetPerfCounters() const noexcept;
         void AdjustOpacity(const double adjustment);
         void ResumeRendering();
 
@@ -177,8 +181,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                             const short wheelDelta,
                             const ::Microsoft::Console::VirtualTerminal::TerminalInput::MouseButtonState state);
         void UserScrollViewport(const int viewTop);
+        bool SmoothScrolling() const;
+        void SetSmoothScrollOffset(const float rows);
 
         void ClearBuffer(Control::ClearBufferType clearType);
+        void JumpToOutputEnd();
 
 #pragma endregion
 
@@ -198,7 +205,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void Search(const winrt::hstring& text,
                     const bool goForward,
-                    const bool caseSensitive);
+                    const bool caseSensitive,
+                    const bool regex);
+        void SearchChanged(const winrt::hstring& text, const bool caseSensitive, const bool regex);
+        void ClearSearch();
 
         void LeftClickOnTerminal(const til::point terminalPosition,
                                  const int numberOfClicks,
@@ -215,12 +225,19 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void SetReadOnlyMode(const bool readOnlyState);
 
         hstring ReadEntireBuffer() const;
+        void ExportToPath(const winrt::hstring& path) const;
+        void PersistToPath(const winrt::hstring& path) const;
+        void RestoreFromPath(const winrt::hstring& path);
 
         static bool IsVintageOpacityAvailable() noexcept;
 
         void AdjustOpacity(const double opacity, const bool relative);
 
         void WindowVisibilityChanged(const bool showOrHide);
+        void SessionLockChanged(const bool locked);
+        void SetInBackground(const bool inBackground);
+        Control::MemoryUsage GetMemoryUsage() const;
+        void TrimMemory();
 
         uint64_t OwningHwnd();
         void OwningHwnd(uint64_t owner);
@@ -252,6 +269,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         TYPED_EVENT(HoveredHyperlinkChanged,   IInspectable, IInspectable);
         TYPED_EVENT(RendererEnteredErrorState, IInspectable, IInspectable);
         TYPED_EVENT(SwapChainChanged,          IInspectable, IInspectable);
+        TYPED_EVENT(FontSizePreviewChanged,    IInspectable, IInspectable);
         TYPED_EVENT(RendererWarning,           IInspectable, Control::RendererWarningArgs);
         TYPED_EVENT(RaiseNotice,               IInspectable, Control::NoticeEventArgs);
         TYPED_EVENT(TransparencyChanged,       IInspectable, Control::TransparencyChangedEventArgs);
@@ -272,11 +290,76 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             std::shared_ptr<ThrottledFuncTrailing<>> tsfTryRedrawCanvas;
             std::unique_ptr<til::throttled_func_trailing<>> updatePatternLocations;
             std::shared_ptr<ThrottledFuncTrailing<Control::ScrollPositionChangedArgs>> updateScrollBar;
+            std::shared_ptr<ThrottledFuncTrailing<Control::FoundResultsArgs>> updateSearchStatus;
+            std::shared_ptr<ThrottledFuncTrailing<>> flushMouseMotion;
+            std::shared_ptr<ThrottledFuncTrailing<til::CoordType, til::CoordType>> resizeConnection;
+            std::shared_ptr<ThrottledFuncTrailing<winrt::hstring>> updateTitle;
+            std::shared_ptr<ThrottledFuncTrailing<size_t, size_t>> updateTaskbarProgress;
+            std::shared_ptr<ThrottledFuncTrailing<>> applyPendingFontSize;
+        };
+
+        // Pointer motion that arrived too soon after the last reported one. It's sent by
+        // flushMouseMotion, unless newer motion replaces it, or a button event flushes it
+        // first. Like _lastMouseMotion this is only accessed on the UI thread.
+        struct PendingMouseMotion
+        {
+            til::point viewportPos;
+            ::Microsoft::Terminal::Core::ControlKeyStates states;
+            ::Microsoft::Console::VirtualTerminal::TerminalInput::MouseButtonState state;
         };
 
         std::atomic<bool> _initializedTerminal{ false };
+        std::atomic<bool> _inBackground{ false };
         bool _closing{ false };
 
+        // A snapshot written by PersistToPath(), which Initialize() imports into the new terminal.
+        winrt::hstring _restorePath;
+
+        // Output received from the connection, which hasn't been written to the terminal yet.
+        // _pendingOutputBatch is protected by the terminal lock. _flushPendingOutput
+        // must be declared after these, so that it's destroyed before them.
+        til::shared_mutex<std::wstring> _pendingOutput;
+        std::wstring _pendingOutputBatch;
+        std::unique_ptr<til::throttled_func_trailing<>> _flushPendingOutput;
+
+        // Reflows the scrollback that was skipped during a resize, once the resize has settled.
+        // _lastLiveResize is protected by the terminal lock.
+        std::chrono::steady_clock::time_point _lastLiveResize{};
+        std::unique_ptr<til::throttled_func_trailing<>> _finishLiveResize;
+
+        // The output governor throttles rendering while the connection floods us with output. See _governOutput().
+        // The flags are atomic, because they're read without holding the terminal lock. Everything else is protected by it.
+        std::atomic<int32_t> _outputGovernorThreshold{ 0 };
+        std::atomic<bool> _outputGoverned{ false };
+        std::atomic<bool> _outputSkipping{ false };
+        std::chrono::steady_clock::time_point _outputGovernorWindowStart{};
+        size_t _outputGovernorWindowChars = 0;
+        ::Microsoft::Console::Render::IRenderEngine* _uiaEngine = nullptr;
+        std::unique_ptr<til::throttled_func_trailing<>> _outputGovernorCheck;
+
+        // The last search, which allows Search() to step through its matches without searching the buffer again.
+        // It needs to be redone if the buffer contents changed since (_searchStale). Protected by the terminal lock.
+        std::optional<::Search> _searcher;
+        winrt::hstring _searchText;
+        bool _searchCaseSensitive = false;
+        bool _searchRegex = false;
+        bool _searchStale = true;
+
+        // The search that's still running in the background, one slice of rows at a time. Its matches are
+        // streamed into the terminal's search highlights. pendingStep is set if the user pressed enter
+        // before the search finished. Replacing it cancels the previous one. Protected by the terminal lock.
+        struct BackgroundSearch
+        {
+            winrt::hstring text;
+            bool caseSensitive = false;
+            bool regex = false;
+            til::CoordType nextRow = 0;
+            int64_t rotationCount = 0;
+            std::optional<::Search::Direction> pendingStep;
+        };
+        std::optional<BackgroundSearch> _backgroundSearch;
+        std::unique_ptr<til::throttled_func_trailing<>> _searchSlice;
+
         TerminalConnection::ITerminalConnection _connection{ nullptr };
         TerminalConnection::ITerminalConnection::TerminalOutput_revoker _connectionOutputEventRevoker;
         TerminalConnection::ITerminalConnection::StateChanged_revoker _connectionStateChangedRevoker;
@@ -323,18 +406,47 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         winrt::Windows::System::DispatcherQueue _dispatcher{ nullptr };
         til::shared_mutex<SharedState> _shared;
 
+        std::optional<PendingMouseMotion> _pendingMouseMotion;
+        std::chrono::steady_clock::time_point _lastMouseMotion{};
+
+        // The font size that AdjustFontSize() will apply once FontSizeZoomInterval elapsed.
+        // _setFontSizeUnderLock() clears it. Only accessed on the UI thread.
+        std::optional<float> _pendingFontSize;
+
+        // The title and taskbar progress we last raised an event for, which allows
+        // us to skip updates that didn't change anything. Only accessed on the UI thread.
+        winrt::hstring _lastRaisedTitle;
+        size_t _lastRaisedTaskbarState = 0;
+        size_t _lastRaisedTaskbarProgress = 0;
+        // The time at which the key press that's currently being handled was received, for measuring
+        // the input latency. Only set during TrySendKeyEvent() and SendCharEvent() on the UI thread.
+        std::optional<std::chrono::steady_clock::time_point> _keyTimestamp;
+
         til::point _contextMenuBufferPosition{ 0, 0 };
 
         void _setupDispatcherAndCallbacks();
 
+        bool _fontSettingsChanged(const implementation::ControlSettings* previousSettings) const;
         bool _setFontSizeUnderLock(float fontSize);
+        void _applyPendingFontSize();
         void _updateFont(const bool initialUpdate = false);
         void _refreshSizeUnderLock();
+        void _resizeConnection(const til::CoordType rows, const til::CoordType columns);
         void _updateSelectionUI();
         bool _shouldTryUpdateSelection(const WORD vkey);
 
         void _handleControlC();
         void _sendInputToConnection(std::wstring_view wstr);
+        void _sendPendingMouseMotion();
+
+        void _clearSearch();
+        void _startBackgroundSearch(winrt::hstring text, const bool caseSensitive, const bool regex);
+        void _restartBackgroundSearch();
+        void _searchNextSlice();
+        void _stepToNextMatch();
+        void _postSearchStatus(const bool foundMatch);
+        void _raiseTitleChanged(const winrt::hstring& title);
+        void _raiseTaskbarProgressChanged(const size_t state, const size_t progress);
 
 #pragma region TerminalCoreCallbacks
         void _terminalCopyToClipboard(std::wstring_view wstr);
@@ -363,7 +475,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void _raiseReadOnlyWarning();
         void _updateAntiAliasingMode();
+        void _updatePacingMode();
         void _connectionOutputHandler(const hstring& hstr);
+        void _writePendingOutput(std::unique_lock<til::recursive_ticket_lock> lock);
+        void _governOutput(const size_t chars);
+        void _setOutputGoverned(const bool governed);
+        void _restoreFromPath(const wchar_t* path);
         void _updateHoveredCell(const std::optional<til::point> terminalPosition);
         void _setOpacity(const double opacity);
 
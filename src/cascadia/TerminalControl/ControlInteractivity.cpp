@@ -563,7 +563,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // underneath us. We wouldn't know - we don't want the overhead of
         // another ScrollPositionChanged handler. If the scrollbar should be
         // somewhere other than where it is currently, then start from that row.
-        const auto currentInternalRow = ::base::saturated_cast<int>(::std::round(_internalScrollbarPosition));
+        const auto currentInternalRow = _internalScrollbarRow();
         const auto currentCoreRow = _core->ScrollOffset();
         const auto currentOffset = currentInternalRow == currentCoreRow ?
                                        _internalScrollbarPosition :
@@ -619,7 +619,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // If the new scrollbar position, rounded to an int, is at a different
         // row, then actually update the scroll position in the core, and raise
         // a ScrollPositionChanged to inform the control.
-        auto viewTop = ::base::saturated_cast<int>(::std::round(_internalScrollbarPosition));
+        auto viewTop = _internalScrollbarRow();
         if (viewTop != _core->ScrollOffset())
         {
             _core->UserScrollViewport(viewTop);
@@ -630,6 +630,25 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                                                                   _core->ViewHeight(),
                                                                                   _core->BufferHeight()));
         }
+
+        // In smooth scrolling mode the remaining fraction of a row isn't rounded away, but drawn
+        // by the renderer instead. The bottom-most viewport has no row below it to scroll into.
+        if (_core->SmoothScrolling())
+        {
+            const auto bottomTop = _core->BufferHeight() - _core->ViewHeight();
+            const auto fraction = viewTop < bottomTop ? _internalScrollbarPosition - viewTop : 0.0;
+            _core->SetSmoothScrollOffset(static_cast<float>(fraction));
+        }
+    }
+
+    // Method Description:
+    // - Returns the row at the top of the viewport for the current _internalScrollbarPosition.
+    //   In smooth scrolling mode this is the row the position lies in, since the
+    //   fraction past it gets drawn as an offset. Otherwise it's the nearest row.
+    int ControlInteractivity::_internalScrollbarRow() const
+    {
+        const auto row = _core->SmoothScrolling() ? ::std::floor(_internalScrollbarPosition) : ::std::round(_internalScrollbarPosition);
+        return ::base::saturated_cast<int>(row);
     }
 
     void ControlInteractivity::_hyperlinkHandler(const std::wstring_view uri)
@@ -150,6 +150,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _mouseScrollHandler(const int32_t mouseDelta,
                                  const Core::Point terminalPosition,
                                  const bool isLeftButtonPressed);
+        int _internalScrollbarRow() const;
 
         void _hyperlinkHandler(const std::wstring_view uri);
         bool _canSendVTMouseInput(const ::Microsoft::Terminal::Core::ControlKeyStates modifiers);
@@ -150,12 +150,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     struct FoundResultsArgs : public FoundResultsArgsT<FoundResultsArgs>
     {
     public:
-        FoundResultsArgs(const bool foundMatch) :
-            _FoundMatch(foundMatch)
+        FoundResultsArgs(const bool foundMatch, const int32_t totalMatches, const int32_t currentMatch) :
+            _FoundMatch(foundMatch),
+            _TotalMatches(totalMatches),
+            _CurrentMatch(currentMatch)
         {
         }
 
         WINRT_PROPERTY(bool, FoundMatch);
+        WINRT_PROPERTY(int32_t, TotalMatches);
+        WINRT_PROPERTY(int32_t, CurrentMatch);
     };
 
     struct ShowWindowArgs : public ShowWindowArgsT<ShowWindowArgs>
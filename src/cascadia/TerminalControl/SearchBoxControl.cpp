@@ -5,6 +5,8 @@
 #include "SearchBoxControl.h"
 #include "SearchBoxControl.g.cpp"
 
+#include <LibraryResources.h>
+
 using namespace winrt;
 using namespace winrt::Windows::UI::Xaml;
 using namespace winrt::Windows::UI::Core;
@@ -22,6 +24,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _focusableElements.insert(TextBox());
         _focusableElements.insert(CloseButton());
         _focusableElements.insert(CaseSensitivityButton());
+        _focusableElements.insert(RegexButton());
         _focusableElements.insert(GoForwardButton());
         _focusableElements.insert(GoBackwardButton());
     }
@@ -50,6 +53,18 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         return CaseSensitivityButton().IsChecked().GetBoolean();
     }
 
+    // Method Description:
+    // - Check if the current search is a regular expression
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - bool: whether the text is a regular expression (regex button is checked)
+    //   or literal text
+    bool SearchBoxControl::_Regex()
+    {
+        return RegexButton().IsChecked().GetBoolean();
+    }
+
     // Method Description:
     // - Handler for pressing Enter on TextBox, trigger
     //   text search
@@ -65,16 +80,42 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             const auto state = CoreWindow::GetForCurrentThread().GetKeyState(winrt::Windows::System::VirtualKey::Shift);
             if (WI_IsFlagSet(state, CoreVirtualKeyStates::Down))
             {
-                _SearchHandlers(TextBox().Text(), !_GoForward(), _CaseSensitive());
+                _SearchHandlers(TextBox().Text(), !_GoForward(), _CaseSensitive(), _Regex());
             }
             else
             {
-                _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+                _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
             }
             e.Handled(true);
         }
     }
 
+    // Method Description:
+    // - Handler for changes to the TextBox's text. This starts searching
+    //   for the new text in the background, while the user is still typing.
+    // Arguments:
+    // - sender: not used
+    // - e: not used
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::TextBoxTextChanged(const winrt::Windows::Foundation::IInspectable& /*sender*/, const Controls::TextChangedEventArgs& /*e*/)
+    {
+        _SearchChangedHandlers(TextBox().Text(), _CaseSensitive(), _Regex());
+    }
+
+    // Method Description:
+    // - Handler for toggling the case sensitivity or regular expressions,
+    //   which changes the search just like editing the text does.
+    // Arguments:
+    // - sender: not used
+    // - e: not used
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::SearchOptionClicked(const winrt::Windows::Foundation::IInspectable& /*sender*/, const RoutedEventArgs& /*e*/)
+    {
+        _SearchChangedHandlers(TextBox().Text(), _CaseSensitive(), _Regex());
+    }
+
     // Method Description:
     // - Handler for pressing "Esc" when focusing
     //   on the search dialog, this triggers close
@@ -124,6 +165,30 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Method Description:
+    // - Shows how many matches the last search found and which of them is selected.
+    // Arguments:
+    // - totalMatches: the number of matches in the buffer
+    // - currentMatch: the index of the selected match, or -1 if there's none
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::SetStatus(int32_t totalMatches, int32_t currentMatch)
+    {
+        if (StatusBox())
+        {
+            std::wstring status;
+            if (totalMatches <= 0)
+            {
+                status = RS_(L"SearchBox_NoResults");
+            }
+            else
+            {
+                status = fmt::format(std::wstring_view{ RS_(L"SearchBox_Results") }, currentMatch + 1, totalMatches);
+            }
+            StatusBox().Text(status);
+        }
+    }
+
     // Method Description:
     // - Check if the current focus is on any element within the
     //   search box
@@ -160,7 +225,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
 
         // kick off search
-        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
     }
 
     // Method Description:
@@ -181,7 +246,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
 
         // kick off search
-        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
     }
 
     // Method Description:
@@ -30,6 +30,8 @@ using namespace winrt::Windows::Storage::Streams;
 // The minimum delay between updates to the scroll bar's values.
 // The updates are throttled to limit power usage.
 constexpr const auto ScrollBarUpdateInterval = std::chrono::milliseconds(8);
+// The scroll bar timers of all panes may be coalesced by up to this much. See UiTimerSlack in ControlCore.
+constexpr const auto ScrollBarUpdateSlack = std::chrono::milliseconds(4);
 
 // The minimum delay between updating the TSF input control.
 // This is already throttled primarily in the ControlCore, with a timeout of 100ms. We're adding another smaller one here, as the (potentially x-proc) call will come in off the UI thread
@@ -61,8 +63,6 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _autoScrollingPointerPoint{ std::nullopt },
         _autoScrollTimer{},
         _lastAutoScrollUpdateTime{ std::nullopt },
-        _cursorTimer{},
-        _blinkTimer{},
         _searchBox{ nullptr }
     {
         InitializeComponent();
@@ -86,6 +86,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // alive.
         _revokers.BackgroundColorChanged = _core.BackgroundColorChanged(winrt::auto_revoke, { get_weak(), &TermControl::_coreBackgroundColorChanged });
         _revokers.FontSizeChanged = _core.FontSizeChanged(winrt::auto_revoke, { get_weak(), &TermControl::_coreFontSizeChanged });
+        _revokers.FontSizePreviewChanged = _core.FontSizePreviewChanged(winrt::auto_revoke, { get_weak(), &TermControl::_coreFontSizePreviewChanged });
         _revokers.TransparencyChanged = _core.TransparencyChanged(winrt::auto_revoke, { get_weak(), &TermControl::_coreTransparencyChanged });
         _revokers.RaiseNotice = _core.RaiseNotice(winrt::auto_revoke, { get_weak(), &TermControl::_coreRaisedNotice });
         _revokers.HoveredHyperlinkChanged = _core.HoveredHyperlinkChanged(winrt::auto_revoke, { get_weak(), &TermControl::_hoveredHyperlinkChanged });
@@ -147,7 +148,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 {
                     control->_throttledUpdateScrollbar(update);
                 }
-            });
+            },
+            ScrollBarUpdateSlack);
 
         // These events might all be triggered by the connection, but that
         // should be drained and closed before we complete destruction. So these
@@ -295,32 +297,97 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         if (_showMarksInScrollbar)
         {
-            // Update scrollbar marks
-            ScrollBarCanvas().Children().Clear();
-            const auto marks{ _core.ScrollMarks() };
-            const auto fullHeight{ ScrollBarCanvas().ActualHeight() };
-            const auto totalBufferRows{ update.newMaximum + update.newViewportSize };
+            _updateScrollBarPips(update);
+        }
+    }
+
+    // Method Description:
+    // - Updates the scrollbar marks to match the marks in the buffer.
+    // - The marks are decimated to one pip per pixel row and compared against
+    //   the pips that are already drawn. Only the pips that changed are
+    //   updated, so that continuous output, which keeps triggering scrollbar
+    //   updates, doesn't recreate thousands of XAML elements each time.
+    // Arguments:
+    // - update: the scrollbar update the marks are positioned relative to.
+    void TermControl::_updateScrollBarPips(const ScrollBarUpdate& update)
+    {
+        const auto marks{ _core.ScrollMarks() };
+        const auto fullHeight{ ScrollBarCanvas().ActualHeight() };
+        const auto totalBufferRows{ update.newMaximum + update.newViewportSize };
+
+        std::vector<ScrollBarPip> pips;
+        pips.reserve(std::min<size_t>(marks.Size(), static_cast<size_t>(std::max(fullHeight, 0.0)) + 1));
 
-            for (const auto m : marks)
+        // The marks are sorted by their row. Once there are more of them
+        // than the scrollbar has pixels, many land on the same pixel row.
+        // Drawing more than one pip per row is pointless, so skip those.
+        auto lastPixelRow{ -1.0 };
+
+        for (const auto m : marks)
+        {
+            const auto markRow = m.Start.Y;
+            const auto fractionalHeight = markRow / totalBufferRows;
+            const auto pixelRow = std::floor(fractionalHeight * fullHeight);
+            if (pixelRow == lastPixelRow)
             {
-                Windows::UI::Xaml::Shapes::Rectangle r;
-                Media::SolidColorBrush brush{};
-                // Sneaky: technically, a mark doesn't need to have a color set,
-                // it might want to just use the color from the palette for that
-                // kind of mark. Fortunately, ControlCore is kind enough to
-                // pre-evaluate that for us, and shove the real value into the
-                // Color member, regardless if the mark has a literal value set.
-                brush.Color(static_cast<til::color>(m.Color.Color));
-                r.Fill(brush);
-                r.Width(16.0f / 3.0f); // pip width - 1/3rd of the scrollbar width.
-                r.Height(2);
-                const auto markRow = m.Start.Y;
-                const auto fractionalHeight = markRow / totalBufferRows;
-                const auto relativePos = fractionalHeight * fullHeight;
-                ScrollBarCanvas().Children().Append(r);
-                Windows::UI::Xaml::Controls::Canvas::SetTop(r, relativePos);
+                continue;
             }
+            lastPixelRow = pixelRow;
+
+            // Sneaky: technically, a mark doesn't need to have a color set,
+            // it might want to just use the color from the palette for that
+            // kind of mark. Fortunately, ControlCore is kind enough to
+            // pre-evaluate that for us, and shove the real value into the
+            // Color member, regardless if the mark has a literal value set.
+            pips.push_back({ pixelRow, static_cast<til::color>(m.Color.Color) });
+        }
+
+        if (pips == _scrollBarPips)
+        {
+            return;
+        }
+
+        auto children = ScrollBarCanvas().Children();
+        const auto reused = std::min(pips.size(), _scrollBarPips.size());
+
+        for (size_t i = 0; i < reused; ++i)
+        {
+            const auto& pip = pips[i];
+            const auto& oldPip = _scrollBarPips[i];
+            if (pip == oldPip)
+            {
+                continue;
+            }
+
+            const auto r = children.GetAt(gsl::narrow_cast<uint32_t>(i)).as<Windows::UI::Xaml::Shapes::Rectangle>();
+            if (pip.color != oldPip.color)
+            {
+                r.Fill().as<Media::SolidColorBrush>().Color(pip.color);
+            }
+            if (pip.top != oldPip.top)
+            {
+                Windows::UI::Xaml::Controls::Canvas::SetTop(r, pip.top);
+            }
+        }
+
+        for (auto i = reused; i < pips.size(); ++i)
+        {
+            Windows::UI::Xaml::Shapes::Rectangle r;
+            Media::SolidColorBrush brush{};
+            brush.Color(pips[i].color);
+            r.Fill(brush);
+            r.Width(16.0f / 3.0f); // pip width - 1/3rd of the scrollbar width.
+            r.Height(2);
+            children.Append(r);
+            Windows::UI::Xaml::Controls::Canvas::SetTop(r, pips[i].top);
+        }
+
+        for (auto i = reused; i < _scrollBarPips.size(); ++i)
+        {
+            children.RemoveAtEnd();
         }
+
+        _scrollBarPips = std::move(pips);
     }
 
     // Method Description:
@@ -368,7 +435,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
         else
         {
-            _core.Search(_searchBox->TextBox().Text(), goForward, false);
+            _core.Search(_searchBox->TextBox().Text(), goForward, false, false);
         }
     }
 
@@ -393,13 +460,31 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - text: the text to search
     // - goForward: boolean that represents if the current search direction is forward
     // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: boolean that represents if the text is a regular expression
     // Return Value:
     // - <none>
     void TermControl::_Search(const winrt::hstring& text,
                               const bool goForward,
-                              const bool caseSensitive)
+                              const bool caseSensitive,
+                              const bool regex)
+    {
+        _core.Search(text, goForward, caseSensitive, regex);
+    }
+
+    // Method Description:
+    // - Searches the text buffer in the background as the user types the
+    //   text to search and highlights the matches, without selecting one.
+    // Arguments:
+    // - text: the text to search
+    // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: boolean that represents if the text is a regular expression
+    // Return Value:
+    // - <none>
+    void TermControl::_SearchChanged(const winrt::hstring& text,
+                                     const bool caseSensitive,
+                                     const bool regex)
     {
-        _core.Search(text, goForward, caseSensitive);
+        _core.SearchChanged(text, caseSensitive, regex);
     }
 
     // Method Description:
@@ -414,6 +499,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                              const RoutedEventArgs& /*args*/)
     {
         _searchBox->Visibility(Visibility::Collapsed);
+        _core.ClearSearch();
 
         // Set focus back to terminal control
         this->Focus(FocusState::Programmatic);
@@ -531,6 +617,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _core.ClearBuffer(clearType);
     }
 
+    void TermControl::JumpToOutputEnd()
+    {
+        _core.JumpToOutputEnd();
+    }
+
     void TermControl::ToggleShaderEffects()
     {
         _core.ToggleShaderEffects();
@@ -591,6 +682,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _showMarksInScrollbar = settings.ShowMarks();
         // Clear out all the current marks
         ScrollBarCanvas().Children().Clear();
+        _scrollBarPips.clear();
         // When we hot reload the settings, the core will send us a scrollbar
         // update. If we enabled scrollbar marks, then great, when we handle
         // that message, we'll redraw them.
@@ -978,14 +1070,37 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         ScrollBar().LargeChange(bufferHeight); // scroll one "screenful" at a time when the scroll bar is clicked
 
         // Set up blinking cursor
+        // In remote sessions every blink would send a frame over the network, so the cursor is kept steady.
+        // Both the cursor and the blinking attributes are driven by the window's shared BlinkClock.
         int blinkTime = GetCaretBlinkTime();
+        std::shared_ptr<BlinkClock> blinkClock;
         if (blinkTime != INFINITE)
         {
-            // Create a timer
-            DispatcherTimer cursorTimer;
-            cursorTimer.Interval(std::chrono::milliseconds(blinkTime));
-            cursorTimer.Tick({ get_weak(), &TermControl::_CursorTimerTick });
-            _cursorTimer.emplace(std::move(cursorTimer));
+            blinkClock = BlinkClock::GetForCurrentThread(std::chrono::milliseconds(blinkTime));
+        }
+
+        if (blinkClock && !GetSystemMetrics(SM_REMOTESESSION))
+        {
+            _cursorTimer.emplace(
+                blinkClock,
+                [weakThis = get_weak()]() {
+                    if (const auto self = weakThis.get())
+                    {
+                        self->_CursorTimerTick();
+                    }
+                },
+                [weakThis = get_weak()]() {
+                    if (const auto self = weakThis.get())
+                    {
+                        self->_CursorTimerPaused();
+                    }
+                });
+
+            DWORD caretTimeout = 0;
+            if (SystemParametersInfoW(SPI_GETCARETTIMEOUT, 0, &caretTimeout, 0) && caretTimeout != 0 && caretTimeout != INFINITE)
+            {
+                _cursorBlinkTimeout = std::chrono::milliseconds{ caretTimeout };
+            }
             // As of GH#6586, don't start the cursor timer immediately, and
             // don't show the cursor initially. We'll show the cursor and start
             // the timer when the control is first focused.
@@ -1000,7 +1115,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             _core.CursorOn(_focused || DisplayCursorWhileBlurred);
             if (DisplayCursorWhileBlurred)
             {
-                _cursorTimer->Start();
+                _StartCursorTimer();
             }
         }
         else
@@ -1012,14 +1127,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // Set up blinking attributes
         auto animationsEnabled = TRUE;
         SystemParametersInfoW(SPI_GETCLIENTAREAANIMATION, 0, &animationsEnabled, 0);
-        if (animationsEnabled && blinkTime != INFINITE)
+        if (animationsEnabled && blinkClock)
         {
-            // Create a timer
-            DispatcherTimer blinkTimer;
-            blinkTimer.Interval(std::chrono::milliseconds(blinkTime));
-            blinkTimer.Tick({ get_weak(), &TermControl::_BlinkTimerTick });
-            blinkTimer.Start();
-            _blinkTimer.emplace(std::move(blinkTimer));
+            _blinkTimer.emplace(blinkClock, [weakThis = get_weak()]() {
+                if (const auto self = weakThis.get())
+                {
+                    self->_BlinkTimerTick();
+                }
+            });
+            _blinkTimer->Start();
         }
         else
         {
@@ -1356,7 +1472,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             // Manually show the cursor when a key is pressed. Restarting
             // the timer prevents flickering.
             _core.CursorOn(_core.SelectionMode() != SelectionInteractionMode::Mark);
-            _cursorTimer->Start();
+            _StartCursorTimer();
         }
 
         return handled;
@@ -1831,7 +1947,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         {
             // When the terminal focuses, show the cursor immediately
             _core.CursorOn(_core.SelectionMode() != SelectionInteractionMode::Mark);
-            _cursorTimer->Start();
+            _StartCursorTimer();
         }
 
         if (_blinkTimer)
@@ -1955,25 +2071,52 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     // Method Description:
     // - Toggle the cursor on and off when called by the cursor blink timer.
-    // Arguments:
-    // - sender: not used
-    // - e: not used
-    void TermControl::_CursorTimerTick(const Windows::Foundation::IInspectable& /* sender */,
-                                       const Windows::Foundation::IInspectable& /* e */)
+    void TermControl::_CursorTimerTick()
+    {
+        if (_IsClosing())
+        {
+            return;
+        }
+
+        if (_cursorBlinkTimeout && std::chrono::steady_clock::now() >= _cursorBlinkDeadline)
+        {
+            // We're idle. Each blink costs us a frame, so instead of blinking
+            // indefinitely the cursor stays visible until the next input.
+            _cursorTimer->Stop();
+            _core.CursorOn(_core.SelectionMode() != SelectionInteractionMode::Mark);
+            return;
+        }
+
+        _core.BlinkCursor();
+    }
+
+    // Method Description:
+    // - Called when the window's BlinkClock got paused, because the window
+    //   became inactive or hidden. Leaves the cursor visible instead of
+    //   freezing it in whatever phase it was in.
+    void TermControl::_CursorTimerPaused()
     {
         if (!_IsClosing())
         {
-            _core.BlinkCursor();
+            _core.CursorOn(_core.SelectionMode() != SelectionInteractionMode::Mark);
+        }
+    }
+
+    // Method Description:
+    // - (Re)starts the cursor blink timer and with it the caret timeout
+    //   after which the cursor stops blinking.
+    void TermControl::_StartCursorTimer()
+    {
+        _cursorTimer->Start();
+        if (_cursorBlinkTimeout)
+        {
+            _cursorBlinkDeadline = std::chrono::steady_clock::now() + *_cursorBlinkTimeout;
         }
     }
 
     // Method Description:
     // - Toggle the blinking rendition state when called by the blink timer.
-    // Arguments:
-    // - sender: not used
-    // - e: not used
-    void TermControl::_BlinkTimerTick(const Windows::Foundation::IInspectable& /* sender */,
-                                      const Windows::Foundation::IInspectable& /* e */)
+    void TermControl::_BlinkTimerTick()
     {
         if (!_IsClosing())
         {
@@ -2394,6 +2537,44 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _core.WindowVisibilityChanged(showOrHide);
     }
 
+    // Method Description:
+    // - Forwards the session (un)lock down into the control core, which stops
+    //   painting while the session is locked.
+    // Arguments:
+    // - locked: true if the session got locked, false once it's unlocked.
+    void TermControl::SessionLockChanged(const bool locked)
+    {
+        _core.SessionLockChanged(locked);
+    }
+
+    // Method Description:
+    // - Pauses or resumes the cursor and text blinking of all controls in the
+    //   calling thread's window. The window calls this while it's inactive or
+    //   hidden, so that it doesn't keep waking up to draw frames nobody sees.
+    // Arguments:
+    // - paused: true to stop all blinking, false to resume it.
+    void TermControl::PauseAnimations(const bool paused)
+    {
+        BlinkClock::PauseForCurrentThread(paused);
+    }
+
+    // Method Description:
+    // - Notifies the core that the tab we're in was hidden or shown. See ControlCore::SetInBackground.
+    void TermControl::SetInBackground(const bool inBackground)
+    {
+        _core.SetInBackground(inBackground);
+    }
+
+    Control::MemoryUsage TermControl::GetMemoryUsage() const
+    {
+        return _core.GetMemoryUsage();
+    }
+
+    void TermControl::TrimMemory()
+    {
+        _core.TrimMemory();
+    }
+
     // Method Description:
     // - Create XAML Thickness object based on padding props provided.
     //   Used for controlling the TermControl XAML Grid container's Padding prop.
@@ -3242,6 +3423,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         scaleMarker(SelectionStartMarker());
         scaleMarker(SelectionEndMarker());
 
+        // The new font size has been applied, so any zoom preview is no longer needed.
+        SwapChainPanel().RenderTransform(nullptr);
+
         // Don't try to inspect the core here. The Core is raising this while
         // it's holding its write lock. If the handlers calls back to some
         // method on the TermControl on the same thread, and that _method_ calls
@@ -3249,6 +3433,21 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _FontSizeChangedHandlers(fontWidth, fontHeight, isInitialChange);
     }
 
+    // Method Description:
+    // - While zooming, the core applies the new font size only every so often.
+    //   In the meantime we scale the last frame, so that zooming still feels
+    //   responsive. The transform is removed again in _coreFontSizeChanged.
+    void TermControl::_coreFontSizePreviewChanged(const IInspectable& /*sender*/,
+                                                  const IInspectable& /*args*/)
+    {
+        const auto scale = _core.FontSizePreviewScale();
+
+        Windows::UI::Xaml::Media::ScaleTransform transform;
+        transform.ScaleX(scale);
+        transform.ScaleY(scale);
+        SwapChainPanel().RenderTransform(transform);
+    }
+
     void TermControl::_coreRaisedNotice(const IInspectable& /*sender*/,
                                         const Control::NoticeEventArgs& eventArgs)
     {
@@ -3311,6 +3510,21 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         return _core.ReadEntireBuffer();
     }
 
+    void TermControl::ExportToPath(const winrt::hstring& path) const
+    {
+        _core.ExportToPath(path);
+    }
+
+    void TermControl::PersistToPath(const winrt::hstring& path) const
+    {
+        _core.PersistToPath(path);
+    }
+
+    void TermControl::RestoreFromPath(const winrt::hstring& path) const
+    {
+        _core.RestoreFromPath(path);
+    }
+
     Core::Scheme TermControl::ColorScheme() const noexcept
     {
         return _core.ColorScheme();
@@ -3365,6 +3579,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 args.FoundMatch() ? RS_(L"SearchBox_MatchesAvailable") : RS_(L"SearchBox_NoMatches"), // what to announce if results were found
                 L"SearchBoxResultAnnouncement" /* unique name for this group of notifications */);
         }
+
+        if (_searchBox)
+        {
+            _searchBox->SetStatus(args.TotalMatches(), args.CurrentMatch());
+        }
     }
 
     void TermControl::OwningHwnd(uint64_t owner)
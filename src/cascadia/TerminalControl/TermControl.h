@@ -6,6 +6,7 @@
 #include "TermControl.g.h"
 #include "XamlLights.h"
 #include "EventArgs.h"
+#include "BlinkClock.h"
 #include "../../renderer/base/Renderer.hpp"
 #include "../../renderer/dx/DxRenderer.hpp"
 #include "../../renderer/uia/UiaRenderer.hpp"
@@ -52,6 +53,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         float SnapDimensionToGrid(const bool widthOrHeight, const float dimension);
 
         void WindowVisibilityChanged(const bool showOrHide);
+        void SessionLockChanged(const bool locked);
+        void SetInBackground(const bool inBackground);
+        Control::MemoryUsage GetMemoryUsage() const;
+        void TrimMemory();
 
         void ColorSelection(Control::SelectionColor fg, Control::SelectionColor bg, Core::MatchMode matchMode);
 
@@ -97,6 +102,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void SendInput(const winrt::hstring& input);
         void ClearBuffer(Control::ClearBufferType clearType);
+        void JumpToOutputEnd();
 
         void ToggleShaderEffects();
 
@@ -138,8 +144,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         static Control::MouseButtonState GetPressedMouseButtons(const winrt::Windows::UI::Input::PointerPoint point);
         static unsigned int GetPointerUpdateKind(const winrt::Windows::UI::Input::PointerPoint point);
         static Windows::UI::Xaml::Thickness ParseThicknessFromPadding(const hstring padding);
+        static void PauseAnimations(bool paused);
 
         hstring ReadEntireBuffer() const;
+        void ExportToPath(const winrt::hstring& path) const;
+        void PersistToPath(const winrt::hstring& path) const;
+        void RestoreFromPath(const winrt::hstring& path) const;
 
         winrt::Microsoft::Terminal::Core::Scheme ColorScheme() const noexcept;
         void ColorScheme(const winrt::Microsoft::Terminal::Core::Scheme& scheme) const noexcept;
@@ -235,12 +245,26 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         winrt::Windows::UI::Composition::ScalarKeyFrameAnimation _bellDarkAnimation{ nullptr };
         Windows::UI::Xaml::DispatcherTimer _bellLightTimer{ nullptr };
 
-        std::optional<Windows::UI::Xaml::DispatcherTimer> _cursorTimer;
-        std::optional<Windows::UI::Xaml::DispatcherTimer> _blinkTimer;
+        std::optional<BlinkClock::Subscription> _cursorTimer;
+        std::optional<BlinkClock::Subscription> _blinkTimer;
+        // Just like the system caret, the cursor stops blinking if there's no input for this long.
+        std::optional<std::chrono::milliseconds> _cursorBlinkTimeout;
+        std::chrono::steady_clock::time_point _cursorBlinkDeadline;
 
         winrt::Windows::UI::Xaml::Controls::SwapChainPanel::LayoutUpdated_revoker _layoutUpdatedRevoker;
         bool _showMarksInScrollbar{ false };
 
+        // The pips currently drawn in the ScrollBarCanvas, one per pixel row at most.
+        // The canvas children are only touched where the newly computed pips differ from these.
+        struct ScrollBarPip
+        {
+            double top;
+            til::color color;
+
+            bool operator==(const ScrollBarPip&) const = default;
+        };
+        std::vector<ScrollBarPip> _scrollBarPips;
+
         bool _isBackgroundLight{ false };
         bool _detached{ false };
 
@@ -301,8 +325,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         winrt::fire_and_forget _HyperlinkHandler(Windows::Foundation::IInspectable sender, Control::OpenHyperlinkEventArgs e);
 
-        void _CursorTimerTick(const Windows::Foundation::IInspectable& sender, const Windows::Foundation::IInspectable& e);
-        void _BlinkTimerTick(const Windows::Foundation::IInspectable& sender, const Windows::Foundation::IInspectable& e);
+        void _CursorTimerTick();
+        void _CursorTimerPaused();
+        void _StartCursorTimer();
+        void _BlinkTimerTick();
         void _BellLightOff(const Windows::Foundation::IInspectable& sender, const Windows::Foundation::IInspectable& e);
 
         void _SetEndSelectionPointAtCursor(const Windows::Foundation::Point& cursorPosition);
@@ -333,7 +359,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         double _GetAutoScrollSpeed(double cursorDistanceFromBorder) const;
 
-        void _Search(const winrt::hstring& text, const bool goForward, const bool caseSensitive);
+        void _Search(const winrt::hstring& text, const bool goForward, const bool caseSensitive, const bool regex);
+        void _SearchChanged(const winrt::hstring& text, const bool caseSensitive, const bool regex);
         void _CloseSearchBoxControl(const winrt::Windows::Foundation::IInspectable& sender, const Windows::UI::Xaml::RoutedEventArgs& args);
 
         // TSFInputControl Handlers
@@ -347,6 +374,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _coreFontSizeChanged(const int fontWidth,
                                   const int fontHeight,
                                   const bool isInitialChange);
+        void _coreFontSizePreviewChanged(const IInspectable& sender, const IInspectable& args);
         winrt::fire_and_forget _coreTransparencyChanged(IInspectable sender, Control::TransparencyChangedEventArgs args);
         void _coreRaisedNotice(const IInspectable& s, const Control::NoticeEventArgs& args);
         void _coreWarningBell(const IInspectable& sender, const IInspectable& args);
@@ -354,6 +382,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         til::point _toPosInDips(const Core::Point terminalCellPos);
         void _throttledUpdateScrollbar(const ScrollBarUpdate& update);
+        void _updateScrollBarPips(const ScrollBarUpdate& update);
 
         void _contextMenuHandler(IInspectable sender, Control::ContextMenuRequestedEventArgs args);
         void _showContextMenuAt(const til::point& controlRelativePos);
@@ -373,6 +402,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             Control::ControlCore::RendererEnteredErrorState_revoker RendererEnteredErrorState;
             Control::ControlCore::BackgroundColorChanged_revoker BackgroundColorChanged;
             Control::ControlCore::FontSizeChanged_revoker FontSizeChanged;
+            Control::ControlCore::FontSizePreviewChanged_revoker FontSizePreviewChanged;
             Control::ControlCore::TransparencyChanged_revoker TransparencyChanged;
             Control::ControlCore::RaiseNotice_revoker RaiseNotice;
             Control::ControlCore::HoveredHyperlinkChanged_revoker HoveredHyperlinkChanged;
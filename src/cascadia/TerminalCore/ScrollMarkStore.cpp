@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "ScrollMarkStore.hpp"
+
+using namespace Microsoft::Terminal::Core;
+
+// Once the buffer has been rotated this far in total, the stored marks get rebased back to 0,
+// so that their absolute coordinates never overflow. This keeps Rotate() amortized O(1).
+static constexpr til::CoordType rebaseThreshold = 1 << 30;
+
+bool ScrollMarkStore::Empty() const noexcept
+{
+    return _entries.empty();
+}
+
+size_t ScrollMarkStore::Size() const noexcept
+{
+    return _entries.size();
+}
+
+// Routine Description:
+// - Inserts the given mark, while keeping the marks ordered by their start position.
+//   Marks with identical start positions remain in the order they were added in.
+//   Since marks are usually added at the bottom of the buffer, this is amortized O(1).
+// Arguments:
+// - mark - The mark to add, in buffer-relative coordinates.
+// - makeCurrent - If true, the mark becomes the one modified by ModifyCurrent().
+// Return Value:
+// - <none>
+void ScrollMarkStore::Add(const ScrollMark& mark, const bool makeCurrent)
+{
+    const auto absolute = _toAbsolute(mark);
+    const auto id = _nextId++;
+
+    auto it = _entries.end();
+    if (!_entries.empty() && absolute.start < _entries.back().mark.start)
+    {
+        it = std::upper_bound(_entries.begin(), _entries.end(), absolute.start, [](const til::point& start, const Entry& entry) {
+            return start < entry.mark.start;
+        });
+    }
+    _entries.insert(it, Entry{ absolute, id });
+
+    if (makeCurrent)
+    {
+        _currentId = id;
+        _currentStart = absolute.start;
+    }
+}
+
+bool ScrollMarkStore::HasCurrent() const noexcept
+{
+    return _currentId != 0;
+}
+
+// Routine Description:
+// - Needs to be called whenever the TextBuffer's circular buffer is rotated.
+//   Drops all marks that have scrolled out of the buffer.
+// Arguments:
+// - delta - The number of rows the buffer was rotated by.
+// Return Value:
+// - <none>
+void ScrollMarkStore::Rotate(const til::CoordType delta)
+{
+    _origin += delta;
+
+    while (!_entries.empty() && _entries.front().mark.start.y < _origin)
+    {
+        if (_entries.front().id == _currentId)
+        {
+            _currentId = 0;
+        }
+        _entries.pop_front();
+    }
+
+    if (_origin >= rebaseThreshold)
+    {
+        _rebase();
+    }
+}
+
+void ScrollMarkStore::Clear() noexcept
+{
+    _entries.clear();
+    _origin = 0;
+    _currentId = 0;
+}
+
+// Routine Description:
+// - Returns all marks in buffer-relative coordinates, ordered by their start position.
+std::vector<ScrollMarkStore::ScrollMark> ScrollMarkStore::GetAll() const
+{
+    std::vector<ScrollMark> marks;
+    marks.reserve(_entries.size());
+    for (const auto& entry : _entries)
+    {
+        marks.emplace_back(_toRelative(entry.mark));
+    }
+    return marks;
+}
+
+// Routine Description:
+// - Returns the marks that start in the rows [top, bottom), for instance those in the viewport.
+// Arguments:
+// - top, bottom - The buffer-relative rows to return the marks of.
+// Return Value:
+// - The marks in buffer-relative coordinates, ordered by their start position.
+std::vector<ScrollMarkStore::ScrollMark> ScrollMarkStore::GetRange(const til::CoordType top, const til::CoordType bottom) const
+{
+    std::vector<ScrollMark> marks;
+    const auto end = _lowerBound(bottom);
+    for (auto it = _lowerBound(top); it < end; ++it)
+    {
+        marks.emplace_back(_toRelative(it->mark));
+    }
+    return marks;
+}
+
+// Routine Description:
+// - Returns the first mark starting below the given row, if any.
+std::optional<ScrollMarkStore::ScrollMark> ScrollMarkStore::GetAfter(const til::CoordType y) const
+{
+    const auto it = _lowerBound(int64_t{ y } + 1);
+    if (it == _entries.end())
+    {
+        return std::nullopt;
+    }
+    return _toRelative(it->mark);
+}
+
+// Routine Description:
+// - Returns the last mark starting above the given row, if any.
+std::optional<ScrollMarkStore::ScrollMark> ScrollMarkStore::GetBefore(const til::CoordType y) const
+{
+    const auto it = _lowerBound(y);
+    if (it == _entries.begin())
+    {
+        return std::nullopt;
+    }
+    return _toRelative(std::prev(it)->mark);
+}
+
+ScrollMarkStore::ScrollMark ScrollMarkStore::_toAbsolute(ScrollMark mark) const noexcept
+{
+    mark.start.y += _origin;
+    mark.end.y += _origin;
+    if (mark.commandEnd)
+    {
+        mark.commandEnd->y += _origin;
+    }
+    if (mark.outputEnd)
+    {
+        mark.outputEnd->y += _origin;
+    }
+    return mark;
+}
+
+ScrollMarkStore::ScrollMark ScrollMarkStore::_toRelative(ScrollMark mark) const noexcept
+{
+    mark.start.y -= _origin;
+    mark.end.y -= _origin;
+    if (mark.commandEnd)
+    {
+        mark.commandEnd->y -= _origin;
+    }
+    if (mark.outputEnd)
+    {
+        mark.outputEnd->y -= _origin;
+    }
+    return mark;
+}
+
+// Returns the first entry whose start is in or below the given buffer-relative row.
+// The row is 64-bit so that callers can safely pass til::CoordTypeMax + 1 and similar.
+ScrollMarkStore::const_iterator ScrollMarkStore::_lowerBound(const int64_t y) const noexcept
+{
+    const auto absoluteY = y + _origin;
+    return std::lower_bound(_entries.begin(), _entries.end(), absoluteY, [](const Entry& entry, const int64_t y) {
+        return entry.mark.start.y < y;
+    });
+}
+
+ScrollMarkStore::iterator ScrollMarkStore::_findCurrent() noexcept
+{
+    if (!_currentId)
+    {
+        return _entries.end();
+    }
+
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), _currentStart, [](const Entry& entry, const til::point& start) {
+        return entry.mark.start < start;
+    });
+    for (; it != _entries.end() && it->mark.start == _currentStart; ++it)
+    {
+        if (it->id == _currentId)
+        {
+            return it;
+        }
+    }
+    return _entries.end();
+}
+
+// Moves the origin of the absolute coordinates back to 0. This is O(n), but only
+// happens once every rebaseThreshold rows.
+void ScrollMarkStore::_rebase() noexcept
+{
+    for (auto& entry : _entries)
+    {
+        entry.mark.start.y -= _origin;
+        entry.mark.end.y -= _origin;
+        if (entry.mark.commandEnd)
+        {
+            entry.mark.commandEnd->y -= _origin;
+        }
+        if (entry.mark.outputEnd)
+        {
+            entry.mark.outputEnd->y -= _origin;
+        }
+    }
+    _currentStart.y -= _origin;
+    _origin = 0;
+}
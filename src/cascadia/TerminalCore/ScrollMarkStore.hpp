@@ -0,0 +1,98 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollMarkStore.hpp
+
+Abstract:
+- Stores the scroll marks of a Terminal, ordered by their start position.
+- The marks are stored in absolute coordinates, which don't change when the
+  TextBuffer's circular buffer is rotated. Instead, the store keeps track of how
+  far the buffer was rotated in total and translates positions on the way in and
+  out. Rotating the buffer then only needs to drop the marks that have scrolled
+  out of it, all of which are at the front.
+--*/
+
+#pragma once
+
+#include "../../terminal/adapter/DispatchTypes.hpp"
+
+namespace Microsoft::Terminal::Core
+{
+    class ScrollMarkStore final
+    {
+    public:
+        using ScrollMark = Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark;
+
+        bool Empty() const noexcept;
+        size_t Size() const noexcept;
+
+        void Add(const ScrollMark& mark, const bool makeCurrent);
+        bool HasCurrent() const noexcept;
+        void Rotate(const til::CoordType delta);
+        void Clear() noexcept;
+
+        std::vector<ScrollMark> GetAll() const;
+        std::vector<ScrollMark> GetRange(const til::CoordType top, const til::CoordType bottom) const;
+        std::optional<ScrollMark> GetAfter(const til::CoordType y) const;
+        std::optional<ScrollMark> GetBefore(const til::CoordType y) const;
+
+        // Calls func with the current mark, which is the one most recently added with makeCurrent.
+        // Shell integration uses this to fill in the mark's command and output as they arrive.
+        // func must not modify the mark's start, as that's what the marks are ordered by.
+        template<typename Func>
+        bool ModifyCurrent(Func&& func)
+        {
+            const auto it = _findCurrent();
+            if (it == _entries.end())
+            {
+                return false;
+            }
+            auto mark = _toRelative(it->mark);
+            func(mark);
+            it->mark = _toAbsolute(mark);
+            return true;
+        }
+
+        // Removes all marks for which pred returns true. This is O(n).
+        template<typename Pred>
+        void EraseIf(Pred&& pred)
+        {
+            std::erase_if(_entries, [&](const Entry& entry) {
+                const auto erase = pred(_toRelative(entry.mark));
+                if (erase && entry.id == _currentId)
+                {
+                    _currentId = 0;
+                }
+                return erase;
+            });
+        }
+
+    private:
+        struct Entry
+        {
+            ScrollMark mark;
+            // Used to find the current mark again, since multiple marks may start at the same position.
+            uint64_t id;
+        };
+
+        using iterator = std::deque<Entry>::iterator;
+        using const_iterator = std::deque<Entry>::const_iterator;
+
+        ScrollMark _toAbsolute(ScrollMark mark) const noexcept;
+        ScrollMark _toRelative(ScrollMark mark) const noexcept;
+        const_iterator _lowerBound(const int64_t y) const noexcept;
+        iterator _findCurrent() noexcept;
+        void _rebase() noexcept;
+
+        std::deque<Entry> _entries;
+        // The sum of all deltas passed to Rotate() since the last _rebase().
+        // Adding it to a buffer-relative row results in an absolute one.
+        til::CoordType _origin = 0;
+        uint64_t _nextId = 1;
+        // The id of the current mark or 0 if there's none.
+        uint64_t _currentId = 0;
+        til::point _currentStart;
+    };
+}
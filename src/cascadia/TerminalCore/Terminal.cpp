@@ -8,7 +8,9 @@
 #include "../../inc/unicode.hpp"
 #include "../../types/inc/utils.hpp"
 #include "../../types/inc/colorTable.hpp"
+#include "../../buffer/out/BufferSnapshot.hpp"
 #include "../../buffer/out/search.h"
+#include "../../renderer/base/renderer.hpp"
 
 #include <winrt/Microsoft.Terminal.Core.h>
 
@@ -105,7 +107,7 @@ void Terminal::UpdateSettings(ICoreSettings settings)
 
     _snapOnInput = settings.SnapOnInput();
     _altGrAliasing = settings.AltGrAliasing();
-    _wordDelimiters = settings.WordDelimiters();
+    _wordDelimiters = WordDelimiters{ settings.WordDelimiters() };
     _suppressApplicationTitle = settings.SuppressApplicationTitle();
     _startingTitle = settings.StartingTitle();
     _trimBlockSelection = settings.TrimBlockSelection();
@@ -253,6 +255,81 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
 //      appropriate HRESULT for failing to resize.
 [[nodiscard]] HRESULT Terminal::UserResize(const til::size viewportSize) noexcept
 {
+    return _UserResize(viewportSize, false);
+}
+
+// Method Description:
+// - Resize the terminal while the user is still in the process of resizing it,
+//   for instance by dragging the window border.
+// - Reflowing the entire scrollback during each step of the resize is expensive,
+//   so this only reflows the viewport and the few viewports of scrollback above it.
+//   The remaining scrollback is put aside at its original width and reflowed by
+//   FinishLiveResize() once the resize has settled, or when it's scrolled into view.
+// Arguments:
+// - viewportSize: the new size of the viewport, in chars
+// Return Value:
+// - See UserResize()
+[[nodiscard]] HRESULT Terminal::LiveResize(const til::size viewportSize) noexcept
+{
+    return _UserResize(viewportSize, true);
+}
+
+// Method Description:
+// - Reflows the scrollback that LiveResize() put aside into the current buffer
+//   and reattaches it above the rest of the buffer. Does nothing if there's none.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::FinishLiveResize() noexcept
+try
+{
+    if (!_deferredHistory)
+    {
+        return;
+    }
+
+    const auto history = std::move(_deferredHistory);
+    const auto viewportSize = _mutableViewport.Dimensions();
+    const auto bufferSize = _mainBuffer->GetSize().Dimensions();
+
+    auto newTextBuffer = std::make_unique<TextBuffer>(bufferSize,
+                                                      TextAttribute{},
+                                                      0,
+                                                      _mainBuffer->IsActiveBuffer(),
+                                                      _mainBuffer->GetRenderer());
+    const auto offset = TextBuffer::ReflowWithHistory(*history,
+                                                      _deferredHistoryRows,
+                                                      *_mainBuffer,
+                                                      _mutableViewport.BottomExclusive(),
+                                                      *newTextBuffer);
+    newTextBuffer->SetCurrentAttributes(_mainBuffer->GetCurrentAttributes());
+
+    // The selection was made in the coordinates of the old buffer.
+    ClearSelection();
+
+    const auto newTop = std::clamp(_mutableViewport.Top() + offset, 0, bufferSize.height - viewportSize.height);
+    _mutableViewport = Viewport::FromDimensions({ 0, newTop }, viewportSize);
+    _scrollOffset = std::min(_scrollOffset, newTop);
+
+    _mainBuffer.swap(newTextBuffer);
+
+    if (!_inAltBuffer())
+    {
+        _mainBuffer->TriggerRedrawAll();
+    }
+    _NotifyScrollEvent();
+}
+CATCH_LOG()
+
+[[nodiscard]] HRESULT Terminal::_UserResize(const til::size viewportSize, const bool deferScrollback) noexcept
+{
+    // A regular resize reflows the entire scrollback and so it needs all of it.
+    if (!deferScrollback)
+    {
+        FinishLiveResize();
+    }
+
     const auto oldDimensions = _GetMutableViewport().Dimensions();
     if (viewportSize == oldDimensions)
     {
@@ -306,6 +383,7 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
 
     // First allocate a new text buffer to take the place of the current one.
     std::unique_ptr<TextBuffer> newTextBuffer;
+    til::CoordType deferredRows = 0;
     try
     {
         // GH#3848 - Stash away the current attributes the old text buffer is
@@ -337,11 +415,20 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
         oldRows.mutableViewportTop = oldViewportTop;
         oldRows.visibleViewportTop = newVisibleTop;
 
+        // During a live resize, the rows far above the visible region are left behind. Once they've
+        // been put aside, the buffer only holds a few viewports of scrollback and can be reflowed in full.
+        if (deferScrollback && !_deferredHistory)
+        {
+            const auto keepTop = std::min(oldViewportTop, newVisibleTop) - oldDimensions.height * _hotScrollbackViewports;
+            deferredRows = keepTop > 0 ? _mainBuffer->GetReflowStart(keepTop) : 0;
+        }
+
         const std::optional oldViewStart{ oldViewportTop };
         RETURN_IF_FAILED(TextBuffer::Reflow(*_mainBuffer.get(),
                                             *newTextBuffer.get(),
                                             _mutableViewport,
-                                            { oldRows }));
+                                            { oldRows },
+                                            deferredRows));
 
         newViewportTop = oldRows.mutableViewportTop;
         newVisibleTop = oldRows.visibleViewportTop;
@@ -456,6 +543,13 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
 
     _mainBuffer.swap(newTextBuffer);
 
+    if (deferredRows > 0)
+    {
+        newTextBuffer->SetAsActiveBuffer(false);
+        _deferredHistory = std::move(newTextBuffer);
+        _deferredHistoryRows = deferredRows;
+    }
+
     // GH#3494: Maintain scrollbar position during resize
     // Make sure that we don't scroll past the mutableViewport at the bottom of the buffer
     newVisibleTop = std::min(newVisibleTop, _mutableViewport.Top());
@@ -478,13 +572,39 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
 }
 
 void Terminal::Write(std::wstring_view stringView)
+{
+    _Write(std::span<const std::wstring_view>{ &stringView, 1 });
+}
+
+void Terminal::Write(std::string_view stringView)
+{
+    _Write(std::span<const std::string_view>{ &stringView, 1 });
+}
+
+void Terminal::Write(std::span<const std::string_view> strings)
+{
+    _Write(strings);
+}
+
+template<typename T>
+void Terminal::_Write(std::span<const T> strings)
 {
     auto lock = LockForWriting();
 
     const auto& cursor = _activeBuffer().GetCursor();
     const til::point cursorPosBefore{ cursor.GetPosition() };
 
-    _stateMachine->ProcessString(stringView);
+    for (const auto& stringView : strings)
+    {
+        ::Microsoft::Console::Render::PerfCounters::Add(_activeBuffer().GetRenderer().GetPerfCounters().parsedBytes, stringView.size() * sizeof(stringView[0]));
+        _stateMachine->ProcessString(stringView);
+    }
+
+    if (!_inAltBuffer())
+    {
+        const auto visibleTop = std::min(_VisibleStartIndex(), _mutableViewport.Top());
+        _mainBuffer->CompactScrollback(visibleTop - _mutableViewport.Height() * _hotScrollbackViewports);
+    }
 
     const til::point cursorPosAfter{ cursor.GetPosition() };
 
@@ -496,6 +616,45 @@ void Terminal::Write(std::wstring_view stringView)
     }
 }
 
+void Terminal::TrimMemory(const bool compactText)
+{
+    // The viewport and the selection are going to be accessed again as
+    // soon as we're shown again. Everything else can be released.
+    std::vector<til::point_span> inUse;
+    inUse.push_back({ { 0, _mutableViewport.Top() }, { 0, _mutableViewport.BottomInclusive() } });
+
+    if (!_inAltBuffer())
+    {
+        inUse.push_back({ { 0, _VisibleStartIndex() }, { 0, _VisibleEndIndex() } });
+        if (_selection)
+        {
+            inUse.push_back({ _selection->start, _selection->end });
+        }
+    }
+
+    _mainBuffer->TrimMemory(inUse, compactText);
+}
+
+size_t Terminal::GetMemoryUsage() const noexcept
+{
+    size_t usage = 0;
+    if (_mainBuffer)
+    {
+        usage += _mainBuffer->GetMemoryUsage();
+    }
+    if (_altBuffer)
+    {
+        usage += _altBuffer->GetMemoryUsage();
+    }
+
+    // The tree only spans the viewport, so counting its intervals is cheap.
+    size_t patterns = 0;
+    _patternIntervalTree.visit_all([&](const auto&) { ++patterns; });
+    usage += patterns * sizeof(decltype(_patternIntervalTree)::interval);
+
+    return usage;
+}
+
 void Terminal::WritePastedText(std::wstring_view stringView)
 {
     const auto option = ::Microsoft::Console::Utils::FilterOption::CarriageReturnNewline |
@@ -591,22 +750,11 @@ std::wstring Terminal::GetHyperlinkAtBufferPosition(const til::point bufferPos)
             result->stop = _ConvertToBufferCell(result->stop);
         }
     }
-    else
+    else if (_detectURLs)
     {
         // Hyperlink is outside of the current view.
         // We need to find if there's a pattern at that location.
-        const auto patterns = _activeBuffer().GetPatterns(bufferPos.y, bufferPos.y);
-
-        // NOTE: patterns is stored with top y-position being 0,
-        //       so we need to cleverly set the y-pos to 0.
-        const til::point viewportPos{ bufferPos.x, 0 };
-        const auto results = patterns.findOverlapping(viewportPos, viewportPos);
-        if (!results.empty())
-        {
-            result = results.front();
-            result->start.y += bufferPos.y;
-            result->stop.y += bufferPos.y;
-        }
+        result = _activeBuffer().GetUrlAt(bufferPos, _hyperlinkPatternId);
     }
 
     // Case 2 - Step 2: get the auto-detected hyperlink
@@ -654,6 +802,19 @@ std::optional<PointTree::interval> Terminal::GetHyperlinkIntervalFromViewportPos
             }
         }
     }
+
+    // The tree is cleared while scrolling and only rebuilt after a delay.
+    // Until then we ask the buffer directly, so that hovering URLs keeps working.
+    if (_detectURLs && !_patternIntervalTreeValid)
+    {
+        if (auto result = _activeBuffer().GetUrlAt(_ConvertToBufferCell(viewportPos), _hyperlinkPatternId))
+        {
+            const auto viewportTop = _VisibleStartIndex();
+            result->start.y -= viewportTop;
+            result->stop.y -= viewportTop;
+            return result;
+        }
+    }
     return std::nullopt;
 }
 
@@ -990,13 +1151,14 @@ WORD Terminal::_TakeVirtualKeyFromLastKeyEvent(const WORD scanCode) noexcept
 }
 
 // Method Description:
-// - Acquire a read lock on the terminal.
+// - Acquire a read lock on the terminal. Other readers may hold it at the same time,
+//      but writers wait until all readers that arrived before them released it.
 // Return Value:
 // - a shared_lock which can be used to unlock the terminal. The shared_lock
 //      will release this lock when it's destructed.
-[[nodiscard]] std::unique_lock<til::recursive_ticket_lock> Terminal::LockForReading()
+[[nodiscard]] std::shared_lock<til::recursive_ticket_lock> Terminal::LockForReading()
 {
-    return std::unique_lock{ _readWriteLock };
+    return std::shared_lock{ _readWriteLock };
 }
 
 // Method Description:
@@ -1009,6 +1171,11 @@ WORD Terminal::_TakeVirtualKeyFromLastKeyEvent(const WORD scanCode) noexcept
     return std::unique_lock{ _readWriteLock };
 }
 
+[[nodiscard]] std::unique_lock<til::recursive_ticket_lock> Terminal::TryLockForWriting()
+{
+    return std::unique_lock{ _readWriteLock, std::try_to_lock };
+}
+
 // Method Description:
 // - Get a reference to the terminal's read/write lock.
 // Return Value:
@@ -1091,7 +1258,16 @@ void Terminal::UserScrollViewport(const int viewTop)
     // we're going to modify state here that the renderer could be reading.
     auto lock = LockForWriting();
 
-    const auto clampedNewTop = std::max(0, viewTop);
+    auto clampedNewTop = std::max(0, viewTop);
+
+    // The user is about to scroll past the scrollback that LiveResize() kept around.
+    if (_deferredHistory && clampedNewTop < _mutableViewport.Height())
+    {
+        const auto oldTop = _mutableViewport.Top();
+        FinishLiveResize();
+        clampedNewTop += _mutableViewport.Top() - oldTop;
+    }
+
     const auto realTop = ViewStartIndex();
     const auto newDelta = realTop - clampedNewTop;
     // if viewTop > realTop, we want the offset to be 0.
@@ -1222,6 +1398,7 @@ void Terminal::UpdatePatternsUnderLock()
 {
     auto oldTree = _patternIntervalTree;
     _patternIntervalTree = _activeBuffer().GetPatterns(_VisibleStartIndex(), _VisibleEndIndex());
+    _patternIntervalTreeValid = true;
     _InvalidatePatternTree(oldTree);
     _InvalidatePatternTree(_patternIntervalTree);
 }
@@ -1234,9 +1411,42 @@ void Terminal::ClearPatternTree()
 {
     auto oldTree = _patternIntervalTree;
     _patternIntervalTree = {};
+    _patternIntervalTreeValid = false;
     _InvalidatePatternTree(oldTree);
 }
 
+// Method Description:
+// - Adds matches of the search in progress to the highlighted ones.
+//   They need to follow the existing ones, so that all of them remain in order.
+// Arguments:
+// - highlights - The matches to add, in buffer coordinates
+void Terminal::AppendSearchHighlights(std::span<const til::point_span> highlights)
+{
+    _searchHighlights.insert(_searchHighlights.end(), highlights.begin(), highlights.end());
+    _InvalidateSearchHighlights(highlights);
+}
+
+void Terminal::ClearSearchHighlights()
+{
+    _InvalidateSearchHighlights(_searchHighlights);
+    _searchHighlights.clear();
+}
+
+// Method Description:
+// - Returns the number of rows the buffer was rotated by so far, which lets
+//   callers translate buffer rows they held on to into the current ones.
+int64_t Terminal::GetBufferRotationCount() const noexcept
+{
+    return _bufferRotationCount;
+}
+
+// Redraws the given highlights, as far as they're visible. Unlike _InvalidateFromCoords()
+// this leaves the text underneath alone, if the render engine draws them on a layer of their own.
+void Terminal::_InvalidateSearchHighlights(std::span<const til::point_span> highlights)
+{
+    _activeBuffer().TriggerRedrawSearchHighlights(highlights);
+}
+
 // Method Description:
 // - Returns the tab color
 // If the starting color exists, its value is preferred
@@ -1370,14 +1580,8 @@ void Terminal::AddMark(const Microsoft::Console::VirtualTerminal::DispatchTypes:
     m.start = start;
     m.end = end;
 
-    if (fromUi)
-    {
-        _scrollMarks.insert(_scrollMarks.begin(), m);
-    }
-    else
-    {
-        _scrollMarks.push_back(m);
-    }
+    // Only marks from the VT api become the current one, which MarkCommandStart() & co. then fill in.
+    _scrollMarks.Add(m, !fromUi);
 
     // Tell the control that the scrollbar has somehow changed. Used as a
     // workaround to force the control to redraw any scrollbar marks
@@ -1406,10 +1610,7 @@ void Terminal::ClearMark()
                (m.end >= start && m.end <= end);
     };
 
-    _scrollMarks.erase(std::remove_if(_scrollMarks.begin(),
-                                      _scrollMarks.end(),
-                                      inSelection),
-                       _scrollMarks.end());
+    _scrollMarks.EraseIf(inSelection);
 
     // Tell the control that the scrollbar has somehow changed. Used as a
     // workaround to force the control to redraw any scrollbar marks
@@ -1417,20 +1618,184 @@ void Terminal::ClearMark()
 }
 void Terminal::ClearAllMarks() noexcept
 {
-    _scrollMarks.clear();
+    _scrollMarks.Clear();
     // Tell the control that the scrollbar has somehow changed. Used as a
     // workaround to force the control to redraw any scrollbar marks
     _NotifyScrollEvent();
 }
 
-const std::vector<DispatchTypes::ScrollMark>& Terminal::GetScrollMarks() const noexcept
+namespace
+{
+    // The scroll marks are appended to the buffer's snapshot in this format.
+    struct SerializedMark
+    {
+        til::CoordType start[2];
+        til::CoordType end[2];
+        til::CoordType commandEnd[2];
+        til::CoordType outputEnd[2];
+        uint32_t color;
+        uint8_t flags;
+        uint8_t category;
+        uint16_t reserved;
+    };
+
+    constexpr uint8_t markHasColor = 0x01;
+    constexpr uint8_t markHasCommandEnd = 0x02;
+    constexpr uint8_t markHasOutputEnd = 0x04;
+}
+
+// Method Description:
+// - Appends a snapshot of the main buffer and its scroll marks to `out`, which
+//   RestoreSnapshot() can import into a new Terminal. The alt buffer isn't included,
+//   since the application that used it won't be around anymore once it's restored.
+// - The caller must hold the lock, but doesn't need to hold it for writing.
+void Terminal::SerializeSnapshot(std::vector<std::byte>& out) const
+{
+    BufferSnapshot::Capture(*_mainBuffer, _mutableViewport.BottomExclusive(), out);
+
+    const auto marks = _scrollMarks.GetAll();
+    const auto count = gsl::narrow<uint32_t>(marks.size());
+    const auto countBytes = reinterpret_cast<const std::byte*>(&count);
+    out.insert(out.end(), countBytes, countBytes + sizeof(count));
+
+    for (const auto& mark : marks)
+    {
+        const auto commandEnd = mark.commandEnd.value_or(til::point{});
+        const auto outputEnd = mark.outputEnd.value_or(til::point{});
+        SerializedMark serialized{
+            .start = { mark.start.x, mark.start.y },
+            .end = { mark.end.x, mark.end.y },
+            .commandEnd = { commandEnd.x, commandEnd.y },
+            .outputEnd = { outputEnd.x, outputEnd.y },
+            .color = mark.color ? mark.color->abgr : 0,
+            .category = static_cast<uint8_t>(mark.category),
+        };
+        WI_SetFlagIf(serialized.flags, markHasColor, mark.color.has_value());
+        WI_SetFlagIf(serialized.flags, markHasCommandEnd, mark.commandEnd.has_value());
+        WI_SetFlagIf(serialized.flags, markHasOutputEnd, mark.outputEnd.has_value());
+
+        const auto bytes = reinterpret_cast<const std::byte*>(&serialized);
+        out.insert(out.end(), bytes, bytes + sizeof(serialized));
+    }
+}
+
+// Method Description:
+// - Imports a snapshot written by SerializeSnapshot() into the main buffer. This
+//   is meant to be called right after the Terminal was created, before any output.
+// - Afterwards the restored contents are scrolled out of the viewport, so that
+//   the connection can't overwrite them when it paints its initial screen.
+void Terminal::RestoreSnapshot(std::span<const std::byte> data)
 {
-    // TODO: GH#11000 - when the marks are stored per-buffer, get rid of this.
-    // We want to return _no_ marks when we're in the alt buffer, to effectively
-    // hide them. We need to return a reference, so we can't just ctor an empty
-    // list here just for when we're in the alt buffer.
-    static const std::vector<DispatchTypes::ScrollMark> _altBufferMarks{};
-    return _inAltBuffer() ? _altBufferMarks : _scrollMarks;
+    auto lock = LockForWriting();
+
+    const auto result = BufferSnapshot::Restore(*_mainBuffer, data);
+    data = data.subspan(result.size);
+
+    // The marks are only worth restoring if their positions are still correct,
+    // which isn't the case if the rows had to be reflowed.
+    uint32_t count = 0;
+    if (result.rowDelta && data.size() >= sizeof(count))
+    {
+        memcpy(&count, data.data(), sizeof(count));
+        data = data.subspan(sizeof(count));
+        count = gsl::narrow_cast<uint32_t>(std::min<size_t>(count, data.size() / sizeof(SerializedMark)));
+    }
+
+    const auto bufferSize = _mainBuffer->GetSize();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        SerializedMark serialized;
+        memcpy(&serialized, data.data() + i * sizeof(SerializedMark), sizeof(SerializedMark));
+
+        const auto translate = [&](const til::CoordType (&pos)[2]) {
+            til::point p{ pos[0], pos[1] - *result.rowDelta };
+            bufferSize.Clamp(p);
+            return p;
+        };
+
+        if (serialized.start[1] < *result.rowDelta || serialized.category > static_cast<uint8_t>(DispatchTypes::MarkCategory::Info))
+        {
+            continue;
+        }
+
+        DispatchTypes::ScrollMark mark;
+        mark.start = translate(serialized.start);
+        mark.end = translate(serialized.end);
+        mark.category = static_cast<DispatchTypes::MarkCategory>(serialized.category);
+        if (WI_IsFlagSet(serialized.flags, markHasColor))
+        {
+            til::color color;
+            color.abgr = serialized.color;
+            mark.color = color;
+        }
+        if (WI_IsFlagSet(serialized.flags, markHasCommandEnd))
+        {
+            mark.commandEnd = translate(serialized.commandEnd);
+        }
+        if (WI_IsFlagSet(serialized.flags, markHasOutputEnd))
+        {
+            mark.outputEnd = translate(serialized.outputEnd);
+        }
+        _scrollMarks.Add(mark, false);
+    }
+
+    // Move the cursor below the restored contents and push all of them into the scrollback.
+    auto& cursor = _mainBuffer->GetCursor();
+    const auto cursorPos = cursor.GetPosition();
+    const auto lastChar = _mainBuffer->GetLastNonSpaceCharacter();
+    cursor.SetPosition({ 0, std::max(cursorPos.y, lastChar.y) });
+    _mutableViewport = Viewport::FromDimensions({ 0, std::max(0, cursor.GetPosition().y - _mutableViewport.Height() + 1) }, _mutableViewport.Dimensions());
+    Write(std::wstring(gsl::narrow_cast<size_t>(_mutableViewport.Height()), L'\n'));
+
+    _mainBuffer->TriggerRedrawAll();
+    _NotifyScrollEvent();
+}
+
+// TODO: GH#11000 - when the marks are stored per-buffer, get rid of the _inAltBuffer() checks below.
+// We want to return _no_ marks when we're in the alt buffer, to effectively hide them.
+
+// Method Description:
+// - Returns all marks, ordered by their start position.
+std::vector<DispatchTypes::ScrollMark> Terminal::GetScrollMarks() const
+{
+    if (_inAltBuffer())
+    {
+        return {};
+    }
+    return _scrollMarks.GetAll();
+}
+
+// Method Description:
+// - Returns the marks that start in the rows [top, bottom), ordered by their start position.
+std::vector<DispatchTypes::ScrollMark> Terminal::GetScrollMarks(const til::CoordType top, const til::CoordType bottom) const
+{
+    if (_inAltBuffer())
+    {
+        return {};
+    }
+    return _scrollMarks.GetRange(top, bottom);
+}
+
+// Method Description:
+// - Returns the first mark that starts below the given row, if any.
+std::optional<DispatchTypes::ScrollMark> Terminal::GetScrollMarkAfter(const til::CoordType y) const
+{
+    if (_inAltBuffer())
+    {
+        return std::nullopt;
+    }
+    return _scrollMarks.GetAfter(y);
+}
+
+// Method Description:
+// - Returns the last mark that starts above the given row, if any.
+std::optional<DispatchTypes::ScrollMark> Terminal::GetScrollMarkBefore(const til::CoordType y) const
+{
+    if (_inAltBuffer())
+    {
+        return std::nullopt;
+    }
+    return _scrollMarks.GetBefore(y);
 }
 
 til::color Terminal::GetColorForMark(const Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark& mark) const
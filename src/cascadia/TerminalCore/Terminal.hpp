@@ -14,10 +14,11 @@
 #include "../../types/inc/Viewport.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
 #include "../../cascadia/terminalcore/ITerminalInput.hpp"
+#include "ScrollMarkStore.hpp"
 
 #include <til/ticket_lock.h>
 
-inline constexpr std::wstring_view linkPattern{ LR"(\b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])" };
+inline constexpr std::wstring_view linkPattern{ TextBuffer::UrlPattern };
 inline constexpr size_t TaskbarMinProgress{ 10 };
 
 // You have to forward decl the ICoreSettings here, instead of including the header.
@@ -81,12 +82,28 @@ public:
 
     // Write comes from the PTY and goes to our parser to be stored in the output buffer
     void Write(std::wstring_view stringView);
+    // Same as above, but for connections that provide UTF-8 directly.
+    void Write(std::string_view stringView);
+    // Same as above, but parses all strings under a single lock.
+    void Write(std::span<const std::string_view> strings);
+
+    // Releases the memory of rows that aren't visible. See TextBuffer::TrimMemory().
+    void TrimMemory(const bool compactText);
+    // The approximate number of bytes held by the text buffers and the pattern tree.
+    size_t GetMemoryUsage() const noexcept;
+
+    // Like UserResize(), but only reflows the rows around the viewport. See Terminal.cpp.
+    [[nodiscard]] HRESULT LiveResize(const til::size viewportSize) noexcept;
+    void FinishLiveResize() noexcept;
 
     // WritePastedText comes from our input and goes back to the PTY's input channel
     void WritePastedText(std::wstring_view stringView);
 
-    [[nodiscard]] std::unique_lock<til::recursive_ticket_lock> LockForReading();
+    // Readers may hold the lock concurrently. They must not call LockForWriting() while holding it.
+    [[nodiscard]] std::shared_lock<til::recursive_ticket_lock> LockForReading();
     [[nodiscard]] std::unique_lock<til::recursive_ticket_lock> LockForWriting();
+    // Returns an unlocked std::unique_lock if another thread currently holds the lock.
+    [[nodiscard]] std::unique_lock<til::recursive_ticket_lock> TryLockForWriting();
     til::recursive_ticket_lock_suspension SuspendLock() noexcept;
 
     til::CoordType GetBufferHeight() const noexcept;
@@ -97,7 +114,10 @@ public:
     RenderSettings& GetRenderSettings() noexcept { return _renderSettings; };
     const RenderSettings& GetRenderSettings() const noexcept { return _renderSettings; };
 
-    const std::vector<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark>& GetScrollMarks() const noexcept;
+    std::vector<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark> GetScrollMarks() const;
+    std::vector<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark> GetScrollMarks(const til::CoordType top, const til::CoordType bottom) const;
+    std::optional<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark> GetScrollMarkAfter(const til::CoordType y) const;
+    std::optional<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark> GetScrollMarkBefore(const til::CoordType y) const;
     void AddMark(const Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark& mark,
                  const til::point& start,
                  const til::point& end,
@@ -142,6 +162,9 @@ public:
     void ClearAllMarks() noexcept;
     til::color GetColorForMark(const Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark& mark) const;
 
+    void SerializeSnapshot(std::vector<std::byte>& out) const;
+    void RestoreSnapshot(std::span<const std::byte> data);
+
 #pragma region ITerminalInput
     // These methods are defined in Terminal.cpp
     bool SendKeyEvent(const WORD vkey, const WORD scanCode, const Microsoft::Terminal::Core::ControlKeyStates states, const bool keyDown) override;
@@ -172,6 +195,8 @@ public:
 
     void LockConsole() noexcept override;
     void UnlockConsole() noexcept override;
+    void LockConsoleShared() noexcept override;
+    void UnlockConsoleShared() noexcept override;
 
     // These methods are defined in TerminalRenderData.cpp
     til::point GetCursorPosition() const noexcept override;
@@ -186,9 +211,11 @@ public:
     const std::wstring GetHyperlinkUri(uint16_t id) const override;
     const std::wstring GetHyperlinkCustomId(uint16_t id) const override;
     const std::vector<size_t> GetPatternId(const til::point location) const override;
+    std::span<const til::point_span> GetSearchHighlights() const noexcept override;
 
     std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept override;
     std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetVisibleSelectionRects() noexcept override;
     const bool IsSelectionActive() const noexcept override;
     const bool IsBlockSelection() const noexcept override;
     void ClearSelection() override;
@@ -216,6 +243,10 @@ public:
     void UpdatePatternsUnderLock();
     void ClearPatternTree();
 
+    void AppendSearchHighlights(std::span<const til::point_span> highlights);
+    void ClearSearchHighlights();
+    int64_t GetBufferRotationCount() const noexcept;
+
     const std::optional<til::color> GetTabColor() const;
 
     winrt::Microsoft::Terminal::Core::Scheme GetColorScheme() const;
@@ -284,7 +315,7 @@ public:
     til::point SelectionEndForRendering() const;
     const SelectionEndpoint SelectionEndpointTarget() const noexcept;
 
-    const TextBuffer::TextAndColor RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace);
+    const TextBuffer::TextAndColor RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace, bool includeColors = true);
 #pragma endregion
 
 private:
@@ -348,12 +379,30 @@ private:
     };
     std::optional<SelectionAnchors> _selection;
     bool _blockSelection = false;
-    std::wstring _wordDelimiters;
+    WordDelimiters _wordDelimiters;
     SelectionExpansion _multiClickSelectionMode = SelectionExpansion::Char;
     SelectionInteractionMode _selectionMode = SelectionInteractionMode::None;
     bool _selectionIsTargetingUrl = false;
     SelectionEndpoint _selectionEndpoint = SelectionEndpoint::None;
     bool _anchorInactiveSelectionEndpoint = false;
+    // The selection rects of the rows in the viewport, as last returned by _GetVisibleSelectionRects().
+    // The renderer asks for them multiple times per frame, but they only need to be recomputed
+    // when the selection or viewport changed, and otherwise only for the rows whose contents changed.
+    // It's updated while the renderer holds the lock in shared mode, which is fine as long as the
+    // render thread remains its only user.
+    struct SelectionRectsCache
+    {
+        const TextBuffer* buffer = nullptr;
+        til::point start;
+        til::point end;
+        bool blockSelection = false;
+        til::CoordType rowBeg = 0;
+        til::CoordType rowEnd = 0;
+        // The ROW::GetLatestGeneration() at the time the rects were computed.
+        uint64_t generation = 0;
+        std::vector<til::inclusive_rect> rects;
+    };
+    SelectionRectsCache _selectionRectsCache;
 #pragma endregion
 
     std::unique_ptr<TextBuffer> _mainBuffer;
@@ -361,9 +410,14 @@ private:
     Microsoft::Console::Types::Viewport _mutableViewport;
     til::CoordType _scrollbackLines = 0;
     bool _detectURLs = false;
+    // Rows further than this many viewports above the visible region get compressed. See TextBuffer::CompactScrollback().
+    static constexpr til::CoordType _hotScrollbackViewports = 4;
 
     til::size _altBufferSize;
     std::optional<til::size> _deferredResize;
+    // The buffer as it was before LiveResize() reflowed everything but its first _deferredHistoryRows rows.
+    std::unique_ptr<TextBuffer> _deferredHistory;
+    til::CoordType _deferredHistoryRows = 0;
 
     // _scrollOffset is the number of lines above the viewport that are currently visible
     // If _scrollOffset is 0, then the visible region of the buffer is the viewport.
@@ -382,9 +436,18 @@ private:
     //      Either way, we should make this behavior controlled by a setting.
 
     interval_tree::IntervalTree<til::point, size_t> _patternIntervalTree;
+    // false while the tree doesn't reflect the current viewport, for instance after scrolling
+    // and until the next (throttled) UpdatePatternsUnderLock(). Hyperlink lookups then ask the buffer.
+    bool _patternIntervalTreeValid = false;
     void _InvalidatePatternTree(const interval_tree::IntervalTree<til::point, size_t>& tree);
     void _InvalidateFromCoords(const til::point start, const til::point end);
 
+    // The matches highlighted by the search in progress, in buffer coordinates and in order.
+    // They're moved up along with the buffer contents, which _bufferRotationCount counts the rows of.
+    std::vector<til::point_span> _searchHighlights;
+    int64_t _bufferRotationCount = 0;
+    void _InvalidateSearchHighlights(std::span<const til::point_span> highlights);
+
     // Since virtual keys are non-zero, you assume that this field is empty/invalid if it is.
     struct KeyEventCodes
     {
@@ -393,7 +456,7 @@ private:
     };
     std::optional<KeyEventCodes> _lastKeyEventCodes;
 
-    std::vector<Microsoft::Console::VirtualTerminal::DispatchTypes::ScrollMark> _scrollMarks;
+    Microsoft::Terminal::Core::ScrollMarkStore _scrollMarks;
     enum class PromptState : uint32_t
     {
         None = 0,
@@ -419,10 +482,15 @@ private:
 
     void _PreserveUserScrollOffset(const int viewportDelta) noexcept;
 
+    [[nodiscard]] HRESULT _UserResize(const til::size viewportSize, const bool deferScrollback) noexcept;
+
     void _NotifyScrollEvent() noexcept;
 
     void _NotifyTerminalCursorPositionChanged() noexcept;
 
+    template<typename T>
+    void _Write(std::span<const T> strings);
+
     bool _inAltBuffer() const noexcept;
     TextBuffer& _activeBuffer() const noexcept;
     void _updateUrlDetection();
@@ -430,6 +498,7 @@ private:
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
     std::vector<til::inclusive_rect> _GetSelectionRects() const noexcept;
+    const std::vector<til::inclusive_rect>& _GetVisibleSelectionRects() noexcept;
     std::vector<til::point_span> _GetSelectionSpans() const noexcept;
     std::pair<til::point, til::point> _PivotSelection(const til::point targetPos, bool& targetStart) const noexcept;
     std::pair<til::point, til::point> _ExpandSelectionAnchors(std::pair<til::point, til::point> anchors) const;
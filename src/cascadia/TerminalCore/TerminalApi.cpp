@@ -48,6 +48,13 @@ void Terminal::SetViewportPosition(const til::point position) noexcept
     // The viewport is fixed at 0,0 for the alt buffer, so this is a no-op.
     if (!_inAltBuffer())
     {
+        // The viewport only moves to the top of the buffer if the scrollback got erased.
+        // That includes the scrollback that LiveResize() put aside.
+        if (position.y == 0)
+        {
+            _deferredHistory.reset();
+        }
+
         const auto viewportDelta = position.y - _GetMutableViewport().Origin().y;
         const auto dimensions = _GetMutableViewport().Dimensions();
         _mutableViewport = Viewport::FromDimensions(position, dimensions);
@@ -201,6 +208,9 @@ void Terminal::UseAlternateScreenBuffer(const TextAttribute& attrs)
                                               cursorSize,
                                               true,
                                               _mainBuffer->GetRenderer());
+    // Applications like pagers enter and leave the alt buffer all the time.
+    // This allows the next alt buffer to reuse the memory of this one.
+    _altBuffer->SetRecyclable(true);
     _mainBuffer->SetAsActiveBuffer(false);
 
     // Copy our cursor state to the new buffer's cursor
@@ -320,7 +330,7 @@ void Terminal::MarkCommandStart()
     const til::point cursorPos{ _activeBuffer().GetCursor().GetPosition() };
 
     if ((_currentPromptState == PromptState::Prompt) &&
-        (_scrollMarks.size() > 0))
+        _scrollMarks.HasCurrent())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -337,7 +347,7 @@ void Terminal::MarkCommandStart()
         mark.category = DispatchTypes::MarkCategory::Prompt;
         AddMark(mark, cursorPos, cursorPos, false);
     }
-    _scrollMarks.back().end = cursorPos;
+    _scrollMarks.ModifyCurrent([&](auto& m) { m.end = cursorPos; });
     _currentPromptState = PromptState::Command;
 }
 
@@ -346,7 +356,7 @@ void Terminal::MarkOutputStart()
     const til::point cursorPos{ _activeBuffer().GetCursor().GetPosition() };
 
     if ((_currentPromptState == PromptState::Command) &&
-        (_scrollMarks.size() > 0))
+        _scrollMarks.HasCurrent())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -363,7 +373,7 @@ void Terminal::MarkOutputStart()
         mark.category = DispatchTypes::MarkCategory::Prompt;
         AddMark(mark, cursorPos, cursorPos, false);
     }
-    _scrollMarks.back().commandEnd = cursorPos;
+    _scrollMarks.ModifyCurrent([&](auto& m) { m.commandEnd = cursorPos; });
     _currentPromptState = PromptState::Output;
 }
 
@@ -379,7 +389,7 @@ void Terminal::MarkCommandFinish(std::optional<unsigned int> error)
     }
 
     if ((_currentPromptState == PromptState::Output) &&
-        (_scrollMarks.size() > 0))
+        _scrollMarks.HasCurrent())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -395,11 +405,13 @@ void Terminal::MarkCommandFinish(std::optional<unsigned int> error)
 
         DispatchTypes::ScrollMark mark;
         mark.category = DispatchTypes::MarkCategory::Prompt;
+        mark.commandEnd = cursorPos;
         AddMark(mark, cursorPos, cursorPos, false);
-        _scrollMarks.back().commandEnd = cursorPos;
     }
-    _scrollMarks.back().outputEnd = cursorPos;
-    _scrollMarks.back().category = category;
+    _scrollMarks.ModifyCurrent([&](auto& m) {
+        m.outputEnd = cursorPos;
+        m.category = category;
+    });
     _currentPromptState = PromptState::None;
 }
 
@@ -457,31 +469,26 @@ void Terminal::NotifyBufferRotation(const int delta)
 
     // manually erase our pattern intervals since the locations have changed now
     _patternIntervalTree = {};
+    _patternIntervalTreeValid = false;
 
-    const auto hasScrollMarks = _scrollMarks.size() > 0;
-    if (hasScrollMarks)
+    // Moves all marks up and drops the ones that scrolled out of the buffer.
+    const auto hasScrollMarks = !_scrollMarks.Empty();
+    _scrollMarks.Rotate(delta);
+
+    // The same goes for the search highlights.
+    if (!_searchHighlights.empty())
     {
-        for (auto& mark : _scrollMarks)
+        const auto it = std::find_if(_searchHighlights.begin(), _searchHighlights.end(), [&](const til::point_span& highlight) {
+            return highlight.start.y >= delta;
+        });
+        _searchHighlights.erase(_searchHighlights.begin(), it);
+        for (auto& highlight : _searchHighlights)
         {
-            // Move the mark up
-            mark.start.y -= delta;
-
-            // If the mark had sub-regions, then move those pointers too
-            if (mark.commandEnd.has_value())
-            {
-                (*mark.commandEnd).y -= delta;
-            }
-            if (mark.outputEnd.has_value())
-            {
-                (*mark.outputEnd).y -= delta;
-            }
+            highlight.start.y -= delta;
+            highlight.end.y -= delta;
         }
-
-        _scrollMarks.erase(std::remove_if(_scrollMarks.begin(),
-                                          _scrollMarks.end(),
-                                          [](const auto& m) { return m.start.y < 0; }),
-                           _scrollMarks.end());
     }
+    _bufferRotationCount += delta;
 
     const auto oldScrollOffset = _scrollOffset;
     _PreserveUserScrollOffset(delta);
@@ -63,6 +63,71 @@ std::vector<til::inclusive_rect> Terminal::_GetSelectionRects() const noexcept
     return result;
 }
 
+// Method Description:
+// - Same as _GetSelectionRects(), but only returns the rects of the rows in the visible viewport.
+//   The result is cached: It's recomputed if the selection or the viewport changed
+//   and otherwise only for the rows whose contents changed since the last call.
+// Return Value:
+// - A vector of rectangles representing the regions to select, line by line. They are absolute coordinates relative to the buffer origin.
+const std::vector<til::inclusive_rect>& Terminal::_GetVisibleSelectionRects() noexcept
+{
+    auto& cache = _selectionRectsCache;
+
+    if (!IsSelectionActive())
+    {
+        cache.buffer = nullptr;
+        cache.rects.clear();
+        return cache.rects;
+    }
+
+    try
+    {
+        const auto& buffer = _activeBuffer();
+        const auto viewport = _GetVisibleViewport();
+        const auto start = _selection->start;
+        const auto end = _selection->end;
+        const auto rowBeg = std::max(viewport.Top(), std::min(start.y, end.y));
+        const auto rowEnd = std::min(viewport.BottomExclusive(), std::max(start.y, end.y) + 1);
+        // This needs to be fetched before computing any rects, so that any
+        // modification to a ROW in the meantime is picked up by the next call.
+        const auto generation = ROW::GetLatestGeneration();
+
+        if (cache.buffer != &buffer || cache.start != start || cache.end != end || cache.blockSelection != _blockSelection || cache.rowBeg != rowBeg || cache.rowEnd != rowEnd)
+        {
+            cache.rects = buffer.GetTextRects(start, end, _blockSelection, false, rowBeg, rowEnd);
+            cache.buffer = &buffer;
+            cache.start = start;
+            cache.end = end;
+            cache.blockSelection = _blockSelection;
+            cache.rowBeg = rowBeg;
+            cache.rowEnd = rowEnd;
+        }
+        else
+        {
+            // Wide glyphs and line renditions affect the rects, which is why
+            // the rows whose contents changed need to be recomputed.
+            for (const auto y : buffer.GetChangedRowsSince(cache.generation, rowBeg, rowEnd))
+            {
+                const auto rects = buffer.GetTextRects(start, end, _blockSelection, false, y, y + 1);
+                if (!rects.empty())
+                {
+                    cache.rects.at(gsl::narrow_cast<size_t>(y - rowBeg)) = rects.front();
+                }
+            }
+        }
+
+        cache.generation = generation;
+        return cache.rects;
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        cache.buffer = nullptr;
+        cache.rects.clear();
+        return cache.rects;
+    }
+}
+
 // Method Description:
 // - Identical to GetTextRects if it's a block selection, else returns a single span for the whole selection.
 // Return Value:
@@ -828,17 +893,22 @@ void Terminal::ClearSelection()
 // - get wstring text from highlighted portion of text buffer
 // Arguments:
 // - singleLine: collapse all of the text to one line
+// - includeColors: if false, only the text will be retrieved, which is significantly cheaper
 // Return Value:
 // - wstring text from buffer. If extended to multiple lines, each line is separated by \r\n
-const TextBuffer::TextAndColor Terminal::RetrieveSelectedTextFromBuffer(bool singleLine)
+const TextBuffer::TextAndColor Terminal::RetrieveSelectedTextFromBuffer(bool singleLine, bool includeColors)
 {
     auto lock = LockForReading();
 
     const auto selectionRects = _GetSelectionRects();
 
-    const auto GetAttributeColors = [&](const auto& attr) {
-        return _renderSettings.GetAttributeColors(attr);
-    };
+    std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors;
+    if (includeColors)
+    {
+        GetAttributeColors = [&](const auto& attr) {
+            return _renderSettings.GetAttributeColors(attr);
+        };
+    }
 
     // GH#6740: Block selection should preserve the visual structure:
     // - CRLFs need to be added - so the lines structure is preserved
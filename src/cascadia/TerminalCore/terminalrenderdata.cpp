@@ -123,6 +123,13 @@ const std::vector<size_t> Terminal::GetPatternId(const til::point location) cons
     return {};
 }
 
+// Method Description:
+// - Returns the matches highlighted by the search in progress. See AppendSearchHighlights().
+std::span<const til::point_span> Terminal::GetSearchHighlights() const noexcept
+{
+    return _searchHighlights;
+}
+
 std::pair<COLORREF, COLORREF> Terminal::GetAttributeColors(const TextAttribute& attr) const noexcept
 {
     return _renderSettings.GetAttributeColors(attr);
@@ -146,6 +153,24 @@ catch (...)
     return {};
 }
 
+std::vector<Microsoft::Console::Types::Viewport> Terminal::GetVisibleSelectionRects() noexcept
+try
+{
+    std::vector<Viewport> result;
+
+    for (const auto& lineRect : _GetVisibleSelectionRects())
+    {
+        result.emplace_back(Viewport::FromInclusive(lineRect));
+    }
+
+    return result;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
 void Terminal::SelectNewRegion(const til::point coordStart, const til::point coordEnd)
 {
 #pragma warning(push)
@@ -217,6 +242,21 @@ void Terminal::UnlockConsole() noexcept
     _readWriteLock.unlock();
 }
 
+// Method Description:
+// - Same as Terminal::LockConsole, but other readers may hold the lock at the
+//      same time. Used by the renderer and UIA, which only read from the terminal.
+void Terminal::LockConsoleShared() noexcept
+{
+    _readWriteLock.lock_shared();
+}
+
+// Method Description:
+// - Unlocks the terminal after a call to Terminal::LockConsoleShared.
+void Terminal::UnlockConsoleShared() noexcept
+{
+    _readWriteLock.unlock_shared();
+}
+
 const bool Terminal::IsUiaDataInitialized() const noexcept
 {
     // GH#11135: Windows Terminal needs to create and return an automation peer
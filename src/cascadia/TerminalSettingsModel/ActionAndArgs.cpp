@@ -40,6 +40,7 @@ static constexpr std::string_view ScrollUpKey{ "scrollUp" };
 static constexpr std::string_view ScrollUpPageKey{ "scrollUpPage" };
 static constexpr std::string_view ScrollToTopKey{ "scrollToTop" };
 static constexpr std::string_view ScrollToBottomKey{ "scrollToBottom" };
+static constexpr std::string_view JumpToOutputEndKey{ "jumpToOutputEnd" };
 static constexpr std::string_view ScrollToMarkKey{ "scrollToMark" };
 static constexpr std::string_view AddMarkKey{ "addMark" };
 static constexpr std::string_view ClearMarkKey{ "clearMark" };
@@ -99,7 +100,7 @@ static constexpr std::string_view ActionKey{ "action" };
 // This key is reserved to remove a keybinding, instead of mapping it to an action.
 static constexpr std::string_view UnboundKey{ "unbound" };
 
-#define KEY_TO_ACTION_PAIR(action) { action##Key, ShortcutAction::action },
+#define KEY_TO_ACTION_PAIR(action) std::pair{ action##Key, ShortcutAction::action },
 #define ACTION_TO_KEY_PAIR(action) { ShortcutAction::action, action##Key },
 #define ACTION_TO_SERIALIZERS_PAIR(action) { ShortcutAction::action, { action##Args::FromJson, action##Args::ToJson } },
 
@@ -107,15 +108,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 {
     using namespace ::Microsoft::Terminal::Settings::Model;
 
-    // Specifically use a map here over an unordered_map. We want to be able to
-    // iterate over these entries in-order when we're serializing the keybindings.
-    // HERE BE DRAGONS:
-    // These are string_views that are being used as keys. These string_views are
-    // just pointers to other strings. This could be dangerous, if the map outlived
-    // the actual strings being pointed to. However, since both these strings and
-    // the map are all const for the lifetime of the app, we have nothing to worry
-    // about here.
-    const std::map<std::string_view, ShortcutAction, std::less<>> ActionAndArgs::ActionKeyNamesMap{
+    // Every "action" of every keybinding is looked up in here while loading the settings.
+    // A perfect hash finds them with a single string comparison.
+    static constexpr til::perfect_static_map ActionKeyNamesMap{
 #define ON_ALL_ACTIONS(action) KEY_TO_ACTION_PAIR(action)
         ALL_SHORTCUT_ACTIONS
 #undef ON_ALL_ACTIONS
@@ -189,8 +184,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     {
         // Try matching the command to one we have. If we can't find the
         // action name in our list of names, let's just unbind that key.
-        const auto found = ActionAndArgs::ActionKeyNamesMap.find(actionString);
-        return found != ActionAndArgs::ActionKeyNamesMap.end() ? found->second : ShortcutAction::Invalid;
+        const auto found = ActionKeyNamesMap.find(actionString);
+        return found != ActionKeyNamesMap.end() ? found->second : ShortcutAction::Invalid;
     }
 
     // Method Description:
@@ -372,6 +367,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
                 { ShortcutAction::ScrollUpPage, RS_(L"ScrollUpPageCommandKey") },
                 { ShortcutAction::ScrollToTop, RS_(L"ScrollToTopCommandKey") },
                 { ShortcutAction::ScrollToBottom, RS_(L"ScrollToBottomCommandKey") },
+                { ShortcutAction::JumpToOutputEnd, RS_(L"JumpToOutputEndCommandKey") },
                 { ShortcutAction::ScrollToMark, RS_(L"ScrollToPreviousMarkCommandKey") },
                 { ShortcutAction::AddMark, RS_(L"AddMarkCommandKey") },
                 { ShortcutAction::ClearMark, RS_(L"ClearMarkCommandKey") },
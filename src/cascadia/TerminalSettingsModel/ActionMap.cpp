@@ -325,6 +325,57 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         _GlobalHotkeysCache = single_threaded_map(std::move(globalHotkeys));
     }
 
+    // Method Description:
+    // - Builds the flattened key chord lookup, now that all of our parents were added.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ActionMap::_FinalizeInheritance()
+    {
+        _RefreshKeyChordLookup();
+    }
+
+    void ActionMap::_RefreshKeyChordLookup()
+    {
+        std::unordered_map<KeyChord, Model::Command, KeyChordHash, KeyChordEquality> keyChordLookup;
+        _PopulateKeyChordLookup(keyChordLookup);
+
+        _KeyChordLookupVkeys.reset();
+        for (const auto& [keys, cmd] : keyChordLookup)
+        {
+            // Chords that only specify a scan code have a Vkey of 0
+            // and only ever compare equal to other chords without one.
+            if (const auto vkey = keys.Vkey(); vkey >= 0 && static_cast<size_t>(vkey) < _KeyChordLookupVkeys.size())
+            {
+                _KeyChordLookupVkeys.set(static_cast<size_t>(vkey));
+            }
+        }
+
+        _KeyChordLookup = std::move(keyChordLookup);
+    }
+
+    // Method Description:
+    // - Populates the provided keyChordLookup with the key chords of all layers.
+    // - This needs to be a bottom up approach, as the first layer to mention a key chord wins,
+    //    just like in _GetActionByKeyChordInternal.
+    // Arguments:
+    // - keyChordLookup: the lookup we're populating. This maps a key chord to its command,
+    //    or to nullptr if the key chord was explicitly unbound.
+    void ActionMap::_PopulateKeyChordLookup(std::unordered_map<Control::KeyChord, Model::Command, KeyChordHash, KeyChordEquality>& keyChordLookup) const
+    {
+        for (const auto& [keys, actionID] : _KeyMap)
+        {
+            // emplace() won't overwrite chords that a more important layer already added.
+            keyChordLookup.emplace(keys, _GetActionByID(actionID).value());
+        }
+
+        for (const auto& parent : _parents)
+        {
+            parent->_PopulateKeyChordLookup(keyChordLookup);
+        }
+    }
+
     // Method Description:
     // - Populates the provided keyBindingsMap with all of our actions and our parents actions
     //    while omitting the key bindings that were already added before.
@@ -413,6 +464,12 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
             actionMap->_parents.emplace_back(parent->Copy());
         }
 
+        // The lookup refers to our Commands, so the copy needs one of its own.
+        if (_KeyChordLookup)
+        {
+            actionMap->_RefreshKeyChordLookup();
+        }
+
         return actionMap;
     }
 
@@ -432,6 +489,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         _NameMapCache = nullptr;
         _GlobalHotkeysCache = nullptr;
         _KeyBindingMapCache = nullptr;
+        _KeyChordLookup.reset();
 
         // Handle nested commands
         const auto cmdImpl{ get_self<Command>(cmd) };
@@ -724,6 +782,20 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     // - nullopt if it was not bound in this layer
     std::optional<Model::Command> ActionMap::_GetActionByKeyChordInternal(const Control::KeyChord& keys) const
     {
+        // Once the layering is complete, all layers were flattened into _KeyChordLookup.
+        if (_KeyChordLookup)
+        {
+            if (const auto vkey = keys.Vkey(); vkey >= 0 && static_cast<size_t>(vkey) < _KeyChordLookupVkeys.size() && !_KeyChordLookupVkeys.test(static_cast<size_t>(vkey)))
+            {
+                return std::nullopt;
+            }
+            if (const auto it = _KeyChordLookup->find(keys); it != _KeyChordLookup->end())
+            {
+                return it->second;
+            }
+            return std::nullopt;
+        }
+
         // Check the current layer
         if (const auto actionIDPair = _KeyMap.find(keys); actionIDPair != _KeyMap.end())
         {
@@ -15,6 +15,8 @@ Author(s):
 
 #pragma once
 
+#include <bitset>
+
 #include "ActionMap.g.h"
 #include "IInheritable.h"
 #include "Command.h"
@@ -49,6 +51,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 
     struct ActionMap : ActionMapT<ActionMap>, IInheritable<ActionMap>
     {
+        void _FinalizeInheritance() override;
+
         // views
         Windows::Foundation::Collections::IMapView<hstring, Model::ActionAndArgs> AvailableActions();
         Windows::Foundation::Collections::IMapView<hstring, Model::Command> NameMap();
@@ -84,6 +88,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         std::optional<Model::Command> _GetActionByKeyChordInternal(const Control::KeyChord& keys) const;
 
         void _RefreshKeyBindingCaches();
+        void _RefreshKeyChordLookup();
+        void _PopulateKeyChordLookup(std::unordered_map<Control::KeyChord, Model::Command, KeyChordHash, KeyChordEquality>& keyChordLookup) const;
         void _PopulateAvailableActionsWithStandardCommands(std::unordered_map<hstring, Model::ActionAndArgs>& availableActions, std::unordered_set<InternalActionID>& visitedActionIDs) const;
         void _PopulateNameMapWithSpecialCommands(std::unordered_map<hstring, Model::Command>& nameMap) const;
         void _PopulateNameMapWithStandardCommands(std::unordered_map<hstring, Model::Command>& nameMap) const;
@@ -121,6 +127,16 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         //   than is necessary to be serialized.
         std::unordered_map<InternalActionID, Model::Command> _MaskingActions;
 
+        // Key Chord Lookup:
+        // A flattened copy of _KeyMap across all layers, mapping each key chord to the
+        //   Command it resolves to, or nullptr if it was explicitly unbound.
+        // It's built once the layering is complete and dropped by AddAction(), after which
+        //   _GetActionByKeyChordInternal falls back to walking the layers.
+        // _KeyChordLookupVkeys has a bit set for the Vkey of every chord in the lookup,
+        //   which allows us to reject most keystrokes without hashing them.
+        std::optional<std::unordered_map<Control::KeyChord, Model::Command, KeyChordHash, KeyChordEquality>> _KeyChordLookup;
+        std::bitset<256> _KeyChordLookupVkeys;
+
         friend class SettingsModelLocalTests::KeyBindingsTests;
         friend class SettingsModelLocalTests::DeserializationTests;
         friend class SettingsModelLocalTests::TerminalSettingsTests;
@@ -47,6 +47,7 @@
     ON_ALL_ACTIONS(ScrollDownPage)          \
     ON_ALL_ACTIONS(ScrollToTop)             \
     ON_ALL_ACTIONS(ScrollToBottom)          \
+    ON_ALL_ACTIONS(JumpToOutputEnd)         \
     ON_ALL_ACTIONS(ScrollToMark)            \
     ON_ALL_ACTIONS(AddMark)                 \
     ON_ALL_ACTIONS(ClearMark)               \
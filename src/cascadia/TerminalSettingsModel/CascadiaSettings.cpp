@@ -1254,3 +1254,8 @@ void CascadiaSettings::ExpandCommands()
 {
     _globals->ExpandCommands(ActiveProfiles().GetView(), GlobalSettings().ColorSchemes());
 }
+
+const til::shared_mutex<CascadiaSettings::TerminalSettingsCache>& CascadiaSettings::GetTerminalSettingsCache() const noexcept
+{
+    return _terminalSettingsCache;
+}
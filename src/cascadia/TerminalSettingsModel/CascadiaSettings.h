@@ -69,7 +69,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     private:
         struct JsonSettings
         {
-            Json::Value root;
+            std::shared_ptr<const Json::Value> root;
             const Json::Value& colorSchemes;
             const Json::Value& profileDefaults;
             const Json::Value& profilesList;
@@ -79,6 +79,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         static std::pair<size_t, size_t> _lineAndColumnFromPosition(const std::string_view& string, const size_t position);
         static void _rethrowSerializationExceptionWithLocationInfo(const JsonUtils::DeserializationError& e, const std::string_view& settingsString);
         static Json::Value _parseJSON(const std::string_view& content);
+        static std::shared_ptr<const Json::Value> _parseJSONCached(const std::string_view& content);
         static const Json::Value& _getJSONValue(const Json::Value& json, const std::string_view& key) noexcept;
         std::span<const winrt::com_ptr<implementation::Profile>> _getNonUserOriginProfiles() const;
         void _parse(const OriginTag origin, const winrt::hstring& source, const std::string_view& content, ParsedSettings& settings);
@@ -87,7 +88,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         static winrt::com_ptr<implementation::Profile> _parseProfile(const OriginTag origin, const winrt::hstring& source, const Json::Value& profileJson);
         void _appendProfile(winrt::com_ptr<Profile>&& profile, const winrt::guid& guid, ParsedSettings& settings);
         void _addUserProfileParent(const winrt::com_ptr<implementation::Profile>& profile);
-        void _executeGenerator(const IDynamicProfileGenerator& generator);
+        static void _executeGenerator(const IDynamicProfileGenerator& generator, std::vector<winrt::com_ptr<implementation::Profile>>& profiles) noexcept;
+        void _appendGeneratedProfiles(const std::wstring_view& generatorNamespace, std::vector<winrt::com_ptr<implementation::Profile>>& profiles);
 
         std::unordered_set<std::wstring_view> _ignoredNamespaces;
         // See _getNonUserOriginProfiles().
@@ -145,6 +147,18 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 
         void ExpandCommands();
 
+        // TerminalSettings cache
+        // TerminalSettings::CreateWithProfile() keeps the resolved settings of each
+        // profile here, so that new panes only need to create a child of them.
+        struct TerminalSettingsCacheEntry
+        {
+            Model::Profile profile{ nullptr };
+            bool systemInDarkTheme = false;
+            Model::TerminalSettings settings{ nullptr };
+        };
+        using TerminalSettingsCache = std::unordered_map<winrt::guid, TerminalSettingsCacheEntry>;
+        const til::shared_mutex<TerminalSettingsCache>& GetTerminalSettingsCache() const noexcept;
+
     private:
         static const std::filesystem::path& _settingsPath();
         static const std::filesystem::path& _releaseSettingsPath();
@@ -188,6 +202,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         // GetProfileForArgs cache
         mutable std::once_flag _commandLinesCacheOnce;
         mutable std::vector<std::pair<std::wstring, Model::Profile>> _commandLinesCache;
+
+        // TerminalSettings::CreateWithProfile cache
+        til::shared_mutex<TerminalSettingsCache> _terminalSettingsCache;
     };
 }
 
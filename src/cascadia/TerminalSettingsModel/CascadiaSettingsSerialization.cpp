@@ -162,13 +162,54 @@ SettingsLoader::SettingsLoader(const std::string_view& userJSON, const std::stri
 // (meaning profiles specified by the application rather by the user).
 void SettingsLoader::GenerateProfiles()
 {
-    _executeGenerator(PowershellCoreProfileGenerator{});
-    _executeGenerator(WslDistroGenerator{});
-    _executeGenerator(AzureCloudShellGenerator{});
-    _executeGenerator(VisualStudioGenerator{});
+    const PowershellCoreProfileGenerator powershellCoreGenerator;
+    const WslDistroGenerator wslDistroGenerator;
+    const AzureCloudShellGenerator azureCloudShellGenerator;
+    const VisualStudioGenerator visualStudioGenerator;
 #if TIL_FEATURE_DYNAMICSSHPROFILES_ENABLED
-    _executeGenerator(SshHostGenerator{});
+    const SshHostGenerator sshHostGenerator;
 #endif
+
+    const std::initializer_list<const IDynamicProfileGenerator*> generators{
+        &powershellCoreGenerator,
+        &wslDistroGenerator,
+        &azureCloudShellGenerator,
+        &visualStudioGenerator,
+#if TIL_FEATURE_DYNAMICSSHPROFILES_ENABLED
+        &sshHostGenerator,
+#endif
+    };
+
+    // Some generators are quite slow (enumerating WSL distributions, or querying the VS setup configuration
+    // for instance), but they're independent of each other. We run them concurrently on the thread pool and
+    // append their results in the order above afterwards, so that the resulting profile order is stable.
+    std::vector<std::vector<winrt::com_ptr<Profile>>> results(generators.size());
+    til::latch latch{ gsl::narrow_cast<ptrdiff_t>(generators.size()) };
+
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        const auto generator = generators.begin()[i];
+        if (_ignoredNamespaces.count(generator->GetNamespace()))
+        {
+            latch.count_down();
+            continue;
+        }
+
+        [](const IDynamicProfileGenerator& generator, std::vector<winrt::com_ptr<Profile>>& profiles, til::latch& latch) -> winrt::fire_and_forget {
+            const auto cleanup = wil::scope_exit([&]() {
+                latch.count_down();
+            });
+            co_await winrt::resume_background();
+            _executeGenerator(generator, profiles);
+        }(*generator, til::at(results, i), latch);
+    }
+
+    latch.wait();
+
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        _appendGeneratedProfiles(generators.begin()[i]->GetNamespace(), til::at(results, i));
+    }
 }
 
 // A new settings.json gets a special treatment:
@@ -341,7 +382,7 @@ void SettingsLoader::FinalizeLayering()
     if (userSettings.globals->EnableColorSelection())
     {
         const auto json = _parseJson(EnableColorSelectionSettingsJson);
-        const auto globals = GlobalAppSettings::FromJson(json.root);
+        const auto globals = GlobalAppSettings::FromJson(*json.root);
         userSettings.globals->AddLeastImportantParent(globals);
     }
 
@@ -521,6 +562,45 @@ Json::Value SettingsLoader::_parseJSON(const std::string_view& content)
     return json;
 }
 
+// Same as _parseJSON, but returns a shared, immutable result that's reused as long as the content doesn't change.
+// The settings are reloaded every time the user saves settings.json, and every window of this process loads
+// them on startup. Since the defaults.json and fragments are still the same most of the time, we can skip
+// most of the parsing. The content itself is part of the cache key, to be certain it's unchanged.
+std::shared_ptr<const Json::Value> SettingsLoader::_parseJSONCached(const std::string_view& content)
+{
+    struct Entry
+    {
+        std::string content;
+        std::shared_ptr<const Json::Value> json;
+    };
+    // Settings.json, defaults.json, the color selection settings and a couple fragments.
+    static constexpr size_t maxEntries = 32;
+    static til::shared_mutex<std::unordered_map<size_t, Entry>> cache;
+
+    const auto hash = til::hash(content);
+
+    {
+        const auto guard = cache.lock_shared();
+        if (const auto it = guard->find(hash); it != guard->end() && it->second.content == content)
+        {
+            return it->second.json;
+        }
+    }
+
+    auto json = std::make_shared<const Json::Value>(_parseJSON(content));
+
+    {
+        const auto guard = cache.lock();
+        if (guard->size() >= maxEntries)
+        {
+            guard->clear();
+        }
+        guard->insert_or_assign(hash, Entry{ std::string{ content }, json });
+    }
+
+    return json;
+}
+
 // A helper method similar to Json::Value::operator[], but compatible with std::string_view.
 const Json::Value& SettingsLoader::_getJSONValue(const Json::Value& json, const std::string_view& key) noexcept
 {
@@ -557,7 +637,7 @@ void SettingsLoader::_parse(const OriginTag origin, const winrt::hstring& source
     settings.clear();
 
     {
-        settings.globals = GlobalAppSettings::FromJson(json.root);
+        settings.globals = GlobalAppSettings::FromJson(*json.root);
 
         for (const auto& schemeJson : json.colorSchemes)
         {
@@ -685,10 +765,10 @@ void SettingsLoader::_parseFragment(const winrt::hstring& source, const std::str
 
 SettingsLoader::JsonSettings SettingsLoader::_parseJson(const std::string_view& content)
 {
-    auto root = content.empty() ? Json::Value{ Json::ValueType::objectValue } : _parseJSON(content);
-    const auto& colorSchemes = _getJSONValue(root, SchemesKey);
-    const auto& themes = _getJSONValue(root, ThemesKey);
-    const auto& profilesObject = _getJSONValue(root, ProfilesKey);
+    auto root = content.empty() ? std::make_shared<const Json::Value>(Json::ValueType::objectValue) : _parseJSONCached(content);
+    const auto& colorSchemes = _getJSONValue(*root, SchemesKey);
+    const auto& themes = _getJSONValue(*root, ThemesKey);
+    const auto& profilesObject = _getJSONValue(*root, ProfilesKey);
     const auto& profileDefaults = _getJSONValue(profilesObject, DefaultSettingsKey);
     const auto& profilesList = profilesObject.isArray() ? profilesObject : _getJSONValue(profilesObject, ProfilesListKey);
     return JsonSettings{ std::move(root), colorSchemes, profileDefaults, profilesList, themes };
@@ -781,34 +861,43 @@ void SettingsLoader::_addUserProfileParent(const winrt::com_ptr<implementation::
 }
 
 // As the name implies it executes a generator.
-// Generated profiles are added to .inboxSettings. Used by GenerateProfiles().
-void SettingsLoader::_executeGenerator(const IDynamicProfileGenerator& generator)
+// Runs the given generator on the calling thread. Used by GenerateProfiles().
+void SettingsLoader::_executeGenerator(const IDynamicProfileGenerator& generator, std::vector<winrt::com_ptr<Profile>>& profiles) noexcept
 {
     const auto generatorNamespace = generator.GetNamespace();
-    if (_ignoredNamespaces.count(generatorNamespace))
-    {
-        return;
-    }
-
-    const auto previousSize = inboxSettings.profiles.size();
 
     try
     {
-        generator.GenerateProfiles(inboxSettings.profiles);
+        // Generators like the VisualStudioGenerator use COM, which thread pool threads haven't initialized.
+        const auto hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        const auto uninit = wil::scope_exit([&]() {
+            if (SUCCEEDED(hr))
+            {
+                CoUninitialize();
+            }
+        });
+        generator.GenerateProfiles(profiles);
     }
     CATCH_LOG_MSG("Dynamic Profile Namespace: \"%.*s\"", gsl::narrow<int>(generatorNamespace.size()), generatorNamespace.data())
+}
+
+// Generated profiles are added to .inboxSettings. Used by GenerateProfiles().
+void SettingsLoader::_appendGeneratedProfiles(const std::wstring_view& generatorNamespace, std::vector<winrt::com_ptr<Profile>>& profiles)
+{
+    if (profiles.empty())
+    {
+        return;
+    }
 
     // If the generator produced some profiles we're going to give them default attributes.
     // By setting the Origin/Source/etc. here, we deduplicate some code and ensure they aren't missing accidentally.
-    if (inboxSettings.profiles.size() > previousSize)
-    {
-        const winrt::hstring source{ generatorNamespace };
+    const winrt::hstring source{ generatorNamespace };
 
-        for (const auto& profile : std::span(inboxSettings.profiles).subspan(previousSize))
-        {
-            profile->Origin(OriginTag::Generated);
-            profile->Source(source);
-        }
+    for (auto& profile : profiles)
+    {
+        profile->Origin(OriginTag::Generated);
+        profile->Source(source);
+        inboxSettings.profiles.emplace_back(std::move(profile));
     }
 }
 
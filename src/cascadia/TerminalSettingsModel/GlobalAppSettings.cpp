@@ -49,6 +49,9 @@ void GlobalAppSettings::_FinalizeInheritance()
             }
         }
     }
+
+    // Now that all of its parents were added, flatten the key bindings of the action map.
+    _actionMap->_FinalizeInheritance();
 }
 
 winrt::com_ptr<GlobalAppSettings> GlobalAppSettings::Copy() const
@@ -130,17 +133,27 @@ winrt::com_ptr<GlobalAppSettings> GlobalAppSettings::FromJson(const Json::Value&
 
 void GlobalAppSettings::LayerJson(const Json::Value& json)
 {
-    JsonUtils::GetValueForKey(json, DefaultProfileKey, _UnparsedDefaultProfile);
     // GH#8076 - when adding enum values to this key, we also changed it from
     // "useTabSwitcher" to "tabSwitcherMode". Continue supporting
-    // "useTabSwitcher", but prefer "tabSwitcherMode"
+    // "useTabSwitcher", but prefer "tabSwitcherMode". Json::Value iterates
+    // members in key order, so this one is read before the pass below.
     JsonUtils::GetValueForKey(json, LegacyUseTabSwitcherModeKey, _TabSwitcherMode);
 
+    // The remaining settings are dispatched by key in a single pass over the json object.
+    using Handler = void (*)(GlobalAppSettings&, const Json::Value&);
+    using Entry = std::pair<std::string_view, Handler>;
+
 #define GLOBAL_SETTINGS_LAYER_JSON(type, name, jsonKey, ...) \
-    JsonUtils::GetValueForKey(json, jsonKey, _##name);
-    MTSM_GLOBAL_SETTINGS(GLOBAL_SETTINGS_LAYER_JSON)
+    Entry{ jsonKey, [](GlobalAppSettings& g, const Json::Value& v) { JsonUtils::GetValue(v, g._##name); } },
+
+    static constexpr til::perfect_static_map handlers{
+        Entry{ DefaultProfileKey, [](GlobalAppSettings& g, const Json::Value& v) { JsonUtils::GetValue(v, g._UnparsedDefaultProfile); } },
+        MTSM_GLOBAL_SETTINGS(GLOBAL_SETTINGS_LAYER_JSON)
+    };
 #undef GLOBAL_SETTINGS_LAYER_JSON
 
+    JsonUtils::GetValuesForMembers(json, handlers, *this);
+
     static constexpr std::array bindingsKeys{ LegacyKeybindingsKey, ActionsKey };
     for (const auto& jsonKey : bindingsKeys)
     {
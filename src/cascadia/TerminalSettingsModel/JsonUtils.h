@@ -15,6 +15,7 @@ Author(s):
 #pragma once
 
 #include <json.h>
+#include <til/static_map.h>
 
 #include "../types/inc/utils.hpp"
 
@@ -231,6 +232,39 @@ namespace Microsoft::Terminal::Settings::Model::JsonUtils
         GetValuesForKeys(json, std::forward<Args>(args)...);
     }
 
+    // Walks the members of the given object once and calls handler(target, value)
+    // for each one whose key is found in the given til::(perfect_)static_map of handlers.
+    // This is cheaper than calling GetValueForKey for every known key, because
+    // settings objects usually only contain a handful of the keys we know about.
+    template<typename T, typename Handlers>
+    void GetValuesForMembers(const Json::Value& json, const Handlers& handlers, T& target)
+    {
+        if (!json.isObject())
+        {
+            return;
+        }
+
+        for (auto it = json.begin(), end = json.end(); it != end; ++it)
+        {
+            const char* keyEnd = nullptr;
+            const auto keyBeg = it.memberName(&keyEnd);
+            const std::string_view key{ keyBeg, gsl::narrow_cast<size_t>(keyEnd - keyBeg) };
+
+            if (const auto handler = handlers.find(key); handler != handlers.end())
+            {
+                try
+                {
+                    handler->second(target, *it);
+                }
+                catch (DeserializationError& e)
+                {
+                    e.SetKey(key);
+                    throw; // rethrow now that it has a key
+                }
+            }
+        }
+    }
+
     // SetValueForKey, type-deduced, manual converter
     template<typename T, typename Converter>
     void SetValueForKey(Json::Value& json, std::string_view key, const T& target, Converter&& conv)
@@ -944,13 +978,13 @@ namespace Microsoft::Terminal::Settings::Model::JsonUtils
         using pair_type = std::pair<std::string_view, T>;
         T FromJson(const Json::Value& json)
         {
+            // Finds the name with a single hash and string comparison, instead of comparing it with each mapping.
+            static constexpr til::perfect_static_map names{ TBase::mappings };
+
             const auto name{ Detail::GetStringView(json) };
-            for (const auto& pair : TBase::mappings)
+            if (const auto it = names.find(name); it != names.end())
             {
-                if (pair.first == name)
-                {
-                    return pair.second;
-                }
+                return it->second;
             }
 
             DeserializationError e{ json };
@@ -26,6 +26,11 @@ Author(s):
     X(bool, FocusFollowMouse, "focusFollowMouse", false)                                                                                                                                              \
     X(bool, ForceFullRepaintRendering, "experimental.rendering.forceFullRepaint", false)                                                                                                              \
     X(bool, SoftwareRendering, "experimental.rendering.software", false)                                                                                                                              \
+    X(bool, PreferLowPowerAdapter, "experimental.rendering.preferLowPowerAdapter", false)                                                                                                             \
+    X(winrt::Microsoft::Terminal::Control::RenderPacingMode, PacingMode, "experimental.rendering.pacing", winrt::Microsoft::Terminal::Control::RenderPacingMode::LowLatency)                          \
+    X(bool, SmoothScrolling, "experimental.rendering.smoothScrolling", false)                                                                                                                         \
+    X(int32_t, PixelShaderFrameRate, "experimental.rendering.pixelShaderFrameRate", 0)                                                                                                                \
+    X(int32_t, OutputGovernorThreshold, "experimental.rendering.outputGovernorThreshold", 8 * 1024 * 1024)                                                                                            \
     X(bool, UseBackgroundImageForWindow, "experimental.useBackgroundImageForWindow", false)                                                                                                           \
     X(bool, ReloadEnvironmentVariables, "compatibility.reloadEnvironmentVariables", true)                                                                                                             \
     X(bool, ForceVTInput, "experimental.input.forceVT", false)                                                                                                                                        \
@@ -63,6 +68,7 @@ Author(s):
     X(bool, ShowAdminShield, "showAdminShield", true)                                                                                                                                                 \
     X(bool, TrimPaste, "trimPaste", true)                                                                                                                                                             \
     X(bool, EnableColorSelection, "experimental.enableColorSelection", false)                                                                                                                         \
+    X(int32_t, PrewarmedControlCount, "experimental.prewarmedControls", 0)                                                                                                                            \
     X(winrt::Windows::Foundation::Collections::IVector<Model::NewTabMenuEntry>, NewTabMenu, "newTabMenu", winrt::single_threaded_vector<Model::NewTabMenuEntry>({ Model::RemainingProfilesEntry{} })) \
     X(bool, AllowHeadless, "compatibility.allowHeadless", false)                                                                                                                                      \
     X(bool, IsolatedMode, "compatibility.isolatedMode", false)                                                                                                                                        \
@@ -90,7 +96,8 @@ Author(s):
     X(bool, Elevate, "elevate", false)                                                                                                                         \
     X(bool, VtPassthrough, "experimental.connection.passthroughMode", false)                                                                                   \
     X(bool, AutoMarkPrompts, "experimental.autoMarkPrompts", false)                                                                                            \
-    X(bool, ShowMarks, "experimental.showMarksOnScrollbar", false)
+    X(bool, ShowMarks, "experimental.showMarksOnScrollbar", false)                                                                                             \
+    X(hstring, SessionRecordingPath, "experimental.sessionRecordingPath")
 
 // Intentionally omitted Profile settings:
 // * Name
@@ -165,24 +165,29 @@ void Profile::LayerJson(const Json::Value& json)
     fontInfoImpl->LayerJson(json);
 
     // Profile-specific Settings
-    JsonUtils::GetValueForKey(json, NameKey, _Name);
-    JsonUtils::GetValueForKey(json, UpdatesKey, _Updates);
-    JsonUtils::GetValueForKey(json, GuidKey, _Guid);
-    JsonUtils::GetValueForKey(json, HiddenKey, _Hidden);
-    JsonUtils::GetValueForKey(json, SourceKey, _Source);
-
-    // Padding was never specified as an integer, but it was a common working mistake.
-    // Allow it to be permissive.
-    JsonUtils::GetValueForKey(json, PaddingKey, _Padding, JsonUtils::OptionalConverter<hstring, JsonUtils::PermissiveStringConverter<std::wstring>>{});
-
-    JsonUtils::GetValueForKey(json, TabColorKey, _TabColor);
+    // They're dispatched by key in a single pass over the json object.
+    using Handler = void (*)(Profile&, const Json::Value&);
+    using Entry = std::pair<std::string_view, Handler>;
 
 #define PROFILE_SETTINGS_LAYER_JSON(type, name, jsonKey, ...) \
-    JsonUtils::GetValueForKey(json, jsonKey, _##name);
-
-    MTSM_PROFILE_SETTINGS(PROFILE_SETTINGS_LAYER_JSON)
+    Entry{ jsonKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._##name); } },
+
+    static constexpr til::perfect_static_map handlers{
+        Entry{ NameKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Name); } },
+        Entry{ UpdatesKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Updates); } },
+        Entry{ GuidKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Guid); } },
+        Entry{ HiddenKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Hidden); } },
+        Entry{ SourceKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Source); } },
+        // Padding was never specified as an integer, but it was a common working mistake.
+        // Allow it to be permissive.
+        Entry{ PaddingKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._Padding, JsonUtils::OptionalConverter<hstring, JsonUtils::PermissiveStringConverter<std::wstring>>{}); } },
+        Entry{ TabColorKey, [](Profile& p, const Json::Value& v) { JsonUtils::GetValue(v, p._TabColor); } },
+        MTSM_PROFILE_SETTINGS(PROFILE_SETTINGS_LAYER_JSON)
+    };
 #undef PROFILE_SETTINGS_LAYER_JSON
 
+    JsonUtils::GetValuesForMembers(json, handlers, *this);
+
     if (json.isMember(JsonKey(UnfocusedAppearanceKey)))
     {
         auto unfocusedAppearance{ winrt::make_self<implementation::AppearanceConfig>(weak_ref<Model::Profile>(*this)) };
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "TerminalSettings.h"
+#include "CascadiaSettings.h"
 #include "../../types/inc/colorTable.hpp"
 
 #include "TerminalSettings.g.cpp"
@@ -62,6 +63,44 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         return settings;
     }
 
+    // Method Description:
+    // - Like _CreateWithProfileCommon, but the resolved settings of each profile are
+    //   created only once per settings load and then cached in appSettings.
+    //   We return a child of them, so callers can apply their overrides freely.
+    // Arguments:
+    // - appSettings: the set of settings being used to construct the new terminal
+    // - profile: the profile to create the settings for
+    // Return Value:
+    // - A TerminalSettings that inherits from the cached settings of the profile
+    winrt::com_ptr<implementation::TerminalSettings> TerminalSettings::_CreateWithProfileCached(const Model::CascadiaSettings& appSettings, const Model::Profile& profile)
+    {
+        // The appearance may pick its color scheme based on the system theme,
+        // which can change without the settings getting reloaded.
+        const auto followsSystemTheme = appSettings.GlobalSettings().CurrentTheme().RequestedTheme() == winrt::Windows::UI::Xaml::ElementTheme::Default;
+        const auto systemInDarkTheme = followsSystemTheme && Model::Theme::IsSystemInDarkTheme();
+        const auto& cache = winrt::get_self<CascadiaSettings>(appSettings)->GetTerminalSettingsCache();
+        const auto guid = profile.Guid();
+
+        winrt::com_ptr<TerminalSettings> parent;
+        {
+            const auto entries = cache.lock_shared();
+            // The "Defaults" profile doesn't have a stable GUID yet,
+            // so we also make sure that it's actually the same profile.
+            if (const auto it = entries->find(guid); it != entries->end() && it->second.profile == profile && it->second.systemInDarkTheme == systemInDarkTheme)
+            {
+                parent.copy_from(winrt::get_self<TerminalSettings>(it->second.settings));
+            }
+        }
+
+        if (!parent)
+        {
+            parent = _CreateWithProfileCommon(appSettings, profile);
+            cache.lock()->insert_or_assign(guid, CascadiaSettings::TerminalSettingsCacheEntry{ profile, systemInDarkTheme, *parent });
+        }
+
+        return parent->CreateChild();
+    }
+
     Model::TerminalSettings TerminalSettings::CreateForPreview(const Model::CascadiaSettings& appSettings, const Model::Profile& profile)
     {
         const auto settings = _CreateWithProfileCommon(appSettings, profile);
@@ -83,7 +122,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     //   one for when the terminal is focused and the other for when the terminal is unfocused
     Model::TerminalSettingsCreateResult TerminalSettings::CreateWithProfile(const Model::CascadiaSettings& appSettings, const Model::Profile& profile, const IKeyBindings& keybindings)
     {
-        const auto settings = _CreateWithProfileCommon(appSettings, profile);
+        const auto settings = _CreateWithProfileCached(appSettings, profile);
         settings->_KeyBindings = keybindings;
 
         Model::TerminalSettings child{ nullptr };
@@ -343,6 +382,11 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         _FocusFollowMouse = globalSettings.FocusFollowMouse();
         _ForceFullRepaintRendering = globalSettings.ForceFullRepaintRendering();
         _SoftwareRendering = globalSettings.SoftwareRendering();
+        _PreferLowPowerAdapter = globalSettings.PreferLowPowerAdapter();
+        _PacingMode = globalSettings.PacingMode();
+        _SmoothScrolling = globalSettings.SmoothScrolling();
+        _PixelShaderFrameRate = globalSettings.PixelShaderFrameRate();
+        _OutputGovernorThreshold = globalSettings.OutputGovernorThreshold();
         _UseBackgroundImageForWindow = globalSettings.UseBackgroundImageForWindow();
         _ForceVTInput = globalSettings.ForceVTInput();
         _TrimBlockSelection = globalSettings.TrimBlockSelection();
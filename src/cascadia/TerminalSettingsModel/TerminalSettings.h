@@ -154,6 +154,11 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         INHERITABLE_SETTING(Model::TerminalSettings, bool, RetroTerminalEffect, false);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, ForceFullRepaintRendering, false);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, SoftwareRendering, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, bool, PreferLowPowerAdapter, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, Microsoft::Terminal::Control::RenderPacingMode, PacingMode, Microsoft::Terminal::Control::RenderPacingMode::LowLatency);
+        INHERITABLE_SETTING(Model::TerminalSettings, bool, SmoothScrolling, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, int32_t, PixelShaderFrameRate, 0);
+        INHERITABLE_SETTING(Model::TerminalSettings, int32_t, OutputGovernorThreshold, 8 * 1024 * 1024);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, UseBackgroundImageForWindow, false);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, ForceVTInput, false);
 
@@ -170,6 +175,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         std::span<Microsoft::Terminal::Core::Color> _getColorTableImpl();
 
         static winrt::com_ptr<implementation::TerminalSettings> _CreateWithProfileCommon(const Model::CascadiaSettings& appSettings, const Model::Profile& profile);
+        static winrt::com_ptr<implementation::TerminalSettings> _CreateWithProfileCached(const Model::CascadiaSettings& appSettings, const Model::Profile& profile);
         void _ApplyProfileSettings(const Model::Profile& profile);
 
         void _ApplyGlobalSettings(const Model::GlobalAppSettings& globalSettings) noexcept;
@@ -37,6 +37,7 @@ namespace ControlUnitTests
         TEST_METHOD(TestClearScreen);
         TEST_METHOD(TestClearAll);
         TEST_METHOD(TestReadEntireBuffer);
+        TEST_METHOD(TestExportToPath);
 
         TEST_METHOD(TestSelectCommandSimple);
         TEST_METHOD(TestSelectOutputSimple);
@@ -361,6 +362,39 @@ namespace ControlUnitTests
         VERIFY_ARE_EQUAL(L"This is some text\r\nwith varying amounts\r\nof whitespace\r\n",
                          core->ReadEntireBuffer());
     }
+
+    void ControlCoreTests::TestExportToPath()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+        Log::Comment(L"Create ControlCore object");
+        auto core = createCore(*settings, *conn);
+        VERIFY_IS_NOT_NULL(core);
+        _standardInit(core);
+
+        Log::Comment(L"Print more text than fits into a single chunk");
+        for (auto i = 0; i < 3000; i++)
+        {
+            conn->WriteInput(winrt::hstring{ fmt::format(L"line {}  \u00e4\r\n", i) });
+        }
+
+        wchar_t tempPath[MAX_PATH];
+        VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(MAX_PATH, &tempPath[0]));
+        const auto path = std::wstring{ &tempPath[0] } + L"TestExportToPath.txt";
+        const auto cleanup = wil::scope_exit([&]() { DeleteFileW(path.c_str()); });
+
+        Log::Comment(L"The file should contain the same text as ReadEntireBuffer(), as UTF-8");
+        core->ExportToPath(winrt::hstring{ path });
+
+        const wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        VERIFY_IS_TRUE(bool{ file });
+
+        std::string contents(1024 * 1024, '\0');
+        DWORD read = 0;
+        VERIFY_WIN32_BOOL_SUCCEEDED(ReadFile(file.get(), contents.data(), gsl::narrow<DWORD>(contents.size()), &read, nullptr));
+        contents.resize(read);
+
+        VERIFY_ARE_EQUAL(til::u16u8(core->ReadEntireBuffer()), contents);
+    }
     void _writePrompt(const winrt::com_ptr<MockConnection>& conn, const auto& path)
     {
         conn->WriteInput(L"\x1b]133;D\x7");
@@ -383,6 +383,38 @@ namespace TerminalCoreUnitTests
             }
         }
 
+        TEST_METHOD(VisibleSelectionRects)
+        {
+            Terminal term;
+            DummyRenderer renderer{ &term };
+            term.Create({ 10, 10 }, 100, renderer);
+
+            // Select from (5,5) to (5,50), which extends far past the viewport.
+            term.SetSelectionAnchor({ 5, 5 });
+            term.SetSelectionEnd({ 5, 50 });
+
+            VERIFY_ARE_EQUAL(term.GetSelectionRects().size(), static_cast<size_t>(46));
+
+            // Only the rows 5 to 9 are visible.
+            auto visibleRects = term.GetVisibleSelectionRects();
+            VERIFY_ARE_EQUAL(visibleRects.size(), static_cast<size_t>(5));
+            VERIFY_ARE_EQUAL(til::inclusive_rect({ 5, 5, 9, 5 }), visibleRects[0].ToInclusive());
+            VERIFY_ARE_EQUAL(til::inclusive_rect({ 0, 9, 9, 9 }), visibleRects[4].ToInclusive());
+
+            // The rects are cached, but rows whose contents changed need to be recomputed.
+            // Writing a wide glyph at (4,5) makes the selection expand to include its leading half.
+            term.GetTextBuffer().GetCursor().SetPosition({ 4, 5 });
+            term.Write(L"\xD83C\xDF2F");
+
+            visibleRects = term.GetVisibleSelectionRects();
+            VERIFY_ARE_EQUAL(visibleRects.size(), static_cast<size_t>(5));
+            VERIFY_ARE_EQUAL(til::inclusive_rect({ 4, 5, 9, 5 }), visibleRects[0].ToInclusive());
+            VERIFY_ARE_EQUAL(til::inclusive_rect({ 0, 6, 9, 6 }), visibleRects[1].ToInclusive());
+
+            term.ClearSelection();
+            VERIFY_ARE_EQUAL(term.GetVisibleSelectionRects().size(), static_cast<size_t>(0));
+        }
+
         TEST_METHOD(SelectWideGlyph_Trailing)
         {
             Terminal term;
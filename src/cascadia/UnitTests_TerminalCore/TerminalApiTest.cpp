@@ -11,6 +11,7 @@
 
 using namespace winrt::Microsoft::Terminal::Core;
 using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::VirtualTerminal;
 
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -41,6 +42,8 @@ namespace TerminalCoreUnitTests
 
         TEST_METHOD(SetTaskbarProgress);
         TEST_METHOD(SetWorkingDirectory);
+
+        TEST_METHOD(ScrollMarksAcrossBufferRotation);
     };
 };
 
@@ -476,3 +479,49 @@ void TerminalCoreUnitTests::TerminalApiTest::SetWorkingDirectory()
     stateMachine.ProcessString(L"\x1b]9;9;D:\\中文\x1b\\");
     VERIFY_ARE_EQUAL(term.GetWorkingDirectory(), L"D:\\中文");
 }
+
+void TerminalApiTest::ScrollMarksAcrossBufferRotation()
+{
+    Terminal term;
+    DummyRenderer renderer{ &term };
+    term.Create({ 100, 10 }, 10, renderer);
+
+    auto& stateMachine = *(term._stateMachine);
+
+    // Each of these prompts takes up 2 rows: The prompt & commandline,
+    // followed by the output. Writing 30 of them into a 20 row buffer
+    // moves the cursor to row 60 and rotates the buffer 41 times. That
+    // leaves us with the last 9 marks, which now start at the odd rows.
+    for (auto i = 0; i < 30; ++i)
+    {
+        stateMachine.ProcessString(L"\x1b]133;A\x1b\\$ \x1b]133;B\x1b\\cmd\r\n\x1b]133;C\x1b\\out\r\n\x1b]133;D;0\x1b\\");
+    }
+
+    const auto marks = term.GetScrollMarks();
+    VERIFY_ARE_EQUAL(9u, marks.size());
+
+    for (size_t i = 0; i < marks.size(); ++i)
+    {
+        const auto& mark = til::at(marks, i);
+        const auto y = gsl::narrow_cast<til::CoordType>(i * 2 + 1);
+        VERIFY_ARE_EQUAL(til::point(0, y), mark.start);
+        VERIFY_ARE_EQUAL(til::point(2, y), mark.end);
+        VERIFY_IS_TRUE(mark.commandEnd.has_value());
+        VERIFY_ARE_EQUAL(til::point(0, y + 1), *mark.commandEnd);
+        VERIFY_IS_TRUE(mark.outputEnd.has_value());
+        VERIFY_ARE_EQUAL(til::point(0, y + 2), *mark.outputEnd);
+        VERIFY_IS_TRUE(mark.category == DispatchTypes::MarkCategory::Success);
+    }
+
+    const auto after = term.GetScrollMarkAfter(3);
+    VERIFY_IS_TRUE(after.has_value());
+    VERIFY_ARE_EQUAL(til::point(0, 5), after->start);
+
+    const auto before = term.GetScrollMarkBefore(3);
+    VERIFY_IS_TRUE(before.has_value());
+    VERIFY_ARE_EQUAL(til::point(0, 1), before->start);
+
+    VERIFY_IS_FALSE(term.GetScrollMarkBefore(1).has_value());
+    VERIFY_IS_FALSE(term.GetScrollMarkAfter(17).has_value());
+    VERIFY_ARE_EQUAL(2u, term.GetScrollMarks(4, 8).size());
+}
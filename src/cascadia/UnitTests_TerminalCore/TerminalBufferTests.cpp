@@ -53,6 +53,8 @@ class TerminalCoreUnitTests::TerminalBufferTests final
 
     TEST_METHOD(TestCursorNotifications);
 
+    TEST_METHOD(TestLiveResizeMatchesUserResize);
+
     TEST_METHOD_SETUP(MethodSetup)
     {
         // STEP 1: Set up the Terminal
@@ -636,3 +638,44 @@ void TerminalBufferTests::TestCursorNotifications()
     VERIFY_ARE_EQUAL(0, expectedCallbacks);
     VERIFY_IS_TRUE(callbackWasCalled);
 }
+
+void TerminalBufferTests::TestLiveResizeMatchesUserResize()
+{
+    static constexpr til::CoordType historyLength = 1000;
+    static constexpr til::size newSize{ 37, 20 };
+
+    // Two terminals with plenty of scrollback, some of which wraps once it's narrower.
+    Terminal terms[2];
+    for (auto& t : terms)
+    {
+        t.Create({ TerminalViewWidth, TerminalViewHeight }, historyLength, *emptyRenderer);
+        for (auto i = 0; i < 600; i++)
+        {
+            t.Write(fmt::format(L"{:0>{}}\r\n", i, i % 50));
+        }
+    }
+
+    auto& live = terms[0];
+    auto& user = terms[1];
+
+    VERIFY_SUCCEEDED(live.LiveResize({ 60, 30 }));
+    VERIFY_IS_NOT_NULL(live._deferredHistory.get());
+    VERIFY_SUCCEEDED(live.LiveResize(newSize));
+    live.FinishLiveResize();
+    VERIFY_IS_NULL(live._deferredHistory.get());
+
+    VERIFY_SUCCEEDED(user.UserResize(newSize));
+
+    VERIFY_ARE_EQUAL(user.GetViewport().Top(), live.GetViewport().Top());
+    VERIFY_ARE_EQUAL(user.GetViewport().Height(), live.GetViewport().Height());
+    VERIFY_ARE_EQUAL(user._scrollOffset, live._scrollOffset);
+    VERIFY_ARE_EQUAL(user._mainBuffer->GetCursor().GetPosition(), live._mainBuffer->GetCursor().GetPosition());
+
+    for (til::CoordType y = 0; y < user._mainBuffer->TotalRowCount(); y++)
+    {
+        const auto& expected = user._mainBuffer->GetRowByOffset(y);
+        const auto& actual = live._mainBuffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+        VERIFY_ARE_EQUAL(expected.WasWrapForced(), actual.WasWrapForced());
+    }
+}
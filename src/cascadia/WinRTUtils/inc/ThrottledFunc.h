@@ -3,8 +3,88 @@
 
 #pragma once
 
+#include "til/mutex.h"
 #include "til/throttled_func.h"
 
+// Collects the callbacks of all ThrottledFunc instances sharing a DispatcherQueue
+// and runs the ones that are due around the same time in a single dispatcher task.
+// Nothing is enqueued while no callbacks are pending.
+class ThrottledFuncBatch : public std::enable_shared_from_this<ThrottledFuncBatch>
+{
+public:
+    explicit ThrottledFuncBatch(winrt::Windows::System::DispatcherQueue dispatcher) :
+        _dispatcher{ std::move(dispatcher) }
+    {
+    }
+
+    // Returns the batch for the given dispatcher. It lives as long as any ThrottledFunc uses it.
+    static std::shared_ptr<ThrottledFuncBatch> Get(const winrt::Windows::System::DispatcherQueue& dispatcher)
+    {
+        static til::shared_mutex<std::vector<std::weak_ptr<ThrottledFuncBatch>>> instances;
+
+        const auto guard = instances.lock();
+
+        std::erase_if(*guard, [](const auto& weak) { return weak.expired(); });
+
+        for (const auto& weak : *guard)
+        {
+            if (auto instance = weak.lock(); instance && instance->_dispatcher == dispatcher)
+            {
+                return instance;
+            }
+        }
+
+        auto instance = std::make_shared<ThrottledFuncBatch>(dispatcher);
+        guard->emplace_back(instance);
+        return instance;
+    }
+
+    void Post(std::function<void()> func)
+    {
+        {
+            const auto guard = _pending.lock();
+            guard->emplace_back(std::move(func));
+            // Another Post() already enqueued the task that will run this callback.
+            if (guard->size() != 1)
+            {
+                return;
+            }
+        }
+
+        const auto enqueued = _dispatcher.TryEnqueue(winrt::Windows::System::DispatcherQueuePriority::Normal, [self = shared_from_this()]() {
+            self->_run();
+        });
+        // If the dispatcher is shutting down, the callbacks won't ever run.
+        // Dropping them allows the next Post() to try again.
+        if (!enqueued)
+        {
+            _pending.lock()->clear();
+        }
+    }
+
+private:
+    void _run()
+    {
+        std::vector<std::function<void()>> funcs;
+        {
+            const auto guard = _pending.lock();
+            funcs.swap(*guard);
+        }
+
+        for (const auto& func : funcs)
+        {
+            try
+            {
+                func();
+            }
+            CATCH_LOG();
+        }
+    }
+
+    winrt::Windows::System::DispatcherQueue _dispatcher;
+    til::shared_mutex<std::vector<std::function<void()>>> _pending;
+};
+
 // ThrottledFunc is a copy of til::throttled_func,
 // specialized for the use with a WinRT Dispatcher.
 template<bool leading, typename... Args>
@@ -23,11 +103,15 @@ public:
     //   be started. After the timer has expired `func` will be invoked just once.
     //
     // After `func` was invoked the state is reset and this cycle is repeated again.
+    //
+    // `slack` is how much later than `delay` the timer may fire, see til::throttled_func.
+    // Instances on the same dispatcher whose timers fire together run in a single dispatcher task.
     ThrottledFunc(
         winrt::Windows::System::DispatcherQueue dispatcher,
         filetime_duration delay,
-        function func) :
-        _dispatcher{ std::move(dispatcher) },
+        function func,
+        std::chrono::milliseconds slack = {}) :
+        _batch{ ThrottledFuncBatch::Get(dispatcher) },
         _func{ std::move(func) },
         _timer{ _create_timer() }
     {
@@ -38,6 +122,13 @@ public:
         }
 
         memcpy(&_delay, &d, sizeof(d));
+
+        if (slack.count() < 0 || slack.count() > MAXDWORD)
+        {
+            throw std::invalid_argument("invalid slack specified");
+        }
+
+        _slack = static_cast<DWORD>(slack.count());
     }
 
     // ThrottledFunc uses its `this` pointer when creating _timer.
@@ -81,7 +172,7 @@ private:
     {
         if constexpr (leading)
         {
-            _dispatcher.TryEnqueue(winrt::Windows::System::DispatcherQueuePriority::Normal, [weakSelf = this->weak_from_this()]() {
+            _batch->Post([weakSelf = this->weak_from_this()]() {
                 if (auto self{ weakSelf.lock() })
                 {
                     try
@@ -90,13 +181,13 @@ private:
                     }
                     CATCH_LOG();
 
-                    SetThreadpoolTimerEx(self->_timer.get(), &self->_delay, 0, 0);
+                    SetThreadpoolTimerEx(self->_timer.get(), &self->_delay, 0, self->_slack);
                 }
             });
         }
         else
         {
-            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, 0);
+            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, _slack);
         }
     }
 
@@ -108,14 +199,10 @@ private:
         }
         else
         {
-            _dispatcher.TryEnqueue(winrt::Windows::System::DispatcherQueuePriority::Normal, [weakSelf = this->weak_from_this()]() {
+            _batch->Post([weakSelf = this->weak_from_this()]() {
                 if (auto self{ weakSelf.lock() })
                 {
-                    try
-                    {
-                        std::apply(self->_func, self->_storage.take());
-                    }
-                    CATCH_LOG();
+                    std::apply(self->_func, self->_storage.take());
                 }
             });
         }
@@ -129,7 +216,8 @@ private:
     }
 
     FILETIME _delay;
-    winrt::Windows::System::DispatcherQueue _dispatcher;
+    DWORD _slack = 0;
+    std::shared_ptr<ThrottledFuncBatch> _batch;
     function _func;
 
     wil::unique_threadpool_timer _timer;
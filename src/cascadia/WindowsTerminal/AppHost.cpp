@@ -313,6 +313,7 @@ void AppHost::Initialize()
     _window->DragRegionClicked([this]() { _windowLogic.TitlebarClicked(); });
 
     _window->WindowVisibilityChanged([this](bool showOrHide) { _windowLogic.WindowVisibilityChanged(showOrHide); });
+    _window->SessionLockChanged([this](bool locked) { _windowLogic.SessionLockChanged(locked); });
 
     _window->UpdateSettingsRequested({ this, &AppHost::_requestUpdateSettings });
 
@@ -0,0 +1,384 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "CommandlineChannel.h"
+
+#include "../../types/inc/utils.hpp"
+
+using namespace ::Microsoft::Console;
+
+// A commandline is at most 32767 characters long, and so is a path (in theory).
+// Anything beyond what these two can add up to isn't something we've sent.
+static constexpr size_t maxMessageSize = 256 * 1024;
+
+// Method Description:
+// - Collects the commandline, working directory and requested show state of
+//   the current process.
+// Arguments:
+// - <none>
+// Return Value:
+// - The commandline of this process.
+CommandlineChannel::Commandline CommandlineChannel::Commandline::FromCurrentProcess()
+{
+    Commandline commandline;
+
+    if (const auto cmdline{ GetCommandLineW() })
+    {
+        auto argc = 0;
+
+        wil::unique_any<LPWSTR*, decltype(&::LocalFree), ::LocalFree> argv{ CommandLineToArgvW(cmdline, &argc) };
+        if (argv)
+        {
+            for (auto& elem : wil::make_range(argv.get(), argc))
+            {
+                commandline.args.emplace_back(elem);
+            }
+        }
+    }
+    if (commandline.args.empty())
+    {
+        commandline.args.emplace_back(L"wt.exe");
+    }
+
+    commandline.cwd = wil::GetCurrentDirectoryW<std::wstring>();
+
+    // Get the requested initial state of the window from our startup info. For
+    // something like `start /min`, this will set the wShowWindow member to
+    // SW_SHOWMINIMIZED. We'll need to make sure is bubbled all the way through,
+    // so we can open a new window with the same state.
+    STARTUPINFOW si;
+    GetStartupInfoW(&si);
+    commandline.showWindow = WI_IsFlagSet(si.dwFlags, STARTF_USESHOWWINDOW) ? si.wShowWindow : SW_SHOW;
+
+    return commandline;
+}
+
+// Method Description:
+// - Attempts to hand the given commandline to an already running instance of
+//   WindowsTerminal.exe from the same install location.
+// Arguments:
+// - commandline: The commandline to forward.
+// Return Value:
+// - true if the other instance has handled the commandline and we may exit.
+//   false if there's no such instance, or it asked us to handle it ourselves.
+bool CommandlineChannel::TryForward(const Commandline& commandline) noexcept
+try
+{
+    const auto name = _pipeName();
+    // If the listener is busy serving another client we won't wait for it.
+    // The COM path is still around to deal with that case.
+    wil::unique_hfile pipe{ CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr) };
+    if (!pipe)
+    {
+        return false;
+    }
+
+    DWORD mode = PIPE_READMODE_MESSAGE;
+    if (!SetNamedPipeHandleState(pipe.get(), &mode, nullptr, nullptr))
+    {
+        return false;
+    }
+
+    // Don't hand our commandline to whoever managed to grab the pipe name
+    // first. It has to be another instance of this very executable.
+    ULONG serverProcessId = 0;
+    if (!GetNamedPipeServerProcessId(pipe.get(), &serverProcessId))
+    {
+        return false;
+    }
+    const wil::unique_handle serverProcess{ OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, serverProcessId) };
+    if (!serverProcess)
+    {
+        return false;
+    }
+    std::wstring serverPath;
+    if (FAILED(wil::QueryFullProcessImageNameW(serverProcess.get(), 0, serverPath)))
+    {
+        return false;
+    }
+    const auto ourPath = wil::GetModuleFileNameW<std::wstring>(nullptr);
+    if (CompareStringOrdinal(serverPath.data(), gsl::narrow<int>(serverPath.size()), ourPath.data(), gsl::narrow<int>(ourPath.size()), TRUE) != CSTR_EQUAL)
+    {
+        return false;
+    }
+
+    // The other instance is about to create or summon a window on our behalf.
+    AllowSetForegroundWindow(serverProcessId);
+
+    const auto message = _serialize(commandline);
+    DWORD written = 0;
+    if (!WriteFile(pipe.get(), message.data(), gsl::narrow<DWORD>(message.size()), &written, nullptr))
+    {
+        return false;
+    }
+
+    uint8_t handled = 0;
+    DWORD read = 0;
+    if (!ReadFile(pipe.get(), &handled, sizeof(handled), &read, nullptr) || read != sizeof(handled))
+    {
+        return false;
+    }
+    return handled != 0;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return false;
+}
+
+CommandlineChannel::~CommandlineChannel()
+{
+    if (_thread.joinable())
+    {
+        _stopEvent.SetEvent();
+        _thread.join();
+    }
+}
+
+// Method Description:
+// - Starts accepting commandlines from other instances on a background thread.
+//   If another process already owns the pipe, this silently does nothing.
+// Arguments:
+// - dispatcher: The thread that the handler should be called on.
+// - handler: Called for every received commandline. Returns true if the
+//   commandline was handled and the sending process may exit.
+// Return Value:
+// - <none>
+void CommandlineChannel::Listen(winrt::Windows::System::DispatcherQueue dispatcher, Handler handler)
+{
+    // Only a single instance of the pipe is allowed. While it's busy, other
+    // clients will fail to connect and fall back to the COM path.
+    wil::unique_hfile pipe{ CreateNamedPipeW(_pipeName().c_str(),
+                                             PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE | FILE_FLAG_OVERLAPPED,
+                                             PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                             1,
+                                             4096,
+                                             4096,
+                                             0,
+                                             nullptr) };
+    if (!pipe)
+    {
+        LOG_LAST_ERROR();
+        return;
+    }
+
+    _stopEvent.create(wil::EventOptions::ManualReset);
+    _ioEvent.create(wil::EventOptions::ManualReset);
+    _dispatcher = std::move(dispatcher);
+    _handler = std::move(handler);
+    _thread = std::thread([this, pipe = std::move(pipe)]() {
+        _run(pipe.get());
+    });
+}
+
+// The pipe is scoped the same way as the Monarch: per session, per elevation
+// level and (for unpackaged installs) per install location.
+std::wstring CommandlineChannel::_pipeName()
+{
+    DWORD sessionId = 0;
+    LOG_IF_WIN32_BOOL_FALSE(ProcessIdToSessionId(GetCurrentProcessId(), &sessionId));
+
+    std::filesystem::path modulePath{ wil::GetModuleFileNameW<std::wstring>(nullptr) };
+    modulePath.remove_filename();
+    const std::wstring_view directory{ modulePath.native() };
+
+    return fmt::format(FMT_COMPILE(L"\\\\.\\pipe\\WindowsTerminal-{}-{:016x}{}"),
+                       sessionId,
+                       til::hash(directory),
+                       Utils::IsRunningElevated() ? L"-Admin" : L"");
+}
+
+// The message consists of the show state, the number of strings, followed by
+// each string (the CWD first, then the args) prefixed with its length.
+std::string CommandlineChannel::_serialize(const Commandline& commandline)
+{
+    std::string buffer;
+    const auto append = [&](const uint32_t value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    const auto appendString = [&](const std::wstring_view str) {
+        append(gsl::narrow<uint32_t>(str.size()));
+        buffer.append(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(wchar_t));
+    };
+
+    append(commandline.showWindow);
+    append(gsl::narrow<uint32_t>(commandline.args.size() + 1));
+    appendString(commandline.cwd);
+    for (const auto& arg : commandline.args)
+    {
+        appendString(arg);
+    }
+    return buffer;
+}
+
+std::optional<CommandlineChannel::Commandline> CommandlineChannel::_deserialize(std::string_view buffer)
+{
+    const auto read = [&](uint32_t& value) {
+        if (buffer.size() < sizeof(value))
+        {
+            return false;
+        }
+        memcpy(&value, buffer.data(), sizeof(value));
+        buffer = buffer.substr(sizeof(value));
+        return true;
+    };
+
+    Commandline commandline;
+    uint32_t count = 0;
+    if (!read(commandline.showWindow) || !read(count) || count == 0)
+    {
+        return std::nullopt;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t length = 0;
+        if (!read(length) || buffer.size() / sizeof(wchar_t) < length)
+        {
+            return std::nullopt;
+        }
+
+        std::wstring str(length, L'\0');
+        memcpy(str.data(), buffer.data(), length * sizeof(wchar_t));
+        buffer = buffer.substr(length * sizeof(wchar_t));
+
+        if (i == 0)
+        {
+            commandline.cwd = std::move(str);
+        }
+        else
+        {
+            commandline.args.emplace_back(std::move(str));
+        }
+    }
+
+    if (!buffer.empty() || commandline.args.empty())
+    {
+        return std::nullopt;
+    }
+    return commandline;
+}
+
+// Starts the overlapped operation `op` and waits for it to finish, unless
+// we're asked to stop first. Returns the operation's Win32 error code.
+template<typename Op>
+DWORD CommandlineChannel::_overlapped(const HANDLE pipe, DWORD& transferred, Op&& op) const noexcept
+{
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = _ioEvent.get();
+    transferred = 0;
+
+    if (!op(&overlapped))
+    {
+        const auto gle = GetLastError();
+        if (gle == ERROR_PIPE_CONNECTED)
+        {
+            return ERROR_SUCCESS;
+        }
+        if (gle != ERROR_IO_PENDING)
+        {
+            return gle;
+        }
+
+        const HANDLE handles[]{ _stopEvent.get(), _ioEvent.get() };
+        if (WaitForMultipleObjects(2, &handles[0], FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+        {
+            // The OVERLAPPED lives on our stack, so we must wait for the
+            // cancellation to complete before returning.
+            CancelIoEx(pipe, &overlapped);
+            std::ignore = GetOverlappedResult(pipe, &overlapped, &transferred, TRUE);
+            return ERROR_OPERATION_ABORTED;
+        }
+    }
+
+    return GetOverlappedResult(pipe, &overlapped, &transferred, FALSE) ? ERROR_SUCCESS : GetLastError();
+}
+
+void CommandlineChannel::_run(const HANDLE pipe)
+{
+    DWORD transferred = 0;
+
+    while (!_stopEvent.is_signaled())
+    {
+        const auto gle = _overlapped(pipe, transferred, [&](auto o) { return ConnectNamedPipe(pipe, o); });
+        if (gle == ERROR_SUCCESS)
+        {
+            _serve(pipe);
+        }
+        // ERROR_NO_DATA: The client hung up before we got to it.
+        else if (gle != ERROR_NO_DATA && gle != ERROR_OPERATION_ABORTED)
+        {
+            LOG_WIN32(gle);
+            return;
+        }
+        DisconnectNamedPipe(pipe);
+    }
+}
+
+void CommandlineChannel::_serve(const HANDLE pipe)
+{
+    std::string message;
+    char chunk[4096];
+    DWORD transferred = 0;
+
+    for (;;)
+    {
+        const auto gle = _overlapped(pipe, transferred, [&](auto o) { return ReadFile(pipe, &chunk[0], sizeof(chunk), nullptr, o); });
+        message.append(&chunk[0], transferred);
+        if (gle == ERROR_SUCCESS)
+        {
+            break;
+        }
+        if (gle != ERROR_MORE_DATA || message.size() > maxMessageSize)
+        {
+            return;
+        }
+    }
+
+    auto commandline = _deserialize(message);
+    if (!commandline)
+    {
+        return;
+    }
+
+    // The handler runs on the dispatcher's thread, which we wait for (or
+    // for our own shutdown, in which case the client is left to fend for itself).
+    struct Request
+    {
+        Commandline commandline;
+        wil::unique_event done{ wil::EventOptions::ManualReset };
+        bool handled = false;
+    };
+    const auto request = std::make_shared<Request>();
+    request->commandline = std::move(*commandline);
+
+    if (!_dispatcher.TryEnqueue([request, handler = _handler]() {
+            const auto signal = wil::scope_exit([&]() { request->done.SetEvent(); });
+            try
+            {
+                request->handled = handler(std::move(request->commandline));
+            }
+            CATCH_LOG();
+        }))
+    {
+        return;
+    }
+
+    const HANDLE handles[]{ _stopEvent.get(), request->done.get() };
+    if (WaitForMultipleObjects(2, &handles[0], FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+    {
+        return;
+    }
+
+    const uint8_t handled = request->handled;
+    if (_overlapped(pipe, transferred, [&](auto o) { return WriteFile(pipe, &handled, sizeof(handled), nullptr, o); }) != ERROR_SUCCESS)
+    {
+        return;
+    }
+
+    // DisconnectNamedPipe() discards anything the client hasn't read yet.
+    // Instead of FlushFileBuffers(), which can't be cancelled, wait for the
+    // client to hang up, which it does right after reading the reply.
+    _overlapped(pipe, transferred, [&](auto o) { return ReadFile(pipe, &chunk[0], sizeof(chunk), nullptr, o); });
+}
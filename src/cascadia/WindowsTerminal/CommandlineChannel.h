@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation Licensed under the MIT license.
+
+Class Name:
+- CommandlineChannel.h
+
+Abstract:
+- A named pipe over which a freshly launched WindowsTerminal.exe can hand its
+  commandline to the process that's already hosting our windows.
+- Going through the Monarch's COM server works, but requires the new process
+  to first spin up COM, the XAML App and load the settings, only to then exit
+  again. TryForward() is meant to be called before any of that happens.
+- The pipe is scoped to the session, the elevation level and the install
+  location of the executable, mirroring how the Monarch's CLSID is scoped.
+  If anything about the handoff fails, the caller falls back to the COM path.
+
+--*/
+
+#pragma once
+#include "pch.h"
+
+class CommandlineChannel
+{
+public:
+    struct Commandline
+    {
+        std::vector<std::wstring> args;
+        std::wstring cwd;
+        uint32_t showWindow = SW_SHOW;
+
+        static Commandline FromCurrentProcess();
+    };
+
+    // Runs on the dispatcher passed to Listen(). Returns true if the commandline has been
+    // fully handled and the client process may exit.
+    using Handler = std::function<bool(Commandline&&)>;
+
+    static bool TryForward(const Commandline& commandline) noexcept;
+
+    CommandlineChannel() = default;
+    ~CommandlineChannel();
+
+    void Listen(winrt::Windows::System::DispatcherQueue dispatcher, Handler handler);
+
+private:
+    static std::wstring _pipeName();
+    static std::string _serialize(const Commandline& commandline);
+    static std::optional<Commandline> _deserialize(std::string_view buffer);
+
+    template<typename Op>
+    DWORD _overlapped(HANDLE pipe, DWORD& transferred, Op&& op) const noexcept;
+    void _run(HANDLE pipe);
+    void _serve(HANDLE pipe);
+
+    winrt::Windows::System::DispatcherQueue _dispatcher{ nullptr };
+    Handler _handler;
+    wil::unique_event _stopEvent;
+    wil::unique_event _ioEvent;
+    std::thread _thread;
+};
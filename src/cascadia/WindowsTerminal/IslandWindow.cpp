@@ -8,6 +8,7 @@
 #include "icon.h"
 #include "NotificationIcon.h"
 #include <dwmapi.h>
+#include <WtsApi32.h>
 #include <TerminalThemeHelpers.h>
 #include <CoreWindow.h>
 
@@ -212,6 +213,9 @@ void IslandWindow::_HandleCreateWindow(const WPARAM, const LPARAM lParam) noexce
     UpdateWindow(_window.get());
 
     UpdateWindowIconForActiveMetrics(_window.get());
+
+    // Get WM_WTSSESSION_CHANGE messages, so that we can stop rendering while the session is locked.
+    LOG_IF_WIN32_BOOL_FALSE(WTSRegisterSessionNotification(_window.get(), NOTIFY_FOR_THIS_SESSION));
 }
 
 // Method Description:
@@ -717,6 +721,30 @@ long IslandWindow::_calculateTotalSize(const bool isWidth, const long clientSize
         }
         break;
     }
+    case WM_WTSSESSION_CHANGE:
+    {
+        switch (wparam)
+        {
+        case WTS_SESSION_LOCK:
+        case WTS_CONSOLE_DISCONNECT:
+        case WTS_REMOTE_DISCONNECT:
+            _SessionLockChangedHandlers(true);
+            break;
+        case WTS_SESSION_UNLOCK:
+        case WTS_CONSOLE_CONNECT:
+        case WTS_REMOTE_CONNECT:
+            _SessionLockChangedHandlers(false);
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    case WM_DESTROY:
+    {
+        WTSUnRegisterSessionNotification(_window.get());
+        break;
+    }
     case WM_ENDSESSION:
     {
         // For WM_QUERYENDSESSION and WM_ENDSESSION, refer to:
@@ -82,6 +82,7 @@ public:
 
     WINRT_CALLBACK(WindowMoved, winrt::delegate<void()>);
     WINRT_CALLBACK(WindowVisibilityChanged, winrt::delegate<void(bool)>);
+    WINRT_CALLBACK(SessionLockChanged, winrt::delegate<void(bool)>);
     WINRT_CALLBACK(UpdateSettingsRequested, winrt::delegate<void()>);
 
 protected:
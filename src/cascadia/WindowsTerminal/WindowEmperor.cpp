@@ -59,33 +59,21 @@ WindowEmperor::~WindowEmperor()
     _app = nullptr;
 }
 
-void _buildArgsFromCommandline(std::vector<winrt::hstring>& args)
+static Remoting::CommandlineArgs _makeCommandlineArgs(const CommandlineChannel::Commandline& commandline)
 {
-    if (auto commandline{ GetCommandLineW() })
-    {
-        auto argc = 0;
-
-        // Get the argv, and turn them into a hstring array to pass to the app.
-        wil::unique_any<LPWSTR*, decltype(&::LocalFree), ::LocalFree> argv{ CommandLineToArgvW(commandline, &argc) };
-        if (argv)
-        {
-            for (auto& elem : wil::make_range(argv.get(), argc))
-            {
-                args.emplace_back(elem);
-            }
-        }
-    }
-    if (args.empty())
+    // Turn the argv into a hstring array to pass to the app.
+    std::vector<winrt::hstring> args;
+    args.reserve(commandline.args.size());
+    for (const auto& arg : commandline.args)
     {
-        args.emplace_back(L"wt.exe");
+        args.emplace_back(arg);
     }
+    return Remoting::CommandlineArgs{ { args }, { commandline.cwd }, commandline.showWindow };
 }
 
-bool WindowEmperor::HandleCommandlineArgs()
+bool WindowEmperor::HandleCommandlineArgs(const CommandlineChannel::Commandline& commandline)
 {
-    std::vector<winrt::hstring> args;
-    _buildArgsFromCommandline(args);
-    const auto cwd{ wil::GetCurrentDirectoryW<std::wstring>() };
+    const auto eventArgs = _makeCommandlineArgs(commandline);
 
     {
         // ALWAYS change the _real_ CWD of the Terminal to system32, so that we
@@ -97,15 +85,11 @@ bool WindowEmperor::HandleCommandlineArgs()
         }
     }
 
-    // Get the requested initial state of the window from our startup info. For
-    // something like `start /min`, this will set the wShowWindow member to
-    // SW_SHOWMINIMIZED. We'll need to make sure is bubbled all the way through,
-    // so we can open a new window with the same state.
-    STARTUPINFOW si;
-    GetStartupInfoW(&si);
-    const uint32_t showWindow = WI_IsFlagSet(si.dwFlags, STARTF_USESHOWWINDOW) ? si.wShowWindow : SW_SHOW;
-
-    Remoting::CommandlineArgs eventArgs{ { args }, { cwd }, showWindow };
+    // main() already forwarded our commandline if another Terminal was running,
+    // so we're most likely going to open a window with a tab in it. Spawning the
+    // pseudoconsole for it takes a while, but doesn't depend on the settings.
+    // Let it run in the background while we load them and build the window.
+    TerminalConnection::ConptyConnection::PrestartPseudoConsole();
 
     const auto isolatedMode{ _app.Logic().IsolatedMode() };
 
@@ -281,6 +265,8 @@ void WindowEmperor::_becomeMonarch()
 
     _createMessageWindow();
 
+    _listenForCommandlines();
+
     _setupGlobalHotkeys();
 
     // When the settings change, we'll want to update our global hotkeys and our
@@ -527,6 +513,45 @@ winrt::fire_and_forget WindowEmperor::_close()
 }
 
 #pragma endregion
+
+// Method Description:
+// - Starts accepting commandlines from new WindowsTerminal.exe processes over
+//   our CommandlineChannel. This lets them skip initializing COM and XAML,
+//   only to then hand their commandline to us over COM anyways.
+// - Anything that the new process would need to handle itself (like printing
+//   the `--help` text) is rejected, and the sender falls back to the regular
+//   path through the WindowManager.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void WindowEmperor::_listenForCommandlines()
+{
+    if (_app.Logic().IsolatedMode())
+    {
+        return;
+    }
+
+    _commandlineChannel.Listen(_dispatcher, [this](CommandlineChannel::Commandline&& commandline) {
+        // The settings may have changed since we started listening.
+        if (_app.Logic().IsolatedMode())
+        {
+            return false;
+        }
+
+        const auto eventArgs = _makeCommandlineArgs(commandline);
+        if (!_app.Logic().GetParseCommandlineMessage(eventArgs.Commandline()).Message.empty())
+        {
+            return false;
+        }
+
+        // We're the Monarch, so this will either create a new window via
+        // RequestNewWindow, or hand the commandline to an existing one.
+        const auto result = _manager.ProposeCommandline(eventArgs, false);
+        return !result.ShouldCreateWindow();
+    });
+}
+
 #pragma region GlobalHotkeys
 
 // Method Description:
@@ -19,6 +19,7 @@ Abstract:
 #include "pch.h"
 
 #include "WindowThread.h"
+#include "CommandlineChannel.h"
 
 class WindowEmperor : public std::enable_shared_from_this<WindowEmperor>
 {
@@ -27,7 +28,7 @@ public:
     ~WindowEmperor();
     void WaitForWindows();
 
-    bool HandleCommandlineArgs();
+    bool HandleCommandlineArgs(const CommandlineChannel::Commandline& commandline);
 
 private:
     void _createNewWindowThread(const winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs& args);
@@ -52,6 +53,8 @@ private:
 
     std::unique_ptr<NotificationIcon> _notificationIcon;
 
+    CommandlineChannel _commandlineChannel;
+
     bool _quitting{ false };
 
     void _windowStartedHandlerPostXAML(const std::shared_ptr<WindowThread>& sender);
@@ -70,6 +73,7 @@ private:
     winrt::fire_and_forget _saveWindowLayoutsRepeat();
 
     void _createMessageWindow();
+    void _listenForCommandlines();
 
     void _hotkeyPressed(const long hotkeyIndex);
     bool _registerHotKey(const int index, const winrt::Microsoft::Terminal::Control::KeyChord& hotkey) noexcept;
@@ -100,6 +100,14 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
     // should choose and install the correct one from the bundle.
     EnsureNativeArchitecture();
 
+    // If there's already a Terminal running, hand it our commandline before we
+    // spend any time on initializing COM, XAML and loading the settings.
+    const auto commandline = CommandlineChannel::Commandline::FromCurrentProcess();
+    if (CommandlineChannel::TryForward(commandline))
+    {
+        return 0;
+    }
+
     // Make sure to call this so we get WM_POINTER messages.
     EnableMouseInPointer(true);
 
@@ -115,7 +123,7 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
     winrt::init_apartment(winrt::apartment_type::single_threaded);
 
     const auto emperor = std::make_shared<::WindowEmperor>();
-    if (emperor->HandleCommandlineArgs())
+    if (emperor->HandleCommandlineArgs(commandline))
     {
         emperor->WaitForWindows();
     }
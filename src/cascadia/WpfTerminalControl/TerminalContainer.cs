@@ -6,6 +6,7 @@
 namespace Microsoft.Terminal.Wpf
 {
     using System;
+    using System.Collections.Generic;
     using System.Runtime.InteropServices;
     using System.Windows;
     using System.Windows.Automation.Peers;
@@ -176,6 +177,67 @@ namespace Microsoft.Terminal.Wpf
             return string.Empty;
         }
 
+        /// <summary>
+        /// Writes UTF-8 encoded output to the terminal, without converting it to a string first.
+        /// </summary>
+        /// <param name="data">The UTF-8 encoded output.</param>
+        internal void WriteOutputUtf8(ArraySegment<byte> data)
+        {
+            if (this.terminal == IntPtr.Zero || data.Count == 0)
+            {
+                return;
+            }
+
+            var handle = GCHandle.Alloc(data.Array, GCHandleType.Pinned);
+            try
+            {
+                NativeMethods.TerminalSendOutputUtf8(this.terminal, handle.AddrOfPinnedObject() + data.Offset, (UIntPtr)data.Count);
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Writes multiple chunks of UTF-8 encoded output to the terminal at once.
+        /// The terminal parses all of them in one go, which is much faster than writing them one by one.
+        /// </summary>
+        /// <param name="chunks">The chunks of UTF-8 encoded output.</param>
+        internal void WriteOutputUtf8(IReadOnlyList<ArraySegment<byte>> chunks)
+        {
+            if (this.terminal == IntPtr.Zero || chunks.Count == 0)
+            {
+                return;
+            }
+
+            var handles = new GCHandle[chunks.Count];
+            var data = new IntPtr[chunks.Count];
+            var lengths = new UIntPtr[chunks.Count];
+
+            try
+            {
+                for (var i = 0; i < chunks.Count; i++)
+                {
+                    handles[i] = GCHandle.Alloc(chunks[i].Array, GCHandleType.Pinned);
+                    data[i] = handles[i].AddrOfPinnedObject() + chunks[i].Offset;
+                    lengths[i] = (UIntPtr)chunks[i].Count;
+                }
+
+                NativeMethods.TerminalSendOutputUtf8Batch(this.terminal, data, lengths, (UIntPtr)chunks.Count);
+            }
+            finally
+            {
+                foreach (var handle in handles)
+                {
+                    if (handle.IsAllocated)
+                    {
+                        handle.Free();
+                    }
+                }
+            }
+        }
+
         /// <summary>
         /// Triggers a resize of the terminal with the given size, redrawing the rendered text.
         /// </summary>
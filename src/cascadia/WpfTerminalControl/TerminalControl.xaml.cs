@@ -6,6 +6,7 @@
 namespace Microsoft.Terminal.Wpf
 {
     using System;
+    using System.Collections.Generic;
     using System.Threading;
     using System.Windows;
     using System.Windows.Automation.Peers;
@@ -111,6 +112,25 @@ namespace Microsoft.Terminal.Wpf
             return this.termContainer.GetSelectedText();
         }
 
+        /// <summary>
+        /// Writes UTF-8 encoded output to the terminal, as if it came from the <see cref="Connection"/>.
+        /// This avoids converting high-rate output to a string first.
+        /// </summary>
+        /// <param name="data">The UTF-8 encoded output. Incomplete UTF-8 sequences at its end are continued by the next write.</param>
+        public void WriteOutputUtf8(ArraySegment<byte> data)
+        {
+            this.termContainer.WriteOutputUtf8(data);
+        }
+
+        /// <summary>
+        /// Writes multiple chunks of UTF-8 encoded output to the terminal, parsing all of them at once.
+        /// </summary>
+        /// <param name="chunks">The chunks of UTF-8 encoded output.</param>
+        public void WriteOutputUtf8(IReadOnlyList<ArraySegment<byte>> chunks)
+        {
+            this.termContainer.WriteOutputUtf8(chunks);
+        }
+
         /// <summary>
         /// Resizes the terminal to the specified rows and columns.
         /// </summary>
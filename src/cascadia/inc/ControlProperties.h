@@ -70,6 +70,11 @@
     X(winrt::Microsoft::Terminal::Control::TextAntialiasingMode, AntialiasingMode, winrt::Microsoft::Terminal::Control::TextAntialiasingMode::Grayscale) \
     X(bool, ForceFullRepaintRendering, false)                                                                                                            \
     X(bool, SoftwareRendering, false)                                                                                                                    \
+    X(bool, PreferLowPowerAdapter, false)                                                                                                                \
+    X(winrt::Microsoft::Terminal::Control::RenderPacingMode, PacingMode, winrt::Microsoft::Terminal::Control::RenderPacingMode::LowLatency)              \
+    X(bool, SmoothScrolling, false)                                                                                                                      \
+    X(int32_t, PixelShaderFrameRate, 0)                                                                                                                  \
+    X(int32_t, OutputGovernorThreshold, 8 * 1024 * 1024)                                                                                                 \
     X(bool, UseAtlasEngine, false)                                                                                                                       \
     X(bool, UseBackgroundImageForWindow, false)                                                                                                          \
     X(bool, ShowMarks, false)                                                                                                                            \
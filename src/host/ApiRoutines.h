@@ -252,6 +252,11 @@ public:
                                                  const Microsoft::Console::Types::Viewport& sourceRectangle,
                                                  Microsoft::Console::Types::Viewport& readRectangle) noexcept override;
 
+    [[nodiscard]] HRESULT GetConsoleOutputChangesImpl(const SCREEN_INFORMATION& context,
+                                                      const uint64_t sequence,
+                                                      std::vector<Microsoft::Console::Types::Viewport>& changedRectangles,
+                                                      uint64_t& currentSequence) noexcept override;
+
     [[nodiscard]] HRESULT GetConsoleTitleAImpl(std::span<char> title,
                                                size_t& written,
                                                size_t& needed) noexcept override;
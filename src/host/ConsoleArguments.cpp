@@ -24,6 +24,9 @@ const std::wstring_view ConsoleArguments::FEATURE_ARG = L"--feature";
 const std::wstring_view ConsoleArguments::FEATURE_PTY_ARG = L"pty";
 const std::wstring_view ConsoleArguments::COM_SERVER_ARG = L"-Embedding";
 const std::wstring_view ConsoleArguments::PASSTHROUGH_ARG = L"--passthrough";
+const std::wstring_view ConsoleArguments::OUTPUT_RING_ARG = L"--outputring";
+const std::wstring_view ConsoleArguments::OUTPUT_RING_DATA_ARG = L"--outputringdata";
+const std::wstring_view ConsoleArguments::OUTPUT_RING_SPACE_ARG = L"--outputringspace";
 // NOTE: Thinking about adding more commandline args that control conpty, for
 // the Terminal? Make sure you add them to the commandline in
 // ConsoleEstablishHandoff. We use that to initialize the ConsoleArguments for a
@@ -149,6 +152,9 @@ ConsoleArguments& ConsoleArguments::operator=(const ConsoleArguments& other)
         _inheritCursor = other._inheritCursor;
         _runAsComServer = other._runAsComServer;
         _forceNoHandoff = other._forceNoHandoff;
+        _outputRingSection = other._outputRingSection;
+        _outputRingData = other._outputRingData;
+        _outputRingSpace = other._outputRingSpace;
     }
 
     return *this;
@@ -447,6 +453,26 @@ void ConsoleArguments::s_ConsumeArg(_Inout_ std::vector<std::wstring>& args, _In
                 hr = s_ParseHandleArg(signalHandleVal, _signalHandle);
             }
         }
+        else if (arg == OUTPUT_RING_ARG || arg == OUTPUT_RING_DATA_ARG || arg == OUTPUT_RING_SPACE_ARG)
+        {
+            auto handle = &_outputRingSpace;
+            if (arg == OUTPUT_RING_ARG)
+            {
+                handle = &_outputRingSection;
+            }
+            else if (arg == OUTPUT_RING_DATA_ARG)
+            {
+                handle = &_outputRingData;
+            }
+
+            std::wstring handleVal;
+            hr = s_GetArgumentValue(args, i, &handleVal);
+
+            if (SUCCEEDED(hr))
+            {
+                hr = s_ParseHandleArg(handleVal, *handle);
+            }
+        }
         else if (arg == FORCE_V1_ARG)
         {
             // -ForceV1 command line switch for NTVDM support
@@ -617,6 +643,32 @@ HANDLE ConsoleArguments::GetSignalHandle() const
     return ULongToHandle(_signalHandle);
 }
 
+// Routine Description:
+// - Returns true if we were passed all three handles of a shared memory output ring.
+// Arguments:
+// - <none> - uses internal state
+// Return Value:
+// - True or false (see description)
+bool ConsoleArguments::HasOutputRing() const noexcept
+{
+    return IsValidHandle(GetOutputRingSection()) && IsValidHandle(GetOutputRingDataEvent()) && IsValidHandle(GetOutputRingSpaceEvent());
+}
+
+HANDLE ConsoleArguments::GetOutputRingSection() const noexcept
+{
+    return ULongToHandle(_outputRingSection);
+}
+
+HANDLE ConsoleArguments::GetOutputRingDataEvent() const noexcept
+{
+    return ULongToHandle(_outputRingData);
+}
+
+HANDLE ConsoleArguments::GetOutputRingSpaceEvent() const noexcept
+{
+    return ULongToHandle(_outputRingSpace);
+}
+
 HANDLE ConsoleArguments::GetVtInHandle() const
 {
     return _vtInHandle;
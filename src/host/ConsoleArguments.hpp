@@ -45,6 +45,11 @@ public:
     bool HasSignalHandle() const;
     HANDLE GetSignalHandle() const;
 
+    bool HasOutputRing() const noexcept;
+    HANDLE GetOutputRingSection() const noexcept;
+    HANDLE GetOutputRingDataEvent() const noexcept;
+    HANDLE GetOutputRingSpaceEvent() const noexcept;
+
     std::wstring GetOriginalCommandLine() const;
     std::wstring GetClientCommandline() const;
     std::wstring GetVtMode() const;
@@ -77,6 +82,9 @@ public:
     static const std::wstring_view FEATURE_PTY_ARG;
     static const std::wstring_view COM_SERVER_ARG;
     static const std::wstring_view PASSTHROUGH_ARG;
+    static const std::wstring_view OUTPUT_RING_ARG;
+    static const std::wstring_view OUTPUT_RING_DATA_ARG;
+    static const std::wstring_view OUTPUT_RING_SPACE_ARG;
 
 private:
 #ifdef UNIT_TESTING
@@ -142,6 +150,10 @@ private:
     DWORD _signalHandle;
     bool _inheritCursor;
     bool _resizeQuirk{ false };
+    // The handles of a til::shared_ring, which replaces _vtOutHandle for VT output if given.
+    DWORD _outputRingSection{ 0 };
+    DWORD _outputRingData{ 0 };
+    DWORD _outputRingSpace{ 0 };
 
     [[nodiscard]] HRESULT _GetClientCommandline(_Inout_ std::vector<std::wstring>& args,
                                                 const size_t index,
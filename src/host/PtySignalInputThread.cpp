@@ -22,9 +22,15 @@ PtySignalInputThread::PtySignalInputThread(wil::unique_hfile hPipe) :
     _hThread{},
     _api{ ServiceLocator::LocateGlobals().getConsoleInformation() },
     _dwThreadId{ 0 },
-    _consoleConnected{ false }
+    _consoleConnected{ false },
+    _signalTx{ nullptr },
+    _signalRx{ nullptr }
 {
     THROW_HR_IF(E_HANDLE, _hFile.get() == INVALID_HANDLE_VALUE);
+
+    auto [tx, rx] = til::mpsc::channel<Signal>(16);
+    _signalTx = std::move(tx);
+    _signalRx = std::move(rx);
 }
 
 PtySignalInputThread::~PtySignalInputThread()
@@ -121,12 +127,12 @@ try
                 return S_OK;
             }
 
-            _DoShowHide(msg);
+            _QueueSignal(msg);
             break;
         }
         case PtySignal::ClearBuffer:
         {
-            _DoClearBuffer();
+            _QueueSignal(ClearBufferData{});
             break;
         }
         case PtySignal::ResizeWindow:
@@ -137,7 +143,7 @@ try
                 return S_OK;
             }
 
-            _DoResizeWindow(resizeMsg);
+            _QueueSignal(resizeMsg);
             break;
         }
         case PtySignal::SetParent:
@@ -148,6 +154,9 @@ try
                 return S_OK;
             }
 
+            // Reparenting must not happen while holding the console lock (see _DoSetWindowParent),
+            // which is why it's not queued like the other signals. All prior signals have
+            // already been executed by _QueueSignal(), so the order is still preserved.
             _DoSetWindowParent(reparentMessage);
             break;
         }
@@ -158,6 +167,88 @@ try
 }
 CATCH_LOG_RETURN_HR(S_OK)
 
+// Method Description:
+// - Hands a signal over to the console. It's executed by ProcessPendingSignals(), either by
+//   the thread that's currently holding the console lock as soon as it releases it, or by us.
+// Arguments:
+// - signal - The signal to execute
+// Return Value:
+// - <none>
+void PtySignalInputThread::_QueueSignal(Signal signal)
+{
+    _signalTx.emplace(std::move(signal));
+
+    // If another thread holds the console lock right now, it'll execute the signal as soon
+    // as it unlocks the console (see ::UnlockConsole). We still need to acquire the lock
+    // ourselves in case it gets released through gci.UnlockConsole().
+    LockConsole();
+    const auto unlock = wil::scope_exit([&] { UnlockConsole(); });
+
+    // Dragging the terminal's window border produces a burst of resizes. Each of them
+    // reflows the buffer and repaints the entire viewport, for sizes that are stale
+    // by the time we're done. So, once we hold the lock, queue up all resizes that are
+    // already waiting in the pipe. ProcessPendingSignals() will skip to the latest one.
+    ResizeWindowData resizeMsg{};
+    while (_TryGetPendingResize(resizeMsg))
+    {
+        // We're the consumer as long as we hold the lock, so if the queue is full, we must make room ourselves.
+        if (!_signalTx.try_emplace(resizeMsg))
+        {
+            ProcessPendingSignals();
+            _signalTx.emplace(resizeMsg);
+        }
+    }
+
+    ProcessPendingSignals();
+}
+
+// Method Description:
+// - Executes all signals that have been received so far, but not executed yet.
+//   Of consecutive resizes only the last one is executed, because the others are stale.
+// - The caller must hold the console lock.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void PtySignalInputThread::ProcessPendingSignals()
+{
+    std::array<Signal, 16> signals;
+
+    for (;;)
+    {
+        const auto count = _signalRx.try_pop_n(signals.begin(), signals.size()).first;
+        if (count == 0)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& signal = til::at(signals, i);
+
+            try
+            {
+                if (const auto resize = std::get_if<ResizeWindowData>(&signal))
+                {
+                    if (i + 1 == count || !std::holds_alternative<ResizeWindowData>(til::at(signals, i + 1)))
+                    {
+                        _DoResizeWindow(*resize);
+                    }
+                }
+                else if (const auto showHide = std::get_if<ShowHideData>(&signal))
+                {
+                    _DoShowHide(*showHide);
+                }
+                else
+                {
+                    _DoClearBuffer();
+                }
+            }
+            CATCH_LOG();
+        }
+    }
+}
+
 // Method Description:
 // - Dispatches a resize window message to the rest of the console code
 // Arguments:
@@ -315,6 +406,46 @@ void PtySignalInputThread::_DoSetWindowParent(const SetParentData& data)
     return true;
 }
 
+// Method Description:
+// - Consumes the next signal in the pipe, if it's a resize that has been fully received already.
+//   This doesn't block and doesn't touch any other kind of signal, which preserves their order.
+// Arguments:
+// - data - Receives the size of the resize, if there was one.
+// Return Value:
+// - True if a resize was consumed. False otherwise.
+[[nodiscard]] bool PtySignalInputThread::_TryGetPendingResize(ResizeWindowData& data)
+{
+    if (!_hFile)
+    {
+        return false;
+    }
+
+    struct
+    {
+        PtySignal signalId;
+        ResizeWindowData data;
+    } message{};
+    static_assert(sizeof(message) == sizeof(PtySignal) + sizeof(ResizeWindowData));
+
+    // PeekNamedPipe fails for anything that isn't a pipe, in which case we simply don't coalesce.
+    DWORD dwRead = 0;
+    if (!PeekNamedPipe(_hFile.get(), &message, sizeof(message), &dwRead, nullptr, nullptr) ||
+        dwRead != sizeof(message) ||
+        message.signalId != PtySignal::ResizeWindow)
+    {
+        return false;
+    }
+
+    // The message is fully buffered already, so this won't block.
+    if (!_GetData(&message, sizeof(message)))
+    {
+        return false;
+    }
+
+    data = message.data;
+    return true;
+}
+
 // Method Description:
 // - Starts the PTY Signal input thread.
 [[nodiscard]] HRESULT PtySignalInputThread::Start() noexcept
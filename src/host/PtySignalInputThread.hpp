@@ -15,6 +15,8 @@ Author(s):
 --*/
 #pragma once
 
+#include <til/mpsc.h>
+
 #include "outputStream.hpp"
 
 namespace Microsoft::Console
@@ -34,6 +36,7 @@ namespace Microsoft::Console
 
         void ConnectConsole() noexcept;
         void CreatePseudoWindow();
+        void ProcessPendingSignals();
 
     private:
         enum class PtySignal : unsigned short
@@ -60,8 +63,17 @@ namespace Microsoft::Console
             uint64_t handle;
         };
 
+        struct ClearBufferData
+        {
+        };
+
+        // The signals that are executed under the console lock by ProcessPendingSignals().
+        using Signal = std::variant<ShowHideData, ClearBufferData, ResizeWindowData>;
+
         [[nodiscard]] HRESULT _InputThread() noexcept;
         [[nodiscard]] bool _GetData(_Out_writes_bytes_(cbBuffer) void* const pBuffer, const DWORD cbBuffer);
+        [[nodiscard]] bool _TryGetPendingResize(ResizeWindowData& data);
+        void _QueueSignal(Signal signal);
         void _DoResizeWindow(const ResizeWindowData& data);
         void _DoSetWindowParent(const SetParentData& data);
         void _DoClearBuffer() const;
@@ -75,6 +87,8 @@ namespace Microsoft::Console
         std::optional<ResizeWindowData> _earlyResize;
         std::optional<ShowHideData> _initialShowHide;
         ConhostInternalGetSet _api;
+        til::mpsc::producer<Signal> _signalTx;
+        til::mpsc::consumer<Signal> _signalRx;
 
     public:
         std::optional<SetParentData> _earlyReparent;
@@ -9,18 +9,20 @@
 using namespace Microsoft::Console::Interactivity;
 
 // When someone attempts to use the console APIs to do a "read back"
-// of the console buffer, we have to give them **something**.
-// These two structures are just some gaudy-colored replacement character
-// text to give them data but represent they've done something that cannot
-// be supported under VT passthrough mode.
+// of the console buffer, we answer them from the host buffer, which we keep as a
+// lazily updated shadow of what we've passed through to the terminal: Everything
+// the VtEngine writes is queued up and only parsed into the host buffer once an API
+// like ReadConsoleOutput actually needs it (see _UpdateShadowBuffer).
 // ----
-// They can't be supported because in passthrough we maintain no internal
-// buffer to answer these questions, and there is no VT sequence that lets
-// us query the final terminal's buffer state. Even if a VT sequence did exist
-// (and we personally believe it shouldn't), there's a possibility that it would
-// read a massive amount of data and cause severe perf issues as applications coded
-// to this old API are likely leaning on it heavily and asking for this data in a
-// loop via VT would be a nightmare of parsing and formatting and over-the-wire transmission.
+// APIs which write into the buffer directly (like FillConsoleOutputCharacter)
+// can't be translated to VT faithfully however. These two structures are just some
+// gaudy-colored replacement character text, which we send to the terminal instead,
+// to represent that they've done something that cannot be supported under VT
+// passthrough mode.
+
+// If a client never calls any read back API, we'd queue up its output forever.
+// Once this much is pending, we bring the shadow buffer up to date regardless.
+static constexpr size_t s_maxPendingPassthroughOutput = 1024 * 1024;
 
 static constexpr CHAR_INFO s_readBackUnicode{
     { UNICODE_REPLACEMENT },
@@ -105,6 +107,37 @@ void VtApiRoutines::_SynchronizeCursor(std::unique_ptr<IWaitRoutine>& waiter) no
     }
 }
 
+// Brings the host buffer up to date with everything we've passed through to the terminal so far,
+// by parsing it with the regular output state machine. This way we only pay for maintaining
+// the host buffer if a client actually reads it back, instead of for every single write.
+// If onlyIfOverdue is true, this only happens once s_maxPendingPassthroughOutput is exceeded.
+void VtApiRoutines::_UpdateShadowBuffer(const bool onlyIfOverdue) noexcept
+try
+{
+    if (onlyIfOverdue && m_pVtEngine->GetPassthroughOutputSize() < s_maxPendingPassthroughOutput)
+    {
+        return;
+    }
+
+    m_pVtEngine->TakePassthroughOutput(m_passthroughOutput);
+    if (m_passthroughOutput.empty())
+    {
+        return;
+    }
+
+    // The output might end in the middle of a UTF-8 sequence, which m_passthroughState carries over.
+    THROW_IF_FAILED(til::u8u16(m_passthroughOutput, m_passthroughText, m_passthroughState));
+
+    m_pVtEngine->BeginShadowBufferUpdate();
+    const auto cleanup = wil::scope_exit([&]() noexcept {
+        m_pVtEngine->EndShadowBufferUpdate();
+    });
+
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.GetActiveOutputBuffer().GetStateMachine().ProcessString(m_passthroughText);
+}
+CATCH_LOG()
+
 [[nodiscard]] HRESULT VtApiRoutines::PeekConsoleInputAImpl(IConsoleInputObject& context,
                                                            std::deque<std::unique_ptr<IInputEvent>>& outEvents,
                                                            const size_t eventsToRead,
@@ -214,6 +247,7 @@ void VtApiRoutines::_SynchronizeCursor(std::unique_ptr<IWaitRoutine>& waiter) no
 
     (void)m_pVtEngine->_Flush();
     read = buffer.size();
+    _UpdateShadowBuffer(true);
     return S_OK;
 }
 
@@ -226,6 +260,7 @@ void VtApiRoutines::_SynchronizeCursor(std::unique_ptr<IWaitRoutine>& waiter) no
     (void)m_pVtEngine->WriteTerminalW(buffer);
     (void)m_pVtEngine->_Flush();
     read = buffer.size();
+    _UpdateShadowBuffer(true);
     return S_OK;
 }
 
@@ -343,6 +378,8 @@ void VtApiRoutines::GetConsoleScreenBufferInfoExImpl(const SCREEN_INFORMATION& c
                                                      CONSOLE_SCREEN_BUFFER_INFOEX& data) noexcept
 {
     // TODO GH10001: this is technically full of potentially incorrect data. do we care? should we store it in here with set?
+    // The cursor position at least is accurate, once the shadow buffer is up to date.
+    _UpdateShadowBuffer();
     return m_pUsualRoutines->GetConsoleScreenBufferInfoExImpl(context, data);
 }
 
@@ -436,9 +473,8 @@ void VtApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& co
                                                                     std::span<WORD> buffer,
                                                                     size_t& written) noexcept
 {
-    std::fill_n(buffer.data(), buffer.size(), s_readBackUnicode.Attributes); // should be same as the ascii one.
-    written = buffer.size();
-    return S_OK;
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->ReadConsoleOutputAttributeImpl(context, origin, buffer, written);
 }
 
 [[nodiscard]] HRESULT VtApiRoutines::ReadConsoleOutputCharacterAImpl(const SCREEN_INFORMATION& context,
@@ -446,9 +482,8 @@ void VtApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& co
                                                                      std::span<char> buffer,
                                                                      size_t& written) noexcept
 {
-    std::fill_n(buffer.data(), buffer.size(), s_readBackAscii.Char.AsciiChar);
-    written = buffer.size();
-    return S_OK;
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->ReadConsoleOutputCharacterAImpl(context, origin, buffer, written);
 }
 
 [[nodiscard]] HRESULT VtApiRoutines::ReadConsoleOutputCharacterWImpl(const SCREEN_INFORMATION& context,
@@ -456,9 +491,8 @@ void VtApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& co
                                                                      std::span<wchar_t> buffer,
                                                                      size_t& written) noexcept
 {
-    std::fill_n(buffer.data(), buffer.size(), s_readBackUnicode.Char.UnicodeChar);
-    written = buffer.size();
-    return S_OK;
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->ReadConsoleOutputCharacterWImpl(context, origin, buffer, written);
 }
 
 [[nodiscard]] HRESULT VtApiRoutines::WriteConsoleInputAImpl(InputBuffer& context,
@@ -581,9 +615,8 @@ extern HRESULT _ConvertCellsToWInplace(const UINT codepage,
                                                             const Microsoft::Console::Types::Viewport& sourceRectangle,
                                                             Microsoft::Console::Types::Viewport& readRectangle) noexcept
 {
-    std::fill_n(buffer.data(), buffer.size(), s_readBackAscii);
-    // TODO GH10001: do we need to constrict readRectangle to within the known buffer size... probably.
-    return S_OK;
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->ReadConsoleOutputAImpl(context, buffer, sourceRectangle, readRectangle);
 }
 
 [[nodiscard]] HRESULT VtApiRoutines::ReadConsoleOutputWImpl(const SCREEN_INFORMATION& context,
@@ -591,9 +624,17 @@ extern HRESULT _ConvertCellsToWInplace(const UINT codepage,
                                                             const Microsoft::Console::Types::Viewport& sourceRectangle,
                                                             Microsoft::Console::Types::Viewport& readRectangle) noexcept
 {
-    std::fill_n(buffer.data(), buffer.size(), s_readBackUnicode);
-    // TODO GH10001: do we need to constrict readRectangle to within the known buffer size... probably.
-    return S_OK;
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->ReadConsoleOutputWImpl(context, buffer, sourceRectangle, readRectangle);
+}
+
+[[nodiscard]] HRESULT VtApiRoutines::GetConsoleOutputChangesImpl(const SCREEN_INFORMATION& context,
+                                                                 const uint64_t sequence,
+                                                                 std::vector<Microsoft::Console::Types::Viewport>& changedRectangles,
+                                                                 uint64_t& currentSequence) noexcept
+{
+    _UpdateShadowBuffer();
+    return m_pUsualRoutines->GetConsoleOutputChangesImpl(context, sequence, changedRectangles, currentSequence);
 }
 
 [[nodiscard]] HRESULT VtApiRoutines::GetConsoleTitleAImpl(std::span<char> title,
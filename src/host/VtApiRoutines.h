@@ -255,6 +255,11 @@ public:
                                                  const Microsoft::Console::Types::Viewport& sourceRectangle,
                                                  Microsoft::Console::Types::Viewport& readRectangle) noexcept override;
 
+    [[nodiscard]] HRESULT GetConsoleOutputChangesImpl(const SCREEN_INFORMATION& context,
+                                                      const uint64_t sequence,
+                                                      std::vector<Microsoft::Console::Types::Viewport>& changedRectangles,
+                                                      uint64_t& currentSequence) noexcept override;
+
     [[nodiscard]] HRESULT GetConsoleTitleAImpl(std::span<char> title,
                                                size_t& written,
                                                size_t& needed) noexcept override;
@@ -389,4 +394,9 @@ public:
 
 private:
     void _SynchronizeCursor(std::unique_ptr<IWaitRoutine>& waiter) noexcept;
+    void _UpdateShadowBuffer(bool onlyIfOverdue = false) noexcept;
+
+    std::string m_passthroughOutput;
+    std::wstring m_passthroughText;
+    til::u8state m_passthroughState;
 };
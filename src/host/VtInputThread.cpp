@@ -30,11 +30,19 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
     _u8State{},
     _dwThreadId{ 0 },
     _exitRequested{ false },
-    _pfnSetLookingForDSR{}
+    _pfnSetLookingForDSR{},
+    _pDispatch{ nullptr },
+    _inputTx{ nullptr },
+    _inputRx{ nullptr }
 {
     THROW_HR_IF(E_HANDLE, _hFile.get() == INVALID_HANDLE_VALUE);
 
+    auto [tx, rx] = til::spsc::channel<std::wstring>(16);
+    _inputTx = std::move(tx);
+    _inputRx = std::move(rx);
+
     auto dispatch = std::make_unique<InteractDispatch>();
+    _pDispatch = dispatch.get();
 
     auto engine = std::make_unique<InputStateMachineEngine>(std::move(dispatch), inheritCursor);
 
@@ -54,12 +62,35 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 // - Processes a string of input characters. The characters should be UTF-8
 //      encoded, and will get converted to wstring to be processed by the
 //      input state machine.
+// - The conversion happens without holding the console lock. The result is
+//      queued up and parsed by ProcessPendingInput() under the lock.
 // Arguments:
 // - u8Str - the UTF-8 string received.
 // Return Value:
 // - S_OK on success, otherwise an appropriate failure.
 [[nodiscard]] HRESULT VtInputThread::_HandleRunInput(const std::string_view u8Str)
 {
+    try
+    {
+        std::wstring wstr;
+        auto hr = til::u8u16(u8Str, wstr, _u8State);
+        // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
+        if (FAILED(hr))
+        {
+            return S_FALSE;
+        }
+        if (wstr.empty())
+        {
+            return S_OK;
+        }
+        _inputTx.emplace(std::move(wstr));
+    }
+    CATCH_RETURN();
+
+    // If another thread holds the console lock right now, it'll process our input
+    // as soon as it unlocks the console (see ::UnlockConsole). We still need to
+    // acquire the lock ourselves in case it gets released through gci.UnlockConsole().
+    //
     // Make sure to call the GLOBAL Lock/Unlock, not the gci's lock/unlock.
     // Only the global unlock attempts to dispatch ctrl events. If you use the
     //      gci's unlock, when you press C-c, it won't be dispatched until the
@@ -70,20 +101,33 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 
     try
     {
-        std::wstring wstr{};
-        auto hr = til::u8u16(u8Str, wstr, _u8State);
-        // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
-        if (FAILED(hr))
-        {
-            return S_FALSE;
-        }
-        _pInputStateMachine->ProcessString(wstr);
+        // We might be called recursively during startup (see VtIo::StartIfNeeded)
+        // in which case ::UnlockConsole won't release the lock and process our input.
+        ProcessPendingInput();
     }
     CATCH_RETURN();
 
     return S_OK;
 }
 
+// Method Description:
+// - Parses all input that has been received so far and is still pending.
+// - The caller must hold the console lock.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtInputThread::ProcessPendingInput()
+{
+    while (const auto chunk = _inputRx.try_pop())
+    {
+        _pInputStateMachine->ProcessString(*chunk);
+    }
+
+    // Plain keys are batched up by the dispatcher while parsing.
+    _pDispatch->FlushPendingKeys();
+}
+
 // Function Description:
 // - Static function used for initializing an instance's ThreadProc.
 // Arguments:
@@ -107,7 +151,9 @@ DWORD WINAPI VtInputThread::StaticVtInputThreadProc(_In_ LPVOID lpParameter)
 // - <none>
 void VtInputThread::DoReadInput(const bool throwOnFail)
 {
-    char buffer[256];
+    // A large paste arrives as a single write on the pipe. Reading it in large
+    // chunks means far fewer round trips through the console lock and parser.
+    char buffer[4096];
     DWORD dwRead = 0;
     auto fSuccess = !!ReadFile(_hFile.get(), buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
 
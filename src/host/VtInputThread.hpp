@@ -16,6 +16,13 @@ Author(s):
 
 #include "../terminal/parser/StateMachine.hpp"
 
+#include <til/spsc.h>
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class InteractDispatch;
+}
+
 namespace Microsoft::Console
 {
     class VtInputThread
@@ -27,6 +34,7 @@ namespace Microsoft::Console
         static DWORD WINAPI StaticVtInputThreadProc(_In_ LPVOID lpParameter);
         void DoReadInput(const bool throwOnFail);
         void SetLookingForDSR(const bool looking) noexcept;
+        void ProcessPendingInput();
 
     private:
         [[nodiscard]] HRESULT _HandleRunInput(const std::string_view u8Str);
@@ -40,7 +48,15 @@ namespace Microsoft::Console
 
         std::function<void(bool)> _pfnSetLookingForDSR;
 
+        // Owned by _pInputStateMachine.
+        Microsoft::Console::VirtualTerminal::InteractDispatch* _pDispatch;
+
         std::unique_ptr<Microsoft::Console::VirtualTerminal::StateMachine> _pInputStateMachine;
         til::u8state _u8State;
+
+        // Input is converted to UTF-16 outside of the console lock and handed off
+        // through this queue. It's drained by whoever holds the console lock.
+        til::spsc::producer<std::wstring> _inputTx;
+        til::spsc::consumer<std::wstring> _inputRx;
     };
 }
@@ -76,6 +76,22 @@ VtIo::VtIo() :
     // If we were already given VT handles, set up the VT IO engine to use those.
     if (pArgs->InConptyMode())
     {
+        // The terminal asked for our output in a shared memory ring. If that fails, it's a
+        // bug or an incompatible terminal and there's no point in silently falling back to
+        // the pipe: The terminal waits for output on the ring, not the pipe.
+        if (pArgs->HasOutputRing())
+        {
+            try
+            {
+                til::shared_ring::handles handles;
+                handles.section.reset(pArgs->GetOutputRingSection());
+                handles.data.reset(pArgs->GetOutputRingDataEvent());
+                handles.space.reset(pArgs->GetOutputRingSpaceEvent());
+                _outputRing = std::make_unique<til::shared_ring::producer>(std::move(handles));
+            }
+            CATCH_RETURN();
+        }
+
         return _Initialize(pArgs->GetVtInHandle(), pArgs->GetVtOutHandle(), pArgs->GetVtMode(), pArgs->GetSignalHandle());
     }
     // Didn't need to initialize if we didn't have VT stuff. It's still OK, but report we did nothing.
@@ -217,6 +233,10 @@ VtIo::VtIo() :
             {
                 _pVtRenderEngine->SetTerminalOwner(this);
                 _pVtRenderEngine->SetResizeQuirk(_resizeQuirk);
+                if (_outputRing)
+                {
+                    _pVtRenderEngine->SetOutputRing(std::move(_outputRing));
+                }
             }
         }
     }
@@ -439,10 +459,33 @@ void VtIo::SetWindowVisibility(bool showOrHide) noexcept
 
 void VtIo::CloseInput()
 {
-    _pVtInputThread = nullptr;
+    {
+        // ::UnlockConsole may call ProcessPendingInput() at any time.
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        gci.LockConsole();
+        auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+        _pVtInputThread = nullptr;
+    }
     SendCloseEvent();
 }
 
+// Method Description:
+// - Parses any input the VT input thread has received and executes any signals
+//   the signal thread has received, but weren't able to process yet, because
+//   another thread was holding the console lock.
+// - The caller must hold the console lock.
+void VtIo::ProcessPendingInput()
+{
+    if (_pPtySignalInputThread)
+    {
+        _pPtySignalInputThread->ProcessPendingSignals();
+    }
+    if (_pVtInputThread)
+    {
+        _pVtInputThread->ProcessPendingInput();
+    }
+}
+
 void VtIo::CloseOutput()
 {
     auto& g = ServiceLocator::LocateGlobals();
@@ -529,6 +572,20 @@ bool VtIo::IsResizeQuirkEnabled() const
     return _resizeQuirk;
 }
 
+// Method Description:
+// - Returns true while the host buffer is being brought up to date with output
+//   that was already passed through to the terminal (see VtApiRoutines). Any
+//   queries contained in that output have already been answered by the
+//   terminal and must not be answered a second time by us.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff we're in passthrough mode and replaying output into the host buffer.
+bool VtIo::IsUpdatingShadowBuffer() const noexcept
+{
+    return _passthroughMode && _pVtRenderEngine && _pVtRenderEngine->IsUpdatingShadowBuffer();
+}
+
 // Method Description:
 // - Manually tell the renderer that it should emit a "Erase Scrollback"
 //   sequence to the connected terminal. We need to do this in certain cases
@@ -38,6 +38,7 @@ namespace Microsoft::Console::VirtualTerminal
         void SendCloseEvent();
 
         void CloseInput();
+        void ProcessPendingInput();
         void CloseOutput();
 
         void BeginResize();
@@ -48,6 +49,7 @@ namespace Microsoft::Console::VirtualTerminal
 #endif
 
         bool IsResizeQuirkEnabled() const;
+        bool IsUpdatingShadowBuffer() const noexcept;
 
         [[nodiscard]] HRESULT ManuallyClearScrollback() const noexcept;
 
@@ -60,6 +62,8 @@ namespace Microsoft::Console::VirtualTerminal
         wil::unique_hfile _hOutput;
         // After CreateAndStartSignalThread is called, this will be invalid.
         wil::unique_hfile _hSignal;
+        // After CreateIoHandlers is called, this will be handed to the VtEngine.
+        std::unique_ptr<til::shared_ring::producer> _outputRing;
         VtIoMode _IoMode;
 
         bool _initialized;
@@ -170,8 +170,56 @@ void AdjustCursorPosition(SCREEN_INFORMATION& screenInfo, _In_ til::point coordC
             }
         }
 
-        // As an optimization, collect characters in buffer and print out all at once.
+        // Fast path: Most output of legacy applications consists of plain printable ASCII up to the next
+        // CR/LF. If the entire run up to the next other character fits into the remainder of the current
+        // line, no control character, DBCS or wrapping logic is needed and we can write it as a whole.
         XPosition = cursor.GetPosition().x;
+        {
+            const auto remaining = (BufferSize - *pcb) / sizeof(WCHAR);
+            size_t runLength = 0;
+            while (runLength < remaining && lpString[runLength] >= L' ' && lpString[runLength] < 0x7F)
+            {
+                runLength++;
+            }
+
+            if (runLength != 0 && runLength < gsl::narrow_cast<size_t>(coordScreenBufferSize.width - XPosition))
+            {
+                CursorPosition = cursor.GetPosition();
+
+                RowWriteState state{
+                    .text = { lpString, runLength },
+                    .columnBegin = CursorPosition.x,
+                    .columnLimit = coordScreenBufferSize.width,
+                };
+                textBuffer.WriteLine(CursorPosition.y, fWrapAtEOL, Attributes, state);
+
+                if (screenInfo.HasAccessibilityEventing() && state.columnBeginDirty != state.columnEndDirty)
+                {
+                    screenInfo.NotifyAccessibilityEventing(state.columnBeginDirty, CursorPosition.y, state.columnEndDirty - 1, CursorPosition.y);
+                }
+
+                TempNumSpaces += runLength;
+                lpString += runLength;
+                pwchRealUnicode += runLength;
+                pwchBuffer += runLength;
+                *pcb += runLength * sizeof(WCHAR);
+
+                CursorPosition.x = state.columnEnd;
+                AdjustCursorPosition(screenInfo, CursorPosition, WI_IsFlagSet(dwFlags, WC_KEEP_CURSOR_VISIBLE), psScrollY);
+
+                if (*pcb == BufferSize)
+                {
+                    if (nullptr != pcSpaces)
+                    {
+                        *pcSpaces = TempNumSpaces;
+                    }
+                    return STATUS_SUCCESS;
+                }
+                continue;
+            }
+        }
+
+        // As an optimization, collect characters in buffer and print out all at once.
         til::CoordType i = 0;
         auto LocalBufPtr = LocalBuffer;
         while (*pcb < BufferSize && i < LOCAL_BUFFER_SIZE && XPosition < coordScreenBufferSize.width)
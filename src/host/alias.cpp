@@ -49,6 +49,8 @@ std::unordered_map<std::wstring,
                    case_insensitive_equality>
     g_aliasData;
 
+std::unordered_map<std::wstring, Alias::CompiledTarget> Alias::s_compiledTargets;
+
 // Routine Description:
 // - Adds a command line alias to the global set.
 // - Converts and calls the W version of this function.
@@ -102,6 +104,8 @@ std::unordered_map<std::wstring,
         std::transform(exeNameString.begin(), exeNameString.end(), exeNameString.begin(), towlower);
         std::transform(sourceString.begin(), sourceString.end(), sourceString.begin(), towlower);
 
+        Alias::s_InvalidateCompiledTargets();
+
         if (targetString.size() == 0)
         {
             // Only try to dig in and erase if the exeName exists.
@@ -156,10 +160,10 @@ std::unordered_map<std::wstring,
     // We use .find for the iterators then dereference to search without creating entries.
     const auto exeIter = g_aliasData.find(exeNameString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), exeIter == g_aliasData.end());
-    const auto exeData = exeIter->second;
+    const auto& exeData = exeIter->second;
     const auto sourceIter = exeData.find(sourceString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), sourceIter == exeData.end());
-    const auto targetString = sourceIter->second;
+    const auto& targetString = sourceIter->second;
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), targetString.size() == 0);
 
     // TargetLength is a byte count, convert to characters.
@@ -333,7 +337,7 @@ static std::wstring aliasesSeparator(L"=");
         auto exeIter = g_aliasData.find(exeNameString);
         if (exeIter != g_aliasData.end())
         {
-            auto list = exeIter->second;
+            const auto& list = exeIter->second;
             for (auto& pair : list)
             {
                 // Alias stores lengths in bytes.
@@ -423,6 +427,15 @@ void Alias::s_ClearCmdExeAliases()
     {
         exeIter->second.clear();
     }
+
+    s_InvalidateCompiledTargets();
+}
+
+// Routine Description:
+// - Drops all targets compiled by s_MatchAndCopyAlias. Must be called whenever the alias data changes.
+void Alias::s_InvalidateCompiledTargets() noexcept
+{
+    s_compiledTargets.clear();
 }
 
 // Routine Description:
@@ -464,7 +477,7 @@ void Alias::s_ClearCmdExeAliases()
     auto exeIter = g_aliasData.find(exeNameString);
     if (exeIter != g_aliasData.end())
     {
-        auto list = exeIter->second;
+        const auto& list = exeIter->second;
         for (auto& pair : list)
         {
             // Alias stores lengths in bytes.
@@ -1144,24 +1157,29 @@ std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
         return std::wstring();
     }
 
-    auto exeList = exeIter->second;
+    const auto& exeList = exeIter->second;
     if (exeList.size() == 0)
     {
         // If there's no match, give back an empty string.
         return std::wstring();
     }
 
-    // Tokenize the text by spaces
-    const auto tokens = s_Tokenize(sourceCopy);
-
-    // If there are no tokens, return an empty string
-    if (tokens.size() == 0)
+    // Tokenize the text by spaces, the same way s_Tokenize does, but without copying them.
+    // Only the alias and the arguments $1-$9 are ever needed.
+    til::small_vector<std::wstring_view, 10> tokens;
     {
-        return std::wstring();
+        const std::wstring_view source{ sourceCopy };
+        size_t prevIndex = 0;
+        for (auto spaceIndex = source.find(L' '); spaceIndex != std::wstring_view::npos && tokens.size() < 9; spaceIndex = source.find(L' ', prevIndex))
+        {
+            tokens.emplace_back(source.substr(prevIndex, spaceIndex - prevIndex));
+            prevIndex = spaceIndex + 1;
+        }
+        tokens.emplace_back(source.substr(prevIndex, source.find(L' ', prevIndex) - prevIndex));
     }
 
     // Find alias. If there isn't one, return an empty string
-    const auto alias = tokens.front();
+    const std::wstring alias{ tokens.front() };
     const auto aliasIter = exeList.find(alias);
     if (aliasIter == exeList.end())
     {
@@ -1169,19 +1187,158 @@ std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
         return std::wstring();
     }
 
-    const auto target = aliasIter->second;
+    const auto& target = aliasIter->second;
     if (target.size() == 0)
     {
         return std::wstring();
     }
 
+    // Look up the target with its macros already parsed, or parse it now.
+    auto key = exeIter->first;
+    key.push_back(UNICODE_NULL);
+    key.append(aliasIter->first);
+
+    auto compiledIter = s_compiledTargets.find(key);
+    if (compiledIter == s_compiledTargets.end())
+    {
+        compiledIter = s_compiledTargets.emplace(std::move(key), s_CompileTarget(target)).first;
+    }
+
     // Get the string of all parameters as a shorthand for $* later.
     const auto allParams = s_GetArgString(sourceCopy);
 
     // The final text will be the target but with macros replaced.
-    auto finalText = target;
-    lineCount = s_ReplaceMacros(finalText, tokens, allParams);
+    return s_ExpandCompiledTarget(compiledIter->second, std::span{ tokens.data(), tokens.size() }, allParams, lineCount);
+}
+
+// Routine Description:
+// - Parses the macros in the target of an alias, the same way s_ReplaceMacros does.
+// Arguments:
+// - target - The target of an alias
+// Return Value:
+// - The compiled target to be passed to s_ExpandCompiledTarget
+Alias::CompiledTarget Alias::s_CompileTarget(const std::wstring_view target)
+{
+    CompiledTarget compiled;
+    compiled.text.reserve(target.size());
+
+    size_t textBegin = 0;
+    const auto flushText = [&]() {
+        if (compiled.text.size() > textBegin)
+        {
+            compiled.segments.push_back({ CompiledTarget::SegmentType::Text, textBegin, compiled.text.size() - textBegin });
+        }
+        textBegin = compiled.text.size();
+    };
+    const auto pushSegment = [&](const CompiledTarget::SegmentType type, const size_t argument) {
+        flushText();
+        compiled.segments.push_back({ type, argument, 0 });
+    };
+
+    for (size_t i = 0; i < target.size(); i++)
+    {
+        const auto ch = til::at(target, i);
+
+        // If it didn't match the macro specifier $ or there's no read-ahead, push the character.
+        if (L'$' != ch || i + 1 >= target.size())
+        {
+            compiled.text.push_back(ch);
+            continue;
+        }
+
+        // Since we read ahead and use that character, advance the index one extra to compensate.
+        const auto chNext = til::at(target, ++i);
+
+        if (chNext >= L'1' && chNext <= L'9')
+        {
+            pushSegment(CompiledTarget::SegmentType::Argument, chNext - L'0');
+        }
+        else if (L'*' == chNext)
+        {
+            pushSegment(CompiledTarget::SegmentType::AllArguments, 0);
+        }
+        else if (L'T' == towupper(chNext))
+        {
+            pushSegment(CompiledTarget::SegmentType::NextCommand, 0);
+        }
+        else if (!s_TryReplaceInputRedirMacro(chNext, compiled.text) &&
+                 !s_TryReplaceOutputRedirMacro(chNext, compiled.text) &&
+                 !s_TryReplacePipeRedirMacro(chNext, compiled.text))
+        {
+            // If nothing matches, just push these two characters in.
+            compiled.text.push_back(ch);
+            compiled.text.push_back(chNext);
+        }
+    }
 
+    flushText();
+    return compiled;
+}
+
+// Routine Description:
+// - Expands a target compiled by s_CompileTarget, equivalent to what s_ReplaceMacros does.
+// Arguments:
+// - compiled - The compiled target of the alias
+// - tokens - The tokenized command line input. 0 is the alias, 1-N are arguments.
+// - fullArgString - Shorthand to 1-N argument string in case of wildcard match.
+// - lineCount - Receives the number of commands in the final string (line feeds, CRLFs)
+// Return Value:
+// - The expanded target, always terminated with a CRLF.
+std::wstring Alias::s_ExpandCompiledTarget(const CompiledTarget& compiled,
+                                           const std::span<const std::wstring_view> tokens,
+                                           const std::wstring_view fullArgString,
+                                           size_t& lineCount)
+{
+    const auto argument = [&](const size_t index) noexcept {
+        return index < tokens.size() ? til::at(tokens, index) : std::wstring_view{};
+    };
+
+    // Measure the final text first, so that it's allocated exactly once.
+    size_t length = 2;
+    for (const auto& segment : compiled.segments)
+    {
+        switch (segment.type)
+        {
+        case CompiledTarget::SegmentType::Text:
+            length += segment.length;
+            break;
+        case CompiledTarget::SegmentType::Argument:
+            length += argument(segment.offset).size();
+            break;
+        case CompiledTarget::SegmentType::AllArguments:
+            length += fullArgString.size();
+            break;
+        case CompiledTarget::SegmentType::NextCommand:
+            length += 2;
+            break;
+        }
+    }
+
+    std::wstring finalText;
+    finalText.reserve(length);
+    lineCount = 0;
+
+    for (const auto& segment : compiled.segments)
+    {
+        switch (segment.type)
+        {
+        case CompiledTarget::SegmentType::Text:
+            finalText.append(compiled.text, segment.offset, segment.length);
+            break;
+        case CompiledTarget::SegmentType::Argument:
+            finalText.append(argument(segment.offset));
+            break;
+        case CompiledTarget::SegmentType::AllArguments:
+            finalText.append(fullArgString);
+            break;
+        case CompiledTarget::SegmentType::NextCommand:
+            s_AppendCrLf(finalText, lineCount);
+            break;
+        }
+    }
+
+    // We always terminate with a CRLF to symbolize end of command.
+    s_AppendCrLf(finalText, lineCount);
     return finalText;
 }
 
@@ -1244,11 +1401,13 @@ void Alias::s_TestAddAlias(std::wstring& exe,
                            std::wstring& target)
 {
     g_aliasData[exe][alias] = target;
+    s_InvalidateCompiledTargets();
 }
 
 void Alias::s_TestClearAliases()
 {
     g_aliasData.clear();
+    s_InvalidateCompiledTargets();
 }
 
 #endif
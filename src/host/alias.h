@@ -15,6 +15,7 @@ class Alias
 {
 public:
     static void s_ClearCmdExeAliases();
+    static void s_InvalidateCompiledTargets() noexcept;
 
     static void s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PCWCH pwchSource,
                                           _In_ size_t cbSource,
@@ -29,6 +30,41 @@ public:
                                             size_t& lineCount);
 
 private:
+    // The target of an alias with its macros parsed ahead of time. s_MatchAndCopyAlias() would
+    // otherwise have to parse it again for every line that's submitted, which adds up for batch
+    // scripts. Literal text (including the redirection macros) is stored in `text` and referenced
+    // by Text segments. The Argument segments refer to the numbered arguments $1-$9.
+    struct CompiledTarget
+    {
+        enum class SegmentType : uint8_t
+        {
+            Text,
+            Argument,
+            AllArguments,
+            NextCommand,
+        };
+
+        struct Segment
+        {
+            SegmentType type;
+            size_t offset; // Text: offset into `text`. Argument: the argument's index.
+            size_t length; // Text: length of the text.
+        };
+
+        std::wstring text;
+        std::vector<Segment> segments;
+    };
+
+    // Maps exe name, a null character and the alias name (as stored in the alias data) to the compiled target.
+    // It's cleared whenever an alias is added or removed.
+    static std::unordered_map<std::wstring, CompiledTarget> s_compiledTargets;
+
+    static CompiledTarget s_CompileTarget(const std::wstring_view target);
+    static std::wstring s_ExpandCompiledTarget(const CompiledTarget& compiled,
+                                               const std::span<const std::wstring_view> tokens,
+                                               const std::wstring_view fullArgString,
+                                               size_t& lineCount);
+
     static void s_TrimTrailingCrLf(std::wstring& str);
     static std::deque<std::wstring> s_Tokenize(const std::wstring& str);
     static std::wstring s_GetArgString(const std::wstring& str);
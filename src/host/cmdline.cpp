@@ -272,6 +272,81 @@ void RedrawCommandLine(COOKED_READ_DATA& cookedReadData)
     }
 }
 
+// Routine Description:
+// - Redraws the command line from the given character on, after the text was edited at that index.
+// - The text before it is unchanged and so are its cells on screen. Only the remainder of the line is
+//   written and only the cells the previous, longer line occupied beyond its new end are blanked out.
+//   This avoids erasing and rewriting the entire line for every edit in the middle of it.
+// Arguments:
+// - cookedReadData - The cooked read data to operate on
+// - index - The index of the first character that was changed
+// - dwFlags - The flags to pass to WriteCharsLegacy
+// - pScrollY - Receives the number of rows the buffer scrolled while writing
+// Return Value:
+// - STATUS_SUCCESS or an appropriate failure from WriteCharsLegacy.
+// - The cursor is left at the end of the command line.
+[[nodiscard]] NTSTATUS RedrawCommandLineFrom(COOKED_READ_DATA& cookedReadData,
+                                             size_t index,
+                                             const DWORD dwFlags,
+                                             _Inout_opt_ til::CoordType* const pScrollY)
+{
+    if (cookedReadData.OriginalCursorPosition().y < 0)
+    {
+        // The start of the command line scrolled off the top of the buffer.
+        // DeleteCommandLine knows how to deal with that, so fall back to redrawing all of it.
+        DeleteCommandLine(cookedReadData, false);
+        index = 0;
+    }
+
+    auto& screenInfo = cookedReadData.ScreenInfo();
+    const auto bufferStart = cookedReadData.BufferStartPtr();
+    const auto originalCursor = cookedReadData.OriginalCursorPosition();
+    const auto previousVisibleCharCount = cookedReadData.VisibleCharCount();
+    const auto prefixSpaces = RetrieveTotalNumberOfSpaces(originalCursor.x, bufferStart, index);
+
+    // Move the cursor to where the character at the given index starts, the same way RedrawCommandLine does.
+    auto cursorPosition = originalCursor;
+    cursorPosition.x += prefixSpaces;
+    if (CheckBisectStringW(bufferStart, index, screenInfo.GetBufferSize().Width() - originalCursor.x))
+    {
+        cursorPosition.x++;
+    }
+    AdjustCursorPosition(screenInfo, cursorPosition, WI_IsFlagSet(dwFlags, WC_KEEP_CURSOR_VISIBLE), nullptr);
+
+    auto bytesToWrite = cookedReadData.BytesRead() - index * sizeof(WCHAR);
+    size_t remainderSpaces = 0;
+    const auto status = WriteCharsLegacy(screenInfo,
+                                         bufferStart,
+                                         bufferStart + index,
+                                         bufferStart + index,
+                                         &bytesToWrite,
+                                         &remainderSpaces,
+                                         originalCursor.x,
+                                         dwFlags,
+                                         pScrollY);
+    if (FAILED_NTSTATUS(status))
+    {
+        return status;
+    }
+
+    const auto visibleCharCount = gsl::narrow_cast<size_t>(prefixSpaces) + remainderSpaces;
+    cookedReadData.VisibleCharCount() = visibleCharCount;
+
+    // Blank out the rest of the previous line. Like DeleteCommandLine, we erase one more
+    // cell in case a wide glyph was pushed to the next row by the old text.
+    if (previousVisibleCharCount > visibleCharCount)
+    {
+        try
+        {
+            const auto cellsToErase = previousVisibleCharCount - visibleCharCount + 1;
+            screenInfo.Write(OutputCellIterator(UNICODE_SPACE, cellsToErase), screenInfo.GetTextBuffer().GetCursor().GetPosition());
+        }
+        CATCH_LOG();
+    }
+
+    return status;
+}
+
 // Routine Description:
 // - This routine copies the commandline specified by Index into the cooked read buffer
 void SetCurrentCommandLine(COOKED_READ_DATA& cookedReadData, _In_ SHORT Index) // index, not command number
@@ -542,19 +617,14 @@ void CommandLine::_setPromptToNewestCommand(COOKED_READ_DATA& cookedReadData)
 // - cookedReadData - The cooked read data to operate on
 void CommandLine::DeletePromptAfterCursor(COOKED_READ_DATA& cookedReadData) noexcept
 {
-    DeleteCommandLine(cookedReadData, false);
     cookedReadData.BytesRead() = cookedReadData.InsertionPoint() * sizeof(WCHAR);
     if (cookedReadData.IsEchoInput())
     {
-        FAIL_FAST_IF_NTSTATUS_FAILED(WriteCharsLegacy(cookedReadData.ScreenInfo(),
-                                                      cookedReadData.BufferStartPtr(),
-                                                      cookedReadData.BufferStartPtr(),
-                                                      cookedReadData.BufferStartPtr(),
-                                                      &cookedReadData.BytesRead(),
-                                                      &cookedReadData.VisibleCharCount(),
-                                                      cookedReadData.OriginalCursorPosition().x,
-                                                      WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
-                                                      nullptr));
+        // The text in front of the cursor stays, so this only needs to erase what followed it.
+        FAIL_FAST_IF_NTSTATUS_FAILED(RedrawCommandLineFrom(cookedReadData,
+                                                           cookedReadData.InsertionPoint(),
+                                                           WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
+                                                           nullptr));
     }
 }
 
@@ -1035,12 +1105,6 @@ til::point CommandLine::DeleteFromRightOfCursor(COOKED_READ_DATA& cookedReadData
 
     if (!cookedReadData.AtEol())
     {
-        // Delete commandline.
-        // clang-format off
-#pragma prefast(suppress: __WARNING_BUFFER_OVERFLOW, "Not sure why prefast is getting confused here")
-        // clang-format on
-        DeleteCommandLine(cookedReadData, false);
-
         // Delete char.
         cookedReadData.BytesRead() -= sizeof(WCHAR);
         memmove(cookedReadData.BufferCurrentPtr(),
@@ -1052,18 +1116,13 @@ til::point CommandLine::DeleteFromRightOfCursor(COOKED_READ_DATA& cookedReadData
             *buf = (WCHAR)' ';
         }
 
-        // Write commandline.
+        // Write the part of the commandline that moved.
         if (cookedReadData.IsEchoInput())
         {
-            FAIL_FAST_IF_NTSTATUS_FAILED(WriteCharsLegacy(cookedReadData.ScreenInfo(),
-                                                          cookedReadData.BufferStartPtr(),
-                                                          cookedReadData.BufferStartPtr(),
-                                                          cookedReadData.BufferStartPtr(),
-                                                          &cookedReadData.BytesRead(),
-                                                          &cookedReadData.VisibleCharCount(),
-                                                          cookedReadData.OriginalCursorPosition().x,
-                                                          WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
-                                                          nullptr));
+            FAIL_FAST_IF_NTSTATUS_FAILED(RedrawCommandLineFrom(cookedReadData,
+                                                               cookedReadData.InsertionPoint(),
+                                                               WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
+                                                               nullptr));
         }
 
         // restore cursor position
@@ -170,6 +170,31 @@ void ConversionAreaInfo::SetWindowInfo(const til::inclusive_rect& view) noexcept
     }
 }
 
+// Routine Description:
+// - Invalidates the given region of the screen, after the conversion area was moved or hidden.
+//   The conversion areas are overlays on top of the text buffer, which is left untouched,
+//   so only the overlays need to be repainted and the text underneath doesn't.
+// Arguments:
+// - screenInfo - The screen buffer the conversion area is shown on.
+// - region - The region in screen buffer coordinates.
+// Return Value:
+// - <none>
+static void RedrawOverlay(const SCREEN_INFORMATION& screenInfo, const Viewport& region) noexcept
+{
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto pRender = ServiceLocator::LocateGlobals().pRender;
+    if (!pRender || !screenInfo.IsActiveScreenBuffer() || WI_IsFlagSet(gci.Flags, CONSOLE_IS_ICONIC))
+    {
+        return;
+    }
+
+    try
+    {
+        pRender->TriggerRedrawOverlay(region);
+    }
+    CATCH_LOG();
+}
+
 void ConversionAreaInfo::SetViewPos(const til::point pos) noexcept
 {
     if (IsHidden())
@@ -185,7 +210,7 @@ void ConversionAreaInfo::SetViewPos(const til::point pos) noexcept
         OldRegion.right += _caInfo.coordConView.x;
         OldRegion.top += _caInfo.coordConView.y;
         OldRegion.bottom += _caInfo.coordConView.y;
-        WriteToScreen(gci.GetActiveOutputBuffer(), Viewport::FromInclusive(OldRegion));
+        RedrawOverlay(gci.GetActiveOutputBuffer(), Viewport::FromInclusive(OldRegion));
 
         _caInfo.coordConView = pos;
 
@@ -194,7 +219,7 @@ void ConversionAreaInfo::SetViewPos(const til::point pos) noexcept
         NewRegion.right += _caInfo.coordConView.x;
         NewRegion.top += _caInfo.coordConView.y;
         NewRegion.bottom += _caInfo.coordConView.y;
-        WriteToScreen(gci.GetActiveOutputBuffer(), Viewport::FromInclusive(NewRegion));
+        RedrawOverlay(gci.GetActiveOutputBuffer(), Viewport::FromInclusive(NewRegion));
     }
 }
 
@@ -216,6 +241,6 @@ void ConversionAreaInfo::Paint() const noexcept
     }
     else
     {
-        WriteToScreen(ScreenInfo, Viewport::FromInclusive(WriteRegion));
+        RedrawOverlay(ScreenInfo, Viewport::FromInclusive(WriteRegion));
     }
 }
@@ -35,6 +35,22 @@ void CONSOLE_INFORMATION::UnlockConsole() noexcept
     _lock.unlock();
 }
 
+// Routine Description:
+// - Acquires the console lock for reading only. Other readers may hold it at the same time.
+// - Shared locks are recursive, but the caller must not call LockConsole() while holding one,
+//   unless it already held the lock exclusively.
+#pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
+void CONSOLE_INFORMATION::LockConsoleShared() noexcept
+{
+    _lock.lock_shared();
+}
+
+#pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
+void CONSOLE_INFORMATION::UnlockConsoleShared() noexcept
+{
+    _lock.unlock_shared();
+}
+
 ULONG CONSOLE_INFORMATION::GetCSRecursionCount() const noexcept
 {
     return _lock.recursion_depth();
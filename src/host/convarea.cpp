@@ -55,9 +55,10 @@ void WriteConvRegionToScreen(const SCREEN_INFORMATION& ScreenInfo,
                     // if we have a renderer, we need to update.
                     // we've already confirmed (above with an early return) that we're on conversion areas that are a part of the active (visible/rendered) screen
                     // so send invalidates to those regions such that we're queried for data on the next frame and repainted.
+                    // The text buffer underneath the conversion areas is unaffected, which is why they're overlay invalidates.
                     if (ServiceLocator::LocateGlobals().pRender != nullptr)
                     {
-                        ServiceLocator::LocateGlobals().pRender->TriggerRedraw(Viewport::FromInclusive(Region));
+                        ServiceLocator::LocateGlobals().pRender->TriggerRedrawOverlay(Viewport::FromInclusive(Region));
                     }
                 }
             }
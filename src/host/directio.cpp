@@ -364,7 +364,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // Return Value:
 // - HRESULT indicating success or failure
 [[nodiscard]] static HRESULT _WriteConsoleInputWImplHelper(InputBuffer& context,
-                                                           std::deque<std::unique_ptr<IInputEvent>>& events,
+                                                           const std::span<const INPUT_RECORD>& events,
                                                            size_t& written,
                                                            const bool append) noexcept
 {
@@ -426,7 +426,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
             context.StoreWritePartialByteSequence(std::move(partialEvent));
         }
 
-        return _WriteConsoleInputWImplHelper(context, events, written, append);
+        return _WriteConsoleInputWImplHelper(context, IInputEvent::ToInputRecords(events), written, append);
     }
     CATCH_RETURN();
 }
@@ -451,13 +451,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
 
-    try
-    {
-        auto events = IInputEvent::Create(buffer);
-
-        return _WriteConsoleInputWImplHelper(context, events, written, append);
-    }
-    CATCH_RETURN();
+    return _WriteConsoleInputWImplHelper(context, buffer, written, append);
 }
 
 // Routine Description:
@@ -674,7 +668,6 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 {
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         const auto& storageBuffer = context.GetActiveBuffer().GetTextBuffer();
         const auto storageSize = storageBuffer.GetSize().Dimensions();
 
@@ -709,44 +702,20 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
         // The final "request rectangle" or the area inside the buffer we want to read, is the clipped dimensions.
         const auto clippedRequestRectangle = Viewport::FromExclusive(clip);
 
-        // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
-        const auto sourcePoint = clippedRequestRectangle.Origin();
-
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        til::point targetPos;
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backing store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Transcode the clipped request row by row directly from the backing store into the
+        // user's buffer, where each row starts at the target point offset into the original request.
+        // We validate that we're always writing inside the user's buffer (before the end).
+        const auto clippedWidth = clip.right - clip.left;
+        for (auto y = clip.top; y < clip.bottom && clippedWidth > 0; ++y)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
+            const auto targetOffset = gsl::narrow_cast<size_t>((targetPoint.y + y - clip.top) * targetSize.width + targetPoint.x);
+            if (targetOffset >= targetBuffer.size())
             {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                ++sourceIter;
+                break;
             }
 
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            ++targetIter;
-
-            // Increment the target
-            targetPos.x++;
-            if (targetPos.x >= targetSize.width)
-            {
-                targetPos.x = 0;
-                targetPos.y++;
-            }
+            const auto count = std::min(gsl::narrow_cast<size_t>(clippedWidth), targetBuffer.size() - targetOffset);
+            storageBuffer.ReadCharInfos({ clip.left, y }, targetBuffer.subspan(targetOffset, count));
         }
 
         // Reply with the region we read out of the backing buffer (potentially clipped)
@@ -803,6 +772,55 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     CATCH_RETURN();
 }
 
+// Routine Description:
+// - Returns the areas of the screen buffer that changed since the given sequence number.
+//   Pollers that periodically scrape the buffer via ReadConsoleOutputW can use this to
+//   only read what changed, instead of reading the entire buffer every single time.
+// - This is based on the ROW generations and as such is accurate to the row.
+//   If rows were moved since then (for instance due to scrolling), the entire buffer is returned.
+// Arguments:
+// - context - The screen buffer to check
+// - sequence - A value previously returned via currentSequence or 0 to get the entire buffer
+// - changedRectangles - Receives the changed areas as full-width rectangles of consecutive rows
+// - currentSequence - Receives the value to pass to the next call
+// Return Value:
+// - S_OK or a suitable HRESULT code.
+[[nodiscard]] HRESULT ApiRoutines::GetConsoleOutputChangesImpl(const SCREEN_INFORMATION& context,
+                                                               const uint64_t sequence,
+                                                               std::vector<Viewport>& changedRectangles,
+                                                               uint64_t& currentSequence) noexcept
+{
+    changedRectangles.clear();
+    currentSequence = 0;
+
+    LockConsole();
+    auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+
+    try
+    {
+        const auto& buffer = context.GetActiveBuffer().GetTextBuffer();
+        const auto size = buffer.GetSize().Dimensions();
+
+        // Any ROW modified after this point will have a larger generation and be returned by the next call.
+        currentSequence = ROW::GetLatestGeneration();
+
+        const auto rows = buffer.GetChangedRowsSince(sequence, 0, size.height);
+        for (auto it = rows.begin(); it != rows.end();)
+        {
+            const auto top = *it;
+            auto bottom = top + 1;
+            for (++it; it != rows.end() && *it == bottom; ++it)
+            {
+                ++bottom;
+            }
+            changedRectangles.emplace_back(Viewport::FromExclusive({ 0, top, size.width, bottom }));
+        }
+
+        return S_OK;
+    }
+    CATCH_RETURN();
+}
+
 [[nodiscard]] static HRESULT _WriteConsoleOutputWImplHelper(SCREEN_INFORMATION& context,
                                                             std::span<CHAR_INFO> buffer,
                                                             const Viewport& requestRectangle,
@@ -887,12 +905,9 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
             // Now we make a subspan starting from that offset for as much of the original request as would fit
             const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
 
-            // Convert to a CHAR_INFO view to fit into the iterator
+            // Transcode the CHAR_INFOs directly into the row at the target position.
             const auto charInfos = std::span<const CHAR_INFO>(subspan.data(), subspan.size());
-
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
+            storageBuffer.GetTextBuffer().WriteCharInfos(target, charInfos);
         }
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
@@ -43,8 +43,8 @@ void ApiRoutines::GetConsoleInputModeImpl(InputBuffer& context, ULONG& mode) noe
     {
         Telemetry::Instance().LogApiCall(Telemetry::ApiCall::GetConsoleMode);
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         mode = context.InputMode;
 
@@ -68,8 +68,8 @@ void ApiRoutines::GetConsoleOutputModeImpl(SCREEN_INFORMATION& context, ULONG& m
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         mode = context.GetActiveBuffer().OutputMode;
     }
@@ -87,8 +87,8 @@ void ApiRoutines::GetConsoleOutputModeImpl(SCREEN_INFORMATION& context, ULONG& m
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         const auto readyEventCount = context.GetNumberOfReadyEvents();
         RETURN_IF_FAILED(SizeTToULong(readyEventCount, &events));
@@ -108,8 +108,8 @@ void ApiRoutines::GetConsoleScreenBufferInfoExImpl(const SCREEN_INFORMATION& con
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         data.bFullscreenSupported = FALSE; // traditional full screen with the driver support is no longer supported.
         // see MSFT: 19918103
@@ -162,8 +162,8 @@ void ApiRoutines::GetConsoleCursorInfoImpl(const SCREEN_INFORMATION& context,
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         size = context.GetActiveBuffer().GetTextBuffer().GetCursor().GetSize();
         isVisible = context.GetTextBuffer().GetCursor().IsVisible();
@@ -1082,8 +1082,8 @@ void ApiRoutines::GetConsoleInputCodePageImpl(ULONG& codepage) noexcept
     try
     {
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         codepage = gci.CP;
     }
@@ -1098,8 +1098,8 @@ void ApiRoutines::GetConsoleOutputCodePageImpl(ULONG& codepage) noexcept
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         codepage = gci.OutputCP;
     }
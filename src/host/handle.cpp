@@ -21,6 +21,13 @@ void UnlockConsole()
     auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     if (gci.GetCSRecursionCount() == 1)
     {
+        // Process any VT input that was received while we held the lock, so
+        // that the VT input thread doesn't need to wait for its turn.
+        try
+        {
+            gci.GetVtIo()->ProcessPendingInput();
+        }
+        CATCH_LOG();
         ProcessCtrlEvents();
     }
     else
@@ -28,3 +35,22 @@ void UnlockConsole()
         gci.UnlockConsole();
     }
 }
+
+// Routine Description:
+// - Acquires the console lock for API calls that only read console state.
+//   They may run concurrently with each other, but not with any writer.
+// - The caller must not call any function that locks the console exclusively while holding it.
+void LockConsoleShared()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsoleShared();
+}
+
+// Routine Description:
+// - Releases the lock acquired by LockConsoleShared(). Since readers don't alter any
+//   state, there's no need to process pending events here, unlike UnlockConsole().
+void UnlockConsoleShared()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.UnlockConsoleShared();
+}
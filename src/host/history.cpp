@@ -5,6 +5,8 @@
 
 #include "history.h"
 
+#include <til/hash.h>
+
 #include "_output.h"
 #include "output.h"
 #include "stream.h"
@@ -107,7 +109,7 @@ void CommandHistory::_Reset()
         {
             std::wstring reuse{};
 
-            if (suppressDuplicates)
+            if (suppressDuplicates && _MayContainCommand(newCommand))
             {
                 SHORT index;
                 if (FindMatchingCommand(newCommand, LastDisplayed, index, CommandHistory::MatchOptions::ExactMatch))
@@ -119,6 +121,7 @@ void CommandHistory::_Reset()
             // find free record.  if all records are used, free the lru one.
             if ((SHORT)_commands.size() == _maxCommands)
             {
+                _UntrackCommand(_commands.front());
                 _commands.erase(_commands.cbegin());
                 // move LastDisplayed back one in order to stay synced with the
                 // command it referred to before erasing the lru one
@@ -126,9 +129,10 @@ void CommandHistory::_Reset()
             }
 
             // add newCommand to array
+            _TrackCommand(newCommand);
             if (!reuse.empty())
             {
-                _commands.emplace_back(reuse);
+                _commands.emplace_back(std::move(reuse));
             }
             else
             {
@@ -243,7 +247,7 @@ std::wstring_view CommandHistory::GetLastCommand() const
 
 void CommandHistory::Empty()
 {
-    _commands.clear();
+    _ClearCommands();
     LastDisplayed = -1;
     WI_SetFlag(Flags, CLE_RESET);
 }
@@ -277,13 +281,12 @@ void CommandHistory::Realloc(const size_t commands)
         return;
     }
 
-    const auto oldCommands = _commands;
+    // Keep the first (oldest) commands that still fit.
     const auto newNumberOfCommands = gsl::narrow<SHORT>(std::min(_commands.size(), commands));
-
-    _commands.clear();
-    for (SHORT i = 0; i < newNumberOfCommands; i++)
+    for (auto i = _commands.size(); i > gsl::narrow_cast<size_t>(newNumberOfCommands); --i)
     {
-        _commands.emplace_back(oldCommands[i]);
+        _UntrackCommand(_commands.back());
+        _commands.pop_back();
     }
 
     WI_SetFlag(Flags, CLE_RESET);
@@ -297,11 +300,11 @@ void CommandHistory::s_ReallocExeToFront(const std::wstring_view appName, const
     {
         if (WI_IsFlagSet(it->Flags, CLE_ALLOCATED) && it->IsAppNameMatch(appName))
         {
-            auto backup = *it;
-            backup.Realloc(commands);
+            it->Realloc(commands);
 
-            s_historyLists.erase(it);
-            s_historyLists.push_front(backup);
+            // Move the node to the front without copying the history.
+            // This also keeps pointers to it valid.
+            s_historyLists.splice(s_historyLists.begin(), s_historyLists, it);
 
             return;
         }
@@ -336,19 +339,19 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
     auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     // Reuse a history buffer.  The buffer must be !CLE_ALLOCATED.
     // If possible, the buffer should have the same app name.
-    std::optional<CommandHistory> BestCandidate;
+    // The candidate is moved to the front of the list via splice(), which avoids copying its commands.
+    auto BestCandidate = s_historyLists.end();
     auto SameApp = false;
 
-    for (auto it = s_historyLists.cbegin(); it != s_historyLists.cend(); it++)
+    for (auto it = s_historyLists.begin(); it != s_historyLists.end(); it++)
     {
         if (WI_IsFlagClear(it->Flags, CLE_ALLOCATED))
         {
             // use MRU history buffer with same app name
             if (it->IsAppNameMatch(appName))
             {
-                BestCandidate = *it;
+                BestCandidate = it;
                 SameApp = true;
-                s_historyLists.erase(it);
                 break;
             }
         }
@@ -371,32 +374,26 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
     // If we have no candidate already and we need one,
     // take the LRU (which is the back/last one) which isn't allocated
     // and if possible the one with empty commands list.
-    if (!BestCandidate.has_value())
+    if (BestCandidate == s_historyLists.end())
     {
-        auto BestCandidateIt = s_historyLists.cend();
-        for (auto it = s_historyLists.cbegin(); it != s_historyLists.cend(); it++)
+        for (auto it = s_historyLists.begin(); it != s_historyLists.end(); it++)
         {
             if (WI_IsFlagClear(it->Flags, CLE_ALLOCATED))
             {
-                if (it->_commands.empty() || BestCandidateIt == s_historyLists.cend() || !BestCandidateIt->_commands.empty())
+                if (it->_commands.empty() || BestCandidate == s_historyLists.end() || !BestCandidate->_commands.empty())
                 {
-                    BestCandidateIt = it;
+                    BestCandidate = it;
                 }
             }
         }
-        if (BestCandidateIt != s_historyLists.cend())
-        {
-            BestCandidate = *BestCandidateIt;
-            s_historyLists.erase(BestCandidateIt);
-        }
     }
 
     // If the app name doesn't match, copy in the new app name and free the old commands.
-    if (BestCandidate.has_value())
+    if (BestCandidate != s_historyLists.end())
     {
         if (!SameApp)
         {
-            BestCandidate->_commands.clear();
+            BestCandidate->_ClearCommands();
             BestCandidate->LastDisplayed = -1;
             BestCandidate->_appName = appName;
         }
@@ -404,7 +401,8 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
         BestCandidate->_processHandle = processHandle;
         WI_SetFlag(BestCandidate->Flags, CLE_ALLOCATED);
 
-        return &s_historyLists.emplace_front(BestCandidate.value());
+        s_historyLists.splice(s_historyLists.begin(), s_historyLists, BestCandidate);
+        return &*BestCandidate;
     }
 
     return nullptr;
@@ -433,6 +431,31 @@ void CommandHistory::_Next(SHORT& ind) const
     }
 }
 
+void CommandHistory::_TrackCommand(const std::wstring_view command)
+{
+    _commandHashes[til::hash(command)]++;
+}
+
+void CommandHistory::_UntrackCommand(const std::wstring_view command) noexcept
+{
+    if (const auto it = _commandHashes.find(til::hash(command)); it != _commandHashes.end() && --it->second == 0)
+    {
+        _commandHashes.erase(it);
+    }
+}
+
+// Returns false if the given command is definitely not part of this history.
+bool CommandHistory::_MayContainCommand(const std::wstring_view command) const noexcept
+{
+    return _commandHashes.contains(til::hash(command));
+}
+
+void CommandHistory::_ClearCommands() noexcept
+{
+    _commands.clear();
+    _commandHashes.clear();
+}
+
 void CommandHistory::_Dec(SHORT& ind) const
 {
     if (ind <= 0)
@@ -475,7 +498,8 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
 
     try
     {
-        const auto str = _commands.at(iDel);
+        auto str = std::move(_commands.at(iDel));
+        _UntrackCommand(str);
 
         if (iDel < iLast)
         {
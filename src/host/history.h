@@ -83,7 +83,16 @@ private:
     void _Dec(SHORT& ind) const;
     void _Inc(SHORT& ind) const;
 
+    void _TrackCommand(const std::wstring_view command);
+    void _UntrackCommand(const std::wstring_view command) noexcept;
+    bool _MayContainCommand(const std::wstring_view command) const noexcept;
+    void _ClearCommands() noexcept;
+
     std::vector<std::wstring> _commands;
+    // Counts how many of the _commands have a given til::hash(). Add() uses this to skip searching for
+    // duplicates if there can't be any, which is by far the most common case for long histories.
+    // Hash collisions are harmless, because they only cause an unnecessary search.
+    std::unordered_map<size_t, uint32_t> _commandHashes;
     SHORT _maxCommands;
 
     std::wstring _appName;
@@ -103,6 +103,25 @@ bool ShouldTakeOverKeyboardShortcuts()
     return !gci.GetCtrlKeyShortcutsDisabled() && IsInProcessedInputMode();
 }
 
+// Routine Description:
+// - Returns true if HandleGenericKeyEvent() may do more with the given key
+//   event than write it to the input buffer (Ctrl+C, Ctrl+Break, etc.).
+//   Any other key event can be written to the input buffer directly.
+bool IsSpecialKeyEvent(const KeyEvent& keyEvent) noexcept
+{
+    if (!keyEvent.IsKeyDown())
+    {
+        return false;
+    }
+
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    if (keyEvent.IsCtrlPressed() && !keyEvent.IsAltPressed())
+    {
+        return vkey == 'C' || vkey == VK_CANCEL || vkey == VK_ESCAPE;
+    }
+    return keyEvent.IsAltPressed() && vkey == VK_ESCAPE;
+}
+
 // Routine Description:
 // - handles key events without reference to Win32 elements.
 void HandleGenericKeyEvent(_In_ KeyEvent keyEvent, const bool generateBreak)
@@ -163,11 +182,11 @@ void HandleGenericKeyEvent(_In_ KeyEvent keyEvent, const bool generateBreak)
         size_t EventsWritten = 0;
         try
         {
-            EventsWritten = gci.pInputBuffer->Write(std::make_unique<KeyEvent>(keyEvent));
+            EventsWritten = gci.pInputBuffer->Write(keyEvent.ToInputRecord());
             if (EventsWritten && generateBreak)
             {
                 keyEvent.SetKeyDown(false);
-                EventsWritten = gci.pInputBuffer->Write(std::make_unique<KeyEvent>(keyEvent));
+                EventsWritten = gci.pInputBuffer->Write(keyEvent.ToInputRecord());
             }
         }
         catch (...)
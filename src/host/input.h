@@ -78,6 +78,7 @@ bool ShouldTakeOverKeyboardShortcuts();
 void HandleMenuEvent(const DWORD wParam);
 void HandleFocusEvent(const BOOL fSetFocus);
 void HandleCtrlEvent(const DWORD EventType);
+bool IsSpecialKeyEvent(const KeyEvent& keyEvent) noexcept;
 void HandleGenericKeyEvent(_In_ KeyEvent keyEvent, const bool generateBreak);
 
 void ProcessCtrlEvents();
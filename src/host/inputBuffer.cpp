@@ -281,6 +281,60 @@ void InputBuffer::StoreWritePartialByteSequence(std::unique_ptr<IInputEvent> eve
     _writePartialByteSequence.swap(event);
 }
 
+void InputBuffer::RecordQueue::push_back(const INPUT_RECORD& record)
+{
+    _reclaim(1);
+    _records.emplace_back(record);
+}
+
+void InputBuffer::RecordQueue::append(const std::span<const INPUT_RECORD>& records)
+{
+    _reclaim(records.size());
+    _records.insert(_records.end(), records.begin(), records.end());
+}
+
+void InputBuffer::RecordQueue::pop_front(const size_t count) noexcept
+{
+    _head += std::min(count, size());
+    if (empty())
+    {
+        clear();
+    }
+}
+
+// Removes all records from `it` up to the end.
+void InputBuffer::RecordQueue::erase_from(const INPUT_RECORD* it) noexcept
+{
+    _records.resize(gsl::narrow_cast<size_t>(it - _records.data()));
+    if (empty())
+    {
+        clear();
+    }
+}
+
+void InputBuffer::RecordQueue::clear() noexcept
+{
+    _records.clear();
+    _head = 0;
+}
+
+void InputBuffer::RecordQueue::swap(RecordQueue& other) noexcept
+{
+    _records.swap(other._records);
+    std::swap(_head, other._head);
+}
+
+// Moves the unread records back to the start of the buffer if the vector would need to grow
+// otherwise and at least half of it are records that were already read.
+void InputBuffer::RecordQueue::_reclaim(const size_t additional)
+{
+    if (_head != 0 && _records.size() + additional > _records.capacity() && _head >= size())
+    {
+        _records.erase(_records.begin(), _records.begin() + _head);
+        _head = 0;
+    }
+}
+
 // Routine Description:
 // - This routine resets the input buffer information fields to their initial values.
 // Arguments:
@@ -296,13 +350,19 @@ void InputBuffer::ReinitializeInputBuffer()
 
 // Routine Description:
 // - Wakes up readers waiting for data to read.
+// - Readers are woken one at a time in the order they started waiting. Notifying all of
+//   them would only make those behind the first one retry under the console lock, just to
+//   find that the first one consumed the input. But if a reader was satisfied and left input
+//   behind, the next one can make progress as well and shouldn't have to wait for more input.
 // Arguments:
 // - None
 // Return Value:
 // - None
 void InputBuffer::WakeUpReadersWaitingForData()
 {
-    WaitQueue.NotifyWaiters(false);
+    while (WaitQueue.NotifyWaiters(false) && !_storage.empty())
+    {
+    }
 }
 
 // Routine Description:
@@ -353,10 +413,10 @@ void InputBuffer::Flush()
 // - The console lock must be held when calling this routine.
 void InputBuffer::FlushAllButKeys()
 {
-    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const std::unique_ptr<IInputEvent>& event) {
-        return event->EventType() != InputEventType::KeyEvent;
+    const auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const INPUT_RECORD& record) {
+        return record.EventType != KEY_EVENT;
     });
-    _storage.erase(newEnd, _storage.end());
+    _storage.erase_from(newEnd);
 }
 
 void InputBuffer::SetTerminalConnection(_In_ Render::VtEngine* const pTtyConnection)
@@ -422,31 +482,29 @@ try
 
     while (it != end && OutEvents.size() < AmountToRead)
     {
-        auto event = IInputEvent::Create((*it)->ToInputRecord());
-
-        if (event->EventType() == InputEventType::KeyEvent)
+        if (it->EventType == KEY_EVENT)
         {
-            const auto keyEvent = static_cast<KeyEvent*>(event.get());
+            KeyEvent keyEvent{ it->Event.KeyEvent };
             WORD repeat = 1;
 
             // for stream reads we need to split any key events that have been coalesced
             if (Stream)
             {
-                repeat = keyEvent->GetRepeatCount();
-                keyEvent->SetRepeatCount(1);
+                repeat = keyEvent.GetRepeatCount();
+                keyEvent.SetRepeatCount(1);
             }
 
             if (Unicode)
             {
                 do
                 {
-                    OutEvents.push_back(std::make_unique<KeyEvent>(*keyEvent));
+                    OutEvents.push_back(std::make_unique<KeyEvent>(keyEvent));
                     repeat--;
                 } while (repeat > 0 && OutEvents.size() < AmountToRead);
             }
             else
             {
-                const auto wch = keyEvent->GetCharData();
+                const auto wch = keyEvent.GetCharData();
 
                 char buffer[8];
                 const auto length = WideCharToMultiByte(cp, 0, &wch, 1, &buffer[0], sizeof(buffer), nullptr, nullptr);
@@ -458,7 +516,7 @@ try
                 {
                     for (const auto& ch : str)
                     {
-                        auto tempEvent = std::make_unique<KeyEvent>(*keyEvent);
+                        auto tempEvent = std::make_unique<KeyEvent>(keyEvent);
                         tempEvent->SetCharData(ch);
                         OutEvents.push_back(std::move(tempEvent));
                     }
@@ -468,14 +526,13 @@ try
 
             if (repeat && !Peek)
             {
-                const auto originalKeyEvent = static_cast<KeyEvent*>((*it).get());
-                originalKeyEvent->SetRepeatCount(repeat);
+                it->Event.KeyEvent.wRepeatCount = repeat;
                 break;
             }
         }
         else
         {
-            OutEvents.push_back(std::move(event));
+            OutEvents.push_back(IInputEvent::Create(*it));
         }
 
         ++it;
@@ -483,7 +540,7 @@ try
 
     if (!Peek)
     {
-        _storage.erase(_storage.begin(), it);
+        _storage.pop_front(gsl::narrow_cast<size_t>(it - _storage.begin()));
     }
 
     Cache(Unicode, OutEvents, AmountToRead);
@@ -558,13 +615,37 @@ catch (...)
 // Note:
 // - The console lock must be held when calling this routine.
 size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+{
+    try
+    {
+        const auto inRecords = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Prepend(inRecords);
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// -  Writes records to the beginning of the input buffer.
+// Arguments:
+// - inRecords - records to write to buffer.
+// Return Value:
+// - The number of records written to the buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Prepend(const std::span<const INPUT_RECORD>& inRecords)
 {
     try
     {
         _vtInputShouldSuppress = true;
         auto resetVtInputSuppress = wil::scope_exit([&]() { _vtInputShouldSuppress = false; });
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> filtered;
+        const auto records = _HandleConsoleSuspensionEvents(inRecords, filtered);
+        if (records.empty())
         {
             return STATUS_SUCCESS;
         }
@@ -573,7 +654,7 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         // this way to handle any coalescing that might occur.
 
         // get all of the existing records, "emptying" the buffer
-        std::deque<std::unique_ptr<IInputEvent>> existingStorage;
+        RecordQueue existingStorage;
         existingStorage.swap(_storage);
 
         // We will need this variable to pass to _WriteBuffer so it can attempt to determine wait status.
@@ -584,12 +665,12 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
 
         // write the prepend records
         size_t prependEventsWritten;
-        _WriteBuffer(inEvents, prependEventsWritten, unusedWaitStatus);
+        _WriteBuffer(records, prependEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(unusedWaitStatus));
 
         // write all previously existing records
         size_t existingEventsWritten;
-        _WriteBuffer(existingStorage, existingEventsWritten, unusedWaitStatus);
+        _WriteBuffer({ existingStorage.begin(), existingStorage.end() }, existingEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(!unusedWaitStatus));
 
         // We need to set the wait event if there were 0 events in the
@@ -629,9 +710,7 @@ size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
 {
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> inEvents;
-        inEvents.push_back(std::move(inEvent));
-        return Write(inEvents);
+        return Write(inEvent->ToInputRecord());
     }
     catch (...)
     {
@@ -650,13 +729,52 @@ size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
 // Note:
 // - The console lock must be held when calling this routine.
 size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+{
+    try
+    {
+        const auto inRecords = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Write(inRecords);
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// - Writes a record to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inRecord - input record to store in the buffer.
+// Return Value:
+// - The number of records that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Write(const INPUT_RECORD& inRecord)
+{
+    return Write(std::span{ &inRecord, 1 });
+}
+
+// Routine Description:
+// - Writes records to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inRecords - input records to store in the buffer.
+// Return Value:
+// - The number of records that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Write(const std::span<const INPUT_RECORD>& inRecords)
 {
     try
     {
         _vtInputShouldSuppress = true;
         auto resetVtInputSuppress = wil::scope_exit([&]() { _vtInputShouldSuppress = false; });
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> filtered;
+        const auto records = _HandleConsoleSuspensionEvents(inRecords, filtered);
+        if (records.empty())
         {
             return 0;
         }
@@ -664,7 +782,7 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
         // Write to buffer.
         size_t EventsWritten;
         bool SetWaitEvent;
-        _WriteBuffer(inEvents, EventsWritten, SetWaitEvent);
+        _WriteBuffer(records, EventsWritten, SetWaitEvent);
 
         if (SetWaitEvent)
         {
@@ -683,9 +801,71 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 }
 
 // Routine Description:
-// - Coalesces input events and transfers them to storage queue.
+// - Writes VT input text, which is meant to be read verbatim by a VT input mode
+// client, to the input buffer. Each character is stored as a key-down record,
+// just like TerminalInput would have produced given the same characters.
+// Arguments:
+// - text - the text to store in the buffer.
+// Return Value:
+// - The number of records that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+// - Storing the records directly avoids creating and running an IInputEvent
+// through TerminalInput per character, which makes large pastes a lot faster.
+// That's only correct if TerminalInput wouldn't translate them (win32-input-mode)
+// and if none of them could resume a suspended console though.
+size_t InputBuffer::WritePassThroughString(const std::wstring_view& text)
+{
+    try
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto makeRecord = [](const wchar_t wch) noexcept {
+            INPUT_RECORD record{ KEY_EVENT };
+            record.Event.KeyEvent.bKeyDown = TRUE;
+            record.Event.KeyEvent.wRepeatCount = 1;
+            record.Event.KeyEvent.uChar.UnicodeChar = wch;
+            return record;
+        };
+
+        if (text.empty())
+        {
+            return 0;
+        }
+
+        if (!IsInVirtualTerminalInputMode() ||
+            _termInput.GetInputMode(TerminalInput::Mode::Win32) ||
+            WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED))
+        {
+            std::vector<INPUT_RECORD> records;
+            records.reserve(text.size());
+            std::transform(text.begin(), text.end(), std::back_inserter(records), makeRecord);
+            return Write(records);
+        }
+
+        const auto initiallyEmptyQueue = _storage.empty();
+        for (const auto wch : text)
+        {
+            _storage.push_back(makeRecord(wch));
+        }
+
+        if (initiallyEmptyQueue)
+        {
+            ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
+        }
+        WakeUpReadersWaitingForData();
+        return text.size();
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// - Coalesces input records and transfers them to storage queue.
 // Arguments:
-// - inRecords - The events to store.
+// - inRecords - The records to store.
 // - eventsWritten - The number of events written since this function
 // was called.
 // - setWaitEvent - on exit, true if buffer became non-empty.
@@ -694,78 +874,58 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw on failure
-void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
+void InputBuffer::_WriteBuffer(const std::span<const INPUT_RECORD>& inRecords,
                                _Out_ size_t& eventsWritten,
                                _Out_ bool& setWaitEvent)
 {
     eventsWritten = 0;
     setWaitEvent = false;
     const auto initiallyEmptyQueue = _storage.empty();
-    const auto initialInEventsSize = inEvents.size();
     const auto vtInputMode = IsInVirtualTerminalInputMode();
 
-    while (!inEvents.empty())
+    // we only check for possible coalescing when storing one
+    // record at a time because this is the original behavior of
+    // the input buffer. Changing this behavior may break stuff
+    // that was depending on it.
+    const auto tryCoalesce = [&](const INPUT_RECORD& inRecord) {
+        // this looks kinda weird but we don't want to coalesce a
+        // mouse event and then try to coalesce a key event right after.
+        return inRecords.size() == 1 && !_storage.empty() &&
+               (_CoalesceMouseMovedEvents(inRecord) || _CoalesceRepeatedKeyPressEvents(inRecord));
+    };
+
+    if (vtInputMode)
     {
-        // Pop the next event.
-        // If we're in vt mode, try and handle it with the vt input module.
-        // If it was handled, do nothing else for it.
-        // If there was one event passed in, try coalescing it with the previous event currently in the buffer.
-        // If it's not coalesced, append it to the buffer.
-        auto inEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (vtInputMode)
+        // If we're in vt mode, try and handle each record with the vt input module.
+        // If it was handled, do nothing else for it. TerminalInput still operates on IInputEvents.
+        for (const auto& inRecord : inRecords)
         {
             // GH#11682: TerminalInput::HandleKey can handle both KeyEvents and Focus events seamlessly
-            const auto handled = _termInput.HandleKey(inEvent.get());
-            if (handled)
-            {
-                eventsWritten++;
-                continue;
-            }
-        }
-
-        // we only check for possible coalescing when storing one
-        // record at a time because this is the original behavior of
-        // the input buffer. Changing this behavior may break stuff
-        // that was depending on it.
-        if (initialInEventsSize == 1 && !_storage.empty())
-        {
-            // coalescing requires a deque of events, so push it back onto the front.
-            inEvents.push_front(std::move(inEvent));
-
-            auto coalesced = false;
-            // this looks kinda weird but we don't want to coalesce a
-            // mouse event and then try to coalesce a key event right after.
-            //
-            // we also pass the whole deque to the coalescing methods
-            // even though they only want one event because it should
-            // be their responsibility to maintain the correct state
-            // of the deque if they process any records in it.
-            if (_CoalesceMouseMovedEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            else if (_CoalesceRepeatedKeyPressEvents(inEvents))
+            const auto inEvent = IInputEvent::Create(inRecord);
+            if (!_termInput.HandleKey(inEvent.get()))
             {
-                coalesced = true;
-            }
-            if (coalesced)
-            {
-                eventsWritten = 1;
-                return;
-            }
-            else
-            {
-                // We didn't coalesce the event. pull it from the queue again,
-                //  to keep the state consistent with the start of this block.
-                inEvent = std::move(inEvents.front());
-                inEvents.pop_front();
+                if (tryCoalesce(inRecord))
+                {
+                    eventsWritten = 1;
+                    return;
+                }
+                // At this point, the event was neither coalesced, nor processed by VT.
+                _storage.push_back(inRecord);
             }
+            ++eventsWritten;
         }
-        // At this point, the event was neither coalesced, nor processed by VT.
-        _storage.push_back(std::move(inEvent));
-        ++eventsWritten;
     }
+    else if (!inRecords.empty() && tryCoalesce(inRecords.front()))
+    {
+        eventsWritten = 1;
+        return;
+    }
+    else
+    {
+        _storage.append(inRecords);
+        eventsWritten = inRecords.size();
+    }
+
     if (initiallyEmptyQueue && !_storage.empty())
     {
         setWaitEvent = true;
@@ -773,67 +933,52 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
 }
 
 // Routine Description:
-// - Checks if the last saved event and the first event of inRecords are
-// both MOUSE_MOVED events. If they are, the last saved event is
-// updated with the new mouse position and the first event of inRecords is
-// dropped.
+// - Checks if the last saved event and inRecord are both MOUSE_MOVED events.
+// If they are, the last saved event is updated with the new mouse position.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord)
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::MouseEvent &&
-        pLastStoredEvent->EventType() == InputEventType::MouseEvent)
+    auto& lastRecord = _storage.back();
+    if (inRecord.EventType == MOUSE_EVENT &&
+        lastRecord.EventType == MOUSE_EVENT &&
+        inRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED &&
+        lastRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED)
     {
-        const auto pInMouseEvent = static_cast<const MouseEvent* const>(pFirstInEvent);
-        const auto pLastMouseEvent = static_cast<const MouseEvent* const>(pLastStoredEvent);
-
-        if (pInMouseEvent->IsMouseMoveEvent() &&
-            pLastMouseEvent->IsMouseMoveEvent())
-        {
-            // update mouse moved position
-            const auto pMouseEvent = static_cast<MouseEvent* const>(_storage.back().release());
-            pMouseEvent->SetPosition(pInMouseEvent->GetPosition());
-            std::unique_ptr<IInputEvent> tempPtr(pMouseEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
-            return true;
-        }
+        // update mouse moved position
+        lastRecord.Event.MouseEvent.dwMousePosition = inRecord.Event.MouseEvent.dwMousePosition;
+        return true;
     }
     return false;
 }
 
 // Routine Description:
-// - checks two KeyEvents to see if they're similar enough to be coalesced
+// - checks two key events to see if they're similar enough to be coalesced
 // Arguments:
-// - a - the first KeyEvent
-// - b - the other KeyEvent
+// - a - the first key event
+// - b - the other key event
 // Return Value:
 // - true if the events could be coalesced, false otherwise
-bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept
+bool InputBuffer::_CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept
 {
-    if (WI_IsFlagSet(a.GetActiveModifierKeys(), NLS_IME_CONVERSION) &&
-        a.GetCharData() == b.GetCharData() &&
-        a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    if (WI_IsFlagSet(a.dwControlKeyState, NLS_IME_CONVERSION) &&
+        a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+        a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
     // other key events check
-    else if (a.GetVirtualScanCode() == b.GetVirtualScanCode() &&
-             a.GetCharData() == b.GetCharData() &&
-             a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    else if (a.wVirtualScanCode == b.wVirtualScanCode &&
+             a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+             a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
@@ -841,44 +986,34 @@ bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexc
 }
 
 // Routine Description::
-// - If the last input event saved and the first input event in inRecords
-// are both a keypress down event for the same key, update the repeat
-// count of the saved event and drop the first from inRecords.
+// - If the last input event saved and inRecord are both a keypress down
+// event for the same key, update the repeat count of the saved event.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord)
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::KeyEvent &&
-        pLastStoredEvent->EventType() == InputEventType::KeyEvent)
-    {
-        const auto pInKeyEvent = static_cast<const KeyEvent* const>(pFirstInEvent);
-        const auto pLastKeyEvent = static_cast<const KeyEvent* const>(pLastStoredEvent);
-
-        if (pInKeyEvent->IsKeyDown() &&
-            pLastKeyEvent->IsKeyDown() &&
-            !IsGlyphFullWidth(pInKeyEvent->GetCharData()) &&
-            _CanCoalesce(*pInKeyEvent, *pLastKeyEvent))
+    auto& lastRecord = _storage.back();
+    if (inRecord.EventType == KEY_EVENT &&
+        lastRecord.EventType == KEY_EVENT)
+    {
+        const auto& inKey = inRecord.Event.KeyEvent;
+        auto& lastKey = lastRecord.Event.KeyEvent;
+
+        if (inKey.bKeyDown &&
+            lastKey.bKeyDown &&
+            !IsGlyphFullWidth(inKey.uChar.UnicodeChar) &&
+            _CanCoalesce(inKey, lastKey))
         {
             // increment repeat count
-            const auto pKeyEvent = static_cast<KeyEvent* const>(_storage.back().release());
-            WORD repeatCount = pKeyEvent->GetRepeatCount() + pInKeyEvent->GetRepeatCount();
-            pKeyEvent->SetRepeatCount(repeatCount);
-            std::unique_ptr<IInputEvent> tempPtr(pKeyEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
+            lastKey.wRepeatCount += inKey.wRepeatCount;
             return true;
         }
     }
@@ -888,42 +1023,64 @@ bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique
 // Routine Description:
 // - Handles records that suspend/resume the console.
 // Arguments:
-// - records - records to check for pause/unpause events
+// - inRecords - records to check for pause/unpause events
+// - buffer - storage for the filtered records, if any were consumed
 // Return Value:
-// - None
+// - inRecords if none of them were consumed, and otherwise a view of buffer holding the remaining ones.
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw exception on error
-void InputBuffer::_HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+std::span<const INPUT_RECORD> InputBuffer::_HandleConsoleSuspensionEvents(const std::span<const INPUT_RECORD>& inRecords, std::vector<INPUT_RECORD>& buffer)
 {
-    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-
-    std::deque<std::unique_ptr<IInputEvent>> outEvents;
-    while (!inEvents.empty())
+    for (size_t i = 0; i < inRecords.size(); ++i)
     {
-        auto currEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (currEvent->EventType() == InputEventType::KeyEvent)
+        if (_HandleConsoleSuspensionEvent(til::at(inRecords, i)))
         {
-            const auto pKeyEvent = static_cast<const KeyEvent* const>(currEvent.get());
-            if (pKeyEvent->IsKeyDown())
+            // Only copy the records if we actually have to drop one, which is rare.
+            buffer.assign(inRecords.begin(), inRecords.begin() + i);
+            for (++i; i < inRecords.size(); ++i)
             {
-                if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) &&
-                    !IsSystemKey(pKeyEvent->GetVirtualKeyCode()))
+                const auto& record = til::at(inRecords, i);
+                if (!_HandleConsoleSuspensionEvent(record))
                 {
-                    UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
-                    continue;
-                }
-                else if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && pKeyEvent->IsPauseKey())
-                {
-                    WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
-                    continue;
+                    buffer.emplace_back(record);
                 }
             }
+            return buffer;
         }
-        outEvents.push_back(std::move(currEvent));
     }
-    inEvents.swap(outEvents);
+    return inRecords;
+}
+
+// Routine Description:
+// - Handles a record that suspends/resumes the console.
+// Arguments:
+// - inRecord - record to check for a pause/unpause event
+// Return Value:
+// - true if the record was consumed and must not be stored.
+// Note:
+// - The console lock must be held when calling this routine.
+bool InputBuffer::_HandleConsoleSuspensionEvent(const INPUT_RECORD& inRecord)
+{
+    if (inRecord.EventType != KEY_EVENT || !inRecord.Event.KeyEvent.bKeyDown)
+    {
+        return false;
+    }
+
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto vkey = inRecord.Event.KeyEvent.wVirtualKeyCode;
+
+    if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) && !IsSystemKey(vkey))
+    {
+        UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
+        return true;
+    }
+    if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && vkey == VK_PAUSE)
+    {
+        WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
+        return true;
+    }
+    return false;
 }
 
 // Routine Description:
@@ -949,12 +1106,11 @@ void InputBuffer::_HandleTerminalInputCallback(std::deque<std::unique_ptr<IInput
     try
     {
         // add all input events to the storage queue
-        while (!inEvents.empty())
+        for (const auto& inEvent : inEvents)
         {
-            auto inEvent = std::move(inEvents.front());
-            inEvents.pop_front();
-            _storage.push_back(std::move(inEvent));
+            _storage.push_back(inEvent->ToInputRecord());
         }
+        inEvents.clear();
 
         if (!_vtInputShouldSuppress)
         {
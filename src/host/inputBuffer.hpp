@@ -77,9 +77,13 @@ public:
                                 const bool Stream);
 
     size_t Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    size_t Prepend(const std::span<const INPUT_RECORD>& inRecords);
 
     size_t Write(_Inout_ std::unique_ptr<IInputEvent> inEvent);
     size_t Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    size_t Write(const INPUT_RECORD& inRecord);
+    size_t Write(const std::span<const INPUT_RECORD>& inRecords);
+    size_t WritePassThroughString(const std::wstring_view& text);
 
     bool IsInVirtualTerminalInputMode() const;
     Microsoft::Console::VirtualTerminal::TerminalInput& GetTerminalInput();
@@ -87,6 +91,35 @@ public:
     void PassThroughWin32MouseRequest(bool enable);
 
 private:
+    // A FIFO of INPUT_RECORDs in a single contiguous allocation. Reading from the front only
+    // advances an offset and the consumed space is reclaimed once it makes up at least half of
+    // the buffer, which keeps push_back() amortized O(1) without ever wrapping around.
+    // Unlike a std::deque of IInputEvents this requires no allocation per event.
+    class RecordQueue
+    {
+    public:
+        bool empty() const noexcept { return _head == _records.size(); }
+        size_t size() const noexcept { return _records.size() - _head; }
+        INPUT_RECORD* begin() noexcept { return _records.data() + _head; }
+        INPUT_RECORD* end() noexcept { return _records.data() + _records.size(); }
+        INPUT_RECORD& front() noexcept { return til::at(_records, _head); }
+        INPUT_RECORD& back() noexcept { return _records.back(); }
+        INPUT_RECORD& operator[](size_t i) noexcept { return til::at(_records, _head + i); }
+
+        void push_back(const INPUT_RECORD& record);
+        void append(const std::span<const INPUT_RECORD>& records);
+        void pop_front(size_t count) noexcept;
+        void erase_from(const INPUT_RECORD* it) noexcept;
+        void clear() noexcept;
+        void swap(RecordQueue& other) noexcept;
+
+    private:
+        void _reclaim(size_t additional);
+
+        std::vector<INPUT_RECORD> _records;
+        size_t _head = 0;
+    };
+
     enum class ReadingMode : uint8_t
     {
         StringA,
@@ -102,7 +135,7 @@ private:
     std::deque<std::unique_ptr<IInputEvent>> _cachedInputEvents;
     ReadingMode _readingMode = ReadingMode::StringA;
 
-    std::deque<std::unique_ptr<IInputEvent>> _storage;
+    RecordQueue _storage;
     std::unique_ptr<IInputEvent> _writePartialByteSequence;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
     Microsoft::Console::Render::VtEngine* _pTtyConnection;
@@ -116,14 +149,15 @@ private:
     void _switchReadingMode(ReadingMode mode);
     void _switchReadingModeSlowPath(ReadingMode mode);
 
-    void _WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inRecords,
+    void _WriteBuffer(const std::span<const INPUT_RECORD>& inRecords,
                       _Out_ size_t& eventsWritten,
                       _Out_ bool& setWaitEvent);
 
-    bool _CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept;
-    bool _CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    bool _CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    void _HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    bool _CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept;
+    bool _CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord);
+    bool _CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord);
+    std::span<const INPUT_RECORD> _HandleConsoleSuspensionEvents(const std::span<const INPUT_RECORD>& inRecords, std::vector<INPUT_RECORD>& buffer);
+    bool _HandleConsoleSuspensionEvent(const INPUT_RECORD& inRecord);
 
     void _HandleTerminalInputCallback(_In_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
@@ -63,9 +63,11 @@ using namespace Microsoft::Console::Interactivity;
 // - screenInfo - reference to screen info
 // - source - rectangle in source buffer to copy
 // - targetOrigin - upper left coordinates of new location rectangle
+// - fill - the area that the caller fills after the copy
 static void _CopyRectangle(SCREEN_INFORMATION& screenInfo,
                            const Viewport& source,
-                           const til::point targetOrigin)
+                           const til::point targetOrigin,
+                           const Viewport& fill)
 {
     const auto sourceOrigin = source.Origin();
 
@@ -77,12 +79,15 @@ static void _CopyRectangle(SCREEN_INFORMATION& screenInfo,
 
     // 1. If we're copying entire rows of the buffer and moving them directly up or down,
     //    then we can send a rotate command to the underlying buffer to just adjust the
-    //    row locations instead of copying or moving anything.
+    //    row locations instead of copying or moving anything. The rows vacated by the
+    //    rotation end up with the contents of the overwritten ones, which is why they
+    //    must be part of the area that gets filled afterwards.
     {
         const auto bufferSize = screenInfo.GetBufferSize().Dimensions();
         const auto sourceFullRows = source.Width() == bufferSize.width;
         const auto verticalCopyOnly = source.Left() == 0 && targetOrigin.x == 0;
-        if (sourceFullRows && verticalCopyOnly)
+        const auto sourceFilled = fill.Width() == bufferSize.width && fill.Top() <= source.Top() && source.BottomInclusive() <= fill.BottomInclusive();
+        if (sourceFullRows && verticalCopyOnly && sourceFilled)
         {
             const auto delta = targetOrigin.y - source.Top();
 
@@ -432,7 +437,7 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
     if (target.IsValid())
     {
         // Perform the copy from the source to the target.
-        _CopyRectangle(screenInfo, source, target.Origin());
+        _CopyRectangle(screenInfo, source, target.Origin(), fill);
 
         // Notify the renderer and accessibility as to what moved and where.
         _ScrollScreen(screenInfo, source, fill, target);
@@ -33,6 +33,13 @@ ConhostInternalGetSet::ConhostInternalGetSet(_In_ IIoProvider& io) :
 // - <none>
 void ConhostInternalGetSet::ReturnResponse(const std::wstring_view response)
 {
+    // In passthrough mode the terminal has already responded to this query.
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (gci.IsInVtIoMode() && gci.GetVtIo()->IsUpdatingShadowBuffer())
+    {
+        return;
+    }
+
     std::deque<std::unique_ptr<IInputEvent>> inEvents;
 
     // generate a paired key down and key up event for every
@@ -290,7 +297,7 @@ void ConhostInternalGetSet::SetWorkingDirectory(const std::wstring_view /*uri*/)
 }
 
 // Routine Description:
-// - Plays a single MIDI note, blocking for the duration.
+// - Queues a single MIDI note, which is played after all previously queued ones.
 // Arguments:
 // - noteNumber - The MIDI note number to be played (0 - 127).
 // - velocity - The force with which the note should be played (0 - 127).
@@ -299,15 +306,10 @@ void ConhostInternalGetSet::SetWorkingDirectory(const std::wstring_view /*uri*/)
 // - true if successful. false otherwise.
 void ConhostInternalGetSet::PlayMidiNote(const int noteNumber, const int velocity, const std::chrono::microseconds duration)
 {
-    // Unlock the console, so the UI doesn't hang while we're busy.
-    UnlockConsole();
-
-    // This call will block for the duration, unless shutdown early.
+    // This call returns immediately. The note is played on MidiAudio's own thread.
     const auto windowHandle = ServiceLocator::LocateConsoleWindow()->GetWindowHandle();
     auto& midiAudio = ServiceLocator::LocateGlobals().getConsoleInformation().GetMidiAudio();
     midiAudio.PlayNote(windowHandle, noteNumber, velocity, std::chrono::duration_cast<std::chrono::milliseconds>(duration));
-
-    LockConsole();
 }
 
 // Routine Description:
@@ -578,6 +578,8 @@ bool COOKED_READ_DATA::ProcessInput(const wchar_t wchOrig,
     else
     {
         auto CallWrite = true;
+        // The index of the first character that changed. Everything in front of it stays on screen as is.
+        size_t editIndex = 0;
         const auto sScreenBufferSizeX = _screenInfo.GetBufferSize().Width();
 
         // processing in the middle of the line is more complex:
@@ -643,6 +645,8 @@ bool COOKED_READ_DATA::ProcessInput(const wchar_t wchOrig,
                         loop = true;
                     }
                 }
+
+                editIndex = _currentPosition;
             }
             else
             {
@@ -684,6 +688,7 @@ bool COOKED_READ_DATA::ProcessInput(const wchar_t wchOrig,
                             _bytesRead - (_currentPosition * sizeof(WCHAR)));
                     _bytesRead += sizeof(WCHAR);
                 }
+                editIndex = _currentPosition;
                 *_bufPtr = wch;
                 _bufPtr += 1;
                 _currentPosition += 1;
@@ -708,29 +713,34 @@ bool COOKED_READ_DATA::ProcessInput(const wchar_t wchOrig,
             CursorPosition = _screenInfo.GetTextBuffer().GetCursor().GetPosition();
             CursorPosition.x = (til::CoordType)(CursorPosition.x + NumSpaces);
 
-            // clear the current command line from the screen
-            // clang-format off
-#pragma prefast(suppress: __WARNING_BUFFER_OVERFLOW, "Not sure why prefast doesn't like this call.")
-            // clang-format on
-            DeleteCommandLine(*this, FALSE);
-
-            // write the new command line to the screen
-            NumToWrite = _bytesRead;
-
-            DWORD dwFlags = WC_DESTRUCTIVE_BACKSPACE | WC_PRINTABLE_CONTROL_CHARS;
             if (wch == UNICODE_CARRIAGERETURN)
             {
-                dwFlags |= WC_KEEP_CURSOR_VISIBLE;
+                // clear the current command line from the screen
+                // clang-format off
+#pragma prefast(suppress: __WARNING_BUFFER_OVERFLOW, "Not sure why prefast doesn't like this call.")
+                // clang-format on
+                DeleteCommandLine(*this, FALSE);
+
+                // write the new command line to the screen
+                NumToWrite = _bytesRead;
+                status = WriteCharsLegacy(_screenInfo,
+                                          _backupLimit,
+                                          _backupLimit,
+                                          _backupLimit,
+                                          &NumToWrite,
+                                          &_visibleCharCount,
+                                          _originalCursorPosition.x,
+                                          WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
+                                          &ScrollY);
+            }
+            else
+            {
+                // Only the text from the edit on has moved, so only that part of the line is rewritten.
+                status = RedrawCommandLineFrom(*this,
+                                               editIndex,
+                                               WC_DESTRUCTIVE_BACKSPACE | WC_PRINTABLE_CONTROL_CHARS,
+                                               &ScrollY);
             }
-            status = WriteCharsLegacy(_screenInfo,
-                                      _backupLimit,
-                                      _backupLimit,
-                                      _backupLimit,
-                                      &NumToWrite,
-                                      &_visibleCharCount,
-                                      _originalCursorPosition.x,
-                                      dwFlags,
-                                      &ScrollY);
             if (FAILED_NTSTATUS(status))
             {
                 RIPMSG1(RIP_WARNING, "WriteCharsLegacy failed 0x%x", status);
@@ -79,6 +79,13 @@ std::vector<Viewport> RenderData::GetSelectionRects() noexcept
     return result;
 }
 
+// Method Description:
+// - The console's selection is limited to the viewport, which makes this identical to GetSelectionRects().
+std::vector<Viewport> RenderData::GetVisibleSelectionRects() noexcept
+{
+    return GetSelectionRects();
+}
+
 // Method Description:
 // - Lock the console for reading the contents of the buffer. Ensures that the
 //      contents of the console won't be changed in the middle of a paint
@@ -97,6 +104,21 @@ void RenderData::UnlockConsole() noexcept
     ::UnlockConsole();
 }
 
+// Method Description:
+// - Same as RenderData::LockConsole, but API calls that only read
+//      console state may hold the lock at the same time.
+void RenderData::LockConsoleShared() noexcept
+{
+    ::LockConsoleShared();
+}
+
+// Method Description:
+// - Unlocks the console after a call to RenderData::LockConsoleShared.
+void RenderData::UnlockConsoleShared() noexcept
+{
+    ::UnlockConsoleShared();
+}
+
 // Method Description:
 // - Gets the cursor's position in the buffer, relative to the buffer origin.
 // Arguments:
@@ -318,6 +340,13 @@ const std::vector<size_t> RenderData::GetPatternId(const til::point /*location*/
     return {};
 }
 
+// Method Description:
+// - The console's find dialog selects its matches one by one and doesn't highlight the others.
+std::span<const til::point_span> RenderData::GetSearchHighlights() const noexcept
+{
+    return {};
+}
+
 // Routine Description:
 // - Converts a text attribute into the RGB values that should be presented, applying
 //   relevant table translation information and preferences.
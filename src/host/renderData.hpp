@@ -26,9 +26,12 @@ public:
     const FontInfo& GetFontInfo() const noexcept override;
 
     std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetVisibleSelectionRects() noexcept override;
 
     void LockConsole() noexcept override;
     void UnlockConsole() noexcept override;
+    void LockConsoleShared() noexcept override;
+    void UnlockConsoleShared() noexcept override;
 
     til::point GetCursorPosition() const noexcept override;
     bool IsCursorVisible() const noexcept override;
@@ -48,6 +51,7 @@ public:
     const std::wstring GetHyperlinkCustomId(uint16_t id) const override;
 
     const std::vector<size_t> GetPatternId(const til::point location) const override;
+    std::span<const til::point_span> GetSearchHighlights() const noexcept override;
 
     std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept override;
     const bool IsSelectionActive() const override;
@@ -619,13 +619,8 @@ void SCREEN_INFORMATION::NotifyAccessibilityEventing(const til::CoordType sStart
             _pAccessibilityNotifier->NotifyConsoleUpdateRegionEvent(MAKELONG(sStartX, sStartY),
                                                                     MAKELONG(sEndX, sEndY));
         }
-        auto pConsoleWindow = ServiceLocator::LocateConsoleWindow();
-        if (pConsoleWindow)
-        {
-            LOG_IF_FAILED(pConsoleWindow->SignalUia(UIA_Text_TextChangedEventId));
-            // TODO MSFT 7960168 do we really need this event to not signal?
-            //pConsoleWindow->SignalUia(UIA_LayoutInvalidatedEventId);
-        }
+        // The notifier batches these updates and raises UIA_Text_TextChangedEventId alongside them.
+        // TODO MSFT 7960168 do we really need UIA_LayoutInvalidatedEventId to not signal?
     }
 }
 
@@ -1453,6 +1448,7 @@ bool SCREEN_INFORMATION::IsMaximizedY() const
 
     // skip any drawing updates that might occur until we swap _textBuffer with the new buffer or we exit early.
     newTextBuffer->GetCursor().StartDeferDrawing();
+    newTextBuffer->SetRecyclable(_IsAltBuffer());
     _textBuffer->GetCursor().StartDeferDrawing();
     // we're capturing _textBuffer by reference here because when we exit, we want to EndDefer on the current active buffer.
     auto endDefer = wil::scope_exit([&]() noexcept { _textBuffer->GetCursor().EndDeferDrawing(); });
@@ -1880,6 +1876,9 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
         altCursor.SetPosition(altCursorPos);
         // The alt buffer's output mode should match the main buffer.
         createdBuffer->OutputMode = OutputMode;
+        // Applications like pagers enter and leave the alt buffer all the time.
+        // This allows the next alt buffer to reuse the memory of this one.
+        createdBuffer->GetTextBuffer().SetRecyclable(true);
 
         s_InsertScreenBuffer(createdBuffer);
 
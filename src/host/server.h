@@ -107,6 +107,8 @@ public:
 
     void LockConsole() noexcept;
     void UnlockConsole() noexcept;
+    void LockConsoleShared() noexcept;
+    void UnlockConsoleShared() noexcept;
     bool IsConsoleLocked() const noexcept;
     ULONG GetCSRecursionCount() const noexcept;
 
@@ -53,7 +53,12 @@ Settings::Settings() :
     _fUseWindowSizePixels(false),
     // window size pixels initialized below
     _fInterceptCopyPaste(0),
+#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
+    // Windows fall back to GDI if the AtlasEngine fails, see Window::_FallbackToGdiEngine().
+    _fUseDx(UseDx::AtlasEngine),
+#else
     _fUseDx(UseDx::Disabled),
+#endif
     _fCopyColor(false)
 {
     _dwScreenBufferSize.X = 80;
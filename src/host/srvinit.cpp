@@ -13,6 +13,7 @@
 #include "ApiRoutines.h"
 
 #include "../types/inc/GlyphWidth.hpp"
+#include "../types/inc/PerformanceRegion.hpp"
 
 #include "../server/DeviceHandle.h"
 #include "../server/Entrypoints.h"
@@ -62,30 +63,36 @@ try
 
     FontInfoBase::s_SetFontDefaultList(Globals.pFontDefaultList);
 
-    // Check if this conhost is allowed to delegate its activities to another.
-    // If so, look up the registered default console handler.
-    if (Globals.delegationPair.IsUndecided() && Microsoft::Console::Internal::DefaultApp::CheckDefaultAppPolicy())
+    // PTY sessions never hand off (see _shouldAttemptHandoff), so they can skip
+    // the policy checks and the registry lookups that come with them.
+    // Every new tab in a terminal pays for those otherwise.
+    if (!args->IsHeadless())
     {
-        Globals.delegationPair = DelegationConfig::s_GetDelegationPair();
-
-        TraceLoggingWrite(g_hConhostV2EventTraceProvider,
-                          "SrvInit_FoundDelegationConsole",
-                          TraceLoggingGuid(Globals.delegationPair.console, "ConsoleClsid"),
-                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
-        TraceLoggingWrite(g_hConhostV2EventTraceProvider,
-                          "SrvInit_FoundDelegationTerminal",
-                          TraceLoggingGuid(Globals.delegationPair.terminal, "TerminalClsid"),
-                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
-    }
-    // If we looked up the registered defterm pair, and it was left as the default (missing or {0}),
-    // AND velocity is enabled for DxD, then we switch the delegation pair to Terminal and
-    // mark that we should check that class for the marker interface later.
-    if (Globals.delegationPair.IsDefault() && Microsoft::Console::Internal::DefaultApp::CheckShouldTerminalBeDefault())
-    {
-        Globals.delegationPair = DelegationConfig::TerminalDelegationPair;
-        Globals.defaultTerminalMarkerCheckRequired = true;
+        // Check if this conhost is allowed to delegate its activities to another.
+        // If so, look up the registered default console handler.
+        if (Globals.delegationPair.IsUndecided() && Microsoft::Console::Internal::DefaultApp::CheckDefaultAppPolicy())
+        {
+            Globals.delegationPair = DelegationConfig::s_GetDelegationPair();
+
+            TraceLoggingWrite(g_hConhostV2EventTraceProvider,
+                              "SrvInit_FoundDelegationConsole",
+                              TraceLoggingGuid(Globals.delegationPair.console, "ConsoleClsid"),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+            TraceLoggingWrite(g_hConhostV2EventTraceProvider,
+                              "SrvInit_FoundDelegationTerminal",
+                              TraceLoggingGuid(Globals.delegationPair.terminal, "TerminalClsid"),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+        }
+        // If we looked up the registered defterm pair, and it was left as the default (missing or {0}),
+        // AND velocity is enabled for DxD, then we switch the delegation pair to Terminal and
+        // mark that we should check that class for the marker interface later.
+        if (Globals.delegationPair.IsDefault() && Microsoft::Console::Internal::DefaultApp::CheckShouldTerminalBeDefault())
+        {
+            Globals.delegationPair = DelegationConfig::TerminalDelegationPair;
+            Globals.defaultTerminalMarkerCheckRequired = true;
+        }
     }
 
     // Create the accessibility notifier early in the startup process.
@@ -891,6 +898,18 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
         //      should we be unable to figure out its width another way.
         auto pfn = std::bind(&Renderer::IsGlyphWideByFont, static_cast<Renderer*>(g.pRender), std::placeholders::_1);
         SetGlyphWidthFallback(pfn);
+
+        // Asking the renderer while writing text stalls the client on the render engine.
+        // Instead, the renderer measures ambiguous glyphs before its next frame, and
+        // we fix up the rows written in the meantime if they turned out to be wide.
+        SetGlyphWidthFallbackDeferred([generation = ROW::GetLatestGeneration()](const std::span<const char32_t> wide) mutable {
+            const auto next = ROW::GetLatestGeneration();
+            for (auto screenInfo = ServiceLocator::LocateGlobals().getConsoleInformation().ScreenBuffers; screenInfo; screenInfo = screenInfo->Next)
+            {
+                screenInfo->GetTextBuffer().RemeasureGlyphs(wide, generation);
+            }
+            generation = next;
+        });
     }
     catch (...)
     {
@@ -1055,6 +1074,8 @@ DWORD WINAPI ConsoleIoThread(LPVOID lpParameter)
             continue;
         }
         ReceiveMsg._pApiRoutines = globals.api;
+
+        const Microsoft::Console::Types::PerformanceRegion region{ "ConsoleIoThread_Dispatch" };
         IoSorter::ServiceIoOperation(&ReceiveMsg, &ReplyMsg);
     }
 
@@ -365,6 +365,31 @@ class AliasTests
         VERIFY_ARE_EQUAL(dwLinesBefore, dwLines, L"Line count should pass through.");
     }
 
+    TEST_METHOD(TestMatchAndCopyAfterRedefinition)
+    {
+        std::wstring exe(L"exe.exe");
+        std::wstring source(L"Source");
+        size_t lineCount = 0;
+
+        std::wstring target(L"first $1$Tsecond $*");
+        Alias::s_TestAddAlias(exe, source, target);
+        auto result = Alias::s_MatchAndCopyAlias(L"Source a b", exe, lineCount);
+        VERIFY_ARE_EQUAL(String(L"first a\r\nsecond a b\r\n"), String(result.c_str()));
+        VERIFY_ARE_EQUAL(2u, lineCount);
+
+        Log::Comment(L"Expanding the same alias again should give the same result.");
+        result = Alias::s_MatchAndCopyAlias(L"Source c", exe, lineCount);
+        VERIFY_ARE_EQUAL(String(L"first c\r\nsecond c\r\n"), String(result.c_str()));
+        VERIFY_ARE_EQUAL(2u, lineCount);
+
+        Log::Comment(L"Redefining the alias must not reuse the previous target.");
+        target = L"third $2 $g $x$";
+        Alias::s_TestAddAlias(exe, source, target);
+        result = Alias::s_MatchAndCopyAlias(L"Source a b", exe, lineCount);
+        VERIFY_ARE_EQUAL(String(L"third b > $x$\r\n"), String(result.c_str()));
+        VERIFY_ARE_EQUAL(1u, lineCount);
+    }
+
     TEST_METHOD(TrimTrailing)
     {
         BEGIN_TEST_METHOD_PROPERTIES()
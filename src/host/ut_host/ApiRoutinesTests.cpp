@@ -866,4 +866,35 @@ class ApiRoutinesTests
 
         ValidateComplexScreen(si, background, fill, scrollRect, Viewport::FromInclusive(scroll), destination, clipViewport);
     }
+
+    TEST_METHOD(ApiGetConsoleOutputChanges)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& si = gci.GetActiveOutputBuffer();
+
+        VERIFY_SUCCEEDED(si.GetTextBuffer().ResizeTraditional({ 5, 5 }), L"Make the buffer small so this doesn't take forever.");
+        const auto bufferSize = si.GetBufferSize();
+
+        std::vector<Viewport> changed;
+        uint64_t sequence = 0;
+
+        Log::Comment(L"Without a previous sequence number the entire buffer is returned.");
+        VERIFY_SUCCEEDED(_pApiRoutines->GetConsoleOutputChangesImpl(si, 0, changed, sequence));
+        VERIFY_ARE_EQUAL(1u, changed.size());
+        VERIFY_ARE_EQUAL(bufferSize.ToExclusive(), changed.front().ToExclusive());
+
+        Log::Comment(L"Nothing changed since the last call.");
+        VERIFY_SUCCEEDED(_pApiRoutines->GetConsoleOutputChangesImpl(si, sequence, changed, sequence));
+        VERIFY_ARE_EQUAL(0u, changed.size());
+
+        Log::Comment(L"Rows 1, 2 and 4 changed, which results in 2 rectangles.");
+        CHAR_INFO ci{ L'A', FOREGROUND_RED };
+        si.GetActiveBuffer().Write(OutputCellIterator(ci, 1), { 3, 1 });
+        si.GetActiveBuffer().Write(OutputCellIterator(ci, 1), { 0, 2 });
+        si.GetActiveBuffer().Write(OutputCellIterator(ci, 1), { 2, 4 });
+        VERIFY_SUCCEEDED(_pApiRoutines->GetConsoleOutputChangesImpl(si, sequence, changed, sequence));
+        VERIFY_ARE_EQUAL(2u, changed.size());
+        VERIFY_ARE_EQUAL((til::rect{ 0, 1, 5, 3 }), changed.at(0).ToExclusive());
+        VERIFY_ARE_EQUAL((til::rect{ 0, 4, 5, 5 }), changed.at(1).ToExclusive());
+    }
 };
@@ -335,4 +335,28 @@ class ClipboardTests
             VERIFY_ARE_EQUAL(expectedEvents[i], currentKeyEvent, NoThrowString().Format(L"i == %d", i));
         }
     }
+
+    TEST_METHOD(LargeTextIsConvertedInChunks)
+    {
+        // Each of these characters results in a key down and up event. The first chunk of 4096
+        // records thus ends right after the carriage return and the linefeed that follows it in
+        // the next chunk must still be filtered out.
+        std::wstring wstr(2047, L'a');
+        wstr.append(L"\r\n");
+        wstr.append(10, L'b');
+
+        std::vector<std::vector<INPUT_RECORD>> chunks;
+        Clipboard::Instance().TextToInputRecords(wstr.c_str(), wstr.size(), false, [&](const std::span<const INPUT_RECORD> records) {
+            chunks.emplace_back(records.begin(), records.end());
+        });
+
+        VERIFY_ARE_EQUAL(2u, chunks.size());
+        VERIFY_ARE_EQUAL(4096u, chunks[0].size());
+        VERIFY_ARE_EQUAL(20u, chunks[1].size());
+        VERIFY_ARE_EQUAL(L'\r', chunks[0].back().Event.KeyEvent.uChar.UnicodeChar);
+        for (const auto& record : chunks[1])
+        {
+            VERIFY_ARE_EQUAL(L'b', record.Event.KeyEvent.uChar.UnicodeChar);
+        }
+    }
 };
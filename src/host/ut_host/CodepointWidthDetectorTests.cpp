@@ -19,13 +19,21 @@ static const std::vector<std::tuple<unsigned int, std::wstring, CodepointWidth>>
     { 0x7, L"\a", CodepointWidth::Narrow }, // BEL
     { 0x20, L" ", CodepointWidth::Narrow },
     { 0x39, L"9", CodepointWidth::Narrow },
+    { 0xA1, L"\xA1", CodepointWidth::Narrow }, // U+00A1 inverted exclamation mark (ambiguous)
     { 0x414, L"\x414", CodepointWidth::Narrow }, // U+0414 cyrillic capital de
+    { 0x10FF, L"\x10FF", CodepointWidth::Narrow }, // U+10FF georgian letter labial sign
+    { 0x1100, L"\x1100", CodepointWidth::Wide }, // U+1100 hangul choseong kiyeok
     { 0x1104, L"\x1104", CodepointWidth::Wide }, // U+1104 hangul choseong ssangtikeut
+    { 0x1160, L"\x1160", CodepointWidth::Narrow }, // U+1160 hangul jungseong filler
     { 0x306A, L"\x306A", CodepointWidth::Wide }, // U+306A hiragana na
     { 0x30CA, L"\x30CA", CodepointWidth::Wide }, // U+30CA katakana na
     { 0x72D7, L"\x72D7", CodepointWidth::Wide }, // U+72D7
     { 0x1F47E, L"\xD83D\xDC7E", CodepointWidth::Wide }, // U+1F47E alien monster
-    { 0x1F51C, L"\xD83D\xDD1C", CodepointWidth::Wide } // U+1F51C SOON
+    { 0x1F51C, L"\xD83D\xDD1C", CodepointWidth::Wide }, // U+1F51C SOON
+    { 0x2FFFD, L"\xD87F\xDFFD", CodepointWidth::Wide }, // U+2FFFD last codepoint of plane 2
+    { 0x2FFFE, L"\xD87F\xDFFE", CodepointWidth::Narrow }, // U+2FFFE noncharacter
+    { 0x10FFFD, L"\xDBFF\xDFFD", CodepointWidth::Narrow }, // U+10FFFD private use (ambiguous)
+    { 0x10FFFF, L"\xDBFF\xDFFF", CodepointWidth::Narrow } // U+10FFFF noncharacter
 };
 
 class CodepointWidthDetectorTests
@@ -69,21 +77,76 @@ class CodepointWidthDetectorTests
         widthDetector.SetFallbackMethod(std::bind(&FallbackMethod, std::placeholders::_1));
 
         // Ensure fallback cache is empty.
-        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.lock_shared()->size());
 
         // Lookup ambiguous width character.
         widthDetector.IsWide(ambiguous);
 
         // Cache should hold it.
-        VERIFY_ARE_EQUAL(1u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(1u, widthDetector._fallbackCache.lock_shared()->size());
 
         // Cached item should match what we expect
-        const auto it = widthDetector._fallbackCache.begin();
-        VERIFY_ARE_EQUAL(ambiguous[0], it->first);
-        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous) ? 2u : 1u, it->second);
+        {
+            const auto cache = widthDetector._fallbackCache.lock_shared();
+            const auto it = cache->begin();
+            VERIFY_ARE_EQUAL(ambiguous[0], it->first);
+            VERIFY_ARE_EQUAL(FallbackMethod(ambiguous) ? 2u : 1u, it->second);
+        }
 
         // Cache should empty when font changes.
         widthDetector.NotifyFontChanged();
-        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.lock_shared()->size());
+    }
+
+    TEST_METHOD(AmbiguousCacheQueriesFallbackOncePerFont)
+    {
+        CodepointWidthDetector widthDetector;
+        auto calls = 0;
+        widthDetector.SetFallbackMethod([&](const std::wstring_view&) {
+            ++calls;
+            return true;
+        });
+
+        VERIFY_IS_TRUE(widthDetector.IsWide(ambiguous));
+        VERIFY_IS_TRUE(widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(1, calls);
+
+        // After a font change the glyph needs to be measured again.
+        widthDetector.NotifyFontChanged();
+        VERIFY_IS_TRUE(widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(2, calls);
+    }
+
+    TEST_METHOD(DeferredFallbackResolvesLater)
+    {
+        CodepointWidthDetector widthDetector;
+        auto calls = 0;
+        std::vector<char32_t> resolved;
+        widthDetector.SetFallbackMethod([&](const std::wstring_view& glyph) {
+            ++calls;
+            return glyph == emoji || glyph == ambiguous;
+        });
+        widthDetector.SetFallbackDeferred([&](const std::span<const char32_t> wide) {
+            resolved.assign(wide.begin(), wide.end());
+        });
+
+        // The fallback isn't called while measuring. The glyph is narrow until it's resolved.
+        VERIFY_IS_FALSE(widthDetector.IsWide(ambiguous));
+        VERIFY_IS_FALSE(widthDetector.IsWide(ambiguous));
+        VERIFY_IS_FALSE(widthDetector.IsWide(L"\xA1"));
+        VERIFY_ARE_EQUAL(0, calls);
+        VERIFY_IS_TRUE(widthDetector.HasDeferredFallbacks());
+
+        // Each glyph is measured once and only the wide ones are reported.
+        widthDetector.ResolveDeferredFallbacks();
+        VERIFY_ARE_EQUAL(2, calls);
+        VERIFY_IS_FALSE(widthDetector.HasDeferredFallbacks());
+        VERIFY_ARE_EQUAL(1u, resolved.size());
+        VERIFY_ARE_EQUAL(static_cast<char32_t>(ambiguous[0]), resolved[0]);
+
+        // From now on the cached width is used.
+        VERIFY_IS_TRUE(widthDetector.IsWide(ambiguous));
+        VERIFY_IS_FALSE(widthDetector.HasDeferredFallbacks());
+        VERIFY_ARE_EQUAL(2, calls);
     }
 };
@@ -242,6 +242,41 @@ class HistoryTests
         VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
     }
 
+    TEST_METHOD(AddNoDuplicatesAfterModifications)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+
+        Log::Comment(L"Overfill the history, which evicts the oldest items.");
+        for (const auto& item : _manyHistoryItems)
+        {
+            VERIFY_SUCCEEDED(history->Add(item, true));
+        }
+        VERIFY_ARE_EQUAL(s_BufferSize, history->GetNumberOfCommands());
+
+        Log::Comment(L"Evicted items aren't duplicates anymore and get added again.");
+        VERIFY_SUCCEEDED(history->Add(_manyHistoryItems[0], true));
+        VERIFY_ARE_EQUAL(String(_manyHistoryItems[0].data()), String(history->GetNth(s_BufferSize - 1).data()));
+
+        Log::Comment(L"Items that are still present are moved to the end instead.");
+        const auto& present = _manyHistoryItems[5];
+        VERIFY_SUCCEEDED(history->Add(present, true));
+        VERIFY_ARE_EQUAL(s_BufferSize, history->GetNumberOfCommands());
+        VERIFY_ARE_EQUAL(String(present.data()), String(history->GetNth(s_BufferSize - 1).data()));
+        for (SHORT i = 0; i < (SHORT)s_BufferSize - 1; i++)
+        {
+            VERIFY_ARE_NOT_EQUAL(String(present.data()), String(history->GetNth(i).data()));
+        }
+
+        Log::Comment(L"Items trimmed by Realloc or Empty aren't duplicates either.");
+        history->Realloc(2);
+        VERIFY_SUCCEEDED(history->Add(present, true));
+        VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
+        history->Empty();
+        VERIFY_SUCCEEDED(history->Add(present, true));
+        VERIFY_ARE_EQUAL(1ul, history->GetNumberOfCommands());
+    }
+
 private:
     const std::array<std::wstring, 5> _manyApps = {
         L"foo.exe",
@@ -70,6 +70,48 @@ class InputBufferTests
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 2u);
     }
 
+    TEST_METHOD(InterleavedReadsAndWritesPreserveOrder)
+    {
+        InputBuffer inputBuffer;
+        std::vector<INPUT_RECORD> records;
+        for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
+        {
+            records.push_back(MakeKeyEvent(true, 1, static_cast<WORD>(L'a' + i), 0, static_cast<wchar_t>(L'a' + i), 0));
+        }
+
+        // Writing in bulk doesn't coalesce, and reading the first half and writing
+        // again forces the storage to move the unread records to the front.
+        VERIFY_ARE_EQUAL(inputBuffer.Write(records), RECORD_INSERT_COUNT);
+        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+        VERIFY_NT_SUCCESS(inputBuffer.Read(outEvents, RECORD_INSERT_COUNT / 2, false, false, true, false));
+        VERIFY_ARE_EQUAL(inputBuffer.Write(records), RECORD_INSERT_COUNT);
+
+        const auto remaining = RECORD_INSERT_COUNT - RECORD_INSERT_COUNT / 2;
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), remaining + RECORD_INSERT_COUNT);
+        for (size_t i = 0; i < remaining; ++i)
+        {
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], records[RECORD_INSERT_COUNT / 2 + i]);
+        }
+        for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
+        {
+            VERIFY_ARE_EQUAL(inputBuffer._storage[remaining + i], records[i]);
+        }
+    }
+
+    TEST_METHOD(PassThroughStringIsStoredAsKeyDownRecords)
+    {
+        InputBuffer inputBuffer;
+        WI_SetFlag(inputBuffer.InputMode, ENABLE_VIRTUAL_TERMINAL_INPUT);
+
+        const std::wstring_view text{ L"\x1b[200~ab\x1b[201~" };
+        VERIFY_ARE_EQUAL(inputBuffer.WritePassThroughString(text), text.size());
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], MakeKeyEvent(true, 1, 0, 0, text[i], 0));
+        }
+    }
+
     TEST_METHOD(CanInsertIntoInputBufferIndividually)
     {
         InputBuffer inputBuffer;
@@ -78,7 +120,7 @@ class InputBufferTests
             INPUT_RECORD record;
             record.EventType = MENU_EVENT;
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back()->ToInputRecord());
+            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back());
         }
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT);
     }
@@ -98,7 +140,7 @@ class InputBufferTests
         // verify that the events are the same in storage
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i]->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], record);
         }
     }
 
@@ -121,10 +163,9 @@ class InputBufferTests
         // check that they coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 1u);
         // check that the mouse position is being updated correctly
-        const IInputEvent* const pOutEvent = inputBuffer._storage.front().get();
-        const auto pMouseEvent = static_cast<const MouseEvent* const>(pOutEvent);
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().x, static_cast<SHORT>(RECORD_INSERT_COUNT));
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
+        const auto& outRecord = inputBuffer._storage.front();
+        VERIFY_ARE_EQUAL(outRecord.Event.MouseEvent.dwMousePosition.X, static_cast<SHORT>(RECORD_INSERT_COUNT));
+        VERIFY_ARE_EQUAL(outRecord.Event.MouseEvent.dwMousePosition.Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
 
         // add a key event and another mouse event to make sure that
         // an event between two mouse events stopped the coalescing.
@@ -162,10 +203,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), mouseRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), mouseRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), mouseRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], mouseRecords[i]);
         }
     }
 
@@ -221,10 +262,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), keyRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), keyRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), keyRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], keyRecords[i]);
         }
     }
 
@@ -239,7 +280,7 @@ class InputBufferTests
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(inputBuffer._storage.back()->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage.back(), record);
         }
 
         // The events shouldn't be coalesced
@@ -597,22 +638,17 @@ class InputBufferTests
     {
         InputBuffer inputBuffer;
         auto record = MakeKeyEvent(true, 1, L'a', 0, L'a', 0);
-        auto inputEvent = IInputEvent::Create(record);
         size_t eventsWritten;
         auto waitEvent = false;
         inputBuffer.Flush();
         // write one event to an empty buffer
-        std::deque<std::unique_ptr<IInputEvent>> storage;
-        storage.push_back(std::move(inputEvent));
-        inputBuffer._WriteBuffer(storage, eventsWritten, waitEvent);
+        inputBuffer._WriteBuffer({ &record, 1 }, eventsWritten, waitEvent);
         VERIFY_IS_TRUE(waitEvent);
         // write another, it shouldn't signal this time
         auto record2 = MakeKeyEvent(true, 1, L'b', 0, L'b', 0);
-        auto inputEvent2 = IInputEvent::Create(record2);
         // write another event to a non-empty buffer
         waitEvent = false;
-        storage.push_back(std::move(inputEvent2));
-        inputBuffer._WriteBuffer(storage, eventsWritten, waitEvent);
+        inputBuffer._WriteBuffer({ &record2, 1 }, eventsWritten, waitEvent);
 
         VERIFY_IS_FALSE(waitEvent);
     }
@@ -633,7 +669,7 @@ class InputBufferTests
                                            true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount - 1);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount - 1);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 
@@ -653,7 +689,7 @@ class InputBufferTests
                                            true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 };
@@ -158,4 +158,32 @@ class SearchTests
         Search s(gci.renderData, L"\x304b", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
         DoFoundChecks(s, coordStartExpected, -1);
     }
+
+    TEST_METHOD(ForwardInSlices)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto endRow = gci.renderData.GetTextBufferEndPosition().y;
+
+        // Searching one row at a time must find the same matches as searching everything at once.
+        std::vector<til::point_span> matches;
+        til::CoordType row = 0;
+        while (row <= endRow)
+        {
+            const auto next = Search::s_FindMatchesInRows(gci.renderData, L"AB", Search::Sensitivity::CaseSensitive, Search::Syntax::Literal, row, row + 1, matches);
+            VERIFY_IS_GREATER_THAN(next, row);
+            row = next;
+        }
+
+        const Search expected(gci.renderData, L"AB", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+        VERIFY_ARE_EQUAL(expected.GetMatches().size(), matches.size());
+        for (size_t i = 0; i < matches.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected.GetMatches()[i].start, matches[i].start);
+            VERIFY_ARE_EQUAL(expected.GetMatches()[i].end, matches[i].end);
+        }
+
+        til::point coordStartExpected;
+        Search s(gci.renderData, std::move(matches), Search::Direction::Forward);
+        DoFoundChecks(s, coordStartExpected, 1);
+    }
 };
@@ -12,6 +12,7 @@
 
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
+#include "../buffer/out/BufferSnapshot.hpp"
 
 #include "input.h"
 #include "_stream.h"
@@ -141,6 +142,9 @@ class TextBufferTests
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
+    TEST_METHOD(ScrollRowsRotatesRegion);
+    TEST_METHOD(GetChangedRowsSince);
+    TEST_METHOD(RecycledArenaIsReset);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
@@ -148,19 +152,37 @@ class TextBufferTests
     TEST_METHOD(TestBurrito);
     TEST_METHOD(TestOverwriteChars);
     TEST_METHOD(TestRowReplaceText);
+    TEST_METHOD(TestRowCopyFromWide);
 
     TEST_METHOD(TestAppendRTFText);
 
     void WriteLinesToBuffer(const std::vector<std::wstring>& text, TextBuffer& buffer);
     TEST_METHOD(GetWordBoundaries);
+    TEST_METHOD(GetWordBoundariesWithWideGlyphs);
     TEST_METHOD(MoveByWord);
+    TEST_METHOD(MoveByWordAfterRowChanged);
     TEST_METHOD(GetGlyphBoundaries);
 
     TEST_METHOD(GetTextRects);
     TEST_METHOD(GetText);
+    TEST_METHOD(GetTextColorRuns);
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
+    TEST_METHOD(HyperlinkIdReuse);
+
+    TEST_METHOD(UrlPatternsMatchRegex);
+    TEST_METHOD(GetUrlAt);
+    TEST_METHOD(FillTextAndAttributesMatchWrite);
+    TEST_METHOD(RemeasureGlyphsWidensRows);
+    TEST_METHOD(SearchText);
+    TEST_METHOD(SearchTextRegex);
+
+    TEST_METHOD(CompactScrollbackRoundTrip);
+    TEST_METHOD(TrimMemory);
+    TEST_METHOD(SnapshotRoundTrip);
+
+    TEST_METHOD(WriteReadCharInfos);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -1906,6 +1928,95 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
 }
 
+// This tests that ScrollRows() moves the rows within the given region, including across the
+// end of the circular buffer, and that the vacated rows receive the ones that were overwritten.
+void TextBufferTests::ScrollRowsRotatesRegion()
+{
+    const til::size bufferSize{ 10, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    _buffer->_SetFirstRowIndex(5);
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        const wchar_t ch = L'a' + gsl::narrow_cast<wchar_t>(y);
+        _buffer->GetRowByOffset(y).ReplaceCharacters(0, 1, { &ch, 1 });
+    }
+
+    const auto verifyRows = [&](const std::wstring_view expected) {
+        for (til::CoordType y = 0; y < bufferSize.height; ++y)
+        {
+            VERIFY_ARE_EQUAL(String(&expected[y], 1), String(_buffer->GetRowByOffset(y).GlyphAt(0).data(), 1));
+        }
+    };
+
+    _buffer->ScrollRows(2, 4, -1);
+    verifyRows(L"acdefbgh");
+
+    _buffer->ScrollRows(1, 3, 2);
+    verifyRows(L"afbcdegh");
+
+    VERIFY_ARE_EQUAL(til::point(0, 7), _buffer->GetLastNonSpaceCharacter());
+}
+
+// This tests that a buffer constructed on top of the memory of a destroyed recyclable
+// buffer reuses it, but starts out blank and with its own attributes nonetheless.
+void TextBufferTests::RecycledArenaIsReset()
+{
+    // An unusual size, so that we don't pick up the arena of an alt buffer from another test.
+    const til::size bufferSize{ 37, 13 };
+    const UINT cursorSize = 12;
+    const TextAttribute oldAttr{ 0x7f };
+    const TextAttribute newAttr{ 0x1e };
+
+    auto oldBuffer = std::make_unique<TextBuffer>(bufferSize, oldAttr, cursorSize, false, _renderer);
+    oldBuffer->SetRecyclable(true);
+    oldBuffer->GetRowByOffset(3).ReplaceCharacters(2, 2, L"\xD83D\xDD25");
+    oldBuffer->GetRowByOffset(3).SetWrapForced(true);
+    const auto oldArena = oldBuffer->_buffer.get();
+    oldBuffer.reset();
+
+    auto newBuffer = std::make_unique<TextBuffer>(bufferSize, newAttr, cursorSize, false, _renderer);
+    VERIFY_ARE_EQUAL(oldArena, newBuffer->_buffer.get());
+
+    const auto& row = newBuffer->GetRowByOffset(3);
+    VERIFY_ARE_EQUAL(String(std::wstring(bufferSize.width, L' ').c_str()), String(std::wstring{ row.GetText() }.c_str()));
+    VERIFY_ARE_EQUAL(newAttr, row.GetAttrByColumn(2));
+    VERIFY_IS_FALSE(row.WasWrapForced());
+}
+
+void TextBufferTests::GetChangedRowsSince()
+{
+    const til::size bufferSize{ 10, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    // Commit all rows, so that we're only getting the ones changed below.
+    std::ignore = _buffer->GetRowByOffset(bufferSize.height - 1);
+    auto generation = ROW::GetLatestGeneration();
+    VERIFY_IS_TRUE(_buffer->GetChangedRowsSince(generation, 0, bufferSize.height).empty());
+
+    _buffer->GetRowByOffset(2).ReplaceCharacters(0, 1, L"a");
+    _buffer->GetRowByOffset(5).ReplaceAttributes(0, 3, TextAttribute{ 0x1f });
+    const auto changed = _buffer->GetChangedRowsSince(generation, 0, bufferSize.height);
+    VERIFY_ARE_EQUAL(2u, changed.size());
+    VERIFY_ARE_EQUAL(2, changed[0]);
+    VERIFY_ARE_EQUAL(5, changed[1]);
+    const auto changedClamped = _buffer->GetChangedRowsSince(generation, 3, 100);
+    VERIFY_ARE_EQUAL(1u, changedClamped.size());
+    VERIFY_ARE_EQUAL(5, changedClamped[0]);
+
+    // Moving rows around invalidates everything.
+    generation = ROW::GetLatestGeneration();
+    _buffer->IncrementCircularBuffer();
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(bufferSize.height), _buffer->GetChangedRowsSince(generation, 0, bufferSize.height).size());
+
+    generation = ROW::GetLatestGeneration();
+    VERIFY_IS_TRUE(_buffer->GetChangedRowsSince(generation, 0, bufferSize.height).empty());
+}
+
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
 // characters from the Unicode Storage buffer
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
@@ -2103,6 +2214,24 @@ void TextBufferTests::TestRowReplaceText()
             { L"", 4, 0, 5 },
             L" efg c" complex L"ab",
         },
+        Test{
+            L"ASCII that is longer than a SIMD vector, followed by a wide glyph that doesn't fit",
+            { L"hijklmnop" complex, 0, til::CoordTypeMax },
+            { complex, 10, 0, 10 },
+            L"hijklmnop ",
+        },
+        Test{
+            L"ASCII interrupted by a wide glyph",
+            { L"a" complex L"bcdefghij", 0, til::CoordTypeMax },
+            { L"ij", 10, 0, 10 },
+            L"a" complex L"bcdefgh",
+        },
+        Test{
+            L"ASCII written into the trailing half of a wide glyph",
+            { L"xy", 2, til::CoordTypeMax },
+            { L"", 4, 1, 4 },
+            L"a xycdefgh",
+        },
     };
 
     for (const auto& t : tests)
@@ -2124,6 +2253,33 @@ void TextBufferTests::TestRowReplaceText()
 #undef complex
 }
 
+void TextBufferTests::TestRowCopyFromWide()
+{
+    // The row needs to be wide enough for ROW::WriteHelper::_copyOffsets
+    // to work on multiple chunks plus an unaligned tail.
+    static constexpr til::size bufferSize{ 45, 2 };
+    static constexpr UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, cursorSize, false, _renderer };
+
+    auto& source = buffer.GetRowByOffset(0);
+    RowWriteState state{ .text = L"a\U0001F41Bb\u3042c\U0001F41B\U0001F41Bdefghijklmnopqrstuvwxyz\u3044ABCD" };
+    source.ReplaceText(state);
+
+    auto& target = buffer.GetRowByOffset(1);
+    target.CopyFrom(source);
+    VERIFY_ARE_EQUAL(source.GetText(), target.GetText());
+
+    // Skipping the first column requires the offsets to be rebased during the copy.
+    RowCopyTextFromState shifted{ .source = source, .sourceColumnBegin = 1 };
+    target.CopyTextFrom(shifted);
+    for (til::CoordType column = 0; column < bufferSize.width - 1; ++column)
+    {
+        VERIFY_ARE_EQUAL(source.GlyphAt(column + 1), target.GlyphAt(column));
+        VERIFY_ARE_EQUAL(static_cast<int>(source.DbcsAttrAt(column + 1)), static_cast<int>(target.DbcsAttrAt(column)));
+    }
+}
+
 void TextBufferTests::TestAppendRTFText()
 {
     {
@@ -2287,6 +2443,48 @@ void TextBufferTests::GetWordBoundaries()
     }
 }
 
+void TextBufferTests::GetWordBoundariesWithWideGlyphs()
+{
+    til::size bufferSize{ 80, 9001 };
+    UINT cursorSize = 12;
+    TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    // The runs are long enough to be scanned in vectorized chunks, and the line mixes
+    // ASCII delimiters, a non-ASCII delimiter (U+2502) and wide glyphs (U+3042).
+    const std::vector<std::wstring> text = { L"aaaaaaaaaaaa,bbbbbbbbbbbb\u2502\u3042\u3042\u3042\u3042cc  dd" };
+    WriteLinesToBuffer(text, *_buffer);
+
+    struct Test
+    {
+        til::point startPos;
+        til::point wordStart;
+        til::point wordEnd;
+    };
+
+    // clang-format off
+    static constexpr std::array testData{
+        Test{ {  5, 0 }, {  0, 0 }, { 11, 0 } },
+        Test{ { 12, 0 }, { 12, 0 }, { 12, 0 } },
+        Test{ { 20, 0 }, { 13, 0 }, { 24, 0 } },
+        Test{ { 25, 0 }, { 25, 0 }, { 25, 0 } },
+        Test{ { 27, 0 }, { 26, 0 }, { 35, 0 } },
+        Test{ { 34, 0 }, { 26, 0 }, { 35, 0 } },
+        Test{ { 37, 0 }, { 36, 0 }, { 37, 0 } },
+        Test{ { 39, 0 }, { 38, 0 }, { 39, 0 } },
+        Test{ { 50, 0 }, { 40, 0 }, { 79, 0 } },
+    };
+    // clang-format on
+
+    const std::wstring_view delimiters = L" ,\u2502";
+    for (const auto& test : testData)
+    {
+        Log::Comment(NoThrowString().Format(L"til::point (%d, %d)", test.startPos.x, test.startPos.y));
+        VERIFY_ARE_EQUAL(test.wordStart, _buffer->GetWordStart(test.startPos, delimiters));
+        VERIFY_ARE_EQUAL(test.wordEnd, _buffer->GetWordEnd(test.startPos, delimiters));
+    }
+}
+
 void TextBufferTests::MoveByWord()
 {
     til::size bufferSize{ 80, 9001 };
@@ -2368,6 +2566,47 @@ void TextBufferTests::MoveByWord()
     }
 }
 
+void TextBufferTests::MoveByWordAfterRowChanged()
+{
+    til::size bufferSize{ 80, 9001 };
+    UINT cursorSize = 12;
+    TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const std::vector<std::wstring> text = { L"word other",
+                                             L"  more   words" };
+    WriteLinesToBuffer(text, *_buffer);
+
+    const std::wstring_view delimiters = L" ";
+    const auto lastCharPos = _buffer->GetLastNonSpaceCharacter();
+
+    Log::Comment(L"Populate the word start cache.");
+    til::point pos{ 0, 0 };
+    VERIFY_IS_TRUE(_buffer->MoveToNextWord(pos, delimiters, lastCharPos));
+    VERIFY_ARE_EQUAL((til::point{ 5, 0 }), pos);
+    pos = { 2, 1 };
+    VERIFY_IS_TRUE(_buffer->MoveToPreviousWord(pos, delimiters));
+    VERIFY_ARE_EQUAL((til::point{ 5, 0 }), pos);
+
+    Log::Comment(L"Splitting \"other\" into two words must be reflected by the next moves.");
+    _buffer->GetRowByOffset(0).ReplaceCharacters(7, 1, L" ");
+    pos = { 5, 0 };
+    VERIFY_IS_TRUE(_buffer->MoveToNextWord(pos, delimiters, lastCharPos));
+    VERIFY_ARE_EQUAL((til::point{ 8, 0 }), pos);
+    pos = { 2, 1 };
+    VERIFY_IS_TRUE(_buffer->MoveToPreviousWord(pos, delimiters));
+    VERIFY_ARE_EQUAL((til::point{ 8, 0 }), pos);
+
+    Log::Comment(L"A word that wraps across the row boundary starts in the previous row.");
+    _buffer->GetRowByOffset(0).ReplaceCharacters(79, 1, L"x");
+    _buffer->GetRowByOffset(1).ReplaceCharacters(0, 1, L"y");
+    pos = { 1, 1 };
+    VERIFY_ARE_EQUAL((til::point{ 79, 0 }), _buffer->GetWordStart(pos, delimiters, true));
+    pos = { 8, 0 };
+    VERIFY_IS_TRUE(_buffer->MoveToNextWord(pos, delimiters, lastCharPos));
+    VERIFY_ARE_EQUAL((til::point{ 79, 0 }), pos);
+}
+
 void TextBufferTests::GetGlyphBoundaries()
 {
     struct ExpectedResult
@@ -2735,6 +2974,39 @@ void TextBufferTests::GetText()
     }
 }
 
+void TextBufferTests::GetTextColorRuns()
+{
+    const til::size bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    auto& row = _buffer->GetRowByOffset(0);
+    RowWriteState state{ .text = L"abcde" };
+    row.ReplaceText(state);
+    row.ReplaceAttributes(2, 5, TextAttribute{ 0x1f });
+
+    const auto textRects = _buffer->GetTextRects({ 0, 0 }, { 9, 1 }, false, false);
+    const auto textData = _buffer->GetText(true, true, textRects, [](const TextAttribute& attr) {
+        return std::pair<COLORREF, COLORREF>{ attr.GetLegacyAttributes(), 0 };
+    });
+
+    VERIFY_ARE_EQUAL(2u, textData.text.size());
+    VERIFY_ARE_EQUAL(L"abcde\r\n", textData.text[0]);
+    VERIFY_ARE_EQUAL(L"", textData.text[1]);
+
+    Log::Comment(L"Cells with identical colors should be merged into runs, trimmed whitespace shouldn't have any");
+    const auto& runs = textData.colors[0];
+    VERIFY_ARE_EQUAL(3u, runs.size());
+    VERIFY_ARE_EQUAL(0x7fu, runs[0].foreground);
+    VERIFY_ARE_EQUAL(2u, runs[0].length);
+    VERIFY_ARE_EQUAL(0x1fu, runs[1].foreground);
+    VERIFY_ARE_EQUAL(3u, runs[1].length);
+    VERIFY_ARE_EQUAL(RGB(0, 0, 0), runs[2].foreground);
+    VERIFY_ARE_EQUAL(2u, runs[2].length);
+    VERIFY_IS_TRUE(textData.colors[1].empty());
+}
+
 // This tests that when we increment the circular buffer, obsolete hyperlink references
 // are removed from the hyperlink map
 void TextBufferTests::HyperlinkTrim()
@@ -2815,3 +3087,534 @@ void TextBufferTests::NoHyperlinkTrim()
     VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(id), url);
     VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalCustomId], id);
 }
+
+// This tests that once the hyperlink ID space wraps around,
+// IDs which are still in use aren't handed out again.
+void TextBufferTests::HyperlinkIdReuse()
+{
+    const til::size bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    static constexpr std::wstring_view url{ L"test.url" };
+
+    const auto id = _buffer->GetHyperlinkId(url, {});
+    _buffer->AddHyperlinkToMap(url, id);
+    VERIFY_ARE_EQUAL(1u, id);
+
+    _buffer->_currentHyperlinkId = UINT16_MAX;
+    VERIFY_ARE_EQUAL(UINT16_MAX, _buffer->GetHyperlinkId(url, {}));
+    // 0 is reserved and 1 is still in use.
+    VERIFY_ARE_EQUAL(2u, _buffer->GetHyperlinkId(url, {}));
+}
+
+// This tests that the hand-written matcher for TextBuffer::UrlPattern
+// finds the exact same URLs as the std::wregex it replaces.
+void TextBufferTests::UrlPatternsMatchRegex()
+{
+    const til::size bufferSize{ 20, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    // Appending an alternative that never matches forces GetPatterns() to use std::wregex.
+    const auto urlId = _buffer->AddPatternRecognizer(TextBuffer::UrlPattern);
+    const auto regexId = _buffer->AddPatternRecognizer(std::wstring{ TextBuffer::UrlPattern } + L"|(?!)");
+
+    const auto verify = [&]() {
+        const auto tree = _buffer->GetPatterns(0, bufferSize.height - 1);
+        std::vector<std::pair<til::point, til::point>> urls;
+        std::vector<std::pair<til::point, til::point>> expected;
+        for (const auto& interval : tree.findOverlapping({ 0, 0 }, { 0, bufferSize.height }))
+        {
+            (interval.value == urlId ? urls : expected).emplace_back(interval.start, interval.stop);
+        }
+        std::sort(urls.begin(), urls.end());
+        std::sort(expected.begin(), expected.end());
+        VERIFY_IS_FALSE(expected.empty());
+        VERIFY_ARE_EQUAL(expected, urls);
+    };
+
+    WriteLinesToBuffer({ L"see https://a.b/c.",
+                         L"xhttp://no ftp://ok",
+                         L"  file://x http://",
+                         L"   https://spans.th",
+                         L"e/next/row and more",
+                         L"\u732B http://\u732B",
+                         L"http://:;,.x?!" },
+                       *_buffer);
+    verify();
+
+    Log::Comment(L"Modify a row and ensure the cached URLs of the other rows are still correct");
+    WriteLinesToBuffer({ L"ftp://changed here" }, *_buffer);
+    verify();
+}
+
+void TextBufferTests::GetUrlAt()
+{
+    const til::size bufferSize{ 20, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto urlId = _buffer->AddPatternRecognizer(TextBuffer::UrlPattern);
+
+    WriteLinesToBuffer({ L"x https://wrapss.acr",
+                         L"oss/rows end",
+                         L"",
+                         L"ftp://last" },
+                       *_buffer);
+
+    const auto verify = [&](const til::point pos, const til::point start, const til::point stop) {
+        const auto url = _buffer->GetUrlAt(pos, urlId);
+        VERIFY_IS_TRUE(url.has_value());
+        VERIFY_ARE_EQUAL(start, url->start);
+        VERIFY_ARE_EQUAL(stop, url->stop);
+        VERIFY_ARE_EQUAL(urlId, url->value);
+    };
+
+    Log::Comment(L"URLs wrapping into the next row are found from either row");
+    verify({ 2, 0 }, { 2, 0 }, { 8, 1 });
+    verify({ 7, 1 }, { 2, 0 }, { 8, 1 });
+    verify({ 0, 3 }, { 0, 3 }, { 10, 3 });
+
+    Log::Comment(L"Positions next to a URL don't match");
+    VERIFY_IS_FALSE(_buffer->GetUrlAt({ 1, 0 }, urlId).has_value());
+    VERIFY_IS_FALSE(_buffer->GetUrlAt({ 8, 1 }, urlId).has_value());
+    VERIFY_IS_FALSE(_buffer->GetUrlAt({ 0, 2 }, urlId).has_value());
+    VERIFY_IS_FALSE(_buffer->GetUrlAt({ 0, 4 }, urlId).has_value());
+}
+
+// This tests that FillText() and FillAttributes() produce
+// the same buffer contents as writing an equivalent OutputCellIterator.
+void TextBufferTests::FillTextAndAttributesMatchWrite()
+{
+    const til::size bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute fillAttr{ 0x1e };
+    auto expected = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    auto actual = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    for (const auto buffer : { expected.get(), actual.get() })
+    {
+        WriteLinesToBuffer({ L"abc\u732Bdefgh",
+                             L"\u732B\u732B\u732B\u732B\u732B",
+                             L"0123456789",
+                             L"xyz" },
+                           *buffer);
+    }
+
+    const auto verify = [&]() {
+        for (til::CoordType y = 0; y < bufferSize.height; ++y)
+        {
+            const auto& expectedRow = expected->GetRowByOffset(y);
+            const auto& actualRow = actual->GetRowByOffset(y);
+            VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced());
+            for (til::CoordType x = 0; x < bufferSize.width; ++x)
+            {
+                VERIFY_ARE_EQUAL(expectedRow.DbcsAttrAt(x), actualRow.DbcsAttrAt(x));
+                VERIFY_ARE_EQUAL(expectedRow.GetAttrByColumn(x), actualRow.GetAttrByColumn(x));
+            }
+        }
+    };
+
+    Log::Comment(L"Fill text across rows, starting in the middle of a wide glyph");
+    {
+        const OutputCellIterator it{ L'-', 20 };
+        const auto expectedFilled = expected->Write(it, { 4, 0 }, false).GetInputDistance(it);
+        VERIFY_ARE_EQUAL(expectedFilled, actual->FillText({ 4, 0 }, L'-', 20, false));
+        verify();
+    }
+
+    Log::Comment(L"Fill attributes up to the end of the buffer");
+    {
+        const OutputCellIterator it{ fillAttr, 100 };
+        const auto expectedFilled = expected->Write(it, { 7, 1 }).GetCellDistance(it);
+        VERIFY_ARE_EQUAL(expectedFilled, actual->FillAttributes({ 7, 1 }, fillAttr, 100));
+        verify();
+    }
+}
+
+void TextBufferTests::RemeasureGlyphsWidensRows()
+{
+    const til::size bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute markAttr{ 0x1e };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto generation = ROW::GetLatestGeneration();
+
+    // Simulate a glyph that was written narrow, because its width wasn't known yet.
+    WriteLinesToBuffer({ L"a?bcdefghi", L"0123456789" }, *_buffer);
+    auto& row = _buffer->GetRowByOffset(0);
+    row.ReplaceCharacters(1, 1, L"\u732B");
+    row.ReplaceAttributes(2, 3, markAttr);
+
+    static constexpr char32_t wide[]{ 0x732B };
+    _buffer->RemeasureGlyphs(wide, generation);
+
+    // The glyph now occupies 2 columns and the rest of the row moved right, cut off at the end.
+    VERIFY_ARE_EQUAL(L"a\u732Bbcdefgh", row.GetText());
+    VERIFY_ARE_EQUAL(DbcsAttribute::Leading, row.DbcsAttrAt(1));
+    VERIFY_ARE_EQUAL(DbcsAttribute::Trailing, row.DbcsAttrAt(2));
+    VERIFY_ARE_EQUAL(attr, row.GetAttrByColumn(2));
+    VERIFY_ARE_EQUAL(markAttr, row.GetAttrByColumn(3));
+    VERIFY_ARE_EQUAL(attr, row.GetAttrByColumn(4));
+
+    // Rows without the glyph are untouched.
+    VERIFY_ARE_EQUAL(L"0123456789", _buffer->GetRowByOffset(1).GetText());
+}
+
+void TextBufferTests::SearchText()
+{
+    const til::size bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    static constexpr std::wstring_view texts[]{
+        L"abc ABC ab",
+        L"c \u732B\u732B xab",
+        L"ABCabcabc",
+    };
+    for (til::CoordType y = 0; y < 3; ++y)
+    {
+        auto& row = _buffer->GetRowByOffset(y);
+        RowWriteState state{ .text = til::at(texts, y) };
+        row.ReplaceText(state);
+        row.SetWrapForced(y == 0);
+    }
+
+    const auto search = [&](const std::wstring_view& needle, const bool caseInsensitive) {
+        std::vector<std::pair<til::point, til::point>> matches;
+        for (const auto& match : _buffer->SearchText(needle, caseInsensitive, 0, bufferSize.height))
+        {
+            matches.emplace_back(match.start, match.end);
+        }
+        return matches;
+    };
+
+    using Matches = std::vector<std::pair<til::point, til::point>>;
+
+    Log::Comment(L"Matches can span soft-wrapped rows, but not hard line breaks");
+    VERIFY_ARE_EQUAL((Matches{
+                         { { 0, 0 }, { 2, 0 } },
+                         { { 4, 0 }, { 6, 0 } },
+                         { { 8, 0 }, { 0, 1 } },
+                         { { 0, 2 }, { 2, 2 } },
+                         { { 3, 2 }, { 5, 2 } },
+                         { { 6, 2 }, { 8, 2 } },
+                     }),
+                     search(L"ABC", true));
+
+    Log::Comment(L"Case sensitive searches skip the upper case occurrences");
+    VERIFY_ARE_EQUAL((Matches{
+                         { { 0, 0 }, { 2, 0 } },
+                         { { 8, 0 }, { 0, 1 } },
+                         { { 3, 2 }, { 5, 2 } },
+                         { { 6, 2 }, { 8, 2 } },
+                     }),
+                     search(L"abc", false));
+
+    Log::Comment(L"Matches end on the trailing column of wide glyphs");
+    VERIFY_ARE_EQUAL((Matches{ { { 2, 1 }, { 5, 1 } } }), search(L"\u732B\u732B", false));
+
+    Log::Comment(L"Matches don't overlap");
+    VERIFY_ARE_EQUAL((Matches{ { { 0, 2 }, { 3, 2 } } }), search(L"abca", true));
+}
+
+void TextBufferTests::SearchTextRegex()
+{
+    const til::size bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    static constexpr std::wstring_view texts[]{
+        L"abc ABC ab",
+        L"c \u732B\u732B xab",
+        L"ABCabcabc",
+    };
+    for (til::CoordType y = 0; y < 3; ++y)
+    {
+        auto& row = _buffer->GetRowByOffset(y);
+        RowWriteState state{ .text = til::at(texts, y) };
+        row.ReplaceText(state);
+        row.SetWrapForced(y == 0);
+    }
+
+    const auto search = [&](const std::wstring_view& pattern, const bool caseInsensitive) {
+        std::vector<std::pair<til::point, til::point>> matches;
+        for (const auto& match : _buffer->SearchTextRegex(pattern, caseInsensitive, 0, bufferSize.height))
+        {
+            matches.emplace_back(match.start, match.end);
+        }
+        return matches;
+    };
+
+    using Matches = std::vector<std::pair<til::point, til::point>>;
+
+    Log::Comment(L"Matches can span soft-wrapped rows, but not hard line breaks");
+    VERIFY_ARE_EQUAL((Matches{
+                         { { 0, 0 }, { 2, 0 } },
+                         { { 8, 0 }, { 0, 1 } },
+                         { { 8, 1 }, { 9, 1 } },
+                         { { 3, 2 }, { 5, 2 } },
+                         { { 6, 2 }, { 8, 2 } },
+                     }),
+                     search(L"a[bc]+", false));
+
+    Log::Comment(L"^ matches at the start of each line, not each row");
+    VERIFY_ARE_EQUAL((Matches{
+                         { { 0, 0 }, { 2, 0 } },
+                         { { 0, 2 }, { 2, 2 } },
+                     }),
+                     search(L"^abc", true));
+
+    Log::Comment(L"The longest of the leftmost matches wins");
+    VERIFY_ARE_EQUAL((Matches{
+                         { { 0, 0 }, { 1, 0 } },
+                         { { 8, 0 }, { 9, 0 } },
+                         { { 8, 1 }, { 9, 1 } },
+                         { { 3, 2 }, { 6, 2 } },
+                     }),
+                     search(L"ab|abca", false));
+
+    Log::Comment(L"Matches end on the trailing column of wide glyphs");
+    VERIFY_ARE_EQUAL((Matches{ { { 2, 1 }, { 5, 1 } } }), search(L"\u732B+", false));
+
+    Log::Comment(L"Invalid patterns and empty matches find nothing");
+    VERIFY_ARE_EQUAL(Matches{}, search(L"a(", false));
+    VERIFY_ARE_EQUAL(Matches{}, search(L"x*", false));
+}
+
+void TextBufferTests::CompactScrollbackRoundTrip()
+{
+    const til::size bufferSize{ 20, 300 };
+    const til::CoordType limit = 280;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    static constexpr std::wstring_view texts[]{
+        L"plain ascii",
+        L"",
+        L"caf\u00E9 narrow non-ascii",
+        L"\u732B\u732B wide glyphs",
+        L"emoji \U0001F600!",
+        L"unpaired \xD800 surrogate",
+        L"spaces at the end    ",
+        L"a somewhat longer row that wraps",
+    };
+
+    std::vector<std::wstring> expectedText;
+    std::vector<til::small_rle<TextAttribute, uint16_t, 1>> expectedAttr;
+    std::vector<bool> expectedWrap;
+
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        auto& row = _buffer->GetRowByOffset(y);
+        RowWriteState state{ .text = til::at(texts, y % std::size(texts)) };
+        row.ReplaceText(state);
+        if (y % 3 == 0)
+        {
+            row.ReplaceAttributes(2, 5, TextAttribute{ 0x1f });
+        }
+        row.SetWrapForced(y % 2 == 0);
+
+        expectedText.emplace_back(row.GetText());
+        expectedAttr.emplace_back(row.Attributes());
+        expectedWrap.emplace_back(row.WasWrapForced());
+    }
+
+    _buffer->CompactScrollback(limit);
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(limit), _buffer->_archive.Count());
+
+    Log::Comment(L"Archived rows should be restored exactly as they were when accessed");
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        const auto& row = _buffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(til::at(expectedText, y), row.GetText());
+        VERIFY_IS_TRUE(til::at(expectedAttr, y) == row.Attributes());
+        VERIFY_ARE_EQUAL(til::at(expectedWrap, y), row.WasWrapForced());
+    }
+    VERIFY_IS_TRUE(_buffer->_archive.Empty());
+}
+
+void TextBufferTests::TrimMemory()
+{
+    const til::size bufferSize{ 20, 300 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    // Commit the entire buffer and write some text into the first 10 rows.
+    _buffer->GetRowByOffset(bufferSize.height - 1);
+    for (til::CoordType y = 0; y < 10; ++y)
+    {
+        RowWriteState state{ .text = L"text" };
+        _buffer->GetRowByOffset(y).ReplaceText(state);
+    }
+    VERIFY_ARE_EQUAL(bufferSize.height - 1, _buffer->_estimateOffsetOfLastCommittedRow());
+
+    const til::point_span inUse[]{ { { 0, 15 }, { 0, 16 } } };
+    _buffer->TrimMemory(inUse, false);
+
+    Log::Comment(L"Blank rows past the last one in use should be decommitted");
+    VERIFY_ARE_EQUAL(16, _buffer->_estimateOffsetOfLastCommittedRow());
+    Log::Comment(L"Blank rows before it should be archived");
+    VERIFY_ARE_EQUAL(5u, _buffer->_archive.Count());
+
+    for (til::CoordType y = 0; y < 20; ++y)
+    {
+        VERIFY_ARE_EQUAL(y < 10, _buffer->GetRowByOffset(y).ContainsText());
+    }
+    VERIFY_IS_TRUE(_buffer->_archive.Empty());
+
+    Log::Comment(L"With compactText all rows that aren't in use should be archived");
+    _buffer->TrimMemory(inUse, true);
+    VERIFY_ARE_EQUAL(15u, _buffer->_archive.Count());
+    VERIFY_ARE_EQUAL(L"text", _buffer->GetRowByOffset(0).GetText().substr(0, 4));
+}
+
+void TextBufferTests::SnapshotRoundTrip()
+{
+    const til::size bufferSize{ 20, 50 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto source = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    static constexpr std::wstring_view texts[]{
+        L"plain ascii",
+        L"",
+        L"\u732B\u732B wide glyphs",
+        L"emoji \U0001F600!",
+        L"spaces at the end    ",
+    };
+
+    TextAttribute linkAttr{ 0x1f };
+    linkAttr.SetHyperlinkId(source->GetHyperlinkId(L"https://example.com", L"custom"));
+    source->AddHyperlinkToMap(L"https://example.com", linkAttr.GetHyperlinkId());
+
+    for (til::CoordType y = 0; y < 30; ++y)
+    {
+        auto& row = source->GetRowByOffset(y);
+        RowWriteState state{ .text = til::at(texts, y % std::size(texts)) };
+        row.ReplaceText(state);
+        if (y % 3 == 0)
+        {
+            row.ReplaceAttributes(2, 5, linkAttr);
+        }
+        row.SetWrapForced(y % 2 == 0);
+    }
+    source->GetCursor().SetPosition({ 4, 29 });
+
+    std::vector<std::byte> snapshot;
+    BufferSnapshot::Capture(*source, bufferSize.height, snapshot);
+
+    Log::Comment(L"A buffer of the same size should be restored exactly");
+    {
+        auto target = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+        const auto result = BufferSnapshot::Restore(*target, snapshot);
+        VERIFY_ARE_EQUAL(snapshot.size(), result.size);
+        VERIFY_ARE_EQUAL(0, result.rowDelta.value_or(-1));
+
+        for (til::CoordType y = 0; y < 30; ++y)
+        {
+            const auto& expected = source->GetRowByOffset(y);
+            const auto& actual = target->GetRowByOffset(y);
+            VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+            VERIFY_IS_TRUE(expected.Attributes() == actual.Attributes());
+            VERIFY_ARE_EQUAL(expected.WasWrapForced(), actual.WasWrapForced());
+        }
+        VERIFY_ARE_EQUAL(til::point(4, 29), target->GetCursor().GetPosition());
+        VERIFY_ARE_EQUAL(std::wstring{ L"https://example.com" }, target->GetHyperlinkUriFromId(linkAttr.GetHyperlinkId()));
+        VERIFY_ARE_EQUAL(linkAttr.GetHyperlinkId(), target->GetHyperlinkId(L"https://example.com", L"custom"));
+    }
+
+    Log::Comment(L"A shorter buffer should receive the last rows");
+    {
+        auto target = std::make_unique<TextBuffer>(til::size{ 20, 10 }, attr, cursorSize, false, _renderer);
+        const auto result = BufferSnapshot::Restore(*target, snapshot);
+        VERIFY_ARE_EQUAL(20, result.rowDelta.value_or(-1));
+        VERIFY_ARE_EQUAL(source->GetRowByOffset(29).GetText(), target->GetRowByOffset(9).GetText());
+        VERIFY_ARE_EQUAL(til::point(4, 9), target->GetCursor().GetPosition());
+    }
+
+    Log::Comment(L"A buffer of a different width should receive the reflowed rows");
+    {
+        auto target = std::make_unique<TextBuffer>(til::size{ 30, 50 }, attr, cursorSize, false, _renderer);
+        const auto result = BufferSnapshot::Restore(*target, snapshot);
+        VERIFY_IS_FALSE(result.rowDelta.has_value());
+        VERIFY_ARE_EQUAL(L"plain ascii", target->GetRowByOffset(0).GetText().substr(0, 11));
+    }
+
+    Log::Comment(L"Corrupted snapshots should be rejected");
+    {
+        auto target = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+        const std::span truncated{ snapshot.data(), snapshot.size() / 2 };
+        VERIFY_THROWS_SPECIFIC(BufferSnapshot::Restore(*target, truncated), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_UNEXPECTED; });
+    }
+}
+
+void TextBufferTests::WriteReadCharInfos()
+{
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const til::size bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto bulk = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    auto generic = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const std::array<CHAR_INFO, 8> paired{ {
+        { L'a', FOREGROUND_RED },
+        { L'b', FOREGROUND_RED },
+        { L'\u3042', FOREGROUND_GREEN | COMMON_LVB_LEADING_BYTE },
+        { L'\u3042', FOREGROUND_GREEN | COMMON_LVB_TRAILING_BYTE },
+        { L'c', BACKGROUND_BLUE | COMMON_LVB_UNDERSCORE },
+        { L'd', BACKGROUND_BLUE },
+        { L'e', BACKGROUND_BLUE },
+        { L'f', FOREGROUND_RED },
+    } };
+    // Starts with the trailing half of a wide glyph and ends with a leading one,
+    // which requires WriteCharInfos() to fall back to the generic path.
+    const std::array<CHAR_INFO, 4> unpaired{ {
+        { L'\u3042', FOREGROUND_GREEN | COMMON_LVB_TRAILING_BYTE },
+        { L'g', FOREGROUND_BLUE },
+        { L'h', FOREGROUND_BLUE },
+        { L'\u3044', FOREGROUND_GREEN | COMMON_LVB_LEADING_BYTE },
+    } };
+
+    bulk->WriteCharInfos({ 2, 0 }, paired);
+    generic->Write(OutputCellIterator{ paired }, { 2, 0 });
+    bulk->WriteCharInfos({ 1, 1 }, paired);
+    generic->Write(OutputCellIterator{ paired }, { 1, 1 });
+    bulk->WriteCharInfos({ 3, 2 }, unpaired);
+    generic->Write(OutputCellIterator{ unpaired }, { 3, 2 });
+
+    Log::Comment(L"WriteCharInfos() should produce the same rows as writing via OutputCellIterator");
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        const auto& a = bulk->GetRowByOffset(y);
+        const auto& b = generic->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(b.GetText(), a.GetText());
+        VERIFY_IS_TRUE(b.Attributes() == a.Attributes());
+        VERIFY_ARE_EQUAL(b.WasWrapForced(), a.WasWrapForced());
+    }
+
+    Log::Comment(L"ReadCharInfos() should produce the same cells as converting them one by one");
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        std::array<CHAR_INFO, 10> actual{};
+        bulk->ReadCharInfos({ 0, y }, actual);
+
+        auto it = bulk->GetCellDataAt({ 0, y });
+        for (const auto& ci : actual)
+        {
+            VERIFY_ARE_EQUAL(gci.AsCharInfo(*it), ci);
+            ++it;
+        }
+    }
+}
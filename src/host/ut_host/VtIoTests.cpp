@@ -282,6 +282,11 @@ public:
         return std::vector<Microsoft::Console::Types::Viewport>{};
     }
 
+    std::vector<Microsoft::Console::Types::Viewport> GetVisibleSelectionRects() noexcept override
+    {
+        return std::vector<Microsoft::Console::Types::Viewport>{};
+    }
+
     void LockConsole() noexcept override
     {
     }
@@ -290,6 +295,14 @@ public:
     {
     }
 
+    void LockConsoleShared() noexcept override
+    {
+    }
+
+    void UnlockConsoleShared() noexcept override
+    {
+    }
+
     std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& /*attr*/) const noexcept override
     {
         return std::make_pair(COLORREF{}, COLORREF{});
@@ -396,6 +409,11 @@ public:
     {
         return {};
     }
+
+    std::span<const til::point_span> GetSearchHighlights() const noexcept override
+    {
+        return {};
+    }
 };
 
 void VtIoTests::RendererDtorAndThread()
@@ -69,6 +69,7 @@ class Microsoft::Console::Render::VtRendererTest
     TEST_METHOD(Xterm256TestCursor);
     TEST_METHOD(Xterm256TestExtendedAttributes);
     TEST_METHOD(Xterm256TestAttributesAcrossReset);
+    TEST_METHOD(Xterm256TestGraphicsRenditionDiff);
 
     TEST_METHOD(XtermTestInvalidate);
     TEST_METHOD(XtermTestColors);
@@ -81,6 +82,8 @@ class Microsoft::Console::Render::VtRendererTest
 
     TEST_METHOD(TestResize);
 
+    TEST_METHOD(TestRepaintSkipsTransmittedRuns);
+
     TEST_METHOD(TestCursorVisibility);
 
     void Test16Colors(VtEngine* engine);
@@ -417,8 +420,7 @@ void VtRendererTest::Xterm256TestColors()
     Log::Comment(NoThrowString().Format(
         L"Begin by setting some test values - FG,BG = (1,2,3), (4,5,6) to start"
         L"These values were picked for ease of formatting raw COLORREF values."));
-    qExpectedInput.push_back("\x1b[38;2;1;2;3m");
-    qExpectedInput.push_back("\x1b[48;2;5;6;7m");
+    qExpectedInput.push_back("\x1b[38;2;1;2;3;48;2;5;6;7m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes({ 0x00030201, 0x00070605 },
                                                   renderSettings,
                                                   &renderData,
@@ -705,55 +707,59 @@ void VtRendererTest::Xterm256TestExtendedAttributes()
     VERIFY_SUCCEEDED(TestData::TryGetValue(L"crossedOut", crossedOut));
 
     TextAttribute desiredAttrs;
-    std::vector<std::string> onSequences, offSequences;
+    std::vector<std::string_view> onParameters;
 
-    // Collect up a VT sequence to set the state given the method properties
+    // Collect up the SGR parameters to set the state given the method properties
     if (faint)
     {
         desiredAttrs.SetFaint(true);
-        onSequences.push_back("\x1b[2m");
-        offSequences.push_back("\x1b[22m");
+        onParameters.push_back("2");
     }
     if (underlined)
     {
         desiredAttrs.SetUnderlined(true);
-        onSequences.push_back("\x1b[4m");
-        offSequences.push_back("\x1b[24m");
+        onParameters.push_back("4");
     }
     if (doublyUnderlined)
     {
         desiredAttrs.SetDoublyUnderlined(true);
-        onSequences.push_back("\x1b[21m");
-        // The two underlines share the same off sequence, so we
-        // only add it here if that hasn't already been done.
-        if (!underlined)
-        {
-            offSequences.push_back("\x1b[24m");
-        }
+        onParameters.push_back("21");
     }
     if (italics)
     {
         desiredAttrs.SetItalic(true);
-        onSequences.push_back("\x1b[3m");
-        offSequences.push_back("\x1b[23m");
+        onParameters.push_back("3");
     }
     if (blink)
     {
         desiredAttrs.SetBlinking(true);
-        onSequences.push_back("\x1b[5m");
-        offSequences.push_back("\x1b[25m");
+        onParameters.push_back("5");
     }
     if (invisible)
     {
         desiredAttrs.SetInvisible(true);
-        onSequences.push_back("\x1b[8m");
-        offSequences.push_back("\x1b[28m");
+        onParameters.push_back("8");
     }
     if (crossedOut)
     {
         desiredAttrs.SetCrossedOut(true);
-        onSequences.push_back("\x1b[9m");
-        offSequences.push_back("\x1b[29m");
+        onParameters.push_back("9");
+    }
+
+    // All attributes are turned on with a single sequence. When they're turned off again,
+    // a single SGR reset is shorter than listing all of them, so it should be used instead.
+    std::vector<std::string> onSequences, offSequences;
+    if (!onParameters.empty())
+    {
+        std::string sequence{ "\x1b[" };
+        for (const auto& parameter : onParameters)
+        {
+            sequence.append(parameter);
+            sequence.push_back(';');
+        }
+        sequence.back() = 'm';
+        onSequences.push_back(std::move(sequence));
+        offSequences.push_back("\x1b[m");
     }
 
     auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
@@ -768,26 +774,31 @@ void VtRendererTest::Xterm256TestExtendedAttributes()
     Log::Comment(NoThrowString().Format(
         L"Test changing the text attributes"));
 
+    Log::Comment(NoThrowString().Format(
+        L"----Start with the default attributes----"));
+    qExpectedInput.push_back("\x1b[m");
+    VERIFY_SUCCEEDED(engine->_UpdateGraphicsRendition({}));
+
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes on----"));
     TestPaint(*engine, [&]() {
         // Merge the "on" sequences into expected input.
         std::copy(onSequences.cbegin(), onSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs(desiredAttrs));
+        VERIFY_SUCCEEDED(engine->_UpdateGraphicsRendition(desiredAttrs));
     });
 
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes off----"));
     TestPaint(*engine, [&]() {
         std::copy(offSequences.cbegin(), offSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs({}));
+        VERIFY_SUCCEEDED(engine->_UpdateGraphicsRendition({}));
     });
 
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes back on----"));
     TestPaint(*engine, [&]() {
         std::copy(onSequences.cbegin(), onSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs(desiredAttrs));
+        VERIFY_SUCCEEDED(engine->_UpdateGraphicsRendition(desiredAttrs));
     });
 
     VerifyExpectedInputsDrained();
@@ -872,8 +883,7 @@ void VtRendererTest::Xterm256TestAttributesAcrossReset()
 
     Log::Comment(L"----Reset Default Foreground and Retain Rendition----");
     textAttributes.SetDefaultForeground();
-    qExpectedInput.push_back("\x1b[m");
-    qExpectedInput.push_back(renditionSequence.str());
+    qExpectedInput.push_back("\x1b[39m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
 
     Log::Comment(L"----Set Green Background----");
@@ -883,13 +893,59 @@ void VtRendererTest::Xterm256TestAttributesAcrossReset()
 
     Log::Comment(L"----Reset Default Background and Retain Rendition----");
     textAttributes.SetDefaultBackground();
-    qExpectedInput.push_back("\x1b[m");
-    qExpectedInput.push_back(renditionSequence.str());
+    qExpectedInput.push_back("\x1b[49m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
 
     VerifyExpectedInputsDrained();
 }
 
+void VtRendererTest::Xterm256TestGraphicsRenditionDiff()
+{
+    const auto format = [](const TextAttribute& last, const TextAttribute& next) {
+        std::string out;
+        Xterm256Engine::_FormatGraphicsRendition(last, next, out);
+        return out;
+    };
+
+    TextAttribute rgb{ RGB(1, 2, 3), RGB(4, 5, 6) };
+
+    Log::Comment(L"Nothing changed, nothing to write");
+    VERIFY_ARE_EQUAL(std::string{}, format({}, {}));
+    VERIFY_ARE_EQUAL(std::string{}, format(rgb, rgb));
+
+    Log::Comment(L"Multiple changes are combined into a single sequence");
+    TextAttribute next;
+    next.SetIndexedForeground(TextColor::DARK_RED);
+    next.SetIntense(true);
+    VERIFY_ARE_EQUAL(std::string{ "\x1b[31;1m" }, format({}, next));
+
+    Log::Comment(L"Turning everything off is a plain reset");
+    TextAttribute last = rgb;
+    last.SetUnderlined(true);
+    last.SetItalic(true);
+    VERIFY_ARE_EQUAL(std::string{ "\x1b[m" }, format(last, {}));
+
+    Log::Comment(L"Turning off a few attributes is shorter than a reset followed by the colors");
+    last = rgb;
+    last.SetItalic(true);
+    last.SetBlinking(true);
+    last.SetIntense(true);
+    next = rgb;
+    next.SetItalic(true);
+    VERIFY_ARE_EQUAL(std::string{ "\x1b[22;25m" }, format(last, next));
+
+    Log::Comment(L"Turning off many attributes is longer than a reset followed by the colors");
+    last = {};
+    last.SetIndexedForeground(TextColor::DARK_RED);
+    last.SetIntense(true);
+    last.SetUnderlined(true);
+    last.SetItalic(true);
+    last.SetBlinking(true);
+    next = {};
+    next.SetIndexedForeground(TextColor::DARK_GREEN);
+    VERIFY_ARE_EQUAL(std::string{ "\x1b[0;32m" }, format(last, next));
+}
+
 void VtRendererTest::XtermTestInvalidate()
 {
     auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
@@ -1466,6 +1522,76 @@ void VtRendererTest::TestResize()
     });
 }
 
+void VtRendererTest::TestRepaintSkipsTransmittedRuns()
+{
+    auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    VerifyFirstPaint(*engine);
+
+    const auto makeClusters = [](const std::wstring_view text) {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            clusters.emplace_back(text.substr(i, 1), 1);
+        }
+        return clusters;
+    };
+    const auto line1 = makeClusters(L"asdfghjkl");
+    const auto line2 = makeClusters(L"zxcvbnm,.");
+    const auto line2Changed = makeClusters(L"zxcvbnm,!");
+
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[H");
+        VERIFY_SUCCEEDED(engine->_MoveCursor({ 0, 0 }));
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Paint two lines. Both of them need to be transmitted.");
+        qExpectedInput.push_back("asdfghjkl");
+        qExpectedInput.push_back("\r\n");
+        qExpectedInput.push_back("zxcvbnm,.");
+
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 1 }, false, false));
+    });
+
+    Log::Comment(L"Repaint everything. Only the line that changed should be transmitted.");
+    VERIFY_SUCCEEDED(engine->InvalidateAll());
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_TRUE(engine->_invalidMap.all());
+
+        qExpectedInput.push_back("\r");
+        qExpectedInput.push_back("zxcvbnm,!");
+
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2Changed.data(), line2Changed.size() }, { 0, 1 }, false, false));
+    });
+
+    Log::Comment(L"Runs are only skipped when the entire viewport is repainted.");
+    til::rect invalid{ 0, 0, 9, 1 };
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("asdfghjkl");
+
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+    });
+
+    Log::Comment(L"Nothing is skipped after the terminal has been cleared.");
+    VERIFY_SUCCEEDED(engine->InvalidateAll());
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[2J");
+        VERIFY_SUCCEEDED(engine->_ClearScreen());
+
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("asdfghjkl");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+    });
+}
+
 void VtRendererTest::TestCursorVisibility()
 {
     auto view = SetUpViewport();
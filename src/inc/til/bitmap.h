@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <bit>
+
 #include "rect.h"
 
 #ifdef UNIT_TESTING
@@ -13,6 +15,232 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
     namespace details
     {
+        // A fixed-size set of bits, stored as 64-bit words in row-major order.
+        // Unlike dynamic_bitset this allows us to search for both set and unset bits a word at a time,
+        // which is what the run iterator below spends most of its time on.
+        // The bits past size() in the last word are always 0.
+        template<typename Allocator>
+        class _bitmap_words
+        {
+        public:
+            using word_type = unsigned long long;
+            static constexpr size_t bits_per_word = 64;
+
+            explicit _bitmap_words(const Allocator& allocator) noexcept :
+                _words{ allocator }
+            {
+            }
+
+            _bitmap_words(const size_t size, const bool fill, const Allocator& allocator) :
+                _words((size + bits_per_word - 1) / bits_per_word, fill ? ~word_type{ 0 } : 0, allocator),
+                _size{ size }
+            {
+                _sanitize();
+            }
+
+            constexpr bool operator==(const _bitmap_words& other) const noexcept
+            {
+                return _size == other._size && _words == other._words;
+            }
+
+            constexpr size_t size() const noexcept
+            {
+                return _size;
+            }
+
+            constexpr bool operator[](const size_t pos) const noexcept
+            {
+                return (_words[pos / bits_per_word] >> (pos % bits_per_word)) & 1;
+            }
+
+            constexpr size_t count() const noexcept
+            {
+                size_t count = 0;
+                for (const auto w : _words)
+                {
+                    count += std::popcount(w);
+                }
+                return count;
+            }
+
+            constexpr bool none() const noexcept
+            {
+                return std::all_of(_words.begin(), _words.end(), [](const auto w) { return w == 0; });
+            }
+
+            constexpr bool all() const noexcept
+            {
+                const auto full = _size / bits_per_word;
+                const auto remaining = _size % bits_per_word;
+
+                for (size_t i = 0; i < full; ++i)
+                {
+                    if (_words[i] != ~word_type{ 0 })
+                    {
+                        return false;
+                    }
+                }
+
+                return remaining == 0 || _words[full] == _lowMask(remaining);
+            }
+
+            constexpr void set(const size_t pos) noexcept
+            {
+                _words[pos / bits_per_word] |= word_type{ 1 } << (pos % bits_per_word);
+            }
+
+            // Sets (or clears) the len bits starting at pos. The words in between the first and last
+            // one are filled as a whole, which the compiler turns into a vectorized memset.
+            constexpr void set(const size_t pos, const size_t len, const bool value) noexcept
+            {
+                if (len == 0)
+                {
+                    return;
+                }
+
+                const auto end = pos + len;
+                const auto first = pos / bits_per_word;
+                const auto last = (end - 1) / bits_per_word;
+                const auto headMask = ~word_type{ 0 } << (pos % bits_per_word);
+                const auto tailMask = ~word_type{ 0 } >> (bits_per_word - 1 - (end - 1) % bits_per_word);
+
+                if (first == last)
+                {
+                    _apply(_words[first], headMask & tailMask, value);
+                    return;
+                }
+
+                _apply(_words[first], headMask, value);
+                std::fill(_words.begin() + first + 1, _words.begin() + last, value ? ~word_type{ 0 } : 0);
+                _apply(_words[last], tailMask, value);
+            }
+
+            constexpr void set() noexcept
+            {
+                std::fill(_words.begin(), _words.end(), ~word_type{ 0 });
+                _sanitize();
+            }
+
+            constexpr void reset() noexcept
+            {
+                std::fill(_words.begin(), _words.end(), word_type{ 0 });
+            }
+
+            // Moves all bits towards higher positions. The uncovered bits are 0.
+            constexpr _bitmap_words& operator<<=(const size_t shift) noexcept
+            {
+                if (shift >= _size)
+                {
+                    reset();
+                    return *this;
+                }
+
+                const auto wordShift = shift / bits_per_word;
+                const auto bitShift = shift % bits_per_word;
+
+                for (auto i = _words.size(); i-- > wordShift;)
+                {
+                    auto w = _words[i - wordShift] << bitShift;
+                    if (bitShift != 0 && i > wordShift)
+                    {
+                        w |= _words[i - wordShift - 1] >> (bits_per_word - bitShift);
+                    }
+                    _words[i] = w;
+                }
+
+                std::fill_n(_words.begin(), wordShift, word_type{ 0 });
+                _sanitize();
+                return *this;
+            }
+
+            // Moves all bits towards lower positions. The uncovered bits are 0.
+            constexpr _bitmap_words& operator>>=(const size_t shift) noexcept
+            {
+                if (shift >= _size)
+                {
+                    reset();
+                    return *this;
+                }
+
+                const auto wordShift = shift / bits_per_word;
+                const auto bitShift = shift % bits_per_word;
+                const auto count = _words.size() - wordShift;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    auto w = _words[i + wordShift] >> bitShift;
+                    if (bitShift != 0 && i + 1 < count)
+                    {
+                        w |= _words[i + wordShift + 1] << (bits_per_word - bitShift);
+                    }
+                    _words[i] = w;
+                }
+
+                std::fill(_words.begin() + count, _words.end(), word_type{ 0 });
+                return *this;
+            }
+
+            // Returns the position of the first set bit at or after pos, or size() if there's none.
+            constexpr size_t find_next_set(const size_t pos) const noexcept
+            {
+                return _find(pos, _size, 0);
+            }
+
+            // Returns the position of the first unset bit at or after pos, or end if there's none before it.
+            constexpr size_t find_next_unset(const size_t pos, const size_t end) const noexcept
+            {
+                return _find(pos, end, ~word_type{ 0 });
+            }
+
+        private:
+            static constexpr word_type _lowMask(const size_t bits) noexcept
+            {
+                return (word_type{ 1 } << bits) - 1;
+            }
+
+            static constexpr void _apply(word_type& word, const word_type mask, const bool value) noexcept
+            {
+                word = value ? word | mask : word & ~mask;
+            }
+
+            // Finds the first bit in [pos, end) whose value isn't the one given by invert (0 = find set bits).
+            constexpr size_t _find(const size_t pos, const size_t end, const word_type invert) const noexcept
+            {
+                if (pos >= end)
+                {
+                    return end;
+                }
+
+                auto i = pos / bits_per_word;
+                const auto lastWord = (end - 1) / bits_per_word;
+                auto w = (_words[i] ^ invert) & (~word_type{ 0 } << (pos % bits_per_word));
+
+                for (;;)
+                {
+                    if (w != 0)
+                    {
+                        return std::min(end, i * bits_per_word + std::countr_zero(w));
+                    }
+                    if (++i > lastWord)
+                    {
+                        return end;
+                    }
+                    w = _words[i] ^ invert;
+                }
+            }
+
+            constexpr void _sanitize() noexcept
+            {
+                if (const auto remaining = _size % bits_per_word)
+                {
+                    _words.back() &= _lowMask(remaining);
+                }
+            }
+
+            std::vector<word_type, Allocator> _words;
+            size_t _size = 0;
+        };
+
         template<typename Allocator>
         class _bitmap_const_iterator
         {
@@ -23,11 +251,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             using pointer = const til::rect*;
             using reference = const til::rect&;
 
-            _bitmap_const_iterator(const dynamic_bitset<unsigned long long, Allocator>& values, til::rect rc, ptrdiff_t pos) :
+            _bitmap_const_iterator(const _bitmap_words<Allocator>& values, til::rect rc, ptrdiff_t pos) :
                 _values(values),
                 _rc(rc),
                 _pos(pos),
-                _end(rc.size().area())
+                _end(rc.size().area()),
+                _width(rc.narrow_width<size_t>())
             {
                 _calculateArea();
             }
@@ -48,7 +277,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             constexpr bool operator==(const _bitmap_const_iterator& other) const noexcept
             {
-                return _pos == other._pos && _values == other._values;
+                return _pos == other._pos && &_values == &other._values;
             }
 
             constexpr bool operator!=(const _bitmap_const_iterator& other) const noexcept
@@ -77,11 +306,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             }
 
         private:
-            const dynamic_bitset<unsigned long long, Allocator>& _values;
+            const _bitmap_words<Allocator>& _values;
             const til::rect _rc;
             size_t _pos;
             size_t _nextPos;
             const size_t _end;
+            const size_t _width;
             til::rect _run;
 
             // Update _run to contain the next rectangle of consecutively set bits within this bitmap.
@@ -90,42 +320,28 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             {
                 // The following logic first finds the next set bit in this bitmap and the next unset bit past that.
                 // The area in between those positions are thus all set bits and will end up being the next _run.
-
-                // dynamic_bitset allows you to quickly find the next set bit using find_next(prev),
-                // where "prev" is the position _past_ which should be searched (i.e. excluding position "prev").
-                // If _pos is still 0, we thus need to use the counterpart find_first().
-                _nextPos = _pos == 0 ? _values.find_first() : _values.find_next(_pos - 1);
+                // Both searches skip over entire words of unset (or set) bits at once.
+                const auto runStart = _values.find_next_set(_pos);
 
                 // If we haven't reached the end yet...
-                if (_nextPos < _end)
+                if (runStart < _end)
                 {
-                    // pos is now at the first on bit.
-                    // If no next set bit can be found, npos is returned, which is SIZE_T_MAX.
-                    // saturated_cast can ensure that this will be converted to CoordType's max (which is greater than _end).
-                    const auto runStart = _rc.point_at(base::saturated_cast<CoordType>(_nextPos));
-
                     // We'll only count up until the end of this row.
                     // a run can be a max of one row tall.
-                    const size_t rowEndIndex = _rc.index_of<size_t>(til::point(_rc.right - 1, runStart.y)) + 1;
-
-                    // Find the length for the rectangle.
-                    size_t runLength = 0;
-
-                    // We have at least 1 so start with a do/while.
-                    do
-                    {
-                        ++_nextPos;
-                        ++runLength;
-                    } while (_nextPos < rowEndIndex && _values[_nextPos]);
-                    // Keep going until we reach end of row, end of the buffer, or the next bit is off.
+                    const auto y = runStart / _width;
+                    const auto x = runStart % _width;
+                    const auto rowEnd = (y + 1) * _width;
+                    _nextPos = _values.find_next_unset(runStart + 1, rowEnd);
 
                     // Assemble and store that run.
-                    _run = til::rect{ runStart, til::size{ base::saturated_cast<CoordType>(runLength), 1 } };
+                    _run = til::rect{
+                        til::point{ _rc.left + static_cast<CoordType>(x), _rc.top + static_cast<CoordType>(y) },
+                        til::size{ static_cast<CoordType>(_nextPos - runStart), 1 },
+                    };
                 }
                 else
                 {
-                    // If we reached the end _nextPos may be >= _end (potentially even PTRDIFF_T_MAX).
-                    // ---> Mark the end of the iterator by updating the state with _end.
+                    // If we reached the end, mark the end of the iterator by updating the state with _end.
                     _pos = _end;
                     _nextPos = _end;
                     _run = til::rect{};
@@ -172,7 +388,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                 _alloc{ allocator },
                 _sz(sz),
                 _rc(sz),
-                _bits(_sz.area(), fill ? std::numeric_limits<unsigned long long>::max() : 0, _alloc),
+                _bits(_sz.area<size_t>(), fill, _alloc),
                 _runs{ _alloc }
             {
             }
@@ -364,7 +580,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
                 for (auto row = rc.top; row < rc.bottom; ++row)
                 {
-                    _bits.set(_rc.index_of(til::point{ rc.left, row }), rc.width(), true);
+                    _bits.set(_rc.index_of(til::point{ rc.left, row }), rc.narrow_width<size_t>(), true);
                 }
             }
 
@@ -532,7 +748,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             allocator_type _alloc;
             til::size _sz;
             til::rect _rc;
-            dynamic_bitset<unsigned long long, allocator_type> _bits;
+            details::_bitmap_words<allocator_type> _bits;
 
             mutable std::optional<std::vector<til::rect, run_allocator_type>> _runs;
 
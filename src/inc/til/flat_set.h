@@ -147,6 +147,50 @@ namespace til
             }
         }
 
+        // Removes all items for which the predicate returns true and returns their count.
+        // Linear probing doesn't support removing individual items without leaving holes in the probe
+        // sequence behind, which is why this rebuilds the hashmap at its current capacity instead.
+        template<typename Predicate>
+        size_t erase_if(Predicate&& pred)
+        {
+            if (!_map)
+            {
+                return 0;
+            }
+
+            auto oldMap = std::exchange(_map, std::make_unique<T[]>(_capacity));
+            size_t erased = 0;
+
+            for (auto& oldSlot : std::span{ oldMap.get(), _capacity })
+            {
+                if (!oldSlot)
+                {
+                    continue;
+                }
+
+                if (pred(std::as_const(oldSlot)))
+                {
+                    _load -= LoadFactor;
+                    ++erased;
+                    continue;
+                }
+
+                const auto hash = ::std::hash<T>{}(oldSlot) >> _shift;
+
+                for (auto i = hash;; ++i)
+                {
+                    auto& slot = _map[i & _mask];
+                    if (!slot)
+                    {
+                        slot = std::move_if_noexcept(oldSlot);
+                        break;
+                    }
+                }
+            }
+
+            return erased;
+        }
+
     private:
         __declspec(noinline) void _bumpSize()
         {
@@ -200,6 +244,281 @@ namespace til
         size_t _shift = initialShift;
         size_t _mask = 0;
     };
+
+    // A hashmap in the style of Abseil's SwissTable. Alongside each slot it stores a control byte, which
+    // is either empty (0x80) or holds 7 bits of the slot's hash. Lookups compare the control bytes of 16
+    // consecutive slots at once and only compare the slots whose control byte matched against the key.
+    // Since most mismatches are rejected without touching the slots, it can be filled up to 7/8 of
+    // its capacity, which makes it a lot more compact than linear_flat_set with its load of <= 50%.
+    //
+    // It has the same interface and requirements as linear_flat_set: T must be default constructible
+    // into an empty state for which its `operator bool` returns false, it must be comparable with and
+    // assignable from the key type, and std::hash<T> must accept both, T and the key type.
+    // Just like linear_flat_set it's grown by rehashing and recreating the slots.
+    //
+    // It performs best with:
+    // * many items (> 64)
+    // * a high rate of unsuccessful lookups
+    template<typename T>
+    struct swiss_flat_set
+    {
+        swiss_flat_set() = default;
+
+        swiss_flat_set(const swiss_flat_set&) = delete;
+        swiss_flat_set& operator=(const swiss_flat_set&) = delete;
+
+        swiss_flat_set(swiss_flat_set&& other) noexcept :
+            _slots{ std::move(other._slots) },
+            _ctrl{ std::move(other._ctrl) },
+            _capacity{ std::exchange(other._capacity, 0) },
+            _size{ std::exchange(other._size, 0) },
+            _shift{ std::exchange(other._shift, initialShift) },
+            _mask{ std::exchange(other._mask, 0) }
+        {
+        }
+
+        swiss_flat_set& operator=(swiss_flat_set&& other) noexcept
+        {
+            _slots = std::move(other._slots);
+            _ctrl = std::move(other._ctrl);
+            _capacity = std::exchange(other._capacity, 0);
+            _size = std::exchange(other._size, 0);
+            _shift = std::exchange(other._shift, initialShift);
+            _mask = std::exchange(other._mask, 0);
+            return *this;
+        }
+
+        bool empty() const noexcept
+        {
+            return _size == 0;
+        }
+
+        size_t size() const noexcept
+        {
+            return _size;
+        }
+
+        std::span<T> container() const noexcept
+        {
+            return { _slots.get(), _capacity };
+        }
+
+        void clear() noexcept
+        {
+            if (_slots)
+            {
+                std::fill_n(_slots.get(), _capacity, T{});
+                memset(_ctrl.get(), ctrlEmpty, _capacity + groupWidth);
+                _size = 0;
+            }
+        }
+
+        template<typename U>
+        T* lookup(U&& key) const noexcept
+        {
+            if (!_slots)
+            {
+                return nullptr;
+            }
+
+            const auto hash = ::std::hash<T>{}(key);
+            const auto h2 = _h2(hash);
+            auto pos = hash >> _shift;
+
+            for (size_t step = groupWidth;; pos += step, step += groupWidth)
+            {
+                pos &= _mask;
+                const auto group = &_ctrl[pos];
+
+                for (auto m = _match(group, h2); m; m &= m - 1)
+                {
+                    auto& slot = _slots[(pos + std::countr_zero(m)) & _mask];
+                    if (slot == key) [[likely]]
+                    {
+                        return &slot;
+                    }
+                }
+
+                if (_match(group, ctrlEmpty))
+                {
+                    return nullptr;
+                }
+            }
+        }
+
+        template<typename U>
+        std::pair<T&, bool> insert(U&& key)
+        {
+            // Putting this into the lookup path is a little pessimistic, but it
+            // allows us to default-construct this hashmap with a size of 0.
+            if (_size >= _capacity - _capacity / 8) [[unlikely]]
+            {
+                _bumpSize();
+            }
+
+            const auto hash = ::std::hash<T>{}(key);
+            const auto h2 = _h2(hash);
+            auto pos = hash >> _shift;
+
+            for (size_t step = groupWidth;; pos += step, step += groupWidth)
+            {
+                pos &= _mask;
+                const auto group = &_ctrl[pos];
+
+                for (auto m = _match(group, h2); m; m &= m - 1)
+                {
+                    auto& slot = _slots[(pos + std::countr_zero(m)) & _mask];
+                    if (slot == key) [[likely]]
+                    {
+                        return { slot, false };
+                    }
+                }
+
+                // Since items are never removed individually, the first group with an empty slot
+                // along the probe sequence is where lookup() stops and where the item must go.
+                if (const auto m = _match(group, ctrlEmpty))
+                {
+                    const auto i = (pos + std::countr_zero(m)) & _mask;
+                    auto& slot = _slots[i];
+                    slot = std::forward<U>(key);
+                    _setCtrl(i, h2);
+                    _size++;
+                    return { slot, true };
+                }
+            }
+        }
+
+        // Removes all items for which the predicate returns true and returns their count.
+        // Just like linear_flat_set this rebuilds the hashmap at its current capacity,
+        // which avoids the need for tombstones in the control bytes.
+        template<typename Predicate>
+        size_t erase_if(Predicate&& pred)
+        {
+            if (!_slots)
+            {
+                return 0;
+            }
+
+            auto oldSlots = std::exchange(_slots, std::make_unique<T[]>(_capacity));
+            memset(_ctrl.get(), ctrlEmpty, _capacity + groupWidth);
+            size_t erased = 0;
+
+            for (auto& oldSlot : std::span{ oldSlots.get(), _capacity })
+            {
+                if (!oldSlot)
+                {
+                    continue;
+                }
+
+                if (pred(std::as_const(oldSlot)))
+                {
+                    _size--;
+                    ++erased;
+                    continue;
+                }
+
+                _reinsert(oldSlot);
+            }
+
+            return erased;
+        }
+
+    private:
+        static constexpr size_t groupWidth = 16;
+        static constexpr uint8_t ctrlEmpty = 0x80;
+        static constexpr auto digits = std::numeric_limits<size_t>::digits;
+        // This results in an initial capacity of 16 items, a single group.
+        static constexpr auto initialShift = digits - 4;
+
+        // The slot position is taken from the topmost bits of the hash (see flat_set_hash_integer)
+        // and the 7 bits stored in the control bytes are the ones right below them.
+        uint8_t _h2(size_t hash) const noexcept
+        {
+            return static_cast<uint8_t>((hash >> (_shift - 7)) & 0x7f);
+        }
+
+        // Returns a bitmask with bit N set if the control byte group[N] equals `value`.
+        static uint32_t _match(const uint8_t* group, uint8_t value) noexcept
+        {
+#if defined(TIL_SSE_INTRINSICS)
+            const auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            const auto needle = _mm_set1_epi8(static_cast<char>(value));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, needle)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < groupWidth; ++i)
+            {
+                mask |= static_cast<uint32_t>(group[i] == value) << i;
+            }
+            return mask;
+#endif
+        }
+
+        // The first groupWidth control bytes are mirrored past the end of _ctrl,
+        // so that _match() can read a group starting at any position without wrapping around.
+        void _setCtrl(size_t i, uint8_t h2) noexcept
+        {
+            _ctrl[i] = h2;
+            if (i < groupWidth)
+            {
+                _ctrl[_capacity + i] = h2;
+            }
+        }
+
+        // Inserts an item that's known not to exist yet, without the lookup part of insert().
+        void _reinsert(T& item) noexcept
+        {
+            const auto hash = ::std::hash<T>{}(item);
+            auto pos = hash >> _shift;
+
+            for (size_t step = groupWidth;; pos += step, step += groupWidth)
+            {
+                pos &= _mask;
+                if (const auto m = _match(&_ctrl[pos], ctrlEmpty))
+                {
+                    const auto i = (pos + std::countr_zero(m)) & _mask;
+                    _slots[i] = std::move_if_noexcept(item);
+                    _setCtrl(i, _h2(hash));
+                    return;
+                }
+            }
+        }
+
+        __declspec(noinline) void _bumpSize()
+        {
+            // The control bytes need 7 bits of the hash below the ones used for the slot position.
+            if (_shift <= 7)
+            {
+                throw std::bad_array_new_length{};
+            }
+
+            const auto newShift = _capacity ? _shift - 1 : _shift;
+            const auto newCapacity = size_t{ 1 } << (digits - newShift);
+            auto oldSlots = std::exchange(_slots, std::make_unique<T[]>(newCapacity));
+            const auto oldCapacity = _capacity;
+
+            _ctrl = std::make_unique_for_overwrite<uint8_t[]>(newCapacity + groupWidth);
+            memset(_ctrl.get(), ctrlEmpty, newCapacity + groupWidth);
+            _capacity = newCapacity;
+            _shift = newShift;
+            _mask = newCapacity - 1;
+
+            for (auto& oldSlot : std::span{ oldSlots.get(), oldCapacity })
+            {
+                if (oldSlot)
+                {
+                    _reinsert(oldSlot);
+                }
+            }
+        }
+
+        std::unique_ptr<T[]> _slots;
+        std::unique_ptr<uint8_t[]> _ctrl;
+        size_t _capacity = 0;
+        size_t _size = 0;
+        size_t _shift = initialShift;
+        size_t _mask = 0;
+    };
 }
 
 #pragma warning(pop)
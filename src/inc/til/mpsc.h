@@ -0,0 +1,451 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <bit>
+
+#include "spsc.h"
+
+// til: Terminal Implementation Library. Also: "Today I Learned".
+// mpsc: Multi Producer Single Consumer. A MPSC queue/channel sends data from any number of senders to one receiver.
+//
+// The API mirrors til::spsc, except that producers can be copied.
+// Blocking waits are implemented on top of the same futex-like primitive as til::spsc.
+namespace til::mpsc
+{
+    using size_type = spsc::size_type;
+
+    using spsc::block_forever;
+    using spsc::block_initially;
+
+    namespace details
+    {
+        // The queue is a bounded ring buffer with a sequence number per slot (Dmitry Vyukov's design):
+        // * A slot whose sequence is equal to a producer position is free and may be written to.
+        //   Producers race for positions with a CAS on _tail and publish a slot by setting its sequence to position + 1.
+        // * A slot whose sequence is equal to the consumer position + 1 contains a value.
+        //   After reading it the consumer frees it for the next revolution by setting its sequence to position + capacity.
+        // The positions and sequence numbers are allowed to wrap around, which is why they're always compared via
+        // their signed difference. That's also why the capacity must be a power of 2 and smaller than 2^31.
+        //
+        // Since slots are only ever loaded and stored, blocking is implemented using two counters instead:
+        // _pushed is incremented after each push and the consumer waits on it while the queue is empty,
+        // _popped is incremented after each pop and the producers wait on it while the queue is full.
+        template<typename T>
+        struct queue
+        {
+            explicit queue(size_type capacity) :
+                _slots(std::make_unique<slot[]>(capacity)),
+                _mask(capacity - 1)
+            {
+                for (size_type i = 0; i < capacity; ++i)
+                {
+                    _slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            queue(const queue&) = delete;
+            queue& operator=(const queue&) = delete;
+
+            ~queue()
+            {
+                while (try_pop())
+                {
+                }
+            }
+
+            void add_producer() noexcept
+            {
+                _producers.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void drop_producer() noexcept
+            {
+                // The last producer wakes up the consumer, so that it can notice that no more values will arrive.
+                if (_producers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    _pushed.fetch_add(1, std::memory_order_release);
+                    _pushed.notify_one();
+                }
+            }
+
+            void drop_consumer() noexcept
+            {
+                _consumerAlive.store(false, std::memory_order_relaxed);
+                _popped.fetch_add(1, std::memory_order_release);
+                _popped.notify_all();
+            }
+
+            template<typename... Args>
+            bool emplace(bool blocking, Args&&... args)
+            {
+                for (;;)
+                {
+                    const auto popped = _popped.load(std::memory_order_acquire);
+                    if (!_consumerAlive.load(std::memory_order_relaxed))
+                    {
+                        return false;
+                    }
+                    if (try_emplace(std::forward<Args>(args)...))
+                    {
+                        return true;
+                    }
+                    if (!blocking)
+                    {
+                        return false;
+                    }
+                    _popped.wait(popped, std::memory_order_relaxed);
+                }
+            }
+
+            // Returns false if the queue is full. The arguments are only consumed on success.
+            template<typename... Args>
+            bool try_emplace(Args&&... args)
+            {
+                auto pos = _tail.load(std::memory_order_relaxed);
+
+                for (;;)
+                {
+                    auto& s = _slots[pos & _mask];
+                    const auto diff = static_cast<int32_t>(s.sequence.load(std::memory_order_acquire) - pos);
+
+                    if (diff == 0)
+                    {
+                        if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            new (s.value()) T(std::forward<Args>(args)...);
+                            s.sequence.store(pos + 1, std::memory_order_release);
+                            _pushed.fetch_add(1, std::memory_order_release);
+                            _pushed.notify_one();
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // The slot still contains the value of the previous revolution: We're full.
+                        return false;
+                    }
+                    else
+                    {
+                        // Another producer got this position before us.
+                        pos = _tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Moves up to count values into first and advances it. If blocking is true and the queue is empty,
+            // this waits until at least one value arrives. The second member of the pair is false
+            // if the queue is empty and all producers have been dropped.
+            template<typename OutputIt>
+            std::pair<size_t, bool> pop_n(bool blocking, OutputIt& first, size_t count)
+            {
+                size_t got = 0;
+
+                for (;;)
+                {
+                    const auto pushed = _pushed.load(std::memory_order_acquire);
+
+                    for (; got < count; ++got)
+                    {
+                        auto& s = _slots[_head & _mask];
+                        if (static_cast<int32_t>(s.sequence.load(std::memory_order_acquire) - (_head + 1)) < 0)
+                        {
+                            break;
+                        }
+
+                        const auto value = s.value();
+                        *first = std::move(*value);
+                        ++first;
+                        std::destroy_at(value);
+                        s.sequence.store(_head + _mask + 1, std::memory_order_release);
+                        ++_head;
+                    }
+
+                    if (got)
+                    {
+                        _popped.fetch_add(1, std::memory_order_release);
+                        _popped.notify_all();
+                        return { got, true };
+                    }
+                    if (count == 0)
+                    {
+                        return { 0, true };
+                    }
+                    // Values pushed before the last producer was dropped are visible to us at this point,
+                    // because the slots are checked after loading _producers (which was decremented after those pushes).
+                    if (_producers.load(std::memory_order_acquire) == 0 && _isEmpty())
+                    {
+                        return { 0, false };
+                    }
+                    if (!blocking)
+                    {
+                        return { 0, true };
+                    }
+
+                    _pushed.wait(pushed, std::memory_order_relaxed);
+                }
+            }
+
+            std::optional<T> try_pop()
+            {
+                std::optional<T> value;
+                _pop_into(value, false);
+                return value;
+            }
+
+            std::optional<T> pop()
+            {
+                std::optional<T> value;
+                _pop_into(value, true);
+                return value;
+            }
+
+        private:
+            struct slot
+            {
+                T* value() noexcept
+                {
+                    return std::launder(reinterpret_cast<T*>(&storage[0]));
+                }
+
+                std::atomic<size_type> sequence{ 0 };
+                alignas(T) std::byte storage[sizeof(T)];
+            };
+
+            // An output iterator that emplaces into an optional, so that pop() can share the logic with pop_n().
+            struct optional_inserter
+            {
+                using iterator_category = std::output_iterator_tag;
+                using difference_type = ptrdiff_t;
+
+                optional_inserter& operator*() noexcept
+                {
+                    return *this;
+                }
+                optional_inserter& operator=(T&& value)
+                {
+                    target->emplace(std::move(value));
+                    return *this;
+                }
+                optional_inserter& operator++() noexcept
+                {
+                    return *this;
+                }
+
+                std::optional<T>* target;
+            };
+
+            void _pop_into(std::optional<T>& value, bool blocking)
+            {
+                optional_inserter it{ &value };
+                pop_n(blocking, it, 1);
+            }
+
+            bool _isEmpty() const noexcept
+            {
+                const auto& s = _slots[_head & _mask];
+                return static_cast<int32_t>(s.sequence.load(std::memory_order_acquire) - (_head + 1)) < 0;
+            }
+
+            std::unique_ptr<slot[]> _slots;
+            const size_type _mask;
+
+            // The producers and the consumer are kept on separate cache lines, so that they don't slow each other down.
+            alignas(std::hardware_destructive_interference_size) std::atomic<size_type> _tail{ 0 };
+            alignas(std::hardware_destructive_interference_size) size_type _head = 0;
+
+            spsc::details::atomic_size_type _pushed;
+            spsc::details::atomic_size_type _popped;
+            std::atomic<size_t> _producers{ 0 };
+            std::atomic<bool> _consumerAlive{ true };
+        };
+
+        inline size_type validate_capacity(size_t capacity)
+        {
+            if (capacity == 0 || capacity > (size_t{ 1 } << 30))
+            {
+                throw std::overflow_error{ "invalid capacity for mpsc" };
+            }
+            // Round up to the next power of 2.
+            return static_cast<size_type>(std::bit_ceil(capacity));
+        }
+    }
+
+    template<typename T>
+    struct producer
+    {
+        explicit producer(std::shared_ptr<details::queue<T>> queue) noexcept :
+            _queue(std::move(queue))
+        {
+            if (_queue)
+            {
+                _queue->add_producer();
+            }
+        }
+
+        producer(const producer<T>& other) noexcept :
+            producer(other._queue)
+        {
+        }
+
+        producer<T>& operator=(const producer<T>& other) noexcept
+        {
+            if (this != &other)
+            {
+                drop();
+                _queue = other._queue;
+                if (_queue)
+                {
+                    _queue->add_producer();
+                }
+            }
+            return *this;
+        }
+
+        producer(producer<T>&& other) noexcept :
+            _queue(std::move(other._queue))
+        {
+        }
+
+        producer<T>& operator=(producer<T>&& other) noexcept
+        {
+            drop();
+            _queue = std::move(other._queue);
+            return *this;
+        }
+
+        ~producer()
+        {
+            drop();
+        }
+
+        // Blocks until there's space in the queue. Returns false if the consumer has been dropped.
+        template<typename... Args>
+        bool emplace(Args&&... args) const
+        {
+            return _queue->emplace(true, std::forward<Args>(args)...);
+        }
+
+        // Returns false without consuming the arguments, if the queue is full or the consumer has been dropped.
+        template<typename... Args>
+        bool try_emplace(Args&&... args) const
+        {
+            return _queue->emplace(false, std::forward<Args>(args)...);
+        }
+
+    private:
+        void drop() noexcept
+        {
+            if (_queue)
+            {
+                _queue->drop_producer();
+                _queue.reset();
+            }
+        }
+
+        std::shared_ptr<details::queue<T>> _queue;
+    };
+
+    template<typename T>
+    struct consumer
+    {
+        explicit consumer(std::shared_ptr<details::queue<T>> queue) noexcept :
+            _queue(std::move(queue))
+        {
+        }
+
+        consumer(const consumer<T>&) = delete;
+        consumer<T>& operator=(const consumer<T>&) = delete;
+
+        consumer(consumer<T>&& other) noexcept :
+            _queue(std::move(other._queue))
+        {
+        }
+
+        consumer<T>& operator=(consumer<T>&& other) noexcept
+        {
+            drop();
+            _queue = std::move(other._queue);
+            return *this;
+        }
+
+        ~consumer()
+        {
+            drop();
+        }
+
+        // Blocks until a value arrives. Returns std::nullopt once all producers have been dropped.
+        std::optional<T> pop() const
+        {
+            return _queue->pop();
+        }
+
+        std::optional<T> try_pop() const
+        {
+            return _queue->try_pop();
+        }
+
+        // Moves up to count values that are available right away into first, waiting for at
+        // least one of them. The second member of the result is false if all producers have been
+        // dropped and the queue is empty.
+        template<typename OutputIt>
+        std::pair<size_t, bool> pop_n(OutputIt first, size_t count) const
+        {
+            return pop_n(block_initially, first, count);
+        }
+
+        // Just like til::spsc, block_initially only waits for the first value,
+        // whereas block_forever waits until all count values have been received.
+        template<typename WaitPolicy, typename OutputIt, spsc::details::enable_if_wait_policy_t<WaitPolicy> = 0>
+        std::pair<size_t, bool> pop_n(WaitPolicy&&, OutputIt first, size_t count) const
+        {
+            size_t got = 0;
+
+            while (got < count)
+            {
+                const auto [n, ok] = _queue->pop_n(true, first, count - got);
+                got += n;
+
+                if (!ok)
+                {
+                    return { got, false };
+                }
+                if constexpr (!std::remove_reference_t<WaitPolicy>::_block_forever)
+                {
+                    break;
+                }
+            }
+
+            return { got, true };
+        }
+
+        // Moves up to count values that are available right away into first, without blocking.
+        template<typename OutputIt>
+        std::pair<size_t, bool> try_pop_n(OutputIt first, size_t count) const
+        {
+            return _queue->pop_n(false, first, count);
+        }
+
+    private:
+        void drop() noexcept
+        {
+            if (_queue)
+            {
+                _queue->drop_consumer();
+                _queue.reset();
+            }
+        }
+
+        std::shared_ptr<details::queue<T>> _queue;
+    };
+
+    // Returns a bounded queue with room for at least the given number of values.
+    // The capacity is rounded up to the next power of 2.
+    template<typename T>
+    std::pair<producer<T>, consumer<T>> channel(size_t capacity)
+    {
+        auto queue = std::make_shared<details::queue<T>>(details::validate_capacity(capacity));
+        return { producer<T>{ queue }, consumer<T>{ queue } };
+    }
+}
@@ -70,4 +70,144 @@ namespace til::pmr
         return std::pmr::get_default_resource();
     }
 #endif
+
+    // A bump allocator for short-lived temporaries. Deallocation is a no-op and
+    // all memory is handed out again after a reset(). Unlike
+    // std::pmr::monotonic_buffer_resource the blocks aren't returned upstream on
+    // reset(), so that a steady-state workload stops touching the heap entirely.
+    class arena_resource : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr size_t default_block_size = 64 * 1024;
+
+        explicit arena_resource(const size_t blockSize = default_block_size, std::pmr::memory_resource* upstream = get_default_resource()) noexcept :
+            _upstream{ upstream },
+            _blockSize{ blockSize }
+        {
+        }
+
+        arena_resource(const arena_resource&) = delete;
+        arena_resource& operator=(const arena_resource&) = delete;
+
+        ~arena_resource() override
+        {
+            _release();
+        }
+
+        // Makes all memory available again. Any memory handed out until now must not be used anymore.
+        void reset() noexcept
+        {
+            // If the last cycle needed more than one block, we replace them with a single one that
+            // fits everything, so that the next cycle doesn't need to skip between blocks anymore.
+            if (_blocks.size() > 1)
+            {
+                size_t total = 0;
+                for (const auto& b : _blocks)
+                {
+                    total += b.size;
+                }
+
+                _release();
+                _blockSize = std::max(_blockSize, total);
+            }
+
+            _index = 0;
+            _offset = 0;
+        }
+
+    private:
+        struct block
+        {
+            std::byte* data;
+            size_t size;
+            size_t align;
+        };
+
+        void* do_allocate(const size_t bytes, const size_t align) override
+        {
+            for (; _index < _blocks.size(); ++_index, _offset = 0)
+            {
+                const auto& b = _blocks[_index];
+                const auto beg = reinterpret_cast<uintptr_t>(b.data);
+                const auto ptr = (beg + _offset + align - 1) & ~(uintptr_t{ align } - 1);
+
+                if (ptr + bytes <= beg + b.size)
+                {
+                    _offset = ptr + bytes - beg;
+                    return reinterpret_cast<void*>(ptr);
+                }
+            }
+
+            _blocks.reserve(_blocks.size() + 1);
+
+            const auto size = std::max(_blockSize, bytes);
+            const auto blockAlign = std::max(align, alignof(std::max_align_t));
+            const auto data = static_cast<std::byte*>(_upstream->allocate(size, blockAlign));
+            _blocks.emplace_back(block{ data, size, blockAlign });
+            _index = _blocks.size() - 1;
+            _offset = bytes;
+            return data;
+        }
+
+        void do_deallocate(void*, size_t, size_t) noexcept override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        void _release() noexcept
+        {
+            for (const auto& b : _blocks)
+            {
+                _upstream->deallocate(b.data, b.size, b.align);
+            }
+            _blocks.clear();
+        }
+
+        friend class frame_scope;
+
+        std::pmr::memory_resource* _upstream;
+        std::vector<block> _blocks;
+        size_t _blockSize;
+        size_t _index = 0;
+        size_t _offset = 0;
+        size_t _depth = 0;
+    };
+
+    // Returns this thread's arena for temporaries that don't outlive the current
+    // frame (rendering) or the current write (parsing). Only use it within a frame_scope.
+    [[nodiscard]] inline arena_resource* get_frame_arena() noexcept
+    {
+        thread_local arena_resource arena;
+        return &arena;
+    }
+
+    // Marks the lifetime of the allocations made from get_frame_arena().
+    // Scopes may be nested and the arena is reset once the outermost one ends.
+    class frame_scope
+    {
+    public:
+        frame_scope() noexcept :
+            _arena{ get_frame_arena() }
+        {
+            _arena->_depth++;
+        }
+
+        frame_scope(const frame_scope&) = delete;
+        frame_scope& operator=(const frame_scope&) = delete;
+
+        ~frame_scope()
+        {
+            if (--_arena->_depth == 0)
+            {
+                _arena->reset();
+            }
+        }
+
+    private:
+        arena_resource* _arena;
+    };
 }
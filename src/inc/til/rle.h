@@ -307,6 +307,14 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         using rle_type = rle_pair<value_type, size_type>;
         using container = Container;
 
+        // A single replacement of the range [begin, end) with value, as used by replace_runs().
+        struct range_replacement
+        {
+            size_type begin;
+            size_type end;
+            value_type value;
+        };
+
         // We don't check anywhere whether a size_type value is negative.
         // Having signed integers would break that.
         static_assert(std::is_unsigned_v<size_type>, "the run length S must be unsigned");
@@ -493,6 +501,90 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             _replace_unchecked(start_index, end_index, replacements._runs);
         }
 
+        // Replaces each of the ranges [begin, end) with its value.
+        // This is equivalent to calling replace() for each of them in order, but the runs are rebuilt in a single
+        // linear pass, instead of being scanned from the start for every single replacement.
+        // The ranges must be sorted and must not overlap. If an end is larger than size() it's set to size().
+        void replace_runs(const std::span<const range_replacement> replacements)
+        {
+            if (replacements.empty())
+            {
+                return;
+            }
+
+            // A single replacement is done in place without having to rebuild the runs.
+            if (replacements.size() == 1)
+            {
+                const auto& replacement = replacements.front();
+                replace(replacement.begin, replacement.end, replacement.value);
+                return;
+            }
+
+            container runs;
+            auto it = _runs.begin();
+            // The position of the first element of the run "it" points to.
+            size_type it_pos = 0;
+            // The position up to which we've filled up "runs".
+            size_type pos = 0;
+
+            const auto append = [&](const value_type& value, const size_type length) {
+                if (length == 0)
+                {
+                    return;
+                }
+                if (!runs.empty() && runs.back().value == value)
+                {
+                    runs.back().length += length;
+                }
+                else
+                {
+                    runs.emplace_back(value, length);
+                }
+            };
+            // Copies the existing runs in the range [pos, until) over.
+            const auto copy_until = [&](const size_type until) {
+                while (pos < until)
+                {
+                    const size_type run_end = it_pos + it->length;
+                    const auto stop = std::min(run_end, until);
+                    append(it->value, static_cast<size_type>(stop - pos));
+                    pos = stop;
+                    if (pos == run_end)
+                    {
+                        it_pos = run_end;
+                        ++it;
+                    }
+                }
+            };
+            // Skips the existing runs in the range [pos, until).
+            const auto skip_until = [&](const size_type until) {
+                while (it != _runs.end() && it_pos + it->length <= until)
+                {
+                    it_pos += it->length;
+                    ++it;
+                }
+                pos = until;
+            };
+
+            size_type previous_end = 0;
+            for (const auto& replacement : replacements)
+            {
+                const auto end_index = std::min(replacement.end, _total_length);
+                if (replacement.begin < previous_end || replacement.begin > end_index)
+                {
+                    throw std::out_of_range("replacements must be sorted and must not overlap");
+                }
+
+                copy_until(replacement.begin);
+                append(replacement.value, static_cast<size_type>(end_index - replacement.begin));
+                skip_until(end_index);
+                previous_end = end_index;
+            }
+
+            copy_until(_total_length);
+            _runs = std::move(runs);
+        }
+
         // Replaces every instance of old_value in this vector with new_value.
         void replace_values(const value_type& old_value, const value_type& new_value)
         {
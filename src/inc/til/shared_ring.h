@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+// shared_ring: A single producer, single consumer byte ring buffer in memory that's shared between two processes.
+//
+// Like til::spsc, the producer and the consumer each own one of the two positions. Unlike til::spsc,
+// which blocks with WaitOnAddress(), this has to work across processes and uses two auto-reset events.
+// A side only signals an event if the other side announced that it's about to wait for it. As long as
+// the ring is neither empty nor full, reading and writing is thus entirely free of system calls.
+//
+// The file mapping and the two events are created with create() by one process and passed to the other
+// one, usually by handle inheritance. Both processes then construct their endpoint from these handles.
+namespace til::shared_ring
+{
+    namespace details
+    {
+        inline constexpr uint32_t magic = 0x474e5253; // "SRNG"
+
+        // The layout of the beginning of the file mapping. The ring's contents follow it.
+        struct header
+        {
+            uint32_t magic;
+            // The size of the ring in bytes. A power of two, so that positions can be wrapped with a mask.
+            uint32_t capacity;
+
+            // The positions count the total number of bytes written and read. Only their owner modifies them.
+            // They're on separate cache lines, so that the two processes don't contend over them.
+            alignas(64) std::atomic<uint64_t> producer;
+            std::atomic<uint32_t> producerWaiting;
+            alignas(64) std::atomic<uint64_t> consumer;
+            std::atomic<uint32_t> consumerWaiting;
+            alignas(64) std::atomic<uint32_t> closed;
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free);
+        static_assert(std::atomic<uint32_t>::is_always_lock_free);
+    }
+
+    struct handles
+    {
+        wil::unique_handle section;
+        // Signaled by the producer if the consumer waits for data.
+        wil::unique_event data;
+        // Signaled by the consumer if the producer waits for space.
+        wil::unique_event space;
+    };
+
+    constexpr size_t mapping_size(const uint32_t capacity) noexcept
+    {
+        return sizeof(details::header) + capacity;
+    }
+
+    // Creates the (non-inheritable) handles for a new ring of the given capacity, which must be a power of two.
+    inline handles create(const uint32_t capacity)
+    {
+        THROW_HR_IF(E_INVALIDARG, capacity == 0 || (capacity & (capacity - 1)) != 0);
+
+        handles h;
+        const auto size = static_cast<uint64_t>(mapping_size(capacity));
+        h.section.reset(CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr));
+        THROW_LAST_ERROR_IF_NULL(h.section);
+        h.data.create(wil::EventOptions::None);
+        h.space.create(wil::EventOptions::None);
+
+        // Fresh page file backed mappings are zeroed. Only the fixed fields need to be set up.
+        const wil::unique_mapview_ptr<details::header> view{ static_cast<details::header*>(MapViewOfFile(h.section.get(), FILE_MAP_WRITE, 0, 0, 0)) };
+        THROW_LAST_ERROR_IF_NULL(view);
+        view->magic = details::magic;
+        view->capacity = capacity;
+
+        return h;
+    }
+
+    namespace details
+    {
+        class endpoint
+        {
+        public:
+            endpoint(const endpoint&) = delete;
+            endpoint& operator=(const endpoint&) = delete;
+
+            // Dropping either endpoint closes the ring, which wakes up the other side.
+            ~endpoint()
+            {
+                close();
+            }
+
+            // Tells the other side to stop and wakes it up if it's waiting.
+            void close() noexcept
+            {
+                _header->closed.store(1, std::memory_order_release);
+                SetEvent(_handles.data.get());
+                SetEvent(_handles.space.get());
+            }
+
+        protected:
+            explicit endpoint(handles&& h) :
+                _handles{ std::move(h) }
+            {
+                _view.reset(static_cast<header*>(MapViewOfFile(_handles.section.get(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0)));
+                THROW_LAST_ERROR_IF_NULL(_view);
+
+                MEMORY_BASIC_INFORMATION info{};
+                THROW_LAST_ERROR_IF(!VirtualQuery(_view.get(), &info, sizeof(info)));
+
+                // The other process might be compromised or just be a different version. Don't trust the header.
+                // The capacity is copied, because only the value validated here is safe to use for indexing.
+                _header = _view.get();
+                _capacity = _header->capacity;
+                THROW_HR_IF(E_INVALIDARG, _header->magic != magic || _capacity == 0 || (_capacity & (_capacity - 1)) != 0 || info.RegionSize < mapping_size(_capacity));
+                _data = reinterpret_cast<char*>(_header + 1);
+            }
+
+            // Announces that the caller is about to wait on `event`, unless `changed` returns true after doing so, in
+            // which case there's no need to. The recheck after the announcement ensures that the other side either
+            // observes the announcement and signals the event, or that we observe its change. seq_cst is required
+            // on both sides for this, because it's a store followed by a load of a different variable.
+            template<typename Changed>
+            bool _prepareWait(std::atomic<uint32_t>& waiting, Changed&& changed) noexcept
+            {
+                waiting.store(1, std::memory_order_seq_cst);
+                if (changed() || _header->closed.load(std::memory_order_seq_cst))
+                {
+                    waiting.store(0, std::memory_order_relaxed);
+                    return false;
+                }
+                return true;
+            }
+
+            static void _notify(std::atomic<uint32_t>& waiting, const wil::unique_event& event) noexcept
+            {
+                if (waiting.exchange(0, std::memory_order_seq_cst))
+                {
+                    SetEvent(event.get());
+                }
+            }
+
+            handles _handles;
+            wil::unique_mapview_ptr<header> _view;
+            header* _header = nullptr;
+            char* _data = nullptr;
+            uint32_t _capacity = 0;
+        };
+    }
+
+    class producer : public details::endpoint
+    {
+    public:
+        explicit producer(handles&& h) :
+            endpoint{ std::move(h) }
+        {
+        }
+
+        // Copies all of `data` into the ring, blocking while it's full.
+        // Returns false if the ring has been closed, in which case the rest of the data is dropped.
+        bool write(std::string_view data) noexcept
+        {
+            const auto mask = _capacity - 1;
+            auto pos = _header->producer.load(std::memory_order_relaxed);
+
+            while (!data.empty())
+            {
+                if (_header->closed.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+
+                const auto consumer = _header->consumer.load(std::memory_order_acquire);
+                const auto used = pos - consumer;
+                if (used > _capacity)
+                {
+                    // The positions are corrupted. There's no way to recover from that.
+                    close();
+                    return false;
+                }
+
+                if (used == _capacity)
+                {
+                    if (_prepareWait(_header->producerWaiting, [&]() noexcept { return _header->consumer.load(std::memory_order_seq_cst) != consumer; }))
+                    {
+                        WaitForSingleObject(_handles.space.get(), INFINITE);
+                    }
+                    continue;
+                }
+
+                const auto count = std::min<size_t>(data.size(), _capacity - used);
+                const auto offset = static_cast<size_t>(pos & mask);
+                const auto first = std::min<size_t>(count, _capacity - offset);
+                memcpy(_data + offset, data.data(), first);
+                memcpy(_data, data.data() + first, count - first);
+
+                pos += count;
+                data = data.substr(count);
+
+                _header->producer.store(pos, std::memory_order_seq_cst);
+                _notify(_header->consumerWaiting, _handles.data);
+            }
+
+            return true;
+        }
+    };
+
+    class consumer : public details::endpoint
+    {
+    public:
+        explicit consumer(handles&& h) :
+            endpoint{ std::move(h) }
+        {
+        }
+
+        // Waits until data is available and returns as much of it as is contiguous in memory.
+        // The data stays valid until it's released with consume().
+        //
+        // Returns an empty view if the ring has been closed and is drained, or if `peer` got signaled and there's
+        // no data left. `peer` is an optional handle, usually the producer process, whose signaling ends the wait.
+        std::string_view read(const HANDLE peer = nullptr) noexcept
+        {
+            const auto mask = _capacity - 1;
+            const auto pos = _header->consumer.load(std::memory_order_relaxed);
+            auto peerSignaled = false;
+
+            for (;;)
+            {
+                const auto producer = _header->producer.load(std::memory_order_acquire);
+                const auto available = producer - pos;
+                if (available > _capacity)
+                {
+                    close();
+                    return {};
+                }
+
+                if (available != 0)
+                {
+                    const auto offset = static_cast<size_t>(pos & mask);
+                    const auto count = std::min<size_t>(static_cast<size_t>(available), _capacity - offset);
+                    return { _data + offset, count };
+                }
+
+                if (peerSignaled || _header->closed.load(std::memory_order_acquire))
+                {
+                    return {};
+                }
+
+                if (_prepareWait(_header->consumerWaiting, [&]() noexcept { return _header->producer.load(std::memory_order_seq_cst) != producer; }))
+                {
+                    const HANDLE events[2]{ _handles.data.get(), peer };
+                    // If the peer got signaled, there may still be data that was written right before.
+                    // Loop around once more to drain it, but without waiting again.
+                    peerSignaled = WaitForMultipleObjects(peer ? 2 : 1, &events[0], FALSE, INFINITE) != WAIT_OBJECT_0;
+                }
+            }
+        }
+
+        // Releases the first `count` bytes returned by read(), making room for the producer.
+        void consume(const size_t count) noexcept
+        {
+            const auto pos = _header->consumer.load(std::memory_order_relaxed) + count;
+            _header->consumer.store(pos, std::memory_order_seq_cst);
+            _notify(_header->producerWaiting, _handles.space);
+        }
+    };
+}
@@ -583,6 +583,29 @@ namespace til
             });
         }
 
+        // Like resize(), but new elements are default-initialized instead of value-initialized,
+        // similar to std::make_unique_for_overwrite. For trivial types like BYTE this leaves them
+        // uninitialized, which is useful if the caller is going to overwrite them anyways.
+        void resize_for_overwrite(size_type new_size)
+        {
+            _generic_resize(new_size, [](auto&& beg, auto&& end) {
+                std::uninitialized_default_construct(beg, end);
+            });
+        }
+
+        // Mirrors std::basic_string::resize_and_overwrite from C++23: Resizes the vector to `count`
+        // default-initialized elements and calls op(data(), count), which overwrites them and returns
+        // the final size (<= count). This allows til::details::resize_and_overwrite and thus til::u8u16
+        // to write straight into a small_vector. op must not throw.
+        template<typename Op>
+        void resize_and_overwrite(size_type count, Op op)
+        {
+            resize_for_overwrite(count);
+            const auto new_size = static_cast<size_type>(std::move(op)(data(), count));
+            assert(new_size <= count);
+            resize(new_size);
+        }
+
         void shrink_to_fit()
         {
             if (_capacity == N || _size == _capacity)
@@ -65,6 +65,14 @@ namespace til::spsc
                 _value.store(desired, order);
             }
 
+            size_type fetch_add(size_type arg, std::memory_order order) noexcept
+            {
+#if _TIL_SPSC_DETAIL_POSITION_IMPL_FALLBACK
+                std::lock_guard<std::mutex> lock{ _m };
+#endif
+                return _value.fetch_add(arg, order);
+            }
+
             void wait(size_type old, [[maybe_unused]] std::memory_order order) const noexcept
             {
 #if _TIL_SPSC_DETAIL_POSITION_IMPL_WIN
@@ -89,6 +97,17 @@ namespace til::spsc
 #endif
             }
 
+            void notify_all() noexcept
+            {
+#if _TIL_SPSC_DETAIL_POSITION_IMPL_WIN
+                WakeByAddressAll(&_value);
+#elif _TIL_SPSC_DETAIL_POSITION_IMPL_LINUX
+                futex(FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max());
+#elif _TIL_SPSC_DETAIL_POSITION_IMPL_FALLBACK
+                _cv.notify_all();
+#endif
+            }
+
         private:
 #if _TIL_SPSC_DETAIL_POSITION_IMPL_LINUX
             inline void futex(int futex_op, size_type val) const noexcept
@@ -555,20 +574,13 @@ namespace til::spsc
         // pop returns the next item in the queue, or std::nullopt if the producer is gone.
         std::optional<T> pop() const
         {
-            auto acquisition = _arc->consumer_acquire(1, true);
-            if (!acquisition.end)
-            {
-                return std::nullopt;
-            }
-
-            auto data = _arc->data();
-            auto begin = data + acquisition.begin;
-
-            auto item = std::move(*begin);
-            std::destroy_at(begin);
+            return _pop(true);
+        }
 
-            _arc->consumer_release(acquisition);
-            return item;
+        // try_pop is like pop, but returns std::nullopt instead of blocking if the queue is empty.
+        std::optional<T> try_pop() const
+        {
+            return _pop(false);
         }
 
         template<typename OutputIt>
@@ -618,6 +630,24 @@ namespace til::spsc
         }
 
     private:
+        std::optional<T> _pop(bool blocking) const
+        {
+            auto acquisition = _arc->consumer_acquire(1, blocking);
+            if (!acquisition.end)
+            {
+                return std::nullopt;
+            }
+
+            auto data = _arc->data();
+            auto begin = data + acquisition.begin;
+
+            auto item = std::move(*begin);
+            std::destroy_at(begin);
+
+            _arc->consumer_release(acquisition);
+            return item;
+        }
+
         void drop()
         {
             if (_arc)
@@ -13,6 +13,9 @@
 // A failure to sort your keys will result in unusual
 // runtime behavior, but no error messages will be
 // generated.
+//
+// til::perfect_static_map is a variant for string keys
+// that looks them up with a perfect hash instead.
 
 namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
@@ -95,6 +98,219 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         }
     };
 
+    namespace details
+    {
+        // FNV-1a over the code units of the string. It's only used to pick a bucket
+        // and a slot in perfect_static_map, after being scrambled by perfect_hash_mix.
+        template<typename K>
+        constexpr uint64_t perfect_hash(const K& key) noexcept
+        {
+            uint64_t h = UINT64_C(14695981039346656037);
+            for (const auto ch : key)
+            {
+                h ^= static_cast<uint64_t>(ch);
+                h *= UINT64_C(1099511628211);
+            }
+            return h;
+        }
+
+        // The 64-bit finalizer of MurmurHash3.
+        constexpr uint64_t perfect_hash_mix(uint64_t h) noexcept
+        {
+            h ^= h >> 33;
+            h *= UINT64_C(0xff51afd7ed558ccd);
+            h ^= h >> 33;
+            h *= UINT64_C(0xc4ceb9fe1a85ec53);
+            h ^= h >> 33;
+            return h;
+        }
+    }
+
+    // perfect_static_map is a static_map for string keys (std::string_view, std::wstring_view, ...),
+    // which finds a key with a single hash of the key and a single string comparison,
+    // instead of a binary search with log2(N) comparisons of ever longer common prefixes.
+    //
+    // The perfect hash is built during construction ("hash and displace"): Keys are first distributed
+    // into buckets of ~2 items. Then, starting with the largest bucket, each bucket is assigned
+    // the first displacement value under which all of its keys hash into yet unused slots.
+    // The keys are expected to be unique. Duplicate keys fail the construction,
+    // which results in a compilation error when used in a constexpr context.
+    //
+    // The pairs are kept in the order they were given in, unlike with static_map.
+    template<typename K, typename V, size_t N>
+    class perfect_static_map
+    {
+    public:
+        using const_iterator = typename std::array<std::pair<K, V>, N>::const_iterator;
+
+        template<typename... Args>
+            requires(std::is_convertible_v<Args, std::pair<K, V>> && ...)
+        constexpr explicit perfect_static_map(Args&&... args) :
+            perfect_static_map{ std::array<std::pair<K, V>, N>{ { std::forward<Args>(args)... } } }
+        {
+            static_assert(sizeof...(Args) == N);
+        }
+
+        constexpr explicit perfect_static_map(const std::array<std::pair<K, V>, N>& pairs) :
+            _array{ pairs }
+        {
+            _build();
+        }
+
+        [[nodiscard]] constexpr const_iterator find(const K& key) const noexcept
+        {
+            const auto h = details::perfect_hash(key);
+            const auto idx = _slots[_slot(h, _displacements[_bucket(h)])];
+
+            if (idx >= N || key != _array[idx].first)
+            {
+                return _array.end();
+            }
+
+            return _array.begin() + idx;
+        }
+
+        [[nodiscard]] constexpr const_iterator begin() const noexcept
+        {
+            return _array.begin();
+        }
+
+        [[nodiscard]] constexpr const_iterator end() const noexcept
+        {
+            return _array.end();
+        }
+
+        [[nodiscard]] constexpr size_t size() const noexcept
+        {
+            return N;
+        }
+
+        [[nodiscard]] constexpr const V& at(const K& key) const
+        {
+            const auto iter{ find(key) };
+
+            if (iter == end())
+            {
+                throw std::runtime_error("key not found");
+            }
+
+            return iter->second;
+        }
+
+        [[nodiscard]] constexpr const V& operator[](const K& key) const
+        {
+            return at(key);
+        }
+
+    private:
+        static_assert(N != 0);
+        static_assert(N < 0xffff);
+
+        using index_type = std::conditional_t<(N < 0xff), uint8_t, uint16_t>;
+        static constexpr index_type emptySlot = std::numeric_limits<index_type>::max();
+        // A load factor of <= 50% allows the displacement search to finish after only a few attempts per bucket.
+        static constexpr size_t slotCount = std::bit_ceil(N * 2);
+        static constexpr size_t bucketCount = std::bit_ceil((N + 1) / 2);
+
+        static constexpr size_t _bucket(uint64_t h) noexcept
+        {
+            return static_cast<size_t>(details::perfect_hash_mix(h) & (bucketCount - 1));
+        }
+
+        static constexpr size_t _slot(uint64_t h, uint16_t displacement) noexcept
+        {
+            return static_cast<size_t>(details::perfect_hash_mix(h ^ (displacement * UINT64_C(0x9E3779B97F4A7C15))) & (slotCount - 1));
+        }
+
+        constexpr void _build()
+        {
+            std::array<uint64_t, N> hashes{};
+            std::array<size_t, bucketCount> bucketSizes{};
+            std::array<size_t, bucketCount> bucketOrder{};
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                hashes[i] = details::perfect_hash(_array[i].first);
+                bucketSizes[_bucket(hashes[i])]++;
+
+                // Two identical keys could never be placed into distinct slots.
+                for (size_t j = 0; j < i; ++j)
+                {
+                    if (hashes[i] == hashes[j] && _array[i].first == _array[j].first)
+                    {
+                        throw std::logic_error("duplicate key");
+                    }
+                }
+            }
+
+            for (size_t b = 0; b < bucketCount; ++b)
+            {
+                bucketOrder[b] = b;
+            }
+            std::sort(bucketOrder.begin(), bucketOrder.end(), [&](size_t lhs, size_t rhs) {
+                return bucketSizes[lhs] > bucketSizes[rhs];
+            });
+
+            _slots.fill(emptySlot);
+
+            for (const auto b : bucketOrder)
+            {
+                if (bucketSizes[b] == 0)
+                {
+                    break;
+                }
+
+                for (uint16_t displacement = 0;; ++displacement)
+                {
+                    if (_tryPlace(hashes, b, displacement))
+                    {
+                        _displacements[b] = displacement;
+                        break;
+                    }
+                    if (displacement == std::numeric_limits<uint16_t>::max())
+                    {
+                        throw std::logic_error("failed to build a perfect hash");
+                    }
+                }
+            }
+        }
+
+        // Places all keys of bucket `b` into the slots given by the displacement,
+        // or none of them if any of the slots is taken (including by the bucket's own keys).
+        constexpr bool _tryPlace(const std::array<uint64_t, N>& hashes, size_t b, uint16_t displacement)
+        {
+            std::array<size_t, N> placed{};
+            size_t placedCount = 0;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                if (_bucket(hashes[i]) != b)
+                {
+                    continue;
+                }
+
+                const auto slot = _slot(hashes[i], displacement);
+                if (_slots[slot] != emptySlot)
+                {
+                    for (size_t j = 0; j < placedCount; ++j)
+                    {
+                        _slots[placed[j]] = emptySlot;
+                    }
+                    return false;
+                }
+
+                _slots[slot] = static_cast<index_type>(i);
+                placed[placedCount++] = slot;
+            }
+
+            return true;
+        }
+
+        std::array<std::pair<K, V>, N> _array;
+        std::array<index_type, slotCount> _slots{};
+        std::array<uint16_t, bucketCount> _displacements{};
+    };
+
     // this is a deduction guide that ensures two things:
     // 1. static_map's member types are all the same
     // 2. static_map's fourth template argument (otherwise undeduced) is how many pairs it contains
@@ -103,4 +319,10 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
     template<typename First, typename... Rest>
     presorted_static_map(First, Rest...) -> presorted_static_map<std::conditional_t<std::conjunction_v<std::is_same<First, Rest>...>, typename First::first_type, void>, typename First::second_type, 1 + sizeof...(Rest)>;
+
+    template<typename First, typename... Rest>
+    perfect_static_map(First, Rest...) -> perfect_static_map<std::conditional_t<std::conjunction_v<std::is_same<First, Rest>...>, typename First::first_type, void>, typename First::second_type, 1 + sizeof...(Rest)>;
+
+    template<typename K, typename V, size_t N>
+    perfect_static_map(std::array<std::pair<K, V>, N>) -> perfect_static_map<K, V, N>;
 }
@@ -97,7 +97,10 @@ namespace til
         //   be started. After the timer has expired `func` will be invoked just once.
         //
         // After `func` was invoked the state is reset and this cycle is repeated again.
-        throttled_func(filetime_duration delay, function func) :
+        //
+        // `slack` is how much later than `delay` the timer may fire. The OS uses it to coalesce
+        // timer expirations, so that many instances with a slack wake up the CPU only once.
+        throttled_func(filetime_duration delay, function func, std::chrono::milliseconds slack = {}) :
             _func{ std::move(func) },
             _timer{ _createTimer() }
         {
@@ -108,6 +111,13 @@ namespace til
             }
 
             memcpy(&_delay, &d, sizeof(d));
+
+            if (slack.count() < 0 || slack.count() > MAXDWORD)
+            {
+                throw std::invalid_argument("invalid slack specified");
+            }
+
+            _slack = static_cast<DWORD>(slack.count());
         }
 
         // throttled_func uses its `this` pointer when creating _timer.
@@ -172,7 +182,7 @@ namespace til
                 _func();
             }
 
-            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, 0);
+            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, _slack);
         }
 
         void _trailing_edge()
@@ -195,6 +205,7 @@ namespace til
         }
 
         FILETIME _delay;
+        DWORD _slack = 0;
         function _func;
         wil::unique_threadpool_timer _timer;
         details::throttled_func_storage<Args...> _storage;
@@ -17,6 +17,9 @@ namespace til
     // * A low number of concurrent accesses (this lock doesn't scale well beyond 2 threads)
     // * alignas(std::hardware_destructive_interference_size) to prevent false sharing
     // * std::unique_lock or std::scoped_lock to prevent unbalanced lock/unlock calls
+    //
+    // lock_shared() allows consecutive readers in line to hold the lock at the same time.
+    // Readers and writers are still served strictly in the order they arrived in.
     struct ticket_lock
     {
         void lock() noexcept
@@ -35,8 +38,47 @@ namespace til
             }
         }
 
+        void lock_shared() noexcept
+        {
+            const auto ticket = _next_ticket.fetch_add(1, std::memory_order_relaxed);
+
+            for (;;)
+            {
+                const auto current = _now_reading.load(std::memory_order_acquire);
+                if (current == ticket)
+                {
+                    break;
+                }
+
+                til::atomic_wait(_now_reading, current);
+            }
+
+            // Let the next ticket in line in, if it's a reader as well.
+            _now_reading.fetch_add(1, std::memory_order_relaxed);
+            til::atomic_notify_all(_now_reading);
+        }
+
+        // Acquires the lock only if it's currently not held by anyone, and
+        // in particular without waiting in line behind other threads.
+        bool try_lock() noexcept
+        {
+            auto ticket = _now_serving.load(std::memory_order_relaxed);
+            return _next_ticket.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
         void unlock() noexcept
         {
+            // Readers get let in by the preceding reader (see lock_shared), so we need to do that for them.
+            _now_reading.fetch_add(1, std::memory_order_release);
+            _now_serving.fetch_add(1, std::memory_order_release);
+            til::atomic_notify_all(_now_reading);
+            til::atomic_notify_all(_now_serving);
+        }
+
+        void unlock_shared() noexcept
+        {
+            // Readers may unlock in any order. Once all of them did, _now_serving
+            // will have caught up with the ticket of the writer waiting behind them.
             _now_serving.fetch_add(1, std::memory_order_release);
             til::atomic_notify_all(_now_serving);
         }
@@ -52,6 +94,9 @@ namespace til
         // atomics are treated more like "IDs" and less like counters.
         std::atomic<uint32_t> _next_ticket{ 0 };
         std::atomic<uint32_t> _now_serving{ 0 };
+        // The ticket that may acquire the lock in shared mode. It runs ahead of
+        // _now_serving while readers hold the lock and is equal to it otherwise.
+        std::atomic<uint32_t> _now_reading{ 0 };
     };
 
     struct recursive_ticket_lock
@@ -108,6 +153,23 @@ namespace til
             _recursion++;
         }
 
+        bool try_lock() noexcept
+        {
+            const auto id = GetCurrentThreadId();
+
+            if (_owner.load(std::memory_order_relaxed) != id)
+            {
+                if (!_lock.try_lock())
+                {
+                    return false;
+                }
+                _owner.store(id, std::memory_order_relaxed);
+            }
+
+            _recursion++;
+            return true;
+        }
+
         void unlock() noexcept
         {
             if (--_recursion == 0)
@@ -117,6 +179,41 @@ namespace til
             }
         }
 
+        // Shared locks are recursive as well, but since any number of threads may hold the lock
+        // in shared mode, their recursion count is tracked per thread (see _shared_recursion()).
+        // A thread holding the lock in shared mode must not call lock() however, because
+        // it would wait behind itself. If the current thread already holds the lock
+        // exclusively, this simply recurses into the exclusive lock.
+        void lock_shared() noexcept
+        {
+            if (is_locked())
+            {
+                _recursion++;
+                return;
+            }
+
+            auto& recursion = _shared_recursion();
+            if (recursion++ == 0)
+            {
+                _lock.lock_shared();
+            }
+        }
+
+        void unlock_shared() noexcept
+        {
+            if (is_locked())
+            {
+                unlock();
+                return;
+            }
+
+            auto& recursion = _shared_recursion();
+            if (--recursion == 0)
+            {
+                _lock.unlock_shared();
+            }
+        }
+
         [[nodiscard]] recursive_ticket_lock_suspension suspend() noexcept
         {
             const auto id = GetCurrentThreadId();
@@ -147,6 +244,41 @@ namespace til
         }
 
     private:
+        // Returns the current thread's recursion count of lock_shared() for this lock.
+        // A thread only ever holds a handful of locks in shared mode at a time, so a tiny
+        // thread-local table is enough. Its slots are released once their count drops to 0.
+        uint32_t& _shared_recursion() noexcept
+        {
+            struct slot
+            {
+                const recursive_ticket_lock* lock = nullptr;
+                uint32_t recursion = 0;
+            };
+            thread_local slot slots[8];
+
+            slot* empty = nullptr;
+            for (auto& s : slots)
+            {
+                if (s.recursion != 0 && s.lock == this)
+                {
+                    return s.recursion;
+                }
+                if (!empty && s.recursion == 0)
+                {
+                    empty = &s;
+                }
+            }
+
+            if (!empty)
+            {
+                // Holding this many different locks in shared mode at once is a bug.
+                __fastfail(FAST_FAIL_FATAL_APP_EXIT);
+            }
+
+            empty->lock = this;
+            return empty->recursion;
+        }
+
         ticket_lock _lock;
         std::atomic<uint32_t> _owner = 0;
         uint32_t _recursion = 0;
@@ -13,7 +13,10 @@ Tests have been made in order to investigate whether or not own algorithms
 could overcome disadvantages of syscalls. Test results can be read up
 in PR #4093 and the test algorithms are available in src\tools\U8U16Test.
 Based on the results the decision was made to keep using the platform
-functions MultiByteToWideChar and WideCharToMultiByte.
+functions MultiByteToWideChar and WideCharToMultiByte for anything but ASCII.
+Most of the text passing through a terminal is ASCII however (VT sequences,
+source code, logs, ...), which is why runs of ASCII are widened and narrowed
+with SIMD instructions, without calling into the platform functions at all.
 
 Author(s):
 - Steffen Illhardt (german-one), Leonard Hecker (lhecker) 2020-2021
@@ -47,6 +50,178 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         }
     };
 
+    namespace details
+    {
+#pragma warning(push)
+#pragma warning(disable : 26429 26481 26490) // use not_null, pointer arithmetic, reinterpret_cast
+        // Non-ASCII runs shorter than this are converted together with the ASCII text around them, so that
+        // text which mixes ASCII with other scripts doesn't result in a platform function call per word.
+        inline constexpr size_t minimumAsciiRun = 16;
+
+        // Widens the leading ASCII characters of [in, end) into out and returns their count.
+        inline size_t widen_ascii(const char* in, const char* const end, wchar_t* out) noexcept
+        {
+            const auto beg = in;
+
+#if defined(TIL_SSE_INTRINSICS)
+            const auto zero = _mm_setzero_si128();
+            for (; end - in >= 16; in += 16, out += 16)
+            {
+                const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                if (_mm_movemask_epi8(v))
+                {
+                    break;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(v, zero));
+            }
+#endif
+
+            for (; in != end && static_cast<uint8_t>(*in) < 0x80; ++in, ++out)
+            {
+                *out = static_cast<wchar_t>(*in);
+            }
+
+            return gsl::narrow_cast<size_t>(in - beg);
+        }
+
+        // Narrows the leading ASCII characters of [in, end) into out and returns their count.
+        inline size_t narrow_ascii(const wchar_t* in, const wchar_t* const end, char* out) noexcept
+        {
+            const auto beg = in;
+
+#if defined(TIL_SSE_INTRINSICS)
+            const auto zero = _mm_setzero_si128();
+            const auto nonAscii = _mm_set1_epi16(static_cast<short>(0xff80));
+            for (; end - in >= 16; in += 16, out += 16)
+            {
+                const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+                const auto high = _mm_and_si128(_mm_or_si128(a, b), nonAscii);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff)
+                {
+                    break;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(a, b));
+            }
+#endif
+
+            for (; in != end && *in < 0x80; ++in, ++out)
+            {
+                *out = static_cast<char>(*in);
+            }
+
+            return gsl::narrow_cast<size_t>(in - beg);
+        }
+
+        // Returns the end of the non-ASCII run starting at `in`, which is either `end` or the
+        // beginning of at least minimumAsciiRun consecutive ASCII characters. Since ASCII code units
+        // never occur within UTF-8 or UTF-16 sequences, this is always a valid place to split the text.
+        template<typename T>
+        const T* find_ascii_run(const T* in, const T* const end) noexcept
+        {
+            size_t ascii = 0;
+            for (; in != end; ++in)
+            {
+                if (static_cast<std::make_unsigned_t<T>>(*in) >= 0x80)
+                {
+                    ascii = 0;
+                }
+                else if (++ascii == minimumAsciiRun)
+                {
+                    return in - (minimumAsciiRun - 1);
+                }
+            }
+            return end;
+        }
+
+        // Converts the UTF-8 string [in, in + count) to UTF-16. out must fit count-many code units,
+        // since UTF-8 never needs less code units than UTF-16. Returns the number of code units
+        // written or 0 if the platform function failed (this is never 0 on success for count > 0).
+        inline size_t u8u16(const char* in, const size_t count, wchar_t* const out) noexcept
+        {
+            const auto end = in + count;
+            auto dst = out;
+
+            while (in != end)
+            {
+                const auto ascii = widen_ascii(in, end, dst);
+                in += ascii;
+                dst += ascii;
+
+                if (in != end)
+                {
+                    const auto runEnd = find_ascii_run(in, end);
+                    const auto runLen = gsl::narrow_cast<int>(runEnd - in);
+                    const auto written = MultiByteToWideChar(CP_UTF8, 0UL, in, runLen, dst, runLen);
+                    if (!written)
+                    {
+                        return 0;
+                    }
+                    in = runEnd;
+                    dst += written;
+                }
+            }
+
+            return gsl::narrow_cast<size_t>(dst - out);
+        }
+
+        // Converts the UTF-16 string [in, in + count) to UTF-8. out must fit 3*count-many code units,
+        // which is the worst ratio of UTF-16 to UTF-8 code units. Returns the number of code units
+        // written or 0 if the platform function failed (this is never 0 on success for count > 0).
+        inline size_t u16u8(const wchar_t* in, const size_t count, char* const out) noexcept
+        {
+            const auto end = in + count;
+            const auto outEnd = out + count * 3;
+            auto dst = out;
+
+            while (in != end)
+            {
+                const auto ascii = narrow_ascii(in, end, dst);
+                in += ascii;
+                dst += ascii;
+
+                if (in != end)
+                {
+                    const auto runEnd = find_ascii_run(in, end);
+                    const auto runLen = gsl::narrow_cast<int>(runEnd - in);
+                    const auto capacity = gsl::narrow_cast<int>(outEnd - dst);
+                    const auto written = WideCharToMultiByte(CP_UTF8, 0UL, in, runLen, dst, capacity, nullptr, nullptr);
+                    if (!written)
+                    {
+                        return 0;
+                    }
+                    in = runEnd;
+                    dst += written;
+                }
+            }
+
+            return gsl::narrow_cast<size_t>(dst - out);
+        }
+#pragma warning(pop)
+
+        // Resizes out to `count` and calls op(out.data(), count), which returns the final size.
+        // Unlike a plain resize() this doesn't zero the contents, if the string type supports it.
+        // op must not throw.
+        template<typename outT, typename Op>
+        void resize_and_overwrite(outT& out, const size_t count, Op op)
+        {
+            if constexpr (requires { out.resize_and_overwrite(count, op); })
+            {
+                out.resize_and_overwrite(count, op);
+            }
+            else if constexpr (requires { out._Resize_and_overwrite(count, op); })
+            {
+                out._Resize_and_overwrite(count, op);
+            }
+            else
+            {
+                out.resize(count);
+                out.resize(op(out.data(), count));
+            }
+        }
+    }
+
     // Routine Description:
     // - Takes a UTF-8 string and performs the conversion to UTF-16. NOTE: The function relies on getting complete UTF-8 characters at the string boundaries.
     // Arguments:
@@ -69,9 +244,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             int lengthRequired{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
-            out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(CP_UTF8, 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            size_t lengthOut{};
+            // avoid to call MultiByteToWideChar twice only to get the required size
+            details::resize_and_overwrite(out, in.length(), [&](auto* const data, const size_t) noexcept {
+                lengthOut = details::u8u16(in.data(), in.length(), data);
+                return lengthOut;
+            });
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
         }
@@ -104,68 +282,77 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::CheckAdd(in.length(), state.have).AssignIfValid(&capa16));
 
-            out.resize(gsl::narrow_cast<size_t>(capa16));
-            auto len8{ gsl::narrow_cast<int>(in.length()) };
-            int len16{};
-            auto cursor8{ in.data() };
-            if (state.have)
-            {
-                const auto copyable{ std::min<int>(state.want, len8) };
-                std::move(cursor8, cursor8 + copyable, &state.partials[state.have]);
-                state.have += gsl::narrow_cast<uint8_t>(copyable);
-                state.want -= gsl::narrow_cast<uint8_t>(copyable);
-                if (state.want) // we still didn't get enough data to complete the code point, however this is not an error
+            auto hr{ S_OK };
+            details::resize_and_overwrite(out, gsl::narrow_cast<size_t>(capa16), [&](auto* const data, const size_t) noexcept -> size_t {
+                auto len8{ gsl::narrow_cast<int>(in.length()) };
+                size_t len16{};
+                auto cursor8{ in.data() };
+                if (state.have)
                 {
-                    out.clear();
-                    return S_OK;
+                    const auto copyable{ std::min<int>(state.want, len8) };
+                    std::move(cursor8, cursor8 + copyable, &state.partials[state.have]);
+                    state.have += gsl::narrow_cast<uint8_t>(copyable);
+                    state.want -= gsl::narrow_cast<uint8_t>(copyable);
+                    if (state.want) // we still didn't get enough data to complete the code point, however this is not an error
+                    {
+                        return 0;
+                    }
+
+                    len16 = details::u8u16(&state.partials[0], state.have, data);
+                    if (!len16)
+                    {
+                        hr = E_UNEXPECTED;
+                        return 0;
+                    }
+
+                    len8 -= copyable;
+                    cursor8 += copyable;
+                    // state.want is already zero at this point
+                    state.have = 0;
                 }
 
-                len16 = MultiByteToWideChar(CP_UTF8, 0UL, &state.partials[0], gsl::narrow_cast<int>(state.have), out.data(), capa16);
-                RETURN_HR_IF(E_UNEXPECTED, !len16);
-
-                capa16 -= len16;
-                len8 -= copyable;
-                cursor8 += copyable;
-                // state.want is already zero at this point
-                state.have = 0;
-            }
-
-            if (len8)
-            {
-                auto backIter{ cursor8 + len8 - 1 };
-                int sequenceLen{ 1 };
-
-                // skip UTF8 continuation bytes
-                while (backIter != cursor8 && (*backIter & 0b11'000000) == 0b10'000000)
+                if (len8)
                 {
-                    --backIter;
-                    ++sequenceLen;
+                    auto backIter{ cursor8 + len8 - 1 };
+                    int sequenceLen{ 1 };
+
+                    // skip UTF8 continuation bytes
+                    while (backIter != cursor8 && (*backIter & 0b11'000000) == 0b10'000000)
+                    {
+                        --backIter;
+                        ++sequenceLen;
+                    }
+
+                    // credits go to Christopher Wellons for this algorithm to determine the length of a UTF-8 code point
+                    // it is released into the Public Domain. https://github.com/skeeto/branchless-utf8
+                    static constexpr uint8_t lengths[]{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0 };
+                    const auto codePointLen{ lengths[gsl::narrow_cast<uint8_t>(*backIter) >> 3] };
+
+                    if (codePointLen > sequenceLen)
+                    {
+                        std::move(backIter, backIter + sequenceLen, &state.partials[0]);
+                        len8 -= sequenceLen;
+                        state.have = gsl::narrow_cast<uint8_t>(sequenceLen);
+                        state.want = gsl::narrow_cast<uint8_t>(codePointLen - sequenceLen);
+                    }
                 }
 
-                // credits go to Christopher Wellons for this algorithm to determine the length of a UTF-8 code point
-                // it is released into the Public Domain. https://github.com/skeeto/branchless-utf8
-                static constexpr uint8_t lengths[]{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0 };
-                const auto codePointLen{ lengths[gsl::narrow_cast<uint8_t>(*backIter) >> 3] };
-
-                if (codePointLen > sequenceLen)
+                if (len8)
                 {
-                    std::move(backIter, backIter + sequenceLen, &state.partials[0]);
-                    len8 -= sequenceLen;
-                    state.have = gsl::narrow_cast<uint8_t>(sequenceLen);
-                    state.want = gsl::narrow_cast<uint8_t>(codePointLen - sequenceLen);
+                    const auto convLen{ details::u8u16(cursor8, gsl::narrow_cast<size_t>(len8), data + len16) };
+                    if (!convLen)
+                    {
+                        hr = E_UNEXPECTED;
+                        return 0;
+                    }
+
+                    len16 += convLen;
                 }
-            }
 
-            if (len8)
-            {
-                const auto convLen{ MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16) };
-                RETURN_HR_IF(E_UNEXPECTED, !convLen);
+                return len16;
+            });
 
-                len16 += convLen;
-            }
-
-            out.resize(gsl::narrow_cast<size_t>(len16));
-            return S_OK;
+            return hr;
         }
         CATCH_RETURN();
     }
@@ -196,9 +383,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // Code Points >U+FFFF: 2 UTF-16 code units --> 4 UTF-8 code units.
             // Thus, the worst ratio of UTF-16 code units to UTF-8 code units is 1 to 3.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthIn) || !base::CheckMul(lengthIn, 3).AssignIfValid(&lengthRequired));
-            out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to call WideCharToMultiByte twice only to get the required size
-            const int lengthOut = WideCharToMultiByte(CP_UTF8, 0ul, in.data(), lengthIn, out.data(), lengthRequired, nullptr, nullptr);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            size_t lengthOut{};
+            // avoid to call WideCharToMultiByte twice only to get the required size
+            details::resize_and_overwrite(out, gsl::narrow_cast<size_t>(lengthRequired), [&](auto* const data, const size_t) noexcept {
+                lengthOut = details::u16u8(in.data(), in.length(), data);
+                return lengthOut;
+            });
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
         }
@@ -232,41 +422,51 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // The worst ratio of UTF-16 code units to UTF-8 code units is 1 to 3.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&len16) || !base::CheckAdd(len16, gsl::narrow_cast<int>(state.partials[0]) != 0).AssignIfValid(&capa8) || !base::CheckMul(capa8, 3).AssignIfValid(&capa8));
 
-            out.resize(gsl::narrow_cast<size_t>(capa8));
-            int len8{};
-            auto cursor16{ in.data() };
-            if (state.partials[0])
-            {
-                state.partials[1] = *cursor16;
-                len8 = WideCharToMultiByte(CP_UTF8, 0UL, &state.partials[0], 2, out.data(), capa8, nullptr, nullptr);
-                RETURN_HR_IF(E_UNEXPECTED, !len8);
-
-                state.reset();
-                capa8 -= len8;
-                --len16;
-                ++cursor16;
-            }
-
-            if (len16)
-            {
-                const auto back = *(cursor16 + len16 - 1);
-                if (back >= 0xD800 && back <= 0xDBFF) // cache the last value in the string if it is in the range of high surrogates
+            auto hr{ S_OK };
+            details::resize_and_overwrite(out, gsl::narrow_cast<size_t>(capa8), [&](auto* const data, const size_t) noexcept -> size_t {
+                size_t len8{};
+                auto cursor16{ in.data() };
+                if (state.partials[0])
                 {
-                    state.partials[0] = back;
+                    state.partials[1] = *cursor16;
+                    len8 = details::u16u8(&state.partials[0], 2, data);
+                    if (!len8)
+                    {
+                        hr = E_UNEXPECTED;
+                        return 0;
+                    }
+
+                    state.reset();
                     --len16;
+                    ++cursor16;
                 }
-            }
 
-            if (len16)
-            {
-                const auto convLen{ WideCharToMultiByte(CP_UTF8, 0UL, cursor16, len16, out.data() + len8, capa8, nullptr, nullptr) };
-                RETURN_HR_IF(E_UNEXPECTED, !convLen);
+                if (len16)
+                {
+                    const auto back = *(cursor16 + len16 - 1);
+                    if (back >= 0xD800 && back <= 0xDBFF) // cache the last value in the string if it is in the range of high surrogates
+                    {
+                        state.partials[0] = back;
+                        --len16;
+                    }
+                }
 
-                len8 += convLen;
-            }
+                if (len16)
+                {
+                    const auto convLen{ details::u16u8(cursor16, gsl::narrow_cast<size_t>(len16), data + len8) };
+                    if (!convLen)
+                    {
+                        hr = E_UNEXPECTED;
+                        return 0;
+                    }
+
+                    len8 += convLen;
+                }
+
+                return len8;
+            });
 
-            out.resize(gsl::narrow_cast<size_t>(len8));
-            return S_OK;
+            return hr;
         }
         CATCH_RETURN();
     }
@@ -31,35 +31,56 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
 
     _fontSize.width = FontWidth > SHORT_MAX ? SHORT_MAX : gsl::narrow_cast<til::CoordType>(FontWidth);
     _fontSize.height = FontHeight > SHORT_MAX ? SHORT_MAX : gsl::narrow_cast<til::CoordType>(FontHeight);
+
+    // The first frame needs to fill the entire shared view.
+    LOG_IF_FAILED(InvalidateAll());
 }
 
-[[nodiscard]] HRESULT BgfxEngine::Invalidate(const til::rect* /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::Invalidate(const til::rect* psrRegion) noexcept
 {
+    _invalidArea |= *psrRegion;
     return S_OK;
 }
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateCursor(const til::rect* /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::InvalidateCursor(const til::rect* psrRegion) noexcept
 {
+    // The cursor is drawn by ConIoSrv, but PaintCursor() only gets called for frames we don't skip.
+    _invalidArea |= *psrRegion;
     return S_OK;
 }
 
 [[nodiscard]] HRESULT BgfxEngine::InvalidateSystem(const til::rect* /*prcDirtyClient*/) noexcept
 {
-    return S_OK;
+    return InvalidateAll();
 }
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateSelection(const std::vector<til::rect>& /*rectangles*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::InvalidateSelection(std::span<const til::rect> rectangles) noexcept
 {
+    for (const auto& rect : rectangles)
+    {
+        _invalidArea |= rect;
+    }
     return S_OK;
 }
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateScroll(const til::point* /*pcoordDelta*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::InvalidateScroll(const til::point* pcoordDelta) noexcept
 {
+    // The shared view has no notion of scrolling. Every row has moved and needs to be copied.
+    if (pcoordDelta->x != 0 || pcoordDelta->y != 0)
+    {
+        return InvalidateAll();
+    }
     return S_OK;
 }
 
 [[nodiscard]] HRESULT BgfxEngine::InvalidateAll() noexcept
 {
+    _invalidArea = {
+        0,
+        0,
+        gsl::narrow_cast<til::CoordType>(_displayWidth),
+        gsl::narrow_cast<til::CoordType>(_displayHeight),
+    };
     return S_OK;
 }
 
@@ -69,11 +90,27 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     return S_FALSE;
 }
 
+// Routine Description:
+// - Skips the frame if nothing was invalidated since the last one.
+//   Otherwise the frame only paints the invalidated cells.
 [[nodiscard]] HRESULT BgfxEngine::StartPaint() noexcept
 {
-    return S_OK;
+    _dirtyArea = _invalidArea & til::rect{
+        0,
+        0,
+        gsl::narrow_cast<til::CoordType>(_displayWidth),
+        gsl::narrow_cast<til::CoordType>(_displayHeight),
+    };
+    _invalidArea = {};
+
+    return _dirtyArea ? S_OK : S_FALSE;
 }
 
+// Routine Description:
+// - Asks ConIoSrv to update the display once for the entire frame and then
+//   copies the cells that the frame painted from the new to the old run of
+//   each row. All other cells haven't changed since the last frame and
+//   already match.
 [[nodiscard]] HRESULT BgfxEngine::EndPaint() noexcept
 try
 {
@@ -81,13 +118,21 @@ try
 
     if (SUCCEEDED_NTSTATUS(Status))
     {
-        for (SIZE_T i = 0; i < _displayHeight; i++)
+        const auto offset = gsl::narrow_cast<SIZE_T>(_dirtyArea.left) * sizeof(CD_IO_CHARACTER);
+        const auto length = gsl::narrow_cast<SIZE_T>(_dirtyArea.width()) * sizeof(CD_IO_CHARACTER);
+
+        for (auto i = gsl::narrow_cast<SIZE_T>(_dirtyArea.top); i < gsl::narrow_cast<SIZE_T>(_dirtyArea.bottom); i++)
         {
-            const auto OldRunBase = _sharedViewBase + (i * 2 * _runLength);
+            const auto OldRunBase = _sharedViewBase + (i * 2 * _runLength) + offset;
             const auto NewRunBase = OldRunBase + _runLength;
-            memcpy_s(OldRunBase, _runLength, NewRunBase, _runLength);
+            memcpy_s(OldRunBase, _runLength - offset, NewRunBase, length);
         }
     }
+    else
+    {
+        // The display didn't get updated. Try again next frame.
+        _invalidArea |= _dirtyArea;
+    }
 
     return HRESULT_FROM_NT(Status);
 }
@@ -112,11 +157,11 @@ CATCH_RETURN()
 
 [[nodiscard]] HRESULT BgfxEngine::PaintBackground() noexcept
 {
-    for (SIZE_T i = 0; i < _displayHeight; i++)
+    for (auto i = gsl::narrow_cast<SIZE_T>(_dirtyArea.top); i < gsl::narrow_cast<SIZE_T>(_dirtyArea.bottom); i++)
     {
         const auto NewRun = reinterpret_cast<PCD_IO_CHARACTER>(_sharedViewBase + (i * 2 * _runLength) + _runLength);
 
-        for (SIZE_T j = 0; j < _displayWidth; j++)
+        for (auto j = gsl::narrow_cast<SIZE_T>(_dirtyArea.left); j < gsl::narrow_cast<SIZE_T>(_dirtyArea.right); j++)
         {
             NewRun[j].Character = L' ';
             NewRun[j].Attribute = 0;
@@ -133,13 +178,14 @@ CATCH_RETURN()
 {
     try
     {
+        const auto x = gsl::narrow_cast<SIZE_T>(coord.x);
         const auto y = gsl::narrow_cast<SIZE_T>(coord.y);
         const auto NewRun = reinterpret_cast<PCD_IO_CHARACTER>(_sharedViewBase + (y * 2 * _runLength) + _runLength);
 
-        for (SIZE_T i = 0; i < clusters.size() && i < _displayWidth; i++)
+        for (SIZE_T i = 0; i < clusters.size() && x + i < _displayWidth; i++)
         {
-            NewRun[coord.x + i].Character = til::at(clusters, i).GetTextAsSingle();
-            NewRun[coord.x + i].Attribute = _currentLegacyColorAttribute;
+            NewRun[x + i].Character = til::at(clusters, i).GetTextAsSingle();
+            NewRun[x + i].Attribute = _currentLegacyColorAttribute;
         }
 
         return S_OK;
@@ -217,9 +263,6 @@ CATCH_RETURN()
 
 [[nodiscard]] HRESULT BgfxEngine::GetDirtyArea(std::span<const til::rect>& area) noexcept
 {
-    _dirtyArea.bottom = gsl::narrow_cast<til::CoordType>(std::max(static_cast<SIZE_T>(0), _displayHeight));
-    _dirtyArea.right = gsl::narrow_cast<til::CoordType>(std::max(static_cast<SIZE_T>(0), _displayWidth));
-
     area = { &_dirtyArea,
              1 };
 
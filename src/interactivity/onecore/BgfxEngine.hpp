@@ -35,7 +35,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT Invalidate(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateCursor(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateSystem(const til::rect* prcDirtyClient) noexcept override;
-        [[nodiscard]] HRESULT InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept override;
+        [[nodiscard]] HRESULT InvalidateSelection(std::span<const til::rect> rectangles) noexcept override;
         [[nodiscard]] HRESULT InvalidateScroll(const til::point* pcoordDelta) noexcept override;
         [[nodiscard]] HRESULT InvalidateAll() noexcept override;
         [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept override;
@@ -80,6 +80,9 @@ namespace Microsoft::Console::Render
 
         SIZE_T _displayHeight;
         SIZE_T _displayWidth;
+        // The cells invalidated since the last frame, and the part of it that the current frame paints.
+        // Only these cells get cleared and copied from the new to the old run of their row.
+        til::rect _invalidArea;
         til::rect _dirtyArea;
 
         til::size _fontSize;
@@ -11,6 +11,17 @@
 using namespace Microsoft::Console::Types;
 using namespace Microsoft::Console::Interactivity::Win32;
 
+AccessibilityNotifier::AccessibilityNotifier(DWORD updateIntervalInMS) :
+    _timer{ THROW_LAST_ERROR_IF_NULL(CreateThreadpoolTimer(&_timerCallback, this, nullptr)) },
+    _updateInterval{ updateIntervalInMS }
+{
+}
+
+AccessibilityNotifier::~AccessibilityNotifier()
+{
+    SetThreadpoolTimer(_timer.get(), nullptr, 0, 0);
+}
+
 void AccessibilityNotifier::NotifyConsoleCaretEvent(_In_ const til::rect& rectangle)
 {
     const auto pWindow = ServiceLocator::LocateConsoleWindow();
@@ -40,6 +51,9 @@ void AccessibilityNotifier::NotifyConsoleCaretEvent(_In_ ConsoleCaretEventFlags
         dwFlags = CONSOLE_CARET_VISIBLE;
     }
 
+    // Screen readers expect the text to be updated before the caret moves.
+    _flushUpdate();
+
     // UIA event notification
     static til::point previousCursorLocation;
     const auto pWindow = ServiceLocator::LocateConsoleWindow();
@@ -64,6 +78,8 @@ void AccessibilityNotifier::NotifyConsoleCaretEvent(_In_ ConsoleCaretEventFlags
 
 void AccessibilityNotifier::NotifyConsoleUpdateScrollEvent(_In_ LONG x, _In_ LONG y)
 {
+    _flushUpdate();
+
     auto pWindow = ServiceLocator::LocateConsoleWindow();
     if (pWindow)
     {
@@ -76,30 +92,41 @@ void AccessibilityNotifier::NotifyConsoleUpdateScrollEvent(_In_ LONG x, _In_ LON
 
 void AccessibilityNotifier::NotifyConsoleUpdateSimpleEvent(_In_ LONG start, _In_ LONG charAndAttribute)
 {
-    auto pWindow = ServiceLocator::LocateConsoleWindow();
-    if (pWindow)
-    {
-        NotifyWinEvent(EVENT_CONSOLE_UPDATE_SIMPLE,
-                       pWindow->GetWindowHandle(),
-                       start,
-                       charAndAttribute);
-    }
+    const auto wasPending = _updatePending;
+    NotifyConsoleUpdateRegionEvent(start, start);
+    _updateSimple = !wasPending;
+    _updateCharAndAttribute = charAndAttribute;
 }
 
 void AccessibilityNotifier::NotifyConsoleUpdateRegionEvent(_In_ LONG startXY, _In_ LONG endXY)
 {
-    auto pWindow = ServiceLocator::LocateConsoleWindow();
-    if (pWindow)
+    const til::inclusive_rect region{
+        static_cast<SHORT>(LOWORD(startXY)),
+        static_cast<SHORT>(HIWORD(startXY)),
+        static_cast<SHORT>(LOWORD(endXY)),
+        static_cast<SHORT>(HIWORD(endXY)),
+    };
+
+    if (_updatePending)
     {
-        NotifyWinEvent(EVENT_CONSOLE_UPDATE_REGION,
-                       pWindow->GetWindowHandle(),
-                       startXY,
-                       endXY);
+        _updateRegion.left = std::min(_updateRegion.left, region.left);
+        _updateRegion.top = std::min(_updateRegion.top, region.top);
+        _updateRegion.right = std::max(_updateRegion.right, region.right);
+        _updateRegion.bottom = std::max(_updateRegion.bottom, region.bottom);
+        _updateSimple = false;
+        return;
     }
+
+    _updatePending = true;
+    _updateSimple = false;
+    _updateRegion = region;
+    _scheduleUpdate();
 }
 
 void AccessibilityNotifier::NotifyConsoleLayoutEvent()
 {
+    _flushUpdate();
+
     auto pWindow = ServiceLocator::LocateConsoleWindow();
     if (pWindow)
     {
@@ -133,3 +160,59 @@ void AccessibilityNotifier::NotifyConsoleEndApplicationEvent(_In_ DWORD processI
                        0);
     }
 }
+
+void CALLBACK AccessibilityNotifier::_timerCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_TIMER /*timer*/) noexcept
+{
+    // Just like with CursorBlinker, the callback may be scheduled even after the timer
+    // got canceled. The notifier is owned by the ServiceLocator however and lives
+    // until the process exits, so that's not much of a concern in practice.
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole();
+    static_cast<AccessibilityNotifier*>(context)->_flushUpdate();
+    gci.UnlockConsole();
+}
+
+void AccessibilityNotifier::_scheduleUpdate() noexcept
+{
+    // The FILETIME struct measures time in 100ns steps. 10000 thus equals 1ms.
+    auto dueTime = -static_cast<int64_t>(_updateInterval) * 10000;
+    SetThreadpoolTimer(_timer.get(), reinterpret_cast<FILETIME*>(&dueTime), 0, 0);
+}
+
+// Routine Description:
+// - Fires the region update that has been accumulated since the last call, if any.
+//   This results in a single WinEvent and UIA TextChanged event per interval.
+void AccessibilityNotifier::_flushUpdate() noexcept
+{
+    if (!_updatePending)
+    {
+        return;
+    }
+
+    _updatePending = false;
+    SetThreadpoolTimer(_timer.get(), nullptr, 0, 0);
+
+    const auto pWindow = ServiceLocator::LocateConsoleWindow();
+    if (!pWindow)
+    {
+        return;
+    }
+
+    const auto start = MAKELONG(_updateRegion.left, _updateRegion.top);
+    if (_updateSimple)
+    {
+        NotifyWinEvent(EVENT_CONSOLE_UPDATE_SIMPLE,
+                       pWindow->GetWindowHandle(),
+                       start,
+                       _updateCharAndAttribute);
+    }
+    else
+    {
+        NotifyWinEvent(EVENT_CONSOLE_UPDATE_REGION,
+                       pWindow->GetWindowHandle(),
+                       start,
+                       MAKELONG(_updateRegion.right, _updateRegion.bottom));
+    }
+
+    LOG_IF_FAILED(pWindow->SignalUia(UIA_Text_TextChangedEventId));
+}
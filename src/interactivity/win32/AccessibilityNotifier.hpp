@@ -25,7 +25,13 @@ namespace Microsoft::Console::Interactivity::Win32
     class AccessibilityNotifier final : public IAccessibilityNotifier
     {
     public:
-        ~AccessibilityNotifier() = default;
+        // Region updates are coalesced over this interval, because firing
+        // one event per write slows down noisy applications considerably
+        // as soon as any accessibility client is listening.
+        static constexpr DWORD DefaultUpdateInterval = 50;
+
+        AccessibilityNotifier(DWORD updateIntervalInMS = DefaultUpdateInterval);
+        ~AccessibilityNotifier();
 
         void NotifyConsoleCaretEvent(_In_ const til::rect& rectangle);
         void NotifyConsoleCaretEvent(_In_ ConsoleCaretEventFlags flags, _In_ LONG position);
@@ -35,5 +41,20 @@ namespace Microsoft::Console::Interactivity::Win32
         void NotifyConsoleLayoutEvent();
         void NotifyConsoleStartApplicationEvent(_In_ DWORD processId);
         void NotifyConsoleEndApplicationEvent(_In_ DWORD processId);
+
+    private:
+        static void CALLBACK _timerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer) noexcept;
+
+        void _scheduleUpdate() noexcept;
+        void _flushUpdate() noexcept;
+
+        wil::unique_threadpool_timer_nowait _timer;
+        DWORD _updateInterval;
+        bool _updatePending = false;
+        // If the interval contained a single 1-cell update, it's forwarded as
+        // EVENT_CONSOLE_UPDATE_SIMPLE together with its character and attribute.
+        bool _updateSimple = false;
+        LONG _updateCharAndAttribute = 0;
+        til::inclusive_rect _updateRegion;
     };
 }
@@ -110,8 +110,18 @@ void Clipboard::StringPaste(_In_reads_(cchData) const wchar_t* const pData,
     {
         const auto vtInputMode = gci.pInputBuffer->IsInVirtualTerminalInputMode();
         const auto bracketedPasteMode = gci.GetBracketedPasteMode();
-        auto inEvents = TextToKeyEvents(pData, cchData, vtInputMode && bracketedPasteMode);
-        gci.pInputBuffer->Write(inEvents);
+        TextToInputRecords(pData, cchData, vtInputMode && bracketedPasteMode, [&](const std::span<const INPUT_RECORD> records) {
+            gci.pInputBuffer->Write(records);
+
+            // Give the clients that are waiting for input a chance to read the chunk we just wrote,
+            // instead of letting them wait until the entire clipboard contents have been converted.
+            // This only works if we're the only ones holding the lock, since it's recursive.
+            if (gci.GetCSRecursionCount() == 1)
+            {
+                gci.UnlockConsole();
+                gci.LockConsole();
+            }
+        });
     }
     catch (...)
     {
@@ -137,14 +147,54 @@ void Clipboard::StringPaste(_In_reads_(cchData) const wchar_t* const pData,
 std::deque<std::unique_ptr<IInputEvent>> Clipboard::TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                     const size_t cchData,
                                                                     const bool bracketedPaste)
+{
+    std::deque<std::unique_ptr<IInputEvent>> keyEvents;
+    TextToInputRecords(pData, cchData, bracketedPaste, [&](const std::span<const INPUT_RECORD> records) {
+        auto events = IInputEvent::Create(records);
+        std::move(events.begin(), events.end(), std::back_inserter(keyEvents));
+    });
+    return keyEvents;
+}
+
+// Routine Description:
+// - converts a wchar_t* into a series of key event INPUT_RECORDs as if it was
+//   typed from the keyboard. Instead of returning all of them at once, they're
+//   passed to the given callback in chunks of at most pasteChunkSize records,
+//   which keeps the memory usage of large pastes bounded.
+// Arguments:
+// - pData - the text to convert
+// - cchData - the size of pData, in wchars
+// - bracketedPaste - should this be bracketed with paste control sequences
+// - flush - receives the records, chunk by chunk
+// Return Value:
+// - <none>
+// Note:
+// - will throw exception on error
+void Clipboard::TextToInputRecords(_In_reads_(cchData) const wchar_t* const pData,
+                                   const size_t cchData,
+                                   const bool bracketedPaste,
+                                   const std::function<void(std::span<const INPUT_RECORD>)>& flush)
 {
     THROW_HR_IF_NULL(E_INVALIDARG, pData);
 
-    std::deque<std::unique_ptr<IInputEvent>> keyEvents;
+    // A chunk of 4096 records is ~80KB large and corresponds to about 2000 pasted characters.
+    static constexpr size_t pasteChunkSize = 4096;
+
+    std::vector<INPUT_RECORD> records;
+    records.reserve(pasteChunkSize);
+
+    const auto pushRecord = [&](const INPUT_RECORD& record) {
+        records.emplace_back(record);
+        if (records.size() >= pasteChunkSize)
+        {
+            flush(records);
+            records.clear();
+        }
+    };
     const auto pushControlSequence = [&](const std::wstring_view sequence) {
         std::for_each(sequence.begin(), sequence.end(), [&](const auto wch) {
-            keyEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
-            keyEvents.push_back(std::make_unique<KeyEvent>(false, 1ui16, 0ui16, 0ui16, wch, 0));
+            pushRecord(KeyEvent{ true, 1ui16, 0ui16, 0ui16, wch, 0 }.ToInputRecord());
+            pushRecord(KeyEvent{ false, 1ui16, 0ui16, 0ui16, wch, 0 }.ToInputRecord());
         });
     };
 
@@ -194,11 +244,9 @@ std::deque<std::unique_ptr<IInputEvent>> Clipboard::TextToKeyEvents(_In_reads_(c
         }
 
         const auto codepage = ServiceLocator::LocateGlobals().getConsoleInformation().OutputCP;
-        auto convertedEvents = CharToKeyEvents(currentChar, codepage);
-        while (!convertedEvents.empty())
+        for (const auto& event : CharToKeyEvents(currentChar, codepage))
         {
-            keyEvents.push_back(std::move(convertedEvents.front()));
-            convertedEvents.pop_front();
+            pushRecord(event->ToInputRecord());
         }
     }
 
@@ -206,7 +254,11 @@ std::deque<std::unique_ptr<IInputEvent>> Clipboard::TextToKeyEvents(_In_reads_(c
     {
         pushControlSequence(L"\x1b[201~");
     }
-    return keyEvents;
+
+    if (!records.empty())
+    {
+        flush(records);
+    }
 }
 
 // Routine Description:
@@ -233,9 +285,13 @@ void Clipboard::StoreSelectionToClipboard(const bool copyFormatting)
     const auto& buffer = gci.GetActiveOutputBuffer().GetTextBuffer();
     const auto& renderSettings = gci.GetRenderSettings();
 
-    const auto GetAttributeColors = [&](const auto& attr) {
-        return renderSettings.GetAttributeColors(attr);
-    };
+    std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors;
+    if (copyFormatting)
+    {
+        GetAttributeColors = [&](const auto& attr) {
+            return renderSettings.GetAttributeColors(attr);
+        };
+    }
 
     bool includeCRLF, trimTrailingWhitespace;
     if (WI_IsFlagSet(OneCoreSafeGetKeyState(VK_SHIFT), KEY_PRESSED))
@@ -23,6 +23,7 @@
 #define CM_CONIME_KL_ACTIVATE    (WM_USER+15)
 #define CM_CONSOLE_MSG           (WM_USER+16)
 #define CM_UPDATE_EDITKEYS       (WM_USER+17)
+#define CM_FALLBACK_TO_GDI       (WM_USER+20)
 
 #ifdef DBG
 #define CM_SET_KEY_STATE         (WM_USER+18)
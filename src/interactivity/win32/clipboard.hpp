@@ -38,6 +38,10 @@ namespace Microsoft::Console::Interactivity::Win32
         std::deque<std::unique_ptr<IInputEvent>> TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                  const size_t cchData,
                                                                  const bool bracketedPaste = false);
+        void TextToInputRecords(_In_reads_(cchData) const wchar_t* const pData,
+                                const size_t cchData,
+                                const bool bracketedPaste,
+                                const std::function<void(std::span<const INPUT_RECORD>)>& flush);
 
         void StoreSelectionToClipboard(_In_ const bool fAlsoCopyFormatting);
 
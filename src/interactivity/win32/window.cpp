@@ -4,6 +4,7 @@
 #include "precomp.h"
 
 #include "ConsoleControl.hpp"
+#include "CustomWindowMessages.h"
 #include "icon.hpp"
 #include "menu.hpp"
 #include "window.hpp"
@@ -234,9 +235,26 @@ void Window::_UpdateSystemMetrics() const
 #endif
 #if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
         case UseDx::AtlasEngine:
-            pAtlasEngine = new AtlasEngine();
-            g.pRender->AddRenderEngine(pAtlasEngine);
-            break;
+            // The constructor only fails if Direct2D or DirectWrite are unavailable.
+            // That's not fatal for us, because we can still use GDI instead.
+            try
+            {
+                pAtlasEngine = new AtlasEngine();
+                g.pRender->AddRenderEngine(pAtlasEngine);
+                // Failures to create a swap chain only show up on the render thread.
+                // Post them to the window thread, which then swaps over to GDI.
+                g.pRender->SetRendererEnteredErrorStateCallback([this]() {
+                    PostMessageW(_hWnd, CM_FALLBACK_TO_GDI, 0, 0);
+                });
+                break;
+            }
+            catch (...)
+            {
+                LOG_CAUGHT_EXCEPTION();
+                delete pAtlasEngine;
+                pAtlasEngine = nullptr;
+            }
+            [[fallthrough]];
 #endif
         default:
             pGdiEngine = new GdiEngine();
@@ -1263,6 +1281,47 @@ void Window::ToggleFullscreen()
     SetIsFullscreen(!IsInFullscreen());
 }
 
+// Routine Description:
+// - Replaces the AtlasEngine with a GdiEngine after it entered an error state,
+//   for instance because Direct3D isn't available in this session.
+// - Must be called with the console lock held.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Window::_FallbackToGdiEngine()
+{
+#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
+    auto& g = ServiceLocator::LocateGlobals();
+    if (!pAtlasEngine || !g.pRender)
+    {
+        return;
+    }
+
+    try
+    {
+        auto gdiEngine = std::make_unique<GdiEngine>();
+        THROW_IF_FAILED(gdiEngine->SetHwnd(_hWnd));
+
+        g.pRender->SetRendererEnteredErrorStateCallback(nullptr);
+        g.pRender->RemoveRenderEngine(pAtlasEngine);
+        g.pRender->AddRenderEngine(gdiEngine.get());
+        pGdiEngine = gdiEngine.release();
+    }
+    CATCH_LOG_RETURN();
+
+    // The render thread is paused while the renderer is in its error state,
+    // so nothing can be using the AtlasEngine anymore.
+    delete pAtlasEngine;
+    pAtlasEngine = nullptr;
+
+    // The GdiEngine needs to know about the font and the window contents need a full repaint.
+    GetScreenInfo().RefreshFontWithRenderer();
+    LOG_IF_WIN32_BOOL_FALSE(InvalidateRect(_hWnd, nullptr, FALSE));
+    g.pRender->ResetErrorStateAndResume();
+#endif
+}
+
 void Window::s_ReinitializeFontsForDPIChange()
 {
     auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
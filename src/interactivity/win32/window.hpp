@@ -111,6 +111,7 @@ namespace Microsoft::Console::Interactivity::Win32
         [[nodiscard]] NTSTATUS _MakeWindow(_In_ Settings* const pSettings,
                                            _In_ SCREEN_INFORMATION* const pScreen);
         void _CloseWindow() const;
+        void _FallbackToGdiEngine();
 
         static ATOM s_atomWindowClass;
         Settings* _pSettings;
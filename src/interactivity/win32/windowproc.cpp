@@ -702,6 +702,12 @@ using namespace Microsoft::Console::Types;
         break;
     }
 
+    case CM_FALLBACK_TO_GDI:
+    {
+        _FallbackToGdiEngine();
+        break;
+    }
+
 #ifdef DBG
     case CM_SET_KEY_STATE:
     {
@@ -836,7 +842,16 @@ void Window::_HandleWindowPosChanged(const LPARAM lParam)
     const auto hdc = BeginPaint(hwnd, &ps);
     RETURN_HR_IF_NULL(E_FAIL, hdc);
 
-    if (ServiceLocator::LocateGlobals().pRender != nullptr)
+    // The AtlasEngine presents through a flip model swap chain whose contents are retained by DWM.
+    // Uncovering or moving the window doesn't require us to draw anything, and the engine
+    // already invalidates itself whenever the swap chain gets resized or recreated.
+#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
+    const auto needsSystemRedraw = pAtlasEngine == nullptr;
+#else
+    constexpr auto needsSystemRedraw = true;
+#endif
+
+    if (needsSystemRedraw && ServiceLocator::LocateGlobals().pRender != nullptr)
     {
         // In lieu of actually painting right now, we're just going to aggregate this information in the renderer
         // and let it paint whenever it feels appropriate.
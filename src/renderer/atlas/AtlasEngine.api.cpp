@@ -82,16 +82,21 @@ constexpr HRESULT vec2_narrow(U x, U y, vec2<T>& out) noexcept
     return Invalidate(&rect);
 }
 
-[[nodiscard]] HRESULT AtlasEngine::InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept
+[[nodiscard]] HRESULT AtlasEngine::InvalidateSelection(std::span<const til::rect> /*rectangles*/) noexcept
 {
-    for (const auto& rect : rectangles)
-    {
-        // BeginPaint() protects against invalid out of bounds numbers.
-        // TODO: rect can contain invalid out of bounds coordinates when the selection is being
-        // dragged outside of the viewport (and the window begins scrolling automatically).
-        _api.invalidatedRows.start = gsl::narrow_cast<u16>(std::min<int>(_api.invalidatedRows.start, std::max<int>(0, rect.top)));
-        _api.invalidatedRows.end = gsl::narrow_cast<u16>(std::max<int>(_api.invalidatedRows.end, std::max<int>(0, rect.bottom)));
-    }
+    // The selection is drawn on a layer of its own, see PaintSelectionLayer().
+    return S_OK;
+}
+
+[[nodiscard]] HRESULT AtlasEngine::InvalidateOverlay(const til::rect* const /*psrRegion*/) noexcept
+{
+    // The overlays are drawn on a layer of their own, see StartOverlayLayer().
+    return S_OK;
+}
+
+[[nodiscard]] HRESULT AtlasEngine::InvalidateSearchHighlights(const til::rect* const /*psrRegion*/) noexcept
+{
+    // The search highlights are drawn on a layer of their own, see PaintSearchHighlightLayer().
     return S_OK;
 }
 
@@ -162,9 +167,13 @@ constexpr HRESULT vec2_narrow(U x, U y, vec2<T>& out) noexcept
 
 [[nodiscard]] HRESULT AtlasEngine::UpdateSoftFont(const std::span<const uint16_t> bitPattern, const til::size cellSize, const size_t centeringHint) noexcept
 {
-    const auto softFont = _api.s.write()->font.write();
-    softFont->softFontPattern = std::vector(bitPattern.begin(), bitPattern.end());
-    softFont->softFontCellSize = cellSize;
+    const auto& current = *_api.s->softFont;
+    if (current.softFontCellSize != cellSize || !std::equal(current.softFontPattern.begin(), current.softFontPattern.end(), bitPattern.begin(), bitPattern.end()))
+    {
+        const auto softFont = _api.s.write()->softFont.write();
+        softFont->softFontPattern = std::vector(bitPattern.begin(), bitPattern.end());
+        softFont->softFontCellSize = cellSize;
+    }
     return S_OK;
 }
 
@@ -301,6 +310,26 @@ CATCH_RETURN()
     return S_OK;
 }
 
+void AtlasEngine::SetPerfCounters(PerfCounters* counters) noexcept
+{
+    _p.perfCounters = counters;
+}
+
+[[nodiscard]] bool AtlasEngine::GetPerfOverlay() const noexcept
+{
+    return _api.perfOverlay;
+}
+
+void AtlasEngine::SetPerfOverlay(bool enable) noexcept
+{
+    if (_api.perfOverlay != enable)
+    {
+        _api.perfOverlay = enable;
+        // This ensures that the area below the overlay gets redrawn when it's hidden again.
+        std::ignore = InvalidateAll();
+    }
+}
+
 #pragma endregion
 
 #pragma region DxRenderer
@@ -376,6 +405,15 @@ void AtlasEngine::SetForceFullRepaintRendering(bool enable) noexcept
     return S_OK;
 }
 
+void AtlasEngine::SetPixelShaderFrameRate(int32_t value) noexcept
+{
+    const auto frameRate = gsl::narrow_cast<u16>(std::clamp(value, 0, 1000));
+    if (_api.s->misc->customPixelShaderFrameRate != frameRate)
+    {
+        _api.s.write()->misc.write()->customPixelShaderFrameRate = frameRate;
+    }
+}
+
 void AtlasEngine::SetPixelShaderPath(std::wstring_view value) noexcept
 try
 {
@@ -405,6 +443,25 @@ void AtlasEngine::SetSelectionBackground(const COLORREF color, const float alpha
     }
 }
 
+void AtlasEngine::SetSmoothScrollOffset(const float rows) noexcept
+{
+    _api.smoothScrollOffset = rows;
+}
+
+void AtlasEngine::SetMonitorHwnd(HWND hwnd) noexcept
+{
+    // Present() picks this up and only switches adapters if the new window is on a monitor driven by another one.
+    _monitorHwnd.store(hwnd, std::memory_order_relaxed);
+}
+
+void AtlasEngine::SetPreferLowPowerAdapter(bool enable) noexcept
+{
+    if (_api.s->target->preferLowPowerAdapter != enable)
+    {
+        _api.s.write()->target.write()->preferLowPowerAdapter = enable;
+    }
+}
+
 void AtlasEngine::SetSoftwareRendering(bool enable) noexcept
 {
     if (_api.s->target->useSoftwareRendering != enable)
@@ -413,6 +470,27 @@ void AtlasEngine::SetSoftwareRendering(bool enable) noexcept
     }
 }
 
+void AtlasEngine::SetOffscreen(bool enable) noexcept
+{
+    if (_api.s->target->offscreen != enable)
+    {
+        _api.s.write()->target.write()->offscreen = enable;
+    }
+}
+
+void AtlasEngine::SetForceD2DMode(bool enable) noexcept
+{
+    if (_api.s->target->forceD2DMode != enable)
+    {
+        _api.s.write()->target.write()->forceD2DMode = enable;
+    }
+}
+
+wil::com_ptr<ID3D11Texture2D> AtlasEngine::GetOffscreenTarget() const noexcept
+{
+    return _p.swapChain.offscreenTarget;
+}
+
 void AtlasEngine::SetWarningCallback(std::function<void(HRESULT)> pfn) noexcept
 {
     _p.warningCallback = std::move(pfn);
@@ -596,35 +674,9 @@ void AtlasEngine::_resolveFontMetrics(const wchar_t* requestedFaceName, const Fo
         requestedWeight = DWRITE_FONT_WEIGHT_NORMAL;
     }
 
-    wil::com_ptr<IDWriteFontCollection> fontCollection;
-    THROW_IF_FAILED(_p.dwriteFactory->GetSystemFontCollection(fontCollection.addressof(), FALSE));
-
-    u32 index = 0;
-    BOOL exists = false;
-    THROW_IF_FAILED(fontCollection->FindFamilyName(requestedFaceName, &index, &exists));
-
-    if constexpr (Feature_NearbyFontLoading::IsEnabled())
-    {
-        if (!exists)
-        {
-            fontCollection = FontCache::GetCached();
-            THROW_IF_FAILED(fontCollection->FindFamilyName(requestedFaceName, &index, &exists));
-        }
-    }
-
-    THROW_HR_IF(DWRITE_E_NOFONT, !exists);
-
-    wil::com_ptr<IDWriteFontFamily> fontFamily;
-    THROW_IF_FAILED(fontCollection->GetFontFamily(index, fontFamily.addressof()));
-
-    wil::com_ptr<IDWriteFont> font;
-    THROW_IF_FAILED(fontFamily->GetFirstMatchingFont(static_cast<DWRITE_FONT_WEIGHT>(requestedWeight), DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, font.addressof()));
-
-    wil::com_ptr<IDWriteFontFace> fontFace;
-    THROW_IF_FAILED(font->CreateFontFace(fontFace.addressof()));
-
-    DWRITE_FONT_METRICS metrics{};
-    fontFace->GetMetrics(&metrics);
+    // This is shared with all other AtlasEngine instances in this process.
+    auto resolved = FontCache::ResolveFont(_p.dwriteFactory.get(), requestedFaceName, static_cast<DWRITE_FONT_WEIGHT>(requestedWeight));
+    const auto& metrics = resolved.metrics;
 
     // Point sizes are commonly treated at a 72 DPI scale
     // (including by OpenType), whereas DirectWrite uses 96 DPI.
@@ -646,18 +698,9 @@ void AtlasEngine::_resolveFontMetrics(const wchar_t* requestedFaceName, const Fo
     // According to the CSS spec, if it's impossible to determine the advance width,
     // it must be assumed to be 0.5em wide. em in CSS refers to the computed font-size.
     auto advanceWidth = 0.5f * fontSizeInPx;
+    if (resolved.zeroAdvanceWidth)
     {
-        static constexpr u32 codePoint = '0';
-
-        u16 glyphIndex;
-        THROW_IF_FAILED(fontFace->GetGlyphIndicesW(&codePoint, 1, &glyphIndex));
-
-        if (glyphIndex)
-        {
-            DWRITE_GLYPH_METRICS glyphMetrics{};
-            THROW_IF_FAILED(fontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &glyphMetrics, FALSE));
-            advanceWidth = static_cast<f32>(glyphMetrics.advanceWidth) * designUnitsPerPx;
-        }
+        advanceWidth = static_cast<f32>(resolved.zeroAdvanceWidth) * designUnitsPerPx;
     }
 
     auto adjustedWidth = std::roundf(fontInfoDesired.GetCellWidth().Resolve(advanceWidth, dpi, fontSizeInPx, advanceWidth));
@@ -738,8 +781,8 @@ void AtlasEngine::_resolveFontMetrics(const wchar_t* requestedFaceName, const Fo
         // NOTE: From this point onward no early returns or throwing code should exist,
         // as we might cause _api to be in an inconsistent state otherwise.
 
-        fontMetrics->fontCollection = std::move(fontCollection);
-        fontMetrics->fontFamily = std::move(fontFamily);
+        fontMetrics->fontCollection = std::move(resolved.fontCollection);
+        fontMetrics->fontFamily = std::move(resolved.fontFamily);
         fontMetrics->fontName = std::move(fontName);
         fontMetrics->fontSize = fontSizeInPx;
         fontMetrics->cellSize = { cellWidth, cellHeight };
@@ -5,7 +5,10 @@
 #include "AtlasEngine.h"
 
 #include "Backend.h"
+#include "BuiltinGlyphs.h"
 #include "DWriteTextAnalysis.h"
+#include "FontFallback.h"
+#include "../../buffer/out/Row.hpp"
 #include "../../interactivity/win32/CustomWindowMessages.h"
 
 // #### NOTE ####
@@ -70,6 +73,41 @@ try
         _handleSettingsUpdate();
     }
 
+    // The frames we presented while the swap chain was occluded may never have made it to the screen.
+    if (_p.swapChain.revealed)
+    {
+        _api.invalidatedRows = invalidatedRowsAll;
+        _p.swapChain.revealed = false;
+    }
+
+    // Rows with characters whose font fallback lookup was still pending have been drawn with U+FFFD.
+    // Once any lookup finished we redraw the viewport and those rows will hopefully map to an actual font now.
+    if (_api.fontFallback)
+    {
+        const auto generation = _api.fontFallback->Generation();
+        if (_api.fontFallbackPending && generation != _api.fontFallbackGeneration)
+        {
+            _api.invalidatedRows = invalidatedRowsAll;
+            _api.fontFallbackPending = false;
+        }
+        _api.fontFallbackGeneration = generation;
+    }
+
+    // The overlay is drawn into the swap chain on top of the backend's output. Invalidating the rows
+    // below it ensures that the backends erase the previous overlay by drawing these rows again.
+    const auto perfOverlay = _api.perfOverlay && _p.perfCounters;
+    if (perfOverlay && !_perfOverlay.enabled)
+    {
+        // Don't compute rates across the time the overlay was hidden.
+        _perfOverlay.text.clear();
+    }
+    _perfOverlay.enabled = perfOverlay;
+    if (perfOverlay)
+    {
+        _api.invalidatedRows.start = 0;
+        _api.invalidatedRows.end = std::max(_api.invalidatedRows.end, _perfOverlayRowCount());
+    }
+
     if constexpr (ATLAS_DEBUG_DISABLE_PARTIAL_INVALIDATION)
     {
         _api.invalidatedRows = invalidatedRowsAll;
@@ -123,6 +161,8 @@ try
         til::CoordTypeMin,
     };
     _p.invalidatedRows = _api.invalidatedRows;
+    _p.backgroundBitmapDirtyRows = { u16max, u16min };
+    _p.backgroundBitmapBaseGeneration = _p.colorBitmapGenerations[0];
     _p.cursorRect = {};
     _p.scrollOffset = _api.scrollOffset;
 
@@ -200,6 +240,10 @@ try
                 {
                     memmove(dst, src, bytes);
                     _p.colorBitmapGenerations[i].bump();
+                    if (i == 0)
+                    {
+                        _p.backgroundBitmapDirtyRows = { 0, _p.s->cellCount.y };
+                    }
                 }
 
                 src += _p.colorBitmapDepthStride;
@@ -238,6 +282,17 @@ try
         }
     }
 
+    // The smooth scroll offset moves the entire frame up by a few pixels. The rows themselves don't
+    // change and don't need to be shaped again, but the frame needs to be drawn and presented in full.
+    {
+        const auto smoothScrollOffset = gsl::narrow_cast<i32>(lrintf(_api.smoothScrollOffset * _p.s->font->cellSize.y));
+        if (smoothScrollOffset || _p.smoothScrollOffset)
+        {
+            _p.dirtyRectInPx = { 0, 0, _p.s->targetSize.x, _p.s->targetSize.y };
+        }
+        _p.smoothScrollOffset = smoothScrollOffset;
+    }
+
 #if ATLAS_DEBUG_CONTINUOUS_REDRAW
     _p.MarkAllAsDirty();
 #endif
@@ -250,6 +305,15 @@ CATCH_RETURN()
 try
 {
     _flushBufferLine();
+    _shapeBufferLines();
+
+    // Most lines take less than a microsecond to shape, which is why this is only flushed once per frame.
+    if (_p.perfCounters)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(_api.shapingTime);
+        PerfCounters::Add(_p.perfCounters->shapingMicroseconds, gsl::narrow_cast<u64>(elapsed.count()));
+        _api.shapingTime -= elapsed;
+    }
 
     _api.invalidatedCursorArea = invalidatedAreaNone;
     _api.invalidatedRows = invalidatedRowsNone;
@@ -297,15 +361,42 @@ CATCH_RETURN()
 try
 {
     const auto y = gsl::narrow_cast<u16>(clamp<int>(coord.y, 0, _p.s->cellCount.y));
+    const auto x = gsl::narrow_cast<u16>(clamp<int>(coord.x, 0, _p.s->cellCount.x));
+    auto columnEnd = x;
+
+    if (_overlayLayer.painting)
+    {
+        if (y >= _p.s->cellCount.y)
+        {
+            return S_OK;
+        }
+
+        auto& run = _overlayLayer.runs.emplace_back();
+        run.foreground = _api.currentForeground;
+        // The overlays are drawn on top of the text, which must not shine through them.
+        run.background = _api.currentBackground | 0xff000000;
+        run.attributes = _api.attributes;
+        run.row = y;
+
+        for (const auto& cluster : clusters)
+        {
+            for (const auto& ch : cluster.GetText())
+            {
+                run.text.push_back(ch);
+                run.columns.emplace_back(columnEnd);
+            }
+            columnEnd += gsl::narrow_cast<u16>(cluster.GetColumns());
+        }
+
+        run.columns.emplace_back(columnEnd);
+        return S_OK;
+    }
 
     if (_api.lastPaintBufferLineCoord.y != y)
     {
         _flushBufferLine();
     }
 
-    const auto x = gsl::narrow_cast<u16>(clamp<int>(coord.x, 0, _p.s->cellCount.x));
-    auto columnEnd = x;
-
     // _api.bufferLineColumn contains 1 more item than _api.bufferLine, as it represents the
     // past-the-end index. It'll get appended again later once we built our new _api.bufferLine.
     if (!_api.bufferLineColumn.empty())
@@ -329,37 +420,74 @@ try
         _api.bufferLineColumn.emplace_back(columnEnd);
     }
 
+    _fillColorBitmap(y, x, columnEnd);
+
+    _api.lastPaintBufferLineCoord = { x, y };
+    return S_OK;
+}
+CATCH_RETURN()
+
+[[nodiscard]] HRESULT AtlasEngine::PaintBufferRow(const BufferRowInfo& info) noexcept
+try
+{
+    const auto y = gsl::narrow_cast<u16>(clamp<int>(info.targetRow, 0, _p.s->cellCount.y));
+    const auto& row = *info.row;
+    const auto& renderSettings = *info.renderSettings;
+
+    _flushBufferLine();
+
+    // If the first column is the trailing half of a wide glyph, we start at its leading half, just like
+    // Renderer::_PaintBufferOutputHelper does with its fTrimLeft. The text is assembled straight from the ROW.
+    const auto columnEnd = std::min<til::CoordType>(info.columnEnd, row.size());
+    auto column = row.NavigateToPrevious(info.columnBegin + 1);
+    til::CoordType runEnd = 0;
+
+    _api.lastPaintBufferLineCoord = { gsl::narrow_cast<u16>(clamp<int>(column, 0, _p.s->cellCount.x)), y };
+
+    for (const auto& run : row.Attributes().runs())
     {
-        const auto shift = gsl::narrow_cast<u8>(_api.lineRendition != LineRendition::SingleWidth);
-        const auto row = _p.colorBitmap.begin() + _p.colorBitmapRowStride * y;
-        auto beg = row + (static_cast<size_t>(x) << shift);
-        auto end = row + (static_cast<size_t>(columnEnd) << shift);
+        runEnd += run.length;
+        if (runEnd <= column)
+        {
+            continue;
+        }
 
-        const u32 colors[] = {
-            u32ColorPremultiply(_api.currentBackground),
-            _api.currentForeground,
-        };
+        _updateCurrentAttributes(run.value, renderSettings);
 
-        for (size_t i = 0; i < 2; ++i)
+        // _api.bufferLineColumn contains 1 more item than _api.bufferLine. See PaintBufferLine().
+        if (!_api.bufferLineColumn.empty())
         {
-            const auto color = colors[i];
+            _api.bufferLineColumn.pop_back();
+        }
 
-            for (auto it = beg; it != end; ++it)
+        // Wide glyphs belong to the run of their leading half, which is why column may end up past runEnd.
+        const auto runBeg = column;
+        const auto end = std::min(runEnd, columnEnd);
+        while (column < end)
+        {
+            const auto col = gsl::narrow_cast<u16>(column);
+            for (const auto& ch : row.GlyphAt(column))
             {
-                if (*it != color)
-                {
-                    _p.colorBitmapGenerations[i].bump();
-                    std::fill(it, end, color);
-                    break;
-                }
+                _api.bufferLine.emplace_back(ch);
+                _api.bufferLineColumn.emplace_back(col);
             }
+            column = row.NavigateToNext(column);
+        }
+
+        _api.bufferLineColumn.emplace_back(gsl::narrow_cast<u16>(column));
+        _fillColorBitmap(y, gsl::narrow_cast<u16>(runBeg), gsl::narrow_cast<u16>(column));
 
-            beg += _p.colorBitmapDepthStride;
-            end += _p.colorBitmapDepthStride;
+        if (column >= columnEnd)
+        {
+            break;
         }
     }
 
-    _api.lastPaintBufferLineCoord = { x, y };
+    if (const auto slice = row.GetImageSlice())
+    {
+        _updateImageBitmap(*_p.rows[y], *slice);
+    }
+
     return S_OK;
 }
 CATCH_RETURN()
@@ -372,6 +500,16 @@ try
     const auto from = gsl::narrow_cast<u16>(clamp<til::CoordType>(coordTarget.x << shift, 0, _p.s->cellCount.x - 1));
     const auto to = gsl::narrow_cast<u16>(clamp<size_t>((coordTarget.x + cchLine) << shift, from, _p.s->cellCount.x));
     const auto fg = gsl::narrow_cast<u32>(color) | 0xff000000;
+
+    if (_overlayLayer.painting)
+    {
+        if (y < _p.s->cellCount.y)
+        {
+            _overlayLayer.gridLines.push_back({ lines, fg, y, from, to });
+        }
+        return S_OK;
+    }
+
     _p.rows[y]->gridLineRanges.emplace_back(lines, fg, from, to);
     return S_OK;
 }
@@ -401,6 +539,164 @@ try
 }
 CATCH_RETURN()
 
+// The backends draw the selection as an overlay on top of the text, which is why selection changes
+// don't need to invalidate any rows: InvalidateSelection() is a no-op and instead we compare the
+// selection of each row with that of the previous frame and only mark the changed pixels as dirty.
+[[nodiscard]] HRESULT AtlasEngine::PaintSelectionLayer(std::span<const til::rect> rects) noexcept
+try
+{
+    // See PaintSelection().
+    _flushBufferLine();
+
+    auto it = rects.begin();
+    const auto end = rects.end();
+
+    for (u16 y = 0; y < _p.s->cellCount.y; ++y)
+    {
+        u16 from = 0;
+        u16 to = 0;
+
+        for (; it != end && it->top < y; ++it)
+        {
+        }
+        if (it != end && it->top == y)
+        {
+            from = gsl::narrow_cast<u16>(clamp<til::CoordType>(it->left, 0, _p.s->cellCount.x - 1));
+            to = gsl::narrow_cast<u16>(clamp<til::CoordType>(it->right, from, _p.s->cellCount.x));
+            ++it;
+        }
+
+        auto& row = *_p.rows[y];
+        if (row.selectionFrom == from && row.selectionTo == to)
+        {
+            continue;
+        }
+
+        _p.dirtyRectInPx.left = std::min(_p.dirtyRectInPx.left, std::min(from, row.selectionFrom) * _p.s->font->cellSize.x);
+        _p.dirtyRectInPx.top = std::min(_p.dirtyRectInPx.top, y * _p.s->font->cellSize.y);
+        _p.dirtyRectInPx.right = std::max(_p.dirtyRectInPx.right, std::max(to, row.selectionTo) * _p.s->font->cellSize.x);
+        _p.dirtyRectInPx.bottom = std::max(_p.dirtyRectInPx.bottom, (y + 1) * _p.s->font->cellSize.y);
+
+        row.selectionFrom = from;
+        row.selectionTo = to;
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Just like the selection, the backends draw the search highlights on top of the text. Each row's highlights get
+// compared with those of the previous frame, so that only the rows whose highlights changed need to be presented.
+[[nodiscard]] HRESULT AtlasEngine::PaintSearchHighlightLayer(std::span<const SearchHighlightRun> runs, COLORREF color) noexcept
+try
+{
+    const auto fg = gsl::narrow_cast<u32>(color) | 0xff000000;
+
+    auto it = runs.begin();
+    const auto end = runs.end();
+
+    for (u16 y = 0; y < _p.s->cellCount.y; ++y)
+    {
+        for (; it != end && it->row < y; ++it)
+        {
+        }
+
+        auto& row = *_p.rows[y];
+        auto& highlights = _api.searchHighlightsScratch;
+        highlights.clear();
+
+        for (; it != end && it->row == y; ++it)
+        {
+            const auto from = gsl::narrow_cast<u16>(clamp<til::CoordType>(it->left, 0, _p.s->cellCount.x - 1));
+            const auto to = gsl::narrow_cast<u16>(clamp<til::CoordType>(it->right, from, _p.s->cellCount.x));
+            if (from < to)
+            {
+                highlights.push_back({ it->lines, fg, from, to });
+            }
+        }
+
+        if (row.searchHighlights == highlights)
+        {
+            continue;
+        }
+
+        u16 left = _p.s->cellCount.x;
+        u16 right = 0;
+        for (const auto& v : { &row.searchHighlights, &highlights })
+        {
+            if (!v->empty())
+            {
+                left = std::min(left, v->front().from);
+                right = std::max(right, v->back().to);
+            }
+        }
+
+        _p.dirtyRectInPx.left = std::min(_p.dirtyRectInPx.left, left * _p.s->font->cellSize.x);
+        _p.dirtyRectInPx.top = std::min(_p.dirtyRectInPx.top, y * _p.s->font->cellSize.y);
+        _p.dirtyRectInPx.right = std::max(_p.dirtyRectInPx.right, right * _p.s->font->cellSize.x);
+        _p.dirtyRectInPx.bottom = std::max(_p.dirtyRectInPx.bottom, (y + 1) * _p.s->font->cellSize.y);
+
+        // Swapping instead of copying means that the vectors get reused across frames.
+        row.searchHighlights.swap(highlights);
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// The overlays (the IME composition) are drawn on a layer of their own during Present(), by _drawOverlayLayer().
+// In between these two calls PaintBufferLine() and PaintBufferGridLines() only record what needs to be drawn.
+// Just like with PaintSelectionLayer() the text underneath doesn't need to be invalidated: The overlays are
+// compared with those of the previous frame instead and only the pixels they cover are marked as dirty.
+[[nodiscard]] HRESULT AtlasEngine::StartOverlayLayer() noexcept
+try
+{
+    // See PaintSelection().
+    _flushBufferLine();
+
+    std::swap(_overlayLayer.runs, _overlayLayer.previousRuns);
+    std::swap(_overlayLayer.gridLines, _overlayLayer.previousGridLines);
+    _overlayLayer.runs.clear();
+    _overlayLayer.gridLines.clear();
+    _overlayLayer.painting = true;
+    return S_OK;
+}
+CATCH_RETURN()
+
+[[nodiscard]] HRESULT AtlasEngine::EndOverlayLayer() noexcept
+{
+    _overlayLayer.painting = false;
+
+    // Present1() scrolls the previous overlays along with the text, so they need to be erased even if they didn't change.
+    if (_overlayLayer.runs == _overlayLayer.previousRuns && _overlayLayer.gridLines == _overlayLayer.previousGridLines && !_p.scrollOffset)
+    {
+        return S_OK;
+    }
+
+    const auto rect = _overlayLayerRectInPx();
+    auto dirty = _overlayLayer.previousRectInPx | rect;
+
+    if (_p.scrollOffset && _overlayLayer.previousRectInPx)
+    {
+        const auto offsetInPx = _p.scrollOffset * _p.s->font->cellSize.y;
+        auto scrolled = _overlayLayer.previousRectInPx;
+        scrolled.top += offsetInPx;
+        scrolled.bottom += offsetInPx;
+        dirty |= scrolled;
+    }
+
+    if (dirty)
+    {
+        _p.dirtyRectInPx.left = std::min(_p.dirtyRectInPx.left, dirty.left);
+        _p.dirtyRectInPx.top = std::min(_p.dirtyRectInPx.top, dirty.top);
+        _p.dirtyRectInPx.right = std::max(_p.dirtyRectInPx.right, dirty.right);
+        _p.dirtyRectInPx.bottom = std::max(_p.dirtyRectInPx.bottom, dirty.bottom);
+    }
+
+    _overlayLayer.previousRectInPx = rect;
+    return S_OK;
+}
+
 [[nodiscard]] HRESULT AtlasEngine::PaintCursor(const CursorOptions& options) noexcept
 try
 {
@@ -466,29 +762,18 @@ CATCH_RETURN()
 [[nodiscard]] HRESULT AtlasEngine::UpdateDrawingBrushes(const TextAttribute& textAttributes, const RenderSettings& renderSettings, const gsl::not_null<IRenderData*> /*pData*/, const bool usingSoftFont, const bool isSettingDefaultBrushes) noexcept
 try
 {
-    auto [fg, bg] = renderSettings.GetAttributeColorsWithAlpha(textAttributes);
-    fg |= 0xff000000;
-    bg |= _api.backgroundOpaqueMixin;
-
     if (!isSettingDefaultBrushes)
     {
-        auto attributes = FontRelevantAttributes::None;
-        WI_SetFlagIf(attributes, FontRelevantAttributes::Bold, textAttributes.IsIntense() && renderSettings.GetRenderMode(RenderSettings::Mode::IntenseIsBold));
-        WI_SetFlagIf(attributes, FontRelevantAttributes::Italic, textAttributes.IsItalic());
-
-        if (_api.attributes != attributes)
-        {
-            _flushBufferLine();
-        }
-
-        _api.currentBackground = gsl::narrow_cast<u32>(bg);
-        _api.currentForeground = gsl::narrow_cast<u32>(fg);
-        _api.attributes = attributes;
+        _updateCurrentAttributes(textAttributes, renderSettings);
     }
-    else if (textAttributes.BackgroundIsDefault() && bg != _api.s->misc->backgroundColor)
+    else if (textAttributes.BackgroundIsDefault())
     {
-        _api.s.write()->misc.write()->backgroundColor = bg;
-        _p.s.write()->misc.write()->backgroundColor = bg;
+        const auto bg = renderSettings.GetAttributeColorsWithAlpha(textAttributes).second | _api.backgroundOpaqueMixin;
+        if (bg != _api.s->misc->backgroundColor)
+        {
+            _api.s.write()->misc.write()->backgroundColor = bg;
+            _p.s.write()->misc.write()->backgroundColor = bg;
+        }
     }
 
     return S_OK;
@@ -502,15 +787,28 @@ void AtlasEngine::_handleSettingsUpdate()
     const auto targetChanged = _p.s->target != _api.s->target;
     const auto fontChanged = _p.s->font != _api.s->font;
     const auto cellCountChanged = _p.s->cellCount != _api.s->cellCount;
+    // Most target changes (the hwnd, transparency, etc.) only require a new swap chain, which _handleSwapChainUpdate()
+    // takes care of. Recreating the backend on top of that would needlessly throw away its glyph atlas.
+    const auto adapterChanged = targetChanged &&
+                                (_p.s->target->useSoftwareRendering != _api.s->target->useSoftwareRendering ||
+                                 _p.s->target->preferLowPowerAdapter != _api.s->target->preferLowPowerAdapter);
+    const auto backendChanged = targetChanged &&
+                                (_p.s->target->forceD2DMode != _api.s->target->forceD2DMode ||
+                                 _p.s->target->offscreen != _api.s->target->offscreen);
 
     _p.s = _api.s;
 
-    if (targetChanged)
+    if (adapterChanged)
     {
-        // target->useSoftwareRendering affects the selection of our IDXGIAdapter which requires us to reset _p.dxgi.
+        // These affect the selection of our IDXGIAdapter which requires us to reset _p.dxgi.
         // This will indirectly also recreate the backend, when AtlasEngine::_recreateAdapter() detects this change.
         _p.dxgi = {};
     }
+    else if (backendChanged)
+    {
+        // These affect the choice between BackendD2D and BackendD3D. See _recreateBackend().
+        _b.reset();
+    }
     if (fontChanged)
     {
         _recreateFontDependentResources();
@@ -525,6 +823,10 @@ void AtlasEngine::_handleSettingsUpdate()
 
 void AtlasEngine::_recreateFontDependentResources()
 {
+    // The shaping results depend on the font face, size, features, etc.
+    _api.shapingCache.clear();
+    _api.shapingCacheMap.clear();
+
     _api.replacementCharacterFontFace.reset();
     _api.replacementCharacterGlyphIndex = 0;
     _api.replacementCharacterLookedUp = false;
@@ -568,27 +870,37 @@ void AtlasEngine::_recreateFontDependentResources()
             _api.textFormatAxes[i] = { fontAxisValues.data(), fontAxisValues.size() };
         }
     }
+
+    {
+        FontFallback::Settings settings{
+            .systemFontFallback = _p.systemFontFallback,
+            .systemFontFallback1 = _p.systemFontFallback1,
+            .fontCollection = _p.s->font->fontCollection,
+            .fontName = _p.s->font->fontName,
+            .localeName = _api.userLocaleName,
+            .fontWeight = _p.s->font->fontWeight,
+        };
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const auto& axes = _api.textFormatAxes[i];
+            settings.fontAxes[i].assign(axes.begin(), axes.end());
+        }
+        _api.fontFallback = FontFallback::Get(std::move(settings));
+        _api.fontFallbackPending = false;
+    }
 }
 
 void AtlasEngine::_recreateCellCountDependentResources()
 {
     // Let's guess that every cell consists of a surrogate pair.
     const auto projectedTextSize = static_cast<size_t>(_p.s->cellCount.x) * 2;
-    // IDWriteTextAnalyzer::GetGlyphs says:
-    //   The recommended estimate for the per-glyph output buffers is (3 * textLength / 2 + 16).
-    const auto projectedGlyphSize = 3 * projectedTextSize / 2 + 16;
 
     _api.bufferLine = std::vector<wchar_t>{};
     _api.bufferLine.reserve(projectedTextSize);
     _api.bufferLineColumn.reserve(projectedTextSize + 1);
 
-    _api.analysisResults = std::vector<TextAnalysisSinkResult>{};
-    _api.clusterMap = Buffer<u16>{ projectedTextSize };
-    _api.textProps = Buffer<DWRITE_SHAPING_TEXT_PROPERTIES>{ projectedTextSize };
-    _api.glyphIndices = Buffer<u16>{ projectedGlyphSize };
-    _api.glyphProps = Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES>{ projectedGlyphSize };
-    _api.glyphAdvances = Buffer<f32>{ projectedGlyphSize };
-    _api.glyphOffsets = Buffer<DWRITE_GLYPH_OFFSET>{ projectedGlyphSize };
+    // _shapeBufferLines() recreates them with buffers that fit the new cell count.
+    _api.shapingContexts.clear();
 
     _p.unorderedRows = Buffer<ShapedRow>(_p.s->cellCount.y);
     _p.rowsScratch = Buffer<ShapedRow*>(_p.s->cellCount.y);
@@ -613,6 +925,127 @@ void AtlasEngine::_recreateCellCountDependentResources()
     }
 }
 
+void AtlasEngine::_updateCurrentAttributes(const TextAttribute& textAttributes, const RenderSettings& renderSettings)
+{
+    auto [fg, bg] = renderSettings.GetAttributeColorsWithAlpha(textAttributes);
+    fg |= 0xff000000;
+    bg |= _api.backgroundOpaqueMixin;
+
+    auto attributes = FontRelevantAttributes::None;
+    WI_SetFlagIf(attributes, FontRelevantAttributes::Bold, textAttributes.IsIntense() && renderSettings.GetRenderMode(RenderSettings::Mode::IntenseIsBold));
+    WI_SetFlagIf(attributes, FontRelevantAttributes::Italic, textAttributes.IsItalic());
+
+    if (_api.attributes != attributes)
+    {
+        _flushBufferLine();
+    }
+
+    _api.currentBackground = gsl::narrow_cast<u32>(bg);
+    _api.currentForeground = gsl::narrow_cast<u32>(fg);
+    _api.attributes = attributes;
+}
+
+// Fills [beg, end) with the given color and returns whether any of the previous values differed from it.
+// Comparing and filling in a single pass is faster than searching for the first mismatch and then calling std::fill.
+static bool fillColorRun(u32* beg, u32* const end, const u32 color) noexcept
+{
+    auto changed = false;
+
+#if defined(TIL_SSE_INTRINSICS)
+    const auto vec = _mm_set1_epi32(static_cast<int>(color));
+    auto diff = _mm_setzero_si128();
+
+    for (; end - beg >= 4; beg += 4)
+    {
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+        const auto ptr = reinterpret_cast<__m128i*>(beg);
+        diff = _mm_or_si128(diff, _mm_xor_si128(_mm_loadu_si128(ptr), vec));
+        _mm_storeu_si128(ptr, vec);
+    }
+
+    changed = _mm_movemask_epi8(_mm_cmpeq_epi32(diff, _mm_setzero_si128())) != 0xffff;
+#endif
+
+    for (; beg != end; ++beg)
+    {
+        changed |= *beg != color;
+        *beg = color;
+    }
+
+    return changed;
+}
+
+// Copies the ImageSlice of a ROW into the ShapedRow, unless it already holds the same revision of it.
+void AtlasEngine::_updateImageBitmap(ShapedRow& row, const ImageSlice& slice)
+{
+    auto& bitmap = row.bitmap;
+    bitmap.active = true;
+
+    if (bitmap.revision == slice.Revision())
+    {
+        return;
+    }
+
+    const auto pixels = slice.Pixels();
+    bitmap.pixels.resize(pixels.size());
+    memcpy(bitmap.pixels.data(), pixels.data(), pixels.size_bytes());
+    bitmap.revision = slice.Revision();
+    bitmap.cellSize = { gsl::narrow_cast<u16>(slice.CellSize().width), gsl::narrow_cast<u16>(slice.CellSize().height) };
+    // ROWs are at most 65535 columns wide, so the columns always fit into an u16.
+    bitmap.columnBegin = gsl::narrow_cast<u16>(slice.ColumnBegin());
+    bitmap.columnEnd = gsl::narrow_cast<u16>(slice.ColumnEnd());
+}
+
+// Fills the columns [from, to) of the given row in the color bitmap with the current colors.
+void AtlasEngine::_fillColorBitmap(const u16 y, const u16 from, const u16 to) noexcept
+{
+    const auto shift = gsl::narrow_cast<u8>(_api.lineRendition != LineRendition::SingleWidth);
+    const auto row = _p.colorBitmap.begin() + _p.colorBitmapRowStride * y;
+    auto beg = row + (static_cast<size_t>(from) << shift);
+    auto end = row + (static_cast<size_t>(to) << shift);
+
+    const u32 colors[] = {
+        u32ColorPremultiply(_api.currentBackground),
+        _api.currentForeground,
+    };
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        if (fillColorRun(beg, end, colors[i]))
+        {
+            _p.colorBitmapGenerations[i].bump();
+            if (i == 0)
+            {
+                _p.backgroundBitmapDirtyRows.start = std::min(_p.backgroundBitmapDirtyRows.start, y);
+                _p.backgroundBitmapDirtyRows.end = std::max(_p.backgroundBitmapDirtyRows.end, gsl::narrow_cast<u16>(y + 1));
+            }
+        }
+
+        beg += _p.colorBitmapDepthStride;
+        end += _p.colorBitmapDepthStride;
+    }
+}
+
+// Returns the area covered by the overlays that were painted between StartOverlayLayer() and EndOverlayLayer().
+til::rect AtlasEngine::_overlayLayerRectInPx() const noexcept
+{
+    const til::CoordType cellWidth = _p.s->font->cellSize.x;
+    const til::CoordType cellHeight = _p.s->font->cellSize.y;
+    til::rect rect;
+
+    for (const auto& run : _overlayLayer.runs)
+    {
+        rect |= til::rect{ run.columns.front() * cellWidth, run.row * cellHeight, run.columns.back() * cellWidth, (run.row + 1) * cellHeight };
+    }
+    for (const auto& gl : _overlayLayer.gridLines)
+    {
+        rect |= til::rect{ gl.from * cellWidth, gl.row * cellHeight, gl.to * cellWidth, (gl.row + 1) * cellHeight };
+    }
+
+    return rect;
+}
+
+// Queues the current buffer line up for _shapeBufferLines(), which will shape all of them at once in EndPaint().
 void AtlasEngine::_flushBufferLine()
 {
     if (_api.bufferLine.empty())
@@ -620,61 +1053,242 @@ void AtlasEngine::_flushBufferLine()
         return;
     }
 
-    const auto cleanup = wil::scope_exit([this]() noexcept {
-        _api.bufferLine.clear();
-        _api.bufferLineColumn.clear();
-    });
-
     // This would seriously blow us up otherwise.
     Expects(_api.bufferLineColumn.size() == _api.bufferLine.size() + 1);
 
-    auto& row = *_p.rows[_api.lastPaintBufferLineCoord.y];
+    if (_api.shapingJobCount >= _api.shapingJobs.size())
+    {
+        _api.shapingJobs.emplace_back();
+    }
+
+    // Swapping the vectors instead of copying them means that the ones of the previous frame get reused.
+    auto& job = _api.shapingJobs[_api.shapingJobCount++];
+    job.text.swap(_api.bufferLine);
+    job.columns.swap(_api.bufferLineColumn);
+    job.attributes = _api.attributes;
+    job.y = _api.lastPaintBufferLineCoord.y;
+
+    _api.bufferLine.clear();
+    _api.bufferLineColumn.clear();
+}
+
+// Shapes the buffer lines queued up by _flushBufferLine() into their ShapedRow.
+// Each row only depends on its own buffer lines, which is why rows with a lot of text
+// can be split up between multiple threads. The lines of a row are always shaped by
+// the same thread and in the order they were painted, because they get appended to it.
+void AtlasEngine::_shapeBufferLines()
+{
+    const auto jobCount = _api.shapingJobCount;
+    if (jobCount == 0)
+    {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto cleanup = wil::scope_exit([&]() noexcept {
+        _api.shapingJobCount = 0;
+        _api.shapingTime += std::chrono::steady_clock::now() - start;
+    });
+
+    // _mapReplacementCharacter() may be called concurrently and so it mustn't do the lookup itself.
+    if (!_api.replacementCharacterLookedUp)
+    {
+        _lookUpReplacementCharacter();
+    }
+
+    const auto& jobs = _api.shapingJobs;
+    auto& order = _api.shapingJobOrder;
+    auto& groups = _api.shapingRowGroups;
+    size_t textLength = 0;
+
+    order.resize(jobCount);
+    for (u32 i = 0; i < jobCount; ++i)
+    {
+        order[i] = i;
+        textLength += jobs[i].text.size();
+    }
+
+    // The sort needs to be stable to preserve the order of the lines within each row.
+    std::ranges::stable_sort(order, {}, [&](const u32 i) { return jobs[i].y; });
+
+    groups.clear();
+    for (u32 i = 0; i < jobCount; ++i)
+    {
+        if (groups.empty() || jobs[order[i]].y != jobs[order[groups.back().start]].y)
+        {
+            groups.push_back({ i, i + 1 });
+        }
+        else
+        {
+            groups.back().end = i + 1;
+        }
+    }
+
+    auto threads = std::min<size_t>(std::thread::hardware_concurrency(), shapingMaxThreads);
+    threads = std::min(threads, groups.size());
+    if (textLength < shapingParallelMinTextLength || threads < 2)
+    {
+        threads = 1;
+    }
+
+    auto& contexts = _api.shapingContexts;
+    while (contexts.size() < threads)
+    {
+        // Let's guess that every cell consists of a surrogate pair.
+        const auto projectedTextSize = static_cast<size_t>(_p.s->cellCount.x) * 2;
+        // IDWriteTextAnalyzer::GetGlyphs says:
+        //   The recommended estimate for the per-glyph output buffers is (3 * textLength / 2 + 16).
+        const auto projectedGlyphSize = 3 * projectedTextSize / 2 + 16;
+
+        auto& ctx = contexts.emplace_back();
+        if (contexts.size() == 1)
+        {
+            ctx.textAnalyzer = _p.textAnalyzer;
+        }
+        else
+        {
+            wil::com_ptr<IDWriteTextAnalyzer> textAnalyzer;
+            THROW_IF_FAILED(_p.dwriteFactory->CreateTextAnalyzer(textAnalyzer.addressof()));
+            ctx.textAnalyzer = textAnalyzer.query<IDWriteTextAnalyzer1>();
+        }
+        ctx.clusterMap = Buffer<u16>{ projectedTextSize };
+        ctx.textProps = Buffer<DWRITE_SHAPING_TEXT_PROPERTIES>{ projectedTextSize };
+        ctx.glyphIndices = Buffer<u16>{ projectedGlyphSize };
+        ctx.glyphProps = Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES>{ projectedGlyphSize };
+        ctx.glyphAdvances = Buffer<f32>{ projectedGlyphSize };
+        ctx.glyphOffsets = Buffer<DWRITE_GLYPH_OFFSET>{ projectedGlyphSize };
+    }
+
+    if (threads == 1)
+    {
+        auto& ctx = contexts.front();
+        for (u32 i = 0; i < jobCount; ++i)
+        {
+            _shapeBufferLine(ctx, jobs[i]);
+        }
+    }
+    else
+    {
+        // Each thread grabs the next unshaped row once it's done with its previous one,
+        // which balances out rows that take a lot longer than others (e.g. complex scripts).
+        std::atomic<size_t> nextGroup{ 0 };
+        std::vector<std::exception_ptr> exceptions(threads);
+
+        std::for_each(std::execution::par, contexts.begin(), contexts.begin() + threads, [&](ShapingContext& ctx) {
+            try
+            {
+                for (auto g = nextGroup.fetch_add(1, std::memory_order_relaxed); g < groups.size(); g = nextGroup.fetch_add(1, std::memory_order_relaxed))
+                {
+                    const auto& group = groups[g];
+                    for (auto i = group.start; i < group.end; ++i)
+                    {
+                        _shapeBufferLine(ctx, jobs[order[i]]);
+                    }
+                }
+            }
+            catch (...)
+            {
+                exceptions[&ctx - contexts.data()] = std::current_exception();
+            }
+        });
+
+        for (const auto& ex : exceptions)
+        {
+            if (ex)
+            {
+                std::rethrow_exception(ex);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < threads; ++i)
+    {
+        auto& ctx = contexts[i];
+        _api.fontFallbackPending |= ctx.fontFallbackPending;
+        ctx.fontFallbackPending = false;
+    }
+}
+
+void AtlasEngine::_shapeBufferLine(ShapingContext& ctx, const ShapingJob& job)
+{
+    auto& row = *_p.rows[job.y];
+
+    // The foreground colors of the cells covered by the buffer line. They're part of the shaping results (row.colors).
+    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
+    const auto foregroundRow = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * job.y;
+    const std::span<const u32> foreground{
+        foregroundRow + (static_cast<size_t>(job.columns.front()) << shift),
+        foregroundRow + (static_cast<size_t>(job.columns.back()) << shift),
+    };
+
+    const auto hash = _hashBufferLine(job, row, foreground);
+    if (_loadShapedBufferLine(hash, job, foreground, row))
+    {
+        return;
+    }
+
+    const auto mappingsBegin = row.mappings.size();
+    const auto glyphsBegin = row.glyphIndices.size();
 
     wil::com_ptr<IDWriteFontFace2> mappedFontFace;
+    bool fontFallbackPending = false;
+    // The position of the next glyph that the backends draw themselves. See BuiltinGlyphs.h.
+    auto builtinBeg = _findBuiltinGlyph(job, 0);
 
 #pragma warning(suppress : 26494) // Variable 'mappedEnd' is uninitialized. Always initialize an object (type.5).
-    for (u32 idx = 0, mappedEnd; idx < _api.bufferLine.size(); idx = mappedEnd)
+    for (u32 idx = 0, mappedEnd; idx < job.text.size(); idx = mappedEnd)
     {
+        if (idx == builtinBeg)
+        {
+            mappedEnd = _mapBuiltinGlyphs(job, idx, row);
+            builtinBeg = _findBuiltinGlyph(job, mappedEnd);
+            continue;
+        }
+
+        bool pending = false;
+        const auto resolvedLength = _api.fontFallback->Resolve(job.text.data() + idx, builtinBeg - idx, job.attributes, &pending);
+
+        if (pending)
+        {
+            // Looking up the fallback font might take a while, so we draw replacement characters
+            // until it's done instead of blocking the frame. See AtlasEngine::StartPaint().
+            mappedEnd = idx + resolvedLength;
+            _mapReplacementCharacter(job, idx, mappedEnd, row);
+            ctx.fontFallbackPending = true;
+            fontFallbackPending = true;
+            continue;
+        }
+
         u32 mappedLength = 0;
-        _mapCharacters(_api.bufferLine.data() + idx, gsl::narrow_cast<u32>(_api.bufferLine.size()) - idx, &mappedLength, mappedFontFace.put());
+        _mapCharacters(job.text.data() + idx, resolvedLength, job.attributes, &mappedLength, mappedFontFace.put());
         mappedEnd = idx + mappedLength;
 
         if (!mappedFontFace)
         {
-            _mapReplacementCharacter(idx, mappedEnd, row);
+            _mapReplacementCharacter(job, idx, mappedEnd, row);
             continue;
         }
 
         const auto initialIndicesCount = row.glyphIndices.size();
 
-        if (mappedLength > _api.glyphIndices.size())
-        {
-            auto size = _api.glyphIndices.size();
-            size = size + (size >> 1);
-            size = std::max<size_t>(size, mappedLength);
-            Expects(size > _api.glyphIndices.size());
-            _api.glyphIndices = Buffer<u16>{ size };
-            _api.glyphProps = Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES>{ size };
-        }
+        ctx.glyphIndices.grow_for_overwrite(mappedLength);
+        ctx.glyphProps.grow_for_overwrite(mappedLength);
 
         // We can reuse idx here, as it'll be reset to "idx = mappedEnd" in the outer loop anyways.
         for (u32 complexityLength = 0; idx < mappedEnd; idx += complexityLength)
         {
             BOOL isTextSimple = FALSE;
-            THROW_IF_FAILED(_p.textAnalyzer->GetTextComplexity(_api.bufferLine.data() + idx, mappedEnd - idx, mappedFontFace.get(), &isTextSimple, &complexityLength, _api.glyphIndices.data()));
+            THROW_IF_FAILED(ctx.textAnalyzer->GetTextComplexity(job.text.data() + idx, mappedEnd - idx, mappedFontFace.get(), &isTextSimple, &complexityLength, ctx.glyphIndices.data()));
 
             if (isTextSimple)
             {
-                const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-                const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
-
                 for (size_t i = 0; i < complexityLength; ++i)
                 {
-                    const size_t col1 = _api.bufferLineColumn[idx + i + 0];
-                    const size_t col2 = _api.bufferLineColumn[idx + i + 1];
+                    const size_t col1 = job.columns[idx + i + 0];
+                    const size_t col2 = job.columns[idx + i + 1];
                     const auto glyphAdvance = (col2 - col1) * _p.s->font->cellSize.x;
-                    const auto fg = colors[col1 << shift];
-                    row.glyphIndices.emplace_back(_api.glyphIndices[i]);
+                    const auto fg = foregroundRow[col1 << shift];
+                    row.glyphIndices.emplace_back(ctx.glyphIndices[i]);
                     row.glyphAdvances.emplace_back(static_cast<f32>(glyphAdvance));
                     row.glyphOffsets.emplace_back();
                     row.colors.emplace_back(fg);
@@ -682,7 +1296,7 @@ void AtlasEngine::_flushBufferLine()
             }
             else
             {
-                _mapComplex(mappedFontFace.get(), idx, complexityLength, row);
+                _mapComplex(ctx, job, mappedFontFace.get(), idx, complexityLength, row);
             }
         }
 
@@ -701,70 +1315,129 @@ void AtlasEngine::_flushBufferLine()
             }
         }
     }
+
+    // The replacement characters shouldn't stick around once the lookup finished.
+    if (!fontFallbackPending)
+    {
+        _storeShapedBufferLine(hash, job, foreground, row, mappingsBegin, glyphsBegin);
+    }
 }
 
-void AtlasEngine::_mapCharacters(const wchar_t* text, const u32 textLength, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const
+size_t AtlasEngine::_hashBufferLine(const ShapingJob& job, const ShapedRow& row, const std::span<const u32> foreground) const noexcept
 {
-    TextAnalysisSource analysisSource{ _api.userLocaleName.c_str(), text, textLength };
-    const auto& textFormatAxis = _api.textFormatAxes[static_cast<size_t>(_api.attributes)];
+    const u32 flags = static_cast<u32>(job.attributes) | static_cast<u32>(row.lineRendition) << 8;
+    return til::hasher{}
+        .write(&flags, 1)
+        .write(job.text.data(), job.text.size())
+        .write(job.columns.data(), job.columns.size())
+        .write(foreground.data(), foreground.size())
+        .finalize();
+}
 
-    // We don't read from scale anyways.
-#pragma warning(suppress : 26494) // Variable 'scale' is uninitialized. Always initialize an object (type.5).
-    f32 scale;
+// Appends the glyphs of a previous, identical buffer line to the given row, if there's one.
+bool AtlasEngine::_loadShapedBufferLine(const size_t hash, const ShapingJob& job, const std::span<const u32> foreground, ShapedRow& row)
+{
+    const std::scoped_lock lock{ _api.shapingCacheMutex };
 
-    if (textFormatAxis)
+    const auto it = _api.shapingCacheMap.find(hash);
+    if (it == _api.shapingCacheMap.end())
     {
-        THROW_IF_FAILED(_p.systemFontFallback1->MapCharacters(
-            /* analysisSource     */ &analysisSource,
-            /* textPosition       */ 0,
-            /* textLength         */ textLength,
-            /* baseFontCollection */ _p.s->font->fontCollection.get(),
-            /* baseFamilyName     */ _p.s->font->fontName.c_str(),
-            /* fontAxisValues     */ textFormatAxis.data(),
-            /* fontAxisValueCount */ gsl::narrow_cast<u32>(textFormatAxis.size()),
-            /* mappedLength       */ mappedLength,
-            /* scale              */ &scale,
-            /* mappedFontFace     */ reinterpret_cast<IDWriteFontFace5**>(mappedFontFace)));
+        return false;
     }
-    else
+
+    const auto& entry = *it->second;
+    if (entry.attributes != job.attributes ||
+        entry.lineRendition != row.lineRendition ||
+        !std::ranges::equal(entry.text, job.text) ||
+        !std::ranges::equal(entry.columns, job.columns) ||
+        !std::ranges::equal(entry.foreground, foreground))
+    {
+        return false;
+    }
+
+    _api.shapingCache.splice(_api.shapingCache.begin(), _api.shapingCache, it->second);
+
+    const auto offset = gsl::narrow_cast<u32>(row.glyphIndices.size());
+    for (const auto& m : entry.mappings)
     {
-        const auto baseWeight = WI_IsFlagSet(_api.attributes, FontRelevantAttributes::Bold) ? DWRITE_FONT_WEIGHT_BOLD : static_cast<DWRITE_FONT_WEIGHT>(_p.s->font->fontWeight);
-        const auto baseStyle = WI_IsFlagSet(_api.attributes, FontRelevantAttributes::Italic) ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
-        wil::com_ptr<IDWriteFont> font;
+        row.mappings.emplace_back(m.fontFace, m.glyphsFrom + offset, m.glyphsTo + offset);
+    }
+    row.glyphIndices.insert(row.glyphIndices.end(), entry.glyphIndices.begin(), entry.glyphIndices.end());
+    row.glyphAdvances.insert(row.glyphAdvances.end(), entry.glyphAdvances.begin(), entry.glyphAdvances.end());
+    row.glyphOffsets.insert(row.glyphOffsets.end(), entry.glyphOffsets.begin(), entry.glyphOffsets.end());
+    row.colors.insert(row.colors.end(), entry.colors.begin(), entry.colors.end());
+    return true;
+}
+
+// Stores the glyphs that _shapeBufferLine() added to the given row since glyphsBegin in the shaping cache.
+void AtlasEngine::_storeShapedBufferLine(const size_t hash, const ShapingJob& job, const std::span<const u32> foreground, const ShapedRow& row, const size_t mappingsBegin, const size_t glyphsBegin)
+{
+    const std::scoped_lock lock{ _api.shapingCacheMutex };
 
-        THROW_IF_FAILED(_p.systemFontFallback->MapCharacters(
-            /* analysisSource     */ &analysisSource,
-            /* textPosition       */ 0,
-            /* textLength         */ textLength,
-            /* baseFontCollection */ _p.s->font->fontCollection.get(),
-            /* baseFamilyName     */ _p.s->font->fontName.c_str(),
-            /* baseWeight         */ baseWeight,
-            /* baseStyle          */ baseStyle,
-            /* baseStretch        */ DWRITE_FONT_STRETCH_NORMAL,
-            /* mappedLength       */ mappedLength,
-            /* mappedFont         */ font.addressof(),
-            /* scale              */ &scale));
+    auto& cache = _api.shapingCache;
+    auto& map = _api.shapingCacheMap;
+    // A couple screens worth of rows, since there's usually 1 buffer line per row.
+    const auto capacity = std::max<size_t>(64, static_cast<size_t>(_p.s->cellCount.y) * 4);
 
-        if (font)
+    if (const auto it = map.find(hash); it != map.end())
+    {
+        // A hash collision (or the same buffer line with a different lineRendition).
+        cache.splice(cache.begin(), cache, it->second);
+        map.erase(it);
+    }
+    else if (cache.size() >= capacity)
+    {
+        // Recycle the least recently used entry, which allows us to reuse its vectors.
+        map.erase(cache.back().hash);
+        cache.splice(cache.begin(), cache, std::prev(cache.end()));
+    }
+    else
+    {
+        cache.emplace_front();
+    }
+
+    auto& entry = cache.front();
+    entry.hash = hash;
+    entry.attributes = job.attributes;
+    entry.lineRendition = row.lineRendition;
+    entry.text.assign(job.text.begin(), job.text.end());
+    entry.columns.assign(job.columns.begin(), job.columns.end());
+    entry.foreground.assign(foreground.begin(), foreground.end());
+
+    // The first glyphs may have been merged into the FontMapping that preceded this buffer line.
+    const auto glyphsFrom = gsl::narrow_cast<u32>(glyphsBegin);
+    entry.mappings.clear();
+    for (auto i = mappingsBegin > 0 ? mappingsBegin - 1 : 0; i < row.mappings.size(); ++i)
+    {
+        const auto& m = row.mappings[i];
+        if (m.glyphsTo > glyphsFrom)
         {
-            THROW_IF_FAILED(font->CreateFontFace(reinterpret_cast<IDWriteFontFace**>(mappedFontFace)));
+            entry.mappings.emplace_back(m.fontFace, std::max(m.glyphsFrom, glyphsFrom) - glyphsFrom, m.glyphsTo - glyphsFrom);
         }
     }
 
-    // Oh wow! You found a case where scale isn't 1! I tried every font and none
-    // returned something besides 1. I just couldn't figure out why this exists.
-    assert(scale == 1);
+    entry.glyphIndices.assign(row.glyphIndices.begin() + glyphsBegin, row.glyphIndices.end());
+    entry.glyphAdvances.assign(row.glyphAdvances.begin() + glyphsBegin, row.glyphAdvances.end());
+    entry.glyphOffsets.assign(row.glyphOffsets.begin() + glyphsBegin, row.glyphOffsets.end());
+    entry.colors.assign(row.colors.begin() + glyphsBegin, row.colors.end());
+
+    map.emplace(hash, cache.begin());
+}
+
+void AtlasEngine::_mapCharacters(const wchar_t* text, const u32 textLength, const FontRelevantAttributes attributes, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const
+{
+    _api.fontFallback->MapCharacters(text, textLength, attributes, mappedLength, mappedFontFace);
 }
 
-void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row)
+void AtlasEngine::_mapComplex(ShapingContext& ctx, const ShapingJob& job, IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row)
 {
-    _api.analysisResults.clear();
+    ctx.analysisResults.clear();
 
-    TextAnalysisSource analysisSource{ _api.userLocaleName.c_str(), _api.bufferLine.data(), gsl::narrow<UINT32>(_api.bufferLine.size()) };
-    TextAnalysisSink analysisSink{ _api.analysisResults };
-    THROW_IF_FAILED(_p.textAnalyzer->AnalyzeScript(&analysisSource, idx, length, &analysisSink));
+    TextAnalysisSource analysisSource{ _api.userLocaleName.c_str(), job.text.data(), gsl::narrow<UINT32>(job.text.size()) };
+    TextAnalysisSink analysisSink{ ctx.analysisResults };
+    THROW_IF_FAILED(ctx.textAnalyzer->AnalyzeScript(&analysisSource, idx, length, &analysisSink));
 
-    for (const auto& a : _api.analysisResults)
+    for (const auto& a : ctx.analysisResults)
     {
         u32 actualGlyphCount = 0;
 
@@ -790,16 +1463,13 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
             featureRanges = 1;
         }
 
-        if (_api.clusterMap.size() <= a.textLength)
-        {
-            _api.clusterMap = Buffer<u16>{ static_cast<size_t>(a.textLength) + 1 };
-            _api.textProps = Buffer<DWRITE_SHAPING_TEXT_PROPERTIES>{ a.textLength };
-        }
+        ctx.clusterMap.grow_for_overwrite(static_cast<size_t>(a.textLength) + 1);
+        ctx.textProps.grow_for_overwrite(a.textLength);
 
         for (auto retry = 0;;)
         {
-            const auto hr = _p.textAnalyzer->GetGlyphs(
-                /* textString          */ _api.bufferLine.data() + a.textPosition,
+            const auto hr = ctx.textAnalyzer->GetGlyphs(
+                /* textString          */ job.text.data() + a.textPosition,
                 /* textLength          */ a.textLength,
                 /* fontFace            */ mappedFontFace,
                 /* isSideways          */ false,
@@ -810,22 +1480,19 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
                 /* features            */ &features,
                 /* featureRangeLengths */ &featureRangeLengths,
                 /* featureRanges       */ featureRanges,
-                /* maxGlyphCount       */ gsl::narrow_cast<u32>(_api.glyphIndices.size()),
-                /* clusterMap          */ _api.clusterMap.data(),
-                /* textProps           */ _api.textProps.data(),
-                /* glyphIndices        */ _api.glyphIndices.data(),
-                /* glyphProps          */ _api.glyphProps.data(),
+                /* maxGlyphCount       */ gsl::narrow_cast<u32>(ctx.glyphIndices.size()),
+                /* clusterMap          */ ctx.clusterMap.data(),
+                /* textProps           */ ctx.textProps.data(),
+                /* glyphIndices        */ ctx.glyphIndices.data(),
+                /* glyphProps          */ ctx.glyphProps.data(),
                 /* actualGlyphCount    */ &actualGlyphCount);
 
             if (hr == HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) && ++retry < 8)
             {
-                // Grow factor 1.5x.
-                auto size = _api.glyphIndices.size();
-                size = size + (size >> 1);
-                // Overflow check.
-                Expects(size > _api.glyphIndices.size());
-                _api.glyphIndices = Buffer<u16>{ size };
-                _api.glyphProps = Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES>{ size };
+                // Grows the buffers by 1.5x.
+                const auto size = ctx.glyphIndices.size() + 1;
+                ctx.glyphIndices.grow_for_overwrite(size);
+                ctx.glyphProps.grow_for_overwrite(size);
                 continue;
             }
 
@@ -833,24 +1500,16 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
             break;
         }
 
-        if (_api.glyphAdvances.size() < actualGlyphCount)
-        {
-            // Grow the buffer by at least 1.5x and at least of `actualGlyphCount` items.
-            // The 1.5x growth ensures we don't reallocate every time we need 1 more slot.
-            auto size = _api.glyphAdvances.size();
-            size = size + (size >> 1);
-            size = std::max<size_t>(size, actualGlyphCount);
-            _api.glyphAdvances = Buffer<f32>{ size };
-            _api.glyphOffsets = Buffer<DWRITE_GLYPH_OFFSET>{ size };
-        }
+        ctx.glyphAdvances.grow_for_overwrite(actualGlyphCount);
+        ctx.glyphOffsets.grow_for_overwrite(actualGlyphCount);
 
-        THROW_IF_FAILED(_p.textAnalyzer->GetGlyphPlacements(
-            /* textString          */ _api.bufferLine.data() + a.textPosition,
-            /* clusterMap          */ _api.clusterMap.data(),
-            /* textProps           */ _api.textProps.data(),
+        THROW_IF_FAILED(ctx.textAnalyzer->GetGlyphPlacements(
+            /* textString          */ job.text.data() + a.textPosition,
+            /* clusterMap          */ ctx.clusterMap.data(),
+            /* textProps           */ ctx.textProps.data(),
             /* textLength          */ a.textLength,
-            /* glyphIndices        */ _api.glyphIndices.data(),
-            /* glyphProps          */ _api.glyphProps.data(),
+            /* glyphIndices        */ ctx.glyphIndices.data(),
+            /* glyphProps          */ ctx.glyphProps.data(),
             /* glyphCount          */ actualGlyphCount,
             /* fontFace            */ mappedFontFace,
             /* fontEmSize          */ _p.s->font->fontSize,
@@ -861,35 +1520,35 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
             /* features            */ &features,
             /* featureRangeLengths */ &featureRangeLengths,
             /* featureRanges       */ featureRanges,
-            /* glyphAdvances       */ _api.glyphAdvances.data(),
-            /* glyphOffsets        */ _api.glyphOffsets.data()));
+            /* glyphAdvances       */ ctx.glyphAdvances.data(),
+            /* glyphOffsets        */ ctx.glyphOffsets.data()));
 
-        _api.clusterMap[a.textLength] = gsl::narrow_cast<u16>(actualGlyphCount);
+        ctx.clusterMap[a.textLength] = gsl::narrow_cast<u16>(actualGlyphCount);
 
         const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-        const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
-        auto prevCluster = _api.clusterMap[0];
+        const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * job.y;
+        auto prevCluster = ctx.clusterMap[0];
         size_t beg = 0;
 
         for (size_t i = 1; i <= a.textLength; ++i)
         {
-            const auto nextCluster = _api.clusterMap[i];
+            const auto nextCluster = ctx.clusterMap[i];
             if (prevCluster == nextCluster)
             {
                 continue;
             }
 
-            const size_t col1 = _api.bufferLineColumn[a.textPosition + beg];
-            const size_t col2 = _api.bufferLineColumn[a.textPosition + i];
+            const size_t col1 = job.columns[a.textPosition + beg];
+            const size_t col2 = job.columns[a.textPosition + i];
             const auto fg = colors[col1 << shift];
 
             const auto expectedAdvance = (col2 - col1) * _p.s->font->cellSize.x;
             f32 actualAdvance = 0;
             for (auto j = prevCluster; j < nextCluster; ++j)
             {
-                actualAdvance += _api.glyphAdvances[j];
+                actualAdvance += ctx.glyphAdvances[j];
             }
-            _api.glyphAdvances[nextCluster - 1] += expectedAdvance - actualAdvance;
+            ctx.glyphAdvances[nextCluster - 1] += expectedAdvance - actualAdvance;
 
             row.colors.insert(row.colors.end(), nextCluster - prevCluster, fg);
 
@@ -897,36 +1556,101 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
             beg = i;
         }
 
-        row.glyphIndices.insert(row.glyphIndices.end(), _api.glyphIndices.begin(), _api.glyphIndices.begin() + actualGlyphCount);
-        row.glyphAdvances.insert(row.glyphAdvances.end(), _api.glyphAdvances.begin(), _api.glyphAdvances.begin() + actualGlyphCount);
-        row.glyphOffsets.insert(row.glyphOffsets.end(), _api.glyphOffsets.begin(), _api.glyphOffsets.begin() + actualGlyphCount);
+        row.glyphIndices.insert(row.glyphIndices.end(), ctx.glyphIndices.begin(), ctx.glyphIndices.begin() + actualGlyphCount);
+        row.glyphAdvances.insert(row.glyphAdvances.end(), ctx.glyphAdvances.begin(), ctx.glyphAdvances.begin() + actualGlyphCount);
+        row.glyphOffsets.insert(row.glyphOffsets.end(), ctx.glyphOffsets.begin(), ctx.glyphOffsets.begin() + actualGlyphCount);
     }
 }
 
-void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedRow& row)
+void AtlasEngine::_lookUpReplacementCharacter()
 {
-    if (!_api.replacementCharacterLookedUp)
+    bool succeeded = false;
+
+    u32 mappedLength = 0;
+    _mapCharacters(L"\uFFFD", 1, FontRelevantAttributes::None, &mappedLength, _api.replacementCharacterFontFace.put());
+
+    if (mappedLength == 1)
     {
-        bool succeeded = false;
+        static constexpr u32 codepoint = 0xFFFD;
+        succeeded = SUCCEEDED(_api.replacementCharacterFontFace->GetGlyphIndicesW(&codepoint, 1, &_api.replacementCharacterGlyphIndex));
+    }
 
-        u32 mappedLength = 0;
-        _mapCharacters(L"\uFFFD", 1, &mappedLength, _api.replacementCharacterFontFace.put());
+    if (!succeeded)
+    {
+        _api.replacementCharacterFontFace.reset();
+        _api.replacementCharacterGlyphIndex = 0;
+    }
 
-        if (mappedLength == 1)
+    _api.replacementCharacterLookedUp = true;
+}
+
+// Returns the position of the first character at or after `from` that begins a cell and is drawn by
+// the backends without a font (see BuiltinGlyphs.h), or the length of the text if there's none.
+u32 AtlasEngine::_findBuiltinGlyph(const ShapingJob& job, u32 from) noexcept
+{
+    const auto len = gsl::narrow_cast<u32>(job.text.size());
+
+    for (; from < len; ++from)
+    {
+        // Characters that share their column with the preceding one are part of its cluster.
+        if (BuiltinGlyphs::IsBuiltinGlyph(job.text[from]) && (from == 0 || job.columns[from] != job.columns[from - 1]))
         {
-            static constexpr u32 codepoint = 0xFFFD;
-            succeeded = SUCCEEDED(_api.replacementCharacterFontFace->GetGlyphIndicesW(&codepoint, 1, &_api.replacementCharacterGlyphIndex));
+            break;
         }
+    }
+
+    return from;
+}
+
+// Maps the run of builtin glyphs at `from` to a mapping without a font face, with the codepoints
+// as their glyph indices, just like soft font glyphs. Returns the end of the run.
+u32 AtlasEngine::_mapBuiltinGlyphs(const ShapingJob& job, u32 from, ShapedRow& row) const
+{
+    const auto len = gsl::narrow_cast<u32>(job.text.size());
+    const auto initialIndicesCount = row.glyphIndices.size();
+    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
+    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * job.y;
 
-        if (!succeeded)
+    auto pos1 = from;
+    while (pos1 < len && BuiltinGlyphs::IsBuiltinGlyph(job.text[pos1]))
+    {
+        size_t col1 = job.columns[pos1];
+        auto pos2 = pos1 + 1;
+
+        // Any combining marks that follow are dropped, since there's no font to draw them with.
+        while (pos2 < len && job.columns[pos2] == col1)
         {
-            _api.replacementCharacterFontFace.reset();
-            _api.replacementCharacterGlyphIndex = 0;
+            ++pos2;
         }
 
-        _api.replacementCharacterLookedUp = true;
+        const size_t col2 = job.columns[pos2];
+        row.glyphIndices.emplace_back(static_cast<u16>(job.text[pos1]));
+        row.glyphAdvances.emplace_back(static_cast<f32>((col2 - col1) * _p.s->font->cellSize.x));
+        row.glyphOffsets.emplace_back();
+        row.colors.emplace_back(colors[col1 << shift]);
+
+        pos1 = pos2;
+    }
+
+    const auto indicesCount = row.glyphIndices.size();
+    if (indicesCount > initialIndicesCount)
+    {
+        if (!row.mappings.empty() && !row.mappings.back().fontFace && row.mappings.back().glyphsTo == initialIndicesCount)
+        {
+            row.mappings.back().glyphsTo = gsl::narrow_cast<u32>(indicesCount);
+        }
+        else
+        {
+            row.mappings.emplace_back(nullptr, gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(indicesCount));
+        }
     }
 
+    return pos1;
+}
+
+// The replacement character must have been looked up by _lookUpReplacementCharacter() beforehand.
+void AtlasEngine::_mapReplacementCharacter(const ShapingJob& job, u32 from, u32 to, ShapedRow& row) const
+{
     if (!_api.replacementCharacterFontFace)
     {
         return;
@@ -938,24 +1662,24 @@ void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedRow& row)
 
     auto pos1 = from;
     auto pos2 = pos1;
-    size_t col1 = _api.bufferLineColumn[from];
+    size_t col1 = job.columns[from];
     size_t col2 = col1;
     auto initialIndicesCount = row.glyphIndices.size();
-    const auto softFontAvailable = !_p.s->font->softFontPattern.empty();
-    auto currentlyMappingSoftFont = isSoftFontChar(_api.bufferLine[pos1]);
+    const auto softFontAvailable = !_p.s->softFont->softFontPattern.empty();
+    auto currentlyMappingSoftFont = isSoftFontChar(job.text[pos1]);
     const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
+    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * job.y;
 
     while (pos2 < to)
     {
-        col2 = _api.bufferLineColumn[++pos2];
+        col2 = job.columns[++pos2];
         if (col1 == col2)
         {
             continue;
         }
 
         const auto cols = col2 - col1;
-        const auto ch = static_cast<u16>(_api.bufferLine[pos1]);
+        const auto ch = static_cast<u16>(job.text[pos1]);
         const auto nowMappingSoftFont = isSoftFontChar(ch);
 
         row.glyphIndices.emplace_back(nowMappingSoftFont ? ch : _api.replacementCharacterGlyphIndex);
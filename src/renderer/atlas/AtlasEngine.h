@@ -9,9 +9,12 @@
 
 #include "common.h"
 
+class ImageSlice;
+
 namespace Microsoft::Console::Render::Atlas
 {
     struct TextAnalysisSinkResult;
+    struct FontFallback;
 
     class AtlasEngine final : public IRenderEngine
     {
@@ -25,6 +28,8 @@ namespace Microsoft::Console::Render::Atlas
         [[nodiscard]] HRESULT StartPaint() noexcept override;
         [[nodiscard]] HRESULT EndPaint() noexcept override;
         [[nodiscard]] bool RequiresContinuousRedraw() noexcept override;
+        [[nodiscard]] DWORD GetContinuousRedrawDelay() noexcept override;
+        [[nodiscard]] bool IsOccluded() noexcept override;
         void WaitUntilCanRender() noexcept override;
         [[nodiscard]] HRESULT Present() noexcept override;
         [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* pForcePaint) noexcept override;
@@ -32,7 +37,7 @@ namespace Microsoft::Console::Render::Atlas
         [[nodiscard]] HRESULT Invalidate(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateCursor(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateSystem(const til::rect* prcDirtyClient) noexcept override;
-        [[nodiscard]] HRESULT InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept override;
+        [[nodiscard]] HRESULT InvalidateSelection(std::span<const til::rect> rectangles) noexcept override;
         [[nodiscard]] HRESULT InvalidateScroll(const til::point* pcoordDelta) noexcept override;
         [[nodiscard]] HRESULT InvalidateAll() noexcept override;
         [[nodiscard]] HRESULT InvalidateFlush(_In_ const bool circled, _Out_ bool* const pForcePaint) noexcept override;
@@ -56,6 +61,18 @@ namespace Microsoft::Console::Render::Atlas
         [[nodiscard]] HRESULT GetFontSize(_Out_ til::size* pFontSize) noexcept override;
         [[nodiscard]] HRESULT IsGlyphWideByFont(std::wstring_view glyph, _Out_ bool* pResult) noexcept override;
         [[nodiscard]] HRESULT UpdateTitle(std::wstring_view newTitle) noexcept override;
+        [[nodiscard]] HRESULT PaintBufferRow(const BufferRowInfo& info) noexcept override;
+        [[nodiscard]] HRESULT PaintSelectionLayer(std::span<const til::rect> rects) noexcept override;
+        [[nodiscard]] HRESULT StartOverlayLayer() noexcept override;
+        [[nodiscard]] HRESULT EndOverlayLayer() noexcept override;
+        [[nodiscard]] HRESULT InvalidateOverlay(const til::rect* psrRegion) noexcept override;
+        [[nodiscard]] HRESULT PaintSearchHighlightLayer(std::span<const SearchHighlightRun> runs, COLORREF color) noexcept override;
+        [[nodiscard]] HRESULT InvalidateSearchHighlights(const til::rect* psrRegion) noexcept override;
+        void SetPerfCounters(PerfCounters* counters) noexcept override;
+        [[nodiscard]] bool GetPerfOverlay() const noexcept override;
+        void SetPerfOverlay(bool enable) noexcept override;
+        void ReleaseResources() noexcept override;
+        [[nodiscard]] u64 GetMemoryUsage() const noexcept override;
 
         // DxRenderer - getter
         HRESULT Enable() noexcept override;
@@ -70,24 +87,50 @@ namespace Microsoft::Console::Render::Atlas
         void EnableTransparentBackground(const bool isTransparent) noexcept override;
         void SetForceFullRepaintRendering(bool enable) noexcept override;
         [[nodiscard]] HRESULT SetHwnd(HWND hwnd) noexcept override;
+        void SetMonitorHwnd(HWND hwnd) noexcept override;
+        void SetPixelShaderFrameRate(int32_t value) noexcept override;
         void SetPixelShaderPath(std::wstring_view value) noexcept override;
+        void SetPreferLowPowerAdapter(bool enable) noexcept override;
         void SetRetroTerminalEffect(bool enable) noexcept override;
         void SetSelectionBackground(COLORREF color, float alpha = 0.5f) noexcept override;
+        void SetSmoothScrollOffset(float rows) noexcept override;
         void SetSoftwareRendering(bool enable) noexcept override;
         void SetWarningCallback(std::function<void(HRESULT)> pfn) noexcept override;
         [[nodiscard]] HRESULT SetWindowSize(til::size pixels) noexcept override;
         [[nodiscard]] HRESULT UpdateFont(const FontInfoDesired& pfiFontInfoDesired, FontInfo& fiFontInfo, const std::unordered_map<std::wstring_view, uint32_t>& features, const std::unordered_map<std::wstring_view, float>& axes) noexcept override;
         void UpdateHyperlinkHoveredId(uint16_t hoveredId) noexcept override;
 
+        // Offscreen rendering, for benchmarks and screenshot tests.
+        // The frames get drawn into a texture instead of a swap chain, which is returned by GetOffscreenTarget()
+        // after the first Present(). It's recreated whenever the window size changes.
+        void SetOffscreen(bool enable) noexcept;
+        void SetForceD2DMode(bool enable) noexcept;
+        [[nodiscard]] wil::com_ptr<ID3D11Texture2D> GetOffscreenTarget() const noexcept;
+
     private:
+        struct ShapingJob;
+        struct ShapingContext;
+
         // AtlasEngine.cpp
         ATLAS_ATTR_COLD void _handleSettingsUpdate();
         void _recreateFontDependentResources();
         void _recreateCellCountDependentResources();
+        void _updateCurrentAttributes(const TextAttribute& textAttributes, const RenderSettings& renderSettings);
+        void _fillColorBitmap(u16 y, u16 from, u16 to) noexcept;
+        void _updateImageBitmap(ShapedRow& row, const ImageSlice& slice);
+        til::rect _overlayLayerRectInPx() const noexcept;
         void _flushBufferLine();
-        void _mapCharacters(const wchar_t* text, u32 textLength, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const;
-        void _mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row);
-        ATLAS_ATTR_COLD void _mapReplacementCharacter(u32 from, u32 to, ShapedRow& row);
+        void _shapeBufferLines();
+        void _shapeBufferLine(ShapingContext& ctx, const ShapingJob& job);
+        size_t _hashBufferLine(const ShapingJob& job, const ShapedRow& row, std::span<const u32> foreground) const noexcept;
+        bool _loadShapedBufferLine(size_t hash, const ShapingJob& job, std::span<const u32> foreground, ShapedRow& row);
+        void _storeShapedBufferLine(size_t hash, const ShapingJob& job, std::span<const u32> foreground, const ShapedRow& row, size_t mappingsBegin, size_t glyphsBegin);
+        void _mapCharacters(const wchar_t* text, u32 textLength, FontRelevantAttributes attributes, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const;
+        void _mapComplex(ShapingContext& ctx, const ShapingJob& job, IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row);
+        ATLAS_ATTR_COLD void _lookUpReplacementCharacter();
+        ATLAS_ATTR_COLD void _mapReplacementCharacter(const ShapingJob& job, u32 from, u32 to, ShapedRow& row) const;
+        static u32 _findBuiltinGlyph(const ShapingJob& job, u32 from) noexcept;
+        u32 _mapBuiltinGlyphs(const ShapingJob& job, u32 from, ShapedRow& row) const;
 
         // AtlasEngine.api.cpp
         void _resolveTransparencySettings() noexcept;
@@ -95,15 +138,21 @@ namespace Microsoft::Console::Render::Atlas
         void _resolveFontMetrics(const wchar_t* faceName, const FontInfoDesired& fontInfoDesired, FontInfo& fontInfo, FontSettings* fontMetrics = nullptr) const;
 
         // AtlasEngine.r.cpp
+        HMONITOR _getTargetMonitor() const noexcept;
         ATLAS_ATTR_COLD void _recreateAdapter();
         ATLAS_ATTR_COLD void _recreateBackend();
         ATLAS_ATTR_COLD void _handleSwapChainUpdate();
         void _createSwapChain();
+        void _createOffscreenTarget();
         void _destroySwapChain();
         void _resizeBuffers();
         void _updateMatrixTransform();
         void _waitUntilCanRender() noexcept;
         void _present();
+        u16 _perfOverlayRowCount() const noexcept;
+        void _updatePerfOverlayText();
+        void _drawPerfOverlay();
+        void _drawOverlayLayer();
 
         static constexpr u16 u16min = 0x0000;
         static constexpr u16 u16max = 0xffff;
@@ -112,9 +161,127 @@ namespace Microsoft::Console::Render::Atlas
         static constexpr u16r invalidatedAreaNone = { u16max, u16max, u16min, u16min };
         static constexpr range<u16> invalidatedRowsNone{ u16max, u16min };
         static constexpr range<u16> invalidatedRowsAll{ u16min, u16max };
+        // Frames in remote sessions are limited to roughly 30 FPS.
+        static constexpr std::chrono::milliseconds remoteSessionFrameInterval{ 33 };
+        // How often we check whether pending font fallback lookups have finished.
+        static constexpr DWORD fontFallbackPollInterval = 16;
+        // Frames with less text than this are shaped on the calling thread, because
+        // waking up the thread pool would take longer than shaping the text itself.
+        static constexpr size_t shapingParallelMinTextLength = 4096;
+        static constexpr size_t shapingMaxThreads = 8;
+
+        // The input of a single _flushBufferLine() call. They're queued up during
+        // the frame and get shaped all at once by _shapeBufferLines() in EndPaint().
+        struct ShapingJob
+        {
+            std::vector<wchar_t> text;
+            std::vector<u16> columns;
+            FontRelevantAttributes attributes = FontRelevantAttributes::None;
+            u16 y = 0;
+        };
+
+        // The scratch buffers used by _shapeBufferLine(). There's one per thread that shapes rows,
+        // each with its own IDWriteTextAnalyzer, because the analyzers aren't safe to share between threads.
+        struct ShapingContext
+        {
+            wil::com_ptr<IDWriteTextAnalyzer1> textAnalyzer;
+            std::vector<TextAnalysisSinkResult> analysisResults;
+            Buffer<u16> clusterMap;
+            Buffer<DWRITE_SHAPING_TEXT_PROPERTIES> textProps;
+            Buffer<u16> glyphIndices;
+            Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES> glyphProps;
+            Buffer<f32> glyphAdvances;
+            Buffer<DWRITE_GLYPH_OFFSET> glyphOffsets;
+            // Merged into ApiState::fontFallbackPending once all rows have been shaped.
+            bool fontFallbackPending = false;
+        };
+
+        // The result of shaping a single _flushBufferLine() call: The glyphs it added to the ShapedRow
+        // as well as the input it got (bufferLine, bufferLineColumn, the foreground colors, etc.).
+        // FontMapping::glyphsFrom/To are relative to the first glyph.
+        struct ShapingCacheEntry
+        {
+            size_t hash = 0;
+            FontRelevantAttributes attributes = FontRelevantAttributes::None;
+            LineRendition lineRendition = LineRendition::SingleWidth;
+            std::vector<wchar_t> text;
+            std::vector<u16> columns;
+            std::vector<u32> foreground;
+
+            std::vector<FontMapping> mappings;
+            std::vector<u16> glyphIndices;
+            std::vector<f32> glyphAdvances;
+            std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets;
+            std::vector<u32> colors;
+        };
 
         std::unique_ptr<IBackend> _b;
         RenderingPayload _p;
+        // Written by Present() and read by GetMemoryUsage() on any thread.
+        std::atomic<u64> _memoryUsage{ 0 };
+        // The window whose monitor the IDXGIAdapter is chosen for, if we don't render into an hwnd.
+        // It's not part of TargetSettings, because changing it (for instance when the content is
+        // moved to another window) must neither recreate the swap chain nor the backend.
+        std::atomic<HWND> _monitorHwnd{ nullptr };
+
+        // The debug overlay enabled via SetPerfOverlay(). It's drawn on top of the backend's output
+        // into the swap chain and only ever accessed by the thread calling StartPaint() and Present().
+        struct PerfOverlay
+        {
+            wil::com_ptr<ID2D1RenderTarget> renderTarget;
+            wil::com_ptr<ID2D1SolidColorBrush> brush;
+            wil::com_ptr<IDWriteTextFormat> textFormat;
+            PerfCounters::Snapshot snapshot;
+            std::chrono::steady_clock::time_point snapshotTime;
+            std::wstring text;
+            bool enabled = false;
+        } _perfOverlay;
+
+        // The overlays painted between StartOverlayLayer() and EndOverlayLayer(), like the IME composition.
+        // Just like the PerfOverlay they're drawn on top of the backend's output, which is why changing them
+        // doesn't invalidate any rows. Only the pixels they cover now and covered before need to be presented again.
+        struct OverlayLayer
+        {
+            // The text of a PaintBufferLine() call. columns contains 1 more item than text, like _api.bufferLineColumn.
+            struct Run
+            {
+                std::wstring text;
+                std::vector<u16> columns;
+                u32 foreground = 0;
+                u32 background = 0;
+                FontRelevantAttributes attributes = FontRelevantAttributes::None;
+                u16 row = 0;
+
+                bool operator==(const Run& rhs) const noexcept = default;
+            };
+
+            struct GridLines
+            {
+                GridLineSet lines;
+                u32 color = 0;
+                u16 row = 0;
+                u16 from = 0;
+                u16 to = 0;
+
+                bool operator==(const GridLines& rhs) const noexcept
+                {
+                    return lines.bits() == rhs.lines.bits() && color == rhs.color && row == rhs.row && from == rhs.from && to == rhs.to;
+                }
+            };
+
+            wil::com_ptr<ID2D1RenderTarget> renderTarget;
+            wil::com_ptr<ID2D1SolidColorBrush> brush;
+            // Indexed by FontRelevantAttributes, just like _api.textFormatAxes.
+            std::array<wil::com_ptr<IDWriteTextFormat>, 4> textFormats;
+            til::generation_t fontGeneration;
+            std::vector<Run> runs;
+            std::vector<GridLines> gridLines;
+            // The contents and the area of the previous frame.
+            std::vector<Run> previousRuns;
+            std::vector<GridLines> previousGridLines;
+            til::rect previousRectInPx;
+            bool painting = false;
+        } _overlayLayer;
 
         struct ApiState
         {
@@ -135,18 +302,40 @@ namespace Microsoft::Console::Render::Atlas
             std::wstring userLocaleName;
 
             std::array<Buffer<DWRITE_FONT_AXIS_VALUE>, 4> textFormatAxes;
-            std::vector<TextAnalysisSinkResult> analysisResults;
-            Buffer<u16> clusterMap;
-            Buffer<DWRITE_SHAPING_TEXT_PROPERTIES> textProps;
-            Buffer<u16> glyphIndices;
-            Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES> glyphProps;
-            Buffer<f32> glyphAdvances;
-            Buffer<DWRITE_GLYPH_OFFSET> glyphOffsets;
+
+            // The buffer lines of the current frame. Only the first shapingJobCount items are in use,
+            // the others are kept around so that their vectors can be reused. See _flushBufferLine().
+            std::vector<ShapingJob> shapingJobs;
+            size_t shapingJobCount = 0;
+            // The shapingJobs indices sorted by row and the ranges of it that belong to the same row.
+            std::vector<u32> shapingJobOrder;
+            std::vector<range<u32>> shapingRowGroups;
+            // Created on demand by _shapeBufferLines(). The first one uses _p.textAnalyzer.
+            std::vector<ShapingContext> shapingContexts;
+            // The search highlights of the row PaintSearchHighlightLayer() is working on. It gets swapped with the row's.
+            std::vector<SearchHighlightRange> searchHighlightsScratch;
+
+            // A LRU cache of shaped buffer lines, most recently used first. Rows are often shaped again
+            // with the exact same contents, for instance when the cursor blinks, when the selection
+            // changes or when scrolling back and forth. This allows us to skip DirectWrite for them.
+            std::list<ShapingCacheEntry> shapingCache;
+            std::unordered_map<size_t, std::list<ShapingCacheEntry>::iterator> shapingCacheMap;
+            // Rows may be shaped concurrently. See _shapeBufferLines().
+            std::mutex shapingCacheMutex;
+
+            std::shared_ptr<FontFallback> fontFallback;
+            // Whether characters have been drawn as U+FFFD because their font fallback lookup is still pending.
+            // StartPaint() redraws the viewport once fontFallback->Generation() changes from fontFallbackGeneration.
+            bool fontFallbackPending = false;
+            u32 fontFallbackGeneration = 0;
 
             wil::com_ptr<IDWriteFontFace2> replacementCharacterFontFace;
             u16 replacementCharacterGlyphIndex = 0;
             bool replacementCharacterLookedUp = false;
 
+            // The time spent in _shapeBufferLines() that hasn't been added to PerfCounters yet.
+            std::chrono::steady_clock::duration shapingTime{};
+
             // PrepareLineTransform()
             LineRendition lineRendition = LineRendition::SingleWidth;
             // UpdateDrawingBrushes()
@@ -157,6 +346,10 @@ namespace Microsoft::Console::Render::Atlas
             u16x2 lastPaintBufferLineCoord{};
             // UpdateHyperlinkHoveredId()
             u16 hyperlinkHoveredId = 0;
+            // SetPerfOverlay()
+            bool perfOverlay = false;
+            // SetSmoothScrollOffset()
+            f32 smoothScrollOffset = 0;
 
             // dirtyRect is a computed value based on invalidatedRows.
             til::rect dirtyRect;
@@ -6,6 +6,7 @@
 
 #include "BackendD2D.h"
 #include "BackendD3D.h"
+#include "../../types/inc/PerformanceRegion.hpp"
 
 // #### NOTE ####
 // If you see any code in here that contains "_api." you might be seeing a race condition.
@@ -32,7 +33,12 @@ using namespace Microsoft::Console::Render::Atlas;
 [[nodiscard]] HRESULT AtlasEngine::Present() noexcept
 try
 {
-    if (!_p.dxgi.adapter || !_p.dxgi.factory->IsCurrent())
+    const Microsoft::Console::Types::PerformanceRegion region{ "AtlasEngine_Present" };
+
+    // Connecting to or disconnecting from a remote session usually changes the adapters and thus
+    // invalidates the factory, but not always (for instance if the session uses the same GPU).
+    // Moving the window to a monitor that's driven by another GPU changes the adapter we prefer.
+    if (!_p.dxgi.adapter || !_p.dxgi.factory->IsCurrent() || _p.dxgi.remoteSession != (GetSystemMetrics(SM_REMOTESESSION) != 0) || _p.dxgi.monitor != _getTargetMonitor())
     {
         _recreateAdapter();
     }
@@ -47,8 +53,32 @@ try
         _handleSwapChainUpdate();
     }
 
-    _b->Render(_p);
+    {
+        const auto start = std::chrono::steady_clock::now();
+        _b->Render(_p);
+        if (_p.perfCounters)
+        {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            PerfCounters::Add(_p.perfCounters->renderMicroseconds, gsl::narrow_cast<u64>(elapsed.count()));
+        }
+    }
+
+    if (!_overlayLayer.runs.empty() || !_overlayLayer.gridLines.empty())
+    {
+        _drawOverlayLayer();
+    }
+
+    if (_perfOverlay.enabled)
+    {
+        _drawPerfOverlay();
+    }
+
     _present();
+
+    // The swap chain has 3 buffers (see _createSwapChain()), while the offscreen target is just one.
+    const auto targetSize = u64{ _p.swapChain.targetSize.x } * _p.swapChain.targetSize.y * 4;
+    const auto targetCount = _p.swapChain.offscreenTarget ? 1 : 3;
+    _memoryUsage.store(targetSize * targetCount + _b->GetMemoryUsage(), std::memory_order_relaxed);
     return S_OK;
 }
 catch (const wil::ResultException& exception)
@@ -77,7 +107,37 @@ CATCH_RETURN()
 
 [[nodiscard]] bool AtlasEngine::RequiresContinuousRedraw() noexcept
 {
-    return ATLAS_DEBUG_CONTINUOUS_REDRAW || (_b && _b->RequiresContinuousRedraw());
+    return ATLAS_DEBUG_CONTINUOUS_REDRAW || (_b && _b->RequiresContinuousRedraw()) || _api.fontFallbackPending;
+}
+
+// Returns true while the swap chain is occluded (e.g. minimized or on a locked session), in which case
+// the Renderer doesn't paint us. DXGI_PRESENT_TEST allows us to check whether that's still the case
+// without actually presenting anything.
+[[nodiscard]] bool AtlasEngine::IsOccluded() noexcept
+{
+    if (!_p.swapChain.occluded || !_p.swapChain.swapChain)
+    {
+        return false;
+    }
+
+    if (_p.swapChain.swapChain->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED)
+    {
+        return true;
+    }
+
+    _p.swapChain.occluded = false;
+    _p.swapChain.revealed = true;
+    return false;
+}
+
+[[nodiscard]] DWORD AtlasEngine::GetContinuousRedrawDelay() noexcept
+{
+    if (_b && _b->RequiresContinuousRedraw())
+    {
+        return _b->GetContinuousRedrawDelay();
+    }
+    // We only keep redrawing to check in StartPaint() whether the font fallback lookups have finished.
+    return _api.fontFallbackPending ? fontFallbackPollInterval : 0;
 }
 
 void AtlasEngine::WaitUntilCanRender() noexcept
@@ -87,10 +147,66 @@ void AtlasEngine::WaitUntilCanRender() noexcept
         Sleep(ATLAS_DEBUG_RENDER_DELAY);
     }
     _waitUntilCanRender();
+
+    // Every frame in a remote session gets sent over the network. Limiting the frame rate
+    // coalesces bursts of output into fewer frames, at the cost of a little latency.
+    if (_p.dxgi.remoteSession && !_p.swapChain.offscreenTarget)
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - _p.swapChain.presentTime;
+        if (elapsed < remoteSessionFrameInterval)
+        {
+            Sleep(gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(remoteSessionFrameInterval - elapsed).count()));
+        }
+    }
+}
+
+// The swap chain and the backend, including its glyph atlas, are recreated by the next Present().
+// The new swap chain is announced through the swapChainChangedCallback as usual.
+void AtlasEngine::ReleaseResources() noexcept
+try
+{
+    _destroySwapChain();
+    _b.reset();
+    _memoryUsage.store(0, std::memory_order_relaxed);
+}
+CATCH_LOG()
+
+[[nodiscard]] u64 AtlasEngine::GetMemoryUsage() const noexcept
+{
+    return _memoryUsage.load(std::memory_order_relaxed);
 }
 
 #pragma endregion
 
+// Returns the monitor that the window we're drawing into is (mostly) on, or nullptr if we don't know it.
+HMONITOR AtlasEngine::_getTargetMonitor() const noexcept
+{
+    const auto hwnd = _p.s->target->hwnd ? _p.s->target->hwnd : _monitorHwnd.load(std::memory_order_relaxed);
+    return hwnd ? MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST) : nullptr;
+}
+
+// Returns the hardware adapter that drives the given monitor, if any.
+static wil::com_ptr<IDXGIAdapter1> findAdapterForMonitor(IDXGIFactory2* factory, HMONITOR monitor)
+{
+    wil::com_ptr<IDXGIAdapter1> adapter;
+
+    for (UINT adapterIndex = 0; SUCCEEDED(factory->EnumAdapters1(adapterIndex, adapter.put())); ++adapterIndex)
+    {
+        wil::com_ptr<IDXGIOutput> output;
+
+        for (UINT outputIndex = 0; SUCCEEDED(adapter->EnumOutputs(outputIndex, output.put())); ++outputIndex)
+        {
+            DXGI_OUTPUT_DESC desc{};
+            if (SUCCEEDED(output->GetDesc(&desc)) && desc.Monitor == monitor)
+            {
+                return adapter;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
 void AtlasEngine::_recreateAdapter()
 {
 #ifndef NDEBUG
@@ -132,32 +248,56 @@ void AtlasEngine::_recreateAdapter()
 
     wil::com_ptr<IDXGIAdapter1> adapter;
     DXGI_ADAPTER_DESC1 desc{};
+    const auto monitor = _getTargetMonitor();
 
+    if (_p.s->target->useSoftwareRendering)
     {
-        const auto useSoftwareRendering = _p.s->target->useSoftwareRendering;
         UINT index = 0;
 
+        // Search until we find the first WARP adapter (usually the last adapter).
         do
         {
             THROW_IF_FAILED(_p.dxgi.factory->EnumAdapters1(index++, adapter.put()));
             THROW_IF_FAILED(adapter->GetDesc1(&desc));
+        } while (WI_IsFlagClear(desc.Flags, DXGI_ADAPTER_FLAG_SOFTWARE));
+    }
+    else
+    {
+        if (_p.s->target->preferLowPowerAdapter)
+        {
+            if (const auto factory6 = _p.dxgi.factory.try_query<IDXGIFactory6>())
+            {
+                LOG_IF_FAILED(factory6->EnumAdapterByGpuPreference(0, DXGI_GPU_PREFERENCE_MINIMUM_POWER, IID_PPV_ARGS(adapter.put())));
+            }
+        }
+        // On hybrid GPU laptops and multi GPU desktops the default adapter (index 0) might not be
+        // the one driving the monitor we're on, in which case every frame has to be copied across
+        // adapters before it can be shown. We avoid that by picking the monitor's adapter instead.
+        else if (monitor)
+        {
+            adapter = findAdapterForMonitor(_p.dxgi.factory.get(), monitor);
+        }
 
-            // If useSoftwareRendering is false we exit during the first iteration. Using the default adapter (index 0)
-            // is the right thing to do under most circumstances, unless you _really_ want to get your hands dirty.
-            // The alternative is to track the window rectangle in respect to all IDXGIOutputs and select the right
-            // IDXGIAdapter, while also considering the "graphics preference" override in the windows settings app, etc.
-            //
-            // If useSoftwareRendering is true we search until we find the first WARP adapter (usually the last adapter).
-        } while (useSoftwareRendering && WI_IsFlagClear(desc.Flags, DXGI_ADAPTER_FLAG_SOFTWARE));
+        if (!adapter)
+        {
+            THROW_IF_FAILED(_p.dxgi.factory->EnumAdapters1(0, adapter.put()));
+        }
+
+        THROW_IF_FAILED(adapter->GetDesc1(&desc));
     }
 
-    if (memcmp(&_p.dxgi.adapterLuid, &desc.AdapterLuid, sizeof(LUID)) != 0)
+    const auto remoteSession = GetSystemMetrics(SM_REMOTESESSION) != 0;
+
+    if (memcmp(&_p.dxgi.adapterLuid, &desc.AdapterLuid, sizeof(LUID)) != 0 || _p.dxgi.remoteSession != remoteSession)
     {
         _p.dxgi.adapter = std::move(adapter);
         _p.dxgi.adapterLuid = desc.AdapterLuid;
         _p.dxgi.adapterFlags = desc.Flags;
+        _p.dxgi.remoteSession = remoteSession;
         _b.reset();
     }
+
+    _p.dxgi.monitor = monitor;
 }
 
 void AtlasEngine::_recreateBackend()
@@ -186,6 +326,19 @@ void AtlasEngine::_recreateBackend()
         d2dMode = true;
     }
 
+    // In remote sessions every frame is sent over the network. BackendD2D only redraws what changed and
+    // doesn't support custom shaders, which avoids the continuous redraws they might otherwise require.
+    // Combined with the frame rate limit in WaitUntilCanRender() this keeps the bandwidth usage low.
+    if (_p.dxgi.remoteSession && !_p.s->target->offscreen)
+    {
+        d2dMode = true;
+    }
+
+    if (_p.s->target->forceD2DMode)
+    {
+        d2dMode = true;
+    }
+
     wil::com_ptr<ID3D11Device> device0;
     wil::com_ptr<ID3D11DeviceContext> deviceContext0;
     D3D_FEATURE_LEVEL featureLevel{};
@@ -309,6 +462,13 @@ void AtlasEngine::_createSwapChain()
 {
     _destroySwapChain();
 
+    if (_p.s->target->offscreen)
+    {
+        _createOffscreenTarget();
+        _p.swapChain.targetGeneration = _p.s->target.generation();
+        return;
+    }
+
     DXGI_SWAP_CHAIN_DESC1 desc{
         .Width = _p.s->targetSize.x,
         .Height = _p.s->targetSize.y,
@@ -374,10 +534,14 @@ void AtlasEngine::_createSwapChain()
 
 void AtlasEngine::_destroySwapChain()
 {
-    if (_p.swapChain.swapChain)
+    if (_p.swapChain.swapChain || _p.swapChain.offscreenTarget)
     {
         // D3D11 defers the destruction of objects and only one swap chain can be associated with a
         // HWND, IWindow, or composition surface at a time. --> Force the destruction of all objects.
+        _perfOverlay.renderTarget.reset();
+        _perfOverlay.brush.reset();
+        _overlayLayer.renderTarget.reset();
+        _overlayLayer.brush.reset();
         _p.swapChain = {};
         if (_b)
         {
@@ -393,16 +557,46 @@ void AtlasEngine::_destroySwapChain()
 
 void AtlasEngine::_resizeBuffers()
 {
+    _perfOverlay.renderTarget.reset();
+    _perfOverlay.brush.reset();
+    _overlayLayer.renderTarget.reset();
+    _overlayLayer.brush.reset();
     _b->ReleaseResources();
     _p.deviceContext->ClearState();
 
+    if (_p.swapChain.offscreenTarget)
+    {
+        _createOffscreenTarget();
+        return;
+    }
+
     THROW_IF_FAILED(_p.swapChain.swapChain->ResizeBuffers(0, _p.s->targetSize.x, _p.s->targetSize.y, DXGI_FORMAT_UNKNOWN, swapChainFlags));
     _p.swapChain.targetSize = _p.s->targetSize;
 }
 
+// Offscreen targets are B8G8R8A8 textures, just like the swap chain's buffers, so that the backends
+// can draw into them unchanged. They're never presented and so they don't wait for the display either.
+void AtlasEngine::_createOffscreenTarget()
+{
+    const D3D11_TEXTURE2D_DESC desc{
+        .Width = _p.s->targetSize.x,
+        .Height = _p.s->targetSize.y,
+        .MipLevels = 1,
+        .ArraySize = 1,
+        .Format = DXGI_FORMAT_B8G8R8A8_UNORM,
+        .SampleDesc = { .Count = 1 },
+        .Usage = D3D11_USAGE_DEFAULT,
+        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
+    };
+
+    _p.swapChain.offscreenTarget.reset();
+    THROW_IF_FAILED(_p.device->CreateTexture2D(&desc, nullptr, _p.swapChain.offscreenTarget.addressof()));
+    _p.swapChain.targetSize = _p.s->targetSize;
+}
+
 void AtlasEngine::_updateMatrixTransform()
 {
-    if (!_p.s->target->hwnd)
+    if (!_p.s->target->hwnd && !_p.swapChain.offscreenTarget)
     {
         // XAML's SwapChainPanel combines the worst of both worlds and always applies a transform
         // to the swap chain to make it match the display scale. This undoes the damage.
@@ -432,6 +626,12 @@ void AtlasEngine::_waitUntilCanRender() noexcept
 
 void AtlasEngine::_present()
 {
+    if (_p.swapChain.offscreenTarget)
+    {
+        _p.swapChain.presentTime = std::chrono::steady_clock::now();
+        return;
+    }
+
     const RECT fullRect{ 0, 0, _p.swapChain.targetSize.x, _p.swapChain.targetSize.y };
 
     DXGI_PRESENT_PARAMETERS params{};
@@ -463,7 +663,8 @@ void AtlasEngine::_present()
             {
                 const auto offsetInPx = _p.scrollOffset * _p.s->font->cellSize.y;
                 const auto width = _p.s->targetSize.x;
-                const auto height = _p.s->cellCount.y * _p.s->font->cellSize.y;
+                // The cell count includes the overscan row in smooth scrolling mode, which may extend past the swap chain.
+                const auto height = std::min<i32>(_p.s->targetSize.y, _p.s->cellCount.y * _p.s->font->cellSize.y);
                 const auto top = std::max(0, offsetInPx);
                 const auto bottom = height + std::min(0, offsetInPx);
 
@@ -476,17 +677,280 @@ void AtlasEngine::_present()
         }
     }
 
+    auto hr = _p.swapChain.swapChain->Present1(1, 0, &params);
     if constexpr (Feature_AtlasEnginePresentFallback::IsEnabled())
     {
-        if (FAILED_LOG(_p.swapChain.swapChain->Present1(1, 0, &params)))
+        if (FAILED_LOG(hr))
+        {
+            hr = _p.swapChain.swapChain->Present(1, 0);
+        }
+    }
+    THROW_IF_FAILED(hr);
+
+    // DXGI_STATUS_OCCLUDED is a success code. Nobody can see our frames until IsOccluded() says otherwise.
+    _p.swapChain.occluded = hr == DXGI_STATUS_OCCLUDED;
+    _p.swapChain.presentTime = std::chrono::steady_clock::now();
+    _p.swapChain.waitForPresentation = true;
+}
+
+// The overlay consists of this many lines of perfOverlayFontSize large text, as laid out by _updatePerfOverlayText().
+static constexpr u16 perfOverlayLines = 9;
+static constexpr f32 perfOverlayFontSize = 12.0f;
+static constexpr f32 perfOverlayLineHeight = 16.0f;
+static constexpr f32 perfOverlayPadding = 6.0f;
+static constexpr f32 perfOverlayWidth = 200.0f;
+static constexpr f32 perfOverlayHeight = perfOverlayLines * perfOverlayLineHeight + 2 * perfOverlayPadding;
+
+// Returns the number of rows from the top of the viewport the overlay overlaps with.
+u16 AtlasEngine::_perfOverlayRowCount() const noexcept
+{
+    const auto heightInPx = perfOverlayHeight * static_cast<f32>(_p.s->font->dpi) / static_cast<f32>(USER_DEFAULT_SCREEN_DPI);
+    const auto cellHeight = std::max<f32>(1.0f, _p.s->font->cellSize.y);
+    return gsl::narrow_cast<u16>(std::min<f32>(ceilf(heightInPx / cellHeight), _p.s->cellCount.y));
+}
+
+// Turns the difference between the current PerfCounters and those of the previous update into rates.
+// This happens at most once per second, because any faster would just make the numbers unreadable.
+void AtlasEngine::_updatePerfOverlayText()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (!_perfOverlay.text.empty() && now - _perfOverlay.snapshotTime < std::chrono::seconds{ 1 })
+    {
+        return;
+    }
+
+    const auto snapshot = _p.perfCounters->Take();
+    const auto& prev = _perfOverlay.snapshot;
+    const auto seconds = std::chrono::duration<f64>(now - _perfOverlay.snapshotTime).count();
+    const auto perSecond = [&](u64 curr, u64 last) { return static_cast<f64>(curr - last) / seconds; };
+    const auto frames = std::max<u64>(1, snapshot.frames - prev.frames);
+    const auto perFrame = [&](u64 curr, u64 last) { return (curr - last) / frames; };
+
+    // The average input latency and the histogram bucket that contains the 90th percentile.
+    const auto latencies = snapshot.inputLatencies - prev.inputLatencies;
+    const auto latencyAverage = (snapshot.inputLatencyMicroseconds - prev.inputLatencyMicroseconds) / std::max<u64>(1, latencies);
+    size_t latencyBucket = 0;
+    for (u64 sum = 0; latencyBucket < PerfCounters::InputLatencyBuckets - 1; ++latencyBucket)
+    {
+        sum += snapshot.inputLatencyHistogram[latencyBucket] - prev.inputLatencyHistogram[latencyBucket];
+        if (sum * 10 >= latencies * 9)
         {
-            THROW_IF_FAILED(_p.swapChain.swapChain->Present(1, 0));
+            break;
         }
     }
+    const auto latencyP90Bound = PerfCounters::InputLatencyBucketLimits[std::min(latencyBucket, PerfCounters::InputLatencyBucketLimits.size() - 1)] / 1000;
+    const auto latencyP90Relation = latencyBucket < PerfCounters::InputLatencyBucketLimits.size() ? L'<' : L'>';
+
+    if (_perfOverlay.text.empty())
+    {
+        // There's no previous snapshot to compare with yet.
+        _perfOverlay.text = L"Measuring...";
+    }
     else
     {
-        THROW_IF_FAILED(_p.swapChain.swapChain->Present1(1, 0, &params));
+        wchar_t buffer[512];
+        swprintf_s(
+            buffer,
+            L"Parsed   %10.2f MB/s\n"
+            L"Rows     %10.0f /s\n"
+            L"Frames   %10.0f /s\n"
+            L"Paint    %10llu \u00b5s\n"
+            L"Render   %10llu \u00b5s\n"
+            L"Shaping  %10llu \u00b5s\n"
+            L"Misses   %10.0f /s\n"
+            L"Latency  %10llu \u00b5s\n"
+            L"P90      %c%9llu ms",
+            perSecond(snapshot.parsedBytes, prev.parsedBytes) / (1024.0 * 1024.0),
+            perSecond(snapshot.rowsWritten, prev.rowsWritten),
+            perSecond(snapshot.frames, prev.frames),
+            perFrame(snapshot.paintMicroseconds, prev.paintMicroseconds),
+            perFrame(snapshot.renderMicroseconds, prev.renderMicroseconds),
+            perFrame(snapshot.shapingMicroseconds, prev.shapingMicroseconds),
+            perSecond(snapshot.atlasMisses, prev.atlasMisses),
+            latencyAverage,
+            latencyP90Relation,
+            latencyP90Bound);
+        _perfOverlay.text = &buffer[0];
     }
 
-    _p.swapChain.waitForPresentation = true;
+    _perfOverlay.snapshot = snapshot;
+    _perfOverlay.snapshotTime = now;
+}
+
+// Draws the overlays recorded between StartOverlayLayer() and EndOverlayLayer() into the swap chain, after the backend
+// is done with it. They're drawn in full on every frame, because the backends overwrite all of the swap chain's contents.
+void AtlasEngine::_drawOverlayLayer()
+{
+    auto& layer = _overlayLayer;
+    const auto& font = *_p.s->font;
+
+    if (!layer.renderTarget)
+    {
+        const auto buffer = _p.GetBackBuffer();
+        const auto surface = buffer.query<IDXGISurface>();
+
+        // The default DPI of 96 makes DIPs identical to pixels, which is what the cell size is measured in.
+        const D2D1_RENDER_TARGET_PROPERTIES props{
+            .type = D2D1_RENDER_TARGET_TYPE_DEFAULT,
+            .pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED },
+        };
+        THROW_IF_FAILED(_p.d2dFactory->CreateDxgiSurfaceRenderTarget(surface.get(), &props, layer.renderTarget.addressof()));
+        layer.renderTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+
+        static constexpr D2D1_COLOR_F color{};
+        THROW_IF_FAILED(layer.renderTarget->CreateSolidColorBrush(&color, nullptr, layer.brush.put()));
+    }
+
+    if (layer.fontGeneration != _p.s->font.generation())
+    {
+        for (auto& textFormat : layer.textFormats)
+        {
+            textFormat.reset();
+        }
+        layer.fontGeneration = _p.s->font.generation();
+    }
+
+    const auto cellWidth = static_cast<f32>(font.cellSize.x);
+    const auto cellHeight = static_cast<f32>(font.cellSize.y);
+    const auto fillRect = [&](f32 left, f32 top, f32 right, f32 bottom, u32 color) {
+        const D2D1_RECT_F rect{ left, top, right, bottom };
+        layer.brush->SetColor(colorFromU32(color));
+        layer.renderTarget->FillRectangle(&rect, layer.brush.get());
+    };
+
+    layer.renderTarget->BeginDraw();
+
+    for (const auto& run : layer.runs)
+    {
+        const auto top = run.row * cellHeight;
+        const auto bottom = top + cellHeight;
+        fillRect(run.columns.front() * cellWidth, top, run.columns.back() * cellWidth, bottom, run.background);
+
+        auto& textFormat = layer.textFormats[static_cast<size_t>(run.attributes)];
+        if (!textFormat)
+        {
+            const auto bold = WI_IsFlagSet(run.attributes, FontRelevantAttributes::Bold);
+            const auto italic = WI_IsFlagSet(run.attributes, FontRelevantAttributes::Italic);
+            const auto weight = bold ? DWRITE_FONT_WEIGHT_BOLD : static_cast<DWRITE_FONT_WEIGHT>(font.fontWeight);
+            const auto style = italic ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
+            THROW_IF_FAILED(_p.dwriteFactory->CreateTextFormat(font.fontName.c_str(), font.fontCollection.get(), weight, style, DWRITE_FONT_STRETCH_NORMAL, font.fontSize, _api.userLocaleName.c_str(), textFormat.addressof()));
+            THROW_IF_FAILED(textFormat->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+            THROW_IF_FAILED(textFormat->SetLineSpacing(DWRITE_LINE_SPACING_METHOD_UNIFORM, cellHeight, static_cast<f32>(font.baseline)));
+        }
+
+        layer.brush->SetColor(colorFromU32(run.foreground));
+
+        // Each cluster is drawn into its own cells, so that wide glyphs and fallback fonts can't push the text off the grid.
+        const auto length = run.text.size();
+        for (size_t beg = 0, end = 0; beg < length; beg = end)
+        {
+            end = beg + 1;
+            while (end < length && run.columns[end] == run.columns[beg])
+            {
+                ++end;
+            }
+
+            const D2D1_RECT_F rect{ run.columns[beg] * cellWidth, top, run.columns[end] * cellWidth, bottom };
+            layer.renderTarget->DrawText(run.text.data() + beg, gsl::narrow_cast<UINT32>(end - beg), textFormat.get(), &rect, layer.brush.get(), D2D1_DRAW_TEXT_OPTIONS_CLIP, DWRITE_MEASURING_MODE_NATURAL);
+        }
+    }
+
+    // This resembles BackendD2D::_drawGridlineRow(), except that the IME composition doesn't use any line renditions.
+    for (const auto& gl : layer.gridLines)
+    {
+        const auto top = gl.row * cellHeight;
+        const auto left = gl.from * cellWidth;
+        const auto right = gl.to * cellWidth;
+
+        const auto verticalLines = [&](FontDecorationPosition pos) {
+            for (auto x = left + pos.position; x < right; x += cellWidth)
+            {
+                fillRect(x, top, x + pos.height, top + cellHeight, gl.color);
+            }
+        };
+        const auto horizontalLine = [&](FontDecorationPosition pos) {
+            fillRect(left, top + pos.position, right, top + pos.position + pos.height, gl.color);
+        };
+
+        if (gl.lines.test(GridLines::Left))
+        {
+            verticalLines(font.gridLeft);
+        }
+        if (gl.lines.test(GridLines::Right))
+        {
+            verticalLines(font.gridRight);
+        }
+        if (gl.lines.test(GridLines::Top))
+        {
+            horizontalLine(font.gridTop);
+        }
+        if (gl.lines.test(GridLines::Bottom))
+        {
+            horizontalLine(font.gridBottom);
+        }
+        if (gl.lines.any(GridLines::Underline, GridLines::HyperlinkUnderline))
+        {
+            horizontalLine(font.underline);
+        }
+        if (gl.lines.test(GridLines::DoubleUnderline))
+        {
+            for (const auto pos : font.doubleUnderline)
+            {
+                horizontalLine(pos);
+            }
+        }
+        if (gl.lines.test(GridLines::Strikethrough))
+        {
+            horizontalLine(font.strikethrough);
+        }
+    }
+
+    THROW_IF_FAILED(layer.renderTarget->EndDraw());
+}
+
+// Draws the PerfCounters into the top right corner of the swap chain, after the backend is done with it.
+void AtlasEngine::_drawPerfOverlay()
+{
+    _updatePerfOverlayText();
+
+    if (!_perfOverlay.renderTarget)
+    {
+        const auto buffer = _p.GetBackBuffer();
+        const auto surface = buffer.query<IDXGISurface>();
+
+        const D2D1_RENDER_TARGET_PROPERTIES props{
+            .type = D2D1_RENDER_TARGET_TYPE_DEFAULT,
+            .pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED },
+        };
+        THROW_IF_FAILED(_p.d2dFactory->CreateDxgiSurfaceRenderTarget(surface.get(), &props, _perfOverlay.renderTarget.addressof()));
+        _perfOverlay.renderTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+
+        static constexpr D2D1_COLOR_F color{};
+        THROW_IF_FAILED(_perfOverlay.renderTarget->CreateSolidColorBrush(&color, nullptr, _perfOverlay.brush.put()));
+    }
+
+    if (!_perfOverlay.textFormat)
+    {
+        THROW_IF_FAILED(_p.dwriteFactory->CreateTextFormat(L"Consolas", nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, perfOverlayFontSize, L"", _perfOverlay.textFormat.addressof()));
+        THROW_IF_FAILED(_perfOverlay.textFormat->SetLineSpacing(DWRITE_LINE_SPACING_METHOD_UNIFORM, perfOverlayLineHeight, perfOverlayLineHeight * 0.8f));
+    }
+
+    const auto dpi = static_cast<f32>(_p.s->font->dpi);
+    const auto scale = dpi / static_cast<f32>(USER_DEFAULT_SCREEN_DPI);
+    const auto targetWidth = static_cast<f32>(_p.s->targetSize.x) / scale;
+    const D2D1_RECT_F rect{ std::max(0.0f, targetWidth - perfOverlayWidth), 0.0f, targetWidth, perfOverlayHeight };
+    const D2D1_RECT_F textRect{ rect.left + perfOverlayPadding, rect.top + perfOverlayPadding, rect.right - perfOverlayPadding, rect.bottom - perfOverlayPadding };
+
+    _perfOverlay.renderTarget->SetDpi(dpi, dpi);
+    _perfOverlay.renderTarget->BeginDraw();
+    _perfOverlay.brush->SetColor(colorFromU32(0xd0000000));
+    _perfOverlay.renderTarget->FillRectangle(&rect, _perfOverlay.brush.get());
+    _perfOverlay.brush->SetColor(colorFromU32(0xffffffff));
+    _perfOverlay.renderTarget->DrawText(_perfOverlay.text.data(), gsl::narrow_cast<UINT32>(_perfOverlay.text.size()), _perfOverlay.textFormat.get(), &textRect, _perfOverlay.brush.get(), D2D1_DRAW_TEXT_OPTIONS_NONE, DWRITE_MEASURING_MODE_NATURAL);
+    THROW_IF_FAILED(_perfOverlay.renderTarget->EndDraw());
+
+    _p.dirtyRectInPx.left = std::min(_p.dirtyRectInPx.left, static_cast<i32>(floorf(rect.left * scale)));
+    _p.dirtyRectInPx.top = std::min(_p.dirtyRectInPx.top, 0);
+    _p.dirtyRectInPx.right = std::max<i32>(_p.dirtyRectInPx.right, _p.s->targetSize.x);
+    _p.dirtyRectInPx.bottom = std::max(_p.dirtyRectInPx.bottom, static_cast<i32>(ceilf(rect.bottom * scale)));
 }
@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "BackendD2D.h"
 
+#include "BuiltinGlyphs.h"
+
 #if ATLAS_DEBUG_SHOW_DIRTY
 #include "colorbrewer.h"
 #endif
@@ -27,10 +29,26 @@ void BackendD2D::ReleaseResources() noexcept
 {
     _renderTarget.reset();
     _renderTarget4.reset();
+    _rowCommandLists = {};
     // Ensure _handleSettingsUpdate() is called so that _renderTarget gets recreated.
     _generation = {};
 }
 
+u64 BackendD2D::GetMemoryUsage() const noexcept
+{
+    // All of our bitmaps use 4 bytes per pixel.
+    const auto bitmapSize = [](ID2D1Bitmap* bitmap) noexcept -> u64 {
+        if (!bitmap)
+        {
+            return 0;
+        }
+        const auto size = bitmap->GetPixelSize();
+        return u64{ size.width } * size.height * 4;
+    };
+
+    return bitmapSize(_backgroundBitmap.get()) + bitmapSize(_cursorBitmap.get());
+}
+
 void BackendD2D::Render(RenderingPayload& p)
 {
     if (_generation != p.s.generation())
@@ -47,6 +65,7 @@ void BackendD2D::Render(RenderingPayload& p)
     _drawCursorPart1(p);
     _drawText(p);
     _drawCursorPart2(p);
+    _drawSearchHighlights(p);
     _drawSelection(p);
 #if ATLAS_DEBUG_SHOW_DIRTY
     _debugShowDirty(p);
@@ -63,6 +82,11 @@ bool BackendD2D::RequiresContinuousRedraw() noexcept
     return false;
 }
 
+DWORD BackendD2D::GetContinuousRedrawDelay() noexcept
+{
+    return 0;
+}
+
 void BackendD2D::_handleSettingsUpdate(const RenderingPayload& p)
 {
     const auto renderTargetChanged = !_renderTarget;
@@ -73,8 +97,7 @@ void BackendD2D::_handleSettingsUpdate(const RenderingPayload& p)
     if (renderTargetChanged)
     {
         {
-            wil::com_ptr<ID3D11Texture2D> buffer;
-            THROW_IF_FAILED(p.swapChain.swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(buffer.addressof())));
+            const auto buffer = p.GetBackBuffer();
             const auto surface = buffer.query<IDXGISurface>();
 
             const D2D1_RENDER_TARGET_PROPERTIES props{
@@ -136,6 +159,20 @@ void BackendD2D::_handleSettingsUpdate(const RenderingPayload& p)
         _backgroundBitmapGeneration = {};
     }
 
+    if (renderTargetChanged || fontChanged || cellCountChanged)
+    {
+        // ClearType requires the text to be drawn directly onto an opaque target. Replaying a command list
+        // goes through the imaging pipeline instead, which would silently degrade the text to grayscale.
+        if (p.s->font->antialiasingMode != AntialiasingMode::ClearType)
+        {
+            _rowCommandLists = Buffer<RowCommandList>{ p.s->cellCount.y };
+        }
+        else
+        {
+            _rowCommandLists = {};
+        }
+    }
+
     if (fontChanged || cursorChanged)
     {
         _cursorBitmap.reset();
@@ -176,111 +213,207 @@ void BackendD2D::_drawText(RenderingPayload& p)
     // then blends it on the screen with the given bitmap brush. While this roughly doubles the performance
     // when drawing lots of colors, the extra latency drops performance by >10x when drawing fewer colors.
     // Since fewer colors are more common, I've chosen to go with regular solid-color brushes.
+    //
+    // This backend is primarily used for remote sessions and software rendering where re-issuing every
+    // DrawGlyphRun() each frame is expensive. If possible, each row is recorded into a command list instead,
+    // which gets replayed for as long as the row isn't invalidated. Since the rows are indexed by their
+    // position in unorderedRows, a row that got scrolled simply replays its command list at an offset.
+    wil::com_ptr<ID2D1Image> target;
+    if (_rowCommandLists)
+    {
+        _renderTarget->GetTarget(target.addressof());
+    }
+
     u16 y = 0;
     for (const auto row : p.rows)
     {
-        auto baselineX = 0.0f;
-        auto baselineY = static_cast<f32>(p.s->font->cellSize.y * y + p.s->font->baseline);
+        const auto invalidated = p.invalidatedRows.contains(y);
+
+        if (_rowCommandLists)
+        {
+            auto& cache = _rowCommandLists[row - p.unorderedRows.data()];
+            const auto top = p.s->font->cellSize.y * y;
+
+            if (invalidated || !cache.recorded)
+            {
+                cache.commandList.reset();
+                cache.top = top;
+                cache.recorded = true;
+
+                // Rows without any text or gridlines are common and don't need a command list at all.
+                if (!row->mappings.empty() || !row->gridLineRanges.empty())
+                {
+                    // Brushes are recorded by value, so reusing _brush and _emojiBrush inside the command list is fine.
+                    THROW_IF_FAILED(_renderTarget->CreateCommandList(cache.commandList.addressof()));
+                    _renderTarget->SetTarget(cache.commandList.get());
+                    _drawTextRow(p, row, y);
+                    _renderTarget->SetTarget(target.get());
+                    THROW_IF_FAILED(cache.commandList->Close());
+                }
+            }
+
+            if (cache.commandList)
+            {
+                const D2D1_POINT_2F offset{ 0, static_cast<f32>(top - cache.top) };
+                _renderTarget->DrawImage(cache.commandList.get(), &offset, nullptr, D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR, D2D1_COMPOSITE_MODE_SOURCE_OVER);
+            }
+        }
+        else
+        {
+            _drawTextRow(p, row, y);
+        }
 
-        if (row->lineRendition != LineRendition::SingleWidth)
+        if (invalidated)
         {
-            baselineY = _drawTextPrepareLineRendition(p, row, baselineY);
+            dirtyTop = std::min(dirtyTop, row->dirtyTop);
+            dirtyBottom = std::max(dirtyBottom, row->dirtyBottom);
         }
 
-        for (const auto& m : row->mappings)
+        ++y;
+    }
+
+    if (dirtyTop < dirtyBottom)
+    {
+        p.dirtyRectInPx.top = std::min(p.dirtyRectInPx.top, dirtyTop);
+        p.dirtyRectInPx.bottom = std::max(p.dirtyRectInPx.bottom, dirtyBottom);
+    }
+}
+
+void BackendD2D::_drawTextRow(const RenderingPayload& p, ShapedRow* row, u16 y)
+{
+    auto baselineX = 0.0f;
+    auto baselineY = static_cast<f32>(p.s->font->cellSize.y * y + p.s->font->baseline);
+
+    if (row->lineRendition != LineRendition::SingleWidth)
+    {
+        baselineY = _drawTextPrepareLineRendition(p, row, baselineY);
+    }
+
+    for (const auto& m : row->mappings)
+    {
+        const auto colorsBegin = row->colors.begin();
+        auto it = colorsBegin + m.glyphsFrom;
+        const auto end = colorsBegin + m.glyphsTo;
+
+        while (it != end)
         {
-            const auto colorsBegin = row->colors.begin();
-            auto it = colorsBegin + m.glyphsFrom;
-            const auto end = colorsBegin + m.glyphsTo;
+            const auto beg = it;
+            const auto off = it - colorsBegin;
+            const auto fg = *it;
 
-            while (it != end)
+            while (++it != end && *it == fg)
             {
-                const auto beg = it;
-                const auto off = it - colorsBegin;
-                const auto fg = *it;
+            }
 
-                while (++it != end && *it == fg)
-                {
-                }
+            const auto count = it - beg;
+            const auto brush = _brushWithColor(fg);
+            const DWRITE_GLYPH_RUN glyphRun{
+                .fontFace = m.fontFace.get(),
+                .fontEmSize = p.s->font->fontSize,
+                .glyphCount = gsl::narrow_cast<UINT32>(count),
+                .glyphIndices = &row->glyphIndices[off],
+                .glyphAdvances = &row->glyphAdvances[off],
+                .glyphOffsets = &row->glyphOffsets[off],
+            };
+            const D2D1_POINT_2F baselineOrigin{
+                baselineX,
+                baselineY,
+            };
 
-                const auto count = it - beg;
-                const auto brush = _brushWithColor(fg);
-                const DWRITE_GLYPH_RUN glyphRun{
-                    .fontFace = m.fontFace.get(),
-                    .fontEmSize = p.s->font->fontSize,
-                    .glyphCount = gsl::narrow_cast<UINT32>(count),
-                    .glyphIndices = &row->glyphIndices[off],
-                    .glyphAdvances = &row->glyphAdvances[off],
-                    .glyphOffsets = &row->glyphOffsets[off],
-                };
-                const D2D1_POINT_2F baselineOrigin{
-                    baselineX,
-                    baselineY,
-                };
+            if (glyphRun.fontFace)
+            {
+                D2D1_RECT_F bounds = GlyphRunEmptyBounds;
 
-                if (glyphRun.fontFace)
+                if (const auto enumerator = TranslateColorGlyphRun(p.dwriteFactory4.get(), baselineOrigin, &glyphRun))
                 {
-                    D2D1_RECT_F bounds = GlyphRunEmptyBounds;
-
-                    if (const auto enumerator = TranslateColorGlyphRun(p.dwriteFactory4.get(), baselineOrigin, &glyphRun))
+                    while (ColorGlyphRunMoveNext(enumerator.get()))
                     {
-                        while (ColorGlyphRunMoveNext(enumerator.get()))
-                        {
-                            const auto colorGlyphRun = ColorGlyphRunGetCurrentRun(enumerator.get());
-                            ColorGlyphRunDraw(_renderTarget4.get(), _emojiBrush.get(), brush, colorGlyphRun);
-                            ColorGlyphRunAccumulateBounds(_renderTarget.get(), colorGlyphRun, bounds);
-                        }
+                        const auto colorGlyphRun = ColorGlyphRunGetCurrentRun(enumerator.get());
+                        ColorGlyphRunDraw(_renderTarget4.get(), _emojiBrush.get(), brush, colorGlyphRun);
+                        ColorGlyphRunAccumulateBounds(_renderTarget.get(), colorGlyphRun, bounds);
                     }
-                    else
+                }
+                else
+                {
+                    _renderTarget->DrawGlyphRun(baselineOrigin, &glyphRun, brush, DWRITE_MEASURING_MODE_NATURAL);
+                    GlyphRunAccumulateBounds(_renderTarget.get(), baselineOrigin, &glyphRun, bounds);
+                }
+
+                if (bounds.top < bounds.bottom)
+                {
+                    // Since we used SetUnitMode(D2D1_UNIT_MODE_PIXELS), bounds.top/bottom is in pixels already and requires no conversion/rounding.
+                    if (row->lineRendition != LineRendition::DoubleHeightTop)
                     {
-                        _renderTarget->DrawGlyphRun(baselineOrigin, &glyphRun, brush, DWRITE_MEASURING_MODE_NATURAL);
-                        GlyphRunAccumulateBounds(_renderTarget.get(), baselineOrigin, &glyphRun, bounds);
+                        row->dirtyBottom = std::max(row->dirtyBottom, static_cast<i32>(lrintf(bounds.bottom)));
                     }
-
-                    if (bounds.top < bounds.bottom)
+                    if (row->lineRendition != LineRendition::DoubleHeightBottom)
                     {
-                        // Since we used SetUnitMode(D2D1_UNIT_MODE_PIXELS), bounds.top/bottom is in pixels already and requires no conversion/rounding.
-                        if (row->lineRendition != LineRendition::DoubleHeightTop)
-                        {
-                            row->dirtyBottom = std::max(row->dirtyBottom, static_cast<i32>(lrintf(bounds.bottom)));
-                        }
-                        if (row->lineRendition != LineRendition::DoubleHeightBottom)
-                        {
-                            row->dirtyTop = std::min(row->dirtyTop, static_cast<i32>(lrintf(bounds.top)));
-                        }
+                        row->dirtyTop = std::min(row->dirtyTop, static_cast<i32>(lrintf(bounds.top)));
                     }
                 }
+            }
+            else
+            {
+                _drawBuiltinGlyphRun(p, glyphRun, fg, baselineX, baselineY);
+            }
 
-                for (UINT32 i = 0; i < glyphRun.glyphCount; ++i)
-                {
-                    baselineX += glyphRun.glyphAdvances[i];
-                }
+            for (UINT32 i = 0; i < glyphRun.glyphCount; ++i)
+            {
+                baselineX += glyphRun.glyphAdvances[i];
             }
         }
+    }
 
-        if (!row->gridLineRanges.empty())
-        {
-            _drawGridlineRow(p, row, y);
-        }
+    if (!row->gridLineRanges.empty())
+    {
+        _drawGridlineRow(p, row, y);
+    }
 
-        if (row->lineRendition != LineRendition::SingleWidth)
-        {
-            _drawTextResetLineRendition(row);
-        }
+    if (row->lineRendition != LineRendition::SingleWidth)
+    {
+        _drawTextResetLineRendition(row);
+    }
+}
+
+// Draws the glyphs of BuiltinGlyphs.h in a run without font face. They never exceed their cells and so
+// they don't affect the dirty area. Soft font glyphs are the only other glyphs without font face,
+// which aren't supported by this backend and are skipped.
+void BackendD2D::_drawBuiltinGlyphRun(const RenderingPayload& p, const DWRITE_GLYPH_RUN& glyphRun, u32 color, f32 baselineX, f32 baselineY)
+{
+    // Any line rendition transform has been applied already by _drawTextPrepareLineRendition().
+    const auto top = baselineY - p.s->font->baseline;
+    const auto height = static_cast<i32>(p.s->font->cellSize.y);
+    auto left = baselineX;
+
+    for (UINT32 i = 0; i < glyphRun.glyphCount; ++i)
+    {
+        const auto glyphIndex = glyphRun.glyphIndices[i];
+        const auto advance = glyphRun.glyphAdvances[i];
 
-        if (p.invalidatedRows.contains(y))
+        if (BuiltinGlyphs::IsBuiltinGlyph(glyphIndex))
         {
-            dirtyTop = std::min(dirtyTop, row->dirtyTop);
-            dirtyBottom = std::max(dirtyBottom, row->dirtyBottom);
-        }
+            BuiltinGlyphs::Rect rects[BuiltinGlyphs::MaxRectCount];
+            const auto count = BuiltinGlyphs::GetRects(glyphIndex, static_cast<i32>(lrintf(advance)), height, p.s->font->thinLineWidth, rects);
 
-        ++y;
-    }
+            for (size_t j = 0; j < count; ++j)
+            {
+                const auto& r = rects[j];
+                const D2D1_RECT_F rect{
+                    left + r.left,
+                    top + r.top,
+                    left + r.right,
+                    top + r.bottom,
+                };
+                auto c = color;
+                if (r.alpha != 255)
+                {
+                    c = (color & 0xffffff) | ((color >> 24) * r.alpha / 255) << 24;
+                }
+                _fillRectangle(rect, c);
+            }
+        }
 
-    if (dirtyTop < dirtyBottom)
-    {
-        p.dirtyRectInPx.top = std::min(p.dirtyRectInPx.top, dirtyTop);
-        p.dirtyRectInPx.bottom = std::max(p.dirtyRectInPx.bottom, dirtyBottom);
+        left += advance;
     }
 }
 
@@ -601,6 +734,52 @@ void BackendD2D::_drawCursor(const RenderingPayload& p, ID2D1RenderTarget* rende
     }
 }
 
+// See BackendD3D::_drawSearchHighlights().
+void BackendD2D::_drawSearchHighlights(const RenderingPayload& p)
+{
+    const auto& font = *p.s->font;
+    const auto cellWidth = static_cast<f32>(font.cellSize.x);
+    const auto cellHeight = static_cast<f32>(font.cellSize.y);
+    u16 y = 0;
+
+    for (const auto& row : p.rows)
+    {
+        const auto top = cellHeight * y;
+        const auto bottom = top + cellHeight;
+
+        for (const auto& r : row->searchHighlights)
+        {
+            const auto left = cellWidth * r.from;
+            const auto right = cellWidth * r.to;
+            const auto horizontalLine = [&](FontDecorationPosition pos) {
+                _fillRectangle({ left, top + pos.position, right, top + pos.position + pos.height }, r.color);
+            };
+            const auto verticalLine = [&](f32 x, FontDecorationPosition pos) {
+                _fillRectangle({ x + pos.position, top, x + pos.position + pos.height, bottom }, r.color);
+            };
+
+            if (r.lines.test(GridLines::Top))
+            {
+                horizontalLine(font.gridTop);
+            }
+            if (r.lines.test(GridLines::Bottom))
+            {
+                horizontalLine(font.gridBottom);
+            }
+            if (r.lines.test(GridLines::Left))
+            {
+                verticalLine(left, font.gridLeft);
+            }
+            if (r.lines.test(GridLines::Right))
+            {
+                verticalLine(right - cellWidth, font.gridRight);
+            }
+        }
+
+        y++;
+    }
+}
+
 void BackendD2D::_drawSelection(const RenderingPayload& p)
 {
     u16 y = 0;
@@ -14,11 +14,24 @@ namespace Microsoft::Console::Render::Atlas
         void ReleaseResources() noexcept override;
         void Render(RenderingPayload& payload) override;
         bool RequiresContinuousRedraw() noexcept override;
+        DWORD GetContinuousRedrawDelay() noexcept override;
+        u64 GetMemoryUsage() const noexcept override;
 
     private:
+        // The recorded text of a ShapedRow, indexed by the row's position in RenderingPayload::unorderedRows.
+        // top is the pixel position the row was recorded at, which differs from its current one after scrolling.
+        struct RowCommandList
+        {
+            wil::com_ptr<ID2D1CommandList> commandList;
+            i32 top = 0;
+            bool recorded = false;
+        };
+
         ATLAS_ATTR_COLD void _handleSettingsUpdate(const RenderingPayload& p);
         void _drawBackground(const RenderingPayload& p) noexcept;
         void _drawText(RenderingPayload& p);
+        void _drawTextRow(const RenderingPayload& p, ShapedRow* row, u16 y);
+        void _drawBuiltinGlyphRun(const RenderingPayload& p, const DWRITE_GLYPH_RUN& glyphRun, u32 color, f32 baselineX, f32 baselineY);
         ATLAS_ATTR_COLD f32 _drawTextPrepareLineRendition(const RenderingPayload& p, const ShapedRow* row, f32 baselineY) const noexcept;
         ATLAS_ATTR_COLD void _drawTextResetLineRendition(const ShapedRow* row) const noexcept;
         ATLAS_ATTR_COLD f32r _getGlyphRunDesignBounds(const DWRITE_GLYPH_RUN& glyphRun, f32 baselineX, f32 baselineY);
@@ -27,6 +40,7 @@ namespace Microsoft::Console::Render::Atlas
         void _drawCursorPart2(const RenderingPayload& p);
         static void _drawCursor(const RenderingPayload& p, ID2D1RenderTarget* renderTarget, D2D1_RECT_F rect, ID2D1Brush* brush) noexcept;
         void _resizeCursorBitmap(const RenderingPayload& p, til::size newSize);
+        void _drawSearchHighlights(const RenderingPayload& p);
         void _drawSelection(const RenderingPayload& p);
         void _debugShowDirty(const RenderingPayload& p);
         void _debugDumpRenderTarget(const RenderingPayload& p);
@@ -49,6 +63,8 @@ namespace Microsoft::Console::Render::Atlas
         u32 _brushColor = 0;
 
         Buffer<DWRITE_GLYPH_METRICS> _glyphMetrics;
+        // Empty if command lists aren't used, for instance because of ClearType.
+        Buffer<RowCommandList> _rowCommandLists;
 
         til::generation_t _generation;
         til::generation_t _fontGeneration;
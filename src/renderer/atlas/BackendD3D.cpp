@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "BackendD3D.h"
 
+#include "BuiltinGlyphs.h"
+
 #include <custom_shader_ps.h>
 #include <custom_shader_vs.h>
 #include <shader_ps.h>
@@ -65,6 +67,19 @@ struct std::hash<BackendD3D::AtlasGlyphEntry>
     }
 };
 
+// The on-disk glyph cache is only a means to speed up the first frame. Any change to how
+// glyphs are rasterized or stored in the atlas should bump the version to invalidate it.
+static constexpr u32 glyphCacheMagic = 0x43475441; // "ATGC"
+static constexpr u32 glyphCacheVersion = 1;
+static constexpr auto glyphCacheDirectory = LR"(%LOCALAPPDATA%\Microsoft\Windows Terminal\GlyphCache)";
+static constexpr u32 glyphCacheMaxFileSize = 16 * 1024 * 1024;
+// The glyph cache only contains the glyphs for printable ASCII as well as U+2500-U+259F
+// (Box Drawing and Block Elements), because those make up the majority of any first frame.
+static constexpr std::pair<u32, u32> glyphCacheCodepointRanges[]{
+    { 0x20, 0x7f },
+    { 0x2500, 0x25a0 },
+};
+
 template<>
 struct std::hash<BackendD3D::AtlasFontFaceEntry>
 {
@@ -72,13 +87,13 @@ struct std::hash<BackendD3D::AtlasFontFaceEntry>
 
     size_t operator()(const BackendD3D::AtlasFontFaceKey& key) const noexcept
     {
-        return til::flat_set_hash_integer(std::bit_cast<uintptr_t>(key.fontFace) | static_cast<u8>(key.lineRendition));
+        return til::flat_set_hash_integer(std::bit_cast<uintptr_t>(key.fontFace));
     }
 
     size_t operator()(const BackendD3D::AtlasFontFaceEntry& slot) const noexcept
     {
         const auto& inner = *slot.inner;
-        return til::flat_set_hash_integer(std::bit_cast<uintptr_t>(inner.fontFace.get()) | static_cast<u8>(inner.lineRendition));
+        return til::flat_set_hash_integer(std::bit_cast<uintptr_t>(inner.fontFace.get()));
     }
 };
 
@@ -90,7 +105,8 @@ BackendD3D::BackendD3D(const RenderingPayload& p)
     {
         static constexpr D3D11_INPUT_ELEMENT_DESC layout[]{
             { "SV_Position", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "shadingType", 0, DXGI_FORMAT_R32_UINT, 1, offsetof(QuadInstance, shadingType), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "shadingType", 0, DXGI_FORMAT_R16_UINT, 1, offsetof(QuadInstance, shadingType), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "renditionShift", 0, DXGI_FORMAT_R8G8_UINT, 1, offsetof(QuadInstance, renditionShift), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
             { "position", 0, DXGI_FORMAT_R16G16_SINT, 1, offsetof(QuadInstance, position), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
             { "size", 0, DXGI_FORMAT_R16G16_UINT, 1, offsetof(QuadInstance, size), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
             { "texcoord", 0, DXGI_FORMAT_R16G16_UINT, 1, offsetof(QuadInstance, texcoord), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
@@ -191,6 +207,16 @@ BackendD3D::BackendD3D(const RenderingPayload& p)
         THROW_IF_FAILED(p.device->CreateBlendState(&desc, _blendState.addressof()));
     }
 
+    {
+        static constexpr D3D11_RASTERIZER_DESC desc{
+            .FillMode = D3D11_FILL_SOLID,
+            .CullMode = D3D11_CULL_BACK,
+            .DepthClipEnable = TRUE,
+            .ScissorEnable = TRUE,
+        };
+        THROW_IF_FAILED(p.device->CreateRasterizerState(&desc, _scissorRasterizerState.addressof()));
+    }
+
 #ifndef NDEBUG
     _sourceDirectory = std::filesystem::path{ __FILE__ }.parent_path();
     _sourceCodeWatcher = wil::make_folder_change_reader_nothrow(_sourceDirectory.c_str(), false, wil::FolderChangeEvents::FileName | wil::FolderChangeEvents::LastWriteTime, [this](wil::FolderChangeEvent, PCWSTR path) {
@@ -208,23 +234,55 @@ void BackendD3D::ReleaseResources() noexcept
 {
     _renderTargetView.reset();
     _customRenderTargetView.reset();
+    _retainedRenderTargetView.reset();
+    _retainedTexture.reset();
     // Ensure _handleSettingsUpdate() is called so that _renderTarget gets recreated.
     _generation = {};
 }
 
+u64 BackendD3D::GetMemoryUsage() const noexcept
+{
+    // All of our textures use 4 bytes per pixel.
+    const auto textureSize = [](ID3D11Texture2D* texture) noexcept -> u64 {
+        if (!texture)
+        {
+            return 0;
+        }
+        D3D11_TEXTURE2D_DESC desc{};
+        texture->GetDesc(&desc);
+        return u64{ desc.Width } * desc.Height * 4;
+    };
+
+    return textureSize(_glyphAtlas.get()) +
+           textureSize(_retainedTexture.get()) +
+           textureSize(_customOffscreenTexture.get()) +
+           textureSize(_backgroundBitmap.get()) +
+           textureSize(_imageTexture.get()) +
+           _instanceBufferCapacity * sizeof(QuadInstance);
+}
+
 void BackendD3D::Render(RenderingPayload& p)
 {
     if (_generation != p.s.generation())
     {
         _handleSettingsUpdate(p);
     }
+    if (_smoothScrollOffset != p.smoothScrollOffset)
+    {
+        _handleSmoothScrollOffsetUpdate(p);
+    }
 
 #ifndef NDEBUG
     _debugUpdateShaders(p);
 #endif
 
+    if (_retainedRenderTargetView || _customRenderTargetView)
+    {
+        _beginRetainedFrame(p);
+    }
+
     // After a Present() the render target becomes unbound.
-    p.deviceContext->OMSetRenderTargets(1, _customRenderTargetView ? _customRenderTargetView.addressof() : _renderTargetView.addressof(), nullptr);
+    p.deviceContext->OMSetRenderTargets(1, _customRenderTargetView ? _customRenderTargetView.addressof() : _retainedRenderTargetView ? _retainedRenderTargetView.addressof() : _renderTargetView.addressof(), nullptr);
 
     // Invalidating the render target helps with spotting invalid quad instances and Present1() bugs.
 #if ATLAS_DEBUG_SHOW_DIRTY || ATLAS_DEBUG_DUMP_RENDER_TARGET
@@ -235,17 +293,39 @@ void BackendD3D::Render(RenderingPayload& p)
 #endif
 
     _drawBackground(p);
+    _drawImages(p);
     _drawCursorBackground(p);
     _drawText(p);
+    _drawSearchHighlights(p);
     _drawSelection(p);
 #if ATLAS_DEBUG_SHOW_DIRTY
     _debugShowDirty(p);
 #endif
     _flushQuads(p);
 
+    // The instance buffer is sized after the largest amount of instances we've recently drawn in a frame.
+    // It decays by 1/16th per frame, so that a single huge frame doesn't keep the buffer large forever.
+    _instanceHighWaterMark = std::max(_instancesThisFrame, _instanceHighWaterMark - (_instanceHighWaterMark >> 4));
+    _instancesThisFrame = 0;
+
     if (_customPixelShader)
     {
-        _executeCustomShader(p);
+        // A shader that doesn't use the time produces the same output for the same input, which allows us
+        // to skip it (and Present()) if nothing changed. Those that use the time run on every frame we get.
+        if (_requiresContinuousRedraw || p.dirtyRectInPx.non_empty())
+        {
+            _executeCustomShader(p);
+        }
+    }
+    else if (_retainedRenderTargetView)
+    {
+        _endRetainedFrame(p);
+    }
+
+    if (std::chrono::steady_clock::now() >= _glyphCacheSaveTime)
+    {
+        _glyphCacheSaveTime = std::chrono::steady_clock::time_point::max();
+        _saveGlyphCache(p);
     }
 
 #if ATLAS_DEBUG_DUMP_RENDER_TARGET
@@ -258,23 +338,35 @@ bool BackendD3D::RequiresContinuousRedraw() noexcept
     return _requiresContinuousRedraw;
 }
 
+// This is called by the Renderer right before the frame it's asking about gets presented.
+// Since a custom shader that uses the time runs on every frame, the next one is due one interval after this one.
+DWORD BackendD3D::GetContinuousRedrawDelay() noexcept
+{
+    return _requiresContinuousRedraw ? _customShaderFrameInterval : 0;
+}
+
 void BackendD3D::_handleSettingsUpdate(const RenderingPayload& p)
 {
     if (!_renderTargetView)
     {
-        wil::com_ptr<ID3D11Texture2D> buffer;
-        THROW_IF_FAILED(p.swapChain.swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(buffer.addressof())));
+        const auto buffer = p.GetBackBuffer();
         THROW_IF_FAILED(p.device->CreateRenderTargetView(buffer.get(), nullptr, _renderTargetView.put()));
     }
 
     const auto fontChanged = _fontGeneration != p.s->font.generation();
+    const auto softFontChanged = _softFontGeneration != p.s->softFont.generation();
     const auto miscChanged = _miscGeneration != p.s->misc.generation();
     const auto cellCountChanged = _cellCount != p.s->cellCount;
+    const auto targetSizeChanged = _targetSize != p.s->targetSize;
 
     if (fontChanged)
     {
         _updateFontDependents(p);
     }
+    else if (softFontChanged)
+    {
+        _invalidateSoftFontGlyphs(p);
+    }
     if (miscChanged)
     {
         _recreateCustomShader(p);
@@ -283,6 +375,12 @@ void BackendD3D::_handleSettingsUpdate(const RenderingPayload& p)
     {
         _recreateBackgroundColorBitmap(p);
     }
+    if (cellCountChanged || fontChanged)
+    {
+        // The image texture is sized after the cell count and size. It's recreated on demand by _drawImages().
+        _imageTexture.reset();
+        _imageTextureView.reset();
+    }
 
     // Similar to _renderTargetView above, we might have to recreate the _customRenderTargetView whenever _swapChainManager
     // resets it. We only do it after calling _recreateCustomShader however, since that sets the _customPixelShader.
@@ -291,14 +389,47 @@ void BackendD3D::_handleSettingsUpdate(const RenderingPayload& p)
         _recreateCustomRenderTargetView(p);
     }
 
+    // The retained texture is redundant with the custom shader's offscreen texture. Since it's
+    // the custom shader's job to fill the entire swap chain, we can't use the former with the latter.
+    // The offscreen texture's contents are retained across frames instead.
+    if (_customPixelShader || ATLAS_DEBUG_SHOW_DIRTY)
+    {
+        _retainedRenderTargetView.reset();
+        _retainedTexture.reset();
+    }
+    else if (!_retainedRenderTargetView || targetSizeChanged)
+    {
+        _recreateRetainedRenderTargetView(p);
+    }
+    // Any settings change may affect the entire frame.
+    _retainedTextureValid = false;
+
     _recreateConstBuffer(p);
     _setupDeviceContextState(p);
 
     _generation = p.s.generation();
     _fontGeneration = p.s->font.generation();
+    _softFontGeneration = p.s->softFont.generation();
+    if (softFontChanged)
+    {
+        _softFontPattern = p.s->softFont->softFontPattern;
+        _softFontCellSize = p.s->softFont->softFontCellSize;
+    }
     _miscGeneration = p.s->misc.generation();
     _targetSize = p.s->targetSize;
     _cellCount = p.s->cellCount;
+    _smoothScrollOffset = p.smoothScrollOffset;
+}
+
+// The smooth scroll offset is applied by the vertex shader, which moves all quads up by it,
+// with the exception of the background quad which covers the entire render target.
+// The pixel shader then compensates by looking up the background colors with the same offset.
+void BackendD3D::_handleSmoothScrollOffsetUpdate(const RenderingPayload& p)
+{
+    _recreateConstBuffer(p);
+    // The pixels in the retained texture are still at their previous offset.
+    _retainedTextureValid = false;
+    _smoothScrollOffset = p.smoothScrollOffset;
 }
 
 void BackendD3D::_updateFontDependents(const RenderingPayload& p)
@@ -306,6 +437,7 @@ void BackendD3D::_updateFontDependents(const RenderingPayload& p)
     const auto& font = *p.s->font;
 
     DWrite_GetRenderParams(p.dwriteFactory.get(), &_gamma, &_cleartypeEnhancedContrast, &_grayscaleEnhancedContrast, _textRenderingParams.put());
+    _loadGlyphCache(p);
     // Clearing the atlas requires BeginDraw(), which is expensive. Defer this until we need Direct2D anyways.
     _fontChangedResetGlyphAtlas = true;
     _textShadingType = font.antialiasingMode == AntialiasingMode::ClearType ? ShadingType::TextClearType : ShadingType::TextGrayscale;
@@ -342,6 +474,41 @@ void BackendD3D::_updateFontDependents(const RenderingPayload& p)
     _softFontBitmap.reset();
 }
 
+// Applications may redefine individual DECDLD glyphs many times per second. Instead of resetting the
+// entire glyph atlas, this only drops the cached soft font glyphs whose bit pattern actually changed.
+// They'll get rasterized again when they're drawn next and their old atlas space is reclaimed by the
+// next page eviction or atlas reset.
+void BackendD3D::_invalidateSoftFontGlyphs(const RenderingPayload& p)
+{
+    const auto& softFont = *p.s->softFont;
+    const auto height = static_cast<size_t>(softFont.softFontCellSize.height);
+    const auto cellSizeChanged = softFont.softFontCellSize != _softFontCellSize;
+
+    const auto glyphChanged = [&](const AtlasGlyphEntry& entry) {
+        const auto beg = (entry.glyphIndex - 0xEF20u) * height;
+        const auto end = beg + height;
+        if (cellSizeChanged || end > _softFontPattern.size() || end > softFont.softFontPattern.size())
+        {
+            return true;
+        }
+        return !std::equal(_softFontPattern.begin() + beg, _softFontPattern.begin() + end, softFont.softFontPattern.begin() + beg);
+    };
+
+    for (auto& slot : _glyphAtlasMap.container())
+    {
+        // Soft font glyphs are the only ones stored without a font face.
+        if (slot.inner && !slot.inner->fontFace)
+        {
+            slot.inner->glyphs.erase_if(glyphChanged);
+        }
+    }
+
+    if (cellSizeChanged)
+    {
+        _softFontBitmap.reset();
+    }
+}
+
 void BackendD3D::_d2dRenderTargetUpdateFontSettings(const RenderingPayload& p) const noexcept
 {
     const auto& font = *p.s->font;
@@ -479,6 +646,11 @@ void BackendD3D::_recreateCustomShader(const RenderingPayload& p)
         }
 
         _customShaderStartTime = std::chrono::steady_clock::now();
+        _customShaderFrameInterval = 0;
+        if (const auto frameRate = p.s->misc->customPixelShaderFrameRate)
+        {
+            _customShaderFrameInterval = 1000 / frameRate;
+        }
     }
 }
 
@@ -502,6 +674,124 @@ void BackendD3D::_recreateCustomRenderTargetView(const RenderingPayload& p)
     THROW_IF_FAILED(p.device->CreateRenderTargetView(_customOffscreenTexture.get(), nullptr, _customRenderTargetView.addressof()));
 }
 
+void BackendD3D::_recreateRetainedRenderTargetView(const RenderingPayload& p)
+{
+    // Avoid memory usage spikes by releasing memory first.
+    _retainedRenderTargetView.reset();
+    _retainedTexture.reset();
+
+    const D3D11_TEXTURE2D_DESC desc{
+        .Width = p.s->targetSize.x,
+        .Height = p.s->targetSize.y,
+        .MipLevels = 1,
+        .ArraySize = 1,
+        .Format = DXGI_FORMAT_B8G8R8A8_UNORM,
+        .SampleDesc = { 1, 0 },
+        .BindFlags = D3D11_BIND_RENDER_TARGET,
+    };
+    THROW_IF_FAILED(p.device->CreateTexture2D(&desc, nullptr, _retainedTexture.addressof()));
+    THROW_IF_FAILED(p.device->CreateRenderTargetView(_retainedTexture.get(), nullptr, _retainedRenderTargetView.addressof()));
+    _retainedTextureValid = false;
+}
+
+// Figures out which part of the retained texture needs to be drawn this frame and restricts drawing to it.
+void BackendD3D::_beginRetainedFrame(RenderingPayload& p)
+{
+    const auto targetWidth = static_cast<til::CoordType>(p.s->targetSize.x);
+    const auto targetHeight = static_cast<til::CoordType>(p.s->targetSize.y);
+
+    if (!_retainedTextureValid)
+    {
+        _drawLeft = 0;
+        _drawTop = 0;
+        _drawRight = targetWidth;
+        _drawBottom = targetHeight;
+        p.dirtyRectInPx = { 0, 0, p.s->targetSize.x, p.s->targetSize.y };
+        _retainedTextureValid = true;
+    }
+    else
+    {
+        if (p.scrollOffset)
+        {
+            _scrollRetainedFrame(p);
+        }
+
+        // Glyphs may be taller than their cells and overlap with the rows above or below the dirty ones.
+        // Drawing an extra row on either side ensures that those overlapping parts get drawn again.
+        const auto cellHeight = static_cast<til::CoordType>(p.s->font->cellSize.y);
+        _drawTop = std::max(0, p.dirtyRectInPx.top - cellHeight);
+        _drawBottom = std::min(targetHeight, p.dirtyRectInPx.bottom + cellHeight);
+
+        // Invalidated rows span the full width. Otherwise the dirty rect only contains the previous and
+        // current cursor (and selection) and the same applies horizontally: Drawing an extra cell on either
+        // side redraws the parts of neighboring glyphs that overlap with it, but nothing else of the rows.
+        // This way cursor movements don't cost us a repaint of the entire row.
+        const auto cellWidth = static_cast<til::CoordType>(p.s->font->cellSize.x);
+        _drawLeft = std::max(0, p.dirtyRectInPx.left - cellWidth);
+        _drawRight = std::min(targetWidth, p.dirtyRectInPx.right + cellWidth);
+
+        // p.dirtyRectInPx is intentionally not extended to the drawn area: Present1() only needs to know
+        // about the pixels that actually changed. Everything else we draw ends up identical to the previous
+        // frame. Since the overlapping parts of glyphs are already accounted for by the ShapedRow's
+        // dirtyTop/dirtyBottom, this keeps the dirty rect of a blinking cursor as small as its cell.
+    }
+
+    // An empty scissor rect is valid and culls everything, which results in an unchanged frame.
+    const D3D11_RECT scissor{ _drawLeft, _drawTop, std::max(_drawLeft, _drawRight), std::max(_drawTop, _drawBottom) };
+    p.deviceContext->RSSetState(_scissorRasterizerState.get());
+    p.deviceContext->RSSetScissorRects(1, &scissor);
+}
+
+// Moves the contents of the retained texture by the scroll offset, just like Present1() will do
+// with the swap chain contents. Afterwards only the newly exposed rows need to be drawn.
+void BackendD3D::_scrollRetainedFrame(const RenderingPayload& p) const
+{
+    const auto width = static_cast<UINT>(p.s->targetSize.x);
+    const auto height = std::min<UINT>(p.s->targetSize.y, static_cast<UINT>(p.s->cellCount.y) * p.s->font->cellSize.y);
+    const auto delta = static_cast<UINT>(std::abs(p.scrollOffset)) * p.s->font->cellSize.y;
+    const auto texture = _retainedTexture ? _retainedTexture.get() : _customOffscreenTexture.get();
+
+    if (delta >= height)
+    {
+        return;
+    }
+
+    // CopySubresourceRegion() doesn't support overlapping source and destination regions within
+    // the same texture. Non-overlapping ones are fine, which is why we copy in strips of delta pixels.
+    // The strips are copied in an order that ensures that we never read from parts we've already overwritten.
+    if (p.scrollOffset < 0)
+    {
+        // The contents move up.
+        for (UINT dstTop = 0; dstTop + delta < height; dstTop += delta)
+        {
+            const auto srcTop = dstTop + delta;
+            const D3D11_BOX box{ 0, srcTop, 0, width, std::min(srcTop + delta, height), 1 };
+            p.deviceContext->CopySubresourceRegion(texture, 0, 0, dstTop, 0, texture, 0, &box);
+        }
+    }
+    else
+    {
+        // The contents move down.
+        for (auto srcBottom = height - delta; srcBottom > 0;)
+        {
+            const auto srcTop = srcBottom > delta ? srcBottom - delta : 0;
+            const D3D11_BOX box{ 0, srcTop, 0, width, srcBottom, 1 };
+            p.deviceContext->CopySubresourceRegion(texture, 0, 0, srcTop + delta, 0, texture, 0, &box);
+            srcBottom = srcTop;
+        }
+    }
+}
+
+// Copies the finished frame into the swap chain.
+void BackendD3D::_endRetainedFrame(const RenderingPayload& p) const
+{
+    p.deviceContext->RSSetState(nullptr);
+
+    wil::com_ptr<ID3D11Resource> buffer;
+    _renderTargetView->GetResource(buffer.addressof());
+    p.deviceContext->CopyResource(buffer.get(), _retainedTexture.get());
+}
+
 void BackendD3D::_recreateBackgroundColorBitmap(const RenderingPayload& p)
 {
     // Avoid memory usage spikes by releasing memory first.
@@ -515,20 +805,42 @@ void BackendD3D::_recreateBackgroundColorBitmap(const RenderingPayload& p)
         .ArraySize = 1,
         .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
         .SampleDesc = { 1, 0 },
-        .Usage = D3D11_USAGE_DYNAMIC,
+        // Not D3D11_USAGE_DYNAMIC, because that only allows us to replace the entire texture,
+        // whereas _uploadBackgroundBitmap() updates just the rows that changed if possible.
+        .Usage = D3D11_USAGE_DEFAULT,
         .BindFlags = D3D11_BIND_SHADER_RESOURCE,
-        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
     };
     THROW_IF_FAILED(p.device->CreateTexture2D(&desc, nullptr, _backgroundBitmap.addressof()));
     THROW_IF_FAILED(p.device->CreateShaderResourceView(_backgroundBitmap.get(), nullptr, _backgroundBitmapView.addressof()));
     _backgroundBitmapGeneration = {};
 }
 
+void BackendD3D::_recreateImageTexture(const RenderingPayload& p)
+{
+    const D3D11_TEXTURE2D_DESC desc{
+        .Width = u32{ p.s->cellCount.x } * p.s->font->cellSize.x,
+        .Height = gsl::narrow_cast<u32>(p.rows.size()) * p.s->font->cellSize.y,
+        .MipLevels = 1,
+        .ArraySize = 1,
+        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .SampleDesc = { 1, 0 },
+        .Usage = D3D11_USAGE_DEFAULT,
+        .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+    };
+    THROW_IF_FAILED(p.device->CreateTexture2D(&desc, nullptr, _imageTexture.addressof()));
+    THROW_IF_FAILED(p.device->CreateShaderResourceView(_imageTexture.get(), nullptr, _imageTextureView.addressof()));
+    _imageTextureRevisions.assign(p.rows.size(), 0);
+
+    // The texture is created in the middle of a frame, after _setupDeviceContextState() bound the others.
+    p.deviceContext->PSSetShaderResources(2, 1, _imageTextureView.addressof());
+}
+
 void BackendD3D::_recreateConstBuffer(const RenderingPayload& p) const
 {
     {
         VSConstBuffer data{};
         data.positionScale = { 2.0f / p.s->targetSize.x, -2.0f / p.s->targetSize.y };
+        data.positionOffset = { 0, static_cast<f32>(-p.smoothScrollOffset) };
         p.deviceContext->UpdateSubresource(_vsConstantBuffer.get(), 0, nullptr, &data, 0, 0);
     }
     {
@@ -539,6 +851,7 @@ void BackendD3D::_recreateConstBuffer(const RenderingPayload& p) const
         DWrite_GetGammaRatios(_gamma, data.gammaRatios);
         data.enhancedContrast = p.s->font->antialiasingMode == AntialiasingMode::ClearType ? _cleartypeEnhancedContrast : _grayscaleEnhancedContrast;
         data.underlineWidth = p.s->font->underline.height;
+        data.backgroundOffset = { 0, static_cast<f32>(p.smoothScrollOffset) };
         p.deviceContext->UpdateSubresource(_psConstantBuffer.get(), 0, nullptr, &data, 0, 0);
     }
 }
@@ -565,14 +878,14 @@ void BackendD3D::_setupDeviceContextState(const RenderingPayload& p)
     p.deviceContext->RSSetViewports(1, &viewport);
 
     // PS: Pixel Shader
-    ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get() };
+    ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get(), _imageTextureView.get() };
     p.deviceContext->PSSetShader(_pixelShader.get(), nullptr, 0);
     p.deviceContext->PSSetConstantBuffers(0, 1, _psConstantBuffer.addressof());
-    p.deviceContext->PSSetShaderResources(0, 2, &resources[0]);
+    p.deviceContext->PSSetShaderResources(0, 3, &resources[0]);
 
     // OM: Output Merger
     p.deviceContext->OMSetBlendState(_blendState.get(), nullptr, 0xffffffff);
-    p.deviceContext->OMSetRenderTargets(1, _customRenderTargetView ? _customRenderTargetView.addressof() : _renderTargetView.addressof(), nullptr);
+    p.deviceContext->OMSetRenderTargets(1, _customRenderTargetView ? _customRenderTargetView.addressof() : _retainedRenderTargetView ? _retainedRenderTargetView.addressof() : _renderTargetView.addressof(), nullptr);
 }
 
 #ifndef NDEBUG
@@ -681,6 +994,80 @@ void BackendD3D::_d2dEndDrawing()
 }
 
 void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p)
+{
+    const auto size = _computeGlyphAtlasSize(p);
+    const auto u = size.x;
+    const auto v = size.y;
+
+    if (size != _glyphAtlasSize)
+    {
+        _resizeGlyphAtlas(p, u, v);
+        _glyphAtlasSize = size;
+    }
+
+    // Each page should be able to hold at least a few rows of glyphs (including double-height ones)
+    // or else evicting a page might not even free up enough space for a single glyph.
+    const auto minPageHeight = static_cast<u32>(p.s->font->cellSize.y) * 4;
+    auto pageCount = static_cast<u16>(_glyphAtlasPages.size());
+    while (pageCount > 1 && v / pageCount < minPageHeight)
+    {
+        pageCount >>= 1;
+    }
+
+    const auto pageHeight = static_cast<u16>(v / pageCount);
+    unsigned long pageShift;
+    _BitScanReverse(&pageShift, pageHeight);
+    _glyphAtlasPageCount = pageCount;
+    _glyphAtlasPageShift = static_cast<u16>(pageShift);
+
+    for (u16 i = 0; i < pageCount; ++i)
+    {
+        auto& page = _glyphAtlasPages[i];
+        if (page.nodes.size() != u)
+        {
+            page.nodes = Buffer<stbrp_node>{ u };
+        }
+        stbrp_init_target(&page.packer, u, pageHeight, page.nodes.data(), gsl::narrow_cast<int>(page.nodes.size()));
+        page.lastUse = 0;
+    }
+
+    // This is a little imperfect, because it only releases the memory of the glyph mappings, not the memory held by
+    // any DirectWrite fonts. On the other side, the amount of fonts on a system is always finite, where "finite"
+    // is pretty low, relatively speaking. Additionally this allows us to cache the boxGlyphs map indefinitely.
+    // It's not great, but it's not terrible.
+    for (auto& slot : _glyphAtlasMap.container())
+    {
+        if (slot.inner)
+        {
+            slot.inner->glyphs.clear();
+        }
+    }
+
+    _d2dBeginDrawing();
+    _d2dRenderTarget->Clear();
+
+    if (_fontChangedResetGlyphAtlas)
+    {
+        // Font faces are independent of the font size, etc., and so they might already be in _glyphAtlasMap.
+        // Those won't be inserted again by _drawText() and so we need to upload their cached glyphs here.
+        if (_glyphCache)
+        {
+            for (auto& slot : _glyphAtlasMap.container())
+            {
+                if (slot.inner)
+                {
+                    _uploadCachedGlyphs(p, *slot.inner);
+                }
+            }
+        }
+
+        _glyphCacheSaveTime = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    }
+
+    _fontChangedResetGlyphAtlas = false;
+}
+
+u16x2 BackendD3D::_computeGlyphAtlasSize(const RenderingPayload& p) const noexcept
 {
     // The index returned by _BitScanReverse is undefined when the input is 0. We can simultaneously guard
     // against that and avoid unreasonably small textures, by clamping the min. texture size to `minArea`.
@@ -692,7 +1079,7 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p)
     const auto targetArea = static_cast<u32>(p.s->targetSize.x) * p.s->targetSize.y;
 
     const auto minAreaByFont = cellArea * 95; // Covers all printable ASCII characters
-    const auto minAreaByGrowth = static_cast<u32>(_rectPacker.width) * _rectPacker.height * 2;
+    const auto minAreaByGrowth = static_cast<u32>(_glyphAtlasSize.x) * _glyphAtlasSize.y * 2;
     const auto min = std::max(minArea, std::max(minAreaByFont, minAreaByGrowth));
 
     // It's hard to say what the max. size of the cache should be. Optimally I think we should use as much
@@ -710,32 +1097,64 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p)
     // every time you resize the window by a pixel. Instead it only grows/shrinks by a factor of 2.
     unsigned long index;
     _BitScanReverse(&index, area - 1);
-    const auto u = static_cast<u16>(1u << ((index + 2) / 2));
-    const auto v = static_cast<u16>(1u << ((index + 1) / 2));
+    return {
+        static_cast<u16>(1u << ((index + 2) / 2)),
+        static_cast<u16>(1u << ((index + 1) / 2)),
+    };
+}
 
-    if (u != _rectPacker.width || v != _rectPacker.height)
+// Once the glyph atlas reached its max. size, resetting it in its entirety whenever it's full causes visible
+// frame spikes, because all glyphs need to be rasterized again. This instead only evicts the least recently used
+// page and the glyphs on it. Returns false if the atlas should be reset instead, because it can still grow.
+bool BackendD3D::_evictGlyphAtlasPage(const RenderingPayload& p, const AtlasGlyphEntry& pendingGlyphEntry)
+{
+    if (_glyphAtlasPageCount <= 1 || _computeGlyphAtlasSize(p) != _glyphAtlasSize)
     {
-        _resizeGlyphAtlas(p, u, v);
+        return false;
     }
 
-    stbrp_init_target(&_rectPacker, u, v, _rectPackerData.data(), _rectPackerData.size());
+    u16 lru = 0;
+    for (u16 i = 1; i < _glyphAtlasPageCount; ++i)
+    {
+        if (_glyphAtlasPages[i].lastUse < _glyphAtlasPages[lru].lastUse)
+        {
+            lru = i;
+        }
+    }
 
-    // This is a little imperfect, because it only releases the memory of the glyph mappings, not the memory held by
-    // any DirectWrite fonts. On the other side, the amount of fonts on a system is always finite, where "finite"
-    // is pretty low, relatively speaking. Additionally this allows us to cache the boxGlyphs map indefinitely.
-    // It's not great, but it's not terrible.
+    // If even the least recently used page is empty, the glyph won't fit on any page.
+    auto& page = _glyphAtlasPages[lru];
+    if (page.lastUse == 0)
+    {
+        return false;
+    }
+
+    const auto pageHeight = static_cast<u16>(1u << _glyphAtlasPageShift);
+    const auto pageTop = static_cast<u16>(lru << _glyphAtlasPageShift);
+    const auto pageBottom = static_cast<u32>(pageTop) + pageHeight;
+
+    stbrp_init_target(&page.packer, _glyphAtlasSize.x, pageHeight, page.nodes.data(), gsl::narrow_cast<int>(page.nodes.size()));
+    page.lastUse = 0;
+
+    // The entry that failed to be drawn has no valid data yet. It needs to be removed
+    // as well, so that the _drawText() retry inserts and draws it again.
     for (auto& slot : _glyphAtlasMap.container())
     {
         if (slot.inner)
         {
-            slot.inner->glyphs.clear();
+            slot.inner->glyphs.erase_if([&](const AtlasGlyphEntry& g) {
+                return &g == &pendingGlyphEntry ||
+                       (g.data.GetShadingType() != ShadingType::Default && g.data.texcoord.y >= pageTop && g.data.texcoord.y < pageBottom);
+            });
         }
     }
 
+    const D2D1_RECT_F clipRect{ 0, static_cast<f32>(pageTop), static_cast<f32>(_glyphAtlasSize.x), static_cast<f32>(pageBottom) };
     _d2dBeginDrawing();
+    _d2dRenderTarget->PushAxisAlignedClip(&clipRect, D2D1_ANTIALIAS_MODE_ALIASED);
     _d2dRenderTarget->Clear();
-
-    _fontChangedResetGlyphAtlas = false;
+    _d2dRenderTarget->PopAxisAlignedClip();
+    return true;
 }
 
 void BackendD3D::_resizeGlyphAtlas(const RenderingPayload& p, const u16 u, const u16 v)
@@ -800,10 +1219,8 @@ void BackendD3D::_resizeGlyphAtlas(const RenderingPayload& p, const u16 u, const
         THROW_IF_FAILED(_d2dRenderTarget->CreateSolidColorBrush(&color, nullptr, _brush.put()));
     }
 
-    ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get() };
-    p.deviceContext->PSSetShaderResources(0, 2, &resources[0]);
-
-    _rectPackerData = Buffer<stbrp_node>{ u };
+    ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get(), _imageTextureView.get() };
+    p.deviceContext->PSSetShaderResources(0, 3, &resources[0]);
 }
 
 BackendD3D::QuadInstance& BackendD3D::_getLastQuad() noexcept
@@ -851,16 +1268,31 @@ void BackendD3D::_flushQuads(const RenderingPayload& p)
         _drawCursorForeground();
     }
 
-    // TODO: Shrink instances buffer
-    if (_instancesCount > _instanceBufferCapacity)
+    _instancesThisFrame += _instancesCount;
+
+    // The instance buffer is used as a ring buffer: Each flush appends its instances after the previous ones
+    // with D3D11_MAP_WRITE_NO_OVERWRITE, which promises the driver that we won't touch anything the GPU might
+    // still be reading. Only once we reach the end, D3D11_MAP_WRITE_DISCARD gives us a fresh buffer to start over.
+    // This avoids the driver having to rename the buffer on every flush, of which there can be several per frame.
+    auto mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+
+    if (_instanceBufferOffset + _instancesCount > _instanceBufferCapacity)
     {
-        _recreateInstanceBuffers(p);
+        // We're about to discard the buffer anyway, which makes this the right time to resize it.
+        const auto shrink = _instanceBufferCapacity > 4 * std::max(_instanceHighWaterMark, _instanceBufferMinCapacity(p));
+        if (_instancesCount > _instanceBufferCapacity || shrink)
+        {
+            _recreateInstanceBuffers(p);
+        }
+
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        _instanceBufferOffset = 0;
     }
 
     {
         D3D11_MAPPED_SUBRESOURCE mapped{};
-        THROW_IF_FAILED(p.deviceContext->Map(_instanceBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
-        memcpy(mapped.pData, _instances.data(), _instancesCount * sizeof(QuadInstance));
+        THROW_IF_FAILED(p.deviceContext->Map(_instanceBuffer.get(), 0, mapType, 0, &mapped));
+        memcpy(static_cast<QuadInstance*>(mapped.pData) + _instanceBufferOffset, _instances.data(), _instancesCount * sizeof(QuadInstance));
         p.deviceContext->Unmap(_instanceBuffer.get(), 0);
     }
 
@@ -883,15 +1315,20 @@ void BackendD3D::_flushQuads(const RenderingPayload& p)
     //   Instead I found that packing instance data as tightly as possible made the biggest performance difference,
     //   and packing 16 bit integers with ID3D11InputLayout is quite a bit more convenient too.
 
-    p.deviceContext->DrawIndexedInstanced(6, static_cast<UINT>(_instancesCount), 0, 0, 0);
+    p.deviceContext->DrawIndexedInstanced(6, static_cast<UINT>(_instancesCount), 0, 0, static_cast<UINT>(_instanceBufferOffset));
+    _instanceBufferOffset += _instancesCount;
     _instancesCount = 0;
 }
 
-void BackendD3D::_recreateInstanceBuffers(const RenderingPayload& p)
+size_t BackendD3D::_instanceBufferMinCapacity(const RenderingPayload& p) noexcept
 {
     // We use the viewport size of the terminal as the initial estimate for the amount of instances we'll see.
-    const auto minCapacity = static_cast<size_t>(p.s->cellCount.x) * p.s->cellCount.y;
-    auto newCapacity = std::max(_instancesCount, minCapacity);
+    return static_cast<size_t>(p.s->cellCount.x) * p.s->cellCount.y;
+}
+
+void BackendD3D::_recreateInstanceBuffers(const RenderingPayload& p)
+{
+    auto newCapacity = std::max({ _instancesCount, _instanceHighWaterMark, _instanceBufferMinCapacity(p) });
     auto newSize = newCapacity * sizeof(QuadInstance);
     // Round up to multiples of 64kB to avoid reallocating too often.
     // 64kB is the minimum alignment for committed resources in D3D12.
@@ -934,29 +1371,113 @@ void BackendD3D::_drawBackground(const RenderingPayload& p)
     };
 }
 
-void BackendD3D::_uploadBackgroundBitmap(const RenderingPayload& p)
+// Images are drawn on top of the background and below everything else. Each row of the _imageTexture
+// holds the image slice of the ShapedRow at the same position, so that the quads can use 1:1 texcoords.
+void BackendD3D::_drawImages(const RenderingPayload& p)
+{
+    const auto cellWidth = p.s->font->cellSize.x;
+    const auto cellHeight = p.s->font->cellSize.y;
+
+    u16 y = 0;
+    for (const auto row : p.rows)
+    {
+        const auto& bitmap = row->bitmap;
+        const auto rowTop = static_cast<til::CoordType>(y * cellHeight) - p.smoothScrollOffset;
+        const auto rowBottom = rowTop + cellHeight;
+
+        if (bitmap.active && bitmap.columnBegin < p.s->cellCount.x && rowBottom > _drawTop && rowTop < _drawBottom)
+        {
+            if (!_imageTexture)
+            {
+                _recreateImageTexture(p);
+            }
+            // The revision stays the same while a row scrolls, but then it'll be at a different y.
+            if (_imageTextureRevisions[y] != bitmap.revision)
+            {
+                _uploadImageRow(p, bitmap, y);
+                _imageTextureRevisions[y] = bitmap.revision;
+            }
+
+            const auto columnEnd = std::min(bitmap.columnEnd, p.s->cellCount.x);
+            const auto left = static_cast<u16>(bitmap.columnBegin * cellWidth);
+            const auto top = static_cast<u16>(y * cellHeight);
+            _appendQuad() = {
+                .shadingType = ShadingType::Image,
+                .position = { static_cast<i16>(left), static_cast<i16>(top) },
+                .size = { static_cast<u16>((columnEnd - bitmap.columnBegin) * cellWidth), cellHeight },
+                .texcoord = { left, top },
+            };
+        }
+
+        ++y;
+    }
+}
+
+// Scales the image slice of a row to the current cell size (nearest neighbor) and uploads it into the _imageTexture.
+void BackendD3D::_uploadImageRow(const RenderingPayload& p, const ImageBitmap& bitmap, const u16 y)
 {
-    D3D11_MAPPED_SUBRESOURCE mapped{};
-    THROW_IF_FAILED(p.deviceContext->Map(_backgroundBitmap.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    const u32 cellWidth = p.s->font->cellSize.x;
+    const u32 cellHeight = p.s->font->cellSize.y;
+    const u32 columnEnd = std::min(bitmap.columnEnd, p.s->cellCount.x);
+    const u32 srcWidth = (bitmap.columnEnd - bitmap.columnBegin) * u32{ bitmap.cellSize.x };
+    const u32 dstWidth = (columnEnd - bitmap.columnBegin) * cellWidth;
+
+    _imageScratch.resize(size_t{ dstWidth } * cellHeight);
+
+    auto dst = _imageScratch.begin();
+    for (u32 dy = 0; dy < cellHeight; ++dy)
+    {
+        const auto sy = dy * bitmap.cellSize.y / cellHeight;
+        const auto src = bitmap.pixels.begin() + size_t{ sy } * srcWidth;
+        for (u32 dx = 0; dx < dstWidth; ++dx)
+        {
+            *dst++ = src[dx * bitmap.cellSize.x / cellWidth];
+        }
+    }
 
-    auto src = std::bit_cast<const char*>(p.backgroundBitmap.data());
-    const auto srcEnd = std::bit_cast<const char*>(p.backgroundBitmap.data() + p.backgroundBitmap.size());
-    const auto srcStride = p.colorBitmapRowStride * sizeof(u32);
-    auto dst = static_cast<char*>(mapped.pData);
+    const D3D11_BOX box{
+        .left = bitmap.columnBegin * cellWidth,
+        .top = y * cellHeight,
+        .front = 0,
+        .right = bitmap.columnBegin * cellWidth + dstWidth,
+        .bottom = (y + 1) * cellHeight,
+        .back = 1,
+    };
+    p.deviceContext->UpdateSubresource(_imageTexture.get(), 0, &box, _imageScratch.data(), dstWidth * sizeof(u32), 0);
+}
 
-    while (src < srcEnd)
+void BackendD3D::_uploadBackgroundBitmap(const RenderingPayload& p)
+{
+    const auto srcStride = gsl::narrow_cast<UINT>(p.colorBitmapRowStride * sizeof(u32));
+
+    // If our texture is up to date with how the bitmap looked before this frame, only the rows that
+    // changed since then need to be uploaded. Otherwise (for instance after the texture got recreated,
+    // or if we skipped a frame) we need to upload all of it.
+    if (_backgroundBitmapGeneration == p.backgroundBitmapBaseGeneration && p.backgroundBitmapDirtyRows.non_empty())
+    {
+        const auto& rows = p.backgroundBitmapDirtyRows;
+        const D3D11_BOX box{
+            .left = 0,
+            .top = rows.start,
+            .front = 0,
+            .right = p.s->cellCount.x,
+            .bottom = rows.end,
+            .back = 1,
+        };
+        p.deviceContext->UpdateSubresource(_backgroundBitmap.get(), 0, &box, p.backgroundBitmap.data() + p.colorBitmapRowStride * rows.start, srcStride, 0);
+    }
+    else
     {
-        memcpy(dst, src, srcStride);
-        src += srcStride;
-        dst += mapped.RowPitch;
+        p.deviceContext->UpdateSubresource(_backgroundBitmap.get(), 0, nullptr, p.backgroundBitmap.data(), srcStride, 0);
     }
 
-    p.deviceContext->Unmap(_backgroundBitmap.get(), 0);
     _backgroundBitmapGeneration = p.colorBitmapGenerations[0];
 }
 
 void BackendD3D::_drawText(RenderingPayload& p)
 {
+    _glyphAtlasFrame++;
+
     if (_fontChangedResetGlyphAtlas)
     {
         _resetGlyphAtlas(p);
@@ -968,19 +1489,47 @@ void BackendD3D::_drawText(RenderingPayload& p)
     u16 y = 0;
     for (const auto row : p.rows)
     {
+        // When drawing into the retained texture, rows that don't touch the dirty area can be
+        // skipped, since their pixels are still in the texture (and the scissor rect would cull them anyway).
+        // The vertex shader moves the rows up by the smooth scroll offset, which brings the overscan row into view.
+        const auto rowTop = std::min<til::CoordType>(y * p.s->font->cellSize.y, row->dirtyTop) - p.smoothScrollOffset;
+        const auto rowBottom = std::max<til::CoordType>((y + 1) * p.s->font->cellSize.y, row->dirtyBottom) - p.smoothScrollOffset;
+        if (rowBottom <= _drawTop || rowTop >= _drawBottom)
+        {
+            ++y;
+            continue;
+        }
+
+        const auto cellHeight = static_cast<til::CoordType>(p.s->font->cellSize.y);
         f32 baselineX = 0;
         f32 baselineY = y * p.s->font->cellSize.y + p.s->font->baseline;
         f32 scaleX = 1;
         f32 scaleY = 1;
+        u8x2 renditionShift{};
+        // DECDHL rows show either half of a glyph that's twice as tall as the row. It gets clipped to the row.
+        auto clipTop = til::CoordTypeMin;
+        auto clipBottom = til::CoordTypeMax;
 
         if (row->lineRendition != LineRendition::SingleWidth)
         {
             scaleX = 2;
+            renditionShift.x = 1;
 
             if (row->lineRendition >= LineRendition::DoubleHeightTop)
             {
+                // Both halves are positioned relative to the top of the pair of rows,
+                // which has twice the line height and thus twice the descender gap.
+                auto pairTop = y * cellHeight;
+                if (row->lineRendition == LineRendition::DoubleHeightBottom)
+                {
+                    pairTop -= cellHeight;
+                }
+
                 scaleY = 2;
-                baselineY /= 2;
+                renditionShift.y = 1;
+                baselineY = (pairTop + cellHeight + p.s->font->baseline - p.s->font->descender) / 2.0f;
+                clipTop = y * cellHeight;
+                clipBottom = clipTop + cellHeight;
             }
         }
 
@@ -989,7 +1538,6 @@ void BackendD3D::_drawText(RenderingPayload& p)
             auto x = m.glyphsFrom;
             const AtlasFontFaceKey fontFaceKey{
                 .fontFace = m.fontFace.get(),
-                .lineRendition = row->lineRendition,
             };
 
         // This goto label exists to allow us to retry rendering a glyph if the glyph atlas was full.
@@ -1002,45 +1550,84 @@ void BackendD3D::_drawText(RenderingPayload& p)
             if (fontFaceInserted)
             {
                 _initializeFontFaceEntry(fontFaceEntry);
+                if (_glyphCache)
+                {
+                    _uploadCachedGlyphs(p, fontFaceEntry);
+                }
             }
 
             while (x < m.glyphsTo)
             {
+                if (!m.fontFace && BuiltinGlyphs::IsBuiltinGlyph(row->glyphIndices[x]))
+                {
+                    _drawBuiltinGlyph(p, y, x, baselineX * scaleX);
+                    baselineX += row->glyphAdvances[x];
+                    ++x;
+                    continue;
+                }
+
                 const auto [glyphEntry, inserted] = fontFaceEntry.glyphs.insert(row->glyphIndices[x]);
 
-                if (inserted && !_drawGlyph(p, fontFaceEntry, glyphEntry))
+                if (inserted)
                 {
-                    // A deadlock in this retry loop is detected in _drawGlyphPrepareRetry.
-                    //
-                    // Yes, I agree, avoid goto. Sometimes. It's not my fault that C++ still doesn't
-                    // have a `continue outerloop;` like other languages had it for decades. :(
+                    if (p.perfCounters)
+                    {
+                        PerfCounters::Add(p.perfCounters->atlasMisses, 1);
+                    }
+
+                    if (!_drawGlyph(p, fontFaceEntry, glyphEntry))
+                    {
+                        // A deadlock in this retry loop is detected in _drawGlyphPrepareRetry.
+                        //
+                        // Yes, I agree, avoid goto. Sometimes. It's not my fault that C++ still doesn't
+                        // have a `continue outerloop;` like other languages had it for decades. :(
 #pragma warning(suppress : 26438) // Avoid 'goto' (es.76).
 #pragma warning(suppress : 26448) // Consider using gsl::finally if final action is intended (gsl.util).
-                    goto drawGlyphRetry;
+                        goto drawGlyphRetry;
+                    }
                 }
 
                 if (glyphEntry.data.GetShadingType() != ShadingType::Default)
                 {
+                    _glyphAtlasPages[glyphEntry.data.texcoord.y >> _glyphAtlasPageShift].lastUse = _glyphAtlasFrame;
+
                     auto l = static_cast<til::CoordType>(lrintf((baselineX + row->glyphOffsets[x].advanceOffset) * scaleX));
                     auto t = static_cast<til::CoordType>(lrintf((baselineY - row->glyphOffsets[x].ascenderOffset) * scaleY));
+                    auto w = static_cast<til::CoordType>(glyphEntry.data.size.x) << renditionShift.x;
+                    auto h = static_cast<til::CoordType>(glyphEntry.data.size.y) << renditionShift.y;
+                    auto u = static_cast<til::CoordType>(glyphEntry.data.texcoord.x) << renditionShift.x;
+                    auto v = static_cast<til::CoordType>(glyphEntry.data.texcoord.y) << renditionShift.y;
 
-                    l += glyphEntry.data.offset.x;
-                    t += glyphEntry.data.offset.y;
+                    l += glyphEntry.data.offset.x * (1 << renditionShift.x);
+                    t += glyphEntry.data.offset.y * (1 << renditionShift.y);
 
-                    row->dirtyTop = std::min(row->dirtyTop, t);
-                    row->dirtyBottom = std::max(row->dirtyBottom, t + glyphEntry.data.size.y);
-
-                    _appendQuad() = {
-                        .shadingType = glyphEntry.data.GetShadingType(),
-                        .position = { static_cast<i16>(l), static_cast<i16>(t) },
-                        .size = glyphEntry.data.size,
-                        .texcoord = glyphEntry.data.texcoord,
-                        .color = row->colors[x],
-                    };
+                    if (t < clipTop)
+                    {
+                        h -= clipTop - t;
+                        v += clipTop - t;
+                        t = clipTop;
+                    }
+                    h = std::min(h, clipBottom - t);
 
-                    if (glyphEntry.data.overlapSplit)
+                    // Things like diacritics might be so small that they only exist on either half of a DECDHL row.
+                    if (h > 0)
                     {
-                        _drawTextOverlapSplit(p, y);
+                        row->dirtyTop = std::min(row->dirtyTop, t);
+                        row->dirtyBottom = std::max(row->dirtyBottom, t + h);
+
+                        _appendQuad() = {
+                            .shadingType = glyphEntry.data.GetShadingType(),
+                            .renditionShift = renditionShift,
+                            .position = { static_cast<i16>(l), static_cast<i16>(t) },
+                            .size = { static_cast<u16>(w), static_cast<u16>(h) },
+                            .texcoord = { static_cast<u16>(u), static_cast<u16>(v) },
+                            .color = row->colors[x],
+                        };
+
+                        if (glyphEntry.data.overlapSplit)
+                        {
+                            _drawTextOverlapSplit(p, y);
+                        }
                     }
                 }
 
@@ -1072,9 +1659,68 @@ void BackendD3D::_drawText(RenderingPayload& p)
     _d2dEndDrawing();
 }
 
-// There are a number of coding-oriented fonts that feature ligatures which (for instance)
-// translate text like "!=" into a glyph that looks like "≠" (just 2 columns wide and not 1).
-// Glyphs like that still need to be colored in potentially multiple colors however, so this
+// Box drawing characters, block elements and braille patterns (see BuiltinGlyphs.h) are drawn
+// as a couple of solid rectangles, instead of being rasterized into the glyph atlas.
+void BackendD3D::_drawBuiltinGlyph(const RenderingPayload& p, u16 y, u32 x, f32 left)
+{
+    const auto row = p.rows[y];
+
+    const auto horizontalShift = static_cast<u8>(row->lineRendition != LineRendition::SingleWidth);
+    const auto verticalShift = static_cast<u8>(row->lineRendition >= LineRendition::DoubleHeightTop);
+
+    const auto cellSize = p.s->font->cellSize;
+    const auto rowTop = static_cast<i32>(cellSize.y * y);
+    const auto rowBottom = rowTop + cellSize.y;
+
+    auto textCellTop = rowTop;
+    if (row->lineRendition == LineRendition::DoubleHeightBottom)
+    {
+        textCellTop -= cellSize.y;
+    }
+
+    const i32 clipTop = row->lineRendition == LineRendition::DoubleHeightBottom ? rowTop : 0;
+    const i32 clipBottom = row->lineRendition == LineRendition::DoubleHeightTop ? rowBottom : p.s->targetSize.y + p.smoothScrollOffset;
+
+    const auto l = static_cast<i32>(lrintf(left));
+    const auto width = static_cast<i32>(lrintf(row->glyphAdvances[x])) << horizontalShift;
+    const auto height = static_cast<i32>(cellSize.y) << verticalShift;
+    const auto color = row->colors[x];
+
+    BuiltinGlyphs::Rect rects[BuiltinGlyphs::MaxRectCount];
+    const auto count = BuiltinGlyphs::GetRects(row->glyphIndices[x], width, height, p.s->font->thinLineWidth, rects);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& r = rects[i];
+        const auto rt = clamp(textCellTop + r.top, clipTop, clipBottom);
+        const auto rb = clamp(textCellTop + r.bottom, clipTop, clipBottom);
+        if (rt >= rb)
+        {
+            continue;
+        }
+
+        // The shades (U+2591-2593) are translucent versions of the full block.
+        auto c = color;
+        if (r.alpha != 255)
+        {
+            c = (color & 0xffffff) | ((color >> 24) * r.alpha / 255) << 24;
+        }
+
+        _appendQuad() = {
+            .shadingType = ShadingType::SolidLine,
+            .position = { static_cast<i16>(l + r.left), static_cast<i16>(rt) },
+            .size = { static_cast<u16>(r.right - r.left), static_cast<u16>(rb - rt) },
+            .color = c,
+        };
+
+        row->dirtyTop = std::min(row->dirtyTop, rt);
+        row->dirtyBottom = std::max(row->dirtyBottom, rb);
+    }
+}
+
+// There are a number of coding-oriented fonts that feature ligatures which (for instance)
+// translate text like "!=" into a glyph that looks like "≠" (just 2 columns wide and not 1).
+// Glyphs like that still need to be colored in potentially multiple colors however, so this
 // function will handle these ligatures by splitting them up into multiple QuadInstances.
 //
 // It works by iteratively splitting the wide glyph into shorter and shorter segments like so
@@ -1176,7 +1822,7 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
 {
     if (!fontFaceEntry.fontFace)
     {
-        return _drawSoftFontGlyph(p, fontFaceEntry, glyphEntry);
+        return _drawSoftFontGlyph(p, glyphEntry);
     }
 
     const DWRITE_GLYPH_RUN glyphRun{
@@ -1254,23 +1900,6 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
     // The buffer now contains a grayscale alpha mask.
 #endif
 
-    const auto lineRendition = static_cast<LineRendition>(fontFaceEntry.lineRendition);
-    const auto needsTransform = lineRendition != LineRendition::SingleWidth;
-
-    static constexpr D2D1_MATRIX_3X2_F identityTransform{ .m11 = 1, .m22 = 1 };
-    D2D1_MATRIX_3X2_F transform = identityTransform;
-
-    if (needsTransform)
-    {
-        transform.m11 = 2.0f;
-        transform.m22 = lineRendition >= LineRendition::DoubleHeightTop ? 2.0f : 1.0f;
-        _d2dRenderTarget->SetTransform(&transform);
-    }
-
-    const auto restoreTransform = wil::scope_exit([&]() noexcept {
-        _d2dRenderTarget->SetTransform(&identityTransform);
-    });
-
     // This calculates the black box of the glyph, or in other words,
     // it's extents/size relative to its baseline origin (at 0,0).
     //
@@ -1330,9 +1959,9 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
     {
         // NOTE: As mentioned above, the "origin" of a glyph's coordinate system is its baseline.
         bounds.left = std::max(bounds.left, 0.0f);
-        bounds.top = std::max(bounds.top, static_cast<f32>(-p.s->font->baseline) * transform.m22);
-        bounds.right = std::min(bounds.right, static_cast<f32>(p.s->font->cellSize.x) * transform.m11);
-        bounds.bottom = std::min(bounds.bottom, static_cast<f32>(p.s->font->descender) * transform.m22);
+        bounds.top = std::max(bounds.top, static_cast<f32>(-p.s->font->baseline));
+        bounds.right = std::min(bounds.right, static_cast<f32>(p.s->font->cellSize.x));
+        bounds.bottom = std::min(bounds.bottom, static_cast<f32>(p.s->font->descender));
     }
 
     // The bounds may be empty if the glyph is whitespace.
@@ -1350,9 +1979,9 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
         .w = br - bl,
         .h = bb - bt,
     };
-    if (!stbrp_pack_rects(&_rectPacker, &rect, 1))
+    if (!_packGlyphRect(rect))
     {
-        _drawGlyphPrepareRetry(p);
+        _drawGlyphPrepareRetry(p, glyphEntry);
         return false;
     }
 
@@ -1366,10 +1995,10 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
     if (isBoxGlyph)
     {
         const D2D1_RECT_F clipRect{
-            static_cast<f32>(rect.x) / transform.m11,
-            static_cast<f32>(rect.y) / transform.m22,
-            static_cast<f32>(rect.x + rect.w) / transform.m11,
-            static_cast<f32>(rect.y + rect.h) / transform.m22,
+            static_cast<f32>(rect.x),
+            static_cast<f32>(rect.y),
+            static_cast<f32>(rect.x + rect.w),
+            static_cast<f32>(rect.y + rect.h),
         };
         _d2dRenderTarget->PushAxisAlignedClip(&clipRect, D2D1_ANTIALIAS_MODE_ALIASED);
     }
@@ -1380,13 +2009,6 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
         }
     });
 
-    if (needsTransform)
-    {
-        transform.dx = (1.0f - transform.m11) * baselineOrigin.x;
-        transform.dy = (1.0f - transform.m22) * baselineOrigin.y;
-        _d2dRenderTarget->SetTransform(&transform);
-    }
-
     if (!isColorGlyph)
     {
         _d2dRenderTarget->DrawGlyphRun(baselineOrigin, &glyphRun, _brush.get(), DWRITE_MEASURING_MODE_NATURAL);
@@ -1406,10 +2028,7 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
     //
     // The former condition makes sure to exclude diacritics and such from being considered a ligature,
     // while the latter condition-pair makes sure to exclude regular BMP wide glyphs that overlap a little.
-    const auto horizontalScale = lineRendition != LineRendition::SingleWidth ? 2 : 1;
-    const auto triggerLeft = _ligatureOverhangTriggerLeft * horizontalScale;
-    const auto triggerRight = _ligatureOverhangTriggerRight * horizontalScale;
-    const auto overlapSplit = rect.w >= p.s->font->cellSize.x && (bl <= triggerLeft || br >= triggerRight);
+    const auto overlapSplit = rect.w >= p.s->font->cellSize.x && (bl <= _ligatureOverhangTriggerLeft || br >= _ligatureOverhangTriggerRight);
 
     glyphEntry.data.shadingType = static_cast<u16>(isColorGlyph ? ShadingType::TextPassthrough : _textShadingType);
     glyphEntry.data.overlapSplit = overlapSplit;
@@ -1420,35 +2039,19 @@ bool BackendD3D::_drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryI
     glyphEntry.data.texcoord.x = rect.x;
     glyphEntry.data.texcoord.y = rect.y;
 
-    if (lineRendition >= LineRendition::DoubleHeightTop)
-    {
-        _splitDoubleHeightGlyph(p, fontFaceEntry, glyphEntry);
-    }
-
     return true;
 }
 
-bool BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p, const AtlasFontFaceEntryInner& fontFaceEntry, AtlasGlyphEntry& glyphEntry)
+bool BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p, AtlasGlyphEntry& glyphEntry)
 {
     stbrp_rect rect{
         .w = p.s->font->cellSize.x,
         .h = p.s->font->cellSize.y,
     };
 
-    const auto lineRendition = static_cast<LineRendition>(fontFaceEntry.lineRendition);
-    auto baseline = p.s->font->baseline;
-
-    if (lineRendition != LineRendition::SingleWidth)
+    if (!_packGlyphRect(rect))
     {
-        const auto heightShift = static_cast<u8>(lineRendition >= LineRendition::DoubleHeightTop);
-        rect.w <<= 1;
-        rect.h <<= heightShift;
-        baseline <<= heightShift;
-    }
-
-    if (!stbrp_pack_rects(&_rectPacker, &rect, 1))
-    {
-        _drawGlyphPrepareRetry(p);
+        _drawGlyphPrepareRetry(p, glyphEntry);
         return false;
     }
 
@@ -1457,8 +2060,8 @@ bool BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p, const AtlasFontFa
         // Allocating such a tiny texture is very wasteful (min. texture size on GPUs
         // right now is 64kB), but this is a seldomly used feature so it's fine...
         const D2D1_SIZE_U size{
-            static_cast<UINT32>(p.s->font->softFontCellSize.width),
-            static_cast<UINT32>(p.s->font->softFontCellSize.height),
+            static_cast<UINT32>(p.s->softFont->softFontCellSize.width),
+            static_cast<UINT32>(p.s->softFont->softFontCellSize.height),
         };
         const D2D1_BITMAP_PROPERTIES1 bitmapProperties{
             .pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED },
@@ -1469,12 +2072,12 @@ bool BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p, const AtlasFontFa
     }
 
     {
-        const auto width = static_cast<size_t>(p.s->font->softFontCellSize.width);
-        const auto height = static_cast<size_t>(p.s->font->softFontCellSize.height);
+        const auto width = static_cast<size_t>(p.s->softFont->softFontCellSize.width);
+        const auto height = static_cast<size_t>(p.s->softFont->softFontCellSize.height);
 
         auto bitmapData = Buffer<u32>{ width * height };
         const auto glyphIndex = glyphEntry.glyphIndex - 0xEF20u;
-        auto src = p.s->font->softFontPattern.begin() + height * glyphIndex;
+        auto src = p.s->softFont->softFontPattern.begin() + height * glyphIndex;
         auto dst = bitmapData.begin();
 
         for (size_t y = 0; y < height; y++)
@@ -1506,67 +2109,509 @@ bool BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p, const AtlasFontFa
     glyphEntry.data.shadingType = static_cast<u16>(ShadingType::TextGrayscale);
     glyphEntry.data.overlapSplit = 0;
     glyphEntry.data.offset.x = 0;
-    glyphEntry.data.offset.y = -baseline;
+    glyphEntry.data.offset.y = -p.s->font->baseline;
     glyphEntry.data.size.x = rect.w;
     glyphEntry.data.size.y = rect.h;
     glyphEntry.data.texcoord.x = rect.x;
     glyphEntry.data.texcoord.y = rect.y;
 
-    if (lineRendition >= LineRendition::DoubleHeightTop)
+    return true;
+}
+
+// Finds space for the given rect on any of the glyph atlas pages.
+// On success rect.x/y are in texture coordinates of the entire atlas.
+bool BackendD3D::_packGlyphRect(stbrp_rect& rect) noexcept
+{
+    for (u16 i = 0; i < _glyphAtlasPageCount; ++i)
     {
-        _splitDoubleHeightGlyph(p, fontFaceEntry, glyphEntry);
+        auto& page = _glyphAtlasPages[i];
+        if (stbrp_pack_rects(&page.packer, &rect, 1))
+        {
+            rect.y += i << _glyphAtlasPageShift;
+            page.lastUse = _glyphAtlasFrame;
+            return true;
+        }
     }
-
-    return true;
+    return false;
 }
 
-void BackendD3D::_drawGlyphPrepareRetry(const RenderingPayload& p)
+void BackendD3D::_drawGlyphPrepareRetry(const RenderingPayload& p, const AtlasGlyphEntry& pendingGlyphEntry)
 {
     THROW_HR_IF_MSG(E_UNEXPECTED, _glyphAtlasMap.empty(), "BackendD3D::_drawGlyph deadlock");
     _d2dEndDrawing();
+    // The pending quads may refer to any page, which is why they need to be drawn before any of them is overwritten.
     _flushQuads(p);
-    _resetGlyphAtlas(p);
+    if (!_evictGlyphAtlasPage(p, pendingGlyphEntry))
+    {
+        _resetGlyphAtlas(p);
+    }
 }
 
-// If this is a double-height glyph (DECDHL), we need to split it into 2 glyph entries:
-// One for the top/bottom half each, because that's how DECDHL works. This will clip the
-// `glyphEntry` to only contain the one specified by `fontFaceEntry.lineRendition`
-// and create a second entry in our glyph cache hashmap that contains the other half.
-void BackendD3D::_splitDoubleHeightGlyph(const RenderingPayload& p, const AtlasFontFaceEntryInner& fontFaceEntry, AtlasGlyphEntry& glyphEntry)
+// Returns a hash that identifies the given font face across processes, or 0 if that's not possible,
+// because it isn't backed by exactly one local font file (for instance fonts loaded from memory).
+// The reference key of local font files contains the file's path and last write time.
+static size_t glyphCacheFontFaceIdentity(IDWriteFontFace2* fontFace) noexcept
+try
 {
-    // Twice the line height, twice the descender gap. For both.
-    glyphEntry.data.offset.y -= p.s->font->descender;
+    UINT32 fileCount = 0;
+    THROW_IF_FAILED(fontFace->GetFiles(&fileCount, nullptr));
+    if (fileCount != 1)
+    {
+        return 0;
+    }
 
-    const auto isTop = fontFaceEntry.lineRendition == LineRendition::DoubleHeightTop;
+    wil::com_ptr<IDWriteFontFile> file;
+    THROW_IF_FAILED(fontFace->GetFiles(&fileCount, file.addressof()));
 
-    const AtlasFontFaceKey key2{
-        .fontFace = fontFaceEntry.fontFace.get(),
-        .lineRendition = isTop ? LineRendition::DoubleHeightBottom : LineRendition::DoubleHeightTop,
+    wil::com_ptr<IDWriteFontFileLoader> loader;
+    THROW_IF_FAILED(file->GetLoader(loader.addressof()));
+    if (!loader.try_query<IDWriteLocalFontFileLoader>())
+    {
+        return 0;
+    }
+
+    const void* key = nullptr;
+    UINT32 keySize = 0;
+    THROW_IF_FAILED(file->GetReferenceKey(&key, &keySize));
+
+    const auto index = fontFace->GetIndex();
+    const auto simulations = static_cast<u32>(fontFace->GetSimulations());
+
+    til::hasher hasher;
+    hasher.write(key, keySize);
+    hasher.write(&index, 1);
+    hasher.write(&simulations, 1);
+
+    if (const auto fontFace5 = wil::try_com_query<IDWriteFontFace5>(fontFace))
+    {
+        std::vector<DWRITE_FONT_AXIS_VALUE> axisValues(fontFace5->GetFontAxisValueCount());
+        THROW_IF_FAILED(fontFace5->GetFontAxisValues(axisValues.data(), gsl::narrow_cast<UINT32>(axisValues.size())));
+        hasher.write(static_cast<const void*>(axisValues.data()), axisValues.size() * sizeof(DWRITE_FONT_AXIS_VALUE));
+    }
+
+    return std::max<size_t>(1, hasher.finalize());
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return 0;
+}
+
+// All BackendD3D instances in this process with the same font settings share one SharedGlyphCache. It's loaded
+// from disk only once and every instance can contribute the glyphs it rasterized, which allows new panes and
+// tabs to fill their glyph atlas without rasterizing anything. Each instance still needs its own atlas texture,
+// because every AtlasEngine owns a separate, single-threaded D3D device.
+struct BackendD3D::SharedGlyphCache
+{
+    explicit SharedGlyphCache(std::filesystem::path path) noexcept :
+        path{ std::move(path) }
+    {
+    }
+
+    static std::shared_ptr<SharedGlyphCache> Get(size_t key, std::filesystem::path path);
+
+    void Load() noexcept;
+    void Save() const noexcept;
+
+    // The on-disk cache file or empty if there's none.
+    const std::filesystem::path path;
+    std::once_flag loaded;
+    // Guards `faces`. Render threads of different windows may access it concurrently.
+    mutable std::shared_mutex mutex;
+    // Keyed by glyphCacheFontFaceIdentity().
+    std::unordered_map<size_t, std::vector<GlyphCacheEntry>> faces;
+};
+
+std::shared_ptr<BackendD3D::SharedGlyphCache> BackendD3D::SharedGlyphCache::Get(const size_t key, std::filesystem::path path)
+{
+    static std::mutex mutex;
+    static std::unordered_map<size_t, std::weak_ptr<SharedGlyphCache>> caches;
+
+    std::shared_ptr<SharedGlyphCache> cache;
+
+    {
+        const std::lock_guard guard{ mutex };
+
+        // The caches are reference counted by the BackendD3D instances using them. This drops
+        // the ones no one uses anymore, for instance because all windows changed their font.
+        std::erase_if(caches, [&](const auto& kv) { return kv.first != key && kv.second.expired(); });
+
+        auto& weak = caches[key];
+        cache = weak.lock();
+        if (!cache)
+        {
+            cache = std::make_shared<SharedGlyphCache>(std::move(path));
+            weak = cache;
+        }
+    }
+
+    // Other threads that get this cache simultaneously will block here until it finished loading.
+    std::call_once(cache->loaded, [&]() { cache->Load(); });
+    return cache;
+}
+
+// Reads the on-disk glyph cache file, if there's any.
+// All errors are ignored: A missing or broken cache file only means that we rasterize all glyphs like before.
+void BackendD3D::SharedGlyphCache::Load() noexcept
+try
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    if (!file)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &fileSize));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE), fileSize.QuadPart > glyphCacheMaxFileSize);
+
+    std::vector<u8> buffer(gsl::narrow_cast<size_t>(fileSize.QuadPart));
+    DWORD bytesRead = 0;
+    THROW_IF_WIN32_BOOL_FALSE(ReadFile(file.get(), buffer.data(), gsl::narrow_cast<DWORD>(buffer.size()), &bytesRead, nullptr));
+    file.reset();
+
+    size_t offset = 0;
+    const auto read = [&](void* dst, size_t size) {
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), size > bytesRead - offset);
+        memcpy(dst, buffer.data() + offset, size);
+        offset += size;
     };
 
-    auto& glyphCache = _glyphAtlasMap.insert(key2).first.inner->glyphs;
-    auto& entry2 = glyphCache.insert(glyphEntry.glyphIndex).first;
-    entry2.data = glyphEntry.data;
+    u32 header[3];
+    read(&header[0], sizeof(header));
+    if (header[0] != glyphCacheMagic || header[1] != glyphCacheVersion)
+    {
+        return;
+    }
+
+    std::unordered_map<size_t, std::vector<GlyphCacheEntry>> loadedFaces;
+
+    for (u32 i = 0; i < header[2]; ++i)
+    {
+        u64 identity;
+        u32 glyphCount;
+        read(&identity, sizeof(identity));
+        read(&glyphCount, sizeof(glyphCount));
+
+        auto& entries = loadedFaces[gsl::narrow_cast<size_t>(identity)];
+        for (u32 j = 0; j < glyphCount; ++j)
+        {
+            auto& entry = entries.emplace_back();
+            read(&entry.glyphIndex, sizeof(entry.glyphIndex));
+            read(&entry.data, sizeof(entry.data));
+
+            if (entry.data.GetShadingType() != ShadingType::Default)
+            {
+                entry.bitmap.resize(static_cast<size_t>(entry.data.size.x) * entry.data.size.y);
+                read(entry.bitmap.data(), entry.bitmap.size() * sizeof(u32));
+            }
+        }
+    }
+
+    const std::unique_lock guard{ mutex };
+    faces = std::move(loadedFaces);
+}
+CATCH_LOG()
+
+// Writes all glyphs into the on-disk glyph cache file.
+void BackendD3D::SharedGlyphCache::Save() const noexcept
+try
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    std::vector<u8> buffer;
+    const auto write = [&](const void* src, size_t size) {
+        const auto data = static_cast<const u8*>(src);
+        buffer.insert(buffer.end(), data, data + size);
+    };
+
+    {
+        const std::shared_lock guard{ mutex };
+
+        const u32 header[3]{ glyphCacheMagic, glyphCacheVersion, gsl::narrow_cast<u32>(faces.size()) };
+        write(&header[0], sizeof(header));
+
+        for (const auto& [identity, entries] : faces)
+        {
+            const auto identity64 = static_cast<u64>(identity);
+            const auto glyphCount = gsl::narrow_cast<u32>(entries.size());
+            write(&identity64, sizeof(identity64));
+            write(&glyphCount, sizeof(glyphCount));
 
-    auto& top = isTop ? glyphEntry : entry2;
-    auto& bottom = isTop ? entry2 : glyphEntry;
+            for (const auto& entry : entries)
+            {
+                write(&entry.glyphIndex, sizeof(entry.glyphIndex));
+                write(&entry.data, sizeof(entry.data));
+                write(entry.bitmap.data(), entry.bitmap.size() * sizeof(u32));
+            }
+        }
+    }
 
-    const auto topSize = clamp(-glyphEntry.data.offset.y - p.s->font->baseline, 0, static_cast<int>(glyphEntry.data.size.y));
-    top.data.offset.y += p.s->font->cellSize.y;
-    top.data.size.y = topSize;
-    bottom.data.offset.y += topSize;
-    bottom.data.size.y = std::max(0, bottom.data.size.y - topSize);
-    bottom.data.texcoord.y += topSize;
+    // Multiple processes may write the same cache file at the same time. Writing
+    // into a temporary file first and then renaming it ensures that neither of
+    // them ends up reading a partially written file.
+    wchar_t suffix[32];
+    swprintf_s(suffix, L".%u.tmp", GetCurrentProcessId());
+    auto temporaryPath = path;
+    temporaryPath += &suffix[0];
+
+    std::filesystem::create_directories(path.parent_path());
 
-    // Things like diacritics might be so small that they only exist on either half of the
-    // double-height row. This effectively turns the other (unneeded) side into whitespace.
-    if (!top.data.size.y)
     {
-        top.data.shadingType = static_cast<u16>(ShadingType::Default);
+        wil::unique_hfile file{ CreateFileW(temporaryPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!file);
+
+        const auto fileSize = gsl::narrow<DWORD>(buffer.size());
+        DWORD bytesWritten = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), buffer.data(), fileSize, &bytesWritten, nullptr));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), bytesWritten != fileSize);
     }
-    if (!bottom.data.size.y)
+
+    if (!MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
     {
-        bottom.data.shadingType = static_cast<u16>(ShadingType::Default);
+        DeleteFileW(temporaryPath.c_str());
+        THROW_LAST_ERROR();
+    }
+}
+CATCH_LOG()
+
+// Gets the SharedGlyphCache for the current font settings. Its glyphs are then uploaded into
+// the atlas by _uploadCachedGlyphs() as soon as their font face is used for the first time.
+void BackendD3D::_loadGlyphCache(const RenderingPayload& p) noexcept
+try
+{
+    _glyphCache.reset();
+
+    const auto& font = *p.s->font;
+    const auto antialiasingMode = static_cast<u32>(font.antialiasingMode);
+    til::hasher hasher;
+    hasher.write(&glyphCacheVersion, 1);
+    hasher.write(font.fontName.data(), font.fontName.size());
+    hasher.write(static_cast<const void*>(font.fontFeatures.data()), font.fontFeatures.size() * sizeof(DWRITE_FONT_FEATURE));
+    hasher.write(static_cast<const void*>(font.fontAxisValues.data()), font.fontAxisValues.size() * sizeof(DWRITE_FONT_AXIS_VALUE));
+    hasher.write(static_cast<const void*>(&font.fontSize), sizeof(font.fontSize));
+    hasher.write(&font.cellSize, 1);
+    hasher.write(&font.fontWeight, 1);
+    hasher.write(&font.baseline, 1);
+    hasher.write(&font.descender, 1);
+    hasher.write(&font.dpi, 1);
+    hasher.write(&antialiasingMode, 1);
+    // The system's text rendering parameters affect the rasterized glyphs as well.
+    hasher.write(static_cast<const void*>(&_gamma), sizeof(_gamma));
+    hasher.write(static_cast<const void*>(&_cleartypeEnhancedContrast), sizeof(_cleartypeEnhancedContrast));
+    hasher.write(static_cast<const void*>(&_grayscaleEnhancedContrast), sizeof(_grayscaleEnhancedContrast));
+    const auto key = hasher.finalize();
+
+    std::filesystem::path path;
+    wchar_t directory[MAX_PATH];
+    const auto directoryLength = ExpandEnvironmentStringsW(glyphCacheDirectory, &directory[0], MAX_PATH);
+    if (directoryLength != 0 && directoryLength <= MAX_PATH)
+    {
+        wchar_t name[32];
+        swprintf_s(name, L"%016llx.bin", static_cast<unsigned long long>(key));
+        path = std::filesystem::path{ &directory[0] } / &name[0];
+    }
+
+    _glyphCache = SharedGlyphCache::Get(key, std::move(path));
+}
+CATCH_LOG()
+
+// Adds the glyphs of the current font settings that are in the atlas and in glyphCacheCodepointRanges
+// to the shared glyph cache and, if any of them are new, writes it to disk. Since this requires
+// reading back the atlas texture from the GPU this is only done once per font change.
+void BackendD3D::_saveGlyphCache(const RenderingPayload& p) noexcept
+try
+{
+    if (!_glyphCache || !_glyphAtlas)
+    {
+        return;
+    }
+
+    std::vector<UINT32> codepoints;
+    for (const auto& [beg, end] : glyphCacheCodepointRanges)
+    {
+        for (auto ch = beg; ch < end; ++ch)
+        {
+            codepoints.emplace_back(ch);
+        }
+    }
+
+    std::vector<u16> glyphIndices(codepoints.size());
+    std::vector<std::pair<size_t, std::vector<const AtlasGlyphEntry*>>> faces;
+
+    {
+        const std::shared_lock guard{ _glyphCache->mutex };
+
+        for (const auto& slot : _glyphAtlasMap.container())
+        {
+            if (!slot.inner || !slot.inner->fontFace)
+            {
+                continue;
+            }
+
+            const auto& fontFaceEntry = *slot.inner;
+            const auto identity = glyphCacheFontFaceIdentity(fontFaceEntry.fontFace.get());
+            if (!identity)
+            {
+                continue;
+            }
+
+            THROW_IF_FAILED(fontFaceEntry.fontFace->GetGlyphIndices(codepoints.data(), gsl::narrow_cast<UINT32>(codepoints.size()), glyphIndices.data()));
+            std::sort(glyphIndices.begin(), glyphIndices.end());
+            const auto end = std::unique(glyphIndices.begin(), glyphIndices.end());
+
+            const auto cached = _glyphCache->faces.find(identity);
+            const auto isCached = [&](u16 glyphIndex) {
+                return cached != _glyphCache->faces.end() && std::ranges::any_of(cached->second, [&](const GlyphCacheEntry& e) { return e.glyphIndex == glyphIndex; });
+            };
+
+            std::vector<const AtlasGlyphEntry*> entries;
+            for (auto it = glyphIndices.begin(); it != end; ++it)
+            {
+                // Glyph index 0 is the .notdef glyph which all codepoints map to that aren't in the font.
+                if (*it == 0 || isCached(*it))
+                {
+                    continue;
+                }
+                if (const auto entry = fontFaceEntry.glyphs.lookup(*it))
+                {
+                    entries.emplace_back(entry);
+                }
+            }
+
+            if (!entries.empty())
+            {
+                faces.emplace_back(identity, std::move(entries));
+            }
+        }
+    }
+
+    // Nothing to contribute. Most likely another pane or tab already did it.
+    if (faces.empty())
+    {
+        return;
+    }
+
+    D3D11_TEXTURE2D_DESC desc;
+    _glyphAtlas->GetDesc(&desc);
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    wil::com_ptr<ID3D11Texture2D> staging;
+    THROW_IF_FAILED(p.device->CreateTexture2D(&desc, nullptr, staging.addressof()));
+    p.deviceContext->CopyResource(staging.get(), _glyphAtlas.get());
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    THROW_IF_FAILED(p.deviceContext->Map(staging.get(), 0, D3D11_MAP_READ, 0, &mapped));
+
+    {
+        const auto unmap = wil::scope_exit([&]() {
+            p.deviceContext->Unmap(staging.get(), 0);
+        });
+
+        const std::unique_lock guard{ _glyphCache->mutex };
+
+        for (const auto& [identity, entries] : faces)
+        {
+            auto& cached = _glyphCache->faces[identity];
+
+            for (const auto entry : entries)
+            {
+                // Another thread might have added the same glyph in the meantime.
+                if (std::ranges::any_of(cached, [&](const GlyphCacheEntry& e) { return e.glyphIndex == entry->glyphIndex; }))
+                {
+                    continue;
+                }
+
+                auto& c = cached.emplace_back();
+                c.glyphIndex = entry->glyphIndex;
+                c.data = entry->data;
+
+                if (entry->data.GetShadingType() != ShadingType::Default)
+                {
+                    const auto width = entry->data.size.x;
+                    auto src = static_cast<const u8*>(mapped.pData) + entry->data.texcoord.y * mapped.RowPitch + entry->data.texcoord.x * sizeof(u32);
+
+                    c.bitmap.resize(static_cast<size_t>(width) * entry->data.size.y);
+                    for (u16 y = 0; y < entry->data.size.y; ++y, src += mapped.RowPitch)
+                    {
+                        memcpy(c.bitmap.data() + static_cast<size_t>(y) * width, src, width * sizeof(u32));
+                    }
+                }
+            }
+        }
+    }
+
+    _glyphCache->Save();
+}
+CATCH_LOG()
+
+// Uploads the cached glyphs for the given font face (if any) into the atlas and inserts them into its glyph map.
+void BackendD3D::_uploadCachedGlyphs(const RenderingPayload& p, AtlasFontFaceEntryInner& fontFaceEntry)
+{
+    if (!fontFaceEntry.fontFace)
+    {
+        return;
+    }
+
+    const auto identity = glyphCacheFontFaceIdentity(fontFaceEntry.fontFace.get());
+    if (!identity)
+    {
+        return;
+    }
+
+    const std::shared_lock guard{ _glyphCache->mutex };
+
+    const auto it = _glyphCache->faces.find(identity);
+    if (it == _glyphCache->faces.end())
+    {
+        return;
+    }
+
+    // Direct2D batches its drawing commands. If we didn't flush them first, they might overwrite our
+    // uploads later on. For instance, the Clear() in _resetGlyphAtlas() would clear the entire atlas.
+    _d2dEndDrawing();
+
+    for (const auto& cached : it->second)
+    {
+        auto data = cached.data;
+
+        if (data.GetShadingType() != ShadingType::Default)
+        {
+            stbrp_rect rect{
+                .w = data.size.x,
+                .h = data.size.y,
+            };
+            // If the atlas is full we simply stop here. Any remaining glyphs will be rasterized on demand.
+            if (!_packGlyphRect(rect))
+            {
+                break;
+            }
+
+            const D3D11_BOX box{
+                static_cast<UINT>(rect.x),
+                static_cast<UINT>(rect.y),
+                0,
+                static_cast<UINT>(rect.x + rect.w),
+                static_cast<UINT>(rect.y + rect.h),
+                1,
+            };
+            p.deviceContext->UpdateSubresource(_glyphAtlas.get(), 0, &box, cached.bitmap.data(), data.size.x * sizeof(u32), 0);
+
+            data.texcoord.x = static_cast<u16>(rect.x);
+            data.texcoord.y = static_cast<u16>(rect.y);
+        }
+
+        fontFaceEntry.glyphs.insert(cached.glyphIndex).first.data = data;
     }
 }
 
@@ -1590,7 +2635,7 @@ void BackendD3D::_drawGridlines(const RenderingPayload& p, u16 y)
     }
 
     const i32 clipTop = row->lineRendition == LineRendition::DoubleHeightBottom ? rowTop : 0;
-    const i32 clipBottom = row->lineRendition == LineRendition::DoubleHeightTop ? rowBottom : p.s->targetSize.y;
+    const i32 clipBottom = row->lineRendition == LineRendition::DoubleHeightTop ? rowBottom : p.s->targetSize.y + p.smoothScrollOffset;
 
     const auto appendVerticalLines = [&](const GridLineRange& r, FontDecorationPosition pos) {
         const auto textCellWidth = cellSize.x << horizontalShift;
@@ -1677,6 +2722,53 @@ void BackendD3D::_drawGridlines(const RenderingPayload& p, u16 y)
     }
 }
 
+// The search highlights are drawn as a separate pass of frames around the highlighted cells, after all of the text.
+// Unlike _drawGridlines() this ignores the line rendition, as the Renderer already accounted for it.
+void BackendD3D::_drawSearchHighlights(const RenderingPayload& p)
+{
+    const auto& font = *p.s->font;
+    const auto cellSize = font.cellSize;
+    u16 y = 0;
+
+    for (const auto row : p.rows)
+    {
+        const auto rowTop = static_cast<i16>(cellSize.y * y);
+
+        for (const auto& r : row->searchHighlights)
+        {
+            const auto left = static_cast<i16>(cellSize.x * r.from);
+            const auto width = static_cast<u16>(cellSize.x * (r.to - r.from));
+            const auto appendLine = [&](i32 x, i32 top, u16 w, u16 h) {
+                _appendQuad() = {
+                    .shadingType = ShadingType::SolidLine,
+                    .position = { static_cast<i16>(x), static_cast<i16>(top) },
+                    .size = { w, h },
+                    .color = r.color,
+                };
+            };
+
+            if (r.lines.test(GridLines::Top))
+            {
+                appendLine(left, rowTop + font.gridTop.position, width, font.gridTop.height);
+            }
+            if (r.lines.test(GridLines::Bottom))
+            {
+                appendLine(left, rowTop + font.gridBottom.position, width, font.gridBottom.height);
+            }
+            if (r.lines.test(GridLines::Left))
+            {
+                appendLine(left + font.gridLeft.position, rowTop, font.gridLeft.height, cellSize.y);
+            }
+            if (r.lines.test(GridLines::Right))
+            {
+                appendLine(left + width - cellSize.x + font.gridRight.position, rowTop, font.gridRight.height, cellSize.y);
+            }
+        }
+
+        y++;
+    }
+}
+
 void BackendD3D::_drawCursorBackground(const RenderingPayload& p)
 {
     _cursorRects.clear();
@@ -2126,9 +3218,14 @@ void BackendD3D::_executeCustomShader(RenderingPayload& p)
 
         // OM: Output Merger
         p.deviceContext->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+
+        // RS: Rasterizer Stage
+        // The shader may sample the offscreen texture anywhere, which is why the entire swap chain is redrawn.
+        p.deviceContext->RSSetState(nullptr);
     }
 
     p.deviceContext->Draw(4, 0);
+    p.dirtyRectInPx = { 0, 0, p.s->targetSize.x, p.s->targetSize.y };
 
     {
         // IA: Input Assembler
@@ -2145,10 +3242,10 @@ void BackendD3D::_executeCustomShader(RenderingPayload& p)
         p.deviceContext->VSSetConstantBuffers(0, 1, _vsConstantBuffer.addressof());
 
         // PS: Pixel Shader
-        ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get() };
+        ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get(), _imageTextureView.get() };
         p.deviceContext->PSSetShader(_pixelShader.get(), nullptr, 0);
         p.deviceContext->PSSetConstantBuffers(0, 1, _psConstantBuffer.addressof());
-        p.deviceContext->PSSetShaderResources(0, 2, &resources[0]);
+        p.deviceContext->PSSetShaderResources(0, 3, &resources[0]);
         p.deviceContext->PSSetSamplers(0, 0, nullptr);
 
         // OM: Output Merger
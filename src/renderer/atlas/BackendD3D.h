@@ -18,6 +18,8 @@ namespace Microsoft::Console::Render::Atlas
         void ReleaseResources() noexcept override;
         void Render(RenderingPayload& payload) override;
         bool RequiresContinuousRedraw() noexcept override;
+        DWORD GetContinuousRedrawDelay() noexcept override;
+        u64 GetMemoryUsage() const noexcept override;
 
         // NOTE: D3D constant buffers sizes must be a multiple of 16 bytes.
         struct alignas(16) VSConstBuffer
@@ -30,6 +32,7 @@ namespace Microsoft::Console::Render::Atlas
             // * bool will probably not work the way you want it to,
             //   because HLSL uses 32-bit bools and C++ doesn't.
             alignas(sizeof(f32x2)) f32x2 positionScale;
+            alignas(sizeof(f32x2)) f32x2 positionOffset;
 #pragma warning(suppress : 4324) // 'VSConstBuffer': structure was padded due to alignment specifier
         };
 
@@ -42,6 +45,7 @@ namespace Microsoft::Console::Render::Atlas
             alignas(sizeof(f32x4)) f32 gammaRatios[4]{};
             alignas(sizeof(f32)) f32 enhancedContrast = 0;
             alignas(sizeof(f32)) f32 underlineWidth = 0;
+            alignas(sizeof(f32x2)) f32x2 backgroundOffset;
 #pragma warning(suppress : 4324) // 'PSConstBuffer': structure was padded due to alignment specifier
         };
 
@@ -55,7 +59,7 @@ namespace Microsoft::Console::Render::Atlas
 #pragma warning(suppress : 4324) // 'CustomConstBuffer': structure was padded due to alignment specifier
         };
 
-        enum class ShadingType : u32
+        enum class ShadingType : u16
         {
             Default = 0,
             Background = 0,
@@ -72,6 +76,7 @@ namespace Microsoft::Console::Render::Atlas
 
             Cursor = 7,
             Selection = 8,
+            Image = 9,
 
             TextDrawingFirst = TextGrayscale,
             TextDrawingLast = SolidLine,
@@ -87,6 +92,10 @@ namespace Microsoft::Console::Render::Atlas
             // appearance in the future, this should be changed to f32x2. But if you do so, please change
             // all other occurrences of i16x2 positions/offsets throughout the class to keep it consistent.
             alignas(u32) ShadingType shadingType;
+            // The log2 of the horizontal and vertical scale of the quad for DECDWL/DECDHL rows. For those, position,
+            // size and texcoord are all in screen pixels (texcoord being the atlas position << renditionShift),
+            // while the glyph in the atlas is unscaled. This avoids having to rasterize each glyph twice.
+            u8x2 renditionShift;
             alignas(u32) i16x2 position;
             alignas(u32) u16x2 size;
             alignas(u32) u16x2 texcoord;
@@ -139,7 +148,6 @@ namespace Microsoft::Console::Render::Atlas
         struct AtlasFontFaceKey
         {
             IDWriteFontFace2* fontFace;
-            LineRendition lineRendition;
         };
 
         struct AtlasFontFaceEntryInner
@@ -148,25 +156,23 @@ namespace Microsoft::Console::Render::Atlas
             // for the same font face variant as long as someone is holding a reference to the instance (see ActiveFaceCache).
             // This allows us to hash the value of the pointer as if it was uniquely identifying the font face variant.
             wil::com_ptr<IDWriteFontFace2> fontFace;
-            LineRendition lineRendition = LineRendition::SingleWidth;
 
             til::linear_flat_set<AtlasGlyphEntry> glyphs;
-            // boxGlyphs gets an increased growth rate of 2^2 = 4x, because presumably fonts either contain very
-            // few or almost all of the box glyphs. This reduces the cost of _initializeFontFaceEntry quite a bit.
-            til::linear_flat_set<u16, 2, 2> boxGlyphs;
+            // boxGlyphs is queried for every glyph that gets rasterized, but most of them aren't box glyphs.
+            // swiss_flat_set rejects such unsuccessful lookups mostly by looking at its control bytes alone.
+            til::swiss_flat_set<u16> boxGlyphs;
         };
 
         struct AtlasFontFaceEntry
         {
-            // This being a heap allocated allows us to insert into `glyphs` in `_splitDoubleHeightGlyph`
-            // (which might resize the hashmap!), while the caller `_drawText` is holding onto `glyphs`.
-            // If it wasn't heap allocated, all pointers into `linear_flat_set` would be invalidated.
+            // This being heap allocated keeps references to `glyphs` valid while `_glyphAtlasMap` grows,
+            // since the caller `_drawText` is holding onto `glyphs` while inserting new font faces.
             std::unique_ptr<AtlasFontFaceEntryInner> inner;
 
             bool operator==(const AtlasFontFaceKey& key) const noexcept
             {
                 const auto& i = *inner;
-                return i.fontFace.get() == key.fontFace && i.lineRendition == key.lineRendition;
+                return i.fontFace.get() == key.fontFace;
             }
 
             operator bool() const noexcept
@@ -179,12 +185,29 @@ namespace Microsoft::Console::Render::Atlas
                 inner = std::make_unique<AtlasFontFaceEntryInner>();
                 auto& i = *inner;
                 i.fontFace = key.fontFace;
-                i.lineRendition = key.lineRendition;
                 return *this;
             }
         };
 
     private:
+        struct GlyphAtlasPage
+        {
+            Buffer<stbrp_node> nodes;
+            stbrp_context packer{};
+            // The _glyphAtlasFrame during which a glyph on this page was last packed or drawn.
+            u64 lastUse = 0;
+        };
+
+        struct GlyphCacheEntry
+        {
+            u16 glyphIndex;
+            AtlasGlyphEntryData data;
+            // The premultiplied BGRA pixels of the glyph. Empty if it's whitespace (ShadingType::Default).
+            std::vector<u32> bitmap;
+        };
+
+        struct SharedGlyphCache;
+
         struct CursorRect
         {
             i16x2 position;
@@ -194,11 +217,18 @@ namespace Microsoft::Console::Render::Atlas
         };
 
         ATLAS_ATTR_COLD void _handleSettingsUpdate(const RenderingPayload& p);
+        void _handleSmoothScrollOffsetUpdate(const RenderingPayload& p);
         void _updateFontDependents(const RenderingPayload& p);
+        ATLAS_ATTR_COLD void _invalidateSoftFontGlyphs(const RenderingPayload& p);
         void _d2dRenderTargetUpdateFontSettings(const RenderingPayload& p) const noexcept;
         void _recreateCustomShader(const RenderingPayload& p);
         void _recreateCustomRenderTargetView(const RenderingPayload& p);
+        void _recreateRetainedRenderTargetView(const RenderingPayload& p);
+        void _beginRetainedFrame(RenderingPayload& p);
+        void _scrollRetainedFrame(const RenderingPayload& p) const;
+        void _endRetainedFrame(const RenderingPayload& p) const;
         void _recreateBackgroundColorBitmap(const RenderingPayload& p);
+        ATLAS_ATTR_COLD void _recreateImageTexture(const RenderingPayload& p);
         void _recreateConstBuffer(const RenderingPayload& p) const;
         void _setupDeviceContextState(const RenderingPayload& p);
         void _debugUpdateShaders(const RenderingPayload& p) noexcept;
@@ -207,22 +237,32 @@ namespace Microsoft::Console::Render::Atlas
         void _d2dBeginDrawing() noexcept;
         void _d2dEndDrawing();
         ATLAS_ATTR_COLD void _resetGlyphAtlas(const RenderingPayload& p);
+        u16x2 _computeGlyphAtlasSize(const RenderingPayload& p) const noexcept;
+        ATLAS_ATTR_COLD [[nodiscard]] bool _evictGlyphAtlasPage(const RenderingPayload& p, const AtlasGlyphEntry& pendingGlyphEntry);
         ATLAS_ATTR_COLD void _resizeGlyphAtlas(const RenderingPayload& p, u16 u, u16 v);
         QuadInstance& _getLastQuad() noexcept;
         QuadInstance& _appendQuad();
         ATLAS_ATTR_COLD void _bumpInstancesSize();
         void _flushQuads(const RenderingPayload& p);
+        static size_t _instanceBufferMinCapacity(const RenderingPayload& p) noexcept;
         ATLAS_ATTR_COLD void _recreateInstanceBuffers(const RenderingPayload& p);
         void _drawBackground(const RenderingPayload& p);
         void _uploadBackgroundBitmap(const RenderingPayload& p);
+        void _drawImages(const RenderingPayload& p);
+        void _uploadImageRow(const RenderingPayload& p, const ImageBitmap& bitmap, u16 y);
         void _drawText(RenderingPayload& p);
         ATLAS_ATTR_COLD void _drawTextOverlapSplit(const RenderingPayload& p, u16 y);
+        void _drawBuiltinGlyph(const RenderingPayload& p, u16 y, u32 x, f32 left);
         ATLAS_ATTR_COLD static void _initializeFontFaceEntry(AtlasFontFaceEntryInner& fontFaceEntry);
         ATLAS_ATTR_COLD [[nodiscard]] bool _drawGlyph(const RenderingPayload& p, const AtlasFontFaceEntryInner& fontFaceEntry, AtlasGlyphEntry& glyphEntry);
-        bool _drawSoftFontGlyph(const RenderingPayload& p, const AtlasFontFaceEntryInner& fontFaceEntry, AtlasGlyphEntry& glyphEntry);
-        void _drawGlyphPrepareRetry(const RenderingPayload& p);
-        void _splitDoubleHeightGlyph(const RenderingPayload& p, const AtlasFontFaceEntryInner& fontFaceEntry, AtlasGlyphEntry& glyphEntry);
+        bool _drawSoftFontGlyph(const RenderingPayload& p, AtlasGlyphEntry& glyphEntry);
+        [[nodiscard]] bool _packGlyphRect(stbrp_rect& rect) noexcept;
+        ATLAS_ATTR_COLD void _loadGlyphCache(const RenderingPayload& p) noexcept;
+        ATLAS_ATTR_COLD void _saveGlyphCache(const RenderingPayload& p) noexcept;
+        ATLAS_ATTR_COLD void _uploadCachedGlyphs(const RenderingPayload& p, AtlasFontFaceEntryInner& fontFaceEntry);
+        void _drawGlyphPrepareRetry(const RenderingPayload& p, const AtlasGlyphEntry& pendingGlyphEntry);
         void _drawGridlines(const RenderingPayload& p, u16 y);
+        void _drawSearchHighlights(const RenderingPayload& p);
         void _drawCursorBackground(const RenderingPayload& p);
         ATLAS_ATTR_COLD void _drawCursorForeground();
         ATLAS_ATTR_COLD size_t _drawCursorForegroundSlowPath(const CursorRect& c, size_t offset);
@@ -240,6 +280,10 @@ namespace Microsoft::Console::Render::Atlas
         wil::com_ptr<ID3D11Buffer> _indexBuffer;
         wil::com_ptr<ID3D11Buffer> _instanceBuffer;
         size_t _instanceBufferCapacity = 0;
+        // The position in _instanceBuffer at which the next _flushQuads() will write its instances.
+        size_t _instanceBufferOffset = 0;
+        size_t _instancesThisFrame = 0;
+        size_t _instanceHighWaterMark = 0;
         Buffer<QuadInstance, 32> _instances;
         size_t _instancesCount = 0;
 
@@ -251,16 +295,56 @@ namespace Microsoft::Console::Render::Atlas
         wil::com_ptr<ID3D11Buffer> _customShaderConstantBuffer;
         wil::com_ptr<ID3D11SamplerState> _customShaderSamplerState;
         std::chrono::steady_clock::time_point _customShaderStartTime;
+        // The time in milliseconds between two frames of a custom shader that uses the time. 0 if there's no limit.
+        DWORD _customShaderFrameInterval = 0;
+
+        // Unless a custom shader is active, we draw into this offscreen texture and copy it into the swap chain,
+        // because its contents are retained across frames, unlike those of the swap chain's buffers.
+        // This allows us to only draw the parts of the frame that are dirty and to implement scrolling
+        // by moving the texture's contents, instead of drawing all rows again.
+        // With a custom shader, the _customOffscreenTexture is retained the same way instead.
+        wil::com_ptr<ID3D11RenderTargetView> _retainedRenderTargetView;
+        wil::com_ptr<ID3D11Texture2D> _retainedTexture;
+        wil::com_ptr<ID3D11RasterizerState> _scissorRasterizerState;
+        bool _retainedTextureValid = false;
+        // The vertical range of pixels that is drawn this frame. Rows outside of it are skipped by _drawText().
+        til::CoordType _drawTop = til::CoordTypeMin;
+        til::CoordType _drawBottom = til::CoordTypeMax;
+        // The horizontal range. It only differs from the full width if no rows were invalidated,
+        // for instance when the cursor blinks or moves, which makes the cursor a pure overlay.
+        til::CoordType _drawLeft = til::CoordTypeMin;
+        til::CoordType _drawRight = til::CoordTypeMax;
 
         wil::com_ptr<ID3D11Texture2D> _backgroundBitmap;
         wil::com_ptr<ID3D11ShaderResourceView> _backgroundBitmapView;
         til::generation_t _backgroundBitmapGeneration;
 
+        // Holds the image slices of the visible rows, scaled to the cell size, at the position of their row.
+        // It's only created once a row contains an image. _imageTextureRevisions stores the ImageBitmap::revision
+        // each of its rows holds, so that only rows that changed or scrolled into a new position get uploaded.
+        wil::com_ptr<ID3D11Texture2D> _imageTexture;
+        wil::com_ptr<ID3D11ShaderResourceView> _imageTextureView;
+        std::vector<u64> _imageTextureRevisions;
+        std::vector<u32> _imageScratch;
+
         wil::com_ptr<ID3D11Texture2D> _glyphAtlas;
         wil::com_ptr<ID3D11ShaderResourceView> _glyphAtlasView;
         til::linear_flat_set<AtlasFontFaceEntry> _glyphAtlasMap;
-        Buffer<stbrp_node> _rectPackerData;
-        stbrp_context _rectPacker{};
+        // The glyph atlas is split into horizontal pages of equal height, each with its own rect packer.
+        // Once the atlas can't grow any further, running out of space only evicts the least recently used page.
+        std::array<GlyphAtlasPage, 4> _glyphAtlasPages;
+        u16x2 _glyphAtlasSize{};
+        u16 _glyphAtlasPageCount = 0;
+        // The page of a glyph is its texcoord.y >> _glyphAtlasPageShift, since the page height is a power of 2.
+        u16 _glyphAtlasPageShift = 0;
+        // Incremented by every _drawText() call, starting at 1. A lastUse of 0 marks an empty page.
+        u64 _glyphAtlasFrame = 0;
+
+        // The glyph cache for the current font settings, shared with all other BackendD3D instances in this process.
+        std::shared_ptr<SharedGlyphCache> _glyphCache;
+        // Once the first few seconds with a new font have passed, the most commonly used glyphs have
+        // been drawn and we write them back into the cache, if any got added. This is only done once.
+        std::chrono::steady_clock::time_point _glyphCacheSaveTime = std::chrono::steady_clock::time_point::max();
         til::CoordType _ligatureOverhangTriggerLeft = 0;
         til::CoordType _ligatureOverhangTriggerRight = 0;
 
@@ -269,6 +353,9 @@ namespace Microsoft::Console::Render::Atlas
         wil::com_ptr<ID2D1SolidColorBrush> _emojiBrush;
         wil::com_ptr<ID2D1SolidColorBrush> _brush;
         wil::com_ptr<ID2D1Bitmap1> _softFontBitmap;
+        // The soft font that the cached soft font glyphs were rasterized from.
+        std::vector<u16> _softFontPattern;
+        til::size _softFontCellSize;
         bool _d2dBeganDrawing = false;
         bool _fontChangedResetGlyphAtlas = false;
 
@@ -279,9 +366,11 @@ namespace Microsoft::Console::Render::Atlas
 
         til::generation_t _generation;
         til::generation_t _fontGeneration;
+        til::generation_t _softFontGeneration;
         til::generation_t _miscGeneration;
         u16x2 _targetSize{};
         u16x2 _cellCount{};
+        i32 _smoothScrollOffset = 0;
         ShadingType _textShadingType = ShadingType::Default;
 
         // An empty-box cursor spanning a wide glyph that has different
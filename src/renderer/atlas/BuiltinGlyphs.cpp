@@ -0,0 +1,351 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "BuiltinGlyphs.h"
+
+#pragma warning(disable : 26446) // Prefer to use gsl::at() instead of unchecked subscript operator (bounds.4).
+#pragma warning(disable : 26482) // Only index into arrays using constant expressions (bounds.2).
+
+using namespace Microsoft::Console::Render::Atlas;
+
+namespace
+{
+    // The weights of the 4 lines ("arms") that extend from the center of a box drawing character to its edges.
+    constexpr u8 N = 0; // none
+    constexpr u8 L = 1; // light
+    constexpr u8 H = 2; // heavy
+    constexpr u8 D = 3; // double
+
+    constexpr u8 arms(u8 left, u8 up, u8 right, u8 down) noexcept
+    {
+        return static_cast<u8>(left | up << 2 | right << 4 | down << 6);
+    }
+
+    // The arms of U+2500-257F. The dashed lines, arcs and diagonals aren't made of arms and are 0.
+    constexpr u8 boxDrawingArms[128]{
+        /* 2500 */ arms(L, N, L, N), arms(H, N, H, N), arms(N, L, N, L), arms(N, H, N, H), 0, 0, 0, 0,
+        /* 2508 */ 0, 0, 0, 0, arms(N, N, L, L), arms(N, N, H, L), arms(N, N, L, H), arms(N, N, H, H),
+        /* 2510 */ arms(L, N, N, L), arms(H, N, N, L), arms(L, N, N, H), arms(H, N, N, H), arms(N, L, L, N), arms(N, L, H, N), arms(N, H, L, N), arms(N, H, H, N),
+        /* 2518 */ arms(L, L, N, N), arms(H, L, N, N), arms(L, H, N, N), arms(H, H, N, N), arms(N, L, L, L), arms(N, L, H, L), arms(N, H, L, L), arms(N, L, L, H),
+        /* 2520 */ arms(N, H, L, H), arms(N, H, H, L), arms(N, L, H, H), arms(N, H, H, H), arms(L, L, N, L), arms(H, L, N, L), arms(L, H, N, L), arms(L, L, N, H),
+        /* 2528 */ arms(L, H, N, H), arms(H, H, N, L), arms(H, L, N, H), arms(H, H, N, H), arms(L, N, L, L), arms(H, N, L, L), arms(L, N, H, L), arms(H, N, H, L),
+        /* 2530 */ arms(L, N, L, H), arms(H, N, L, H), arms(L, N, H, H), arms(H, N, H, H), arms(L, L, L, N), arms(H, L, L, N), arms(L, L, H, N), arms(H, L, H, N),
+        /* 2538 */ arms(L, H, L, N), arms(H, H, L, N), arms(L, H, H, N), arms(H, H, H, N), arms(L, L, L, L), arms(H, L, L, L), arms(L, L, H, L), arms(H, L, H, L),
+        /* 2540 */ arms(L, H, L, L), arms(L, L, L, H), arms(L, H, L, H), arms(H, H, L, L), arms(L, H, H, L), arms(H, L, L, H), arms(L, L, H, H), arms(H, H, H, L),
+        /* 2548 */ arms(H, L, H, H), arms(H, H, L, H), arms(L, H, H, H), arms(H, H, H, H), 0, 0, 0, 0,
+        /* 2550 */ arms(D, N, D, N), arms(N, D, N, D), arms(N, N, D, L), arms(N, N, L, D), arms(N, N, D, D), arms(D, N, N, L), arms(L, N, N, D), arms(D, N, N, D),
+        /* 2558 */ arms(N, L, D, N), arms(N, D, L, N), arms(N, D, D, N), arms(D, L, N, N), arms(L, D, N, N), arms(D, D, N, N), arms(N, L, D, L), arms(N, D, L, D),
+        /* 2560 */ arms(N, D, D, D), arms(D, L, N, L), arms(L, D, N, D), arms(D, D, N, D), arms(D, N, D, L), arms(L, N, L, D), arms(D, N, D, D), arms(D, L, D, N),
+        /* 2568 */ arms(L, D, L, N), arms(D, D, D, N), arms(D, L, D, L), arms(L, D, L, D), arms(D, D, D, D), 0, 0, 0,
+        /* 2570 */ 0, 0, 0, 0, arms(L, N, N, N), arms(N, L, N, N), arms(N, N, L, N), arms(N, N, N, L),
+        /* 2578 */ arms(H, N, N, N), arms(N, H, N, N), arms(N, N, H, N), arms(N, N, N, H), arms(L, N, H, N), arms(N, L, N, H), arms(H, N, L, N), arms(N, H, N, L),
+    };
+
+    class RectBuilder
+    {
+    public:
+        RectBuilder(const std::span<BuiltinGlyphs::Rect, BuiltinGlyphs::MaxRectCount> rects, const i32 width, const i32 height) noexcept :
+            _rects{ rects },
+            _width{ width },
+            _height{ height }
+        {
+        }
+
+        void Add(i32 left, i32 top, i32 right, i32 bottom, const u8 alpha = 255) noexcept
+        {
+            left = std::clamp(left, 0, _width);
+            top = std::clamp(top, 0, _height);
+            right = std::clamp(right, 0, _width);
+            bottom = std::clamp(bottom, 0, _height);
+
+            if (left < right && top < bottom && _count < _rects.size())
+            {
+                _rects[_count++] = {
+                    static_cast<i16>(left),
+                    static_cast<i16>(top),
+                    static_cast<i16>(right),
+                    static_cast<i16>(bottom),
+                    alpha,
+                };
+            }
+        }
+
+        size_t Count() const noexcept
+        {
+            return _count;
+        }
+
+    private:
+        std::span<BuiltinGlyphs::Rect, BuiltinGlyphs::MaxRectCount> _rects;
+        i32 _width;
+        i32 _height;
+        size_t _count = 0;
+    };
+
+    // The extent of a line (or pair of lines, if it's a double line) across its direction.
+    // For single lines the "near" and "far" lines are identical.
+    struct Stroke
+    {
+        i32 near0;
+        i32 near1;
+        i32 far0;
+        i32 far1;
+    };
+
+    // Centers a stroke of the given weight in a cell dimension of the given size.
+    Stroke centerStroke(const i32 size, const u8 weight, const i32 light) noexcept
+    {
+        if (weight == D)
+        {
+            const auto beg = (size - 3 * light) / 2;
+            return { beg, beg + light, beg + 2 * light, beg + 3 * light };
+        }
+
+        const auto thickness = weight == H ? 2 * light : light;
+        const auto beg = (size - thickness) / 2;
+        return { beg, beg + thickness, beg, beg + thickness };
+    }
+
+    // Box drawing lines are drawn arm by arm. Each arm extends from the edge of the cell to the lines
+    // perpendicular to it, such that corners are closed, crossings are continuous and double lines leave
+    // a gap wherever the lines of another arm pass through. Without perpendicular lines they meet at the center.
+    void drawArms(RectBuilder& b, const u8 armWeights, const i32 width, const i32 height, const i32 light) noexcept
+    {
+        const u8 left = armWeights & 3;
+        const u8 up = armWeights >> 2 & 3;
+        const u8 right = armWeights >> 4 & 3;
+        const u8 down = armWeights >> 6 & 3;
+
+        const auto horizontal = left || right;
+        const auto vertical = up || down;
+        // The lines in the middle of the cell, made up of the widest horizontal and vertical arms respectively.
+        const auto h = centerStroke(height, std::max(left, right), light);
+        const auto v = centerStroke(width, std::max(up, down), light);
+
+        if (left)
+        {
+            const auto own = centerStroke(height, left, light);
+            if (left == D)
+            {
+                b.Add(0, own.near0, vertical ? (up ? v.near1 : v.far1) : width / 2, own.near1);
+                b.Add(0, own.far0, vertical ? (down ? v.near1 : v.far1) : width / 2, own.far1);
+            }
+            else
+            {
+                const auto end = vertical ? (right || !(up && down) ? v.far1 : v.near1) : centerStroke(width, left, light).far1;
+                b.Add(0, own.near0, end, own.near1);
+            }
+        }
+
+        if (right)
+        {
+            const auto own = centerStroke(height, right, light);
+            if (right == D)
+            {
+                b.Add(vertical ? (up ? v.far0 : v.near0) : width / 2, own.near0, width, own.near1);
+                b.Add(vertical ? (down ? v.far0 : v.near0) : width / 2, own.far0, width, own.far1);
+            }
+            else
+            {
+                const auto beg = vertical ? (left || !(up && down) ? v.near0 : v.far0) : centerStroke(width, right, light).near0;
+                b.Add(beg, own.near0, width, own.near1);
+            }
+        }
+
+        if (up)
+        {
+            const auto own = centerStroke(width, up, light);
+            if (up == D)
+            {
+                b.Add(own.near0, 0, own.near1, horizontal ? (left ? h.near1 : h.far1) : height / 2);
+                b.Add(own.far0, 0, own.far1, horizontal ? (right ? h.near1 : h.far1) : height / 2);
+            }
+            else
+            {
+                const auto end = horizontal ? (down || !(left && right) ? h.far1 : h.near1) : centerStroke(height, up, light).far1;
+                b.Add(own.near0, 0, own.near1, end);
+            }
+        }
+
+        if (down)
+        {
+            const auto own = centerStroke(width, down, light);
+            if (down == D)
+            {
+                b.Add(own.near0, horizontal ? (left ? h.far0 : h.near0) : height / 2, own.near1, height);
+                b.Add(own.far0, horizontal ? (right ? h.far0 : h.near0) : height / 2, own.far1, height);
+            }
+            else
+            {
+                const auto beg = horizontal ? (up || !(left && right) ? h.near0 : h.far0) : centerStroke(height, down, light).near0;
+                b.Add(own.near0, beg, own.near1, height);
+            }
+        }
+    }
+
+    // The dashed lines U+2504-250B and U+254C-254F are split into the given number of segments.
+    void drawDashes(RectBuilder& b, const bool isVertical, const u8 weight, const i32 segments, const i32 width, const i32 height, const i32 light) noexcept
+    {
+        const auto length = isVertical ? height : width;
+        const auto stroke = centerStroke(isVertical ? width : height, weight, light);
+
+        for (i32 i = 0; i < segments; ++i)
+        {
+            const auto beg = i * length / segments;
+            const auto end = (i + 1) * length / segments;
+            const auto gap = std::max(1, (end - beg) / 3);
+            const auto dashBeg = beg + gap / 2;
+            const auto dashEnd = end - (gap - gap / 2);
+
+            if (isVertical)
+            {
+                b.Add(stroke.near0, dashBeg, stroke.near1, dashEnd);
+            }
+            else
+            {
+                b.Add(dashBeg, stroke.near0, dashEnd, stroke.near1);
+            }
+        }
+    }
+
+    // U+2580-259F
+    void drawBlockElement(RectBuilder& b, const u32 codepoint, const i32 width, const i32 height) noexcept
+    {
+        // Rounds the given number of eighths of the cell's width or height to whole pixels.
+        const auto eighthsX = [=](i32 n) noexcept { return (width * n + 4) / 8; };
+        const auto eighthsY = [=](i32 n) noexcept { return (height * n + 4) / 8; };
+        const auto halfX = eighthsX(4);
+        const auto halfY = eighthsY(4);
+
+        switch (codepoint)
+        {
+        case 0x2580: // ▀
+            b.Add(0, 0, width, halfY);
+            return;
+        case 0x2590: // ▐
+            b.Add(halfX, 0, width, height);
+            return;
+        case 0x2591: // ░
+        case 0x2592: // ▒
+        case 0x2593: // ▓
+            b.Add(0, 0, width, height, static_cast<u8>((codepoint - 0x2590) * 64 - 1));
+            return;
+        case 0x2594: // ▔
+            b.Add(0, 0, width, eighthsY(1));
+            return;
+        case 0x2595: // ▕
+            b.Add(width - eighthsX(1), 0, width, height);
+            return;
+        default:
+            break;
+        }
+
+        if (codepoint <= 0x2588)
+        {
+            // U+2581-2588: ▁▂▃▄▅▆▇█
+            b.Add(0, height - eighthsY(gsl::narrow_cast<i32>(codepoint - 0x2580)), width, height);
+        }
+        else if (codepoint <= 0x258F)
+        {
+            // U+2589-258F: ▉▊▋▌▍▎▏
+            b.Add(0, 0, eighthsX(gsl::narrow_cast<i32>(0x2590 - codepoint)), height);
+        }
+        else
+        {
+            // U+2596-259F: ▖▗▘▙▚▛▜▝▞▟
+            // The quadrants are a bitmask of: 1 = upper left, 2 = upper right, 4 = lower left, 8 = lower right.
+            static constexpr u8 quadrants[]{ 4, 8, 1, 13, 9, 7, 11, 2, 6, 14 };
+            const auto q = quadrants[codepoint - 0x2596];
+            if (q & 1)
+            {
+                b.Add(0, 0, halfX, halfY);
+            }
+            if (q & 2)
+            {
+                b.Add(halfX, 0, width, halfY);
+            }
+            if (q & 4)
+            {
+                b.Add(0, halfY, halfX, height);
+            }
+            if (q & 8)
+            {
+                b.Add(halfX, halfY, width, height);
+            }
+        }
+    }
+
+    // U+2800-28FF. The lower 8 bits of the codepoint are the 8 dots in a 2x4 grid. Bit 0-2 are the first
+    // 3 rows of the left column, bit 3-5 those of the right column and bit 6-7 the bottom row.
+    void drawBraille(RectBuilder& b, const u32 codepoint, const i32 width, const i32 height) noexcept
+    {
+        static constexpr u8 dotColumns[8]{ 0, 0, 0, 1, 1, 1, 0, 1 };
+        static constexpr u8 dotRows[8]{ 0, 1, 2, 0, 1, 2, 3, 3 };
+
+        const auto size = std::max(1, std::min(width / 2, height / 4) / 2);
+
+        for (u32 i = 0; i < 8; ++i)
+        {
+            if (codepoint & (1u << i))
+            {
+                const auto centerX = (2 * dotColumns[i] + 1) * width / 4;
+                const auto centerY = (2 * dotRows[i] + 1) * height / 8;
+                const auto left = centerX - size / 2;
+                const auto top = centerY - size / 2;
+                b.Add(left, top, left + size, top + size);
+            }
+        }
+    }
+}
+
+bool BuiltinGlyphs::IsBuiltinGlyph(const u32 codepoint) noexcept
+{
+    if (codepoint >= 0x2500 && codepoint <= 0x259F)
+    {
+        // The arcs ╭╮╯╰ and the diagonals ╱╲╳ can't be drawn with rectangles.
+        return codepoint < 0x256D || codepoint > 0x2573;
+    }
+    return codepoint >= 0x2800 && codepoint <= 0x28FF;
+}
+
+// Fills `rects` with the rectangles that make up the given glyph in a cell of the given size, and returns
+// their number. `lineWidth` is the width of light box drawing lines. Heavy lines are twice as wide.
+// Returns 0 if the glyph isn't a builtin one (or if it's blank, like U+2800).
+size_t BuiltinGlyphs::GetRects(const u32 codepoint, const i32 width, const i32 height, const i32 lineWidth, const std::span<Rect, MaxRectCount> rects) noexcept
+{
+    RectBuilder b{ rects, width, height };
+    const auto light = std::max(1, lineWidth);
+
+    if (!IsBuiltinGlyph(codepoint))
+    {
+        return 0;
+    }
+
+    if (codepoint >= 0x2800)
+    {
+        drawBraille(b, codepoint, width, height);
+    }
+    else if (codepoint >= 0x2580)
+    {
+        drawBlockElement(b, codepoint, width, height);
+    }
+    else if (const auto a = boxDrawingArms[codepoint - 0x2500])
+    {
+        drawArms(b, a, width, height, light);
+    }
+    else if (codepoint >= 0x254C)
+    {
+        // U+254C-254F: ╌╍╎╏
+        const auto i = codepoint - 0x254C;
+        drawDashes(b, i >= 2, (i & 1) ? H : L, 2, width, height, light);
+    }
+    else
+    {
+        // U+2504-250B: ┄┅┆┇┈┉┊┋
+        const auto i = codepoint - 0x2504;
+        drawDashes(b, (i & 2) != 0, (i & 1) ? H : L, i >= 4 ? 4 : 3, width, height, light);
+    }
+
+    return b.Count();
+}
@@ -0,0 +1,34 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "common.h"
+
+// Box drawing characters (U+2500-257F), block elements (U+2580-259F) and braille patterns (U+2800-28FF)
+// are meant to seamlessly connect with their neighbors, which the glyphs of most fonts fail to do at least
+// at some font sizes, because they're designed for a specific cell size and get rasterized with antialiasing.
+// The backends draw them as a handful of pixel-aligned rectangles instead, without DirectWrite, without
+// shaping and without taking up any space in the glyph atlas. The few characters that are curved or
+// diagonal (like U+256D or U+2571) are left to the font.
+//
+// Like soft font glyphs, AtlasEngine maps them to a null font face, with the codepoint as the glyph index.
+namespace Microsoft::Console::Render::Atlas::BuiltinGlyphs
+{
+    // A rectangle in pixels, relative to the top-left corner of the glyph's cell.
+    struct Rect
+    {
+        i16 left;
+        i16 top;
+        i16 right;
+        i16 bottom;
+        // The opacity of the rectangle. Only the shades (U+2591-2593) are drawn translucently.
+        u8 alpha;
+    };
+
+    // The number of rectangles of the most complex glyphs, like U+256C or U+28FF.
+    inline constexpr size_t MaxRectCount = 8;
+
+    bool IsBuiltinGlyph(u32 codepoint) noexcept;
+    size_t GetRects(u32 codepoint, i32 width, i32 height, i32 lineWidth, std::span<Rect, MaxRectCount> rects) noexcept;
+}
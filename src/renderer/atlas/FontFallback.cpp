@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "FontFallback.h"
+
+#include "DWriteTextAnalysis.h"
+
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26482) // Only index into arrays using constant expressions (bounds.2).
+
+using namespace Microsoft::Console::Render::Atlas;
+
+bool FontFallback::Settings::operator==(const Settings& other) const noexcept
+{
+    if (systemFontFallback != other.systemFontFallback ||
+        systemFontFallback1 != other.systemFontFallback1 ||
+        fontCollection != other.fontCollection ||
+        fontWeight != other.fontWeight ||
+        fontName != other.fontName ||
+        localeName != other.localeName)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < fontAxes.size(); ++i)
+    {
+        const auto& a = fontAxes[i];
+        const auto& b = other.fontAxes[i];
+        if (a.size() != b.size() || memcmp(a.data(), b.data(), a.size() * sizeof(DWRITE_FONT_AXIS_VALUE)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<FontFallback> FontFallback::Get(Settings&& settings)
+{
+    static til::shared_mutex<std::vector<std::weak_ptr<FontFallback>>> instances;
+
+    const auto guard = instances.lock();
+
+    std::erase_if(*guard, [](const auto& weak) { return weak.expired(); });
+
+    for (const auto& weak : *guard)
+    {
+        if (auto instance = weak.lock(); instance && instance->_settings == settings)
+        {
+            return instance;
+        }
+    }
+
+    auto instance = std::make_shared<FontFallback>(std::move(settings));
+    guard->emplace_back(instance);
+    return instance;
+}
+
+FontFallback::FontFallback(Settings&& settings) :
+    _settings{ std::move(settings) }
+{
+    wil::com_ptr<IDWriteFontFamily> fontFamily;
+    UINT32 index = 0;
+    BOOL exists = FALSE;
+
+    if (FAILED(_settings.fontCollection->FindFamilyName(_settings.fontName.c_str(), &index, &exists)) ||
+        !exists ||
+        FAILED(_settings.fontCollection->GetFontFamily(index, fontFamily.addressof())))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < _primaryFonts.size(); ++i)
+    {
+        const auto attributes = static_cast<FontRelevantAttributes>(i);
+        const auto weight = WI_IsFlagSet(attributes, FontRelevantAttributes::Bold) ? DWRITE_FONT_WEIGHT_BOLD : static_cast<DWRITE_FONT_WEIGHT>(_settings.fontWeight);
+        const auto style = WI_IsFlagSet(attributes, FontRelevantAttributes::Italic) ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
+
+        if (FAILED_LOG(fontFamily->GetFirstMatchingFont(weight, DWRITE_FONT_STRETCH_NORMAL, style, _primaryFonts[i].addressof())))
+        {
+            _primaryFonts = {};
+            return;
+        }
+    }
+}
+
+void FontFallback::MapCharacters(const wchar_t* text, const u32 textLength, const FontRelevantAttributes attributes, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const
+{
+    TextAnalysisSource analysisSource{ _settings.localeName.c_str(), text, textLength };
+    const auto& fontAxes = _settings.fontAxes[static_cast<size_t>(attributes)];
+
+    // We don't read from scale anyways.
+#pragma warning(suppress : 26494) // Variable 'scale' is uninitialized. Always initialize an object (type.5).
+    f32 scale;
+
+    if (!fontAxes.empty())
+    {
+        THROW_IF_FAILED(_settings.systemFontFallback1->MapCharacters(
+            /* analysisSource     */ &analysisSource,
+            /* textPosition       */ 0,
+            /* textLength         */ textLength,
+            /* baseFontCollection */ _settings.fontCollection.get(),
+            /* baseFamilyName     */ _settings.fontName.c_str(),
+            /* fontAxisValues     */ fontAxes.data(),
+            /* fontAxisValueCount */ gsl::narrow_cast<u32>(fontAxes.size()),
+            /* mappedLength       */ mappedLength,
+            /* scale              */ &scale,
+            /* mappedFontFace     */ reinterpret_cast<IDWriteFontFace5**>(mappedFontFace)));
+    }
+    else
+    {
+        const auto baseWeight = WI_IsFlagSet(attributes, FontRelevantAttributes::Bold) ? DWRITE_FONT_WEIGHT_BOLD : static_cast<DWRITE_FONT_WEIGHT>(_settings.fontWeight);
+        const auto baseStyle = WI_IsFlagSet(attributes, FontRelevantAttributes::Italic) ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
+        wil::com_ptr<IDWriteFont> font;
+
+        THROW_IF_FAILED(_settings.systemFontFallback->MapCharacters(
+            /* analysisSource     */ &analysisSource,
+            /* textPosition       */ 0,
+            /* textLength         */ textLength,
+            /* baseFontCollection */ _settings.fontCollection.get(),
+            /* baseFamilyName     */ _settings.fontName.c_str(),
+            /* baseWeight         */ baseWeight,
+            /* baseStyle          */ baseStyle,
+            /* baseStretch        */ DWRITE_FONT_STRETCH_NORMAL,
+            /* mappedLength       */ mappedLength,
+            /* mappedFont         */ font.addressof(),
+            /* scale              */ &scale));
+
+        if (font)
+        {
+            THROW_IF_FAILED(font->CreateFontFace(reinterpret_cast<IDWriteFontFace**>(mappedFontFace)));
+        }
+    }
+
+    // Oh wow! You found a case where scale isn't 1! I tried every font and none
+    // returned something besides 1. I just couldn't figure out why this exists.
+    assert(scale == 1);
+}
+
+// Returns the length of the longest prefix of the given text whose characters are either all resolved
+// (*pending = false) and can be passed to MapCharacters() right away, or all unresolved (*pending = true).
+// The lookup of unresolved characters is queued and Generation() changes once it's finished.
+u32 FontFallback::Resolve(const wchar_t* text, const u32 textLength, const FontRelevantAttributes attributes, bool* pending)
+{
+    *pending = false;
+
+    const auto& primaryFont = _primaryFonts[static_cast<size_t>(attributes)];
+    if (!primaryFont)
+    {
+        return textLength;
+    }
+
+    std::vector<u32> keys;
+    u32 length = 0;
+
+    {
+        const auto guard = _state.lock();
+
+        while (length < textLength)
+        {
+            u32 codepoint = text[length];
+            u32 advance = 1;
+
+            if (til::is_leading_surrogate(text[length]) && length + 1 < textLength && til::is_trailing_surrogate(text[length + 1]))
+            {
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (text[length + 1] - 0xDC00);
+                advance = 2;
+            }
+
+            const auto key = codepoint | static_cast<u32>(attributes) << 24;
+            BOOL exists = FALSE;
+            const auto resolved = (SUCCEEDED(primaryFont->HasCharacter(codepoint, &exists)) && exists) || guard->resolved.contains(key);
+
+            if (length == 0)
+            {
+                *pending = !resolved;
+            }
+            else if (*pending == resolved)
+            {
+                break;
+            }
+
+            if (!resolved && guard->pending.emplace(key).second)
+            {
+                keys.emplace_back(key);
+            }
+
+            length += advance;
+        }
+    }
+
+    if (!keys.empty())
+    {
+        auto work = std::make_unique<Work>(shared_from_this(), std::move(keys));
+        if (TrySubmitThreadpoolCallback(&_resolveCallback, work.get(), nullptr))
+        {
+            work.release();
+        }
+        else
+        {
+            _resolve(work->keys);
+        }
+    }
+
+    return length;
+}
+
+u32 FontFallback::Generation() const noexcept
+{
+    return _generation.load(std::memory_order_acquire);
+}
+
+void CALLBACK FontFallback::_resolveCallback(PTP_CALLBACK_INSTANCE, void* context) noexcept
+{
+    const std::unique_ptr<Work> work{ static_cast<Work*>(context) };
+    work->self->_resolve(work->keys);
+}
+
+void FontFallback::_resolve(const std::vector<u32>& keys) noexcept
+{
+    for (const auto key : keys)
+    {
+        const auto codepoint = key & 0xffffff;
+        const auto attributes = static_cast<FontRelevantAttributes>(key >> 24);
+        wil::com_ptr<IDWriteFontFace2> fontFace;
+
+        try
+        {
+            wchar_t text[2];
+            u32 textLength = 1;
+
+            if (codepoint >= 0x10000)
+            {
+                text[0] = static_cast<wchar_t>(0xD800 + ((codepoint - 0x10000) >> 10));
+                text[1] = static_cast<wchar_t>(0xDC00 + ((codepoint - 0x10000) & 0x3ff));
+                textLength = 2;
+            }
+            else
+            {
+                text[0] = static_cast<wchar_t>(codepoint);
+            }
+
+            u32 mappedLength = 0;
+            MapCharacters(&text[0], textLength, attributes, &mappedLength, fontFace.put());
+        }
+        CATCH_LOG();
+
+        // Failed lookups are marked as resolved as well. MapCharacters() will fail for them
+        // synchronously then, which is no worse than before and doesn't keep them pending forever.
+        const auto guard = _state.lock();
+        guard->resolved.insert_or_assign(key, std::move(fontFace));
+        guard->pending.erase(key);
+    }
+
+    _generation.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <til/mutex.h>
+
+#include "common.h"
+
+namespace Microsoft::Console::Render::Atlas
+{
+    // Wraps IDWriteFontFallback::MapCharacters() for a specific set of font settings.
+    //
+    // The first time MapCharacters() picks a fallback font for a codepoint, DirectWrite may have to load
+    // the font's files, which can stall a frame for tens of milliseconds. Resolve() avoids this by telling
+    // the caller which characters can be mapped right away, because they're either part of the primary font
+    // or have been looked up before. The others are looked up on the thread pool in the meantime.
+    //
+    // Instances are shared between all AtlasEngine instances in this process with the same font settings,
+    // so that opening another tab doesn't need to look up the same codepoints again.
+    struct FontFallback : std::enable_shared_from_this<FontFallback>
+    {
+        struct Settings
+        {
+            wil::com_ptr<IDWriteFontFallback> systemFontFallback;
+            wil::com_ptr<IDWriteFontFallback1> systemFontFallback1; // optional, might be nullptr
+            wil::com_ptr<IDWriteFontCollection> fontCollection;
+            std::wstring fontName;
+            std::wstring localeName;
+            // Indexed by FontRelevantAttributes. Empty if the font has no axes.
+            std::array<std::vector<DWRITE_FONT_AXIS_VALUE>, 4> fontAxes;
+            u16 fontWeight = 0;
+
+            bool operator==(const Settings& other) const noexcept;
+        };
+
+        static std::shared_ptr<FontFallback> Get(Settings&& settings);
+
+        explicit FontFallback(Settings&& settings);
+
+        void MapCharacters(const wchar_t* text, u32 textLength, FontRelevantAttributes attributes, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const;
+        u32 Resolve(const wchar_t* text, u32 textLength, FontRelevantAttributes attributes, bool* pending);
+        // Changes whenever a lookup queued by Resolve() finished.
+        u32 Generation() const noexcept;
+
+    private:
+        struct State
+        {
+            // The keys are made of the codepoint and the FontRelevantAttributes in the upper 8 bits.
+            // The faces are kept around, because they keep their font files loaded as well.
+            std::unordered_map<u32, wil::com_ptr<IDWriteFontFace2>> resolved;
+            std::unordered_set<u32> pending;
+        };
+
+        struct Work
+        {
+            std::shared_ptr<FontFallback> self;
+            std::vector<u32> keys;
+        };
+
+        static void CALLBACK _resolveCallback(PTP_CALLBACK_INSTANCE instance, void* context) noexcept;
+        void _resolve(const std::vector<u32>& keys) noexcept;
+
+        Settings _settings;
+        // Used to check whether a codepoint is part of the primary font, in which case MapCharacters()
+        // is fast. Empty if the primary font couldn't be found, which disables the asynchronous lookups.
+        std::array<wil::com_ptr<IDWriteFont>, 4> _primaryFonts;
+        til::shared_mutex<State> _state;
+        std::atomic<u32> _generation{ 0 };
+    };
+}
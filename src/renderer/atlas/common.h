@@ -125,6 +125,7 @@ namespace Microsoft::Console::Render::Atlas
     };
 
     using u8 = uint8_t;
+    using u8x2 = vec2<u8>;
 
     using u16 = uint16_t;
     using u16x2 = vec2<u16>;
@@ -145,11 +146,15 @@ namespace Microsoft::Console::Render::Atlas
     using i32x4 = vec4<i32>;
     using i32r = rect<i32>;
 
+    using u64 = uint64_t;
+
     using f32 = float;
     using f32x2 = vec2<f32>;
     using f32x4 = vec4<f32>;
     using f32r = rect<f32>;
 
+    using f64 = double;
+
     // I wrote `Buffer` instead of using `std::vector`, because I want to convey that these things
     // explicitly _don't_ hold resizeable contents, but rather plain content of a fixed size.
     // For instance I didn't want a resizeable vector with a `push_back` method for my fixed-size
@@ -207,6 +212,18 @@ namespace Microsoft::Console::Render::Atlas
             return _data != nullptr;
         }
 
+        // Ensures that the buffer holds at least `min_size` items. The buffer is reallocated if it's too small,
+        // in which case its previous contents are lost and the new items are default-initialized (that is,
+        // uninitialized for trivial types), because all callers overwrite the buffer anyways.
+        // It grows by at least 1.5x, so that slowly increasing sizes don't reallocate it every time.
+        void grow_for_overwrite(size_t min_size)
+        {
+            if (_size < min_size)
+            {
+                *this = Buffer{ std::max(_size + (_size >> 1), min_size) };
+            }
+        }
+
         T& operator[](size_t index) noexcept
         {
             assert(index < _size);
@@ -315,6 +332,12 @@ namespace Microsoft::Console::Render::Atlas
         HWND hwnd = nullptr;
         bool enableTransparentBackground = false;
         bool useSoftwareRendering = false;
+        // Prefer the integrated/low power GPU over the one driving the monitor we're on.
+        bool preferLowPowerAdapter = false;
+        // Render into swapChain.offscreenTarget instead of a swap chain. See AtlasEngine::SetOffscreen().
+        bool offscreen = false;
+        // Use BackendD2D even if BackendD3D is supported.
+        bool forceD2DMode = false;
     };
 
     enum class AntialiasingMode : u8
@@ -359,7 +382,12 @@ namespace Microsoft::Console::Render::Atlas
 
         u16 dpi = 96;
         AntialiasingMode antialiasingMode = DefaultAntialiasingMode;
+    };
 
+    // DECDLD soft fonts live apart from FontSettings, because applications may redefine them
+    // frequently and that shouldn't invalidate everything that depends on the regular font.
+    struct SoftFontSettings
+    {
         std::vector<uint16_t> softFontPattern;
         til::size softFontCellSize;
     };
@@ -378,6 +406,8 @@ namespace Microsoft::Console::Render::Atlas
         u32 backgroundColor = 0;
         u32 selectionColor = 0x7fffffff;
         std::wstring customPixelShaderPath;
+        // The frame rate limit for custom shaders that use the time. 0 means no limit.
+        u16 customPixelShaderFrameRate = 0;
         bool useRetroTerminalEffect = false;
     };
 
@@ -385,6 +415,7 @@ namespace Microsoft::Console::Render::Atlas
     {
         til::generational<TargetSettings> target;
         til::generational<FontSettings> font;
+        til::generational<SoftFontSettings> softFont;
         til::generational<CursorSettings> cursor;
         til::generational<MiscellaneousSettings> misc;
         u16x2 targetSize{};
@@ -399,6 +430,7 @@ namespace Microsoft::Console::Render::Atlas
             til::generation_t{ 1 },
             til::generational<TargetSettings>{ til::generation_t{ 1 } },
             til::generational<FontSettings>{ til::generation_t{ 1 } },
+            til::generational<SoftFontSettings>{ til::generation_t{ 1 } },
             til::generational<CursorSettings>{ til::generation_t{ 1 } },
             til::generational<MiscellaneousSettings>{ til::generation_t{ 1 } },
         };
@@ -427,6 +459,34 @@ namespace Microsoft::Console::Render::Atlas
         u16 to = 0;
     };
 
+    // A search highlight within a ShapedRow. See AtlasEngine::PaintSearchHighlightLayer().
+    struct SearchHighlightRange
+    {
+        GridLineSet lines;
+        u32 color = 0;
+        u16 from = 0;
+        u16 to = 0;
+
+        bool operator==(const SearchHighlightRange& rhs) const noexcept
+        {
+            return lines.bits() == rhs.lines.bits() && color == rhs.color && from == rhs.from && to == rhs.to;
+        }
+    };
+
+    // A copy of the ImageSlice of a ROW, in straight RGBA pixels which are
+    // (columnEnd - columnBegin) * cellSize.x wide and cellSize.y tall.
+    struct ImageBitmap
+    {
+        std::vector<u32> pixels;
+        u64 revision = 0;
+        u16x2 cellSize{};
+        u16 columnBegin = 0;
+        u16 columnEnd = 0;
+        // The pixels are kept across Clear() calls so that an unchanged slice doesn't need
+        // to be copied again when its row gets repainted. This tracks whether it's still in use.
+        bool active = false;
+    };
+
     struct ShapedRow
     {
         void Clear(u16 y, u16 cellHeight) noexcept
@@ -440,6 +500,8 @@ namespace Microsoft::Console::Render::Atlas
             lineRendition = LineRendition::SingleWidth;
             selectionFrom = 0;
             selectionTo = 0;
+            searchHighlights.clear();
+            bitmap.active = false;
             dirtyTop = y * cellHeight;
             dirtyBottom = dirtyTop + cellHeight;
         }
@@ -450,6 +512,8 @@ namespace Microsoft::Console::Render::Atlas
         std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets; // same size as glyphIndices
         std::vector<u32> colors; // same size as glyphIndices
         std::vector<GridLineRange> gridLineRanges;
+        std::vector<SearchHighlightRange> searchHighlights;
+        ImageBitmap bitmap;
         LineRendition lineRendition = LineRendition::SingleWidth;
         u16 selectionFrom = 0;
         u16 selectionTo = 0;
@@ -469,6 +533,8 @@ namespace Microsoft::Console::Render::Atlas
         wil::com_ptr<IDWriteRenderingParams1> renderingParams;
         std::function<void(HRESULT)> warningCallback;
         std::function<void(HANDLE)> swapChainChangedCallback;
+        // Owned by the Renderer. Might be nullptr.
+        PerfCounters* perfCounters = nullptr;
 
         //// Parameters which are constant for the existence of the backend.
         struct
@@ -477,17 +543,28 @@ namespace Microsoft::Console::Render::Atlas
             wil::com_ptr<IDXGIAdapter1> adapter;
             LUID adapterLuid{};
             UINT adapterFlags = 0;
+            // Whether we're running in a remote desktop session, as of the last _recreateAdapter().
+            bool remoteSession = false;
+            // The monitor the adapter was chosen for. See AtlasEngine::_getTargetMonitor().
+            HMONITOR monitor = nullptr;
         } dxgi;
         struct
         {
             wil::com_ptr<IDXGISwapChain2> swapChain;
             wil::unique_handle handle;
             wil::unique_handle frameLatencyWaitableObject;
+            // Used instead of the swap chain if target->offscreen is set.
+            wil::com_ptr<ID3D11Texture2D> offscreenTarget;
             til::generation_t generation;
             til::generation_t targetGeneration;
             til::generation_t fontGeneration;
             u16x2 targetSize{};
+            std::chrono::steady_clock::time_point presentTime;
             bool waitForPresentation = false;
+            // Set if the last Present() returned DXGI_STATUS_OCCLUDED. See AtlasEngine::IsOccluded().
+            bool occluded = false;
+            // Set by IsOccluded() once the occlusion ended, so that StartPaint() redraws everything.
+            bool revealed = false;
         } swapChain;
         wil::com_ptr<ID3D11Device2> device;
         wil::com_ptr<ID3D11DeviceContext2> deviceContext;
@@ -529,6 +606,10 @@ namespace Microsoft::Console::Render::Atlas
         // A generation of 1 ensures that the backends redraw the background on the first Present().
         // The 1st entry in this array corresponds to the background and the 2nd to the foreground bitmap.
         std::array<til::generation_t, 2> colorBitmapGenerations{ 1, 1 };
+        // The rows of the background bitmap that changed during this frame and its generation before that.
+        // If a backend's copy of the bitmap is of backgroundBitmapBaseGeneration, it only needs to update these rows.
+        range<u16> backgroundBitmapDirtyRows{};
+        til::generation_t backgroundBitmapBaseGeneration;
         // In columns/rows.
         til::rect cursorRect;
         // The viewport/SwapChain area to be presented. In pixel.
@@ -541,6 +622,21 @@ namespace Microsoft::Console::Render::Atlas
         range<u16> invalidatedRows{};
         // In pixel.
         i16 scrollOffset = 0;
+        // In pixel. The amount by which all rows are drawn moved up in smooth scrolling mode.
+        i32 smoothScrollOffset = 0;
+
+        // Returns the texture the frame gets drawn into. Either the swap chain's back buffer or the offscreen target.
+        wil::com_ptr<ID3D11Texture2D> GetBackBuffer() const
+        {
+            if (swapChain.offscreenTarget)
+            {
+                return swapChain.offscreenTarget;
+            }
+
+            wil::com_ptr<ID3D11Texture2D> buffer;
+            THROW_IF_FAILED(swapChain.swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(buffer.addressof())));
+            return buffer;
+        }
 
         void MarkAllAsDirty() noexcept
         {
@@ -556,5 +652,8 @@ namespace Microsoft::Console::Render::Atlas
         virtual void ReleaseResources() noexcept = 0;
         virtual void Render(RenderingPayload& payload) = 0;
         virtual bool RequiresContinuousRedraw() noexcept = 0;
+        virtual DWORD GetContinuousRedrawDelay() noexcept = 0;
+        // The approximate number of bytes of GPU memory held by the backend's textures and buffers.
+        virtual u64 GetMemoryUsage() const noexcept = 0;
     };
 }
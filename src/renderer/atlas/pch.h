@@ -7,7 +7,10 @@
 #define WIN32_LEAN_AND_MEAN
 
 #include <array>
+#include <execution>
 #include <filesystem>
+#include <list>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <span>
@@ -23,7 +26,7 @@
 #include <d3dcompiler.h>
 #include <dcomp.h>
 #include <dwrite_3.h>
-#include <dxgi1_3.h>
+#include <dxgi1_6.h>
 #include <dxgidebug.h>
 #include <VersionHelpers.h>
 
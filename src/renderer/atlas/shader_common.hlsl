@@ -8,12 +8,14 @@
 #define SHADING_TYPE_TEXT_PASSTHROUGH   3
 #define SHADING_TYPE_DOTTED_LINE        4
 #define SHADING_TYPE_DOTTED_LINE_WIDE   5
+#define SHADING_TYPE_IMAGE              9
 // clang-format on
 
 struct VSData
 {
     float2 vertex : SV_Position;
     uint shadingType : shadingType;
+    uint2 renditionShift : renditionShift;
     int2 position : position;
     uint2 size : size;
     uint2 texcoord : texcoord;
@@ -12,10 +12,12 @@ cbuffer ConstBuffer : register(b0)
     float4 gammaRatios;
     float enhancedContrast;
     float underlineWidth;
+    float2 backgroundOffset;
 }
 
 Texture2D<float4> background : register(t0);
 Texture2D<float4> glyphAtlas : register(t1);
+Texture2D<float4> imageTexture : register(t2);
 
 struct Output
 {
@@ -34,7 +36,7 @@ Output main(PSData data) : SV_Target
     {
     case SHADING_TYPE_TEXT_BACKGROUND:
     {
-        const float2 cell = data.position.xy / cellSize;
+        const float2 cell = (data.position.xy + backgroundOffset) / cellSize;
         color = all(cell < cellCount) ? background[cell] : backgroundColor;
         weights = float4(1, 1, 1, 1);
         break;
@@ -85,6 +87,13 @@ Output main(PSData data) : SV_Target
         weights = color.aaaa;
         break;
     }
+    case SHADING_TYPE_IMAGE:
+    {
+        // The image pixels are either fully transparent (and zero) or opaque, which makes them premultiplied.
+        color = imageTexture[data.texcoord];
+        weights = color.aaaa;
+        break;
+    }
     default:
     {
         color = premultiplyColor(data.color);
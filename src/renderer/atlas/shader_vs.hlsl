@@ -6,6 +6,7 @@
 cbuffer ConstBuffer : register(b0)
 {
     float2 positionScale;
+    float2 positionOffset;
 }
 
 // clang-format off
@@ -17,8 +18,13 @@ PSData main(VSData data)
     output.shadingType = data.shadingType;
     // positionScale is expected to be float2(2.0f / sizeInPixel.x, -2.0f / sizeInPixel.y). Together with the
     // addition below this will transform our "position" from pixel into normalized device coordinate (NDC) space.
-    output.position.xy = (data.position + data.vertex.xy * data.size) * positionScale + float2(-1.0f, 1.0f);
+    // positionOffset moves all quads up by the smooth scroll offset, except for the background,
+    // which covers the entire render target. The pixel shader compensates for it via backgroundOffset.
+    const float2 offset = data.shadingType == SHADING_TYPE_TEXT_BACKGROUND ? float2(0, 0) : positionOffset;
+    output.position.xy = (data.position + offset + data.vertex.xy * data.size) * positionScale + float2(-1.0f, 1.0f);
     output.position.zw = float2(0, 1);
-    output.texcoord = data.texcoord + data.vertex.xy * data.size;
+    // For DECDWL/DECDHL rows the texcoord is in screen pixels as well. Scaling it down
+    // here stretches the unscaled glyph in the atlas across the larger quad.
+    output.texcoord = (data.texcoord + data.vertex.xy * data.size) / float2(1u << data.renditionShift);
     return output;
 }
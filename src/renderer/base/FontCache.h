@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <map>
+
 #include <til/mutex.h>
 
 namespace Microsoft::Console::Render::FontCache
@@ -90,4 +92,94 @@ namespace Microsoft::Console::Render::FontCache
         }
         return *guard;
     }
+
+    // The result of ResolveFont(). Since the metrics are in design units, they're independent
+    // of the font size and DPI and the same entry can be shared by all controls in the process.
+    struct ResolvedFont
+    {
+        // The system font collection at the time of the lookup. If it changed since
+        // (for instance, because fonts got installed), the entry is resolved again.
+        wil::com_ptr<IDWriteFontCollection> systemFontCollection;
+        wil::com_ptr<IDWriteFontCollection> fontCollection;
+        wil::com_ptr<IDWriteFontFamily> fontFamily;
+        wil::com_ptr<IDWriteFontFace> fontFace;
+        DWRITE_FONT_METRICS metrics{};
+        // The advance width of "0" in design units, or 0 if the font doesn't have that glyph.
+        int32_t zeroAdvanceWidth = 0;
+    };
+
+    namespace details
+    {
+        inline ResolvedFont resolveFont(wil::com_ptr<IDWriteFontCollection> systemFontCollection, const wchar_t* faceName, DWRITE_FONT_WEIGHT weight)
+        {
+            ResolvedFont r;
+            r.systemFontCollection = systemFontCollection;
+            r.fontCollection = std::move(systemFontCollection);
+
+            uint32_t index = 0;
+            BOOL exists = false;
+            THROW_IF_FAILED(r.fontCollection->FindFamilyName(faceName, &index, &exists));
+
+            if constexpr (Feature_NearbyFontLoading::IsEnabled())
+            {
+                if (!exists)
+                {
+                    r.fontCollection = GetCached();
+                    THROW_IF_FAILED(r.fontCollection->FindFamilyName(faceName, &index, &exists));
+                }
+            }
+
+            THROW_HR_IF(DWRITE_E_NOFONT, !exists);
+
+            THROW_IF_FAILED(r.fontCollection->GetFontFamily(index, r.fontFamily.addressof()));
+
+            wil::com_ptr<IDWriteFont> font;
+            THROW_IF_FAILED(r.fontFamily->GetFirstMatchingFont(weight, DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, font.addressof()));
+            THROW_IF_FAILED(font->CreateFontFace(r.fontFace.addressof()));
+            r.fontFace->GetMetrics(&r.metrics);
+
+            static constexpr uint32_t codePoint = '0';
+            uint16_t glyphIndex = 0;
+            THROW_IF_FAILED(r.fontFace->GetGlyphIndicesW(&codePoint, 1, &glyphIndex));
+
+            if (glyphIndex)
+            {
+                DWRITE_GLYPH_METRICS glyphMetrics{};
+                THROW_IF_FAILED(r.fontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &glyphMetrics, FALSE));
+                r.zeroAdvanceWidth = static_cast<int32_t>(glyphMetrics.advanceWidth);
+            }
+
+            return r;
+        }
+    }
+
+    // Finds the font face for the given family name and weight in the system font collection,
+    // or in the one returned by GetCached() if it doesn't exist there. Throws DWRITE_E_NOFONT if neither
+    // has it. Creating the font face and querying its metrics is comparatively costly, which is why
+    // the results are cached for the lifetime of the process, so that subsequent controls start faster.
+    inline ResolvedFont ResolveFont(IDWriteFactory* factory, const wchar_t* faceName, DWRITE_FONT_WEIGHT weight)
+    {
+        using Key = std::pair<std::wstring, DWRITE_FONT_WEIGHT>;
+        static til::shared_mutex<std::map<Key, ResolvedFont>> cachedFonts;
+
+        // DirectWrite hands out the same cached collection until fonts get (un)installed.
+        wil::com_ptr<IDWriteFontCollection> systemFontCollection;
+        THROW_IF_FAILED(factory->GetSystemFontCollection(systemFontCollection.addressof(), FALSE));
+
+        Key key{ faceName, weight };
+
+        {
+            const auto guard = cachedFonts.lock_shared();
+            if (const auto it = guard->find(key); it != guard->end() && it->second.systemFontCollection == systemFontCollection)
+            {
+                return it->second;
+            }
+        }
+
+        auto resolved = details::resolveFont(std::move(systemFontCollection), faceName, weight);
+
+        const auto guard = cachedFonts.lock();
+        guard->insert_or_assign(std::move(key), resolved);
+        return resolved;
+    }
 }
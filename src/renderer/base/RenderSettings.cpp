@@ -35,6 +35,7 @@ RenderSettings::RenderSettings() noexcept
 void RenderSettings::SetRenderMode(const Mode mode, const bool enabled) noexcept
 {
     _renderMode.set(mode, enabled);
+    _colorsGeneration.bump();
     // If blinking is disabled, make sure blinking content is not faint.
     if (mode == Mode::BlinkAllowed && !enabled)
     {
@@ -65,6 +66,7 @@ const std::array<COLORREF, TextColor::TABLE_SIZE>& RenderSettings::GetColorTable
 void RenderSettings::ResetColorTable() noexcept
 {
     InitializeColorTable({ _colorTable.data(), 16 });
+    _colorsGeneration.bump();
 }
 
 // Routine Description:
@@ -75,6 +77,7 @@ void RenderSettings::ResetColorTable() noexcept
 void RenderSettings::SetColorTableEntry(const size_t tableIndex, const COLORREF color)
 {
     _colorTable.at(tableIndex) = color;
+    _colorsGeneration.bump();
 }
 
 // Routine Description:
@@ -121,6 +124,7 @@ void RenderSettings::SetColorAliasIndex(const ColorAlias alias, const size_t tab
     if (tableIndex < TextColor::TABLE_SIZE)
     {
         gsl::at(_colorAliasIndices, static_cast<size_t>(alias)) = tableIndex;
+        _colorsGeneration.bump();
     }
 }
 
@@ -146,6 +150,45 @@ std::pair<COLORREF, COLORREF> RenderSettings::GetAttributeColors(const TextAttri
 {
     _blinkIsInUse = _blinkIsInUse || attr.IsBlinking();
 
+    static_assert(sizeof(TextColor) == 4);
+    uint32_t fgBits;
+    uint32_t bgBits;
+    const auto fgTextColor = attr.GetForeground();
+    const auto bgTextColor = attr.GetBackground();
+    memcpy(&fgBits, &fgTextColor, sizeof(fgBits));
+    memcpy(&bgBits, &bgTextColor, sizeof(bgBits));
+
+    const auto colors = static_cast<uint64_t>(fgBits) << 32 | bgBits;
+    const auto flags = static_cast<uint32_t>(attr.IsIntense()) |
+                       static_cast<uint32_t>(attr.IsFaint()) << 1 |
+                       static_cast<uint32_t>(attr.IsBlinking()) << 2 |
+                       static_cast<uint32_t>(attr.IsReverseVideo()) << 3 |
+                       static_cast<uint32_t>(attr.IsInvisible()) << 4;
+
+    // Multiplicative hashing. The top bits of the product depend on all bits of the key.
+    const auto hash = (colors ^ flags) * UINT64_C(0x9E3779B97F4A7C15);
+    auto& entry = til::at(_attributeColorsCache, hash >> 56);
+    static_assert(AttributeColorsCacheSize == 256);
+
+    if (entry.generation != _colorsGeneration || entry.colors != colors || entry.flags != flags)
+    {
+        entry.colors = colors;
+        entry.flags = flags;
+        entry.generation = _colorsGeneration;
+        entry.result = _calculateAttributeColors(attr);
+    }
+
+    return entry.result;
+}
+
+// Routine Description:
+// - The uncached implementation of GetAttributeColors().
+// Arguments:
+// - attr - The TextAttribute to retrieve the colors for.
+// Return Value:
+// - The color values of the attribute's foreground and background.
+std::pair<COLORREF, COLORREF> RenderSettings::_calculateAttributeColors(const TextAttribute& attr) const noexcept
+{
     const auto fgTextColor = attr.GetForeground();
     const auto bgTextColor = attr.GetBackground();
 
@@ -229,14 +272,17 @@ try
         _blinkCycle = (_blinkCycle + 1) % 4;
         // ... and two of those four render the blink attributes as faint.
         _blinkShouldBeFaint = _blinkCycle >= 2;
+        _colorsGeneration.bump();
         // Every two cycles (when the state changes), we need to trigger a
         // redraw, but only if there are actually blink attributes in use.
         if (_blinkIsInUse && _blinkCycle % 2 == 0)
         {
             // We reset the _blinkIsInUse flag before redrawing, so we can
             // get a fresh assessment of the current blink attribute usage.
+            // Only the blinking cells are redrawn, which get painted again
+            // and thus set the flag again if they're still there.
             _blinkIsInUse = false;
-            renderer.TriggerRedrawAll();
+            renderer.TriggerRedrawBlinking();
         }
     }
 }
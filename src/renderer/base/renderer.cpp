@@ -4,6 +4,11 @@
 #include "precomp.h"
 #include "renderer.hpp"
 
+#include <til/atomic.h>
+
+#include "../../types/inc/GlyphWidth.hpp"
+#include "../../types/inc/PerformanceRegion.hpp"
+
 #pragma hdrstop
 
 using namespace Microsoft::Console::Render;
@@ -14,6 +19,11 @@ using PointTree = interval_tree::IntervalTree<til::point, size_t>;
 static constexpr auto maxRetriesForRenderEngine = 3;
 // The renderer will wait this number of milliseconds * how many tries have elapsed before trying again.
 static constexpr auto renderBackoffBaseTimeMilliseconds{ 150 };
+// How long we'll hold off painting for an application that started a
+// synchronized update (DECSET 2026), but never ended it.
+static constexpr std::chrono::milliseconds synchronizedOutputTimeout{ 100 };
+// How often we check whether an engine that reported IsOccluded() became visible again.
+static constexpr DWORD occlusionPollInterval{ 500 };
 
 #define FOREACH_ENGINE(var)   \
     for (auto var : _engines) \
@@ -64,8 +74,48 @@ Renderer::~Renderer()
 // - HRESULT S_OK, GDI error, Safe Math error, or state/argument errors.
 [[nodiscard]] HRESULT Renderer::PaintFrame()
 {
+    // No one is going to look at our frames. SetOccluded() redraws everything once that changes.
+    if (_occlusion.load(std::memory_order_relaxed))
+    {
+        return S_OK;
+    }
+
+    const PerformanceRegion region{ "Renderer_PaintFrame" };
+    const auto start = std::chrono::steady_clock::now();
+    const auto countFrame = wil::scope_exit([&]() noexcept {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        PerfCounters::Add(_perfCounters.frames, 1);
+        PerfCounters::Add(_perfCounters.paintMicroseconds, gsl::narrow_cast<uint64_t>(elapsed.count()));
+    });
+
+    // Ambiguous glyphs written since the last frame may have been measured as narrow without asking
+    // the font (see SetGlyphWidthFallbackDeferred). We own the engines, so we can measure them now.
+    // The fixup of the text modifies the buffer, which is why this needs the exclusive lock.
+    if (HasDeferredGlyphWidths())
+    {
+        _pData->LockConsole();
+        const auto unlock = wil::scope_exit([&]() {
+            _pData->UnlockConsole();
+        });
+        try
+        {
+            ResolveDeferredGlyphWidths();
+        }
+        CATCH_LOG();
+    }
+
     FOREACH_ENGINE(pEngine)
     {
+        // Invalidations keep accumulating in the engine until it's visible again.
+        if (pEngine->IsOccluded())
+        {
+            if (_pThread)
+            {
+                _pThread->NotifyPaintAfter(occlusionPollInterval);
+            }
+            continue;
+        }
+
         auto tries = maxRetriesForRenderEngine;
         while (tries > 0)
         {
@@ -110,9 +160,13 @@ try
 {
     FAIL_FAST_IF_NULL(pEngine); // This is a programming error. Fail fast.
 
-    _pData->LockConsole();
+    // Temporaries needed to paint this frame are allocated from the frame arena.
+    const til::pmr::frame_scope frame;
+
+    // Painting only reads from the buffer, so other readers may proceed alongside us.
+    _pData->LockConsoleShared();
     auto unlock = wil::scope_exit([&]() {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
 
     // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
@@ -130,15 +184,27 @@ try
         return S_OK;
     }
 
+    // The echo of a key press that was written into the buffer before we took the lock is part of this frame.
+    const auto echoedInput = _perfCounters.TakeEchoedInput();
+
     auto endPaint = wil::scope_exit([&]() {
         LOG_IF_FAILED(pEngine->EndPaint());
 
         // If the engine tells us it really wants to redraw immediately,
         // tell the thread so it doesn't go to sleep and ticks again
-        // at the next opportunity.
+        // at the next opportunity. Engines that limit their frame rate
+        // get woken up once their next frame is due instead.
         if (pEngine->RequiresContinuousRedraw())
         {
-            NotifyPaintFrame();
+            const auto delay = pEngine->GetContinuousRedrawDelay();
+            if (delay && _pThread)
+            {
+                _pThread->NotifyPaintAfter(delay);
+            }
+            else
+            {
+                NotifyPaintFrame();
+            }
         }
     });
 
@@ -178,6 +244,11 @@ try
     // Trigger out-of-lock presentation for renderers that can support it
     RETURN_IF_FAILED(pEngine->Present());
 
+    if (const auto latency = _perfCounters.InputPresented(echoedInput); latency && _pfnInputLatency)
+    {
+        _pfnInputLatency(*latency);
+    }
+
     // As we leave the scope, EndPaint will be called (declared above)
     return S_OK;
 }
@@ -244,6 +315,76 @@ void Renderer::TriggerRedraw(const Viewport& region)
     }
 }
 
+// Routine Description:
+// - Called when the contents of an overlay (like the IME composition) within the given region
+//   have changed, or when an overlay was moved, shown or hidden. Unlike TriggerRedraw(), this
+//   allows engines with an overlay layer to skip repainting the text buffer underneath it.
+// Arguments:
+// - region: The buffer-space region covered by the overlay.
+// Return Value:
+// - <none>
+void Renderer::TriggerRedrawOverlay(const Viewport& region)
+{
+    auto view = _viewport;
+    auto srUpdateRegion = region.ToExclusive();
+
+    if (view.TrimToViewport(&srUpdateRegion))
+    {
+        view.ConvertToOrigin(&srUpdateRegion);
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateOverlay(&srUpdateRegion));
+        }
+
+        NotifyPaintFrame();
+    }
+}
+
+// Routine Description:
+// - Called when search highlights were added or removed. Unlike TriggerRedraw(), this allows
+//   engines with a search highlight layer to skip repainting the text buffer underneath them.
+// Arguments:
+// - highlights: The highlights that changed, in buffer coordinates. They don't need to be visible.
+// Return Value:
+// - <none>
+void Renderer::TriggerRedrawSearchHighlights(std::span<const til::point_span> highlights)
+{
+    const auto view = _viewport;
+    const auto& buffer = _pData->GetTextBuffer();
+    const auto width = buffer.GetSize().Width();
+    auto invalidated = false;
+
+    for (const auto& highlight : highlights)
+    {
+        const auto top = std::max(highlight.start.y, view.Top());
+        const auto bottom = std::min(highlight.end.y, view.BottomInclusive());
+
+        for (auto y = top; y <= bottom; ++y)
+        {
+            // Just like in TriggerRedraw(), double width lines cover twice as many columns.
+            const auto shift = buffer.IsDoubleWidthLine(y) ? 1 : 0;
+            const auto left = y == highlight.start.y ? highlight.start.x : 0;
+            const auto right = y == highlight.end.y ? highlight.end.x + 1 : width;
+            til::rect srUpdateRegion{ left << shift, y, right << shift, y + 1 };
+
+            if (view.TrimToViewport(&srUpdateRegion))
+            {
+                view.ConvertToOrigin(&srUpdateRegion);
+                FOREACH_ENGINE(pEngine)
+                {
+                    LOG_IF_FAILED(pEngine->InvalidateSearchHighlights(&srUpdateRegion));
+                }
+                invalidated = true;
+            }
+        }
+    }
+
+    if (invalidated)
+    {
+        NotifyPaintFrame();
+    }
+}
+
 // Routine Description:
 // - Called when a particular coordinate within the console buffer has changed.
 // Arguments:
@@ -324,6 +465,34 @@ void Renderer::TriggerRedrawAll(const bool backgroundChanged, const bool frameCh
     }
 }
 
+// Routine Description:
+// - Called when the blink rendition changed. Only the runs of blinking cells
+//   within the viewport are invalidated, instead of the entire frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::TriggerRedrawBlinking()
+{
+    const auto& buffer = _pData->GetTextBuffer();
+    const auto view = _viewport;
+    const auto rowEnd = std::min(view.BottomExclusive(), buffer.GetSize().BottomExclusive());
+
+    for (auto y = view.Top(); y < rowEnd; ++y)
+    {
+        til::CoordType x = 0;
+        for (const auto& run : buffer.GetRowByOffset(y).Attributes().runs())
+        {
+            const auto end = x + run.length;
+            if (run.value.IsBlinking())
+            {
+                TriggerRedraw(Viewport::FromExclusive({ x, y, end, y + 1 }));
+            }
+            x = end;
+        }
+    }
+}
+
 // Method Description:
 // - Called when the host is about to die, to give the renderer one last chance
 //      to paint before the host exits.
@@ -333,6 +502,9 @@ void Renderer::TriggerRedrawAll(const bool backgroundChanged, const bool frameCh
 // - <none>
 void Renderer::TriggerTeardown() noexcept
 {
+    // Don't let the paint thread hang around waiting for the end of a synchronized update.
+    SetSynchronizedOutput(false);
+
     // We need to shut down the paint thread on teardown.
     _pThread->WaitForPaintCompletionAndDisable(INFINITE);
 
@@ -360,6 +532,8 @@ void Renderer::TriggerSelection()
 {
     try
     {
+        const til::pmr::frame_scope frame;
+
         // Get selection rectangles
         auto rects = _GetSelectionRects();
 
@@ -378,13 +552,31 @@ void Renderer::TriggerSelection()
             LOG_IF_FAILED(pEngine->InvalidateSelection(rects));
         }
 
-        _previousSelection = std::move(rects);
+        _previousSelection.assign(rects.begin(), rects.end());
 
         NotifyPaintFrame();
     }
     CATCH_LOG();
 }
 
+// Routine Description:
+// - Returns the part of the buffer that the engines are given to draw. In smooth scrolling mode
+//   this is the viewport plus one row of overscan below it, which scrolls into view as the
+//   contents get moved up by the sub-row offset. See SetSmoothScrolling().
+// Arguments:
+// - <none>
+// Return Value:
+// - The viewport in buffer coordinates.
+Viewport Renderer::_GetRenderViewport() const
+{
+    auto viewport = _pData->GetViewport().ToInclusive();
+    if (_smoothScrolling)
+    {
+        viewport.bottom++;
+    }
+    return Viewport::FromInclusive(viewport);
+}
+
 // Routine Description:
 // - Called when we want to check if the viewport has moved and scroll accordingly if so.
 // Arguments:
@@ -394,7 +586,7 @@ void Renderer::TriggerSelection()
 bool Renderer::_CheckViewportAndScroll()
 {
     const auto srOldViewport = _viewport.ToInclusive();
-    const auto srNewViewport = _pData->GetViewport().ToInclusive();
+    const auto srNewViewport = _GetRenderViewport().ToInclusive();
 
     if (!_forceUpdateViewport && srOldViewport == srNewViewport)
     {
@@ -454,6 +646,48 @@ void Renderer::TriggerScroll(const til::point* const pcoordDelta)
     NotifyPaintFrame();
 }
 
+// Routine Description:
+// - Called when the rows within a part of the buffer were moved up or down, like a DECSTBM
+//   scroll region does. Engines that can move their existing pixels only need to paint the
+//   rows revealed by the move, which the caller is expected to invalidate when it erases them.
+// - Regions that aren't entirely visible or contain double width rows are simply redrawn.
+// Arguments:
+// - region - the full width rows that were moved, in buffer coordinates.
+// - delta - the number of rows the contents moved by (positive is down, negative is up).
+// Return Value:
+// - <none>
+void Renderer::TriggerScrollRegion(const til::rect& region, const til::CoordType delta)
+{
+    const auto view = _viewport.ToExclusive();
+    if (delta == 0 || region.top < view.top || region.bottom > view.bottom)
+    {
+        TriggerRedraw(Viewport::FromExclusive(region));
+        return;
+    }
+
+    const auto& buffer = _pData->GetTextBuffer();
+    for (auto row = region.top; row < region.bottom; row++)
+    {
+        if (buffer.IsDoubleWidthLine(row))
+        {
+            TriggerRedraw(Viewport::FromExclusive(region));
+            return;
+        }
+    }
+
+    auto srRegion = region;
+    if (_viewport.TrimToViewport(&srRegion))
+    {
+        _viewport.ConvertToOrigin(&srRegion);
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateScrollRegion(&srRegion, delta));
+        }
+
+        NotifyPaintFrame();
+    }
+}
+
 // Routine Description:
 // - Called when the text buffer is about to circle its backing buffer.
 //      A renderer might want to get painted before that happens.
@@ -463,6 +697,7 @@ void Renderer::TriggerScroll(const til::point* const pcoordDelta)
 // - <none>
 void Renderer::TriggerFlush(const bool circling)
 {
+    const til::pmr::frame_scope frame;
     const auto rects = _GetSelectionRects();
 
     FOREACH_ENGINE(pEngine)
@@ -637,7 +872,7 @@ void Renderer::EnablePainting()
 {
     // When the renderer is constructed, the initial viewport won't be available yet,
     // but once EnablePainting is called it should be safe to retrieve.
-    _viewport = _pData->GetViewport();
+    _viewport = _GetRenderViewport();
     _forceUpdateViewport = true;
 
     // When running the unit tests, we may be using a render without a render thread.
@@ -660,6 +895,173 @@ void Renderer::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
     _pThread->WaitForPaintCompletionAndDisable(dwTimeoutMs);
 }
 
+// Routine Description:
+// - Sets whether this renderer's frames should be painted before those of other renderers
+//   that share the same SharedRenderThread. Used to paint the focused pane first.
+// Arguments:
+// - highPriority - true if this renderer should be painted first.
+// Return Value:
+// - <none>
+void Renderer::SetHighPriority(const bool highPriority) noexcept
+{
+    if (_pThread)
+    {
+        _pThread->SetHighPriority(highPriority);
+    }
+}
+
+// Routine Description:
+// - Sets whether this renderer's frames should be painted as soon as possible
+//   or at most once per display refresh.
+// Arguments:
+// - mode - the PacingMode to use.
+// Return Value:
+// - <none>
+void Renderer::SetPacingMode(const PacingMode mode) noexcept
+{
+    if (_pThread)
+    {
+        _pThread->SetPacingMode(mode);
+    }
+}
+
+// Routine Description:
+// - Enables or disables smooth scrolling. While enabled, the engines are given one
+//   extra row below the viewport to draw, so that scrolling by a fraction of a row
+//   via SetSmoothScrollOffset() only needs to move the existing frame on the screen.
+//   New rows only need to be drawn once the viewport crosses a row boundary.
+// Arguments:
+// - enabled - true to enable smooth scrolling.
+// Return Value:
+// - <none>
+void Renderer::SetSmoothScrolling(const bool enabled) noexcept
+{
+    if (_smoothScrolling == enabled)
+    {
+        return;
+    }
+
+    _smoothScrolling = enabled;
+    // The viewport changes size by the overscan row, which _CheckViewportAndScroll() passes on to the engines.
+    _forceUpdateViewport = true;
+    SetSmoothScrollOffset(0);
+    NotifyPaintFrame();
+}
+
+// Routine Description:
+// - Sets the fraction of a row by which the contents are moved up past the top of the viewport.
+//   Only has an effect while smooth scrolling has been enabled with SetSmoothScrolling().
+// Arguments:
+// - rows - the offset in rows, in the range [0, 1).
+// Return Value:
+// - <none>
+void Renderer::SetSmoothScrollOffset(const float rows) noexcept
+{
+    const auto offset = _smoothScrolling ? std::clamp(rows, 0.0f, 1.0f) : 0.0f;
+    if (_smoothScrollOffset == offset)
+    {
+        return;
+    }
+
+    _smoothScrollOffset = offset;
+    FOREACH_ENGINE(pEngine)
+    {
+        pEngine->SetSmoothScrollOffset(offset);
+    }
+    NotifyPaintFrame();
+}
+
+// Routine Description:
+// - Puts the renderer into (or out of) a mode in which it doesn't paint or present
+//   anything, because the window is minimized or the session is locked. The buffer
+//   is still updated and the invalidations accumulate in the engines in the
+//   meantime. Once the last reason is gone, a single frame is drawn.
+// - Must be called while holding the console lock.
+// Arguments:
+// - reason - Why nobody can see the frames right now.
+// - occluded - true if that reason applies, false once it doesn't anymore.
+// Return Value:
+// - <none>
+void Renderer::SetOccluded(const OcclusionReason reason, const bool occluded)
+{
+    const auto bit = gsl::narrow_cast<uint8_t>(1u << static_cast<uint8_t>(reason));
+    const auto previous = occluded ? _occlusion.fetch_or(bit, std::memory_order_relaxed) : _occlusion.fetch_and(gsl::narrow_cast<uint8_t>(~bit), std::memory_order_relaxed);
+
+    if (!occluded && previous == bit)
+    {
+        TriggerRedrawAll();
+    }
+}
+
+// Routine Description:
+// - Starts or ends a synchronized update (DECSET/DECRST 2026). While an update
+//   is in progress the paint thread holds off painting, so that applications
+//   which redraw the screen in multiple writes don't get half-finished frames
+//   presented. If the update takes longer than synchronizedOutputTimeout,
+//   we'll paint regardless.
+// - Must only be called by the thread that processes the output.
+// Arguments:
+// - enabled - true to start an update, false to end it.
+// Return Value:
+// - <none>
+void Renderer::SetSynchronizedOutput(const bool enabled) noexcept
+{
+    if (enabled == _isSynchronizingOutput.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + synchronizedOutputTimeout;
+        _synchronizedOutputDeadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        _isSynchronizingOutput.store(true, std::memory_order_release);
+    }
+    else
+    {
+        _isSynchronizingOutput.store(false, std::memory_order_release);
+        til::atomic_notify_all(_isSynchronizingOutput);
+        NotifyPaintFrame();
+    }
+}
+
+bool Renderer::IsSynchronizingOutput() const noexcept
+{
+    return _isSynchronizingOutput.load(std::memory_order_relaxed);
+}
+
+// Routine Description:
+// - Returns how long the current synchronized update may still hold off painting.
+// Return Value:
+// - The delay in milliseconds, or 0 if there's no update in progress (or it timed out).
+DWORD Renderer::GetSynchronizedOutputDelay() const noexcept
+{
+    if (!_isSynchronizingOutput.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+
+    const std::chrono::steady_clock::time_point deadline{ std::chrono::steady_clock::duration{ _synchronizedOutputDeadline.load(std::memory_order_relaxed) } };
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+    {
+        return 0;
+    }
+
+    return gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+}
+
+// Routine Description:
+// - Blocks the calling (paint) thread until the current synchronized update
+//   ends or times out. Returns immediately if there isn't one.
+void Renderer::WaitForSynchronizedOutput() noexcept
+{
+    while (const auto delay = GetSynchronizedOutputDelay())
+    {
+        til::atomic_wait(_isSynchronizingOutput, true, delay);
+    }
+}
+
 // Routine Description:
 // - Paint helper to fill in the background color of the invalid area within the frame.
 // Arguments:
@@ -683,14 +1085,18 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
 {
     // This is the subsection of the entire screen buffer that is currently being presented.
     // It can move left/right or top/bottom depending on how the viewport is scrolled
-    // relative to the entire buffer.
-    const auto view = _pData->GetViewport();
+    // relative to the entire buffer. It includes the overscan row in smooth scrolling mode.
+    const auto view = _viewport;
 
     // This is effectively the number of cells on the visible screen that need to be redrawn.
     // The origin is always 0, 0 because it represents the screen itself, not the underlying buffer.
     std::span<const til::rect> dirtyAreas;
     LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
 
+    // Engines with a search highlight layer get all visible highlights at once.
+    // The others get them painted into each row below, as far as it's dirty.
+    const auto paintSearchHighlights = !_PaintSearchHighlightLayer(pEngine);
+
     // This is to make sure any transforms are reset when this paint is finished.
     auto resetLineTransform = wil::scope_exit([&]() {
         LOG_IF_FAILED(pEngine->ResetLineTransform());
@@ -717,8 +1123,11 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         // Retrieve the text buffer so we can read information out of it.
         const auto& buffer = _pData->GetTextBuffer();
 
+        // The overscan row doesn't exist while the viewport is at the bottom of the buffer.
+        const auto rowEnd = std::min(redraw.BottomExclusive(), buffer.GetSize().BottomExclusive());
+
         // Now walk through each row of text that we need to redraw.
-        for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
+        for (auto row = redraw.Top(); row < rowEnd; row++)
         {
             // Calculate the boundaries of a single line. This is from the left to right edge of the dirty
             // area in width and exactly 1 tall.
@@ -736,21 +1145,46 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
             // of the backing buffer to fill in line 1 of the screen.
             const auto screenPosition = bufferLine.Origin() - til::point{ 0, view.Top() };
 
-            // Retrieve the cell information iterator limited to just this line we want to redraw.
-            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+            const auto& rowData = buffer.GetRowByOffset(bufferLine.Origin().y);
+
+            // Prepare the appropriate line transform for the current row and viewport offset.
+            LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.y, view.Left()));
+
+            // Engines that can consume ROWs directly don't need us to split it up into
+            // clusters and brush changes. We only need to paint the grid lines for them.
+            const BufferRowInfo rowInfo{
+                .row = &rowData,
+                .renderSettings = &_renderSettings,
+                .targetRow = screenPosition.y,
+                .columnBegin = bufferLine.Left(),
+                .columnEnd = bufferLine.RightExclusive(),
+            };
+            if (const auto hr = pEngine->PaintBufferRow(rowInfo); hr != E_NOTIMPL)
+            {
+                LOG_IF_FAILED(hr);
+                if (_pData->IsGridLineDrawingAllowed())
+                {
+                    _PaintBufferRowGridLines(pEngine, rowData, bufferLine, screenPosition);
+                }
+                if (paintSearchHighlights)
+                {
+                    _PaintSearchHighlights(pEngine, bufferLine, screenPosition);
+                }
+                continue;
+            }
 
             // Calculate if two things are true:
             // 1. this row wrapped
             // 2. We're painting the last col of the row.
             // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-            const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().y).WasWrapForced()) &&
-                                     (bufferLine.RightExclusive() == buffer.GetSize().Width());
-
-            // Prepare the appropriate line transform for the current row and viewport offset.
-            LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.y, view.Left()));
+            const auto lineWrapped = rowData.WasWrapForced() && (bufferLine.RightExclusive() == buffer.GetSize().Width());
 
             // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+            _PaintBufferOutputHelper(pEngine, rowData, bufferLine.Left(), bufferLine.RightExclusive(), screenPosition, lineWrapped);
+            if (paintSearchHighlights)
+            {
+                _PaintSearchHighlights(pEngine, bufferLine, screenPosition);
+            }
         }
     }
 }
@@ -762,153 +1196,162 @@ static bool _IsAllSpaces(const std::wstring_view v)
 }
 
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
-                                        TextBufferCellIterator it,
+                                        const ROW& row,
+                                        const til::CoordType columnBegin,
+                                        const til::CoordType columnEnd,
                                         const til::point target,
                                         const bool lineWrapped)
 {
-    auto globalInvert{ _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed) };
+    const auto globalInvert{ _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed) };
+    const auto end = std::min<til::CoordType>(columnEnd, row.size());
+    auto column = columnBegin;
 
-    // If we have valid data, let's figure out how to draw it.
-    if (it)
+    // Nothing to draw if the range is empty or outside of the row.
+    if (column < 0 || column >= end)
     {
-        // TODO: MSFT: 20961091 -  This is a perf issue. Instead of rebuilding this and allocing memory to hold the reinterpretation,
-        // we should have an iterator/view adapter for the rendering.
-        // That would probably also eliminate the RenderData needing to give us the entire TextBuffer as well...
-        // Retrieve the iterator for one line of information.
-        til::CoordType cols = 0;
+        return;
+    }
+
+    // The attributes are read straight from the ROW's runs, instead of copying them out cell by cell.
+    // attrAt() only ever moves forward, which is fine since we walk the columns from left to right.
+    const auto& runs = row.Attributes().runs();
+    auto runIt = runs.begin();
+    til::CoordType runEnd = runIt->length;
+    const auto attrAt = [&](const til::CoordType col) -> const TextAttribute& {
+        while (runEnd <= col)
+        {
+            ++runIt;
+            runEnd += runIt->length;
+        }
+        return runIt->value;
+    };
 
-        // Retrieve the first color.
-        auto color = it->TextAttr();
-        // Retrieve the first pattern id
-        auto patternIds = _pData->GetPatternId(target);
-        // Determine whether we're using a soft font.
-        auto usingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
+    til::CoordType cols = 0;
 
-        // And hold the point where we should start drawing.
-        auto screenPoint = target;
+    // Retrieve the first color.
+    auto color = attrAt(column);
+    // Retrieve the first pattern id
+    auto patternIds = _pData->GetPatternId(target);
+    // Determine whether we're using a soft font.
+    auto usingSoftFont = s_IsSoftFontChar(row.GlyphAt(column), _firstSoftFontChar, _lastSoftFontChar);
 
-        // This outer loop will continue until we reach the end of the text we are trying to draw.
-        while (it)
+    // And hold the point where we should start drawing.
+    auto screenPoint = target;
+
+    // This outer loop will continue until we reach the end of the text we are trying to draw.
+    while (column < end)
+    {
+        // Hold onto the current run color right here for the length of the outer loop.
+        // We'll be changing the persistent one as we run through the inner loops to detect
+        // when a run changes, but we will still need to know this color at the bottom
+        // when we go to draw gridlines for the length of the run.
+        const auto currentRunColor = color;
+
+        // Update the drawing brushes with our color and font usage.
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
+
+        // Advance the point by however many columns we've just outputted and reset the accumulator.
+        screenPoint.x += cols;
+        cols = 0;
+
+        // Hold onto the start of this run and the target location where we started
+        // in case we need to do some special work to paint the line drawing characters.
+        const auto currentRunColumnStart = column;
+        const auto currentRunTargetStart = screenPoint;
+
+        // Ensure that our cluster vector is clear.
+        _clusterBuffer.clear();
+
+        // Reset our flag to know when we're in the special circumstance
+        // of attempting to draw only the right-half of a two-column character
+        // as the first item in our run.
+        auto trimLeft = false;
+
+        // Run contains wide character (>1 columns)
+        auto containsWideCharacter = false;
+
+        // This inner loop will accumulate clusters until the color changes.
+        // When the color changes, it will save the new color off and break.
+        // We also accumulate clusters according to regex patterns
+        do
         {
-            // Hold onto the current run color right here for the length of the outer loop.
-            // We'll be changing the persistent one as we run through the inner loops to detect
-            // when a run changes, but we will still need to know this color at the bottom
-            // when we go to draw gridlines for the length of the run.
-            const auto currentRunColor = color;
-
-            // Hold onto the current pattern id as well
-            const auto currentPatternId = patternIds;
-
-            // Update the drawing brushes with our color and font usage.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
-
-            // Advance the point by however many columns we've just outputted and reset the accumulator.
-            screenPoint.x += cols;
-            cols = 0;
-
-            // Hold onto the start of this run iterator and the target location where we started
-            // in case we need to do some special work to paint the line drawing characters.
-            const auto currentRunItStart = it;
-            const auto currentRunTargetStart = screenPoint;
-
-            // Ensure that our cluster vector is clear.
-            _clusterBuffer.clear();
-
-            // Reset our flag to know when we're in the special circumstance
-            // of attempting to draw only the right-half of a two-column character
-            // as the first item in our run.
-            auto trimLeft = false;
-
-            // Run contains wide character (>1 columns)
-            auto containsWideCharacter = false;
-
-            // This inner loop will accumulate clusters until the color changes.
-            // When the color changes, it will save the new color off and break.
-            // We also accumulate clusters according to regex patterns
-            do
+            const til::point thisPoint{ screenPoint.x + cols, screenPoint.y };
+            const auto glyph = row.GlyphAt(column);
+            const auto& attr = attrAt(column);
+            const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
+            const auto thisUsingSoftFont = s_IsSoftFontChar(glyph, _firstSoftFontChar, _lastSoftFontChar);
+            const auto changedPatternOrFont = patternIds != thisPointPatterns || usingSoftFont != thisUsingSoftFont;
+            if (color != attr || changedPatternOrFont)
             {
-                til::point thisPoint{ screenPoint.x + cols, screenPoint.y };
-                const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
-                const auto thisUsingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
-                const auto changedPatternOrFont = patternIds != thisPointPatterns || usingSoftFont != thisUsingSoftFont;
-                if (color != it->TextAttr() || changedPatternOrFont)
+                // foreground doesn't matter for runs of spaces (!)
+                // if we trick it . . . we call Paint far fewer times for cmatrix
+                if (!_IsAllSpaces(glyph) || !attr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || changedPatternOrFont)
                 {
-                    auto newAttr{ it->TextAttr() };
-                    // foreground doesn't matter for runs of spaces (!)
-                    // if we trick it . . . we call Paint far fewer times for cmatrix
-                    if (!_IsAllSpaces(it->Chars()) || !newAttr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || changedPatternOrFont)
-                    {
-                        color = newAttr;
-                        patternIds = thisPointPatterns;
-                        usingSoftFont = thisUsingSoftFont;
-                        break; // vend this run
-                    }
+                    color = attr;
+                    patternIds = thisPointPatterns;
+                    usingSoftFont = thisUsingSoftFont;
+                    break; // vend this run
                 }
+            }
 
-                // Walk through the text data and turn it into rendering clusters.
-                // Keep the columnCount as we go to improve performance over digging it out of the vector at the end.
-                auto columnCount = it->Columns();
+            // Walk through the text data and turn it into rendering clusters.
+            // Keep the columnCount as we go to improve performance over digging it out of the vector at the end.
+            const auto dbcsAttr = row.DbcsAttrAt(column);
+            const til::CoordType advance = dbcsAttr == DbcsAttribute::Leading ? 2 : 1;
+            auto columnCount = advance;
 
-                // If we're on the first cluster to be added and it's marked as "trailing"
-                // (a.k.a. the right half of a two column character), then we need some special handling.
-                if (_clusterBuffer.empty() && it->DbcsAttr() == DbcsAttribute::Trailing)
-                {
-                    // Move left to the one so the whole character can be struck correctly.
-                    --screenPoint.x;
-                    // And tell the next function to trim off the left half of it.
-                    trimLeft = true;
-                    // And add one to the number of columns we expect it to take as we insert it.
-                    ++columnCount;
-                }
+            // If we're on the first cluster to be added and it's marked as "trailing"
+            // (a.k.a. the right half of a two column character), then we need some special handling.
+            if (_clusterBuffer.empty() && dbcsAttr == DbcsAttribute::Trailing)
+            {
+                // Move left to the one so the whole character can be struck correctly.
+                --screenPoint.x;
+                // And tell the next function to trim off the left half of it.
+                trimLeft = true;
+                // And add one to the number of columns we expect it to take as we insert it.
+                ++columnCount;
+            }
 
-                if (columnCount > 1)
-                {
-                    containsWideCharacter = true;
-                }
+            if (columnCount > 1)
+            {
+                containsWideCharacter = true;
+            }
 
-                // Advance the cluster and column counts.
-                _clusterBuffer.emplace_back(it->Chars(), columnCount);
-                it += std::max(it->Columns(), 1); // prevent infinite loop for no visible columns
-                cols += columnCount;
+            // Advance the cluster and column counts.
+            _clusterBuffer.emplace_back(glyph, columnCount);
+            column += advance;
+            cols += columnCount;
 
-            } while (it);
+        } while (column < end);
 
-            // Do the painting.
-            THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
+        // Do the painting.
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
 
-            // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
-            // We're only allowed to draw the grid lines under certain circumstances.
-            if (_pData->IsGridLineDrawingAllowed())
+        // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
+        // We're only allowed to draw the grid lines under certain circumstances.
+        if (_pData->IsGridLineDrawingAllowed())
+        {
+            // See GH: 803
+            // If we found a wide character while we looped above, it's possible we skipped over the right half
+            // attribute that could have contained different line information than the left half.
+            if (containsWideCharacter)
             {
-                // See GH: 803
-                // If we found a wide character while we looped above, it's possible we skipped over the right half
-                // attribute that could have contained different line information than the left half.
-                if (containsWideCharacter)
-                {
-                    // Start from the original position in this run.
-                    auto lineIt = currentRunItStart;
-                    // Start from the original target in this run.
-                    auto lineTarget = currentRunTargetStart;
-
-                    // We need to go through the iterators again to ensure we get the lines associated with each
-                    // exact column. The code above will condense two-column characters into one, but it is possible
-                    // (like with the IME) that the line drawing characters will vary from the left to right half
-                    // of a wider character.
-                    // We could theoretically pre-pass for this in the loop above to be more efficient about walking
-                    // the iterator, but I fear it would make the code even more confusing than it already is.
-                    // Do that in the future if some WPR trace points you to this spot as super bad.
-                    for (til::CoordType colsPainted = 0; colsPainted < cols; ++colsPainted, ++lineIt, ++lineTarget.x)
-                    {
-                        auto lines = lineIt->TextAttr();
-                        _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
-                    }
-                }
-                else
+                // We need to go through the columns again to ensure we get the lines associated with each
+                // exact column. The code above will condense two-column characters into one, but it is possible
+                // (like with the IME) that the line drawing characters will vary from the left to right half
+                // of a wider character.
+                const auto runEndColumn = std::min(column, end);
+                auto lineTarget = currentRunTargetStart;
+                for (auto lineColumn = currentRunColumnStart; lineColumn < runEndColumn; ++lineColumn, ++lineTarget.x)
                 {
-                    // If nothing exciting is going on, draw the lines in bulk.
-                    _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
+                    _PaintBufferOutputGridLineHelper(pEngine, row.GetAttrByColumn(lineColumn), 1, lineTarget);
                 }
             }
+            else
+            {
+                // If nothing exciting is going on, draw the lines in bulk.
+                _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
+            }
         }
     }
 }
@@ -1002,6 +1445,174 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
     }
 }
 
+// Routine Description:
+// - Paint helper for engines that implement IRenderEngine::PaintBufferRow().
+// - Paints the grid lines of each attribute run of the given row that intersects with bufferLine.
+//   Runs are additionally split up at the edges of the hovered pattern, since it's underlined differently.
+// Arguments:
+// - row - The row that's being painted.
+// - bufferLine - The columns of the row that are being painted. Its top is ignored.
+// - target - The screen position of the left edge of bufferLine.
+// Return Value:
+// - <none>
+void Renderer::_PaintBufferRowGridLines(_In_ IRenderEngine* const pEngine,
+                                        const ROW& row,
+                                        const Viewport& bufferLine,
+                                        const til::point target)
+{
+    // The columns of the hovered pattern in this row, if any.
+    auto hoveredBeg = til::CoordTypeMax;
+    auto hoveredEnd = til::CoordTypeMax;
+    if (_hoveredInterval && _hoveredInterval->start.y <= target.y && target.y <= _hoveredInterval->stop.y)
+    {
+        hoveredBeg = _hoveredInterval->start.y == target.y ? _hoveredInterval->start.x : 0;
+        hoveredEnd = _hoveredInterval->stop.y == target.y ? _hoveredInterval->stop.x + 1 : til::CoordTypeMax;
+    }
+
+    const auto left = bufferLine.Left();
+    const auto right = bufferLine.RightExclusive();
+    til::CoordType runEnd = 0;
+
+    for (const auto& run : row.Attributes().runs())
+    {
+        auto beg = std::max(runEnd, left);
+        runEnd += run.length;
+        const auto end = std::min(runEnd, right);
+
+        while (beg < end)
+        {
+            auto next = end;
+            if (beg < hoveredBeg)
+            {
+                next = std::min(next, hoveredBeg);
+            }
+            else if (beg < hoveredEnd)
+            {
+                next = std::min(next, hoveredEnd);
+            }
+
+            _PaintBufferOutputGridLineHelper(pEngine, run.value, gsl::narrow_cast<size_t>(next - beg), { target.x + beg - left, target.y });
+            beg = next;
+        }
+
+        if (runEnd >= right)
+        {
+            break;
+        }
+    }
+}
+
+// Routine Description:
+// - Paints a frame around the part of each search highlight that intersects with bufferLine.
+//   Highlights spanning multiple rows are left open at the row boundaries.
+// Arguments:
+// - bufferLine - The cells of the row that are being painted.
+// - target - The screen position of the left edge of bufferLine.
+// Return Value:
+// - <none>
+void Renderer::_PaintSearchHighlights(_In_ IRenderEngine* const pEngine, const Viewport& bufferLine, const til::point target)
+{
+    const auto highlights = _pData->GetSearchHighlights();
+    if (highlights.empty())
+    {
+        return;
+    }
+
+    const auto y = bufferLine.Top();
+    const auto left = bufferLine.Left();
+    const auto right = bufferLine.RightExclusive();
+    const auto color = _renderSettings.GetColorAlias(ColorAlias::DefaultForeground);
+
+    // The highlights don't overlap, which means that they're ordered by their end as well.
+    auto it = std::lower_bound(highlights.begin(), highlights.end(), y, [](const til::point_span& highlight, const til::CoordType y) {
+        return highlight.end.y < y;
+    });
+
+    for (; it != highlights.end() && it->start.y <= y; ++it)
+    {
+        const auto opensHere = it->start.y == y;
+        const auto closesHere = it->end.y == y;
+        const auto beg = std::max(opensHere ? it->start.x : 0, left);
+        const auto end = std::min(closesHere ? it->end.x + 1 : right, right);
+        if (beg >= end)
+        {
+            continue;
+        }
+
+        const til::point begTarget{ target.x + beg - left, target.y };
+        const til::point endTarget{ target.x + end - 1 - left, target.y };
+        LOG_IF_FAILED(pEngine->PaintBufferGridLines({ GridLines::Top, GridLines::Bottom }, color, gsl::narrow_cast<size_t>(end - beg), begTarget));
+        if (opensHere && it->start.x >= left)
+        {
+            LOG_IF_FAILED(pEngine->PaintBufferGridLines(GridLines::Left, color, 1, begTarget));
+        }
+        if (closesHere && it->end.x < right)
+        {
+            LOG_IF_FAILED(pEngine->PaintBufferGridLines(GridLines::Right, color, 1, endTarget));
+        }
+    }
+}
+
+// Routine Description:
+// - Hands the visible parts of all search highlights to engines that draw them on a layer of their own.
+// Arguments:
+// - pEngine - The engine to paint the highlights with
+// Return Value:
+// - false if the engine doesn't have a search highlight layer and _PaintSearchHighlights() should be used instead.
+bool Renderer::_PaintSearchHighlightLayer(_In_ IRenderEngine* const pEngine)
+{
+    const auto highlights = _pData->GetSearchHighlights();
+    const auto view = _viewport;
+    const auto& buffer = _pData->GetTextBuffer();
+    const auto width = buffer.GetSize().Width();
+    const auto viewWidth = view.Width();
+    // The overscan row doesn't exist while the viewport is at the bottom of the buffer.
+    const auto rowEnd = std::min(view.BottomExclusive(), buffer.GetSize().BottomExclusive());
+
+    _searchHighlightRuns.clear();
+
+    // The highlights don't overlap, which means that they're ordered by their end as well.
+    auto it = std::lower_bound(highlights.begin(), highlights.end(), view.Top(), [](const til::point_span& highlight, const til::CoordType y) {
+        return highlight.end.y < y;
+    });
+
+    for (; it != highlights.end() && it->start.y < rowEnd; ++it)
+    {
+        const auto top = std::max(it->start.y, view.Top());
+        const auto bottom = std::min(it->end.y + 1, rowEnd);
+
+        for (auto y = top; y < bottom; ++y)
+        {
+            const auto opensHere = it->start.y == y;
+            const auto closesHere = it->end.y == y;
+            const auto shift = buffer.IsDoubleWidthLine(y) ? 1 : 0;
+            const auto left = ((opensHere ? it->start.x : 0) << shift) - view.Left();
+            const auto right = ((closesHere ? it->end.x + 1 : width) << shift) - view.Left();
+            const auto clampedLeft = std::max(left, 0);
+            const auto clampedRight = std::min(right, viewWidth);
+            if (clampedLeft >= clampedRight)
+            {
+                continue;
+            }
+
+            GridLineSet lines{ GridLines::Top, GridLines::Bottom };
+            lines.set(GridLines::Left, opensHere && left >= 0);
+            lines.set(GridLines::Right, closesHere && right <= viewWidth);
+            _searchHighlightRuns.push_back({ lines, y - view.Top(), clampedLeft, clampedRight });
+        }
+    }
+
+    const auto color = _renderSettings.GetColorAlias(ColorAlias::DefaultForeground);
+    const auto hr = pEngine->PaintSearchHighlightLayer(_searchHighlightRuns, color);
+    if (hr == E_NOTIMPL)
+    {
+        return false;
+    }
+
+    LOG_IF_FAILED(hr);
+    return true;
+}
+
 bool Renderer::_isHoveredHyperlink(const TextAttribute& textAttribute) const noexcept
 {
     return _hyperlinkHoveredId && _hyperlinkHoveredId == textAttribute.GetHyperlinkId();
@@ -1117,10 +1728,12 @@ void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine)
 // Arguments:
 // - engine - The render engine that we're targeting.
 // - overlay - The overlay to draw.
+// - areas - The viewport-relative areas of the overlay that should be painted.
 // Return Value:
 // - <none>
 void Renderer::_PaintOverlay(IRenderEngine& engine,
-                             const RenderOverlay& overlay)
+                             const RenderOverlay& overlay,
+                             std::span<const til::rect> areas)
 {
     try
     {
@@ -1131,10 +1744,7 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
         srCaView.left += overlay.origin.x;
         srCaView.right += overlay.origin.x;
 
-        std::span<const til::rect> dirtyAreas;
-        LOG_IF_FAILED(engine.GetDirtyArea(dirtyAreas));
-
-        for (const auto& rect : dirtyAreas)
+        for (const auto& rect : areas)
         {
             if (const auto viewDirty = rect & srCaView)
             {
@@ -1143,9 +1753,13 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
                     const til::point target{ viewDirty.left, iRow };
                     const auto source = target - overlay.origin;
 
-                    auto it = overlay.buffer.GetCellLineDataAt(source);
+                    if (!overlay.buffer.GetSize().IsInBounds(source))
+                    {
+                        continue;
+                    }
 
-                    _PaintBufferOutputHelper(&engine, it, target, false);
+                    const auto& row = overlay.buffer.GetRowByOffset(source.y);
+                    _PaintBufferOutputHelper(&engine, row, source.x, row.size(), target, false);
                 }
             }
         }
@@ -1167,9 +1781,30 @@ void Renderer::_PaintOverlays(_In_ IRenderEngine* const pEngine)
     {
         const auto overlays = _pData->GetOverlays();
 
+        // Engines with an overlay layer get the visible part of each overlay in its entirety,
+        // because the text underneath isn't necessarily being repainted along with it.
+        if (const auto hr = pEngine->StartOverlayLayer(); hr != E_NOTIMPL)
+        {
+            if (SUCCEEDED_LOG(hr))
+            {
+                const auto viewport = _viewport.ToOrigin().ToExclusive();
+
+                for (const auto& overlay : overlays)
+                {
+                    _PaintOverlay(*pEngine, overlay, { &viewport, 1 });
+                }
+
+                LOG_IF_FAILED(pEngine->EndOverlayLayer());
+            }
+            return;
+        }
+
+        std::span<const til::rect> dirtyAreas;
+        LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
+
         for (const auto& overlay : overlays)
         {
-            _PaintOverlay(*pEngine, overlay);
+            _PaintOverlay(*pEngine, overlay, dirtyAreas);
         }
     }
     CATCH_LOG();
@@ -1185,11 +1820,18 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 {
     try
     {
+        // Get selection rectangles
+        const auto rectangles = _GetSelectionRects();
+
+        if (const auto hr = pEngine->PaintSelectionLayer(rectangles); hr != E_NOTIMPL)
+        {
+            LOG_IF_FAILED(hr);
+            return;
+        }
+
         std::span<const til::rect> dirtyAreas;
         LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
 
-        // Get selection rectangles
-        const auto rectangles = _GetSelectionRects();
         for (const auto& rect : rectangles)
         {
             for (auto& dirtyRect : dirtyAreas)
@@ -1243,14 +1885,15 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 // - Helper to determine the selected region of the buffer.
 // Return Value:
 // - A vector of rectangles representing the regions to select, line by line.
-std::vector<til::rect> Renderer::_GetSelectionRects() const
+//   It's allocated from the frame arena and must not outlive the caller's til::pmr::frame_scope.
+std::pmr::vector<til::rect> Renderer::_GetSelectionRects() const
 {
     const auto& buffer = _pData->GetTextBuffer();
-    auto rects = _pData->GetSelectionRects();
+    auto rects = _pData->GetVisibleSelectionRects();
     // Adjust rectangles to viewport
     auto view = _pData->GetViewport();
 
-    std::vector<til::rect> result;
+    std::pmr::vector<til::rect> result{ til::pmr::get_frame_arena() };
     result.reserve(rects.size());
 
     for (auto rect : rects)
@@ -1303,6 +1946,7 @@ void Renderer::AddRenderEngine(_In_ IRenderEngine* const pEngine)
         if (!p)
         {
             p = pEngine;
+            pEngine->SetPerfCounters(&_perfCounters);
             return;
         }
     }
@@ -1318,6 +1962,7 @@ void Renderer::RemoveRenderEngine(_In_ IRenderEngine* const pEngine)
     {
         if (p == pEngine)
         {
+            pEngine->SetPerfCounters(nullptr);
             p = nullptr;
             return;
         }
@@ -1358,6 +2003,18 @@ void Renderer::SetRendererEnteredErrorStateCallback(std::function<void()> pfn)
     _pfnRendererEnteredErrorState = std::move(pfn);
 }
 
+// Method Description:
+// - Registers a callback for when a frame with the echo of a key press was presented.
+//   It's called on the render thread with the time since the key press was sent.
+// Arguments:
+// - pfn: the callback
+// Return Value:
+// - <none>
+void Renderer::SetInputLatencyCallback(std::function<void(std::chrono::microseconds)> pfn)
+{
+    _pfnInputLatency = std::move(pfn);
+}
+
 // Method Description:
 // - Attempts to restart the renderer.
 void Renderer::ResetErrorStateAndResume()
@@ -1380,6 +2037,14 @@ void Renderer::UpdateLastHoveredInterval(const std::optional<PointTree::interval
     _hoveredInterval = newInterval;
 }
 
+// Method Description:
+// - Returns the counters for this renderer's output pipeline. They're shared with
+//   its engines as well as the TextBuffer and parser that are feeding it.
+PerfCounters& Renderer::GetPerfCounters() noexcept
+{
+    return _perfCounters;
+}
+
 // Method Description:
 // - Blocks until the engines are able to render without blocking.
 void Renderer::WaitUntilCanRender()
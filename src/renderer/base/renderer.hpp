@@ -33,6 +33,14 @@ namespace TerminalCoreUnitTests
 
 namespace Microsoft::Console::Render
 {
+    enum class OcclusionReason : uint8_t
+    {
+        // The window is minimized or otherwise hidden.
+        WindowHidden,
+        // The session is locked, or the user switched to another session.
+        SessionLocked,
+    };
+
     class Renderer
     {
     public:
@@ -49,14 +57,18 @@ namespace Microsoft::Console::Render
         void NotifyPaintFrame() noexcept;
         void TriggerSystemRedraw(const til::rect* const prcDirtyClient);
         void TriggerRedraw(const Microsoft::Console::Types::Viewport& region);
+        void TriggerRedrawOverlay(const Microsoft::Console::Types::Viewport& region);
+        void TriggerRedrawSearchHighlights(std::span<const til::point_span> highlights);
         void TriggerRedraw(const til::point* const pcoord);
         void TriggerRedrawCursor(const til::point* const pcoord);
         void TriggerRedrawAll(const bool backgroundChanged = false, const bool frameChanged = false);
+        void TriggerRedrawBlinking();
         void TriggerTeardown() noexcept;
 
         void TriggerSelection();
         void TriggerScroll();
         void TriggerScroll(const til::point* const pcoordDelta);
+        void TriggerScrollRegion(const til::rect& region, const til::CoordType delta);
 
         void TriggerFlush(const bool circling);
         void TriggerTitleChange();
@@ -79,7 +91,17 @@ namespace Microsoft::Console::Render
 
         void EnablePainting();
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs);
+        void SetHighPriority(const bool highPriority) noexcept;
+        void SetPacingMode(const PacingMode mode) noexcept;
+        void SetSmoothScrolling(const bool enabled) noexcept;
+        void SetSmoothScrollOffset(const float rows) noexcept;
+        void SetOccluded(const OcclusionReason reason, const bool occluded);
+        void SetSynchronizedOutput(const bool enabled) noexcept;
+        bool IsSynchronizingOutput() const noexcept;
+        DWORD GetSynchronizedOutputDelay() const noexcept;
+        void WaitForSynchronizedOutput() noexcept;
         void WaitUntilCanRender();
+        PerfCounters& GetPerfCounters() noexcept;
 
         void AddRenderEngine(_In_ IRenderEngine* const pEngine);
         void RemoveRenderEngine(_In_ IRenderEngine* const pEngine);
@@ -87,6 +109,7 @@ namespace Microsoft::Console::Render
         void SetBackgroundColorChangedCallback(std::function<void()> pfn);
         void SetFrameColorChangedCallback(std::function<void()> pfn);
         void SetRendererEnteredErrorStateCallback(std::function<void()> pfn);
+        void SetInputLatencyCallback(std::function<void(std::chrono::microseconds)> pfn);
         void ResetErrorStateAndResume();
 
         void UpdateHyperlinkHoveredId(uint16_t id) noexcept;
@@ -97,19 +120,23 @@ namespace Microsoft::Console::Render
         static bool s_IsSoftFontChar(const std::wstring_view& v, const size_t firstSoftFontChar, const size_t lastSoftFontChar);
 
         [[nodiscard]] HRESULT _PaintFrameForEngine(_In_ IRenderEngine* const pEngine) noexcept;
+        Microsoft::Console::Types::Viewport _GetRenderViewport() const;
         bool _CheckViewportAndScroll();
         [[nodiscard]] HRESULT _PaintBackground(_In_ IRenderEngine* const pEngine);
         void _PaintBufferOutput(_In_ IRenderEngine* const pEngine);
-        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const til::point target, const bool lineWrapped);
+        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, const ROW& row, const til::CoordType columnBegin, const til::CoordType columnEnd, const til::point target, const bool lineWrapped);
         void _PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngine, const TextAttribute textAttribute, const size_t cchLine, const til::point coordTarget);
+        void _PaintBufferRowGridLines(_In_ IRenderEngine* const pEngine, const ROW& row, const Microsoft::Console::Types::Viewport& bufferLine, const til::point target);
+        void _PaintSearchHighlights(_In_ IRenderEngine* const pEngine, const Microsoft::Console::Types::Viewport& bufferLine, const til::point target);
+        bool _PaintSearchHighlightLayer(_In_ IRenderEngine* const pEngine);
         bool _isHoveredHyperlink(const TextAttribute& textAttribute) const noexcept;
         void _PaintSelection(_In_ IRenderEngine* const pEngine);
         void _PaintCursor(_In_ IRenderEngine* const pEngine);
         void _PaintOverlays(_In_ IRenderEngine* const pEngine);
-        void _PaintOverlay(IRenderEngine& engine, const RenderOverlay& overlay);
+        void _PaintOverlay(IRenderEngine& engine, const RenderOverlay& overlay, std::span<const til::rect> areas);
         [[nodiscard]] HRESULT _UpdateDrawingBrushes(_In_ IRenderEngine* const pEngine, const TextAttribute attr, const bool usingSoftFont, const bool isSettingDefaultBrushes);
         [[nodiscard]] HRESULT _PerformScrolling(_In_ IRenderEngine* const pEngine);
-        std::vector<til::rect> _GetSelectionRects() const;
+        std::pmr::vector<til::rect> _GetSelectionRects() const;
         void _ScrollPreviousSelection(const til::point delta);
         [[nodiscard]] HRESULT _PaintTitle(IRenderEngine* const pEngine);
         bool _isInHoveredInterval(til::point coordTarget) const noexcept;
@@ -120,6 +147,7 @@ namespace Microsoft::Console::Render
         std::array<IRenderEngine*, 2> _engines{};
         IRenderData* _pData = nullptr; // Non-ownership pointer
         std::unique_ptr<RenderThread> _pThread;
+        PerfCounters _perfCounters;
         static constexpr size_t _firstSoftFontChar = 0xEF20;
         size_t _lastSoftFontChar = 0;
         uint16_t _hyperlinkHoveredId = 0;
@@ -127,11 +155,20 @@ namespace Microsoft::Console::Render
         Microsoft::Console::Types::Viewport _viewport;
         std::vector<Cluster> _clusterBuffer;
         std::vector<til::rect> _previousSelection;
+        std::vector<SearchHighlightRun> _searchHighlightRuns;
         std::function<void()> _pfnBackgroundColorChanged;
         std::function<void()> _pfnFrameColorChanged;
         std::function<void()> _pfnRendererEnteredErrorState;
+        std::function<void(std::chrono::microseconds)> _pfnInputLatency;
         bool _destructing = false;
         bool _forceUpdateViewport = false;
+        bool _smoothScrolling = false;
+        float _smoothScrollOffset = 0;
+        // A bitmask of OcclusionReasons. See SetOccluded().
+        std::atomic<uint8_t> _occlusion{ 0 };
+        // See SetSynchronizedOutput(). The deadline is a steady_clock::time_point's tick count.
+        std::atomic<bool> _isSynchronizingOutput{ false };
+        std::atomic<std::chrono::steady_clock::rep> _synchronizedOutputDeadline{ 0 };
 
 #ifdef UNIT_TESTING
         friend class ConptyOutputTests;
@@ -18,12 +18,34 @@ RenderThread::RenderThread() :
     _fKeepRunning(true),
     _hPaintEnabledEvent(nullptr),
     _fNextFrameRequested(false),
-    _fWaiting(false)
+    _fWaiting(false),
+    _fHighPriority(false),
+    _pacingInterval(0),
+    _scheduledFrameTime(INT64_MAX)
 {
 }
 
+// Method Description:
+// - Creates a RenderThread without a thread of its own. Its frames are
+//      painted by the given SharedRenderThread instead.
+// Arguments:
+// - sharedThread: the SharedRenderThread to register with during Initialize().
+RenderThread::RenderThread(std::shared_ptr<SharedRenderThread> sharedThread) noexcept :
+    RenderThread()
+{
+    _sharedThread = std::move(sharedThread);
+}
+
 RenderThread::~RenderThread()
 {
+    if (_sharedThread)
+    {
+        // Unlike with a dedicated thread there's no final frame: The SharedRenderThread
+        // keeps running for the other clients and the renderer is being destroyed anyways.
+        _sharedThread->_Unregister(this);
+        _sharedThread.reset();
+    }
+
     if (_hThread)
     {
         _fKeepRunning = false; // stop loop after final run
@@ -120,6 +142,17 @@ RenderThread::~RenderThread()
         }
     }
 
+    if (SUCCEEDED(hr) && _sharedThread)
+    {
+        try
+        {
+            _sharedThread->_Register(this);
+        }
+        CATCH_RETURN();
+
+        return S_OK;
+    }
+
     if (SUCCEEDED(hr))
     {
         auto hThread = CreateThread(nullptr, // non-inheritable security attributes
@@ -183,8 +216,8 @@ DWORD WINAPI RenderThread::_ThreadProc()
             // check again now (see comment above)
             if (!_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
             {
-                // Wait until a next frame is requested.
-                WaitForSingleObject(_hEvent, INFINITE);
+                // Wait until a next frame is requested or a scheduled one is due.
+                WaitForSingleObject(_hEvent, _GetScheduledFrameDelay());
             }
 
             // <--
@@ -208,20 +241,111 @@ DWORD WINAPI RenderThread::_ThreadProc()
             ResetEvent(_hEvent);
         }
 
-        ResetEvent(_hPaintCompletedEvent);
+        // Any NotifyPaint() calls while we're sleeping are coalesced into the upcoming frame.
+        if (const auto delay = _GetPacingDelay())
+        {
+            Sleep(delay);
+        }
 
-        _pRenderer->WaitUntilCanRender();
-        LOG_IF_FAILED(_pRenderer->PaintFrame());
+        // Hold off while the application is in the middle of a synchronized update (DECSET 2026).
+        _pRenderer->WaitForSynchronizedOutput();
 
-        SetEvent(_hPaintCompletedEvent);
+        _PaintFrame();
     }
 
     return S_OK;
 }
 
+void RenderThread::_PaintFrame() noexcept
+{
+    ResetEvent(_hPaintCompletedEvent);
+
+    _lastFrameStart = std::chrono::steady_clock::now();
+    // Whatever a scheduled frame would've painted is painted now.
+    _scheduledFrameTime.store(INT64_MAX, std::memory_order_relaxed);
+
+    _pRenderer->WaitUntilCanRender();
+    LOG_IF_FAILED(_pRenderer->PaintFrame());
+
+    SetEvent(_hPaintCompletedEvent);
+}
+
+// Method Description:
+// - Returns how long to wait before the next frame may be painted according to the PacingMode.
+// Return Value:
+// - The delay in milliseconds, or 0 if the frame can be painted right away.
+DWORD RenderThread::_GetPacingDelay() const noexcept
+{
+    const std::chrono::microseconds interval{ _pacingInterval.load(std::memory_order_relaxed) };
+    if (interval.count() == 0)
+    {
+        return 0;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - _lastFrameStart;
+    if (elapsed >= interval)
+    {
+        return 0;
+    }
+
+    return gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(interval - elapsed).count());
+}
+
+// Method Description:
+// - Returns how long to wait until the frame requested by NotifyPaintAfter() is due.
+// Return Value:
+// - The delay in milliseconds, 0 if the frame is due, or INFINITE if none was requested.
+DWORD RenderThread::_GetScheduledFrameDelay() const noexcept
+{
+    const auto scheduled = _scheduledFrameTime.load(std::memory_order_relaxed);
+    if (scheduled == INT64_MAX)
+    {
+        return INFINITE;
+    }
+
+    const std::chrono::steady_clock::time_point time{ std::chrono::steady_clock::duration{ scheduled } };
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= time)
+    {
+        return 0;
+    }
+
+    return gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(time - now).count());
+}
+
+// Method Description:
+// - Requests a frame once the given delay has elapsed, unless another one gets painted earlier.
+//      This is meant to be called while painting a frame, like Renderer does for engines
+//      that require continuous redraw at a limited frame rate.
+// Arguments:
+// - delayMs: the delay in milliseconds. 0 is the same as calling NotifyPaint().
+void RenderThread::NotifyPaintAfter(const DWORD delayMs) noexcept
+{
+    if (!delayMs)
+    {
+        NotifyPaint();
+        return;
+    }
+
+    const auto time = std::chrono::steady_clock::now() + std::chrono::milliseconds{ delayMs };
+    _scheduledFrameTime.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+
+    // A dedicated thread picks up the delay when it goes to sleep after this frame.
+    // The SharedRenderThread however has already computed its timeout for this round.
+    if (_sharedThread)
+    {
+        _sharedThread->_NotifyPaint();
+    }
+}
+
 void RenderThread::NotifyPaint() noexcept
 {
-    if (_fWaiting.load(std::memory_order_acquire))
+    if (_sharedThread)
+    {
+        _fNextFrameRequested.store(true, std::memory_order_release);
+        _sharedThread->_NotifyPaint();
+    }
+    else if (_fWaiting.load(std::memory_order_acquire))
     {
         SetEvent(_hEvent);
     }
@@ -234,6 +358,13 @@ void RenderThread::NotifyPaint() noexcept
 void RenderThread::EnablePainting() noexcept
 {
     SetEvent(_hPaintEnabledEvent);
+
+    // The SharedRenderThread skips over disabled clients but keeps their frame
+    // requests pending. It needs to be woken up to finally handle them.
+    if (_sharedThread)
+    {
+        _sharedThread->_NotifyPaint();
+    }
 }
 
 void RenderThread::DisablePainting() noexcept
@@ -297,3 +428,249 @@ void RenderThread::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) noe
     ResetEvent(_hPaintEnabledEvent);
     WaitForSingleObject(_hPaintCompletedEvent, dwTimeoutMs);
 }
+
+// Method Description:
+// - Sets whether this RenderThread should be painted before others sharing the same SharedRenderThread.
+//      This has no effect for RenderThreads with a dedicated thread.
+// Arguments:
+// - highPriority: true for the focused pane, false otherwise.
+void RenderThread::SetHighPriority(const bool highPriority) noexcept
+{
+    _fHighPriority.store(highPriority, std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Sets whether frames should be painted as soon as possible or at most once per display refresh.
+//      Either way the engine's WaitUntilCanRender() still blocks until it can accept a new frame.
+// Arguments:
+// - mode: the new PacingMode.
+void RenderThread::SetPacingMode(const PacingMode mode) noexcept
+{
+    uint32_t interval = 0;
+
+    if (mode == PacingMode::Throughput)
+    {
+        // dmDisplayFrequency is 0 or 1 if the display uses the hardware's default refresh rate.
+        DEVMODEW dm{};
+        dm.dmSize = sizeof(dm);
+        DWORD frequency = 60;
+        if (EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1)
+        {
+            frequency = dm.dmDisplayFrequency;
+        }
+        interval = 1'000'000 / frequency;
+    }
+    else if (mode == PacingMode::Throttled)
+    {
+        interval = 100'000;
+    }
+
+    _pacingInterval.store(interval, std::memory_order_relaxed);
+}
+
+std::shared_ptr<SharedRenderThread> SharedRenderThread::GetForCurrentThread()
+{
+    // The SharedRenderThread is reference counted by the RenderThreads using it
+    // and exits once the last one of them (= the last pane of a window) is gone.
+    thread_local std::weak_ptr<SharedRenderThread> current;
+
+    auto shared = current.lock();
+    if (!shared)
+    {
+        shared = std::make_shared<SharedRenderThread>();
+        THROW_IF_FAILED(shared->Initialize());
+        current = shared;
+    }
+    return shared;
+}
+
+SharedRenderThread::SharedRenderThread() :
+    _hThread(nullptr),
+    _hEvent(nullptr),
+    _painting(nullptr),
+    _fKeepRunning(true),
+    _fNextFrameRequested(false),
+    _fWaiting(false)
+{
+}
+
+SharedRenderThread::~SharedRenderThread()
+{
+    if (_hThread)
+    {
+        _fKeepRunning.store(false, std::memory_order_relaxed);
+        SignalObjectAndWait(_hEvent, _hThread, INFINITE, FALSE);
+
+        CloseHandle(_hThread);
+        _hThread = nullptr;
+    }
+
+    if (_hEvent)
+    {
+        CloseHandle(_hEvent);
+        _hEvent = nullptr;
+    }
+}
+
+// Method Description:
+// - Creates the Event we're woken up with and the actual thread we'll be doing work on.
+// Return Value:
+// - S_OK if we succeeded, else an HRESULT corresponding to a failure to create
+//      the Event or Thread.
+[[nodiscard]] HRESULT SharedRenderThread::Initialize() noexcept
+{
+    _hEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    RETURN_LAST_ERROR_IF_NULL(_hEvent);
+
+    _hThread = CreateThread(nullptr, 0, s_ThreadProc, this, 0, nullptr);
+    RETURN_LAST_ERROR_IF_NULL(_hThread);
+
+    // SetThreadDescription only works on 1607 and higher. If we cannot find it,
+    // then it's no big deal. Just skip setting the description.
+    auto func = GetProcAddressByFunctionDeclaration(GetModuleHandleW(L"kernel32.dll"), SetThreadDescription);
+    if (func)
+    {
+        LOG_IF_FAILED(func(_hThread, L"Shared Rendering Output Thread"));
+    }
+
+    return S_OK;
+}
+
+void SharedRenderThread::_Register(RenderThread* const client)
+{
+    {
+        const std::lock_guard guard{ _clientsMutex };
+        _clients.emplace_back(client);
+    }
+
+    // The client might have requested a frame before it was registered.
+    _NotifyPaint();
+}
+
+void SharedRenderThread::_Unregister(RenderThread* const client) noexcept
+{
+    {
+        const std::lock_guard guard{ _clientsMutex };
+        std::erase(_clients, client);
+    }
+
+    // Once the client is removed from _clients, the thread won't start painting it again.
+    // But it might still be in the middle of doing so, in which case we have to wait.
+    for (auto painting = _painting.load(std::memory_order_acquire); painting == client; painting = _painting.load(std::memory_order_acquire))
+    {
+        _painting.wait(painting, std::memory_order_acquire);
+    }
+}
+
+void SharedRenderThread::_NotifyPaint() noexcept
+{
+    if (_fWaiting.load(std::memory_order_acquire))
+    {
+        SetEvent(_hEvent);
+    }
+    else
+    {
+        _fNextFrameRequested.store(true, std::memory_order_release);
+    }
+}
+
+DWORD WINAPI SharedRenderThread::s_ThreadProc(_In_ LPVOID lpParameter)
+{
+    const auto pContext = static_cast<SharedRenderThread*>(lpParameter);
+
+    if (pContext != nullptr)
+    {
+        return pContext->_ThreadProc();
+    }
+    else
+    {
+        return (DWORD)E_INVALIDARG;
+    }
+}
+
+DWORD WINAPI SharedRenderThread::_ThreadProc()
+{
+    std::vector<RenderThread*> clients;
+    // If a client's frame was deferred due to its PacingMode, we wake up again after this many milliseconds.
+    DWORD timeout = INFINITE;
+
+    while (_fKeepRunning.load(std::memory_order_relaxed))
+    {
+        // See RenderThread::_ThreadProc() for an explanation of this dance.
+        if (!_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
+        {
+            _fWaiting.store(true, std::memory_order_release);
+
+            if (!_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
+            {
+                WaitForSingleObject(_hEvent, timeout);
+            }
+
+            _fWaiting.store(false, std::memory_order_release);
+            ResetEvent(_hEvent);
+        }
+
+        if (!_fKeepRunning.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+
+        timeout = INFINITE;
+
+        {
+            const std::lock_guard guard{ _clientsMutex };
+            clients = _clients;
+        }
+
+        // The focused pane is painted first, so that its frame gets out as early as possible.
+        std::stable_partition(clients.begin(), clients.end(), [](const RenderThread* client) {
+            return client->_fHighPriority.load(std::memory_order_relaxed);
+        });
+
+        // All clients are painted in a single pass, which results in their frames getting presented back to back.
+        for (const auto client : clients)
+        {
+            {
+                const std::lock_guard guard{ _clientsMutex };
+                // The client might have been unregistered since we made our copy of _clients.
+                if (std::find(_clients.begin(), _clients.end(), client) == _clients.end())
+                {
+                    continue;
+                }
+                _painting.store(client, std::memory_order_relaxed);
+            }
+
+            // Disabled clients keep their frame request pending until EnablePainting() wakes us up.
+            // Instead of sleeping (and delaying all other clients), clients that aren't due for their next
+            // frame yet keep it pending as well, and we wake up again once the earliest of them is due.
+            // The same goes for clients in the middle of a synchronized update, whose end wakes us up early.
+            // Frames scheduled with NotifyPaintAfter() turn into regular requests once they're due.
+            if (const auto scheduledDelay = client->_GetScheduledFrameDelay(); scheduledDelay == 0)
+            {
+                client->_fNextFrameRequested.store(true, std::memory_order_release);
+            }
+            else if (scheduledDelay != INFINITE)
+            {
+                timeout = std::min(timeout, scheduledDelay);
+            }
+
+            if (WaitForSingleObject(client->_hPaintEnabledEvent, 0) == WAIT_OBJECT_0 &&
+                client->_fNextFrameRequested.load(std::memory_order_acquire))
+            {
+                if (const auto delay = std::max(client->_GetPacingDelay(), client->_pRenderer->GetSynchronizedOutputDelay()))
+                {
+                    timeout = std::min(timeout, delay);
+                }
+                else if (client->_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
+                {
+                    client->_PaintFrame();
+                }
+            }
+
+            _painting.store(nullptr, std::memory_order_release);
+            _painting.notify_all();
+        }
+    }
+
+    return S_OK;
+}
@@ -7,6 +7,8 @@ Module Name:
 
 Abstract:
 - This is the definition of our rendering thread designed to throttle and compartmentalize drawing operations.
+- A RenderThread either owns a dedicated thread or shares a SharedRenderThread with other RenderThreads,
+  for instance with all other panes in the same window.
 
 Author(s):
 - Michael Niksa (MiNiksa) Feb 2016
@@ -17,23 +19,43 @@ Author(s):
 namespace Microsoft::Console::Render
 {
     class Renderer;
+    class SharedRenderThread;
+
+    enum class PacingMode
+    {
+        // Frames are painted as soon as they're requested, for instance right after a typed character was echoed.
+        LowLatency,
+        // Frames are painted at most once per display refresh, coalescing bursts of output into fewer frames.
+        Throughput,
+        // Frames are painted at most 10 times per second. Used while a flood of output would otherwise keep the renderer busy.
+        Throttled,
+    };
 
     class RenderThread
     {
     public:
         RenderThread();
+        explicit RenderThread(std::shared_ptr<SharedRenderThread> sharedThread) noexcept;
         ~RenderThread();
 
         [[nodiscard]] HRESULT Initialize(Renderer* const pRendererParent) noexcept;
 
         void NotifyPaint() noexcept;
+        void NotifyPaintAfter(const DWORD delayMs) noexcept;
         void EnablePainting() noexcept;
         void DisablePainting() noexcept;
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) noexcept;
+        void SetHighPriority(const bool highPriority) noexcept;
+        void SetPacingMode(const PacingMode mode) noexcept;
 
     private:
+        friend class SharedRenderThread;
+
         static DWORD WINAPI s_ThreadProc(_In_ LPVOID lpParameter);
         DWORD WINAPI _ThreadProc();
+        void _PaintFrame() noexcept;
+        DWORD _GetPacingDelay() const noexcept;
+        DWORD _GetScheduledFrameDelay() const noexcept;
 
         HANDLE _hThread;
         HANDLE _hEvent;
@@ -46,5 +68,58 @@ namespace Microsoft::Console::Render
         bool _fKeepRunning;
         std::atomic<bool> _fNextFrameRequested;
         std::atomic<bool> _fWaiting;
+        std::atomic<bool> _fHighPriority;
+
+        // The minimum time between the start of two frames in microseconds. 0 for PacingMode::LowLatency.
+        std::atomic<uint32_t> _pacingInterval;
+        // Only accessed by the thread that paints this RenderThread's frames.
+        std::chrono::steady_clock::time_point _lastFrameStart;
+        // The steady_clock time at which NotifyPaintAfter() requested the next frame. INT64_MAX if there's none.
+        std::atomic<int64_t> _scheduledFrameTime;
+
+        // If set, this RenderThread has no thread of its own and _hThread and _hEvent are unused.
+        std::shared_ptr<SharedRenderThread> _sharedThread;
+    };
+
+    // A single thread that paints the frames of multiple RenderThreads. Compared to a thread per
+    // RenderThread this results in fewer wakeups and ensures that the frames of all of them are
+    // presented back to back, instead of each at its own time. RenderThreads with a high
+    // priority (the focused pane) are painted first.
+    class SharedRenderThread
+    {
+    public:
+        // Returns the SharedRenderThread for the calling thread, creating it if needed. In
+        // Windows Terminal each window has its own UI thread, which makes this one per window.
+        static std::shared_ptr<SharedRenderThread> GetForCurrentThread();
+
+        SharedRenderThread();
+        ~SharedRenderThread();
+
+        SharedRenderThread(const SharedRenderThread&) = delete;
+        SharedRenderThread& operator=(const SharedRenderThread&) = delete;
+
+        [[nodiscard]] HRESULT Initialize() noexcept;
+
+    private:
+        friend class RenderThread;
+
+        void _Register(RenderThread* const client);
+        void _Unregister(RenderThread* const client) noexcept;
+        void _NotifyPaint() noexcept;
+
+        static DWORD WINAPI s_ThreadProc(_In_ LPVOID lpParameter);
+        DWORD WINAPI _ThreadProc();
+
+        HANDLE _hThread;
+        HANDLE _hEvent;
+
+        std::mutex _clientsMutex;
+        std::vector<RenderThread*> _clients; // Non-ownership pointers, guarded by _clientsMutex.
+        // The client that is currently being painted. _Unregister() waits until it's not this client anymore.
+        std::atomic<RenderThread*> _painting;
+
+        std::atomic<bool> _fKeepRunning;
+        std::atomic<bool> _fNextFrameRequested;
+        std::atomic<bool> _fWaiting;
     };
 }
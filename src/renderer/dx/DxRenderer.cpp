@@ -1125,7 +1125,7 @@ CATCH_RETURN();
 // - rectangles - One or more rectangles describing character positions on the grid
 // Return Value:
 // - S_OK
-[[nodiscard]] HRESULT DxEngine::InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept
+[[nodiscard]] HRESULT DxEngine::InvalidateSelection(std::span<const til::rect> rectangles) noexcept
 {
     if (!_allInvalid)
     {
@@ -27,8 +27,9 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT SetHwnd(const HWND hwnd) noexcept;
 
-        [[nodiscard]] HRESULT InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept override;
+        [[nodiscard]] HRESULT InvalidateSelection(std::span<const til::rect> rectangles) noexcept override;
         [[nodiscard]] HRESULT InvalidateScroll(const til::point* const pcoordDelta) noexcept override;
+        [[nodiscard]] HRESULT InvalidateScrollRegion(const til::rect* const psrRegion, const til::CoordType delta) noexcept override;
         [[nodiscard]] HRESULT InvalidateSystem(const til::rect* const prcDirtyClient) noexcept override;
         [[nodiscard]] HRESULT Invalidate(const til::rect* const psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateCursor(const til::rect* const psrRegion) noexcept override;
@@ -104,9 +105,21 @@ namespace Microsoft::Console::Render
         TEXTMETRICW _tmFontMetrics;
         FontResource _softFont;
 
-        static const size_t s_cPolyTextCache = 80;
-        POLYTEXTW _pPolyText[s_cPolyTextCache];
-        size_t _cPolyText;
+        // The lines cached for PolyTextOutW(). Their text and advances are stored back to back in per-frame
+        // arenas, which only grow and are reset with clear(), so that their capacity is reused by later frames.
+        // Since the arenas may move while they grow, lpstr and pdx are only filled in by _FlushBufferLines(),
+        // based on the offsets stored in _polyOffsets for each line.
+        struct PolyTextOffsets
+        {
+            size_t text;
+            size_t width;
+        };
+        std::vector<POLYTEXTW> _polyTexts;
+        std::vector<PolyTextOffsets> _polyOffsets;
+        std::vector<wchar_t> _polyTextArena;
+        std::vector<int> _polyWidthArena;
+        // Scratch buffer for the conversion of text for raster fonts.
+        std::string _polyConvertBuffer;
         [[nodiscard]] HRESULT _FlushBufferLines() noexcept;
 
         std::vector<RECT> cursorInvertRects;
@@ -133,6 +146,11 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _PrepareMemoryBitmap(const HWND hwnd) noexcept;
 
         til::size _szInvalidScroll;
+        // A pending scroll of the rows within a part of the viewport, in pixels. It's never pending
+        // at the same time as _szInvalidScroll, because InvalidateScroll() turns it into an invalidation.
+        til::rect _rcInvalidScrollRegion;
+        til::CoordType _invalidScrollRegionDelta = 0;
+        [[nodiscard]] HRESULT _InvalidScrollRegionFallback() noexcept;
         til::rect _rcInvalid;
         bool _fInvalidRectUsed;
 
@@ -152,13 +170,6 @@ namespace Microsoft::Console::Render
         XFORM _currentLineTransform;
         LineRendition _currentLineRendition;
 
-        // Memory pooling to save alloc/free work to the OS for things
-        // frequently created and dropped.
-        // It's important the pool is first so it can be given to the others on construction.
-        std::pmr::unsynchronized_pool_resource _pool;
-        std::pmr::vector<std::pmr::wstring> _polyStrings;
-        std::pmr::vector<std::pmr::basic_string<int>> _polyWidths;
-
         [[nodiscard]] HRESULT _InvalidCombine(const til::rect* const prc) noexcept;
         [[nodiscard]] HRESULT _InvalidOffset(const til::point* const ppt) noexcept;
         [[nodiscard]] HRESULT _InvalidRestrict() noexcept;
@@ -32,6 +32,8 @@ HRESULT GdiEngine::InvalidateScroll(const til::point* const pcoordDelta) noexcep
 {
     if (pcoordDelta->x != 0 || pcoordDelta->y != 0)
     {
+        RETURN_IF_FAILED(_InvalidScrollRegionFallback());
+
         const auto ptDelta = *pcoordDelta * _GetFontSize();
         RETURN_IF_FAILED(_InvalidOffset(&ptDelta));
         _szInvalidScroll = _szInvalidScroll + ptDelta;
@@ -40,13 +42,72 @@ HRESULT GdiEngine::InvalidateScroll(const til::point* const pcoordDelta) noexcep
     return S_OK;
 }
 
+// Routine Description:
+// - Notifies us that the console has moved the rows within a part of the screen up or down, like a scroll region does.
+// - ScrollFrame() will then move the existing pixels, instead of us painting the entire region again.
+//   We only track a single pending region. Region scrolls that can't be combined with it
+//   are invalidated instead, just like a simple Invalidate() would.
+// Arguments:
+// - psrRegion - Character region (til::rect) whose rows were moved
+// - delta - The number of rows the contents moved by (positive is down, negative is up)
+// Return Value:
+// - HRESULT S_OK, GDI-based error code, or safemath error
+HRESULT GdiEngine::InvalidateScrollRegion(const til::rect* const psrRegion, const til::CoordType delta) noexcept
+{
+    const auto coordFontSize = _GetFontSize();
+    const auto rcRegion = psrRegion->scale_up(coordFontSize);
+    const auto deltaInPx = delta * coordFontSize.height;
+
+    // Moving the contents back and forth may lose rows at the edges, which a combined delta wouldn't reveal.
+    const auto combinable = _invalidScrollRegionDelta == 0 ?
+                                _szInvalidScroll == til::size{} :
+                                rcRegion == _rcInvalidScrollRegion && (deltaInPx < 0) == (_invalidScrollRegionDelta < 0);
+    if (delta == 0 || !combinable)
+    {
+        RETURN_IF_FAILED(_InvalidScrollRegionFallback());
+        RETURN_HR(Invalidate(psrRegion));
+    }
+
+    // The invalid parts of the region move along with the region's contents.
+    // Like in _InvalidOffset(), they're added to what was left behind.
+    if (_fInvalidRectUsed)
+    {
+        auto rcMoved = _rcInvalid & rcRegion;
+        rcMoved.top += deltaInPx;
+        rcMoved.bottom += deltaInPx;
+        rcMoved &= rcRegion;
+        _rcInvalid |= rcMoved;
+    }
+
+    _rcInvalidScrollRegion = rcRegion;
+    _invalidScrollRegionDelta += deltaInPx;
+    return S_OK;
+}
+
+// Routine Description:
+// - Turns the pending region scroll, if any, into an invalidation of the entire region.
+// Arguments:
+// - <none>
+// Return Value:
+// - HRESULT S_OK, GDI-based error code, or safemath error
+HRESULT GdiEngine::_InvalidScrollRegionFallback() noexcept
+{
+    if (_invalidScrollRegionDelta != 0)
+    {
+        _invalidScrollRegionDelta = 0;
+        RETURN_IF_FAILED(_InvalidateRect(&_rcInvalidScrollRegion));
+    }
+
+    return S_OK;
+}
+
 // Routine Description:
 // - Notifies us that the console has changed the selection region and would like it updated
 // Arguments:
 // - rectangles - Vector of rectangles to draw, line by line
 // Return Value:
 // - HRESULT S_OK or GDI-based error code
-HRESULT GdiEngine::InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept
+HRESULT GdiEngine::InvalidateSelection(std::span<const til::rect> rectangles) noexcept
 {
     for (const auto& rect : rectangles)
     {
@@ -40,7 +40,10 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
     RETURN_HR_IF(S_FALSE, (!IsWindowVisible(_hwndTargetWindow) && !_titleChanged));
 
     // At the beginning of a new frame, we have 0 lines ready for painting in PolyTextOut
-    _cPolyText = 0;
+    _polyTexts.clear();
+    _polyOffsets.clear();
+    _polyTextArena.clear();
+    _polyWidthArena.clear();
 
     // Prepare our in-memory bitmap for double-buffered composition.
     RETURN_IF_FAILED(_PrepareMemoryBitmap(_hwndTargetWindow));
@@ -79,7 +82,7 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
 [[nodiscard]] HRESULT GdiEngine::ScrollFrame() noexcept
 {
     // If we don't have any scrolling to do, return early.
-    RETURN_HR_IF(S_OK, 0 == _szInvalidScroll.width && 0 == _szInvalidScroll.height);
+    RETURN_HR_IF(S_OK, 0 == _szInvalidScroll.width && 0 == _szInvalidScroll.height && 0 == _invalidScrollRegionDelta);
 
     // If we have an inverted cursor, we have to see if we have to clean it before we scroll to prevent
     // left behind cursor copies in the scrolled region.
@@ -125,10 +128,19 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
     RETURN_IF_FAILED(LongSub(_szMemorySurface.width, szGutter.width, &rcScrollLimit.right));
     RETURN_IF_FAILED(LongSub(_szMemorySurface.height, szGutter.height, &rcScrollLimit.bottom));
 
+    // A region scroll only moves the rows within its region, similar to how ScrollConsoleScreenBuffer() works.
+    // InvalidateScroll() ensures that we never have to do both kinds of scrolls in the same frame.
+    auto szScroll = _szInvalidScroll;
+    if (_invalidScrollRegionDelta != 0)
+    {
+        szScroll = { 0, _invalidScrollRegionDelta };
+        rcScrollLimit = (til::rect{ rcScrollLimit } & _rcInvalidScrollRegion).to_win32_rect();
+    }
+
     // Scroll real window and memory buffer in-sync.
     LOG_LAST_ERROR_IF(!ScrollWindowEx(_hwndTargetWindow,
-                                      _szInvalidScroll.width,
-                                      _szInvalidScroll.height,
+                                      szScroll.width,
+                                      szScroll.height,
                                       &rcScrollLimit,
                                       &rcScrollLimit,
                                       nullptr,
@@ -136,7 +148,7 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
                                       0));
 
     til::rect rcUpdate;
-    LOG_HR_IF(E_FAIL, !(ScrollDC(_hdcMemoryContext, _szInvalidScroll.width, _szInvalidScroll.height, &rcScrollLimit, &rcScrollLimit, nullptr, rcUpdate.as_win32_rect())));
+    LOG_HR_IF(E_FAIL, !(ScrollDC(_hdcMemoryContext, szScroll.width, szScroll.height, &rcScrollLimit, &rcScrollLimit, nullptr, rcUpdate.as_win32_rect())));
 
     LOG_IF_FAILED(_InvalidCombine(&rcUpdate));
 
@@ -234,6 +246,8 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
     _rcInvalid = {};
     _fInvalidRectUsed = false;
     _szInvalidScroll = {};
+    _rcInvalidScrollRegion = {};
+    _invalidScrollRegionDelta = 0;
 
     LOG_HR_IF(E_FAIL, !(GdiFlush()));
     LOG_HR_IF(E_FAIL, !(ReleaseDC(_hwndTargetWindow, _psInvalidData.hdc)));
@@ -307,6 +321,8 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
 // Routine Description:
 // - Draws one line of the buffer to the screen.
 // - This will now be cached in a PolyText buffer and flushed periodically instead of drawing every individual segment. Note this means that the PolyText buffer must be flushed before some operations (changing the brush color, drawing lines on top of the characters, inverting for cursor/selection, etc.)
+// - The text and advances are appended to per-frame arenas, which keep their capacity from one frame to the next.
+//   A line that continues the previous one on the same row is merged into it.
 // Arguments:
 // - clusters - text to be written and columns expected per cluster
 // - coord - character coordinate target to render within viewport
@@ -335,16 +351,10 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
         RETURN_HR_IF(S_OK, 0 == cchLine);
 
         const auto ptDraw = coord * _GetFontSize();
-
-        const auto pPolyTextLine = &_pPolyText[_cPolyText];
-
-        auto& polyString = _polyStrings.emplace_back();
-        polyString.reserve(cchLine);
-
         const auto coordFontSize = _GetFontSize();
 
-        auto& polyWidth = _polyWidths.emplace_back();
-        polyWidth.reserve(cchLine);
+        const auto textOffset = _polyTextArena.size();
+        const auto widthOffset = _polyWidthArena.size();
 
         // If we have a soft font, we only use the character's lower 7 bits.
         const auto softFontCharMask = _lastFontType == FontType::Soft ? L'\x7F' : ~0;
@@ -359,46 +369,52 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
             const auto& cluster = til::at(clusters, i);
 
             const auto text = cluster.GetText();
-            polyString += text;
-            polyString.back() &= softFontCharMask;
-            polyWidth.push_back(gsl::narrow<int>(cluster.GetColumns()) * coordFontSize.width);
-            cchCharWidths += polyWidth.back();
-            polyWidth.append(text.size() - 1, 0);
+            _polyTextArena.insert(_polyTextArena.end(), text.begin(), text.end());
+            _polyTextArena.back() &= softFontCharMask;
+            _polyWidthArena.push_back(gsl::narrow<int>(cluster.GetColumns()) * coordFontSize.width);
+            cchCharWidths += _polyWidthArena.back();
+            _polyWidthArena.insert(_polyWidthArena.end(), text.size() - 1, 0);
         }
 
         // Detect and convert for raster font...
         if (!_isTrueTypeFont)
         {
+            const auto polyString = _polyTextArena.data() + textOffset;
+
             // dispatch conversion into our codepage
 
             // Find out the bytes required
-            const auto cbRequired = WideCharToMultiByte(_fontCodepage, 0, polyString.data(), (int)cchLine, nullptr, 0, nullptr, nullptr);
+            const auto cbRequired = WideCharToMultiByte(_fontCodepage, 0, polyString, (int)cchLine, nullptr, 0, nullptr, nullptr);
 
             if (cbRequired != 0)
             {
-                // Allocate buffer for MultiByte
-                auto psConverted = std::make_unique<char[]>(cbRequired);
+                // Reuse the scratch buffer for MultiByte
+                _polyConvertBuffer.resize(cbRequired);
 
                 // Attempt conversion to current codepage
-                const auto cbConverted = WideCharToMultiByte(_fontCodepage, 0, polyString.data(), (int)cchLine, psConverted.get(), cbRequired, nullptr, nullptr);
+                const auto cbConverted = WideCharToMultiByte(_fontCodepage, 0, polyString, (int)cchLine, _polyConvertBuffer.data(), cbRequired, nullptr, nullptr);
 
                 // If successful...
                 if (cbConverted != 0)
                 {
                     // Now we have to convert back to Unicode but using the system ANSI codepage. Find buffer size first.
-                    const auto cchRequired = MultiByteToWideChar(CP_ACP, 0, psConverted.get(), cbRequired, nullptr, 0);
+                    const auto cchRequired = MultiByteToWideChar(CP_ACP, 0, _polyConvertBuffer.data(), cbRequired, nullptr, 0);
 
                     if (cchRequired != 0)
                     {
-                        std::pmr::wstring polyConvert(cchRequired, UNICODE_NULL, &_pool);
-
-                        // Then do the actual conversion.
-                        const auto cchConverted = MultiByteToWideChar(CP_ACP, 0, psConverted.get(), cbRequired, polyConvert.data(), cchRequired);
+                        // Then do the actual conversion, right behind our line in the arena.
+                        _polyTextArena.resize(_polyTextArena.size() + cchRequired);
+                        const auto polyConvert = _polyTextArena.data() + _polyTextArena.size() - cchRequired;
+                        const auto cchConverted = MultiByteToWideChar(CP_ACP, 0, _polyConvertBuffer.data(), cbRequired, polyConvert, cchRequired);
 
                         if (cchConverted != 0)
                         {
                             // If all successful, use this instead.
-                            polyString.swap(polyConvert);
+                            _polyTextArena.erase(_polyTextArena.begin() + textOffset, _polyTextArena.end() - cchRequired);
+                        }
+                        else
+                        {
+                            _polyTextArena.resize(_polyTextArena.size() - cchRequired);
                         }
                     }
                 }
@@ -411,36 +427,53 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
         const auto topOffset = _currentLineRendition == LineRendition::DoubleHeightBottom ? halfHeight : 0;
         const auto bottomOffset = _currentLineRendition == LineRendition::DoubleHeightTop ? halfHeight : 0;
 
-        pPolyTextLine->lpstr = polyString.data();
-        pPolyTextLine->n = gsl::narrow<UINT>(polyString.size());
-        pPolyTextLine->x = ptDraw.x;
-        pPolyTextLine->y = ptDraw.y;
-        pPolyTextLine->uiFlags = ETO_OPAQUE | ETO_CLIPPED;
-        pPolyTextLine->rcl.left = pPolyTextLine->x;
-        pPolyTextLine->rcl.top = pPolyTextLine->y + topOffset;
-        pPolyTextLine->rcl.right = pPolyTextLine->rcl.left + (til::CoordType)cchCharWidths;
-        pPolyTextLine->rcl.bottom = pPolyTextLine->y + coordFontSize.height - bottomOffset;
-        pPolyTextLine->pdx = polyWidth.data();
+        POLYTEXTW polyTextLine{};
+        polyTextLine.n = gsl::narrow<UINT>(_polyTextArena.size() - textOffset);
+        polyTextLine.x = ptDraw.x;
+        polyTextLine.y = ptDraw.y;
+        polyTextLine.uiFlags = ETO_OPAQUE | ETO_CLIPPED;
+        polyTextLine.rcl.left = polyTextLine.x;
+        polyTextLine.rcl.top = polyTextLine.y + topOffset;
+        polyTextLine.rcl.right = polyTextLine.rcl.left + (til::CoordType)cchCharWidths;
+        polyTextLine.rcl.bottom = polyTextLine.y + coordFontSize.height - bottomOffset;
 
         if (trimLeft)
         {
-            pPolyTextLine->rcl.left += coordFontSize.width;
+            polyTextLine.rcl.left += coordFontSize.width;
         }
 
-        _cPolyText++;
-
-        if (_cPolyText >= s_cPolyTextCache)
+        // Since all cached lines share the current brushes and font, a line that starts
+        // where the previous one ended simply extends it. Their text is already contiguous in the arenas.
+        if (!_polyTexts.empty())
         {
-            LOG_IF_FAILED(_FlushBufferLines());
+            auto& prev = _polyTexts.back();
+            const auto& prevOffsets = _polyOffsets.back();
+            if (!trimLeft &&
+                prev.y == polyTextLine.y &&
+                prev.rcl.right == polyTextLine.x &&
+                prev.rcl.top == polyTextLine.rcl.top &&
+                prev.rcl.bottom == polyTextLine.rcl.bottom &&
+                prevOffsets.text + prev.n == textOffset &&
+                prevOffsets.width + prev.n == widthOffset &&
+                polyTextLine.n == _polyWidthArena.size() - widthOffset)
+            {
+                prev.n += polyTextLine.n;
+                prev.rcl.right = polyTextLine.rcl.right;
+                return S_OK;
+            }
         }
 
+        _polyTexts.push_back(polyTextLine);
+        _polyOffsets.push_back({ textOffset, widthOffset });
+
         return S_OK;
     }
     CATCH_RETURN();
 }
 
 // Routine Description:
-// - Flushes any buffer lines in the PolyTextOut cache by drawing them and freeing the strings.
+// - Flushes any buffer lines in the PolyTextOut cache by drawing them and resetting the arenas.
+// - Consecutive lines without complex scripts are drawn with a single PolyTextOutW() call.
 // - See also: PaintBufferLine
 // Arguments:
 // - <none>
@@ -450,56 +483,76 @@ bool GdiEngine::FontHasWesternScript(HDC hdc)
 {
     auto hr = S_OK;
 
-    if (_cPolyText > 0)
+    if (!_polyTexts.empty())
     {
-        for (size_t i = 0; i != _cPolyText; ++i)
+        const auto count = _polyTexts.size();
+
+        // The arenas are done growing for now, which makes it safe to point into them.
+        for (size_t i = 0; i != count; ++i)
         {
-            const auto& t = _pPolyText[i];
+            auto& t = til::at(_polyTexts, i);
+            const auto& offsets = til::at(_polyOffsets, i);
+            t.lpstr = _polyTextArena.data() + offsets.text;
+            t.pdx = _polyWidthArena.data() + offsets.width;
+        }
 
-            // The following if/else replicates the essentials of how ExtTextOutW() without ETO_IGNORELANGUAGE works.
+        for (size_t i = 0; i != count;)
+        {
+            // The following check replicates the essentials of how ExtTextOutW() without ETO_IGNORELANGUAGE works.
             // See InternalTextOut().
             //
             // Unlike the original, we don't check for `GetTextCharacterExtra(hdc) != 0`,
             // because we don't ever call SetTextCharacterExtra() anyways.
-            //
-            // GH#12294:
-            // Additionally we set ss.fOverrideDirection to TRUE, because we need to present RTL
-            // text in logical order in order to be compatible with applications like `vim -H`.
-            if (_fontHasWesternScript && ScriptIsComplex(t.lpstr, t.n, SIC_COMPLEX) == S_FALSE)
+            auto end = i;
+            for (; end != count; ++end)
             {
-                if (!ExtTextOutW(_hdcMemoryContext, t.x, t.y, t.uiFlags | ETO_IGNORELANGUAGE, &t.rcl, t.lpstr, t.n, t.pdx))
+                auto& t = til::at(_polyTexts, end);
+                if (!_fontHasWesternScript || ScriptIsComplex(t.lpstr, t.n, SIC_COMPLEX) != S_FALSE)
                 {
-                    hr = E_FAIL;
                     break;
                 }
+                t.uiFlags |= ETO_IGNORELANGUAGE;
             }
-            else
-            {
-                SCRIPT_STATE ss{};
-                ss.fOverrideDirection = TRUE;
-
-                SCRIPT_STRING_ANALYSIS ssa;
-                hr = ScriptStringAnalyse(_hdcMemoryContext, t.lpstr, t.n, 0, -1, SSA_GLYPHS | SSA_FALLBACK, 0, nullptr, &ss, t.pdx, nullptr, nullptr, &ssa);
-                if (FAILED(hr))
-                {
-                    break;
-                }
 
-                hr = ScriptStringOut(ssa, t.x, t.y, t.uiFlags, &t.rcl, 0, 0, FALSE);
-                std::ignore = ScriptStringFree(&ssa);
-                if (FAILED(hr))
+            if (end != i)
+            {
+                if (!PolyTextOutW(_hdcMemoryContext, &til::at(_polyTexts, i), gsl::narrow_cast<int>(end - i)))
                 {
+                    hr = E_FAIL;
                     break;
                 }
+                i = end;
+                continue;
             }
-        }
 
-        _polyStrings.clear();
-        _polyWidths.clear();
+            const auto& t = til::at(_polyTexts, i);
+            ++i;
 
-        ZeroMemory(_pPolyText, sizeof(_pPolyText));
+            // GH#12294:
+            // We set ss.fOverrideDirection to TRUE, because we need to present RTL
+            // text in logical order in order to be compatible with applications like `vim -H`.
+            SCRIPT_STATE ss{};
+            ss.fOverrideDirection = TRUE;
+
+            SCRIPT_STRING_ANALYSIS ssa;
+            hr = ScriptStringAnalyse(_hdcMemoryContext, t.lpstr, t.n, 0, -1, SSA_GLYPHS | SSA_FALLBACK, 0, nullptr, &ss, t.pdx, nullptr, nullptr, &ssa);
+            if (FAILED(hr))
+            {
+                break;
+            }
+
+            hr = ScriptStringOut(ssa, t.x, t.y, t.uiFlags, &t.rcl, 0, 0, FALSE);
+            std::ignore = ScriptStringFree(&ssa);
+            if (FAILED(hr))
+            {
+                break;
+            }
+        }
 
-        _cPolyText = 0;
+        _polyTexts.clear();
+        _polyOffsets.clear();
+        _polyTextArena.clear();
+        _polyWidthArena.clear();
     }
 
     RETURN_HR(hr);
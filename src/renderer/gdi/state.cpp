@@ -25,7 +25,6 @@ GdiEngine::GdiEngine() :
 #endif
     _iCurrentDpi(s_iBaseDpi),
     _hbitmapMemorySurface(nullptr),
-    _cPolyText(0),
     _fInvalidRectUsed(false),
     _lastFg(INVALID_COLOR),
     _lastBg(INVALID_COLOR),
@@ -35,13 +34,8 @@ GdiEngine::GdiEngine() :
     _fPaintStarted(false),
     _invalidCharacters{},
     _hfont(nullptr),
-    _hfontItalic(nullptr),
-    _pool{ til::pmr::get_default_resource() }, // It's important the pool is first so it can be given to the others on construction.
-    _polyStrings{ &_pool },
-    _polyWidths{ &_pool }
+    _hfontItalic(nullptr)
 {
-    ZeroMemory(_pPolyText, sizeof(POLYTEXTW) * s_cPolyTextCache);
-
     _hdcMemoryContext = CreateCompatibleDC(nullptr);
     THROW_HR_IF_NULL(E_FAIL, _hdcMemoryContext);
 
@@ -76,14 +70,6 @@ GdiEngine::GdiEngine() :
 // - <none>
 GdiEngine::~GdiEngine()
 {
-    for (size_t iPoly = 0; iPoly < _cPolyText; iPoly++)
-    {
-        if (_pPolyText[iPoly].lpstr != nullptr)
-        {
-            delete[] _pPolyText[iPoly].lpstr;
-        }
-    }
-
     if (_hbitmapMemorySurface != nullptr)
     {
         LOG_HR_IF(E_FAIL, !(DeleteObject(_hbitmapMemorySurface)));
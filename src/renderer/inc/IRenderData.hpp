@@ -47,8 +47,14 @@ namespace Microsoft::Console::Render
         virtual const TextBuffer& GetTextBuffer() const noexcept = 0;
         virtual const FontInfo& GetFontInfo() const noexcept = 0;
         virtual std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept = 0;
+        // Same as GetSelectionRects(), but only for the rows within GetViewport().
+        // The renderer calls this multiple times per frame.
+        virtual std::vector<Microsoft::Console::Types::Viewport> GetVisibleSelectionRects() noexcept = 0;
         virtual void LockConsole() noexcept = 0;
         virtual void UnlockConsole() noexcept = 0;
+        // Locks out writers, but not other readers. The caller must not modify any state or lock exclusively.
+        virtual void LockConsoleShared() noexcept = 0;
+        virtual void UnlockConsoleShared() noexcept = 0;
 
         // This block used to be the original IRenderData.
         virtual til::point GetCursorPosition() const noexcept = 0;
@@ -64,6 +70,8 @@ namespace Microsoft::Console::Render
         virtual const std::wstring GetHyperlinkUri(uint16_t id) const = 0;
         virtual const std::wstring GetHyperlinkCustomId(uint16_t id) const = 0;
         virtual const std::vector<size_t> GetPatternId(const til::point location) const = 0;
+        // The matches of the search in progress that should be highlighted, in buffer coordinates and in order.
+        virtual std::span<const til::point_span> GetSearchHighlights() const noexcept = 0;
 
         // This block used to be IUiaData.
         virtual std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept = 0;
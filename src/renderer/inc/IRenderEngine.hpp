@@ -20,9 +20,12 @@ Author(s):
 #include "Cluster.hpp"
 #include "FontInfoDesired.hpp"
 #include "IRenderData.hpp"
+#include "PerfCounters.hpp"
 #include "RenderSettings.hpp"
 #include "../../buffer/out/LineRendition.hpp"
 
+class ROW;
+
 #pragma warning(push)
 #pragma warning(disable : 4100) // '...': unreferenced formal parameter
 namespace Microsoft::Console::Render
@@ -32,6 +35,17 @@ namespace Microsoft::Console::Render
         std::optional<CursorOptions> cursorInfo;
     };
 
+    // The columns [columnBegin, columnEnd) of a ROW that need to be painted into the given
+    // screen row. The columns map 1:1 to the "coord.x" passed to PaintBufferLine().
+    struct BufferRowInfo
+    {
+        const ROW* row = nullptr;
+        const RenderSettings* renderSettings = nullptr;
+        til::CoordType targetRow = 0;
+        til::CoordType columnBegin = 0;
+        til::CoordType columnEnd = 0;
+    };
+
     enum class GridLines
     {
         None,
@@ -46,6 +60,16 @@ namespace Microsoft::Console::Render
     };
     using GridLineSet = til::enumset<GridLines>;
 
+    // The part of a search highlight that's within a single row of the viewport, covering the cells [left, right).
+    // Highlights spanning multiple rows only get their Left and Right lines in the rows they start and end in.
+    struct SearchHighlightRun
+    {
+        GridLineSet lines;
+        til::CoordType row = 0;
+        til::CoordType left = 0;
+        til::CoordType right = 0;
+    };
+
     class __declspec(novtable) IRenderEngine
     {
     public:
@@ -55,6 +79,10 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT StartPaint() noexcept = 0;
         [[nodiscard]] virtual HRESULT EndPaint() noexcept = 0;
         [[nodiscard]] virtual bool RequiresContinuousRedraw() noexcept = 0;
+        [[nodiscard]] virtual DWORD GetContinuousRedrawDelay() noexcept { return 0; }
+        // Returns true if nothing the engine presents is visible right now. The Renderer skips
+        // the engine then and checks again every occlusionPollInterval (see renderer.cpp).
+        [[nodiscard]] virtual bool IsOccluded() noexcept { return false; }
         virtual void WaitUntilCanRender() noexcept = 0;
         [[nodiscard]] virtual HRESULT Present() noexcept = 0;
         [[nodiscard]] virtual HRESULT PrepareForTeardown(_Out_ bool* pForcePaint) noexcept = 0;
@@ -62,8 +90,9 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT Invalidate(const til::rect* psrRegion) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateCursor(const til::rect* psrRegion) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateSystem(const til::rect* prcDirtyClient) noexcept = 0;
-        [[nodiscard]] virtual HRESULT InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept = 0;
+        [[nodiscard]] virtual HRESULT InvalidateSelection(std::span<const til::rect> rectangles) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateScroll(const til::point* pcoordDelta) noexcept = 0;
+        [[nodiscard]] virtual HRESULT InvalidateScrollRegion(const til::rect* psrRegion, til::CoordType delta) noexcept { return Invalidate(psrRegion); }
         [[nodiscard]] virtual HRESULT InvalidateAll() noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateFlush(_In_ const bool circled, _Out_ bool* const pForcePaint) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateTitle(std::wstring_view proposedTitle) noexcept = 0;
@@ -87,6 +116,44 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT IsGlyphWideByFont(std::wstring_view glyph, _Out_ bool* pResult) noexcept = 0;
         [[nodiscard]] virtual HRESULT UpdateTitle(std::wstring_view newTitle) noexcept = 0;
 
+        // Engines may implement this to receive the contents of each dirty row straight from the TextBuffer,
+        // instead of the UpdateDrawingBrushes() and PaintBufferLine() calls for each of its attribute runs.
+        // Grid lines are still painted via PaintBufferGridLines(). Returning E_NOTIMPL selects the latter path.
+        [[nodiscard]] virtual HRESULT PaintBufferRow(const BufferRowInfo& info) noexcept { return E_NOTIMPL; }
+
+        // Engines may implement this to draw the selection on a layer of its own, on top of the text.
+        // They then receive the selection rects of the entire viewport on every frame (one per row, ordered by row),
+        // so that changes to the selection don't require the text underneath to be repainted.
+        // Returning E_NOTIMPL selects the PaintSelection() path, which is only called for the dirty area.
+        [[nodiscard]] virtual HRESULT PaintSelectionLayer(std::span<const til::rect> rects) noexcept { return E_NOTIMPL; }
+
+        // Engines may implement this to draw overlays (like the IME composition) on a layer of its own, on top of the text.
+        // They then receive all visible rows of the overlays on every frame, which are painted between these two calls,
+        // so that InvalidateOverlay() doesn't need to invalidate the text underneath them, unlike Invalidate().
+        // Returning E_NOTIMPL selects the regular path, where overlays are only painted into the dirty area.
+        [[nodiscard]] virtual HRESULT StartOverlayLayer() noexcept { return E_NOTIMPL; }
+        [[nodiscard]] virtual HRESULT EndOverlayLayer() noexcept { return E_NOTIMPL; }
+        [[nodiscard]] virtual HRESULT InvalidateOverlay(const til::rect* psrRegion) noexcept { return Invalidate(psrRegion); }
+
+        // Engines may implement this to draw the search highlights on a layer of their own, on top of the text.
+        // They then receive the highlights of the entire viewport on every frame (ordered by row and column),
+        // so that InvalidateSearchHighlights() doesn't need to invalidate the text underneath them, unlike Invalidate().
+        // Returning E_NOTIMPL selects the regular path, where the highlights are painted as grid lines into the dirty area.
+        [[nodiscard]] virtual HRESULT PaintSearchHighlightLayer(std::span<const SearchHighlightRun> runs, COLORREF color) noexcept { return E_NOTIMPL; }
+        [[nodiscard]] virtual HRESULT InvalidateSearchHighlights(const til::rect* psrRegion) noexcept { return Invalidate(psrRegion); }
+
+        // Called by the Renderer when the engine is added to it. Engines may contribute to the given
+        // counters, which outlive the engine, and may optionally show them in a debug overlay.
+        virtual void SetPerfCounters(PerfCounters* counters) noexcept {}
+        [[nodiscard]] virtual bool GetPerfOverlay() const noexcept { return false; }
+        virtual void SetPerfOverlay(bool enable) noexcept {}
+        // Called while painting is disabled and the output isn't visible. Engines may release
+        // any resources that they can recreate on the next frame, like their swap chain.
+        virtual void ReleaseResources() noexcept {}
+        // The approximate number of bytes of (GPU) memory held by the engine, as of the last frame.
+        // Unlike most other functions, this may be called from any thread.
+        [[nodiscard]] virtual uint64_t GetMemoryUsage() const noexcept { return 0; }
+
         // The following functions used to be specific to the DxRenderer and they should
         // be abstracted away and integrated into the above or simply get removed.
 
@@ -103,9 +170,13 @@ namespace Microsoft::Console::Render
         virtual void EnableTransparentBackground(const bool isTransparent) noexcept {}
         virtual void SetForceFullRepaintRendering(bool enable) noexcept {}
         [[nodiscard]] virtual HRESULT SetHwnd(const HWND hwnd) noexcept { return E_NOTIMPL; }
+        virtual void SetMonitorHwnd(const HWND hwnd) noexcept {}
+        virtual void SetPixelShaderFrameRate(int32_t value) noexcept {}
         virtual void SetPixelShaderPath(std::wstring_view value) noexcept {}
+        virtual void SetPreferLowPowerAdapter(bool enable) noexcept {}
         virtual void SetRetroTerminalEffect(bool enable) noexcept {}
         virtual void SetSelectionBackground(const COLORREF color, const float alpha = 0.5f) noexcept {}
+        virtual void SetSmoothScrollOffset(const float rows) noexcept {}
         virtual void SetSoftwareRendering(bool enable) noexcept {}
         virtual void SetWarningCallback(std::function<void(HRESULT)> pfn) noexcept {}
         [[nodiscard]] virtual HRESULT SetWindowSize(const til::size pixels) noexcept { return E_NOTIMPL; }
@@ -0,0 +1,148 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PerfCounters.hpp
+
+Abstract:
+- Lightweight, always-on counters for each stage of the output pipeline, from parsing
+  VT over writing into the TextBuffer to painting frames. They allow us to tell which
+  stage a slow terminal is bottlenecked in, without an ETW capture and offline analysis.
+- All counters are cumulative. Rates are computed by the reader by comparing two Snapshots.
+- The input latency is measured from a key press being written to the connection until the first
+  frame is presented after the connection's output (its echo) was written into the TextBuffer.
+--*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+namespace Microsoft::Console::Render
+{
+    struct PerfCounters
+    {
+        // The input latency histogram has buckets for latencies below each of these limits
+        // (in microseconds) and one more bucket for all latencies above the last one.
+        static constexpr std::array<uint64_t, 7> InputLatencyBucketLimits{ 1000, 2000, 4000, 8000, 16000, 32000, 64000 };
+        static constexpr size_t InputLatencyBuckets = InputLatencyBucketLimits.size() + 1;
+
+        struct Snapshot
+        {
+            uint64_t parsedBytes = 0;
+            uint64_t rowsWritten = 0;
+            uint64_t frames = 0;
+            uint64_t paintMicroseconds = 0;
+            uint64_t renderMicroseconds = 0;
+            uint64_t shapingMicroseconds = 0;
+            uint64_t atlasMisses = 0;
+            uint64_t inputLatencies = 0;
+            uint64_t inputLatencyMicroseconds = 0;
+            std::array<uint64_t, InputLatencyBuckets> inputLatencyHistogram{};
+        };
+
+        // The counters are written to by the output and render threads and read from any thread,
+        // but they don't need to be consistent with each other, hence the relaxed memory order.
+        static void Add(std::atomic<uint64_t>& counter, const uint64_t value) noexcept
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        // Called when a key press was written to the connection. Only one key press is tracked
+        // at a time. Any others are ignored until its echo was presented.
+        void InputSent(const std::chrono::steady_clock::time_point time) noexcept
+        {
+            auto expected = std::chrono::steady_clock::rep{};
+            pendingInput.compare_exchange_strong(expected, time.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        // Called after the connection's output was written into the TextBuffer,
+        // which is assumed to be the echo of the pending key press, if there's one.
+        void OutputReceived() noexcept
+        {
+            if (!echoedInput.load(std::memory_order_relaxed))
+            {
+                if (const auto input = pendingInput.exchange(0, std::memory_order_relaxed))
+                {
+                    echoedInput.store(input, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Called by the Renderer while it's holding the console lock at the start of a frame.
+        // If this returns a key press then the frame contains its echo. Pass it to InputPresented().
+        std::chrono::steady_clock::rep TakeEchoedInput() noexcept
+        {
+            return echoedInput.exchange(0, std::memory_order_relaxed);
+        }
+
+        // Called by the Renderer once the frame with TakeEchoedInput()'s result was presented.
+        // Returns the latency of the key press, if there was one, after adding it to the histogram.
+        std::optional<std::chrono::microseconds> InputPresented(const std::chrono::steady_clock::rep input) noexcept
+        {
+            if (!input)
+            {
+                return std::nullopt;
+            }
+
+            const std::chrono::steady_clock::time_point time{ std::chrono::steady_clock::duration{ input } };
+            const auto latency = std::max(std::chrono::microseconds::zero(), std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time));
+            const auto value = static_cast<uint64_t>(latency.count());
+
+            size_t bucket = 0;
+            while (bucket < InputLatencyBucketLimits.size() && value >= InputLatencyBucketLimits[bucket])
+            {
+                ++bucket;
+            }
+
+            Add(inputLatencies, 1);
+            Add(inputLatencyMicroseconds, value);
+            Add(inputLatencyHistogram[bucket], 1);
+            return latency;
+        }
+
+        Snapshot Take() const noexcept
+        {
+            Snapshot snapshot{
+                .parsedBytes = parsedBytes.load(std::memory_order_relaxed),
+                .rowsWritten = rowsWritten.load(std::memory_order_relaxed),
+                .frames = frames.load(std::memory_order_relaxed),
+                .paintMicroseconds = paintMicroseconds.load(std::memory_order_relaxed),
+                .renderMicroseconds = renderMicroseconds.load(std::memory_order_relaxed),
+                .shapingMicroseconds = shapingMicroseconds.load(std::memory_order_relaxed),
+                .atlasMisses = atlasMisses.load(std::memory_order_relaxed),
+                .inputLatencies = inputLatencies.load(std::memory_order_relaxed),
+                .inputLatencyMicroseconds = inputLatencyMicroseconds.load(std::memory_order_relaxed),
+            };
+            for (size_t i = 0; i < InputLatencyBuckets; ++i)
+            {
+                snapshot.inputLatencyHistogram[i] = inputLatencyHistogram[i].load(std::memory_order_relaxed);
+            }
+            return snapshot;
+        }
+
+        // Text given to the StateMachine, in bytes of UTF-16.
+        std::atomic<uint64_t> parsedBytes{ 0 };
+        // Number of times text got written into a row of the TextBuffer.
+        std::atomic<uint64_t> rowsWritten{ 0 };
+        // Frames painted by the Renderer and the time spent doing so, including the engine's Present().
+        std::atomic<uint64_t> frames{ 0 };
+        std::atomic<uint64_t> paintMicroseconds{ 0 };
+        // The subset of paintMicroseconds spent in the engine's backend (for instance BackendD3D::Render).
+        std::atomic<uint64_t> renderMicroseconds{ 0 };
+        // The subset of paintMicroseconds spent turning text into glyphs.
+        std::atomic<uint64_t> shapingMicroseconds{ 0 };
+        // Glyphs that weren't in the glyph atlas yet and had to be rasterized.
+        std::atomic<uint64_t> atlasMisses{ 0 };
+        // Key presses whose echo was presented, the sum of their latencies and their distribution.
+        std::atomic<uint64_t> inputLatencies{ 0 };
+        std::atomic<uint64_t> inputLatencyMicroseconds{ 0 };
+        std::array<std::atomic<uint64_t>, InputLatencyBuckets> inputLatencyHistogram{};
+        // The steady_clock timestamps of the tracked key press, before and after its echo was received, or 0.
+        std::atomic<std::chrono::steady_clock::rep> pendingInput{ 0 };
+        std::atomic<std::chrono::steady_clock::rep> echoedInput{ 0 };
+    };
+}
@@ -11,6 +11,8 @@ Abstract:
 
 #pragma once
 
+#include <til/generational.h>
+
 #include "../../buffer/out/TextAttribute.hpp"
 
 namespace Microsoft::Console::Render
@@ -44,11 +46,29 @@ namespace Microsoft::Console::Render
         void ToggleBlinkRendition(class Renderer& renderer) noexcept;
 
     private:
+        // A small direct-mapped cache for GetAttributeColors(). Entries are keyed by the
+        // foreground and background TextColor and the attributes that affect the result.
+        // Anything else that does (the color table, render modes, blink state) bumps
+        // _colorsGeneration instead, which invalidates all entries at once.
+        struct AttributeColorsCacheEntry
+        {
+            uint64_t colors = 0;
+            uint32_t flags = 0;
+            til::generation_t generation;
+            std::pair<COLORREF, COLORREF> result;
+        };
+
+        static constexpr size_t AttributeColorsCacheSize = 256;
+
+        std::pair<COLORREF, COLORREF> _calculateAttributeColors(const TextAttribute& attr) const noexcept;
+
         til::enumset<Mode> _renderMode{ Mode::BlinkAllowed, Mode::IntenseIsBright };
         std::array<COLORREF, TextColor::TABLE_SIZE> _colorTable;
         std::array<size_t, static_cast<size_t>(ColorAlias::ENUM_COUNT)> _colorAliasIndices;
         size_t _blinkCycle = 0;
         mutable bool _blinkIsInUse = false;
         bool _blinkShouldBeFaint = false;
+        til::generation_t _colorsGeneration;
+        mutable std::array<AttributeColorsCacheEntry, AttributeColorsCacheSize> _attributeColorsCache{};
     };
 }
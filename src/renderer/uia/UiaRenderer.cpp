@@ -104,7 +104,7 @@ CATCH_RETURN();
 // - rectangles - One or more rectangles describing character positions on the grid
 // Return Value:
 // - S_OK
-[[nodiscard]] HRESULT UiaEngine::InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept
+[[nodiscard]] HRESULT UiaEngine::InvalidateSelection(std::span<const til::rect> rectangles) noexcept
 {
     // early exit: different number of rows
     if (_prevSelection.size() != rectangles.size())
@@ -112,7 +112,7 @@ CATCH_RETURN();
         try
         {
             _selectionChanged = true;
-            _prevSelection = rectangles;
+            _prevSelection.assign(rectangles.begin(), rectangles.end());
         }
         CATCH_LOG_RETURN_HR(E_FAIL);
         return S_OK;
@@ -123,13 +123,13 @@ CATCH_RETURN();
         try
         {
             const auto prevRect = _prevSelection.at(i);
-            const auto newRect = rectangles.at(i);
+            const auto newRect = til::at(rectangles, i);
 
             // if any value is different, selection has changed
             if (prevRect.top != newRect.top || prevRect.right != newRect.right || prevRect.left != newRect.left || prevRect.bottom != newRect.bottom)
             {
                 _selectionChanged = true;
-                _prevSelection = rectangles;
+                _prevSelection.assign(rectangles.begin(), rectangles.end());
                 return S_OK;
             }
         }
@@ -176,6 +176,13 @@ try
         _newOutput.append(newText);
         _newOutput.push_back(L'\n');
         _textBufferChanged = true;
+
+        // A screen reader can't keep up with more than a few chunks per frame anyway.
+        // Keep the most recent text only, so that noisy output doesn't pile up.
+        if (_newOutput.size() > _maxNewOutputSize)
+        {
+            _newOutput.erase(0, _newOutput.size() - _maxNewOutputSize);
+        }
     }
     return S_OK;
 }
@@ -284,11 +291,10 @@ void UiaEngine::WaitUntilCanRender() noexcept
         // The speech API is limited to 1000 characters at a time.
         // Break up the output into 1000 character chunks to ensure
         // the output isn't cut off.
-        static constexpr size_t sapiLimit{ 1000 };
         const std::wstring_view output{ _queuedOutput };
-        for (size_t offset = 0; offset < output.size(); offset += sapiLimit)
+        for (size_t offset = 0; offset < output.size(); offset += _sapiLimit)
         {
-            _dispatcher->NotifyNewOutput(output.substr(offset, sapiLimit));
+            _dispatcher->NotifyNewOutput(output.substr(offset, _sapiLimit));
         }
     }
     CATCH_LOG();
@@ -106,11 +106,14 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_ClearScreen() noexcept
 {
+    _ResetShadowFrame();
     return _Write("\x1b[2J");
 }
 
 [[nodiscard]] HRESULT VtEngine::_ClearScrollback() noexcept
 {
+    // Some terminals clear the screen as well.
+    _ResetShadowFrame();
     return _Write("\x1b[3J");
 }
 
@@ -447,6 +450,7 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_SwitchScreenBuffer(const bool useAltBuffer) noexcept
 {
+    _ResetShadowFrame();
     return _Write(useAltBuffer ? "\x1b[?1049h" : "\x1b[?1049l");
 }
 
@@ -34,7 +34,8 @@ Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
 {
     RETURN_HR_IF(S_FALSE, _passthrough && isSettingDefaultBrushes);
 
-    RETURN_IF_FAILED(VtEngine::_RgbUpdateDrawingBrushes(textAttributes));
+    // Colors and rendition attributes are combined into a single SGR sequence.
+    RETURN_IF_FAILED(_UpdateGraphicsRendition(textAttributes));
 
     RETURN_IF_FAILED(_UpdateHyperlinkAttr(textAttributes, pData));
 
@@ -49,103 +50,225 @@ Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
         _usingSoftFont = usingSoftFont;
     }
 
-    // Only do extended attributes in xterm-256color, as to not break telnet.exe.
-    return _UpdateExtendedAttrs(textAttributes);
+    return S_OK;
 }
 
 // Routine Description:
-// - Write a VT sequence to update the character rendition attributes.
+// - Write a single SGR sequence that changes the colors and character rendition
+//      attributes (intense, italic, underline, etc.) from the ones we last
+//      sent to the terminal, to the given ones.
 // Arguments:
-// - textAttributes - text attributes (intense, italic, underline, etc.) to use.
+// - textAttributes - text attributes to use.
 // Return Value:
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
-[[nodiscard]] HRESULT Xterm256Engine::_UpdateExtendedAttrs(const TextAttribute& textAttributes) noexcept
+[[nodiscard]] HRESULT Xterm256Engine::_UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept
+try
 {
-    // Turning off Intense and Faint must be handled at the same time,
-    // since there is only one sequence that resets both of them.
-    const auto intenseTurnedOff = !textAttributes.IsIntense() && _lastTextAttributes.IsIntense();
-    const auto faintTurnedOff = !textAttributes.IsFaint() && _lastTextAttributes.IsFaint();
-    if (intenseTurnedOff || faintTurnedOff)
+    _sgrBuffer.clear();
+    _FormatGraphicsRendition(_lastTextAttributes, textAttributes, _sgrBuffer);
+    if (_sgrBuffer.empty())
     {
-        RETURN_IF_FAILED(_SetIntense(false));
-        _lastTextAttributes.SetIntense(false);
-        _lastTextAttributes.SetFaint(false);
+        return S_OK;
     }
 
-    // Once we've handled the cases where they need to be turned off,
-    // we can then check if either should be turned back on again.
-    if (textAttributes.IsIntense() && !_lastTextAttributes.IsIntense())
-    {
-        RETURN_IF_FAILED(_SetIntense(true));
-        _lastTextAttributes.SetIntense(true);
-    }
-    if (textAttributes.IsFaint() && !_lastTextAttributes.IsFaint())
-    {
-        RETURN_IF_FAILED(_SetFaint(true));
-        _lastTextAttributes.SetFaint(true);
-    }
+    RETURN_IF_FAILED(_Write(_sgrBuffer));
 
-    // Turning off the underline styles must be handled at the same time,
-    // since there is only one sequence that resets both of them.
-    const auto singleTurnedOff = !textAttributes.IsUnderlined() && _lastTextAttributes.IsUnderlined();
-    const auto doubleTurnedOff = !textAttributes.IsDoublyUnderlined() && _lastTextAttributes.IsDoublyUnderlined();
-    if (singleTurnedOff || doubleTurnedOff)
-    {
-        RETURN_IF_FAILED(_SetUnderlined(false));
-        _lastTextAttributes.SetUnderlined(false);
-        _lastTextAttributes.SetDoublyUnderlined(false);
-    }
+    // We can't simply assign textAttributes to _lastTextAttributes,
+    // because we want to retain the last hyperlink ID.
+    _lastTextAttributes.SetForeground(textAttributes.GetForeground());
+    _lastTextAttributes.SetBackground(textAttributes.GetBackground());
+    _lastTextAttributes.SetIntense(textAttributes.IsIntense());
+    _lastTextAttributes.SetFaint(textAttributes.IsFaint());
+    _lastTextAttributes.SetUnderlined(textAttributes.IsUnderlined());
+    _lastTextAttributes.SetDoublyUnderlined(textAttributes.IsDoublyUnderlined());
+    _lastTextAttributes.SetOverlined(textAttributes.IsOverlined());
+    _lastTextAttributes.SetItalic(textAttributes.IsItalic());
+    _lastTextAttributes.SetBlinking(textAttributes.IsBlinking());
+    _lastTextAttributes.SetInvisible(textAttributes.IsInvisible());
+    _lastTextAttributes.SetCrossedOut(textAttributes.IsCrossedOut());
+    _lastTextAttributes.SetReverseVideo(textAttributes.IsReverseVideo());
+    return S_OK;
+}
+CATCH_RETURN();
 
-    // Once we've handled the cases where they need to be turned off,
-    // we can then check if either should be turned back on again.
-    if (textAttributes.IsUnderlined() && !_lastTextAttributes.IsUnderlined())
-    {
-        RETURN_IF_FAILED(_SetUnderlined(true));
-        _lastTextAttributes.SetUnderlined(true);
-    }
-    if (textAttributes.IsDoublyUnderlined() && !_lastTextAttributes.IsDoublyUnderlined())
-    {
-        RETURN_IF_FAILED(_SetDoublyUnderlined(true));
-        _lastTextAttributes.SetDoublyUnderlined(true);
-    }
+// Routine Description:
+// - Appends the shortest SGR sequence that turns the colors and character rendition
+//      attributes of `last` into the ones of `next` to `out`. This is either a sequence
+//      that only contains the parameters that changed, or one that starts with a
+//      reset (SGR 0) followed by all the parameters of `next`, whichever is shorter.
+//      Nothing is appended if there's nothing to change.
+// Arguments:
+// - last - the attributes the terminal currently uses
+// - next - the attributes the terminal should use
+// - out - the string to append the sequence to
+// Return Value:
+// - <none>
+void Xterm256Engine::_FormatGraphicsRendition(const TextAttribute& last, const TextAttribute& next, std::string& out)
+{
+    fmt::basic_memory_buffer<char, 128> diff;
+    fmt::basic_memory_buffer<char, 128> reset;
 
-    if (textAttributes.IsOverlined() != _lastTextAttributes.IsOverlined())
-    {
-        RETURN_IF_FAILED(_SetOverlined(textAttributes.IsOverlined()));
-        _lastTextAttributes.SetOverlined(textAttributes.IsOverlined());
-    }
+    const auto appendParameter = [](auto& buffer, const std::string_view parameter) {
+        if (buffer.size() != 0)
+        {
+            buffer.push_back(';');
+        }
+        buffer.append(parameter);
+    };
+    const auto appendColor = [](auto& buffer, const TextColor& color, const bool isForeground) {
+        if (buffer.size() != 0)
+        {
+            buffer.push_back(';');
+        }
+        if (color.IsDefault())
+        {
+            buffer.append(std::string_view{ isForeground ? "39" : "49" });
+        }
+        else if (color.IsIndex16())
+        {
+            // See _SetGraphicsRendition16Color for why intensity and brightness are separate.
+            const auto index = color.GetIndex();
+            const auto prefix = WI_IsFlagSet(index, FOREGROUND_INTENSITY) ? (isForeground ? 90 : 100) : (isForeground ? 30 : 40);
+            fmt::format_to(std::back_inserter(buffer), FMT_COMPILE("{}"), prefix + (index & 7));
+        }
+        else if (color.IsIndex256())
+        {
+            fmt::format_to(std::back_inserter(buffer), FMT_COMPILE("{}8;5;{}"), isForeground ? '3' : '4', color.GetIndex());
+        }
+        else if (color.IsRgb())
+        {
+            const auto rgb = color.GetRGB();
+            fmt::format_to(std::back_inserter(buffer), FMT_COMPILE("{}8;2;{};{};{}"), isForeground ? '3' : '4', GetRValue(rgb), GetGValue(rgb), GetBValue(rgb));
+        }
+    };
 
-    if (textAttributes.IsItalic() != _lastTextAttributes.IsItalic())
+    // The parameter set that only contains what changed.
     {
-        RETURN_IF_FAILED(_SetItalic(textAttributes.IsItalic()));
-        _lastTextAttributes.SetItalic(textAttributes.IsItalic());
+        if (next.GetForeground() != last.GetForeground())
+        {
+            appendColor(diff, next.GetForeground(), true);
+        }
+        if (next.GetBackground() != last.GetBackground())
+        {
+            appendColor(diff, next.GetBackground(), false);
+        }
+
+        // Turning off Intense and Faint must be handled at the same time,
+        // since there is only one parameter that resets both of them.
+        auto lastIntense = last.IsIntense();
+        auto lastFaint = last.IsFaint();
+        if ((lastIntense && !next.IsIntense()) || (lastFaint && !next.IsFaint()))
+        {
+            appendParameter(diff, "22");
+            lastIntense = false;
+            lastFaint = false;
+        }
+        if (next.IsIntense() && !lastIntense)
+        {
+            appendParameter(diff, "1");
+        }
+        if (next.IsFaint() && !lastFaint)
+        {
+            appendParameter(diff, "2");
+        }
+
+        // The same applies to the two underline styles.
+        auto lastUnderlined = last.IsUnderlined();
+        auto lastDoublyUnderlined = last.IsDoublyUnderlined();
+        if ((lastUnderlined && !next.IsUnderlined()) || (lastDoublyUnderlined && !next.IsDoublyUnderlined()))
+        {
+            appendParameter(diff, "24");
+            lastUnderlined = false;
+            lastDoublyUnderlined = false;
+        }
+        if (next.IsUnderlined() && !lastUnderlined)
+        {
+            appendParameter(diff, "4");
+        }
+        if (next.IsDoublyUnderlined() && !lastDoublyUnderlined)
+        {
+            appendParameter(diff, "21");
+        }
+
+        if (next.IsOverlined() != last.IsOverlined())
+        {
+            appendParameter(diff, next.IsOverlined() ? "53" : "55");
+        }
+        if (next.IsItalic() != last.IsItalic())
+        {
+            appendParameter(diff, next.IsItalic() ? "3" : "23");
+        }
+        if (next.IsBlinking() != last.IsBlinking())
+        {
+            appendParameter(diff, next.IsBlinking() ? "5" : "25");
+        }
+        if (next.IsInvisible() != last.IsInvisible())
+        {
+            appendParameter(diff, next.IsInvisible() ? "8" : "28");
+        }
+        if (next.IsCrossedOut() != last.IsCrossedOut())
+        {
+            appendParameter(diff, next.IsCrossedOut() ? "9" : "29");
+        }
+        if (next.IsReverseVideo() != last.IsReverseVideo())
+        {
+            appendParameter(diff, next.IsReverseVideo() ? "7" : "27");
+        }
     }
 
-    if (textAttributes.IsBlinking() != _lastTextAttributes.IsBlinking())
+    if (diff.size() == 0)
     {
-        RETURN_IF_FAILED(_SetBlinking(textAttributes.IsBlinking()));
-        _lastTextAttributes.SetBlinking(textAttributes.IsBlinking());
+        return;
     }
 
-    if (textAttributes.IsInvisible() != _lastTextAttributes.IsInvisible())
+    // The parameter set that follows a reset and as such only contains what's set.
     {
-        RETURN_IF_FAILED(_SetInvisible(textAttributes.IsInvisible()));
-        _lastTextAttributes.SetInvisible(textAttributes.IsInvisible());
+        if (!next.GetForeground().IsDefault())
+        {
+            appendColor(reset, next.GetForeground(), true);
+        }
+        if (!next.GetBackground().IsDefault())
+        {
+            appendColor(reset, next.GetBackground(), false);
+        }
+        const std::pair<bool, std::string_view> renditions[]{
+            { next.IsIntense(), "1" },
+            { next.IsFaint(), "2" },
+            { next.IsUnderlined(), "4" },
+            { next.IsDoublyUnderlined(), "21" },
+            { next.IsOverlined(), "53" },
+            { next.IsItalic(), "3" },
+            { next.IsBlinking(), "5" },
+            { next.IsInvisible(), "8" },
+            { next.IsCrossedOut(), "9" },
+            { next.IsReverseVideo(), "7" },
+        };
+        for (const auto& [set, parameter] : renditions)
+        {
+            if (set)
+            {
+                appendParameter(reset, parameter);
+            }
+        }
     }
 
-    if (textAttributes.IsCrossedOut() != _lastTextAttributes.IsCrossedOut())
+    // A plain reset is written as "CSI m". Otherwise it needs an explicit "0;" in front.
+    const auto resetSize = reset.size() == 0 ? 0 : reset.size() + 2;
+
+    out.append("\x1b[");
+    if (resetSize < diff.size())
     {
-        RETURN_IF_FAILED(_SetCrossedOut(textAttributes.IsCrossedOut()));
-        _lastTextAttributes.SetCrossedOut(textAttributes.IsCrossedOut());
+        if (reset.size() != 0)
+        {
+            out.append("0;");
+            out.append(reset.data(), reset.size());
+        }
     }
-
-    if (textAttributes.IsReverseVideo() != _lastTextAttributes.IsReverseVideo())
+    else
     {
-        RETURN_IF_FAILED(_SetReverseVideo(textAttributes.IsReverseVideo()));
-        _lastTextAttributes.SetReverseVideo(textAttributes.IsReverseVideo());
+        out.append(diff.data(), diff.size());
     }
-
-    return S_OK;
+    out.push_back('m');
 }
 
 // Routine Description:
@@ -41,10 +41,13 @@ namespace Microsoft::Console::Render
         friend class ::VtApiRoutines;
 
     private:
-        [[nodiscard]] HRESULT _UpdateExtendedAttrs(const TextAttribute& textAttributes) noexcept;
+        [[nodiscard]] HRESULT _UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept;
+        static void _FormatGraphicsRendition(const TextAttribute& last, const TextAttribute& next, std::string& out);
         [[nodiscard]] HRESULT _UpdateHyperlinkAttr(const TextAttribute& textAttributes,
                                                    const gsl::not_null<IRenderData*> pData) noexcept;
 
+        std::string _sgrBuffer;
+
 #ifdef UNIT_TESTING
         friend class VtRendererTest;
         friend class ConptyOutputTests;
@@ -398,6 +398,8 @@ try
         RETURN_IF_FAILED(_InsertLine(absDy));
     }
 
+    _ScrollShadowFrame(dy);
+
     // Restore our wrap state.
     _wrappedRow = oldWrappedRow;
     _delayedEolWrap = oldDelayedEolWrap;
@@ -509,9 +511,24 @@ CATCH_RETURN();
                                                    const bool /*trimLeft*/,
                                                    const bool lineWrapped) noexcept
 {
-    return _fUseAsciiOnly ?
-               VtEngine::_PaintAsciiBufferLine(clusters, coord) :
-               VtEngine::_PaintUtf8BufferLine(clusters, coord, lineWrapped);
+    // When the entire viewport is repainted, for instance because the buffer
+    // got resized, most of it is usually the same as what we sent before.
+    // Only send the runs that the terminal isn't displaying already.
+    const auto hash = _HashShadowRun(clusters, lineWrapped);
+    if (_IsRunTransmitted(coord, hash))
+    {
+        return S_OK;
+    }
+
+    RETURN_IF_FAILED(_fUseAsciiOnly ?
+                         VtEngine::_PaintAsciiBufferLine(clusters, coord) :
+                         VtEngine::_PaintUtf8BufferLine(clusters, coord, lineWrapped));
+
+    if (coord.y >= _virtualTop)
+    {
+        _RecordTransmittedRun(clusters, coord, hash);
+    }
+    return S_OK;
 }
 
 // Method Description:
@@ -526,6 +543,8 @@ CATCH_RETURN();
     RETURN_IF_FAILED(_fUseAsciiOnly ?
                          VtEngine::_WriteTerminalAscii(wstr) :
                          VtEngine::_WriteTerminalUtf8(wstr));
+    // We don't know what this sequence does to the terminal's contents.
+    _ResetShadowFrame();
     // GH#4106, GH#2011, GH#13710 - WriteTerminalW is only ever called by the
     // StateMachine, when we've encountered a string we don't understand. When
     // this happens, we will trigger a new frame in the renderer, and
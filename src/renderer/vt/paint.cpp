@@ -7,6 +7,8 @@
 #include "../../inc/conattrs.hpp"
 #include "../../types/inc/convert.hpp"
 
+#include <til/hash.h>
+
 #pragma hdrstop
 using namespace Microsoft::Console::Render;
 using namespace Microsoft::Console::Types;
@@ -28,6 +30,7 @@ using namespace Microsoft::Console::Types;
     // If we're using line renditions, and this is a full screen paint, we can
     // potentially stop using them at the end of this frame.
     _stopUsingLineRenditions = _usingLineRenditions && _AllIsInvalid();
+    _repaintingAll = _AllIsInvalid();
 
     // If there's nothing to do, quick return
     auto somethingToDo = _invalidMap.any() ||
@@ -246,80 +249,6 @@ using namespace Microsoft::Console::Types;
     return S_OK;
 }
 
-// Routine Description:
-// - Write a VT sequence to change the current colors of text. Writes true RGB
-//      color sequences.
-// Arguments:
-// - textAttributes: Text attributes to use for the colors.
-// Return Value:
-// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
-[[nodiscard]] HRESULT VtEngine::_RgbUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept
-{
-    const auto fg = textAttributes.GetForeground();
-    const auto bg = textAttributes.GetBackground();
-    auto lastFg = _lastTextAttributes.GetForeground();
-    auto lastBg = _lastTextAttributes.GetBackground();
-
-    // If both the FG and BG should be the defaults, emit a SGR reset.
-    if (fg.IsDefault() && bg.IsDefault() && !(lastFg.IsDefault() && lastBg.IsDefault()))
-    {
-        // SGR Reset will clear all attributes (except hyperlink ID) - which means
-        // we cannot reset _lastTextAttributes by simply doing
-        // _lastTextAttributes = {};
-        // because we want to retain the last hyperlink ID
-        RETURN_IF_FAILED(_SetGraphicsDefault());
-        _lastTextAttributes.SetDefaultBackground();
-        _lastTextAttributes.SetDefaultForeground();
-        _lastTextAttributes.SetDefaultRenditionAttributes();
-        lastFg = {};
-        lastBg = {};
-    }
-
-    if (fg != lastFg)
-    {
-        if (fg.IsDefault())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(true));
-        }
-        else if (fg.IsIndex16())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition16Color(fg.GetIndex(), true));
-        }
-        else if (fg.IsIndex256())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition256Color(fg.GetIndex(), true));
-        }
-        else if (fg.IsRgb())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(fg.GetRGB(), true));
-        }
-        _lastTextAttributes.SetForeground(fg);
-    }
-
-    if (bg != lastBg)
-    {
-        if (bg.IsDefault())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(false));
-        }
-        else if (bg.IsIndex16())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition16Color(bg.GetIndex(), false));
-        }
-        else if (bg.IsIndex256())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition256Color(bg.GetIndex(), false));
-        }
-        else if (bg.IsRgb())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(bg.GetRGB(), false));
-        }
-        _lastTextAttributes.SetBackground(bg);
-    }
-
-    return S_OK;
-}
-
 // Routine Description:
 // - Write a VT sequence to change the current colors of text. It will try to
 //      find ANSI colors that are nearest to the input colors, and write those
@@ -656,6 +585,153 @@ using namespace Microsoft::Console::Types;
     return S_OK;
 }
 
+// Method Description:
+// - Hashes everything that determines what a run painted by PaintBufferLine looks like
+//      in the terminal: its text, the width of each cluster, the current attributes
+//      (which UpdateDrawingBrushes has already transmitted) and whether the row wrapped.
+// Arguments:
+// - clusters - text and column widths to be written
+// - lineWrapped - true if this run ends a line that wrapped
+// Return Value:
+// - The hash to pass to _IsRunTransmitted and _RecordTransmittedRun.
+size_t VtEngine::_HashShadowRun(const std::span<const Cluster> clusters, const bool lineWrapped) const noexcept
+{
+    til::hasher h;
+    h.write(&_lastTextAttributes, sizeof(_lastTextAttributes));
+    h.write(lineWrapped);
+    for (const auto& cluster : clusters)
+    {
+        h.write(cluster.GetText());
+        h.write(cluster.GetColumns());
+    }
+    return h.finalize();
+}
+
+// Method Description:
+// - Returns the shadow of the given viewport row, or nullptr if it's out of bounds.
+std::vector<VtEngine::ShadowRun>* VtEngine::_GetShadowRow(const til::point coord) noexcept
+{
+    const auto height = _lastViewport.Height();
+    const auto row = coord.y - _lastViewport.Top();
+    if (row < 0 || row >= height)
+    {
+        return nullptr;
+    }
+
+    if (_shadowRows.size() != gsl::narrow_cast<size_t>(height))
+    {
+        try
+        {
+            _shadowRows.resize(gsl::narrow_cast<size_t>(height));
+        }
+        catch (...)
+        {
+            _shadowRows.clear();
+            return nullptr;
+        }
+    }
+
+    return &til::at(_shadowRows, row);
+}
+
+// Method Description:
+// - Returns true if the terminal already displays the given run, because this
+//      is a repaint of the entire viewport and we transmitted the very same run
+//      at the same position before. The run doesn't need to be painted then.
+// - Line renditions, soft fonts and passthrough mode aren't tracked by the shadow.
+// Arguments:
+// - coord - character coordinate target to render within viewport
+// - hash - the result of _HashShadowRun for the run
+// Return Value:
+// - true if the run can be skipped.
+bool VtEngine::_IsRunTransmitted(const til::point coord, const size_t hash) noexcept
+{
+    if (!_repaintingAll || _clearedAllThisFrame || _usingLineRenditions || _usingSoftFont || _passthrough)
+    {
+        return false;
+    }
+
+    const auto shadow = _GetShadowRow(coord);
+    if (!shadow)
+    {
+        return false;
+    }
+
+    return std::ranges::any_of(*shadow, [&](const ShadowRun& run) {
+        return run.column == coord.x && run.hash == hash;
+    });
+}
+
+// Method Description:
+// - Remembers that the given run was transmitted to the terminal. Any runs it
+//      (partially) overwrote are forgotten, so that they'll be painted again.
+// Arguments:
+// - clusters - text and column widths that were written
+// - coord - character coordinate target the run was rendered at
+// - hash - the result of _HashShadowRun for the run
+void VtEngine::_RecordTransmittedRun(const std::span<const Cluster> clusters, const til::point coord, const size_t hash) noexcept
+{
+    const auto shadow = _GetShadowRow(coord);
+    if (!shadow)
+    {
+        return;
+    }
+
+    til::CoordType columns = 0;
+    for (const auto& cluster : clusters)
+    {
+        columns += cluster.GetColumns();
+    }
+
+    const auto begin = coord.x;
+    const auto end = coord.x + columns;
+    std::erase_if(*shadow, [&](const ShadowRun& run) {
+        return run.column < end && begin < run.column + run.columns;
+    });
+
+    try
+    {
+        shadow->emplace_back(ShadowRun{ begin, columns, hash });
+    }
+    CATCH_LOG();
+}
+
+// Method Description:
+// - Moves the rows of the shadow frame along with the contents of the terminal,
+//      after ScrollFrame scrolled them. The rows that scrolled into view are empty.
+// Arguments:
+// - dy - the distance the contents moved. Negative values move them up.
+void VtEngine::_ScrollShadowFrame(const til::CoordType dy) noexcept
+{
+    const auto height = gsl::narrow_cast<til::CoordType>(_shadowRows.size());
+    if (dy <= -height || dy >= height)
+    {
+        _ResetShadowFrame();
+    }
+    else if (dy < 0)
+    {
+        std::rotate(_shadowRows.begin(), _shadowRows.begin() - dy, _shadowRows.end());
+        std::for_each(_shadowRows.end() + dy, _shadowRows.end(), [](auto& row) { row.clear(); });
+    }
+    else if (dy > 0)
+    {
+        std::rotate(_shadowRows.begin(), _shadowRows.end() - dy, _shadowRows.end());
+        std::for_each(_shadowRows.begin(), _shadowRows.begin() + dy, [](auto& row) { row.clear(); });
+    }
+}
+
+// Method Description:
+// - Forgets what the terminal displays, because we emitted something that
+//      changed its contents outside of PaintBufferLine. The next repaint
+//      will transmit everything again.
+void VtEngine::_ResetShadowFrame() noexcept
+{
+    for (auto& row : _shadowRows)
+    {
+        row.clear();
+    }
+}
+
 // Method Description:
 // - Updates the window's title string. Emits the VT sequence to SetWindowTitle.
 //      Because wintelnet does not understand these sequences by default, we
@@ -18,6 +18,15 @@ using namespace Microsoft::Console::Types;
 
 constexpr til::point VtEngine::INVALID_COORDS = { -1, -1 };
 
+// Output is usually flushed once per frame, but a single frame (like a full repaint
+// of a large window full of colored text) can be arbitrarily large. Once _buffer
+// exceeds the high watermark we flush it early instead of growing it any further.
+// Since our pipe writes are synchronous, this also makes PaintFrame block on a
+// terminal that's slow to drain, which gives the client output time to coalesce.
+// After a flush we keep up to the low watermark of capacity around for the next frame.
+static constexpr size_t s_bufferHighWatermark = 256 * 1024;
+static constexpr size_t s_bufferLowWatermark = 16 * 1024;
+
 // Routine Description:
 // - Creates a new VT-based rendering engine
 // - NOTE: Will throw if initialization failure. Caller must catch.
@@ -72,6 +81,15 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
 [[nodiscard]] HRESULT VtEngine::_WriteFill(const size_t n, const char c) noexcept
 try
 {
+    if (_updatingShadowBuffer)
+    {
+        return S_OK;
+    }
+    if (_passthrough)
+    {
+        _passthroughOutput.append(n, c);
+    }
+
     _trace.TraceStringFill(n, c);
 #ifdef UNIT_TESTING
     if (_usingTestCallback)
@@ -94,7 +112,7 @@ try
 
     // TODO GH10001: Replace me with REP
     _buffer.append(n, c);
-    return S_OK;
+    return _buffer.size() >= s_bufferHighWatermark ? _Flush() : S_OK;
 }
 CATCH_RETURN();
 
@@ -108,6 +126,19 @@ CATCH_RETURN();
 // - S_OK or suitable HRESULT error from writing pipe.
 [[nodiscard]] HRESULT VtEngine::_Write(std::string_view const str) noexcept
 {
+    if (_updatingShadowBuffer)
+    {
+        return S_OK;
+    }
+    if (_passthrough)
+    {
+        try
+        {
+            _passthroughOutput.append(str);
+        }
+        CATCH_RETURN();
+    }
+
     _trace.TraceString(str);
 #ifdef UNIT_TESTING
     if (_usingTestCallback)
@@ -130,21 +161,31 @@ CATCH_RETURN();
     try
     {
         _buffer.append(str);
-
-        return S_OK;
     }
     CATCH_RETURN();
+
+    return _buffer.size() >= s_bufferHighWatermark ? _Flush() : S_OK;
 }
 
 [[nodiscard]] HRESULT VtEngine::_Flush() noexcept
 {
-    if (_hFile)
+    // Many callers flush unconditionally after every operation. There's no point in a syscall for 0 bytes.
+    if (_hFile && !_buffer.empty())
     {
-        auto fSuccess = !!WriteFile(_hFile.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), nullptr, nullptr);
+        auto fSuccess = _outputRing ? _outputRing->write(_buffer) : !!WriteFile(_hFile.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), nullptr, nullptr);
         _buffer.clear();
+        if (_buffer.capacity() > 2 * s_bufferHighWatermark)
+        {
+            // A single huge write (like a long pasted line) grew the buffer past what the high
+            // watermark would've allowed. Release that memory, but keep enough around for a typical frame.
+            _buffer.shrink_to_fit();
+            _buffer.reserve(s_bufferLowWatermark);
+        }
         if (!fSuccess)
         {
-            _exitResult = HRESULT_FROM_WIN32(GetLastError());
+            // The ring doesn't set a last error. It only fails if the terminal closed it.
+            _exitResult = _outputRing ? HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE) : HRESULT_FROM_WIN32(GetLastError());
+            _outputRing.reset();
             _hFile.reset();
             if (_terminalOwner)
             {
@@ -283,6 +324,9 @@ CATCH_RETURN();
             // invalid. Previously, we'd invalidate everything if the width changed,
             // because we couldn't be sure if lines were reflowed.
             _invalidMap.resize(newSize);
+
+            // The terminal reflows its own contents, so we can't know what it displays anymore.
+            _ResetShadowFrame();
         }
         else
         {
@@ -294,6 +338,9 @@ CATCH_RETURN();
                 if (oldSize.height > newSize.height || oldSize.width > newSize.width)
                 {
                     hr = InvalidateAll();
+
+                    // We can't know how the terminal shrunk its contents either.
+                    _ResetShadowFrame();
                 }
             }
         }
@@ -490,6 +537,17 @@ void VtEngine::SetResizeQuirk(const bool resizeQuirk)
     _resizeQuirk = resizeQuirk;
 }
 
+// Method Description:
+// - Makes the engine write its output into the given shared memory ring, instead of the output pipe.
+// Arguments:
+// - outputRing - The producer end of the ring the terminal reads from.
+// Return Value:
+// - <none>
+void VtEngine::SetOutputRing(std::unique_ptr<til::shared_ring::producer> outputRing) noexcept
+{
+    _outputRing = std::move(outputRing);
+}
+
 // Method Description:
 // - Configure the renderer to understand that we're operating in limited-draw
 //   passthrough mode. We do not need to handle full responsibility for replicating
@@ -503,6 +561,56 @@ void VtEngine::SetPassthroughMode(const bool passthrough) noexcept
     _passthrough = passthrough;
 }
 
+// Method Description:
+// - Hands out everything that was written to the terminal in passthrough mode
+//   since the last call. The caller is expected to replay it into the host
+//   buffer, between calls to BeginShadowBufferUpdate and EndShadowBufferUpdate.
+// Arguments:
+// - output - Receives the pending output. Its previous contents are discarded,
+//   but its capacity is reused for the next batch of output.
+// Return Value:
+// - <none>
+void VtEngine::TakePassthroughOutput(std::string& output) noexcept
+{
+    output.clear();
+    std::swap(output, _passthroughOutput);
+}
+
+// Method Description:
+// - Returns the number of bytes that TakePassthroughOutput would return.
+size_t VtEngine::GetPassthroughOutputSize() const noexcept
+{
+    return _passthroughOutput.size();
+}
+
+// Method Description:
+// - Prepares for the host buffer to be brought up to date with the output that
+//   was passed through to the terminal. Until EndShadowBufferUpdate is called,
+//   anything we'd write to the terminal is dropped, because the terminal has
+//   already received that very output in the first place.
+void VtEngine::BeginShadowBufferUpdate() noexcept
+{
+    _updatingShadowBuffer = true;
+}
+
+// Method Description:
+// - Ends the update started by BeginShadowBufferUpdate. Any invalidation that
+//   the update caused is forgotten. The terminal already shows those changes,
+//   so there's nothing for us to paint.
+void VtEngine::EndShadowBufferUpdate() noexcept
+{
+    _updatingShadowBuffer = false;
+    _invalidMap.reset_all();
+    _scrollDelta = { 0, 0 };
+    _cursorMoved = false;
+    _titleChanged = false;
+}
+
+bool VtEngine::IsUpdatingShadowBuffer() const noexcept
+{
+    return _updatingShadowBuffer;
+}
+
 void VtEngine::SetLookingForDSRCallback(std::function<void(bool)> pfnLooking) noexcept
 {
     _pfnSetLookingForDSR = pfnLooking;
@@ -20,6 +20,7 @@ Author(s):
 #include "tracing.hpp"
 #include <string>
 #include <functional>
+#include <til/shared_ring.h>
 
 // fwdecl unittest classes
 #ifdef UNIT_TESTING
@@ -55,7 +56,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT Invalidate(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateCursor(const til::rect* psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateSystem(const til::rect* prcDirtyClient) noexcept override;
-        [[nodiscard]] HRESULT InvalidateSelection(const std::vector<til::rect>& rectangles) noexcept override;
+        [[nodiscard]] HRESULT InvalidateSelection(std::span<const til::rect> rectangles) noexcept override;
         [[nodiscard]] HRESULT InvalidateAll() noexcept override;
         [[nodiscard]] HRESULT InvalidateFlush(_In_ const bool circled, _Out_ bool* const pForcePaint) noexcept override;
         [[nodiscard]] HRESULT ResetLineTransform() noexcept override;
@@ -83,7 +84,13 @@ namespace Microsoft::Console::Render
         void BeginResizeRequest();
         void EndResizeRequest();
         void SetResizeQuirk(const bool resizeQuirk);
+        void SetOutputRing(std::unique_ptr<til::shared_ring::producer> outputRing) noexcept;
         void SetPassthroughMode(const bool passthrough) noexcept;
+        void TakePassthroughOutput(std::string& output) noexcept;
+        size_t GetPassthroughOutputSize() const noexcept;
+        void BeginShadowBufferUpdate() noexcept;
+        void EndShadowBufferUpdate() noexcept;
+        bool IsUpdatingShadowBuffer() const noexcept;
         void SetLookingForDSRCallback(std::function<void(bool)> pfnLooking) noexcept;
         void SetTerminalCursorTextPosition(const til::point coordCursor) noexcept;
         [[nodiscard]] virtual HRESULT ManuallyClearScrollback() noexcept;
@@ -93,6 +100,9 @@ namespace Microsoft::Console::Render
 
     protected:
         wil::unique_hfile _hFile;
+        // If set, output is written into this ring instead of _hFile.
+        // _hFile stays open regardless, because the terminal uses it to detect our exit.
+        std::unique_ptr<til::shared_ring::producer> _outputRing;
         std::string _buffer;
 
         std::string _formatBuffer;
@@ -139,9 +149,28 @@ namespace Microsoft::Console::Render
 
         bool _resizeQuirk{ false };
         bool _passthrough{ false };
+        // In passthrough mode, everything we send to the terminal is also kept here until
+        // VtApiRoutines replays it into the host buffer. While it does so, _updatingShadowBuffer
+        // is set and all output is dropped, because the terminal has already seen it.
+        std::string _passthroughOutput;
+        bool _updatingShadowBuffer{ false };
         bool _noFlushOnEnd{ false };
         std::optional<TextColor> _newBottomLineBG{ std::nullopt };
 
+        // A copy of what we last transmitted for each row of the viewport, as a list of
+        // the runs passed to PaintBufferLine, identified by a hash of their contents.
+        // When the entire viewport gets repainted, runs that the terminal already displays
+        // are skipped, so that only the changed parts of the frame are sent over the pipe.
+        // It's reset whenever we lose track of what the terminal displays.
+        struct ShadowRun
+        {
+            til::CoordType column;
+            til::CoordType columns;
+            size_t hash;
+        };
+        std::vector<std::vector<ShadowRun>> _shadowRows;
+        bool _repaintingAll{ false };
+
         [[nodiscard]] HRESULT _WriteFill(const size_t n, const char c) noexcept;
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
         [[nodiscard]] HRESULT _Flush() noexcept;
@@ -209,7 +238,6 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _RequestFocusEventMode() noexcept;
 
         [[nodiscard]] virtual HRESULT _MoveCursor(const til::point coord) noexcept = 0;
-        [[nodiscard]] HRESULT _RgbUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept;
         [[nodiscard]] HRESULT _16ColorUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept;
 
         bool _WillWriteSingleChar() const;
@@ -224,6 +252,13 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _PaintAsciiBufferLine(const std::span<const Cluster> clusters,
                                                     const til::point coord) noexcept;
 
+        size_t _HashShadowRun(const std::span<const Cluster> clusters, const bool lineWrapped) const noexcept;
+        std::vector<ShadowRun>* _GetShadowRow(const til::point coord) noexcept;
+        bool _IsRunTransmitted(const til::point coord, const size_t hash) noexcept;
+        void _RecordTransmittedRun(const std::span<const Cluster> clusters, const til::point coord, const size_t hash) noexcept;
+        void _ScrollShadowFrame(const til::CoordType dy) noexcept;
+        void _ResetShadowFrame() noexcept;
+
         [[nodiscard]] HRESULT _WriteTerminalUtf8(const std::wstring_view str) noexcept;
         [[nodiscard]] HRESULT _WriteTerminalAscii(const std::wstring_view str) noexcept;
         [[nodiscard]] HRESULT _WriteTerminalDrcs(const std::wstring_view str) noexcept;
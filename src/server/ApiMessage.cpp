@@ -31,6 +31,7 @@ _CONSOLE_API_MSG& _CONSOLE_API_MSG::operator=(const _CONSOLE_API_MSG& other)
     _pApiRoutines = other._pApiRoutines;
     _inputBuffer = other._inputBuffer;
     _outputBuffer = other._outputBuffer;
+    _prefetchedInput = other._prefetchedInput;
 
     // Since this struct uses anonymous unions and thus cannot
     // explicitly reference it, we have to a bit cheeky to copy it.
@@ -39,7 +40,17 @@ _CONSOLE_API_MSG& _CONSOLE_API_MSG::operator=(const _CONSOLE_API_MSG& other)
 
     if (State.InputBuffer)
     {
-        State.InputBuffer = _inputBuffer.data();
+        // The input buffer either points into _prefetchedInput (see GetInputBuffer) or is _inputBuffer.
+        const auto input = reinterpret_cast<uintptr_t>(other.State.InputBuffer);
+        const auto prefetched = reinterpret_cast<uintptr_t>(other._prefetchedInput.data());
+        if (input >= prefetched && input < prefetched + other._prefetchedInput.size())
+        {
+            State.InputBuffer = _prefetchedInput.data() + (input - prefetched);
+        }
+        else
+        {
+            State.InputBuffer = _inputBuffer.data();
+        }
     }
 
     if (State.OutputBuffer)
@@ -106,18 +117,27 @@ try
 
         const auto cbReadSize = Descriptor.InputSize - State.ReadOffset;
 
-        // If we were previously called with a huge buffer we have an equally large _inputBuffer.
-        // We shouldn't just keep this huge buffer around, if no one needs it anymore.
-        if (_inputBuffer.capacity() > 16 * 1024 && (_inputBuffer.capacity() >> 1) > cbReadSize)
+        // Small payloads might have been received alongside the message already,
+        // in which case we can hand them out without copying them anywhere.
+        if (State.ReadOffset + cbReadSize <= _prefetchedInput.size())
         {
-            _inputBuffer.shrink_to_fit();
+            State.InputBuffer = _prefetchedInput.data() + State.ReadOffset;
+        }
+        else
+        {
+            // If we were previously called with a huge buffer we have an equally large _inputBuffer.
+            // We shouldn't just keep this huge buffer around, if no one needs it anymore.
+            if (_inputBuffer.capacity() > 16 * 1024 && (_inputBuffer.capacity() >> 1) > cbReadSize)
+            {
+                _inputBuffer.shrink_to_fit();
+            }
+
+            // The driver copies the payload straight into our buffer, so there's no point in zeroing it first.
+            _inputBuffer.resize_for_overwrite(cbReadSize);
+            RETURN_IF_FAILED(ReadMessageInput(0, _inputBuffer.data(), cbReadSize));
+            State.InputBuffer = _inputBuffer.data();
         }
 
-        _inputBuffer.resize(cbReadSize);
-
-        RETURN_IF_FAILED(ReadMessageInput(0, _inputBuffer.data(), cbReadSize));
-
-        State.InputBuffer = _inputBuffer.data();
         State.InputBufferSize = cbReadSize;
     }
 
@@ -156,9 +176,9 @@ try
             _outputBuffer.shrink_to_fit();
         }
 
-        _outputBuffer.resize(cbWriteSize);
-
-        // 0 it out.
+        // 0 it out. resize() would do that only for the newly added elements,
+        // so we skip that and clear the entire buffer in one go instead.
+        _outputBuffer.resize_for_overwrite(cbWriteSize);
         std::fill_n(_outputBuffer.data(), _outputBuffer.size(), BYTE(0));
 
         State.OutputBuffer = _outputBuffer.data();
@@ -64,6 +64,11 @@ typedef struct _CONSOLE_API_MSG
     til::small_vector<BYTE, 128> _inputBuffer;
     til::small_vector<BYTE, 128> _outputBuffer;
 
+    // The beginning of the message's input payload (starting at offset 0, the CONSOLE_MSG_HEADER),
+    // if the IDeviceComm was able to retrieve it alongside the message. See ConDrvDeviceComm::ReadIo.
+    static constexpr size_t PrefetchedInputSize = 4096;
+    til::small_vector<BYTE, 128> _prefetchedInput;
+
     // From here down is the actual packet data sent/received.
     CD_IO_DESCRIPTOR Descriptor;
     union
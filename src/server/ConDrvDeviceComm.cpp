@@ -39,16 +39,42 @@ ConDrvDeviceComm::~ConDrvDeviceComm() = default;
 [[nodiscard]] HRESULT ConDrvDeviceComm::ReadIo(_In_opt_ PCONSOLE_API_MSG const pReplyMsg,
                                                _Out_ CONSOLE_API_MSG* const pMessage) const
 {
+    // The driver follows the descriptor with as much of the message's input payload as fits into our
+    // buffer. The packet portion of CONSOLE_API_MSG only fits the API message structures, while the
+    // payload of e.g. WriteConsole (the text) would otherwise require a separate IOCTL_CONDRV_READ_INPUT.
+    // Clients that call WriteConsole in a tight loop with short strings thus spent half their round
+    // trips on that second IOCTL. By asking for a bit more we can hand the payload out from memory.
+    static constexpr DWORD packetSize = sizeof(CONSOLE_API_MSG) - FIELD_OFFSET(CONSOLE_API_MSG, Descriptor);
+    static constexpr DWORD descriptorSize = sizeof(CD_IO_DESCRIPTOR);
+    alignas(CONSOLE_API_MSG) BYTE buffer[packetSize + CONSOLE_API_MSG::PrefetchedInputSize];
+
+    DWORD written = 0;
     auto hr = _CallIoctl(IOCTL_CONDRV_READ_IO,
                          pReplyMsg == nullptr ? nullptr : &pReplyMsg->Complete,
                          pReplyMsg == nullptr ? 0 : sizeof(pReplyMsg->Complete),
-                         &pMessage->Descriptor,
-                         sizeof(CONSOLE_API_MSG) - FIELD_OFFSET(CONSOLE_API_MSG, Descriptor));
+                         &buffer[0],
+                         sizeof(buffer),
+                         &written);
 
     if (hr == HRESULT_FROM_WIN32(ERROR_IO_PENDING))
     {
         WaitForSingleObjectEx(_Server.get(), 0, FALSE);
         hr = S_OK; // TODO: MSFT: 9115192 - ??? This isn't really relevant anymore with a switch from NtDeviceIoControlFile to DeviceIoControl...
+        // We don't know how much was written in this case. Don't trust anything past the packet.
+        written = 0;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Like before, the parts of the packet that the driver didn't write to retain their previous contents.
+        memcpy(&pMessage->Descriptor, &buffer[0], written ? std::min(written, packetSize) : packetSize);
+
+        // GetInputBuffer falls back to IOCTL_CONDRV_READ_INPUT for anything that isn't in here.
+        pMessage->_prefetchedInput.clear();
+        if (written > descriptorSize && written <= sizeof(buffer))
+        {
+            pMessage->_prefetchedInput.insert(pMessage->_prefetchedInput.end(), &buffer[descriptorSize], &buffer[written]);
+        }
     }
 
     return hr;
@@ -132,10 +158,11 @@ ConDrvDeviceComm::~ConDrvDeviceComm() = default;
                                                    _In_reads_bytes_opt_(cbInBufferSize) PVOID pInBuffer,
                                                    _In_ DWORD cbInBufferSize,
                                                    _Out_writes_bytes_opt_(cbOutBufferSize) PVOID pOutBuffer,
-                                                   _In_ DWORD cbOutBufferSize) const
+                                                   _In_ DWORD cbOutBufferSize,
+                                                   _Out_opt_ DWORD* pcbWritten) const
 {
     // See: https://msdn.microsoft.com/en-us/library/windows/desktop/aa363216(v=vs.85).aspx
-    // Written is unused but cannot be nullptr because we aren't using overlapped.
+    // Written cannot be nullptr because we aren't using overlapped.
     DWORD cbWritten = 0;
     RETURN_IF_WIN32_BOOL_FALSE(DeviceIoControl(_Server.get(),
                                                dwIoControlCode,
@@ -146,6 +173,10 @@ ConDrvDeviceComm::~ConDrvDeviceComm() = default;
                                                &cbWritten,
                                                nullptr));
 
+    if (pcbWritten)
+    {
+        *pcbWritten = cbWritten;
+    }
     return S_OK;
 }
 
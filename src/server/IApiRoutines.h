@@ -265,6 +265,11 @@ public:
                                                          const Microsoft::Console::Types::Viewport& sourceRectangle,
                                                          Microsoft::Console::Types::Viewport& readRectangle) noexcept = 0;
 
+    [[nodiscard]] virtual HRESULT GetConsoleOutputChangesImpl(const IConsoleOutputObject& context,
+                                                              const uint64_t sequence,
+                                                              std::vector<Microsoft::Console::Types::Viewport>& changedRectangles,
+                                                              uint64_t& currentSequence) noexcept = 0;
+
     [[nodiscard]] virtual HRESULT GetConsoleTitleAImpl(std::span<char> title,
                                                        size_t& written,
                                                        size_t& needed) noexcept = 0;
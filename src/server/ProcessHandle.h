@@ -62,6 +62,9 @@ private:
 
     mutable ULONG64 _processCreationTime;
 
+    // The order in which the process connected. Assigned by the ConsoleProcessList.
+    ULONG64 _sequence = 0;
+
     const ConsoleProcessPolicy _policy;
     const ConsoleShimPolicy _shimPolicy;
 
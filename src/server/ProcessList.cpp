@@ -40,7 +40,14 @@ using namespace Microsoft::Console::Interactivity;
     try
     {
         pProcessData = std::make_unique<ConsoleProcessHandle>(dwProcessId, dwThreadId, ulProcessGroupId);
-        _processes.emplace_back(pProcessData.get());
+        pProcessData->_sequence = _nextSequence++;
+
+        // If any of the insertions fails, undo the others, so that the indexes remain consistent.
+        auto undo = wil::scope_exit([&]() noexcept { _Erase(pProcessData.get()); });
+        _processes.emplace(pProcessData->_sequence, pProcessData.get());
+        _processesById.emplace(dwProcessId, pProcessData.get());
+        _processesByGroupId[ulProcessGroupId].emplace(pProcessData->_sequence, pProcessData.get());
+        undo.release();
     }
     CATCH_RETURN();
 
@@ -59,10 +66,10 @@ void ConsoleProcessList::FreeProcessData(_In_ ConsoleProcessHandle* const pProce
 {
     assert(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked());
 
-    const auto it = std::ranges::find(_processes, pProcessData);
-    if (it != _processes.end())
+    const auto it = _processesById.find(pProcessData->dwProcessId);
+    if (it != _processesById.end() && it->second == pProcessData)
     {
-        _processes.erase(it);
+        _Erase(pProcessData);
         delete pProcessData;
     }
     else
@@ -84,15 +91,8 @@ ConsoleProcessHandle* ConsoleProcessList::FindProcessInList(const DWORD dwProces
 {
     assert(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked());
 
-    for (const auto& p : _processes)
-    {
-        if (p->dwProcessId == dwProcessId)
-        {
-            return p;
-        }
-    }
-
-    return nullptr;
+    const auto it = _processesById.find(dwProcessId);
+    return it != _processesById.end() ? it->second : nullptr;
 }
 
 // Routine Description:
@@ -105,15 +105,9 @@ ConsoleProcessHandle* ConsoleProcessList::FindProcessByGroupId(_In_ ULONG ulProc
 {
     assert(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked());
 
-    for (const auto& p : _processes)
-    {
-        if (p->_ulProcessGroupId == ulProcessGroupId)
-        {
-            return p;
-        }
-    }
-
-    return nullptr;
+    // Groups are erased once their last process is gone, so they're never empty.
+    const auto it = _processesByGroupId.find(ulProcessGroupId);
+    return it != _processesByGroupId.end() ? it->second.begin()->second : nullptr;
 }
 
 // Routine Description:
@@ -124,7 +118,7 @@ ConsoleProcessHandle* ConsoleProcessList::GetRootProcess() const
 {
     assert(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked());
 
-    for (const auto& p : _processes)
+    for (const auto& [sequence, p] : _processes)
     {
         if (p->fRootProcess)
         {
@@ -149,7 +143,7 @@ ConsoleProcessHandle* ConsoleProcessList::GetOldestProcess() const
 
     if (!_processes.empty())
     {
-        return _processes.front();
+        return _processes.begin()->second;
     }
 
     return nullptr;
@@ -183,7 +177,7 @@ ConsoleProcessHandle* ConsoleProcessList::GetOldestProcess() const
 
     for (; it != end; ++it)
     {
-        *pProcessList++ = (*it)->dwProcessId;
+        *pProcessList++ = it->second->dwProcessId;
     }
 
     *pcProcessList = _processes.size();
@@ -211,35 +205,44 @@ ConsoleProcessHandle* ConsoleProcessList::GetOldestProcess() const
     {
         termRecords.clear();
 
-        // Dig through known processes looking for a match
-        for (const auto& p : _processes)
+        // If no limit was specified, generate a termination record for every process.
+        // Otherwise only the processes in the given group are of interest, which the index gives us directly.
+        const decltype(_processes)* processes = &_processes;
+        if (dwLimitingProcessId)
         {
-            // If no limit was specified OR if we have a match, generate a new termination record.
-            if (!dwLimitingProcessId ||
-                p->_ulProcessGroupId == dwLimitingProcessId)
+            const auto it = _processesByGroupId.find(dwLimitingProcessId);
+            if (it == _processesByGroupId.end())
             {
-                // If we're hard closing the window, increment the counter.
-                if (fCtrlClose)
-                {
-                    p->_ulTerminateCount++;
-                }
-
-                wil::unique_handle process;
-                // If the duplicate failed, the best we can do is to skip including the process in the list and hope it goes away.
-                LOG_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(),
-                                                        p->_hProcess.get(),
-                                                        GetCurrentProcess(),
-                                                        &process,
-                                                        0,
-                                                        0,
-                                                        DUPLICATE_SAME_ACCESS));
-
-                termRecords.emplace_back(ConsoleProcessTerminationRecord{
-                    .hProcess = std::move(process),
-                    .dwProcessID = p->dwProcessId,
-                    .ulTerminateCount = p->_ulTerminateCount,
-                });
+                return S_OK;
             }
+            processes = &it->second;
+        }
+
+        termRecords.reserve(processes->size());
+
+        for (const auto& [sequence, p] : *processes)
+        {
+            // If we're hard closing the window, increment the counter.
+            if (fCtrlClose)
+            {
+                p->_ulTerminateCount++;
+            }
+
+            wil::unique_handle process;
+            // If the duplicate failed, the best we can do is to skip including the process in the list and hope it goes away.
+            LOG_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(),
+                                                    p->_hProcess.get(),
+                                                    GetCurrentProcess(),
+                                                    &process,
+                                                    0,
+                                                    0,
+                                                    DUPLICATE_SAME_ACCESS));
+
+            termRecords.emplace_back(ConsoleProcessTerminationRecord{
+                .hProcess = std::move(process),
+                .dwProcessID = p->dwProcessId,
+                .ulTerminateCount = p->_ulTerminateCount,
+            });
         }
 
         return S_OK;
@@ -258,7 +261,7 @@ void ConsoleProcessList::ModifyConsoleProcessFocus(const bool fForeground)
 {
     assert(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked());
 
-    for (const auto& pProcessHandle : _processes)
+    for (const auto& [sequence, pProcessHandle] : _processes)
     {
         if (pProcessHandle->_hProcess)
         {
@@ -283,6 +286,27 @@ bool ConsoleProcessList::IsEmpty() const
     return _processes.empty();
 }
 
+// Routine Description:
+// - Removes the given process from the list and all of its indexes, without freeing it.
+// Arguments:
+// - pProcessData - The process to remove.
+// Return Value:
+// - <none>
+void ConsoleProcessList::_Erase(const ConsoleProcessHandle* const pProcessData) noexcept
+{
+    _processes.erase(pProcessData->_sequence);
+    _processesById.erase(pProcessData->dwProcessId);
+
+    if (const auto it = _processesByGroupId.find(pProcessData->_ulProcessGroupId); it != _processesByGroupId.end())
+    {
+        it->second.erase(pProcessData->_sequence);
+        if (it->second.empty())
+        {
+            _processesByGroupId.erase(it);
+        }
+    }
+}
+
 // Routine Description:
 // - Requests the OS allow the console to set one of its child processes as the foreground window
 // Arguments:
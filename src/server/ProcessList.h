@@ -58,7 +58,16 @@ public:
     bool IsEmpty() const;
 
 private:
-    std::vector<ConsoleProcessHandle*> _processes;
-
+    void _Erase(const ConsoleProcessHandle* const pProcessData) noexcept;
     void _ModifyProcessForegroundRights(const HANDLE hProcess, const bool fForeground) const;
+
+    // All processes, ordered from oldest to newest by their _sequence.
+    // GetOldestProcess() and GetProcessList() depend on this order.
+    std::map<ULONG64, ConsoleProcessHandle*> _processes;
+    // Indexes into _processes, so that finding a process by its ID or
+    // group doesn't need to scan through all of them. Consoles shared by large
+    // parallel builds may have thousands of short-lived processes attached.
+    std::unordered_map<DWORD, ConsoleProcessHandle*> _processesById;
+    std::unordered_map<ULONG, std::map<ULONG64, ConsoleProcessHandle*>> _processesByGroupId;
+    ULONG64 _nextSequence = 0;
 };
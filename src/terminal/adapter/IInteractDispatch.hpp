@@ -34,6 +34,8 @@ namespace Microsoft::Console::VirtualTerminal
 
         virtual bool WriteString(const std::wstring_view string) = 0;
 
+        virtual bool WritePassThroughString(const std::wstring_view string) = 0;
+
         virtual bool WindowManipulation(const DispatchTypes::WindowManipulationType function,
                                         const VTParameter parameter1,
                                         const VTParameter parameter2) = 0;
@@ -31,6 +31,7 @@ public:
 
     virtual void Print(const wchar_t wchPrintable) = 0;
     virtual void PrintString(const std::wstring_view string) = 0;
+    virtual void PrintLines(const std::wstring_view string) = 0;
 
     virtual bool CursorUp(const VTInt distance) = 0; // CUU
     virtual bool CursorDown(const VTInt distance) = 0; // CUD
@@ -146,6 +147,10 @@ public:
                                        const VTParameter cellHeight,
                                        const DispatchTypes::DrcsCharsetSize charsetSize) = 0; // DECDLD
 
+    virtual StringHandler DefineSixelImage(const VTInt macroParameter,
+                                           const DispatchTypes::SixelBackground backgroundSelect,
+                                           const VTParameter backgroundColor) = 0; // SIXEL
+
     virtual StringHandler DefineMacro(const VTInt macroId,
                                       const DispatchTypes::MacroDeleteControl deleteControl,
                                       const DispatchTypes::MacroEncoding encoding) = 0; // DECDMAC
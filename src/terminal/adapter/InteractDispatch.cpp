@@ -41,6 +41,7 @@ InteractDispatch::InteractDispatch() :
 bool InteractDispatch::WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inputEvents)
 {
     const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    FlushPendingKeys();
     gci.GetActiveInputBuffer()->Write(inputEvents);
     return true;
 }
@@ -50,16 +51,52 @@ bool InteractDispatch::WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inpu
 //   process special keys such as Ctrl-C or Ctrl+Break. The host will then
 //   decide what to do with it, including potentially sending an interrupt to a
 //   client application.
+// - Every other key is only queued up and written to the input buffer in a
+//   single batch by the next call to FlushPendingKeys(). This avoids waking up
+//   pending reads once per key when a whole chunk of win32-input-mode
+//   sequences was received at once.
 // Arguments:
 // - event: The key to send to the host.
 // Return Value:
 // - True.
 bool InteractDispatch::WriteCtrlKey(const KeyEvent& event)
 {
+    if (!IsSpecialKeyEvent(event))
+    {
+        _pendingKeys.emplace_back(event.ToInputRecord());
+        return true;
+    }
+
+    FlushPendingKeys();
     HandleGenericKeyEvent(event, false);
     return true;
 }
 
+// Method Description:
+// - Writes all key events queued up by WriteCtrlKey() to the input buffer.
+//   Every other method that writes to the input buffer calls this first,
+//   so that the order of the input is preserved.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void InteractDispatch::FlushPendingKeys() const
+{
+    if (_pendingKeys.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        gci.GetActiveInputBuffer()->Write(std::span<const INPUT_RECORD>{ _pendingKeys });
+    }
+    CATCH_LOG();
+
+    _pendingKeys.clear();
+}
+
 // Method Description:
 // - Writes a string of input to the host. The string is converted to keystrokes
 //      that will faithfully represent the input by CharToKeyEvents.
@@ -88,6 +125,23 @@ bool InteractDispatch::WriteString(const std::wstring_view string)
     return true;
 }
 
+// Method Description:
+// - Writes a string of VT input to the host, which is meant to be read by a
+//   VT input mode client as is. Unlike WriteString(), this doesn't synthesize
+//   a key-down/key-up pair per character, so that large pastes can be moved
+//   into the input buffer in bulk.
+// Arguments:
+// - string : a string to write to the console.
+// Return Value:
+// - True.
+bool InteractDispatch::WritePassThroughString(const std::wstring_view string)
+{
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    FlushPendingKeys();
+    gci.GetActiveInputBuffer()->WritePassThroughString(string);
+    return true;
+}
+
 //Method Description:
 // Window Manipulation - Performs a variety of actions relating to the window,
 //      such as moving the window position, resizing the window, querying
@@ -240,6 +294,7 @@ bool InteractDispatch::FocusChanged(const bool focused) const
 
         WI_UpdateFlag(gci.Flags, CONSOLE_HAS_FOCUS, shouldActuallyFocus);
         gci.ProcessHandleList.ModifyConsoleProcessFocus(shouldActuallyFocus);
+        FlushPendingKeys();
         gci.pInputBuffer->Write(std::make_unique<FocusEvent>(focused));
     }
     // Does nothing outside of ConPTY. If there's a real HWND, then the HWND is solely in charge.
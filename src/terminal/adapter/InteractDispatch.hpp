@@ -28,6 +28,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inputEvents) override;
         bool WriteCtrlKey(const KeyEvent& event) override;
         bool WriteString(const std::wstring_view string) override;
+        bool WritePassThroughString(const std::wstring_view string) override;
         bool WindowManipulation(const DispatchTypes::WindowManipulationType function,
                                 const VTParameter parameter1,
                                 const VTParameter parameter2) override; // DTTERM_WindowManipulation
@@ -37,7 +38,13 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool FocusChanged(const bool focused) const override;
 
+        void FlushPendingKeys() const;
+
     private:
         ConhostInternalGetSet _api;
+
+        // Plain win32-input-mode key events that haven't been written to the
+        // input buffer yet. See WriteCtrlKey() and FlushPendingKeys().
+        mutable std::vector<INPUT_RECORD> _pendingKeys;
     };
 }
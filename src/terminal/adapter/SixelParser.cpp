@@ -0,0 +1,289 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "SixelParser.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+namespace
+{
+    constexpr uint8_t _percentToByte(const VTInt percent) noexcept
+    {
+        return gsl::narrow_cast<uint8_t>((std::clamp(percent, 0, 100) * 255 + 50) / 100);
+    }
+
+    constexpr til::color _rgbPercent(const VTInt r, const VTInt g, const VTInt b) noexcept
+    {
+        return { _percentToByte(r), _percentToByte(g), _percentToByte(b) };
+    }
+
+    // The default color map of the VT340, in RGB percentages.
+    constexpr std::array<til::color, 16> _defaultColorMap{
+        _rgbPercent(0, 0, 0),
+        _rgbPercent(20, 20, 80),
+        _rgbPercent(80, 13, 13),
+        _rgbPercent(20, 80, 20),
+        _rgbPercent(80, 20, 80),
+        _rgbPercent(20, 80, 80),
+        _rgbPercent(80, 80, 20),
+        _rgbPercent(53, 53, 53),
+        _rgbPercent(26, 26, 26),
+        _rgbPercent(33, 33, 60),
+        _rgbPercent(60, 26, 26),
+        _rgbPercent(33, 60, 33),
+        _rgbPercent(60, 33, 60),
+        _rgbPercent(33, 60, 60),
+        _rgbPercent(60, 60, 33),
+        _rgbPercent(80, 80, 80),
+    };
+
+    til::color _hlsToRgb(const VTInt hue, const VTInt lightness, const VTInt saturation) noexcept
+    {
+        // The DEC HLS model places blue at 0 degrees, red at 120 and green at 240,
+        // which is rotated by 240 degrees compared to the conventional HLS model.
+        const auto h = ((hue + 240) % 360) / 360.0f;
+        const auto l = std::clamp(lightness, 0, 100) / 100.0f;
+        const auto s = std::clamp(saturation, 0, 100) / 100.0f;
+        const auto q = l < 0.5f ? l * (1 + s) : l + s - l * s;
+        const auto p = 2 * l - q;
+        const auto channel = [&](float t) {
+            t = t < 0 ? t + 1 : (t > 1 ? t - 1 : t);
+            const auto v = t < 1 / 6.0f ? p + (q - p) * 6 * t :
+                           t < 1 / 2.0f ? q :
+                           t < 2 / 3.0f ? p + (q - p) * (2 / 3.0f - t) * 6 :
+                                          p;
+            return gsl::narrow_cast<uint8_t>(std::lround(v * 255));
+        };
+        return { channel(h + 1 / 3.0f), channel(h), channel(h - 1 / 3.0f) };
+    }
+}
+
+SixelParser::SixelParser(const til::size maximumSize, const VTInt aspectRatio, const DispatchTypes::SixelBackground backgroundSelect) noexcept :
+    _maximumSize{ maximumSize },
+    _transparentBackground{ backgroundSelect == DispatchTypes::SixelBackground::Transparent }
+{
+    for (size_t i = 0; i < _colorRegisters.size(); ++i)
+    {
+        til::at(_colorRegisters, i) = til::at(_defaultColorMap, i % _defaultColorMap.size());
+    }
+    _foregroundColor = til::at(_colorRegisters, 7);
+    // An opaque background is filled with color register 0. A transparent
+    // background is stored as zero, which doubles as premultiplied alpha.
+    _backgroundColor = _transparentBackground ? til::color{} : til::at(_colorRegisters, 0);
+
+    // The macro parameter of the DCS sequence selects the pixel aspect ratio,
+    // which determines how many pixels tall each sixel bit is drawn.
+    switch (aspectRatio)
+    {
+    case 2:
+        _aspectRatio = 5;
+        break;
+    case 3:
+    case 4:
+        _aspectRatio = 3;
+        break;
+    case 7:
+    case 8:
+    case 9:
+        _aspectRatio = 1;
+        break;
+    default:
+        _aspectRatio = 2;
+        break;
+    }
+}
+
+// Routine Description:
+// - Processes the next character of the sixel data string.
+// Arguments:
+// - ch - the character to process.
+// Return Value:
+// - <none>
+void SixelParser::AddData(const wchar_t ch)
+{
+    if (_state != State::Normal)
+    {
+        if (ch >= L'0' && ch <= L'9')
+        {
+            auto& parameter = til::at(_parameters, std::max<size_t>(_parameterCount, 1) - 1);
+            _parameterCount = std::max<size_t>(_parameterCount, 1);
+            parameter = std::min(parameter * 10 + (ch - L'0'), MAX_PARAMETER_VALUE);
+            return;
+        }
+        if (ch == L';')
+        {
+            _parameterCount = std::max<size_t>(_parameterCount, 1);
+            if (_parameterCount < MAX_PARAMETERS)
+            {
+                til::at(_parameters, _parameterCount++) = 0;
+            }
+            return;
+        }
+        _executeCommand();
+    }
+
+    switch (ch)
+    {
+    case L'!':
+    case L'#':
+    case L'"':
+        _state = ch == L'!' ? State::RepeatIntroducer : (ch == L'#' ? State::ColorIntroducer : State::RasterAttributes);
+        _parameters = {};
+        _parameterCount = 0;
+        break;
+    case L'$':
+        // Graphics carriage return
+        _column = 0;
+        break;
+    case L'-':
+        // Graphics new line
+        _column = 0;
+        _bandTop += 6 * _aspectRatio;
+        break;
+    default:
+        if (ch >= L'?' && ch <= L'~')
+        {
+            _drawSixel(ch - L'?');
+        }
+        break;
+    }
+}
+
+// Routine Description:
+// - Completes the image once the end of the data string has been reached.
+// Return Value:
+// - true if there's anything to display.
+bool SixelParser::Finalize()
+{
+    if (_state != State::Normal)
+    {
+        _executeCommand();
+    }
+    return _width > 0 && _height > 0;
+}
+
+til::size SixelParser::GetSize() const noexcept
+{
+    return { _width, _height };
+}
+
+// Returns the pixels of the given image row, GetSize().width pixels wide.
+std::span<const til::color> SixelParser::GetPixelRow(const til::CoordType y) const noexcept
+{
+    const auto offset = gsl::narrow_cast<size_t>(y) * _maximumSize.width;
+    return std::span{ _pixels }.subspan(offset, gsl::narrow_cast<size_t>(_width));
+}
+
+void SixelParser::_executeCommand() noexcept
+{
+    switch (_state)
+    {
+    case State::RepeatIntroducer:
+        _repeatCount = std::max(_parameters[0], 1);
+        break;
+    case State::ColorIntroducer:
+        _defineColor();
+        break;
+    case State::RasterAttributes:
+        _setRasterAttributes();
+        break;
+    default:
+        break;
+    }
+    _state = State::Normal;
+}
+
+void SixelParser::_defineColor() noexcept
+{
+    const auto& [number, colorSpace, x, y, z] = _parameters;
+    auto& color = til::at(_colorRegisters, gsl::narrow_cast<size_t>(number) % MAX_COLOR_REGISTERS);
+    if (_parameterCount >= MAX_PARAMETERS)
+    {
+        if (colorSpace == 1)
+        {
+            color = _hlsToRgb(x, y, z);
+        }
+        else if (colorSpace == 2)
+        {
+            color = _rgbPercent(x, y, z);
+        }
+    }
+    _foregroundColor = color;
+}
+
+void SixelParser::_setRasterAttributes()
+{
+    // The raster attributes are only applicable before any sixel data has been drawn.
+    if (_sawSixelData)
+    {
+        return;
+    }
+
+    const auto numerator = _parameters[0];
+    const auto denominator = _parameters[1];
+    const auto width = _parameters[2];
+    const auto height = _parameters[3];
+    if (numerator > 0 && denominator > 0)
+    {
+        _aspectRatio = std::clamp((numerator + denominator - 1) / denominator, 1, 10);
+    }
+
+    // With an opaque background the image extent is filled with the background color,
+    // so the declared size becomes the minimum size of the image.
+    if (!_transparentBackground && width > 0 && height > 0)
+    {
+        _width = std::min(width, _maximumSize.width);
+        _height = std::min(height, _maximumSize.height);
+        _growHeight(_height);
+    }
+}
+
+void SixelParser::_drawSixel(const VTInt sixelValue)
+{
+    _sawSixelData = true;
+
+    const auto columnBegin = _column;
+    const auto columnEnd = std::min(_column + _repeatCount, _maximumSize.width);
+    _column += _repeatCount;
+    _repeatCount = 1;
+
+    if (sixelValue == 0 || columnBegin >= columnEnd)
+    {
+        return;
+    }
+
+    for (auto bit = 0; bit < 6; ++bit)
+    {
+        if (((sixelValue >> bit) & 1) == 0)
+        {
+            continue;
+        }
+
+        const auto top = _bandTop + bit * _aspectRatio;
+        const auto bottom = std::min(top + _aspectRatio, _maximumSize.height);
+        if (top >= bottom)
+        {
+            break;
+        }
+
+        _growHeight(bottom);
+        for (auto y = top; y < bottom; ++y)
+        {
+            const auto row = _pixels.begin() + gsl::narrow_cast<size_t>(y) * _maximumSize.width;
+            std::fill(row + columnBegin, row + columnEnd, _foregroundColor);
+        }
+        _width = std::max(_width, columnEnd);
+        _height = std::max(_height, bottom);
+    }
+}
+
+void SixelParser::_growHeight(const til::CoordType height)
+{
+    if (height > _allocatedHeight)
+    {
+        // Grow by at least a full band at a time, which avoids reallocating the pixels for each bit.
+        _allocatedHeight = std::min(std::max(height, _allocatedHeight + 6 * _aspectRatio), _maximumSize.height);
+        _pixels.resize(gsl::narrow_cast<size_t>(_allocatedHeight) * _maximumSize.width, _backgroundColor);
+    }
+}
@@ -0,0 +1,74 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SixelParser.hpp
+
+Abstract:
+- This decodes the data string of a sixel graphic (DCS q) into an RGBA image.
+  The image is measured in "virtual" pixels, relative to the VT340 cell size
+  defined by CellSize, which is how it's stored in the text buffer.
+--*/
+
+#pragma once
+
+#include "DispatchTypes.hpp"
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class SixelParser
+    {
+    public:
+        static constexpr til::size CellSize{ 10, 20 };
+
+        SixelParser(const til::size maximumSize, const VTInt aspectRatio, const DispatchTypes::SixelBackground backgroundSelect) noexcept;
+        void AddData(const wchar_t ch);
+        bool Finalize();
+
+        til::size GetSize() const noexcept;
+        std::span<const til::color> GetPixelRow(const til::CoordType y) const noexcept;
+
+    private:
+        enum class State : uint8_t
+        {
+            Normal,
+            RepeatIntroducer,
+            ColorIntroducer,
+            RasterAttributes
+        };
+
+        static constexpr size_t MAX_PARAMETERS = 5;
+        static constexpr VTInt MAX_PARAMETER_VALUE = 32767;
+        static constexpr size_t MAX_COLOR_REGISTERS = 256;
+
+        void _executeCommand() noexcept;
+        void _defineColor() noexcept;
+        void _setRasterAttributes();
+        void _drawSixel(const VTInt sixelValue);
+        void _growHeight(const til::CoordType height);
+
+        til::size _maximumSize;
+        bool _transparentBackground = false;
+
+        State _state = State::Normal;
+        std::array<VTInt, MAX_PARAMETERS> _parameters{};
+        size_t _parameterCount = 0;
+
+        std::array<til::color, MAX_COLOR_REGISTERS> _colorRegisters;
+        til::color _foregroundColor;
+        til::color _backgroundColor;
+        til::CoordType _aspectRatio = 2;
+        VTInt _repeatCount = 1;
+        bool _sawSixelData = false;
+
+        // The image is stored with a row stride of _maximumSize.width, so that we never need to
+        // relayout it when it grows wider. _width and _height track the area that was drawn to.
+        std::vector<til::color> _pixels;
+        til::CoordType _allocatedHeight = 0;
+        til::CoordType _width = 0;
+        til::CoordType _height = 0;
+        til::CoordType _column = 0;
+        til::CoordType _bandTop = 0;
+    };
+}
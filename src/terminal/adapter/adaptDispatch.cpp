@@ -6,6 +6,7 @@
 #include "adaptDispatch.hpp"
 #include "../../renderer/base/renderer.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
+#include "../../types/inc/PerformanceRegion.hpp"
 #include "../../types/inc/Viewport.hpp"
 #include "../../types/inc/utils.hpp"
 #include "../../inc/unicode.hpp"
@@ -55,15 +56,12 @@ void AdaptDispatch::Print(const wchar_t wchPrintable)
 // - <none>
 void AdaptDispatch::PrintString(const std::wstring_view string)
 {
+    const PerformanceRegion region{ "AdaptDispatch_PrintString" };
+
     if (_termOutput.NeedToTranslate())
     {
-        std::wstring buffer;
-        buffer.reserve(string.size());
-        for (auto& wch : string)
-        {
-            buffer.push_back(_termOutput.TranslateKey(wch));
-        }
-        _WriteToBuffer(buffer);
+        _termOutput.TranslateString(string, _translationBuffer);
+        _WriteToBuffer(_translationBuffer);
     }
     else
     {
@@ -71,6 +69,46 @@ void AdaptDispatch::PrintString(const std::wstring_view string)
     }
 }
 
+// Routine Description:
+// - Prints a batch of lines, each of which is terminated by a CRLF. This is
+//   the same as calling PrintString(), CarriageReturn() and LineFeed() for
+//   each of them, but avoids a round trip through the parser for every line.
+// Arguments:
+// - string - The lines to print, including their CRLFs.
+// Return Value:
+// - <none>
+void AdaptDispatch::PrintLines(const std::wstring_view string)
+{
+    const PerformanceRegion region{ "AdaptDispatch_PrintLines" };
+
+    auto& textBuffer = _api.GetTextBuffer();
+    const auto bufferWidth = textBuffer.GetSize().Width();
+
+    // Without margins a CR followed by a LF is the same as a single line feed
+    // with return. With margins, CarriageReturn() has a few rules about the
+    // cursor's position that _DoLineFeed() doesn't replicate, so we leave it
+    // to the regular code path. Printing text doesn't change the margins.
+    const auto [leftMargin, rightMargin] = _GetHorizontalMargins(bufferWidth);
+    const auto marginsSet = _scrollMargins.top < _scrollMargins.bottom || leftMargin != 0 || rightMargin != bufferWidth - 1;
+
+    for (auto remaining = string; !remaining.empty();)
+    {
+        const auto eol = std::min(remaining.find(L"\r\n"), remaining.size());
+        PrintString(remaining.substr(0, eol));
+        remaining = remaining.substr(std::min(eol + 2, remaining.size()));
+
+        if (marginsSet)
+        {
+            CarriageReturn();
+            LineFeed(DispatchTypes::LineFeedType::DependsOnMode);
+        }
+        else
+        {
+            _DoLineFeed(textBuffer, true, false);
+        }
+    }
+}
+
 void AdaptDispatch::_WriteToBuffer(const std::wstring_view string)
 {
     auto& textBuffer = _api.GetTextBuffer();
@@ -608,8 +646,9 @@ void AdaptDispatch::_ScrollRectVertically(TextBuffer& textBuffer, const til::rec
         {
             // If the scrollRect is the full width of the buffer, we can scroll
             // more efficiently by rotating the row storage.
+            // The renderer can then move the existing rows as well, instead of drawing them again.
             textBuffer.ScrollRows(top, height, actualDelta);
-            textBuffer.TriggerRedraw(Viewport::FromExclusive(scrollRect));
+            textBuffer.TriggerScrollRegion(scrollRect, actualDelta);
         }
         else
         {
@@ -987,26 +1026,49 @@ void AdaptDispatch::_ChangeRectAttributes(TextBuffer& textBuffer, const til::rec
 {
     if (changeRect)
     {
+        // Every run of equal attributes within the rect is changed as a whole and
+        // the resulting runs are then applied to the row all at once.
+        til::small_vector<til::small_rle<TextAttribute, uint16_t, 1>::range_replacement, 16> changes;
+
         for (auto row = changeRect.top; row < changeRect.bottom; row++)
         {
             auto& rowBuffer = textBuffer.GetRowByOffset(row);
-            for (auto col = changeRect.left; col < changeRect.right; col++)
+            til::CoordType runBegin = 0;
+
+            changes.clear();
+
+            for (const auto& run : rowBuffer.Attributes().runs())
             {
-                auto attr = rowBuffer.GetAttrByColumn(col);
-                auto characterAttributes = attr.GetCharacterAttributes();
-                characterAttributes &= changeOps.andAttrMask;
-                characterAttributes ^= changeOps.xorAttrMask;
-                attr.SetCharacterAttributes(characterAttributes);
-                if (changeOps.foreground)
+                const auto runEnd = runBegin + run.length;
+                const auto begin = std::max(runBegin, changeRect.left);
+                const auto end = std::min(runEnd, changeRect.right);
+
+                if (begin < end)
                 {
-                    attr.SetForeground(*changeOps.foreground);
+                    auto attr = run.value;
+                    auto characterAttributes = attr.GetCharacterAttributes();
+                    characterAttributes &= changeOps.andAttrMask;
+                    characterAttributes ^= changeOps.xorAttrMask;
+                    attr.SetCharacterAttributes(characterAttributes);
+                    if (changeOps.foreground)
+                    {
+                        attr.SetForeground(*changeOps.foreground);
+                    }
+                    if (changeOps.background)
+                    {
+                        attr.SetBackground(*changeOps.background);
+                    }
+                    changes.push_back({ gsl::narrow_cast<uint16_t>(begin), gsl::narrow_cast<uint16_t>(end), attr });
                 }
-                if (changeOps.background)
+
+                runBegin = runEnd;
+                if (runBegin >= changeRect.right)
                 {
-                    attr.SetBackground(*changeOps.background);
+                    break;
                 }
-                rowBuffer.ReplaceAttributes(col, col + 1, attr);
             }
+
+            rowBuffer.ReplaceAttributes({ changes.data(), changes.size() });
         }
         textBuffer.TriggerRedraw(Viewport::FromExclusive(changeRect));
         _api.NotifyAccessibilityChange(changeRect);
@@ -1373,45 +1435,33 @@ bool AdaptDispatch::RequestChecksumRectangularArea(const VTInt id, const VTInt p
 
             const auto& textBuffer = _api.GetTextBuffer();
             const auto eraseRect = _CalculateRectArea(top, left, bottom, right, textBuffer.GetSize().Dimensions());
+            if (_checksumCache.size() < gsl::narrow_cast<size_t>(eraseRect.bottom))
+            {
+                _checksumCache.resize(gsl::narrow_cast<size_t>(eraseRect.bottom));
+            }
             for (auto row = eraseRect.top; row < eraseRect.bottom; row++)
             {
-                for (auto col = eraseRect.left; col < eraseRect.right; col++)
+                // Test scripts tend to poll the checksum of the whole page after every
+                // step, while only touching a few rows in between. Since ROW generations
+                // change whenever a ROW is modified, we can reuse the sums of all others.
+                const auto& r = textBuffer.GetRowByOffset(row);
+                auto& cached = til::at(_checksumCache, row);
+                if (cached.generation != r.GetGeneration() ||
+                    cached.left != eraseRect.left ||
+                    cached.right != eraseRect.right ||
+                    cached.defaultFgIndex != defaultFgIndex ||
+                    cached.defaultBgIndex != defaultBgIndex)
                 {
-                    // The algorithm we're using here should match the DEC terminals
-                    // for the ASCII and Latin-1 range. Their other character sets
-                    // predate Unicode, though, so we'd need a custom mapping table
-                    // to lookup the correct checksums. Considering this is only for
-                    // testing at the moment, that doesn't seem worth the effort.
-                    const auto cell = textBuffer.GetCellDataAt({ col, row });
-                    for (auto ch : cell->Chars())
-                    {
-                        // That said, I've made a special allowance for U+2426,
-                        // since that is widely used in a lot of character sets.
-                        checksum -= (ch == L'\u2426' ? 0x1B : ch);
-                    }
-
-                    // Since we're attempting to match the DEC checksum algorithm,
-                    // the only attributes affecting the checksum are the ones that
-                    // were supported by DEC terminals.
-                    const auto attr = cell->TextAttr();
-                    checksum -= attr.IsProtected() ? 0x04 : 0;
-                    checksum -= attr.IsInvisible() ? 0x08 : 0;
-                    checksum -= attr.IsUnderlined() ? 0x10 : 0;
-                    checksum -= attr.IsReverseVideo() ? 0x20 : 0;
-                    checksum -= attr.IsBlinking() ? 0x40 : 0;
-                    checksum -= attr.IsIntense() ? 0x80 : 0;
-
-                    // For the same reason, we only care about the eight basic ANSI
-                    // colors, although technically we also report the 8-16 index
-                    // range. Everything else gets mapped to the default colors.
-                    const auto colorIndex = [](const auto color, const auto defaultIndex) {
-                        return color.IsLegacy() ? color.GetIndex() : defaultIndex;
+                    cached = {
+                        .generation = r.GetGeneration(),
+                        .left = eraseRect.left,
+                        .right = eraseRect.right,
+                        .defaultFgIndex = defaultFgIndex,
+                        .defaultBgIndex = defaultBgIndex,
+                        .checksum = _ChecksumRow(r, eraseRect.left, eraseRect.right, defaultFgIndex, defaultBgIndex),
                     };
-                    const auto fgIndex = colorIndex(attr.GetForeground(), defaultFgIndex);
-                    const auto bgIndex = colorIndex(attr.GetBackground(), defaultBgIndex);
-                    checksum -= gsl::narrow_cast<uint16_t>(fgIndex << 4);
-                    checksum -= gsl::narrow_cast<uint16_t>(bgIndex);
                 }
+                checksum += cached.checksum;
             }
         }
     }
@@ -1420,6 +1470,78 @@ bool AdaptDispatch::RequestChecksumRectangularArea(const VTInt id, const VTInt p
     return true;
 }
 
+// Routine Description:
+// - Calculates the DECRQCRA checksum of the given range of columns in a row.
+//   The checksums of consecutive rows can simply be added up.
+// Arguments:
+// - row - The row to calculate the checksum for.
+// - left - The first column of the range.
+// - right - The column 1 past the end of the range.
+// - defaultFgIndex - The color index reported for the default foreground.
+// - defaultBgIndex - The color index reported for the default background.
+// Return Value:
+// - The checksum of the range.
+uint16_t AdaptDispatch::_ChecksumRow(const ROW& row, const til::CoordType left, const til::CoordType right, const size_t defaultFgIndex, const size_t defaultBgIndex) noexcept
+{
+    uint16_t checksum = 0;
+
+    for (auto col = left; col < right; col++)
+    {
+        // The algorithm we're using here should match the DEC terminals
+        // for the ASCII and Latin-1 range. Their other character sets
+        // predate Unicode, though, so we'd need a custom mapping table
+        // to lookup the correct checksums. Considering this is only for
+        // testing at the moment, that doesn't seem worth the effort.
+        for (auto ch : row.GlyphAt(col))
+        {
+            // That said, I've made a special allowance for U+2426,
+            // since that is widely used in a lot of character sets.
+            checksum -= (ch == L'\u2426' ? 0x1B : ch);
+        }
+    }
+
+    // The attributes are the same for each cell of a run,
+    // so we only need to calculate their sum once per run.
+    til::CoordType runBegin = 0;
+    for (const auto& run : row.Attributes().runs())
+    {
+        const auto runEnd = runBegin + run.length;
+        const auto count = std::min(runEnd, right) - std::max(runBegin, left);
+        runBegin = runEnd;
+        if (count <= 0)
+        {
+            continue;
+        }
+
+        // Since we're attempting to match the DEC checksum algorithm,
+        // the only attributes affecting the checksum are the ones that
+        // were supported by DEC terminals.
+        const auto& attr = run.value;
+        uint16_t cellChecksum = 0;
+        cellChecksum -= attr.IsProtected() ? 0x04 : 0;
+        cellChecksum -= attr.IsInvisible() ? 0x08 : 0;
+        cellChecksum -= attr.IsUnderlined() ? 0x10 : 0;
+        cellChecksum -= attr.IsReverseVideo() ? 0x20 : 0;
+        cellChecksum -= attr.IsBlinking() ? 0x40 : 0;
+        cellChecksum -= attr.IsIntense() ? 0x80 : 0;
+
+        // For the same reason, we only care about the eight basic ANSI
+        // colors, although technically we also report the 8-16 index
+        // range. Everything else gets mapped to the default colors.
+        const auto colorIndex = [](const auto color, const auto defaultIndex) {
+            return color.IsLegacy() ? color.GetIndex() : defaultIndex;
+        };
+        const auto fgIndex = colorIndex(attr.GetForeground(), defaultFgIndex);
+        const auto bgIndex = colorIndex(attr.GetBackground(), defaultBgIndex);
+        cellChecksum -= gsl::narrow_cast<uint16_t>(fgIndex << 4);
+        cellChecksum -= gsl::narrow_cast<uint16_t>(bgIndex);
+
+        checksum += gsl::narrow_cast<uint16_t>(cellChecksum * count);
+    }
+
+    return checksum;
+}
+
 // Routine Description:
 // - DECSWL/DECDWL/DECDHL - Sets the line rendition attribute for the current line.
 // Arguments:
@@ -1895,6 +2017,12 @@ bool AdaptDispatch::_ModeParamsHelper(const DispatchTypes::ModeParams param, con
     case DispatchTypes::ModeParams::XTERM_BracketedPasteMode:
         _api.SetSystemMode(ITerminalApi::Mode::BracketedPaste, enable);
         return !_api.IsConsolePty();
+    case DispatchTypes::ModeParams::SO_SynchronizedOutput:
+        // In ConPTY this holds off the VtEngine, which in turn means that
+        // the terminal receives each update in one piece. There's no need
+        // to pass the mode through as well.
+        _renderer.SetSynchronizedOutput(enable);
+        return true;
     case DispatchTypes::ModeParams::W32IM_Win32InputMode:
         _terminalInput.SetInputMode(TerminalInput::Mode::Win32, enable);
         return !_PassThroughInputModes();
@@ -2027,6 +2155,9 @@ bool AdaptDispatch::RequestMode(const DispatchTypes::ModeParams param)
     case DispatchTypes::ModeParams::XTERM_BracketedPasteMode:
         enabled = _api.GetSystemMode(ITerminalApi::Mode::BracketedPaste);
         break;
+    case DispatchTypes::ModeParams::SO_SynchronizedOutput:
+        enabled = _renderer.IsSynchronizingOutput();
+        break;
     case DispatchTypes::ModeParams::W32IM_Win32InputMode:
         enabled = _terminalInput.GetInputMode(TerminalInput::Mode::Win32);
         break;
@@ -3046,6 +3177,9 @@ bool AdaptDispatch::HardReset()
     // Reset bracketed paste mode
     _api.SetSystemMode(ITerminalApi::Mode::BracketedPaste, false);
 
+    // End any synchronized update that's still in progress.
+    _renderer.SetSynchronizedOutput(false);
+
     // Restore cursor blinking mode.
     _api.GetTextBuffer().GetCursor().SetBlinkingAllowed(true);
 
@@ -3808,6 +3942,123 @@ ITermDispatch::StringHandler AdaptDispatch::DownloadDRCS(const VTInt fontNumber,
     };
 }
 
+// Routine Description:
+// - SIXEL - Defines a sixel graphic, which is drawn into the buffer at the
+//   cursor position. The image is decoded as the data string arrives, and
+//   once complete it's split into per-row slices that are stored in the rows
+//   it covers, so it then scrolls together with the text. The cursor ends up
+//   on the last row covered by the image, at the column the image started in.
+// Arguments:
+// - macroParameter - Selects the pixel aspect ratio.
+// - backgroundSelect - Whether unset pixels are transparent or opaque.
+// - backgroundColor - The horizontal grid size (ignored).
+// Return Value:
+// - a function to receive the data or nullptr if the image can't be drawn.
+ITermDispatch::StringHandler AdaptDispatch::DefineSixelImage(const VTInt macroParameter,
+                                                             const DispatchTypes::SixelBackground backgroundSelect,
+                                                             const VTParameter /*backgroundColor*/)
+{
+    const auto& textBuffer = _api.GetTextBuffer();
+    const auto viewport = _api.GetViewport();
+    const auto cursorPosition = textBuffer.GetCursor().GetPosition();
+    const auto cellSize = SixelParser::CellSize;
+
+    // The image is clipped to the right edge of the buffer and the height of the viewport,
+    // which also limits the amount of memory an application can make us allocate.
+    const til::size maximumSize{
+        (textBuffer.GetLineWidth(cursorPosition.y) - cursorPosition.x) * cellSize.width,
+        viewport.height() * cellSize.height,
+    };
+    if (maximumSize.width <= 0 || maximumSize.height <= 0)
+    {
+        return nullptr;
+    }
+
+    _sixelParser = std::make_unique<SixelParser>(maximumSize, macroParameter, backgroundSelect);
+
+    // If we're a conpty, we forward the image to the connected terminal, but we
+    // still decode it locally, so that our cursor position remains in sync.
+    const auto conptyPassthrough = _api.IsConsolePty() ? _CreatePassthroughHandler() : nullptr;
+
+    return [=](const auto ch) {
+        if (conptyPassthrough)
+        {
+            conptyPassthrough(ch);
+        }
+        if (ch != AsciiChars::ESC)
+        {
+            _sixelParser->AddData(ch);
+        }
+        else
+        {
+            if (_sixelParser->Finalize())
+            {
+                _DrawSixelImage(*_sixelParser);
+            }
+            _sixelParser.reset();
+        }
+        return true;
+    };
+}
+
+// Routine Description:
+// - Splits a decoded sixel image into per-row slices, and stores them in the
+//   rows starting at the cursor position. Rows are added with line feeds as
+//   needed, which scrolls the viewport if the image extends past the bottom.
+// Arguments:
+// - parser - The parser holding the decoded image.
+// Return Value:
+// - <none>
+void AdaptDispatch::_DrawSixelImage(const SixelParser& parser)
+{
+    auto& textBuffer = _api.GetTextBuffer();
+    auto& cursor = textBuffer.GetCursor();
+    const auto cellSize = SixelParser::CellSize;
+    const auto imageSize = parser.GetSize();
+    const auto columnBegin = cursor.GetPosition().x;
+    const auto columnEnd = columnBegin + (imageSize.width + cellSize.width - 1) / cellSize.width;
+    const auto rowCount = (imageSize.height + cellSize.height - 1) / cellSize.height;
+
+    cursor.ResetDelayEOLWrap();
+
+    for (til::CoordType i = 0; i < rowCount; ++i)
+    {
+        if (i != 0)
+        {
+            _DoLineFeed(textBuffer, false, false);
+        }
+
+        const auto y = cursor.GetPosition().y;
+        auto& row = textBuffer.GetRowByOffset(y);
+        if (!row.GetImageSlice())
+        {
+            row.SetImageSlice(std::make_unique<ImageSlice>(cellSize));
+        }
+
+        auto& slice = *row.GetMutableImageSlice();
+        const auto pixels = slice.MutablePixels(columnBegin, columnEnd);
+        const auto stride = gsl::narrow_cast<size_t>(slice.PixelWidth());
+        const auto pixelTop = i * cellSize.height;
+        const auto pixelBottom = std::min(pixelTop + cellSize.height, imageSize.height);
+
+        for (auto py = pixelTop; py < pixelBottom; ++py)
+        {
+            auto dst = pixels.begin() + (py - pixelTop) * stride;
+            for (const auto& color : parser.GetPixelRow(py))
+            {
+                // Transparent pixels leave whatever was there before.
+                if (color.a)
+                {
+                    *dst = color;
+                }
+                ++dst;
+            }
+        }
+
+        textBuffer.TriggerRedraw(Viewport::FromExclusive({ columnBegin, y, columnEnd, y + 1 }));
+    }
+}
+
 // Routine Description:
 // - Helper method to create a string handler that can be used to pass through
 //   DECDLD sequences when in conpty mode. This patches the original sequence
@@ -18,6 +18,7 @@ Author(s):
 #include "ITerminalApi.hpp"
 #include "FontBuffer.hpp"
 #include "MacroBuffer.hpp"
+#include "SixelParser.hpp"
 #include "terminalOutput.hpp"
 #include "../input/terminalInput.hpp"
 #include "../../types/inc/sgrStack.hpp"
@@ -39,6 +40,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         void Print(const wchar_t wchPrintable) override;
         void PrintString(const std::wstring_view string) override;
+        void PrintLines(const std::wstring_view string) override;
 
         bool CursorUp(const VTInt distance) override; // CUU
         bool CursorDown(const VTInt distance) override; // CUD
@@ -148,6 +150,10 @@ namespace Microsoft::Console::VirtualTerminal
                                    const VTParameter cellHeight,
                                    const DispatchTypes::DrcsCharsetSize charsetSize) override; // DECDLD
 
+        StringHandler DefineSixelImage(const VTInt macroParameter,
+                                       const DispatchTypes::SixelBackground backgroundSelect,
+                                       const VTParameter backgroundColor) override; // SIXEL
+
         StringHandler DefineMacro(const VTInt macroId,
                                   const DispatchTypes::MacroDeleteControl deleteControl,
                                   const DispatchTypes::MacroEncoding encoding) override; // DECDMAC
@@ -199,6 +205,16 @@ namespace Microsoft::Console::VirtualTerminal
             static constexpr Offset Backward(const VTInt value) { return { -value, false }; };
             static constexpr Offset Unchanged() { return Forward(0); };
         };
+        // The DECRQCRA checksum of a ROW, which is valid as long as its generation doesn't change.
+        struct RowChecksum
+        {
+            uint64_t generation = 0;
+            til::CoordType left = 0;
+            til::CoordType right = 0;
+            size_t defaultFgIndex = 0;
+            size_t defaultBgIndex = 0;
+            uint16_t checksum = 0;
+        };
         struct ChangeOps
         {
             CharacterAttributes andAttrMask = CharacterAttributes::All;
@@ -240,6 +256,7 @@ namespace Microsoft::Console::VirtualTerminal
         void _CursorPositionReport(const bool extendedReport);
         void _MacroSpaceReport() const;
         void _MacroChecksumReport(const VTParameter id) const;
+        static uint16_t _ChecksumRow(const ROW& row, const til::CoordType left, const til::CoordType right, const size_t defaultFgIndex, const size_t defaultBgIndex) noexcept;
 
         void _SetColumnMode(const bool enable);
         void _SetAlternateScreenBufferMode(const bool enable);
@@ -268,6 +285,8 @@ namespace Microsoft::Console::VirtualTerminal
         StringHandler _CreateDrcsPassthroughHandler(const DispatchTypes::DrcsCharsetSize charsetSize);
         StringHandler _CreatePassthroughHandler();
 
+        void _DrawSixelImage(const SixelParser& parser);
+
         std::vector<bool> _tabStopColumns;
         bool _initDefaultTabStops = true;
 
@@ -276,7 +295,12 @@ namespace Microsoft::Console::VirtualTerminal
         RenderSettings& _renderSettings;
         TerminalInput& _terminalInput;
         TerminalOutput _termOutput;
+        // Scratch space for PrintString(), reused to avoid an allocation per call.
+        std::wstring _translationBuffer;
+        // Indexed by buffer row. See RequestChecksumRectangularArea().
+        std::vector<RowChecksum> _checksumCache;
         std::unique_ptr<FontBuffer> _fontBuffer;
+        std::unique_ptr<SixelParser> _sixelParser;
         std::shared_ptr<MacroBuffer> _macroBuffer;
         std::optional<unsigned int> _initialCodePage;
 
@@ -24,6 +24,18 @@ class Microsoft::Console::VirtualTerminal::TermDispatch : public Microsoft::Cons
 public:
     void Print(const wchar_t wchPrintable) override = 0;
     void PrintString(const std::wstring_view string) override = 0;
+    void PrintLines(const std::wstring_view string) override
+    {
+        // Each of the lines ends with a CRLF.
+        for (auto remaining = string; !remaining.empty();)
+        {
+            const auto eol = std::min(remaining.find(L"\r\n"), remaining.size());
+            PrintString(remaining.substr(0, eol));
+            CarriageReturn();
+            LineFeed(DispatchTypes::LineFeedType::DependsOnMode);
+            remaining = remaining.substr(std::min(eol + 2, remaining.size()));
+        }
+    }
 
     bool CursorUp(const VTInt /*distance*/) override { return false; } // CUU
     bool CursorDown(const VTInt /*distance*/) override { return false; } // CUD
@@ -139,6 +151,10 @@ public:
                                const VTParameter /*cellHeight*/,
                                const DispatchTypes::DrcsCharsetSize /*charsetSize*/) override { return nullptr; } // DECDLD
 
+    StringHandler DefineSixelImage(const VTInt /*macroParameter*/,
+                                   const DispatchTypes::SixelBackground /*backgroundSelect*/,
+                                   const VTParameter /*backgroundColor*/) override { return nullptr; } // SIXEL
+
     StringHandler DefineMacro(const VTInt /*macroId*/,
                               const DispatchTypes::MacroDeleteControl /*deleteControl*/,
                               const DispatchTypes::MacroEncoding /*encoding*/) override { return nullptr; } // DECDMAC
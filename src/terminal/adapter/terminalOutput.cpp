@@ -167,6 +167,50 @@ wchar_t TerminalOutput::TranslateKey(const wchar_t wch) const noexcept
     return wchFound;
 }
 
+// Routine Description:
+// - Translates an entire string, like calling TranslateKey() for each character.
+// Arguments:
+// - string - The characters to translate.
+// - buffer - Receives the translated characters. Its capacity is reused
+//   across calls, so that printing doesn't need to allocate every time.
+// Return Value:
+// - <none>
+void TerminalOutput::TranslateString(const std::wstring_view string, std::wstring& buffer) const
+{
+    buffer.resize(string.size());
+
+    auto in = string.begin();
+    auto out = buffer.begin();
+    const auto end = string.end();
+
+    // A single shift only ever applies to the first character.
+    if (_ssSetNumber != 0 && in != end)
+    {
+        *out++ = TranslateKey(*in++);
+    }
+
+    // With the single shift out of the way, this is a plain table lookup
+    // and we can avoid going through TranslateKey()'s branches each time.
+    const auto gl = _glTranslationTable;
+    const auto gr = _grTranslationTable;
+    for (; in != end; ++in, ++out)
+    {
+        const auto wch = *in;
+        if (wch - 0x20u < gl.size())
+        {
+            *out = til::at(gl, wch - 0x20u);
+        }
+        else if (wch - 0xA0u < gr.size())
+        {
+            *out = til::at(gr, wch - 0xA0u);
+        }
+        else
+        {
+            *out = wch;
+        }
+    }
+}
+
 const std::wstring_view TerminalOutput::_LookupTranslationTable94(const VTID charset) const
 {
     // Note that the DRCS set can be designated with either a 94 or 96 sequence,
@@ -612,6 +612,42 @@ public:
         }
     }
 
+    TEST_METHOD(MotionCoalescingTests)
+    {
+        Log::Comment(L"Starting test...");
+        auto mouseInput = std::make_unique<TerminalInput>(s_MouseInputTestCallback);
+        const short noModifierKeys = 0;
+        const TerminalInput::MouseButtonState noButtons{};
+        const TerminalInput::MouseButtonState leftButton{ true, false, false };
+
+        mouseInput->SetInputMode(TerminalInput::Mode::SgrMouseEncoding, true);
+        mouseInput->SetInputMode(TerminalInput::Mode::AnyEventMouseTracking, true);
+
+        Log::Comment(L"The first hover is reported");
+        s_pwszInputExpected = L"\x1b[<35;2;2m";
+        VERIFY_IS_TRUE(mouseInput->HandleMouse({ 1, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, noButtons));
+
+        Log::Comment(L"Hovers within the same cell aren't");
+        VERIFY_IS_FALSE(mouseInput->HandleMouse({ 1, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, noButtons));
+
+        Log::Comment(L"Button presses are always reported");
+        s_pwszInputExpected = L"\x1b[<0;2;2M";
+        VERIFY_IS_TRUE(mouseInput->HandleMouse({ 1, 1 }, WM_LBUTTONDOWN, noModifierKeys, 0, leftButton));
+
+        Log::Comment(L"Dragging within the cell that was clicked isn't reported");
+        VERIFY_IS_FALSE(mouseInput->HandleMouse({ 1, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, leftButton));
+
+        Log::Comment(L"Dragging into another cell is");
+        s_pwszInputExpected = L"\x1b[<32;3;2M";
+        VERIFY_IS_TRUE(mouseInput->HandleMouse({ 2, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, leftButton));
+        VERIFY_IS_FALSE(mouseInput->HandleMouse({ 2, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, leftButton));
+
+        Log::Comment(L"Releasing the button is reported, but not the hover in the same cell after it");
+        s_pwszInputExpected = L"\x1b[<0;3;2m";
+        VERIFY_IS_TRUE(mouseInput->HandleMouse({ 2, 1 }, WM_LBUTTONUP, noModifierKeys, 0, noButtons));
+        VERIFY_IS_FALSE(mouseInput->HandleMouse({ 2, 1 }, WM_MOUSEMOVE, noModifierKeys, 0, noButtons));
+    }
+
     TEST_METHOD(AlternateScrollModeTests)
     {
         Log::Comment(L"Starting test...");
@@ -1795,7 +1795,7 @@ public:
         // and DECRQM would not then be applicable.
 
         BEGIN_TEST_METHOD_PROPERTIES()
-            TEST_METHOD_PROPERTY(L"Data:modeNumber", L"{1, 3, 5, 6, 7, 8, 12, 25, 40, 66, 67, 69, 117, 1000, 1002, 1003, 1004, 1005, 1006, 1007, 1049, 2004, 9001}")
+            TEST_METHOD_PROPERTY(L"Data:modeNumber", L"{1, 3, 5, 6, 7, 8, 12, 25, 40, 66, 67, 69, 117, 1000, 1002, 1003, 1004, 1005, 1006, 1007, 1049, 2004, 2026, 9001}")
         END_TEST_METHOD_PROPERTIES()
 
         VTInt modeNumber;
@@ -2709,6 +2709,48 @@ public:
         VERIFY_IS_TRUE(decdld(CellMatrix::Default, 0, FontSet::Size132x24, FontUsage::FullCell, bitmapOf6x18));
     }
 
+    TEST_METHOD(SixelImages)
+    {
+        _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
+        auto& textBuffer = *_testGetSet->_textBuffer;
+        const auto top = _testGetSet->_viewport.top;
+        const auto cellSize = SixelParser::CellSize;
+
+        Log::Comment(L"A red image that is 2 cells wide and 42 pixels (3 cells) tall");
+        _stateMachine->ProcessString(L"\033P0;1;0q\"1;1;20;42#1;2;100;0;0#1!20~-!20~-!20~-!20~-!20~-!20~-!20~\033\\");
+
+        for (auto y = top; y < top + 3; ++y)
+        {
+            const auto slice = textBuffer.GetRowByOffset(y).GetImageSlice();
+            VERIFY_IS_NOT_NULL(slice);
+            VERIFY_ARE_EQUAL(cellSize, slice->CellSize());
+            VERIFY_ARE_EQUAL(0, slice->ColumnBegin());
+            VERIFY_ARE_EQUAL(2, slice->ColumnEnd());
+            VERIFY_ARE_EQUAL(til::color(255, 0, 0), slice->Pixels().front());
+        }
+        VERIFY_IS_NULL(textBuffer.GetRowByOffset(top + 3).GetImageSlice());
+
+        Log::Comment(L"The last row is partially covered and the rest of it is transparent");
+        const auto lastSlice = textBuffer.GetRowByOffset(top + 2).GetImageSlice();
+        VERIFY_ARE_EQUAL(til::color{}, lastSlice->Pixels()[gsl::narrow_cast<size_t>(2 * cellSize.width * 2)]);
+
+        Log::Comment(L"The cursor ends up on the last row of the image");
+        VERIFY_ARE_EQUAL(til::point(0, top + 2), textBuffer.GetCursor().GetPosition());
+
+        Log::Comment(L"Erasing a line erases the image slice in it");
+        _stateMachine->ProcessString(L"\033[2K");
+        VERIFY_IS_NULL(textBuffer.GetRowByOffset(top + 2).GetImageSlice());
+        VERIFY_IS_NOT_NULL(textBuffer.GetRowByOffset(top + 1).GetImageSlice());
+
+        Log::Comment(L"Erasing part of a line only clears those columns");
+        textBuffer.GetCursor().SetPosition({ 1, top + 1 });
+        _stateMachine->ProcessString(L"\033[K");
+        const auto partialSlice = textBuffer.GetRowByOffset(top + 1).GetImageSlice();
+        VERIFY_IS_NOT_NULL(partialSlice);
+        VERIFY_ARE_EQUAL(til::color(255, 0, 0), partialSlice->Pixels()[0]);
+        VERIFY_ARE_EQUAL(til::color{}, partialSlice->Pixels()[gsl::narrow_cast<size_t>(cellSize.width)]);
+    }
+
     TEST_METHOD(TogglingC1ParserMode)
     {
         _stateMachine->SetParserMode(StateMachine::Mode::AcceptC1, false);
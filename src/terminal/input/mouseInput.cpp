@@ -344,10 +344,6 @@ bool TerminalInput::HandleMouse(const til::point position,
             const auto isHover = _isHoverMsg(button);
             const auto isButton = _isButtonMsg(button);
 
-            const auto sameCoord = (position.x == _mouseInputState.lastPos.x) &&
-                                   (position.y == _mouseInputState.lastPos.y) &&
-                                   (_mouseInputState.lastButton == button);
-
             // If we have a WM_MOUSEMOVE, we need to know if any of the mouse
             //      buttons are actually pressed. If they are,
             //      _GetPressedButton will return the first pressed mouse button.
@@ -355,6 +351,14 @@ bool TerminalInput::HandleMouse(const til::point position,
             //      moved without a button being pressed.
             const auto realButton = isHover ? s_GetPressedButton(state) : button;
 
+            // Motion is only reported once the pointer moves into another cell,
+            // or if the set of pressed buttons changed since the last report.
+            // High polling rate mice generate many events per cell otherwise.
+            // lastButton holds the button state (realButton), not the message.
+            const auto sameCoord = (position.x == _mouseInputState.lastPos.x) &&
+                                   (position.y == _mouseInputState.lastPos.y) &&
+                                   (_mouseInputState.lastButton == realButton);
+
             // In default mode, only button presses/releases are sent
             // In ButtonEvent mode, changing coord hovers WITH A BUTTON PRESSED
             //      (WM_LBUTTONUP is our sentinel that no button was pressed) are also sent.
@@ -367,14 +371,15 @@ bool TerminalInput::HandleMouse(const til::point position,
 
             if (success)
             {
-                std::wstring sequence;
+                auto& sequence = _mouseSequence;
                 if (_inputMode.test(Mode::Utf8MouseEncoding))
                 {
-                    sequence = _GenerateUtf8Sequence(position,
-                                                     realButton,
-                                                     isHover,
-                                                     modifierKeyState,
-                                                     delta);
+                    _GenerateUtf8Sequence(sequence,
+                                          position,
+                                          realButton,
+                                          isHover,
+                                          modifierKeyState,
+                                          delta);
                 }
                 else if (_inputMode.test(Mode::SgrMouseEncoding))
                 {
@@ -382,20 +387,22 @@ bool TerminalInput::HandleMouse(const til::point position,
                     // then we want to handle hovers with WM_MOUSEMOVE.
                     // However, if we're dragging (WM_MOUSEMOVE with a button pressed),
                     //      then use that pressed button instead.
-                    sequence = _GenerateSGRSequence(position,
-                                                    physicalButtonPressed ? realButton : button,
-                                                    _isButtonDown(realButton), // Use realButton here, to properly get the up/down state
-                                                    isHover,
-                                                    modifierKeyState,
-                                                    delta);
+                    _GenerateSGRSequence(sequence,
+                                         position,
+                                         physicalButtonPressed ? realButton : button,
+                                         _isButtonDown(realButton), // Use realButton here, to properly get the up/down state
+                                         isHover,
+                                         modifierKeyState,
+                                         delta);
                 }
                 else
                 {
-                    sequence = _GenerateDefaultSequence(position,
-                                                        realButton,
-                                                        isHover,
-                                                        modifierKeyState,
-                                                        delta);
+                    _GenerateDefaultSequence(sequence,
+                                             position,
+                                             realButton,
+                                             isHover,
+                                             modifierKeyState,
+                                             delta);
                 }
                 success = !sequence.empty();
 
@@ -408,7 +415,7 @@ bool TerminalInput::HandleMouse(const til::point position,
                 {
                     _mouseInputState.lastPos.x = position.x;
                     _mouseInputState.lastPos.y = position.y;
-                    _mouseInputState.lastButton = button;
+                    _mouseInputState.lastButton = realButton;
                 }
             }
         }
@@ -420,19 +427,23 @@ bool TerminalInput::HandleMouse(const til::point position,
 // - Generates a sequence encoding the mouse event according to the default scheme.
 //     see http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-Mouse-Tracking
 // Parameters:
+// - sequence - Receives the generated sequence. Will be empty if we couldn't generate.
 // - position - The windows coordinates (top,left = 0,0) of the mouse event
 // - button - the message to decode.
 // - isHover - true if the sequence is generated in response to a mouse hover
 // - modifierKeyState - the modifier keys pressed with this button
 // - delta - the amount that the scroll wheel changed (should be 0 unless button is a WM_MOUSE*WHEEL)
 // Return value:
-// - The generated sequence. Will be empty if we couldn't generate.
-std::wstring TerminalInput::_GenerateDefaultSequence(const til::point position,
-                                                     const unsigned int button,
-                                                     const bool isHover,
-                                                     const short modifierKeyState,
-                                                     const short delta)
+// - <none>
+void TerminalInput::_GenerateDefaultSequence(std::wstring& sequence,
+                                             const til::point position,
+                                             const unsigned int button,
+                                             const bool isHover,
+                                             const short modifierKeyState,
+                                             const short delta)
 {
+    sequence.clear();
+
     // In the default, non-extended encoding scheme, coordinates above 94 shouldn't be supported,
     //   because (95+32+1)=128, which is not an ASCII character.
     // There are more details in _GenerateUtf8Sequence, but basically, we can't put anything above x80 into the input
@@ -443,33 +454,34 @@ std::wstring TerminalInput::_GenerateDefaultSequence(const til::point position,
         const auto encodedX = _encodeDefaultCoordinate(vtCoords.x);
         const auto encodedY = _encodeDefaultCoordinate(vtCoords.y);
 
-        std::wstring format{ L"\x1b[Mbxy" };
-        til::at(format, 3) = gsl::narrow_cast<wchar_t>(L' ' + _windowsButtonToXEncoding(button, isHover, modifierKeyState, delta));
-        til::at(format, 4) = gsl::narrow_cast<wchar_t>(encodedX);
-        til::at(format, 5) = gsl::narrow_cast<wchar_t>(encodedY);
-        return format;
+        sequence.append(L"\x1b[M");
+        sequence.push_back(gsl::narrow_cast<wchar_t>(L' ' + _windowsButtonToXEncoding(button, isHover, modifierKeyState, delta)));
+        sequence.push_back(gsl::narrow_cast<wchar_t>(encodedX));
+        sequence.push_back(gsl::narrow_cast<wchar_t>(encodedY));
     }
-
-    return {};
 }
 
 // Routine Description:
 // - Generates a sequence encoding the mouse event according to the UTF8 Extended scheme.
 //     see http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-Extended-coordinates
 // Parameters:
+// - sequence - Receives the generated sequence. Will be empty if we couldn't generate.
 // - position - The windows coordinates (top,left = 0,0) of the mouse event
 // - button - the message to decode.
 // - isHover - true if the sequence is generated in response to a mouse hover
 // - modifierKeyState - the modifier keys pressed with this button
 // - delta - the amount that the scroll wheel changed (should be 0 unless button is a WM_MOUSE*WHEEL)
 // Return value:
-// - The generated sequence. Will be empty if we couldn't generate.
-std::wstring TerminalInput::_GenerateUtf8Sequence(const til::point position,
-                                                  const unsigned int button,
-                                                  const bool isHover,
-                                                  const short modifierKeyState,
-                                                  const short delta)
+// - <none>
+void TerminalInput::_GenerateUtf8Sequence(std::wstring& sequence,
+                                          const til::point position,
+                                          const unsigned int button,
+                                          const bool isHover,
+                                          const short modifierKeyState,
+                                          const short delta)
 {
+    sequence.clear();
+
     // So we have some complications here.
     // The windows input stream is typically encoded as UTF16.
     // Bash.exe knows this, and converts the utf16 input, character by character, into utf8, to send to wsl.
@@ -489,46 +501,41 @@ std::wstring TerminalInput::_GenerateUtf8Sequence(const til::point position,
         const auto vtCoords = _winToVTCoord(position);
         const auto encodedX = _encodeDefaultCoordinate(vtCoords.x);
         const auto encodedY = _encodeDefaultCoordinate(vtCoords.y);
-        std::wstring format{ L"\x1b[Mbxy" };
+        sequence.append(L"\x1b[M");
         // The short cast is safe because we know s_WindowsButtonToXEncoding  never returns more than xff
-        til::at(format, 3) = gsl::narrow_cast<wchar_t>(L' ' + _windowsButtonToXEncoding(button, isHover, modifierKeyState, delta));
-        til::at(format, 4) = gsl::narrow_cast<wchar_t>(encodedX);
-        til::at(format, 5) = gsl::narrow_cast<wchar_t>(encodedY);
-        return format;
+        sequence.push_back(gsl::narrow_cast<wchar_t>(L' ' + _windowsButtonToXEncoding(button, isHover, modifierKeyState, delta)));
+        sequence.push_back(gsl::narrow_cast<wchar_t>(encodedX));
+        sequence.push_back(gsl::narrow_cast<wchar_t>(encodedY));
     }
-
-    return {};
 }
 
 // Routine Description:
 // - Generates a sequence encoding the mouse event according to the SGR Extended scheme.
 //     see http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-Extended-coordinates
 // Parameters:
+// - sequence - Receives the generated sequence.
 // - position - The windows coordinates (top,left = 0,0) of the mouse event
 // - button - the message to decode. WM_MOUSEMOVE is used for mouse hovers with no buttons pressed.
 // - isDown - true if a mouse button was pressed.
 // - isHover - true if the sequence is generated in response to a mouse hover
 // - modifierKeyState - the modifier keys pressed with this button
 // - delta - the amount that the scroll wheel changed (should be 0 unless button is a WM_MOUSE*WHEEL)
-// - ppwchSequence - On success, where to put the pointer to the generated sequence
-// - pcchLength - On success, where to put the length of the generated sequence
 // Return value:
-// - true if we were able to successfully generate a sequence.
-// On success, caller is responsible for delete[]ing *ppwchSequence.
-std::wstring TerminalInput::_GenerateSGRSequence(const til::point position,
-                                                 const unsigned int button,
-                                                 const bool isDown,
-                                                 const bool isHover,
-                                                 const short modifierKeyState,
-                                                 const short delta)
+// - <none>
+void TerminalInput::_GenerateSGRSequence(std::wstring& sequence,
+                                         const til::point position,
+                                         const unsigned int button,
+                                         const bool isDown,
+                                         const bool isHover,
+                                         const short modifierKeyState,
+                                         const short delta)
 {
     // Format for SGR events is:
     // "\x1b[<%d;%d;%d;%c", xButton, x+1, y+1, fButtonDown? 'M' : 'm'
     const auto xbutton = _windowsButtonToSGREncoding(button, isHover, modifierKeyState, delta);
 
-    auto format = wil::str_printf<std::wstring>(L"\x1b[<%d;%d;%d%c", xbutton, position.x + 1, position.y + 1, isDown ? L'M' : L'm');
-
-    return format;
+    sequence.clear();
+    fmt::format_to(std::back_inserter(sequence), FMT_COMPILE(L"\x1b[<{};{};{}{}"), xbutton, position.x + 1, position.y + 1, isDown ? L'M' : L'm');
 }
 
 // Routine Description:
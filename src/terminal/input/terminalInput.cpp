@@ -278,205 +278,225 @@ void TerminalInput::ForceDisableWin32InputMode(const bool win32InputMode) noexce
     _forceDisableWin32InputMode = win32InputMode;
 }
 
-static const std::span<const TermKeyMap> _getKeyMapping(const KeyEvent& keyEvent,
-                                                        const bool ansiMode,
-                                                        const bool cursorApplicationMode,
-                                                        const bool keypadApplicationMode) noexcept
-{
-    if (ansiMode)
-    {
-        if (keyEvent.IsCursorKey())
+// The key mapping tables above are the source of truth, but searching them for every key
+// event is needlessly slow. Instead, they're compiled into the directly indexed lookup
+// tables below. Every distinct key in them is assigned a "slot" (0 being "none"), which
+// indexes into tables of pre-encoded sequences, so that translating a key is a single lookup.
+static constexpr auto s_keySlots = [] {
+    std::array<uint8_t, 256> slots{};
+    uint8_t next = 1;
+    const auto add = [&](const std::span<const TermKeyMap> mapping) {
+        for (const auto& map : mapping)
         {
-            if (cursorApplicationMode)
+            auto& slot = slots.at(map.vkey);
+            if (!slot)
             {
-                return { s_cursorKeysApplicationMapping.data(), s_cursorKeysApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_cursorKeysNormalMapping.data(), s_cursorKeysNormalMapping.size() };
+                slot = next++;
             }
         }
-        else
+    };
+    add(s_cursorKeysNormalMapping);
+    add(s_cursorKeysApplicationMapping);
+    add(s_cursorKeysVt52Mapping);
+    add(s_keypadNumericMapping);
+    add(s_keypadApplicationMapping);
+    add(s_keypadVt52Mapping);
+    add(s_modifierKeyMapping);
+    add(s_simpleModifiedKeyMapping);
+    return slots;
+}();
+
+static constexpr size_t s_keySlotCount = *std::max_element(s_keySlots.begin(), s_keySlots.end()) + 1u;
+
+static constexpr size_t _keySlot(const KeyEvent& keyEvent) noexcept
+{
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    return vkey < s_keySlots.size() ? til::at(s_keySlots, vkey) : 0;
+}
+
+// Returns an index for the combination of key mapping modes, used for s_unmodifiedSequences.
+static constexpr size_t _modeIndex(const bool ansiMode, const bool cursorApplicationMode, const bool keypadApplicationMode) noexcept
+{
+    return (ansiMode ? 4 : 0) | (cursorApplicationMode ? 2 : 0) | (keypadApplicationMode ? 1 : 0);
+}
+
+// Returns an index for the combination of modifier keys, used for s_modifiedSequences.
+// It's the same as the modifier parameter of the sequences in s_modifierKeyMapping, minus 1.
+static constexpr size_t _modifierIndex(const bool shift, const bool alt, const bool ctrl) noexcept
+{
+    return (shift ? 1 : 0) | (alt ? 2 : 0) | (ctrl ? 4 : 0);
+}
+
+// The sequences of keys pressed without modifiers, or for which the modifiers didn't
+// matter (see HandleKey), indexed by [_modeIndex][key slot].
+static constexpr auto s_unmodifiedSequences = [] {
+    std::array<std::array<std::wstring_view, s_keySlotCount>, 8> table{};
+    for (auto ansi = 0; ansi < 2; ++ansi)
+    {
+        for (auto cursorApplication = 0; cursorApplication < 2; ++cursorApplication)
         {
-            if (keypadApplicationMode)
+            for (auto keypadApplication = 0; keypadApplication < 2; ++keypadApplication)
             {
-                return { s_keypadApplicationMapping.data(), s_keypadApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_keypadNumericMapping.data(), s_keypadNumericMapping.size() };
+                const std::span<const TermKeyMap> cursorKeys = !ansi            ? std::span<const TermKeyMap>{ s_cursorKeysVt52Mapping } :
+                                                               cursorApplication ? std::span<const TermKeyMap>{ s_cursorKeysApplicationMapping } :
+                                                                                   std::span<const TermKeyMap>{ s_cursorKeysNormalMapping };
+                const std::span<const TermKeyMap> keypadKeys = !ansi            ? std::span<const TermKeyMap>{ s_keypadVt52Mapping } :
+                                                               keypadApplication ? std::span<const TermKeyMap>{ s_keypadApplicationMapping } :
+                                                                                   std::span<const TermKeyMap>{ s_keypadNumericMapping };
+                auto& row = table.at(_modeIndex(ansi, cursorApplication, keypadApplication));
+                for (const auto& map : cursorKeys)
+                {
+                    row.at(s_keySlots.at(map.vkey)) = map.sequence;
+                }
+                for (const auto& map : keypadKeys)
+                {
+                    row.at(s_keySlots.at(map.vkey)) = map.sequence;
+                }
             }
         }
     }
-    else
+    return table;
+}();
+
+// A sequence from s_modifierKeyMapping with the modifier parameter filled in.
+struct EncodedSequence
+{
+    std::array<wchar_t, 8> chars{};
+    size_t length = 0;
+
+    constexpr std::wstring_view view() const noexcept
     {
-        if (keyEvent.IsCursorKey())
-        {
-            return { s_cursorKeysVt52Mapping.data(), s_cursorKeysVt52Mapping.size() };
-        }
-        else
+        return { chars.data(), length };
+    }
+};
+
+// The sequences of keys pressed with modifiers, indexed by [key slot][_modifierIndex].
+// Combinations without a sequence are left empty.
+static constexpr auto s_modifiedSequences = [] {
+    std::array<std::array<EncodedSequence, 8>, s_keySlotCount> table{};
+    const auto encode = [](EncodedSequence& encoded, const std::wstring_view sequence) {
+        std::copy(sequence.begin(), sequence.end(), encoded.chars.begin());
+        encoded.length = sequence.size();
+    };
+
+    for (const auto& map : s_modifierKeyMapping)
+    {
+        auto& row = table.at(s_keySlots.at(map.vkey));
+        for (size_t modifiers = 0; modifiers < row.size(); ++modifiers)
         {
-            return { s_keypadVt52Mapping.data(), s_keypadVt52Mapping.size() };
+            auto& encoded = row.at(modifiers);
+            encode(encoded, map.sequence);
+            encoded.chars.at(encoded.length - 2) = static_cast<wchar_t>(L'1' + modifiers);
         }
     }
-}
 
-// Routine Description:
-// - Searches the keyMapping for a entry corresponding to this key event, and returns it.
-// Arguments:
-// - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// Return Value:
-// - Has value if there was a match to a key translation.
-static std::optional<const TermKeyMap> _searchKeyMapping(const KeyEvent& keyEvent,
-                                                         std::span<const TermKeyMap> keyMapping) noexcept
-{
-    for (auto& map : keyMapping)
+    // s_simpleModifiedKeyMapping only applies to the exact modifier combination it lists.
+    for (const auto& map : s_simpleModifiedKeyMapping)
     {
-        if (map.vkey == keyEvent.GetVirtualKeyCode())
+        auto& encoded = table.at(s_keySlots.at(map.vkey)).at(_modifierIndex(WI_IsFlagSet(map.modifiers, SHIFT_PRESSED),
+                                                                             WI_IsAnyFlagSet(map.modifiers, ALT_PRESSED),
+                                                                             WI_IsAnyFlagSet(map.modifiers, CTRL_PRESSED)));
+        if (!encoded.length)
         {
-            // If the mapping has no modifiers set, then it doesn't really care
-            //      what the modifiers are on the key. The caller will likely do
-            //      something with them.
-            // However, if there are modifiers set, then we only want to match
-            //      if the key's modifiers are the same as the modifiers in the
-            //      mapping.
-            auto modifiersMatch = WI_AreAllFlagsClear(map.modifiers, MOD_PRESSED);
-            if (!modifiersMatch)
-            {
-                // The modifier mapping expects certain modifier keys to be
-                //      pressed. Check those as well.
-                modifiersMatch =
-                    (WI_IsFlagSet(map.modifiers, SHIFT_PRESSED) == keyEvent.IsShiftPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, ALT_PRESSED) == keyEvent.IsAltPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, CTRL_PRESSED) == keyEvent.IsCtrlPressed());
-            }
-
-            if (modifiersMatch)
-            {
-                return map;
-            }
+            encode(encoded, map.sequence);
         }
     }
-    return std::nullopt;
-}
+
+    return table;
+}();
 
 typedef std::function<void(const std::wstring_view)> InputSender;
 
 // Routine Description:
-// - Searches the s_modifierKeyMapping for a entry corresponding to this key event.
-//      Changes the second to last byte to correspond to the currently pressed modifier keys
-//      before sending to the input.
+// - Looks up the sequence for this key event and its modifiers in s_modifiedSequences,
+//      which covers both s_modifierKeyMapping and s_simpleModifiedKeyMapping.
 // Arguments:
 // - keyEvent - Key event to translate
 // - sender - Function to use to dispatch translated event
 // Return Value:
-// - True if there was a match to a key translation, and we successfully modified and sent it to the input
-static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
+// - True if there was a match to a key translation, and we successfully sent it to the input
+static bool _searchWithModifier(const KeyEvent& keyEvent, const InputSender& sender)
 {
     auto success = false;
 
-    const auto match = _searchKeyMapping(keyEvent,
-                                         { s_modifierKeyMapping.data(), s_modifierKeyMapping.size() });
-    if (match)
+    const auto& encoded = til::at(til::at(s_modifiedSequences, _keySlot(keyEvent)),
+                                  _modifierIndex(keyEvent.IsShiftPressed(), keyEvent.IsAltPressed(), keyEvent.IsCtrlPressed()));
+    if (encoded.length)
     {
-        const auto& v = match.value();
-        if (!v.sequence.empty())
-        {
-            std::wstring modified{ v.sequence }; // Make a copy so we can modify it.
-            const auto shift = keyEvent.IsShiftPressed();
-            const auto alt = keyEvent.IsAltPressed();
-            const auto ctrl = keyEvent.IsCtrlPressed();
-            modified.at(modified.size() - 2) = L'1' + (shift ? 1 : 0) + (alt ? 2 : 0) + (ctrl ? 4 : 0);
-            sender(modified);
-            success = true;
-        }
+        sender(encoded.view());
+        success = true;
     }
     else
     {
-        // We didn't find the key in the map of modified keys that need editing,
-        //      maybe it's in the other map of modified keys with sequences that
-        //      don't need editing before sending.
-        const auto match2 = _searchKeyMapping(keyEvent,
-                                              { s_simpleModifiedKeyMapping.data(), s_simpleModifiedKeyMapping.size() });
-        if (match2)
+        // One last check:
+        // * C-/ is supposed to be ^_ (the C0 character US)
+        // * C-? is supposed to be DEL
+        // * C-M-/ is supposed to be ^[^_
+        // * C-M-? is supposed to be ^[^?
+        //
+        // But this whole scenario is tricky. '/' is not the same VKEY on
+        // all keyboards. On USASCII keyboards, '/' and '?' share the _same_
+        // key. So we have to figure out the vkey at runtime, and we have to
+        // determine if the key that was pressed was '?' with some
+        // modifiers, or '/' with some modifiers.
+        //
+        // These translations are not in s_simpleModifiedKeyMapping, because
+        // the aforementioned fact that they aren't the same VKEY on all
+        // keyboards.
+        //
+        // See GH#3079 for details.
+        // Also see https://github.com/microsoft/terminal/pull/4947#issuecomment-600382856
+
+        // VkKeyScan will give us both the Vkey of the key needed for this
+        // character, and the modifiers the user might need to press to get
+        // this character.
+        const auto slashKeyScan = OneCoreSafeVkKeyScanW(L'/'); // On USASCII: 0x00bf
+        const auto questionMarkKeyScan = OneCoreSafeVkKeyScanW(L'?'); //On USASCII: 0x01bf
+
+        const auto slashVkey = LOBYTE(slashKeyScan);
+        const auto questionMarkVkey = LOBYTE(questionMarkKeyScan);
+
+        const auto ctrl = keyEvent.IsCtrlPressed();
+        const auto alt = keyEvent.IsAltPressed();
+        const auto shift = keyEvent.IsShiftPressed();
+
+        // From the KeyEvent we're translating, synthesize the equivalent VkKeyScan result
+        const auto vkey = keyEvent.GetVirtualKeyCode();
+        const short keyScanFromEvent = vkey |
+                                       (shift ? 0x100 : 0) |
+                                       (ctrl ? 0x200 : 0) |
+                                       (alt ? 0x400 : 0);
+
+        // Make sure the VKEY is an _exact_ match, and that the modifier
+        // bits also match. This handles the hypothetical case we get a
+        // keyscan back that's ctrl+alt+some_random_VK, and some_random_VK
+        // has bits that are a superset of the bits set for question mark.
+        const auto wasQuestionMark = vkey == questionMarkVkey && WI_AreAllFlagsSet(keyScanFromEvent, questionMarkKeyScan);
+        const auto wasSlash = vkey == slashVkey && WI_AreAllFlagsSet(keyScanFromEvent, slashKeyScan);
+
+        // If the key pressed was exactly the ? key, then try to send the
+        // appropriate sequence for a modified '?'. Otherwise, check if this
+        // was a modified '/' keypress. These mappings don't need to be
+        // changed at all.
+        if ((ctrl && alt) && wasQuestionMark)
         {
-            // This mapping doesn't need to be changed at all.
-            sender(match2.value().sequence);
+            sender(CTRL_ALT_QUESTIONMARK_SEQUENCE);
             success = true;
         }
-        else
+        else if (ctrl && wasQuestionMark)
         {
-            // One last check:
-            // * C-/ is supposed to be ^_ (the C0 character US)
-            // * C-? is supposed to be DEL
-            // * C-M-/ is supposed to be ^[^_
-            // * C-M-? is supposed to be ^[^?
-            //
-            // But this whole scenario is tricky. '/' is not the same VKEY on
-            // all keyboards. On USASCII keyboards, '/' and '?' share the _same_
-            // key. So we have to figure out the vkey at runtime, and we have to
-            // determine if the key that was pressed was '?' with some
-            // modifiers, or '/' with some modifiers.
-            //
-            // These translations are not in s_simpleModifiedKeyMapping, because
-            // the aforementioned fact that they aren't the same VKEY on all
-            // keyboards.
-            //
-            // See GH#3079 for details.
-            // Also see https://github.com/microsoft/terminal/pull/4947#issuecomment-600382856
-
-            // VkKeyScan will give us both the Vkey of the key needed for this
-            // character, and the modifiers the user might need to press to get
-            // this character.
-            const auto slashKeyScan = OneCoreSafeVkKeyScanW(L'/'); // On USASCII: 0x00bf
-            const auto questionMarkKeyScan = OneCoreSafeVkKeyScanW(L'?'); //On USASCII: 0x01bf
-
-            const auto slashVkey = LOBYTE(slashKeyScan);
-            const auto questionMarkVkey = LOBYTE(questionMarkKeyScan);
-
-            const auto ctrl = keyEvent.IsCtrlPressed();
-            const auto alt = keyEvent.IsAltPressed();
-            const auto shift = keyEvent.IsShiftPressed();
-
-            // From the KeyEvent we're translating, synthesize the equivalent VkKeyScan result
-            const auto vkey = keyEvent.GetVirtualKeyCode();
-            const short keyScanFromEvent = vkey |
-                                           (shift ? 0x100 : 0) |
-                                           (ctrl ? 0x200 : 0) |
-                                           (alt ? 0x400 : 0);
-
-            // Make sure the VKEY is an _exact_ match, and that the modifier
-            // bits also match. This handles the hypothetical case we get a
-            // keyscan back that's ctrl+alt+some_random_VK, and some_random_VK
-            // has bits that are a superset of the bits set for question mark.
-            const auto wasQuestionMark = vkey == questionMarkVkey && WI_AreAllFlagsSet(keyScanFromEvent, questionMarkKeyScan);
-            const auto wasSlash = vkey == slashVkey && WI_AreAllFlagsSet(keyScanFromEvent, slashKeyScan);
-
-            // If the key pressed was exactly the ? key, then try to send the
-            // appropriate sequence for a modified '?'. Otherwise, check if this
-            // was a modified '/' keypress. These mappings don't need to be
-            // changed at all.
-            if ((ctrl && alt) && wasQuestionMark)
-            {
-                sender(CTRL_ALT_QUESTIONMARK_SEQUENCE);
-                success = true;
-            }
-            else if (ctrl && wasQuestionMark)
-            {
-                sender(CTRL_QUESTIONMARK_SEQUENCE);
-                success = true;
-            }
-            else if ((ctrl && alt) && wasSlash)
-            {
-                sender(CTRL_ALT_SLASH_SEQUENCE);
-                success = true;
-            }
-            else if (ctrl && wasSlash)
-            {
-                sender(CTRL_SLASH_SEQUENCE);
-                success = true;
-            }
+            sender(CTRL_QUESTIONMARK_SEQUENCE);
+            success = true;
+        }
+        else if ((ctrl && alt) && wasSlash)
+        {
+            sender(CTRL_ALT_SLASH_SEQUENCE);
+            success = true;
+        }
+        else if (ctrl && wasSlash)
+        {
+            sender(CTRL_SLASH_SEQUENCE);
+            success = true;
         }
     }
 
@@ -484,23 +504,23 @@ static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
 }
 
 // Routine Description:
-// - Searches the input array of mappings, and sends it to the input if a match was found.
+// - Looks up the sequence for this key event in the given mode, and sends it to the input if there is one.
 // Arguments:
 // - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
+// - modeIndex - The current key mapping modes, as returned by _modeIndex
 // - sender - Function to use to dispatch translated event
 // Return Value:
 // - True if there was a match to a key translation, and we successfully sent it to the input
 static bool _translateDefaultMapping(const KeyEvent& keyEvent,
-                                     const std::span<const TermKeyMap> keyMapping,
-                                     InputSender sender)
+                                     const size_t modeIndex,
+                                     const InputSender& sender)
 {
-    const auto match = _searchKeyMapping(keyEvent, keyMapping);
-    if (match)
+    const auto sequence = til::at(til::at(s_unmodifiedSequences, modeIndex), _keySlot(keyEvent));
+    if (!sequence.empty())
     {
-        sender(match->sequence);
+        sender(sequence);
     }
-    return match.has_value();
+    return !sequence.empty();
 }
 
 // Routine Description:
@@ -721,8 +741,8 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     // Check any other key mappings (like those for the F1-F12 keys).
     // These mappings will kick in no matter which modifiers are pressed and as such
     // must be checked last, or otherwise we'd override more complex key combinations.
-    const auto mapping = _getKeyMapping(keyEvent, _inputMode.test(Mode::Ansi), _inputMode.test(Mode::CursorKey), _inputMode.test(Mode::Keypad));
-    if (_translateDefaultMapping(keyEvent, mapping, senderFunc))
+    const auto modeIndex = _modeIndex(_inputMode.test(Mode::Ansi), _inputMode.test(Mode::CursorKey), _inputMode.test(Mode::Keypad));
+    if (_translateDefaultMapping(keyEvent, modeIndex, senderFunc))
     {
         return true;
     }
@@ -117,25 +117,31 @@ namespace Microsoft::Console::VirtualTerminal
         };
 
         MouseInputState _mouseInputState;
+        // The mouse sequences are generated into this buffer, so that
+        // we don't allocate a new string for every single mouse event.
+        std::wstring _mouseSequence;
 #pragma endregion
 
 #pragma region MouseInput
-        static std::wstring _GenerateDefaultSequence(const til::point position,
-                                                     const unsigned int button,
-                                                     const bool isHover,
-                                                     const short modifierKeyState,
-                                                     const short delta);
-        static std::wstring _GenerateUtf8Sequence(const til::point position,
-                                                  const unsigned int button,
-                                                  const bool isHover,
-                                                  const short modifierKeyState,
-                                                  const short delta);
-        static std::wstring _GenerateSGRSequence(const til::point position,
-                                                 const unsigned int button,
-                                                 const bool isDown,
-                                                 const bool isHover,
-                                                 const short modifierKeyState,
-                                                 const short delta);
+        static void _GenerateDefaultSequence(std::wstring& sequence,
+                                             const til::point position,
+                                             const unsigned int button,
+                                             const bool isHover,
+                                             const short modifierKeyState,
+                                             const short delta);
+        static void _GenerateUtf8Sequence(std::wstring& sequence,
+                                          const til::point position,
+                                          const unsigned int button,
+                                          const bool isHover,
+                                          const short modifierKeyState,
+                                          const short delta);
+        static void _GenerateSGRSequence(std::wstring& sequence,
+                                         const til::point position,
+                                         const unsigned int button,
+                                         const bool isDown,
+                                         const bool isHover,
+                                         const short modifierKeyState,
+                                         const short delta);
 
         bool _SendAlternateScroll(const short delta) const noexcept;
 
@@ -32,6 +32,7 @@ namespace Microsoft::Console::VirtualTerminal
         virtual bool ActionExecuteFromEscape(const wchar_t wch) = 0;
         virtual bool ActionPrint(const wchar_t wch) = 0;
         virtual bool ActionPrintString(const std::wstring_view string) = 0;
+        virtual bool ActionPrintLines(const std::wstring_view string) = 0;
 
         virtual bool ActionPassThroughString(const std::wstring_view string) = 0;
 
@@ -263,6 +263,17 @@ bool InputStateMachineEngine::ActionPrintString(const std::wstring_view string)
     return _pDispatch->WriteString(string);
 }
 
+// Method Description:
+// - The StateMachine only batches lines for output, never for input.
+// Arguments:
+// - string - lines to dispatch.
+// Return Value:
+// - false
+bool InputStateMachineEngine::ActionPrintLines(const std::wstring_view /*string*/)
+{
+    return false;
+}
+
 // Method Description:
 // - Triggers the Print action to indicate that the listener should render the
 //      string of characters given.
@@ -274,17 +285,10 @@ bool InputStateMachineEngine::ActionPassThroughString(const std::wstring_view st
 {
     if (_pDispatch->IsVtInputEnabled())
     {
-        // Synthesize string into key events that we'll write to the buffer
-        // similar to TerminalInput::_SendInputSequence
-        if (!string.empty())
-        {
-            std::deque<std::unique_ptr<IInputEvent>> inputEvents;
-            for (const auto& wch : string)
-            {
-                inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
-            }
-            return _pDispatch->WriteInput(inputEvents);
-        }
+        // The string is handed to the input buffer as a whole. Key events are only
+        // synthesized from it (similar to TerminalInput::_SendInputSequence) once
+        // they're actually needed, instead of allocating one per character here.
+        return string.empty() || _pDispatch->WritePassThroughString(string);
     }
     return ActionPrintString(string);
 }
@@ -165,6 +165,24 @@ bool OutputStateMachineEngine::ActionPrintString(const std::wstring_view string)
     return true;
 }
 
+// Routine Description:
+// - Triggers the PrintLines action, which is equivalent to printing each of
+//      the CRLF terminated lines in the given string, and executing its CR
+//      and LF, but without dispatching each of them individually.
+// Arguments:
+// - string - lines to dispatch, each of which ends with a CRLF.
+// Return Value:
+// - true iff we successfully dispatched the sequence.
+bool OutputStateMachineEngine::ActionPrintLines(const std::wstring_view string)
+{
+    _dispatch->PrintLines(string);
+
+    // Executing the final LF would have cleared the last character.
+    _ClearLastChar();
+
+    return true;
+}
+
 // Routine Description:
 // This is called when we have determined that we don't understand a particular
 //      sequence, or the adapter has determined that the string is intended for
@@ -570,8 +588,8 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const VTID id, const VTParamete
         if (_lastPrintedChar != AsciiChars::NUL)
         {
             const size_t repeatCount = parameters.at(0);
-            std::wstring wstr(repeatCount, _lastPrintedChar);
-            _dispatch->PrintString(wstr);
+            _repeatBuffer.assign(repeatCount, _lastPrintedChar);
+            _dispatch->PrintString(_repeatBuffer);
         }
         success = true;
         break;
@@ -683,6 +701,11 @@ IStateMachineEngine::StringHandler OutputStateMachineEngine::ActionDcsDispatch(c
                                           parameters.at(6),
                                           parameters.at(7));
         break;
+    case DcsActionCodes::SIXEL_DefineImage:
+        handler = _dispatch->DefineSixelImage(parameters.at(0),
+                                              parameters.at(1),
+                                              parameters.at(2));
+        break;
     case DcsActionCodes::DECDMAC_DefineMacro:
         handler = _dispatch->DefineMacro(parameters.at(0).value_or(0), parameters.at(1), parameters.at(2));
         break;
@@ -35,6 +35,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool ActionPrint(const wchar_t wch) override;
 
         bool ActionPrintString(const std::wstring_view string) override;
+        bool ActionPrintLines(const std::wstring_view string) override;
 
         bool ActionPassThroughString(const std::wstring_view string) override;
 
@@ -67,6 +68,8 @@ namespace Microsoft::Console::VirtualTerminal
         Microsoft::Console::Render::VtEngine* _pTtyConnection;
         std::function<bool()> _pfnFlushToTerminal;
         wchar_t _lastPrintedChar;
+        // Reused by REP, so that repeating a character doesn't allocate each time.
+        std::wstring _repeatBuffer;
 
         enum EscActionCodes : uint64_t
         {
@@ -172,6 +175,7 @@ namespace Microsoft::Console::VirtualTerminal
         enum DcsActionCodes : uint64_t
         {
             DECDLD_DownloadDRCS = VTID("{"),
+            SIXEL_DefineImage = VTID("q"),
             DECDMAC_DefineMacro = VTID("!z"),
             DECRSTS_RestoreTerminalState = VTID("$p"),
             DECRQSS_RequestSetting = VTID("$q"),
@@ -10,9 +10,12 @@
 #pragma warning(disable : 26447) // The function is declared 'noexcept' but calls function '...' which may throw exceptions (f.6).
 #pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
 #pragma warning(disable : 26482) // Only index into arrays using constant expressions (bounds.2).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
 
 using namespace Microsoft::Console::VirtualTerminal;
 
+extern "C" int __isa_available;
+
 // clang-format off
 static constexpr uint8_t decodeTable[128] = {
     255 /* NUL */, 255 /* SOH */, 255 /* STX */, 255 /* ETX */, 255 /* EOT */, 255 /* ENQ */, 255 /* ACK */, 255 /* BEL */, 255 /* BS  */, 255 /* HT  */, 255 /* LF  */, 255 /* VT  */, 255 /* FF  */, 255 /* CR  */, 255 /* SO  */, 255 /* SI  */,
@@ -85,6 +88,50 @@ HRESULT Base64::Decode(const std::wstring_view& src, std::wstring& dst) noexcept
         r = r << 6 | n;
     };
 
+#if defined(TIL_SSE_INTRINSICS)
+    // OSC 52 payloads can be several MB large, which is why this vectorized loop exists.
+    // It's the SSSE3 decoder by Wojciech Muła and Daniel Lemire: Two pshufb lookups indexed by
+    // the low and high nibble of each character are AND'ed together and produce 0 for valid
+    // characters only. A third lookup indexed by the high nibble yields the offset that
+    // maps the character to its 6-bit value. Finally, pmaddubsw/pmaddwd merge 4x6 bits
+    // into 3 bytes which get shuffled into place.
+    //
+    // It only supports the regular base64 alphabet. As soon as it encounters anything else
+    // (padding, base64url, or invalid input) it leaves the rest to the scalar loops below.
+    if (__isa_available >= __ISA_AVAILABLE_SSE42)
+    {
+        const auto nibbleMask = _mm_set1_epi8(0x0f);
+        const auto slash = _mm_set1_epi8('/');
+        const auto lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const auto lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const auto lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const auto mergeBytes = _mm_set1_epi32(0x01400140);
+        const auto mergeWords = _mm_set1_epi32(0x00011000);
+        const auto pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        // Each iteration consumes 16 characters and stores 16 bytes, only 12 of which are valid.
+        // With at least 24 characters left, there are at least 18 bytes left in result to write to.
+        for (; inEnd - in >= 24; in += 16, out += 12)
+        {
+            // Characters above U+00FF saturate to either 0x00 or 0xff, both of which are invalid.
+            const auto v = _mm_packus_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8)));
+            const auto hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), nibbleMask);
+            const auto loNibbles = _mm_and_si128(v, nibbleMask);
+            if (!_mm_testz_si128(_mm_shuffle_epi8(lutLo, loNibbles), _mm_shuffle_epi8(lutHi, hiNibbles)))
+            {
+                break;
+            }
+
+            // "/" shares its high nibble with "+", but needs a different offset. Subtracting 1
+            // from its index moves it over to the otherwise unused slot 1 in lutRoll.
+            const auto roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(v, slash), hiNibbles));
+            const auto values = _mm_add_epi8(v, roll);
+            const auto merged = _mm_madd_epi16(_mm_maddubs_epi16(values, mergeBytes), mergeWords);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(merged, pack));
+        }
+    }
+#endif
+
     // If src.empty() then `in == inEndBatched == nullptr` and this is skipped.
     while (in < inEndBatched)
     {
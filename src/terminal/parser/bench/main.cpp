@@ -0,0 +1,545 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "../stateMachine.hpp"
+#include "../OutputStateMachineEngine.hpp"
+#include "../../adapter/adaptDispatch.hpp"
+#include "../../../renderer/inc/DummyRenderer.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+// Measures the throughput of the StateMachine, AdaptDispatch and TextBuffer combined.
+// The TextBuffer isn't the active buffer of the renderer, which means that
+// invalidation and painting are intentionally excluded from the results.
+
+static constexpr til::CoordType viewportWidth = 120;
+static constexpr til::CoordType viewportHeight = 30;
+static constexpr til::CoordType scrollbackHeight = 9001;
+// Large enough to scroll through the entire scrollback a few times.
+static constexpr size_t corpusSize = 4 * 1024 * 1024;
+
+// A minimal ITerminalApi that only keeps track of the viewport.
+class BenchmarkApi final : public ITerminalApi
+{
+public:
+    BenchmarkApi(Microsoft::Console::Render::Renderer& renderer) :
+        _textBuffer{ { viewportWidth, scrollbackHeight }, TextAttribute{}, 0, false, renderer }
+    {
+    }
+
+    void ReturnResponse(const std::wstring_view /*response*/) override
+    {
+    }
+
+    StateMachine& GetStateMachine() override
+    {
+        return *_stateMachine;
+    }
+
+    TextBuffer& GetTextBuffer() override
+    {
+        return _textBuffer;
+    }
+
+    til::rect GetViewport() const override
+    {
+        return _viewport;
+    }
+
+    void SetViewportPosition(const til::point position) override
+    {
+        _viewport = { position, _viewport.size() };
+    }
+
+    bool IsVtInputEnabled() const override
+    {
+        return false;
+    }
+
+    void SetTextAttributes(const TextAttribute& attrs) override
+    {
+        _textBuffer.SetCurrentAttributes(attrs);
+    }
+
+    void SetSystemMode(const Mode mode, const bool enabled) override
+    {
+        _systemMode.set(mode, enabled);
+    }
+
+    bool GetSystemMode(const Mode mode) const override
+    {
+        return _systemMode.test(mode);
+    }
+
+    void WarningBell() override
+    {
+    }
+
+    void SetWindowTitle(const std::wstring_view /*title*/) override
+    {
+    }
+
+    void UseAlternateScreenBuffer(const TextAttribute& /*attrs*/) override
+    {
+    }
+
+    void UseMainScreenBuffer() override
+    {
+    }
+
+    CursorType GetUserDefaultCursorStyle() const override
+    {
+        return CursorType::Legacy;
+    }
+
+    void ShowWindow(bool /*showOrHide*/) override
+    {
+    }
+
+    void SetConsoleOutputCP(const unsigned int /*codepage*/) override
+    {
+    }
+
+    unsigned int GetConsoleOutputCP() const override
+    {
+        return CP_UTF8;
+    }
+
+    void CopyToClipboard(const std::wstring_view /*content*/) override
+    {
+    }
+
+    void SetTaskbarProgress(const DispatchTypes::TaskbarState /*state*/, const size_t /*progress*/) override
+    {
+    }
+
+    void SetWorkingDirectory(const std::wstring_view /*uri*/) override
+    {
+    }
+
+    void PlayMidiNote(const int /*noteNumber*/, const int /*velocity*/, const std::chrono::microseconds /*duration*/) override
+    {
+    }
+
+    bool ResizeWindow(const til::CoordType /*width*/, const til::CoordType /*height*/) override
+    {
+        return false;
+    }
+
+    bool IsConsolePty() const override
+    {
+        return false;
+    }
+
+    void NotifyAccessibilityChange(const til::rect& /*changedRect*/) override
+    {
+    }
+
+    void NotifyBufferRotation(const int /*delta*/) override
+    {
+    }
+
+    void MarkPrompt(const DispatchTypes::ScrollMark& /*mark*/) override
+    {
+    }
+
+    void MarkCommandStart() override
+    {
+    }
+
+    void MarkOutputStart() override
+    {
+    }
+
+    void MarkCommandFinish(std::optional<unsigned int> /*error*/) override
+    {
+    }
+
+    StateMachine* _stateMachine = nullptr;
+
+private:
+    TextBuffer _textBuffer;
+    til::rect _viewport{ 0, 0, viewportWidth, viewportHeight };
+    til::enumset<Mode> _systemMode{ Mode::AutoWrap };
+};
+
+// The full stack, created from scratch for each corpus.
+class Harness
+{
+public:
+    Harness() :
+        _api{ _renderer },
+        _terminalInput{ nullptr }
+    {
+        auto dispatch = std::make_unique<AdaptDispatch>(_api, _renderer, _renderer._renderSettings, _terminalInput);
+        auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+        _stateMachine = std::make_unique<StateMachine>(std::move(engine));
+        _api._stateMachine = _stateMachine.get();
+    }
+
+    void Process(const std::string_view input)
+    {
+        _stateMachine->ProcessString(input);
+    }
+
+private:
+    DummyRenderer _renderer;
+    BenchmarkApi _api;
+    TerminalInput _terminalInput;
+    std::unique_ptr<StateMachine> _stateMachine;
+};
+
+struct Corpus
+{
+    std::wstring name;
+    std::string data;
+};
+
+// The corpora are generated, instead of being checked in, so that they're
+// identical on every machine. A fixed seed makes them deterministic.
+class CorpusBuilder
+{
+public:
+    CorpusBuilder() :
+        _rng{ 0x5eed }
+    {
+    }
+
+    uint32_t Random(const uint32_t count)
+    {
+        return _rng() % count;
+    }
+
+    template<typename... Args>
+    void Append(const std::wstring_view format, Args&&... args)
+    {
+        fmt::format_to(std::back_inserter(_text), fmt::runtime(format), std::forward<Args>(args)...);
+    }
+
+    void AppendCodepoint(const uint32_t cp)
+    {
+        if (cp >= 0x10000)
+        {
+            _text.push_back(static_cast<wchar_t>(0xD800 + ((cp - 0x10000) >> 10)));
+            _text.push_back(static_cast<wchar_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+        }
+        else
+        {
+            _text.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+
+    bool Full() const noexcept
+    {
+        // Most of our corpora are ASCII. This is just a rough estimate.
+        return _text.size() >= corpusSize;
+    }
+
+    Corpus Finish(std::wstring name)
+    {
+        return { std::move(name), til::u16u8(_text) };
+    }
+
+private:
+    std::minstd_rand _rng;
+    std::wstring _text;
+};
+
+static constexpr std::array<std::wstring_view, 8> words{
+    L"request", L"worker", L"connection", L"timeout", L"buffer", L"session", L"cache", L"thread"
+};
+
+// Plain log output, like from a build or a server.
+static Corpus BuildAsciiCorpus()
+{
+    CorpusBuilder b;
+    for (uint32_t line = 0; !b.Full(); ++line)
+    {
+        b.Append(L"[{:02}:{:02}:{:02}.{:03}] INFO {}-{}: processed {} {} in {}ms\r\n",
+                 line / 3600 % 24,
+                 line / 60 % 60,
+                 line % 60,
+                 b.Random(1000),
+                 til::at(words, b.Random(8)),
+                 b.Random(16),
+                 til::at(words, b.Random(8)),
+                 b.Random(100000),
+                 b.Random(500));
+    }
+    return b.Finish(L"ascii");
+}
+
+// Short colored runs, like `ls --color` or `git log --graph`.
+static Corpus BuildSgrCorpus()
+{
+    static constexpr std::array<std::wstring_view, 6> colors{
+        L"01;34", L"01;32", L"01;36", L"38;5;208", L"38;2;255;128;0", L"0"
+    };
+
+    CorpusBuilder b;
+    while (!b.Full())
+    {
+        for (auto column = 0; column < 6; ++column)
+        {
+            b.Append(L"\x1b[0m\x1b[{}m{}{}\x1b[0m  ", til::at(colors, b.Random(6)), til::at(words, b.Random(8)), b.Random(1000));
+        }
+        b.Append(L"\r\n");
+    }
+    return b.Finish(L"sgr");
+}
+
+// Full screen redraws with absolute cursor positioning and
+// syntax highlighting, like an editor or another TUI application.
+static Corpus BuildTuiCorpus()
+{
+    CorpusBuilder b;
+    b.Append(L"\x1b[?1049h\x1b[1;{}r", viewportHeight - 1);
+    while (!b.Full())
+    {
+        b.Append(L"\x1b[?25l\x1b[H");
+        for (auto row = 1; row < viewportHeight; ++row)
+        {
+            b.Append(L"\x1b[{};1H\x1b[38;5;243m{:>4} \x1b[38;5;141mif\x1b[39m ({} \x1b[38;5;203m==\x1b[39m {}) {{\x1b[K", row, b.Random(10000), til::at(words, b.Random(8)), b.Random(100));
+        }
+        // A status line and a scroll of the editing area.
+        b.Append(L"\x1b[{};1H\x1b[7m -- INSERT -- {:>20} \x1b[27m\x1b[K", viewportHeight, b.Random(100000));
+        b.Append(L"\x1b[{};1H\x1b[M\x1b[{};1H\x1b[L", b.Random(viewportHeight - 1) + 1, b.Random(viewportHeight - 1) + 1);
+        b.Append(L"\x1b[{};{}H\x1b[?25h", b.Random(viewportHeight - 1) + 1, b.Random(viewportWidth) + 1);
+    }
+    b.Append(L"\x1b[r\x1b[?1049l");
+    return b.Finish(L"tui");
+}
+
+// Wide glyphs, which take a different path through the TextBuffer.
+static Corpus BuildCjkCorpus()
+{
+    CorpusBuilder b;
+    while (!b.Full())
+    {
+        for (auto i = 0; i < 50; ++i)
+        {
+            b.AppendCodepoint(0x4E00 + b.Random(0x5000));
+        }
+        b.Append(L" {} {}\r\n", til::at(words, b.Random(8)), b.Random(1000));
+    }
+    return b.Finish(L"cjk");
+}
+
+// Surrogate pairs, as well as joined and modified emoji.
+static Corpus BuildEmojiCorpus()
+{
+    CorpusBuilder b;
+    while (!b.Full())
+    {
+        for (auto i = 0; i < 20; ++i)
+        {
+            switch (b.Random(4))
+            {
+            case 0:
+                // Skin tone modifier
+                b.AppendCodepoint(0x1F44B);
+                b.AppendCodepoint(0x1F3FB + b.Random(5));
+                break;
+            case 1:
+                // ZWJ sequence
+                b.AppendCodepoint(0x1F468);
+                b.AppendCodepoint(0x200D);
+                b.AppendCodepoint(0x1F4BB);
+                break;
+            default:
+                b.AppendCodepoint(0x1F600 + b.Random(0x50));
+                break;
+            }
+            b.Append(L" ");
+        }
+        b.Append(L"\r\n");
+    }
+    return b.Finish(L"emoji");
+}
+
+// Large OSC 52 clipboard writes, like those of tmux or nvim yanking a big buffer.
+static Corpus BuildClipboardCorpus()
+{
+    static constexpr std::wstring_view alphabet{ L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" };
+
+    CorpusBuilder b;
+    std::string text;
+    while (!b.Full())
+    {
+        text.clear();
+        while (text.size() < 48 * 1024)
+        {
+            fmt::format_to(std::back_inserter(text), "{} {}\n", til::at(words, b.Random(8)), b.Random(100000));
+        }
+        // Truncate to a multiple of 3, so that no padding is needed.
+        text.resize(text.size() / 3 * 3);
+
+        b.Append(L"\x1b]52;c;");
+        for (size_t i = 0; i < text.size(); i += 3)
+        {
+            const auto n = static_cast<uint8_t>(text[i]) << 16 | static_cast<uint8_t>(text[i + 1]) << 8 | static_cast<uint8_t>(text[i + 2]);
+            b.Append(L"{}{}{}{}", alphabet[n >> 18], alphabet[n >> 12 & 63], alphabet[n >> 6 & 63], alphabet[n & 63]);
+        }
+        b.Append(L"\x1b\\");
+    }
+    return b.Finish(L"clipboard");
+}
+
+static std::string ReadFile(const wchar_t* path)
+{
+    const wil::unique_hfile file{ CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    LARGE_INTEGER size{};
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+
+    std::string buffer;
+    buffer.resize(gsl::narrow<size_t>(size.QuadPart));
+
+    DWORD read = 0;
+    THROW_IF_WIN32_BOOL_FALSE(::ReadFile(file.get(), buffer.data(), gsl::narrow<DWORD>(buffer.size()), &read, nullptr));
+    buffer.resize(read);
+    return buffer;
+}
+
+// Returns the median time in ns per byte over the given number of iterations.
+static double Measure(const Corpus& corpus, const int iterations)
+{
+    Harness harness;
+    // Warm up the caches and fill the scrollback, so that all iterations
+    // run in the same steady state of a terminal with a full buffer.
+    harness.Process(corpus.data);
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    for (auto i = 0; i < iterations; ++i)
+    {
+        const auto beg = std::chrono::steady_clock::now();
+        harness.Process(corpus.data);
+        const auto end = std::chrono::steady_clock::now();
+        const auto ns = std::chrono::duration<double, std::nano>(end - beg).count();
+        samples.emplace_back(ns / static_cast<double>(corpus.data.size()));
+    }
+
+    const auto median = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), median, samples.end());
+    return *median;
+}
+
+// The baseline file contains one "<name> <ns per byte>" pair per line.
+static std::unordered_map<std::wstring, double> ReadBaseline(const wchar_t* path)
+{
+    std::unordered_map<std::wstring, double> baseline;
+    std::wifstream file{ path };
+    std::wstring name;
+    double nsPerByte = 0;
+    while (file >> name >> nsPerByte)
+    {
+        baseline.emplace(name, nsPerByte);
+    }
+    return baseline;
+}
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: conterm.parser.benchmark.exe [-iterations <n>] [-baseline <file> [-tolerance <percent>]] [-save <file>] [recording...]\r\n");
+    wprintf(L"Benchmarks the built-in corpora and any given recordings (UTF-8, as written by ParserInstrumentation).\r\n");
+    wprintf(L"Fails if any corpus is slower than its ns/byte in the baseline file by more than the tolerance (default 15%%).\r\n");
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    auto iterations = 5;
+    auto tolerance = 15.0;
+    const wchar_t* baselinePath = nullptr;
+    const wchar_t* savePath = nullptr;
+    std::vector<const wchar_t*> recordings;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == L"-iterations" && hasValue)
+        {
+            iterations = std::max(1, _wtoi(argv[++i]));
+        }
+        else if (arg == L"-baseline" && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (arg == L"-tolerance" && hasValue)
+        {
+            tolerance = _wtof(argv[++i]);
+        }
+        else if (arg == L"-save" && hasValue)
+        {
+            savePath = argv[++i];
+        }
+        else if (!arg.empty() && arg.front() != L'-')
+        {
+            recordings.emplace_back(argv[i]);
+        }
+        else
+        {
+            PrintUsage();
+            return E_INVALIDARG;
+        }
+    }
+
+    std::vector<Corpus> corpora;
+    corpora.emplace_back(BuildAsciiCorpus());
+    corpora.emplace_back(BuildSgrCorpus());
+    corpora.emplace_back(BuildTuiCorpus());
+    corpora.emplace_back(BuildCjkCorpus());
+    corpora.emplace_back(BuildEmojiCorpus());
+    corpora.emplace_back(BuildClipboardCorpus());
+    for (const auto path : recordings)
+    {
+        corpora.emplace_back(Corpus{ std::filesystem::path{ path }.filename().wstring(), ReadFile(path) });
+    }
+
+    const auto baseline = baselinePath ? ReadBaseline(baselinePath) : std::unordered_map<std::wstring, double>{};
+    std::wstring results;
+    auto regressed = false;
+
+    wprintf(L"%-20s %10s %10s %10s\r\n", L"corpus", L"bytes", L"MB/s", L"ns/byte");
+
+    for (const auto& corpus : corpora)
+    {
+        const auto nsPerByte = Measure(corpus, iterations);
+        const auto megabytesPerSecond = 1e9 / nsPerByte / (1024.0 * 1024.0);
+        wprintf(L"%-20s %10zu %10.1f %10.3f", corpus.name.c_str(), corpus.data.size(), megabytesPerSecond, nsPerByte);
+
+        if (const auto it = baseline.find(corpus.name); it != baseline.end())
+        {
+            const auto change = (nsPerByte / it->second - 1.0) * 100.0;
+            wprintf(L" %+7.1f%%", change);
+            if (change > tolerance)
+            {
+                wprintf(L" REGRESSION");
+                regressed = true;
+            }
+        }
+
+        wprintf(L"\r\n");
+        fmt::format_to(std::back_inserter(results), FMT_COMPILE(L"{} {:.3f}\n"), corpus.name, nsPerByte);
+    }
+
+    if (savePath)
+    {
+        std::wofstream file{ savePath };
+        file << results;
+    }
+
+    return regressed ? 1 : 0;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return wil::ResultFromCaughtException();
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "../stateMachine.hpp"
+#include "../OutputStateMachineEngine.hpp"
+#include "../../adapter/termDispatch.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+// Replays a recording made by ParserInstrumentation through the parser, to benchmark it in
+// isolation. The dispatch doesn't do anything, so this measures the parsing overhead only.
+class NullDispatch final : public TermDispatch
+{
+public:
+    void Print(const wchar_t) override
+    {
+    }
+
+    void PrintString(const std::wstring_view) override
+    {
+    }
+};
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: conterm.parser.replay.exe <recording> [iterations]\r\n");
+    wprintf(L"The recording is expected to be UTF-8, as written by ParserInstrumentation::StartRecording().\r\n");
+}
+
+static std::string ReadFile(const wchar_t* path)
+{
+    const wil::unique_hfile file{ CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    LARGE_INTEGER size{};
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+
+    std::string buffer;
+    buffer.resize(gsl::narrow<size_t>(size.QuadPart));
+
+    DWORD read = 0;
+    THROW_IF_WIN32_BOOL_FALSE(::ReadFile(file.get(), buffer.data(), gsl::narrow<DWORD>(buffer.size()), &read, nullptr));
+    buffer.resize(read);
+    return buffer;
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    if (argc < 2 || argc > 3)
+    {
+        PrintUsage();
+        return E_INVALIDARG;
+    }
+
+    const auto iterations = argc == 3 ? std::max(1, _wtoi(argv[2])) : 10;
+    const auto input = ReadFile(argv[1]);
+
+    StateMachine machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>()) };
+
+    // The first pass collects the statistics. The instrumentation
+    // is detached afterwards so that it doesn't skew the timings.
+    machine.SetInstrumentation(std::make_unique<ParserInstrumentation>());
+    machine.ProcessString(std::string_view{ input });
+    wprintf(L"%s\r\n", machine.Instrumentation()->Summarize().c_str());
+    machine.SetInstrumentation(nullptr);
+
+    const auto beg = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i)
+    {
+        machine.ProcessString(std::string_view{ input });
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto seconds = std::chrono::duration<double>(end - beg).count();
+    const auto megabytes = static_cast<double>(input.size()) * iterations / (1024.0 * 1024.0);
+    wprintf(L"%d iterations of %zu bytes in %.3fs: %.1f MB/s\r\n", iterations, input.size(), seconds, megabytes / seconds);
+    return 0;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return wil::ResultFromCaughtException();
+}
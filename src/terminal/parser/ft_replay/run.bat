@@ -0,0 +1 @@
+%_NTTREE%\unittests\conterm.parser.replay.exe %1 %2 %3 %4 %5 %6
\ No newline at end of file
@@ -0,0 +1,203 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "instrumentation.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+// Routine Description:
+// - Starts appending all input to the given file, replacing any existing recording.
+// Arguments:
+// - path - The file to record into. It'll be overwritten if it exists.
+// Return Value:
+// - <none>
+void ParserInstrumentation::StartRecording(const std::wstring_view path)
+{
+    const std::wstring file{ path };
+    wil::unique_hfile handle{ CreateFileW(file.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!handle);
+    _recording = std::move(handle);
+    _recordingState = {};
+}
+
+void ParserInstrumentation::StopRecording() noexcept
+{
+    _recording.reset();
+}
+
+bool ParserInstrumentation::IsRecording() const noexcept
+{
+    return _recording.is_valid();
+}
+
+// Routine Description:
+// - Called by the StateMachine for every string it's given, before parsing it.
+// Arguments:
+// - string - The input string.
+// Return Value:
+// - <none>
+void ParserInstrumentation::OnInput(const std::wstring_view string)
+{
+    _inputLength += string.size();
+
+    if (_recording)
+    {
+        THROW_IF_FAILED(til::u16u8(string, _recordingBuffer, _recordingState));
+
+        DWORD written = 0;
+        if (!WriteFile(_recording.get(), _recordingBuffer.data(), gsl::narrow<DWORD>(_recordingBuffer.size()), &written, nullptr))
+        {
+            // A failing recording shouldn't affect the terminal itself.
+            LOG_LAST_ERROR();
+            _recording.reset();
+        }
+    }
+}
+
+// Routine Description:
+// - Called by the StateMachine after it printed a run of text.
+// Arguments:
+// - length - The length of the printed text.
+// - start - The value of Now() before the text was dispatched.
+// Return Value:
+// - <none>
+void ParserInstrumentation::OnPrint(const size_t length, const int64_t start) noexcept
+{
+    auto& stats = til::at(_classStats, static_cast<size_t>(DispatchClass::Print));
+    stats.count++;
+    stats.ticks += Now() - start;
+    _printedLength += length;
+}
+
+// Routine Description:
+// - Called by the StateMachine after it dispatched a control function.
+// Arguments:
+// - dispatchClass - The kind of control function.
+// - id - The identifier of the control function. See _sequenceStats.
+// - start - The value of Now() before the control function was dispatched.
+// Return Value:
+// - <none>
+void ParserInstrumentation::OnDispatch(const DispatchClass dispatchClass, const uint64_t id, const int64_t start)
+{
+    const auto ticks = Now() - start;
+    const auto index = static_cast<size_t>(dispatchClass);
+
+    auto& classStats = til::at(_classStats, index);
+    classStats.count++;
+    classStats.ticks += ticks;
+
+    auto& sequenceStats = til::at(_sequenceStats, index)[id];
+    sequenceStats.count++;
+    sequenceStats.ticks += ticks;
+}
+
+int64_t ParserInstrumentation::Now() noexcept
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+const ParserInstrumentation::Stats& ParserInstrumentation::GetStats(const DispatchClass dispatchClass) const noexcept
+{
+    return til::at(_classStats, static_cast<size_t>(dispatchClass));
+}
+
+uint64_t ParserInstrumentation::GetInputLength() const noexcept
+{
+    return _inputLength;
+}
+
+uint64_t ParserInstrumentation::GetPrintedLength() const noexcept
+{
+    return _printedLength;
+}
+
+// Routine Description:
+// - Creates a human readable report of the collected statistics.
+// Arguments:
+// - maxSequences - The number of individual sequences to list, ordered by the time spent on them.
+// Return Value:
+// - The report, one item per line.
+std::wstring ParserInstrumentation::Summarize(const size_t maxSequences) const
+{
+    static constexpr std::array<std::wstring_view, _classCount> classNames{
+        L"C0", L"Print", L"ESC", L"VT52", L"CSI", L"OSC", L"SS3", L"DCS"
+    };
+
+    using duration = std::chrono::steady_clock::duration;
+    const auto micros = [](const int64_t ticks) {
+        return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration{ ticks }).count();
+    };
+
+    std::wstring summary;
+    fmt::format_to(std::back_inserter(summary), FMT_COMPILE(L"{} chars of input, {} of which printable\n"), _inputLength, _printedLength);
+
+    for (size_t i = 0; i < _classCount; i++)
+    {
+        const auto& stats = til::at(_classStats, i);
+        if (stats.count)
+        {
+            fmt::format_to(std::back_inserter(summary), FMT_COMPILE(L"{:<6} {:>10} x {:>14.1f}us\n"), til::at(classNames, i), stats.count, micros(stats.ticks));
+        }
+    }
+
+    struct Sequence
+    {
+        size_t dispatchClass;
+        uint64_t id;
+        Stats stats;
+    };
+    std::vector<Sequence> sequences;
+    for (size_t i = 0; i < _classCount; i++)
+    {
+        for (const auto& [id, stats] : til::at(_sequenceStats, i))
+        {
+            sequences.emplace_back(Sequence{ i, id, stats });
+        }
+    }
+
+    const auto count = std::min(maxSequences, sequences.size());
+    std::partial_sort(sequences.begin(), sequences.begin() + count, sequences.end(), [](const auto& a, const auto& b) {
+        return a.stats.ticks > b.stats.ticks;
+    });
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto& s = til::at(sequences, i);
+        const auto dispatchClass = static_cast<DispatchClass>(s.dispatchClass);
+        std::wstring name{ til::at(classNames, s.dispatchClass) };
+
+        if (dispatchClass == DispatchClass::Osc)
+        {
+            fmt::format_to(std::back_inserter(name), FMT_COMPILE(L" {}"), s.id);
+        }
+        else if (dispatchClass == DispatchClass::Execute)
+        {
+            fmt::format_to(std::back_inserter(name), FMT_COMPILE(L" 0x{:02X}"), s.id);
+        }
+        else
+        {
+            const VTID id{ s.id };
+            name.push_back(L' ');
+            for (const auto ch : id.ToString())
+            {
+                name.push_back(static_cast<wchar_t>(ch));
+            }
+        }
+
+        fmt::format_to(std::back_inserter(summary), FMT_COMPILE(L"  {:<12} {:>10} x {:>14.1f}us\n"), name, s.stats.count, micros(s.stats.ticks));
+    }
+
+    return summary;
+}
+
+void ParserInstrumentation::Reset() noexcept
+{
+    _classStats = {};
+    for (auto& map : _sequenceStats)
+    {
+        map.clear();
+    }
+    _inputLength = 0;
+    _printedLength = 0;
+}
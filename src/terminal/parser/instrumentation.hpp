@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- instrumentation.hpp
+
+Abstract:
+- Optionally attached to a StateMachine to find out which sequences dominate a given workload.
+- Counts the dispatched sequences by their identifier (the final character and
+  any prefix/intermediate characters, or the parameter for OSC) and measures
+  the time spent dispatching them, as well as the amount of printable text.
+- It can also record the raw input stream into a file as UTF-8,
+  which can then be replayed with the TerminalParser.Replay benchmark.
+*/
+
+#pragma once
+
+#include "../adapter/DispatchTypes.hpp"
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class ParserInstrumentation final
+    {
+    public:
+        enum class DispatchClass : uint8_t
+        {
+            Execute,
+            Print,
+            Esc,
+            Vt52,
+            Csi,
+            Osc,
+            Ss3,
+            Dcs,
+            Count,
+        };
+
+        struct Stats
+        {
+            uint64_t count = 0;
+            // The time spent dispatching, in std::chrono::steady_clock ticks.
+            int64_t ticks = 0;
+        };
+
+        void StartRecording(const std::wstring_view path);
+        void StopRecording() noexcept;
+        bool IsRecording() const noexcept;
+
+        void OnInput(const std::wstring_view string);
+        void OnPrint(const size_t length, const int64_t start) noexcept;
+        void OnDispatch(const DispatchClass dispatchClass, const uint64_t id, const int64_t start);
+
+        static int64_t Now() noexcept;
+
+        const Stats& GetStats(const DispatchClass dispatchClass) const noexcept;
+        uint64_t GetInputLength() const noexcept;
+        uint64_t GetPrintedLength() const noexcept;
+        std::wstring Summarize(const size_t maxSequences = 20) const;
+        void Reset() noexcept;
+
+    private:
+        static constexpr size_t _classCount = static_cast<size_t>(DispatchClass::Count);
+
+        std::array<Stats, _classCount> _classStats{};
+        // The stats of each individual sequence, keyed by the VTID for ESC, CSI, etc., by
+        // the parameter for OSC and by the character for C0 controls. Print isn't broken down.
+        std::array<std::unordered_map<uint64_t, Stats>, _classCount> _sequenceStats;
+        uint64_t _inputLength = 0;
+        uint64_t _printedLength = 0;
+
+        wil::unique_hfile _recording;
+        std::string _recordingBuffer;
+        // ProcessString() may split surrogate pairs across calls.
+        til::u16state _recordingState;
+    };
+}
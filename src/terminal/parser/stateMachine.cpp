@@ -6,9 +6,16 @@
 #include "stateMachine.hpp"
 
 #include "ascii.hpp"
+#include "../../inc/unicode.hpp"
+#include "../../types/inc/PerformanceRegion.hpp"
 
 using namespace Microsoft::Console::VirtualTerminal;
 
+extern "C" int __isa_available;
+
+// The OSC string buffer is kept around between sequences, unless it grew larger than this.
+static constexpr size_t RETAINED_OSC_STRING_CAPACITY = 64 * 1024;
+
 //Takes ownership of the pEngine.
 StateMachine::StateMachine(std::unique_ptr<IStateMachineEngine> engine, const bool isEngineForInput) :
     _engine(std::move(engine)),
@@ -34,6 +41,40 @@ bool StateMachine::GetParserMode(const Mode mode) const noexcept
     return _parserMode.test(mode);
 }
 
+// Routine Description:
+// - Sets the maximum number of characters an OSC string may consist of.
+//   Sequences that exceed it are consumed, but not dispatched.
+// Arguments:
+// - length - The new limit.
+// Return Value:
+// - <none>
+void StateMachine::SetMaxOscStringLength(const size_t length) noexcept
+{
+    _oscStringLimit = length;
+}
+
+size_t StateMachine::GetMaxOscStringLength() const noexcept
+{
+    return _oscStringLimit;
+}
+
+// Routine Description:
+// - Attaches the given instrumentation, which will then be informed about all
+//   input and dispatched actions. Passing nullptr turns instrumentation off again.
+// Arguments:
+// - instrumentation - The instrumentation to attach, or nullptr.
+// Return Value:
+// - <none>
+void StateMachine::SetInstrumentation(std::unique_ptr<ParserInstrumentation> instrumentation) noexcept
+{
+    _instrumentation = std::move(instrumentation);
+}
+
+ParserInstrumentation* StateMachine::Instrumentation() const noexcept
+{
+    return _instrumentation.get();
+}
+
 const IStateMachineEngine& StateMachine::Engine() const noexcept
 {
     return *_engine;
@@ -193,30 +234,6 @@ static constexpr bool _isCsiInvalid(const wchar_t wch) noexcept
     return wch == L':'; // 0x3A
 }
 
-// Routine Description:
-// - Determines if a character is an invalid intermediate.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isIntermediateInvalid(const wchar_t wch) noexcept
-{
-    // 0x30 - 0x3F
-    return _isNumericParamValue(wch) || _isCsiInvalid(wch) || _isParameterDelimiter(wch) || _isCsiPrivateMarker(wch);
-}
-
-// Routine Description:
-// - Determines if a character is an invalid parameter.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isParameterInvalid(const wchar_t wch) noexcept
-{
-    // 0x3A, 0x3C - 0x3F
-    return _isCsiInvalid(wch) || _isCsiPrivateMarker(wch);
-}
-
 // Routine Description:
 // - Determines if a character is a string terminator indicator.
 // Arguments:
@@ -379,6 +396,206 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
 
 #pragma warning(pop)
 
+// The CharClass of each character below U+0100. Everything else is CharClass::Final.
+const std::array<StateMachine::CharClass, 256> StateMachine::_charClasses = [] {
+    std::array<CharClass, 256> classes{};
+    for (size_t i = 0; i < classes.size(); ++i)
+    {
+        const auto wch = gsl::narrow_cast<wchar_t>(i);
+        auto& c = til::at(classes, i);
+        if (_isC0Code(wch))
+        {
+            c = CharClass::C0;
+        }
+        else if (_isDelete(wch))
+        {
+            c = CharClass::Delete;
+        }
+        else if (_isIntermediate(wch))
+        {
+            c = CharClass::Intermediate;
+        }
+        else if (_isNumericParamValue(wch))
+        {
+            c = CharClass::Digit;
+        }
+        else if (_isCsiInvalid(wch))
+        {
+            c = CharClass::Colon;
+        }
+        else if (_isParameterDelimiter(wch))
+        {
+            c = CharClass::Delimiter;
+        }
+        else if (_isCsiPrivateMarker(wch))
+        {
+            c = CharClass::PrivateMarker;
+        }
+        else
+        {
+            c = CharClass::Final;
+        }
+    }
+    return classes;
+}();
+
+// The transitions of the states handled by _EventSequence, indexed by [state][CharClass].
+// A transition to the current state means that we stay in it. The rows of all other states are unused.
+const std::array<std::array<StateMachine::SequenceTransition, StateMachine::CharClassCount>, StateMachine::VTStateCount> StateMachine::_sequenceTransitions = [] {
+    using A = SequenceAction;
+    using S = VTStates;
+
+    std::array<std::array<SequenceTransition, CharClassCount>, VTStateCount> table{};
+    const auto row = [&](const VTStates state, const std::array<SequenceTransition, CharClassCount>& transitions) {
+        til::at(table, static_cast<size_t>(state)) = transitions;
+    };
+
+    // clang-format off
+    // The columns are in the order of CharClass: C0, Delete, Intermediate, Digit, Colon, Delimiter, PrivateMarker, Final.
+    row(S::CsiEntry,        { { { A::Execute, S::CsiEntry },        { A::Ignore, S::CsiEntry },        { A::Collect, S::CsiIntermediate },        { A::Param, S::CsiParam },        { A::None, S::CsiIgnore },        { A::Param, S::CsiParam },        { A::Collect, S::CsiParam },        { A::CsiDispatch, S::Ground } } });
+    row(S::CsiIntermediate, { { { A::Execute, S::CsiIntermediate }, { A::Ignore, S::CsiIntermediate }, { A::Collect, S::CsiIntermediate },        { A::None, S::CsiIgnore },        { A::None, S::CsiIgnore },        { A::None, S::CsiIgnore },        { A::None, S::CsiIgnore },          { A::CsiDispatch, S::Ground } } });
+    row(S::CsiIgnore,       { { { A::Execute, S::CsiIgnore },       { A::Ignore, S::CsiIgnore },       { A::Ignore, S::CsiIgnore },               { A::Ignore, S::CsiIgnore },      { A::Ignore, S::CsiIgnore },      { A::Ignore, S::CsiIgnore },      { A::Ignore, S::CsiIgnore },        { A::None, S::Ground } } });
+    row(S::CsiParam,        { { { A::Execute, S::CsiParam },        { A::Ignore, S::CsiParam },        { A::Collect, S::CsiIntermediate },        { A::Param, S::CsiParam },        { A::None, S::CsiIgnore },        { A::Param, S::CsiParam },        { A::None, S::CsiIgnore },          { A::CsiDispatch, S::Ground } } });
+    // SS3 sequences are ignored just like CSI sequences, which is why they can share the CsiIgnore state.
+    row(S::Ss3Entry,        { { { A::Execute, S::Ss3Entry },        { A::Ignore, S::Ss3Entry },        { A::Ss3Dispatch, S::Ground },             { A::Param, S::Ss3Param },        { A::None, S::CsiIgnore },        { A::Param, S::Ss3Param },        { A::Ss3Dispatch, S::Ground },      { A::Ss3Dispatch, S::Ground } } });
+    row(S::Ss3Param,        { { { A::Execute, S::Ss3Param },        { A::Ignore, S::Ss3Param },        { A::Ss3Dispatch, S::Ground },             { A::Param, S::Ss3Param },        { A::None, S::CsiIgnore },        { A::Param, S::Ss3Param },        { A::None, S::CsiIgnore },          { A::Ss3Dispatch, S::Ground } } });
+    // C0 controls are ignored in DCS sequences. _ActionDcsDispatch enters the next state by itself.
+    row(S::DcsEntry,        { { { A::Ignore, S::DcsEntry },         { A::Ignore, S::DcsEntry },        { A::Collect, S::DcsIntermediate },        { A::Param, S::DcsParam },        { A::None, S::DcsIgnore },        { A::Param, S::DcsParam },        { A::DcsDispatch, S::DcsEntry },    { A::DcsDispatch, S::DcsEntry } } });
+    row(S::DcsIntermediate, { { { A::Ignore, S::DcsIntermediate },  { A::Ignore, S::DcsIntermediate }, { A::Collect, S::DcsIntermediate },        { A::None, S::DcsIgnore },        { A::None, S::DcsIgnore },        { A::None, S::DcsIgnore },        { A::None, S::DcsIgnore },          { A::DcsDispatch, S::DcsIntermediate } } });
+    row(S::DcsParam,        { { { A::Ignore, S::DcsParam },         { A::Ignore, S::DcsParam },        { A::Collect, S::DcsIntermediate },        { A::Param, S::DcsParam },        { A::None, S::DcsIgnore },        { A::Param, S::DcsParam },        { A::None, S::DcsIgnore },          { A::DcsDispatch, S::DcsParam } } });
+    // clang-format on
+
+    return table;
+}();
+
+// The names of all VTStates for tracing purposes.
+static constexpr std::array<const wchar_t*, 19> stateNames{
+    L"Ground",
+    L"Escape",
+    L"EscapeIntermediate",
+    L"CsiEntry",
+    L"CsiIntermediate",
+    L"CsiIgnore",
+    L"CsiParam",
+    L"OscParam",
+    L"OscString",
+    L"OscTermination",
+    L"Ss3Entry",
+    L"Ss3Param",
+    L"Vt52Param",
+    L"DcsEntry",
+    L"DcsIgnore",
+    L"DcsIntermediate",
+    L"DcsParam",
+    L"DcsPassThrough",
+    L"SosPmApcString",
+};
+
+// Routine Description:
+// - Finds the next character at or after the given offset for which
+//   _isActionableFromGround() returns true. This is the hot path when printing
+//   large amounts of plain text and so it's vectorized to check 8-16 characters at once.
+//   The actionable set consists of [0x00,0x1F] and [0x7F,0x9F] (DEL and the C1 controls),
+//   which allows us to test for it with just two unsigned saturating subtractions.
+// Arguments:
+// - string - Characters to scan.
+// - offset - The index at which to start scanning.
+// Return Value:
+// - The index of the first actionable character, or string.size() if there is none.
+// Returns true if there's a CR followed by a LF at the given offset.
+static bool _isCRLF(const std::wstring_view& string, const size_t offset) noexcept
+{
+    return offset + 1 < string.size() && til::at(string, offset) == AsciiChars::CR && til::at(string, offset + 1) == AsciiChars::LF;
+}
+
+static size_t _findActionableFromGround(const std::wstring_view& string, size_t offset) noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    const auto beg = string.data();
+    const auto end = beg + string.size();
+    auto it = beg + std::min(offset, string.size());
+
+#if defined(TIL_SSE_INTRINSICS)
+    if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        const auto c0Max = _mm256_set1_epi16(0x1f);
+        const auto delMin = _mm256_set1_epi16(0x7f);
+        const auto delRange = _mm256_set1_epi16(0x9f - 0x7f);
+
+        for (; end - it >= 16; it += 16)
+        {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            // v <= 0x1f  <=>  saturate(v - 0x1f) == 0
+            const auto c0 = _mm256_subs_epu16(v, c0Max);
+            // 0x7f <= v <= 0x9f  <=>  saturate((v - 0x7f) - 0x20) == 0
+            const auto c1 = _mm256_subs_epu16(_mm256_sub_epi16(v, delMin), delRange);
+            const auto zero = _mm256_cmpeq_epi16(_mm256_min_epu16(c0, c1), _mm256_setzero_si256());
+            if (const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(zero)))
+            {
+                return gsl::narrow_cast<size_t>(it - beg) + (_tzcnt_u32(mask) / 2);
+            }
+        }
+    }
+
+    {
+        const auto c0Max = _mm_set1_epi16(0x1f);
+        const auto delMin = _mm_set1_epi16(0x7f);
+        const auto delRange = _mm_set1_epi16(0x9f - 0x7f);
+
+        for (; end - it >= 8; it += 8)
+        {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const auto c0 = _mm_subs_epu16(v, c0Max);
+            const auto c1 = _mm_subs_epu16(_mm_sub_epi16(v, delMin), delRange);
+            // SSE2 lacks _mm_min_epu16, but since we only care about zeroes, OR works just as well.
+            const auto zero = _mm_cmpeq_epi16(_mm_or_si128(c0, c1), _mm_setzero_si128());
+            if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(zero)))
+            {
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return gsl::narrow_cast<size_t>(it - beg) + (index / 2);
+            }
+        }
+    }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+    {
+        const auto c0Max = vdupq_n_u16(0x1f);
+        const auto delMin = vdupq_n_u16(0x7f);
+        const auto delRange = vdupq_n_u16(0x9f - 0x7f);
+
+        for (; end - it >= 8; it += 8)
+        {
+            const auto v = vld1q_u16(reinterpret_cast<const uint16_t*>(it));
+            const auto c0 = vcleq_u16(v, c0Max);
+            const auto c1 = vcleq_u16(vsubq_u16(v, delMin), delRange);
+            // Narrow each 16-bit lane down to 8 bits, so that the 8 lanes fit into a single uint64_t.
+            const auto hits = vmovn_u16(vorrq_u16(c0, c1));
+            if (const auto mask = vget_lane_u64(vreinterpret_u64_u8(hits), 0))
+            {
+                unsigned long index;
+                _BitScanForward64(&index, mask);
+                return gsl::narrow_cast<size_t>(it - beg) + (index / 8);
+            }
+        }
+    }
+#endif
+
+    for (; it != end; ++it)
+    {
+        if (_isActionableFromGround(*it))
+        {
+            break;
+        }
+    }
+
+    return gsl::narrow_cast<size_t>(it - beg);
+
+#pragma warning(pop)
+}
+
 // Routine Description:
 // - Triggers the Execute action to indicate that the listener should immediately respond to a C0 control character.
 // Arguments:
@@ -387,10 +604,15 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
 // - <none>
 void StateMachine::_ActionExecute(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
     _trace.TraceOnExecute(wch);
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
         return _engine->ActionExecute(wch);
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Execute, wch, start);
+    }
 }
 
 // Routine Description:
@@ -403,10 +625,15 @@ void StateMachine::_ActionExecute(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
     _trace.TraceOnExecuteFromEscape(wch);
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
         return _engine->ActionExecuteFromEscape(wch);
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Execute, wch, start);
+    }
 }
 
 // Routine Description:
@@ -417,10 +644,15 @@ void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionPrint(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
     _trace.TraceOnAction(L"Print");
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
         return _engine->ActionPrint(wch);
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnPrint(1, start);
+    }
 }
 
 // Routine Description:
@@ -431,10 +663,35 @@ void StateMachine::_ActionPrint(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionPrintString(const std::wstring_view string)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
     _SafeExecute([=]() {
         return _engine->ActionPrintString(string);
     });
     _trace.DispatchPrintRunTrace(string);
+    if (_instrumentation)
+    {
+        _instrumentation->OnPrint(string.size(), start);
+    }
+}
+
+// Routine Description:
+// - Triggers the PrintLines action to indicate that the listener should render
+//      the given lines, each of which is terminated by a CRLF.
+// Arguments:
+// - string - Lines to dispatch.
+// Return Value:
+// - <none>
+void StateMachine::_ActionPrintLines(const std::wstring_view string)
+{
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    _SafeExecute([=]() {
+        return _engine->ActionPrintLines(string);
+    });
+    _trace.DispatchPrintRunTrace(string);
+    if (_instrumentation)
+    {
+        _instrumentation->OnPrint(string.size(), start);
+    }
 }
 
 // Routine Description:
@@ -446,10 +703,16 @@ void StateMachine::_ActionPrintString(const std::wstring_view string)
 // - <none>
 void StateMachine::_ActionEscDispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    const auto id = _identifier.Finalize(wch);
     _trace.TraceOnAction(L"EscDispatch");
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
-        return _engine->ActionEscDispatch(_identifier.Finalize(wch));
+        return _engine->ActionEscDispatch(id);
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Esc, id, start);
+    }
 }
 
 // Routine Description:
@@ -461,10 +724,16 @@ void StateMachine::_ActionEscDispatch(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionVt52EscDispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    const auto id = _identifier.Finalize(wch);
     _trace.TraceOnAction(L"Vt52EscDispatch");
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
-        return _engine->ActionVt52EscDispatch(_identifier.Finalize(wch), { _parameters.data(), _parameters.size() });
+        return _engine->ActionVt52EscDispatch(id, { _parameters.data(), _parameters.size() });
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Vt52, id, start);
+    }
 }
 
 // Routine Description:
@@ -476,10 +745,16 @@ void StateMachine::_ActionVt52EscDispatch(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionCsiDispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    const auto id = _identifier.Finalize(wch);
     _trace.TraceOnAction(L"CsiDispatch");
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
-        return _engine->ActionCsiDispatch(_identifier.Finalize(wch), { _parameters.data(), _parameters.size() });
+        return _engine->ActionCsiDispatch(id, { _parameters.data(), _parameters.size() });
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Csi, id, start);
+    }
 }
 
 // Routine Description:
@@ -561,8 +836,18 @@ void StateMachine::_ActionClear()
     _parameters.clear();
     _parameterLimitReached = false;
 
-    _oscString.clear();
+    // Don't hold on to the memory of an unusually large string (like an
+    // OSC 52 clipboard write) for the lifetime of the state machine.
+    if (_oscString.capacity() > RETAINED_OSC_STRING_CAPACITY)
+    {
+        _oscString = {};
+    }
+    else
+    {
+        _oscString.clear();
+    }
     _oscParameter = 0;
+    _oscStringLimitReached = false;
 
     _dcsStringHandler = nullptr;
 
@@ -622,7 +907,33 @@ void StateMachine::_ActionOscPut(const wchar_t wch)
 {
     _trace.TraceOnAction(L"OscPut");
 
-    _oscString.push_back(wch);
+    if (_oscString.size() < _oscStringLimit)
+    {
+        _oscString.push_back(wch);
+    }
+    else
+    {
+        _oscStringLimitReached = true;
+    }
+}
+
+// Routine Description:
+// - Stores a run of characters as part of the OSC string. This is equivalent
+//   to calling _ActionOscPut for each of them, but only grows the string once.
+// Arguments:
+// - string - Characters to store.
+// Return Value:
+// - <none>
+void StateMachine::_ActionOscPutString(const std::wstring_view string)
+{
+    _trace.TraceOnAction(L"OscPut");
+
+    const auto remaining = _oscStringLimit - std::min(_oscStringLimit, _oscString.size());
+    if (string.size() > remaining)
+    {
+        _oscStringLimitReached = true;
+    }
+    _oscString.append(string.substr(0, remaining));
 }
 
 // Routine Description:
@@ -634,10 +945,22 @@ void StateMachine::_ActionOscPut(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionOscDispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    const auto parameter = _oscParameter;
     _trace.TraceOnAction(L"OscDispatch");
+    // A truncated string would be misinterpreted (e.g. as a partial clipboard
+    // payload), so it's better to not dispatch it at all.
+    if (_oscStringLimitReached)
+    {
+        return;
+    }
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
         return _engine->ActionOscDispatch(wch, _oscParameter, _oscString);
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Osc, gsl::narrow_cast<uint64_t>(parameter), start);
+    }
 }
 
 // Routine Description:
@@ -649,10 +972,15 @@ void StateMachine::_ActionOscDispatch(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
     _trace.TraceOnAction(L"Ss3Dispatch");
     _trace.DispatchSequenceTrace(_SafeExecute([=]() {
         return _engine->ActionSs3Dispatch(wch, { _parameters.data(), _parameters.size() });
     }));
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Ss3, wch, start);
+    }
 }
 
 // Routine Description:
@@ -664,10 +992,12 @@ void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 // - <none>
 void StateMachine::_ActionDcsDispatch(const wchar_t wch)
 {
+    const auto start = _instrumentation ? ParserInstrumentation::Now() : 0;
+    const auto id = _identifier.Finalize(wch);
     _trace.TraceOnAction(L"DcsDispatch");
 
     const auto success = _SafeExecute([=]() {
-        _dcsStringHandler = _engine->ActionDcsDispatch(_identifier.Finalize(wch), { _parameters.data(), _parameters.size() });
+        _dcsStringHandler = _engine->ActionDcsDispatch(id, { _parameters.data(), _parameters.size() });
         // If the returned handler is null, the sequence is not supported.
         return _dcsStringHandler != nullptr;
     });
@@ -675,6 +1005,13 @@ void StateMachine::_ActionDcsDispatch(const wchar_t wch)
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
 
+    // This only measures the dispatch itself and not the processing
+    // of the data string that follows, which happens per character.
+    if (_instrumentation)
+    {
+        _instrumentation->OnDispatch(ParserInstrumentation::DispatchClass::Dcs, id, start);
+    }
+
     if (success)
     {
         // If successful, enter the pass through state.
@@ -687,6 +1024,30 @@ void StateMachine::_ActionDcsDispatch(const wchar_t wch)
     }
 }
 
+// Routine Description:
+// - Passes a run of characters to the DCS string handler. This is equivalent
+//   to calling _EventDcsPassThrough for each of them, minus the state machine
+//   overhead. The run must not contain any C0 or C1 control characters.
+// Arguments:
+// - string - Characters to pass through.
+// Return Value:
+// - <none>
+void StateMachine::_ActionDcsPassThroughString(const std::wstring_view string)
+{
+    _trace.TraceOnAction(L"DcsPassThrough");
+
+    for (const auto wch : string)
+    {
+        // Anything outside the GL range is ignored, just like in _EventDcsPassThrough.
+        if (_isDcsPassThroughValid(wch) && !_dcsStringHandler(wch))
+        {
+            // The rest of the run would be ignored by the DcsIgnore state anyway.
+            _EnterDcsIgnore();
+            return;
+        }
+    }
+}
+
 // Routine Description:
 // - Moves the state machine into the Ground state.
 //   This state is entered:
@@ -1128,175 +1489,92 @@ void StateMachine::_EventEscapeIntermediate(const wchar_t wch)
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiEntry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Collect Control Sequence Private markers
-//   7. Dispatch a control sequence with parameters for action
+// - Processes a character event into an Action that occurs while in one of the states
+//   collecting the parameters and intermediates of a CSI, SS3 or DCS sequence.
+//   Instead of testing the character against each of the classes the current state
+//   cares about, its class is looked up in _charClasses and the action and next state in
+//   _sequenceTransitions. This is the hot path for SGR-heavy output.
 // Arguments:
 // - wch - Character that triggered the event
 // Return Value:
 // - <none>
-void StateMachine::_EventCsiEntry(const wchar_t wch)
+void StateMachine::_EventSequence(const wchar_t wch)
 {
-    _trace.TraceOnEvent(L"CsiEntry");
-    if (_isC0Code(wch))
+    static_assert(stateNames.size() == VTStateCount);
+
+    const auto state = _state;
+    _trace.TraceOnEvent(til::at(stateNames, static_cast<size_t>(state)));
+
+    const auto charClass = wch < _charClasses.size() ? til::at(_charClasses, wch) : CharClass::Final;
+    const auto& transition = til::at(til::at(_sequenceTransitions, static_cast<size_t>(state)), static_cast<size_t>(charClass));
+
+    switch (transition.action)
     {
+    case SequenceAction::None:
+        break;
+    case SequenceAction::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
+        break;
+    case SequenceAction::Ignore:
         _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
+        break;
+    case SequenceAction::Collect:
         _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
+        break;
+    case SequenceAction::Param:
         _ActionParam(wch);
-        _EnterCsiParam();
-    }
-    else if (_isCsiPrivateMarker(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiParam();
-    }
-    else
-    {
+        break;
+    case SequenceAction::CsiDispatch:
         _ActionCsiDispatch(wch);
-        _EnterGround();
-        _ExecuteCsiCompleteCallback();
+        break;
+    case SequenceAction::Ss3Dispatch:
+        _ActionSs3Dispatch(wch);
+        break;
+    case SequenceAction::DcsDispatch:
+        _ActionDcsDispatch(wch);
+        break;
     }
-}
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIntermediate");
-    if (_isC0Code(wch))
+    if (transition.next != state)
     {
-        _ActionExecute(wch);
+        _EnterSequenceState(transition.next);
     }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
+
+    if (transition.action == SequenceAction::CsiDispatch)
     {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
         _ExecuteCsiCompleteCallback();
     }
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIgnore state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Return to Ground
+// - Enters one of the states that _sequenceTransitions can transition to.
 // Arguments:
-// - wch - Character that triggered the event
+// - state - The state to enter.
 // Return Value:
 // - <none>
-void StateMachine::_EventCsiIgnore(const wchar_t wch)
+void StateMachine::_EnterSequenceState(const VTStates state) noexcept
 {
-    _trace.TraceOnEvent(L"CsiIgnore");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
+    switch (state)
     {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiParam");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-        _ExecuteCsiCompleteCallback();
+    case VTStates::Ground:
+        return _EnterGround();
+    case VTStates::CsiIntermediate:
+        return _EnterCsiIntermediate();
+    case VTStates::CsiIgnore:
+        return _EnterCsiIgnore();
+    case VTStates::CsiParam:
+        return _EnterCsiParam();
+    case VTStates::Ss3Param:
+        return _EnterSs3Param();
+    case VTStates::DcsIntermediate:
+        return _EnterDcsIntermediate();
+    case VTStates::DcsIgnore:
+        return _EnterDcsIgnore();
+    case VTStates::DcsParam:
+        return _EnterDcsParam();
+    default:
+        // _sequenceTransitions doesn't transition to any other state.
+        return;
     }
 }
 
@@ -1390,88 +1668,6 @@ void StateMachine::_EventOscTermination(const wchar_t wch)
     }
 }
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Ss3Entry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-//  SS3 sequences are structurally the same as CSI sequences, just with a
-//      different initiation. It's safe to reuse CSI's functions for
-//      determining if a character is a parameter, delimiter, or invalid.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSs3Entry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Entry");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        // It's safe for us to go into the CSI ignore here, because both SS3 and
-        //      CSI sequences ignore characters the same way.
-        _EnterCsiIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterSs3Param();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSs3Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Param");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
 // Routine Description:
 // - Processes a character event into an Action that occurs while in the Vt52Param state.
 //   Events in this state will:
@@ -1507,53 +1703,6 @@ void StateMachine::_EventVt52Param(const wchar_t wch)
     }
 }
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsEntry state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining characters when an invalid character is detected (DcsIgnore)
-//   4. Store parameter data
-//   5. Collect Intermediate characters
-//   6. Dispatch the Final character in preparation for parsing the data string
-//  DCS sequences are structurally almost the same as CSI sequences, just with an
-//      extra data string. It's safe to reuse CSI functions for
-//      determining if a character is a parameter, delimiter, or invalid.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsEntry");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterDcsParam();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
 // Routine Description:
 // - Processes a character event into an Action that occurs while in the DcsIgnore state.
 //   In this state the entire DCS string is considered invalid and we will ignore everything.
@@ -1568,86 +1717,6 @@ void StateMachine::_EventDcsIgnore() noexcept
     _ActionIgnore();
 }
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsIntermediate state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect intermediate data.
-//   4. Begin to ignore all remaining intermediates when an invalid character is detected (DcsIgnore)
-//   5. Dispatch the Final character in preparation for parsing the data string
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsParam state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect DCS parameter data
-//   4. Enter DcsIntermediate if we see an intermediate
-//   5. Begin to ignore all remaining parameters when an invalid character is detected (DcsIgnore)
-//   6. Dispatch the Final character in preparation for parsing the data string
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsParam");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
 // Routine Description:
 // - Processes a character event into an Action that occurs while in the DcsPassThrough state.
 //   Events in this state will:
@@ -1743,33 +1812,25 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
         case VTStates::EscapeIntermediate:
             return _EventEscapeIntermediate(wch);
         case VTStates::CsiEntry:
-            return _EventCsiEntry(wch);
         case VTStates::CsiIntermediate:
-            return _EventCsiIntermediate(wch);
         case VTStates::CsiIgnore:
-            return _EventCsiIgnore(wch);
         case VTStates::CsiParam:
-            return _EventCsiParam(wch);
+        case VTStates::Ss3Entry:
+        case VTStates::Ss3Param:
+        case VTStates::DcsEntry:
+        case VTStates::DcsIntermediate:
+        case VTStates::DcsParam:
+            return _EventSequence(wch);
         case VTStates::OscParam:
             return _EventOscParam(wch);
         case VTStates::OscString:
             return _EventOscString(wch);
         case VTStates::OscTermination:
             return _EventOscTermination(wch);
-        case VTStates::Ss3Entry:
-            return _EventSs3Entry(wch);
-        case VTStates::Ss3Param:
-            return _EventSs3Param(wch);
         case VTStates::Vt52Param:
             return _EventVt52Param(wch);
-        case VTStates::DcsEntry:
-            return _EventDcsEntry(wch);
         case VTStates::DcsIgnore:
             return _EventDcsIgnore();
-        case VTStates::DcsIntermediate:
-            return _EventDcsIntermediate(wch);
-        case VTStates::DcsParam:
-            return _EventDcsParam(wch);
         case VTStates::DcsPassThrough:
             return _EventDcsPassThrough(wch);
         case VTStates::SosPmApcString:
@@ -1832,6 +1893,13 @@ bool StateMachine::FlushToTerminal()
 // - <none>
 void StateMachine::ProcessString(const std::wstring_view string)
 {
+    const Microsoft::Console::Types::PerformanceRegion region{ "StateMachine_ProcessString" };
+
+    if (_instrumentation)
+    {
+        _instrumentation->OnInput(string);
+    }
+
     size_t start = 0;
     auto current = start;
 
@@ -1849,6 +1917,28 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
         if (_processingIndividually)
         {
+            // OSC and DCS strings can be very long (think OSC 52 clipboard writes or DECDLD
+            // soft fonts), but mostly consist of plain characters, which can't change our state.
+            // We find them with the same scan we use for printable text and hand them off in bulk.
+            if (!_isEngineForInput && (_state == VTStates::OscString || _state == VTStates::DcsPassThrough))
+            {
+                const auto end = _findActionableFromGround(string, current);
+                if (end != current)
+                {
+                    const auto chunk = string.substr(current, end - current);
+                    if (_state == VTStates::OscString)
+                    {
+                        _ActionOscPutString(chunk);
+                    }
+                    else
+                    {
+                        _ActionDcsPassThroughString(chunk);
+                    }
+                    current = end;
+                    continue;
+                }
+            }
+
             // Note whether we're dealing with the last character in the buffer.
             _processingLastCharacter = (current + 1 >= string.size());
             // If we're processing characters individually, send it to the state machine.
@@ -1862,24 +1952,34 @@ void StateMachine::ProcessString(const std::wstring_view string)
         }
         else
         {
-            if (_isActionableFromGround(til::at(string, current))) // If the current char is the start of an escape sequence, or should be executed in ground state...
+            // Skip over all printable characters in one go. They're all part of the current run.
+            current = _findActionableFromGround(string, current);
+
+            // Output like that of `cat` mostly consists of lines of text each terminated by a
+            // CRLF. Instead of printing each line and then executing its CR and LF individually,
+            // we collect as many of them as we can and hand them to the engine in one go.
+            if (!_isEngineForInput && _isCRLF(string, current))
             {
-                if (_runSize > 0)
+                auto end = current + 2;
+                for (auto next = _findActionableFromGround(string, end); _isCRLF(string, next); next = _findActionableFromGround(string, end))
                 {
-                    // Because the run above is composed INCLUDING current, we must
-                    // trim it off here since we just determined it's actionable
-                    // and only pass through everything before it.
-                    _runSize -= 1;
-                    _ActionPrintString(_CurrentRun()); // ... print all the chars leading up to it as part of the run...
+                    end = next + 2;
                 }
 
-                _processingIndividually = true; // begin processing future characters individually...
-                start = current;
-                continue;
+                _runSize = end - start;
+                _ActionPrintLines(_CurrentRun());
+
+                start = end;
+                current = end;
             }
-            else
+            else if (current < string.size()) // If the current char is the start of an escape sequence, or should be executed in ground state...
             {
-                ++current; // Otherwise, add this char to the current run to be printed.
+                // The run only consists of the characters leading up to the actionable one.
+                _runSize = current - start;
+                _ActionPrintString(_CurrentRun()); // ... print all the chars leading up to it as part of the run...
+
+                _processingIndividually = true; // begin processing future characters individually...
+                start = current;
             }
         }
     }
@@ -1986,6 +2086,109 @@ void StateMachine::ProcessString(const std::wstring_view string)
     }
 }
 
+// Routine Description:
+// - Returns the length of the longest prefix of the given UTF-8 string that
+//   consists of ASCII characters only (or respectively the opposite).
+// Arguments:
+// - beg, end - The range of bytes to scan.
+// - ascii - If true, the returned prefix consists of bytes < 0x80, otherwise >= 0x80.
+// Return Value:
+// - The length of the prefix.
+static size_t _utf8RunLength(const char* beg, const char* end, const bool ascii) noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    auto it = beg;
+
+#if defined(TIL_SSE_INTRINSICS)
+    // The high bit of each byte directly tells us whether it's ASCII or not.
+    const auto invert = ascii ? 0u : 0xffffu;
+    for (; end - it >= 16; it += 16)
+    {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(v)) ^ invert)
+        {
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return gsl::narrow_cast<size_t>(it - beg) + index;
+        }
+    }
+#endif
+
+    for (; it != end && (static_cast<uint8_t>(*it) < 0x80) == ascii; ++it)
+    {
+    }
+
+    return gsl::narrow_cast<size_t>(it - beg);
+
+#pragma warning(pop)
+}
+
+// Routine Description:
+// - An alternative entry point to ProcessString() for output engines, which takes
+//   UTF-8 input. This avoids having to convert the entire input to UTF-16 upfront:
+//   ASCII runs (which includes all control characters and escape sequences) are
+//   widened using a simple copy and only the remaining text is passed to u8u16.
+//   The input is processed in chunks of a bounded size and so it can be of any length.
+//   Incomplete UTF-8 sequences at the end of the input are preserved for the next call.
+// - This should not be used for input engines, which rely on each call to
+//   ProcessString() containing exactly one complete key press.
+// Arguments:
+// - string - UTF-8 characters to operate upon
+// Return Value:
+// - <none>
+void StateMachine::ProcessString(const std::string_view string)
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+
+    // Large enough to amortize the cost of each ProcessString() call,
+    // while still fitting comfortably into the L1 cache.
+    static constexpr size_t chunkSize = 4096;
+
+    auto it = string.data();
+    const auto end = it + string.size();
+
+    while (it != end)
+    {
+        const auto available = std::min(gsl::narrow_cast<size_t>(end - it), chunkSize);
+
+        if (static_cast<uint8_t>(*it) < 0x80)
+        {
+            // An ASCII character can't continue an incomplete sequence from a previous call.
+            // MultiByteToWideChar would replace it with U+FFFD and so we do the same.
+            if (_utf8State.have)
+            {
+                _utf8State.reset();
+                ProcessCharacter(UNICODE_REPLACEMENT);
+            }
+
+            const auto len = _utf8RunLength(it, it + available, true);
+            // The buffer is overwritten entirely, so there's no point in zeroing it first.
+            til::details::resize_and_overwrite(_utf8Buffer, len, [&](wchar_t* data, size_t) noexcept {
+                std::copy_n(it, len, data);
+                return len;
+            });
+            it += len;
+        }
+        else
+        {
+            const auto len = _utf8RunLength(it, it + available, false);
+            THROW_IF_FAILED(til::u8u16({ it, len }, _utf8Buffer, _utf8State));
+            it += len;
+        }
+
+        if (!_utf8Buffer.empty())
+        {
+            ProcessString(std::wstring_view{ _utf8Buffer });
+        }
+    }
+
+#pragma warning(pop)
+}
+
 // Routine Description:
 // - Determines whether the character being processed is the last in the
 //   current output fragment, or there are more still to come. Other parts
@@ -15,6 +15,7 @@ Abstract:
 #pragma once
 
 #include "IStateMachineEngine.hpp"
+#include "instrumentation.hpp"
 #include "tracing.hpp"
 #include <memory>
 
@@ -31,6 +32,11 @@ namespace Microsoft::Console::VirtualTerminal
     // that number.
     constexpr size_t MAX_PARAMETER_COUNT = 32;
 
+    // OSC strings are buffered until they're terminated, which means that an
+    // unterminated one could otherwise grow without bounds. The default is
+    // generous enough for multi-MiB OSC 52 clipboard writes.
+    constexpr size_t DEFAULT_MAX_OSC_STRING_LENGTH = 8 * 1024 * 1024;
+
     class StateMachine final
     {
 #ifdef UNIT_TESTING
@@ -56,8 +62,12 @@ namespace Microsoft::Console::VirtualTerminal
         void SetParserMode(const Mode mode, const bool enabled) noexcept;
         bool GetParserMode(const Mode mode) const noexcept;
 
+        void SetMaxOscStringLength(const size_t length) noexcept;
+        size_t GetMaxOscStringLength() const noexcept;
+
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const std::wstring_view string);
+        void ProcessString(const std::string_view string);
         bool IsProcessingLastCharacter() const noexcept;
 
         void OnCsiComplete(const std::function<void()> callback);
@@ -69,6 +79,9 @@ namespace Microsoft::Console::VirtualTerminal
         const IStateMachineEngine& Engine() const noexcept;
         IStateMachineEngine& Engine() noexcept;
 
+        void SetInstrumentation(std::unique_ptr<ParserInstrumentation> instrumentation) noexcept;
+        ParserInstrumentation* Instrumentation() const noexcept;
+
         class ShutdownException : public wil::ResultException
         {
         public:
@@ -81,6 +94,7 @@ namespace Microsoft::Console::VirtualTerminal
         void _ActionExecuteFromEscape(const wchar_t wch);
         void _ActionPrint(const wchar_t wch);
         void _ActionPrintString(const std::wstring_view string);
+        void _ActionPrintLines(const std::wstring_view string);
         void _ActionEscDispatch(const wchar_t wch);
         void _ActionVt52EscDispatch(const wchar_t wch);
         void _ActionCollect(const wchar_t wch) noexcept;
@@ -88,9 +102,11 @@ namespace Microsoft::Console::VirtualTerminal
         void _ActionCsiDispatch(const wchar_t wch);
         void _ActionOscParam(const wchar_t wch) noexcept;
         void _ActionOscPut(const wchar_t wch);
+        void _ActionOscPutString(const std::wstring_view string);
         void _ActionOscDispatch(const wchar_t wch);
         void _ActionSs3Dispatch(const wchar_t wch);
         void _ActionDcsDispatch(const wchar_t wch);
+        void _ActionDcsPassThroughString(const std::wstring_view string);
 
         void _ActionClear();
         void _ActionIgnore() noexcept;
@@ -119,20 +135,12 @@ namespace Microsoft::Console::VirtualTerminal
         void _EventGround(const wchar_t wch);
         void _EventEscape(const wchar_t wch);
         void _EventEscapeIntermediate(const wchar_t wch);
-        void _EventCsiEntry(const wchar_t wch);
-        void _EventCsiIntermediate(const wchar_t wch);
-        void _EventCsiIgnore(const wchar_t wch);
-        void _EventCsiParam(const wchar_t wch);
+        void _EventSequence(const wchar_t wch);
         void _EventOscParam(const wchar_t wch) noexcept;
         void _EventOscString(const wchar_t wch);
         void _EventOscTermination(const wchar_t wch);
-        void _EventSs3Entry(const wchar_t wch);
-        void _EventSs3Param(const wchar_t wch);
         void _EventVt52Param(const wchar_t wch);
-        void _EventDcsEntry(const wchar_t wch);
         void _EventDcsIgnore() noexcept;
-        void _EventDcsIntermediate(const wchar_t wch);
-        void _EventDcsParam(const wchar_t wch);
         void _EventDcsPassThrough(const wchar_t wch);
         void _EventSosPmApcString(const wchar_t wch) noexcept;
 
@@ -165,8 +173,48 @@ namespace Microsoft::Console::VirtualTerminal
             DcsPassThrough,
             SosPmApcString
         };
+        static constexpr size_t VTStateCount = static_cast<size_t>(VTStates::SosPmApcString) + 1;
+
+        // The states handled by _EventSequence only care about which of these classes a character belongs to.
+        enum class CharClass : uint8_t
+        {
+            C0,
+            Delete,
+            Intermediate, // 0x20 - 0x2F
+            Digit, // 0x30 - 0x39
+            Colon, // 0x3A
+            Delimiter, // 0x3B
+            PrivateMarker, // 0x3C - 0x3F
+            Final,
+        };
+        static constexpr size_t CharClassCount = static_cast<size_t>(CharClass::Final) + 1;
+
+        enum class SequenceAction : uint8_t
+        {
+            None,
+            Execute,
+            Ignore,
+            Collect,
+            Param,
+            CsiDispatch,
+            Ss3Dispatch,
+            DcsDispatch,
+        };
+
+        struct SequenceTransition
+        {
+            SequenceAction action;
+            VTStates next;
+        };
+
+        static const std::array<CharClass, 256> _charClasses;
+        static const std::array<std::array<SequenceTransition, CharClassCount>, VTStateCount> _sequenceTransitions;
+
+        void _EnterSequenceState(const VTStates state) noexcept;
 
         Microsoft::Console::VirtualTerminal::ParserTracing _trace;
+        // Only set while someone is interested in the statistics. See SetInstrumentation().
+        std::unique_ptr<ParserInstrumentation> _instrumentation;
 
         std::unique_ptr<IStateMachineEngine> _engine;
         const bool _isEngineForInput;
@@ -194,11 +242,17 @@ namespace Microsoft::Console::VirtualTerminal
 
         std::wstring _oscString;
         VTInt _oscParameter;
+        size_t _oscStringLimit = DEFAULT_MAX_OSC_STRING_LENGTH;
+        bool _oscStringLimitReached = false;
 
         IStateMachineEngine::StringHandler _dcsStringHandler;
 
         std::optional<std::wstring> _cachedSequence;
 
+        // Scratch space for ProcessString(std::string_view).
+        std::wstring _utf8Buffer;
+        til::u8state _utf8State;
+
         // This is tracked per state machine instance so that separate calls to Process*
         //   can start and finish a sequence.
         bool _processingIndividually;
@@ -103,6 +103,33 @@ class Microsoft::Console::VirtualTerminal::Base64Test
         }
     }
 
+    TEST_METHOD(DecodeLong)
+    {
+        // These are long enough to go through the vectorized decoder (if available)
+        // and test that it correctly hands off to the scalar one where needed.
+        std::wstring result;
+
+        Log::Comment(L"Regular alphabet, including both 62 and 63");
+        VERIFY_SUCCEEDED(Base64::Decode(L"VGhlID8+Pj8gcXVpY2sgfn5+IGJyb3duID8+PyBmb3hUaGUgPz4+PyBxdWljayB+fn4gYnJvd24gPz4/IGZveA==", result));
+        VERIFY_ARE_EQUAL(L"The ?>>? quick ~~~ brown ?>? foxThe ?>>? quick ~~~ brown ?>? fox", result);
+
+        Log::Comment(L"URL alphabet");
+        VERIFY_SUCCEEDED(Base64::Decode(L"VGhlID8-Pj8gcXVpY2sgfn5-IGJyb3duID8-PyBmb3hUaGUgPz4-PyBxdWljayB-fn4gYnJvd24gPz4_IGZveA==", result));
+        VERIFY_ARE_EQUAL(L"The ?>>? quick ~~~ brown ?>? foxThe ?>>? quick ~~~ brown ?>? fox", result);
+
+        Log::Comment(L"Padding at the end of the input");
+        VERIFY_SUCCEEDED(Base64::Decode(L"VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", result));
+        VERIFY_ARE_EQUAL(L"The quick brown fox jumps over the lazy dog.", result);
+
+        Log::Comment(L"Invalid characters in the middle of the input");
+        VERIFY_FAILED(Base64::Decode(L"VGhlIHF1aWNrIGJyb3duIGZv eCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", result));
+        VERIFY_FAILED(Base64::Decode(L"VGhlIHF1aWNrIGJyb3duIGZv=CBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", result));
+
+        Log::Comment(L"Characters outside of ASCII, whose lower byte is in the alphabet");
+        VERIFY_FAILED(Base64::Decode(L"VGhlIHF1aWNrIGJyb3duIGZv\u0165CBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", result));
+        VERIFY_FAILED(Base64::Decode(L"VGhlIHF1aWNrIGJyb3duIGZv\uff65CBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", result));
+    }
+
     TEST_METHOD(DecodeUTF8)
     {
         std::wstring result;
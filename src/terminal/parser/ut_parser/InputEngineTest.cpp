@@ -327,6 +327,7 @@ public:
                                     const VTParameter parameter1,
                                     const VTParameter parameter2) override; // DTTERM_WindowManipulation
     virtual bool WriteString(const std::wstring_view string) override;
+    virtual bool WritePassThroughString(const std::wstring_view string) override;
 
     virtual bool MoveCursor(const VTInt row,
                             const VTInt col) override;
@@ -389,6 +390,16 @@ bool TestInteractDispatch::WriteString(const std::wstring_view string)
     return WriteInput(keyEvents);
 }
 
+bool TestInteractDispatch::WritePassThroughString(const std::wstring_view string)
+{
+    std::deque<std::unique_ptr<IInputEvent>> inputEvents;
+    for (const auto& wch : string)
+    {
+        inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
+    }
+    return WriteInput(inputEvents);
+}
+
 bool TestInteractDispatch::MoveCursor(const VTInt row, const VTInt col)
 {
     VERIFY_IS_TRUE(_testState->_expectCursorPosition);
@@ -38,6 +38,9 @@ public:
         dcsId = 0;
         dcsParams.clear();
         dcsDataString.clear();
+        oscDispatchCount = 0;
+        oscParameter = 0;
+        oscString.clear();
     }
 
     bool ActionExecute(const wchar_t wch) override
@@ -53,6 +56,18 @@ public:
         printed += string;
         return true;
     };
+    bool ActionPrintLines(const std::wstring_view string) override
+    {
+        // Record the lines as if they had been printed and executed individually.
+        for (auto remaining = string; !remaining.empty();)
+        {
+            const auto eol = std::min(remaining.find(L"\r\n"), remaining.size());
+            printed += remaining.substr(0, eol);
+            executed += L"\r\n";
+            remaining = remaining.substr(std::min(eol + 2, remaining.size()));
+        }
+        return true;
+    };
 
     bool ActionPassThroughString(const std::wstring_view string) override
     {
@@ -69,9 +84,12 @@ public:
     bool ActionIgnore() override { return true; };
 
     bool ActionOscDispatch(const wchar_t /* wch */,
-                           const size_t /* parameter */,
-                           const std::wstring_view /* string */) override
+                           const size_t parameter,
+                           const std::wstring_view string) override
     {
+        oscDispatchCount++;
+        oscParameter = parameter;
+        oscString = string;
         if (pfnFlushToTerminal)
         {
             pfnFlushToTerminal();
@@ -133,6 +151,11 @@ public:
     uint64_t dcsId = 0;
     std::vector<size_t> dcsParams;
     std::wstring dcsDataString;
+
+    // These will only be populated if ActionOscDispatch is called.
+    size_t oscDispatchCount = 0;
+    size_t oscParameter = 0;
+    std::wstring oscString;
 };
 
 class Microsoft::Console::VirtualTerminal::StateMachineTest
@@ -154,11 +177,19 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(PassThroughUnhandled);
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
+    TEST_METHOD(BulkTextPrintAroundControlCharacters);
+    TEST_METHOD(Utf8TextPrint);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
+    TEST_METHOD(DcsDataStringsSplitAcrossWrites);
+    TEST_METHOD(DcsControlCharactersInParameters);
+    TEST_METHOD(OscStringsSplitAcrossWrites);
+    TEST_METHOD(OscStringLengthLimit);
 
     TEST_METHOD(VtParameterSubspanTest);
+
+    TEST_METHOD(InstrumentationCountsDispatches);
 };
 
 void StateMachineTest::TwoStateMachinesDoNotInterfereWithEachOther()
@@ -231,6 +262,69 @@ void StateMachineTest::BulkTextPrint()
     VERIFY_ARE_EQUAL(String(L"12345 Hello World"), String(engine.printed.c_str()));
 }
 
+void StateMachineTest::BulkTextPrintAroundControlCharacters()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // The ground state scanner processes up to 16 characters at a time.
+    // Place an actionable character at every offset of a string that's
+    // longer than that, to ensure that each one is found exactly where it is.
+    // The characters right next to the actionable ranges must still be printed.
+    static constexpr std::wstring_view text{ L"abcdefghijklmnopqrstuvwxyz \x7e\xa0\u2500\U0001F600" };
+    static constexpr std::array<wchar_t, 5> actionable{ L'\x00', L'\x1f', L'\x7f', L'\x85', L'\x9f' };
+
+    for (const auto ch : actionable)
+    {
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            std::wstring input{ text };
+            input.insert(i, 1, ch);
+
+            engine.ResetTestState();
+            machine.ResetState();
+            machine.ProcessString(input);
+
+            Log::Comment(NoThrowString().Format(L"Control character 0x%02x at offset %zu", ch, i));
+            VERIFY_ARE_EQUAL(String(text.data(), gsl::narrow<int>(text.size())), String(engine.printed.c_str()));
+        }
+    }
+}
+
+void StateMachineTest::Utf8TextPrint()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"Escape sequences and text are handled just like their UTF-16 equivalent");
+    machine.ProcessString(std::string_view{ "abc\x1b[12;34m\xc3\xa4\xe2\x94\x80\xf0\x9f\x98\x80xyz" });
+    VERIFY_ARE_EQUAL(String(L"abc\u00e4\u2500\U0001F600xyz"), String(engine.printed.c_str()));
+    VERIFY_ARE_EQUAL((std::vector<size_t>{ 12u, 34u }), engine.csiParams);
+
+    Log::Comment(L"Incomplete code points are completed by the next call");
+    engine.ResetTestState();
+    machine.ProcessString(std::string_view{ "a\xf0\x9f" });
+    machine.ProcessString(std::string_view{ "\x98" });
+    machine.ProcessString(std::string_view{ "\x80b" });
+    VERIFY_ARE_EQUAL(String(L"a\U0001F600b"), String(engine.printed.c_str()));
+
+    Log::Comment(L"Incomplete code points followed by ASCII are replaced with U+FFFD");
+    engine.ResetTestState();
+    machine.ProcessString(std::string_view{ "a\xe2\x94" });
+    machine.ProcessString(std::string_view{ "b" });
+    VERIFY_ARE_EQUAL(String(L"a\ufffdb"), String(engine.printed.c_str()));
+
+    Log::Comment(L"Input larger than the internal chunk size is printed in full");
+    engine.ResetTestState();
+    const std::string large(10000, 'x');
+    machine.ProcessString(large);
+    VERIFY_ARE_EQUAL(String(std::wstring(10000, L'x').c_str()), String(engine.printed.c_str()));
+}
+
 void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
 {
     auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
@@ -340,6 +434,97 @@ void StateMachineTest::DcsDataStringsReceivedByHandler()
     VERIFY_ARE_EQUAL(expectedExecuted, engine.executed);
 }
 
+void StateMachineTest::DcsDataStringsSplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"Characters outside of the GL range are ignored, but control characters are passed through");
+    machine.ProcessString(L"\033P1|first");
+    machine.ProcessString(L" half\u00e9\r\nsecond");
+    machine.ProcessString(L" half\033\\printed text");
+
+    VERIFY_ARE_EQUAL(VTID("|"), engine.dcsId);
+    VERIFY_ARE_EQUAL(L"first half\r\nsecond half\033", engine.dcsDataString);
+    VERIFY_ARE_EQUAL(L"printed text", engine.printed);
+}
+
+void StateMachineTest::DcsControlCharactersInParameters()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"C0 controls and DEL are ignored in every part of the DCS introducer");
+    machine.ProcessString(L"\033P\r1\n2\x7f;3 \b|data\033\\");
+
+    VERIFY_ARE_EQUAL(VTID(" |"), engine.dcsId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 12, 3 }), engine.dcsParams);
+    VERIFY_ARE_EQUAL(L"data\033", engine.dcsDataString);
+    VERIFY_ARE_EQUAL(L"", engine.executed);
+}
+
+void StateMachineTest::OscStringsSplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"OSC string terminated with BEL");
+    machine.ProcessString(L"\033]52;c;SGVsbG8s");
+    machine.ProcessString(L"IHdvcmxk\u00e9\x7f");
+    machine.ProcessString(L"IQ==\007printed text");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatchCount);
+    VERIFY_ARE_EQUAL(52u, engine.oscParameter);
+    VERIFY_ARE_EQUAL(L"c;SGVsbG8sIHdvcmxk\u00e9\x7fIQ==", engine.oscString);
+    VERIFY_ARE_EQUAL(L"printed text", engine.printed);
+
+    engine.ResetTestState();
+
+    Log::Comment(L"OSC string terminated with ST");
+    machine.ProcessString(L"\033]0;title");
+    machine.ProcessString(L"\033");
+    machine.ProcessString(L"\\printed text");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatchCount);
+    VERIFY_ARE_EQUAL(0u, engine.oscParameter);
+    VERIFY_ARE_EQUAL(L"title", engine.oscString);
+    VERIFY_ARE_EQUAL(L"printed text", engine.printed);
+}
+
+void StateMachineTest::OscStringLengthLimit()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+    machine.SetMaxOscStringLength(8);
+
+    Log::Comment(L"Strings up to the limit are dispatched");
+    machine.ProcessString(L"\033]0;1234567\033\\");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatchCount);
+    VERIFY_ARE_EQUAL(L"1234567", engine.oscString);
+
+    engine.ResetTestState();
+
+    Log::Comment(L"Strings exceeding the limit are consumed, but not dispatched");
+    machine.ProcessString(L"\033]0;12345");
+    machine.ProcessString(L"6789\033\\printed text");
+    VERIFY_ARE_EQUAL(0u, engine.oscDispatchCount);
+    VERIFY_ARE_EQUAL(L"printed text", engine.printed);
+
+    engine.ResetTestState();
+
+    Log::Comment(L"The limit doesn't carry over to the next string");
+    machine.ProcessString(L"\033]0;");
+    for (auto i = 0; i < 8; i++)
+    {
+        machine.ProcessCharacter(L'x');
+    }
+    machine.ProcessString(L"\007");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatchCount);
+    VERIFY_ARE_EQUAL(L"xxxxxxxx", engine.oscString);
+}
+
 void StateMachineTest::VtParameterSubspanTest()
 {
     const auto parameterList = std::vector<VTParameter>{ 12, 34, 56, 78 };
@@ -374,3 +559,29 @@ void StateMachineTest::VtParameterSubspanTest()
         VERIFY_IS_FALSE(subspan.at(0).has_value());
     }
 }
+
+void StateMachineTest::InstrumentationCountsDispatches()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    StateMachine mach(std::move(enginePtr));
+
+    mach.SetInstrumentation(std::make_unique<ParserInstrumentation>());
+    // 2 CSIs with different final characters, 1 OSC, a C0 control and 6 printable characters.
+    mach.ProcessString(L"\x1b[1mabc\x1b[2J\x1b]0;t\x07\rdef");
+
+    const auto& instrumentation = *mach.Instrumentation();
+    VERIFY_ARE_EQUAL(2u, instrumentation.GetStats(ParserInstrumentation::DispatchClass::Csi).count);
+    VERIFY_ARE_EQUAL(1u, instrumentation.GetStats(ParserInstrumentation::DispatchClass::Osc).count);
+    VERIFY_ARE_EQUAL(1u, instrumentation.GetStats(ParserInstrumentation::DispatchClass::Execute).count);
+    VERIFY_ARE_EQUAL(6u, instrumentation.GetPrintedLength());
+    VERIFY_ARE_EQUAL(21u, instrumentation.GetInputLength());
+
+    const auto summary = instrumentation.Summarize();
+    VERIFY_IS_TRUE(summary.find(L"CSI m") != std::wstring::npos);
+    VERIFY_IS_TRUE(summary.find(L"CSI J") != std::wstring::npos);
+    VERIFY_IS_TRUE(summary.find(L"OSC 0") != std::wstring::npos);
+
+    mach.SetInstrumentation(nullptr);
+    mach.ProcessString(L"\x1b[1m");
+    VERIFY_IS_NULL(mach.Instrumentation());
+}
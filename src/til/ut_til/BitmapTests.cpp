@@ -962,6 +962,43 @@ class BitmapTests
         VERIFY_ARE_EQUAL(expected, actual);
     }
 
+    TEST_METHOD(RunsAcrossWords)
+    {
+        // The bits are stored in 64-bit words. A width of 100 ensures that
+        // rows and runs start and end in the middle of words.
+        Log::Comment(L"Set up a bitmap that is larger than a couple of words.");
+        til::bitmap map{ til::size{ 100, 5 } };
+
+        map.set(til::rect{ til::point{ 60, 0 }, til::size{ 10, 1 } });
+        map.set(til::rect{ til::point{ 0, 1 }, til::size{ 100, 2 } });
+        map.set(til::point{ 99, 4 });
+
+        std::vector<til::rect> expected;
+        expected.emplace_back(til::rect{ til::point{ 60, 0 }, til::size{ 10, 1 } });
+        expected.emplace_back(til::rect{ til::point{ 0, 1 }, til::size{ 100, 1 } });
+        expected.emplace_back(til::rect{ til::point{ 0, 2 }, til::size{ 100, 1 } });
+        expected.emplace_back(til::rect{ til::point{ 99, 4 }, til::size{ 1, 1 } });
+
+        std::vector<til::rect> actual{ map.begin(), map.end() };
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        Log::Comment(L"Translating down by a row shifts the bits across word boundaries.");
+        map.translate(til::point{ 0, 1 });
+
+        expected.clear();
+        expected.emplace_back(til::rect{ til::point{ 60, 1 }, til::size{ 10, 1 } });
+        expected.emplace_back(til::rect{ til::point{ 0, 2 }, til::size{ 100, 1 } });
+        expected.emplace_back(til::rect{ til::point{ 0, 3 }, til::size{ 100, 1 } });
+
+        actual.assign(map.begin(), map.end());
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        Log::Comment(L"Filling a large bitmap must set every bit, not just the first word.");
+        const til::bitmap filled{ til::size{ 100, 5 }, true };
+        VERIFY_IS_TRUE(filled.all());
+        VERIFY_ARE_EQUAL(500u, filled._bits.count());
+    }
+
     TEST_METHOD(RunsWithPmr)
     {
         // This is a copy of the above test, but with a pmr::bitmap.
@@ -65,4 +65,103 @@ class FlatSetTests
         VERIFY_ARE_EQUAL(&entry1, &entry2);
         VERIFY_ARE_EQUAL(123u, entry2.value);
     }
+
+    TEST_METHOD(EraseIf)
+    {
+        til::linear_flat_set<Data> set;
+
+        // 100 items ensure that the hashmap grows a couple times and that some of them collide.
+        for (auto i = 0; i < 100; ++i)
+        {
+            set.insert(i);
+        }
+
+        const auto erased = set.erase_if([](const Data& d) { return d.value % 3 == 0; });
+        VERIFY_ARE_EQUAL(34u, erased);
+        VERIFY_ARE_EQUAL(66u, set.size());
+
+        // Every remaining item must still be reachable through its probe sequence.
+        for (auto i = 0; i < 100; ++i)
+        {
+            VERIFY_ARE_EQUAL(i % 3 != 0, set.lookup(i) != nullptr);
+        }
+
+        const auto [entry, inserted] = set.insert(3);
+        VERIFY_IS_TRUE(inserted);
+        VERIFY_ARE_EQUAL(3u, entry.value);
+    }
+
+    TEST_METHOD(SwissBasic)
+    {
+        til::swiss_flat_set<Data> set;
+
+        const auto [entry1, inserted1] = set.insert(123);
+        VERIFY_IS_TRUE(inserted1);
+
+        const auto [entry2, inserted2] = set.insert(123);
+        VERIFY_IS_FALSE(inserted2);
+
+        VERIFY_ARE_EQUAL(&entry1, &entry2);
+        VERIFY_ARE_EQUAL(123u, entry2.value);
+        VERIFY_ARE_EQUAL(1u, set.size());
+        VERIFY_IS_NULL(set.lookup(124));
+    }
+
+    TEST_METHOD(SwissGrowth)
+    {
+        til::swiss_flat_set<Data> set;
+
+        // 1000 items ensure that the hashmap grows many times, that probe sequences
+        // span multiple groups and that the mirrored control bytes at the end are used.
+        for (auto i = 0; i < 1000; ++i)
+        {
+            VERIFY_IS_TRUE(set.insert(i * 7).second);
+        }
+
+        VERIFY_ARE_EQUAL(1000u, set.size());
+
+        size_t occupied = 0;
+        for (const auto& slot : set.container())
+        {
+            occupied += slot ? 1 : 0;
+        }
+        VERIFY_ARE_EQUAL(1000u, occupied);
+
+        for (auto i = 0; i < 7000; ++i)
+        {
+            const auto slot = set.lookup(i);
+            VERIFY_ARE_EQUAL(i % 7 == 0, slot != nullptr);
+            if (slot)
+            {
+                VERIFY_ARE_EQUAL(static_cast<size_t>(i), slot->value);
+            }
+        }
+
+        set.clear();
+        VERIFY_IS_TRUE(set.empty());
+        VERIFY_IS_NULL(set.lookup(0));
+    }
+
+    TEST_METHOD(SwissEraseIf)
+    {
+        til::swiss_flat_set<Data> set;
+
+        for (auto i = 0; i < 100; ++i)
+        {
+            set.insert(i);
+        }
+
+        const auto erased = set.erase_if([](const Data& d) { return d.value % 3 == 0; });
+        VERIFY_ARE_EQUAL(34u, erased);
+        VERIFY_ARE_EQUAL(66u, set.size());
+
+        for (auto i = 0; i < 100; ++i)
+        {
+            VERIFY_ARE_EQUAL(i % 3 != 0, set.lookup(i) != nullptr);
+        }
+
+        const auto [entry, inserted] = set.insert(3);
+        VERIFY_IS_TRUE(inserted);
+        VERIFY_ARE_EQUAL(3u, entry.value);
+    }
 };
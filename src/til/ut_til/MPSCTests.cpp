@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+
+#include <til/mpsc.h>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class MPSCTests
+{
+    BEGIN_TEST_CLASS(MPSCTests)
+        TEST_CLASS_PROPERTY(L"TestTimeout", L"0:0:10") // 10s timeout
+    END_TEST_CLASS()
+
+    TEST_METHOD(SmokeTest);
+    TEST_METHOD(FullQueueTest);
+    TEST_METHOD(DropProducersTest);
+    TEST_METHOD(DropConsumerTest);
+    TEST_METHOD(IntegrationTest);
+};
+
+void MPSCTests::SmokeTest()
+{
+    // This test mostly ensures that the API wasn't broken.
+
+    // construction
+    auto [tx, rx] = til::mpsc::channel<int>(32);
+    std::array<int, 3> data{};
+
+    // copy and move
+    auto tx2(tx);
+    auto tx3(std::move(tx2));
+    tx2 = tx3;
+    auto rx2(std::move(rx));
+    rx = std::move(rx2);
+
+    // push
+    tx.emplace(0);
+    tx2.emplace(1);
+    tx3.try_emplace(2);
+
+    // pop
+    VERIFY_ARE_EQUAL(0, rx.pop());
+    VERIFY_ARE_EQUAL(1, rx.try_pop());
+    VERIFY_ARE_EQUAL(1u, rx.try_pop_n(data.begin(), data.size()).first);
+    VERIFY_ARE_EQUAL(2, data[0]);
+    VERIFY_ARE_EQUAL(0u, rx.try_pop_n(data.begin(), data.size()).first);
+}
+
+void MPSCTests::FullQueueTest()
+{
+    // The capacity is rounded up to 4.
+    auto [tx, rx] = til::mpsc::channel<int>(3);
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        VERIFY_IS_TRUE(tx.try_emplace(i));
+    }
+    VERIFY_IS_FALSE(tx.try_emplace(4));
+
+    VERIFY_ARE_EQUAL(0, rx.try_pop());
+    VERIFY_IS_TRUE(tx.try_emplace(4));
+
+    std::array<int, 8> data{};
+    VERIFY_ARE_EQUAL(4u, rx.try_pop_n(data.begin(), data.size()).first);
+    for (auto i = 0; i < 4; ++i)
+    {
+        VERIFY_ARE_EQUAL(i + 1, data[i]);
+    }
+}
+
+void MPSCTests::DropProducersTest()
+{
+    auto [tx, rx] = til::mpsc::channel<std::unique_ptr<int>>(4);
+    auto tx2 = tx;
+
+    tx.emplace(std::make_unique<int>(1));
+    { auto _ = std::move(tx); }
+
+    // One producer is still alive.
+    tx2.emplace(std::make_unique<int>(2));
+    VERIFY_ARE_EQUAL(1, *rx.pop().value());
+
+    // Remaining items are still returned after all producers are gone.
+    { auto _ = std::move(tx2); }
+    VERIFY_ARE_EQUAL(2, *rx.pop().value());
+    VERIFY_IS_FALSE(rx.pop().has_value());
+}
+
+void MPSCTests::DropConsumerTest()
+{
+    auto [tx, rx] = til::mpsc::channel<int>(4);
+
+    VERIFY_IS_TRUE(tx.emplace(1));
+    { auto _ = std::move(rx); }
+    VERIFY_IS_FALSE(tx.emplace(2));
+    VERIFY_IS_FALSE(tx.try_emplace(3));
+}
+
+void MPSCTests::IntegrationTest()
+{
+    static constexpr auto producers = 4;
+    static constexpr auto count = 10000;
+
+    auto [tx, rx] = til::mpsc::channel<int>(7);
+    std::vector<std::thread> threads;
+
+    for (auto p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([tx, p]() {
+            for (auto i = 0; i < count; ++i)
+            {
+                tx.emplace(p * count + i);
+            }
+        });
+    }
+
+    { auto _ = std::move(tx); }
+
+    // The values of each producer must arrive in order.
+    std::array<int, producers> next{};
+    std::array<int, 5> buffer{};
+    auto received = 0;
+
+    for (;;)
+    {
+        const auto [n, ok] = rx.pop_n(buffer.begin(), buffer.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            const auto p = buffer[i] / count;
+            VERIFY_ARE_EQUAL(next[p], buffer[i] % count);
+            ++next[p];
+            ++received;
+        }
+        if (!ok)
+        {
+            break;
+        }
+    }
+
+    VERIFY_ARE_EQUAL(producers * count, received);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
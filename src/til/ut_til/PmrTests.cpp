@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class PmrTests
+{
+    TEST_CLASS(PmrTests);
+
+    TEST_METHOD(ArenaHonorsAlignment)
+    {
+        til::pmr::arena_resource arena{ 256 };
+
+        for (const size_t align : { 1, 2, 4, 8, 16, 64 })
+        {
+            const auto ptr = arena.allocate(3, align);
+            VERIFY_ARE_EQUAL(0u, reinterpret_cast<uintptr_t>(ptr) % align);
+        }
+    }
+
+    TEST_METHOD(ArenaReusesMemoryAfterReset)
+    {
+        til::pmr::arena_resource arena{ 256 };
+
+        const auto first = arena.allocate(16, 8);
+        arena.allocate(16, 8);
+        arena.reset();
+        VERIFY_ARE_EQUAL(first, arena.allocate(16, 8));
+    }
+
+    TEST_METHOD(ArenaGrowsBeyondBlockSize)
+    {
+        til::pmr::arena_resource arena{ 256 };
+        std::pmr::vector<int> vec{ &arena };
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            vec.emplace_back(i);
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            VERIFY_ARE_EQUAL(i, vec[i]);
+        }
+    }
+
+    TEST_METHOD(FrameScopesNest)
+    {
+        void* first;
+
+        {
+            const til::pmr::frame_scope outer;
+            first = til::pmr::get_frame_arena()->allocate(16, 8);
+
+            {
+                const til::pmr::frame_scope inner;
+            }
+
+            // The inner scope must not have reset the arena.
+            VERIFY_ARE_NOT_EQUAL(first, til::pmr::get_frame_arena()->allocate(16, 8));
+        }
+
+        const til::pmr::frame_scope scope;
+        VERIFY_ARE_EQUAL(first, til::pmr::get_frame_arena()->allocate(16, 8));
+    }
+};
@@ -378,6 +378,61 @@ class RunLengthEncodingTests
         }
     }
 
+    TEST_METHOD(ReplaceRuns)
+    {
+        using range_replacement = rle_vector::range_replacement;
+
+        struct TestCase
+        {
+            std::string_view source;
+            std::vector<range_replacement> replacements;
+            std::string_view expected;
+        };
+
+        const std::array<TestCase, 6> test_cases{
+            {
+                // no replacements
+                { "1|3 3|2", {}, "1|3 3|2" },
+                // single replacement
+                { "1|3 3|2", { { 1, 3, 4 } }, "1|4 4|2" },
+                // adjacent replacements
+                { "1|3 3|2|1 1 1|5 5", { { 0, 2, 6 }, { 2, 3, 7 }, { 3, 9, 8 } }, "6 6|7|8 8 8 8 8 8" },
+                // gaps between replacements, within runs
+                { "1|3 3|2|1 1 1|5 5", { { 2, 3, 6 }, { 4, 6, 7 }, { 8, 9, 6 } }, "1|3|6|2|7 7|1|5|6" },
+                // join with predecessor/successor runs and each other
+                { "1|3 3|2|1 1 1|5 5", { { 1, 2, 1 }, { 2, 4, 1 }, { 7, 8, 1 } }, "1 1 1 1 1 1 1 1|5" },
+                // end_index larger than size()
+                { "1|3 3|2", { { 0, 1, 2 }, { 2, 100, 2 } }, "2|3|2 2" },
+            }
+        };
+
+        auto idx = 0;
+
+        for (const auto& test_case : test_cases)
+        {
+            rle_vector rle{ rle_encode(test_case.source) };
+            rle.replace_runs(test_case.replacements);
+
+            VERIFY_ARE_EQUAL(
+                test_case.expected,
+                rle,
+                NoThrowString().Format(
+                    L"test case: %d\nsource:    %hs\nexpected:  %hs\nactual:    %s",
+                    idx,
+                    test_case.source.data(),
+                    test_case.expected.data(),
+                    rle.to_string().c_str()));
+            ++idx;
+        }
+
+        {
+            Log::Comment(L"Overlapping replacements must be rejected.");
+            rle_vector rle{ rle_encode("1|3 3|2") };
+            const std::array<range_replacement, 2> replacements{ { { 0, 2, 4 }, { 1, 3, 5 } } };
+            VERIFY_THROWS(rle.replace_runs(replacements), std::out_of_range);
+        }
+    }
+
     TEST_METHOD(ReplaceValues)
     {
         struct TestCase
@@ -56,6 +56,7 @@ class SPSCTests
     TEST_METHOD(DropEmptyTest);
     TEST_METHOD(DropSameRevolutionTest);
     TEST_METHOD(DropDifferentRevolutionTest);
+    TEST_METHOD(TryPopTest);
     TEST_METHOD(IntegrationTest);
 };
 
@@ -86,6 +87,7 @@ void SPSCTests::SmokeTest()
 
     // pop
     auto x = rx.pop();
+    auto y = rx.try_pop();
     rx.pop_n(til::spsc::block_initially, data.begin(), data.size());
     rx.pop_n(til::spsc::block_forever, data.begin(), data.size());
 }
@@ -185,6 +187,26 @@ void SPSCTests::DropDifferentRevolutionTest()
     VERIFY_ARE_EQUAL(counter, 8);
 }
 
+void SPSCTests::TryPopTest()
+{
+    auto [tx, rx] = til::spsc::channel<int>(4);
+
+    // An empty queue must not block.
+    VERIFY_IS_FALSE(rx.try_pop().has_value());
+
+    tx.emplace(1);
+    tx.emplace(2);
+    VERIFY_ARE_EQUAL(1, rx.try_pop().value());
+    VERIFY_ARE_EQUAL(2, rx.try_pop().value());
+    VERIFY_IS_FALSE(rx.try_pop().has_value());
+
+    // Remaining items are still returned after the producer is gone.
+    tx.emplace(3);
+    drop(tx);
+    VERIFY_ARE_EQUAL(3, rx.try_pop().value());
+    VERIFY_IS_FALSE(rx.try_pop().has_value());
+}
+
 void SPSCTests::IntegrationTest()
 {
     auto [tx, rx] = til::spsc::channel<int>(7);
@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+
+#include <til/shared_ring.h>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+namespace
+{
+    // Both endpoints live in the same process here, but they must not share the handles.
+    til::shared_ring::handles duplicate(const til::shared_ring::handles& h)
+    {
+        const auto process = GetCurrentProcess();
+        til::shared_ring::handles d;
+        THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(process, h.section.get(), process, d.section.addressof(), 0, FALSE, DUPLICATE_SAME_ACCESS));
+        THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(process, h.data.get(), process, d.data.addressof(), 0, FALSE, DUPLICATE_SAME_ACCESS));
+        THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(process, h.space.get(), process, d.space.addressof(), 0, FALSE, DUPLICATE_SAME_ACCESS));
+        return d;
+    }
+}
+
+class SharedRingTests
+{
+    BEGIN_TEST_CLASS(SharedRingTests)
+        TEST_CLASS_PROPERTY(L"TestTimeout", L"0:0:10") // 10s timeout
+    END_TEST_CLASS()
+
+    TEST_METHOD(SmokeTest);
+    TEST_METHOD(InvalidCapacityTest);
+    TEST_METHOD(DropConsumerTest);
+    TEST_METHOD(DropProducerTest);
+    TEST_METHOD(IntegrationTest);
+};
+
+void SharedRingTests::SmokeTest()
+{
+    auto h = til::shared_ring::create(16);
+    til::shared_ring::producer tx{ duplicate(h) };
+    til::shared_ring::consumer rx{ std::move(h) };
+
+    VERIFY_IS_TRUE(tx.write("hello"));
+
+    auto data = rx.read();
+    VERIFY_IS_TRUE(data == "hello");
+    rx.consume(3);
+
+    data = rx.read();
+    VERIFY_IS_TRUE(data == "lo");
+    rx.consume(2);
+
+    // This fills the ring entirely and wraps around its end,
+    // which read() returns as two contiguous pieces.
+    VERIFY_IS_TRUE(tx.write("0123456789abcdef"));
+
+    data = rx.read();
+    VERIFY_IS_TRUE(data == "0123456789a");
+    rx.consume(data.size());
+
+    data = rx.read();
+    VERIFY_IS_TRUE(data == "bcdef");
+    rx.consume(data.size());
+}
+
+void SharedRingTests::InvalidCapacityTest()
+{
+    VERIFY_THROWS(til::shared_ring::create(0), wil::ResultException);
+    VERIFY_THROWS(til::shared_ring::create(1000), wil::ResultException);
+}
+
+void SharedRingTests::DropConsumerTest()
+{
+    auto h = til::shared_ring::create(16);
+    til::shared_ring::producer tx{ duplicate(h) };
+    auto rx = std::make_unique<til::shared_ring::consumer>(std::move(h));
+
+    // The write doesn't fit into the ring and blocks until the consumer is gone.
+    std::thread t([&]() {
+        Sleep(50);
+        rx.reset();
+    });
+
+    VERIFY_IS_FALSE(tx.write(std::string(100, 'x')));
+    t.join();
+}
+
+void SharedRingTests::DropProducerTest()
+{
+    auto h = til::shared_ring::create(16);
+    auto tx = std::make_unique<til::shared_ring::producer>(duplicate(h));
+    til::shared_ring::consumer rx{ std::move(h) };
+
+    VERIFY_IS_TRUE(tx->write("abc"));
+    tx.reset();
+
+    // The consumer drains the ring before it reports that it's closed.
+    const auto data = rx.read();
+    VERIFY_IS_TRUE(data == "abc");
+    rx.consume(data.size());
+    VERIFY_IS_TRUE(rx.read().empty());
+}
+
+void SharedRingTests::IntegrationTest()
+{
+    static constexpr size_t total = 8 * 1024 * 1024;
+
+    auto h = til::shared_ring::create(4096);
+    auto tx = std::make_unique<til::shared_ring::producer>(duplicate(h));
+    til::shared_ring::consumer rx{ std::move(h) };
+
+    // The writes are of varying sizes, some of which are larger than the ring itself.
+    std::thread t([&]() {
+        std::string buffer;
+        size_t written = 0;
+        uint32_t seed = 1;
+
+        while (written < total)
+        {
+            seed = seed * 1103515245 + 12345;
+            const auto length = std::min<size_t>(1 + seed % 9000, total - written);
+
+            buffer.clear();
+            for (size_t i = 0; i < length; ++i)
+            {
+                buffer.push_back(static_cast<char>((written + i) * 7));
+            }
+
+            if (!tx->write(buffer))
+            {
+                break;
+            }
+            written += length;
+        }
+
+        tx.reset();
+    });
+
+    size_t read = 0;
+    auto valid = true;
+
+    for (;;)
+    {
+        const auto data = rx.read();
+        if (data.empty())
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            valid &= data[i] == static_cast<char>((read + i) * 7);
+        }
+
+        read += data.size();
+        rx.consume(data.size());
+    }
+
+    t.join();
+    VERIFY_IS_TRUE(valid);
+    VERIFY_ARE_EQUAL(total, read);
+}
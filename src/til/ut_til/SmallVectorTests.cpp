@@ -169,6 +169,23 @@ class SmallVectorTests
         v0.resize(10, 'z');
         VERIFY_ARE_EQUAL(v0.size(), 10u);
         VERIFY_ARE_EQUAL(v0.back(), 'z');
+        v0.resize_for_overwrite(11);
+        VERIFY_ARE_EQUAL(v0.size(), 11u);
+        VERIFY_ARE_EQUAL(v0[9], 'z');
+        v0.resize_for_overwrite(10);
+        VERIFY_ARE_EQUAL(v0.size(), 10u);
+        VERIFY_ARE_EQUAL(v0.back(), 'z');
+        size_t overwriteCount = 0;
+        v0.resize_and_overwrite(20, [&](char* data, size_t count) noexcept {
+            overwriteCount = count;
+            data[10] = 'y';
+            return size_t{ 11 };
+        });
+        VERIFY_ARE_EQUAL(overwriteCount, 20u);
+        VERIFY_ARE_EQUAL(v0.size(), 11u);
+        VERIFY_ARE_EQUAL(v0[9], 'z');
+        VERIFY_ARE_EQUAL(v0.back(), 'y');
+        v0.resize(10);
         VERIFY_IS_LESS_THAN_OR_EQUAL(v0.size(), v0.max_size());
 
         container* p_cont = &v0;
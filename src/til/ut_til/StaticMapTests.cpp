@@ -120,4 +120,50 @@ class StaticMapTests
         VERIFY_THROWS(unused = intIntMap[7], std::runtime_error);
 #pragma warning(pop)
     }
+
+    TEST_METHOD(PerfectHash)
+    {
+        static constexpr til::perfect_static_map stringIntMap{
+            std::pair{ "xylophones"sv, 100 },
+            std::pair{ "apples"sv, 200 },
+            std::pair{ "grapes"sv, 300 },
+            std::pair{ "pears"sv, 400 },
+            std::pair{ ""sv, 500 },
+        };
+
+        VERIFY_ARE_EQUAL(100, stringIntMap.at("xylophones"));
+        VERIFY_ARE_EQUAL(300, stringIntMap.at("grapes"));
+        VERIFY_ARE_EQUAL(400, stringIntMap.at("pears"));
+        VERIFY_ARE_EQUAL(200, stringIntMap.at("apples"));
+        VERIFY_ARE_EQUAL(500, stringIntMap.at(""));
+
+        // Unlike static_map, the pairs retain their original order.
+        VERIFY_IS_TRUE(stringIntMap.begin()->first == "xylophones"sv);
+        VERIFY_ARE_EQUAL(5u, stringIntMap.size());
+
+        int unused{};
+        VERIFY_ARE_EQUAL(stringIntMap.end(), stringIntMap.find("apple"));
+        VERIFY_THROWS(unused = stringIntMap.at("0_hello"), std::runtime_error);
+        VERIFY_THROWS(unused = stringIntMap.at("z_world"), std::runtime_error);
+    }
+
+    TEST_METHOD(PerfectHashManyKeys)
+    {
+        // Enough keys to result in buckets with more than 1 item and collisions between their slots.
+        static constexpr std::array<std::pair<std::wstring_view, int>, 40> pairs{ {
+            { L"a0", 0 }, { L"a1", 1 }, { L"a2", 2 }, { L"a3", 3 }, { L"a4", 4 }, { L"a5", 5 }, { L"a6", 6 }, { L"a7", 7 }, { L"a8", 8 }, { L"a9", 9 },
+            { L"b0", 10 }, { L"b1", 11 }, { L"b2", 12 }, { L"b3", 13 }, { L"b4", 14 }, { L"b5", 15 }, { L"b6", 16 }, { L"b7", 17 }, { L"b8", 18 }, { L"b9", 19 },
+            { L"c0", 20 }, { L"c1", 21 }, { L"c2", 22 }, { L"c3", 23 }, { L"c4", 24 }, { L"c5", 25 }, { L"c6", 26 }, { L"c7", 27 }, { L"c8", 28 }, { L"c9", 29 },
+            { L"d0", 30 }, { L"d1", 31 }, { L"d2", 32 }, { L"d3", 33 }, { L"d4", 34 }, { L"d5", 35 }, { L"d6", 36 }, { L"d7", 37 }, { L"d8", 38 }, { L"d9", 39 },
+        } };
+        static constexpr til::perfect_static_map map{ pairs };
+
+        for (const auto& [key, value] : pairs)
+        {
+            VERIFY_ARE_EQUAL(value, map.at(key));
+        }
+
+        VERIFY_ARE_EQUAL(map.end(), map.find(L"e0"));
+        VERIFY_ARE_EQUAL(map.end(), map.find(L"a"));
+    }
 };
@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+
+#include <til/ticket_lock.h>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TicketLockTests
+{
+    BEGIN_TEST_CLASS(TicketLockTests)
+        TEST_CLASS_PROPERTY(L"TestTimeout", L"0:0:10") // 10s timeout
+    END_TEST_CLASS()
+
+    TEST_METHOD(RecursiveShared);
+    TEST_METHOD(ConcurrentReaders);
+    TEST_METHOD(WriterExcludesReaders);
+};
+
+void TicketLockTests::RecursiveShared()
+{
+    til::recursive_ticket_lock lock;
+
+    // A thread may recursively lock in shared mode...
+    lock.lock_shared();
+    lock.lock_shared();
+    lock.unlock_shared();
+    lock.unlock_shared();
+
+    // ...and in shared mode while it holds the lock exclusively.
+    lock.lock();
+    lock.lock_shared();
+    VERIFY_ARE_EQUAL(2u, lock.recursion_depth());
+    lock.unlock_shared();
+    lock.unlock();
+
+    // This is here just to ensure that the lock is unlocked again.
+    VERIFY_IS_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+void TicketLockTests::ConcurrentReaders()
+{
+    til::recursive_ticket_lock lock;
+    std::atomic<int> readers{ 0 };
+
+    // Both readers only exit once they saw each other holding the lock.
+    const auto reader = [&]() {
+        std::shared_lock outer{ lock };
+        std::shared_lock inner{ lock };
+        readers.fetch_add(1);
+        while (readers.load() < 2)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    std::thread a{ reader };
+    std::thread b{ reader };
+    a.join();
+    b.join();
+
+    VERIFY_ARE_EQUAL(2, readers.load());
+}
+
+void TicketLockTests::WriterExcludesReaders()
+{
+    til::recursive_ticket_lock lock;
+    std::atomic<bool> done{ false };
+    int value = 0;
+
+    std::thread writer{ [&]() {
+        for (auto i = 0; i < 1000; ++i)
+        {
+            std::unique_lock outer{ lock };
+            std::unique_lock inner{ lock };
+            // Readers must never observe the odd intermediate value.
+            ++value;
+            ++value;
+        }
+        done.store(true);
+    } };
+
+    std::thread reader{ [&]() {
+        while (!done.load())
+        {
+            std::shared_lock outer{ lock };
+            std::shared_lock inner{ lock };
+            VERIFY_ARE_EQUAL(0, value % 2);
+        }
+    } };
+
+    writer.join();
+    reader.join();
+
+    VERIFY_ARE_EQUAL(2000, value);
+}
@@ -17,6 +17,7 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestAsciiRuns);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +192,57 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+// The ASCII fast path converts runs of ASCII itself and only passes the remaining text
+// to the platform functions. Runs of various lengths around the SIMD block size of 16
+// code units ensure that the two are stitched together correctly.
+void Utf8Utf16ConvertTests::TestAsciiRuns()
+{
+    std::wstring u16String{};
+    for (size_t run = 0; run < 40; ++run)
+    {
+        for (size_t i = 0; i < run; ++i)
+        {
+            u16String.push_back(gsl::narrow_cast<wchar_t>(L'!' + (i + run) % 90));
+        }
+        u16String.push_back(gsl::narrow_cast<wchar_t>(0x00f6U)); // LATIN SMALL LETTER O WITH DIAERESIS
+        u16String.append(run % 3, gsl::narrow_cast<wchar_t>(0x20acU)); // EURO SIGN
+        u16String.push_back(gsl::narrow_cast<wchar_t>(0xd853U)); // CJK UNIFIED IDEOGRAPH-24F5C (surrogate pair)
+        u16String.push_back(gsl::narrow_cast<wchar_t>(0xdf5cU));
+    }
+
+    const auto u16Length = gsl::narrow<int>(u16String.size());
+    std::string u8StringComp(u16String.size() * 3, '\0');
+    u8StringComp.resize(gsl::narrow_cast<size_t>(WideCharToMultiByte(CP_UTF8, 0, u16String.data(), u16Length, u8StringComp.data(), gsl::narrow<int>(u8StringComp.size()), nullptr, nullptr)));
+
+    std::string u8Out{};
+    VERIFY_ARE_EQUAL(S_OK, til::u16u8(u16String, u8Out));
+    VERIFY_ARE_EQUAL(u8StringComp, u8Out);
+
+    std::wstring u16Out{};
+    VERIFY_ARE_EQUAL(S_OK, til::u8u16(u8Out, u16Out));
+    VERIFY_ARE_EQUAL(u16String, u16Out);
+
+    // The same in chunks of unusual sizes, which split both types of runs and the code points.
+    for (const size_t chunkSize : { 7u, 16u, 33u })
+    {
+        til::u8state u8State{};
+        til::u16state u16State{};
+        std::wstring u16Chunked{};
+        std::string u8Chunked{};
+
+        for (size_t i = 0; i < u8StringComp.size(); i += chunkSize)
+        {
+            VERIFY_ARE_EQUAL(S_OK, til::u8u16(std::string_view{ u8StringComp }.substr(i, chunkSize), u16Out, u8State));
+            u16Chunked.append(u16Out);
+        }
+        for (size_t i = 0; i < u16String.size(); i += chunkSize)
+        {
+            VERIFY_ARE_EQUAL(S_OK, til::u16u8(std::wstring_view{ u16String }.substr(i, chunkSize), u8Out, u16State));
+            u8Chunked.append(u8Out);
+        }
+
+        VERIFY_ARE_EQUAL(u16String, u16Chunked);
+        VERIFY_ARE_EQUAL(u8StringComp, u8Chunked);
+    }
+}
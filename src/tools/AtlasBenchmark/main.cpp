@@ -0,0 +1,561 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Renders the contents of a TextBuffer with AtlasEngine into an offscreen texture and reports how
+// long each stage of a frame took on the CPU and the GPU. No window or swap chain is involved,
+// which makes it suitable for CI machines and for comparing screenshots between builds.
+//
+// Usage: AtlasBenchmark [--d2d] [--scenario ascii|colors|unicode] [--scroll]
+//                       [--size <columns>x<rows>] [--frames <count>] [--screenshot <path.png>]
+//        AtlasBenchmark --glyph-map
+//
+// --glyph-map doesn't render anything and instead compares the hashmaps in til/flat_set.h
+// with a distribution of glyph indices resembling that of BackendD3D's glyph caches.
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <LibraryIncludes.h>
+
+#include <d2d1_3.h>
+#include <d3d11_2.h>
+#include <dwrite_3.h>
+#include <dxgi1_3.h>
+
+#include "../../buffer/out/textBuffer.hpp"
+#include "../../renderer/atlas/AtlasEngine.h"
+#include "../../renderer/atlas/wic.h"
+#include "../../renderer/inc/DummyRenderer.hpp"
+
+#include <random>
+
+#include <til/flat_set.h>
+
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Render::Atlas;
+
+// A stand-in for BackendD3D::AtlasGlyphEntry. The padding gives it a similar size.
+struct GlyphSlot
+{
+    u16 glyphIndex = 0;
+    u16 padding[15]{};
+
+    explicit operator bool() const noexcept
+    {
+        return glyphIndex != 0;
+    }
+
+    bool operator==(u16 key) const noexcept
+    {
+        return glyphIndex == key;
+    }
+
+    GlyphSlot& operator=(u16 key) noexcept
+    {
+        glyphIndex = key;
+        return *this;
+    }
+};
+
+// Same as in BackendD3D.cpp: The flat sets use the topmost bits of the hash,
+// but std::hash for integers is usually just the identity function.
+template<>
+struct std::hash<u16>
+{
+    constexpr size_t operator()(u16 key) const noexcept
+    {
+        return til::flat_set_hash_integer(key);
+    }
+};
+
+template<>
+struct std::hash<GlyphSlot>
+{
+    constexpr size_t operator()(u16 key) const noexcept
+    {
+        return til::flat_set_hash_integer(key);
+    }
+
+    constexpr size_t operator()(const GlyphSlot& slot) const noexcept
+    {
+        return til::flat_set_hash_integer(slot.glyphIndex);
+    }
+};
+
+namespace
+{
+    enum class Scenario
+    {
+        Ascii,
+        Colors,
+        Unicode,
+    };
+
+    struct Options
+    {
+        Scenario scenario = Scenario::Ascii;
+        til::size cellCount{ 120, 30 };
+        int frames = 300;
+        bool d2d = false;
+        bool scroll = false;
+        bool glyphMap = false;
+        std::wstring screenshot;
+    };
+
+    // The samples of a single stage of the frame, in microseconds.
+    struct Stage
+    {
+        const wchar_t* name = nullptr;
+        std::vector<double> samples;
+
+        void print()
+        {
+            if (samples.empty())
+            {
+                wprintf(L"%-10s         n/a\n", name);
+                return;
+            }
+
+            std::ranges::sort(samples);
+            const auto average = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+            const auto median = samples[samples.size() / 2];
+            const auto p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+            wprintf(L"%-10s avg %8.1fus  median %8.1fus  p95 %8.1fus  max %8.1fus\n", name, average, median, p95, samples.back());
+        }
+    };
+
+    // The GPU time is measured with a pair of timestamp queries around AtlasEngine::Present().
+    // Waiting for their results every frame serializes the CPU and GPU, which would be unacceptable
+    // for a real renderer, but makes sure that the results belong to the frame that was just drawn.
+    struct GpuTimer
+    {
+        wil::com_ptr<ID3D11DeviceContext> context;
+        wil::com_ptr<ID3D11Query> disjoint;
+        wil::com_ptr<ID3D11Query> begin;
+        wil::com_ptr<ID3D11Query> end;
+
+        explicit operator bool() const noexcept
+        {
+            return context.get() != nullptr;
+        }
+
+        void create(ID3D11Texture2D* target)
+        {
+            wil::com_ptr<ID3D11Device> device;
+            target->GetDevice(device.addressof());
+            device->GetImmediateContext(context.addressof());
+
+            D3D11_QUERY_DESC desc{ .Query = D3D11_QUERY_TIMESTAMP_DISJOINT };
+            THROW_IF_FAILED(device->CreateQuery(&desc, disjoint.addressof()));
+            desc.Query = D3D11_QUERY_TIMESTAMP;
+            THROW_IF_FAILED(device->CreateQuery(&desc, begin.addressof()));
+            THROW_IF_FAILED(device->CreateQuery(&desc, end.addressof()));
+        }
+
+        template<typename T>
+        T wait(ID3D11Query* query) const
+        {
+            T data{};
+            while (context->GetData(query, &data, sizeof(data), 0) == S_FALSE)
+            {
+                YieldProcessor();
+            }
+            return data;
+        }
+
+        // Returns the time between the two timestamps in microseconds, or a negative value if the
+        // GPU clock changed its frequency in the meantime and the timestamps are unreliable.
+        double measure() const
+        {
+            const auto freq = wait<D3D11_QUERY_DATA_TIMESTAMP_DISJOINT>(disjoint.get());
+            const auto t0 = wait<UINT64>(begin.get());
+            const auto t1 = wait<UINT64>(end.get());
+            return freq.Disjoint ? -1.0 : static_cast<double>(t1 - t0) * 1e6 / static_cast<double>(freq.Frequency);
+        }
+    };
+
+    void printUsage()
+    {
+        wprintf(L"Usage: AtlasBenchmark [--d2d] [--scenario ascii|colors|unicode] [--scroll]\n"
+                L"                      [--size <columns>x<rows>] [--frames <count>] [--screenshot <path.png>]\n"
+                L"       AtlasBenchmark --glyph-map\n");
+    }
+
+    bool parseOptions(int argc, wchar_t* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::wstring_view arg{ argv[i] };
+            const auto hasValue = i + 1 < argc;
+
+            if (arg == L"--d2d")
+            {
+                options.d2d = true;
+            }
+            else if (arg == L"--glyph-map")
+            {
+                options.glyphMap = true;
+            }
+            else if (arg == L"--scroll")
+            {
+                options.scroll = true;
+            }
+            else if (arg == L"--scenario" && hasValue)
+            {
+                const std::wstring_view value{ argv[++i] };
+                if (value == L"ascii")
+                {
+                    options.scenario = Scenario::Ascii;
+                }
+                else if (value == L"colors")
+                {
+                    options.scenario = Scenario::Colors;
+                }
+                else if (value == L"unicode")
+                {
+                    options.scenario = Scenario::Unicode;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--size" && hasValue)
+            {
+                if (swscanf_s(argv[++i], L"%dx%d", &options.cellCount.width, &options.cellCount.height) != 2 ||
+                    options.cellCount.width <= 0 || options.cellCount.height <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--frames" && hasValue)
+            {
+                options.frames = _wtoi(argv[++i]);
+                if (options.frames <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--screenshot" && hasValue)
+            {
+                options.screenshot = argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Fills the buffer with the text of the given scenario. Each line is slightly different,
+    // so that scrolling through the buffer doesn't only hit the engine's shaping cache.
+    void fillBuffer(TextBuffer& buffer, const Scenario scenario)
+    {
+        static constexpr std::array asciiLines{
+            L"    for (auto it = rows.begin(); it != rows.end(); ++it) { total += it->size(); }",
+            L"drwxr-xr-x  2 user group  4096 Jan  1 00:00 src/renderer/atlas",
+            L"[  OK  ] Started Daily Cleanup of Temporary Directories.",
+            L"The quick brown fox jumps over the lazy dog. 0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+        };
+        static constexpr std::array unicodeLines{
+            L"日本語のテキストと English text が混在している行です。",
+            L"한국어 텍스트 — Ελληνικά — Русский текст — ไทย",
+            L"Emoji 😀🎉👩‍👩‍👧‍👦🏳️‍🌈 and combining marks: e\u0301 a\u0308 n\u0303",
+            L"Box drawing ┌─┬─┐ │ │ │ ├─┼─┤ └─┴─┘ ░▒▓█ and math ∑∫√∞≠≤≥",
+        };
+
+        const auto size = buffer.GetSize().Dimensions();
+
+        for (til::CoordType y = 0; y < size.height; ++y)
+        {
+            const auto& lines = scenario == Scenario::Unicode ? unicodeLines : asciiLines;
+            wchar_t lineNumber[16];
+            swprintf_s(lineNumber, L"%6d ", y);
+            const auto text = std::wstring{ lineNumber } + lines[y % lines.size()];
+            std::wstring_view remaining{ text };
+            til::CoordType column = 0;
+            int segment = 0;
+
+            while (!remaining.empty() && column < size.width)
+            {
+                TextAttribute attributes;
+                std::wstring_view chunk = remaining;
+
+                if (scenario == Scenario::Colors)
+                {
+                    // Every word gets its own colors, which splits the rows into many short runs.
+                    const auto space = remaining.find(L' ', 1);
+                    chunk = remaining.substr(0, space == std::wstring_view::npos ? remaining.size() : space);
+                    attributes.SetIndexedForeground256(gsl::narrow_cast<BYTE>(16 + (y * 7 + segment * 13) % 216));
+                    attributes.SetIndexedBackground256(gsl::narrow_cast<BYTE>(232 + (y + segment) % 24));
+                    ++segment;
+                }
+
+                RowWriteState state{
+                    .text = chunk,
+                    .columnBegin = column,
+                    .columnLimit = size.width,
+                };
+                buffer.WriteLine(y, false, attributes, state);
+
+                remaining.remove_prefix(chunk.size() - state.text.size());
+                column = state.columnEnd;
+
+                if (!state.text.empty())
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    void run(const Options& options)
+    {
+        // The fixture contains a couple screens worth of rows, which the viewport scrolls through.
+        const til::size bufferSize{ options.cellCount.width, options.cellCount.height * 4 };
+        const auto maxTop = bufferSize.height - options.cellCount.height;
+
+        DummyRenderer renderer;
+        TextBuffer buffer{ bufferSize, TextAttribute{}, 0, false, renderer };
+        fillBuffer(buffer, options.scenario);
+
+        AtlasEngine engine;
+        PerfCounters counters;
+        engine.SetOffscreen(true);
+        engine.SetForceD2DMode(options.d2d);
+        engine.SetPerfCounters(&counters);
+        THROW_IF_FAILED(engine.UpdateDpi(USER_DEFAULT_SCREEN_DPI));
+
+        FontInfoDesired fontInfoDesired{ L"Cascadia Mono", 0, DWRITE_FONT_WEIGHT_NORMAL, 12.0f, CP_UTF8 };
+        FontInfo fontInfo{ L"", 0, 0, {}, 0 };
+        THROW_IF_FAILED(engine.UpdateFont(fontInfoDesired, fontInfo));
+
+        const auto cellSize = fontInfo.GetSize();
+        THROW_IF_FAILED(engine.SetWindowSize({ options.cellCount.width * cellSize.width, options.cellCount.height * cellSize.height }));
+        THROW_IF_FAILED(engine.UpdateViewport({ 0, 0, options.cellCount.width - 1, options.cellCount.height - 1 }));
+
+        Stage paint{ L"paint" };
+        Stage shaping{ L"shaping" };
+        Stage render{ L"render" };
+        Stage present{ L"present" };
+        Stage gpu{ L"gpu" };
+        GpuTimer gpuTimer;
+
+        // The first frame creates the device, the glyph atlas, etc., which is reported separately.
+        double firstFrame = 0;
+
+        for (int frame = 0; frame <= options.frames; ++frame)
+        {
+            const auto top = frame % (maxTop + 1);
+
+            if (options.scroll && top != 0)
+            {
+                const til::point delta{ 0, -1 };
+                const til::rect lastRow{ 0, options.cellCount.height - 1, options.cellCount.width, options.cellCount.height };
+                THROW_IF_FAILED(engine.InvalidateScroll(&delta));
+                THROW_IF_FAILED(engine.Invalidate(&lastRow));
+            }
+            else
+            {
+                THROW_IF_FAILED(engine.InvalidateAll());
+            }
+
+            const auto before = counters.Take();
+            const auto t0 = std::chrono::steady_clock::now();
+
+            THROW_IF_FAILED(engine.StartPaint());
+
+            std::span<const til::rect> dirtyArea;
+            THROW_IF_FAILED(engine.GetDirtyArea(dirtyArea));
+
+            for (const auto& rect : dirtyArea)
+            {
+                for (auto y = std::max(0, rect.top); y < std::min(rect.bottom, options.cellCount.height); ++y)
+                {
+                    const BufferRowInfo info{
+                        .row = &buffer.GetRowByOffset(top + y),
+                        .renderSettings = &renderer._renderSettings,
+                        .targetRow = y,
+                        .columnBegin = 0,
+                        .columnEnd = options.cellCount.width,
+                    };
+                    THROW_IF_FAILED(engine.PaintBufferRow(info));
+                }
+            }
+
+            THROW_IF_FAILED(engine.EndPaint());
+            const auto t1 = std::chrono::steady_clock::now();
+
+            if (gpuTimer)
+            {
+                gpuTimer.context->Begin(gpuTimer.disjoint.get());
+                gpuTimer.context->End(gpuTimer.begin.get());
+            }
+
+            THROW_IF_FAILED(engine.Present());
+
+            if (gpuTimer)
+            {
+                gpuTimer.context->End(gpuTimer.end.get());
+                gpuTimer.context->End(gpuTimer.disjoint.get());
+            }
+
+            const auto t2 = std::chrono::steady_clock::now();
+            const auto after = counters.Take();
+
+            const auto micros = [](auto duration) {
+                return std::chrono::duration<double, std::micro>(duration).count();
+            };
+
+            if (frame == 0)
+            {
+                firstFrame = micros(t2 - t0);
+                gpuTimer.create(engine.GetOffscreenTarget().get());
+                continue;
+            }
+
+            paint.samples.emplace_back(micros(t1 - t0));
+            shaping.samples.emplace_back(static_cast<double>(after.shapingMicroseconds - before.shapingMicroseconds));
+            render.samples.emplace_back(static_cast<double>(after.renderMicroseconds - before.renderMicroseconds));
+            present.samples.emplace_back(micros(t2 - t1));
+
+            if (const auto time = gpuTimer.measure(); time >= 0)
+            {
+                gpu.samples.emplace_back(time);
+            }
+        }
+
+        wprintf(L"backend:   %s\n", options.d2d ? L"BackendD2D" : L"BackendD3D");
+        wprintf(L"size:      %dx%d cells, %dx%d px\n", options.cellCount.width, options.cellCount.height, options.cellCount.width * cellSize.width, options.cellCount.height * cellSize.height);
+        wprintf(L"frames:    %d (+1 warm-up frame, %.1fus)\n", options.frames, firstFrame);
+        paint.print();
+        shaping.print();
+        render.print();
+        present.print();
+        gpu.print();
+
+        if (!options.screenshot.empty())
+        {
+            SaveTextureToPNG(gpuTimer.context.get(), engine.GetOffscreenTarget().get(), USER_DEFAULT_SCREEN_DPI, options.screenshot.c_str());
+            wprintf(L"saved:     %s\n", options.screenshot.c_str());
+        }
+    }
+
+    // Returns the average time per lookup in nanoseconds.
+    template<typename Set>
+    double benchmarkGlyphMap(const std::vector<u16>& inserts, const std::vector<u16>& lookups, size_t& found)
+    {
+        static constexpr int rounds = 20;
+        const auto t0 = std::chrono::steady_clock::now();
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            Set set;
+            for (const auto idx : inserts)
+            {
+                set.insert(idx);
+            }
+            for (const auto idx : lookups)
+            {
+                found += set.lookup(idx) != nullptr;
+            }
+        }
+
+        const auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / (static_cast<double>(rounds) * lookups.size());
+    }
+
+    // The glyph indices of a font are roughly ordered by their codepoint. The distribution below consists of:
+    // * printable ASCII, which is by far the most common text and skewed towards lowercase letters and spaces
+    // * the ~160 box drawing and block element glyphs used by TUIs
+    // * a few thousand CJK glyphs spread across a range of 20k glyph indices
+    // The box glyphs are additionally queried with mostly unrelated glyph indices, because that's
+    // how BackendD3D's boxGlyphs map is used: It's consulted for every glyph that gets rasterized.
+    void runGlyphMap()
+    {
+        std::mt19937 rng{ 1234 };
+
+        std::vector<u16> glyphs;
+        for (u16 i = 3; i < 98; ++i)
+        {
+            glyphs.emplace_back(i);
+        }
+        for (u16 i = 0; i < 160; ++i)
+        {
+            glyphs.emplace_back(static_cast<u16>(1000 + i));
+        }
+        for (int i = 0; i < 3000; ++i)
+        {
+            glyphs.emplace_back(static_cast<u16>(5000 + rng() % 20000));
+        }
+
+        std::vector<u16> glyphLookups;
+        std::discrete_distribution<int> category{ 70, 10, 20 };
+        for (int i = 0; i < 1000000; ++i)
+        {
+            switch (category(rng))
+            {
+            case 0:
+            {
+                // A cubic distribution roughly approximates the skew of letter frequencies.
+                const auto x = std::uniform_real_distribution<double>{}(rng);
+                glyphLookups.emplace_back(static_cast<u16>(3 + x * x * x * 95));
+                break;
+            }
+            case 1:
+                glyphLookups.emplace_back(static_cast<u16>(1000 + rng() % 160));
+                break;
+            default:
+                glyphLookups.emplace_back(static_cast<u16>(5000 + rng() % 20000));
+                break;
+            }
+        }
+
+        const std::vector<u16> boxGlyphs{ glyphs.begin() + 95, glyphs.begin() + 95 + 160 };
+        std::vector<u16> boxLookups;
+        for (int i = 0; i < 1000000; ++i)
+        {
+            boxLookups.emplace_back(rng() % 10 == 0 ? boxGlyphs[rng() % boxGlyphs.size()] : static_cast<u16>(3 + rng() % 25000));
+        }
+
+        size_t found = 0;
+        wprintf(L"glyphs     linear_flat_set %6.2fns  swiss_flat_set %6.2fns\n",
+                benchmarkGlyphMap<til::linear_flat_set<GlyphSlot>>(glyphs, glyphLookups, found),
+                benchmarkGlyphMap<til::swiss_flat_set<GlyphSlot>>(glyphs, glyphLookups, found));
+        wprintf(L"boxGlyphs  linear_flat_set %6.2fns  swiss_flat_set %6.2fns\n",
+                benchmarkGlyphMap<til::linear_flat_set<u16, 2, 2>>(boxGlyphs, boxLookups, found),
+                benchmarkGlyphMap<til::swiss_flat_set<u16>>(boxGlyphs, boxLookups, found));
+        // Prevents the compiler from optimizing the lookups away.
+        wprintf(L"(%zu hits)\n", found);
+    }
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        if (options.glyphMap)
+        {
+            runGlyphMap();
+            return 0;
+        }
+
+        run(options);
+        return 0;
+    }
+    catch (...)
+    {
+        const auto hr = wil::ResultFromCaughtException();
+        wprintf(L"failed with 0x%08x\n", static_cast<unsigned int>(hr));
+        return 1;
+    }
+}
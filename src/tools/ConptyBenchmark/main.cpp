@@ -0,0 +1,571 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Measures how fast a ConPTY ingests VT output. For every workload this spawns a copy of itself
+// inside a headless pseudoconsole, which writes a deterministic VT stream in fixed-size chunks
+// while the parent drains the pseudoconsole's output pipe. The results are printed as JSON to
+// stdout, so that runs of different builds can be compared by a script. Progress goes to stderr.
+//
+// Usage: ConptyBenchmark [--workload ascii|sgr|tui|unicode|hyperlinks|all] [--size <columns>x<rows>]
+//                        [--bytes <count>] [--chunk <bytes>] [--conpty <path to conpty.dll>]
+//
+// Without --conpty the inbox ConPTY from kernel32 is used. Point it at the conpty.dll of a build
+// to measure the OpenConsole.exe next to it instead.
+//
+// "seconds" is the time the child spent writing, which is bounded by how fast the console parses
+// and stores the text. "drainSeconds" additionally includes the time until the pseudoconsole
+// flushed its last byte of output. Latencies are those of the individual WriteFile calls.
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <LibraryIncludes.h>
+
+#include <random>
+#include <thread>
+
+namespace
+{
+    using CreatePseudoConsoleFn = HRESULT(WINAPI*)(COORD, HANDLE, HANDLE, DWORD, HPCON*);
+    using ClosePseudoConsoleFn = void(WINAPI*)(HPCON);
+
+    constexpr std::array workloadNames{ "ascii", "sgr", "tui", "unicode", "hyperlinks" };
+
+    struct Options
+    {
+        std::vector<std::string_view> workloads;
+        til::size cellCount{ 120, 30 };
+        size_t bytes = 16 * 1024 * 1024;
+        size_t chunk = 4096;
+        std::wstring conpty;
+    };
+
+    struct Result
+    {
+        std::string_view name;
+        uint64_t inputBytes = 0;
+        uint64_t outputBytes = 0;
+        double seconds = 0;
+        double drainSeconds = 0;
+        // From CreatePseudoConsole() until the first output arrived, which covers the startup of OpenConsole.
+        double firstOutputSeconds = 0;
+        std::vector<double> latencies; // in microseconds
+    };
+
+    double now() noexcept
+    {
+        static const auto frequency = [] {
+            LARGE_INTEGER li;
+            QueryPerformanceFrequency(&li);
+            return static_cast<double>(li.QuadPart);
+        }();
+        LARGE_INTEGER li;
+        QueryPerformanceCounter(&li);
+        return static_cast<double>(li.QuadPart) / frequency;
+    }
+
+    void appendUtf8(std::string& out, uint32_t ch)
+    {
+        if (ch < 0x80)
+        {
+            out.push_back(static_cast<char>(ch));
+        }
+        else if (ch < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (ch >> 6)));
+            out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+        }
+        else if (ch < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (ch >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (ch >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((ch >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+        }
+    }
+
+    void appendAsciiText(std::string& out, std::mt19937& rng, til::CoordType count)
+    {
+        std::uniform_int_distribution<int> printable{ 0x21, 0x7E };
+        for (til::CoordType i = 0; i < count; ++i)
+        {
+            // Roughly every 8th character is a space, similar to prose or source code.
+            out.push_back((rng() & 7) == 0 ? ' ' : static_cast<char>(printable(rng)));
+        }
+    }
+
+    // The workloads are generated with a fixed seed, so that every run writes the exact same bytes.
+    std::string generateWorkload(std::string_view name, til::size cellCount, size_t bytes)
+    {
+        std::mt19937 rng{ 0x5EED };
+        std::string out;
+        out.reserve(bytes + 4096);
+
+        if (name == "ascii")
+        {
+            // Plain lines of varying length that scroll the buffer, like `type` on a large log file.
+            std::uniform_int_distribution<til::CoordType> length{ 0, cellCount.width - 1 };
+            while (out.size() < bytes)
+            {
+                appendAsciiText(out, rng, length(rng));
+                out.append("\r\n");
+            }
+        }
+        else if (name == "sgr")
+        {
+            // Every few cells change the colors, alternating between indexed and RGB colors.
+            std::uniform_int_distribution<int> run{ 1, 8 };
+            std::uniform_int_distribution<int> component{ 0, 255 };
+            char buffer[64];
+            while (out.size() < bytes)
+            {
+                for (til::CoordType x = 0; x < cellCount.width;)
+                {
+                    if (rng() & 1)
+                    {
+                        sprintf_s(buffer, "\x1b[38;5;%dm", component(rng));
+                    }
+                    else
+                    {
+                        sprintf_s(buffer, "\x1b[1;48;2;%d;%d;%dm", component(rng), component(rng), component(rng));
+                    }
+                    out.append(buffer);
+
+                    const auto count = std::min(run(rng), cellCount.width - x);
+                    appendAsciiText(out, rng, count);
+                    x += count;
+                }
+                out.append("\x1b[m\r\n");
+            }
+        }
+        else if (name == "tui")
+        {
+            // A full-screen application in the alternate buffer: every 8th frame is a complete redraw,
+            // the others update a handful of cursor-addressed spans, like a text editor or `htop`.
+            std::uniform_int_distribution<til::CoordType> row{ 2, std::max(2, cellCount.height - 1) };
+            std::uniform_int_distribution<til::CoordType> column{ 1, cellCount.width };
+            std::uniform_int_distribution<int> color{ 0, 15 };
+            char buffer[64];
+            out.append("\x1b[?1049h\x1b[?25l");
+            for (uint32_t frame = 0; out.size() < bytes; ++frame)
+            {
+                if ((frame & 7) == 0)
+                {
+                    const auto length = sprintf_s(buffer, "\x1b[H\x1b[7m frame %u", frame) - 7;
+                    out.append(buffer);
+                    out.append(std::max(0, cellCount.width - length), ' ');
+                    out.append("\x1b[m");
+                    for (til::CoordType y = 2; y < cellCount.height; ++y)
+                    {
+                        sprintf_s(buffer, "\x1b[%d;1H\x1b[38;5;%dm", y, color(rng));
+                        out.append(buffer);
+                        appendAsciiText(out, rng, cellCount.width / 2);
+                        out.append("\x1b[K");
+                    }
+                    sprintf_s(buffer, "\x1b[%d;1H\x1b[30;47m", cellCount.height);
+                    out.append(buffer);
+                    appendAsciiText(out, rng, cellCount.width);
+                    out.append("\x1b[m");
+                }
+                else
+                {
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        const auto x = column(rng);
+                        sprintf_s(buffer, "\x1b[%d;%dH\x1b[38;5;%dm", row(rng), x, color(rng));
+                        out.append(buffer);
+                        appendAsciiText(out, rng, std::min<til::CoordType>(16, cellCount.width - x + 1));
+                    }
+                }
+            }
+            out.append("\x1b[m\x1b[?25h\x1b[?1049l");
+        }
+        else if (name == "unicode")
+        {
+            // A mix of wide CJK ideographs, emoji (surrogate pairs in UTF-16), and combining marks.
+            std::uniform_int_distribution<uint32_t> cjk{ 0x4E00, 0x9FFF };
+            std::uniform_int_distribution<uint32_t> emoji{ 0x1F600, 0x1F64F };
+            std::uniform_int_distribution<uint32_t> latin{ 0x61, 0x7A };
+            std::uniform_int_distribution<uint32_t> combining{ 0x0300, 0x036F };
+            while (out.size() < bytes)
+            {
+                for (til::CoordType x = 0; x + 2 <= cellCount.width;)
+                {
+                    switch (rng() & 3)
+                    {
+                    case 0:
+                        appendUtf8(out, emoji(rng));
+                        x += 2;
+                        break;
+                    case 1:
+                        appendUtf8(out, latin(rng));
+                        appendUtf8(out, combining(rng));
+                        x += 1;
+                        break;
+                    default:
+                        appendUtf8(out, cjk(rng));
+                        x += 2;
+                        break;
+                    }
+                }
+                out.append("\r\n");
+            }
+        }
+        else if (name == "hyperlinks")
+        {
+            // OSC 8 hyperlinks with unique IDs and URIs, like the output of `ls --hyperlink`.
+            std::uniform_int_distribution<til::CoordType> length{ 4, 24 };
+            char buffer[128];
+            for (uint32_t id = 0; out.size() < bytes; ++id)
+            {
+                sprintf_s(buffer, "\x1b]8;id=%u;https://example.com/file/%u\x1b\\", id, id);
+                out.append(buffer);
+                appendAsciiText(out, rng, length(rng));
+                out.append("\x1b]8;;\x1b\\");
+                out.append((id & 3) == 3 ? "\r\n" : " ");
+            }
+        }
+
+        return out;
+    }
+
+    void printUsage()
+    {
+        fwprintf(stderr,
+                 L"Usage: ConptyBenchmark [--workload ascii|sgr|tui|unicode|hyperlinks|all] [--size <columns>x<rows>]\n"
+                 L"                       [--bytes <count>] [--chunk <bytes>] [--conpty <path to conpty.dll>]\n");
+    }
+
+    std::optional<std::string_view> parseWorkload(std::wstring_view value)
+    {
+        for (const auto name : workloadNames)
+        {
+            if (value == til::u8u16(name))
+            {
+                return name;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool parseOptions(int argc, wchar_t* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::wstring_view arg{ argv[i] };
+            const auto hasValue = i + 1 < argc;
+
+            if (arg == L"--workload" && hasValue)
+            {
+                const std::wstring_view value{ argv[++i] };
+                if (value == L"all")
+                {
+                    options.workloads.assign(workloadNames.begin(), workloadNames.end());
+                }
+                else if (const auto name = parseWorkload(value))
+                {
+                    options.workloads.emplace_back(*name);
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--size" && hasValue)
+            {
+                if (swscanf_s(argv[++i], L"%dx%d", &options.cellCount.width, &options.cellCount.height) != 2 ||
+                    options.cellCount.width < 16 || options.cellCount.width > 32767 ||
+                    options.cellCount.height < 4 || options.cellCount.height > 32767)
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--bytes" && hasValue)
+            {
+                options.bytes = wcstoull(argv[++i], nullptr, 10);
+                if (options.bytes == 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--chunk" && hasValue)
+            {
+                options.chunk = wcstoull(argv[++i], nullptr, 10);
+                if (options.chunk == 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == L"--conpty" && hasValue)
+            {
+                options.conpty = argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (options.workloads.empty())
+        {
+            options.workloads.assign(workloadNames.begin(), workloadNames.end());
+        }
+        return true;
+    }
+
+    // Runs inside the pseudoconsole. Writes the workload to the console and stores the total byte
+    // count followed by the latency of each write (as doubles, in microseconds) in the stats file.
+    int runChild(std::string_view name, til::size cellCount, size_t bytes, size_t chunk, const wchar_t* statsPath)
+    {
+        const auto output = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        THROW_IF_WIN32_BOOL_FALSE(GetConsoleMode(output, &mode));
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN));
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleOutputCP(CP_UTF8));
+
+        const auto data = generateWorkload(name, cellCount, bytes);
+        std::vector<double> latencies;
+        latencies.reserve(data.size() / chunk + 1);
+
+        // Chunks may split UTF-8 sequences and escape sequences, just like a real application's writes.
+        for (size_t offset = 0; offset < data.size(); offset += chunk)
+        {
+            const auto count = gsl::narrow_cast<DWORD>(std::min(chunk, data.size() - offset));
+            DWORD written = 0;
+            const auto start = now();
+            THROW_IF_WIN32_BOOL_FALSE(WriteFile(output, data.data() + offset, count, &written, nullptr));
+            latencies.emplace_back((now() - start) * 1e6);
+        }
+
+        const wil::unique_hfile stats{ CreateFileW(statsPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!stats);
+        const uint64_t total = data.size();
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(stats.get(), &total, sizeof(total), &written, nullptr));
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(stats.get(), latencies.data(), gsl::narrow<DWORD>(latencies.size() * sizeof(double)), &written, nullptr));
+        return 0;
+    }
+
+    void readStats(const wchar_t* statsPath, Result& result)
+    {
+        const wil::unique_hfile stats{ CreateFileW(statsPath, GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_FLAG_DELETE_ON_CLOSE, nullptr) };
+        THROW_LAST_ERROR_IF(!stats);
+
+        LARGE_INTEGER size;
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(stats.get(), &size));
+        THROW_HR_IF(E_UNEXPECTED, size.QuadPart < static_cast<LONGLONG>(sizeof(uint64_t)));
+
+        DWORD read = 0;
+        THROW_IF_WIN32_BOOL_FALSE(ReadFile(stats.get(), &result.inputBytes, sizeof(result.inputBytes), &read, nullptr));
+        result.latencies.resize(static_cast<size_t>(size.QuadPart - sizeof(uint64_t)) / sizeof(double));
+        THROW_IF_WIN32_BOOL_FALSE(ReadFile(stats.get(), result.latencies.data(), gsl::narrow<DWORD>(result.latencies.size() * sizeof(double)), &read, nullptr));
+    }
+
+    Result runWorkload(const Options& options, std::string_view name, CreatePseudoConsoleFn createPseudoConsole, ClosePseudoConsoleFn closePseudoConsole)
+    {
+        Result result;
+        result.name = name;
+
+        wchar_t tempPath[MAX_PATH];
+        wchar_t statsPath[MAX_PATH];
+        THROW_LAST_ERROR_IF(!GetTempPathW(MAX_PATH, &tempPath[0]));
+        THROW_LAST_ERROR_IF(!GetTempFileNameW(&tempPath[0], L"cpb", 0, &statsPath[0]));
+
+        wil::unique_hfile inputRead, inputWrite, outputRead, outputWrite;
+        THROW_IF_WIN32_BOOL_FALSE(CreatePipe(inputRead.addressof(), inputWrite.addressof(), nullptr, 0));
+        THROW_IF_WIN32_BOOL_FALSE(CreatePipe(outputRead.addressof(), outputWrite.addressof(), nullptr, 1024 * 1024));
+
+        HPCON hpc = nullptr;
+        const COORD size{ gsl::narrow_cast<SHORT>(options.cellCount.width), gsl::narrow_cast<SHORT>(options.cellCount.height) };
+        const auto createStart = now();
+        THROW_IF_FAILED(createPseudoConsole(size, inputRead.get(), outputWrite.get(), 0, &hpc));
+        const auto closePseudoConsoleOnExit = wil::scope_exit([&]() noexcept {
+            if (hpc)
+            {
+                closePseudoConsole(hpc);
+            }
+        });
+        // The pseudoconsole holds its own references. Closing ours ensures
+        // that ReadFile() fails once the pseudoconsole has been closed.
+        inputRead.reset();
+        outputWrite.reset();
+
+        double drainEnd = 0;
+        double firstOutput = 0;
+        std::thread reader{ [&]() noexcept {
+            auto buffer = std::make_unique<char[]>(128 * 1024);
+            DWORD read = 0;
+            while (ReadFile(outputRead.get(), buffer.get(), 128 * 1024, &read, nullptr) && read)
+            {
+                drainEnd = now();
+                if (!result.outputBytes)
+                {
+                    firstOutput = drainEnd;
+                }
+                result.outputBytes += read;
+            }
+        } };
+        auto joinReaderOnExit = wil::scope_exit([&]() noexcept {
+            if (hpc)
+            {
+                closePseudoConsole(std::exchange(hpc, nullptr));
+            }
+            reader.join();
+        });
+
+        SIZE_T attributeListSize = 0;
+        InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeListSize);
+        const auto attributeList = std::make_unique<std::byte[]>(attributeListSize);
+        const auto attributes = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeList.get());
+        THROW_IF_WIN32_BOOL_FALSE(InitializeProcThreadAttributeList(attributes, 1, 0, &attributeListSize));
+        const auto deleteAttributesOnExit = wil::scope_exit([&]() noexcept {
+            DeleteProcThreadAttributeList(attributes);
+        });
+        THROW_IF_WIN32_BOOL_FALSE(UpdateProcThreadAttribute(attributes, 0, PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE, hpc, sizeof(hpc), nullptr, nullptr));
+
+        // Without STARTF_USESTDHANDLES the child would inherit our redirected stdout
+        // instead of being connected to the pseudoconsole.
+        STARTUPINFOEXW si{};
+        si.StartupInfo.cb = sizeof(si);
+        si.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+        si.lpAttributeList = attributes;
+
+        const auto self = wil::GetModuleFileNameW<std::wstring>(nullptr);
+        auto commandLine = fmt::format(FMT_COMPILE(L"\"{}\" --child {} {} {} {} {} \"{}\""),
+                                       self,
+                                       til::u8u16(name),
+                                       options.cellCount.width,
+                                       options.cellCount.height,
+                                       options.bytes,
+                                       options.chunk,
+                                       &statsPath[0]);
+
+        wil::unique_process_information pi;
+        const auto start = now();
+        THROW_IF_WIN32_BOOL_FALSE(CreateProcessW(self.c_str(), commandLine.data(), nullptr, nullptr, FALSE, EXTENDED_STARTUPINFO_PRESENT, nullptr, nullptr, &si.StartupInfo, &pi));
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        const auto end = now();
+
+        DWORD exitCode = 0;
+        THROW_IF_WIN32_BOOL_FALSE(GetExitCodeProcess(pi.hProcess, &exitCode));
+        THROW_HR_IF(E_FAIL, exitCode != 0);
+
+        // ClosePseudoConsole() flushes the remaining output, after which ReadFile() fails and the reader exits.
+        closePseudoConsole(std::exchange(hpc, nullptr));
+        reader.join();
+        joinReaderOnExit.release();
+
+        result.seconds = end - start;
+        result.drainSeconds = std::max(end, drainEnd) - start;
+        result.firstOutputSeconds = firstOutput ? firstOutput - createStart : 0;
+        readStats(&statsPath[0], result);
+        return result;
+    }
+
+    double percentile(const std::vector<double>& sorted, size_t p) noexcept
+    {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+    }
+
+    void printResults(const Options& options, std::vector<Result>& results)
+    {
+        auto conpty = options.conpty.empty() ? std::string{ "inbox" } : til::u16u8(options.conpty);
+        // The path is the only user-provided string and Windows paths have no quotes, only backslashes.
+        for (size_t i = 0; (i = conpty.find('\\', i)) != std::string::npos; i += 2)
+        {
+            conpty.insert(i, 1, '\\');
+        }
+
+        printf("{\n");
+        printf("  \"conpty\": \"%s\",\n", conpty.c_str());
+        printf("  \"size\": [%d, %d],\n", options.cellCount.width, options.cellCount.height);
+        printf("  \"chunk\": %zu,\n", options.chunk);
+        printf("  \"workloads\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& r = results[i];
+            std::ranges::sort(r.latencies);
+            const auto mb = static_cast<double>(r.inputBytes) / (1024.0 * 1024.0);
+            printf("    {\n");
+            printf("      \"name\": \"%.*s\",\n", gsl::narrow_cast<int>(r.name.size()), r.name.data());
+            printf("      \"inputBytes\": %llu,\n", r.inputBytes);
+            printf("      \"outputBytes\": %llu,\n", r.outputBytes);
+            printf("      \"seconds\": %.6f,\n", r.seconds);
+            printf("      \"drainSeconds\": %.6f,\n", r.drainSeconds);
+            printf("      \"firstOutputSeconds\": %.6f,\n", r.firstOutputSeconds);
+            printf("      \"megabytesPerSecond\": %.3f,\n", r.seconds > 0 ? mb / r.seconds : 0.0);
+            printf("      \"writeLatencyUs\": { \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f }\n",
+                   percentile(r.latencies, 50),
+                   percentile(r.latencies, 90),
+                   percentile(r.latencies, 99),
+                   r.latencies.empty() ? 0.0 : r.latencies.back());
+            printf("    }%s\n", i + 1 < results.size() ? "," : "");
+        }
+        printf("  ]\n");
+        printf("}\n");
+    }
+
+    void run(const Options& options)
+    {
+        wil::unique_hmodule conptyModule;
+        HMODULE module = GetModuleHandleW(L"kernel32.dll");
+        if (!options.conpty.empty())
+        {
+            conptyModule.reset(LoadLibraryExW(options.conpty.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH));
+            THROW_LAST_ERROR_IF(!conptyModule);
+            module = conptyModule.get();
+        }
+
+        const auto createPseudoConsole = reinterpret_cast<CreatePseudoConsoleFn>(GetProcAddress(module, "CreatePseudoConsole"));
+        const auto closePseudoConsole = reinterpret_cast<ClosePseudoConsoleFn>(GetProcAddress(module, "ClosePseudoConsole"));
+        THROW_LAST_ERROR_IF(!createPseudoConsole || !closePseudoConsole);
+
+        std::vector<Result> results;
+        for (const auto name : options.workloads)
+        {
+            fwprintf(stderr, L"%-10hs ", std::string{ name }.c_str());
+            auto& r = results.emplace_back(runWorkload(options, name, createPseudoConsole, closePseudoConsole));
+            fwprintf(stderr, L"%8.3fs  %8.2f MB/s  %7.1f ms to first output\n", r.seconds, static_cast<double>(r.inputBytes) / (1024.0 * 1024.0) / r.seconds, r.firstOutputSeconds * 1e3);
+        }
+
+        printResults(options, results);
+    }
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    try
+    {
+        // ConptyBenchmark --child <workload> <columns> <rows> <bytes> <chunk> <stats path>
+        if (argc == 8 && std::wstring_view{ argv[1] } == L"--child")
+        {
+            const auto name = parseWorkload(argv[2]);
+            THROW_HR_IF(E_INVALIDARG, !name);
+            const til::size cellCount{ _wtoi(argv[3]), _wtoi(argv[4]) };
+            return runChild(*name, cellCount, wcstoull(argv[5], nullptr, 10), wcstoull(argv[6], nullptr, 10), argv[7]);
+        }
+
+        Options options;
+        if (!parseOptions(argc, argv, options))
+        {
+            printUsage();
+            return 1;
+        }
+
+        run(options);
+        return 0;
+    }
+    catch (...)
+    {
+        const auto hr = wil::ResultFromCaughtException();
+        fwprintf(stderr, L"failed with 0x%08x\n", static_cast<unsigned int>(hr));
+        return 1;
+    }
+}
@@ -3,6 +3,8 @@
 // NOTE The functions u8u16 and u16u8 contain own algorithms. Tests have shown that they perform
 // worse than the platform API functions.
 // Thus, these functions are *unrelated* to the til::u8u16 and til::u16u8 implementation.
+// The til_* tests at the end measure the til implementation, which widens and narrows
+// runs of ASCII itself and passes everything else to the platform API functions.
 
 #include <iostream>
 #include <memory>
@@ -13,6 +15,8 @@
 
 #include "U8U16Test.hpp"
 
+#include <LibraryIncludes.h>
+
 typedef NTSTATUS(WINAPI* t_RtlUTF8ToUnicodeN)(PWSTR, ULONG, PULONG, PCCH, ULONG);
 typedef NTSTATUS(WINAPI* t_RtlUnicodeToUTF8N)(PCHAR, ULONG, PULONG, PCWSTR, ULONG);
 NTSTATUS(WINAPI* p_RtlUTF8ToUnicodeN)
@@ -330,6 +334,65 @@ void u8u16_ptr_Chunks(std::string_view u8Str, size_t u8CharLen, size_t u16ChunkL
               << "\n HRESULT " << hRes << "\n length " << length << "\n elapsed " << duration << std::endl;
 }
 
+// Converts the string in chunks of the size ConptyConnection reads from its pipe,
+// while carrying the partials over from one chunk to the next, just like it does.
+void til_u8u16_Chunks(std::string_view u8Str, const char* const description)
+{
+    static constexpr size_t chunkLen{ 4096u };
+    PrintHeader(description);
+    double duration{};
+    size_t length{};
+    HRESULT hRes{};
+    std::wstring u16Str{};
+    til::u8state state{};
+
+    for (size_t i{}; i < u8Str.length(); i += chunkLen)
+    {
+        const auto sv{ u8Str.substr(i, chunkLen) };
+        GetDuration();
+        hRes = til::u8u16(sv, u16Str, state);
+        duration += GetDuration();
+        length += u16Str.length();
+    }
+
+    std::cout << " HRESULT " << hRes << "\n length " << length << "\n elapsed " << duration << std::endl;
+}
+
+void til_u16u8_Chunks(std::wstring_view testU16, const char* const description)
+{
+    static constexpr size_t chunkLen{ 4096u };
+    PrintHeader(description);
+    double duration{};
+    size_t length{};
+    HRESULT hRes{};
+    std::string u8Str{};
+    til::u16state state{};
+
+    for (size_t i{}; i < testU16.length(); i += chunkLen)
+    {
+        const auto sv{ testU16.substr(i, chunkLen) };
+        GetDuration();
+        hRes = til::u16u8(sv, u8Str, state);
+        duration += GetDuration();
+        length += u8Str.length();
+    }
+
+    std::cout << " HRESULT " << hRes << "\n length " << length << "\n elapsed " << duration << std::endl;
+}
+
+void til_CompareWithPlatform(std::wstring_view testU16, const char* const description)
+{
+    std::cout << "\n--- " << description << " ---" << std::endl;
+
+    std::string u8Str{};
+    WideCharToMultiByte_WholeString(testU16);
+    u8Str = til::u16u8(testU16);
+    til_u16u8_Chunks(testU16, "til::u16u8 (chunks of 4096)");
+
+    MultiByteToWideChar_WholeString(u8Str);
+    til_u8u16_Chunks(u8Str, "til::u8u16 (chunks of 4096)");
+}
+
 void CompNaturalLang_WholeString(const std::string& fileName)
 {
     std::string head{ __func__ };
@@ -519,6 +582,25 @@ int main()
     CompNaturalLang_Chunks("ru.txt");
     CompNaturalLang_Chunks("zh.txt");
 
+    std::cout << "\n\n### til ###" << std::endl;
+
+    // The output of most console applications is mostly ASCII. This is
+    // what the ASCII fast path of til::u8u16 and til::u16u8 is made for.
+    std::wstring testVt{};
+    while (testVt.length() < u16Length)
+    {
+        testVt.append(L"\x1b[38;5;42mdrwxr-xr-x\x1b[m 2 user group 4096 Oct 14 12:00 src\r\n");
+    }
+    std::wstring testMixed{};
+    while (testMixed.length() < u16Length)
+    {
+        testMixed.append(L"\x1b[32mGr\u00fc\u00dfe\x1b[m \u4f60\u597d \u20ac 42 \U0001F600\r\n");
+    }
+
+    til_CompareWithPlatform(testVt, "ASCII with VT sequences");
+    til_CompareWithPlatform(testMixed, "Mixed scripts");
+    til_CompareWithPlatform(testU16, "EURO SIGN only");
+
     FreeLibrary(ntdll);
     return 0;
 }
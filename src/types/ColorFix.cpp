@@ -46,6 +46,33 @@ static constexpr float srgbToRgbLUT[256]{
 };
 // clang-format on
 
+// This table contains the linear RGB values halfway between each pair of adjacent 8-bit sRGB values.
+// The number of entries that are less than or equal to a linear value is its rounded 8-bit sRGB value.
+// It was generated the same way as the table above, except that the loop runs
+// from 0 to 254 and the value is computed as:
+//   auto v = (i + 0.5f) / 255.0f;
+//
+// clang-format off
+static constexpr float rgbToSrgbThresholdLUT[255]{
+    0x1.3e4568p-13f, 0x1.dd681cp-12f, 0x1.8dd6c2p-11f, 0x1.167cbap-10f, 0x1.660e16p-10f, 0x1.b59f70p-10f, 0x1.029864p-9f,  0x1.2a6112p-9f,  0x1.5229c0p-9f,  0x1.79f26cp-9f,  0x1.a1e5a2p-9f,  0x1.cbf736p-9f,  0x1.f86806p-9f,  0x1.13a0bep-8f,  0x1.2c4666p-8f,  0x1.46297ap-8f,
+    0x1.614e62p-8f,  0x1.7db96ep-8f,  0x1.9b6edap-8f,  0x1.ba72d0p-8f,  0x1.dac960p-8f,  0x1.fc768cp-8f,  0x1.0fbf22p-7f,  0x1.21f234p-7f,  0x1.34d664p-7f,  0x1.486d8ep-7f,  0x1.5cb98ep-7f,  0x1.71bc34p-7f,  0x1.877748p-7f,  0x1.9dec90p-7f,  0x1.b51dc8p-7f,  0x1.cd0ca8p-7f,
+    0x1.e5bae4p-7f,  0x1.ff2a20p-7f,  0x1.0cae04p-6f,  0x1.1a291ep-6f,  0x1.28072cp-6f,  0x1.3648f8p-6f,  0x1.44ef4cp-6f,  0x1.53faf0p-6f,  0x1.636ca6p-6f,  0x1.734532p-6f,  0x1.838552p-6f,  0x1.942dc6p-6f,  0x1.a53f4ap-6f,  0x1.b6ba96p-6f,  0x1.c8a064p-6f,  0x1.daf16ap-6f,
+    0x1.edae5cp-6f,  0x1.006bf6p-5f,  0x1.0a3768p-5f,  0x1.1439d8p-5f,  0x1.1e73a0p-5f,  0x1.28e514p-5f,  0x1.338e8ap-5f,  0x1.3e7056p-5f,  0x1.498acep-5f,  0x1.54de42p-5f,  0x1.606b08p-5f,  0x1.6c316ep-5f,  0x1.7831c6p-5f,  0x1.846c64p-5f,  0x1.90e192p-5f,  0x1.9d91a4p-5f,
+    0x1.aa7ce8p-5f,  0x1.b7a3a8p-5f,  0x1.c50632p-5f,  0x1.d2a4d6p-5f,  0x1.e07fdep-5f,  0x1.ee9796p-5f,  0x1.fcec4ap-5f,  0x1.05bf22p-4f,  0x1.0d26e6p-4f,  0x1.14ad96p-4f,  0x1.1c5358p-4f,  0x1.24184ep-4f,  0x1.2bfc9ep-4f,  0x1.34006ap-4f,  0x1.3c23d8p-4f,  0x1.446708p-4f,
+    0x1.4cca20p-4f,  0x1.554d42p-4f,  0x1.5df08ep-4f,  0x1.66b42ap-4f,  0x1.6f9836p-4f,  0x1.789cd6p-4f,  0x1.81c228p-4f,  0x1.8b0852p-4f,  0x1.946f72p-4f,  0x1.9df7acp-4f,  0x1.a7a11ep-4f,  0x1.b16beap-4f,  0x1.bb5832p-4f,  0x1.c56614p-4f,  0x1.cf95b2p-4f,  0x1.d9e72cp-4f,
+    0x1.e45aa0p-4f,  0x1.eef02ep-4f,  0x1.f9a7f8p-4f,  0x1.02410ep-3f,  0x1.07bf5cp-3f,  0x1.0d4ef6p-3f,  0x1.12efecp-3f,  0x1.18a24cp-3f,  0x1.1e6626p-3f,  0x1.243b8ap-3f,  0x1.2a2286p-3f,  0x1.301b2ap-3f,  0x1.362584p-3f,  0x1.3c41a2p-3f,  0x1.426f94p-3f,  0x1.48af6ap-3f,
+    0x1.4f0132p-3f,  0x1.5564f8p-3f,  0x1.5bdacep-3f,  0x1.6262c2p-3f,  0x1.68fce0p-3f,  0x1.6fa938p-3f,  0x1.7667d8p-3f,  0x1.7d38cep-3f,  0x1.841c28p-3f,  0x1.8b11f6p-3f,  0x1.921a42p-3f,  0x1.99351ep-3f,  0x1.a06298p-3f,  0x1.a7a2bap-3f,  0x1.aef594p-3f,  0x1.b65b34p-3f,
+    0x1.bdd3a6p-3f,  0x1.c55efap-3f,  0x1.ccfd3cp-3f,  0x1.d4ae7cp-3f,  0x1.dc72c2p-3f,  0x1.e44a20p-3f,  0x1.ec34a2p-3f,  0x1.f43256p-3f,  0x1.fc4348p-3f,  0x1.0233c2p-2f,  0x1.064f8ep-2f,  0x1.0a750cp-2f,  0x1.0ea442p-2f,  0x1.12dd3ap-2f,  0x1.171ff8p-2f,  0x1.1b6c82p-2f,
+    0x1.1fc2dep-2f,  0x1.242314p-2f,  0x1.288d2cp-2f,  0x1.2d0128p-2f,  0x1.317f12p-2f,  0x1.3606ecp-2f,  0x1.3a98c2p-2f,  0x1.3f3496p-2f,  0x1.43da70p-2f,  0x1.488a54p-2f,  0x1.4d444cp-2f,  0x1.52085ap-2f,  0x1.56d686p-2f,  0x1.5baed8p-2f,  0x1.609154p-2f,  0x1.657dfep-2f,
+    0x1.6a74e0p-2f,  0x1.6f7600p-2f,  0x1.748160p-2f,  0x1.799708p-2f,  0x1.7eb700p-2f,  0x1.83e14cp-2f,  0x1.8915f2p-2f,  0x1.8e54f6p-2f,  0x1.939e62p-2f,  0x1.98f23ap-2f,  0x1.9e5082p-2f,  0x1.a3b942p-2f,  0x1.a92c80p-2f,  0x1.aeaa40p-2f,  0x1.b4328ap-2f,  0x1.b9c562p-2f,
+    0x1.bf62cep-2f,  0x1.c50ad2p-2f,  0x1.cabd78p-2f,  0x1.d07ac4p-2f,  0x1.d642b8p-2f,  0x1.dc155ep-2f,  0x1.e1f2bcp-2f,  0x1.e7dad4p-2f,  0x1.edcdacp-2f,  0x1.f3cb4ep-2f,  0x1.f9d3bap-2f,  0x1.ffe6fap-2f,  0x1.030288p-1f,  0x1.061702p-1f,  0x1.0930ecp-1f,  0x1.0c504cp-1f,
+    0x1.0f7522p-1f,  0x1.129f70p-1f,  0x1.15cf3cp-1f,  0x1.190486p-1f,  0x1.1c3f52p-1f,  0x1.1f7fa2p-1f,  0x1.22c57ap-1f,  0x1.2610dap-1f,  0x1.2961c6p-1f,  0x1.2cb842p-1f,  0x1.301450p-1f,  0x1.3375f2p-1f,  0x1.36dd2ap-1f,  0x1.3a49fcp-1f,  0x1.3dbc6ap-1f,  0x1.413476p-1f,
+    0x1.44b224p-1f,  0x1.483576p-1f,  0x1.4bbe6ep-1f,  0x1.4f4d0ep-1f,  0x1.52e15cp-1f,  0x1.567b58p-1f,  0x1.5a1b04p-1f,  0x1.5dc062p-1f,  0x1.616b78p-1f,  0x1.651c46p-1f,  0x1.68d2cep-1f,  0x1.6c8f14p-1f,  0x1.70511ap-1f,  0x1.7418e4p-1f,  0x1.77e672p-1f,  0x1.7bb9c8p-1f,
+    0x1.7f92e6p-1f,  0x1.8371d2p-1f,  0x1.87568ep-1f,  0x1.8b411ap-1f,  0x1.8f317cp-1f,  0x1.9327b2p-1f,  0x1.9723c2p-1f,  0x1.9b25aep-1f,  0x1.9f2d78p-1f,  0x1.a33b22p-1f,  0x1.a74eaep-1f,  0x1.ab6820p-1f,  0x1.af8778p-1f,  0x1.b3acbcp-1f,  0x1.b7d7ecp-1f,  0x1.bc090ap-1f,
+    0x1.c0401ap-1f,  0x1.c47d1cp-1f,  0x1.c8c016p-1f,  0x1.cd0908p-1f,  0x1.d157f4p-1f,  0x1.d5acdep-1f,  0x1.da07c6p-1f,  0x1.de68b2p-1f,  0x1.e2cfa0p-1f,  0x1.e73c96p-1f,  0x1.ebaf96p-1f,  0x1.f028a0p-1f,  0x1.f4a7b8p-1f,  0x1.f92ce0p-1f,  0x1.fdb81ap-1f,
+};
+// clang-format on
+
 TIL_FAST_MATH_BEGIN
 
 constexpr float saturate(float f) noexcept
@@ -148,17 +175,30 @@ __forceinline oklab::RGB colorrefToLinear(COLORREF c) noexcept
     return { r, g, b };
 }
 
+// Converts a linear RGB value to 8-bit sRGB. This is equivalent to rounding
+// the result of the sRGB transfer function, but avoids the expensive powf().
+__forceinline uint32_t linearToSrgb8(float v) noexcept
+{
+    // A binary search over the 255 thresholds with a fixed number of steps: 128 + 64 + ... + 1 = 255.
+    uint32_t i = 0;
+    for (uint32_t step = 128; step; step >>= 1)
+    {
+        if (rgbToSrgbThresholdLUT[i + step - 1] <= v)
+        {
+            i += step;
+        }
+    }
+    return i;
+}
+
 #pragma warning(pop)
 
 __forceinline COLORREF linearToColorref(const oklab::RGB& c) noexcept
 {
-    auto r = saturate(c.r);
-    auto g = saturate(c.g);
-    auto b = saturate(c.b);
-    r = (r > 0.0031308f ? (1.055f * powf(r, 1.0f / 2.4f) - 0.055f) : 12.92f * r) * 255.0f;
-    g = (g > 0.0031308f ? (1.055f * powf(g, 1.0f / 2.4f) - 0.055f) : 12.92f * g) * 255.0f;
-    b = (b > 0.0031308f ? (1.055f * powf(b, 1.0f / 2.4f) - 0.055f) : 12.92f * b) * 255.0f;
-    return lrintf(r) | (lrintf(g) << 8) | (lrintf(b) << 16);
+    const auto r = linearToSrgb8(saturate(c.r));
+    const auto g = linearToSrgb8(saturate(c.g));
+    const auto b = linearToSrgb8(saturate(c.b));
+    return r | (g << 8) | (b << 16);
 }
 
 // This function changes `color` so that it is visually different
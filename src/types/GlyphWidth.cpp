@@ -40,6 +40,35 @@ void SetGlyphWidthFallback(std::function<bool(const std::wstring_view&)> pfnFall
     widthDetector.SetFallbackMethod(std::move(pfnFallback));
 }
 
+// Function Description:
+// - Stops the global CodepointWidthDetector from calling the fallback method while measuring
+//      text. Ambiguous glyphs are measured as narrow instead, until whoever owns the fallback
+//      calls ResolveDeferredGlyphWidths(). See CodepointWidthDetector::SetFallbackDeferred.
+// Arguments:
+// - pfnResolved - called with the glyphs that turned out to be wide, so that the text
+//      containing them can be laid out again.
+// Return Value:
+// - <none>
+void SetGlyphWidthFallbackDeferred(std::function<void(std::span<const char32_t>)> pfnResolved) noexcept
+{
+    widthDetector.SetFallbackDeferred(std::move(pfnResolved));
+}
+
+// Function Description:
+// - Returns true if there are glyphs that ResolveDeferredGlyphWidths() needs to measure.
+bool HasDeferredGlyphWidths() noexcept
+{
+    return widthDetector.HasDeferredFallbacks();
+}
+
+// Function Description:
+// - Measures the glyphs deferred since the last call with the fallback method.
+//      See CodepointWidthDetector::ResolveDeferredFallbacks
+void ResolveDeferredGlyphWidths()
+{
+    widthDetector.ResolveDeferredFallbacks();
+}
+
 // Function Description:
 // - Forwards notification about font changing to glyph width detector
 // Arguments:
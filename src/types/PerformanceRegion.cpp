@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "inc/PerformanceRegion.hpp"
+
+#pragma warning(push)
+#pragma warning(disable : 26446 26447 26477 26482 26485 26494 26496)
+TRACELOGGING_DEFINE_PROVIDER(g_hConsolePerformanceProvider,
+                             "Microsoft.Windows.Console.Performance",
+                             // tl:{c3c9681a-bb13-5c78-77d4-16520a094896}
+                             (0xc3c9681a, 0xbb13, 0x5c78, 0x77, 0xd4, 0x16, 0x52, 0x0a, 0x09, 0x48, 0x96));
+
+using namespace Microsoft::Console::Types;
+
+// The regions are spread across several static libraries that end up in conhost as well as
+// in Windows Terminal's DLLs. Registering the provider during static initialization of this
+// translation unit ensures that every binary that uses a region also registers it.
+static const struct PerformanceProviderRegistration
+{
+    PerformanceProviderRegistration() noexcept
+    {
+        TraceLoggingRegister(g_hConsolePerformanceProvider);
+    }
+
+    ~PerformanceProviderRegistration()
+    {
+        TraceLoggingUnregister(g_hConsolePerformanceProvider);
+    }
+} s_performanceProviderRegistration;
+
+// Routine Description:
+// - Writes the start event of the region and makes it the current activity of this thread,
+//   so that regions started before the matching _stop() become its children.
+// Arguments:
+// - name - The name of the region.
+void PerformanceRegion::_start(_In_z_ const char* name) noexcept
+{
+    _name = name;
+
+    EventActivityIdControl(EVENT_ACTIVITY_CTRL_GET_ID, &_parentActivityId);
+    EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &_activityId);
+    EventActivityIdControl(EVENT_ACTIVITY_CTRL_SET_ID, &_activityId);
+
+    const auto parent = _parentActivityId == GUID{} ? nullptr : &_parentActivityId;
+    TraceLoggingWriteActivity(g_hConsolePerformanceProvider,
+                              "PerfRegion",
+                              &_activityId,
+                              parent,
+                              TraceLoggingString(name, "Region"),
+                              TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+}
+
+// Routine Description:
+// - Writes the stop event of the region and restores the thread's previous activity.
+void PerformanceRegion::_stop() noexcept
+{
+    TraceLoggingWriteActivity(g_hConsolePerformanceProvider,
+                              "PerfRegion",
+                              &_activityId,
+                              nullptr,
+                              TraceLoggingString(_name, "Region"),
+                              TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
+    EventActivityIdControl(EVENT_ACTIVITY_CTRL_SET_ID, &_parentActivityId);
+}
+
+#pragma warning(pop)
@@ -223,9 +223,9 @@ IFACEMETHODIMP ScreenInfoUiaProviderBase::GetSelection(_Outptr_result_maybenull_
     RETURN_HR_IF_NULL(E_INVALIDARG, ppRetVal);
     *ppRetVal = nullptr;
 
-    _LockConsole();
+    _LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _UnlockConsole();
+        _UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -273,9 +273,9 @@ IFACEMETHODIMP ScreenInfoUiaProviderBase::GetVisibleRanges(_Outptr_result_mayben
     RETURN_HR_IF_NULL(E_INVALIDARG, ppRetVal);
     *ppRetVal = nullptr;
 
-    _LockConsole();
+    _LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _UnlockConsole();
+        _UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -380,14 +380,14 @@ Viewport ScreenInfoUiaProviderBase::_getViewport() const noexcept
     return _pData->GetViewport();
 }
 
-void ScreenInfoUiaProviderBase::_LockConsole() noexcept
+void ScreenInfoUiaProviderBase::_LockConsoleShared() noexcept
 {
     // TODO GitHub #2141: Lock and Unlock in conhost should decouple Ctrl+C dispatch and use smarter handling
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
 }
 
-void ScreenInfoUiaProviderBase::_UnlockConsole() noexcept
+void ScreenInfoUiaProviderBase::_UnlockConsoleShared() noexcept
 {
     // TODO GitHub #2141: Lock and Unlock in conhost should decouple Ctrl+C dispatch and use smarter handling
-    _pData->UnlockConsole();
+    _pData->UnlockConsoleShared();
 }
@@ -7,8 +7,27 @@
 #include "../buffer/out/search.h"
 #include "UiaTracing.h"
 
+#include <til/mutex.h>
+
 using namespace Microsoft::Console::Types;
 
+namespace
+{
+    // Screen readers tend to call GetText() on the same (potentially huge) ranges over and over again,
+    // even if nothing changed in between. The result of the last call is cached for that reason and
+    // remains valid for as long as the rows it was extracted from are unmodified (see ROW::GetGeneration).
+    struct TextValueCache
+    {
+        const TextBuffer* buffer = nullptr;
+        std::vector<til::inclusive_rect> textRects;
+        size_t maxLength = 0;
+        std::vector<uint64_t> rowStates;
+        std::wstring text;
+    };
+
+    til::shared_mutex<TextValueCache> textValueCache;
+}
+
 // Foreground/Background text color doesn't care about the alpha.
 static constexpr long _RemoveAlpha(COLORREF color) noexcept
 {
@@ -185,9 +204,9 @@ bool UiaTextRangeBase::IsDegenerate() const noexcept
 
 IFACEMETHODIMP UiaTextRangeBase::Compare(_In_opt_ ITextRangeProvider* pRange, _Out_ BOOL* pRetVal) noexcept
 {
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
 
     RETURN_HR_IF(E_INVALIDARG, pRetVal == nullptr);
@@ -212,9 +231,9 @@ try
     RETURN_HR_IF_NULL(E_INVALIDARG, pRetVal);
     *pRetVal = 0;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -244,9 +263,9 @@ CATCH_RETURN();
 
 IFACEMETHODIMP UiaTextRangeBase::ExpandToEnclosingUnit(_In_ TextUnit unit) noexcept
 {
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -434,9 +453,9 @@ try
     RETURN_HR_IF(E_INVALIDARG, ppRetVal == nullptr);
     *ppRetVal = nullptr;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -602,9 +621,9 @@ try
     RETURN_HR_IF(E_INVALIDARG, ppRetVal == nullptr);
     *ppRetVal = nullptr;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -733,9 +752,9 @@ try
     RETURN_HR_IF(E_INVALIDARG, pRetVal == nullptr);
     VariantInit(pRetVal);
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -830,9 +849,9 @@ IFACEMETHODIMP UiaTextRangeBase::GetBoundingRectangles(_Outptr_result_maybenull_
     RETURN_HR_IF(E_INVALIDARG, ppRetVal == nullptr);
     *ppRetVal = nullptr;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -931,9 +950,9 @@ try
     RETURN_HR_IF(E_INVALIDARG, maxLength < -1);
     *pRetVal = nullptr;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -976,8 +995,39 @@ std::wstring UiaTextRangeBase::_getTextValue(til::CoordType maxLength) const
         auto inclusiveEnd = _end;
         bufferSize.DecrementInBounds(inclusiveEnd, true);
 
+        auto textRects = buffer.GetTextRects(_start, inclusiveEnd, _blockRange, true);
+
+        // Since we don't trim whitespace, every row yields at least 1 character per 2 columns (= wide glyphs).
+        // Once the rows we've seen so far are guaranteed to fill maxLength, all following ones can be skipped.
+        size_t minimumLength = 0;
+        for (auto it = textRects.begin(); it != textRects.end(); ++it)
+        {
+            if (minimumLength >= maxLengthAsSize)
+            {
+                textRects.erase(it, textRects.end());
+                break;
+            }
+            minimumLength += gsl::narrow_cast<size_t>(it->right - it->left + 1) / 2;
+        }
+
+        std::vector<uint64_t> rowStates;
+        rowStates.reserve(textRects.size());
+        for (const auto& rect : textRects)
+        {
+            // The generation doesn't cover the wrap flag, which decides whether a CRLF is added.
+            const auto& row = buffer.GetRowByOffset(rect.top);
+            rowStates.emplace_back(row.GetGeneration() << 1 | row.WasWrapForced());
+        }
+
+        {
+            const auto cache = textValueCache.lock_shared();
+            if (cache->buffer == &buffer && cache->maxLength == maxLengthAsSize && cache->textRects == textRects && cache->rowStates == rowStates)
+            {
+                return cache->text;
+            }
+        }
+
         // reserve size in accordance to extracted text
-        const auto textRects = buffer.GetTextRects(_start, inclusiveEnd, _blockRange, true);
         const auto bufferData = buffer.GetText(true,
                                                false,
                                                textRects);
@@ -999,6 +1049,13 @@ std::wstring UiaTextRangeBase::_getTextValue(til::CoordType maxLength) const
         {
             textData.resize(maxLengthAsSize);
         }
+
+        const auto cache = textValueCache.lock();
+        cache->buffer = &buffer;
+        cache->textRects = std::move(textRects);
+        cache->maxLength = maxLengthAsSize;
+        cache->rowStates = std::move(rowStates);
+        cache->text = textData;
     }
 
     return textData;
@@ -1013,9 +1070,9 @@ try
     RETURN_HR_IF(E_INVALIDARG, pRetVal == nullptr);
     *pRetVal = 0;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
 
@@ -1075,9 +1132,9 @@ IFACEMETHODIMP UiaTextRangeBase::MoveEndpointByUnit(_In_ TextPatternRangeEndpoin
     RETURN_HR_IF(E_INVALIDARG, pRetVal == nullptr);
     *pRetVal = 0;
 
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
     RETURN_HR_IF(E_FAIL, !_pData->IsUiaDataInitialized());
     RETURN_HR_IF(S_OK, count == 0);
@@ -1126,9 +1183,9 @@ IFACEMETHODIMP UiaTextRangeBase::MoveEndpointByRange(_In_ TextPatternRangeEndpoi
                                                      _In_ TextPatternRangeEndpoint targetEndpoint) noexcept
 try
 {
-    _pData->LockConsole();
+    _pData->LockConsoleShared();
     auto Unlock = wil::scope_exit([&]() noexcept {
-        _pData->UnlockConsole();
+        _pData->UnlockConsoleShared();
     });
 
     const UiaTextRangeBase* range = static_cast<UiaTextRangeBase*>(pTargetRange);
@@ -125,7 +125,7 @@ namespace Microsoft::Console::Types
 
         IRawElementProviderSimple* _pProvider{ nullptr };
 
-        std::wstring _wordDelimiters{};
+        WordDelimiters _wordDelimiters{};
 
         virtual void _TranslatePointToScreen(til::point* clientPoint) const = 0;
         virtual void _TranslatePointFromScreen(til::point* screenPoint) const = 0;
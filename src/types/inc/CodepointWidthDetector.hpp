@@ -15,6 +15,8 @@ Author:
 
 #include "convert.hpp"
 
+#include <til/mutex.h>
+
 // use to measure the width of a codepoint
 class CodepointWidthDetector final
 {
@@ -22,6 +24,9 @@ public:
     CodepointWidth GetWidth(const std::wstring_view& glyph) noexcept;
     bool IsWide(const std::wstring_view& glyph) noexcept;
     void SetFallbackMethod(std::function<bool(const std::wstring_view&)> pfnFallback) noexcept;
+    void SetFallbackDeferred(std::function<void(std::span<const char32_t>)> pfnResolved) noexcept;
+    bool HasDeferredFallbacks() const noexcept;
+    void ResolveDeferredFallbacks();
     void NotifyFontChanged() noexcept;
 
 #ifdef UNIT_TESTING
@@ -32,6 +37,18 @@ private:
     uint8_t _lookupGlyphWidth(char32_t codepoint, const std::wstring_view& glyph) noexcept;
     uint8_t _checkFallbackViaCache(char32_t codepoint, const std::wstring_view& glyph) noexcept;
 
-    std::unordered_map<char32_t, uint8_t> _fallbackCache;
+    // The fallback may query the font, which is slow. The cache ensures that we do that at
+    // most once per ambiguous codepoint and font. It's shared by all text buffers, which
+    // might measure text concurrently, and cleared (= invalidated) by NotifyFontChanged().
+    til::shared_mutex<std::unordered_map<char32_t, uint8_t>> _fallbackCache;
+    // Incremented on every font change, to avoid caching widths measured with a previous font.
+    std::atomic<uint32_t> _fallbackCacheGeneration{ 0 };
     std::function<bool(const std::wstring_view&)> _pfnFallbackMethod;
+
+    // If set, the fallback isn't called while measuring text. Instead, ambiguous codepoints are
+    // measured as narrow and queued up in _deferredFallbacks until ResolveDeferredFallbacks()
+    // gets called, which passes those that turned out to be wide to _pfnDeferredResolved.
+    til::shared_mutex<std::vector<char32_t>> _deferredFallbacks;
+    std::atomic<bool> _hasDeferredFallbacks{ false };
+    std::function<void(std::span<const char32_t>)> _pfnDeferredResolved;
 };
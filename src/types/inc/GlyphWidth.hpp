@@ -11,6 +11,7 @@ Abstract:
 #pragma once
 
 #include <functional>
+#include <span>
 #include <string_view>
 
 #include "convert.hpp"
@@ -18,4 +19,7 @@ Abstract:
 bool IsGlyphFullWidth(const std::wstring_view& glyph) noexcept;
 bool IsGlyphFullWidth(const wchar_t wch) noexcept;
 void SetGlyphWidthFallback(std::function<bool(const std::wstring_view&)> pfnFallback) noexcept;
+void SetGlyphWidthFallbackDeferred(std::function<void(std::span<const char32_t>)> pfnResolved) noexcept;
+bool HasDeferredGlyphWidths() noexcept;
+void ResolveDeferredGlyphWidths();
 void NotifyGlyphWidthFontChanged() noexcept;
@@ -0,0 +1,61 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PerformanceRegion.hpp
+
+Abstract:
+- Brackets a stage of the output pipeline (parse, buffer, render, present, ...) with a pair of
+  start/stop events, so that WPA can attribute time to it. See ConsolePerf.regions.xml.
+- Every region gets its own activity ID and is linked to the region that encloses it on the same
+  thread through its related activity ID. This allows WPA to nest, for instance, a TextBuffer
+  reflow underneath the API call that caused it.
+- If no one listens to the provider, constructing a region costs a single test of the provider's
+  enablement bits. The events are written out of line.
+--*/
+
+#pragma once
+
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hConsolePerformanceProvider);
+
+namespace Microsoft::Console::Types
+{
+    class PerformanceRegion final
+    {
+    public:
+        // The name must be a string literal (or otherwise outlive the region). It becomes
+        // the "Region" payload field, which is what the region definitions are named after.
+        explicit PerformanceRegion(_In_z_ const char* name) noexcept
+        {
+            if (TraceLoggingProviderEnabled(g_hConsolePerformanceProvider, WINEVENT_LEVEL_VERBOSE, TIL_KEYWORD_TRACE)) [[unlikely]]
+            {
+                _start(name);
+            }
+        }
+
+        ~PerformanceRegion()
+        {
+            if (_name) [[unlikely]]
+            {
+                _stop();
+            }
+        }
+
+        PerformanceRegion(const PerformanceRegion&) = delete;
+        PerformanceRegion& operator=(const PerformanceRegion&) = delete;
+        PerformanceRegion(PerformanceRegion&&) = delete;
+        PerformanceRegion& operator=(PerformanceRegion&&) = delete;
+
+    private:
+        void _start(_In_z_ const char* name) noexcept;
+        void _stop() noexcept;
+
+        const char* _name = nullptr;
+        GUID _activityId{};
+        GUID _parentActivityId{};
+    };
+}
@@ -93,11 +93,24 @@ static bool _HandleIsValid(HANDLE h) noexcept
     return (h != INVALID_HANDLE_VALUE) && (h != nullptr);
 }
 
+// Function Description:
+// - Returns whether the console host we're going to spawn understands the --outputring arguments.
+//   Only OpenConsole does. The inbox conhost of older versions of Windows doesn't.
+static bool _ConsoleHostSupportsOutputRing() noexcept
+{
+#if defined(__INSIDE_WINDOWS)
+    return true;
+#else
+    return std::wstring_view{ _ConsoleHostPath() }.ends_with(L"OpenConsole.exe");
+#endif // __INSIDE_WINDOWS
+}
+
 HRESULT _CreatePseudoConsole(const HANDLE hToken,
                              const COORD size,
                              const HANDLE hInput,
                              const HANDLE hOutput,
                              const DWORD dwFlags,
+                             _In_reads_opt_(3) const HANDLE* phOutputRing,
                              _Inout_ PseudoConsole* pPty)
 {
     if (pPty == nullptr)
@@ -108,6 +121,10 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
     {
         return E_INVALIDARG;
     }
+    if (phOutputRing && !_ConsoleHostSupportsOutputRing())
+    {
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
 
     wil::unique_handle serverHandle;
     RETURN_IF_NTSTATUS_FAILED(CreateServerHandle(serverHandle.addressof(), TRUE));
@@ -134,13 +151,13 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
 
     // GH4061: Ensure that the path to executable in the format is escaped so C:\Program.exe cannot collide with C:\Program Files
     auto pwszFormat = L"\"%s\" --headless %s%s%s--width %hu --height %hu --signal 0x%x --server 0x%x";
-    // This is plenty of space to hold the formatted string
-    wchar_t cmd[MAX_PATH]{};
+    // This is plenty of space to hold the formatted string, including the optional output ring arguments.
+    wchar_t cmd[MAX_PATH + 128]{};
     const BOOL bInheritCursor = (dwFlags & PSEUDOCONSOLE_INHERIT_CURSOR) == PSEUDOCONSOLE_INHERIT_CURSOR;
     const BOOL bResizeQuirk = (dwFlags & PSEUDOCONSOLE_RESIZE_QUIRK) == PSEUDOCONSOLE_RESIZE_QUIRK;
     const BOOL bPassthroughMode = (dwFlags & PSEUDOCONSOLE_PASSTHROUGH_MODE) == PSEUDOCONSOLE_PASSTHROUGH_MODE;
     swprintf_s(cmd,
-               MAX_PATH,
+               ARRAYSIZE(cmd),
                pwszFormat,
                _ConsoleHostPath(),
                bInheritCursor ? L"--inheritcursor " : L"",
@@ -151,6 +168,17 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
                signalPipeConhostSide.get(),
                serverHandle.get());
 
+    if (phOutputRing)
+    {
+        const auto length = wcslen(cmd);
+        swprintf_s(cmd + length,
+                   ARRAYSIZE(cmd) - length,
+                   L" --outputring 0x%x --outputringdata 0x%x --outputringspace 0x%x",
+                   phOutputRing[0],
+                   phOutputRing[1],
+                   phOutputRing[2]);
+    }
+
     STARTUPINFOEXW siEx{ 0 };
     siEx.StartupInfo.cb = sizeof(STARTUPINFOEXW);
     siEx.StartupInfo.hStdInput = hInput;
@@ -159,12 +187,18 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
     siEx.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
 
     // Only pass the handles we actually want the conhost to know about to it:
-    const size_t INHERITED_HANDLES_COUNT = 4;
-    HANDLE inheritedHandles[INHERITED_HANDLES_COUNT];
+    HANDLE inheritedHandles[7];
+    size_t inheritedHandlesCount = 4;
     inheritedHandles[0] = serverHandle.get();
     inheritedHandles[1] = hInput;
     inheritedHandles[2] = hOutput;
     inheritedHandles[3] = signalPipeConhostSide.get();
+    if (phOutputRing)
+    {
+        inheritedHandles[inheritedHandlesCount++] = phOutputRing[0];
+        inheritedHandles[inheritedHandlesCount++] = phOutputRing[1];
+        inheritedHandles[inheritedHandlesCount++] = phOutputRing[2];
+    }
 
     // Get the size of the attribute list. We need one attribute, the handle list.
     SIZE_T listSize = 0;
@@ -187,7 +221,7 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
                                                          0,
                                                          PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
                                                          inheritedHandles,
-                                                         (INHERITED_HANDLES_COUNT * sizeof(HANDLE)),
+                                                         (inheritedHandlesCount * sizeof(HANDLE)),
                                                          nullptr,
                                                          nullptr));
     wil::unique_process_information pi;
@@ -471,7 +505,61 @@ extern "C" HRESULT WINAPI ConptyCreatePseudoConsoleAsUser(_In_ HANDLE hToken,
     RETURN_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), hInput, GetCurrentProcess(), duplicatedInput.addressof(), 0, TRUE, DUPLICATE_SAME_ACCESS));
     RETURN_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), hOutput, GetCurrentProcess(), duplicatedOutput.addressof(), 0, TRUE, DUPLICATE_SAME_ACCESS));
 
-    RETURN_IF_FAILED(_CreatePseudoConsole(hToken, size, duplicatedInput.get(), duplicatedOutput.get(), dwFlags, pPty));
+    RETURN_IF_FAILED(_CreatePseudoConsole(hToken, size, duplicatedInput.get(), duplicatedOutput.get(), dwFlags, nullptr, pPty));
+
+    *phPC = (HPCON)pPty;
+    cleanupPty.release();
+
+    return S_OK;
+}
+
+// Function Description:
+// Creates a "Pseudo-console" (conpty) like ConptyCreatePseudoConsole, but additionally asks
+//      the console host to write its output into the given shared memory ring, as created
+//      by til::shared_ring::create(). `hOutput` is still required and remains connected:
+//      The conpty closes it when it exits, which the caller can use to detect that.
+// Returns HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED) if the console host in use doesn't
+//      support the output ring. The caller should then fall back to ConptyCreatePseudoConsole.
+extern "C" HRESULT WINAPI ConptyCreatePseudoConsoleWithOutputRing(_In_ COORD size,
+                                                                  _In_ HANDLE hInput,
+                                                                  _In_ HANDLE hOutput,
+                                                                  _In_ HANDLE hRingSection,
+                                                                  _In_ HANDLE hRingData,
+                                                                  _In_ HANDLE hRingSpace,
+                                                                  _In_ DWORD dwFlags,
+                                                                  _Out_ HPCON* phPC)
+{
+    if (phPC == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+    *phPC = nullptr;
+    if (!_HandleIsValid(hInput) || !_HandleIsValid(hOutput) ||
+        !_HandleIsValid(hRingSection) || !_HandleIsValid(hRingData) || !_HandleIsValid(hRingSpace))
+    {
+        return E_INVALIDARG;
+    }
+
+    auto pPty = (PseudoConsole*)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(PseudoConsole));
+    RETURN_IF_NULL_ALLOC(pPty);
+    auto cleanupPty = wil::scope_exit([&]() noexcept {
+        _ClosePseudoConsole(pPty, 0);
+    });
+
+    wil::unique_handle duplicatedInput;
+    wil::unique_handle duplicatedOutput;
+    wil::unique_handle duplicatedRing[3];
+    const HANDLE ringHandles[3]{ hRingSection, hRingData, hRingSpace };
+    HANDLE duplicatedRingHandles[3];
+    RETURN_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), hInput, GetCurrentProcess(), duplicatedInput.addressof(), 0, TRUE, DUPLICATE_SAME_ACCESS));
+    RETURN_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), hOutput, GetCurrentProcess(), duplicatedOutput.addressof(), 0, TRUE, DUPLICATE_SAME_ACCESS));
+    for (size_t i = 0; i < 3; ++i)
+    {
+        RETURN_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), ringHandles[i], GetCurrentProcess(), duplicatedRing[i].addressof(), 0, TRUE, DUPLICATE_SAME_ACCESS));
+        duplicatedRingHandles[i] = duplicatedRing[i].get();
+    }
+
+    RETURN_IF_FAILED(_CreatePseudoConsole(INVALID_HANDLE_VALUE, size, duplicatedInput.get(), duplicatedOutput.get(), dwFlags, &duplicatedRingHandles[0], pPty));
 
     *phPC = (HPCON)pPty;
     cleanupPty.release();
@@ -68,6 +68,7 @@ HRESULT _CreatePseudoConsole(const HANDLE hToken,
                              const HANDLE hInput,
                              const HANDLE hOutput,
                              const DWORD dwFlags,
+                             _In_reads_opt_(3) const HANDLE* phOutputRing,
                              _Inout_ PseudoConsole* pPty);
 
 HRESULT _ResizePseudoConsole(_In_ const PseudoConsole* const pPty, _In_ const COORD size);
@@ -5,10 +5,15 @@
 # (we use the null coalescing operator)
 
 ################################################################################
-# This script generates the an array suitable for replacing the body of
+# This script generates the lookup tables suitable for replacing the body of
 # src/types/CodepointWidthDetector.cpp from a Unicode UCD XML document[1]
 # compliant with UAX#42[2].
 #
+# The tables form a 3-stage trie: The codepoint's bits 10-20 index into the
+# first stage, bits 4-9 into the block of the second stage it refers to and
+# bits 0-3 into the block of widths of the third stage. Identical blocks are
+# deduplicated, which is what keeps the tables small.
+#
 # This script supports a quasi-mandatory "overrides" file, overrides.xml.
 # If you do not have overrides, supply the -NoOverrides parameter. This was
 # developed for use with the CodepointWidthDetector, which has some override
@@ -255,6 +260,51 @@ ForEach($_ in $ranges) {
     $c += $_.End - $_.Start + 1
 }
 
+# Flatten the ranges into one width per codepoint: 1 = narrow, 2 = wide, 0 = ambiguous.
+$widths = [byte[]]::new(0x110000)
+[Array]::Fill($widths, [byte]1)
+ForEach($_ in $ranges) {
+    $w = $_.Width -eq [CodepointWidth]::Ambiguous ? 0 : 2
+    For($i = $_.Start; $i -le $_.End; $i++) {
+        $widths[$i] = $w
+    }
+}
+
+# Splits $Data into blocks of 2^$Bits bytes and deduplicates them.
+# Returns the unique blocks and, for each original block, the index of its unique block.
+Function Compress-Stage([byte[]]$Data, [int]$Bits) {
+    $size = 1 -shl $Bits
+    $blocks = @{}
+    $values = [System.Collections.Generic.List[byte]]::New()
+    $indices = [byte[]]::new($Data.Length -shr $Bits)
+    For($i = 0; $i -lt $Data.Length; $i += $size) {
+        $key = [Convert]::ToBase64String($Data, $i, $size)
+        $index = $blocks[$key]
+        If ($null -eq $index) {
+            $index = $blocks.Count
+            If ($index -gt 255) {
+                throw "Too many unique blocks for a byte-sized index"
+            }
+            $blocks[$key] = $index
+            $values.AddRange([System.ArraySegment[byte]]::new($Data, $i, $size))
+        }
+        $indices[$i -shr $Bits] = $index
+    }
+    [PSCustomObject]@{ Values = $values.ToArray(); Indices = $indices }
+}
+
+Function Format-Stage([string]$Name, [byte[]]$Data) {
+    "    static constexpr std::array<uint8_t, {0}> {1}{{" -f $Data.Length, $Name
+    For($i = 0; $i -lt $Data.Length; $i += 16) {
+        $line = $Data[$i..([Math]::Min($i + 15, $Data.Length - 1))] | ForEach-Object { "0x{0:x2}" -f $_ }
+        "        {0}," -f ($line -join ", ")
+    }
+    "    };"
+}
+
+$stage3 = Compress-Stage $widths 4
+$stage2 = Compress-Stage $stage3.Indices 6
+
 # Emit Code
 "    // Generated by {0} -Pack:{1} -Full:{2} -NoOverrides:{3}" -f $MyInvocation.MyCommand.Name, $Pack, $Full, $NoOverrides
 "    // on {0} from {1}." -f (Get-Date -AsUTC -Format "u"), $InputObject.ucd.description
@@ -263,14 +313,8 @@ If (-not $NoOverrides) {
 "    // {0} (0x{0:X}) codepoints overridden." -f $overrideCount
 "    // Override path: {0}" -f $OverridePath
 }
-"    static constexpr std::array<UnicodeRange, {0}> s_wideAndAmbiguousTable{{" -f $ranges.Count
-ForEach($_ in $ranges) {
-    $isAmbiguous = $_.Width -eq [CodepointWidth]::Ambiguous
-    $comment = ""
-    if ($null -ne $_.Comment) {
-        # We only vend comments when we aren't packing tightly
-        $comment = " // {0}" -f $_.Comment
-    }
-"        UnicodeRange{{ 0x{0:x}, 0x{1:x}, {2} }},{3}" -f $_.Start, $_.End, [int]$isAmbiguous, $comment
-}
-"    };"
+"    // clang-format off"
+Format-Stage "s_stage1" $stage2.Indices
+Format-Stage "s_stage2" $stage2.Values
+Format-Stage "s_stage3" $stage3.Values
+"    // clang-format on"